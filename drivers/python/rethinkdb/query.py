@@ -6,7 +6,8 @@ __all__ = [
     'literal', 'asc', 'desc',
     'db', 'db_create', 'db_drop', 'db_list',
     'table', 'table_create', 'table_drop', 'table_list', 'grant',
-    'group', 'reduce', 'count', 'sum', 'avg', 'min', 'max', 'distinct',
+    'group', 'reduce', 'count', 'sum', 'avg', 'approx_count_distinct',
+    'approx_quantile', 'min', 'max', 'distinct',
     'contains', 'eq', 'ne', 'le', 'ge', 'lt', 'gt', 'and_', 'or_', 'not_',
     'add', 'sub', 'mul', 'div', 'mod', 'bit_and', 'bit_or', 'bit_xor',
     'bit_not', 'bit_sal', 'bit_sar', 'floor', 'ceil',
@@ -133,6 +134,14 @@ def avg(*args):
     return ast.Avg(*[ast.func_wrap(arg) for arg in args])
 
 
+def approx_count_distinct(*args):
+    return ast.ApproxCountDistinct(*[ast.func_wrap(arg) for arg in args])
+
+
+def approx_quantile(*args):
+    return ast.ApproxQuantile(*[ast.func_wrap(arg) for arg in args])
+
+
 def min(*args):
     return ast.Min(*[ast.func_wrap(arg) for arg in args])
 
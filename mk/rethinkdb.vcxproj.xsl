@@ -176,7 +176,7 @@
             <xsl:choose>
               <xsl:when test="/config/unittest">
                 <xsl:message>UNIT</xsl:message>
-                <xsl:attribute name="Exclude">src\main.cc</xsl:attribute>
+                <xsl:attribute name="Exclude">src\main.cc;src\unittest\bench\main.cc</xsl:attribute>
               </xsl:when>
               <xsl:otherwise>
                 <xsl:message>NOUNIT</xsl:message>
@@ -1,6 +1,7 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "arch/arch.hpp"
 
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/coroutines.hpp"
 
 struct io_coroutine_adapter_t : public iocallback_t {
@@ -12,6 +13,7 @@ struct io_coroutine_adapter_t : public iocallback_t {
 };
 
 void co_read(file_t *file, int64_t offset, size_t length, void *buf, file_account_t *account) {
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::disk);
     io_coroutine_adapter_t adapter;
     file->read_async(offset, length, buf, account, &adapter);
     coro_t::wait();
@@ -19,6 +21,7 @@ void co_read(file_t *file, int64_t offset, size_t length, void *buf, file_accoun
 
 void co_write(file_t *file, int64_t offset, size_t length, void *buf,
               file_account_t *account, datasync_op datasync) {
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::disk);
     io_coroutine_adapter_t adapter;
     file->write_async(offset, length, buf, account, &adapter, datasync);
     coro_t::wait();
@@ -8,6 +8,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <libgen.h>
 #endif
 
@@ -22,6 +23,7 @@
 #include "arch/runtime/runtime.hpp"
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk/pool.hpp"
+#include "arch/io/disk/uring.hpp"
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
@@ -31,6 +33,42 @@
 #include "logger.hpp"
 #include "utils.hpp"
 
+#ifdef _WIN32
+bool mapped_range_is_resident(UNUSED const char *data, UNUSED size_t length) {
+    return false;
+}
+#else
+bool mapped_range_is_resident(const char *data, size_t length) {
+    const uintptr_t page_size = getpagesize();
+    const uintptr_t start = floor_aligned(reinterpret_cast<uintptr_t>(data), page_size);
+    const uintptr_t end = ceil_aligned(reinterpret_cast<uintptr_t>(data) + length,
+                                       page_size);
+    const size_t num_pages = (end - start) / page_size;
+#ifdef __MACH__
+    typedef char mincore_vec_t;
+#else
+    typedef unsigned char mincore_vec_t;
+#endif
+    // Blocks are at most a few pages long.
+    mincore_vec_t stack_vec[16];
+    scoped_array_t<mincore_vec_t> heap_vec;
+    mincore_vec_t *vec = stack_vec;
+    if (num_pages > sizeof(stack_vec)) {
+        heap_vec.init(num_pages);
+        vec = heap_vec.data();
+    }
+    if (mincore(reinterpret_cast<void *>(start), end - start, vec) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < num_pages; ++i) {
+        if ((vec[i] & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
 void verify_aligned_file_access(DEBUG_VAR int64_t file_size, DEBUG_VAR int64_t offset,
                                 DEBUG_VAR size_t length,
                                 DEBUG_VAR const scoped_array_t<iovec> &bufs);
@@ -50,14 +88,38 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         io_backend_mode_t backend_mode,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
-        accounter(batch_factor),
+        accounter(batch_factor, stats),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        /* Set up the backend that actually talks to the OS. */
+        std::function<void(pool_diskmgr_t::action_t *)> backend_done_fun =
+            std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        bool use_uring = false;
+        if (backend_mode == io_backend_mode_t::io_uring) {
+            use_uring = io_uring_is_supported();
+            if (!use_uring) {
+                logWRN("io_uring is not supported on this system. Falling back to the "
+                       "thread pool I/O backend.");
+            }
+        }
+#if USE_IO_URING
+        if (use_uring) {
+            uring_backend.init(new uring_diskmgr_t(
+                queue, backend_stats.producer, max_concurrent_io_requests));
+            uring_backend->done_fun = backend_done_fun;
+        }
+#endif
+        if (!use_uring) {
+            pool_backend.init(new pool_diskmgr_t(
+                queue, backend_stats.producer, max_concurrent_io_requests));
+            pool_backend->done_fun = backend_done_fun;
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -67,7 +129,6 @@ public:
                                                  &accounter, ph::_1);
 
         /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -81,8 +142,9 @@ public:
                 outstanding_txn);
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(int pri, int outstanding_requests_limit, io_class_t io_class) {
+        return new accounting_diskmgr_t::account_t(
+            &accounter, pri, outstanding_requests_limit, io_class);
     }
 
     void destroy_account(void *account) {
@@ -126,6 +188,19 @@ public:
                                a));
     }
 
+    void submit_discard(fd_t fd, int64_t offset, int64_t length,
+                        void *account, linux_iocallback_t *cb) {
+        threadnum_t calling_thread = get_thread_id();
+
+        action_t *a = new action_t(calling_thread, cb);
+        a->make_discard(fd, offset, length);
+        a->account = static_cast<accounting_diskmgr_t::account_t *>(account);
+
+        do_on_thread(home_thread(),
+                     std::bind(&linux_disk_manager_t::submit_action_to_stack_stats, this,
+                               a));
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined.  Did you include pool.hpp?"
 #elif USE_WRITEV
@@ -180,7 +255,9 @@ private:
     holding back operations that must be run after other, currently-running, operations.
     Then it goes to the account manager, which queues up running IO operations according
     to which account they are part of. Finally the "backend" pops the IO operations
-    from the queue.
+    from the queue. The backend is either a `pool_diskmgr_t` or, if io_uring was
+    requested and is available, a `uring_diskmgr_t`; exactly one of
+    `pool_backend` and `uring_backend` is set.
 
     At two points in the process--once as soon as it is submitted, and again right
     as the backend pops it off the queue--its statistics are recorded. The "stack stats"
@@ -193,7 +270,10 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+#if USE_IO_URING
+    scoped_ptr_t<uring_diskmgr_t> uring_backend;
+#endif
 
 
     intptr_t outstanding_txn;
@@ -202,11 +282,13 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               io_backend_mode_t backend_mode)
     : direct_io_mode(_direct_io_mode),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
+                                       backend_mode,
                                        &stats)) { }
 
 io_backender_t::~io_backender_t() { }
@@ -255,12 +337,39 @@ void linux_file_t::set_file_size(int64_t new_size) {
     file_size = new_size;
 }
 
+void linux_file_t::discard(int64_t offset, int64_t length) {
+    assert_thread();
+    rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
+    rassert(divides(DEVICE_BLOCK_SIZE, offset) && divides(DEVICE_BLOCK_SIZE, length));
+    rassert(offset >= 0 && offset + length <= file_size);
+
+    struct discard_callback_t : public linux_iocallback_t {
+        void on_io_complete() {
+            delete this;
+        }
+
+        void on_io_failure(int errsv, int64_t offset, int64_t length) {
+            // Nothing depends on the space actually being freed.
+            logWRN("Could not discard %" PRIi64 " bytes at offset %" PRIi64 ": %s",
+                   length, offset, errno_string(errsv).c_str());
+            delete this;
+        }
+
+        auto_drainer_t::lock_t lock;
+    };
+    discard_callback_t *callback = new discard_callback_t();
+    callback->lock = file_size_ops_drainer.lock();
+    diskmgr->submit_discard(fd.get(), offset, length, default_account->get_account(),
+                            callback);
+}
+
 // For growing in large chunks at a time.
 int64_t chunk_factor(int64_t size, int64_t extent_size) {
     // x is at most 12.5% of size. Overall we align to chunks no larger than 64 extents.
-    // This ratio was increased from 6.25% for performance reasons.  Resizing a file
-    // (with ftruncate) doesn't actually use disk space, so it's OK if we pick a value
-    // that's too big.
+    // This ratio was increased from 6.25% for performance reasons.  Growing the file
+    // preallocates the new space where the file system supports it, so a chunk that's
+    // too big costs some disk space until we write to it, but it keeps the file in few
+    // large pieces.
 
     // We round off at an extent_size because it would be silly to allocate a partial
     // extent.
@@ -369,9 +478,38 @@ bool linux_file_t::coop_lock_and_check() {
 #endif
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
+#ifdef _WIN32
+// TODO WINDOWS
+const char *linux_file_t::map_read_only(UNUSED int64_t offset, UNUSED size_t length) {
+    return nullptr;
+}
+
+void linux_file_t::unmap(UNUSED const char *data, UNUSED size_t length) {
+    unreachable();
+}
+#else
+const char *linux_file_t::map_read_only(int64_t offset, size_t length) {
+    if (!divides(getpagesize(), offset)) {
+        return nullptr;
+    }
+    void *res = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd.get(), offset);
+    if (res == MAP_FAILED) {
+        logWRN("Could not map part of a file for reading (%s), reading it the "
+               "normal way instead.", errno_string(get_errno()).c_str());
+        return nullptr;
+    }
+    return static_cast<const char *>(res);
+}
+
+void linux_file_t::unmap(const char *data, size_t length) {
+    guarantee_err(munmap(const_cast<char *>(data), length) == 0, "munmap failed");
+}
+#endif
+
+void *linux_file_t::create_account(int priority, int outstanding_requests_limit,
+                                   io_class_t io_class) {
     assert_thread();
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+    return diskmgr->create_account(priority, outstanding_requests_limit, io_class);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -28,8 +28,11 @@ public:
     // This takes what is effectively a global flag whether to use O_DIRECT here.  Nothing technical
     // stops us from specifying this on a file-by-file basis, but right now there's no desire for
     // that.  See https://github.com/rethinkdb/rethinkdb/issues/97#issuecomment-19778177 .
+    // `backend_mode` selects the disk manager at the bottom of the I/O stack.  If
+    // io_uring is requested but not available, we fall back to the thread pool.
     io_backender_t(file_direct_io_mode_t direct_io_mode,
-                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS);
+                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                   io_backend_mode_t backend_mode = io_backend_mode_t::pool);
     ~io_backender_t();
     linux_disk_manager_t *get_diskmgr_ptr() { return diskmgr.get(); }
     file_direct_io_mode_t get_direct_io_mode() const;
@@ -72,6 +75,7 @@ public:
     int64_t get_file_size();
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size, int64_t extent_size);
+    void discard(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf, file_account_t *account,
                     linux_iocallback_t *cb);
@@ -85,7 +89,11 @@ public:
 
     bool coop_lock_and_check();
 
-    void *create_account(int priority, int outstanding_requests_limit);
+    const char *map_read_only(int64_t offset, size_t length);
+    void unmap(const char *data, size_t length);
+
+    void *create_account(int priority, int outstanding_requests_limit,
+                         io_class_t io_class);
     void destroy_account(void *account);
 
     ~linux_file_t();
@@ -120,6 +128,10 @@ NORETURN void crash_due_to_inaccessible_database_file(const char *path, file_ope
 // file size, and that buf is not null.
 void verify_aligned_file_access(int64_t file_size, int64_t offset, size_t length, const void *buf);
 
+// Whether all of the given part of a memory mapping is in memory, so that reading it
+// won't block on a page fault.
+bool mapped_range_is_resident(const char *data, size_t length);
+
 // Makes blocking syscalls.  Upon error, returns the errno value.
 int perform_datasync(fd_t fd);
 
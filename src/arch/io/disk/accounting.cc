@@ -11,9 +11,10 @@ struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_
 
     accounting_diskmgr_eager_account_t(accounting_diskmgr_t *par,
                                        int pri,
-                                       int outstanding_requests_limit) :
+                                       int outstanding_requests_limit,
+                                       io_class_t io_class) :
         outstanding_requests_limiter(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS ? SEMAPHORE_NO_LIMIT : outstanding_requests_limit),
-        account(&par->queue, &queue, pri),
+        account(par->get_queue(io_class), &queue, pri),
         accounter_lock(par->get_auto_drainer()) {
         rassert(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS || outstanding_requests_limit > 0);
     }
@@ -49,9 +50,11 @@ private:
 
 accounting_diskmgr_account_t::accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                                            int _pri,
-                                                           int _outstanding_requests_limit)
+                                                           int _outstanding_requests_limit,
+                                                           io_class_t _io_class)
         : par(_par), pri(_pri),
-          outstanding_requests_limit(_outstanding_requests_limit) { }
+          outstanding_requests_limit(_outstanding_requests_limit),
+          io_class(_io_class) { }
 
 accounting_diskmgr_account_t::~accounting_diskmgr_account_t() {
     par->assert_thread();
@@ -83,7 +86,8 @@ co_semaphore_t *accounting_diskmgr_account_t::get_outstanding_requests_limiter()
 void accounting_diskmgr_account_t::maybe_init(){
     if (!eager_account.has()) {
         par->assert_thread();
-        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit));
+        eager_account.init(
+            new eager_account_t(par, pri, outstanding_requests_limit, io_class));
     }
 }
 
@@ -99,19 +103,133 @@ void debug_print(printf_buffer_t *buf,
 }
 
 
+accounting_diskmgr_t::io_class_queue_t::io_class_queue_t(
+        accounting_diskmgr_t *_parent, int batch_factor, ticks_t _target_latency,
+        perfmon_collection_t *stats, const std::string &name)
+    : parent(_parent),
+      queue(batch_factor),
+      target_latency(_target_latency),
+      waiting_since(get_ticks()),
+      in_flight(0),
+      wait_time_membership(stats, &wait_time, name.c_str()) {
+    queue.available->set_callback(this);
+}
+
+void accounting_diskmgr_t::io_class_queue_t::on_source_availability_changed() {
+    if (queue.available->get()) {
+        waiting_since = get_ticks();
+    }
+    parent->update_availability();
+}
+
+accounting_diskmgr_t::accounting_diskmgr_t(int batch_factor,
+                                           perfmon_collection_t *stats)
+    : passive_producer_t<accounting_payload_t *>(&available_control),
+      producer(this),
+      auto_drainer(new auto_drainer_t()) {
+    const struct {
+        io_class_t io_class;
+        int64_t target_latency_ms;
+        const char *name;
+    } classes[NUM_IO_CLASSES] = {
+        { io_class_t::foreground_read, IO_FOREGROUND_READ_TARGET_LATENCY_MS,
+          "queue_wait_foreground_read" },
+        { io_class_t::foreground_write, IO_FOREGROUND_WRITE_TARGET_LATENCY_MS,
+          "queue_wait_foreground_write" },
+        { io_class_t::background, IO_BACKGROUND_TARGET_LATENCY_MS,
+          "queue_wait_background" }
+    };
+    for (size_t i = 0; i < NUM_IO_CLASSES; ++i) {
+        guarantee(static_cast<size_t>(classes[i].io_class) == i);
+        class_queues[i].init(new io_class_queue_t(
+            this, batch_factor,
+            ticks_t{classes[i].target_latency_ms * MILLION}, stats, classes[i].name));
+    }
+}
+
 accounting_diskmgr_t::~accounting_diskmgr_t() {
     auto_drainer.reset();  // Make absolutely sure this happens first.
+    for (size_t i = 0; i < NUM_IO_CLASSES; ++i) {
+        class_queues[i]->queue.available->unset_callback();
+    }
 }
 
 void accounting_diskmgr_t::submit(action_t *a) {
+    a->queued_time = get_ticks();
     a->account->push(a);
 }
 
 void accounting_diskmgr_t::done(accounting_payload_t *p) {
     // p really is an action_t...
     action_t *a = static_cast<action_t *>(p);
+    io_class_queue_t *class_queue =
+        class_queues[static_cast<size_t>(a->account->get_io_class())].get();
+    guarantee(class_queue->in_flight > 0);
+    --class_queue->in_flight;
     a->account->get_outstanding_requests_limiter()->unlock(1);
     a->account_acq.reset();
+    update_availability();
     done_fun(static_cast<action_t *>(p));
 }
 
+bool accounting_diskmgr_t::can_send(size_t i, ticks_t now) const {
+    const io_class_queue_t *class_queue = class_queues[i].get();
+    if (!class_queue->queue.available->get()) {
+        return false;
+    }
+    if (i != static_cast<size_t>(io_class_t::background) ||
+            class_queue->in_flight < IO_BACKGROUND_MAX_IN_FLIGHT_UNDER_LOAD ||
+            now.nanos - class_queue->waiting_since.nanos
+                > class_queue->target_latency.nanos) {
+        return true;
+    }
+    for (size_t j = 0; j < i; ++j) {
+        if (class_queues[j]->in_flight > 0 || class_queues[j]->queue.available->get()) {
+            // The foreground is busy, so we hold the background requests back.
+            return false;
+        }
+    }
+    return true;
+}
+
+void accounting_diskmgr_t::update_availability() {
+    const ticks_t now = get_ticks();
+    bool available = false;
+    for (size_t i = 0; i < NUM_IO_CLASSES && !available; ++i) {
+        available = can_send(i, now);
+    }
+    available_control.set_available(available);
+}
+
+accounting_payload_t *accounting_diskmgr_t::produce_next_value() {
+    assert_thread();
+    const ticks_t now = get_ticks();
+    // The most urgent class that has waited for longer than its target latency goes
+    // first; if no class is late, the most urgent one that has requests does.
+    size_t chosen = NUM_IO_CLASSES;
+    for (size_t i = 0; i < NUM_IO_CLASSES; ++i) {
+        if (can_send(i, now) && now.nanos - class_queues[i]->waiting_since.nanos
+                > class_queues[i]->target_latency.nanos) {
+            chosen = i;
+            break;
+        }
+    }
+    if (chosen == NUM_IO_CLASSES) {
+        for (size_t i = 0; i < NUM_IO_CLASSES; ++i) {
+            if (can_send(i, now)) {
+                chosen = i;
+                break;
+            }
+        }
+    }
+    guarantee(chosen != NUM_IO_CLASSES);
+
+    io_class_queue_t *class_queue = class_queues[chosen].get();
+    class_queue->waiting_since = now;
+    ++class_queue->in_flight;
+    action_t *a = class_queue->queue.pop();
+    class_queue->wait_time.record_since(a->queued_time);
+    update_availability();
+    return a;
+}
+
@@ -3,6 +3,7 @@
 #define ARCH_IO_DISK_ACCOUNTING_HPP_
 
 #include <functional>
+#include <string>
 
 #include "containers/intrusive_list.hpp"
 #include "containers/scoped.hpp"
@@ -10,29 +11,24 @@
 #include "concurrency/queue/accounting.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
 #include "concurrency/semaphore.hpp"
+#include "perfmon/perfmon.hpp"
+#include "time.hpp"
 #include "arch/io/disk.hpp"
 #include "arch/io/disk/stats_2.hpp"
 
-/* `casting_passive_producer_t` is useful when you have a
-`passive_producer_t<X>` but you need a `passive_producer_t<Y>`, where `X` can
-be cast to `Y`. */
+/* `accounting_diskmgr_t` decides which request goes to the disk next.  Every account
+belongs to an `io_class_t`.  Within a class, the accounts share the disk throughput
+proportionally to their priorities.  Between the classes, the most urgent class that
+has requests waiting goes first, unless a less urgent class has been waiting for longer
+than its target latency, in which case that one gets the next slot.  So a point read
+doesn't queue behind a burst of GC writes, and GC still makes progress.
 
-template <class input_t, class output_t>
-struct casting_passive_producer_t : public passive_producer_t<output_t> {
-    explicit casting_passive_producer_t(passive_producer_t<input_t> *_source) :
-        passive_producer_t<output_t>(_source->available), source(_source) { }
+While foreground requests are waiting or in flight, only
+`IO_BACKGROUND_MAX_IN_FLIGHT_UNDER_LOAD` background requests get sent to the disk at a
+time; otherwise background requests can use the whole queue depth of the backend.
 
-    output_t produce_next_value() {
-        /* Implicit cast from `input_t` to `output_t` in return */
-        return source->pop();
-    }
-
-private:
-    passive_producer_t<input_t> *source;
-};
-
-/* `accounting_diskmgr_t` shares disk throughput proportionally between a
-number of different "accounts". */
+The time the requests of each class wait in here goes into a histogram in the disk
+manager's stats. */
 
 typedef stats_diskmgr_2_t::action_t accounting_payload_t;
 
@@ -47,7 +43,8 @@ struct accounting_diskmgr_account_t {
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                  int _pri,
-                                 int _outstanding_requests_limit);
+                                 int _outstanding_requests_limit,
+                                 io_class_t _io_class);
 
     ~accounting_diskmgr_account_t();
 
@@ -55,6 +52,8 @@ struct accounting_diskmgr_account_t {
     void on_semaphore_available();
     co_semaphore_t *get_outstanding_requests_limiter();
 
+    io_class_t get_io_class() const { return io_class; }
+
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
 
@@ -63,6 +62,7 @@ private:
     accounting_diskmgr_t *par;
     int pri;
     int outstanding_requests_limit;
+    io_class_t io_class;
     scoped_ptr_t<eager_account_t> eager_account;
     // A scoped pointer because we create the drainer lazily on first use.
     scoped_ptr_t<auto_drainer_t> requests_drainer;
@@ -75,18 +75,18 @@ struct accounting_diskmgr_action_t
       public accounting_payload_t {
     accounting_diskmgr_account_t *account;
     auto_drainer_t::lock_t account_acq;
+    // When the action got submitted to the `accounting_diskmgr_t`.
+    ticks_t queued_time;
 };
 
 void debug_print(printf_buffer_t *buf,
                  const accounting_diskmgr_action_t &action);
 
-class accounting_diskmgr_t : public home_thread_mixin_t {
+class accounting_diskmgr_t
+    : public home_thread_mixin_t,
+      private passive_producer_t<accounting_payload_t *> {
 public:
-    explicit accounting_diskmgr_t(int batch_factor)
-        : producer(&caster),
-          queue(batch_factor),
-          caster(&queue),
-          auto_drainer(new auto_drainer_t()) { }
+    accounting_diskmgr_t(int batch_factor, perfmon_collection_t *stats);
 
     ~accounting_diskmgr_t();
 
@@ -108,8 +108,34 @@ public:
 private:
     friend struct accounting_diskmgr_eager_account_t;
 
-    accounting_queue_t<action_t *> queue;
-    casting_passive_producer_t<action_t *, accounting_payload_t *> caster;
+    /* The accounts of one `io_class_t`. */
+    struct io_class_queue_t : public availability_callback_t {
+        io_class_queue_t(accounting_diskmgr_t *parent, int batch_factor,
+                         ticks_t target_latency, perfmon_collection_t *stats,
+                         const std::string &name);
+        void on_source_availability_changed();
+
+        accounting_diskmgr_t *const parent;
+        accounting_queue_t<action_t *> queue;
+        const ticks_t target_latency;
+        // When the class last got a request sent to the disk, or when it started
+        // having requests, whichever is later.
+        ticks_t waiting_since;
+        int64_t in_flight;
+        perfmon_histogram_t wait_time;
+        perfmon_membership_t wait_time_membership;
+    };
+
+    accounting_queue_t<action_t *> *get_queue(io_class_t io_class) {
+        return &class_queues[static_cast<size_t>(io_class)]->queue;
+    }
+    // Whether the next request may come from `class_queues[i]`.
+    bool can_send(size_t i, ticks_t now) const;
+    void update_availability();
+    accounting_payload_t *produce_next_value();
+
+    availability_control_t available_control;
+    scoped_ptr_t<io_class_queue_t> class_queues[NUM_IO_CLASSES];
     scoped_ptr_t<auto_drainer_t> auto_drainer;
 
     DISABLE_COPYING(accounting_diskmgr_t);
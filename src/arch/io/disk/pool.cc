@@ -171,10 +171,26 @@ void pool_diskmgr_t::action_t::run() {
         io_result = 0;
 #else
         CT_ASSERT(sizeof(off_t) == sizeof(int64_t));
-        int res;
-        do {
-            res = ftruncate(fd, offset);
-        } while (res == -1 && get_errno() == EINTR);
+        int res = -1;
+#ifdef __linux__
+        if (size_change > 0) {
+            // Allocate the new space right away, so that the file system can lay it
+            // out in one piece instead of block by block as we write it.  Not every
+            // file system can do that, in which case we just set the size.
+            do {
+                res = fallocate(fd, 0, offset - size_change, size_change);
+            } while (res == -1 && get_errno() == EINTR);
+            if (res == -1 && get_errno() != EOPNOTSUPP && get_errno() != ENOSYS) {
+                io_result = -get_errno();
+                return;
+            }
+        }
+#endif
+        if (res != 0) {
+            do {
+                res = ftruncate(fd, offset);
+            } while (res == -1 && get_errno() == EINTR);
+        }
         if (res == 0) {
             io_result = 0;
         } else {
@@ -183,6 +199,21 @@ void pool_diskmgr_t::action_t::run() {
         }
 #endif
     } break;
+    case ACTION_DISCARD: {
+#ifdef __linux__
+        int res;
+        do {
+            res = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                            offset, buf_and_count.iov_len);
+        } while (res == -1 && get_errno() == EINTR);
+        // A discard is only a hint, so it's fine if the file system can't do it.
+        if (res == -1 && get_errno() != EOPNOTSUPP && get_errno() != ENOSYS) {
+            io_result = -get_errno();
+            return;
+        }
+#endif
+        io_result = buf_and_count.iov_len;
+    } break;
     case ACTION_READ:
     case ACTION_WRITE: {
         // Copy the io vectors because perform_read_write will modify them
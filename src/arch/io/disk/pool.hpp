@@ -22,6 +22,7 @@
 struct iovec;
 class pool_diskmgr_t;
 class printf_buffer_t;
+class uring_diskmgr_t;
 
 /* The pool disk manager uses a thread pool in conjunction with synchronous
 (blocking) IO calls to asynchronously run IO requests. */
@@ -52,6 +53,18 @@ struct pool_diskmgr_action_t
         size_change = _new_size - _old_size;
     }
 
+    // Tells the file system that the range doesn't hold data anymore, so it can give
+    // the space (and, with a discard mount option, the SSD blocks) back.
+    void make_discard(fd_t _fd, int64_t _offset, size_t _count) {
+        type = ACTION_DISCARD;
+        ds_op = datasync_op::no_datasyncs;
+        fd = _fd;
+        buf_and_count.iov_base = nullptr;
+        buf_and_count.iov_len = _count;
+        offset = _offset;
+        size_change = 0;
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined... but we are in pool.hpp.  Where is it?"
 #elif USE_WRITEV
@@ -79,6 +92,7 @@ struct pool_diskmgr_action_t
 
     bool get_is_write() const { return type == ACTION_WRITE; }
     bool get_is_resize() const { return type == ACTION_RESIZE; }
+    bool get_is_discard() const { return type == ACTION_DISCARD; }
     bool get_is_read() const { return type == ACTION_READ; }
     fd_t get_fd() const { return fd; }
     void get_bufs(iovec **iovecs_out, size_t *iovecs_len_out) {
@@ -103,17 +117,18 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class uring_diskmgr_t;
     pool_diskmgr_t *parent;
 
-    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
+    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE, ACTION_DISCARD};
     action_type_t type;
     datasync_op ds_op;
     fd_t fd;
 
-    // Either type is ACTION_RESIZE, or buf_and_count.iov_base is used, or iovecs
-    // is used (for writev).  If iovecs is used, then buf_and_count.iov_len is the
-    // sum of the iovecs' iov_len fields.  Currently readv is not supported, but if
-    // you need it, it should be easy to add.
+    // Either type is ACTION_RESIZE or ACTION_DISCARD, or buf_and_count.iov_base is
+    // used, or iovecs is used (for writev).  If iovecs is used, then
+    // buf_and_count.iov_len is the sum of the iovecs' iov_len fields.  Currently readv
+    // is not supported, but if you need it, it should be easy to add.
     scoped_array_t<iovec> iovecs;
     iovec buf_and_count;
     int64_t offset;
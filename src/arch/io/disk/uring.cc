@@ -0,0 +1,421 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if USE_IO_URING
+
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/system_event/eventfd.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+#include "utils.hpp"
+
+// Older C libraries don't know the io_uring system calls yet. The numbers are the
+// same on every architecture that uses the generic syscall table, including x86_64.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params *p) {
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   nullptr, 0);
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void *arg,
+                          unsigned nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// Each action takes at most three SQEs: a leading fsync, the read or write itself,
+// and a trailing fsync.
+const uint32_t MAX_SQES_PER_ACTION = 3;
+
+// There is no point in making the rings huge, the device queue is much shallower.
+const uint32_t MAX_URING_ENTRIES = 4096;
+
+// Set in the `user_data` of fsync SQEs, so that we can tell their completions apart
+// from the completion of the data transfer.
+const uint64_t SYNC_TAG = 1;
+
+uint32_t uring_entries_for_queue_depth(int queue_depth) {
+    uint32_t wanted = static_cast<uint32_t>(
+        std::min<int64_t>(static_cast<int64_t>(queue_depth) * MAX_SQES_PER_ACTION,
+                          MAX_URING_ENTRIES));
+    uint32_t entries = 1;
+    while (entries < wanted) {
+        entries <<= 1;
+    }
+    return entries;
+}
+
+}  // namespace
+
+bool io_uring_is_supported() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = sys_io_uring_setup(1, &params);
+    if (fd < 0) {
+        return false;
+    }
+    scoped_fd_t ring_fd(fd);
+
+    // Registering an eventfd needs Linux 5.2. We rely on it to learn about
+    // completions from the event queue.
+    int efd = eventfd(0, 0);
+    if (efd < 0) {
+        return false;
+    }
+    scoped_fd_t event_fd(efd);
+    return sys_io_uring_register(ring_fd.get(), IORING_REGISTER_EVENTFD, &efd, 1) == 0;
+}
+
+/* Bookkeeping for an action whose SQEs are currently owned by the kernel. */
+class uring_inflight_t {
+public:
+    explicit uring_inflight_t(pool_diskmgr_action_t *_action)
+        : action(_action), cqes_left(0), data_result(0), sync_errno(0) { }
+
+    pool_diskmgr_action_t *action;
+    // How many completions we are still waiting for.
+    uint32_t cqes_left;
+    // The result of the read or write SQE.
+    int64_t data_result;
+    // The first error reported by one of the fsync SQEs, or 0.
+    int sync_errno;
+};
+
+class uring_diskmgr_t::fallback_job_t : public blocker_pool_t::job_t {
+public:
+    fallback_job_t(uring_diskmgr_t *_parent, action_t *_action)
+        : parent(_parent), action(_action) { }
+
+    void run() {
+        // `pool_diskmgr_action_t::run()` performs the whole operation, including
+        // any datasyncs, with blocking system calls.
+        static_cast<blocker_pool_t::job_t *>(action)->run();
+    }
+
+    void done() {
+        parent->on_fallback_done(this);
+    }
+
+    uring_diskmgr_t *const parent;
+    action_t *const action;
+};
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue_depth(std::min<int>(max_concurrent_io_requests * 2,
+                                MAX_URING_ENTRIES / MAX_SQES_PER_ACTION)),
+      n_pending(0),
+      source(_source),
+      queue(_queue),
+      local_sq_tail(0),
+      unsubmitted_sqes(0),
+      sqes_in_flight(0),
+      fallback_pool(1, _queue) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(max_concurrent_io_requests < MAXIMUM_MAX_CONCURRENT_IO_REQUESTS);
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = sys_io_uring_setup(uring_entries_for_queue_depth(queue_depth), &params);
+    guarantee_err(fd >= 0, "Could not set up io_uring");
+    ring_fd.reset(fd);
+    sq_entries = params.sq_entries;
+    cq_entries = params.cq_entries;
+    guarantee(sq_entries >= MAX_SQES_PER_ACTION);
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQ_RING);
+    guarantee_err(sq_ring != MAP_FAILED, "Could not map the io_uring submission ring");
+    if (single_mmap) {
+        cq_ring = sq_ring;
+    } else {
+        cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_CQ_RING);
+        guarantee_err(cq_ring != MAP_FAILED,
+                      "Could not map the io_uring completion ring");
+    }
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQES);
+    guarantee_err(sqes != MAP_FAILED, "Could not map the io_uring submission entries");
+
+    char *sq_base = static_cast<char *>(sq_ring);
+    sq_head = reinterpret_cast<uint32_t *>(sq_base + params.sq_off.head);
+    sq_tail = reinterpret_cast<uint32_t *>(sq_base + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<uint32_t *>(sq_base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<uint32_t *>(sq_base + params.sq_off.array);
+    local_sq_tail = *sq_tail;
+
+    char *cq_base = static_cast<char *>(cq_ring);
+    cq_head = reinterpret_cast<uint32_t *>(cq_base + params.cq_off.head);
+    cq_tail = reinterpret_cast<uint32_t *>(cq_base + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<uint32_t *>(cq_base + params.cq_off.ring_mask);
+    cqes = cq_base + params.cq_off.cqes;
+
+    int efd = completion_event.get_notify_fd();
+    int res = sys_io_uring_register(ring_fd.get(), IORING_REGISTER_EVENTFD, &efd, 1);
+    guarantee_err(res == 0, "Could not register an eventfd with io_uring");
+    queue->watch_event(&completion_event, this);
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    // Like `blocker_pool_t`, we must not be destroyed with requests outstanding.
+    rassert(n_pending == 0);
+    source->available->unset_callback();
+    queue->forget_event(&completion_event, this);
+
+    munmap(sqes, sqes_size);
+    if (cq_ring != sq_ring) {
+        munmap(cq_ring, cq_ring_size);
+    }
+    munmap(sq_ring, sq_ring_size);
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+    reap_completions();
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get()
+           && n_pending < queue_depth
+           && sqes_in_flight + MAX_SQES_PER_ACTION <= sq_entries) {
+        action_t *a = source->pop();
+        n_pending++;
+        if (!prepare_sqes(a)) {
+            run_in_fallback(a);
+        }
+    }
+    submit_prepared();
+}
+
+bool uring_diskmgr_t::prepare_sqes(action_t *a) {
+    if (a->get_is_resize() || a->get_is_discard()) {
+        return false;
+    }
+    iovec *vecs;
+    size_t vecs_len;
+    a->get_bufs(&vecs, &vecs_len);
+    if (vecs_len > IOV_MAX) {
+        return false;
+    }
+
+    uring_inflight_t *inflight = new uring_inflight_t(a);
+    const uint64_t data_tag = reinterpret_cast<uintptr_t>(inflight);
+    const uint64_t sync_tag = data_tag | SYNC_TAG;
+    rassert((data_tag & SYNC_TAG) == 0);
+
+    io_uring_sqe *const sqe_array = static_cast<io_uring_sqe *>(sqes);
+    auto next_sqe = [&]() -> io_uring_sqe * {
+        const uint32_t index = local_sq_tail & sq_mask;
+        io_uring_sqe *sqe = &sqe_array[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        ++local_sq_tail;
+        ++unsubmitted_sqes;
+        ++sqes_in_flight;
+        ++inflight->cqes_left;
+        return sqe;
+    };
+    auto prep_datasync = [&](io_uring_sqe *sqe) {
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = a->get_fd();
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = sync_tag;
+    };
+
+    // `IOSQE_IO_LINK` makes the kernel start each SQE only once the previous one in
+    // the chain has completed successfully, which gives us the same ordering as the
+    // blocking syscalls in `pool_diskmgr_action_t::run()`.
+    if (a->ds_op == datasync_op::wrap_in_datasyncs) {
+        io_uring_sqe *sqe = next_sqe();
+        prep_datasync(sqe);
+        sqe->flags |= IOSQE_IO_LINK;
+    }
+
+    io_uring_sqe *data_sqe = next_sqe();
+    data_sqe->opcode = a->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+    data_sqe->fd = a->get_fd();
+    data_sqe->off = a->get_offset();
+    data_sqe->addr = reinterpret_cast<uintptr_t>(vecs);
+    data_sqe->len = vecs_len;
+    data_sqe->user_data = data_tag;
+
+    if (a->ds_op == datasync_op::wrap_in_datasyncs
+        || a->ds_op == datasync_op::datasync_after) {
+        data_sqe->flags |= IOSQE_IO_LINK;
+        prep_datasync(next_sqe());
+    }
+    return true;
+}
+
+void uring_diskmgr_t::submit_prepared() {
+    if (unsubmitted_sqes == 0) {
+        return;
+    }
+    // Publish the new SQEs to the kernel before telling it about them.
+    __atomic_store_n(sq_tail, local_sq_tail, __ATOMIC_RELEASE);
+
+    while (unsubmitted_sqes > 0) {
+        int res = sys_io_uring_enter(ring_fd.get(), unsubmitted_sqes, 0, 0);
+        if (res >= 0) {
+            unsubmitted_sqes -= res;
+            if (res == 0) {
+                break;
+            }
+        } else if (get_errno() == EINTR) {
+            continue;
+        } else if (get_errno() == EAGAIN || get_errno() == EBUSY) {
+            // The kernel is short on resources. If anything is in flight, we'll
+            // try again once its completions have been reaped. Otherwise there's
+            // nothing to wait for, so we just keep retrying.
+            if (sqes_in_flight > unsubmitted_sqes) {
+                break;
+            }
+        } else {
+            crash("io_uring_enter failed: %s", errno_string(get_errno()).c_str());
+        }
+    }
+}
+
+void uring_diskmgr_t::reap_completions() {
+    assert_thread();
+    struct completion_t {
+        uint64_t user_data;
+        int32_t res;
+    };
+    std::vector<completion_t> completions;
+
+    // Only this thread ever writes the CQ head, so a plain read is fine for it.
+    uint32_t head = *cq_head;
+    const uint32_t tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    const io_uring_cqe *const cqe_array = static_cast<const io_uring_cqe *>(cqes);
+    completions.reserve(tail - head);
+    while (head != tail) {
+        const io_uring_cqe &cqe = cqe_array[head & cq_mask];
+        completions.push_back(completion_t{cqe.user_data, cqe.res});
+        ++head;
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+    for (const completion_t &c : completions) {
+        uring_inflight_t *inflight =
+            reinterpret_cast<uring_inflight_t *>(c.user_data & ~SYNC_TAG);
+        if ((c.user_data & SYNC_TAG) != 0) {
+            // A cancelled fsync means an earlier SQE in its chain failed; that
+            // failure is what we want to report.
+            if (c.res < 0 && c.res != -ECANCELED && inflight->sync_errno == 0) {
+                inflight->sync_errno = -c.res;
+            }
+        } else {
+            inflight->data_result = c.res;
+        }
+        guarantee(sqes_in_flight > 0);
+        --sqes_in_flight;
+        guarantee(inflight->cqes_left > 0);
+        if (--inflight->cqes_left == 0) {
+            finish(inflight);
+        }
+    }
+
+    // Some SQEs might be left over from an `EBUSY` earlier on.
+    submit_prepared();
+    pump();
+}
+
+void uring_diskmgr_t::finish(uring_inflight_t *inflight) {
+    action_t *a = inflight->action;
+    const int64_t data_result = inflight->data_result;
+    const int sync_errno = inflight->sync_errno;
+    delete inflight;
+
+    if (data_result == -ECANCELED && sync_errno != 0) {
+        // The leading datasync failed, so the transfer never started.
+        a->io_result = -sync_errno;
+    } else if (data_result == -EINTR || data_result == -EAGAIN) {
+        run_in_fallback(a);
+        return;
+    } else if (data_result < 0) {
+        a->io_result = data_result;
+    } else if (data_result != static_cast<int64_t>(a->get_count())) {
+        // A short transfer. `pool_diskmgr_action_t::run()` knows how to continue
+        // those, and how to diagnose a full disk or reads past the end of the file.
+        // Redoing the whole operation is harmless, and this is very rare.
+        run_in_fallback(a);
+        return;
+    } else if (sync_errno != 0) {
+        a->io_result = -sync_errno;
+    } else {
+        a->io_result = data_result;
+    }
+
+    n_pending--;
+    done_fun(a);
+}
+
+void uring_diskmgr_t::run_in_fallback(action_t *a) {
+    fallback_pool.do_job(new fallback_job_t(this, a));
+}
+
+void uring_diskmgr_t::on_fallback_done(fallback_job_t *job) {
+    assert_thread();
+    action_t *a = job->action;
+    delete job;
+    n_pending--;
+    pump();
+    done_fun(a);
+}
+
+#else  // USE_IO_URING
+
+bool io_uring_is_supported() {
+    return false;
+}
+
+#endif  // USE_IO_URING
@@ -0,0 +1,121 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#include <functional>
+
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "arch/io/blocker_pool.hpp"
+#include "arch/io/io_utils.hpp"
+#include "arch/io/disk/pool.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "containers/scoped.hpp"
+
+/* io_uring needs Linux 5.1 or newer and an eventfd to wake up the event queue. We
+compile the backend in wherever the kernel headers could provide it and decide at
+runtime whether the running kernel actually supports it. */
+#if defined(__linux__) && !defined(LEGACY_LINUX) && !defined(NO_EVENTFD) \
+    && !defined(NO_IO_URING)
+#define USE_IO_URING 1
+#else
+#define USE_IO_URING 0
+#endif
+
+/* Returns true if io_uring can be used on this system. This makes a throwaway
+`io_uring_setup()` call, so kernels without io_uring support (or with io_uring
+disabled by a seccomp policy) report false. */
+bool io_uring_is_supported();
+
+#if USE_IO_URING
+
+class uring_inflight_t;
+
+/* The io_uring disk manager is a drop-in replacement for `pool_diskmgr_t`. Instead of
+handing each operation to a blocking thread, it writes submission queue entries into a
+ring shared with the kernel from the owning thread, and submits everything it pulled
+off `source` with a single `io_uring_enter()` call. Completions are signalled through an
+eventfd that is registered with the event queue, so they are reaped from the normal
+event loop without any thread hops.
+
+Operations that io_uring can't express (file resizes and discards), and the rare reads
+and writes that come back short, are handed to a one-thread `blocker_pool_t` which
+performs them the same way `pool_diskmgr_t` would. */
+class uring_diskmgr_t :
+    private availability_callback_t,
+    private linux_event_callback_t,
+    public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Same contract as `pool_diskmgr_t`: actions are drawn from `source`, and
+    `done_fun` is called on each one once it has completed. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    class fallback_job_t;
+
+    void on_source_availability_changed();
+    void on_event(int events);
+
+    void pump();
+    void reap_completions();
+
+    /* Fills in between one and three linked SQEs for `a`. Returns false if `a` has to
+    go through the blocker pool instead. */
+    bool prepare_sqes(action_t *a);
+    void submit_prepared();
+
+    void finish(uring_inflight_t *inflight);
+    void run_in_fallback(action_t *a);
+    void on_fallback_done(fallback_job_t *job);
+
+    /* The maximum number of actions we have in flight, and the number of SQEs we are
+    allowed to use for them. */
+    const int queue_depth;
+    int n_pending;
+
+    passive_producer_t<action_t *> *source;
+    linux_event_queue_t *queue;
+
+    scoped_fd_t ring_fd;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+
+    /* The kernel-shared rings. `sq_ring` and `cq_ring` may point into the same
+    mapping when the kernel supports `IORING_FEAT_SINGLE_MMAP`. */
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    void *sqes;
+    size_t sqes_size;
+
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t sq_mask;
+    uint32_t *sq_array;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t cq_mask;
+    void *cqes;
+
+    /* Our local copy of the SQ tail, and the number of SQEs written since the last
+    `io_uring_enter()`. */
+    uint32_t local_sq_tail;
+    uint32_t unsubmitted_sqes;
+    uint32_t sqes_in_flight;
+
+    system_event_t completion_event;
+
+    blocker_pool_t fallback_pool;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif  // USE_IO_URING
+
+#endif  // ARCH_IO_DISK_URING_HPP_
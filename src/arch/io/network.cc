@@ -13,13 +13,19 @@
 #include <iphlpapi.h> // NOLINT
 #else
 #include <arpa/inet.h>
+#include <limits.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/timing.hpp"
@@ -212,7 +218,8 @@ linux_tcp_conn_t::linux_tcp_conn_t(const ip_address_t &peer,
         read_buffer(IO_BUFFER_SIZE),
         write_handler(this),
         write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
-        write_coro_pool(1, &write_queue, &write_handler),
+        // The write handler only pushes buffers into the socket.
+        write_coro_pool(1, &write_queue, &write_handler, coro_stack_class_t::shallow),
         current_write_buffer(get_write_buffer()),
         drainer(new auto_drainer_t) {
 
@@ -253,7 +260,7 @@ linux_tcp_conn_t::linux_tcp_conn_t(fd_t s) :
        read_buffer(IO_BUFFER_SIZE),
        write_handler(this),
        write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
-       write_coro_pool(1, &write_queue, &write_handler),
+       write_coro_pool(1, &write_queue, &write_handler, coro_stack_class_t::shallow),
        current_write_buffer(get_write_buffer()),
        drainer(new auto_drainer_t) {
     rassert(sock.get() != INVALID_FD);
@@ -278,6 +285,18 @@ void linux_tcp_conn_t::enable_keepalive() THROWS_ONLY(tcp_conn_write_closed_exc_
     guarantee_err(res != -1, "Could not set SO_KEEPALIVE option.");
 }
 
+void linux_tcp_conn_t::enable_busy_poll() {
+#ifdef SO_BUSY_POLL
+    const int64_t busy_poll_micros = get_busy_poll_nanos() / 1000;
+    if (busy_poll_micros > 0) {
+        int optval = std::min<int64_t>(busy_poll_micros, INT_MAX);
+        // Values above `net.core.busy_read` need `CAP_NET_ADMIN`.
+        UNUSED int res = setsockopt(sock.get(), SOL_SOCKET, SO_BUSY_POLL,
+                                    &optval, sizeof(optval));
+    }
+#endif
+}
+
 linux_tcp_conn_t::write_buffer_t * linux_tcp_conn_t::get_write_buffer() {
     write_buffer_t *buffer;
 
@@ -315,6 +334,7 @@ void linux_tcp_conn_t::release_write_queue_op(write_queue_op_t *op) {
 size_t linux_tcp_conn_t::read_internal(void *buffer, size_t size) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
     assert_thread();
     rassert(!read_closed.is_pulsed());
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::network);
 
 #ifdef _WIN32
     overlapped_operation_t op(event_watcher.get());
@@ -521,7 +541,9 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != nullptr) {
+    if (operation->slices != nullptr) {
+        parent->perform_write_vectored(operation->slices, operation->num_slices);
+    } else if (operation->buffer != nullptr) {
         parent->perform_write(operation->buffer, operation->size);
         if (operation->dealloc != nullptr) {
             parent->release_write_buffer(operation->dealloc);
@@ -546,6 +568,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
        released once the write is over. */
     op->buffer = current_write_buffer->buffer;
     op->size = current_write_buffer->size;
+    op->slices = nullptr;
     op->dealloc = current_write_buffer.release();
     op->cond = nullptr;
     op->keepalive = auto_drainer_t::lock_t(drainer.get());
@@ -562,6 +585,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
 
 void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
     assert_thread();
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::network);
 
     if (write_closed.is_pulsed()) {
         /* The write end of the connection was closed, but there are still
@@ -601,48 +625,113 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
     while (size > 0) {
         ssize_t res = ::write(sock.get(), buf, size);
 
-        if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
-            /* Wait for a notification from the event queue, or for an order to
-               shut down */
-            linux_event_watcher_t::watch_t watch(event_watcher.get(), poll_event_out);
-            wait_any_t waiter(&watch, &write_closed);
-            waiter.wait_lazily_unordered();
-
-            if (write_closed.is_pulsed()) {
-                /* We were closed for whatever reason. Whatever signalled us has already called
-                   on_shutdown_write(). */
+        if (res <= 0) {
+            if (!handle_failed_write(res)) {
                 break;
             }
+        } else {
+            rassert(res <= static_cast<ssize_t>(size));
+            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
+            size -= res;
+            if (write_perfmon) {
+                write_perfmon->record(res);
+            }
+        }
+    }
+#endif
+}
 
-            /* Go around the loop and try to write again */
+#ifndef _WIN32
+bool linux_tcp_conn_t::handle_failed_write(ssize_t res) {
+    if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
+        /* Wait for a notification from the event queue, or for an order to
+           shut down */
+        linux_event_watcher_t::watch_t watch(event_watcher.get(), poll_event_out);
+        wait_any_t waiter(&watch, &write_closed);
+        waiter.wait_lazily_unordered();
+
+        /* If we were closed for whatever reason, whatever signalled us has already
+           called on_shutdown_write(). Otherwise go around the loop and try to write
+           again. */
+        return !write_closed.is_pulsed();
+
+    } else if (res == -1 && (get_errno() == EPIPE || get_errno() == ENOTCONN || get_errno() == EHOSTUNREACH ||
+                             get_errno() == ENETDOWN || get_errno() == EHOSTDOWN || get_errno() == ECONNRESET)) {
+        /* These errors are expected to happen at some point in practice */
+        on_shutdown_write();
+        return false;
 
-        } else if (res == -1 && (get_errno() == EPIPE || get_errno() == ENOTCONN || get_errno() == EHOSTUNREACH ||
-                                 get_errno() == ENETDOWN || get_errno() == EHOSTDOWN || get_errno() == ECONNRESET)) {
-            /* These errors are expected to happen at some point in practice */
-            on_shutdown_write();
-            break;
+    } else if (res == -1) {
+        /* In theory this should never happen, but it probably will. So we write a log message
+           and then shut down normally. */
+        logERR("Could not write to socket: %s", errno_string(get_errno()).c_str());
+        on_shutdown_write();
+        return false;
 
-        } else if (res == -1) {
-            /* In theory this should never happen, but it probably will. So we write a log message
-               and then shut down normally. */
-            logERR("Could not write to socket: %s", errno_string(get_errno()).c_str());
-            on_shutdown_write();
-            break;
+    } else {
+        /* This should never happen either, but it's better to write an error message than to
+           crash completely. */
+        rassert(res == 0);
+        logERR("Didn't expect write() to return 0.");
+        on_shutdown_write();
+        return false;
+    }
+}
+#endif
 
-        } else if (res == 0) {
-            /* This should never happen either, but it's better to write an error message than to
-               crash completely. */
-            logERR("Didn't expect write() to return 0.");
-            on_shutdown_write();
-            break;
+void linux_tcp_conn_t::perform_write_vectored(const write_slice_t *slices,
+                                              size_t num_slices) {
+#ifdef _WIN32
+    for (size_t i = 0; i < num_slices && !write_closed.is_pulsed(); ++i) {
+        perform_write(slices[i].buf, slices[i].size);
+    }
+#else
+    assert_thread();
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::network);
+
+    if (write_closed.is_pulsed()) {
+        /* See `perform_write()`. */
+        return;
+    }
+
+    std::vector<iovec> iovecs;
+    iovecs.reserve(num_slices);
+    for (size_t i = 0; i < num_slices; ++i) {
+        if (slices[i].size > 0) {
+            iovec v;
+            v.iov_base = const_cast<void *>(slices[i].buf);
+            v.iov_len = slices[i].size;
+            iovecs.push_back(v);
+        }
+    }
 
+    size_t next = 0;
+    while (next < iovecs.size()) {
+        const int count = static_cast<int>(std::min<size_t>(iovecs.size() - next, IOV_MAX));
+        ssize_t res = ::writev(sock.get(), iovecs.data() + next, count);
+
+        if (res <= 0) {
+            if (!handle_failed_write(res)) {
+                break;
+            }
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) {
                 write_perfmon->record(res);
             }
+            /* Skip over what was written, which might end in the middle of a slice. */
+            size_t written = res;
+            while (written > 0) {
+                rassert(next < iovecs.size());
+                if (written >= iovecs[next].iov_len) {
+                    written -= iovecs[next].iov_len;
+                    ++next;
+                } else {
+                    iovecs[next].iov_base =
+                        static_cast<char *>(iovecs[next].iov_base) + written;
+                    iovecs[next].iov_len -= written;
+                    written = 0;
+                }
+            }
         }
     }
 #endif
@@ -665,6 +754,7 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     /* Enqueue the write so it will happen eventually */
     op.buffer = buf;
     op.size = size;
+    op.slices = nullptr;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -679,12 +769,74 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     }
 }
 
+void linux_tcp_conn_t::write_vectored(const write_slice_t *slices, size_t num_slices, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    write_op_wrapper_t sentry(this, closer);
+
+    write_queue_op_t op;
+    cond_t to_signal_when_done;
+
+    /* Flush out any data that's been buffered, so that things don't get out of order */
+    if (current_write_buffer->size > 0) {
+        internal_flush_write_buffer();
+    }
+
+    /* Like in `write()`, we block until the write is done, so the slices stay valid
+       and we don't need the write semaphore. */
+    op.buffer = nullptr;
+    op.size = 0;
+    op.slices = slices;
+    op.num_slices = num_slices;
+    op.dealloc = nullptr;
+    op.cond = &to_signal_when_done;
+    write_queue.push(&op);
+
+    to_signal_when_done.wait();
+
+    if (write_closed.is_pulsed()) {
+        throw tcp_conn_write_closed_exc_t();
+    }
+}
+
 void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
     /* Convert to `char` for ease of pointer arithmetic */
     const char *buf = reinterpret_cast<const char *>(vbuf);
 
+    if (size >= LARGE_WRITE_SIZE) {
+        /* Copying this into write buffers would cost more than it saves, so we send
+           the buffered data and `buf` together in one vectored write and block until
+           it's done, just like `write_vectored()`. Nobody else can touch
+           `current_write_buffer` in the meantime because of `sentry`. */
+        if (write_closed.is_pulsed()) {
+            throw tcp_conn_write_closed_exc_t();
+        }
+
+        write_slice_t slices[2];
+        slices[0].buf = current_write_buffer->buffer;
+        slices[0].size = current_write_buffer->size;
+        slices[1].buf = buf;
+        slices[1].size = size;
+
+        write_queue_op_t op;
+        cond_t to_signal_when_done;
+        op.buffer = nullptr;
+        op.size = 0;
+        op.slices = slices;
+        op.num_slices = 2;
+        op.dealloc = nullptr;
+        op.cond = &to_signal_when_done;
+        write_queue.push(&op);
+
+        to_signal_when_done.wait();
+        current_write_buffer->size = 0;
+
+        if (write_closed.is_pulsed()) {
+            throw tcp_conn_write_closed_exc_t();
+        }
+        return;
+    }
+
     while (size > 0) {
         /* Stop putting more things on the write queue if it's already closed. */
         if (write_closed.is_pulsed()) {
@@ -737,6 +889,7 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     write_queue_op_t op;
     cond_t to_signal_when_done;
     op.buffer = nullptr;
+    op.slices = nullptr;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -939,6 +1092,23 @@ void linux_secure_tcp_conn_t::rethread(threadnum_t thread) {
     linux_tcp_conn_t::rethread(thread);
 }
 
+struct tls_handshake_stats_t {
+    // Resumed handshakes reuse an earlier session, so they skip the certificate
+    // exchange and the key agreement.
+    perfmon_counter_t full, resumed;
+    perfmon_multi_membership_t membership;
+
+    tls_handshake_stats_t()
+        : membership(&get_global_perfmon_collection(),
+                     &full, "tls_handshakes_full",
+                     &resumed, "tls_handshakes_resumed") { }
+};
+
+static tls_handshake_stats_t *get_tls_handshake_stats() {
+    static tls_handshake_stats_t stats;
+    return &stats;
+}
+
 void linux_secure_tcp_conn_t::perform_handshake(signal_t *interruptor)
         THROWS_ONLY(crypto::openssl_error_t, interrupted_exc_t) {
     // Perform TLS handshake.
@@ -947,7 +1117,13 @@ void linux_secure_tcp_conn_t::perform_handshake(signal_t *interruptor)
         int ret = SSL_do_handshake(conn.get());
 
         if (ret > 0) {
-            return; // Successful TLS handshake.
+            // Successful TLS handshake.
+            if (SSL_session_reused(conn.get())) {
+                ++get_tls_handshake_stats()->resumed;
+            } else {
+                ++get_tls_handshake_stats()->full;
+            }
+            return;
         }
 
         if (ret == 0) {
@@ -990,6 +1166,7 @@ size_t linux_secure_tcp_conn_t::read_internal(void *buffer, size_t size)
     THROWS_ONLY(tcp_conn_read_closed_exc_t) {
     assert_thread();
     rassert(!closed.is_pulsed());
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::network);
 
     while(true) {
         ERR_clear_error();
@@ -1044,8 +1221,16 @@ size_t linux_secure_tcp_conn_t::read_internal(void *buffer, size_t size)
     }
 }
 
+void linux_secure_tcp_conn_t::perform_write_vectored(const write_slice_t *slices,
+                                                     size_t num_slices) {
+    for (size_t i = 0; i < num_slices && !closed.is_pulsed(); ++i) {
+        perform_write(slices[i].buf, slices[i].size);
+    }
+}
+
 void linux_secure_tcp_conn_t::perform_write(const void *buffer, size_t size) {
     assert_thread();
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::network);
 
     if (closed.is_pulsed()) {
         /* The connection was closed, but there are still operations in the
@@ -1258,11 +1443,13 @@ void linux_tcp_conn_descriptor_t::make_server_connection(
 /* Network listener object */
 linux_nonthrowing_tcp_listener_t::linux_nonthrowing_tcp_listener_t(
          const std::set<ip_address_t> &bind_addresses, int _port,
-         const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &cb) :
+         const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &cb,
+         bool _reuse_port) :
     callback(cb),
     local_addresses(bind_addresses),
     port(_port),
     bound(false),
+    reuse_port(_reuse_port),
     socks(),
     last_used_socket_index(0),
     event_watchers(),
@@ -1367,6 +1554,14 @@ int linux_nonthrowing_tcp_listener_t::init_sockets() {
         // to be re-bound quickly (e.g. if you restart the server).
         int res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &sockoptval, sizeof(sockoptval)); 
         guarantee_err(res != -1, "Could not set REUSEADDR option");
+#ifdef SO_REUSEPORT
+        // Kernels that don't support `SO_REUSEPORT` fail this, in which case other
+        // listeners just won't be able to bind to our port.
+        if (reuse_port) {
+            UNUSED int ignored_res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT,
+                                                &sockoptval, sizeof(sockoptval));
+        }
+#endif
 #endif
         /* XXX Making our socket NODELAY prevents the problem where responses to
          * pipelined requests are delayed, since the TCP Nagle algorithm will
@@ -1677,8 +1872,10 @@ int linux_tcp_bound_socket_t::get_port() const {
 }
 
 linux_tcp_listener_t::linux_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
-    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback) :
-        listener(new linux_nonthrowing_tcp_listener_t(bind_addresses, port, callback))
+    const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback,
+    bool reuse_port) :
+        listener(new linux_nonthrowing_tcp_listener_t(bind_addresses, port, callback,
+                                                      reuse_port))
 {
     if (!listener->begin_listening()) {
         throw address_in_use_exc_t("localhost", listener->get_port());
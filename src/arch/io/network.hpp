@@ -55,6 +55,11 @@ public:
 
     void enable_keepalive() THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    // If the thread pool busy polls, asks the kernel to busy poll the device queue
+    // for this socket's reads for just as long.  This is only a hint, so failures are
+    // ignored.
+    void enable_busy_poll();
+
     class connect_failed_exc_t : public std::exception {
     public:
         explicit connect_failed_exc_t(int en) :
@@ -138,9 +143,24 @@ public:
 
     /* write_buffered() is like write(), but it might not send the data until
     flush_buffer*() or write() is called. Internally, it bundles together the
-    buffered writes; this may improve performance. */
+    buffered writes; this may improve performance. Writes of `LARGE_WRITE_SIZE` or
+    more aren't copied; they go out right away together with the buffered data, and
+    write_buffered() blocks until they're done. */
     void write_buffered(const void *buf, size_t size, signal_t *closer)
         THROWS_ONLY(tcp_conn_write_closed_exc_t);
+    static const size_t LARGE_WRITE_SIZE = 64 * KILOBYTE;
+
+    /* A piece of the data for write_vectored(). */
+    struct write_slice_t {
+        const void *buf;
+        size_t size;
+    };
+
+    /* write_vectored() is like write(), but for data that's spread over several
+    buffers. The buffers go to the socket as they are (with as few writev() calls as
+    possible) instead of being copied together first. */
+    void write_vectored(const write_slice_t *slices, size_t num_slices, signal_t *closer)
+        THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
     void writef(signal_t *closer, const char *format, ...)
         THROWS_ONLY(tcp_conn_write_closed_exc_t) ATTR_FORMAT(printf, 3, 4);
@@ -279,6 +299,9 @@ private:
         write_buffer_t *dealloc;
         const void *buffer;
         size_t size;
+        /* If non-null, this is a vectored write and `buffer` and `size` are unused. */
+        const write_slice_t *slices;
+        size_t num_slices;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
     };
@@ -345,6 +368,15 @@ private:
     /* Used to actually perform a write. If the write end of the connection is open, then
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
+
+    /* Like perform_write(), but writes the slices one after the other. */
+    virtual void perform_write_vectored(const write_slice_t *slices, size_t num_slices);
+
+#ifndef _WIN32
+    /* Deals with a ::write() or ::writev() that returned `res` <= 0. Returns true if
+    the write should be tried again, and false if the write end has been closed. */
+    bool handle_failed_write(ssize_t res);
+#endif
 };
 
 #ifdef ENABLE_TLS
@@ -409,6 +441,9 @@ private:
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
 
+    /* There's no vectored `SSL_write()`, so this writes the slices one by one. */
+    virtual void perform_write_vectored(const write_slice_t *slices, size_t num_slices);
+
     void shutdown();
     void shutdown_socket();
 
@@ -448,12 +483,17 @@ private:
 
 /* The linux_nonthrowing_tcp_listener_t is used to listen on a network port for incoming
 connections. Create a linux_nonthrowing_tcp_listener_t with some port and then call set_callback();
-the provided callback will be called in a new coroutine every time something connects. */
+the provided callback will be called in a new coroutine every time something connects.
+
+If `reuse_port` is true, the sockets get `SO_REUSEPORT`, so that listeners on other
+threads can bind to the same port and the kernel spreads the incoming connections
+over them. It's ignored where `SO_REUSEPORT` doesn't exist or isn't supported. */
 
 class linux_nonthrowing_tcp_listener_t : private linux_event_callback_t {
 public:
     linux_nonthrowing_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int _port,
-        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback,
+        bool reuse_port = false);
 
     ~linux_nonthrowing_tcp_listener_t();
 
@@ -502,6 +542,8 @@ private:
     // Inidicates successful binding to a port
     bool bound;
 
+    bool reuse_port;
+
     // The sockets to listen for connections on
     scoped_array_t<scoped_fd_t> socks;
 
@@ -531,7 +573,8 @@ public:
     linux_tcp_listener_t(linux_tcp_bound_socket_t *bound_socket,
         const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
     linux_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
-        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback,
+        bool reuse_port = false);
 
     int get_port() const;
 
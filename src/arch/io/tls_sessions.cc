@@ -0,0 +1,141 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/tls_sessions.hpp"
+
+#ifdef ENABLE_TLS
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <string.h>
+
+#include <deque>
+
+#include "arch/spinlock.hpp"
+#include "config/args.hpp"
+#include "crypto/random.hpp"
+#include "logger.hpp"
+#include "time.hpp"
+
+namespace {
+
+struct ticket_key_t {
+    unsigned char name[16];
+    unsigned char cipher_key[32];
+    unsigned char hmac_key[32];
+    ticks_t created;
+};
+
+/* All TLS contexts share the keys; OpenSSL calls `ticket_key_callback()` on whichever
+thread does the handshake. */
+class ticket_keys_t {
+public:
+    ticket_keys_t() { }
+
+    // Sets `*out` to the key for new tickets.
+    void get_current(ticket_key_t *out) {
+        spinlock_acq_t acq(&lock);
+        const ticks_t now = get_ticks();
+        if (keys.empty() ||
+                now.nanos - keys.front().created.nanos >=
+                    secs_to_ticks(TLS_TICKET_KEY_LIFETIME_SECS).nanos) {
+            ticket_key_t key;
+            crypto::detail::random_bytes(key.name, sizeof(key.name));
+            crypto::detail::random_bytes(key.cipher_key, sizeof(key.cipher_key));
+            crypto::detail::random_bytes(key.hmac_key, sizeof(key.hmac_key));
+            key.created = now;
+            keys.push_front(key);
+            while (keys.size() > 2) {
+                OPENSSL_cleanse(&keys.back(), sizeof(ticket_key_t));
+                keys.pop_back();
+            }
+        }
+        *out = keys.front();
+    }
+
+    // Sets `*out` to the key called `name`. Returns 0 if it has expired, 1 if it's the
+    // current key and 2 if the ticket should be replaced by one with the current key.
+    int find(const unsigned char *name, ticket_key_t *out) {
+        spinlock_acq_t acq(&lock);
+        const ticks_t now = get_ticks();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (memcmp(keys[i].name, name, sizeof(keys[i].name)) != 0) {
+                continue;
+            }
+            if (now.nanos - keys[i].created.nanos >=
+                    2 * secs_to_ticks(TLS_TICKET_KEY_LIFETIME_SECS).nanos) {
+                return 0;
+            }
+            *out = keys[i];
+            return i == 0 ? 1 : 2;
+        }
+        return 0;
+    }
+
+private:
+    spinlock_t lock;
+    // The newest key comes first.
+    std::deque<ticket_key_t> keys;
+
+    DISABLE_COPYING(ticket_keys_t);
+};
+
+ticket_keys_t *get_ticket_keys() {
+    static ticket_keys_t keys;
+    return &keys;
+}
+
+int ticket_key_callback(UNUSED SSL *ssl, unsigned char *key_name, unsigned char *iv,
+                        EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *hmac_ctx, int encrypt) {
+    ticket_key_t key;
+    int res = 1;
+    if (encrypt == 1) {
+        get_ticket_keys()->get_current(&key);
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) {
+            return -1;
+        }
+        memcpy(key_name, key.name, sizeof(key.name));
+        if (EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr,
+                               key.cipher_key, iv) != 1) {
+            res = -1;
+        }
+    } else {
+        res = get_ticket_keys()->find(key_name, &key);
+        if (res == 0) {
+            // Not our key, or too old. The client gets a full handshake.
+            return 0;
+        }
+        if (EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr,
+                               key.cipher_key, iv) != 1) {
+            res = -1;
+        }
+    }
+    if (res != -1 &&
+            HMAC_Init_ex(hmac_ctx, key.hmac_key, sizeof(key.hmac_key), EVP_sha256(),
+                         nullptr) != 1) {
+        res = -1;
+    }
+    OPENSSL_cleanse(&key, sizeof(key));
+    return res;
+}
+
+}  // namespace
+
+bool enable_tls_session_resumption(tls_ctx_t *tls_ctx, const char *session_id_context) {
+    if (1 != SSL_CTX_set_session_id_context(
+            tls_ctx, reinterpret_cast<const unsigned char *>(session_id_context),
+            strlen(session_id_context))) {
+        logERR("Unable to set the TLS session id context.");
+        return false;
+    }
+    SSL_CTX_set_session_cache_mode(tls_ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(tls_ctx, TLS_SESSION_CACHE_SIZE);
+    SSL_CTX_set_timeout(tls_ctx, TLS_TICKET_KEY_LIFETIME_SECS);
+    if (1 != SSL_CTX_set_tlsext_ticket_key_cb(tls_ctx, ticket_key_callback)) {
+        logERR("Unable to set up TLS session tickets.");
+        return false;
+    }
+    return true;
+}
+
+#endif  // ENABLE_TLS
@@ -0,0 +1,21 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_TLS_SESSIONS_HPP_
+#define ARCH_IO_TLS_SESSIONS_HPP_
+
+#include "arch/io/openssl.hpp"
+
+#ifdef ENABLE_TLS
+
+/* Lets clients that reconnect resume their TLS session instead of doing a full
+handshake, either from the server's session cache or with a session ticket.  Session
+tickets are encrypted with keys that only live in this process.  A new key is made
+every `TLS_TICKET_KEY_LIFETIME_SECS` and the previous one keeps decrypting tickets for
+as long again, so a stolen key can only open recent sessions.  Resumed sessions skip
+the certificate exchange, which is why `session_id_context` has to tell apart contexts
+that check client certificates differently.  Returns false and logs an error if
+OpenSSL refuses the settings. */
+bool enable_tls_session_resumption(tls_ctx_t *tls_ctx, const char *session_id_context);
+
+#endif  // ENABLE_TLS
+
+#endif  // ARCH_IO_TLS_SESSIONS_HPP_
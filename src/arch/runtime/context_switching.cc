@@ -422,6 +422,31 @@ size_t artificial_stack_t::free_space_below(const void *addr) const {
     return reinterpret_cast<uintptr_t>(addr) - lowest_valid_address;
 }
 
+size_t artificial_stack_t::high_water_mark() const {
+    // Skip the protection page, which we can't read.
+    const uintptr_t *word = reinterpret_cast<const uintptr_t *>(
+        reinterpret_cast<uintptr_t>(get_stack_bound()) + getpagesize());
+    const uintptr_t *end = reinterpret_cast<const uintptr_t *>(get_stack_base());
+    while (word < end && *word == 0) {
+        ++word;
+    }
+    return reinterpret_cast<uintptr_t>(end) - reinterpret_cast<uintptr_t>(word);
+}
+
+void artificial_stack_t::release_pages_below(const void *addr) {
+    rassert(address_in_stack(addr) && !address_is_stack_overflow(addr));
+    char *start = stack.get() + getpagesize();
+    char *end = reinterpret_cast<char *>(
+        floor_aligned(reinterpret_cast<uintptr_t>(addr), getpagesize()));
+    if (end > start) {
+#ifdef __MACH__
+        madvise(start, end - start, MADV_FREE);
+#else
+        madvise(start, end - start, MADV_DONTNEED);
+#endif
+    }
+}
+
 extern "C" {
 // `lightweight_swapcontext` is defined in assembly further down.  If we didn't add the
 // asm("_lightweight_swapcontext") here, we'd have to conditionally compile the symbol name in the
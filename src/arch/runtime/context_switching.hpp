@@ -28,6 +28,10 @@ public:
     I think fibers always have some overflow protection though? */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+
+    /* These two are currently not implemented for fiber stacks either. */
+    size_t high_water_mark() const { return 0; }
+    void release_pages_below(const void *) {}
 };
 
 void context_switch(fiber_context_ref_t *current_context_out, fiber_context_ref_t *dest_context_in);
@@ -108,6 +112,16 @@ public:
     /* Disables stack-smashing protection for this stack, if currently enabled */
     void disable_overflow_protection();
 
+    /* Returns how many bytes of the stack have been used so far.  This relies on
+    stack pages that haven't been used being zeroed, so it only counts usage since the
+    stack was created or since the last `release_pages_below()`.  It also reads the
+    whole stack, so it's only meant for profiling. */
+    size_t high_water_mark() const;
+
+    /* Gives the pages of the stack below the page that `addr` is on back to the
+    operating system.  They will be zeroed when they get used again. */
+    void release_pages_below(const void *addr);
+
 private:
     scoped_page_aligned_ptr_t<char> stack;
     size_t stack_size;
@@ -224,9 +238,11 @@ public:
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
 
-    /* These two are currently not implemented for threaded stacks. */
+    /* These four are currently not implemented for threaded stacks. */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+    size_t high_water_mark() const { return 0; }
+    void release_pages_below(const void *) {}
 
 private:
     static void *internal_run(void *p);
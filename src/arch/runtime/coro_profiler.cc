@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <cmath>
@@ -126,6 +127,30 @@ void coro_profiler_t::record_coro_yield(size_t levels_to_strip_from_backtrace) {
     record_sample(1 + levels_to_strip_from_backtrace);
 }
 
+void coro_profiler_t::record_coro_stack_usage(size_t bytes_used, size_t stack_size) {
+    rassert(coro_t::self());
+
+#ifndef NDEBUG
+    const std::string &coro_type = coro_t::self()->get_coroutine_type();
+#else
+    const std::string coro_type = "?";
+#endif
+    per_thread_samples_t &thread_samples = per_thread_samples[get_thread_id().threadnum].value;
+    const spinlock_acq_t thread_lock(&thread_samples.spinlock);
+    stack_usage_t &usage = thread_samples.stack_usage[coro_type];
+    ++usage.num_coros;
+    usage.stack_size = std::max(usage.stack_size, stack_size);
+    usage.max_bytes_used = std::max(usage.max_bytes_used, bytes_used);
+    usage.total_bytes_used += bytes_used;
+}
+
+void coro_profiler_t::stack_usage_t::merge(const stack_usage_t &other) {
+    num_coros += other.num_coros;
+    stack_size = std::max(stack_size, other.stack_size);
+    max_bytes_used = std::max(max_bytes_used, other.max_bytes_used);
+    total_bytes_used += other.total_bytes_used;
+}
+
 coro_profiler_t::coro_execution_point_key_t coro_profiler_t::get_current_execution_point(
     size_t levels_to_strip_from_backtrace) {
 
@@ -159,6 +184,7 @@ coro_profiler_t::coro_execution_point_key_t coro_profiler_t::get_current_executi
 
 void coro_profiler_t::generate_report() {
     std::map<coro_execution_point_key_t, per_execution_point_collected_report_t> execution_point_reports;
+    std::map<std::string, stack_usage_t> stack_usage;
 
     // We assume that the global report_interval_spinlock has already been locked by our caller.
     {
@@ -199,6 +225,12 @@ void coro_profiler_t::generate_report() {
                     execution_point_samples->second.samples.clear();
                 }
             }
+
+            // Collect stack usage
+            for (const auto &usage : thread_samples->value.stack_usage) {
+                stack_usage[usage.first].merge(usage.second);
+            }
+            thread_samples->value.stack_usage.clear();
         }
 
         // Release per-thread locks
@@ -213,6 +245,7 @@ void coro_profiler_t::generate_report() {
 
     if (reql_output_file != nullptr) {
         print_to_reql(execution_point_reports);
+        print_stack_usage_to_reql(stack_usage);
     }
 }
 
@@ -323,6 +356,30 @@ void coro_profiler_t::print_to_reql(
     }
 }
 
+void coro_profiler_t::print_stack_usage_to_reql(
+    const std::map<std::string, stack_usage_t> &stack_usage) {
+    guarantee(reql_output_file != nullptr);
+
+    const double time = ticks_to_secs(get_ticks());
+
+    for (const auto &usage : stack_usage) {
+        fprintf(reql_output_file,
+                "print t.insert({\n"
+                "\t\t'time': %.10f,\n", time);
+        fprintf(reql_output_file,
+                "\t\t'coro_type': '%s',\n",
+                usage.first.c_str());
+        fprintf(reql_output_file,
+                "\t\t'stack_usage': {'num_coros': %zu, 'stack_size': %zu, "
+                "'max': %zu, 'mean': %zu}\n",
+                usage.second.num_coros, usage.second.stack_size,
+                usage.second.max_bytes_used,
+                usage.second.total_bytes_used / usage.second.num_coros);
+        fprintf(reql_output_file,
+                "\t}).run(conn, durability='soft')\n");
+    }
+}
+
 std::string coro_profiler_t::trace_to_array_str(const small_trace_t &trace) {
     std::string trace_array_str = "[";
     for (size_t i = 0; i < CORO_PROFILER_BACKTRACE_DEPTH; ++i) {
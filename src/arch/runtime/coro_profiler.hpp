@@ -55,6 +55,10 @@
  *      - How much time has passed on a coroutine since the previous recording
  *        point
  *      - The priority of the coroutine
+ *      - How much of its stack a coroutine used by the time it finished, as a maximum
+ *        and a mean per coro_type, together with the size of the stacks (this is
+ *        useful to find coroutines that could be spawned with a shallow stack, see
+ *        `coro_stack_class_t`)
  *
  * A combination of coro_type (signature of the function that spawned the coroutine)
  * and a limited-depth backtrace (see `CORO_PROFILER_BACKTRACE_DEPTH`) is used to
@@ -80,6 +84,9 @@ public:
     // coroutine execution yields
     void record_coro_yield(size_t levels_to_strip_from_backtrace);
 
+    // coroutine finished after using `bytes_used` of its stack of `stack_size` bytes
+    void record_coro_stack_usage(size_t bytes_used, size_t stack_size);
+
 private:
     typedef std::array<void *, CORO_PROFILER_BACKTRACE_DEPTH> small_trace_t;
     // We identify an execution point of a coroutine by a pair of
@@ -100,9 +107,20 @@ private:
         int num_samples_total;
         std::vector<coro_sample_t> samples;
     };
+    struct stack_usage_t {
+        stack_usage_t() : num_coros(0), stack_size(0), max_bytes_used(0),
+                          total_bytes_used(0) { }
+        void merge(const stack_usage_t &other);
+        size_t num_coros;
+        size_t stack_size;
+        size_t max_bytes_used;
+        size_t total_bytes_used;
+    };
     struct per_thread_samples_t {
         per_thread_samples_t() : ticks_at_last_report(get_ticks()) { }
         std::map<coro_execution_point_key_t, per_execution_point_samples_t> per_execution_point_samples;
+        // Keyed by coro_type
+        std::map<std::string, stack_usage_t> stack_usage;
         spinlock_t spinlock;
         // This field is a duplicate of the global `ticks_at_last_report` in
         // `coro_profiler_t`. We copy it in each thread in order to avoid having
@@ -141,6 +159,7 @@ private:
     void generate_report();
     void print_to_reql(const std::map<coro_execution_point_key_t,
                        per_execution_point_collected_report_t> &execution_point_reports);
+    void print_stack_usage_to_reql(const std::map<std::string, stack_usage_t> &stack_usage);
     void write_reql_header();
     std::string distribution_to_object_str(const data_distribution_t &distribution);
     std::string trace_to_array_str(const small_trace_t &trace);
@@ -0,0 +1,213 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coro_sampler.hpp"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "backtrace.hpp"
+#include "containers/scoped.hpp"
+#include "rethinkdb_backtrace.hpp"
+#include "utils.hpp"
+
+const char *coro_wait_reason_name(coro_wait_reason_t reason) {
+    switch (reason) {
+    case coro_wait_reason_t::other: return "other";
+    case coro_wait_reason_t::yield: return "yield";
+    case coro_wait_reason_t::mutex: return "mutex";
+    case coro_wait_reason_t::disk: return "disk";
+    case coro_wait_reason_t::network: return "network";
+    case coro_wait_reason_t::cross_thread: return "cross_thread";
+    default: unreachable();
+    }
+}
+
+coro_wait_reason_scope_t::coro_wait_reason_scope_t(coro_wait_reason_t reason)
+    : reason_slot(nullptr), previous_reason(coro_wait_reason_t::other) {
+    coro_t *self = coro_t::self();
+    if (self != nullptr) {
+        reason_slot = &self->wait_reason_;
+        previous_reason = *reason_slot;
+        *reason_slot = reason;
+    }
+}
+
+coro_wait_reason_scope_t::~coro_wait_reason_scope_t() {
+    if (reason_slot != nullptr) {
+        *reason_slot = previous_reason;
+    }
+}
+
+std::atomic<bool> coro_sampler_t::running(false);
+
+coro_sampler_t &coro_sampler_t::get_global_sampler() {
+    // See `coro_profiler_t::get_global_profiler()`.
+    static coro_sampler_t sampler;
+    return sampler;
+}
+
+coro_sampler_t::coro_sampler_t() : interval(1) { }
+
+void coro_sampler_t::start(int64_t _interval) {
+    guarantee(_interval >= 1);
+    for (auto &thread_samples : per_thread_samples) {
+        const spinlock_acq_t thread_lock(&thread_samples.value.spinlock);
+        thread_samples.value.samples.clear();
+    }
+    interval.store(_interval);
+    running.store(true);
+}
+
+void coro_sampler_t::stop() {
+    running.store(false);
+}
+
+int64_t coro_sampler_t::get_interval() const {
+    return interval.load();
+}
+
+bool coro_sampler_t::maybe_begin_wait(const void *spawn_site,
+                                      coro_wait_reason_t reason,
+                                      size_t levels_to_strip_from_backtrace,
+                                      coro_wait_sample_t *sample_out) {
+    per_thread_samples_t &thread_samples =
+        per_thread_samples[get_thread_id().threadnum].value;
+    const int64_t current_interval = interval.load(std::memory_order_relaxed);
+    if (thread_samples.countdown > current_interval) {
+        // The interval got shorter since we last sampled.
+        thread_samples.countdown = current_interval;
+    }
+    if (--thread_samples.countdown > 0) {
+        return false;
+    }
+    thread_samples.countdown = current_interval;
+
+    // We strip ourselves, and the frames that are inside `rethinkdb_backtrace()`.
+    const size_t levels_to_strip =
+        levels_to_strip_from_backtrace + 1 + NUM_FRAMES_INSIDE_RETHINKDB_BACKTRACE;
+    void *frames[CORO_SAMPLER_BACKTRACE_DEPTH + 8];
+    const int num_frames = rethinkdb_backtrace(
+        frames, std::min<size_t>(CORO_SAMPLER_BACKTRACE_DEPTH + levels_to_strip,
+                                 sizeof(frames) / sizeof(frames[0])));
+    for (size_t i = 0; i < CORO_SAMPLER_BACKTRACE_DEPTH; ++i) {
+        const size_t frame = i + levels_to_strip;
+        sample_out->trace[i] =
+            frame < static_cast<size_t>(std::max(num_frames, 0)) ? frames[frame] : nullptr;
+    }
+    sample_out->spawn_site = spawn_site;
+    sample_out->reason = reason;
+    sample_out->started = get_ticks();
+    return true;
+}
+
+void coro_sampler_t::end_wait(const coro_wait_sample_t &sample) {
+    const int64_t wait_nanos = get_ticks().nanos - sample.started.nanos;
+
+    sample_key_t key;
+    key.spawn_site = sample.spawn_site;
+    key.reason = sample.reason;
+    key.trace = sample.trace;
+
+    // The coroutine might have woken up on another thread than the one it started
+    // waiting on, so this can be a different `per_thread_samples_t`.
+    per_thread_samples_t &thread_samples =
+        per_thread_samples[get_thread_id().threadnum].value;
+    const spinlock_acq_t thread_lock(&thread_samples.spinlock);
+    sample_stats_t &stats = thread_samples.samples[key];
+    ++stats.num_waits;
+    stats.total_wait_nanos += std::max<int64_t>(wait_nanos, 0);
+}
+
+bool coro_sampler_t::sample_key_t::operator<(const sample_key_t &other) const {
+    if (spawn_site != other.spawn_site) {
+        return spawn_site < other.spawn_site;
+    }
+    if (reason != other.reason) {
+        return reason < other.reason;
+    }
+    return trace < other.trace;
+}
+
+namespace {
+
+// Some characters would confuse flamegraph.pl.
+std::string sanitize_frame_description(std::string description) {
+    for (char &c : description) {
+        if (c == ';' || c == '\n') {
+            c = '_';
+        }
+    }
+    return description;
+}
+
+const std::string &get_frame_description(
+        const void *addr, std::map<const void *, std::string> *cache) {
+    auto it = cache->find(addr);
+    if (it != cache->end()) {
+        return it->second;
+    }
+
+    backtrace_frame_t frame(addr);
+    frame.initialize_symbols();
+    std::string description;
+    try {
+        description = frame.get_demangled_name();
+    } catch (const demangle_failed_exc_t &) {
+        description = frame.get_name();
+    }
+    if (description.empty()) {
+        description = strprintf("%p", addr);
+    }
+
+    // Spawn sites show up as `void coro_spawn_site<callable>()`, of which only the
+    // callable is interesting.
+    const std::string spawn_site_prefix = "void coro_spawn_site<";
+    const std::string spawn_site_suffix = ">()";
+    if (description.compare(0, spawn_site_prefix.size(), spawn_site_prefix) == 0
+        && description.size() > spawn_site_prefix.size() + spawn_site_suffix.size()) {
+        description = "spawn " + description.substr(
+            spawn_site_prefix.size(),
+            description.size() - spawn_site_prefix.size() - spawn_site_suffix.size());
+    }
+
+    return (*cache)[addr] = sanitize_frame_description(description);
+}
+
+}  // namespace
+
+std::string coro_sampler_t::get_folded_stacks() {
+    std::map<sample_key_t, sample_stats_t> collected;
+    for (auto &thread_samples : per_thread_samples) {
+        const spinlock_acq_t thread_lock(&thread_samples.value.spinlock);
+        for (const auto &sample : thread_samples.value.samples) {
+            sample_stats_t &stats = collected[sample.first];
+            stats.num_waits += sample.second.num_waits;
+            stats.total_wait_nanos += sample.second.total_wait_nanos;
+        }
+    }
+
+    std::map<const void *, std::string> frame_descriptions;
+    std::string result;
+    for (const auto &sample : collected) {
+        std::string line;
+        if (sample.first.spawn_site != nullptr) {
+            line += get_frame_description(sample.first.spawn_site, &frame_descriptions);
+            line += ";";
+        }
+        // Flame graphs go from the outermost frame to the innermost frame.
+        for (size_t i = CORO_SAMPLER_BACKTRACE_DEPTH; i > 0; --i) {
+            const void *addr = sample.first.trace[i - 1];
+            if (addr != nullptr) {
+                line += get_frame_description(addr, &frame_descriptions);
+                line += ";";
+            }
+        }
+        line += coro_wait_reason_name(sample.first.reason);
+        result += strprintf("%s %" PRIi64 "\n",
+                            line.c_str(), sample.second.total_wait_nanos / 1000);
+    }
+    return result;
+}
@@ -0,0 +1,132 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CORO_SAMPLER_HPP_
+#define ARCH_RUNTIME_CORO_SAMPLER_HPP_
+
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <string>
+
+#include "arch/spinlock.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "config/args.hpp"
+#include "errors.hpp"
+#include "time.hpp"
+
+/* Depth of the backtraces that the coro sampler takes of waiting coroutines. */
+#define CORO_SAMPLER_BACKTRACE_DEPTH            16
+
+/* What a coroutine is waiting for.  Code that blocks on one of these sets it with a
+`coro_wait_reason_scope_t`; everything else is `other`. */
+enum class coro_wait_reason_t {
+    other = 0,
+    yield,
+    mutex,
+    disk,
+    network,
+    cross_thread
+};
+
+const char *coro_wait_reason_name(coro_wait_reason_t reason);
+
+/* Sets the wait reason of the current coroutine while it's in scope.  Does nothing
+outside of a coroutine. */
+class coro_wait_reason_scope_t {
+public:
+    explicit coro_wait_reason_scope_t(coro_wait_reason_t reason);
+    ~coro_wait_reason_scope_t();
+private:
+    coro_wait_reason_t *reason_slot;
+    coro_wait_reason_t previous_reason;
+
+    DISABLE_COPYING(coro_wait_reason_scope_t);
+};
+
+/* A wait that is being sampled.  Lives on the stack of the waiting coroutine. */
+struct coro_wait_sample_t {
+    const void *spawn_site;
+    coro_wait_reason_t reason;
+    ticks_t started;
+    std::array<void *, CORO_SAMPLER_BACKTRACE_DEPTH> trace;
+};
+
+/*
+ * The `coro_sampler_t` records where coroutines wait, and for how long.  Unlike the
+ * `coro_profiler_t`, it's always compiled in, and it can be started and stopped while
+ * the server is running (see `coro_sampler_http_app_t`).  While it's stopped, the
+ * only cost is a relaxed atomic load in `coro_t::wait()`.
+ *
+ * While it's running, every `interval`th wait on each thread is sampled.  A sample
+ * consists of a short backtrace of where the coroutine started waiting, the reason
+ * for the wait, the function that spawned the coroutine, and the time until the
+ * coroutine resumed.  Samples with the same spawn site, backtrace and reason are
+ * aggregated per thread, so memory use only grows with the number of distinct call
+ * sites.
+ *
+ * `get_folded_stacks()` returns the aggregated wait times in the "folded" format that
+ * flamegraph.pl reads: one line per call site, with the frames from the spawn site
+ * down to the wait reason separated by semicolons, followed by the total sampled
+ * wait time in microseconds.
+ */
+class coro_sampler_t {
+public:
+    static coro_sampler_t &get_global_sampler();
+
+    /* Whether the sampler is running.  Cheap enough to call on every wait. */
+    static bool is_running() {
+        return running.load(std::memory_order_relaxed);
+    }
+
+    /* Starts sampling every `interval`th wait on each thread.  Drops whatever has
+    been collected before. */
+    void start(int64_t interval);
+    void stop();
+    int64_t get_interval() const;
+
+    std::string get_folded_stacks();
+
+    /* These are called by `coro_t::wait()` while the sampler is running.
+    `maybe_begin_wait()` returns `false` if this wait isn't sampled.
+    `levels_to_strip_from_backtrace` are the frames of the caller that should not
+    show up in the backtrace. */
+    bool maybe_begin_wait(const void *spawn_site,
+                          coro_wait_reason_t reason,
+                          size_t levels_to_strip_from_backtrace,
+                          coro_wait_sample_t *sample_out);
+    void end_wait(const coro_wait_sample_t &sample);
+
+private:
+    coro_sampler_t();
+
+    struct sample_key_t {
+        const void *spawn_site;
+        coro_wait_reason_t reason;
+        std::array<void *, CORO_SAMPLER_BACKTRACE_DEPTH> trace;
+        bool operator<(const sample_key_t &other) const;
+    };
+    struct sample_stats_t {
+        sample_stats_t() : num_waits(0), total_wait_nanos(0) { }
+        uint64_t num_waits;
+        int64_t total_wait_nanos;
+    };
+    struct per_thread_samples_t {
+        per_thread_samples_t() : countdown(0) { }
+        // Only accessed by the thread itself, so it's not protected by the spinlock.
+        int64_t countdown;
+        spinlock_t spinlock;
+        std::map<sample_key_t, sample_stats_t> samples;
+    };
+
+    static std::atomic<bool> running;
+    std::atomic<int64_t> interval;
+
+    // Would be nice if we could use one_per_thread here. However
+    // that makes the construction order tricky.
+    std::array<cache_line_padded_t<per_thread_samples_t>, MAX_THREADS> per_thread_samples;
+
+    DISABLE_COPYING(coro_sampler_t);
+};
+
+#endif /* ARCH_RUNTIME_CORO_SAMPLER_HPP_ */
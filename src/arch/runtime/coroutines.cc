@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <functional>
 #ifndef NDEBUG
 #include <map>
@@ -31,6 +32,28 @@ size_t coro_stack_size = COROUTINE_STACK_SIZE;
 // freed. This value is per thread.
 const size_t COROUTINE_FREE_LIST_SIZE = 64;
 
+// Shallow stacks are cheap to keep around, so we keep more of them.  That way bursts
+// of short-lived coroutines don't keep allocating and freeing stacks.
+const size_t COROUTINE_SHALLOW_FREE_LIST_SIZE = 4 * COROUTINE_FREE_LIST_SIZE;
+
+const size_t NUM_CORO_STACK_CLASSES = 2;
+
+size_t stack_class_index(coro_stack_class_t stack_class) {
+    return stack_class == coro_stack_class_t::shallow ? 1 : 0;
+}
+
+size_t stack_size_for_class(coro_stack_class_t stack_class) {
+    return stack_class == coro_stack_class_t::shallow
+        ? std::min<size_t>(COROUTINE_SHALLOW_STACK_SIZE, coro_stack_size)
+        : coro_stack_size;
+}
+
+size_t free_list_size_for_class(coro_stack_class_t stack_class) {
+    return stack_class == coro_stack_class_t::shallow
+        ? COROUTINE_SHALLOW_FREE_LIST_SIZE
+        : COROUTINE_FREE_LIST_SIZE;
+}
+
 // In debug mode, we print a warning if more than this many coroutines have been
 // allocated on one thread.
 #ifndef NDEBUG
@@ -68,8 +91,9 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
-    intrusive_list_t<coro_t> free_coros;
+    /* Lists of coro_t objects that are not in use, one per stack class (see
+    `stack_class_index()`). */
+    intrusive_list_t<coro_t> free_coros[NUM_CORO_STACK_CLASSES];
 
     /* A list of coroutines that currently have protected stacks. The least recently
     used protected coroutine is always at the front of the list. */
@@ -120,9 +144,11 @@ struct coro_globals_t {
         rassert(!current_coro);
 
         /* Destroy remaining coroutines */
-        while (coro_t *s = free_coros.head()) {
-            free_coros.remove(s);
-            delete s;
+        for (size_t i = 0; i < NUM_CORO_STACK_CLASSES; ++i) {
+            while (coro_t *s = free_coros[i].head()) {
+                free_coros[i].remove(s);
+                delete s;
+            }
         }
     }
 
@@ -162,12 +188,15 @@ void coro_runtime_t::get_coroutine_counts(std::map<std::string, size_t> *dest) {
 TLS_with_init(int64_t, coro_selfname_counter, 0);
 #endif
 
-coro_t::coro_t() :
-    stack(&coro_t::run, coro_stack_size),
+coro_t::coro_t(coro_stack_class_t stack_class) :
+    stack_class_(stack_class),
+    stack(&coro_t::run, stack_size_for_class(stack_class)),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
     waiting_(false),
-    protected_stack_lru_entry_(this)
+    protected_stack_lru_entry_(this),
+    spawn_site_(nullptr),
+    wait_reason_(coro_wait_reason_t::other)
 #ifndef NDEBUG
     , selfname_number(get_thread_id().threadnum + MAX_THREADS *
           // The comma here is the comma operator, to implement the semantics
@@ -199,13 +228,16 @@ void coro_t::return_coro_to_free_list(coro_t *coro) {
     // This is important because when we call `return_coro_to_free_list` in
     // `coro_t::run`, that coroutine is still active and must not be deleted yet.
     static_assert(COROUTINE_FREE_LIST_SIZE > 0, "COROUTINE_FREE_LIST_SIZE cannot be 0");
-    if (cglobals->free_coros.size() >= COROUTINE_FREE_LIST_SIZE) {
-        coro_t *coro_to_delete = cglobals->free_coros.tail();
-        cglobals->free_coros.remove(coro_to_delete);
+    intrusive_list_t<coro_t> *free_coros =
+        &cglobals->free_coros[stack_class_index(coro->stack_class_)];
+    const size_t max_free_coros = free_list_size_for_class(coro->stack_class_);
+    if (free_coros->size() >= max_free_coros) {
+        coro_t *coro_to_delete = free_coros->tail();
+        free_coros->remove(coro_to_delete);
         delete coro_to_delete;
     }
-    rassert(cglobals->free_coros.size() < COROUTINE_FREE_LIST_SIZE);
-    cglobals->free_coros.push_back(coro);
+    rassert(free_coros->size() < max_free_coros);
+    free_coros->push_back(coro);
 }
 
 coro_t::~coro_t() {
@@ -276,6 +308,16 @@ void coro_t::run() {
         PROFILER_CORO_RESUME;
         coro->action_wrapper.run();
         PROFILER_CORO_YIELD(0);
+#ifdef ENABLE_CORO_PROFILER
+        {
+            // Measure how deep the stack got, and zero it again for the next
+            // coroutine that gets it.
+            char stack_marker;
+            coro_profiler_t::get_global_profiler().record_coro_stack_usage(
+                coro->stack.high_water_mark(), stack_size_for_class(coro->stack_class_));
+            coro->stack.release_pages_below(&stack_marker);
+        }
+#endif
 #ifndef NDEBUG
         TLS_get_cglobals()->running_coroutine_counts[coro->coroutine_type]--;
         TLS_get_cglobals()->active_coroutines.erase(coro);
@@ -360,6 +402,13 @@ void coro_t::wait() {   /* class method */
     rassert(!self()->waiting_);
     self()->waiting_ = true;
 
+    coro_wait_sample_t wait_sample;
+    const bool sampled = coro_sampler_t::is_running()
+        && coro_sampler_t::get_global_sampler().maybe_begin_wait(
+            reinterpret_cast<const void *>(
+                reinterpret_cast<uintptr_t>(self()->spawn_site_)),
+            self()->wait_reason_, 1, &wait_sample);
+
     PROFILER_CORO_YIELD(1);
     if (TLS_get_cglobals()->prev_coro) {
         TLS_get_cglobals()->prev_coro->switch_to_coro_with_protection(
@@ -369,6 +418,10 @@ void coro_t::wait() {   /* class method */
     }
     PROFILER_CORO_RESUME;
 
+    if (sampled) {
+        coro_sampler_t::get_global_sampler().end_wait(wait_sample);
+    }
+
     rassert(self());
     rassert(self()->waiting_);
     self()->waiting_ = false;
@@ -376,12 +429,14 @@ void coro_t::wait() {   /* class method */
 
 void coro_t::yield() {  /* class method */
     rassert(self(), "Not in a coroutine context");
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::yield);
     self()->notify_sometime();
     self()->wait();
 }
 
 void coro_t::yield_ordered() {  /* class method */
     rassert(self(), "Not in a coroutine context");
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::yield);
     self()->notify_later_ordered();
     self()->wait();
 }
@@ -466,6 +521,7 @@ void coro_t::move_to_thread(threadnum_t thread) {
             &self()->protected_stack_lru_entry_);
     }
     self()->current_thread_ = thread;
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::cross_thread);
     self()->notify_later_ordered();
     wait();
 }
@@ -514,16 +570,19 @@ bool coroutines_have_been_initialized() {
     return TLS_get_cglobals() != nullptr;
 }
 
-coro_t * coro_t::get_coro() {
+coro_t * coro_t::get_coro(coro_stack_class_t stack_class) {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (TLS_get_cglobals()->free_coros.size() == 0) {
-        coro = new coro_t();
+    intrusive_list_t<coro_t> *free_coros =
+        &TLS_get_cglobals()->free_coros[stack_class_index(stack_class)];
+    if (free_coros->size() == 0) {
+        coro = new coro_t(stack_class);
     } else {
-        coro = TLS_get_cglobals()->free_coros.tail();
-        TLS_get_cglobals()->free_coros.remove(coro);
+        coro = free_coros->tail();
+        free_coros->remove(coro);
     }
+    rassert(coro->stack_class_ == stack_class);
 
     rassert(!coro->intrusive_list_node_t<coro_t>::in_a_list());
 
@@ -3,6 +3,7 @@
 #define ARCH_RUNTIME_COROUTINES_HPP_
 
 #include <exception>
+#include <type_traits>
 #ifndef NDEBUG
 #include <string>
 #endif
@@ -10,6 +11,7 @@
 #include "arch/compiler.hpp"
 #include "arch/runtime/callable_action.hpp"
 #include "arch/runtime/context_switching.hpp"
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "threading.hpp"
 #include "time.hpp"
@@ -43,6 +45,19 @@ struct coro_lru_entry_t : public intrusive_list_node_t<coro_lru_entry_t> {
     coro_t *coro;
 };
 
+/* There is one of these functions for every type of callable that coroutines get
+spawned with.  They are never called; their addresses tell the coro sampler where a
+coroutine was spawned. */
+template <class callable_t>
+NOINLINE void coro_spawn_site() { }
+
+/* Coroutines that are known never to run deep call chains can ask for a smaller
+stack when they are spawned, which lets a lot more of them exist at the same time.
+Each class has its own pool of stacks on every thread.  Whatever code runs in a
+`shallow` coroutine must not recurse without `call_with_enough_stack()`, and must not
+put large buffers on the stack. */
+enum class coro_stack_class_t { normal, shallow };
+
 /* A coro_t represents a fiber of execution within a thread. Create one with spawn_*(). Within a
 coroutine, call wait() to return control to the scheduler; the coroutine will be resumed when
 another fiber calls notify_*() on it.
@@ -56,16 +71,21 @@ class coro_t : private coro_profiler_mixin_t,
 public:
     friend bool is_coroutine_stack_overflow(void *);
     friend bool has_n_bytes_free_stack_space(size_t);
+    friend class coro_wait_reason_scope_t;
 
     template<class callable_t>
-    static void spawn_now_dangerously(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static void spawn_now_dangerously(
+            callable_t &&action,
+            coro_stack_class_t stack_class = coro_stack_class_t::normal) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->notify_now_deprecated();
     }
 
     template<class callable_t>
-    static coro_t *spawn_sometime(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_sometime(
+            callable_t &&action,
+            coro_stack_class_t stack_class = coro_stack_class_t::normal) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->notify_sometime();
         return coro;
     }
@@ -74,8 +94,10 @@ public:
     It avoids two thread messages, since it doesn't have to run on the original
     thread first, and also doesn't switch back at the end of the coro's lifetime. */
     template<class callable_t>
-    static coro_t *spawn_on_thread(callable_t &&action, threadnum_t thread) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_on_thread(
+            callable_t &&action, threadnum_t thread,
+            coro_stack_class_t stack_class = coro_stack_class_t::normal) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
         coro->current_thread_ = thread;
         coro->notify_sometime();
         return coro;
@@ -86,7 +108,8 @@ public:
     honor scheduler priorities. */
     template<class callable_t>
     static coro_t *spawn_later_ordered(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action),
+                                         coro_stack_class_t::normal);
         coro->notify_later_ordered();
         return coro;
     }
@@ -152,6 +175,8 @@ public:
 
     coro_stack_t *get_stack();
 
+    coro_stack_class_t get_stack_class() const { return stack_class_; }
+
     void set_priority(int _priority) {
         linux_thread_message_t::set_priority(_priority);
     }
@@ -174,7 +199,7 @@ private:
 
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
-    coro_t();
+    explicit coro_t(coro_stack_class_t stack_class);
 
     // Generates a spawn-time backtrace and stores it into `spawn_backtrace`.
     void grab_spawn_backtrace();
@@ -185,12 +210,14 @@ private:
 
     // If this function footprint ever changes, you may need to update the parse_coroutine_info function
     template<class callable_t>
-    static coro_t *get_and_init_coro(callable_t &&action) {
-        coro_t *coro = get_coro();
+    static coro_t *get_and_init_coro(callable_t &&action,
+                                     coro_stack_class_t stack_class) {
+        coro_t *coro = get_coro(stack_class);
 #ifndef NDEBUG
         coro->parse_coroutine_type(CURRENT_FUNCTION_PRETTY);
 #endif
         coro->grab_spawn_backtrace();
+        coro->spawn_site_ = &coro_spawn_site<typename std::decay<callable_t>::type>;
         coro->action_wrapper.reset(std::forward<callable_t>(action));
 
         // If we were called from a coroutine, the new coroutine inherits our
@@ -205,7 +232,7 @@ private:
         return coro;
     }
 
-    static coro_t *get_coro();
+    static coro_t *get_coro(coro_stack_class_t stack_class);
 
     static void return_coro_to_free_list(coro_t *coro);
 
@@ -217,6 +244,7 @@ private:
 
     virtual void on_thread_switch();
 
+    const coro_stack_class_t stack_class_;
     coro_stack_t stack;
 
     threadnum_t current_thread_;
@@ -230,6 +258,10 @@ private:
     /* Used to eventually unprotect the coroutine if it has been inactive for a while. */
     coro_lru_entry_t protected_stack_lru_entry_;
 
+    /* For the coro sampler (see `coro_sampler_t`). */
+    void (*spawn_site_)();
+    coro_wait_reason_t wait_reason_;
+
 #ifndef NDEBUG
     int64_t selfname_number;
     std::string coroutine_type;
@@ -18,6 +18,7 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "perfmon/perfmon.hpp"
+#include "time.hpp"
 
 int user_to_epoll(int mode) {
 
@@ -56,10 +57,39 @@ epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
 void epoll_event_queue_t::run() {
     int res;
 
+    // With busy polling, we don't go to sleep as soon as we're idle, but keep polling
+    // epoll and the incoming messages until we've been idle for `busy_poll_nanos`.
+    // That saves the wake-up latency at the cost of a busy CPU, and the other threads
+    // can skip waking us when they send us messages.
+    const int64_t busy_poll_nanos =
+        linux_thread_pool_t::get_thread_pool()->busy_poll_nanos;
+    bool busy_polling = false;
+    ticks_t busy_poll_deadline = {0};
+
     // Now, start the loop
     while (!parent->should_shut_down()) {
+        int timeout = -1;
+        if (busy_poll_nanos > 0) {
+            if (!busy_polling) {
+                parent->set_busy_polling(true);
+                busy_polling = true;
+                busy_poll_deadline.nanos = get_ticks().nanos + busy_poll_nanos;
+            }
+            if (get_ticks().nanos < busy_poll_deadline.nanos) {
+                timeout = 0;
+            } else {
+                parent->set_busy_polling(false);
+                busy_polling = false;
+                // Messages that were sent before we stopped busy polling didn't wake
+                // us up, so we have to look for them one last time.
+                if (parent->poll()) {
+                    timeout = 0;
+                }
+            }
+        }
+
         // Grab the events from the kernel!
-        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, timeout);
 
         // epoll_wait might return with EINTR in some cases (in
         // particular under GDB), we just need to retry.
@@ -116,10 +146,22 @@ void epoll_event_queue_t::run() {
             }
         }
 
+        bool found_work = nevents > 0;
         nevents = 0;
 
+        if (busy_polling) {
+            found_work = parent->poll() || found_work;
+            if (found_work) {
+                busy_poll_deadline.nanos = get_ticks().nanos + busy_poll_nanos;
+            }
+        }
+
         parent->pump();
     }
+
+    if (busy_polling) {
+        parent->set_busy_polling(false);
+    }
 }
 
 epoll_event_queue_t::~epoll_event_queue_t() {
@@ -15,6 +15,12 @@ struct linux_event_callback_t {
 struct linux_queue_parent_t {
     virtual void pump() = 0;
     virtual bool should_shut_down() = 0;
+
+    // While the event queue busy polls, the parent may stop waking it up when it gets
+    // work, so the event queue has to call `poll()` to find the work.  `poll()`
+    // returns whether there was any.
+    virtual void set_busy_polling(bool) { }
+    virtual bool poll() { return false; }
     virtual ~linux_queue_parent_t() {}
 };
 
@@ -23,7 +23,8 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
                                          threadnum_t current_thread)
     : queue_(queue),
       thread_pool_(thread_pool),
-      is_woken_up_(false),
+      incoming_messages_(nullptr),
+      busy_polling_(false),
       current_thread_(current_thread) {
 
 #ifndef NDEBUG
@@ -47,7 +48,7 @@ linux_message_hub_t::~linux_message_hub_t() {
         guarantee(get_priority_msg_list(p).empty());
     }
 
-    guarantee(incoming_messages_.empty());
+    guarantee(incoming_messages_.load() == nullptr);
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
@@ -94,19 +95,59 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
+    msg_list_t messages;
+    messages.push_back(msg);
+    push_incoming_messages(&messages);
+}
+
+void linux_message_hub_t::push_incoming_messages(msg_list_t *messages) {
+    // Link the messages newest first, so that the whole batch can go onto the stack at
+    // once.
+    linux_thread_message_t *const oldest = messages->head();
+    linux_thread_message_t *newest = nullptr;
+    while (linux_thread_message_t *m = messages->head()) {
+        messages->remove(m);
+        m->next_incoming = newest;
+        newest = m;
+    }
+    if (newest == nullptr) {
+        return;
     }
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
-        event_.wakey_wakey();
+    linux_thread_message_t *old_head = incoming_messages_.load(std::memory_order_relaxed);
+    do {
+        oldest->next_incoming = old_head;
+    } while (!incoming_messages_.compare_exchange_weak(old_head, newest,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed));
+
+    // We only need to do a wake up if the stack was empty.  Otherwise whoever pushed
+    // onto the empty stack has woken up the thread (or is about to), and it hasn't
+    // taken the messages yet, so it's going to see ours too.
+    if (old_head == nullptr) {
+        // Pairs with the fence in `set_busy_polling()`: either we see that the thread
+        // has stopped busy polling, or it's going to poll our messages.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!busy_polling_.load(std::memory_order_relaxed)) {
+            // Wakey wakey eggs and bakey
+            event_.wakey_wakey();
+        }
     }
 }
 
+void linux_message_hub_t::set_busy_polling(bool busy_polling) {
+    busy_polling_.store(busy_polling, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool linux_message_hub_t::poll_incoming_messages() {
+    if (incoming_messages_.load(std::memory_order_relaxed) == nullptr) {
+        return false;
+    }
+    process_messages();
+    return true;
+}
+
 linux_message_hub_t::msg_list_t &linux_message_hub_t::get_priority_msg_list(int priority) {
     rassert(priority >= MESSAGE_SCHEDULER_MIN_PRIORITY);
     rassert(priority <= MESSAGE_SCHEDULER_MAX_PRIORITY);
@@ -122,6 +163,10 @@ void linux_message_hub_t::on_event(int events) {
     // up and so that poll-based event triggering doesn't infinite-loop.
     event_.consume_wakey_wakeys();
 
+    process_messages();
+}
+
+void linux_message_hub_t::process_messages() {
     // Sort incoming messages into the respective priority_msg_lists_
     sort_incoming_messages_by_priority();
 
@@ -178,36 +223,32 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
-                event_.wakey_wakey();
-            }
+            // If another thread wakes us up as well, both wakeups are consumed
+            // at once.
+            event_.wakey_wakey();
             break;
         }
     }
 }
 
 void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
-
-    // 1. Pull the messages
-    msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
+    // 1. Take all of the messages off the stack, and put them back into the order in
+    // which they were sent.  (Messages from different threads are only ordered
+    // relative to the messages from the same thread.)
+    linux_thread_message_t *newest = incoming_messages_.exchange(nullptr,
+                                                                 std::memory_order_acquire);
+    linux_thread_message_t *oldest = nullptr;
+    while (newest != nullptr) {
+        linux_thread_message_t *next = newest->next_incoming;
+        newest->next_incoming = oldest;
+        oldest = newest;
+        newest = next;
     }
 
     // 2. Sort the messages into their respective priority queues
-    while (linux_thread_message_t *m = new_messages.head()) {
-        new_messages.remove(m);
+    while (linux_thread_message_t *m = oldest) {
+        oldest = m->next_incoming;
+        m->next_incoming = nullptr;
         int effective_priority = m->priority;
         if (m->is_ordered) {
             // Ordered messages are treated as if they had
@@ -221,38 +262,16 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
     }
 }
 
-bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
-}
-
 // Pushes messages collected locally global lists available to all
 // threads.
 void linux_message_hub_t::push_messages() {
     for (int i = 0; i < thread_pool_->n_threads; i++) {
-        // Append the local list for ith thread to that thread's global
-        // message list.
+        // Hand the local list for ith thread to that thread's message hub.
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
-            }
+            thread_pool_->threads[i]->message_hub.push_incoming_messages(
+                &queue->msg_local_list);
         }
     }
 }
@@ -4,10 +4,11 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
 #include "threading.hpp"
@@ -48,6 +49,14 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    // While our thread busy polls, other threads don't wake it up when they send it
+    // messages, so it has to call `poll_incoming_messages()` instead, which handles
+    // the messages and returns whether there were any.  Once busy polling has been
+    // turned off, `poll_incoming_messages()` must be called once more before the
+    // thread goes to sleep.
+    void set_busy_polling(bool busy_polling);
+    bool poll_incoming_messages();
+
     ~linux_message_hub_t();
 
 private:
@@ -73,11 +82,15 @@ private:
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
-    bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    // Hands `messages` to this message hub (which is usually another thread's), and
+    // wakes it up if it needs to.  Empties `messages`.
+    void push_incoming_messages(msg_list_t *messages);
+
+    // The messages that other threads have sent us, newest first, linked through
+    // their `next_incoming` fields.  Every thread pushes a whole batch of messages
+    // with a single compare-and-swap, and we take all of them at once, so neither
+    // side ever takes a lock.
+    std::atomic<linux_thread_message_t *> incoming_messages_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -89,8 +102,15 @@ private:
 
     void on_event(int events);
 
-    // The eventfd (or pipe-based alternative) notified after the first incoming
-    // message is put onto incoming_messages_.
+    // Handles a batch of messages by priority.
+    void process_messages();
+
+    // Whether our thread is busy polling, see `set_busy_polling()`.
+    std::atomic<bool> busy_polling_;
+
+    // The eventfd (or pipe-based alternative) notified when a batch of messages gets
+    // pushed onto an empty incoming_messages_.  Batches that get pushed after that
+    // are covered by the same notification.
     system_event_t event_;
 
     /* The thread that we queue messages originating from. (Recall that there is one
@@ -2,6 +2,8 @@
 #ifndef ARCH_RUNTIME_RUNTIME_HPP_
 #define ARCH_RUNTIME_RUNTIME_HPP_
 
+#include <stdint.h>
+
 #include "threading.hpp"
 
 class linux_thread_message_t;
@@ -11,6 +13,12 @@ threadnum_t get_thread_id();
 
 int get_num_threads();
 
+// The NUMA node that the thread has been pinned to, see `linux_thread_pool_t`.
+int get_thread_numa_node(threadnum_t thread);
+
+// How long idle threads busy poll for work, zero if they don't.
+int64_t get_busy_poll_nanos();
+
 #ifndef NDEBUG
 bool in_thread_pool();
 void assert_good_thread_id(threadnum_t thread);
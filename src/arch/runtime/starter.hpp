@@ -4,12 +4,17 @@
 
 // Implementation in runtime.cc.
 
+#include <stdint.h>
+
 #include <functional>
 
 /* `run_in_thread_pool()` starts a RethinkDB thread pool, runs the given
 function in a coroutine inside of it, waits for the function to return, and then
-shuts down the thread pool. */
+shuts down the thread pool.  With `pin_threads`, the worker threads are pinned to
+CPUs node by node, and idle threads busy poll for `busy_poll_nanos` before they go to
+sleep, see `linux_thread_pool_t`. */
 
-void run_in_thread_pool(const std::function<void()> &fun, int worker_threads);
+void run_in_thread_pool(const std::function<void()> &fun, int worker_threads,
+                        bool pin_threads = false, int64_t busy_poll_nanos = 0);
 
 #endif  // ARCH_RUNTIME_STARTER_HPP_
@@ -3,13 +3,21 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #ifndef _WIN32
+#include <dirent.h>
 #include <sys/time.h>
 #endif
 
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "arch/compiler.hpp"
 #include "arch/barrier.hpp"
 #include "arch/os_signal.hpp"
@@ -62,14 +70,16 @@ void linux_thread_pool_t::set_thread(linux_thread_t *val) {
     thread = val;
 }
 
-linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity) :
+linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity,
+                                         int64_t _busy_poll_nanos) :
 #ifndef NDEBUG
       coroutine_summary(false),
 #endif
       interrupt_message(nullptr),
       generic_blocker_pool(nullptr),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      do_set_affinity(_do_set_affinity),
+      busy_poll_nanos(_busy_poll_nanos)
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
@@ -81,6 +91,113 @@ linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affini
 
     res = pthread_mutex_init(&shutdown_cond_mutex, nullptr);
     guarantee_xerr(res == 0, res, "Could not create shutdown cond mutex");
+
+    assign_cpus();
+}
+
+#ifdef __linux__
+// Parses a CPU list like "0-7,16-23" from sysfs.
+static std::vector<int> parse_cpu_list(const char *list) {
+    std::vector<int> cpus;
+    const char *pos = list;
+    while (*pos != '\0' && *pos != '\n') {
+        char *end;
+        const long first = strtol(pos, &end, 10);
+        if (end == pos) {
+            break;
+        }
+        long last = first;
+        pos = end;
+        if (*pos == '-') {
+            ++pos;
+            last = strtol(pos, &end, 10);
+            if (end == pos) {
+                break;
+            }
+            pos = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if (*pos == ',') {
+            ++pos;
+        }
+    }
+    return cpus;
+}
+
+// Returns the CPUs of every NUMA node that has any, ordered by node id, or nothing if
+// sysfs doesn't describe the nodes.
+static std::vector<std::vector<int> > get_numa_node_cpus() {
+    std::vector<std::pair<int, std::vector<int> > > nodes;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir == nullptr) {
+        return std::vector<std::vector<int> >();
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        int node_id;
+        char extra;
+        if (sscanf(entry->d_name, "node%d%c", &node_id, &extra) != 1) {
+            continue;
+        }
+        std::string path = strprintf("/sys/devices/system/node/%s/cpulist",
+                                     entry->d_name);
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            continue;
+        }
+        char list[4096];
+        if (fgets(list, sizeof(list), file) != nullptr) {
+            std::vector<int> cpus = parse_cpu_list(list);
+            if (!cpus.empty()) {
+                nodes.push_back(std::make_pair(node_id, std::move(cpus)));
+            }
+        }
+        fclose(file);
+    }
+    closedir(dir);
+    std::sort(nodes.begin(), nodes.end());
+
+    std::vector<std::vector<int> > res;
+    for (auto &node : nodes) {
+        res.push_back(std::move(node.second));
+    }
+    return res;
+}
+#endif
+
+void linux_thread_pool_t::assign_cpus() {
+    for (int i = 0; i < n_threads; ++i) {
+        thread_cpus[i] = -1;
+        thread_numa_nodes[i] = 0;
+    }
+    if (!do_set_affinity) {
+        return;
+    }
+
+    std::vector<std::vector<int> > nodes;
+#ifdef __linux__
+    nodes = get_numa_node_cpus();
+#endif
+    if (nodes.empty()) {
+        nodes.emplace_back();
+        for (int cpu = 0; cpu < get_cpu_count(); ++cpu) {
+            nodes[0].push_back(cpu);
+        }
+    }
+
+    // Every node gets an equal block of consecutive worker threads, whose CPUs are
+    // spread evenly over the node's CPUs.
+    const int num_workers = n_threads - 1;
+    const int num_nodes = nodes.size();
+    for (int i = 0; i < num_workers; ++i) {
+        const int node = static_cast<int64_t>(i) * num_nodes / num_workers;
+        const int first_on_node =
+            (static_cast<int64_t>(node) * num_workers + num_nodes - 1) / num_nodes;
+        const std::vector<int> &cpus = nodes[node];
+        thread_cpus[i] = cpus[(i - first_on_node) % cpus.size()];
+        thread_numa_nodes[i] = node;
+    }
 }
 
 os_signal_cond_t *linux_thread_pool_t::exchange_interrupt_message(os_signal_cond_t *m) {
@@ -231,11 +348,9 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         if (do_set_affinity && !is_utility_thread) {
             // On Apple, the thread affinity API has awful documentation, so we don't even bother.
 #ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
             cpu_set_t mask;
             CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
+            CPU_SET(thread_cpus[i], &mask);
             res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
             guarantee_xerr(res == 0, res, "Could not set thread affinity");
 #endif
@@ -488,6 +603,14 @@ void linux_thread_t::pump() {
     message_hub.push_messages();
 }
 
+void linux_thread_t::set_busy_polling(bool busy_polling) {
+    message_hub.set_busy_polling(busy_polling);
+}
+
+bool linux_thread_t::poll() {
+    return message_hub.poll_incoming_messages();
+}
+
 void linux_thread_t::on_event(int events) {
     // No-op. This is just to make sure that the event queue wakes up
     // so it can shut down.
@@ -16,6 +16,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
+#include "arch/spinlock.hpp"
 #include "arch/timer.hpp"
 
 class linux_thread_t;
@@ -41,7 +42,8 @@ and shutting down the threads and event queues. */
 
 class linux_thread_pool_t {
 public:
-    linux_thread_pool_t(int worker_threads, bool do_set_affinity);
+    linux_thread_pool_t(int worker_threads, bool do_set_affinity,
+                        int64_t busy_poll_nanos);
 
     // When the process receives a SIGINT or SIGTERM, interrupt_message will be delivered to the
     // same thread that initial_message was delivered to, and interrupt_message will be set to
@@ -74,6 +76,9 @@ private:
 
     static void *start_thread(void*);
 
+    // Fills in `thread_cpus` and `thread_numa_nodes`.
+    void assign_cpus();
+
 #ifndef _WIN32
     static void interrupt_handler(int signo, siginfo_t *siginfo, void *);
     // Currently handles SIGSEGV and SIGBUS signals.
@@ -103,6 +108,18 @@ public:
     int n_threads;
     bool do_set_affinity;
 
+    // With `do_set_affinity`, consecutive worker threads are pinned to the CPUs of one
+    // NUMA node before the next node is used, so that `thread_numa_nodes` tells which
+    // threads share their memory.  The utility thread isn't pinned (its CPU is -1).
+    // Without `do_set_affinity`, or if the kernel doesn't tell us about its NUMA
+    // nodes, all threads count as being on node 0.
+    int thread_cpus[MAX_THREADS];
+    int thread_numa_nodes[MAX_THREADS];
+
+    // How long an idle thread keeps polling for work before it goes to sleep, see
+    // `epoll_event_queue_t::run()`.  Zero means that idle threads sleep right away.
+    const int64_t busy_poll_nanos;
+
 #ifdef _WIN32
     static linux_thread_pool_t *get_global_thread_pool();
 #endif
@@ -190,6 +207,8 @@ public:
 
     void pump();   // Called by the event queue
     bool should_shut_down();   // Called by the event queue
+    void set_busy_polling(bool busy_polling);   // Called by the event queue
+    bool poll();   // Called by the event queue
 #ifndef NDEBUG
     void initiate_shut_down(std::map<std::string, size_t> *coroutine_counts); // Can be called from any thread
 #else
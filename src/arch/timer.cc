@@ -7,11 +7,15 @@
 #include "time.hpp"
 #include "utils.hpp"
 
-class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t> {
+class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t>,
+                      public intrusive_list_node_t<timer_token_t> {
     friend class timer_handler_t;
 
 private:
-    timer_token_t() : interval_nanos(-1), next_time_in_nanos(-1), callback(nullptr) { }
+    timer_token_t()
+        : interval_nanos(-1), next_time_in_nanos(-1), callback(nullptr),
+          location(location_t::QUEUE), wheel_expiry_tick(-1), wheel_level(-1),
+          wheel_slot(-1) { }
 
     friend bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right);
 
@@ -24,6 +28,15 @@ private:
     // The callback we call upon each 'ring'.
     timer_callback_t *callback;
 
+    // Which of the timer handler's containers the token is in.
+    enum class location_t { QUEUE, WHEEL, EXPIRED };
+    location_t location;
+
+    // The wheel tick at which the token rings, and its slot, if it's in the wheel.
+    int64_t wheel_expiry_tick;
+    int wheel_level;
+    int wheel_slot;
+
     DISABLE_COPYING(timer_token_t);
 };
 
@@ -31,44 +44,211 @@ bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *rig
     return left->next_time_in_nanos < right->next_time_in_nanos;
 }
 
+// `wheel_occupied` has one bit per slot.
+static_assert(timer_handler_t::WHEEL_SLOTS == 64, "wheel levels must have 64 slots");
+
 timer_handler_t::timer_handler_t(linux_event_queue_t *queue)
     : timer_provider(queue),
-      expected_oneshot_time_in_nanos(0) {
+      expected_oneshot_time_in_nanos(0),
+      oneshot_scheduled(false),
+      wheel_tick(get_ticks().nanos / WHEEL_TICK_NANOS),
+      wheel_size(0) {
     // Right now, we have no tokens.  So we don't ask the timer provider to do anything for us.
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        wheel_occupied[level] = 0;
+    }
 }
 
 timer_handler_t::~timer_handler_t() {
     guarantee(token_queue.empty());
+    guarantee(wheel_size == 0);
+    guarantee(expired_tokens.empty());
 }
 
 void timer_handler_t::on_oneshot() {
+    oneshot_scheduled = false;
+
     // If the timer_provider tends to return its callback a touch early, we don't want to make a
     // bunch of calls to it, returning a tad early over and over again, leading up to a ticks
     // threshold.  So we bump the real time up to the threshold when processing the priority queue.
     int64_t real_ticks = get_ticks().nanos;
     int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
 
+    // All the wheel tokens that are due ring as one batch.  Callbacks may cancel the
+    // tokens in the batch that haven't rung yet.
+    advance_wheel(ticks / WHEEL_TICK_NANOS);
+    while (!expired_tokens.empty()) {
+        timer_token_t *token = expired_tokens.head();
+        expired_tokens.pop_front();
+        ring_token(token, real_ticks);
+    }
+
     while (!token_queue.empty() && token_queue.peek()->next_time_in_nanos <= ticks) {
-        timer_token_t *token = token_queue.pop();
+        ring_token(token_queue.pop(), real_ticks);
+    }
+
+    // We've processed young tokens.  Now schedule a new one-shot (if necessary).
+    schedule_next_oneshot();
+}
+
+void timer_handler_t::ring_token(timer_token_t *token, int64_t real_ticks) {
+    // Put the repeating timer back on the queue before the callback can be called (so that it
+    // may be canceled).
+    if (token->interval_nanos != 0) {
+        token->next_time_in_nanos = real_ticks + token->interval_nanos;
+        insert_token(token, real_ticks);
+    }
+
+    token->callback->on_timer(ticks_t{real_ticks});
+
+    // Delete nonrepeating timer tokens.
+    if (token->interval_nanos == 0) {
+        delete token;
+    }
+}
+
+void timer_handler_t::insert_token(timer_token_t *token, int64_t now_in_nanos) {
+    if (token->next_time_in_nanos - now_in_nanos >= WHEEL_MIN_DELAY_NANOS) {
+        // `wheel_tick` only moves on in `on_oneshot()`.  Catching up with the ticks
+        // that have passed since then (as far as we can without anything being due)
+        // lets the token go on a lower level.
+        wheel_tick = std::max(
+            wheel_tick,
+            std::min(now_in_nanos / WHEEL_TICK_NANOS, next_wheel_event_tick() - 1));
+
+        const int64_t tick =
+            (token->next_time_in_nanos + WHEEL_TICK_NANOS - 1) / WHEEL_TICK_NANOS;
+        const int top_shift = WHEEL_SLOT_BITS * WHEEL_LEVELS;
+        if (tick > wheel_tick && (tick >> top_shift) == (wheel_tick >> top_shift)) {
+            token->wheel_expiry_tick = tick;
+            insert_into_wheel(token);
+            return;
+        }
+    }
+    token->location = timer_token_t::location_t::QUEUE;
+    token_queue.push(token);
+}
+
+void timer_handler_t::insert_into_wheel(timer_token_t *token) {
+    const int64_t tick = token->wheel_expiry_tick;
+    rassert(tick > wheel_tick);
+    int level = 0;
+    while ((tick >> (WHEEL_SLOT_BITS * (level + 1)))
+           != (wheel_tick >> (WHEEL_SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    guarantee(level < WHEEL_LEVELS);
+    const int slot = (tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
 
-        // Put the repeating timer back on the queue before the callback can be called (so that it
-        // may be canceled).
-        if (token->interval_nanos != 0) {
-            token->next_time_in_nanos = real_ticks + token->interval_nanos;
-            token_queue.push(token);
+    token->location = timer_token_t::location_t::WHEEL;
+    token->wheel_level = level;
+    token->wheel_slot = slot;
+    wheel[level][slot].push_back(token);
+    wheel_occupied[level] |= uint64_t(1) << slot;
+    ++wheel_size;
+}
+
+void timer_handler_t::remove_token(timer_token_t *token) {
+    switch (token->location) {
+    case timer_token_t::location_t::QUEUE:
+        token_queue.remove(token);
+        break;
+    case timer_token_t::location_t::WHEEL: {
+        intrusive_list_t<timer_token_t> *list =
+            &wheel[token->wheel_level][token->wheel_slot];
+        list->remove(token);
+        if (list->empty()) {
+            wheel_occupied[token->wheel_level] &= ~(uint64_t(1) << token->wheel_slot);
         }
+        --wheel_size;
+    } break;
+    case timer_token_t::location_t::EXPIRED:
+        expired_tokens.remove(token);
+        break;
+    default:
+        unreachable();
+    }
+}
 
-        token->callback->on_timer(ticks_t{real_ticks});
+int64_t timer_handler_t::next_wheel_event_tick() const {
+    int64_t result = INT64_MAX;
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        const int shift = WHEEL_SLOT_BITS * level;
+        const int current = (wheel_tick >> shift) & (WHEEL_SLOTS - 1);
+        rassert((wheel_occupied[level] & ((uint64_t(2) << current) - 1)) == 0);
+        const uint64_t ahead = current == WHEEL_SLOTS - 1
+            ? 0
+            : wheel_occupied[level] >> (current + 1);
+        if (ahead != 0) {
+            // Level 0 slots ring when we get to them, the others are moved down.
+            const int64_t slot_start =
+                ((wheel_tick >> shift) + 1 + __builtin_ctzll(ahead)) << shift;
+            result = std::min(result, slot_start);
+        }
+    }
+    return result;
+}
 
-        // Delete nonrepeating timer tokens.
-        if (token->interval_nanos == 0) {
-            delete token;
+void timer_handler_t::advance_wheel(int64_t tick) {
+    while (wheel_size != 0) {
+        const int64_t next = next_wheel_event_tick();
+        if (next > tick) {
+            break;
+        }
+        // Nothing happens in the ticks before `next`, so we skip straight to it.
+        wheel_tick = next;
+        // Higher levels go first, so that their tokens can move all the way down.
+        for (int level = WHEEL_LEVELS - 1; level >= 0; --level) {
+            const int shift = WHEEL_SLOT_BITS * level;
+            if ((wheel_tick & ((int64_t(1) << shift) - 1)) != 0) {
+                continue;
+            }
+            const int slot = (wheel_tick >> shift) & (WHEEL_SLOTS - 1);
+            if ((wheel_occupied[level] & (uint64_t(1) << slot)) == 0) {
+                continue;
+            }
+            intrusive_list_t<timer_token_t> tokens;
+            tokens.append_and_clear(&wheel[level][slot]);
+            wheel_occupied[level] &= ~(uint64_t(1) << slot);
+            wheel_size -= tokens.size();
+            while (!tokens.empty()) {
+                timer_token_t *token = tokens.head();
+                tokens.pop_front();
+                if (token->wheel_expiry_tick <= wheel_tick) {
+                    token->location = timer_token_t::location_t::EXPIRED;
+                    expired_tokens.push_back(token);
+                } else {
+                    insert_into_wheel(token);
+                }
+            }
         }
     }
+    wheel_tick = std::max(wheel_tick, tick);
+}
 
-    // We've processed young tokens.  Now schedule a new one-shot (if necessary).
+void timer_handler_t::schedule_oneshot(int64_t time_in_nanos) {
+    if (!oneshot_scheduled || time_in_nanos < expected_oneshot_time_in_nanos) {
+        timer_provider.schedule_oneshot(time_in_nanos, this);
+        expected_oneshot_time_in_nanos = time_in_nanos;
+        oneshot_scheduled = true;
+    }
+}
+
+void timer_handler_t::schedule_next_oneshot() {
+    // We wake up for every wheel slot that has to be moved down a level, not just for
+    // the first token that's due, because finding that token would take a search.
+    int64_t next_time = INT64_MAX;
     if (!token_queue.empty()) {
-        timer_provider.schedule_oneshot(token_queue.peek()->next_time_in_nanos, this);
+        next_time = token_queue.peek()->next_time_in_nanos;
+    }
+    if (wheel_size != 0) {
+        next_time = std::min(next_time, next_wheel_event_tick() * WHEEL_TICK_NANOS);
+    }
+    if (next_time != INT64_MAX) {
+        schedule_oneshot(next_time);
+    } else if (oneshot_scheduled) {
+        timer_provider.unschedule_oneshot();
+        oneshot_scheduled = false;
     }
 }
 
@@ -83,22 +263,19 @@ timer_token_t *timer_handler_t::add_timer_internal(
     token->next_time_in_nanos = next_time.nanos;
     token->callback = callback;
 
-    const timer_token_t *top_entry = token_queue.peek();
-    token_queue.push(token);
-
-    if (top_entry == nullptr || next_time.nanos < top_entry->next_time_in_nanos) {
-        timer_provider.schedule_oneshot(next_time.nanos, this);
-    }
+    insert_token(token, get_ticks().nanos);
+    schedule_next_oneshot();
 
     return token;
 }
 
 void timer_handler_t::cancel_timer(timer_token_t *token) {
-    token_queue.remove(token);
+    remove_token(token);
     delete token;
 
-    if (token_queue.empty()) {
+    if (token_queue.empty() && wheel_size == 0 && oneshot_scheduled) {
         timer_provider.unschedule_oneshot();
+        oneshot_scheduled = false;
     }
 }
 
@@ -3,6 +3,7 @@
 #define ARCH_TIMER_HPP_
 
 #include "arch/io/timer_provider.hpp"
+#include "containers/intrusive_list.hpp"
 #include "containers/intrusive_priority_queue.hpp"
 #include "time.hpp"
 
@@ -18,7 +19,13 @@ struct timer_callback_t {
 /* This timer class uses the underlying OS timer provider to get one-shot timing
  * events. It then manages a list of application timers based on that lower level
  * interface. Everyone who needs a timer should use this class (through the thread
- * pool). */
+ * pool).
+ *
+ * Timers that are due soon are kept in a priority queue and ring on time.  Most
+ * longer timers are timeouts that get canceled before they ring (heartbeats, read
+ * timeouts, ...), so those go into a hierarchical timer wheel instead, where adding
+ * and canceling a timer takes constant time.  Wheel timers ring at the first
+ * millisecond tick at or after their time. */
 class timer_handler_t : private timer_provider_callback_t {
 public:
     explicit timer_handler_t(linux_event_queue_t *queue);
@@ -29,9 +36,35 @@ public:
                                       timer_callback_t *callback);
     void cancel_timer(timer_token_t *timer);
 
+    // The wheel has `WHEEL_LEVELS` levels of `WHEEL_SLOTS` slots.  A slot on level
+    // `n` covers `WHEEL_SLOTS^n` ticks of `WHEEL_TICK_NANOS`.
+    static const int WHEEL_LEVELS = 4;
+    static const int WHEEL_SLOT_BITS = 6;
+    static const int WHEEL_SLOTS = 1 << WHEEL_SLOT_BITS;
+    static const int64_t WHEEL_TICK_NANOS = 1000000;
+    // Timers that are due sooner than this go into the priority queue.
+    static const int64_t WHEEL_MIN_DELAY_NANOS = 50 * WHEEL_TICK_NANOS;
+
 private:
     void on_oneshot();
 
+    void insert_token(timer_token_t *token, int64_t now_in_nanos);
+    void remove_token(timer_token_t *token);
+    void ring_token(timer_token_t *token, int64_t real_ticks);
+
+    // Puts a token into the slot for its tick, relative to `wheel_tick`.
+    void insert_into_wheel(timer_token_t *token);
+    // The first tick after `wheel_tick` at which a wheel slot must either ring or be
+    // moved down a level, or `INT64_MAX` if the wheel is empty.
+    int64_t next_wheel_event_tick() const;
+    // Moves `wheel_tick` up to `tick`, moving the tokens that are due to
+    // `expired_tokens`.
+    void advance_wheel(int64_t tick);
+
+    // Starts a oneshot for `time_in_nanos` unless one is due before then.
+    void schedule_oneshot(int64_t time_in_nanos);
+    void schedule_next_oneshot();
+
     // The timer provider, a platform-dependent typedef for interfacing with the OS.
     timer_provider_t timer_provider;
 
@@ -39,9 +72,24 @@ private:
     // than this time, we pretend that it had arrived on time.
     int64_t expected_oneshot_time_in_nanos;
 
+    bool oneshot_scheduled;
+
     // A priority queue of timer tokens, ordered by the soonest.
     intrusive_priority_queue_t<timer_token_t> token_queue;
 
+    // Every tick up to and including `wheel_tick` has been processed.  A token lives
+    // on the lowest level whose slots still share the next level's slot with
+    // `wheel_tick`, which means it's always in a slot after the current one.  Tokens
+    // that don't even share a top level slot go into the priority queue.
+    int64_t wheel_tick;
+    intrusive_list_t<timer_token_t> wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+    // Bit `i` of `wheel_occupied[n]` is set if `wheel[n][i]` is not empty.
+    uint64_t wheel_occupied[WHEEL_LEVELS];
+    size_t wheel_size;
+
+    // Wheel tokens that are due and are about to ring.
+    intrusive_list_t<timer_token_t> expired_tokens;
+
     DISABLE_COPYING(timer_handler_t);
 };
 
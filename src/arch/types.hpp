@@ -105,8 +105,29 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which disk manager sits at the bottom of the I/O stack. `pool` runs blocking
+// syscalls in a `blocker_pool_t`, `io_uring` submits operations to the kernel
+// asynchronously and falls back to `pool` if the kernel doesn't support io_uring.
+enum class io_backend_mode_t {
+    pool,
+    io_uring
+};
+
 enum class datasync_op { no_datasyncs, wrap_in_datasyncs, datasync_after };
 
+// The disk manager sends the requests of the more urgent classes to the disk first, but
+// it doesn't let any class wait for much longer than its target latency; see
+// `accounting_diskmgr_t`.  The order here is the order of urgency.
+enum class io_class_t {
+    // Reads that a query or a cache miss is waiting for.
+    foreground_read = 0,
+    // Flushes of the page cache and other writes that queries wait for eventually.
+    foreground_write,
+    // Garbage collection, backfills and secondary index construction.
+    background
+};
+const size_t NUM_IO_CLASSES = 3;
+
 // A linux file.  It expects reads and writes and buffers to have an
 // alignment of DEVICE_BLOCK_SIZE.
 class file_t {
@@ -117,6 +138,10 @@ public:
     virtual int64_t get_file_size() = 0;
     virtual void set_file_size(int64_t size) = 0;
     virtual void set_file_size_at_least(int64_t size, int64_t extent_size) = 0;
+    // Tells the file system that the given range doesn't hold any data anymore, so
+    // that it can free the space.  The range reads as zeros afterwards.  This is a
+    // hint: files that can't do it keep the data.
+    virtual void discard(UNUSED int64_t offset, UNUSED int64_t length) { }
 
     virtual void read_async(int64_t offset, size_t length, void *buf,
                             file_account_t *account, linux_iocallback_t *cb) = 0;
@@ -127,18 +152,29 @@ public:
     virtual void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                               file_account_t *account, linux_iocallback_t *cb) = 0;
 
-    virtual void *create_account(int priority, int outstanding_requests_limit) = 0;
+    virtual void *create_account(int priority, int outstanding_requests_limit,
+                                 io_class_t io_class) = 0;
     virtual void destroy_account(void *account) = 0;
 
     virtual bool coop_lock_and_check() = 0;
 
+    // Maps `length` bytes starting at `offset` read-only into memory, or returns null
+    // if the file can't be mapped.  The mapping sees later writes to the file.  Files
+    // that don't support mapping can keep these defaults.
+    virtual const char *map_read_only(UNUSED int64_t offset, UNUSED size_t length) {
+        return nullptr;
+    }
+    virtual void unmap(UNUSED const char *data, UNUSED size_t length) { }
+
 private:
     DISABLE_COPYING(file_t);
 };
 
 class file_account_t {
 public:
-    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
+    file_account_t(file_t *f, int p,
+                   int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS,
+                   io_class_t io_class = io_class_t::foreground_write);
     ~file_account_t();
     void *get_account() { return account; }
 
@@ -311,6 +311,11 @@ public:
         { }
 
 private:
+    /* A backfill reads every block in the range once. */
+    page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::streaming;
+    }
+
     /* Skip B-tree subtrees that haven't changed since the reference timestamp and that
     don't overlap with any pre-items' ranges. */
     continue_bool_t filter_range_ts(
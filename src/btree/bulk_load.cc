@@ -0,0 +1,173 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "btree/bulk_load.hpp"
+
+#include <string.h>
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "buffer_cache/alt.hpp"
+
+btree_bulk_loader_t::level_t::level_t(max_block_size_t block_size)
+    : node(block_size.value()),
+      num_children(0),
+      last_child(NULL_BLOCK_ID),
+      recency(repli_timestamp_t::distant_past) {
+    internal_node::init(block_size, node.get());
+}
+
+btree_bulk_loader_t::btree_bulk_loader_t(value_sizer_t *sizer,
+                                         superblock_t *superblock)
+    : sizer_(sizer),
+      superblock_(superblock),
+      leaf_(sizer->block_size().value()),
+      leaf_is_empty_(true),
+      leaf_recency_(repli_timestamp_t::distant_past),
+      num_pairs_(0),
+      finished_(false) {
+    guarantee(superblock_->get_root_block_id() == NULL_BLOCK_ID,
+              "Bulk loading requires an empty btree.");
+    leaf::init(sizer_, leaf_.get());
+}
+
+btree_bulk_loader_t::~btree_bulk_loader_t() {
+    if (!finished_) {
+        finish();
+    }
+}
+
+void btree_bulk_loader_t::add(const btree_key_t *key,
+                              const void *value,
+                              repli_timestamp_t tstamp) {
+    guarantee(!finished_);
+    guarantee(num_pairs_ == 0 || btree_key_cmp(key, last_key_.btree_key()) > 0,
+              "Keys must be bulk loaded in ascending order.");
+    if (!leaf_is_empty_ && leaf::is_full(sizer_, leaf_.get(), key, value)) {
+        write_leaf();
+    }
+    leaf::insert(sizer_,
+                 leaf_.get(),
+                 key,
+                 value,
+                 tstamp,
+                 leaf_recency_,
+                 key_modification_proof_t::real_proof());
+    leaf_recency_ = superceding_recency(leaf_recency_, tstamp);
+    leaf_is_empty_ = false;
+    last_key_.assign(key);
+    ++num_pairs_;
+}
+
+void btree_bulk_loader_t::finish() {
+    guarantee(!finished_);
+    finished_ = true;
+    if (num_pairs_ == 0) {
+        return;
+    }
+
+    write_leaf();
+    // Completing the last node on one level adds a child to the level above, so we
+    // go up until there's a level with only one child, which is the root.
+    block_id_t root = NULL_BLOCK_ID;
+    for (size_t i = 0; root == NULL_BLOCK_ID; ++i) {
+        level_t *level = levels_[i].get();
+        if (i + 1 == levels_.size() && level->num_children == 1) {
+            root = level->last_child;
+        } else {
+            guarantee(level->num_children >= 2);
+            const store_key_t max_key = level->last_key;
+            const repli_timestamp_t recency = level->recency;
+            block_id_t node_id = write_internal_node(level);
+            add_child(i + 1, node_id, max_key, recency);
+        }
+    }
+    insert_root(root, superblock_);
+
+    // The stats block is detached from the rest of the btree, so we pass the txn as
+    // its parent (like `apply_keyvalue_change()` does).
+    const block_id_t stat_block_id = superblock_->get_stat_block_id();
+    if (stat_block_id != NULL_BLOCK_ID) {
+        buf_lock_t stat_block(buf_parent_t(superblock_->expose_buf().txn()),
+                              stat_block_id, access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        auto stat_block_buf = static_cast<btree_statblock_t *>(
+            stat_block_write.get_data_write(BTREE_STATBLOCK_SIZE));
+        stat_block_buf->population += num_pairs_;
+    }
+}
+
+void btree_bulk_loader_t::write_leaf() {
+    guarantee(!leaf_is_empty_);
+    buf_lock_t buf(superblock_->expose_buf(), alt_create_t::create);
+    {
+        buf_write_t write(&buf);
+        memcpy(write.get_data_write(), leaf_.get(), sizer_->block_size().value());
+    }
+    buf.set_recency(leaf_recency_);
+    add_child(0, buf.block_id(), last_key_, leaf_recency_);
+
+    leaf::init(sizer_, leaf_.get());
+    leaf_is_empty_ = true;
+    leaf_recency_ = repli_timestamp_t::distant_past;
+}
+
+void btree_bulk_loader_t::add_child(size_t level_index,
+                                    block_id_t child,
+                                    const store_key_t &max_key,
+                                    repli_timestamp_t recency) {
+    if (level_index == levels_.size()) {
+        levels_.push_back(make_scoped<level_t>(sizer_->block_size()));
+    }
+    level_t *level = levels_[level_index].get();
+
+    if (level->num_children >= 2 && internal_node::is_full(level->node.get())) {
+        // We write the node without its last child, which goes into the next node
+        // together with `child`.  That way no node ends up with only one child.
+        guarantee(level->num_children >= 3);
+        const store_key_t node_max_key(&internal_node::get_pair_by_index(
+            level->node.get(), level->node->npairs - 2)->key);
+        const block_id_t moved_child = level->last_child;
+        const store_key_t moved_key = level->last_key;
+        internal_node::remove(
+            sizer_->block_size(), level->node.get(), moved_key.btree_key());
+
+        // The moved child's recency is still included in `level->recency`.  That's
+        // more conservative than it needs to be, but it's what splitting does too.
+        const repli_timestamp_t node_recency = level->recency;
+        block_id_t node_id = write_internal_node(level);
+        add_child(level_index + 1, node_id, node_max_key, node_recency);
+
+        level->last_child = moved_child;
+        level->last_key = moved_key;
+        level->num_children = 1;
+        level->recency = node_recency;
+    }
+
+    if (level->num_children >= 1) {
+        DEBUG_VAR bool success = internal_node::insert(
+            level->node.get(), level->last_key.btree_key(), level->last_child, child);
+        rassert(success, "could not insert internal btree node");
+    }
+    level->last_child = child;
+    level->last_key = max_key;
+    ++level->num_children;
+    level->recency = superceding_recency(level->recency, recency);
+}
+
+block_id_t btree_bulk_loader_t::write_internal_node(level_t *level) {
+    buf_lock_t buf(superblock_->expose_buf(), alt_create_t::create);
+    {
+        buf_write_t write(&buf);
+        memcpy(write.get_data_write(),
+               level->node.get(),
+               sizer_->block_size().value());
+    }
+    buf.set_recency(level->recency);
+
+    internal_node::init(sizer_->block_size(), level->node.get());
+    level->num_children = 0;
+    level->last_child = NULL_BLOCK_ID;
+    level->recency = repli_timestamp_t::distant_past;
+    return buf.block_id();
+}
@@ -0,0 +1,81 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BTREE_BULK_LOAD_HPP_
+#define BTREE_BULK_LOAD_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "containers/scoped.hpp"
+#include "repli_timestamp.hpp"
+#include "serializer/types.hpp"
+
+struct internal_node_t;
+struct leaf_node_t;
+class superblock_t;
+class value_sizer_t;
+
+/* `btree_bulk_loader_t` builds a B-tree bottom-up from key/value pairs that arrive in
+ascending key order.  Instead of looking up the leaf for every key with
+`find_keyvalue_location_for_write()` and splitting nodes as they fill up, it fills one
+leaf node after the other, and it writes the internal nodes above them as soon as they
+are complete.  All leaves end up at the same depth, and every node except for the last
+one on each level is full.
+
+The tree under `superblock` must be empty.  The loader writes the nodes through the
+superblock's transaction, and stores the new root in the superblock in `finish()`.  If
+the loader gets destroyed before `finish()` is called, it finishes the tree with the
+pairs it has been given so far.
+
+The values have to be complete values for `sizer`.  Blocks that a value refers to (such
+as the blocks of a blob) must have been created by the caller. */
+class btree_bulk_loader_t {
+public:
+    btree_bulk_loader_t(value_sizer_t *sizer, superblock_t *superblock);
+    ~btree_bulk_loader_t();
+
+    // `key` must be greater than all keys that have been added before.
+    void add(const btree_key_t *key, const void *value, repli_timestamp_t tstamp);
+
+    void finish();
+
+    int64_t num_pairs() const { return num_pairs_; }
+
+private:
+    // The internal node that is being filled on one level of the tree.  Once it
+    // has two or more children, its special last pair points to `last_child`.
+    struct level_t {
+        explicit level_t(max_block_size_t block_size);
+        scoped_malloc_t<internal_node_t> node;
+        int num_children;
+        block_id_t last_child;
+        // The greatest key in the subtree of `last_child`.
+        store_key_t last_key;
+        repli_timestamp_t recency;
+    };
+
+    void write_leaf();
+    void add_child(size_t level, block_id_t child, const store_key_t &max_key,
+                   repli_timestamp_t recency);
+    block_id_t write_internal_node(level_t *level);
+
+    value_sizer_t *const sizer_;
+    superblock_t *const superblock_;
+
+    scoped_malloc_t<leaf_node_t> leaf_;
+    bool leaf_is_empty_;
+    repli_timestamp_t leaf_recency_;
+    store_key_t last_key_;
+
+    // `levels_[0]` is the level of internal nodes right above the leaves,
+    // `levels_[1]` the one above that, and so on.
+    std::vector<scoped_ptr_t<level_t> > levels_;
+
+    int64_t num_pairs_;
+    bool finished_;
+
+    DISABLE_COPYING(btree_bulk_loader_t);
+};
+
+#endif  // BTREE_BULK_LOAD_HPP_
@@ -82,6 +82,13 @@ public:
     }
 
     virtual continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, signal_t *) {
+        bool skip;
+        cb_->filter_key(keyvalue.key(), &skip);
+        if (skip) {
+            return failure_cond_->is_pulsed()
+                ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
+        }
+
         // First thing first: Get in line with the token enforcer.
 
         fifo_enforcer_write_token_t token = source_.enter_write();
@@ -107,6 +114,18 @@ public:
             ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
     }
 
+    virtual page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return cb_->get_access_hint();
+    }
+
+    virtual bool prefetch_children() THROWS_NOTHING {
+        return cb_->prefetch_children();
+    }
+
+    virtual bool prefetch_wanted_children() THROWS_NOTHING {
+        return cb_->prefetch_wanted_children();
+    }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING {
         return cb_->get_trace();
     }
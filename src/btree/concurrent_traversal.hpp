@@ -44,6 +44,14 @@ public:
         *skip_out = false;
     }
 
+    /* Like `filter_range()`, but for the keys of a leaf. If it sets `*skip_out` to
+    `true`, `handle_pair()` won't be called for the key. This happens before the pair
+    gets in line for `handle_pair()`, so skipping a key here is much cheaper than
+    returning early from `handle_pair()`. */
+    virtual void filter_key(UNUSED const btree_key_t *key, bool *skip_out) {
+        *skip_out = false;
+    }
+
     // Passes a keyvalue and a callback.  waiter.wait_interruptible() must be called to
     // begin the region of "exclusive access", which only handle_pair implementation
     // can enters at a time.  (This should happen after loading the value from disk
@@ -54,6 +62,13 @@ public:
             concurrent_traversal_fifo_enforcer_signal_t waiter)
             THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* See `depth_first_traversal_callback_t`. */
+    virtual page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::normal;
+    }
+    virtual bool prefetch_children() THROWS_NOTHING { return false; }
+    virtual bool prefetch_wanted_children() THROWS_NOTHING { return false; }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return nullptr; }
 
 protected:
@@ -1,11 +1,18 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/depth_first_traversal.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #include "btree/internal_node.hpp"
 #include "btree/operations.hpp"
 #include "concurrency/interruptor.hpp"
 #include "rdb_protocol/profile.hpp"
 
+// How many children of an internal node a traversal asks the cache to prefetch ahead
+// of the one it's in, once it has moved on from the first one.
+const int TRAVERSAL_PREFETCH_WINDOW = 4;
+
 scoped_key_value_t::scoped_key_value_t(const btree_key_t *_key,
                                        const void *_value,
                                        movable_t<counted_buf_lock_and_read_t> &&buf)
@@ -163,7 +170,7 @@ continue_bool_t btree_depth_first_traversal(
     if (skip) {
         return continue_bool_t::CONTINUE;
     }
-    block->read.init(new buf_read_t(&block->lock));
+    block->read.init(new buf_read_t(&block->lock, cb->get_access_hint()));
     const node_t *node = static_cast<const node_t *>(block->read->get_data_read());
     if (node::is_internal(node)) {
         if (continue_bool_t::ABORT == cb->handle_pre_internal(
@@ -180,10 +187,50 @@ continue_bool_t btree_depth_first_traversal(
             r.decrement();
             end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
         }
+        if (cb->prefetch_wanted_children()) {
+            std::vector<block_id_t> wanted;
+            for (int index = start_index; index < end_index; ++index) {
+                const btree_key_t *child_left_excl_or_null;
+                const btree_key_t *child_right_incl;
+                get_child_key_range(inode, index,
+                                    left_excl_or_null, right_incl,
+                                    &child_left_excl_or_null, &child_right_incl);
+                if (continue_bool_t::ABORT == cb->filter_range(
+                        child_left_excl_or_null, child_right_incl, interruptor,
+                        &skip)) {
+                    return continue_bool_t::ABORT;
+                }
+                if (!skip) {
+                    wanted.push_back(
+                        internal_node::get_pair_by_index(inode, index)->lnode);
+                }
+            }
+            // With only one child, there's nothing to load in parallel.
+            if (wanted.size() > 1) {
+                block->lock.prefetch_children(wanted);
+            }
+        }
+        const bool prefetch = cb->prefetch_children();
+        // We only start prefetching once we move on to the second child, so that
+        // short reads that stay in one child don't load any extra blocks.  The child
+        // we're about to acquire doesn't need to be prefetched.
+        int prefetched_until = 2;
         for (int i = 0; i < end_index - start_index; ++i) {
             int true_index = (direction == FORWARD ? start_index + i : (end_index - 1) - i);
             const btree_internal_pair *pair = internal_node::get_pair_by_index(inode, true_index);
 
+            if (prefetch && i > 0) {
+                const int prefetch_end =
+                    std::min(i + TRAVERSAL_PREFETCH_WINDOW + 1, end_index - start_index);
+                for (; prefetched_until < prefetch_end; ++prefetched_until) {
+                    const int index = (direction == FORWARD
+                                       ? start_index + prefetched_until
+                                       : (end_index - 1) - prefetched_until);
+                    block->lock.prefetch_child(
+                        internal_node::get_pair_by_index(inode, index)->lnode);
+                }
+            }
+
             // Get the child key range
             const btree_key_t *child_left_excl_or_null;
             const btree_key_t *child_right_incl;
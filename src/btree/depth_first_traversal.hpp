@@ -126,6 +126,25 @@ public:
     resulting key ranges would be contiguous and non-overlapping, and they would together
     cover the full range of the traversal. */
 
+    /* Tells the cache how the traversal is going to use the blocks it acquires.
+    Traversals that visit each block once and are unlikely to come back soon should
+    return `page_access_hint_t::streaming`, so that their blocks get evicted before
+    the rest of the cache. */
+    virtual page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::normal;
+    }
+
+    /* If this returns true, traversals that move on from one child of an internal
+    node to the next will ask the cache to start loading the next few children, so
+    that long range scans don't wait for one block at a time. */
+    virtual bool prefetch_children() THROWS_NOTHING { return false; }
+
+    /* If this returns true, the traversal calls `filter_range()` for all the children
+    of an internal node before it goes into the first, and has the cache load the ones
+    that aren't skipped all at once, in the order they are in the file.  This is for
+    traversals that skip most of the tree, such as reads of a set of keys. */
+    virtual bool prefetch_wanted_children() THROWS_NOTHING { return false; }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return nullptr; }
 protected:
     virtual ~depth_first_traversal_callback_t() { }
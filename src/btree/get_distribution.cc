@@ -90,11 +90,13 @@ public:
 
 void get_btree_key_distribution(superblock_t *superblock, int depth_limit,
                                 int64_t *key_count_out,
-                                std::vector<store_key_t> *keys_out) {
+                                std::vector<store_key_t> *keys_out,
+                                release_superblock_t release_superblock) {
     get_distribution_traversal_helper_t helper(depth_limit, keys_out);
     rassert(keys_out->empty(), "Why is this output parameter not an empty vector\n");
 
     cond_t non_interruptor;
-    btree_parallel_traversal(superblock, &helper, &non_interruptor);
+    btree_parallel_traversal(
+        superblock, &helper, &non_interruptor, release_superblock);
     *key_count_out = helper.key_count;
 }
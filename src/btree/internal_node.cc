@@ -23,6 +23,10 @@ void delete_offset(internal_node_t *node, int index);
 void insert_offset(internal_node_t *node, uint16_t offset, int index);
 void make_last_pair_special(internal_node_t *node);
 bool is_equal(const btree_key_t *key1, const btree_key_t *key2);
+
+// The first eight bytes of the key as a big-endian integer, padded with zeros.  If two
+// keys' prefixes differ, the keys compare the same way as their prefixes.
+uint64_t key_prefix(const btree_key_t *key);
 }  // namespace impl
 
 void init(block_size_t block_size, internal_node_t *node) {
@@ -357,7 +361,27 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index) {
 }
 
 int get_offset_index(const internal_node_t *node, const btree_key_t *key) {
-    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    // The same as a `std::lower_bound` with `internal_key_comp`, except that most
+    // probes get decided by comparing the keys' prefixes, without calling
+    // `btree_key_cmp`.
+    const uint64_t key_prefix = impl::key_prefix(key);
+    int begin = 0;
+    int count = node->npairs - 1;
+    while (count > 0) {
+        const int half = count / 2;
+        const btree_key_t *probe = &get_pair_by_index(node, begin + half)->key;
+        const uint64_t probe_prefix = impl::key_prefix(probe);
+        const bool probe_is_less = probe_prefix != key_prefix
+            ? probe_prefix < key_prefix
+            : btree_key_cmp(probe, key) < 0;
+        if (probe_is_less) {
+            begin += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return begin;
 }
 
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2) {
@@ -460,6 +484,15 @@ bool is_equal(const btree_key_t *key1, const btree_key_t *key2) {
     return btree_key_cmp(key1, key2) == 0;
 }
 
+uint64_t key_prefix(const btree_key_t *key) {
+    // We can't read past the end of the key, it might be the last thing in the node.
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        prefix = (prefix << 8) | (i < key->size ? key->contents[i] : 0);
+    }
+    return prefix;
+}
+
 }  // namespace impl
 
 }  // namespace internal_node
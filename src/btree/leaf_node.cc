@@ -7,6 +7,7 @@
 #include <set>
 
 #include "btree/node.hpp"
+#include "math.hpp"
 #include "repli_timestamp.hpp"
 #include "utils.hpp"
 
@@ -150,6 +151,130 @@ repli_timestamp_t get_timestamp(const leaf_node_t *node, int offset) {
     return *reinterpret_cast<const repli_timestamp_t *>(reinterpret_cast<const char *>(node) + offset);
 }
 
+// Key heads
+//
+// To speed up `find_key()`, we keep a compact array of fixed-width "key heads" in
+// the free space between the end of `pair_offsets` and `frontmost`, whenever it
+// fits:
+//
+// ...[offN-1][pad][KEY_HEADS_MAGIC][num_pairs][frontmost][prefix_size][pad x3][head0][head1]...[headN-1]....[frontmost entry]...
+//
+// All keys in a node share their first `prefix_size` bytes.  The head of a key is
+// made up of the four bytes that follow this common prefix, in big-endian order and
+// padded with zeros.  Hence if one key is less than another, its head is at most the
+// other's head, and we can narrow down most searches to one or two keys by searching
+// the heads, without looking at the entries themselves.
+//
+// The heads are only a hint.  They don't take up space that the node could use
+// otherwise, and nodes written before we started keeping heads (or nodes where they
+// don't fit) simply don't have them.  Whatever `find_key()` gets out of the heads
+// is double-checked against the neighbouring keys, so stale or garbage heads can
+// only make it slower.  Every function that changes the set of keys in the node
+// rebuilds the heads before returning.
+
+const uint32_t KEY_HEADS_MAGIC = 0x6b686473;  // "khds"
+
+// It's not worth keeping heads for nodes with fewer keys than this.
+const int KEY_HEADS_MIN_PAIRS = 8;
+
+ATTR_PACKED(struct key_heads_t {
+    uint32_t magic;
+    // Copies of the node's fields at the time the heads were built.
+    uint16_t num_pairs;
+    uint16_t frontmost;
+    uint8_t prefix_size;
+    uint8_t padding[3];
+    uint32_t heads[];
+});
+
+int key_heads_offset(const leaf_node_t *node) {
+    return ceil_aligned(offsetof(leaf_node_t, pair_offsets)
+                        + node->num_pairs * sizeof(uint16_t),
+                        sizeof(uint32_t));
+}
+
+uint32_t key_head(const btree_key_t *key, int prefix_size) {
+    uint32_t head = 0;
+    for (int i = prefix_size; i < prefix_size + 4; ++i) {
+        head = (head << 8) | (i < key->size ? key->contents[i] : 0);
+    }
+    return head;
+}
+
+const key_heads_t *get_key_heads(const leaf_node_t *node) {
+    const int offset = key_heads_offset(node);
+    if (node->num_pairs < KEY_HEADS_MIN_PAIRS
+        || offset + offsetof(key_heads_t, heads) + node->num_pairs * sizeof(uint32_t)
+           > node->frontmost) {
+        return nullptr;
+    }
+    const key_heads_t *key_heads = reinterpret_cast<const key_heads_t *>(
+        reinterpret_cast<const char *>(node) + offset);
+    if (key_heads->magic != KEY_HEADS_MAGIC
+        || key_heads->num_pairs != node->num_pairs
+        || key_heads->frontmost != node->frontmost
+        || key_heads->prefix_size > MAX_KEY_SIZE) {
+        return nullptr;
+    }
+    return key_heads;
+}
+
+// Rebuilds the key heads after the keys in `node` have changed, or clears them if
+// they don't fit.
+void update_key_heads(leaf_node_t *node) {
+    const int offset = key_heads_offset(node);
+    key_heads_t *key_heads = reinterpret_cast<key_heads_t *>(
+        reinterpret_cast<char *>(node) + offset);
+    if (node->num_pairs < KEY_HEADS_MIN_PAIRS
+        || offset + offsetof(key_heads_t, heads) + node->num_pairs * sizeof(uint32_t)
+           > node->frontmost) {
+        if (offset + sizeof(uint32_t) <= node->frontmost) {
+            key_heads->magic = 0;
+        }
+        return;
+    }
+
+    // The keys are sorted, so the first and the last key have the shortest common
+    // prefix of any pair of keys.
+    const btree_key_t *first = entry_key(get_entry(node, node->pair_offsets[0]));
+    const btree_key_t *last
+        = entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1]));
+    int prefix_size = 0;
+    while (prefix_size < first->size && prefix_size < last->size
+           && first->contents[prefix_size] == last->contents[prefix_size]) {
+        ++prefix_size;
+    }
+
+    key_heads->magic = KEY_HEADS_MAGIC;
+    key_heads->num_pairs = node->num_pairs;
+    key_heads->frontmost = node->frontmost;
+    key_heads->prefix_size = prefix_size;
+    memset(key_heads->padding, 0, sizeof(key_heads->padding));
+    for (int i = 0; i < node->num_pairs; ++i) {
+        key_heads->heads[i]
+            = key_head(entry_key(get_entry(node, node->pair_offsets[i])), prefix_size);
+    }
+}
+
+// Returns the index of the first head that's greater than or equal to `head` (or just
+// greater than `head`, if `upper` is true).  Branch-free, so that the CPU doesn't
+// mispredict half of the steps.
+template <bool upper>
+int key_heads_bound(const uint32_t *heads, int count, uint32_t head) {
+    if (count == 0) {
+        return 0;
+    }
+    const uint32_t *base = heads;
+    int n = count;
+    while (n > 1) {
+        const int half = n / 2;
+        base = (upper ? base[half - 1] <= head : base[half - 1] < head)
+            ? base + half : base;
+        n -= half;
+    }
+    return (base - heads) + ((upper ? *base <= head : *base < head) ? 1 : 0);
+}
+
 struct entry_iter_t {
     int offset;
 
@@ -565,6 +690,16 @@ bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node) {
     return mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS) < free_space(sizer) / 2 - leaf_epsilon(sizer);
 }
 
+bool is_change_safe(value_sizer_t *sizer, const leaf_node_t *node) {
+    // `is_full()` adds at most `leaf_epsilon` to the mandatory cost for the new
+    // pair. A removal takes away the removed pair, and the deletion entry that
+    // replaces it can push another deletion entry out of the mandatory ones, so the
+    // cost drops by at most twice `leaf_epsilon`.
+    int cost = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS);
+    return cost + leaf_epsilon(sizer) <= free_space(sizer)
+        && cost >= free_space(sizer) / 2 + leaf_epsilon(sizer);
+}
+
 
 // Compares indices by looking at values in another array.
 class indirect_index_comparator_t {
@@ -956,6 +1091,9 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
         tow->num_pairs = j;
     }
 
+    update_key_heads(fro);
+    update_key_heads(tow);
+
     validate(sizer, fro);
     validate(sizer, tow);
 }
@@ -1177,13 +1315,10 @@ bool is_mergable(value_sizer_t *sizer, const leaf_node_t *node, const leaf_node_
     return is_underfull(sizer, node) && is_underfull(sizer, sibling);
 }
 
-// Sets *index_out to the index for the live entry or deletion entry
-// for the key, or to the index the key would have if it were
-// inserted.  Returns true if the key at said index is actually equal.
-bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
-    int beg = 0;
-    int end = node->num_pairs;
-
+// Sets *index_out to the index of the first key in [beg, end) that isn't less than
+// `key`, or to `end`.  Returns true if the key at said index is actually equal.
+bool find_key_in_range(const leaf_node_t *node, const btree_key_t *key,
+                       int beg, int end, int *index_out) {
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
@@ -1215,6 +1350,73 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     return false;
 }
 
+// Uses the key heads to find the index that `find_key()` would return.  Returns false
+// if the heads aren't usable, or turn out to be wrong.
+bool find_key_using_heads(const leaf_node_t *node, const btree_key_t *key,
+                          int *index_out, bool *found_out) {
+    const key_heads_t *key_heads = get_key_heads(node);
+    if (key_heads == nullptr) {
+        return false;
+    }
+    const int num_pairs = node->num_pairs;
+    const int prefix_size = key_heads->prefix_size;
+
+    // Keys that don't share the common prefix go before or after all of the keys.
+    const btree_key_t *first = entry_key(get_entry(node, node->pair_offsets[0]));
+    if (first->size < prefix_size) {
+        return false;
+    }
+    const int prefix_cmp = memcmp(key->contents, first->contents,
+                                  std::min<int>(key->size, prefix_size));
+    int beg, end;
+    if (prefix_cmp < 0 || (prefix_cmp == 0 && key->size < prefix_size)) {
+        beg = end = 0;
+    } else if (prefix_cmp > 0) {
+        beg = end = num_pairs;
+    } else {
+        // `key_heads_t` is packed, but `key_heads_offset()` keeps the heads aligned,
+        // so we can read them through an ordinary pointer.
+        static_assert(offsetof(key_heads_t, heads) % sizeof(uint32_t) == 0,
+                      "the key heads must stay aligned");
+        const uint32_t *heads = reinterpret_cast<const uint32_t *>(
+            reinterpret_cast<const char *>(key_heads) + offsetof(key_heads_t, heads));
+        const uint32_t head = key_head(key, prefix_size);
+        beg = key_heads_bound<false>(heads, num_pairs, head);
+        end = key_heads_bound<true>(heads, num_pairs, head);
+    }
+
+    int index;
+    find_key_in_range(node, key, beg, end, &index);
+
+    // Double-check that the key belongs at `index`.
+    if (index > 0
+        && btree_key_cmp(entry_key(get_entry(node, node->pair_offsets[index - 1])),
+                         key) >= 0) {
+        return false;
+    }
+    int cmp = -1;
+    if (index < num_pairs) {
+        cmp = btree_key_cmp(key, entry_key(get_entry(node, node->pair_offsets[index])));
+        if (cmp > 0) {
+            return false;
+        }
+    }
+    *index_out = index;
+    *found_out = cmp == 0;
+    return true;
+}
+
+// Sets *index_out to the index for the live entry or deletion entry
+// for the key, or to the index the key would have if it were
+// inserted.  Returns true if the key at said index is actually equal.
+bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
+    bool found;
+    if (find_key_using_heads(node, key, index_out, &found)) {
+        return found;
+    }
+    return find_key_in_range(node, key, 0, node->num_pairs, index_out);
+}
+
 bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *key, void *value_out) {
     int index;
     if (find_key(node, key, &index)) {
@@ -1229,6 +1431,58 @@ bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *ke
     return false;
 }
 
+static const int KEY_FILTER_BITS_PER_KEY = 10;
+static const int KEY_FILTER_NUM_HASHES = 7;
+
+// The probes are `h1 + i * h2` for the two halves of a 64 bit hash of the key.
+static uint64_t key_filter_hash(const btree_key_t *key) {
+    // FNV-1a, followed by the finalizer of MurmurHash3 so that both halves of the
+    // hash depend on all of the key.
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < key->size; ++i) {
+        h = (h ^ key->contents[i]) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+std::vector<uint64_t> make_key_filter(const leaf_node_t *node) {
+    int num_keys = 0;
+    for (auto it = begin(*node); it != end(*node); ++it) {
+        ++num_keys;
+    }
+    const size_t num_bits =
+        ceil_aligned(std::max(num_keys, 1) * KEY_FILTER_BITS_PER_KEY, 64);
+    std::vector<uint64_t> filter(num_bits / 64, 0);
+    for (auto it = begin(*node); it != end(*node); ++it) {
+        const uint64_t h = key_filter_hash((*it).first);
+        const uint32_t h1 = h, h2 = h >> 32;
+        for (uint32_t i = 0; i < KEY_FILTER_NUM_HASHES; ++i) {
+            const size_t bit = (h1 + i * h2) % num_bits;
+            filter[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+    return filter;
+}
+
+bool key_filter_may_contain(const std::vector<uint64_t> &filter,
+                            const btree_key_t *key) {
+    const size_t num_bits = filter.size() * 64;
+    const uint64_t h = key_filter_hash(key);
+    const uint32_t h1 = h, h2 = h >> 32;
+    for (uint32_t i = 0; i < KEY_FILTER_NUM_HASHES; ++i) {
+        const size_t bit = (h1 + i * h2) % num_bits;
+        if ((filter[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /* `insert()` and `remove()` call this to insert a new entry into the leaf node.
 
 First it removes any existing entry for `key`; then it makes room in the leaf
@@ -1525,6 +1779,8 @@ void insert(
 
     node->live_size += sizeof(uint16_t) + key->full_size() + sizer->size(value);
 
+    update_key_heads(node);
+
     validate(sizer, node);
 }
 
@@ -1553,6 +1809,8 @@ void remove(
         memcpy(location_to_write_data, key, key->full_size());
     }
 
+    update_key_heads(node);
+
     validate(sizer, node);
 }
 
@@ -1573,6 +1831,7 @@ void erase_presence(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *
 
         memmove(node->pair_offsets + index, node->pair_offsets + index + 1, (node->num_pairs - (index + 1)) * sizeof(uint16_t));
         node->num_pairs -= 1;
+        update_key_heads(node);
     }
 
     validate(sizer, node);
@@ -1670,6 +1929,8 @@ void erase_deletions(
 
     /* Finally, update `node->tstamp_cutpoint` */
     node->tstamp_cutpoint = new_tstamp_cutpoint;
+
+    update_key_heads(node);
 }
 
 /* Calls `cb` on every entry in the node, whether a real entry or a deletion. The calls
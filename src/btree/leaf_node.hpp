@@ -128,6 +128,10 @@ bool is_full(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *k
 
 bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node);
 
+// True if inserting, replacing or removing any single key can neither make the node
+// full nor underfull, so that a write to it won't have to touch its parent.
+bool is_change_safe(value_sizer_t *sizer, const leaf_node_t *node);
+
 void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
            btree_key_t *median_out);
 
@@ -145,6 +149,12 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out);
 
 bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *key, void *value_out);
 
+/* A Bloom filter of the live keys in the node, which `lookup()` could only find if
+`key_filter_may_contain()` returns true.  It takes about 10 bits per key, for a false
+positive rate of about 1%. */
+std::vector<uint64_t> make_key_filter(const leaf_node_t *node);
+bool key_filter_may_contain(const std::vector<uint64_t> &filter, const btree_key_t *key);
+
 void insert(
         value_sizer_t *sizer,
         leaf_node_t *node,
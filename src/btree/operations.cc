@@ -357,6 +357,16 @@ void check_and_handle_underfull(value_sizer_t *sizer,
     }
 }
 
+// Releases `kv_loc->superblock`, or passes it back if the caller asked for that.
+static void release_superblock_for_write(keyvalue_location_t *kv_loc) {
+    if (kv_loc->pass_back_superblock != nullptr) {
+        kv_loc->pass_back_superblock->pulse(kv_loc->superblock);
+    } else {
+        kv_loc->superblock->release();
+    }
+    kv_loc->superblock = nullptr;
+}
+
 /* Passing in a pass_back_superblock parameter will cause this function to
  * return the superblock after it's no longer needed (rather than releasing
  * it). Notice the superblock is not guaranteed to be returned until the
@@ -415,14 +425,19 @@ void find_keyvalue_location_for_write(
         // Release the superblock, if we've gone past the root (and haven't
         // already released it). If we're still at the root or at one of
         // its direct children, we might still want to replace the root, so
-        // we can't release the superblock yet.
-        if (!last_buf.empty() && keyvalue_location_out->superblock) {
-            if (pass_back_superblock != nullptr) {
-                pass_back_superblock->pulse(superblock);
-                keyvalue_location_out->superblock = nullptr;
-            } else {
-                keyvalue_location_out->superblock->release();
-                keyvalue_location_out->superblock = nullptr;
+        // we can't release the superblock yet -- unless the root has room for
+        // another key and more than two children, in which case nothing that
+        // happens below it can split it or make it go away.
+        if (keyvalue_location_out->superblock != nullptr) {
+            bool root_is_safe = false;
+            if (last_buf.empty()) {
+                buf_read_t read(&buf);
+                auto node = static_cast<const internal_node_t *>(read.get_data_read());
+                root_is_safe = !internal_node::is_full(node)
+                    && !internal_node::is_doubleton(node);
+            }
+            if (!last_buf.empty() || root_is_safe) {
+                release_superblock_for_write(keyvalue_location_out);
             }
         }
 
@@ -467,6 +482,17 @@ void find_keyvalue_location_for_write(
             keyvalue_location_out->there_originally_was_value = true;
             keyvalue_location_out->value = std::move(tmp);
         }
+
+        // If no change to a single key can make the leaf split or merge, we won't
+        // need its parent (or the superblock, if the parent is the root), so we let
+        // other writes into that part of the tree now instead of after the change
+        // has been applied. Otherwise we keep holding them, as before.
+        if (!last_buf.empty() && leaf::is_change_safe(sizer, node)) {
+            last_buf.reset_buf_lock();
+            if (keyvalue_location_out->superblock != nullptr) {
+                release_superblock_for_write(keyvalue_location_out);
+            }
+        }
     }
 
     keyvalue_location_out->last_buf.swap(last_buf);
@@ -528,6 +554,14 @@ void find_keyvalue_location_for_read(
             buf = std::move(tmp);
         }
 
+        // Only leaf nodes get summaries, so the child is a leaf if it has one, and
+        // we might not have to load it at all.
+        const std::vector<uint64_t> *filter = buf.get_block_summary();
+        if (filter != nullptr && !leaf::key_filter_may_contain(*filter, key)) {
+            stats->pm_total_keys_filtered += 1;
+            return;
+        }
+
 #ifndef NDEBUG
         {
             buf_read_t read(&buf);
@@ -544,6 +578,11 @@ void find_keyvalue_location_for_read(
         const leaf_node_t *leaf
             = static_cast<const leaf_node_t *>(read.get_data_read());
         value_found = leaf::lookup(sizer, leaf, key, value.get());
+        // Lookups for keys that don't exist tend to repeat, so after a miss we keep
+        // a filter of the leaf's keys that lets the next miss skip loading it.
+        if (!value_found && buf.get_block_summary() == nullptr) {
+            buf.set_block_summary(leaf::make_key_filter(leaf));
+        }
     }
     if (value_found) {
         keyvalue_location_out->buf = std::move(buf);
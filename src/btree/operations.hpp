@@ -67,7 +67,8 @@ public:
               &pm_keys_read, "keys_read",
               &pm_total_keys_read, "total_keys_read",
               &pm_keys_set, "keys_set",
-              &pm_total_keys_set, "total_keys_set") {
+              &pm_total_keys_set, "total_keys_set",
+              &pm_total_keys_filtered, "total_keys_filtered") {
         if (parent != nullptr) {
             rename(parent, identifier);
         }
@@ -93,7 +94,9 @@ public:
         pm_keys_set;
     perfmon_counter_t
         pm_total_keys_read,
-        pm_total_keys_set;
+        pm_total_keys_set,
+        // Lookups that a leaf's key filter answered without loading the leaf.
+        pm_total_keys_filtered;
     perfmon_multi_membership_t pm_keys_membership;
 };
 
@@ -124,7 +124,8 @@ cache_t::cache_t(serializer_t *serializer,
           page_cache_.soft_durability_interval_flush(
               ticks_t{get_ticks().nanos + soft_durability_flusher_.interval_ms() * MILLION / 16});
       }),
-      which_cpu_shard_(which_cpu_shard) {
+      which_cpu_shard_(which_cpu_shard),
+      group_durability_flush_pending_(false) {
 
   soft_durability_flusher_.clamp_next_ring(
       clamp_ring_length(which_cpu_shard, DEFAULT_FLUSH_INTERVAL));
@@ -134,6 +135,24 @@ cache_t::~cache_t() {
     guarantee(snapshot_nodes_by_block_id_.empty());
 }
 
+void cache_t::schedule_group_durability_flush() {
+    if (group_durability_flush_pending_) {
+        return;
+    }
+    group_durability_flush_pending_ = true;
+    auto_drainer_t::lock_t lock(&drainer_);
+    coro_t::spawn_sometime([this, lock]() {
+        try {
+            nap(GROUP_DURABILITY_FLUSH_DELAY_MS, lock.get_drain_signal());
+        } catch (const interrupted_exc_t &) {
+            // `page_cache_t`'s destructor flushes whatever is left.
+            return;
+        }
+        group_durability_flush_pending_ = false;
+        page_cache_.begin_flush_pending_txns(true, ticks_t{0});
+    });
+}
+
 void cache_t::configure_flush_interval(flush_interval_t interval) {
     rassert(interval.millis > 0);
     soft_durability_flusher_.change_interval(interval.millis);
@@ -141,6 +160,19 @@ void cache_t::configure_flush_interval(flush_interval_t interval) {
         clamp_ring_length(which_cpu_shard_, interval.millis));
 }
 
+void cache_t::configure_eviction_policy(eviction_policy_t policy) {
+    page_cache_.evicter().set_eviction_policy(policy);
+}
+
+std::vector<block_id_t> cache_t::hot_block_ids(size_t max_count) {
+    return page_cache_.hot_block_ids(max_count);
+}
+
+void cache_t::warm_up(const std::vector<block_id_t> &block_ids, uint64_t max_bytes,
+                      signal_t *interruptor) {
+    page_cache_.warm_up(block_ids, max_bytes, interruptor);
+}
+
 cache_account_t cache_t::create_cache_account(int priority) {
     return page_cache_.create_cache_account(priority);
 }
@@ -275,6 +307,10 @@ txn_t::~txn_t() {
 }
 
 void txn_t::commit() {
+    commit([]() { });
+}
+
+void txn_t::commit(const std::function<void()> &flush_started) {
     cache_->assert_thread();
 
     guarantee(!is_committed_);
@@ -286,12 +322,17 @@ void txn_t::commit() {
             std::move(page_txn_),
             durability_,
             nullptr);
+        flush_started();
     } else {
         page_txn_complete_cb_t cb;
         cache_->page_cache_.flush_and_destroy_txn(
             std::move(page_txn_),
             durability_,
             &cb);
+        if (durability_ == write_durability_t::GROUP) {
+            cache_->schedule_group_durability_flush();
+        }
+        flush_started();
         cb.cond.wait_lazily_unordered();
     }
 }
@@ -727,6 +768,26 @@ void buf_lock_t::snapshot_subdag() {
     current_page_acq_.reset();
 }
 
+const std::vector<uint64_t> *buf_lock_t::get_block_summary() {
+    guarantee(!empty());
+    if (is_snapshotted()) {
+        return nullptr;
+    }
+    current_page_acq_->read_acq_signal()->wait();
+    guarantee(!empty());
+    return cache()->page_cache_.get_block_summary(current_page_acq_.get());
+}
+
+void buf_lock_t::set_block_summary(std::vector<uint64_t> &&summary) {
+    guarantee(!empty());
+    if (is_snapshotted()) {
+        return;
+    }
+    current_page_acq_->read_acq_signal()->wait();
+    guarantee(!empty());
+    cache()->page_cache_.set_block_summary(current_page_acq_.get(), std::move(summary));
+}
+
 current_page_acq_t *buf_lock_t::current_page_acq() const {
     ASSERT_NO_CORO_WAITING;
     guarantee(!empty());
@@ -750,6 +811,22 @@ void buf_lock_t::detach_child(block_id_t child_id) {
             child_id);
 }
 
+void buf_lock_t::prefetch_child(block_id_t child_id) {
+    guarantee(!empty());
+    page_cache_t *page_cache = &cache()->page_cache_;
+    if (txn_->account() == page_cache->default_reads_account()) {
+        page_cache->prefetch_block(child_id);
+    }
+}
+
+void buf_lock_t::prefetch_children(const std::vector<block_id_t> &child_ids) {
+    guarantee(!empty());
+    page_cache_t *page_cache = &cache()->page_cache_;
+    if (txn_->account() == page_cache->default_reads_account()) {
+        page_cache->prefetch_blocks(child_ids);
+    }
+}
+
 repli_timestamp_t buf_lock_t::get_recency() const {
     guarantee(!empty());
     current_page_acq_t *cpa = current_page_acq();
@@ -816,8 +893,8 @@ page_t *buf_lock_t::get_held_page_for_write() {
     return current_page_acq_->current_page_for_write(txn()->account());
 }
 
-buf_read_t::buf_read_t(buf_lock_t *lock)
-    : lock_(lock) {
+buf_read_t::buf_read_t(buf_lock_t *lock, page_access_hint_t hint)
+    : lock_(lock), hint_(hint) {
     guarantee(!lock_->empty());
     lock_->access_ref_count_++;
 }
@@ -832,6 +909,7 @@ const void *buf_read_t::get_data_read(uint16_t *block_size_out) {
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
                        lock_->txn()->account());
+        page->note_reference(hint_);
     }
     page_acq_.buf_ready_signal()->wait();
     *block_size_out = page_acq_.get_buf_size().value();
@@ -854,6 +932,7 @@ void *buf_write_t::get_data_write(uint16_t block_size) {
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
                        lock_->txn()->account());
+        page->note_reference(page_access_hint_t::normal);
     }
     page_acq_.buf_ready_signal()->wait();
     return page_acq_.get_buf_write(block_size_t::make_from_cache(block_size));
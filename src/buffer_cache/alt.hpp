@@ -2,6 +2,7 @@
 #ifndef BUFFER_CACHE_ALT_HPP_
 #define BUFFER_CACHE_ALT_HPP_
 
+#include <functional>
 #include <map>
 #include <vector>
 #include <utility>
@@ -63,8 +64,18 @@ public:
     cache_account_t create_cache_account(int priority);
 
     void configure_flush_interval(flush_interval_t interval);
+    void configure_eviction_policy(eviction_policy_t policy);
+
+    // See `page_cache_t::hot_block_ids()` and `page_cache_t::warm_up()`.
+    std::vector<block_id_t> hot_block_ids(size_t max_count);
+    void warm_up(const std::vector<block_id_t> &block_ids, uint64_t max_bytes,
+                 signal_t *interruptor);
 
 private:
+    // Starts a flush `GROUP_DURABILITY_FLUSH_DELAY_MS` from now, unless one is
+    // already coming.
+    void schedule_group_durability_flush();
+
     friend class txn_t;
     friend class buf_read_t;
     friend class buf_write_t;
@@ -89,6 +100,9 @@ private:
     repeating_timer_t soft_durability_flusher_;
     which_cpu_shard_t which_cpu_shard_;
 
+    bool group_durability_flush_pending_;
+    auto_drainer_t drainer_;
+
     DISABLE_COPYING(cache_t);
 };
 
@@ -108,6 +122,9 @@ public:
     // There is no roll-back / abort! Destructing an uncommitted
     // write-transaction will terminate the server.
     void commit();
+    // Like `commit()`, but calls `flush_started` once the transaction has been handed
+    // to the page cache, before waiting for a hard durability flush to finish.
+    void commit(const std::function<void()> &flush_started);
 
     cache_t *cache() { return cache_; }
     alt::page_txn_t *page_txn() { return page_txn_.get(); }
@@ -204,11 +221,24 @@ public:
 
     void detach_child(block_id_t child_id);
 
+    // Hints that the child will probably be acquired soon, so that the cache can
+    // start loading it.  This does nothing if the txn uses its own cache account,
+    // since the prefetch could outlive that account (and shouldn't take priority over
+    // it, either).
+    void prefetch_child(block_id_t child_id);
+    // The same for several children, see `page_cache_t::prefetch_blocks()`.
+    void prefetch_children(const std::vector<block_id_t> &child_ids);
+
     block_id_t block_id() const {
         guarantee(txn_ != nullptr);
         return current_page_acq()->block_id();
     }
 
+    // See `page_cache_t::get_block_summary()`.  These wait for read access, and
+    // they treat snapshotted locks as if the block had no summary.
+    const std::vector<uint64_t> *get_block_summary();
+    void set_block_summary(std::vector<uint64_t> &&summary);
+
     // It is illegal to call this on a buf lock that has been mark_deleted, or that
     // is a lock on an aux block.  This never returns repli_timestamp_t::invalid.
     repli_timestamp_t get_recency() const;
@@ -327,7 +357,8 @@ private:
 
 class buf_read_t {
 public:
-    explicit buf_read_t(buf_lock_t *lock);
+    explicit buf_read_t(buf_lock_t *lock,
+                        page_access_hint_t hint = page_access_hint_t::normal);
     ~buf_read_t();
 
     const void *get_data_read(uint16_t *block_size_out);
@@ -340,6 +371,7 @@ public:
 
 private:
     buf_lock_t *lock_;
+    const page_access_hint_t hint_;
     alt::page_acq_t page_acq_;
 
     DISABLE_COPYING(buf_read_t);
@@ -2,6 +2,7 @@
 #include "buffer_cache/blob.hpp"
 
 #include <stdint.h>
+#include <string.h>
 
 #include <algorithm>
 #include <limits>
@@ -57,6 +58,10 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
                                 touches_end_t touches_end,
                                 buffer_group_t *buffer_group_out,
                                 blob_acq_t *acq_group_out);
+int64_t overwrite_tree_from_block_ids(buf_parent_t parent, int levels,
+                                      int64_t offset, int64_t size,
+                                      temporary_acq_tree_node_t *tree,
+                                      const char **data);
 
 
 int small_size(const char *ref, int maxreflen) {
@@ -488,6 +493,55 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
     delete[] tree;
 }
 
+// Copies the bytes at `*data` over the [offset, offset + size) region of the tree,
+// skipping the leaves that already hold them, and advances `*data` past the region.
+// Like expose_tree_from_block_ids, it consumes `tree`.
+int64_t overwrite_tree_from_block_ids(buf_parent_t parent, int levels,
+                                      int64_t offset, int64_t size,
+                                      temporary_acq_tree_node_t *tree,
+                                      const char **data) {
+    rassert(size > 0);
+
+    int lo, hi;
+    blob::compute_acquisition_offsets(parent.cache()->max_block_size(), levels,
+                                      offset, size, &lo, &hi);
+
+    int64_t blocks_written = 0;
+    for (int i = 0; i < hi - lo; ++i) {
+        int64_t suboffset, subsize;
+        blob::shrink(parent.cache()->max_block_size(), levels, offset, size,
+                     lo + i, &suboffset, &subsize);
+        if (levels > 1) {
+            blocks_written += overwrite_tree_from_block_ids(parent, levels - 1,
+                                                            suboffset, subsize,
+                                                            tree[i].child, data);
+        } else {
+            scoped_ptr_t<buf_lock_t> buf(tree[i].buf);
+            bool changed;
+            {
+                buf_read_t buf_read(buf.get());
+                uint16_t block_size;
+                const char *old_data
+                    = blob::leaf_node_data(buf_read.get_data_read(&block_size));
+                changed = memcmp(old_data + suboffset, *data, subsize) != 0;
+            }
+            if (changed) {
+                buf_write_t buf_write(buf.get());
+                // The region ends where the blob ends, see expose_tree_from_block_ids.
+                char *new_data = blob::leaf_node_data(
+                    buf_write.get_data_write(suboffset + subsize
+                                             + blob::LEAF_NODE_DATA_OFFSET));
+                memcpy(new_data + suboffset, *data, subsize);
+                ++blocks_written;
+            }
+            *data += subsize;
+        }
+    }
+
+    delete[] tree;
+    return blocks_written;
+}
+
 }  // namespace blob
 
 void blob_t::append_region(buf_parent_t parent, int64_t size) {
@@ -562,6 +616,18 @@ void blob_t::write_from_string(const std::string &val,
     buffer_group_copy_data(&dest, const_view(&src));
 }
 
+int64_t blob_t::overwrite_changed_blocks(const char *data, buf_parent_t parent) {
+    guarantee(!blob::is_small(ref_, maxreflen_));
+    const int64_t size = valuesize();
+    const int levels = blob::ref_info(parent.cache()->max_block_size(),
+                                      ref_, maxreflen_).levels;
+
+    temporary_acq_tree_node_t *tree
+        = blob::make_tree_from_block_ids(parent, access_t::write, levels, 0, size,
+                                         blob::block_ids(ref_, maxreflen_));
+    return blob::overwrite_tree_from_block_ids(parent, levels, 0, size, tree, &data);
+}
+
 namespace blob {
 
 struct traverse_helper_t {
@@ -202,6 +202,12 @@ public:
     void write_from_string(const std::string &val, buf_parent_t root,
                            int64_t offset);
 
+    // Writes the valuesize() bytes at `data` over the whole blob, which must not be
+    // stored inline in the ref.  Unlike write_from_string, it compares every leaf
+    // block with the new contents first, and only writes to the ones that change,
+    // so the others don't get dirtied.  Returns how many leaf blocks it wrote to.
+    int64_t overwrite_changed_blocks(const char *data, buf_parent_t root);
+
 private:
     bool traverse_to_dimensions(buf_parent_t parent, int levels,
                                 int64_t smaller_size, int64_t bigger_size,
@@ -17,18 +17,27 @@ alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     evicter(_evicter),
     new_size(0),
     old_size(evicter->memory_limit()),
+    new_compressed_size(0),
     unevictable_size(evicter->unevictable_size()),
     evictable_disk_backed_size(evicter->evictable_disk_backed_size()),
     evictable_unbacked_size(evicter->evictable_unbacked_size()),
     bytes_loaded(evicter->get_bytes_loaded()),
-    access_count(evicter->access_count()) { }
+    access_count(evicter->access_count()),
+    misses(evicter->get_misses()),
+    ghost_list_capacity(evicter->ghost_list_capacity()),
+    marginal_gain(0) { }
 
 alt_cache_balancer_t::alt_cache_balancer_t(
-        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable) :
+        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable,
+        cache_balancer_mode_t _mode,
+        uint64_t _total_compressed_cache_size) :
     total_cache_size_watchable(_total_cache_size_watchable),
+    mode(_mode),
+    total_compressed_cache_size(_total_compressed_cache_size),
     rebalance_timer(make_scoped<repeating_timer_t>(rebalance_check_interval_ms, this)),
     rebalance_timer_state(rebalance_timer_state_t::normal),
     last_rebalance_time{0},
+    last_accounting_time(get_kiloticks()),
     read_ahead_ok(true),
     bytes_toward_read_ahead_limit(0),
     per_thread_data(get_num_threads()),
@@ -84,6 +93,21 @@ void alt_cache_balancer_t::remove_evicter(alt::evicter_t *evicter) {
     guarantee(res == 1);
 }
 
+double alt_cache_balancer_t::compute_marginal_gain(const cache_data_t &data,
+                                                   double interval_secs) {
+    if (data.misses.misses == 0 || data.ghost_list_capacity == 0 || interval_secs <= 0) {
+        return 0;
+    }
+    // A hit on the ghost list is a miss that wouldn't have happened with
+    // `ghost_list_capacity` more bytes of memory.  We assume it would have cost as
+    // much as the average miss.
+    const double avg_miss_micros =
+        static_cast<double>(data.misses.load_nanos) / data.misses.misses / THOUSAND;
+    const double ghost_list_mb =
+        static_cast<double>(data.ghost_list_capacity) / MEGABYTE;
+    return data.misses.ghost_hits * avg_miss_micros / interval_secs / ghost_list_mb;
+}
+
 void alt_cache_balancer_t::on_ring() {
     assert_thread();
 
@@ -150,6 +174,31 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
 
     last_rebalance_time = now;
 
+    const double accounting_interval_secs =
+        static_cast<double>(now.micros - last_accounting_time.micros) / MILLION;
+    last_accounting_time = now;
+    double total_marginal_gain = 0;
+    for (size_t i = 0; i < num_threads; ++i) {
+        for (cache_data_t &data : cache_data[i]) {
+            data.marginal_gain = compute_marginal_gain(data, accounting_interval_secs);
+            total_marginal_gain += data.marginal_gain;
+        }
+    }
+
+    // How much each cache should grow by if it had all of `total_bytes_loaded` to
+    // itself.  In `access_count` mode this is just what it has loaded.  In
+    // `marginal_gain` mode, the caches where a bigger memory limit would save the most
+    // loading time get more, and caches that load a lot without benefitting from more
+    // memory (range scans, for example) shrink.  If no cache would benefit at all,
+    // it's the same as `access_count` mode.
+    auto bytes_wanted = [&](const cache_data_t &data) -> int64_t {
+        if (mode == cache_balancer_mode_t::marginal_gain && total_marginal_gain > 0) {
+            return static_cast<int64_t>(
+                total_bytes_loaded * (data.marginal_gain / total_marginal_gain));
+        }
+        return std::max<int64_t>(0, data.bytes_loaded);
+    };
+
     // Calculate new cache sizes
     if (total_evicters > 0) {
         uint64_t total_new_sizes = 0;
@@ -165,7 +214,7 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
                     temp /= static_cast<double>(total_cache_size);
                     temp *= static_cast<double>(total_bytes_loaded);
 
-                    int64_t new_size = std::max<int64_t>(0, data->bytes_loaded);
+                    int64_t new_size = bytes_wanted(*data);
                     new_size -= static_cast<int64_t>(temp);
                     new_size += data->old_size;
                     new_size = std::max<int64_t>(new_size, 0);
@@ -244,6 +293,20 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
 
         }
 
+        // The compressed copies are split up the same way as the memory limits.
+        for (size_t i = 0; i < cache_data.size(); ++i) {
+            for (cache_data_t &data : cache_data[i]) {
+                if (total_cache_size > 0) {
+                    data.new_compressed_size = static_cast<uint64_t>(
+                        static_cast<double>(total_compressed_cache_size)
+                        * (static_cast<double>(data.new_size) / total_cache_size));
+                } else {
+                    data.new_compressed_size =
+                        total_compressed_cache_size / total_evicters;
+                }
+            }
+        }
+
         // Send new cache sizes to each thread
         pmap(num_threads,
              std::bind(&alt_cache_balancer_t::apply_rebalance_to_thread,
@@ -299,7 +362,10 @@ void alt_cache_balancer_t::apply_rebalance_to_thread(int index,
             new_size.evicter->update_memory_limit(new_size.new_size,
                                                   new_size.bytes_loaded,
                                                   new_size.access_count,
-                                                  new_read_ahead_ok);
+                                                  new_size.misses,
+                                                  new_size.marginal_gain,
+                                                  new_read_ahead_ok,
+                                                  new_size.new_compressed_size);
         }
     }
 }
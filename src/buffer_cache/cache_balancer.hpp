@@ -10,6 +10,7 @@
 
 #include "threading.hpp"
 #include "arch/timing.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "concurrency/watchable.hpp"
 #include "containers/scoped.hpp"
@@ -18,6 +19,15 @@ namespace alt {
 class evicter_t;
 }
 
+// How `alt_cache_balancer_t` decides which caches should grow.
+enum class cache_balancer_mode_t {
+    // In proportion to how much each cache has loaded recently.
+    access_count,
+    // In proportion to how much reading time extra memory would save each cache, as
+    // estimated from the hits on its ghost list.
+    marginal_gain
+};
+
 // Base class so we can have a dummy implementation for tests
 class cache_balancer_t : public home_thread_mixin_t {
 public:
@@ -26,6 +36,8 @@ public:
 
     // Used to determine the initial size of a cache
     virtual uint64_t base_mem_per_store() const = 0;
+    // The same for the cache's compressed copies of evicted pages.
+    virtual uint64_t base_compressed_mem_per_store() const = 0;
 
     // Tells caches whether to start read ahead initially
     virtual bool read_ahead_ok_at_start() const = 0;
@@ -55,8 +67,10 @@ protected:
 // Dummy balancer that does nothing but provide the initial size of a cache
 class dummy_cache_balancer_t final : public cache_balancer_t {
 public:
-    explicit dummy_cache_balancer_t(uint64_t _base_mem_per_store)
+    explicit dummy_cache_balancer_t(uint64_t _base_mem_per_store,
+                                    uint64_t _base_compressed_mem_per_store = 0)
         : base_mem_per_store_(_base_mem_per_store),
+          base_compressed_mem_per_store_(_base_compressed_mem_per_store),
           notify_activity_boolean_(false) { }
     ~dummy_cache_balancer_t() { }
 
@@ -64,6 +78,10 @@ public:
         return base_mem_per_store_;
     }
 
+    uint64_t base_compressed_mem_per_store() const final {
+        return base_compressed_mem_per_store_;
+    }
+
     bool read_ahead_ok_at_start() const final {
         return false;
     }
@@ -79,6 +97,7 @@ private:
     void remove_evicter(alt::evicter_t *) { }
 
     uint64_t base_mem_per_store_;
+    uint64_t base_compressed_mem_per_store_;
 
     bool notify_activity_boolean_;
 
@@ -89,14 +108,20 @@ class alt_cache_balancer_t final :
     public cache_balancer_t,
     public repeating_timer_callback_t {
 public:
-    explicit alt_cache_balancer_t(
-        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable);
+    alt_cache_balancer_t(
+        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable,
+        cache_balancer_mode_t _mode,
+        uint64_t _total_compressed_cache_size = 0);
     ~alt_cache_balancer_t();
 
     uint64_t base_mem_per_store() const final {
         return 0;
     }
 
+    uint64_t base_compressed_mem_per_store() const final {
+        return 0;
+    }
+
     bool read_ahead_ok_at_start() const final {
         return true;
     }
@@ -141,6 +166,7 @@ private:
 
         uint64_t new_size;
         uint64_t old_size;
+        uint64_t new_compressed_size;
 
         // The three components of actual memory usage by the cache
         uint64_t unevictable_size;
@@ -149,8 +175,16 @@ private:
 
         int64_t bytes_loaded;
         uint64_t access_count;
+
+        cache_miss_counts_t misses;
+        uint64_t ghost_list_capacity;
+        double marginal_gain;
     };
 
+    // Estimates how many microseconds of loading per second another megabyte of
+    // memory would save the cache, over an interval of `interval_secs`.
+    static double compute_marginal_gain(const cache_data_t &data, double interval_secs);
+
     // Helper function to collect stats from each thread so we don't need
     //  atomic variables slowing down normal operations
     void collect_stats_from_thread(int index,
@@ -162,6 +196,11 @@ private:
                                    bool new_read_ahead_ok);
 
     clone_ptr_t<watchable_t<uint64_t> > total_cache_size_watchable;
+    const cache_balancer_mode_t mode;
+    // The memory for compressed copies of evicted pages, on top of the total cache
+    // size.  Each cache gets a share in proportion to its memory limit.  Zero if
+    // there aren't any compressed copies.
+    const uint64_t total_compressed_cache_size;
     scoped_ptr_t<repeating_timer_t> rebalance_timer;
     enum class rebalance_timer_state_t {
         // Normal operating condition: there is a timer, and it'll ping soon.  Can
@@ -178,6 +217,9 @@ private:
     rebalance_timer_state_t rebalance_timer_state;
 
     kiloticks_t last_rebalance_time;
+    // When the caches' miss counts were last accounted for.  Unlike
+    // `last_rebalance_time`, this doesn't get reset when the cache size changes.
+    kiloticks_t last_accounting_time;
     bool read_ahead_ok;
     uint64_t bytes_toward_read_ahead_limit;
 
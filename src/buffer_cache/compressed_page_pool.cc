@@ -0,0 +1,91 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/compressed_page_pool.hpp"
+
+#include <tuple>
+#include <utility>
+
+namespace alt {
+
+compressed_page_pool_t::compressed_page_pool_t()
+    : capacity_(0), size_(0), next_sequence_number_(0) { }
+
+void compressed_page_pool_t::set_capacity(uint64_t capacity) {
+    assert_thread();
+    capacity_ = capacity;
+    trim();
+}
+
+void compressed_page_pool_t::add(block_id_t block_id,
+                                 const counted_t<block_token_t> &token,
+                                 const ser_buffer_t *buf, block_size_t block_size) {
+    assert_thread();
+    remove(block_id);
+    if (capacity_ == 0) {
+        return;
+    }
+    buf_ptr_t compressed
+        = compressor_.compress(block_compression_t::zlib, buf, block_size);
+    if (!compressed.has() || compressed.aligned_block_size() > capacity_) {
+        return;
+    }
+
+    // Don't let removed entries pile up in `entries_`, see `ghost_list_t::add()`.
+    if (entries_.size() >= 2 * index_.size() + 16) {
+        std::deque<order_t> live_entries;
+        for (const order_t &o : entries_) {
+            if (is_live(o)) {
+                live_entries.push_back(o);
+            }
+        }
+        entries_.swap(live_entries);
+    }
+    const uint64_t sequence_number = next_sequence_number_++;
+    size_ += compressed.aligned_block_size();
+    index_.emplace(std::piecewise_construct, std::forward_as_tuple(block_id),
+                   std::forward_as_tuple(token, std::move(compressed), block_size,
+                                         sequence_number));
+    entries_.push_back(order_t{block_id, sequence_number});
+    trim();
+}
+
+buf_ptr_t compressed_page_pool_t::take(block_id_t block_id,
+                                       counted_t<block_token_t> *token_out) {
+    assert_thread();
+    auto it = index_.find(block_id);
+    if (it == index_.end()) {
+        return buf_ptr_t();
+    }
+    buf_ptr_t ret = compressor_.decompress(it->second.compressed, it->second.block_size);
+    *token_out = std::move(it->second.token);
+    rassert(size_ >= it->second.compressed.aligned_block_size());
+    size_ -= it->second.compressed.aligned_block_size();
+    index_.erase(it);
+    return ret;
+}
+
+void compressed_page_pool_t::remove(block_id_t block_id) {
+    assert_thread();
+    auto it = index_.find(block_id);
+    if (it != index_.end()) {
+        rassert(size_ >= it->second.compressed.aligned_block_size());
+        size_ -= it->second.compressed.aligned_block_size();
+        index_.erase(it);
+    }
+}
+
+bool compressed_page_pool_t::is_live(const order_t &order) const {
+    auto it = index_.find(order.block_id);
+    return it != index_.end() && it->second.sequence_number == order.sequence_number;
+}
+
+void compressed_page_pool_t::trim() {
+    while (size_ > capacity_ && !entries_.empty()) {
+        const order_t front = entries_.front();
+        entries_.pop_front();
+        if (is_live(front)) {
+            remove(front.block_id);
+        }
+    }
+}
+
+}  // namespace alt
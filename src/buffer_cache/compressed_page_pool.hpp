@@ -0,0 +1,94 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_COMPRESSED_PAGE_POOL_HPP_
+#define BUFFER_CACHE_COMPRESSED_PAGE_POOL_HPP_
+
+#include <stdint.h>
+
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include "containers/counted.hpp"
+#include "errors.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/compression.hpp"
+#include "serializer/types.hpp"
+#include "threading.hpp"
+
+namespace alt {
+
+/* Keeps compressed copies of the blocks that were evicted most recently, up to a
+total size of `capacity()` bytes, so that loading them again doesn't need to go to
+disk.
+
+A copy comes with the block token it was loaded with.  The block might have been
+written again since, so the copy is only good if that token still refers to the
+block's current version, see `page_t::load_with_block_id()`.  Holding on to the token
+also keeps the serializer from reusing its offset. */
+class compressed_page_pool_t : public home_thread_mixin_debug_only_t {
+public:
+    compressed_page_pool_t();
+
+    // Forgets the oldest copies if the pool has grown beyond the new capacity.  A
+    // capacity of zero turns the pool off.
+    void set_capacity(uint64_t capacity);
+    uint64_t capacity() const { return capacity_; }
+
+    // Keeps a compressed copy of `buf`, which has size `block_size` and was loaded
+    // with `token`, replacing any older copy of the block.  Does nothing if the block
+    // doesn't compress well enough to be worth it.
+    void add(block_id_t block_id, const counted_t<block_token_t> &token,
+             const ser_buffer_t *buf, block_size_t block_size);
+
+    // Returns the decompressed copy of the block and the token it came with, and
+    // removes it from the pool.  Returns an empty `buf_ptr_t` if there is none.
+    buf_ptr_t take(block_id_t block_id, counted_t<block_token_t> *token_out);
+
+    void remove(block_id_t block_id);
+
+    size_t entry_count() const { return index_.size(); }
+    // The memory taken up by the compressed copies.
+    uint64_t size() const { return size_; }
+
+private:
+    struct entry_t {
+        entry_t(const counted_t<block_token_t> &_token, buf_ptr_t &&_compressed,
+                block_size_t _block_size, uint64_t _sequence_number)
+            : token(_token),
+              compressed(std::move(_compressed)),
+              block_size(_block_size),
+              sequence_number(_sequence_number) { }
+
+        counted_t<block_token_t> token;
+        buf_ptr_t compressed;
+        block_size_t block_size;
+        uint64_t sequence_number;
+    };
+
+    // What `entries_` remembers about an entry, to find it in `index_`.
+    struct order_t {
+        block_id_t block_id;
+        uint64_t sequence_number;
+    };
+
+    bool is_live(const order_t &order) const;
+    void trim();
+
+    uint64_t capacity_;
+    // The total aligned size of the compressed copies.
+    uint64_t size_;
+
+    // Oldest first.  This can contain entries that have been removed already, those
+    // aren't in `index_` (under the same sequence number).
+    std::deque<order_t> entries_;
+    std::unordered_map<block_id_t, entry_t> index_;
+    uint64_t next_sequence_number_;
+
+    block_compressor_t compressor_;
+
+    DISABLE_COPYING(compressed_page_pool_t);
+};
+
+}  // namespace alt
+
+#endif  // BUFFER_CACHE_COMPRESSED_PAGE_POOL_HPP_
@@ -1,5 +1,7 @@
 #include "buffer_cache/evicter.hpp"
 
+#include <algorithm>
+
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/page.hpp"
@@ -8,14 +10,30 @@
 
 namespace alt {
 
+// The ghost list covers this fraction of the memory limit, but at least
+// `GHOST_LIST_MIN_CAPACITY` and at most `GHOST_LIST_MAX_CAPACITY` bytes (its entries
+// take up memory too).
+const uint64_t GHOST_LIST_MEMORY_LIMIT_DIVISOR = 4;
+const uint64_t GHOST_LIST_MIN_CAPACITY = 4 * MEGABYTE;
+const uint64_t GHOST_LIST_MAX_CAPACITY = 256 * MEGABYTE;
+
+static uint64_t ghost_list_capacity_for_memory_limit(uint64_t memory_limit) {
+    return std::min(std::max(memory_limit / GHOST_LIST_MEMORY_LIMIT_DIVISOR,
+                             GHOST_LIST_MIN_CAPACITY),
+                    GHOST_LIST_MAX_CAPACITY);
+}
+
 evicter_t::evicter_t()
     : initialized_(false),
       page_cache_(nullptr),
       balancer_(nullptr),
       balancer_notify_activity_boolean_(nullptr),
       throttler_(nullptr),
+      eviction_policy_(eviction_policy_t::lru),
       bytes_loaded_counter_(0),
       access_count_counter_(0),
+      marginal_gain_(0),
+      compressed_hits_(0),
       access_time_counter_(INITIAL_ACCESS_TIME),
       evict_if_necessary_active_(false),
       last_force_flush_time_(ticks_t{0}) { }
@@ -37,6 +55,8 @@ void evicter_t::initialize(page_cache_t *page_cache,
     initialized_ = true;  // Can you really say this class is 'initialized_'?
     page_cache_ = page_cache;
     memory_limit_ = balancer->base_mem_per_store();
+    ghosts_.set_capacity(ghost_list_capacity_for_memory_limit(memory_limit_));
+    compressed_pages_.set_capacity(balancer->base_compressed_mem_per_store());
     page_cache_ = page_cache;
     throttler_ = throttler;
     balancer_ = balancer;
@@ -50,7 +70,10 @@ void evicter_t::initialize(page_cache_t *page_cache,
 void evicter_t::update_memory_limit(uint64_t new_memory_limit,
                                     int64_t bytes_loaded_accounted_for,
                                     uint64_t access_count_accounted_for,
-                                    bool read_ahead_ok) {
+                                    const cache_miss_counts_t &misses_accounted_for,
+                                    double marginal_gain,
+                                    bool read_ahead_ok,
+                                    uint64_t new_compressed_limit) {
     guarantee_initialized();
 
     if (!read_ahead_ok) {
@@ -59,13 +82,24 @@ void evicter_t::update_memory_limit(uint64_t new_memory_limit,
 
     bytes_loaded_counter_ -= bytes_loaded_accounted_for;
     access_count_counter_ -= access_count_accounted_for;
+    misses_counter_.misses -= misses_accounted_for.misses;
+    misses_counter_.ghost_hits -= misses_accounted_for.ghost_hits;
+    misses_counter_.load_nanos -= misses_accounted_for.load_nanos;
+    marginal_gain_ = marginal_gain;
     memory_limit_ = new_memory_limit;
+    ghosts_.set_capacity(ghost_list_capacity_for_memory_limit(memory_limit_));
+    compressed_pages_.set_capacity(new_compressed_limit);
     evict_if_necessary();
 
     throttler_->inform_memory_limit_change(memory_limit_,
                                            page_cache_->max_block_size());
 }
 
+void evicter_t::set_eviction_policy(eviction_policy_t policy) {
+    assert_thread();
+    eviction_policy_ = policy;
+}
+
 void wake_up_balancer(cache_balancer_t *balancer,
                       UNUSED auto_drainer_t::lock_t drainer_lock) {
     on_thread_t th(balancer->home_thread());
@@ -108,6 +142,24 @@ void evicter_t::reloading_page(page_t *page) {
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
 
+void evicter_t::record_miss(block_id_t block_id, ticks_t load_time) {
+    guarantee_initialized();
+    const bool ghost_hit = ghosts_.remove(block_id);
+    for (cache_miss_counts_t *counts : { &misses_counter_, &total_misses_ }) {
+        ++counts->misses;
+        if (ghost_hit) {
+            ++counts->ghost_hits;
+        }
+        counts->load_nanos += load_time.nanos;
+    }
+}
+
+buf_ptr_t evicter_t::take_compressed_copy(block_id_t block_id,
+                                          counted_t<block_token_t> *token_out) {
+    guarantee_initialized();
+    return compressed_pages_.take(block_id, token_out);
+}
+
 bool evicter_t::page_is_in_unevictable_bag(page_t *page) const {
     guarantee_initialized();
     return unevictable_.has_page(page);
@@ -197,11 +249,14 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
     evict_if_necessary_active_ = true;
     page_t *page;
     while (in_memory_size() > memory_limit_
-           && eviction_bag_t::select_oldish(
-                &evictable_disk_backed_, access_time_counter_, &page)) {
+           && select_page_to_evict(&page)) {
         uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
         evictable_disk_backed_.remove(page, mem_usage);
         evicted_.add(page, mem_usage);
+        ghosts_.add(page->block_id(), mem_usage);
+        compressed_pages_.add(page->block_id(), page->block_token(),
+                              page->get_loaded_ser_buffer(),
+                              page->get_page_buf_size());
         page->evict_self(page_cache_);
         page_cache_->consider_evicting_current_page(page->block_id());
     }
@@ -220,6 +275,26 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
     evict_if_necessary_active_ = false;
 }
 
+bool evicter_t::select_page_to_evict(page_t **page_out) {
+    switch (eviction_policy_) {
+    case eviction_policy_t::lru:
+        return eviction_bag_t::select_oldish(
+            &evictable_disk_backed_, access_time_counter_, page_out);
+    case eviction_policy_t::scan_resistant: {
+        // A hot page that hasn't been touched while the whole cache could have been
+        // accessed twice over has fallen out of the working set.
+        const uint64_t resident_pages = unevictable_.page_count()
+            + evictable_disk_backed_.page_count()
+            + evictable_unbacked_.page_count();
+        return eviction_bag_t::select_scan_resistant(
+            &evictable_disk_backed_, access_time_counter_, 2 * resident_pages,
+            page_out);
+    }
+    default:
+        unreachable();
+    }
+}
+
 usage_adjuster_t::usage_adjuster_t(page_cache_t *page_cache, page_t *page)
     : page_cache_(page_cache),
       page_(page),
@@ -5,7 +5,10 @@
 
 #include <functional>
 
+#include "buffer_cache/compressed_page_pool.hpp"
 #include "buffer_cache/eviction_bag.hpp"
+#include "buffer_cache/ghost_list.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
@@ -35,6 +38,21 @@ public:
     void remove_page(page_t *page);
     void reloading_page(page_t *page);
 
+    // Called when a page that wasn't in memory has been loaded, which took
+    // `load_time`.
+    void record_miss(block_id_t block_id, ticks_t load_time);
+
+    // Returns the block's contents from the compressed page pool, if it's still in
+    // there, and the token they were loaded with.  They're only good if the token
+    // refers to the block's current version.  Call `record_compressed_hit()` if they
+    // are.
+    buf_ptr_t take_compressed_copy(block_id_t block_id,
+                                   counted_t<block_token_t> *token_out);
+    void record_compressed_hit() {
+        guarantee_initialized();
+        ++compressed_hits_;
+    }
+
     // Evicter will be unusable until initialize is called
     evicter_t();
     ~evicter_t();
@@ -45,7 +63,14 @@ public:
     void update_memory_limit(uint64_t new_memory_limit,
                              int64_t bytes_loaded_accounted_for,
                              uint64_t access_count_accounted_for,
-                             bool read_ahead_ok);
+                             const cache_miss_counts_t &misses_accounted_for,
+                             double marginal_gain,
+                             bool read_ahead_ok,
+                             uint64_t new_compressed_limit);
+
+    // Defaults to eviction_policy_t::lru.
+    void set_eviction_policy(eviction_policy_t policy);
+    eviction_policy_t eviction_policy() const { return eviction_policy_; }
 
     uint64_t next_access_time() {
         guarantee_initialized();
@@ -56,6 +81,20 @@ public:
         guarantee_initialized();
         return memory_limit_;
     }
+    // The budget for compressed copies of evicted pages, on top of `memory_limit()`.
+    uint64_t compressed_limit() const {
+        guarantee_initialized();
+        return compressed_pages_.capacity();
+    }
+    uint64_t compressed_size() const {
+        guarantee_initialized();
+        return compressed_pages_.size();
+    }
+    // How many loads the compressed page pool has saved us, for the stats.
+    uint64_t compressed_hits() const {
+        guarantee_initialized();
+        return compressed_hits_;
+    }
     uint64_t access_count() const {
         guarantee_initialized();
         return access_count_counter_;
@@ -78,6 +117,27 @@ public:
         return bytes_loaded_counter_;
     }
 
+    // The misses since the balancer last accounted for them.
+    const cache_miss_counts_t &get_misses() const {
+        guarantee_initialized();
+        return misses_counter_;
+    }
+    // The misses ever, for the stats.
+    const cache_miss_counts_t &total_misses() const {
+        guarantee_initialized();
+        return total_misses_;
+    }
+    uint64_t ghost_list_capacity() const {
+        guarantee_initialized();
+        return ghosts_.capacity();
+    }
+    // The balancer's latest estimate of how much a bigger memory limit would help
+    // this cache, see `alt_cache_balancer_t::compute_marginal_gain()`.
+    double marginal_gain() const {
+        guarantee_initialized();
+        return marginal_gain_;
+    }
+
 
     uint64_t in_memory_size() const;
 
@@ -99,6 +159,10 @@ private:
     // Evicts any evictable pages until under the memory limit
     void evict_if_necessary() THROWS_NOTHING;
 
+    // Picks the next page to evict from evictable_disk_backed_, according to the
+    // eviction policy.
+    bool select_page_to_evict(page_t **page_out);
+
     bool initialized_;
     page_cache_t *page_cache_;
     cache_balancer_t *balancer_;
@@ -108,11 +172,25 @@ private:
 
     uint64_t memory_limit_;
 
+    eviction_policy_t eviction_policy_;
+
     // These are updated every time a page is loaded, created, or destroyed, and
     // cleared when cache memory limits are re-evaluated.  This value can go
     // negative, if you keep deleting blocks or suddenly drop a snapshot.
     int64_t bytes_loaded_counter_;
     uint64_t access_count_counter_;
+    cache_miss_counts_t misses_counter_;
+
+    cache_miss_counts_t total_misses_;
+    double marginal_gain_;
+
+    // The pages we evicted most recently.  Its capacity follows the memory limit.
+    ghost_list_t ghosts_;
+
+    // Compressed copies of the clean pages we evicted most recently.  Its capacity
+    // comes from the balancer, separately from the memory limit.
+    compressed_page_pool_t compressed_pages_;
+    uint64_t compressed_hits_;
 
     // This gets incremented every time a page is accessed.
     uint64_t access_time_counter_;
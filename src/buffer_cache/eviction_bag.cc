@@ -59,6 +59,49 @@ bool eviction_bag_t::select_oldish(eviction_bag_t *eb, uint64_t access_time_offs
     return true;
 }
 
+// Lower ranks get evicted first.
+static int eviction_rank(page_t *page, uint64_t age, uint64_t hot_age_limit) {
+    switch (page->reference_class()) {
+    case page_reference_class_t::unreferenced: // fallthru
+    case page_reference_class_t::streaming:
+        return 0;
+    case page_reference_class_t::probation:
+        return 1;
+    case page_reference_class_t::hot:
+        return age > hot_age_limit ? 1 : 2;
+    default:
+        unreachable();
+    }
+}
+
+bool eviction_bag_t::select_scan_resistant(eviction_bag_t *eb,
+                                           uint64_t access_time_offset,
+                                           uint64_t hot_age_limit,
+                                           page_t **page_out) {
+    if (eb->bag_.size() == 0) {
+        return false;
+    }
+    // We take a few more samples than select_oldish does, so that we're likely to
+    // see a streaming page if there are any around.
+    const size_t num_randoms = 8;
+    page_t *best = eb->bag_.access_random(randsize(eb->bag_.size()));
+    uint64_t best_age = access_time_offset - best->access_time();
+    int best_rank = eviction_rank(best, best_age, hot_age_limit);
+    for (size_t i = 1; i < num_randoms; ++i) {
+        page_t *page = eb->bag_.access_random(randsize(eb->bag_.size()));
+        const uint64_t age = access_time_offset - page->access_time();
+        const int rank = eviction_rank(page, age, hot_age_limit);
+        if (rank < best_rank || (rank == best_rank && age > best_age)) {
+            best = page;
+            best_age = age;
+            best_rank = rank;
+        }
+    }
+
+    *page_out = best;
+    return true;
+}
+
 template <class T>
 T access_random2(const backindex_bag_t<T> &b1, const backindex_bag_t<T> &b2,
                  size_t index) {
@@ -30,6 +30,9 @@ public:
 
     uint64_t size() const { return size_; }
 
+    // The number of pages in the bag.
+    size_t page_count() const { return bag_.size(); }
+
     static bool select_oldish(
         eviction_bag_t *eb, uint64_t access_time_offset,
         page_t **page_out);
@@ -38,6 +41,15 @@ public:
         eviction_bag_t *eb1, eviction_bag_t *eb2, uint64_t access_time_offset,
         page_t **page_out);
 
+    // Used by the scan-resistant eviction policy.  Like select_oldish, but pages
+    // that were only used by a streaming access (or not used at all yet) are picked
+    // over pages that were used once, which are picked over pages that were used
+    // again.  Hot pages that haven't been accessed in the last `hot_age_limit`
+    // accesses are considered to be on probation again.
+    static bool select_scan_resistant(
+        eviction_bag_t *eb, uint64_t access_time_offset, uint64_t hot_age_limit,
+        page_t **page_out);
+
 private:
     backindex_bag_t<page_t *> bag_;
     // The size in memory.
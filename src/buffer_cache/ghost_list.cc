@@ -0,0 +1,64 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/ghost_list.hpp"
+
+namespace alt {
+
+ghost_list_t::ghost_list_t()
+    : capacity_(0), size_(0), next_sequence_number_(0) { }
+
+void ghost_list_t::set_capacity(uint64_t capacity) {
+    capacity_ = capacity;
+    trim();
+}
+
+void ghost_list_t::add(block_id_t block_id, uint32_t size) {
+    remove(block_id);
+    // Don't let removed entries pile up in `entries_`.  Dropping them once they make
+    // up half of it keeps this amortized constant time.
+    if (entries_.size() >= 2 * index_.size() + 16) {
+        std::deque<entry_t> live_entries;
+        for (const entry_t &e : entries_) {
+            if (is_live(e)) {
+                live_entries.push_back(e);
+            }
+        }
+        entries_.swap(live_entries);
+    }
+    entry_t entry;
+    entry.block_id = block_id;
+    entry.size = size;
+    entry.sequence_number = next_sequence_number_++;
+    entries_.push_back(entry);
+    index_.insert(std::make_pair(block_id, entry));
+    size_ += size;
+    trim();
+}
+
+bool ghost_list_t::remove(block_id_t block_id) {
+    auto it = index_.find(block_id);
+    if (it == index_.end()) {
+        return false;
+    }
+    rassert(size_ >= it->second.size);
+    size_ -= it->second.size;
+    index_.erase(it);
+    return true;
+}
+
+bool ghost_list_t::is_live(const entry_t &entry) const {
+    auto it = index_.find(entry.block_id);
+    return it != index_.end() && it->second.sequence_number == entry.sequence_number;
+}
+
+void ghost_list_t::trim() {
+    while (size_ > capacity_ && !entries_.empty()) {
+        const entry_t front = entries_.front();
+        entries_.pop_front();
+        if (is_live(front)) {
+            size_ -= front.size;
+            index_.erase(front.block_id);
+        }
+    }
+}
+
+}  // namespace alt
@@ -0,0 +1,60 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_GHOST_LIST_HPP_
+#define BUFFER_CACHE_GHOST_LIST_HPP_
+
+#include <stdint.h>
+
+#include <deque>
+#include <unordered_map>
+
+#include "errors.hpp"
+#include "serializer/types.hpp"
+
+namespace alt {
+
+/* Remembers the block ids of the pages that were evicted most recently, up to a
+total size of `capacity()` bytes.  A miss on one of those blocks would have been a hit
+if the cache had been `capacity()` bytes bigger, so the number of such hits tells the
+cache balancer how much extra memory would help this cache. */
+class ghost_list_t {
+public:
+    ghost_list_t();
+
+    // Forgets the oldest entries if the list has grown beyond the new capacity.
+    void set_capacity(uint64_t capacity);
+    uint64_t capacity() const { return capacity_; }
+
+    void add(block_id_t block_id, uint32_t size);
+
+    // Removes the block from the list.  Returns true if it was in there.
+    bool remove(block_id_t block_id);
+
+    size_t entry_count() const { return index_.size(); }
+    uint64_t size() const { return size_; }
+
+private:
+    struct entry_t {
+        block_id_t block_id;
+        uint32_t size;
+        uint64_t sequence_number;
+    };
+
+    bool is_live(const entry_t &entry) const;
+    void trim();
+
+    uint64_t capacity_;
+    // The total size of the live entries.
+    uint64_t size_;
+
+    // Oldest first.  This can contain entries that have been removed already, those
+    // aren't in `index_` (under the same sequence number).
+    std::deque<entry_t> entries_;
+    std::unordered_map<block_id_t, entry_t> index_;
+    uint64_t next_sequence_number_;
+
+    DISABLE_COPYING(ghost_list_t);
+};
+
+}  // namespace alt
+
+#endif  // BUFFER_CACHE_GHOST_LIST_HPP_
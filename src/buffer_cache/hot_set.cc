@@ -0,0 +1,144 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/hot_set.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <functional>
+#include <vector>
+
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/types.hpp"
+#include "buffer_cache/alt.hpp"
+#include "concurrency/interruptor.hpp"
+#include "logger.hpp"
+#include "paths.hpp"
+#include "utils.hpp"
+
+// The file is this, followed by the block ids as native 64-bit integers, most
+// recently used first.
+static const char HOT_SET_MAGIC[8] = { 'r', 'd', 'b', 'h', 'o', 't', '0', '1' };
+
+static bool read_hot_set_file(const std::string &path,
+                              std::vector<block_id_t> *block_ids_out) {
+    std::string contents;
+    if (!blocking_read_file(path.c_str(), &contents)) {
+        return false;
+    }
+    if (contents.size() < sizeof(HOT_SET_MAGIC)
+        || memcmp(contents.data(), HOT_SET_MAGIC, sizeof(HOT_SET_MAGIC)) != 0
+        || (contents.size() - sizeof(HOT_SET_MAGIC)) % sizeof(block_id_t) != 0) {
+        return false;
+    }
+    block_ids_out->resize(
+        (contents.size() - sizeof(HOT_SET_MAGIC)) / sizeof(block_id_t));
+    memcpy(block_ids_out->data(), contents.data() + sizeof(HOT_SET_MAGIC),
+           block_ids_out->size() * sizeof(block_id_t));
+    return true;
+}
+
+// Writes the file under a temporary name first, so that the old file stays intact if
+// we crash.  Returns an errno value, or 0.
+static int write_hot_set_file(const std::string &path,
+                              const std::vector<block_id_t> &block_ids) {
+    std::string contents(HOT_SET_MAGIC, sizeof(HOT_SET_MAGIC));
+    contents.append(reinterpret_cast<const char *>(block_ids.data()),
+                    block_ids.size() * sizeof(block_id_t));
+    const std::string temp_path = path + ".tmp";
+    scoped_fd_t fd;
+    {
+        int res;
+        do {
+            res = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        } while (res == -1 && get_errno() == EINTR);
+        if (res == -1) {
+            return get_errno();
+        }
+        fd.reset(res);
+    }
+    const char *data = contents.data();
+    size_t size = contents.size();
+    while (size > 0) {
+        ssize_t res = ::write(fd.get(), data, size);
+        if (res == -1) {
+            if (get_errno() == EINTR) {
+                continue;
+            }
+            return get_errno();
+        }
+        data += res;
+        size -= res;
+    }
+    fd.reset();
+    if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+        return get_errno();
+    }
+    return 0;
+}
+
+hot_set_manifest_t::hot_set_manifest_t(cache_t *cache, const std::string &path)
+    : cache_(cache), path_(path), saving_(false) {
+    coro_t::spawn_sometime(
+        std::bind(&hot_set_manifest_t::warm_up, this, drainer_.lock()));
+    timer_.init(new repeating_timer_t(HOT_SET_MANIFEST_INTERVAL_SECS * THOUSAND,
+        [this]() {
+            coro_t::spawn_sometime(
+                std::bind(&hot_set_manifest_t::periodic_save, this, drainer_.lock()));
+        }));
+}
+
+hot_set_manifest_t::~hot_set_manifest_t() {
+    assert_thread();
+    timer_.reset();
+    drainer_.drain();
+    // Saving on a clean shutdown means that a restart starts with what was hot just
+    // before it.
+    save();
+}
+
+void hot_set_manifest_t::warm_up(auto_drainer_t::lock_t keepalive) {
+    if (HOT_SET_WARM_UP_MAX_BYTES == 0) {
+        return;
+    }
+    std::vector<block_id_t> block_ids;
+    bool found = false;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        found = read_hot_set_file(path_, &block_ids);
+    });
+    if (!found || block_ids.empty()) {
+        return;
+    }
+    try {
+        cache_->warm_up(block_ids, HOT_SET_WARM_UP_MAX_BYTES,
+                        keepalive.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.
+    }
+}
+
+void hot_set_manifest_t::periodic_save(UNUSED auto_drainer_t::lock_t keepalive) {
+    save();
+}
+
+void hot_set_manifest_t::save() {
+    assert_thread();
+    if (saving_) {
+        return;
+    }
+    saving_ = true;
+    std::vector<block_id_t> block_ids =
+        cache_->hot_block_ids(HOT_SET_MANIFEST_MAX_BLOCKS);
+    int errsv = 0;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        errsv = write_hot_set_file(path_, block_ids);
+    });
+    if (errsv != 0) {
+        logWRN("Could not write the list of cached blocks to '%s': %s",
+               path_.c_str(), errno_string(errsv).c_str());
+    }
+    saving_ = false;
+}
@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_HOT_SET_HPP_
+#define BUFFER_CACHE_HOT_SET_HPP_
+
+#include <string>
+
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/scoped.hpp"
+#include "threading.hpp"
+
+class cache_t;
+
+/* `hot_set_manifest_t` keeps a file with the ids of the blocks that a cache used most
+recently, so that the cache can load them again after a restart instead of faulting
+them in one random read at a time.  When it's constructed it reads the file and warms
+up the cache in the background, and it rewrites the file every
+`HOT_SET_MANIFEST_INTERVAL_SECS` and when it's destroyed.  A missing or damaged file
+is ignored.  It must be destroyed before the cache. */
+class hot_set_manifest_t : public home_thread_mixin_t {
+public:
+    hot_set_manifest_t(cache_t *cache, const std::string &path);
+    ~hot_set_manifest_t();
+
+private:
+    void warm_up(auto_drainer_t::lock_t keepalive);
+    void periodic_save(auto_drainer_t::lock_t keepalive);
+    // Does nothing if another save is running.
+    void save();
+
+    cache_t *const cache_;
+    const std::string path_;
+    bool saving_;
+
+    auto_drainer_t drainer_;
+    scoped_ptr_t<repeating_timer_t> timer_;
+
+    DISABLE_COPYING(hot_set_manifest_t);
+};
+
+#endif  // BUFFER_CACHE_HOT_SET_HPP_
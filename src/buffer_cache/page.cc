@@ -56,7 +56,8 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache)
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
-      snapshot_refcount_(0) {
+      snapshot_refcount_(0),
+      reference_class_(page_reference_class_t::unreferenced) {
     page_cache->evicter().add_deferred_loaded(this);
 
     coro_t::spawn_now_dangerously(std::bind(&page_t::deferred_load_with_block_id,
@@ -70,7 +71,8 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache,
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
-      snapshot_refcount_(0) {
+      snapshot_refcount_(0),
+      reference_class_(page_reference_class_t::unreferenced) {
     page_cache->evicter().add_not_yet_loaded(this);
 
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_with_block_id,
@@ -86,7 +88,8 @@ page_t::page_t(block_id_t _block_id, buf_ptr_t buf,
       loader_(nullptr),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
-      snapshot_refcount_(0) {
+      snapshot_refcount_(0),
+      reference_class_(page_reference_class_t::unreferenced) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
 }
@@ -100,7 +103,8 @@ page_t::page_t(block_id_t _block_id,
       buf_(std::move(buf)),
       block_token_(_block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
-      snapshot_refcount_(0) {
+      snapshot_refcount_(0),
+      reference_class_(page_reference_class_t::unreferenced) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
 }
@@ -109,7 +113,8 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
-      snapshot_refcount_(0) {
+      snapshot_refcount_(0),
+      reference_class_(copyee->reference_class_) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
                                             this,
@@ -349,16 +354,34 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
     buf_ptr_t buf;
     counted_t<block_token_t> block_token;
 
+    const ticks_t load_start = get_ticks();
+    counted_t<block_token_t> copy_token;
+    bool used_copy;
+    buf_ptr_t copy = page_cache->evicter().take_compressed_copy(block_id, &copy_token);
     {
         serializer_t *const serializer = page_cache->serializer();
         on_thread_t th(serializer->home_thread());
         block_token = serializer->index_read(block_id);
         rassert(block_token.has());
-        buf = serializer->block_read(block_token,
-                                     account->get());
+        // The copy is of the current version if its token points at the same place.
+        // (Token offsets are only safe to look at on the serializer's thread.)
+        used_copy = copy.has() && copy_token->offset() == block_token->offset();
+        if (used_copy) {
+            buf = std::move(copy);
+        } else {
+            copy.reset();
+            buf = serializer->block_read(block_token,
+                                         account->get());
+        }
+        copy_token.reset();
     }
 
     ASSERT_FINITE_CORO_WAITING;
+    if (used_copy) {
+        page_cache->evicter().record_compressed_hit();
+    }
+    page_cache->evicter().record_miss(
+        block_id, ticks_t{get_ticks().nanos - load_start.nanos});
     if (loader.abandon_page()) {
         return;
     }
@@ -445,8 +468,17 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     counted_t<block_token_t> block_token = page->block_token_;
     rassert(block_token.has());
 
-    buf_ptr_t buf;
-    {
+    // The page might be gone once we get back, if it was abandoned.
+    const block_id_t block_id = page->block_id_;
+    const ticks_t load_start = get_ticks();
+    // The copy is of this page if it came with the page's own token.  It could be of
+    // another version of the block, if the page is a snapshot.
+    counted_t<block_token_t> copy_token;
+    buf_ptr_t buf = page_cache->evicter().take_compressed_copy(block_id, &copy_token);
+    if (buf.has() && copy_token.get() == block_token.get()) {
+        page_cache->evicter().record_compressed_hit();
+    } else {
+        buf.reset();
         serializer_t *const serializer = page_cache->serializer();
 
         on_thread_t th(serializer->home_thread());
@@ -455,6 +487,8 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     }
 
     ASSERT_FINITE_CORO_WAITING;
+    page_cache->evicter().record_miss(
+        block_id, ticks_t{get_ticks().nanos - load_start.nanos});
     if (loader.abandon_page()) {
         return;
     }
@@ -521,6 +555,28 @@ void *page_t::get_page_buf(page_cache_t *page_cache) {
     return buf_.cache_data();
 }
 
+void page_t::note_reference(page_access_hint_t hint) {
+    switch (hint) {
+    case page_access_hint_t::normal:
+        reference_class_ =
+            reference_class_ == page_reference_class_t::unreferenced
+            ? page_reference_class_t::probation
+            : page_reference_class_t::hot;
+        break;
+    case page_access_hint_t::streaming:
+        // Streaming accesses never make a page hot by themselves: a table scanned
+        // over and over again shouldn't push out pages used by point reads.
+        if (reference_class_ == page_reference_class_t::unreferenced) {
+            reference_class_ = page_reference_class_t::streaming;
+        } else if (reference_class_ == page_reference_class_t::streaming) {
+            reference_class_ = page_reference_class_t::probation;
+        }
+        break;
+    default:
+        unreachable();
+    }
+}
+
 void page_t::reset_block_token(DEBUG_VAR page_cache_t *page_cache) {
     // The page is supposed to have its buffer acquired in reset_block_token -- it's
     // the thing modifying the page.  We thus assume that the page is unevictable and
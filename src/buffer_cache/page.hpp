@@ -1,6 +1,7 @@
 #ifndef BUFFER_CACHE_PAGE_HPP_
 #define BUFFER_CACHE_PAGE_HPP_
 
+#include "buffer_cache/types.hpp"
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
@@ -19,6 +20,22 @@ class page_loader_t;
 class deferred_page_loader_t;
 class deferred_block_token_t;
 
+// How a page has been referenced since it was created or first loaded.  The
+// scan-resistant eviction policy uses this to decide which pages to evict first.  A
+// page keeps its class when it gets evicted (the page_t sticks around in the evicted
+// bag), so a page that is re-referenced soon after being evicted goes straight back
+// to being hot.
+enum class page_reference_class_t : uint8_t {
+    // Not yet referenced through a buf_read_t or buf_write_t, e.g. read-ahead pages.
+    unreferenced,
+    // Only referenced by one streaming access.
+    streaming,
+    // Referenced by one normal access, or by more than one streaming access.
+    probation,
+    // Re-referenced by a normal access.
+    hot,
+};
+
 // A page_t represents a page (a byte buffer of a specific size), having a definite
 // value known at the construction of the page_t (and possibly later modified
 // in-place, but still a definite known value).
@@ -56,6 +73,10 @@ public:
     uint32_t hypothetical_memory_usage(page_cache_t *page_cache) const;
     uint64_t access_time() const { return access_time_; }
 
+    // Called once for every buf_read_t or buf_write_t that gets at the page's buffer.
+    void note_reference(page_access_hint_t hint);
+    page_reference_class_t reference_class() const { return reference_class_; }
+
     bool is_loading() const {
         return loader_ != nullptr && page_t::loader_is_loading(loader_);
     }
@@ -155,6 +176,10 @@ private:
     // The logic above is implemented in evicter_t::correct_eviction_category.
     backindex_bag_index_t eviction_index_;
 
+    // This fits in next to `eviction_index_`, instead of being padded out to eight
+    // bytes after `access_time_`.
+    page_reference_class_t reference_class_;
+
     DISABLE_COPYING(page_t);
 };
 
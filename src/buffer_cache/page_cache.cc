@@ -9,6 +9,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/runtime_utils.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "buffer_cache/cache_balancer.hpp"
@@ -31,6 +32,13 @@ cache_conn_t::~cache_conn_t() {
 
 namespace alt {
 
+// `page_cache_t::prefetch_block()` doesn't start any loads while this fraction of
+// the memory limit is unevictable.
+const uint64_t PREFETCH_MAX_UNEVICTABLE_FRACTION = 8;
+
+// How long `page_cache_t::warm_up()` waits when it can't start any more loads.
+const int64_t WARM_UP_RETRY_MS = 10;
+
 class current_page_help_t {
 public:
     current_page_help_t(block_id_t _block_id, page_cache_t *_page_cache)
@@ -98,7 +106,7 @@ void page_read_ahead_cb_t::offer_read_ahead_buf(
     buf_ptr_t local_buf = std::move(*buf);
 
     block_size_t block_size = block_size_t::undefined();
-    scoped_device_block_aligned_ptr_t<ser_buffer_t> ptr;
+    scoped_buf_arena_ptr_t<ser_buffer_t> ptr;
     local_buf.release(&block_size, &ptr);
 
     // We're going to reconstruct the buf_ptr_t on the other side of this do_on_thread
@@ -111,7 +119,7 @@ void page_read_ahead_cb_t::offer_read_ahead_buf(
                  std::bind(&page_cache_t::add_read_ahead_buf,
                            page_cache_,
                            block_id,
-                           copyable_unique_t<scoped_device_block_aligned_ptr_t<ser_buffer_t> >(std::move(ptr)),
+                           copyable_unique_t<scoped_buf_arena_ptr_t<ser_buffer_t> >(std::move(ptr)),
                            token));
 }
 
@@ -138,12 +146,11 @@ void page_cache_t::consider_evicting_current_page(block_id_t block_id) {
         return;
     }
 
-    auto page_it = current_pages_.find(block_id);
-    if (page_it == current_pages_.end()) {
+    current_page_t *page_ptr = current_pages_.get(block_id);
+    if (page_ptr == nullptr) {
         return;
     }
 
-    current_page_t *page_ptr = page_it->second;
     if (page_ptr->should_be_evicted()) {
         current_pages_.erase(block_id);
         page_ptr->reset(this);
@@ -151,6 +158,48 @@ void page_cache_t::consider_evicting_current_page(block_id_t block_id) {
     }
 }
 
+const std::vector<uint64_t> *page_cache_t::get_block_summary(
+        const current_page_acq_t *acq) {
+    assert_thread();
+    if (!acq->sees_current_version()) {
+        return nullptr;
+    }
+    auto it = block_summaries_.find(acq->block_id());
+    return it == block_summaries_.end() ? nullptr : &it->second.words;
+}
+
+void page_cache_t::set_block_summary(const current_page_acq_t *acq,
+                                     std::vector<uint64_t> &&summary) {
+    assert_thread();
+    if (!acq->sees_current_version()) {
+        return;
+    }
+    drop_block_summary(acq->block_id());
+    const uint64_t serial = next_block_summary_serial_++;
+    block_summaries_bytes_ += summary.size() * sizeof(uint64_t);
+    block_summaries_.insert(std::make_pair(
+        acq->block_id(), block_summary_t{std::move(summary), serial}));
+    block_summary_order_.push_back(std::make_pair(acq->block_id(), serial));
+
+    while (block_summaries_bytes_ > BLOCK_SUMMARIES_MAX_BYTES
+           || block_summary_order_.size() > 2 * block_summaries_.size()) {
+        const std::pair<block_id_t, uint64_t> oldest = block_summary_order_.front();
+        block_summary_order_.pop_front();
+        auto it = block_summaries_.find(oldest.first);
+        if (it != block_summaries_.end() && it->second.serial == oldest.second) {
+            drop_block_summary(oldest.first);
+        }
+    }
+}
+
+void page_cache_t::drop_block_summary(block_id_t block_id) {
+    auto it = block_summaries_.find(block_id);
+    if (it != block_summaries_.end()) {
+        block_summaries_bytes_ -= it->second.words.size() * sizeof(uint64_t);
+        block_summaries_.erase(it);
+    }
+}
+
 block_version_t page_cache_t::gen_block_version() {
     block_version_t ret = next_block_version_;
     next_block_version_ = next_block_version_.subsequent();
@@ -160,7 +209,7 @@ block_version_t page_cache_t::gen_block_version() {
 
 
 void page_cache_t::add_read_ahead_buf(block_id_t block_id,
-                                      scoped_device_block_aligned_ptr_t<ser_buffer_t> ptr,
+                                      scoped_buf_arena_ptr_t<ser_buffer_t> ptr,
                                       const counted_t<block_token_t> &token) {
     assert_thread();
 
@@ -172,7 +221,7 @@ void page_cache_t::add_read_ahead_buf(block_id_t block_id,
 
     // We MUST stop if current_pages_[block_id] already exists, because that means
     // the read-ahead page might be out of date.
-    if (current_pages_.count(block_id) > 0) {
+    if (current_pages_.get(block_id) != nullptr) {
         return;
     }
 
@@ -183,7 +232,8 @@ void page_cache_t::add_read_ahead_buf(block_id_t block_id,
     // no useful work to be done).
 
     buf_ptr_t buf(token->block_size(), std::move(ptr));
-    current_pages_[block_id] = new current_page_t(block_id, std::move(buf), token, this);
+    current_pages_.insert(
+        block_id, new current_page_t(block_id, std::move(buf), token, this));
 }
 
 void page_cache_t::have_read_ahead_cb_destroyed() {
@@ -207,9 +257,10 @@ void page_cache_t::consider_evicting_all_current_pages(page_cache_t *page_cache,
     // Atomically grab a list of block IDs that currently exist in current_pages.
     std::vector<block_id_t> current_block_ids;
     current_block_ids.reserve(page_cache->current_pages_.size());
-    for (const auto &current_page : page_cache->current_pages_) {
-        current_block_ids.push_back(current_page.first);
-    }
+    page_cache->current_pages_.visit(
+        [&](const current_page_map_t::entry_t &entry) {
+            current_block_ids.push_back(entry.key);
+        });
 
     // In a separate step, evict current pages that should be evicted.
     // We do this separately so that we can yield between evictions.
@@ -245,6 +296,10 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
                            alt_txn_throttler_t *throttler)
     : max_block_size_(_serializer->max_block_size()),
       serializer_(_serializer),
+      prefetched_blocks_(0),
+      prefetch_hits_(0),
+      next_block_summary_serial_(0),
+      block_summaries_bytes_(0),
       // Start the counter at 1 so we can distinguish empty values.
       next_block_version_(block_version_t().subsequent()),
       free_list_(_serializer),
@@ -264,7 +319,9 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
             local_read_ahead_cb = new page_read_ahead_cb_t(_serializer, this);
         }
         default_reads_account_.init(_serializer->home_thread(),
-                                    _serializer->make_io_account(CACHE_READS_IO_PRIORITY));
+                                    _serializer->make_io_account(
+                                        CACHE_READS_IO_PRIORITY,
+                                        io_class_t::foreground_read));
         index_write_sink_.init(new page_cache_index_write_sink_t);
         recencies_ = _serializer->get_all_recencies();
     }
@@ -292,14 +349,15 @@ page_cache_t::~page_cache_t() {
 
     drainer_.reset();
     size_t i = 0;
-    for (auto &&page : current_pages_) {
-        if (i % 256 == 255) {
-            coro_t::yield();
-        }
-        ++i;
-        page.second->reset(this);
-        delete page.second;
-    }
+    current_pages_.visit(
+        [&](const current_page_map_t::entry_t &entry) {
+            if (i % 256 == 255) {
+                coro_t::yield();
+            }
+            ++i;
+            entry.value->reset(this);
+            delete entry.value;
+        });
 
     {
         /* IO accounts and a few other fields must be destroyed on the serializer
@@ -373,20 +431,163 @@ void page_cache_t::end_read_txn(scoped_ptr_t<page_txn_t> txn) {
 current_page_t *page_cache_t::page_for_block_id(block_id_t block_id) {
     assert_thread();
 
-    auto page_it = current_pages_.find(block_id);
-    if (page_it == current_pages_.end()) {
+    current_page_t *page = current_pages_.get(block_id);
+    if (page == nullptr) {
         rassert(is_aux_block_id(block_id) ||
                 recency_for_block_id(block_id) != repli_timestamp_t::invalid,
                 "Expected block %" PR_BLOCK_ID " not to be deleted "
                 "(should you have used alt_create_t::create?).",
                 block_id);
-        page_it = current_pages_.insert(
-            page_it, std::make_pair(block_id, new current_page_t(block_id, this)));
+        page = new current_page_t(block_id, this);
+        current_pages_.insert(block_id, page);
     } else {
-        rassert(!page_it->second->is_deleted());
+        rassert(!page->is_deleted());
+    }
+
+    return page;
+}
+
+bool page_cache_t::prefetch_block(block_id_t block_id) {
+    assert_thread();
+
+    // Pages that are being loaded are unevictable, so this bounds how much of the
+    // memory limit the balancer gave us can be tied up by prefetches.
+    if (evicter_.unevictable_size()
+        >= evicter_.memory_limit() / PREFETCH_MAX_UNEVICTABLE_FRACTION) {
+        return false;
+    }
+
+    current_page_t *existing = current_pages_.get(block_id);
+    if (existing == nullptr) {
+        if (!is_aux_block_id(block_id)
+            && recency_for_block_id(block_id) == repli_timestamp_t::invalid) {
+            // The block has been deleted.
+            return false;
+        }
+    } else {
+        if (existing->is_deleted() || !existing->acquirers_.empty()) {
+            return false;
+        }
+        if (existing->page_.has()) {
+            page_t *page = existing->page_.get_page_for_read();
+            if (page->is_loading() || page->is_loaded()) {
+                return false;
+            }
+        }
+    }
+
+    current_page_t *cp = page_for_block_id(block_id);
+    // This constructs the page with an account, which starts loading it right away.
+    // Once it's loaded, it's evictable like any other unacquired page.
+    cp->the_page_for_read(current_page_help_t(block_id, this), &default_reads_account_);
+    cp->prefetched_ = true;
+    ++prefetched_blocks_;
+    return true;
+}
+
+std::vector<block_id_t> page_cache_t::hot_block_ids(size_t max_count) {
+    assert_thread();
+    std::vector<std::pair<uint64_t, block_id_t> > pages;
+    current_pages_.visit(
+        [&](const current_page_map_t::entry_t &entry) {
+            const current_page_t *cp = entry.value;
+            if (is_aux_block_id(entry.key) || cp->is_deleted() || !cp->page_.has()) {
+                return;
+            }
+            const page_t *page = cp->page_.get_page_for_read();
+            if (page->is_loaded() && page->is_disk_backed()) {
+                pages.push_back(std::make_pair(page->access_time(), entry.key));
+            }
+        });
+    const size_t count = std::min(max_count, pages.size());
+    std::partial_sort(pages.begin(), pages.begin() + count, pages.end(),
+                      std::greater<std::pair<uint64_t, block_id_t> >());
+    std::vector<block_id_t> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ret.push_back(pages[i].second);
+    }
+    return ret;
+}
+
+void page_cache_t::warm_up(const std::vector<block_id_t> &block_ids,
+                           uint64_t max_bytes,
+                           signal_t *interruptor) {
+    assert_thread();
+    std::vector<std::pair<int64_t, block_id_t> > offsets;
+    {
+        on_thread_t thread_switcher(serializer_->home_thread());
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < block_ids.size() && bytes < max_bytes; ++i) {
+            if (is_aux_block_id(block_ids[i])) {
+                continue;
+            }
+            counted_t<block_token_t> token = serializer_->index_read(block_ids[i]);
+            if (token.has()) {
+                bytes += token->block_size().ser_value();
+                offsets.push_back(std::make_pair(token->offset(), block_ids[i]));
+            }
+            if (i % 1024 == 1023) {
+                coro_t::yield();
+            }
+        }
+    }
+    std::sort(offsets.begin(), offsets.end());
+
+    for (const auto &pair : offsets) {
+        if (evicter_.unevictable_size() + evicter_.evictable_disk_backed_size()
+                + evicter_.evictable_unbacked_size() >= evicter_.memory_limit()) {
+            return;
+        }
+        while (evicter_.unevictable_size()
+               >= evicter_.memory_limit() / PREFETCH_MAX_UNEVICTABLE_FRACTION) {
+            nap(WARM_UP_RETRY_MS, interruptor);
+        }
+        prefetch_block(pair.second);
+    }
+}
+
+void page_cache_t::prefetch_blocks(const std::vector<block_id_t> &block_ids) {
+    assert_thread();
+    std::vector<block_id_t> missing;
+    for (block_id_t block_id : block_ids) {
+        current_page_t *existing = current_pages_.get(block_id);
+        if (existing != nullptr && existing->page_.has()) {
+            page_t *page = existing->page_.get_page_for_read();
+            if (page->is_loading() || page->is_loaded()) {
+                continue;
+            }
+        }
+        missing.push_back(block_id);
+    }
+    if (missing.size() == 1) {
+        prefetch_block(missing[0]);
+    } else if (missing.size() > 1) {
+        coro_t::spawn_sometime(std::bind(&page_cache_t::prefetch_blocks_in_file_order,
+                                         this, std::move(missing), drainer_->lock()));
     }
+}
 
-    return page_it->second;
+void page_cache_t::prefetch_blocks_in_file_order(std::vector<block_id_t> block_ids,
+                                                 auto_drainer_t::lock_t) {
+    std::vector<std::pair<int64_t, block_id_t> > offsets;
+    {
+        on_thread_t thread_switcher(serializer_->home_thread());
+        for (block_id_t block_id : block_ids) {
+            if (is_aux_block_id(block_id)) {
+                continue;
+            }
+            counted_t<block_token_t> token = serializer_->index_read(block_id);
+            if (token.has()) {
+                offsets.push_back(std::make_pair(token->offset(), block_id));
+            }
+        }
+    }
+    std::sort(offsets.begin(), offsets.end());
+    for (const auto &pair : offsets) {
+        // The blocks that the traversal got to in the meantime are skipped here.
+        prefetch_block(pair.second);
+    }
 }
 
 current_page_t *page_cache_t::page_for_new_block_id(
@@ -433,11 +634,11 @@ current_page_t *page_cache_t::internal_page_for_new_chosen(block_id_t block_id)
     memset(buf.cache_data(), 0xCD, max_block_size_.value());
 #endif
 
-    auto inserted_page = current_pages_.insert(std::make_pair(
-        block_id, new current_page_t(block_id, std::move(buf), this)));
-    guarantee(inserted_page.second);
+    current_page_t *page = new current_page_t(block_id, std::move(buf), this);
+    bool inserted = current_pages_.insert(block_id, page);
+    guarantee(inserted);
 
-    return inserted_page.first->second;
+    return page;
 }
 
 cache_account_t page_cache_t::create_cache_account(int priority) {
@@ -459,7 +660,8 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
         // what the file account API is right now, deep in the I/O layer.
         on_thread_t thread_switcher(serializer_->home_thread());
         io_account = serializer_->make_io_account(io_priority,
-                                                  outstanding_requests_limit);
+                                                  outstanding_requests_limit,
+                                                  io_class_t::background);
     }
 
     return cache_account_t(serializer_->home_thread(), io_account);
@@ -577,6 +779,15 @@ current_page_acq_t::~current_page_acq_t() {
     }
 }
 
+bool current_page_acq_t::sees_current_version() const {
+    assert_thread();
+    return access_ == access_t::read
+        && !declared_snapshotted_
+        && current_page_ != nullptr
+        && read_cond_.is_pulsed()
+        && block_version_ == current_page_->last_write_acquirer_version_;
+}
+
 void current_page_acq_t::declare_readonly() {
     assert_thread();
     access_ = access_t::read;
@@ -746,22 +957,24 @@ void current_page_acq_t::pulse_write_available() {
 
 current_page_t::current_page_t(block_id_t block_id, page_cache_t *page_cache)
     : block_id_(block_id),
-      is_deleted_(false),
       last_write_acquirer_(nullptr),
       last_write_acquirer_version_(page_cache->gen_block_version()),
       last_dirtier_(nullptr),
-      num_keepalives_(0) { }
+      num_keepalives_(0),
+      is_deleted_(false),
+      prefetched_(false) { }
 
 current_page_t::current_page_t(block_id_t block_id,
                                buf_ptr_t buf,
                                page_cache_t *page_cache)
     : block_id_(block_id),
       page_(new page_t(block_id, std::move(buf), page_cache)),
-      is_deleted_(false),
       last_write_acquirer_(nullptr),
       last_write_acquirer_version_(page_cache->gen_block_version()),
       last_dirtier_(nullptr),
-      num_keepalives_(0) { }
+      num_keepalives_(0),
+      is_deleted_(false),
+      prefetched_(false) { }
 
 current_page_t::current_page_t(block_id_t block_id,
                                buf_ptr_t buf,
@@ -769,11 +982,12 @@ current_page_t::current_page_t(block_id_t block_id,
                                page_cache_t *page_cache)
     : block_id_(block_id),
       page_(new page_t(block_id, std::move(buf), token, page_cache)),
-      is_deleted_(false),
       last_write_acquirer_(nullptr),
       last_write_acquirer_version_(page_cache->gen_block_version()),
       last_dirtier_(nullptr),
-      num_keepalives_(0) { }
+      num_keepalives_(0),
+      is_deleted_(false),
+      prefetched_(false) { }
 
 current_page_t::~current_page_t() {
     // Check that reset() has been called.
@@ -853,6 +1067,7 @@ void current_page_t::add_acquirer(current_page_acq_t *acq) {
     const block_version_t prev_version = last_write_acquirer_version_;
 
     if (acq->access_ == access_t::write) {
+        acq->page_cache_->drop_block_summary(block_id_);
         block_version_t v = acq->page_cache_->gen_block_version();
         acq->block_version_ = v;
 
@@ -881,6 +1096,16 @@ void current_page_t::add_acquirer(current_page_acq_t *acq) {
         acq->block_version_ = prev_version;
     }
 
+    if (prefetched_) {
+        prefetched_ = false;
+        if (page_.has()) {
+            page_t *page = page_.get_page_for_read();
+            if (page->is_loading() || page->is_loaded()) {
+                ++acq->page_cache_->prefetch_hits_;
+            }
+        }
+    }
+
     acquirers_.push_back(acq);
     pulse_pulsables(acq);
 }
@@ -2015,7 +2240,8 @@ void page_cache_t::begin_waiting_for_flush(
     rassert(!base->spawned_flush_);
 
     // This is redundant because we pass the durability in the throttler_acq_
-    // constructor anyway.
+    // constructor anyway.  GROUP txns wait in `waiting_for_spawn_flush_` like soft
+    // ones, until `cache_t`'s group flush picks them up.
     if (durability == write_durability_t::HARD) {
         page_txn_t::propagate_pre_spawn_flush(base.get());
     }
@@ -2,6 +2,7 @@
 #ifndef BUFFER_CACHE_PAGE_CACHE_HPP_
 #define BUFFER_CACHE_PAGE_CACHE_HPP_
 
+#include <deque>
 #include <functional>
 #include <map>
 #include <set>
@@ -21,7 +22,9 @@
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/new_semaphore.hpp"
 #include "containers/backindex_bag.hpp"
+#include "containers/buf_arena.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/open_addressing_map.hpp"
 #include "containers/segmented_vector.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/types.hpp"
@@ -145,6 +148,10 @@ private:
 
     bool is_deleted() const { return is_deleted_; }
 
+    // There is one of these for every block in the cache, so the fields are ordered
+    // to leave no padding: the pointers and 64-bit values first, then the 32-bit
+    // backindexes and `num_keepalives_`, then the flags.
+
     // KSI: We could get rid of this variable if
     // page_txn_t::pages_write_acquired_last_ noted each page's block_id_t.  Other
     // space reductions are more important.
@@ -156,19 +163,14 @@ private:
     // be used to access this variable.
     // KSI: Could we encapsulate that rule?
     page_ptr_t page_;
-    // True if the block is in a deleted state.  page_ will be null.
-    bool is_deleted_;
 
     // The last write acquirer for this page.
     page_txn_t *last_write_acquirer_;
-    // Our index into the last_write_acquirer_->pages_write_acquired_last_.
-    backindex_bag_index_t last_write_acquirer_index_;
 
     // The version of the page, that the last write acquirer had.
     block_version_t last_write_acquirer_version_;
 
     page_txn_t *last_dirtier_;
-    backindex_bag_index_t last_dirtier_index_;
 
     // The version and recency of the page, that the last dirtier had.  We merely set
     // and read these values, the only thing it affects is compute_changes, later.
@@ -179,13 +181,25 @@ private:
 
     // Instead of storing the recency here, we store it page_cache_t::recencies_.
 
-    // All list elements have current_page_ != NULL, snapshotted_page_ == NULL.
+    // All list elements have current_page_ != NULL, snapshotted_page_ == NULL.  The
+    // acquirers link themselves into the list, so waiting in line doesn't allocate.
     intrusive_list_t<current_page_acq_t> acquirers_;
 
+    // Our index into the last_write_acquirer_->pages_write_acquired_last_.
+    backindex_bag_index_t last_write_acquirer_index_;
+    backindex_bag_index_t last_dirtier_index_;
+
     // Avoids eviction if > 0. This is used by snapshotted current_page_acq_t's
     // that have a snapshotted version of this block. If the current_page_t
     // would be evicted that would mess with the block version.
-    intptr_t num_keepalives_;
+    uint32_t num_keepalives_;
+
+    // True if the block is in a deleted state.  page_ will be null.
+    bool is_deleted_;
+
+    // True if the page was loaded by `page_cache_t::prefetch_block()` and hasn't
+    // been acquired since.
+    bool prefetched_;
 
     DISABLE_COPYING(current_page_t);
 };
@@ -264,6 +278,11 @@ private:
               read_access_t read);
     friend class page_txn_t;
     friend class current_page_t;
+    friend class page_cache_t;
+
+    // Returns true if we're a reader that has been pulsed, and no write acquirer has
+    // gotten in line for the page since we did.
+    bool sees_current_version() const;
 
     // Returns true if the page has been created, edited, or deleted.
     bool dirtied_page() const;
@@ -459,6 +478,43 @@ public:
         block_id_t *block_id_out);
     current_page_t *page_for_new_chosen_block_id(block_id_t block_id);
 
+    // Starts loading the block in the background (with the default reads account),
+    // unless it's already in memory or being loaded.  It gives up if too much of the
+    // cache is busy with loads already.  Returns true if it started a load.
+    bool prefetch_block(block_id_t block_id);
+
+    // How many blocks `prefetch_block()` has started loading, and how many of them
+    // were acquired before they got evicted.
+    uint64_t prefetched_blocks() const { return prefetched_blocks_; }
+    uint64_t prefetch_hits() const { return prefetch_hits_; }
+
+    // Returns the ids of up to `max_count` of the loaded blocks, most recently
+    // accessed first.
+    std::vector<block_id_t> hot_block_ids(size_t max_count);
+
+    // Prefetches the blocks in `block_ids` that are still on disk, taking them in
+    // order until they add up to `max_bytes` or the cache is full, and loading them in
+    // the order they are in the file.  That way, while read-ahead is on, each read
+    // brings in its neighbours too.  Throws `interrupted_exc_t`.
+    void warm_up(const std::vector<block_id_t> &block_ids, uint64_t max_bytes,
+                 signal_t *interruptor);
+
+    // Like calling `prefetch_block()` for each of `block_ids`, but when several of
+    // them have to be loaded, they are loaded in the order they are in the file.
+    // Doesn't block; finding out the order happens in the background.
+    void prefetch_blocks(const std::vector<block_id_t> &block_ids);
+
+    // The cache can keep a small summary of a block's contents for its user (the btree
+    // keeps Bloom filters of the keys in leaf nodes), which stays in memory when the
+    // block gets evicted, and gets dropped when the block is acquired for write.
+    // `get_block_summary()` returns null if there's no summary, or if `acq` might
+    // see another version of the block than the current one.  `acq` must have been
+    // pulsed for read, and must not be snapshotted.  The oldest summaries are
+    // dropped once they take up more than `BLOCK_SUMMARIES_MAX_BYTES`.
+    const std::vector<uint64_t> *get_block_summary(const current_page_acq_t *acq);
+    void set_block_summary(const current_page_acq_t *acq,
+                           std::vector<uint64_t> &&summary);
+
     // Returns how much memory is being used by all the pages in the cache at this
     // moment in time.
     size_t total_page_memory() const;
@@ -466,6 +522,8 @@ public:
 
     max_block_size_t max_block_size() const { return max_block_size_; }
 
+    // For backfills and the like: reads through the account are in
+    // `io_class_t::background`.
     cache_account_t create_cache_account(int priority);
 
     cache_account_t *default_reads_account() {
@@ -488,12 +546,15 @@ public:
     serializer_t *serializer() { return serializer_; }
 
 private:
+    void prefetch_blocks_in_file_order(std::vector<block_id_t> block_ids,
+                                       auto_drainer_t::lock_t keepalive);
+
     void help_take_snapshotted_dirtied_page(
         current_page_t *cp, block_id_t block_id, page_txn_t *dirtier);
 
     friend class page_read_ahead_cb_t;
     void add_read_ahead_buf(block_id_t block_id,
-                            scoped_device_block_aligned_ptr_t<ser_buffer_t> ptr,
+                            scoped_buf_arena_ptr_t<ser_buffer_t> ptr,
                             const counted_t<block_token_t> &token);
 
     void read_ahead_cb_is_destroyed();
@@ -617,7 +678,26 @@ private:
     serializer_t *serializer_;
     segmented_vector_t<repli_timestamp_t> recencies_;
 
-    std::unordered_map<block_id_t, current_page_t *> current_pages_;
+    // Looked up on every block acquisition.
+    typedef open_addressing_map_t<block_id_t, current_page_t *> current_page_map_t;
+    current_page_map_t current_pages_;
+
+    uint64_t prefetched_blocks_;
+    uint64_t prefetch_hits_;
+
+    void drop_block_summary(block_id_t block_id);
+
+    struct block_summary_t {
+        std::vector<uint64_t> words;
+        // Tells apart the summaries for the same block in `block_summary_order_`.
+        uint64_t serial;
+    };
+    std::unordered_map<block_id_t, block_summary_t> block_summaries_;
+    // The summaries in the order they were set, including ones that have been
+    // dropped or replaced since, which `set_block_summary()` skips.
+    std::deque<std::pair<block_id_t, uint64_t> > block_summary_order_;
+    uint64_t next_block_summary_serial_;
+    size_t block_summaries_bytes_;
 
     // An incrementing 64-bit counter used to generate block versions, with values 1, 2,
     // 3, ...  This makes sure that block writes never get overwritten by previous block
@@ -8,28 +8,70 @@ alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
     page_cache(_page_cache),
     cache_collection(),
     cache_membership(parent, &cache_collection, "cache"),
-    in_use_bytes(this),
+    in_use_bytes(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().in_memory_size();
+    }),
     in_use_bytes_membership(&cache_collection,
                             &in_use_bytes, "in_use_bytes"),
+    prefetched_blocks(this, [](alt::page_cache_t *c) -> double {
+        return c->prefetched_blocks();
+    }),
+    prefetched_blocks_membership(&cache_collection,
+                                 &prefetched_blocks, "prefetched_blocks"),
+    prefetch_hits(this, [](alt::page_cache_t *c) -> double {
+        return c->prefetch_hits();
+    }),
+    prefetch_hits_membership(&cache_collection,
+                             &prefetch_hits, "prefetch_hits"),
+    limit_bytes(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().memory_limit();
+    }),
+    limit_bytes_membership(&cache_collection, &limit_bytes, "limit_bytes"),
+    misses_total(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().total_misses().misses;
+    }),
+    misses_total_membership(&cache_collection, &misses_total, "misses_total"),
+    ghost_hits_total(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().total_misses().ghost_hits;
+    }),
+    ghost_hits_total_membership(&cache_collection,
+                                &ghost_hits_total, "ghost_hits_total"),
+    marginal_gain(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().marginal_gain();
+    }),
+    marginal_gain_membership(&cache_collection, &marginal_gain, "marginal_gain"),
+    compressed_in_use_bytes(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().compressed_size();
+    }),
+    compressed_in_use_bytes_membership(&cache_collection,
+                                       &compressed_in_use_bytes,
+                                       "compressed_in_use_bytes"),
+    compressed_hits_total(this, [](alt::page_cache_t *c) -> double {
+        return c->evicter().compressed_hits();
+    }),
+    compressed_hits_total_membership(&cache_collection,
+                                     &compressed_hits_total, "compressed_hits_total"),
     cache_collection_membership(&cache_collection) { }
 
-alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent) :
-    parent(_parent) { }
+alt_cache_stats_t::perfmon_value_t::perfmon_value_t(
+        alt_cache_stats_t *_parent,
+        double (*_get_value)(alt::page_cache_t *)) :
+    parent(_parent), get_value(_get_value) { }
 
 void *alt_cache_stats_t::perfmon_value_t::begin_stats() {
-    return new uint64_t;
+    return new double(0);
 }
 
 void alt_cache_stats_t::perfmon_value_t::visit_stats(void *ptr) {
     if (get_thread_id() == parent->home_thread()) {
-        uint64_t *value = reinterpret_cast<uint64_t *>(ptr);
-        *value = parent->page_cache->evicter().in_memory_size();
+        double *value = reinterpret_cast<double *>(ptr);
+        *value = get_value(parent->page_cache);
     }
 }
 
 ql::datum_t alt_cache_stats_t::perfmon_value_t::end_stats(void *ptr) {
-    uint64_t *value = reinterpret_cast<uint64_t *>(ptr);
-    ql::datum_t res(static_cast<double>(*value));
+    double *value = reinterpret_cast<double *>(ptr);
+    ql::datum_t res(*value);
     delete value;
     return res;
 }
@@ -17,17 +17,42 @@ public:
 
     class perfmon_value_t : public perfmon_t {
     public:
-        explicit perfmon_value_t(alt_cache_stats_t *_parent);
+        perfmon_value_t(alt_cache_stats_t *_parent,
+                        double (*_get_value)(alt::page_cache_t *));
         void *begin_stats();
         void visit_stats(void *);
         ql::datum_t end_stats(void *);
     private:
         alt_cache_stats_t *parent;
+        double (*get_value)(alt::page_cache_t *);
         DISABLE_COPYING(perfmon_value_t);
     };
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
 
+    // Blocks loaded by range scans before they were acquired, see
+    // `page_cache_t::prefetch_block()`.
+    perfmon_value_t prefetched_blocks;
+    perfmon_membership_t prefetched_blocks_membership;
+    perfmon_value_t prefetch_hits;
+    perfmon_membership_t prefetch_hits_membership;
+
+    // What the cache balancer bases its decisions on, see `alt_cache_balancer_t`.
+    perfmon_value_t limit_bytes;
+    perfmon_membership_t limit_bytes_membership;
+    perfmon_value_t misses_total;
+    perfmon_membership_t misses_total_membership;
+    perfmon_value_t ghost_hits_total;
+    perfmon_membership_t ghost_hits_total_membership;
+    perfmon_value_t marginal_gain;
+    perfmon_membership_t marginal_gain_membership;
+
+    // The compressed copies of evicted pages, see `compressed_page_pool_t`.
+    perfmon_value_t compressed_in_use_bytes;
+    perfmon_membership_t compressed_in_use_bytes_membership;
+    perfmon_value_t compressed_hits_total;
+    perfmon_membership_t compressed_hits_total_membership;
+
 
     perfmon_multi_membership_t cache_collection_membership;
 };
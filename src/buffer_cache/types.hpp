@@ -9,12 +9,16 @@
 #include "serializer/types.hpp"
 
 // write_durability_t::INVALID is an invalid value, notably it can't be serialized.
-enum class write_durability_t { INVALID, SOFT, HARD };
+// GROUP transactions don't start a flush of their own like HARD ones do, but still
+// wait until they're on disk.  They get flushed together, at most
+// GROUP_DURABILITY_FLUSH_DELAY_MS after the first of them commits.
+enum class write_durability_t { INVALID, SOFT, HARD, GROUP };
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(write_durability_t, int8_t,
                                       write_durability_t::SOFT,
-                                      write_durability_t::HARD);
+                                      write_durability_t::GROUP);
 
 #define DEFAULT_FLUSH_INTERVAL 1000
+#define GROUP_DURABILITY_FLUSH_DELAY_MS 2
 // Converting this value from millis to nanos is less than half of 2^63.
 #define NEVER_FLUSH_INTERVAL (0x100000000ll * 1000ll)
 
@@ -22,6 +26,29 @@ struct flush_interval_t {
     int64_t millis;
 };
 
+// How the evicter picks pages to evict.  `lru` evicts (approximately) the least
+// recently used page.  `scan_resistant` prefers to evict pages that were brought in
+// by a streaming access or that have only been used once, so that a large range scan
+// can't flush out the working set of a cache.  See `alt::evicter_t`.
+enum class eviction_policy_t { lru, scan_resistant };
+
+// Passed along with a block acquisition to tell the evicter how the block is being
+// used.  Range traversals that touch each block once (table scans, backfills,
+// changefeed initial values, ...) should use `streaming`.
+enum class page_access_hint_t { normal, streaming };
+
+// Counts the pages that had to be loaded from the serializer because they weren't in
+// memory.
+struct cache_miss_counts_t {
+    cache_miss_counts_t() : misses(0), ghost_hits(0), load_nanos(0) { }
+
+    uint64_t misses;
+    // The misses on blocks that were in the evicter's ghost list.
+    uint64_t ghost_hits;
+    // The total time spent loading the pages for the misses.
+    int64_t load_nanos;
+};
+
 typedef uint32_t block_magic_comparison_t;
 
 struct block_magic_t {
@@ -0,0 +1,142 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/binary.hpp"
+
+#include <string.h>
+
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "client_protocol/json.hpp"
+#include "client_protocol/protocols.hpp"
+#include "containers/archive/archive.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/rdb_backtrace.hpp"
+#include "rdb_protocol/response.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "rdb_protocol/term_storage.hpp"
+#include "utils.hpp"
+
+scoped_ptr_t<ql::query_params_t> binary_protocol_t::parse_query(
+        tcp_conn_t *conn,
+        signal_t *interruptor,
+        ql::query_cache_t *query_cache) {
+    return json_protocol_t::parse_query(conn, interruptor, query_cache,
+                                        &binary_protocol_t::send_response);
+}
+
+namespace {
+
+ql::datum_t response_to_datum(ql::response_t *response) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("t", ql::datum_t(static_cast<double>(response->type())));
+    if (response->type() == Response::RUNTIME_ERROR &&
+        response->error_type()) {
+        builder.overwrite("e",
+                          ql::datum_t(static_cast<double>(*response->error_type())));
+    }
+
+    // Copying the vector only copies references to the rows.
+    std::vector<ql::datum_t> rows = response->data();
+    builder.overwrite("r", ql::datum_t(std::move(rows),
+                                       ql::datum_t::no_array_size_limit_check_t()));
+
+    if (response->backtrace()) {
+        builder.overwrite("b", *response->backtrace());
+    }
+    if (response->profile()) {
+        builder.overwrite("p", *response->profile());
+    }
+    if (response->type() == Response::SUCCESS_PARTIAL ||
+        response->type() == Response::SUCCESS_SEQUENCE) {
+        std::vector<ql::datum_t> notes;
+        notes.reserve(response->notes().size());
+        for (const auto &note : response->notes()) {
+            notes.push_back(ql::datum_t(static_cast<double>(note)));
+        }
+        builder.overwrite("n", ql::datum_t(std::move(notes),
+                                           ql::datum_t::no_array_size_limit_check_t()));
+    }
+    return std::move(builder).to_datum();
+}
+
+}  // namespace
+
+void binary_protocol_t::write_response_to_message(ql::response_t *response,
+                                                  write_message_t *wm_out) {
+    // Without error checking, rows that still have their serialization from disk
+    // are copied into the message as they are.  The checks are only about what may
+    // be written to disk; anything is okay to send over the network.
+    ql::datum_serialize(wm_out, response_to_datum(response),
+                        ql::check_datum_serialization_errors_t::NO);
+}
+
+void binary_protocol_t::send_response(ql::response_t *response,
+                                      int64_t token,
+                                      tcp_conn_t *conn,
+                                      signal_t *interruptor) {
+    send_response_internal(response, token, conn, interruptor, false);
+}
+
+void binary_protocol_t::send_response_buffered(ql::response_t *response,
+                                               int64_t token,
+                                               tcp_conn_t *conn,
+                                               signal_t *interruptor) {
+    send_response_internal(response, token, conn, interruptor, true);
+}
+
+void binary_protocol_t::send_response_internal(ql::response_t *response,
+                                               int64_t token,
+                                               tcp_conn_t *conn,
+                                               signal_t *interruptor,
+                                               bool buffered) {
+    write_message_t payload;
+    write_response_to_message(response, &payload);
+    const size_t payload_size = payload.size();
+    guarantee(payload_size > 0);
+
+    if (payload_size >= wire_protocol_t::TOO_LARGE_RESPONSE_SIZE) {
+        response->fill_error(Response::RUNTIME_ERROR,
+                             Response::RESOURCE_LIMIT,
+                             wire_protocol_t::too_large_response_message(payload_size),
+                             ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        send_response_internal(response, token, conn, interruptor, buffered);
+        return;
+    }
+
+    uint32_t data_size = static_cast<uint32_t>(payload_size);
+#ifdef __s390x__
+    token = __builtin_bswap64(token);
+    data_size = __builtin_bswap32(data_size);
+#endif
+
+    // The header and the payload go out together, just like in the JSON protocol.
+    // Rows that `datum_serialize()` referenced rather than copied go from their shared
+    // buffers straight to the socket.
+    char header[sizeof(token) + sizeof(data_size)];
+    memcpy(header, &token, sizeof(token));
+    memcpy(header + sizeof(token), &data_size, sizeof(data_size));
+
+    std::vector<tcp_conn_t::write_slice_t> slices;
+    tcp_conn_t::write_slice_t header_slice;
+    header_slice.buf = header;
+    header_slice.size = sizeof(header);
+    slices.push_back(header_slice);
+    intrusive_list_t<write_buffer_t> *buffers = payload.unsafe_expose_buffers();
+    for (write_buffer_t *p = buffers->head(); p != nullptr; p = buffers->next(p)) {
+        tcp_conn_t::write_slice_t slice;
+        slice.buf = p->data();
+        slice.size = p->size;
+        slices.push_back(slice);
+    }
+
+    if (buffered && sizeof(header) + payload_size < tcp_conn_t::LARGE_WRITE_SIZE) {
+        // Small responses get copied together with the other buffered ones.
+        for (const tcp_conn_t::write_slice_t &slice : slices) {
+            conn->write_buffered(slice.buf, slice.size, interruptor);
+        }
+    } else {
+        conn->write_vectored(slices.data(), slices.size(), interruptor);
+    }
+}
@@ -0,0 +1,53 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLIENT_PROTOCOL_BINARY_HPP_
+#define CLIENT_PROTOCOL_BINARY_HPP_
+
+#include <stdint.h>
+
+#include "arch/types.hpp"
+#include "containers/scoped.hpp"
+
+class signal_t;
+class write_message_t;
+
+namespace ql {
+class response_t;
+class query_cache_t;
+class query_params_t;
+}
+
+// Selected with `protocol_version` 1 in the `V1_0` handshake.  Queries are still
+// JSON, but responses are the same `{t, e, r, b, p, n}` object that the JSON protocol
+// sends, encoded with `datum_serialize()` instead of as JSON.  That's the format we
+// store documents in, so rows that were read from disk go to the socket straight
+// from their shared buffers instead of being decoded and rendered again.
+class binary_protocol_t {
+public:
+    static scoped_ptr_t<ql::query_params_t> parse_query(tcp_conn_t *conn,
+                                                        signal_t *interruptor,
+                                                        ql::query_cache_t *query_cache);
+
+    static void write_response_to_message(ql::response_t *response,
+                                          write_message_t *wm_out);
+
+    static void send_response(ql::response_t *response,
+                              int64_t token,
+                              tcp_conn_t *conn,
+                              signal_t *interruptor);
+
+    // Like `send_response()`, but small responses might stay in the connection's
+    // write buffer until it gets flushed.
+    static void send_response_buffered(ql::response_t *response,
+                                       int64_t token,
+                                       tcp_conn_t *conn,
+                                       signal_t *interruptor);
+
+private:
+    static void send_response_internal(ql::response_t *response,
+                                       int64_t token,
+                                       tcp_conn_t *conn,
+                                       signal_t *interruptor,
+                                       bool buffered);
+};
+
+#endif // CLIENT_PROTOCOL_BINARY_HPP_
@@ -20,6 +20,9 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query_from_buffer(
         scoped_array_t<char> &&buffer, size_t offset,
         ql::query_cache_t *query_cache, int64_t token,
         ql::response_t *error_out) {
+    // `ParseInsitu` overwrites the buffer, so we have to copy the text first.
+    optional<std::string> compile_cache_key =
+        ql::query_params_t::make_compile_cache_key(buffer.data() + offset);
     rapidjson::Document doc;
     doc.ParseInsitu(buffer.data() + offset);
 
@@ -29,6 +32,7 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query_from_buffer(
             res = make_scoped<ql::query_params_t>(token, query_cache,
                     scoped_ptr_t<ql::term_storage_t>(
                         new ql::json_term_storage_t(std::move(buffer), std::move(doc))));
+            res->compile_cache_key = std::move(compile_cache_key);
         } catch (const ql::bt_exc_t &ex) {
             error_out->fill_error(Response::CLIENT_ERROR,
                                   ex.error_type,
@@ -48,7 +52,8 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query_from_buffer(
 scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         tcp_conn_t *conn,
         signal_t *interruptor,
-        ql::query_cache_t *query_cache) {
+        ql::query_cache_t *query_cache,
+        send_response_t send_error) {
     int64_t token;
     uint32_t size;
     conn->read_buffered(&token, sizeof(token), interruptor);
@@ -75,7 +80,7 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
             conn->pop(size, &pop_interruptor);
         }
 
-        send_response(&error, token, conn, interruptor);
+        send_error(&error, token, conn, interruptor);
         throw tcp_conn_read_closed_exc_t();
     }
 
@@ -91,7 +96,7 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         parse_query_from_buffer(std::move(data), 0, query_cache, token, &error);
 
     if (!res.has()) {
-        send_response(&error, token, conn, interruptor);
+        send_error(&error, token, conn, interruptor);
     }
     return res;
 }
@@ -205,6 +210,14 @@ void json_protocol_t::send_response(ql::response_t *response,
                                     int64_t token,
                                     tcp_conn_t *conn,
                                     signal_t *interruptor) {
+    send_response_buffered(response, token, conn, interruptor);
+    conn->flush_buffer(interruptor);
+}
+
+void json_protocol_t::send_response_buffered(ql::response_t *response,
+                                             int64_t token,
+                                             tcp_conn_t *conn,
+                                             signal_t *interruptor) {
     uint32_t data_size; // filled in below
     const size_t prefix_size = sizeof(token) + sizeof(data_size);
 
@@ -225,7 +238,7 @@ void json_protocol_t::send_response(ql::response_t *response,
                              Response::RESOURCE_LIMIT,
                              wire_protocol_t::too_large_response_message(payload_size),
                              ql::backtrace_registry_t::EMPTY_BACKTRACE);
-        send_response(response, token, conn, interruptor);
+        send_response_buffered(response, token, conn, interruptor);
         return;
     }
 
@@ -247,6 +260,6 @@ void json_protocol_t::send_response(ql::response_t *response,
             reinterpret_cast<const char *>(&data_size)[i];
     }
 
-    conn->write(buffer.GetString(), buffer.GetSize(), interruptor);
+    conn->write_buffered(buffer.GetString(), buffer.GetSize(), interruptor);
 }
 
@@ -27,6 +27,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/queue/limited_fifo.hpp"
 #include "crypto/error.hpp"
 #include "perfmon/perfmon.hpp"
@@ -192,24 +193,78 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
                                int port,
                                query_handler_t *_handler,
                                uint32_t http_timeout_sec,
-                               tls_ctx_t *_tls_ctx) :
+                               tls_ctx_t *_tls_ctx,
+                               bool reuse_port) :
         tls_ctx(_tls_ctx),
         rdb_ctx(_rdb_ctx),
         handler(_handler),
         http_conn_cache(http_timeout_sec),
+        listener_thread(get_thread_id()),
         next_thread(0) {
     rassert(rdb_ctx != nullptr);
     try {
         tcp_listener.init(new tcp_listener_t(local_addresses, port,
             std::bind(&query_server_t::handle_conn,
-                      this, ph::_1, auto_drainer_t::lock_t(&drainer))));
+                      this, ph::_1, auto_drainer_t::lock_t(&drainer)),
+            reuse_port));
     } catch (const address_in_use_exc_t &ex) {
         throw address_in_use_exc_t(
             strprintf("Could not bind to RDB protocol port: %s", ex.what()));
     }
+    if (reuse_port) {
+        start_thread_listeners(local_addresses);
+    }
+}
+
+query_server_t::~query_server_t() {
+    stop_thread_listeners();
 }
 
-query_server_t::~query_server_t() { }
+void query_server_t::start_thread_listeners(
+        const std::set<ip_address_t> &local_addresses) {
+#ifdef _WIN32
+    // There's no `SO_REUSEPORT` on Windows.
+    (void)local_addresses;
+#else
+    thread_listeners.init(get_num_db_threads());
+    pmap(get_num_db_threads(), [&](int i) {
+        if (threadnum_t(i) == listener_thread) {
+            return;
+        }
+        on_thread_t thread_switcher((threadnum_t(i)));
+        scoped_ptr_t<thread_listener_t> thread_listener(new thread_listener_t);
+        try {
+            thread_listener->listener.init(new tcp_listener_t(
+                local_addresses, tcp_listener->get_port(),
+                std::bind(&query_server_t::handle_conn, this, ph::_1,
+                          auto_drainer_t::lock_t(&thread_listener->drainer)),
+                true));
+        } catch (const address_in_use_exc_t &) {
+            // `SO_REUSEPORT` isn't supported, or something else took the port.
+            return;
+        }
+        thread_listeners[i] = std::move(thread_listener);
+    });
+
+    for (int i = 0; i < get_num_db_threads(); ++i) {
+        if (threadnum_t(i) != listener_thread && !thread_listeners[i].has()) {
+            logWRN("Could not listen for driver connections on every thread; "
+                   "accepting them on a single thread instead.");
+            stop_thread_listeners();
+            return;
+        }
+    }
+#endif
+}
+
+void query_server_t::stop_thread_listeners() {
+    pmap(thread_listeners.size(), [&](int64_t i) {
+        if (thread_listeners[i].has()) {
+            on_thread_t thread_switcher((threadnum_t(i)));
+            thread_listeners[i].reset();
+        }
+    });
+}
 
 int query_server_t::get_port() const {
     return tcp_listener->get_port();
@@ -252,8 +307,13 @@ ql::datum_t read_datum(tcp_conn_t *connection, signal_t *interruptor) {
 
 void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                                  auto_drainer_t::lock_t keepalive) {
-    threadnum_t chosen_thread = threadnum_t(next_thread);
-    next_thread = (next_thread + 1) % get_num_db_threads();
+    /* Connections from the listeners on the other threads stay where they are, since
+    the kernel already spread them out. */
+    threadnum_t chosen_thread = get_thread_id();
+    if (chosen_thread == listener_thread) {
+        chosen_thread = threadnum_t(next_thread);
+        next_thread = (next_thread + 1) % get_num_db_threads();
+    }
 
     cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
     on_thread_t rethreader(chosen_thread);
@@ -273,10 +333,13 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
 
     uint8_t version = 0;
     std::unique_ptr<auth::base_authenticator_t> authenticator;
+    // Negotiated in the `V1_0` handshake: 0 is JSON, 1 is `binary_protocol_t`.
+    int64_t protocol_version = 0;
     uint32_t error_code = 0;
     std::string error_message;
     try {
         conn->enable_keepalive();
+        conn->enable_busy_poll();
 
         int32_t client_magic_number;
         conn->read_buffered(
@@ -367,7 +430,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             {
                 ql::datum_object_builder_t datum_object_builder;
                 datum_object_builder.overwrite("success", ql::datum_t::boolean(true));
-                datum_object_builder.overwrite("max_protocol_version", ql::datum_t(0.0));
+                datum_object_builder.overwrite("max_protocol_version", ql::datum_t(1.0));
                 datum_object_builder.overwrite("min_protocol_version", ql::datum_t(0.0));
                 datum_object_builder.overwrite(
                     "server_version", ql::datum_t(RETHINKDB_VERSION));
@@ -381,13 +444,17 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             {
                 ql::datum_t datum = read_datum(conn.get(), &ct_keepalive);
 
-                ql::datum_t protocol_version =
+                ql::datum_t requested_protocol_version =
                     datum.get_field("protocol_version", ql::NOTHROW);
-                if (protocol_version.get_type() != ql::datum_t::R_NUM) {
+                if (requested_protocol_version.get_type() != ql::datum_t::R_NUM) {
                     throw client_protocol::client_server_error_t(
                         1, "Expected a number for `protocol_version`.");
                 }
-                if (protocol_version.as_num() != 0.0) {
+                if (requested_protocol_version.as_num() == 0.0) {
+                    protocol_version = 0;
+                } else if (requested_protocol_version.as_num() == 1.0) {
+                    protocol_version = 1;
+                } else {
                     throw client_protocol::client_server_error_t(
                         2, "Unsupported `protocol_version`.");
                 }
@@ -459,13 +526,18 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 : ql::return_empty_normal_batches_t::NO,
             auth::user_context_t(authenticator->get_authenticated_username()));
 
-        connection_loop<json_protocol_t>(
-            conn.get(),
-            (version < 4)
-                ? 1
-                : 1024,
-            &query_cache,
-            &ct_keepalive);
+        if (protocol_version == 1) {
+            connection_loop<binary_protocol_t>(
+                conn.get(), 1024, &query_cache, &ct_keepalive);
+        } else {
+            connection_loop<json_protocol_t>(
+                conn.get(),
+                (version < 4)
+                    ? 1
+                    : 1024,
+                &query_cache,
+                &ct_keepalive);
+        }
     } catch (client_protocol::client_server_error_t const &error) {
         // We can't write the response here due to coroutine switching inside an
         // exception handler
@@ -578,6 +650,27 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
     wait_any_t interruptor(drain_signal, &abort);
 #endif  // __linux
 
+    /* Responses that finish while another one is being sent queue up on
+    `send_mutex`. Only the last one in line flushes the connection's write buffer, so
+    a burst of small responses goes out with a single write. */
+    size_t responses_waiting = 0;
+    auto send_response = [&](ql::response_t *response, int64_t token,
+                             signal_t *mutex_interruptor, signal_t *send_interruptor) {
+        ++responses_waiting;
+        scoped_ptr_t<new_mutex_acq_t> send_lock;
+        try {
+            send_lock.init(new new_mutex_acq_t(&send_mutex, mutex_interruptor));
+        } catch (const interrupted_exc_t &) {
+            --responses_waiting;
+            throw;
+        }
+        --responses_waiting;
+        protocol_t::send_response_buffered(response, token, conn, send_interruptor);
+        if (responses_waiting == 0) {
+            conn->flush_buffer(send_interruptor);
+        }
+    };
+
     new_semaphore_t sem(max_concurrent_queries);
     auto_drainer_t coro_drainer;
     while (!err) {
@@ -600,9 +693,8 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                 save_exception(&err, &err_str, &abort, [&]() {
                     handler->run_query(query.get(), &response, &cb_interruptor);
                     if (!query->noreply) {
-                        new_mutex_acq_t send_lock(&send_mutex, &cb_interruptor);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        send_response(&response, query->token,
+                                      &cb_interruptor, &cb_interruptor);
                         replied = true;
                     }
                 });
@@ -610,9 +702,8 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                     if (!replied && !query->noreply) {
                         make_error_response(drain_signal->is_pulsed(), *conn,
                                             err_str, &response);
-                        new_mutex_acq_t send_lock(&send_mutex, drain_signal);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        send_response(&response, query->token,
+                                      drain_signal, &cb_interruptor);
                     }
                 });
             });
@@ -103,7 +103,8 @@ public:
         int port,
         query_handler_t *_handler,
         uint32_t http_timeout_sec,
-        tls_ctx_t* tls_ctx);
+        tls_ctx_t* tls_ctx,
+        bool reuse_port);
     ~query_server_t();
 
     int get_port() const;
@@ -118,6 +119,14 @@ private:
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                      auto_drainer_t::lock_t);
 
+    /* If `reuse_port` was given, this opens another `SO_REUSEPORT` listener for the
+    driver port on every other db thread, so that accepting the connections and their
+    TLS handshakes don't all happen on our thread. If that isn't possible, we keep
+    accepting connections on our thread only and hand them out round-robin. Without
+    `reuse_port` the port isn't shared, so binding it fails if it's already in use. */
+    void start_thread_listeners(const std::set<ip_address_t> &local_addresses);
+    void stop_thread_listeners();
+
     // This is templatized based on the wire protocol requested by the client
     template<class protocol_t>
     void connection_loop(tcp_conn_t *conn,
@@ -139,6 +148,16 @@ private:
     http_conn_cache_t http_conn_cache;
     scoped_ptr_t<tcp_listener_t> tcp_listener;
 
+    // The listeners on the other db threads, which live on their own thread and keep
+    // the connections they accepted there.
+    struct thread_listener_t {
+        auto_drainer_t drainer;
+        scoped_ptr_t<tcp_listener_t> listener;
+    };
+    scoped_array_t<scoped_ptr_t<thread_listener_t> > thread_listeners;
+
+    // The thread of `tcp_listener`, whose connections we hand out round-robin
+    const threadnum_t listener_thread;
     int next_thread;
 };
 
@@ -107,6 +107,7 @@ bool artificial_reql_cluster_interface_t::table_create(
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
         write_durability_t durability,
+        uint32_t block_size,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -124,6 +125,7 @@ bool artificial_reql_cluster_interface_t::table_create(
         config_params,
         primary_key,
         durability,
+        block_size,
         interruptor,
         result_out,
         error_out);
@@ -363,6 +365,7 @@ bool artificial_reql_cluster_interface_t::table_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
         const name_string_t &name,
+        rebalance_mode_t mode,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -374,12 +377,13 @@ bool artificial_reql_cluster_interface_t::table_rebalance(
         return false;
     }
     return next_or_error(error_out) && m_next->table_rebalance(
-        user_context, db, name, interruptor, result_out, error_out);
+        user_context, db, name, mode, interruptor, result_out, error_out);
 }
 
 bool artificial_reql_cluster_interface_t::db_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
+        rebalance_mode_t mode,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -391,7 +395,7 @@ bool artificial_reql_cluster_interface_t::db_rebalance(
         return false;
     }
     return next_or_error(error_out) && m_next->db_rebalance(
-        user_context, db, interruptor, result_out, error_out);
+        user_context, db, mode, interruptor, result_out, error_out);
 }
 
 bool artificial_reql_cluster_interface_t::grant_global(
@@ -85,6 +85,7 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            uint32_t block_size,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -171,12 +172,14 @@ public:
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
             const name_string_t &name,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
     bool db_rebalance(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
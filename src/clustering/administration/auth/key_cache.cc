@@ -0,0 +1,114 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/auth/key_cache.hpp"
+
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/types.hpp"
+#include "clustering/administration/auth/password.hpp"
+#include "clustering/administration/auth/username.hpp"
+#include "containers/lru_cache.hpp"
+#include "crypto/compare_equal.hpp"
+#include "crypto/hash.hpp"
+#include "crypto/hmac.hpp"
+#include "crypto/pbkcs5_pbkdf2_hmac.hpp"
+#include "crypto/random.hpp"
+#include "thread_local.hpp"
+
+namespace auth {
+
+// How many passwords each thread remembers.
+const size_t KEY_CACHE_SIZE = 1000;
+
+struct key_cache_entry_t {
+    // The salted password the entry was derived from.
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash;
+    scram_keys_t scram_keys;
+    // A keyed hash of the last plaintext that `check_plaintext_password()` accepted,
+    // if any.  We don't keep the plaintext itself.
+    bool has_accepted_plaintext;
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> accepted_plaintext;
+};
+
+typedef lru_cache_t<std::string, key_cache_entry_t> key_cache_t;
+
+TLS_with_init(key_cache_t *, key_cache, nullptr);
+
+static std::string key_cache_key(
+        username_t const &username, password_t const &password) {
+    std::string key = username.to_string();
+    key.push_back('\0');
+    key.append(reinterpret_cast<char const *>(password.get_salt().data()),
+               password.get_salt().size());
+    key.append(std::to_string(password.get_iteration_count()));
+    return key;
+}
+
+// Returns the cache entry for `password`, which is created if it's missing or stale.
+static key_cache_entry_t *get_key_cache_entry(
+        username_t const &username, password_t const &password) {
+    key_cache_t *cache = TLS_get_key_cache();
+    if (cache == nullptr) {
+        cache = new key_cache_t(KEY_CACHE_SIZE);
+        TLS_set_key_cache(cache);
+    }
+
+    const std::string key = key_cache_key(username, password);
+    key_cache_entry_t *entry;
+    if (!cache->lookup(key, &entry)) {
+        cache->insert(key, key_cache_entry_t());
+        guarantee(cache->lookup(key, &entry));
+    } else if (entry->hash == password.get_hash()) {
+        return entry;
+    }
+
+    entry->hash = password.get_hash();
+    entry->scram_keys.client_key =
+        crypto::hmac_sha256(password.get_hash(), "Client Key");
+    entry->scram_keys.stored_key = crypto::sha256(entry->scram_keys.client_key);
+    entry->scram_keys.server_key =
+        crypto::hmac_sha256(password.get_hash(), "Server Key");
+    entry->has_accepted_plaintext = false;
+    return entry;
+}
+
+static std::array<unsigned char, SHA256_DIGEST_LENGTH> plaintext_tag(
+        std::string const &plaintext) {
+    // Random for every process, so that the tags are useless outside of it.
+    static const std::array<unsigned char, SHA256_DIGEST_LENGTH> tag_key =
+        crypto::random_bytes<SHA256_DIGEST_LENGTH>();
+    return crypto::hmac_sha256(tag_key, plaintext);
+}
+
+scram_keys_t get_scram_keys(username_t const &username, password_t const &password) {
+    return get_key_cache_entry(username, password)->scram_keys;
+}
+
+bool check_plaintext_password(
+        username_t const &username,
+        password_t const &password,
+        std::string const &plaintext) {
+    const std::array<unsigned char, SHA256_DIGEST_LENGTH> tag = plaintext_tag(plaintext);
+    {
+        key_cache_entry_t *entry = get_key_cache_entry(username, password);
+        if (entry->has_accepted_plaintext &&
+                crypto::compare_equal(entry->accepted_plaintext, tag)) {
+            return true;
+        }
+    }
+
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        hash = crypto::pbkcs5_pbkdf2_hmac_sha256(
+            plaintext, password.get_salt(), password.get_iteration_count());
+    });
+    if (!crypto::compare_equal(password.get_hash(), hash)) {
+        return false;
+    }
+
+    // We may have waited for the blocker pool, so the entry has to be looked up again.
+    key_cache_entry_t *entry = get_key_cache_entry(username, password);
+    entry->has_accepted_plaintext = true;
+    entry->accepted_plaintext = tag;
+    return true;
+}
+
+}  // namespace auth
@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_AUTH_KEY_CACHE_HPP
+#define CLUSTERING_ADMINISTRATION_AUTH_KEY_CACHE_HPP
+
+#include <openssl/sha.h>
+
+#include <array>
+#include <string>
+
+namespace auth {
+
+class password_t;
+class username_t;
+
+struct scram_keys_t {
+    // ClientKey := HMAC(SaltedPassword, "Client Key")
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> client_key;
+    // StoredKey := H(ClientKey)
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> stored_key;
+    // ServerKey := HMAC(SaltedPassword, "Server Key")
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> server_key;
+};
+
+/* When many clients reconnect at once, they all log in as the same few users.  These
+functions remember what they derived from a user's password in a cache per thread,
+keyed on the user, the salt and the iteration count.  Changing a password always
+generates a new salt, and an entry is also checked against the salted password, so an
+old password never matches after a change. */
+
+// Returns the SCRAM keys for `password`.
+scram_keys_t get_scram_keys(username_t const &username, password_t const &password);
+
+// Returns whether `plaintext` (after SASLprep) is `password`.  Unless this thread has
+// accepted the same plaintext for the same password before, this runs PBKDF2, which
+// is slow on purpose, in the blocker pool, so it doesn't hold up the thread.  Wrong
+// passwords are never cached.  Must be called in a coroutine.
+bool check_plaintext_password(
+        username_t const &username,
+        password_t const &password,
+        std::string const &plaintext);
+
+}  // namespace auth
+
+#endif  // CLUSTERING_ADMINISTRATION_AUTH_KEY_CACHE_HPP
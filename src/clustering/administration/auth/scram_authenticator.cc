@@ -2,11 +2,11 @@
 #include "clustering/administration/auth/scram_authenticator.hpp"
 
 #include "clustering/administration/auth/authentication_error.hpp"
+#include "clustering/administration/auth/key_cache.hpp"
 #include "clustering/administration/auth/password.hpp"
 #include "clustering/administration/auth/username.hpp"
 #include "crypto/base64.hpp"
 #include "crypto/error.hpp"
-#include "crypto/hash.hpp"
 #include "crypto/hmac.hpp"
 #include "crypto/random.hpp"
 
@@ -85,13 +85,12 @@ std::string scram_authenticator_t::next_message(std::string const &message)
                     throw authentication_error_t(17, "Unknown user");
                 }
 
-                // ClientKey := HMAC(SaltedPassword, "Client Key")
-                std::array<unsigned char, SHA256_DIGEST_LENGTH> client_key =
-                    crypto::hmac_sha256(m_password.get_hash(), "Client Key");
-
-                // StoredKey := H(ClientKey)
-                std::array<unsigned char, SHA256_DIGEST_LENGTH> stored_key =
-                    crypto::sha256(client_key);
+                // ClientKey, StoredKey and ServerKey only depend on the password.
+                scram_keys_t keys = get_scram_keys(m_username, m_password);
+                std::array<unsigned char, SHA256_DIGEST_LENGTH> const &client_key =
+                    keys.client_key;
+                std::array<unsigned char, SHA256_DIGEST_LENGTH> const &stored_key =
+                    keys.stored_key;
 
                 /* AuthMessage := client-first-message-bare + "," +
                                   server-first-message + "," +
@@ -144,13 +143,9 @@ std::string scram_authenticator_t::next_message(std::string const &message)
                     throw authentication_error_t(10, "Invalid encoding");
                 }
 
-                // ServerKey := HMAC(SaltedPassword, "Server Key")
-                std::array<unsigned char, SHA256_DIGEST_LENGTH> server_key =
-                    crypto::hmac_sha256(m_password.get_hash(), "Server Key");
-
                 // ServerSignature := HMAC(ServerKey, AuthMessage)
                 std::array<unsigned char, SHA256_DIGEST_LENGTH> server_signature =
-                    crypto::hmac_sha256(server_key, auth_message);
+                    crypto::hmac_sha256(keys.server_key, auth_message);
 
                 return "v=" + crypto::base64_encode(server_signature);
             }
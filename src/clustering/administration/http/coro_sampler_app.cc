@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/coro_sampler_app.hpp"
+
+#include <inttypes.h>
+
+#include <string>
+
+#include "arch/runtime/coro_sampler.hpp"
+#include "utils.hpp"
+
+// Sampling one in this many waits keeps the overhead negligible even on a busy
+// server.
+const int64_t CORO_SAMPLER_DEFAULT_INTERVAL = 100;
+
+void coro_sampler_http_app_t::handle(const http_req_t &req,
+                                     http_res_t *result,
+                                     UNUSED signal_t *interruptor) {
+    coro_sampler_t *sampler = &coro_sampler_t::get_global_sampler();
+
+    if (req.method == http_method_t::GET) {
+        *result = http_res_t(http_status_code_t::OK, "text/plain",
+                             sampler->get_folded_stacks());
+        return;
+    } else if (req.method != http_method_t::POST) {
+        *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+        return;
+    }
+
+    const optional<std::string> action = req.find_query_param("action");
+    if (action && *action == "start") {
+        int64_t interval = CORO_SAMPLER_DEFAULT_INTERVAL;
+        const optional<std::string> interval_param = req.find_query_param("interval");
+        if (interval_param
+            && (!strtoi64_strict(*interval_param, 10, &interval) || interval < 1)) {
+            *result = http_error_res("`interval` must be a positive integer.");
+            return;
+        }
+        sampler->start(interval);
+        *result = http_res_t(http_status_code_t::OK, "text/plain",
+            strprintf("Sampling every %" PRIi64 " waits.\n", interval));
+    } else if (action && *action == "stop") {
+        sampler->stop();
+        *result = http_res_t(http_status_code_t::OK, "text/plain",
+                             "Stopped sampling.\n");
+    } else {
+        *result = http_error_res("`action` must be `start` or `stop`.");
+    }
+}
@@ -0,0 +1,19 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_CORO_SAMPLER_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_CORO_SAMPLER_APP_HPP_
+
+#include "http/http.hpp"
+
+/* This is an `http_app_t` that controls the `coro_sampler_t`.
+
+    GET  returns what the sampler has collected, in the folded format of
+         flamegraph.pl (e.g. `curl host:8080/ajax/coro_sampler | flamegraph.pl`).
+    POST with `action=start` starts sampling every `interval`th wait (100 by default),
+         and drops the samples collected so far.
+    POST with `action=stop` stops sampling, but keeps the samples around. */
+class coro_sampler_http_app_t : public http_app_t {
+public:
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_CORO_SAMPLER_APP_HPP_ */
@@ -0,0 +1,17 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/metrics_app.hpp"
+
+#include "perfmon/collect.hpp"
+#include "perfmon/openmetrics.hpp"
+
+void metrics_http_app_t::handle(const http_req_t &req,
+                                http_res_t *result,
+                                UNUSED signal_t *interruptor) {
+    if (req.method != http_method_t::GET) {
+        *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+        return;
+    }
+    *result = http_res_t(http_status_code_t::OK,
+                         "application/openmetrics-text; version=1.0.0; charset=utf-8",
+                         perfmon_stats_to_openmetrics(perfmon_get_stats()));
+}
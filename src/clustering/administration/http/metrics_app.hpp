@@ -0,0 +1,15 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_
+
+#include "http/http.hpp"
+
+/* This is an `http_app_t` that serves the stats of this server (and only this server)
+in the OpenMetrics text format, for Prometheus to scrape at `/metrics`. Unlike the
+`stats` table, it doesn't contact the other servers in the cluster. */
+class metrics_http_app_t : public http_app_t {
+public:
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_ */
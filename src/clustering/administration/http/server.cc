@@ -1,7 +1,9 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/administration/http/server.hpp"
 
+#include "clustering/administration/http/coro_sampler_app.hpp"
 #include "clustering/administration/http/cyanide.hpp"
+#include "clustering/administration/http/metrics_app.hpp"
 #include "http/file_app.hpp"
 #include "http/http.hpp"
 #include "http/routing_app.hpp"
@@ -16,6 +18,8 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
 {
 
     file_app.init(new file_http_app_t(path));
+    coro_sampler_app.init(new coro_sampler_http_app_t);
+    metrics_app.init(new metrics_http_app_t);
 
 #ifndef NDEBUG
     cyanide_app.init(new cyanide_http_app_t);
@@ -23,11 +27,13 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
 
     std::map<std::string, http_app_t *> ajax_routes;
     ajax_routes["reql"] = reql_app;
+    ajax_routes["coro_sampler"] = coro_sampler_app.get();
     DEBUG_ONLY_CODE(ajax_routes["cyanide"] = cyanide_app.get());
     ajax_routing_app.init(new routing_http_app_t(nullptr, ajax_routes));
 
     std::map<std::string, http_app_t *> root_routes;
     root_routes["ajax"] = ajax_routing_app.get();
+    root_routes["metrics"] = metrics_app.get();
     root_routing_app.init(new routing_http_app_t(file_app.get(), root_routes));
 
     server.init(new http_server_t(tls_ctx, local_addresses, port, root_routing_app.get()));
@@ -65,20 +65,21 @@ RDB_IMPL_EQUALITY_COMPARABLE_3(memory_issue_t,
 
 std::vector<memory_issue_t> memory_issue_tracker_t::get_issues() {
     std::vector<memory_issue_t> issues;
-    if (static_cast<bool>(error_message)) {
-        issues.push_back(memory_issue_t(*error_message));
+    for (const auto &pair : error_messages) {
+        issues.push_back(memory_issue_t(pair.second));
     }
     return issues;
 }
 
-void memory_issue_tracker_t::report_success() {
+void memory_issue_tracker_t::report_success(memory_issue_source_t source) {
     assert_thread();
-    error_message = r_nullopt;
+    error_messages.erase(source);
 }
 
-void memory_issue_tracker_t::report_error(const std::string &message) {
+void memory_issue_tracker_t::report_error(memory_issue_source_t source,
+                                          const std::string &message) {
     assert_thread();
-    error_message = make_optional(message);
+    error_messages[source] = message;
 }
 
 void memory_issue_tracker_t::combine(
@@ -2,6 +2,7 @@
 #ifndef CLUSTERING_ADMINISTRATION_ISSUES_MEMORY_HPP_
 #define CLUSTERING_ADMINISTRATION_ISSUES_MEMORY_HPP_
 
+#include <map>
 #include <string>
 
 #include "clustering/administration/issues/issue.hpp"
@@ -42,6 +43,13 @@ private:
 RDB_DECLARE_SERIALIZABLE(memory_issue_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(memory_issue_t);
 
+// The checks that can report a memory issue.  Each of them has at most one issue at a
+// time.
+enum class memory_issue_source_t {
+    swap,
+    buf_arena
+};
+
 class memory_issue_tracker_t :
     public home_thread_mixin_t {
 public:
@@ -49,8 +57,8 @@ public:
 
     std::vector<memory_issue_t> get_issues();
 
-    void report_success();
-    void report_error(const std::string &message);
+    void report_success(memory_issue_source_t source);
+    void report_error(memory_issue_source_t source, const std::string &message);
 
     static void combine(std::vector<memory_issue_t> &&issues,
                         std::vector<scoped_ptr_t<issue_t> > *issues_out);
@@ -58,7 +66,7 @@ public:
 private:
     void do_update();
 
-    optional<std::string> error_message;
+    std::map<memory_issue_source_t, std::string> error_messages;
 
     DISABLE_COPYING(memory_issue_tracker_t);
 };
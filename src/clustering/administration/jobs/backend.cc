@@ -52,6 +52,7 @@ void insert_or_merge_jobs(std::vector<T> const &jobs, std::map<uuid_u, T> *jobs_
 template <typename T>
 void jobs_to_datums(
         std::map<uuid_u, T> const &jobs,
+        const ql::datumspec_t *datumspec,
         admin_identifier_format_t identifier_format,
         server_config_client_t *server_config_client,
         table_meta_client_t *table_meta_client,
@@ -59,6 +60,12 @@ void jobs_to_datums(
         std::map<uuid_u, ql::datum_t> *jobs_out) {
     ql::datum_t job_out;
     for (auto const &job : jobs) {
+        // Building the row looks up server and table names, so we skip it for the jobs
+        // that weren't asked for.
+        if (datumspec != nullptr && datumspec->copies(
+                convert_job_type_and_id_to_datum(job.second.type, job.first)) == 0) {
+            continue;
+        }
         if (job.second.to_datum(identifier_format, server_config_client,
                 table_meta_client, metadata, &job_out)) {
             jobs_out->insert(std::make_pair(job.first, std::move(job_out)));
@@ -68,6 +75,7 @@ void jobs_to_datums(
 
 void jobs_artificial_table_backend_t::get_all_job_reports(
         auth::user_context_t const &user_context,
+        const ql::datumspec_t *datumspec,
         signal_t *interruptor,
         std::map<uuid_u, ql::datum_t> *jobs_out) {
     assert_thread();  // Accessing `directory_view`
@@ -129,14 +137,14 @@ void jobs_artificial_table_backend_t::get_all_job_reports(
     }
 
     cluster_semilattice_metadata_t metadata = semilattice_view->get();
-    jobs_to_datums(query_jobs_map, identifier_format, server_config_client,
-        table_meta_client, metadata, jobs_out);
-    jobs_to_datums(disk_compaction_jobs_map, identifier_format, server_config_client,
-        table_meta_client, metadata, jobs_out);
-    jobs_to_datums(index_construction_jobs_map, identifier_format, server_config_client,
-        table_meta_client, metadata, jobs_out);
-    jobs_to_datums(backfill_jobs_map, identifier_format, server_config_client,
-        table_meta_client, metadata, jobs_out);
+    jobs_to_datums(query_jobs_map, datumspec, identifier_format,
+        server_config_client, table_meta_client, metadata, jobs_out);
+    jobs_to_datums(disk_compaction_jobs_map, datumspec, identifier_format,
+        server_config_client, table_meta_client, metadata, jobs_out);
+    jobs_to_datums(index_construction_jobs_map, datumspec, identifier_format,
+        server_config_client, table_meta_client, metadata, jobs_out);
+    jobs_to_datums(backfill_jobs_map, datumspec, identifier_format,
+        server_config_client, table_meta_client, metadata, jobs_out);
 }
 
 bool jobs_artificial_table_backend_t::read_all_rows_as_vector(
@@ -152,6 +160,33 @@ bool jobs_artificial_table_backend_t::read_all_rows_as_vector(
     std::map<uuid_u, ql::datum_t> job_reports;
     get_all_job_reports(
         user_context,
+        nullptr,
+        &interruptor_on_home,
+        &job_reports);
+
+    rows_out->reserve(job_reports.size());
+    for (auto &&job_report : job_reports) {
+        rows_out->push_back(std::move(job_report.second));
+    }
+
+    return true;
+}
+
+bool jobs_artificial_table_backend_t::read_rows_in_datumspec(
+        auth::user_context_t const &user_context,
+        const ql::datumspec_t &datumspec,
+        signal_t *interruptor_on_caller,
+        std::vector<ql::datum_t> *rows_out,
+        UNUSED admin_err_t *error_out) {
+    rows_out->clear();
+
+    cross_thread_signal_t interruptor_on_home(interruptor_on_caller, home_thread());
+    on_thread_t rethreader(home_thread());
+
+    std::map<uuid_u, ql::datum_t> job_reports;
+    get_all_job_reports(
+        user_context,
+        datumspec.is_universe() ? nullptr : &datumspec,
         &interruptor_on_home,
         &job_reports);
 
@@ -177,9 +212,11 @@ bool jobs_artificial_table_backend_t::read_row(
     std::string job_type;
     uuid_u job_id;
     if (convert_job_type_and_id_from_datum(primary_key, &job_type, &job_id)) {
+        ql::datumspec_t datumspec((ql::datum_range_t(primary_key)));
         std::map<uuid_u, ql::datum_t> job_reports;
         get_all_job_reports(
             user_context,
+            &datumspec,
             &interruptor_on_home,
             &job_reports);
 
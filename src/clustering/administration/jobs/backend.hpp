@@ -54,8 +54,18 @@ public:
             admin_err_t *error_out);
 
 private:
+    bool read_rows_in_datumspec(
+            auth::user_context_t const &user_context,
+            const ql::datumspec_t &datumspec,
+            signal_t *interruptor,
+            std::vector<ql::datum_t> *rows_out,
+            admin_err_t *error_out);
+
+    /* Only converts the jobs whose primary keys are in `datumspec` to datums, or every
+    job if `datumspec` is `nullptr`. */
     void get_all_job_reports(
             auth::user_context_t const &user_context,
+            const ql::datumspec_t *datumspec,
             signal_t *interruptor,
             std::map<uuid_u, ql::datum_t> *jobs_out);
 
@@ -92,7 +92,7 @@ void jobs_manager_t::on_get_job_reports(
 
                     std::string render = pprint::pretty_print_as_js(
                         printed_query_columns,
-                        pair.second->term_storage->root_term());
+                        pair.second->compiled_query->term_storage->root_term());
 
                     query_job_reports_inner.emplace_back(
                         pair.second->job_id,
@@ -100,7 +100,8 @@ void jobs_manager_t::on_get_job_reports(
                         server_id,
                         query_cache->get_client_addr_port(),
                         std::move(render),
-                        query_cache->get_user_context());
+                        query_cache->get_user_context(),
+                        pair.second->usage);
                 }
             }
         }
@@ -135,6 +136,9 @@ void jobs_manager_t::on_get_job_reports(
                 double duration = status.second.second.ready
                     ? 0.0
                     : time - std::min<double>(status.second.second.start_time, time);
+                double rows_per_second = duration > 0.0
+                    ? status.second.second.rows_constructed / (duration / 1e6)
+                    : 0.0;
 
                 index_construction_job_reports.emplace_back(
                     id,
@@ -144,7 +148,8 @@ void jobs_manager_t::on_get_job_reports(
                     status.first,
                     status.second.second.ready,
                     status.second.second.progress_numerator,
-                    status.second.second.progress_denominator);
+                    status.second.second.progress_denominator,
+                    rows_per_second);
             }
 
             std::map<region_t, backfill_progress_tracker_t::progress_tracker_t> backfills =
@@ -160,6 +165,9 @@ void jobs_manager_t::on_get_job_reports(
                 double duration = backfill.second.is_ready
                     ? 0.0
                     : time - std::min<double>(backfill.second.start_time, time);
+                double bytes_per_second = duration > 0.0
+                    ? backfill.second.bytes_received / (duration / 1e6)
+                    : 0.0;
 
                 backfill_job_reports.emplace_back(
                     id,
@@ -168,6 +176,7 @@ void jobs_manager_t::on_get_job_reports(
                     table_id,
                     backfill.second.is_ready,
                     backfill.second.progress,
+                    bytes_per_second,
                     backfill.second.source_server_id,
                     server_id);
             }
@@ -55,6 +55,7 @@ backfill_job_report_t::backfill_job_report_t(
         namespace_id_t const &_table,
         bool _is_ready,
         double _progress,
+        double _bytes_per_second,
         server_id_t const &_source_server,
         server_id_t const &_destination_server)
     : job_report_base_t<backfill_job_report_t>("backfill", _id, _duration, _server_id),
@@ -62,6 +63,7 @@ backfill_job_report_t::backfill_job_report_t(
       is_ready(_is_ready),
       progress_numerator(_progress),
       progress_denominator(1.0),
+      bytes_per_second(_bytes_per_second),
       source_server(_source_server),
       destination_server(_destination_server) {
     servers.insert({source_server, destination_server});
@@ -72,6 +74,8 @@ void backfill_job_report_t::merge_derived(
     is_ready &= job_report.is_ready;
     progress_numerator += job_report.progress_numerator;
     progress_denominator += job_report.progress_denominator;
+    // The shards of a table are backfilled at the same time.
+    bytes_per_second += job_report.bytes_per_second;
 }
 
 bool backfill_job_report_t::info_derived(
@@ -127,11 +131,12 @@ bool backfill_job_report_t::info_derived(
 
     info_builder_out->overwrite("progress",
         ql::datum_t(progress_numerator / progress_denominator));
+    info_builder_out->overwrite("bytes_per_second", ql::datum_t(bytes_per_second));
 
     return true;
 }
 
-RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(
+RDB_IMPL_SERIALIZABLE_11_FOR_CLUSTER(
     backfill_job_report_t,
     type,
     id,
@@ -141,6 +146,7 @@ RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(
     is_ready,
     progress_numerator,
     progress_denominator,
+    bytes_per_second,
     source_server,
     destination_server);
 
@@ -155,20 +161,24 @@ index_construction_job_report_t::index_construction_job_report_t(
         std::string const &_index,
         bool _is_ready,
         double _progress_numerator,
-        double _progress_denominator)
+        double _progress_denominator,
+        double _rows_per_second)
     : job_report_base_t<index_construction_job_report_t>(
         "index_construction", _id, _duration, _server_id),
       table(_table),
       index(_index),
       is_ready(_is_ready),
       progress_numerator(_progress_numerator),
-      progress_denominator(_progress_denominator) { }
+      progress_denominator(_progress_denominator),
+      rows_per_second(_rows_per_second) { }
 
 void index_construction_job_report_t::merge_derived(
        index_construction_job_report_t const &job_report) {
     is_ready &= job_report.is_ready;
     progress_numerator += job_report.progress_numerator;
     progress_denominator += job_report.progress_denominator;
+    // The servers construct their parts of the index at the same time.
+    rows_per_second += job_report.rows_per_second;
 }
 
 bool index_construction_job_report_t::info_derived(
@@ -202,11 +212,12 @@ bool index_construction_job_report_t::info_derived(
         ql::datum_t(progress_denominator == 0
             ? 0
             : progress_numerator / progress_denominator));
+    info_builder_out->overwrite("rows_per_second", ql::datum_t(rows_per_second));
 
     return true;
 }
 
-RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
+RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(
     index_construction_job_report_t,
     type,
     id,
@@ -216,10 +227,16 @@ RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
     index,
     is_ready,
     progress_numerator,
-    progress_denominator);
+    progress_denominator,
+    rows_per_second);
 
 query_job_report_t::query_job_report_t()
-    : job_report_base_t<query_job_report_t>() { }
+    : job_report_base_t<query_job_report_t>(),
+      reads(0),
+      writes(0),
+      rows_scanned(0),
+      rows_written(0),
+      active_micros(0) { }
 
 query_job_report_t::query_job_report_t(
         uuid_u const &_id,
@@ -227,11 +244,17 @@ query_job_report_t::query_job_report_t(
         server_id_t const &_server_id,
         ip_and_port_t const &_client_addr_port,
         std::string const &_query,
-        auth::user_context_t const &_user_context)
+        auth::user_context_t const &_user_context,
+        ql::query_usage_t const &_usage)
     : job_report_base_t<query_job_report_t>("query", _id, _duration, _server_id),
       client_addr_port(_client_addr_port),
       query(_query),
-      user_context(_user_context) { }
+      user_context(_user_context),
+      reads(_usage.reads),
+      writes(_usage.writes),
+      rows_scanned(_usage.rows_scanned),
+      rows_written(_usage.rows_written),
+      active_micros(_usage.active_micros) { }
 
 void query_job_report_t::merge_derived(query_job_report_t const &) { }
 
@@ -248,12 +271,21 @@ bool query_job_report_t::info_derived(
     info_builder_out->overwrite("query", convert_string_to_datum(query));
     info_builder_out->overwrite(
         "user", convert_string_to_datum(user_context.to_string()));
+    info_builder_out->overwrite("reads", ql::datum_t(static_cast<double>(reads)));
+    info_builder_out->overwrite("writes", ql::datum_t(static_cast<double>(writes)));
+    info_builder_out->overwrite(
+        "rows_scanned", ql::datum_t(static_cast<double>(rows_scanned)));
+    info_builder_out->overwrite(
+        "rows_written", ql::datum_t(static_cast<double>(rows_written)));
+    info_builder_out->overwrite(
+        "active_duration_sec", ql::datum_t(active_micros / 1e6));
 
     return true;
 }
 
-RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
-    query_job_report_t, type, id, duration, servers, client_addr_port, query, user_context);
+RDB_IMPL_SERIALIZABLE_12_FOR_CLUSTER(
+    query_job_report_t, type, id, duration, servers, client_addr_port, query,
+    user_context, reads, writes, rows_scanned, rows_written, active_micros);
 
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(jobs_manager_business_card_t,
                                     get_job_reports_mailbox_address,
@@ -12,6 +12,7 @@
 #include "containers/archive/stl_types.hpp"
 #include "containers/uuid.hpp"
 #include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/query_usage.hpp"
 #include "rpc/serialize_macros.hpp"
 #include "time.hpp"
 
@@ -59,6 +60,7 @@ public:
             namespace_id_t const &table,
             bool is_ready,
             double progress,
+            double bytes_per_second,
             server_id_t const &source_server,
             server_id_t const &destination_server);
 
@@ -75,6 +77,7 @@ public:
     bool is_ready;
     double progress_numerator;
     double progress_denominator;
+    double bytes_per_second;
     server_id_t source_server;
     server_id_t destination_server;
 };
@@ -112,7 +115,8 @@ public:
             std::string const &index,
             bool is_ready,
             double progress_numerator,
-            double progress_denominator);
+            double progress_denominator,
+            double rows_per_second);
 
     void merge_derived(index_construction_job_report_t const &job_report);
 
@@ -128,6 +132,7 @@ public:
     bool is_ready;
     double progress_numerator;
     double progress_denominator;
+    double rows_per_second;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(index_construction_job_report_t);
 
@@ -140,7 +145,8 @@ public:
             server_id_t const &server_id,
             ip_and_port_t const &client_addr_port,
             std::string const &query,
-            auth::user_context_t const &user_context);
+            auth::user_context_t const &user_context,
+            ql::query_usage_t const &usage);
 
     void merge_derived(query_job_report_t const &job_report);
 
@@ -154,6 +160,11 @@ public:
     ip_and_port_t client_addr_port;
     std::string query;
     auth::user_context_t user_context;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t rows_scanned;
+    uint64_t rows_written;
+    uint64_t active_micros;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(query_job_report_t);
 
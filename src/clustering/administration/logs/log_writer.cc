@@ -5,9 +5,13 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <stdarg.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <limits>
+
 #ifdef _WIN32
 #include <io.h>
 #endif
@@ -16,6 +20,7 @@
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk.hpp"
 #include "concurrency/promise.hpp"
+#include "config/args.hpp"
 #include "containers/scoped.hpp"
 #include "thread_local.hpp"
 
@@ -238,10 +243,10 @@ void throw_unless(bool condition, const std::string &where) {
     }
 }
 
-file_reverse_reader_t::file_reverse_reader_t(scoped_fd_t &&_fd) :
+file_reverse_reader_t::file_reverse_reader_t(scoped_fd_t &&_fd, int64_t end) :
         fd(std::move(_fd)),
         current_chunk(chunk_size) {
-    int64_t fd_filesize = get_file_size(fd.get());
+    int64_t fd_filesize = end == -1 ? get_file_size(fd.get()) : end;
     if (fd_filesize == 0) {
         remaining_in_current_chunk = current_chunk_start = 0;
     } else {
@@ -309,6 +314,81 @@ bool file_reverse_reader_t::read_chunk() {
     return true;
 }
 
+/* Next to the log file we keep a sparse index of it in `<log file>.index`. It's an
+array of `log_index_entry_t`s, one for about every `LOG_TIME_INDEX_INTERVAL_BYTES` of
+log, each giving the timestamp of the line that starts at `offset`. Timestamps in the
+log only ever go up, so a read with a `max_timestamp` can start at the first indexed
+line that's newer than that instead of at the end of the file. The index is only a
+hint: the reader checks the line that it points to, and reads the whole file if the
+index doesn't match it. */
+struct log_index_entry_t {
+    int64_t tv_sec;
+    int64_t tv_nsec;
+    int64_t offset;
+};
+
+std::string log_index_path(const base_path_t &log_path) {
+    return log_path.path() + ".index";
+}
+
+#ifndef _WIN32
+/* Returns the offset of the first line of the log file that the index says is newer
+than `max_timestamp`, or -1 if the index can't tell. */
+int64_t find_log_end_in_index(int log_fd, const base_path_t &log_path,
+                              struct timespec max_timestamp) {
+    scoped_fd_t index_fd;
+    do {
+        index_fd.reset(open(log_index_path(log_path).c_str(), O_RDONLY));
+    } while (index_fd.get() == INVALID_FD && get_errno() == EINTR);
+    if (index_fd.get() == INVALID_FD) {
+        return -1;
+    }
+    int64_t index_size = get_file_size(index_fd.get());
+    if (index_size == 0 || index_size % sizeof(log_index_entry_t) != 0) {
+        return -1;
+    }
+    std::vector<log_index_entry_t> entries(index_size / sizeof(log_index_entry_t));
+    if (pread(index_fd.get(), entries.data(), index_size, 0) != index_size) {
+        return -1;
+    }
+
+    auto it = std::upper_bound(entries.begin(), entries.end(), max_timestamp,
+        [](const struct timespec &t, const log_index_entry_t &e) {
+            return t.tv_sec < e.tv_sec
+                || (t.tv_sec == e.tv_sec && t.tv_nsec < e.tv_nsec);
+        });
+    if (it == entries.end() || it->offset < 0 || it->offset > get_file_size(log_fd)) {
+        return -1;
+    }
+    if (it->offset == 0) {
+        return 0;
+    }
+
+    /* Make sure that the line still is where the index says it is. The log file might
+    have been truncated or replaced since the index was written. */
+    scoped_array_t<char> buf(4096);
+    ssize_t res = pread(log_fd, buf.data(), buf.size(), it->offset - 1);
+    if (res <= 0 || buf[0] != '\n') {
+        return -1;
+    }
+    const char *line_end =
+        static_cast<const char *>(memchr(buf.data() + 1, '\n', res - 1));
+    if (line_end == nullptr) {
+        return -1;
+    }
+    try {
+        log_message_t lm = parse_log_message(
+            std::string(buf.data() + 1, line_end - (buf.data() + 1)));
+        if (lm.timestamp.tv_sec != it->tv_sec || lm.timestamp.tv_nsec != it->tv_nsec) {
+            return -1;
+        }
+    } catch (const log_read_exc_t &) {
+        return -1;
+    }
+    return it->offset;
+}
+#endif
+
 /* Most of the logging we do will be through thread_pool_log_writer_t. However,
 thread_pool_log_writer_t depends on the existence of a thread pool, which is
 not always the case. Thus, fallback_log_writer_t exists to perform logging
@@ -329,6 +409,11 @@ private:
 
     bool write(const log_message_t &msg, std::string *error_out);
     void initiate_write(log_level_t level, const std::string &message);
+#ifndef _WIN32
+    void open_index();
+    // Called with the log file locked, after writing the line at `line_offset`.
+    void update_index(const struct timespec &timestamp, int64_t line_offset);
+#endif
     base_path_t filename;
     struct timespec uptime_reference;
     struct timespec last_msg_timestamp;
@@ -338,6 +423,9 @@ private:
     // TODO WINDOWS: log locking
 #else
     struct flock filelock, fileunlock;
+    scoped_fd_t index_fd;
+    // The offset of the line that the last index entry points to, or -1.
+    int64_t last_indexed_offset;
 #endif
     scoped_fd_t fd;
 
@@ -350,6 +438,8 @@ fallback_log_writer_t::fallback_log_writer_t() :
     last_msg_timestamp = clock_realtime();
 
 #ifndef _WIN32
+    last_indexed_offset = -1;
+
     filelock.l_type = F_WRLCK;
     filelock.l_whence = SEEK_SET;
     filelock.l_start = 0;
@@ -396,6 +486,10 @@ void fallback_log_writer_t::install(const std::string &logfile_name) {
     //  the working directory changes
     filename.make_absolute();
 
+#ifndef _WIN32
+    open_index();
+#endif
+
     // For the case that the log file was newly created,
     // call fsync() on the parent directory to guarantee that its
     // directory entry is persisted to disk.
@@ -409,6 +503,65 @@ void fallback_log_writer_t::install(const std::string &logfile_name) {
     }
 }
 
+#ifndef _WIN32
+void fallback_log_writer_t::open_index() {
+    /* Without the index reads just go through the whole log file, so we don't treat
+    any of the errors here as fatal. */
+    int res;
+    do {
+        res = open(log_index_path(filename).c_str(), O_RDWR|O_APPEND|O_CREAT, 0644);
+    } while (res == INVALID_FD && get_errno() == EINTR);
+    index_fd.reset(res);
+    if (index_fd.get() == INVALID_FD) {
+        return;
+    }
+
+    /* Pick up where the index left off, unless it doesn't fit the log file anymore. */
+    int64_t index_size = get_file_size(index_fd.get());
+    log_index_entry_t last;
+    if (index_size != 0
+            && index_size % sizeof(last) == 0
+            && pread(index_fd.get(), &last, sizeof(last), index_size - sizeof(last))
+                == static_cast<ssize_t>(sizeof(last))
+            && last.offset >= 0
+            && last.offset < get_file_size(fd.get())) {
+        last_indexed_offset = last.offset;
+    } else if (index_size != 0 && ftruncate(index_fd.get(), 0) != 0) {
+        index_fd.reset();
+    }
+}
+
+void fallback_log_writer_t::update_index(
+        const struct timespec &timestamp, int64_t line_offset) {
+    if (line_offset < last_indexed_offset) {
+        /* Someone truncated the log file, so the index is about lines that aren't
+        there anymore. */
+        if (ftruncate(index_fd.get(), 0) != 0) {
+            index_fd.reset();
+            return;
+        }
+        last_indexed_offset = -1;
+    }
+    if (last_indexed_offset != -1
+            && line_offset - last_indexed_offset < LOG_TIME_INDEX_INTERVAL_BYTES) {
+        return;
+    }
+    log_index_entry_t entry;
+    entry.tv_sec = timestamp.tv_sec;
+    entry.tv_nsec = timestamp.tv_nsec;
+    entry.offset = line_offset;
+    ssize_t res = ::write(index_fd.get(), &entry, sizeof(entry));
+    if (res == static_cast<ssize_t>(sizeof(entry))) {
+        last_indexed_offset = line_offset;
+    } else if (res > 0 && ftruncate(index_fd.get(), 0) == 0) {
+        // A partial entry would make the reader ignore the whole index.
+        last_indexed_offset = -1;
+    } else if (res > 0) {
+        index_fd.reset();
+    }
+}
+#endif
+
 log_message_t fallback_log_writer_t::assemble_log_message(
         log_level_t level, const std::string &m) {
     struct timespec timestamp = clock_realtime();
@@ -509,11 +662,16 @@ bool fallback_log_writer_t::write(const log_message_t &msg, std::string *error_o
         return false;
     }
 #else
+    int64_t line_offset =
+        index_fd.get() == INVALID_FD ? -1 : lseek(fd.get(), 0, SEEK_END);
     ssize_t write_res = ::write(fd.get(), formatted.data(), formatted.length());
     if (write_res != static_cast<ssize_t>(formatted.length())) {
         error_out->assign("cannot write to log file: " + errno_string(get_errno()));
         return false;
     }
+    if (line_offset != -1) {
+        update_index(msg.timestamp, line_offset);
+    }
 #endif
 
 #ifndef _WIN32
@@ -658,7 +816,16 @@ void thread_pool_log_writer_t::tail_blocking(
             strprintf("could not open '%s' for reading.",
                 fallback_log_writer.filename.path().c_str()));
 
-        file_reverse_reader_t reader(std::move(fd));
+        /* Lines that are newer than `max_timestamp` don't count towards
+        `max_lines`, so skipping them with the index doesn't change the result. */
+        int64_t end = -1;
+#ifndef _WIN32
+        if (max_timestamp.tv_sec != std::numeric_limits<time_t>::max()) {
+            end = find_log_end_in_index(
+                fd.get(), fallback_log_writer.filename, max_timestamp);
+        }
+#endif
+        file_reverse_reader_t reader(std::move(fd), end);
         std::string line;
         while (max_lines-- > 0 && reader.get_next(&line) && !*cancel) {
             if (line.empty()) {
@@ -677,6 +844,7 @@ void thread_pool_log_writer_t::tail_blocking(
                 continue;
             }
             if (lm.timestamp > max_timestamp) {
+                ++max_lines;
                 continue;
             }
             if (lm.timestamp < min_timestamp) {
@@ -46,7 +46,9 @@ log_message_t parse_log_message(const std::string &s) THROWS_ONLY(log_read_exc_t
 
 class file_reverse_reader_t {
 public:
-    explicit file_reverse_reader_t(scoped_fd_t &&fd);
+    /* Reads the lines before byte `end` of the file, last line first. `end` must be
+    the start of a line; -1 means the end of the file. */
+    explicit file_reverse_reader_t(scoped_fd_t &&fd, int64_t end = -1);
     bool get_next(std::string *out);
 
 private:
@@ -0,0 +1,793 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/main/bench.hpp"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+
+#include "arch/io/network.hpp"
+#include "arch/os_signal.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/wait_any.hpp"
+#include "containers/scoped.hpp"
+#include "math.hpp"
+#include "paths.hpp"
+#include "random.hpp"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/ql2proto.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+#include "utils.hpp"
+
+void latency_histogram_t::record(int64_t value) {
+    guarantee(value >= 0);
+    const size_t index = bucket_index(value);
+    if (index >= counts.size()) {
+        counts.resize(index + 1, 0);
+    }
+    ++counts[index];
+    ++total_count;
+    max_value = std::max(max_value, value);
+    sum += value;
+}
+
+void latency_histogram_t::merge(const latency_histogram_t &other) {
+    if (other.counts.size() > counts.size()) {
+        counts.resize(other.counts.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    total_count += other.total_count;
+    max_value = std::max(max_value, other.max_value);
+    sum += other.sum;
+}
+
+double latency_histogram_t::mean() const {
+    return total_count == 0 ? 0 : sum / total_count;
+}
+
+int64_t latency_histogram_t::percentile(double p) const {
+    guarantee(p >= 0 && p <= 100);
+    if (total_count == 0) {
+        return 0;
+    }
+    const int64_t target = std::max<int64_t>(
+        1, static_cast<int64_t>(ceil(p / 100 * total_count)));
+    int64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min(bucket_highest_value(i), max_value);
+        }
+    }
+    return max_value;
+}
+
+// Values below `SUB_BUCKETS` get a bucket each.  Above that, the bucket is picked by
+// the position of the highest bit and the `SUB_BUCKET_BITS - 1` bits after it.
+size_t latency_histogram_t::bucket_index(int64_t value) {
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    const int shift = (63 - __builtin_clzll(value)) - (SUB_BUCKET_BITS - 1);
+    return SUB_BUCKETS + (shift - 1) * (SUB_BUCKETS / 2)
+        + ((value >> shift) - SUB_BUCKETS / 2);
+}
+
+int64_t latency_histogram_t::bucket_highest_value(size_t index) {
+    if (index < static_cast<size_t>(SUB_BUCKETS)) {
+        return index;
+    }
+    const size_t offset = index - SUB_BUCKETS;
+    const int shift = offset / (SUB_BUCKETS / 2) + 1;
+    const int64_t mantissa = offset % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+// This is the generator from Gray et al., "Quickly Generating Billion-Record Synthetic
+// Databases", which YCSB uses too.  Computing `zeta_n` takes O(n), but only once.
+zipfian_generator_t::zipfian_generator_t(uint64_t _n, double _theta)
+    : n(_n), theta(_theta), alpha(1 / (1 - _theta)), zeta_n(0) {
+    guarantee(n > 0);
+    for (uint64_t i = 1; i <= n; ++i) {
+        zeta_n += 1 / pow(i, theta);
+    }
+    const double zeta_2 = 1 + 1 / pow(2, theta);
+    eta = (1 - pow(2.0 / n, 1 - theta)) / (1 - zeta_2 / zeta_n);
+}
+
+uint64_t zipfian_generator_t::next(rng_t *rng) const {
+    const double u = rng->randdouble();
+    const double uz = u * zeta_n;
+    uint64_t rank;
+    if (uz < 1) {
+        rank = 0;
+    } else if (uz < 1 + pow(0.5, theta)) {
+        rank = 1;
+    } else {
+        rank = static_cast<uint64_t>(n * pow(eta * u - eta + 1, alpha));
+        rank = std::min(rank, n - 1);
+    }
+    // Scramble the rank with FNV-1a so the hot keys don't all sit in one range.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (rank >> (8 * i)) & 0xff;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash % n;
+}
+
+bench_config_t::bench_config_t()
+    : records(0), load(false), operations(0), concurrency(1), changefeeds(0),
+      zipfian(false), value_size(100), range_size(10), seed(0) {
+    for (size_t i = 0; i < NUM_BENCH_OPS; ++i) {
+        mix[i] = 0;
+    }
+}
+
+namespace {
+
+const char *const bench_op_names[NUM_BENCH_OPS] = { "get", "range", "insert", "update" };
+
+bool parse_bench_op_name(const std::string &name, bench_op_t *op_out) {
+    for (size_t i = 0; i < NUM_BENCH_OPS; ++i) {
+        if (name == bench_op_names[i]) {
+            *op_out = static_cast<bench_op_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool parse_bench_mix(const std::string &spec, bench_config_t *config) {
+    double mix[NUM_BENCH_OPS] = { 0, 0, 0, 0 };
+    // The core YCSB workloads, without F's read-modify-writes.
+    if (spec == "a") {
+        mix[static_cast<size_t>(bench_op_t::GET)] = 50;
+        mix[static_cast<size_t>(bench_op_t::UPDATE)] = 50;
+    } else if (spec == "b") {
+        mix[static_cast<size_t>(bench_op_t::GET)] = 95;
+        mix[static_cast<size_t>(bench_op_t::UPDATE)] = 5;
+    } else if (spec == "c") {
+        mix[static_cast<size_t>(bench_op_t::GET)] = 100;
+    } else if (spec == "d") {
+        mix[static_cast<size_t>(bench_op_t::GET)] = 95;
+        mix[static_cast<size_t>(bench_op_t::INSERT)] = 5;
+    } else if (spec == "e") {
+        mix[static_cast<size_t>(bench_op_t::RANGE)] = 95;
+        mix[static_cast<size_t>(bench_op_t::INSERT)] = 5;
+    } else {
+        size_t pos = 0;
+        while (pos <= spec.size()) {
+            size_t end = spec.find(',', pos);
+            if (end == std::string::npos) {
+                end = spec.size();
+            }
+            const std::string item = spec.substr(pos, end - pos);
+            const size_t equals = item.find('=');
+            bench_op_t op;
+            uint64_t weight;
+            if (equals == std::string::npos
+                || !parse_bench_op_name(item.substr(0, equals), &op)
+                || !strtou64_strict(item.substr(equals + 1), 10, &weight)) {
+                return false;
+            }
+            mix[static_cast<size_t>(op)] = weight;
+            pos = end + 1;
+        }
+    }
+    double total = 0;
+    for (size_t i = 0; i < NUM_BENCH_OPS; ++i) {
+        total += mix[i];
+    }
+    if (total == 0) {
+        return false;
+    }
+    std::copy(mix, mix + NUM_BENCH_OPS, config->mix);
+    return true;
+}
+
+namespace {
+
+std::string json_string(const std::string &str) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.String(str.data(), str.size());
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+// The wire protocol is little-endian, whatever the machine is.
+void append_little_endian(uint64_t value, size_t size, std::string *out) {
+    for (size_t i = 0; i < size; ++i) {
+        out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t decode_little_endian(const char *data, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+/* A minimal client of the JSON protocol.  It uses the `V0_4` handshake, whose auth key
+is the admin password in plain text, so that it doesn't need a SCRAM implementation.
+Queries on one connection are run one at a time. */
+class bench_connection_t {
+public:
+    bench_connection_t(const ip_address_t &ip, int port, const std::string &password,
+                       signal_t *interruptor)
+        : conn(ip, port, interruptor), next_token(1) {
+        std::string handshake;
+        append_little_endian(VersionDummy::V0_4, 4, &handshake);
+        append_little_endian(password.size(), 4, &handshake);
+        handshake += password;
+        append_little_endian(VersionDummy::JSON, 4, &handshake);
+        conn.write(handshake.data(), handshake.size(), interruptor);
+
+        std::string reply;
+        for (;;) {
+            char c;
+            conn.read_buffered(&c, 1, interruptor);
+            if (c == '\0') {
+                break;
+            }
+            reply.push_back(c);
+        }
+        if (reply != "SUCCESS") {
+            throw std::runtime_error("The server refused the connection: " + reply);
+        }
+    }
+
+    int64_t start(const std::string &term, signal_t *closer) {
+        const int64_t token = next_token++;
+        send(token, strprintf("[%d,%s,{}]", Query::START, term.c_str()), closer);
+        return token;
+    }
+
+    void continue_query(int64_t token, signal_t *closer) {
+        send(token, strprintf("[%d]", Query::CONTINUE), closer);
+    }
+
+    // Returns the response type and puts the whole response in `doc_out`.
+    int read_response(int64_t token, rapidjson::Document *doc_out, signal_t *closer) {
+        char header[12];
+        conn.read_buffered(header, sizeof(header), closer);
+        const int64_t response_token = decode_little_endian(header, 8);
+        const uint32_t size = decode_little_endian(header + 8, 4);
+        scoped_array_t<char> buffer(size + 1);
+        conn.read_buffered(buffer.data(), size, closer);
+        buffer[size] = '\0';
+        if (response_token != token) {
+            throw std::runtime_error(strprintf(
+                "Got a response for query %" PRIi64 " while waiting for %" PRIi64,
+                response_token, token));
+        }
+        doc_out->Parse(buffer.data());
+        if (doc_out->HasParseError() || !doc_out->IsObject()
+            || !doc_out->HasMember("t") || !(*doc_out)["t"].IsInt()) {
+            throw std::runtime_error("The server sent a response that isn't valid.");
+        }
+        return (*doc_out)["t"].GetInt();
+    }
+
+    // Runs a query to the end, fetching every batch of a sequence.  Returns an empty
+    // string if it succeeded and the error message otherwise.
+    std::string run(const std::string &term, signal_t *closer) {
+        rapidjson::Document doc;
+        const int64_t token = start(term, closer);
+        int type = read_response(token, &doc, closer);
+        while (type == Response::SUCCESS_PARTIAL) {
+            continue_query(token, closer);
+            type = read_response(token, &doc, closer);
+        }
+        if (type == Response::SUCCESS_ATOM || type == Response::SUCCESS_SEQUENCE) {
+            return std::string();
+        }
+        if (doc.HasMember("r") && doc["r"].IsArray() && doc["r"].Size() > 0
+            && doc["r"][0].IsString()) {
+            return doc["r"][0].GetString();
+        }
+        return strprintf("The query failed with response type %d.", type);
+    }
+
+private:
+    void send(int64_t token, const std::string &query, signal_t *closer) {
+        std::string message;
+        append_little_endian(token, 8, &message);
+        append_little_endian(query.size(), 4, &message);
+        message += query;
+        conn.write(message.data(), message.size(), closer);
+    }
+
+    tcp_conn_t conn;
+    int64_t next_token;
+
+    DISABLE_COPYING(bench_connection_t);
+};
+
+struct bench_query_t {
+    bench_op_t op;
+    std::string term;
+};
+
+std::string table_term(const bench_config_t &config) {
+    return strprintf("[%d,[[%d,[%s]],%s]]",
+                     Term::TABLE, Term::DB, json_string(config.db).c_str(),
+                     json_string(config.table).c_str());
+}
+
+std::string random_value(int64_t size, rng_t *rng) {
+    std::string value;
+    value.reserve(size);
+    for (int64_t i = 0; i < size; ++i) {
+        value.push_back('a' + rng->randint(26));
+    }
+    return value;
+}
+
+/* Generates the queries of one worker.  Everything comes from an `rng_t` seeded with
+`--seed` and the worker's number, so two runs with the same options send the same
+queries in the same order, which is also what `--record` writes. */
+class bench_generator_t {
+public:
+    bench_generator_t(const bench_config_t *_config, int64_t _worker,
+                      const zipfian_generator_t *_zipfian)
+        : config(_config), worker(_worker), zipfian(_zipfian),
+          rng(_config->seed ^ (static_cast<uint64_t>(_worker + 1)
+                               * 0x9e3779b97f4a7c15ULL)),
+          table(table_term(*_config)), total_weight(0), generated(0), inserted(0) {
+        for (size_t i = 0; i < NUM_BENCH_OPS; ++i) {
+            total_weight += config->mix[i];
+        }
+    }
+
+    bool next(bench_query_t *query_out) {
+        if (generated == config->operations) {
+            return false;
+        }
+        ++generated;
+        // If rounding leaves `choice` past the end, we pick the last operation.
+        double choice = rng.randdouble() * total_weight;
+        size_t op = 0;
+        for (size_t i = 0; i < NUM_BENCH_OPS; ++i) {
+            if (config->mix[i] == 0) {
+                continue;
+            }
+            op = i;
+            if (choice < config->mix[i]) {
+                break;
+            }
+            choice -= config->mix[i];
+        }
+        query_out->op = static_cast<bench_op_t>(op);
+        switch (query_out->op) {
+        case bench_op_t::GET:
+            query_out->term = strprintf("[%d,[%s,%" PRIu64 "]]",
+                                        Term::GET, table.c_str(), next_key());
+            break;
+        case bench_op_t::RANGE: {
+            const uint64_t key = next_key();
+            query_out->term = strprintf(
+                "[%d,[[%d,[%s,%" PRIu64 ",%" PRIu64 "]],%" PRIi64 "]]",
+                Term::LIMIT, Term::BETWEEN, table.c_str(), key,
+                key + config->range_size, config->range_size);
+        } break;
+        case bench_op_t::INSERT: {
+            // Every worker inserts its own ids after the loaded ones.
+            const int64_t key =
+                config->records + worker + inserted * config->concurrency;
+            ++inserted;
+            query_out->term = strprintf(
+                "[%d,[%s,{\"id\":%" PRIi64 ",\"value\":%s}]]",
+                Term::INSERT, table.c_str(), key,
+                json_string(random_value(config->value_size, &rng)).c_str());
+        } break;
+        case bench_op_t::UPDATE: {
+            const uint64_t key = next_key();
+            query_out->term = strprintf(
+                "[%d,[[%d,[%s,%" PRIu64 "]],{\"value\":%s}]]",
+                Term::UPDATE, Term::GET, table.c_str(), key,
+                json_string(random_value(config->value_size, &rng)).c_str());
+        } break;
+        default:
+            unreachable();
+        }
+        return true;
+    }
+
+private:
+    uint64_t next_key() {
+        return zipfian != nullptr
+            ? zipfian->next(&rng)
+            : rng.randuint64(config->records);
+    }
+
+    const bench_config_t *config;
+    int64_t worker;
+    const zipfian_generator_t *zipfian;
+    rng_t rng;
+    std::string table;
+    double total_weight;
+    int64_t generated;
+    int64_t inserted;
+
+    DISABLE_COPYING(bench_generator_t);
+};
+
+/* A trace starts with a comment line, and then has a line `worker<TAB>op<TAB>term` for
+every query.  The queries of each worker are in the order they are sent. */
+const char *const bench_trace_header = "# rethinkdb bench trace\n";
+const uint64_t MAX_BENCH_TRACE_WORKERS = 10000;
+
+bool write_bench_trace(const bench_config_t &config,
+                       const zipfian_generator_t *zipfian) {
+    FILE *file = fopen(config.record_path.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "ERROR: Could not open '%s' for writing: %s\n",
+                config.record_path.c_str(), errno_string(get_errno()).c_str());
+        return false;
+    }
+    bool ok = fputs(bench_trace_header, file) >= 0;
+    for (int64_t worker = 0; ok && worker < config.concurrency; ++worker) {
+        bench_generator_t generator(&config, worker, zipfian);
+        bench_query_t query;
+        while (ok && generator.next(&query)) {
+            ok = fprintf(file, "%" PRIi64 "\t%s\t%s\n", worker,
+                         bench_op_names[static_cast<size_t>(query.op)],
+                         query.term.c_str()) >= 0;
+        }
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: Could not write the trace to '%s'\n",
+                config.record_path.c_str());
+    }
+    return ok;
+}
+
+bool read_bench_trace(const std::string &path,
+                      std::vector<std::vector<bench_query_t> > *trace_out) {
+    std::string contents;
+    if (!blocking_read_file(path.c_str(), &contents)) {
+        fprintf(stderr, "ERROR: Could not read the trace '%s'\n", path.c_str());
+        return false;
+    }
+    if (contents.compare(0, strlen(bench_trace_header), bench_trace_header) != 0) {
+        fprintf(stderr, "ERROR: '%s' is not a trace written by 'rethinkdb bench'\n",
+                path.c_str());
+        return false;
+    }
+    size_t pos = strlen(bench_trace_header);
+    int64_t line_number = 1;
+    while (pos < contents.size()) {
+        ++line_number;
+        size_t end = contents.find('\n', pos);
+        if (end == std::string::npos) {
+            end = contents.size();
+        }
+        const std::string line = contents.substr(pos, end - pos);
+        pos = end + 1;
+
+        const size_t tab1 = line.find('\t');
+        const size_t tab2 =
+            tab1 == std::string::npos ? std::string::npos : line.find('\t', tab1 + 1);
+        uint64_t worker;
+        bench_query_t query;
+        if (tab2 == std::string::npos
+            || !strtou64_strict(line.substr(0, tab1), 10, &worker)
+            || worker >= MAX_BENCH_TRACE_WORKERS
+            || !parse_bench_op_name(line.substr(tab1 + 1, tab2 - tab1 - 1), &query.op)) {
+            fprintf(stderr, "ERROR: Line %" PRIi64 " of the trace '%s' is invalid\n",
+                    line_number, path.c_str());
+            return false;
+        }
+        query.term = line.substr(tab2 + 1);
+        if (worker >= trace_out->size()) {
+            trace_out->resize(worker + 1);
+        }
+        (*trace_out)[worker].push_back(std::move(query));
+    }
+    return true;
+}
+
+struct bench_worker_result_t {
+    bench_worker_result_t() : errors(0), failed(false) { }
+
+    latency_histogram_t latencies[NUM_BENCH_OPS];
+    int64_t errors;
+    // The first query error, or the error that stopped the worker.
+    std::string first_error;
+    bool failed;
+};
+
+// Creates the table if it doesn't exist yet and inserts the rows with ids
+// 0 ... `config.records - 1`, in batches, on `config.concurrency` connections.
+bool bench_load(const bench_config_t &config, const ip_and_port_t &address,
+                signal_t *interruptor) {
+    {
+        bench_connection_t conn(address.ip(), address.port().value(), config.password,
+                                interruptor);
+        // These fail if the database or table already exists, which is fine.
+        UNUSED std::string db_error = conn.run(
+            strprintf("[%d,[%s]]", Term::DB_CREATE, json_string(config.db).c_str()),
+            interruptor);
+        UNUSED std::string table_error = conn.run(
+            strprintf("[%d,[[%d,[%s]],%s]]", Term::TABLE_CREATE, Term::DB,
+                      json_string(config.db).c_str(),
+                      json_string(config.table).c_str()),
+            interruptor);
+        const std::string wait_error = conn.run(
+            strprintf("[%d,[%s]]", Term::WAIT, table_term(config).c_str()),
+            interruptor);
+        if (!wait_error.empty()) {
+            fprintf(stderr, "ERROR: The table isn't available: %s\n",
+                    wait_error.c_str());
+            return false;
+        }
+    }
+
+    const int64_t batch_size = 200;
+    const int64_t per_worker = ceil_divide(config.records, config.concurrency);
+    std::vector<std::string> errors(config.concurrency);
+    pmap(config.concurrency, [&](int64_t worker) {
+        cross_thread_signal_t ct_interruptor(
+            interruptor, threadnum_t(worker % get_num_threads()));
+        on_thread_t thread_switcher(threadnum_t(worker % get_num_threads()));
+        try {
+            bench_connection_t conn(address.ip(), address.port().value(),
+                                    config.password, &ct_interruptor);
+            rng_t rng(config.seed + worker);
+            const std::string table = table_term(config);
+            const int64_t end = std::min(config.records, (worker + 1) * per_worker);
+            for (int64_t key = worker * per_worker; key < end; key += batch_size) {
+                std::string docs;
+                for (int64_t i = key; i < std::min(end, key + batch_size); ++i) {
+                    docs += strprintf(
+                        "%s{\"id\":%" PRIi64 ",\"value\":%s}",
+                        docs.empty() ? "" : ",", i,
+                        json_string(random_value(config.value_size, &rng)).c_str());
+                }
+                errors[worker] = conn.run(
+                    strprintf("[%d,[%s,[%d,[%s]]]]", Term::INSERT, table.c_str(),
+                              Term::MAKE_ARRAY, docs.c_str()),
+                    &ct_interruptor);
+                if (!errors[worker].empty()) {
+                    break;
+                }
+            }
+        } catch (const std::exception &ex) {
+            errors[worker] = ex.what();
+        }
+    });
+    for (const std::string &error : errors) {
+        if (!error.empty()) {
+            fprintf(stderr, "ERROR: Loading the table failed: %s\n", error.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Follows a changefeed on the table and counts the changes until `stop` is pulsed.
+void follow_changefeed(const bench_config_t &config, const ip_and_port_t &address,
+                       signal_t *stop, int64_t *changes_out, std::string *error_out) {
+    try {
+        bench_connection_t conn(address.ip(), address.port().value(), config.password,
+                                stop);
+        rapidjson::Document doc;
+        const int64_t token = conn.start(
+            strprintf("[%d,[%s]]", Term::CHANGES, table_term(config).c_str()), stop);
+        for (;;) {
+            const int type = conn.read_response(token, &doc, stop);
+            if (type != Response::SUCCESS_PARTIAL) {
+                *error_out = strprintf(
+                    "The changefeed stopped with response type %d.", type);
+                return;
+            }
+            if (doc.HasMember("r") && doc["r"].IsArray()) {
+                *changes_out += doc["r"].Size();
+            }
+            conn.continue_query(token, stop);
+        }
+    } catch (const tcp_conn_read_closed_exc_t &) {
+        if (!stop->is_pulsed()) {
+            *error_out = "The server closed the changefeed connection.";
+        }
+    } catch (const tcp_conn_write_closed_exc_t &) {
+        if (!stop->is_pulsed()) {
+            *error_out = "The server closed the changefeed connection.";
+        }
+    } catch (const interrupted_exc_t &) {
+        // `stop` was pulsed while we were connecting.
+    } catch (const std::exception &ex) {
+        *error_out = ex.what();
+    }
+}
+
+void run_bench_worker(const bench_config_t &config, const ip_and_port_t &address,
+                      bench_generator_t *generator,
+                      const std::vector<bench_query_t> *replay,
+                      signal_t *interruptor, bench_worker_result_t *result) {
+    try {
+        bench_connection_t conn(address.ip(), address.port().value(), config.password,
+                                interruptor);
+        size_t replayed = 0;
+        bench_query_t generated;
+        for (;;) {
+            const bench_query_t *query;
+            if (replay != nullptr) {
+                if (replayed == replay->size()) {
+                    break;
+                }
+                query = &(*replay)[replayed++];
+            } else {
+                if (!generator->next(&generated)) {
+                    break;
+                }
+                query = &generated;
+            }
+            const ticks_t start = get_ticks();
+            const std::string error = conn.run(query->term, interruptor);
+            const ticks_t end = get_ticks();
+            if (!error.empty()) {
+                ++result->errors;
+                if (result->first_error.empty()) {
+                    result->first_error = error;
+                }
+                continue;
+            }
+            result->latencies[static_cast<size_t>(query->op)].record(
+                end.nanos - start.nanos);
+        }
+    } catch (const tcp_conn_read_closed_exc_t &) {
+        result->failed = true;
+        result->first_error = "The connection was closed.";
+    } catch (const tcp_conn_write_closed_exc_t &) {
+        result->failed = true;
+        result->first_error = "The connection was closed.";
+    } catch (const interrupted_exc_t &) {
+        result->failed = true;
+        result->first_error = "Interrupted.";
+    } catch (const std::exception &ex) {
+        result->failed = true;
+        result->first_error = ex.what();
+    }
+}
+
+void print_bench_results(const std::vector<bench_worker_result_t> &results,
+                         double seconds, int64_t changes, int changefeeds) {
+    latency_histogram_t latencies[NUM_BENCH_OPS];
+    latency_histogram_t all;
+    int64_t errors = 0;
+    for (const bench_worker_result_t &result : results) {
+        for (size_t i = 0; i < NUM_BENCH_OPS; ++i) {
+            latencies[i].merge(result.latencies[i]);
+            all.merge(result.latencies[i]);
+        }
+        errors += result.errors;
+    }
+
+    printf("%" PRIi64 " operations in %.3f s (%.1f operations/s), %" PRIi64
+           " errors\n", all.count(), seconds, all.count() / seconds, errors);
+    if (changefeeds > 0) {
+        printf("%d changefeeds received %" PRIi64 " changes (%.1f changes/s)\n",
+               changefeeds, changes, changes / seconds);
+    }
+    printf("\nlatency (us)  %10s %10s %10s %10s %10s %10s %10s\n",
+           "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (size_t i = 0; i <= NUM_BENCH_OPS; ++i) {
+        const latency_histogram_t &h = i < NUM_BENCH_OPS ? latencies[i] : all;
+        if (h.count() == 0) {
+            continue;
+        }
+        printf("%-13s %10" PRIi64 " %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+               i < NUM_BENCH_OPS ? bench_op_names[i] : "all", h.count(),
+               h.mean() / 1000, h.percentile(50) / 1000.0, h.percentile(90) / 1000.0,
+               h.percentile(99) / 1000.0, h.percentile(99.9) / 1000.0,
+               h.max() / 1000.0);
+    }
+    for (const bench_worker_result_t &result : results) {
+        if (!result.first_error.empty()) {
+            printf("\nFirst error: %s\n", result.first_error.c_str());
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+bool run_bench(const bench_config_t &config) {
+    os_signal_cond_t sigint_cond;
+
+    std::vector<std::vector<bench_query_t> > trace;
+    if (!config.replay_path.empty() && !read_bench_trace(config.replay_path, &trace)) {
+        return false;
+    }
+
+    scoped_ptr_t<zipfian_generator_t> zipfian;
+    if (config.zipfian && config.records > 0) {
+        zipfian.init(new zipfian_generator_t(config.records));
+    }
+    if (!config.record_path.empty() && !write_bench_trace(config, zipfian.get())) {
+        return false;
+    }
+
+    const std::set<ip_and_port_t> addresses = config.server.resolve();
+    if (addresses.empty()) {
+        fprintf(stderr, "ERROR: Could not resolve '%s'\n",
+                config.server.host().c_str());
+        return false;
+    }
+    const ip_and_port_t address = *addresses.begin();
+
+    try {
+        if (config.load && !bench_load(config, address, &sigint_cond)) {
+            return false;
+        }
+    } catch (const interrupted_exc_t &) {
+        return false;
+    }
+
+    const int64_t num_workers =
+        config.replay_path.empty() ? config.concurrency : trace.size();
+    std::vector<bench_worker_result_t> results(num_workers);
+    std::vector<int64_t> changes(config.changefeeds, 0);
+    std::vector<std::string> changefeed_errors(config.changefeeds);
+    cond_t workload_done;
+    wait_any_t stop_changefeeds(&workload_done, &sigint_cond);
+
+    const ticks_t start = get_ticks();
+    ticks_t end = start;
+    pmap(config.changefeeds + 1, [&](int64_t i) {
+        if (i < config.changefeeds) {
+            follow_changefeed(config, address, &stop_changefeeds, &changes[i],
+                              &changefeed_errors[i]);
+            return;
+        }
+        pmap(num_workers, [&](int64_t worker) {
+            const threadnum_t thread(worker % get_num_threads());
+            cross_thread_signal_t ct_interruptor(&sigint_cond, thread);
+            on_thread_t thread_switcher(thread);
+            scoped_ptr_t<bench_generator_t> generator;
+            if (config.replay_path.empty()) {
+                generator.init(new bench_generator_t(&config, worker, zipfian.get()));
+            }
+            run_bench_worker(config, address, generator.get(),
+                             config.replay_path.empty() ? nullptr : &trace[worker],
+                             &ct_interruptor, &results[worker]);
+        });
+        end = get_ticks();
+        workload_done.pulse();
+    });
+
+    print_bench_results(results, (end.nanos - start.nanos) / 1.0e9,
+                        std::accumulate(changes.begin(), changes.end(), int64_t(0)),
+                        config.changefeeds);
+    bool ok = !sigint_cond.is_pulsed();
+    for (const bench_worker_result_t &result : results) {
+        ok = ok && !result.failed;
+    }
+    for (const std::string &error : changefeed_errors) {
+        if (!error.empty()) {
+            fprintf(stderr, "ERROR: %s\n", error.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,104 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_MAIN_BENCH_HPP_
+#define CLUSTERING_ADMINISTRATION_MAIN_BENCH_HPP_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "arch/address.hpp"
+#include "errors.hpp"
+
+class rng_t;
+
+// A latency histogram in the style of HdrHistogram.  Every power of two is split into
+// `SUB_BUCKETS / 2` equal buckets, so a percentile is never off by more than 1/64 of
+// its value, no matter how long the tail is, and histograms from several workers can
+// be merged exactly.
+class latency_histogram_t {
+public:
+    static const int SUB_BUCKET_BITS = 7;
+    static const int64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    latency_histogram_t() : total_count(0), max_value(0), sum(0) { }
+
+    // `value` is usually in nanoseconds and must not be negative.
+    void record(int64_t value);
+    void merge(const latency_histogram_t &other);
+
+    int64_t count() const { return total_count; }
+    int64_t max() const { return max_value; }
+    double mean() const;
+    // The smallest value that at least `p` percent of the values are at most, to
+    // within the bucket width.  `p` must be between 0 and 100.
+    int64_t percentile(double p) const;
+
+private:
+    static size_t bucket_index(int64_t value);
+    static int64_t bucket_highest_value(size_t index);
+
+    std::vector<int64_t> counts;
+    int64_t total_count;
+    int64_t max_value;
+    double sum;
+};
+
+// A scrambled Zipfian distribution over [0, n) as in YCSB: a few keys are much hotter
+// than the rest, but the hot keys are spread over the key space instead of being the
+// smallest ones.
+class zipfian_generator_t {
+public:
+    explicit zipfian_generator_t(uint64_t n, double theta = 0.99);
+    uint64_t next(rng_t *rng) const;
+
+private:
+    uint64_t n;
+    double theta;
+    double alpha;
+    double zeta_n;
+    double eta;
+};
+
+enum class bench_op_t { GET = 0, RANGE, INSERT, UPDATE };
+const size_t NUM_BENCH_OPS = 4;
+
+struct bench_config_t {
+    bench_config_t();
+
+    host_and_port_t server;
+    std::string password;
+    std::string db;
+    std::string table;
+
+    // Rows with ids 0 ... `records - 1` are read and updated; `--load` inserts them.
+    int64_t records;
+    bool load;
+    // For every worker, which sends its queries one after another.
+    int64_t operations;
+    int concurrency;
+    // Connections that only follow a changefeed on the table.
+    int changefeeds;
+
+    // Relative weights of the operations, by `bench_op_t`.
+    double mix[NUM_BENCH_OPS];
+    bool zipfian;
+    int64_t value_size;
+    int64_t range_size;
+    uint64_t seed;
+
+    // If not empty, the generated queries are written here before they run.
+    std::string record_path;
+    // If not empty, runs the queries from this file instead of generating them.
+    std::string replay_path;
+};
+
+// Parses a YCSB workload letter ("a" to "e") or a list like "get=95,update=5" into
+// `config->mix`.  Returns false if `spec` is neither.
+MUST_USE bool parse_bench_mix(const std::string &spec, bench_config_t *config);
+
+// Connects to the server, runs the benchmark and prints the results.  Must be called
+// in the thread pool.  Returns false and prints an error if the benchmark failed.
+MUST_USE bool run_bench(const bench_config_t &config);
+
+#endif  // CLUSTERING_ADMINISTRATION_MAIN_BENCH_HPP_
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <limits>
 #include <string>
+#include <vector>
 
 #if defined(__MACH__)
 #include <cstdio>
@@ -10,6 +11,7 @@
 
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #if defined(__MACH__)
@@ -21,6 +23,7 @@
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/types.hpp"
+#include "config/args.hpp"
 #include "logger.hpp"
 #include "paths.hpp"
 #include "utils.hpp"
@@ -237,6 +240,209 @@ bool get_proc_meminfo_available_memory_size(uint64_t *mem_avail_out) {
 
 #endif  // __MACH_
 
+bool parse_cgroup_memory_value(const std::string &contents, uint64_t *value_out) {
+    // cgroup v2 writes "max" when there's no limit, which doesn't parse.
+    const size_t end = contents.find_last_not_of(" \t\n");
+    if (end == std::string::npos) {
+        return false;
+    }
+    return strtou64_strict(contents.substr(0, end + 1), 10, value_out);
+}
+
+bool parse_cgroup_memory_stat(const std::string &contents, const std::string &key,
+                              uint64_t *value_out) {
+    // Every line is a key, a space and a number, like "inactive_file 4096".
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        size_t line_end = contents.find('\n', offset);
+        if (line_end == std::string::npos) {
+            line_end = contents.size();
+        }
+        if (contents.compare(offset, key.size(), key) == 0
+            && offset + key.size() < line_end && contents[offset + key.size()] == ' ') {
+            const size_t begin = offset + key.size() + 1;
+            return strtou64_strict(contents.substr(begin, line_end - begin), 10,
+                                   value_out);
+        }
+        offset = line_end + 1;
+    }
+    return false;
+}
+
+uint64_t cgroup_working_set(uint64_t usage, const std::string &stat_contents,
+                            bool v2) {
+    uint64_t file_memory;
+    if (!parse_cgroup_memory_stat(stat_contents, v2 ? "file" : "inactive_file",
+                                  &file_memory)) {
+        return usage;
+    }
+    return usage > file_memory ? usage - file_memory : 0;
+}
+
+uint64_t cgroup_available_memory(uint64_t mem_available, const cgroup_memory_t &cgroup) {
+    return std::min(mem_available,
+                    cgroup.limit > cgroup.usage ? cgroup.limit - cgroup.usage : 0);
+}
+
+bool cgroup_memory_is_low(const cgroup_memory_t &cgroup) {
+    return cgroup.usage > cgroup.limit / 100 * CACHE_SHRINK_CGROUP_USAGE_PERCENT;
+}
+
+uint64_t next_automatic_cache_size(uint64_t current, uint64_t target,
+                                   bool under_pressure) {
+    if (under_pressure) {
+        return std::min(std::max(current - current / 4,
+                                 get_min_default_total_cache_size()),
+                        target);
+    } else if (current < target) {
+        return std::min(current + target / 8, target);
+    } else {
+        return target;
+    }
+}
+
+bool parse_memory_pressure(const std::string &contents, double *percent_out) {
+    // The first line is "some avg10=1.23 avg60=4.56 avg300=7.89 total=12345".
+    const std::string prefix = "some avg10=";
+    if (contents.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    const char *begin = contents.c_str() + prefix.size();
+    char *end;
+    const double value = strtod(begin, &end);
+    if (end == begin || (*end != ' ' && *end != '\n' && *end != '\0')) {
+        return false;
+    }
+    *percent_out = value;
+    return true;
+}
+
+#if defined(__linux__)
+
+static bool read_small_file(const std::string &path, std::string *contents_out) {
+    bool ok;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        ok = blocking_read_file(path.c_str(), contents_out);
+    });
+    return ok;
+}
+
+// Returns the directories of our memory cgroup and its ancestors, innermost first, and
+// whether it's a cgroup v2 hierarchy.
+static std::vector<std::string> get_cgroup_memory_dirs(bool *v2_out) {
+    std::vector<std::string> dirs;
+    std::string contents;
+    if (!read_small_file("/proc/self/cgroup", &contents)) {
+        return dirs;
+    }
+    // The lines look like "0::/path" for v2, and "4:memory:/path" for v1.
+    std::string path;
+    bool found = false;
+    size_t offset = 0;
+    while (offset < contents.size() && !found) {
+        size_t line_end = contents.find('\n', offset);
+        if (line_end == std::string::npos) {
+            line_end = contents.size();
+        }
+        const std::string line = contents.substr(offset, line_end - offset);
+        offset = line_end + 1;
+        const size_t first_colon = line.find(':');
+        const size_t second_colon = line.find(':', first_colon + 1);
+        if (first_colon == std::string::npos || second_colon == std::string::npos) {
+            continue;
+        }
+        const std::string controllers =
+            "," + line.substr(first_colon + 1, second_colon - first_colon - 1) + ",";
+        path = line.substr(second_colon + 1);
+        if (controllers == ",,") {
+            *v2_out = true;
+            found = true;
+        } else if (controllers.find(",memory,") != std::string::npos) {
+            *v2_out = false;
+            found = true;
+        }
+    }
+    if (!found) {
+        return dirs;
+    }
+    const std::string root = *v2_out ? "/sys/fs/cgroup" : "/sys/fs/cgroup/memory";
+    // With a cgroup namespace, or in a container that mounts only its own cgroup,
+    // the path doesn't exist under the mount point, but the root is our cgroup.
+    if (access((root + path).c_str(), F_OK) != 0) {
+        path = "/";
+    }
+    while (true) {
+        dirs.push_back(path == "/" ? root : root + path);
+        if (path == "/" || path.empty()) {
+            break;
+        }
+        const size_t slash = path.find_last_of('/');
+        path = slash == 0 ? "/" : path.substr(0, slash);
+    }
+    return dirs;
+}
+
+bool get_cgroup_memory(cgroup_memory_t *memory_out) {
+    bool v2;
+    const std::vector<std::string> dirs = get_cgroup_memory_dirs(&v2);
+    // cgroup v1 reports a huge number instead of no limit.
+    const uint64_t physical_memory =
+        static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+    bool found = false;
+    for (const std::string &dir : dirs) {
+        std::string contents;
+        uint64_t limit;
+        if (read_small_file(dir + (v2 ? "/memory.max" : "/memory.limit_in_bytes"),
+                            &contents)
+            && parse_cgroup_memory_value(contents, &limit)
+            && limit < physical_memory
+            && (!found || limit < memory_out->limit)) {
+            memory_out->limit = limit;
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    std::string contents;
+    if (!read_small_file(
+            dirs[0] + (v2 ? "/memory.current" : "/memory.usage_in_bytes"), &contents)
+        || !parse_cgroup_memory_value(contents, &memory_out->usage)) {
+        memory_out->usage = 0;
+    }
+    // The usage includes the page cache, which the kernel reclaims before it runs
+    // out of memory.
+    if (read_small_file(dirs[0] + "/memory.stat", &contents)) {
+        memory_out->usage = cgroup_working_set(memory_out->usage, contents, v2);
+    }
+    return true;
+}
+
+bool get_memory_pressure(double *percent_out) {
+    bool v2;
+    const std::vector<std::string> dirs = get_cgroup_memory_dirs(&v2);
+    std::string contents;
+    if (!dirs.empty() && v2
+        && read_small_file(dirs[0] + "/memory.pressure", &contents)
+        && parse_memory_pressure(contents, percent_out)) {
+        return true;
+    }
+    return read_small_file("/proc/pressure/memory", &contents)
+        && parse_memory_pressure(contents, percent_out);
+}
+
+#else
+
+bool get_cgroup_memory(UNUSED cgroup_memory_t *memory_out) {
+    return false;
+}
+
+bool get_memory_pressure(UNUSED double *percent_out) {
+    return false;
+}
+
+#endif  // __linux__
+
 #if defined(__MACH__)
 
 bool osx_runtime_version_check() {
@@ -314,6 +520,11 @@ uint64_t get_avail_mem_size() {
 	{
         uint64_t memory;
         if (get_proc_meminfo_available_memory_size(&memory)) {
+            // Inside a container, the cgroup's limit is what matters.
+            cgroup_memory_t cgroup;
+            if (get_cgroup_memory(&cgroup)) {
+                memory = cgroup_available_memory(memory, cgroup);
+            }
             return memory;
         } else {
             logERR("Could not parse /proc/meminfo, so we will treat cached file memory "
@@ -343,16 +554,26 @@ uint64_t get_max_total_cache_size() {
         static_cast<uint64_t>(MEGABYTE) * static_cast<uint64_t>(GIGABYTE));
 }
 
-uint64_t get_default_total_cache_size() {
-    const int64_t available_mem = get_avail_mem_size();
+uint64_t get_min_default_total_cache_size() {
+    return 100 * MEGABYTE;
+}
 
-    // Default to half the available memory minus a gigabyte, to leave room for server
-    // and query overhead, but never default to less than 100 megabytes
+// Half the memory minus a gigabyte, to leave room for server and query overhead, but
+// never less than 100 megabytes.
+static uint64_t default_total_cache_size_for(int64_t memory) {
     const int64_t signed_res =
-        std::min<int64_t>(available_mem - GIGABYTE, get_max_total_cache_size()) /
+        std::min<int64_t>(memory - GIGABYTE, get_max_total_cache_size()) /
         DEFAULT_MAX_CACHE_RATIO;
-    const uint64_t res = std::max<int64_t>(signed_res, 100 * MEGABYTE);
-    return res;
+    return std::max<int64_t>(signed_res, get_min_default_total_cache_size());
+}
+
+uint64_t get_default_total_cache_size() {
+    return default_total_cache_size_for(get_avail_mem_size());
+}
+
+uint64_t get_default_total_cache_size_for_limit(uint64_t limit) {
+    return default_total_cache_size_for(
+        std::min<uint64_t>(limit, std::numeric_limits<int64_t>::max()));
 }
 
 void log_warnings_for_cache_size(uint64_t bytes) {
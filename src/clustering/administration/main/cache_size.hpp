@@ -9,5 +9,49 @@ uint64_t get_max_total_cache_size();
 uint64_t get_default_total_cache_size();
 void log_warnings_for_cache_size(uint64_t);
 
+// The smallest cache size we pick automatically.
+uint64_t get_min_default_total_cache_size();
+
+// The memory limit of the cgroup (v2 or v1) that the server is in, or the tightest
+// limit of its ancestors, and the cgroup's working set: how much memory it uses,
+// minus the file cache that the kernel can reclaim.  Returns false if there's no
+// limit.
+struct cgroup_memory_t {
+    uint64_t limit;
+    uint64_t usage;
+};
+bool get_cgroup_memory(cgroup_memory_t *memory_out);
+
+// `usage` minus the `inactive_file` (v1) or `file` (v2) bytes of the cgroup's
+// `memory.stat`.
+uint64_t cgroup_working_set(uint64_t usage, const std::string &stat_contents, bool v2);
+
+// How much of `mem_available`, from /proc/meminfo, the cgroup leaves us.
+uint64_t cgroup_available_memory(uint64_t mem_available, const cgroup_memory_t &cgroup);
+
+// Whether the cgroup's working set is above CACHE_SHRINK_CGROUP_USAGE_PERCENT of its
+// limit.
+bool cgroup_memory_is_low(const cgroup_memory_t &cgroup);
+
+// The automatic cache size to use after `current`, when it should be at most `target`.
+uint64_t next_automatic_cache_size(uint64_t current, uint64_t target,
+                                   bool under_pressure);
+
+// The cache size we would pick for a cgroup with a memory limit of `limit`.
+uint64_t get_default_total_cache_size_for_limit(uint64_t limit);
+
+// Sets `*percent_out` to the share of the last ten seconds in which some tasks were
+// stalled on memory, from the kernel's pressure stall information for our cgroup, or
+// for the whole system.  Returns false if the kernel doesn't have it.
+bool get_memory_pressure(double *percent_out);
+
+// These parse the contents of `memory.max` or `memory.limit_in_bytes`, and of
+// `memory.pressure` or `/proc/pressure/memory`.
+bool parse_cgroup_memory_value(const std::string &contents, uint64_t *value_out);
+bool parse_memory_pressure(const std::string &contents, double *percent_out);
+// Sets `*value_out` to the value of `key` in the contents of a `memory.stat` file.
+bool parse_cgroup_memory_stat(const std::string &contents, const std::string &key,
+                              uint64_t *value_out);
+
 #endif  // CLUSTERING_ADMINISTRATION_MAIN_CACHE_SIZE_HPP_
 
@@ -40,17 +40,20 @@
 
 #include "arch/io/disk.hpp"
 #include "arch/io/openssl.hpp"
+#include "arch/io/tls_sessions.hpp"
 #include "arch/os_signal.hpp"
 #include "arch/runtime/starter.hpp"
 #include "arch/filesystem.hpp"
 
 #include "extproc/extproc_spawner.hpp"
+#include "clustering/administration/main/bench.hpp"
 #include "clustering/administration/main/cache_size.hpp"
 #include "clustering/administration/main/names.hpp"
 #include "clustering/administration/main/options.hpp"
 #include "clustering/administration/main/ports.hpp"
 #include "clustering/administration/main/serve.hpp"
 #include "clustering/administration/main/directory_lock.hpp"
+#include "clustering/administration/main/export_data.hpp"
 #include "clustering/administration/main/version_check.hpp"
 #include "clustering/administration/main/windows_service.hpp"
 #include "clustering/administration/metadata.hpp"
@@ -61,9 +64,11 @@
 #include "clustering/administration/persist/migrate/migrate_v1_16.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_1.hpp"
 #include "clustering/administration/servers/server_metadata.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "containers/scoped.hpp"
 #include "crypto/random.hpp"
 #include "logger.hpp"
+#include "rdb_protocol/query_memory.hpp"
 
 #define RETHINKDB_EXPORT_SCRIPT "rethinkdb-export"
 #define RETHINKDB_IMPORT_SCRIPT "rethinkdb-import"
@@ -481,6 +486,21 @@ optional<int> parse_node_reconnect_timeout_secs_option(
     return optional<int>();
 }
 
+uint64_t parse_slow_query_log_option(
+        const std::map<std::string, options::values_t> &opts) {
+    if (exists_option(opts, "--slow-query-log")) {
+        const std::string threshold_opt = get_single_option(opts, "--slow-query-log");
+        uint64_t threshold_ms;
+        if (!strtou64_strict(threshold_opt, 10, &threshold_ms)) {
+            throw std::runtime_error(strprintf(
+                    "ERROR: slow-query-log should be a number of milliseconds, got '%s'",
+                    threshold_opt.c_str()));
+        }
+        return threshold_ms;
+    }
+    return 0;
+}
+
 /* An empty outer `optional` means the `--cache-size` parameter is not present. An
 empty inner `optional` means the cache size is set to `auto`. */
 optional<optional<uint64_t> > parse_total_cache_size_option(
@@ -512,6 +532,78 @@ optional<optional<uint64_t> > parse_total_cache_size_option(
     }
 }
 
+/* Sets the limit for the rows that queries buffer in memory from `--query-memory-limit`.
+Without the option, there's no limit. */
+void apply_query_memory_limit_option(
+        const std::map<std::string, options::values_t> &opts) {
+    if (exists_option(opts, "--query-memory-limit")) {
+        const std::string limit_opt = get_single_option(opts, "--query-memory-limit");
+        uint64_t limit_megs;
+        if (!strtou64_strict(limit_opt, 10, &limit_megs)
+            || limit_megs > std::numeric_limits<uint64_t>::max() / MEGABYTE) {
+            throw std::runtime_error(strprintf(
+                    "ERROR: query-memory-limit should be a number, got '%s'",
+                    limit_opt.c_str()));
+        }
+        ql::set_query_memory_limit(limit_megs * MEGABYTE);
+    }
+}
+
+/* Returns the memory for compressed copies of evicted pages from
+`--compressed-cache-size`, in bytes.  Without the option there are none. */
+uint64_t parse_compressed_cache_size_option(
+        const std::map<std::string, options::values_t> &opts) {
+    if (!exists_option(opts, "--compressed-cache-size")) {
+        return 0;
+    }
+    const std::string size_opt = get_single_option(opts, "--compressed-cache-size");
+    uint64_t size_megs;
+    if (!strtou64_strict(size_opt, 10, &size_megs)
+        || size_megs > get_max_total_cache_size() / MEGABYTE) {
+        throw std::runtime_error(strprintf(
+                "ERROR: compressed-cache-size should be a number, got '%s'",
+                size_opt.c_str()));
+    }
+    return size_megs * MEGABYTE;
+}
+
+/* Reads `--flash-cache-dir` and `--flash-cache-size`.  Leaves `*dir_out` empty if
+there is no flash cache, and sets it to the directory's absolute path otherwise.
+`*size_out` is per table, in bytes. */
+void parse_flash_cache_options(
+        const std::map<std::string, options::values_t> &opts,
+        std::string *dir_out,
+        uint64_t *size_out) {
+    dir_out->clear();
+    *size_out = 0;
+    if (!exists_option(opts, "--flash-cache-dir")) {
+        if (exists_option(opts, "--flash-cache-size")) {
+            throw std::runtime_error(
+                "ERROR: flash-cache-size was given without flash-cache-dir");
+        }
+        return;
+    }
+    base_path_t dir(get_single_option(opts, "--flash-cache-dir"));
+    if (!check_existence(dir)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: flash cache directory not found '%s'", dir.path().c_str()));
+    }
+    dir.make_absolute();
+
+    uint64_t size_megs = 1024;
+    if (exists_option(opts, "--flash-cache-size")) {
+        const std::string size_opt = get_single_option(opts, "--flash-cache-size");
+        if (!strtou64_strict(size_opt, 10, &size_megs)
+            || size_megs > std::numeric_limits<uint64_t>::max() / MEGABYTE) {
+            throw std::runtime_error(strprintf(
+                    "ERROR: flash-cache-size should be a number, got '%s'",
+                    size_opt.c_str()));
+        }
+    }
+    *dir_out = dir.path();
+    *size_out = size_megs * MEGABYTE;
+}
+
 // Note that this defaults to the peer port if no port is specified
 //  (at the moment, this is only used for parsing --join directives)
 // Possible formats:
@@ -765,7 +857,8 @@ bool configure_web_tls(
         return false;
     }
 
-    return load_tls_key_and_cert(web_tls, *key_file, *cert_file);
+    return load_tls_key_and_cert(web_tls, *key_file, *cert_file)
+        && enable_tls_session_resumption(web_tls, "http");
 }
 
 bool configure_driver_tls(
@@ -802,7 +895,8 @@ bool configure_driver_tls(
             driver_tls, SSL_VERIFY_PEER|SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
     }
 
-    return true;
+    // Drivers often reconnect, so resuming their sessions saves a lot of handshakes.
+    return enable_tls_session_resumption(driver_tls, "driver");
 }
 
 bool configure_cluster_tls(
@@ -832,7 +926,7 @@ bool configure_cluster_tls(
     SSL_CTX_set_verify(
         cluster_tls, SSL_VERIFY_PEER|SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
 
-    return true;
+    return enable_tls_session_resumption(cluster_tls, "cluster");
 }
 
 class fp_wrapper_t {
@@ -997,6 +1091,19 @@ bool initialize_tls_ctx(
         }
     }
 
+    /* With kernel TLS, OpenSSL hands the session keys to the kernel after the
+    handshake, and `SSL_read()` and `SSL_write()` turn into plain reads and writes on
+    the socket that the kernel encrypts and decrypts. OpenSSL falls back to doing the
+    encryption itself if the kernel or the cipher suite doesn't support it. */
+    if (exists_option(opts, "--tls-ktls")) {
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(tls_ctx_out->get(), SSL_OP_ENABLE_KTLS);
+#else
+        logWRN("This build's OpenSSL doesn't support kernel TLS; ignoring "
+               "`--tls-ktls`.");
+#endif
+    }
+
     return true;
 }
 
@@ -1045,6 +1152,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const io_backend_mode_t io_backend_mode,
                           bool *const result_out) {
     server_id_t our_server_id = server_id_t::generate_server_id();
 
@@ -1058,7 +1166,8 @@ void run_rethinkdb_create(const base_path_t &base_path,
     server_config.config.cache_size_bytes = total_cache_size;
     server_config.version = 1;
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests,
+                                io_backend_mode);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1139,6 +1248,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const std::string &initial_password,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const io_backend_mode_t io_backend_mode,
                          const optional<optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -1156,7 +1266,8 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests,
+                                io_backend_mode);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1284,6 +1395,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::string &initial_password,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const io_backend_mode_t io_backend_mode,
                              const optional<optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -1292,7 +1404,8 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend_mode,
+                            total_cache_size,
                             nullptr, nullptr, nullptr, data_directory_lock,
                             result_out);
     } else {
@@ -1328,7 +1441,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         server_config.version = 1;
 
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests,
+                            max_concurrent_io_requests, io_backend_mode,
                             optional<optional<uint64_t> >(),
                             &our_server_id, &server_config, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -1368,6 +1481,17 @@ options::help_section_t get_server_options(std::vector<options::option_t> *optio
     help.add("-t [ --server-tag ] arg",
              "a tag for this server. Can be specified multiple times.");
 
+    options_out->push_back(options::option_t(options::names_t("--backfill-rate-limit"),
+                                             options::OPTIONAL));
+    help.add("--backfill-rate-limit mb",
+             "how many megabytes per second this server may receive from backfills in "
+             "total. Unlimited by default.");
+    options_out->push_back(options::option_t(
+        options::names_t("--backfill-source-rate-limit"), options::OPTIONAL));
+    help.add("--backfill-source-rate-limit mb",
+             "how many megabytes per second this server may receive from backfills "
+             "from any single other server. Unlimited by default.");
+
     return help;
 }
 
@@ -1392,6 +1516,10 @@ options::help_section_t get_log_options(std::vector<options::option_t> *options_
                                             options::OPTIONAL_NO_PARAMETER));
     help.add("--no-update-check", "disable checking for available updates.  Also turns "
              "off anonymous usage data collection.");
+    options_out->push_back(options::option_t(options::names_t("--slow-query-log"),
+                                             options::OPTIONAL));
+    help.add("--slow-query-log ms", "log queries that spend more than this many "
+             "milliseconds evaluating, with a profile for a sample of them");
     return help;
 }
 
@@ -1407,6 +1535,12 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
     help.add("--io-threads n",
              "how many simultaneous I/O operations can happen at the same time");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend pool | io_uring",
+             "how to submit disk I/O to the OS: from a thread pool, or through "
+             "io_uring (if the kernel supports it)");
 #ifndef _WIN32
     // TODO WINDOWS: accept this option, but error out if it is passed
     options_out->push_back(options::option_t(options::names_t("--direct-io"),
@@ -1417,6 +1551,50 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--query-memory-limit"),
+                                             options::OPTIONAL));
+    help.add("--query-memory-limit mb", "how much memory (in megabytes) queries may use "
+        "together to buffer rows for orderBy and distinct; orderBy spills to disk "
+        "beyond it, distinct fails. Unlimited by default.");
+    options_out->push_back(options::option_t(options::names_t("--compressed-cache-size"),
+                                             options::OPTIONAL));
+    help.add("--compressed-cache-size mb", "memory (in megabytes) for compressed copies "
+        "of pages evicted from the cache, on top of the cache size, so that reading "
+        "them again doesn't need the disk. None by default.");
+    options_out->push_back(options::option_t(options::names_t("--flash-cache-dir"),
+                                             options::OPTIONAL));
+    help.add("--flash-cache-dir path", "a directory on fast local storage for a second "
+        "level cache of each table's blocks below the memory cache, useful when the "
+        "data directory is on slower storage. Its files are discarded on restart.");
+    options_out->push_back(options::option_t(options::names_t("--flash-cache-size"),
+                                             options::OPTIONAL));
+    help.add("--flash-cache-size mb", "how large (in megabytes) each table's file in "
+        "the flash cache directory may get. Defaults to 1024.");
+    options_out->push_back(options::option_t(options::names_t("--block-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--block-compression none | zlib",
+             "how to compress the blocks that tables write to disk. Blocks that are "
+             "already on disk can be read back whatever this is set to.");
+    options_out->push_back(options::option_t(options::names_t("--checksum-algorithm"),
+                                             options::OPTIONAL,
+                                             "fletcher64"));
+    help.add("--checksum-algorithm fletcher64 | crc32c",
+             "how the files of new tables checksum their blocks. Only applies when a "
+             "table's file is created; existing files keep their algorithm.");
+    options_out->push_back(options::option_t(options::names_t("--cache-balancer"),
+                                             options::OPTIONAL,
+                                             "access-count"));
+    help.add("--cache-balancer access-count | marginal-gain",
+             "how the cache is divided between tables: by how much each one reads, or "
+             "by how much each one would benefit from more memory");
+    options_out->push_back(options::option_t(options::names_t("--cache-eviction-policy"),
+                                             options::OPTIONAL,
+                                             "scan-resistant"));
+    help.add("--cache-eviction-policy scan-resistant | lru",
+             "how the tables' caches pick pages to evict: keeping pages that were only "
+             "read once by a scan from pushing out the ones read repeatedly, or just "
+             "the least recently used ones");
     return help;
 }
 
@@ -1594,6 +1772,12 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              strprintf("%d", port_defaults::reql_port)));
     help.add("--driver-port port", "port for rethinkdb protocol client drivers");
 
+    options_out->push_back(options::option_t(options::names_t("--driver-reuse-port"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--driver-reuse-port", "accept client driver connections on every thread "
+             "by binding the driver port with SO_REUSEPORT; other processes of the same "
+             "user can then bind that port too without an error");
+
     options_out->push_back(options::option_t(options::names_t("--port-offset", "-o"),
                                              options::OPTIONAL,
                                              strprintf("%d", port_defaults::port_offset)));
@@ -1624,6 +1808,11 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                                     "before giving up, the default is "
                                                     "24 hours");
 
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--cluster-compression", "compress large messages to other servers that "
+             "also have this enabled, which saves bandwidth at the cost of CPU time");
+
     return help;
 }
 
@@ -1633,6 +1822,17 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+
+    options_out->push_back(options::option_t(options::names_t("--pin-threads"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--pin-threads", "pin each thread to a CPU, filling one NUMA node at a "
+             "time, and keep each table's threads on one node");
+
+    options_out->push_back(options::option_t(options::names_t("--busy-poll"),
+                                             options::OPTIONAL));
+    help.add("--busy-poll usecs", "keep idle threads polling for work for this many "
+             "microseconds before they go to sleep, which lowers latency at the cost "
+             "of busy CPUs");
     return help;
 }
 
@@ -1647,6 +1847,28 @@ MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t>
     return true;
 }
 
+const uint64_t MAX_BUSY_POLL_USECS = 1000000;
+
+// Returns the time in nanoseconds.
+int64_t parse_busy_poll_option(const std::map<std::string, options::values_t> &opts) {
+    if (!exists_option(opts, "--busy-poll")) {
+        return 0;
+    }
+    const std::string busy_poll_opt = get_single_option(opts, "--busy-poll");
+    uint64_t busy_poll_usecs;
+    if (!strtou64_strict(busy_poll_opt, 10, &busy_poll_usecs)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: busy-poll should be a number, got '%s'",
+                busy_poll_opt.c_str()));
+    }
+    if (busy_poll_usecs > MAX_BUSY_POLL_USECS) {
+        throw std::runtime_error(strprintf(
+                "ERROR: busy-poll is too large. Must be at most %" PRIu64,
+                MAX_BUSY_POLL_USECS));
+    }
+    return static_cast<int64_t>(busy_poll_usecs) * 1000;
+}
+
 options::help_section_t get_service_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Service options");
     options_out->push_back(options::option_t(options::names_t("--pid-file"),
@@ -1730,6 +1952,8 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL));
     options_out->push_back(options::option_t(options::names_t("--tls-dhparams"),
                                              options::OPTIONAL));
+    options_out->push_back(options::option_t(options::names_t("--tls-ktls"),
+                                             options::OPTIONAL_NO_PARAMETER));
     help.add(
         "--tls-min-protocol protocol",
         "the minimum TLS protocol version that the server accepts; options are "
@@ -1744,6 +1968,10 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
         "--tls-dhparams dhparams_filename",
         "provide parameters for DHE key agreement; REQUIRED if using DHE cipher suites; "
         "at least 2048-bit recommended");
+    help.add(
+        "--tls-ktls",
+        "let the kernel encrypt and decrypt TLS connections when the kernel and the "
+        "cipher suite support it");
 
     return help;
 }
@@ -1821,6 +2049,99 @@ void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_
     help_out->push_back(get_config_file_options(options_out));
 }
 
+void get_rethinkdb_export_data_options(std::vector<options::help_section_t> *help_out,
+                                       std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Export options");
+    options_out->push_back(options::option_t(options::names_t("--directory", "-d"),
+                                             options::OPTIONAL,
+                                             "rethinkdb_data"));
+    help.add("-d [ --directory ] path", "the data directory of a server that isn't "
+             "running");
+    options_out->push_back(options::option_t(options::names_t("--output", "-o"),
+                                             options::OPTIONAL,
+                                             "rethinkdb_export"));
+    help.add("-o [ --output ] path", "the directory to write the files to");
+    options_out->push_back(options::option_t(options::names_t("--table"),
+                                             options::OPTIONAL_REPEAT));
+    help.add("--table id", "export only the table with this id (may be repeated), "
+             "defaults to every table in the data directory");
+    options_out->push_back(options::option_t(options::names_t("--gzip"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--gzip", "compress the files with gzip");
+    help_out->push_back(help);
+    help_out->push_back(get_help_options(options_out));
+}
+
+void get_rethinkdb_bench_options(std::vector<options::help_section_t> *help_out,
+                                 std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Benchmark options");
+    options_out->push_back(options::option_t(options::names_t("--connect", "-c"),
+                                             options::OPTIONAL,
+                                             "localhost"));
+    help.add("-c [ --connect ] host[:port]",
+             "the server to send queries to, the port defaults to the driver port");
+    options_out->push_back(options::option_t(options::names_t("--password"),
+                                             options::OPTIONAL,
+                                             ""));
+    help.add("--password password", "the password of the admin user");
+    options_out->push_back(options::option_t(options::names_t("--table"),
+                                             options::OPTIONAL,
+                                             "bench.usertable"));
+    help.add("--table db.table", "the table to run the benchmark on");
+    options_out->push_back(options::option_t(options::names_t("--workload"),
+                                             options::OPTIONAL,
+                                             "b"));
+    help.add("--workload spec", "one of the YCSB workloads 'a' to 'e', or weights "
+             "like 'get=90,range=2,insert=3,update=5'");
+    options_out->push_back(options::option_t(options::names_t("--records"),
+                                             options::OPTIONAL,
+                                             "100000"));
+    help.add("--records n", "the number of rows that the workload reads and updates");
+    options_out->push_back(options::option_t(options::names_t("--load"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--load", "create the table if necessary and insert the rows first");
+    options_out->push_back(options::option_t(options::names_t("--operations"),
+                                             options::OPTIONAL,
+                                             "10000"));
+    help.add("--operations n", "the number of queries that every client sends");
+    options_out->push_back(options::option_t(options::names_t("--concurrency"),
+                                             options::OPTIONAL,
+                                             "16"));
+    help.add("--concurrency n", "the number of clients, each on its own connection "
+             "with one query in flight");
+    options_out->push_back(options::option_t(options::names_t("--changefeeds"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--changefeeds n", "the number of extra connections that follow a "
+             "changefeed on the table");
+    options_out->push_back(options::option_t(options::names_t("--distribution"),
+                                             options::OPTIONAL,
+                                             "zipfian"));
+    help.add("--distribution name", "how rows are picked, 'zipfian' or 'uniform'");
+    options_out->push_back(options::option_t(options::names_t("--value-size"),
+                                             options::OPTIONAL,
+                                             "100"));
+    help.add("--value-size bytes", "the size of the value written by inserts and "
+             "updates");
+    options_out->push_back(options::option_t(options::names_t("--range-size"),
+                                             options::OPTIONAL,
+                                             "10"));
+    help.add("--range-size n", "the number of rows that a range query reads");
+    options_out->push_back(options::option_t(options::names_t("--seed"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--seed n", "runs with the same seed and options send the same queries");
+    options_out->push_back(options::option_t(options::names_t("--record"),
+                                             options::OPTIONAL));
+    help.add("--record file", "write the queries to a trace file before running them");
+    options_out->push_back(options::option_t(options::names_t("--replay"),
+                                             options::OPTIONAL));
+    help.add("--replay file", "run the queries of a trace file instead of generating "
+             "them, with one client for each client of the recorded run");
+    help_out->push_back(help);
+    help_out->push_back(get_help_options(options_out));
+}
+
 std::map<std::string, options::values_t> parse_config_file_flat(const std::string &config_filepath,
                                                                 const std::vector<options::option_t> &options) {
     std::string file;
@@ -1899,6 +2220,112 @@ file_direct_io_mode_t parse_direct_io_mode_option(const std::map<std::string, op
         file_direct_io_mode_t::buffered_desired;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      io_backend_mode_t *io_backend_mode_out) {
+    const std::string backend = get_single_option(opts, "--io-backend");
+    if (backend == "pool") {
+        *io_backend_mode_out = io_backend_mode_t::pool;
+    } else if (backend == "io_uring") {
+        *io_backend_mode_out = io_backend_mode_t::io_uring;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be either 'pool' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_cache_balancer_option(
+        const std::map<std::string, options::values_t> &opts,
+        cache_balancer_mode_t *cache_balancer_mode_out) {
+    const std::string mode = get_single_option(opts, "--cache-balancer");
+    if (mode == "access-count") {
+        *cache_balancer_mode_out = cache_balancer_mode_t::access_count;
+    } else if (mode == "marginal-gain") {
+        *cache_balancer_mode_out = cache_balancer_mode_t::marginal_gain;
+    } else {
+        fprintf(stderr, "ERROR: cache-balancer must be either 'access-count' or "
+                "'marginal-gain'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_block_compression_option(
+        const std::map<std::string, options::values_t> &opts,
+        block_compression_t *block_compression_out) {
+    const std::string compression = get_single_option(opts, "--block-compression");
+    if (compression == "none") {
+        *block_compression_out = block_compression_t::none;
+    } else if (compression == "zlib") {
+        *block_compression_out = block_compression_t::zlib;
+    } else {
+        fprintf(stderr, "ERROR: block-compression must be either 'none' or 'zlib'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_checksum_algorithm_option(
+        const std::map<std::string, options::values_t> &opts,
+        checksum_algorithm_t *checksum_algorithm_out) {
+    const std::string algorithm = get_single_option(opts, "--checksum-algorithm");
+    if (algorithm == "fletcher64") {
+        *checksum_algorithm_out = checksum_algorithm_t::fletcher64;
+    } else if (algorithm == "crc32c") {
+        *checksum_algorithm_out = checksum_algorithm_t::crc32c;
+    } else {
+        fprintf(stderr, "ERROR: checksum-algorithm must be either 'fletcher64' or "
+                "'crc32c'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_cache_eviction_policy_option(
+        const std::map<std::string, options::values_t> &opts,
+        eviction_policy_t *eviction_policy_out) {
+    const std::string policy = get_single_option(opts, "--cache-eviction-policy");
+    if (policy == "scan-resistant") {
+        *eviction_policy_out = eviction_policy_t::scan_resistant;
+    } else if (policy == "lru") {
+        *eviction_policy_out = eviction_policy_t::lru;
+    } else {
+        fprintf(stderr, "ERROR: cache-eviction-policy must be either 'scan-resistant' "
+                "or 'lru'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_backfill_rate_limit_option(
+        const std::map<std::string, options::values_t> &opts,
+        const std::string &option_name,
+        uint64_t *bytes_per_sec_out) {
+    *bytes_per_sec_out = 0;
+    if (exists_option(opts, option_name)) {
+        const std::string limit_opt = get_single_option(opts, option_name);
+        uint64_t limit_megs;
+        if (!strtou64_strict(limit_opt, 10, &limit_megs) || limit_megs == 0
+                || limit_megs > std::numeric_limits<uint64_t>::max() / MEGABYTE) {
+            fprintf(stderr, "ERROR: %s should be a positive number, got '%s'\n",
+                    option_name.c_str() + 2, limit_opt.c_str());
+            return false;
+        }
+        *bytes_per_sec_out = limit_megs * MEGABYTE;
+    }
+    return true;
+}
+
+MUST_USE bool parse_backfill_rate_limits_options(
+        const std::map<std::string, options::values_t> &opts,
+        backfill_rate_limits_t *rate_limits_out) {
+    return parse_backfill_rate_limit_option(
+            opts, "--backfill-rate-limit", &rate_limits_out->total_bytes_per_sec)
+        && parse_backfill_rate_limit_option(
+            opts, "--backfill-source-rate-limit",
+            &rate_limits_out->per_source_bytes_per_sec);
+}
+
 int main_rethinkdb_create(int argc, char *argv[]) {
     std::vector<options::option_t> options;
     std::vector<options::help_section_t> help;
@@ -1949,6 +2376,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
+        io_backend_mode_t io_backend_mode;
+        if (!parse_io_backend_option(opts, &io_backend_mode)) {
+            return EXIT_FAILURE;
+        }
+
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_create,
                                      base_path,
@@ -1958,6 +2390,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend_mode,
                                      &result),
                            num_workers);
 
@@ -2051,16 +2484,47 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         if (!parse_cores_option(opts, &num_workers)) {
             return EXIT_FAILURE;
         }
+        const int64_t busy_poll_nanos = parse_busy_poll_option(opts);
 
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
         }
 
+        cache_balancer_mode_t cache_balancer_mode;
+        if (!parse_cache_balancer_option(opts, &cache_balancer_mode)) {
+            return EXIT_FAILURE;
+        }
+
+        eviction_policy_t cache_eviction_policy;
+        if (!parse_cache_eviction_policy_option(opts, &cache_eviction_policy)) {
+            return EXIT_FAILURE;
+        }
+
+        backfill_rate_limits_t backfill_rate_limits;
+        if (!parse_backfill_rate_limits_options(opts, &backfill_rate_limits)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<optional<uint64_t> > total_cache_size =
             parse_total_cache_size_option(opts);
+        apply_query_memory_limit_option(opts);
+        const uint64_t compressed_cache_size = parse_compressed_cache_size_option(opts);
+        std::string flash_cache_dir;
+        uint64_t flash_cache_size;
+        parse_flash_cache_options(opts, &flash_cache_dir, &flash_cache_size);
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
+        checksum_algorithm_t checksum_algorithm;
+        if (!parse_checksum_algorithm_option(opts, &checksum_algorithm)) {
+            return EXIT_FAILURE;
+        }
 
         optional<int> join_delay_secs = parse_join_delay_secs_option(opts);
         optional<int> node_reconnect_timeout_secs =
@@ -2107,10 +2571,26 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                cache_balancer_mode,
+                                cache_eviction_policy,
+                                compressed_cache_size,
+                                flash_cache_dir,
+                                flash_cache_size,
+                                block_compression,
+                                checksum_algorithm,
+                                backfill_rate_limits,
+                                exists_option(opts, "--cluster-compression"),
+                                exists_option(opts, "--driver-reuse-port"),
+                                parse_slow_query_log_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
+        io_backend_mode_t io_backend_mode;
+        if (!parse_io_backend_option(opts, &io_backend_mode)) {
+            return EXIT_FAILURE;
+        }
+
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_serve,
                                      base_path,
@@ -2118,13 +2598,16 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend_mode,
                                      total_cache_size,
                                      static_cast<server_id_t*>(nullptr),
                                      static_cast<server_config_versioned_t *>(nullptr),
                                      static_cast<cluster_semilattice_metadata_t*>(nullptr),
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"),
+                           busy_poll_nanos);
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
         output_named_error(ex, help);
@@ -2210,7 +2693,18 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                cache_balancer_mode_t::access_count,
+                                eviction_policy_t::scan_resistant,
+                                0,
+                                std::string(),
+                                0,
+                                block_compression_t::none,
+                                checksum_algorithm_t::fletcher64,
+                                backfill_rate_limits_t(),
+                                exists_option(opts, "--cluster-compression"),
+                                exists_option(opts, "--driver-reuse-port"),
+                                parse_slow_query_log_option(opts));
 
         bool result;
         run_in_thread_pool(
@@ -2246,6 +2740,171 @@ MUST_USE bool split_db_table(const std::string &db_table, std::string *db_name_o
     return true;
 }
 
+void run_rethinkdb_export_data(const base_path_t &base_path,
+                               const std::set<namespace_id_t> &tables,
+                               const std::string &output_directory,
+                               bool gzip,
+                               bool *result_out) {
+    *result_out = export_table_files(base_path, tables, output_directory, gzip);
+}
+
+int main_rethinkdb_export_data(int argc, char *argv[]) {
+    std::vector<options::option_t> options;
+    std::vector<options::help_section_t> help;
+    get_rethinkdb_export_data_options(&help, &options);
+
+    try {
+        std::map<std::string, options::values_t> opts =
+            parse_commands_deep(argc - 2, argv + 2, options);
+
+        if (handle_help_or_version_option(opts, &help_rethinkdb_export_data)) {
+            return EXIT_SUCCESS;
+        }
+
+        options::verify_option_counts(options, opts);
+
+        base_path_t base_path(get_single_option(opts, "--directory"));
+        const std::string output_directory = get_single_option(opts, "--output");
+        const bool gzip = exists_option(opts, "--gzip");
+
+        // This makes sure that no server is using the directory while we read it.
+        bool created;
+        directory_lock_t data_directory_lock(base_path, false, &created);
+
+        std::set<namespace_id_t> tables;
+        for (const std::string &table : all_options(opts, "--table")) {
+            namespace_id_t table_id;
+            if (!str_to_uuid(table, &table_id)) {
+                fprintf(stderr, "ERROR: '%s' is not a table id\n", table.c_str());
+                return EXIT_FAILURE;
+            }
+            tables.insert(table_id);
+        }
+        if (tables.empty()) {
+            tables = list_table_files(base_path);
+        }
+
+        if (mkdir(output_directory.c_str(), 0755) != 0 && get_errno() != EEXIST) {
+            fprintf(stderr, "ERROR: Could not create the directory '%s': %s\n",
+                    output_directory.c_str(), errno_string(get_errno()).c_str());
+            return EXIT_FAILURE;
+        }
+
+        bool result;
+        run_in_thread_pool(
+            std::bind(&run_rethinkdb_export_data, base_path, tables, output_directory,
+                      gzip, &result),
+            std::min(get_cpu_count(), CPU_SHARDING_FACTOR));
+        return result ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const options::named_error_t &ex) {
+        output_named_error(ex, help);
+        fprintf(stderr, "Run 'rethinkdb help export-data' for help on the command\n");
+    } catch (const options::option_error_t &ex) {
+        output_sourced_error(ex);
+        fprintf(stderr, "Run 'rethinkdb help export-data' for help on the command\n");
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+    }
+    return EXIT_FAILURE;
+}
+
+uint64_t parse_bench_number_option(
+        const std::map<std::string, options::values_t> &opts, const std::string &name) {
+    const std::string value = get_single_option(opts, name);
+    uint64_t number;
+    if (!strtou64_strict(value, 10, &number) || number > INT64_MAX) {
+        throw std::runtime_error(strprintf(
+                "ERROR: %s should be a number, got '%s'", name.c_str(), value.c_str()));
+    }
+    return number;
+}
+
+void run_rethinkdb_bench(const bench_config_t *config, bool *result_out) {
+    *result_out = run_bench(*config);
+}
+
+int main_rethinkdb_bench(int argc, char *argv[]) {
+    std::vector<options::option_t> options;
+    std::vector<options::help_section_t> help;
+    get_rethinkdb_bench_options(&help, &options);
+
+    try {
+        std::map<std::string, options::values_t> opts =
+            parse_commands_deep(argc - 2, argv + 2, options);
+
+        if (handle_help_or_version_option(opts, &help_rethinkdb_bench)) {
+            return EXIT_SUCCESS;
+        }
+
+        options::verify_option_counts(options, opts);
+
+        bench_config_t config;
+        config.server = parse_host_and_port(
+            "the command line", "--connect", get_single_option(opts, "--connect"),
+            port_defaults::reql_port);
+        config.password = get_single_option(opts, "--password");
+        if (!split_db_table(get_single_option(opts, "--table"),
+                            &config.db, &config.table)) {
+            fprintf(stderr, "ERROR: --table should be given as db.table\n");
+            return EXIT_FAILURE;
+        }
+        const std::string workload = get_single_option(opts, "--workload");
+        if (!parse_bench_mix(workload, &config)) {
+            fprintf(stderr, "ERROR: Unknown workload '%s'\n", workload.c_str());
+            return EXIT_FAILURE;
+        }
+        config.records = parse_bench_number_option(opts, "--records");
+        config.load = exists_option(opts, "--load");
+        config.operations = parse_bench_number_option(opts, "--operations");
+        config.concurrency = get_single_int(opts, "--concurrency");
+        config.changefeeds = get_single_int(opts, "--changefeeds");
+        const std::string distribution = get_single_option(opts, "--distribution");
+        if (distribution != "zipfian" && distribution != "uniform") {
+            fprintf(stderr, "ERROR: --distribution should be 'zipfian' or 'uniform'\n");
+            return EXIT_FAILURE;
+        }
+        config.zipfian = distribution == "zipfian";
+        config.value_size = parse_bench_number_option(opts, "--value-size");
+        config.range_size = parse_bench_number_option(opts, "--range-size");
+        config.seed = parse_bench_number_option(opts, "--seed");
+        config.record_path = get_optional_option(opts, "--record").value_or("");
+        config.replay_path = get_optional_option(opts, "--replay").value_or("");
+
+        if (config.concurrency <= 0 || config.changefeeds < 0) {
+            fprintf(stderr, "ERROR: --concurrency must be positive and --changefeeds "
+                    "must not be negative\n");
+            return EXIT_FAILURE;
+        }
+        if (!config.record_path.empty() && !config.replay_path.empty()) {
+            fprintf(stderr, "ERROR: --record and --replay can't be used together\n");
+            return EXIT_FAILURE;
+        }
+        const double *mix = config.mix;
+        if (config.replay_path.empty() && config.records == 0
+            && (mix[static_cast<size_t>(bench_op_t::GET)] != 0
+                || mix[static_cast<size_t>(bench_op_t::RANGE)] != 0
+                || mix[static_cast<size_t>(bench_op_t::UPDATE)] != 0)) {
+            fprintf(stderr, "ERROR: Only inserts can run on a table without "
+                    "--records\n");
+            return EXIT_FAILURE;
+        }
+
+        bool result;
+        run_in_thread_pool(std::bind(&run_rethinkdb_bench, &config, &result),
+                           std::min(config.concurrency, get_cpu_count()));
+        return result ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const options::named_error_t &ex) {
+        output_named_error(ex, help);
+        fprintf(stderr, "Run 'rethinkdb help bench' for help on the command\n");
+    } catch (const options::option_error_t &ex) {
+        output_sourced_error(ex);
+        fprintf(stderr, "Run 'rethinkdb help bench' for help on the command\n");
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+    }
+    return EXIT_FAILURE;
+}
+
 void run_backup_script(const std::string& script_name, char * const arguments[]) {
     int res = execvp(script_name.c_str(), arguments);
     if (res == -1) {
@@ -2322,12 +2981,28 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         if (!parse_cores_option(opts, &num_workers)) {
             return EXIT_FAILURE;
         }
+        const int64_t busy_poll_nanos = parse_busy_poll_option(opts);
 
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
         }
 
+        cache_balancer_mode_t cache_balancer_mode;
+        if (!parse_cache_balancer_option(opts, &cache_balancer_mode)) {
+            return EXIT_FAILURE;
+        }
+
+        eviction_policy_t cache_eviction_policy;
+        if (!parse_cache_eviction_policy_option(opts, &cache_eviction_policy)) {
+            return EXIT_FAILURE;
+        }
+
+        backfill_rate_limits_t backfill_rate_limits;
+        if (!parse_backfill_rate_limits_options(opts, &backfill_rate_limits)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<int> join_delay_secs = parse_join_delay_secs_option(opts);
@@ -2365,6 +3040,21 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
 
         optional<optional<uint64_t> > total_cache_size =
             parse_total_cache_size_option(opts);
+        apply_query_memory_limit_option(opts);
+        const uint64_t compressed_cache_size = parse_compressed_cache_size_option(opts);
+        std::string flash_cache_dir;
+        uint64_t flash_cache_size;
+        parse_flash_cache_options(opts, &flash_cache_dir, &flash_cache_size);
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
+        checksum_algorithm_t checksum_algorithm;
+        if (!parse_checksum_algorithm_option(opts, &checksum_algorithm)) {
+            return EXIT_FAILURE;
+        }
 
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
@@ -2400,10 +3090,26 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                cache_balancer_mode,
+                                cache_eviction_policy,
+                                compressed_cache_size,
+                                flash_cache_dir,
+                                flash_cache_size,
+                                block_compression,
+                                checksum_algorithm,
+                                backfill_rate_limits,
+                                exists_option(opts, "--cluster-compression"),
+                                exists_option(opts, "--driver-reuse-port"),
+                                parse_slow_query_log_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
+        io_backend_mode_t io_backend_mode;
+        if (!parse_io_backend_option(opts, &io_backend_mode)) {
+            return EXIT_FAILURE;
+        }
+
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_porcelain,
                                      base_path,
@@ -2412,12 +3118,15 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend_mode,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"),
+                           busy_poll_nanos);
 
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
@@ -2454,6 +3163,8 @@ void help_rethinkdb_porcelain() {
     printf("    'rethinkdb restore': import compressed data into an existing cluster\n");
     printf("    'rethinkdb index-rebuild': rebuild outdated secondary indexes\n");
     printf("    'rethinkdb repl': start a Python REPL with the RethinkDB driver\n");
+    printf("    'rethinkdb export-data': export the tables of a stopped server\n");
+    printf("    'rethinkdb bench': run a benchmark workload against a cluster\n");
 #ifdef _WIN32
     printf("    'rethinkdb install-service': install RethinkDB as a Windows service\n");
     printf("    'rethinkdb remove-service': remove a previously installed Windows service\n");
@@ -2496,6 +3207,31 @@ void help_rethinkdb_proxy() {
     printf("%s", format_help(help_sections).c_str());
 }
 
+void help_rethinkdb_export_data() {
+    std::vector<options::help_section_t> help_sections;
+    {
+        std::vector<options::option_t> options;
+        get_rethinkdb_export_data_options(&help_sections, &options);
+    }
+
+    printf("'rethinkdb export-data' writes the documents of the tables in a data "
+           "directory to\nnewline-delimited JSON files, one for every shard of a "
+           "table's file.  The server\nusing the directory must be stopped.\n");
+    printf("%s", format_help(help_sections).c_str());
+}
+
+void help_rethinkdb_bench() {
+    std::vector<options::help_section_t> help_sections;
+    {
+        std::vector<options::option_t> options;
+        get_rethinkdb_bench_options(&help_sections, &options);
+    }
+
+    printf("'rethinkdb bench' sends a YCSB-style workload to a server and reports the "
+           "throughput\nand the latency percentiles of every kind of query.\n");
+    printf("%s", format_help(help_sections).c_str());
+}
+
 void help_rethinkdb_export() {
     char help_arg[] = "--help";
     char dummy_arg[] = RETHINKDB_EXPORT_SCRIPT;
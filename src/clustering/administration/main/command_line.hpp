@@ -2,6 +2,14 @@
 #ifndef CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_
 #define CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arch/io/openssl.hpp"
+#include "clustering/administration/main/options.hpp"
+
 void print_version_message();
 
 int main_rethinkdb_create(int argc, char *argv[]);
@@ -14,6 +22,8 @@ int main_rethinkdb_dump(int argc, char *argv[]);
 int main_rethinkdb_restore(int argc, char *argv[]);
 int main_rethinkdb_index_rebuild(int argc, char *argv[]);
 int main_rethinkdb_repl(int argc, char *argv[]);
+int main_rethinkdb_export_data(int argc, char *argv[]);
+int main_rethinkdb_bench(int argc, char *argv[]);
 #ifdef _WIN32
 int main_rethinkdb_run_service(int argc, char *argv[]);
 int main_rethinkdb_install_service(int argc, char *argv[]);
@@ -30,9 +40,21 @@ void help_rethinkdb_dump();
 void help_rethinkdb_restore();
 void help_rethinkdb_index_rebuild();
 void help_rethinkdb_repl();
+void help_rethinkdb_export_data();
+void help_rethinkdb_bench();
 #ifdef _WIN32
 void help_rethinkdb_install_service();
 void help_rethinkdb_remove_service();
 #endif /* _WIN32 */
 
+#ifdef ENABLE_TLS
+// These are used by `main_rethinkdb_serve()` and friends, and by the unit tests.
+options::help_section_t get_tls_options(std::vector<options::option_t> *options_out);
+// Builds a TLS context from the `--tls-*` options in `opts`.  On failure, logs the
+// error and returns false.
+bool initialize_tls_ctx(
+    const std::map<std::string, options::values_t> &opts,
+    std::shared_ptr<tls_ctx_t> *tls_ctx_out);
+#endif /* ENABLE_TLS */
+
 #endif /* CLUSTERING_ADMINISTRATION_MAIN_COMMAND_LINE_HPP_ */
@@ -0,0 +1,138 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/main/export_data.hpp"
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/os_signal.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
+#include "perfmon/core.hpp"
+#include "rdb_protocol/store.hpp"
+#include "rdb_protocol/store_export.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "serializer/translator.hpp"
+#include "threading.hpp"
+
+// The export reads every block once, so the caches don't need to be big.
+static const uint64_t EXPORT_CACHE_SIZE_PER_STORE = 64 * MEGABYTE;
+
+std::set<namespace_id_t> list_table_files(const base_path_t &directory) {
+    DIR *dir = opendir(directory.path().c_str());
+    if (dir == nullptr) {
+        throw std::runtime_error(strprintf(
+            "Could not read the directory '%s': %s", directory.path().c_str(),
+            errno_string(get_errno()).c_str()));
+    }
+    std::set<namespace_id_t> tables;
+    while (struct dirent *entry = readdir(dir)) {
+        // Table files are named after the table's id; nothing else in there is
+        // named just that.
+        namespace_id_t table_id;
+        if (str_to_uuid(entry->d_name, &table_id)) {
+            tables.insert(table_id);
+        }
+    }
+    closedir(dir);
+    return tables;
+}
+
+static bool export_table_file(const base_path_t &directory,
+                              const namespace_id_t &table_id,
+                              io_backender_t *io_backender,
+                              cache_balancer_t *balancer,
+                              const std::string &output_directory,
+                              bool gzip,
+                              signal_t *interruptor) {
+    const std::string table_name = uuid_to_str(table_id);
+    const serializer_filepath_t path(directory, table_name);
+    if (access(path.permanent_path().c_str(), R_OK) != 0) {
+        fprintf(stderr, "ERROR: There is no file for table %s in '%s'\n",
+                table_name.c_str(), directory.path().c_str());
+        return false;
+    }
+
+    filepath_file_opener_t file_opener(path, io_backender);
+    log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                &file_opener,
+                                &get_global_perfmon_collection());
+    std::vector<serializer_t *> ptrs;
+    ptrs.push_back(&serializer);
+    serializer_multiplexer_t multiplexer(ptrs);
+
+    std::vector<int64_t> rows(CPU_SHARDING_FACTOR, 0);
+    std::vector<std::string> errors(CPU_SHARDING_FACTOR);
+    pmap(CPU_SHARDING_FACTOR, [&](int ix) {
+        const threadnum_t thread(ix % get_num_threads());
+        cross_thread_signal_t ct_interruptor(interruptor, thread);
+        on_thread_t thread_switcher(thread);
+        const std::string file_name = strprintf(
+            "%s/%s.%d.json%s", output_directory.c_str(), table_name.c_str(), ix,
+            gzip ? ".gz" : "");
+        try {
+            /* With `LEAVE_ALONE` the store doesn't resume building secondary indexes,
+            so opening it doesn't write anything. */
+            store_t store(cpu_sharding_subspace(ix),
+                          multiplexer.proxies[ix],
+                          balancer,
+                          strprintf("export_shard_%d", ix),
+                          false,
+                          &get_global_perfmon_collection(),
+                          nullptr,
+                          io_backender,
+                          directory,
+                          table_id,
+                          update_sindexes_t::LEAVE_ALONE,
+                          which_cpu_shard_t{ix, CPU_SHARDING_FACTOR});
+            ndjson_file_writer_t writer(file_name, gzip);
+            rows[ix] = export_store_rows(&store, &writer, &ct_interruptor);
+            writer.finish();
+        } catch (const interrupted_exc_t &) {
+            errors[ix] = "Interrupted.";
+        } catch (const std::exception &ex) {
+            errors[ix] = ex.what();
+        }
+    });
+
+    int64_t total_rows = 0;
+    bool ok = true;
+    for (size_t i = 0; i < errors.size(); ++i) {
+        total_rows += rows[i];
+        if (!errors[i].empty()) {
+            fprintf(stderr, "ERROR: Exporting shard %zu of table %s failed: %s\n",
+                    i, table_name.c_str(), errors[i].c_str());
+            ok = false;
+        }
+    }
+    if (ok) {
+        printf("Exported %" PRIi64 " rows of table %s\n", total_rows, table_name.c_str());
+    }
+    return ok;
+}
+
+bool export_table_files(const base_path_t &directory,
+                        const std::set<namespace_id_t> &tables,
+                        const std::string &output_directory,
+                        bool gzip) {
+    os_signal_cond_t sigint_cond;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(EXPORT_CACHE_SIZE_PER_STORE);
+    bool ok = true;
+    for (const namespace_id_t &table_id : tables) {
+        if (sigint_cond.is_pulsed()) {
+            return false;
+        }
+        ok = export_table_file(directory, table_id, &io_backender, &balancer,
+                               output_directory, gzip, &sigint_cond) && ok;
+    }
+    return ok;
+}
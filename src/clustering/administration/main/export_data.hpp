@@ -0,0 +1,26 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_MAIN_EXPORT_DATA_HPP_
+#define CLUSTERING_ADMINISTRATION_MAIN_EXPORT_DATA_HPP_
+
+#include <set>
+#include <string>
+
+#include "containers/uuid.hpp"
+#include "paths.hpp"
+
+/* Lists the tables that have a file in the data directory. */
+std::set<namespace_id_t> list_table_files(const base_path_t &directory);
+
+/* Exports the rows of the given tables from the table files in `directory`, which no
+server may be using, into `output_directory`.  Every table file holds
+`CPU_SHARDING_FACTOR` B-trees, which are exported in parallel, each to its own file
+`<table id>.<n>.json`, with `.gz` at the end if `gzip` is set.  The files are
+newline-delimited JSON, one document per line, so `rethinkdb import` can load them.
+Must be called in the thread pool.  Returns false and prints an error if an export
+failed. */
+bool export_table_files(const base_path_t &directory,
+                        const std::set<namespace_id_t> &tables,
+                        const std::string &output_directory,
+                        bool gzip);
+
+#endif  // CLUSTERING_ADMINISTRATION_MAIN_EXPORT_DATA_HPP_
@@ -1,6 +1,7 @@
 // Copyright 2010-2016 RethinkDB, all rights reserved.
 #include "clustering/administration/main/memory_checker.hpp"
 
+#include <inttypes.h>
 #include <math.h>
 #ifndef _WIN32
 #include <sys/resource.h>
@@ -8,6 +9,7 @@
 
 #include "clustering/administration/metadata.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
+#include "containers/buf_arena.hpp"
 #include "logger.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
@@ -17,11 +19,17 @@ static const int64_t reset_checks = 10;
 
 static const int64_t practice_runs = 2;
 
+// We report an issue when the arena for block buffers holds at least this much memory
+// that isn't used by any buffer, and that's more than this fraction of its memory.
+static const uint64_t buf_arena_overhead_threshold = 1024 * MEGABYTE;
+static const double buf_arena_fragmentation_threshold = 0.5;
+
 memory_checker_t::memory_checker_t() :
     checks_until_reset(0),
     swap_usage(0),
     print_log_message(true),
     practice_runs_remaining(practice_runs),
+    buf_arena_issue_reported(false),
     timer(delay_time, this)
 {
     coro_t::spawn_sometime(std::bind(&memory_checker_t::do_check,
@@ -61,10 +69,10 @@ void memory_checker_t::do_check(UNUSED auto_drainer_t::lock_t keepalive) {
             print_log_message = false;
         }
         checks_until_reset = reset_checks;
-        memory_issue_tracker.report_error(error_message);
+        memory_issue_tracker.report_error(memory_issue_source_t::swap, error_message);
     } else if (checks_until_reset == 0) {
         // We haven't had more than 200 major page faults per minute for the last 10m.
-        memory_issue_tracker.report_success();
+        memory_issue_tracker.report_success(memory_issue_source_t::swap);
         print_log_message = true;
     }
 
@@ -76,5 +84,30 @@ void memory_checker_t::do_check(UNUSED auto_drainer_t::lock_t keepalive) {
     if (practice_runs_remaining > 0) {
         --practice_runs_remaining;
     }
+
+    check_buf_arena();
+}
+
+void memory_checker_t::check_buf_arena() {
+    const buf_arena_stats_t stats = get_buf_arena_stats();
+    const uint64_t overhead = stats.touched_bytes - stats.allocated_bytes;
+    if (overhead >= buf_arena_overhead_threshold
+        && stats.fragmentation() >= buf_arena_fragmentation_threshold) {
+        const std::string message = strprintf(
+            "The cache's block buffers take up %" PRIu64 " MB of memory, but only %"
+            PRIu64 " MB of it are in use (%.0f%% fragmentation).  The rest will be "
+            "freed as the cache evicts or reloads the remaining blocks.",
+            static_cast<uint64_t>(stats.touched_bytes / MEGABYTE),
+            static_cast<uint64_t>(stats.allocated_bytes / MEGABYTE),
+            stats.fragmentation() * 100.0);
+        if (!buf_arena_issue_reported) {
+            logWRN("%s", message.c_str());
+            buf_arena_issue_reported = true;
+        }
+        memory_issue_tracker.report_error(memory_issue_source_t::buf_arena, message);
+    } else {
+        memory_issue_tracker.report_success(memory_issue_source_t::buf_arena);
+        buf_arena_issue_reported = false;
+    }
 }
 
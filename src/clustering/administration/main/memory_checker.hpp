@@ -16,6 +16,8 @@ class table_meta_client_t;
 // memory_checker_t is created in serve.cc, and calls a repeating timer to
 // Periodically check if we're using swap by looking at the proc file or system calls.
 // If we're using swap, it creates an issue in a local issue tracker, and logs an error.
+// It does the same if the block buffer arena (see containers/buf_arena.hpp) is badly
+// fragmented.
 class memory_checker_t : private repeating_timer_callback_t {
 public:
     memory_checker_t();
@@ -25,6 +27,7 @@ public:
     }
 private:
     void do_check(auto_drainer_t::lock_t keepalive);
+    void check_buf_arena();
     void on_ring() final {
         coro_t::spawn_sometime(std::bind(&memory_checker_t::do_check,
                                          this,
@@ -39,6 +42,8 @@ private:
 
     int practice_runs_remaining;
 
+    bool buf_arena_issue_reported;
+
     // Timer must be destructed before drainer, because on_ring aquires a lock on drainer.
     auto_drainer_t drainer;
     repeating_timer_t timer;
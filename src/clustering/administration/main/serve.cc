@@ -235,7 +235,8 @@ bool do_serve(io_backender_t *io_backender,
                 serve_info.ports.client_port,
                 semilattice_manager_heartbeat.get_root_view(),
                 semilattice_manager_auth.get_root_view(),
-                serve_info.tls_configs.cluster.get()));
+                serve_info.tls_configs.cluster.get(),
+                serve_info.cluster_compression));
         } catch (const address_in_use_exc_t &ex) {
             throw address_in_use_exc_t(strprintf("Could not bind to cluster port: %s", ex.what()));
         }
@@ -282,7 +283,10 @@ bool do_serve(io_backender_t *io_backender,
                               nullptr,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              i_am_a_server ? io_backender : nullptr,
+                              base_path,
+                              serve_info.slow_query_threshold_ms);
         {
             /* Extract a subview of the directory with all the table meta manager
             business cards. */
@@ -304,12 +308,19 @@ bool do_serve(io_backender_t *io_backender,
             scoped_ptr_t<multi_table_manager_t> multi_table_manager;
             if (i_am_a_server) {
                 cache_balancer.init(new alt_cache_balancer_t(
-                    server_config_server->get_actual_cache_size_bytes()));
+                    server_config_server->get_actual_cache_size_bytes(),
+                    serve_info.cache_balancer_mode,
+                    serve_info.compressed_cache_size));
                 table_persistence_interface.init(
                     new real_table_persistence_interface_t(
                         io_backender,
                         cache_balancer.get(),
                         base_path,
+                        serve_info.flash_cache_dir,
+                        serve_info.flash_cache_size,
+                        serve_info.block_compression,
+                        serve_info.checksum_algorithm,
+                        serve_info.cache_eviction_policy,
                         &rdb_ctx,
                         metadata_file));
                 multi_table_manager.init(new multi_table_manager_t(
@@ -322,7 +333,8 @@ bool do_serve(io_backender_t *io_backender,
                     table_persistence_interface.get(),
                     base_path,
                     io_backender,
-                    &perfmon_collection_repo));
+                    &perfmon_collection_repo,
+                    serve_info.backfill_rate_limits));
             } else {
                 /* Proxies still need a `multi_table_manager_t` because it takes care of
                 receiving table names, databases, and primary keys from other servers and
@@ -542,7 +554,8 @@ bool do_serve(io_backender_t *io_backender,
                     &rdb_ctx,
                     &server_config_client,
                     server_id,
-                    serve_info.tls_configs.driver.get());
+                    serve_info.tls_configs.driver.get(),
+                    serve_info.driver_reuse_port);
                 logNTC("Listening for client driver connections on port %d\n",
                        rdb_query_server.get_port());
                 /* If `serve_info.ports.reql_port` was zero then the OS assigned us a
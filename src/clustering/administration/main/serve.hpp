@@ -13,6 +13,11 @@
 #include "clustering/administration/main/version_check.hpp"
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "buffer_cache/types.hpp"
+#include "clustering/immediate_consistency/standard_backfill_throttler.hpp"
+#include "serializer/checksum.hpp"
+#include "serializer/compression.hpp"
 
 class os_signal_cond_t;
 
@@ -119,7 +124,18 @@ public:
                  std::vector<std::string> &&_argv,
                  const int _join_delay_secs,
                  const int _node_reconnect_timeout_secs,
-                 tls_configs_t _tls_configs) :
+                 tls_configs_t _tls_configs,
+                 cache_balancer_mode_t _cache_balancer_mode,
+                 eviction_policy_t _cache_eviction_policy,
+                 uint64_t _compressed_cache_size,
+                 const std::string &_flash_cache_dir,
+                 uint64_t _flash_cache_size,
+                 block_compression_t _block_compression,
+                 checksum_algorithm_t _checksum_algorithm,
+                 const backfill_rate_limits_t &_backfill_rate_limits,
+                 bool _cluster_compression,
+                 bool _driver_reuse_port,
+                 uint64_t _slow_query_threshold_ms) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
         web_assets(std::move(_web_assets)),
@@ -128,7 +144,18 @@ public:
         config_file(_config_file),
         argv(std::move(_argv)),
         join_delay_secs(_join_delay_secs),
-        node_reconnect_timeout_secs(_node_reconnect_timeout_secs)
+        node_reconnect_timeout_secs(_node_reconnect_timeout_secs),
+        cache_balancer_mode(_cache_balancer_mode),
+        cache_eviction_policy(_cache_eviction_policy),
+        compressed_cache_size(_compressed_cache_size),
+        flash_cache_dir(_flash_cache_dir),
+        flash_cache_size(_flash_cache_size),
+        block_compression(_block_compression),
+        checksum_algorithm(_checksum_algorithm),
+        backfill_rate_limits(_backfill_rate_limits),
+        cluster_compression(_cluster_compression),
+        driver_reuse_port(_driver_reuse_port),
+        slow_query_threshold_ms(_slow_query_threshold_ms)
     {
         tls_configs = _tls_configs;
     }
@@ -149,6 +176,26 @@ public:
     std::vector<std::string> argv;
     int join_delay_secs;
     int node_reconnect_timeout_secs;
+    cache_balancer_mode_t cache_balancer_mode;
+    /* How the tables' caches pick pages to evict. */
+    eviction_policy_t cache_eviction_policy;
+    /* In bytes, zero if `--compressed-cache-size` wasn't given. */
+    uint64_t compressed_cache_size;
+    /* Empty if `--flash-cache-dir` wasn't given.  The size is per table, in bytes. */
+    std::string flash_cache_dir;
+    uint64_t flash_cache_size;
+    /* How the tables' serializers compress the blocks they write. */
+    block_compression_t block_compression;
+    /* The checksum algorithm of the files of tables created from now on.  Existing
+    files keep the one they were created with. */
+    checksum_algorithm_t checksum_algorithm;
+    backfill_rate_limits_t backfill_rate_limits;
+    /* Whether we offer to compress large cluster messages during the handshake. */
+    bool cluster_compression;
+    /* Whether the driver port is bound with `SO_REUSEPORT` on every thread. */
+    bool driver_reuse_port;
+    /* Zero if `--slow-query-log` wasn't given. */
+    uint64_t slow_query_threshold_ms;
     tls_configs_t tls_configs;
 };
 
@@ -74,6 +74,18 @@ void real_branch_history_manager_t::import_branch_history(
         const branch_history_t &new_records)
         THROWS_NOTHING {
     assert_thread();
+    /* This gets called with histories that we mostly know already, so don't pay for a
+    hard-durability write if there's nothing new. */
+    bool any_new = false;
+    for (const auto &pair : new_records.branches) {
+        if (!is_branch_known(pair.first)) {
+            any_new = true;
+            break;
+        }
+    }
+    if (!any_new) {
+        return;
+    }
     {
         cond_t non_interruptor;
         metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
@@ -103,6 +115,9 @@ void real_branch_history_manager_t::prepare_gc(
 void real_branch_history_manager_t::perform_gc(
         const std::set<branch_id_t> &remove_branches)
         THROWS_NOTHING {
+    if (remove_branches.empty()) {
+        return;
+    }
     cond_t non_interruptor;
     metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
     for (const branch_id_t &bid : remove_branches) {
@@ -9,6 +9,7 @@
 #include "clustering/administration/persist/migrate/migrate_v1_16.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_1.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_3.hpp"
+#include "clustering/administration/persist/migrate/migrate_v2_5.hpp"
 #include "clustering/administration/persist/migrate/rewrite.hpp"
 #include "config/args.hpp"
 #include "logger.hpp"
@@ -27,7 +28,7 @@ ATTR_PACKED(struct metadata_disk_superblock_t {
 
 // Etymology: In version 1.13, the magic was 'RDmd', for "(R)ethink(D)B (m)eta(d)ata".
 // Every subsequent version, the last character has been incremented.
-static const block_magic_t metadata_sb_magic = { { 'R', 'D', 'm', 'm' } };
+static const block_magic_t metadata_sb_magic = { { 'R', 'D', 'm', 'n' } };
 
 void init_metadata_superblock(void *sb_void, size_t block_size) {
     memset(sb_void, 0, block_size);
@@ -58,14 +59,15 @@ cluster_version_t magic_to_version(block_magic_t magic) {
     case 'j': return cluster_version_t::v2_2;
     case 'k': return cluster_version_t::v2_3;
     case 'l': return cluster_version_t::v2_4;
-    case 'm': return cluster_version_t::v2_5_is_latest_disk;
+    case 'm': return cluster_version_t::v2_5;
+    case 'n': return cluster_version_t::v2_6_is_latest_disk;
     default:
         fail_due_to_user_error("You're trying to use an earlier version of RethinkDB "
             "to open a database created by a later version of RethinkDB.");
     }
     // This is here so you don't forget to add new versions above.
     // Please also update the value of metadata_sb_magic at the top of this file!
-    static_assert(cluster_version_t::LATEST_DISK == cluster_version_t::v2_5,
+    static_assert(cluster_version_t::LATEST_DISK == cluster_version_t::v2_6,
         "Please add new version to magic_to_version.");
 }
 
@@ -375,9 +377,22 @@ metadata_file_t::metadata_file_t(
             // The metadata is now serialized using the latest serialization version
             metadata_version = cluster_version_t::LATEST_DISK;
         } // fallthrough intentional
-        case cluster_version_t::v2_4: {
+        case cluster_version_t::v2_4: // fallthrough intentional
+        case cluster_version_t::v2_5: {
+            if (sb_lock.has()) {
+                update_metadata_superblock_version(sb_data);
+                sb_write.reset();
+                sb_lock.reset();
+            }
+
+            logNTC("Migrating cluster metadata to v2.6");
+            migrate_metadata_v2_5_to_v2_6(
+                metadata_version, &write_txn, &non_interruptor);
+
+            // The metadata is now serialized using the latest serialization version
+            metadata_version = cluster_version_t::LATEST_DISK;
         } // fallthrough intentional
-        case cluster_version_t::v2_5_is_latest_disk:
+        case cluster_version_t::v2_6_is_latest_disk:
             break;  // up-to-date, do nothing
         default: unreachable();
         }
@@ -432,9 +447,12 @@ void metadata_file_t::init_serializer(
     if (!standard_ser->coop_lock_and_check()) {
         throw file_in_use_exc_t();
     }
+    /* During a rebalance or reconfiguration, many tables write their Raft state at
+    the same time, so it's worth holding back their flushes to let them share one. */
     serializer.init(new merger_serializer_t(
         std::move(standard_ser),
-        MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+        MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+        MERGER_SERIALIZER_GROUP_COMMIT_WINDOW_MS));
 }
 
 serializer_filepath_t metadata_file_t::get_filename(const base_path_t &path) {
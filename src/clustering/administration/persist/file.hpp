@@ -140,8 +140,12 @@ public:
         // This acts as a safety check to make sure a transaction
         // is not interrupted in the middle, which could leave the
         // metadata in an inconsistent state.
+        // We let go of the file's lock before waiting for the flush, so that the
+        // writes of other transactions (for example, the Raft logs of many tables that
+        // are being reconfigured at once) can go into the same flush instead of each
+        // waiting for its own fdatasync.
         void commit() {
-            get_txn()->commit();
+            get_txn()->commit([this]() { rwlock_acq.reset(); });
         }
 
     private:
@@ -3,27 +3,39 @@
 
 #include <algorithm>
 #include <array>
+#include <vector>
 
+#include "buffer_cache/hot_set.hpp"
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/administration/perfmon_collection_repo.hpp"
+#include "concurrency/pmap.hpp"
 #include "logger.hpp"
 #include "rdb_protocol/store.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "serializer/merger.hpp"
 #include "serializer/translator.hpp"
 
+// The file where the cache of one of a table's stores keeps its hot set.
+static std::string hot_set_path(const serializer_filepath_t &path, size_t shard) {
+    return strprintf("%s.hot%zu", path.permanent_path().c_str(), shard);
+}
+
 class real_multistore_ptr_t :
     public multistore_ptr_t {
 public:
     real_multistore_ptr_t(
             const namespace_id_t &table_id,
             const serializer_filepath_t &path,
+            const log_serializer_t::dynamic_config_t &serializer_config,
+            uint32_t block_size,
+            checksum_algorithm_t checksum_algorithm,
             scoped_ptr_t<real_branch_history_manager_t> &&bhm,
             const base_path_t &base_path,
             io_backender_t *io_backender,
             cache_balancer_t *cache_balancer,
+            eviction_policy_t eviction_policy,
             rdb_context_t *rdb_context,
             perfmon_collection_t *perfmon_collection_serializers,
             scoped_ptr_t<thread_allocation_t> &&serializer_thread,
@@ -54,21 +66,23 @@ public:
         filepath_file_opener_t file_opener(path, io_backender);
 
         if (create) {
-            log_serializer_t::create(
-                &file_opener,
-                log_serializer_t::static_config_t());
+            log_serializer_t::static_config_t static_config;
+            static_config.block_size_ = block_size;
+            static_config.checksum_algorithm = checksum_algorithm;
+            log_serializer_t::create(&file_opener, static_config);
         }
 
         // TODO: Could we handle failure when loading the serializer?  Right
         // now, we don't.
 
         scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
-            log_serializer_t::dynamic_config_t(),
+            serializer_config,
             &file_opener,
             perfmon_collection_serializers));
         serializer.init(new merger_serializer_t(
             std::move(inner_serializer),
-            MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+            MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+            MERGER_SERIALIZER_GROUP_COMMIT_WINDOW_MS));
 
         std::vector<serializer_t *> ptrs;
         ptrs.push_back(serializer.get());
@@ -96,6 +110,7 @@ public:
                 table_id,
                 update_sindexes_t::UPDATE,
                 which_cpu_shard_t{ix, CPU_SHARDING_FACTOR}));
+            stores[ix]->cache->configure_eviction_policy(eviction_policy);
 
             /* Initialize the metainfo if necessary */
             if (create) {
@@ -112,6 +127,9 @@ public:
                     write_durability_t::HARD,
                     &non_interruptor);
             }
+
+            hot_sets[ix].init(new hot_set_manifest_t(
+                stores[ix]->cache.get(), hot_set_path(path, ix)));
         });
 
         if (create) {
@@ -127,6 +145,7 @@ public:
         pmap(CPU_SHARDING_FACTOR, [this](int ix) {
             if (stores[ix].has()) {
                 on_thread_t thread_switcher(stores[ix]->home_thread());
+                hot_sets[ix].reset();
                 stores[ix].reset();
             }
         });
@@ -169,6 +188,8 @@ private:
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
     scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
+    // These have to be destroyed before the stores' caches.
+    scoped_ptr_t<hot_set_manifest_t> hot_sets[CPU_SHARDING_FACTOR];
 
     scoped_ptr_t<thread_allocation_t> serializer_thread_allocation;
     std::vector<scoped_ptr_t<thread_allocation_t> > store_thread_allocations;
@@ -202,12 +223,20 @@ void real_table_persistence_interface_t::read_all_metadata(
         },
         interruptor);
     storage_interfaces.clear();
+    std::vector<const std::pair<const namespace_id_t,
+                                table_active_persistent_state_t> *> to_load;
     for (const auto &pair : active_tables) {
         storage_interfaces[pair.first].init(new table_raft_storage_interface_t(
             metadata_file, &read_txn, pair.first, interruptor));
-        active_cb(
-            pair.first, pair.second, storage_interfaces[pair.first].get(), &read_txn);
+        to_load.push_back(&pair);
     }
+    /* Most of the time goes into opening the tables' files, and every table has its
+    own serializer on its own thread, so we load several tables at once. */
+    throttled_pmap(to_load.size(), [&](int64_t i) {
+        const namespace_id_t &table_id = to_load[i]->first;
+        active_cb(
+            table_id, to_load[i]->second, storage_interfaces[table_id].get(), &read_txn);
+    }, TABLE_LOAD_CONCURRENCY);
 
     read_txn.read_many<table_inactive_persistent_state_t>(
         mdprefix_table_inactive(),
@@ -279,6 +308,21 @@ void real_table_persistence_interface_t::load_multistore(
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) {
+    /* The file only doesn't exist yet if we crashed right after writing the metadata
+    for a new table.  The block size is just a performance setting, so it's fine if
+    such a replica ends up with the default one. */
+    open_multistore(
+        table_id, DEFAULT_BTREE_BLOCK_SIZE, metadata_read_txn, multistore_ptr_out,
+        interruptor, perfmon_collection_serializers);
+}
+
+void real_table_persistence_interface_t::open_multistore(
+        const namespace_id_t &table_id,
+        uint32_t block_size,
+        metadata_file_t::read_txn_t *metadata_read_txn,
+        scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
+        signal_t *interruptor,
+        perfmon_collection_t *perfmon_collection_serializers) {
     scoped_ptr_t<real_branch_history_manager_t> bhm(
         new real_branch_history_manager_t(
             table_id, metadata_file, metadata_read_txn, interruptor));
@@ -287,16 +331,28 @@ void real_table_persistence_interface_t::load_multistore(
         new thread_allocation_t(&thread_allocator));
     std::vector<scoped_ptr_t<thread_allocation_t> > store_threads;
     for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-        store_threads.emplace_back(new thread_allocation_t(&thread_allocator));
+        // The stores allocate their page caches on their own threads, so keeping
+        // them on the serializer's NUMA node keeps the table's memory on one node.
+        store_threads.emplace_back(new thread_allocation_t(
+            &thread_allocator, serializer_thread->get_thread()));
     }
 
+    log_serializer_t::dynamic_config_t serializer_config;
+    serializer_config.flash_cache_path = flash_cache_file_name_for(table_id);
+    serializer_config.flash_cache_size = flash_cache_size;
+    serializer_config.compression = block_compression;
+
     multistore_ptr_out->init(new real_multistore_ptr_t(
         table_id,
         file_name_for(table_id),
+        serializer_config,
+        block_size,
+        checksum_algorithm,
         std::move(bhm),
         base_path,
         io_backender,
         cache_balancer,
+        eviction_policy,
         rdb_context,
         perfmon_collection_serializers,
         std::move(serializer_thread),
@@ -306,12 +362,13 @@ void real_table_persistence_interface_t::load_multistore(
 
 void real_table_persistence_interface_t::create_multistore(
         const namespace_id_t &table_id,
+        uint32_t block_size,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) {
     metadata_file_t::read_txn_t read_txn(metadata_file, interruptor);
-    load_multistore(
-        table_id, &read_txn, multistore_ptr_out, interruptor,
+    open_multistore(
+        table_id, block_size, &read_txn, multistore_ptr_out, interruptor,
         perfmon_collection_serializers);
 }
 
@@ -326,6 +383,17 @@ void real_table_persistence_interface_t::destroy_multistore(
     const int res = ::unlink(filepath.c_str());
     guarantee_err(res == 0 || get_errno() == ENOENT,
                   "unlink failed for file %s", filepath.c_str());
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        const std::string hot_set_filepath = hot_set_path(file_name_for(table_id), i);
+        const int hot_set_res = ::unlink(hot_set_filepath.c_str());
+        guarantee_err(hot_set_res == 0 || get_errno() == ENOENT,
+                      "unlink failed for file %s", hot_set_filepath.c_str());
+    }
+    // The flash cache is only a cache, so it's fine if this fails.
+    const std::string flash_cache_filepath = flash_cache_file_name_for(table_id);
+    if (!flash_cache_filepath.empty()) {
+        ::unlink(flash_cache_filepath.c_str());
+    }
 }
 
 serializer_filepath_t real_table_persistence_interface_t::file_name_for(
@@ -333,6 +401,14 @@ serializer_filepath_t real_table_persistence_interface_t::file_name_for(
     return serializer_filepath_t(base_path, uuid_to_str(table_id));
 }
 
+std::string real_table_persistence_interface_t::flash_cache_file_name_for(
+        const namespace_id_t &table_id) {
+    if (flash_cache_dir.empty()) {
+        return std::string();
+    }
+    return flash_cache_dir + "/" + uuid_to_str(table_id) + ".flash";
+}
+
 bool real_table_persistence_interface_t::is_gc_active() const {
     for (int thread = 0; thread < get_num_db_threads(); ++thread) {
         std::map<serializer_t *, auto_drainer_t::lock_t> serializers_copy;
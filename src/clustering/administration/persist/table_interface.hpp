@@ -2,9 +2,12 @@
 #ifndef CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_
 #define CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_
 
+#include "buffer_cache/types.hpp"
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
+#include "serializer/checksum.hpp"
+#include "serializer/compression.hpp"
 
 class cache_balancer_t;
 class metadata_file_t;
@@ -18,11 +21,21 @@ public:
             io_backender_t *_io_backender,
             cache_balancer_t *_cache_balancer,
             const base_path_t &_base_path,
+            const std::string &_flash_cache_dir,
+            uint64_t _flash_cache_size,
+            block_compression_t _block_compression,
+            checksum_algorithm_t _checksum_algorithm,
+            eviction_policy_t _eviction_policy,
             rdb_context_t *_rdb_context,
             metadata_file_t *_metadata_file) :
         io_backender(_io_backender),
         cache_balancer(_cache_balancer),
         base_path(_base_path),
+        flash_cache_dir(_flash_cache_dir),
+        flash_cache_size(_flash_cache_size),
+        block_compression(_block_compression),
+        checksum_algorithm(_checksum_algorithm),
+        eviction_policy(_eviction_policy),
         rdb_context(_rdb_context),
         metadata_file(_metadata_file),
         /* We assign threads from the lowest thread number upwards. This is to reduce
@@ -63,6 +76,7 @@ public:
         perfmon_collection_t *perfmon_collection_serializers);
     void create_multistore(
         const namespace_id_t &table_id,
+        uint32_t block_size,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
@@ -73,12 +87,30 @@ public:
     bool is_gc_active() const;
 
 private:
+    /* Opens the table's files, or creates them with `block_size` if they don't exist
+    yet. */
+    void open_multistore(
+        const namespace_id_t &table_id,
+        uint32_t block_size,
+        metadata_file_t::read_txn_t *metadata_read_txn,
+        scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
+        signal_t *interruptor,
+        perfmon_collection_t *perfmon_collection_serializers);
+
     serializer_filepath_t file_name_for(const namespace_id_t &table_id);
+    // The table's flash cache file, or the empty string if there is no flash cache.
+    std::string flash_cache_file_name_for(const namespace_id_t &table_id);
     threadnum_t pick_thread();
 
     io_backender_t * const io_backender;
     cache_balancer_t * const cache_balancer;
     base_path_t const base_path;
+    // See `serve_info_t`.
+    std::string const flash_cache_dir;
+    uint64_t const flash_cache_size;
+    block_compression_t const block_compression;
+    checksum_algorithm_t const checksum_algorithm;
+    eviction_policy_t const eviction_policy;
     rdb_context_t * const rdb_context;
     metadata_file_t * const metadata_file;
 
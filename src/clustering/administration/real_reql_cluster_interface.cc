@@ -12,6 +12,7 @@
 #include "clustering/administration/tables/table_config.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/archive/string_stream.hpp"
 #include "rdb_protocol/artificial_table/artificial_table.hpp"
 #include "rdb_protocol/env.hpp"
@@ -292,6 +293,7 @@ bool real_reql_cluster_interface_t::table_create(
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
         write_durability_t durability,
+        uint32_t block_size,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -329,12 +331,14 @@ bool real_reql_cluster_interface_t::table_create(
         /* Pick which servers to host the data */
         table_generate_config(
             m_server_config_client, nil_uuid(), m_table_meta_client,
-            config_params, config.shard_scheme, &interruptor_on_home,
-            &config.config.shards, &config.server_names);
+            config_params, config.shard_scheme,
+            std::map<server_id_t, double>(), /* a new table has no writes yet */
+            &interruptor_on_home, &config.config.shards, &config.server_names);
 
         config.config.write_ack_config = write_ack_config_t::MAJORITY;
         config.config.durability = durability;
         config.config.user_data = default_user_data();
+        config.config.block_size = block_size;
 
         table_id = generate_uuid();
         m_table_meta_client->create(table_id, config, &interruptor_on_home);
@@ -646,6 +650,53 @@ bool real_reql_cluster_interface_t::db_wait(
     }
 }
 
+void real_reql_cluster_interface_t::fetch_table_write_rates(
+        const namespace_id_t &table_id,
+        signal_t *interruptor,
+        std::map<server_id_t, double> *write_rates_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    std::vector<std::pair<server_id_t, get_stats_mailbox_address_t> > servers;
+    m_server_config_client->get_directory_view()->read_all(
+        [&](const peer_id_t &, const cluster_directory_metadata_t *metadata) {
+            servers.push_back(std::make_pair(
+                metadata->server_id, metadata->get_stats_mailbox_address));
+        });
+
+    const std::string table_str = uuid_to_str(table_id);
+    const std::set<std::vector<std::string> > filter {
+        {"query_engine", "table_writes_per_sec", table_str} };
+    std::vector<ql::datum_t> results(servers.size());
+    pmap(servers.size(), [&](int64_t i) {
+        try {
+            admin_err_t dummy_error;
+            if (!fetch_stats_from_server(m_mailbox_manager, servers[i].second, filter,
+                    interruptor, &results[i], &dummy_error)) {
+                results[i] = ql::datum_t();
+            }
+        } catch (const interrupted_exc_t &) {
+            /* We check `interruptor` below */
+        }
+    });
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+
+    for (size_t i = 0; i < servers.size(); ++i) {
+        ql::datum_t rate = results[i];
+        for (const char *field : {"query_engine", "table_writes_per_sec",
+                                  table_str.c_str()}) {
+            if (!rate.has() || rate.get_type() != ql::datum_t::R_OBJECT) {
+                rate = ql::datum_t();
+                break;
+            }
+            rate = rate.get_field(field, ql::NOTHROW);
+        }
+        if (rate.has() && rate.get_type() == ql::datum_t::R_NUM) {
+            (*write_rates_out)[servers[i].first] += rate.as_num();
+        }
+    }
+}
+
 void real_reql_cluster_interface_t::reconfigure_internal(
         auth::user_context_t const &user_context,
         const counted_t<const ql::db_t> &db,
@@ -691,6 +742,7 @@ void real_reql_cluster_interface_t::reconfigure_internal(
     new_config.config.write_ack_config = old_config.config.write_ack_config;
     new_config.config.durability = old_config.config.durability;
     new_config.config.user_data = old_config.config.user_data;
+    new_config.config.block_size = old_config.config.block_size;
 
     calculate_split_points_intelligently(
         table_id,
@@ -700,11 +752,16 @@ void real_reql_cluster_interface_t::reconfigure_internal(
         interruptor_on_home,
         &new_config.shard_scheme);
 
+    std::map<server_id_t, double> write_rates;
+    if (params.primary_near_writes) {
+        fetch_table_write_rates(table_id, interruptor_on_home, &write_rates);
+    }
+
     /* `table_generate_config()` just generates the config; it doesn't apply it */
     table_generate_config(
         m_server_config_client, table_id, m_table_meta_client,
-        params, new_config.shard_scheme, interruptor_on_home, &new_config.config.shards,
-        &new_config.server_names);
+        params, new_config.shard_scheme, write_rates, interruptor_on_home,
+        &new_config.config.shards, &new_config.server_names);
 
     if (!dry_run) {
         table_config_and_shards_change_t table_config_and_shards_change(
@@ -982,6 +1039,7 @@ bool real_reql_cluster_interface_t::table_emergency_repair(
 void real_reql_cluster_interface_t::rebalance_internal(
         auth::user_context_t const &user_context,
         const namespace_id_t &table_id,
+        rebalance_mode_t mode,
         signal_t *interruptor_on_home,
         ql::datum_t *results_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t,
@@ -1010,13 +1068,24 @@ void real_reql_cluster_interface_t::rebalance_internal(
         throw no_such_table_exc_t();
     }
 
-    std::map<store_key_t, int64_t> counts;
-    fetch_distribution(table_id, this, interruptor_on_home, &counts);
-
-    /* If there's not enough data to rebalance, return `rebalanced: 0` but don't report
-    an error */
-    bool actually_rebalanced = calculate_split_points_with_distribution(
-        counts, config.config.shards.size(), &config.shard_scheme);
+    std::map<store_key_t, int64_t> counts, loads;
+    fetch_distribution(table_id, this, interruptor_on_home, &counts, &loads);
+
+    /* If there's not enough data (or, when rebalancing by load, no recent load) to
+    rebalance, return `rebalanced: 0` but don't report an error */
+    bool actually_rebalanced;
+    switch (mode) {
+    case rebalance_mode_t::DOCUMENTS:
+        actually_rebalanced = calculate_split_points_with_distribution(
+            counts, config.config.shards.size(), &config.shard_scheme);
+        break;
+    case rebalance_mode_t::LOAD:
+        actually_rebalanced = calculate_split_points_with_load(
+            counts, loads, config.config.shards.size(), &config.shard_scheme);
+        break;
+    default:
+        unreachable();
+    }
     if (actually_rebalanced) {
         table_config_and_shards_change_t table_config_and_shards_change(
             table_config_and_shards_change_t::set_table_config_and_shards_t{ config });
@@ -1045,6 +1114,7 @@ bool real_reql_cluster_interface_t::table_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
         const name_string_t &name,
+        rebalance_mode_t mode,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -1059,7 +1129,8 @@ bool real_reql_cluster_interface_t::table_rebalance(
 
         user_context.require_config_permission(m_rdb_context, db->id, table_id);
 
-        rebalance_internal(user_context, table_id, &interruptor_on_home, result_out);
+        rebalance_internal(
+            user_context, table_id, mode, &interruptor_on_home, result_out);
         return true;
     } catch (const admin_op_exc_t &admin_op_exc) {
         *error_out = admin_op_exc.to_admin_err();
@@ -1073,6 +1144,7 @@ bool real_reql_cluster_interface_t::table_rebalance(
 bool real_reql_cluster_interface_t::db_rebalance(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
+        rebalance_mode_t mode,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -1096,7 +1168,8 @@ bool real_reql_cluster_interface_t::db_rebalance(
     for (const auto &table_id : table_ids) {
         ql::datum_t stats;
         try {
-            rebalance_internal(user_context, table_id, &interruptor_on_home, &stats);
+            rebalance_internal(
+                user_context, table_id, mode, &interruptor_on_home, &stats);
         } catch (const no_such_table_exc_t &) {
             /* This table was deleted while we were iterating over the tables list. So
             just ignore it to avoid making a confusing error message. */
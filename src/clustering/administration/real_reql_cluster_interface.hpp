@@ -86,6 +86,7 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            uint32_t block_size,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -176,12 +177,14 @@ public:
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
             const name_string_t &name,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
     bool db_rebalance(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -322,6 +325,15 @@ private:
             THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t,
                 failed_table_op_exc_t, maybe_failed_table_op_exc_t, admin_op_exc_t);
 
+    /* Asks every connected server how many writes per second it sends to the table,
+    for `reconfigure()` with `primary_near_writes`. Servers that don't answer are left
+    out. */
+    void fetch_table_write_rates(
+            const namespace_id_t &table_id,
+            signal_t *interruptor,
+            std::map<server_id_t, double> *write_rates_out)
+            THROWS_ONLY(interrupted_exc_t);
+
     void emergency_repair_internal(
             auth::user_context_t const &user_context,
             const counted_t<const ql::db_t> &db,
@@ -336,6 +348,7 @@ private:
     void rebalance_internal(
             auth::user_context_t const &user_context,
             const namespace_id_t &table_id,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *results_out)
             THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t,
@@ -48,6 +48,10 @@ public:
         return &connections_map;
     }
 
+    watchable_map_t<peer_id_t, cluster_directory_metadata_t> *get_directory_view() {
+        return directory_view;
+    }
+
     const server_connectivity_t& get_server_connectivity() const {
         return server_connectivity;
     }
@@ -1,6 +1,10 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "clustering/administration/servers/config_server.hpp"
 
+#include <algorithm>
+#include <functional>
+
+#include "arch/runtime/coroutines.hpp"
 #include "clustering/administration/main/cache_size.hpp"
 #include "clustering/administration/persist/file.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
@@ -12,6 +16,14 @@ server_config_server_t::server_config_server_t(
     file(_file),
     my_config(server_config_versioned_t()),
     actual_cache_size_bytes(0),
+    adjusting_cache_size(false),
+    cache_size_timer(CACHE_SIZE_CHECK_INTERVAL_MS, [this]() {
+        if (static_cast<bool>(automatic_cache_size_bytes) && !adjusting_cache_size) {
+            coro_t::spawn_sometime(std::bind(
+                &server_config_server_t::adjust_automatic_cache_size,
+                this, drainer.lock()));
+        }
+    }),
     set_config_mailbox(mailbox_manager,
         std::bind(&server_config_server_t::on_set_config, this,
             ph::_1, ph::_2, ph::_3))
@@ -70,10 +82,12 @@ void server_config_server_t::on_set_config(
 void server_config_server_t::update_actual_cache_size(
         const optional<uint64_t> &setting) {
     uint64_t actual_size;
+    automatic_cache_size_bytes.reset();
     if (!static_cast<bool>(setting)) {
         actual_size = get_default_total_cache_size();
         logINF("Automatically using cache size of %" PRIu64 " MB",
             actual_size / static_cast<uint64_t>(MEGABYTE));
+        automatic_cache_size_bytes.set(actual_size);
     } else {
         if (*setting > get_max_total_cache_size()) {
             /* Usually this won't happen, because something else will reject the value
@@ -96,3 +110,35 @@ void server_config_server_t::update_actual_cache_size(
     actual_cache_size_bytes.set_value(actual_size);
 }
 
+void server_config_server_t::adjust_automatic_cache_size(
+        auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    adjusting_cache_size = true;
+    double pressure = 0;
+    const bool has_pressure = get_memory_pressure(&pressure);
+    cgroup_memory_t cgroup;
+    const bool has_cgroup = get_cgroup_memory(&cgroup);
+    adjusting_cache_size = false;
+    if (keepalive.get_drain_signal()->is_pulsed()
+            || !static_cast<bool>(automatic_cache_size_bytes)) {
+        return;
+    }
+
+    uint64_t target = *automatic_cache_size_bytes;
+    if (has_cgroup) {
+        // The limit can change while we're running.
+        target = std::min(target, get_default_total_cache_size_for_limit(cgroup.limit));
+    }
+    const uint64_t current = actual_cache_size_bytes.get();
+    const bool under_pressure =
+        (has_pressure && pressure >= CACHE_SHRINK_MEMORY_PRESSURE_PERCENT)
+        || (has_cgroup && cgroup_memory_is_low(cgroup));
+    const uint64_t new_size = next_automatic_cache_size(current, target, under_pressure);
+    if (new_size != current) {
+        if (under_pressure) {
+            logINF("Shrinking the cache to %" PRIu64 " MB because memory is running "
+                "low.", new_size / static_cast<uint64_t>(MEGABYTE));
+        }
+        actual_cache_size_bytes.set_value(new_size);
+    }
+}
@@ -4,8 +4,10 @@
 
 #include <set>
 
+#include "arch/timing.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/servers/server_metadata.hpp"
+#include "concurrency/auto_drainer.hpp"
 
 class metadata_file_t;
 
@@ -23,7 +25,9 @@ public:
 
     /* Returns the actual cache size, not the cache size setting. If the cache size
     setting is "auto", the actual cache size will be some reasonable automatically
-    selected value; otherwise, the actual cache size will be the cache size setting. */
+    selected value, which shrinks under memory pressure and follows changes to our
+    cgroup's memory limit; otherwise, the actual cache size will be the cache size
+    setting. */
     clone_ptr_t<watchable_t<uint64_t> > get_actual_cache_size_bytes() {
         return actual_cache_size_bytes.get_watchable();
     }
@@ -37,12 +41,23 @@ private:
 
     void update_actual_cache_size(const optional<uint64_t> &setting);
 
+    // Called every `CACHE_SIZE_CHECK_INTERVAL_MS` while the cache size is automatic.
+    void adjust_automatic_cache_size(auto_drainer_t::lock_t keepalive);
+
     mailbox_manager_t *const mailbox_manager;
     metadata_file_t *const file;
     server_id_t my_server_id;
     watchable_variable_t<server_config_versioned_t> my_config;
     watchable_variable_t<uint64_t> actual_cache_size_bytes;
 
+    // If the cache size is automatic, the size we would like, and whether
+    // `adjust_automatic_cache_size()` is running.
+    optional<uint64_t> automatic_cache_size_bytes;
+    bool adjusting_cache_size;
+
+    auto_drainer_t drainer;
+    repeating_timer_t cache_size_timer;
+
     server_config_business_card_t::set_config_mailbox_t set_config_mailbox;
 };
 
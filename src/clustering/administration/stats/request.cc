@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "clustering/administration/stats/request.hpp"
 
+#include <functional>
+
 #include "clustering/administration/datum_adapter.hpp"
 #include "clustering/administration/servers/config_client.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
@@ -31,6 +33,50 @@ const char *table_server_stats_request_t::table_server_request_type = "table_ser
     (BUILDER).overwrite(#NAME, ql::datum_t( \
         (STATS).accumulate_server(SERVER, &parsed_stats_t::table_stats_t::NAME)));
 
+// Latency histograms are shown as their count and percentiles, without the buckets
+#define ADD_LATENCY_STAT(BUILDER, SUB_STATS, NAME) \
+    (BUILDER).overwrite(#NAME, (SUB_STATS).NAME.to_datum(false))
+
+#define ADD_CLUSTER_SERVER_LATENCY(BUILDER, STATS, NAME) \
+    (BUILDER).overwrite(#NAME, \
+        (STATS).merge(&parsed_stats_t::server_stats_t::NAME).to_datum(false));
+
+#define ADD_CLUSTER_TABLE_LATENCY(BUILDER, STATS, NAME) \
+    (BUILDER).overwrite(#NAME, \
+        (STATS).merge(&parsed_stats_t::table_stats_t::NAME).to_datum(false));
+
+#define ADD_TABLE_LATENCY(BUILDER, STATS, TABLE, NAME) \
+    (BUILDER).overwrite(#NAME, (STATS).merge_table( \
+        TABLE, &parsed_stats_t::table_stats_t::NAME).to_datum(false));
+
+#define ADD_SERVER_LATENCY(BUILDER, STATS, SERVER, NAME) \
+    (BUILDER).overwrite(#NAME, (STATS).merge_server( \
+        SERVER, &parsed_stats_t::table_stats_t::NAME).to_datum(false));
+
+// The histograms that split up the latency of writes, under the names they have in the
+// `write_latency_stages` field.  `ack` is recorded by the primary, from handing a write
+// to the replicas until enough of them have acked it, so it includes the other stages
+// on the replicas.  The others come from `store_t::write()` on every replica.
+static const std::pair<const char *,
+                       parsed_stats_t::histogram_t parsed_stats_t::table_stats_t::*>
+    write_stage_latencies[] = {
+        { "ack", &parsed_stats_t::table_stats_t::write_ack_latency },
+        { "superblock", &parsed_stats_t::table_stats_t::write_superblock_latency },
+        { "btree", &parsed_stats_t::table_stats_t::write_btree_latency },
+        { "sindexes", &parsed_stats_t::table_stats_t::write_sindex_latency },
+        { "changefeeds", &parsed_stats_t::table_stats_t::write_changefeed_latency },
+        { "commit", &parsed_stats_t::table_stats_t::write_commit_latency } };
+
+static ql::datum_t write_latency_stages_to_datum(
+        const std::function<parsed_stats_t::histogram_t(
+            parsed_stats_t::histogram_t parsed_stats_t::table_stats_t::*)> &get) {
+    ql::datum_object_builder_t builder;
+    for (const auto &stage : write_stage_latencies) {
+        builder.overwrite(stage.first, get(stage.second).to_datum(false));
+    }
+    return std::move(builder).to_datum();
+}
+
 parsed_stats_t::server_stats_t::server_stats_t() :
     responsive(false),
     queries_per_sec(0), queries_total(0),
@@ -39,7 +85,8 @@ parsed_stats_t::server_stats_t::server_stats_t() :
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
     written_docs_per_sec(0), written_docs_total(0),
-    in_use_bytes(0), metadata_bytes(0), data_bytes(0),
+    in_use_bytes(0), limit_bytes(0), misses_total(0), ghost_hits_total(0),
+    marginal_gain(0), metadata_bytes(0), data_bytes(0),
     garbage_bytes(0), preallocated_bytes(0),
     read_bytes_per_sec(0), read_bytes_total(0),
     written_bytes_per_sec(0), written_bytes_total(0) { }
@@ -65,6 +112,8 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "mailbox_round_trips") {
+                serv_stats.mailbox_round_trip_latency.aggregate_datum(perf_pair.second);
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -101,6 +150,16 @@ void parsed_stats_t::add_perfmon_value(const ql::datum_t &perf,
     }
 }
 
+void parsed_stats_t::max_perfmon_value(const ql::datum_t &perf,
+                                       const std::string &key,
+                                       double *value_out) {
+    ql::datum_t v = perf.get_field(key.c_str(), ql::throw_bool_t::NOTHROW);
+    if (v.has()) {
+        r_sanity_check(v.get_type() == ql::datum_t::R_NUM);
+        *value_out = std::max(*value_out, v.as_num());
+    }
+}
+
 void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                                         table_stats_t *stats_out) {
     r_sanity_check(shard_perf.get_type() == ql::datum_t::R_OBJECT);
@@ -125,6 +184,32 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                    add_perfmon_value(sub_pair.second, "limit_bytes",
+                                      &stats_out->limit_bytes);
+                    add_perfmon_value(sub_pair.second, "misses_total",
+                                      &stats_out->misses_total);
+                    add_perfmon_value(sub_pair.second, "ghost_hits_total",
+                                      &stats_out->ghost_hits_total);
+                    // Each shard has its own cache, so the memory would go to the
+                    // shard that benefits the most.
+                    max_perfmon_value(sub_pair.second, "marginal_gain",
+                                      &stats_out->marginal_gain);
+                } else if (key == "read_latency") {
+                    stats_out->read_latency.aggregate_datum(sub_pair.second);
+                } else if (key == "write_latency") {
+                    stats_out->write_latency.aggregate_datum(sub_pair.second);
+                } else if (key == "write_superblock_latency") {
+                    stats_out->write_superblock_latency.aggregate_datum(
+                        sub_pair.second);
+                } else if (key == "write_btree_latency") {
+                    stats_out->write_btree_latency.aggregate_datum(sub_pair.second);
+                } else if (key == "write_sindex_latency") {
+                    stats_out->write_sindex_latency.aggregate_datum(sub_pair.second);
+                } else if (key == "write_changefeed_latency") {
+                    stats_out->write_changefeed_latency.aggregate_datum(
+                        sub_pair.second);
+                } else if (key == "write_commit_latency") {
+                    stats_out->write_commit_latency.aggregate_datum(sub_pair.second);
                 }
             }
         }
@@ -142,6 +227,10 @@ void parsed_stats_t::store_serializer_values(const ql::datum_t &ser_perf,
                         &stats_out->written_bytes_per_sec);
     store_perfmon_value(ser_perf, "serializer_written_bytes_total",
                         &stats_out->written_bytes_total);
+    stats_out->disk_read_latency.aggregate_datum(
+        ser_perf.get_field("serializer_block_read_latency", ql::throw_bool_t::NOTHROW));
+    stats_out->disk_write_latency.aggregate_datum(
+        ser_perf.get_field("serializer_block_write_latency", ql::throw_bool_t::NOTHROW));
 
     store_perfmon_value(ser_perf, "serializer_data_extents",
                         &stats_out->data_bytes);
@@ -167,6 +256,22 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+    stats_out->query_latency.aggregate_datum(
+        qe_perf.get_field("query_latency", ql::throw_bool_t::NOTHROW));
+}
+
+void parsed_stats_t::store_region_values(const ql::datum_t &regions_perf,
+                                         table_stats_t *stats_out) {
+    r_sanity_check(regions_perf.get_type() == ql::datum_t::R_OBJECT);
+    for (size_t i = 0; i < regions_perf.obj_size(); ++i) {
+        // Only the primaries have a broadcaster, the other executions are skipped.
+        ql::datum_t broadcaster_perf = regions_perf.get_pair(i).second.get_field(
+            "broadcaster", ql::throw_bool_t::NOTHROW);
+        if (broadcaster_perf.has()) {
+            stats_out->write_ack_latency.aggregate_datum(broadcaster_perf.get_field(
+                "write_ack_latency", ql::throw_bool_t::NOTHROW));
+        }
+    }
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -186,6 +291,12 @@ void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
         if (sub_sers_perf.has()) {
             store_serializer_values(sub_sers_perf, &table_stats_out);
         }
+
+        ql::datum_t regions_perf = table_perf.get_field("regions",
+                                                        ql::throw_bool_t::NOTHROW);
+        if (regions_perf.has()) {
+            store_region_values(regions_perf, &table_stats_out);
+        }
     }
 }
 
@@ -230,6 +341,51 @@ double parsed_stats_t::accumulate_server(const server_id_t &server_id,
     return res;
 }
 
+parsed_stats_t::histogram_t parsed_stats_t::merge(
+        histogram_t server_stats_t::*field) const {
+    histogram_t res;
+    for (auto const &pair : servers) {
+        res.aggregate(pair.second.*field);
+    }
+    return res;
+}
+
+parsed_stats_t::histogram_t parsed_stats_t::merge(
+        histogram_t table_stats_t::*field) const {
+    histogram_t res;
+    for (auto const &server_pair : servers) {
+        for (auto const &table_pair : server_pair.second.tables) {
+            res.aggregate(table_pair.second.*field);
+        }
+    }
+    return res;
+}
+
+parsed_stats_t::histogram_t parsed_stats_t::merge_table(
+        const namespace_id_t &table_id,
+        histogram_t table_stats_t::*field) const {
+    histogram_t res;
+    for (auto const &server_pair : servers) {
+        auto const &table_it = server_pair.second.tables.find(table_id);
+        if (table_it != server_pair.second.tables.end()) {
+            res.aggregate(table_it->second.*field);
+        }
+    }
+    return res;
+}
+
+parsed_stats_t::histogram_t parsed_stats_t::merge_server(
+        const server_id_t &server_id,
+        histogram_t table_stats_t::*field) const {
+    histogram_t res;
+    auto const server_it = servers.find(server_id);
+    r_sanity_check(server_it != servers.end());
+    for (auto const &table_pair : server_it->second.tables) {
+        res.aggregate(table_pair.second.*field);
+    }
+    return res;
+}
+
 bool add_table_fields(const namespace_id_t &table_id,
                       const cluster_semilattice_metadata_t &metadata,
                       table_meta_client_t *table_meta_client,
@@ -253,6 +409,7 @@ bool add_table_fields(const namespace_id_t &table_id,
 std::set<std::vector<std::string> > stats_request_t::global_stats_filter() {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"mailbox_round_trips"},
           {"[0-9A-Fa-f-]+", "serializers" } });
 }
 
@@ -286,7 +443,9 @@ cluster_stats_request_t::cluster_stats_request_t() { }
 std::set<std::vector<std::string> > cluster_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine" },
-          {".*", "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" } });
+          {"mailbox_round_trips"},
+          {".*", "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" },
+          {".*", "serializers", "shard_[0-9]+", "(read|write)_latency" } });
 }
 
 std::vector<peer_id_t> cluster_stats_request_t::get_peers(
@@ -312,6 +471,10 @@ bool cluster_stats_request_t::to_datum(const parsed_stats_t &stats,
     ADD_CLUSTER_SERVER_STAT(qe_builder, stats, clients_active);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, read_docs_per_sec);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, written_docs_per_sec);
+    ADD_CLUSTER_SERVER_LATENCY(qe_builder, stats, query_latency);
+    ADD_CLUSTER_SERVER_LATENCY(qe_builder, stats, mailbox_round_trip_latency);
+    ADD_CLUSTER_TABLE_LATENCY(qe_builder, stats, read_latency);
+    ADD_CLUSTER_TABLE_LATENCY(qe_builder, stats, write_latency);
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
     *result_out = std::move(row_builder).to_datum();
@@ -344,7 +507,10 @@ table_stats_request_t::table_stats_request_t(const namespace_id_t &_table_id) :
 
 std::set<std::vector<std::string> > table_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >({
-        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" }
+        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" },
+        { uuid_to_str(table_id), "serializers", "shard_[0-9]+",
+          "(read|write)(_[a-z]+)?_latency" },
+        { uuid_to_str(table_id), "regions", ".*", "broadcaster", "write_ack_latency" }
         });
 }
 
@@ -374,6 +540,12 @@ bool table_stats_request_t::to_datum(const parsed_stats_t &stats,
     ql::datum_object_builder_t qe_builder;
     ADD_TABLE_STAT(qe_builder, stats, table_id, read_docs_per_sec);
     ADD_TABLE_STAT(qe_builder, stats, table_id, written_docs_per_sec);
+    ADD_TABLE_LATENCY(qe_builder, stats, table_id, read_latency);
+    ADD_TABLE_LATENCY(qe_builder, stats, table_id, write_latency);
+    qe_builder.overwrite("write_latency_stages", write_latency_stages_to_datum(
+        [&](parsed_stats_t::histogram_t parsed_stats_t::table_stats_t::*field) {
+            return stats.merge_table(table_id, field);
+        }));
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
     *result_out = std::move(row_builder).to_datum();
@@ -407,7 +579,9 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
-          {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
+          {"mailbox_round_trips"},
+          {".*", "serializers", "shard_[0-9]+", "btree-.*" },
+          {".*", "serializers", "shard_[0-9]+", "(read|write)_latency" } });
 }
 
 std::vector<peer_id_t> server_stats_request_t::get_peers(
@@ -456,6 +630,10 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
+        ADD_LATENCY_STAT(qe_builder, server_stats, query_latency);
+        ADD_LATENCY_STAT(qe_builder, server_stats, mailbox_round_trip_latency);
+        ADD_SERVER_LATENCY(qe_builder, stats, server_id, read_latency);
+        ADD_SERVER_LATENCY(qe_builder, stats, server_id, write_latency);
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
     }
     *result_out = std::move(row_builder).to_datum();
@@ -494,7 +672,9 @@ table_server_stats_request_t::table_server_stats_request_t(
 
 std::set<std::vector<std::string> > table_server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >({
-        { uuid_to_str(table_id), "serializers" } });
+        { uuid_to_str(table_id), "serializers" },
+        { uuid_to_str(table_id), "regions", ".*", "broadcaster", "write_ack_latency" }
+        });
 }
 
 std::vector<peer_id_t> table_server_stats_request_t::get_peers(
@@ -549,9 +729,19 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(qe_builder, table_stats, read_docs_total);
         ADD_STAT(qe_builder, table_stats, written_docs_per_sec);
         ADD_STAT(qe_builder, table_stats, written_docs_total);
+        ADD_LATENCY_STAT(qe_builder, table_stats, read_latency);
+        ADD_LATENCY_STAT(qe_builder, table_stats, write_latency);
+        qe_builder.overwrite("write_latency_stages", write_latency_stages_to_datum(
+            [&](parsed_stats_t::histogram_t parsed_stats_t::table_stats_t::*field) {
+                return table_stats.*field;
+            }));
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
+        ADD_STAT(se_cache_builder, table_stats, limit_bytes);
+        ADD_STAT(se_cache_builder, table_stats, misses_total);
+        ADD_STAT(se_cache_builder, table_stats, ghost_hits_total);
+        ADD_STAT(se_cache_builder, table_stats, marginal_gain);
 
         ql::datum_object_builder_t se_disk_space_builder;
         ADD_STAT(se_disk_space_builder, table_stats, metadata_bytes);
@@ -564,6 +754,10 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(se_disk_builder, table_stats, read_bytes_total);
         ADD_STAT(se_disk_builder, table_stats, written_bytes_per_sec);
         ADD_STAT(se_disk_builder, table_stats, written_bytes_total);
+        se_disk_builder.overwrite("read_latency",
+                                  table_stats.disk_read_latency.to_datum(false));
+        se_disk_builder.overwrite("write_latency",
+                                  table_stats.disk_write_latency.to_datum(false));
         se_disk_builder.overwrite("space_usage", std::move(se_disk_space_builder).to_datum());
 
         ql::datum_object_builder_t se_builder;
@@ -9,6 +9,7 @@
 
 #include "clustering/administration/metadata.hpp"
 #include "containers/uuid.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/datum.hpp"
 
 class server_config_client_t;
@@ -28,6 +29,10 @@ public:
         double written_docs_per_sec;
         double written_docs_total;
         double in_use_bytes;
+        double limit_bytes;
+        double misses_total;
+        double ghost_hits_total;
+        double marginal_gain;
         double metadata_bytes;
         double data_bytes;
         double garbage_bytes;
@@ -36,6 +41,18 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+
+        perfmon_histogram::stats_t read_latency;
+        perfmon_histogram::stats_t write_latency;
+        // The stages of writes, see `write_stage_latencies` in `request.cc`
+        perfmon_histogram::stats_t write_ack_latency;
+        perfmon_histogram::stats_t write_superblock_latency;
+        perfmon_histogram::stats_t write_btree_latency;
+        perfmon_histogram::stats_t write_sindex_latency;
+        perfmon_histogram::stats_t write_changefeed_latency;
+        perfmon_histogram::stats_t write_commit_latency;
+        perfmon_histogram::stats_t disk_read_latency;
+        perfmon_histogram::stats_t disk_write_latency;
     };
 
     struct server_stats_t {
@@ -47,6 +64,9 @@ public:
         double client_connections;
         double clients_active;
 
+        perfmon_histogram::stats_t query_latency;
+        perfmon_histogram::stats_t mailbox_round_trip_latency;
+
         std::map<namespace_id_t, table_stats_t> tables;
     };
 
@@ -66,6 +86,15 @@ public:
     double accumulate_server(const server_id_t &server_id,
                              double table_stats_t::*field) const;
 
+    // Like the `accumulate` functions, but these merge latency histograms
+    typedef perfmon_histogram::stats_t histogram_t;
+    histogram_t merge(histogram_t server_stats_t::*field) const;
+    histogram_t merge(histogram_t table_stats_t::*field) const;
+    histogram_t merge_table(const namespace_id_t &table_id,
+                            histogram_t table_stats_t::*field) const;
+    histogram_t merge_server(const server_id_t &server_id,
+                             histogram_t table_stats_t::*field) const;
+
     std::map<server_id_t, server_stats_t> servers;
 
 private:
@@ -75,6 +104,11 @@ private:
                            const std::string &key,
                            double *value_out);
 
+    // Like `add_perfmon_value`, but keeps the largest value instead of the sum.
+    void max_perfmon_value(const ql::datum_t &perf,
+                           const std::string &key,
+                           double *value_out);
+
     // Stores a given stat value and asserts that the value is the default (0);
     // use `add_perfmon_value` for summing stats from multple sources.
     void store_perfmon_value(const ql::datum_t &perf,
@@ -87,6 +121,9 @@ private:
     void store_serializer_values(const ql::datum_t &ser_perf,
                                  table_stats_t *);
 
+    void store_region_values(const ql::datum_t &regions_perf,
+                             table_stats_t *stats_out);
+
     void store_query_engine_stats(const ql::datum_t &qe_perf,
                                   server_stats_t *stats_out);
 
@@ -9,10 +9,15 @@
 #include "perfmon/filter.hpp"
 #include "stl_utils.hpp"
 
+/* Long enough to coalesce clients that poll the `stats` table every second, short
+enough that the stats don't look stale. */
+static const int64_t STATS_CACHE_MAX_AGE_MS = 500;
+
 stat_manager_t::stat_manager_t(mailbox_manager_t* mm,
                                server_id_t _own_server_id) :
     own_server_id(_own_server_id),
     mailbox_manager(mm),
+    cached_stats_time(ticks_t{0}),
     get_stats_mailbox(mailbox_manager,
                       std::bind(&stat_manager_t::on_stats_request,
                                 this, ph::_1, ph::_2, ph::_3))
@@ -22,12 +27,23 @@ get_stats_mailbox_address_t stat_manager_t::get_address() {
     return get_stats_mailbox.get_address();
 }
 
+ql::datum_t stat_manager_t::get_stats(signal_t *interruptor) {
+    new_mutex_acq_t acq(&collect_mutex, interruptor);
+    ticks_t now = get_ticks();
+    if (!cached_stats.has()
+        || now.nanos - cached_stats_time.nanos > STATS_CACHE_MAX_AGE_MS * MILLION) {
+        cached_stats = perfmon_get_stats();
+        cached_stats_time = get_ticks();
+    }
+    return cached_stats;
+}
+
 void stat_manager_t::on_stats_request(
-        UNUSED signal_t *interruptor,
+        signal_t *interruptor,
         const return_address_t& reply_address,
         const std::set<std::vector<stat_id_t> >& requested_stats) {
     perfmon_filter_t request(requested_stats);
-    ql::datum_t perfmon_result(perfmon_get_stats());
+    ql::datum_t perfmon_result(get_stats(interruptor));
     perfmon_result = request.filter(perfmon_result);
 
     // Add in our own server id so the other side does not need to perform lookups
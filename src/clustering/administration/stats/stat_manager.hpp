@@ -6,8 +6,10 @@
 #include <set>
 #include <string>
 
+#include "concurrency/new_mutex.hpp"
 #include "perfmon/types.hpp"
 #include "rpc/mailbox/typed.hpp"
+#include "time.hpp"
 
 struct admin_err_t;
 
@@ -29,8 +31,23 @@ private:
         const return_address_t& reply_address,
         const std::set<std::vector<stat_id_t> >& requested_stats);
 
+    /* Returns the result of `perfmon_get_stats()`, reusing the last one if it's less
+    than `STATS_CACHE_MAX_AGE_MS` old. Collecting the stats visits every thread, so
+    when several clients poll the `stats` table at the same time, we only want to do
+    it once for all of them. */
+    ql::datum_t get_stats(signal_t *interruptor);
+
     server_id_t own_server_id;
     mailbox_manager_t *mailbox_manager;
+
+    // Held while collecting the stats, so that concurrent requests wait for the
+    // collection that's in progress instead of starting their own.
+    new_mutex_t collect_mutex;
+    // These stay on our home thread only because `collect_mutex` does.  The datum
+    // itself would be fine to share, since its reference counts are atomic.
+    ql::datum_t cached_stats;
+    ticks_t cached_stats_time;
+
     get_stats_mailbox_t get_stats_mailbox;
 
     DISABLE_COPYING(stat_manager_t);
@@ -5,6 +5,10 @@
 #include "clustering/table_manager/table_meta_client.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 
+/* Up to this many rows requested by primary key are read one by one, because reading a
+row only asks the servers for the stats that go into it. */
+static const size_t MAX_STATS_ROWS_READ_BY_KEY = 8;
+
 stats_artificial_table_backend_t::stats_artificial_table_backend_t(
         rdb_context_t *rdb_context,
         lifetime_t<name_resolver_t const &> name_resolver,
@@ -161,6 +165,42 @@ bool parse_stats_request(const ql::datum_t &info,
     return false;
 }
 
+bool stats_artificial_table_backend_t::read_rows_in_datumspec(
+        auth::user_context_t const &user_context,
+        const ql::datumspec_t &datumspec,
+        signal_t *interruptor_on_caller,
+        std::vector<ql::datum_t> *rows_out,
+        admin_err_t *error_out) {
+    std::vector<ql::datum_t> keys;
+    bool by_key = datumspec.visit<bool>(
+        [](const ql::datum_range_t &) { return false; },
+        [&](const std::map<ql::datum_t, uint64_t> &key_map) {
+            if (key_map.size() > MAX_STATS_ROWS_READ_BY_KEY) {
+                return false;
+            }
+            for (const auto &pair : key_map) {
+                keys.push_back(pair.first);
+            }
+            return true;
+        });
+    if (!by_key) {
+        return read_all_rows_as_vector(
+            user_context, interruptor_on_caller, rows_out, error_out);
+    }
+
+    rows_out->clear();
+    for (const ql::datum_t &key : keys) {
+        ql::datum_t row;
+        if (!read_row(user_context, key, interruptor_on_caller, &row, error_out)) {
+            return false;
+        }
+        if (row.has()) {
+            rows_out->push_back(std::move(row));
+        }
+    }
+    return true;
+}
+
 bool stats_artificial_table_backend_t::read_row(
         UNUSED auth::user_context_t const &user_context,
         ql::datum_t primary_key,
@@ -53,6 +53,13 @@ public:
             admin_err_t *error_out);
 
 private:
+    bool read_rows_in_datumspec(
+            auth::user_context_t const &user_context,
+            const ql::datumspec_t &datumspec,
+            signal_t *interruptor_on_caller,
+            std::vector<ql::datum_t> *rows_out,
+            admin_err_t *error_out);
+
     void get_peer_stats(const peer_id_t &peer,
                         const std::set<std::vector<std::string> > &filter,
                         ql::datum_t *result_out,
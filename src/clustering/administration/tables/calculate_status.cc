@@ -4,6 +4,7 @@
 #include "clustering/administration/namespace_interface_repository.hpp"
 #include "clustering/administration/servers/config_client.hpp"
 #include "concurrency/exponential_backoff.hpp"
+#include "concurrency/pmap.hpp"
 
 bool wait_for_table_readiness(
         const namespace_id_t &table_id,
@@ -67,31 +68,18 @@ size_t wait_for_many_tables_readiness(
     return tables.size();
 }
 
-void get_table_status(
+/* Fills in the rest of `status_out` once `raft_leader` and `server_shards` are set.
+This is the part of computing the status that's per table even when we fetch the shard
+statuses of every table at once. */
+static void finish_table_status(
         const namespace_id_t &table_id,
-        const table_config_and_shards_t &config,
+        bool all_replicas_ready,
         namespace_repo_t *namespace_repo,
-        table_meta_client_t *table_meta_client,
         server_config_client_t *server_config_client,
         signal_t *interruptor,
         table_status_t *status_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t) {
-    status_out->total_loss = false;
-    status_out->config = config;
-
-    /* Get the Raft leader for this table. */
-    table_meta_client->get_raft_leader(table_id, interruptor, &status_out->raft_leader);
-
-    /* Send the status query to every server for the table. */
-    bool all_replicas_ready;
-    try {
-        table_meta_client->get_shard_status(
-            table_id, all_replicas_ready_mode_t::EXCLUDE_RAFT_TEST, interruptor,
-            &status_out->server_shards, &all_replicas_ready);
-    } catch (const failed_table_op_exc_t &) {
-        all_replicas_ready = false;
-        status_out->server_shards.clear();
-    }
+    const table_config_and_shards_t &config = status_out->config;
 
     /* We need to pay special attention to servers that appear in the config but not in
     the status response. There are two possible reasons: they might be disconnected, or
@@ -177,3 +165,91 @@ void get_table_status(
     }
 }
 
+void get_table_status(
+        const namespace_id_t &table_id,
+        const table_config_and_shards_t &config,
+        namespace_repo_t *namespace_repo,
+        table_meta_client_t *table_meta_client,
+        server_config_client_t *server_config_client,
+        signal_t *interruptor,
+        table_status_t *status_out)
+        THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t) {
+    status_out->total_loss = false;
+    status_out->config = config;
+
+    /* Get the Raft leader for this table. */
+    table_meta_client->get_raft_leader(table_id, interruptor, &status_out->raft_leader);
+
+    /* Send the status query to every server for the table. */
+    bool all_replicas_ready;
+    try {
+        table_meta_client->get_shard_status(
+            table_id, all_replicas_ready_mode_t::EXCLUDE_RAFT_TEST, interruptor,
+            &status_out->server_shards, &all_replicas_ready);
+    } catch (const failed_table_op_exc_t &) {
+        all_replicas_ready = false;
+        status_out->server_shards.clear();
+    }
+
+    finish_table_status(table_id, all_replicas_ready, namespace_repo,
+        server_config_client, interruptor, status_out);
+}
+
+void get_all_table_statuses(
+        const std::map<namespace_id_t, table_config_and_shards_t> &configs,
+        namespace_repo_t *namespace_repo,
+        table_meta_client_t *table_meta_client,
+        server_config_client_t *server_config_client,
+        signal_t *interruptor,
+        std::map<namespace_id_t, table_status_t> *statuses_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    std::map<namespace_id_t, std::map<server_id_t, range_map_t<
+        key_range_t::right_bound_t, table_shard_status_t> > > server_shards;
+    std::map<namespace_id_t, bool> all_replicas_ready;
+    std::map<namespace_id_t, server_id_t> raft_leaders;
+    table_meta_client->list_shard_statuses(
+        all_replicas_ready_mode_t::EXCLUDE_RAFT_TEST, interruptor,
+        &server_shards, &all_replicas_ready, &raft_leaders);
+
+    statuses_out->clear();
+    for (const auto &pair : configs) {
+        table_status_t *status = &(*statuses_out)[pair.first];
+        status->total_loss = false;
+        status->config = pair.second;
+        auto leader_it = raft_leaders.find(pair.first);
+        if (leader_it != raft_leaders.end()) {
+            status->raft_leader = make_optional(leader_it->second);
+        }
+        auto shards_it = server_shards.find(pair.first);
+        if (shards_it != server_shards.end()) {
+            status->server_shards = std::move(shards_it->second);
+        }
+    }
+
+    /* Only tables that aren't completely ready need probe queries, so this is cheap
+    for a healthy cluster. */
+    pmap(statuses_out->begin(), statuses_out->end(),
+    [&](std::pair<const namespace_id_t, table_status_t> &pair) {
+        auto ready_it = all_replicas_ready.find(pair.first);
+        try {
+            finish_table_status(pair.first,
+                ready_it != all_replicas_ready.end() && ready_it->second,
+                namespace_repo, server_config_client, interruptor, &pair.second);
+        } catch (const no_such_table_exc_t &) {
+            /* The table was deleted in the meantime; it's erased below. */
+            pair.second.total_loss = true;
+        } catch (const interrupted_exc_t &) {
+            /* We're handling this outside the `pmap` */
+        }
+    });
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    for (auto it = statuses_out->begin(); it != statuses_out->end();) {
+        if (it->second.total_loss) {
+            statuses_out->erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -73,5 +73,18 @@ void get_table_status(
     table_status_t *status_out)
     THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t);
 
+/* Like calling `get_table_status()` for every table in `configs`, except that it asks
+every server about all of its tables in one round trip, which matters when there are
+thousands of tables. Tables that were deleted in the meantime are left out of
+`statuses_out`. */
+void get_all_table_statuses(
+    const std::map<namespace_id_t, table_config_and_shards_t> &configs,
+    namespace_repo_t *namespace_repo,
+    table_meta_client_t *table_meta_client,
+    server_config_client_t *server_config_client,
+    signal_t *interruptor,
+    std::map<namespace_id_t, table_status_t> *statuses_out)
+    THROWS_ONLY(interrupted_exc_t);
+
 #endif /* CLUSTERING_ADMINISTRATION_TABLES_CALCULATE_STATUS_HPP_ */
 
@@ -157,6 +157,36 @@ double estimate_backfill_cost(
     return numerator / denominator;
 }
 
+/* `estimate_write_locality()` estimates how many of the table's writes per second
+would reach `server` without crossing between server tags. Writes that `server` sends
+itself count fully; writes from servers that share a server tag with `server` count
+half. The `default` tag doesn't count, since almost every server has it. */
+double estimate_write_locality(
+        const server_id_t &server,
+        const std::map<server_id_t, double> &write_rates,
+        const std::map<server_id_t, std::set<name_string_t> > &server_tags) {
+    static const name_string_t default_tag = name_string_t::guarantee_valid("default");
+    auto tags_it = server_tags.find(server);
+    double locality = 0;
+    for (const auto &pair : write_rates) {
+        if (pair.first == server) {
+            locality += pair.second;
+            continue;
+        }
+        auto other_it = server_tags.find(pair.first);
+        if (tags_it == server_tags.end() || other_it == server_tags.end()) {
+            continue;
+        }
+        for (const name_string_t &tag : tags_it->second) {
+            if (tag != default_tag && other_it->second.count(tag) == 1) {
+                locality += pair.second / 2;
+                break;
+            }
+        }
+    }
+    return locality;
+}
+
 /* A `pairing_t` represents the possibility of using the given server as a replica for
 the given shard.
 
@@ -171,7 +201,12 @@ cost to copy data to the given server, as computed by
 Because we'll be regularly updating `self_usage_cost`, we want to make updating it
 inexpensive. We solve this by storing `self_usage_cost` for an entire group of pairings
 (a `server_pairings_t`) simultaneously. The `server_pairings_t`s are themselves sorted
-first by `self_usage_cost` and then by the cost of the cheapest internal `pairing_t`. */
+first by `self_usage_cost` and then by the cost of the cheapest internal `pairing_t`.
+
+When placing primaries with `primary_near_writes`, `locality_cost` comes before all of
+these. It's the negated number of writes per second that are local to the server, as
+computed by `estimate_write_locality()`, rounded so that small differences in the
+sampled rates don't matter. Otherwise it is zero. */
 
 class pairing_t {
 public:
@@ -186,6 +221,7 @@ public:
     server_pairings_t(server_pairings_t &&) = default;
     server_pairings_t &operator=(server_pairings_t &&) = default;
 
+    int locality_cost;
     int self_usage_cost;
     std::multiset<pairing_t> pairings;
     int other_usage_cost;
@@ -200,7 +236,11 @@ bool operator<(const counted_t<countable_wrapper_t<server_pairings_t> > &x,
                const counted_t<countable_wrapper_t<server_pairings_t> > &y) {
     guarantee(!x->pairings.empty());
     guarantee(!y->pairings.empty());
-    if (x->self_usage_cost < y->self_usage_cost) {
+    if (x->locality_cost < y->locality_cost) {
+        return true;
+    } else if (x->locality_cost > y->locality_cost) {
+        return false;
+    } else if (x->self_usage_cost < y->self_usage_cost) {
         return true;
     } else if (x->self_usage_cost > y->self_usage_cost) {
         return false;
@@ -249,6 +289,7 @@ void table_generate_config(
         table_meta_client_t *table_meta_client,
         const table_generate_config_params_t &params,
         const table_shard_scheme_t &shard_scheme,
+        const std::map<server_id_t, double> &write_rates,
         signal_t *interruptor,
         std::vector<table_config_t::shard_t> *config_shards_out,
         server_name_map_t *server_names_out)
@@ -262,8 +303,12 @@ void table_generate_config(
     consistent. */
     server_name_map_t server_names;
     std::map<name_string_t, std::set<server_id_t> > servers_with_tags;
+    std::map<server_id_t, std::set<name_string_t> > server_tags;
     server_config_client->get_server_config_map()->read_all(
     [&](const server_id_t &sid, const server_config_versioned_t *config) {
+        if (params.primary_near_writes) {
+            server_tags[sid] = config->config.tags;
+        }
         bool any = false;
         for (const name_string_t &tag : config->config.tags) {
             if (params.num_replicas.count(tag) != 0) {
@@ -339,6 +384,7 @@ void table_generate_config(
         for (const server_id_t &server : servers_with_tags.at(server_tag)) {
             server_pairings_t sp;
             sp.server = server;
+            sp.locality_cost = 0;
             sp.self_usage_cost = 0;
             auto u_it = server_usage.find(server);
             sp.other_usage_cost = (u_it == server_usage.end()) ? 0 : u_it->second;
@@ -382,8 +428,13 @@ void table_generate_config(
             std::multiset<counted_t<countable_wrapper_t<server_pairings_t> > > s;
             for (const auto &x : pairings) {
                 if (!x.second.pairings.empty()) {
-                    s.insert(make_counted<countable_wrapper_t<server_pairings_t> >(
-                        x.second));
+                    auto sp = make_counted<countable_wrapper_t<server_pairings_t> >(
+                        x.second);
+                    if (params.primary_near_writes) {
+                        sp->locality_cost = -static_cast<int>(estimate_write_locality(
+                            x.first, write_rates, server_tags));
+                    }
+                    s.insert(sp);
                 }
             }
             pick_best_pairings(
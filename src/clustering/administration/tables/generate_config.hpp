@@ -32,6 +32,11 @@ void table_generate_config(
         /* What the new sharding scheme for the table will be. If `table_id` is
         `nil_uuid()` this is unused. */
         const table_shard_scheme_t &shard_scheme,
+        /* How many writes per second each server sends to the table. This is only
+        used if `params.primary_near_writes` is set; then all of the table's primary
+        replicas go to the server where most of the writes are local, even if that
+        means putting several of them on the same server. */
+        const std::map<server_id_t, double> &write_rates,
 
         signal_t *interruptor,
 
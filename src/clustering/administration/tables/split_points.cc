@@ -89,7 +89,8 @@ void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *loads_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     namespace_interface_access_t ns_if_access =
         reql_cluster_interface->get_namespace_repo()->get_namespace_interface(
@@ -113,21 +114,28 @@ void fetch_distribution(
         /* If `get_name()` didn't throw, the table exists but is inaccessible */
         throw failed_table_op_exc_t();
     }
-    *counts_out = std::move(
-        boost::get<distribution_read_response_t>(resp.response).key_counts);
+    distribution_read_response_t *dist_resp =
+        boost::get<distribution_read_response_t>(&resp.response);
+    *counts_out = std::move(dist_resp->key_counts);
+    if (loads_out != nullptr) {
+        *loads_out = std::move(dist_resp->key_loads);
+    }
 }
 
-bool calculate_split_points_with_distribution(
-        const std::map<store_key_t, int64_t> &counts,
+/* `calculate_split_points_with_weights()` is the common part of
+`calculate_split_points_with_distribution()` and `calculate_split_points_with_load()`.
+`weights` has the same format as the `key_counts` of a `distribution_read_response_t`. */
+static bool calculate_split_points_with_weights(
+        const std::map<store_key_t, double> &weights,
         size_t num_shards,
         table_shard_scheme_t *split_points_out) {
-    std::vector<std::pair<int64_t, store_key_t> > pairs;
-    int64_t total_count = 0;
-    for (auto const &pair : counts) {
+    std::vector<std::pair<double, store_key_t> > pairs;
+    double total_weight = 0;
+    for (auto const &pair : weights) {
         if (pair.second != 0) {
-            pairs.push_back(std::make_pair(total_count, pair.first));
+            pairs.push_back(std::make_pair(total_weight, pair.first));
         }
-        total_count += pair.second;
+        total_weight += pair.second;
     }
     if (pairs.size() < static_cast<size_t>(num_shards)) {
         return false;
@@ -136,19 +144,19 @@ bool calculate_split_points_with_distribution(
     split_points_out->split_points.clear();
     size_t left_pair = 0;
     for (size_t split_index = 1; split_index < num_shards; ++split_index) {
-        int64_t split_count = (split_index * total_count) / num_shards;
-        rassert(pairs[left_pair].first <= split_count);
+        double split_weight = (split_index * total_weight) / num_shards;
+        rassert(pairs[left_pair].first <= split_weight);
         while (left_pair+1 < pairs.size() &&
-                pairs[left_pair+1].first <= split_count) {
+                pairs[left_pair+1].first <= split_weight) {
             ++left_pair;
         }
-        std::pair<int64_t, store_key_t> left = pairs[left_pair];
-        std::pair<int64_t, store_key_t> right =
+        std::pair<double, store_key_t> left = pairs[left_pair];
+        std::pair<double, store_key_t> right =
             (left_pair == pairs.size() - 1)
-                ? std::make_pair(total_count, store_key_t::max())
+                ? std::make_pair(total_weight, store_key_t::max())
                 : pairs[left_pair+1];
         store_key_t split_key = interpolate_key(left.second, right.second,
-            (split_count - left.first) / static_cast<double>(right.first - left.first));
+            clamp((split_weight - left.first) / (right.first - left.first), 0.0, 1.0));
         split_points_out->split_points.push_back(split_key);
     }
     ensure_distinct(&split_points_out->split_points);
@@ -156,6 +164,59 @@ bool calculate_split_points_with_distribution(
     return true;
 }
 
+bool calculate_split_points_with_distribution(
+        const std::map<store_key_t, int64_t> &counts,
+        size_t num_shards,
+        table_shard_scheme_t *split_points_out) {
+    std::map<store_key_t, double> weights;
+    for (auto const &pair : counts) {
+        weights.insert(weights.end(),
+            std::make_pair(pair.first, static_cast<double>(pair.second)));
+    }
+    return calculate_split_points_with_weights(weights, num_shards, split_points_out);
+}
+
+bool calculate_split_points_with_load(
+        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &loads,
+        size_t num_shards,
+        table_shard_scheme_t *split_points_out) {
+    if (counts.empty()) {
+        return false;
+    }
+    int64_t total_count = 0;
+    for (auto const &pair : counts) {
+        total_count += pair.second;
+    }
+    int64_t total_load = 0;
+    for (auto const &pair : loads) {
+        total_load += pair.second;
+    }
+    if (total_count == 0 || total_load == 0) {
+        return false;
+    }
+
+    /* Every range of the distribution gets half of its weight from its share of the
+    documents and half from its share of the load. Ignoring the documents entirely
+    could put almost all of them into one shard just because they're rarely
+    accessed. */
+    std::map<store_key_t, double> weights;
+    for (auto const &pair : counts) {
+        weights.insert(weights.end(), std::make_pair(
+            pair.first, 0.5 * pair.second / total_count));
+    }
+    for (auto const &pair : loads) {
+        /* Find the range of the distribution that contains the key. Keys before the
+        first range go into the first one. */
+        auto it = weights.upper_bound(pair.first);
+        if (it != weights.begin()) {
+            --it;
+        }
+        it->second += 0.5 * pair.second / total_load;
+    }
+    return calculate_split_points_with_weights(weights, num_shards, split_points_out);
+}
+
 store_key_t key_for_uuid(uint64_t first_8_bytes) {
     uuid_u uuid;
     memset(uuid.data(), 0, uuid_u::static_size());
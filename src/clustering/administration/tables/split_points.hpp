@@ -14,12 +14,15 @@ class real_reql_cluster_interface_t;
 class signal_t;
 class table_shard_scheme_t;
 
-/* `fetch_distribution` fetches the distribution information from the database. */
+/* `fetch_distribution` fetches the distribution information from the database. If
+`loads_out` isn't null, it also gets the recent load on the keys, as sampled by the
+stores. */
 void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *loads_out = nullptr)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t);
 
 /* `calculate_split_points_with_distribution` generates a set of split points that are
@@ -31,6 +34,16 @@ bool calculate_split_points_with_distribution(
         size_t num_shards,
         table_shard_scheme_t *split_points_out);
 
+/* `calculate_split_points_with_load` is like `calculate_split_points_with_distribution`,
+but it also takes the recent load from `fetch_distribution()` into account, so that hot
+key ranges end up in smaller shards. It returns `false` if there are too few documents or
+there hasn't been any load. */
+bool calculate_split_points_with_load(
+        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &loads,
+        size_t num_shards,
+        table_shard_scheme_t *split_points_out);
+
 /* `calculate_split_points_for_uuids` generates a set of split points that will divide
 the range of UUIDs evenly. */
 void calculate_split_points_for_uuids(
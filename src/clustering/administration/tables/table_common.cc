@@ -37,43 +37,19 @@ bool common_table_artificial_table_backend_t::read_all_rows_as_vector(
     std::map<namespace_id_t, table_basic_config_t> disconnected_configs;
     table_meta_client->list_configs(
         &interruptor_on_home, &configs, &disconnected_configs);
-    rows_out->clear();
-    pmap(configs.cbegin(), configs.cend(),
-        [&](const std::pair<namespace_id_t, table_config_and_shards_t> &pair) {
+    std::map<namespace_id_t, ql::datum_t> db_names_or_uuids;
+    for (const auto &pair : configs) {
         ql::datum_t db_name_or_uuid;
         if (!convert_database_id_to_datum(
             pair.second.config.basic.database, identifier_format, metadata,
             &db_name_or_uuid, nullptr)) {
             db_name_or_uuid = ql::datum_t("__deleted_database__");
         }
-        try {
-            ql::datum_t row;
-            format_row(
-                user_context,
-                pair.first,
-                pair.second,
-                db_name_or_uuid,
-                &interruptor_on_home, &row);
-            rows_out->push_back(row);
-        } catch (const no_such_table_exc_t &) {
-            /* The table got deleted between the call to `list_configs()` and the
-            call to `format_row()`. Ignore it. */
-        } catch (const failed_table_op_exc_t &) {
-            ql::datum_t row;
-            format_error_row(
-                user_context,
-                pair.first,
-                db_name_or_uuid,
-                pair.second.config.basic.name,
-                &row);
-            rows_out->push_back(row);
-        } catch (const interrupted_exc_t &) {
-            /* We're handling this outside the `pmap` */
-        }
-    });
-    if (interruptor_on_home.is_pulsed()) {
-        throw interrupted_exc_t();
+        db_names_or_uuids.insert(std::make_pair(pair.first, db_name_or_uuid));
     }
+    rows_out->clear();
+    format_all_rows(
+        user_context, configs, db_names_or_uuids, &interruptor_on_home, rows_out);
     for (const auto &pair : disconnected_configs) {
         ql::datum_t db_name_or_uuid;
         if (!convert_database_id_to_datum(
@@ -139,6 +115,46 @@ bool common_table_artificial_table_backend_t::read_row(
     }
 }
 
+void common_table_artificial_table_backend_t::format_all_rows(
+        auth::user_context_t const &user_context,
+        const std::map<namespace_id_t, table_config_and_shards_t> &configs,
+        const std::map<namespace_id_t, ql::datum_t> &db_names_or_uuids,
+        signal_t *interruptor_on_home,
+        std::vector<ql::datum_t> *rows_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    pmap(configs.cbegin(), configs.cend(),
+        [&](const std::pair<namespace_id_t, table_config_and_shards_t> &pair) {
+        const ql::datum_t &db_name_or_uuid = db_names_or_uuids.at(pair.first);
+        try {
+            ql::datum_t row;
+            format_row(
+                user_context,
+                pair.first,
+                pair.second,
+                db_name_or_uuid,
+                interruptor_on_home, &row);
+            rows_out->push_back(row);
+        } catch (const no_such_table_exc_t &) {
+            /* The table got deleted between the call to `list_configs()` and the
+            call to `format_row()`. Ignore it. */
+        } catch (const failed_table_op_exc_t &) {
+            ql::datum_t row;
+            format_error_row(
+                user_context,
+                pair.first,
+                db_name_or_uuid,
+                pair.second.config.basic.name,
+                &row);
+            rows_out->push_back(row);
+        } catch (const interrupted_exc_t &) {
+            /* We're handling this outside the `pmap` */
+        }
+    });
+    if (interruptor_on_home->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+}
+
 void common_table_artificial_table_backend_t::format_error_row(
         UNUSED auth::user_context_t const &user_context,
         const namespace_id_t &table_id,
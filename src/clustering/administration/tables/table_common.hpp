@@ -61,6 +61,19 @@ protected:
             failed_table_op_exc_t,
             auth::permission_error_t) = 0;
 
+    /* `read_all_rows_as_vector()` calls this with every table whose configuration it
+    found. The default implementation calls `format_row()` for each one, which is fine
+    unless `format_row()` contacts other servers; then subclasses should override it to
+    fetch the information for all the tables at once. Rows for tables that were deleted
+    in the meantime are left out. */
+    virtual void format_all_rows(
+            auth::user_context_t const &user_context,
+            const std::map<namespace_id_t, table_config_and_shards_t> &configs,
+            const std::map<namespace_id_t, ql::datum_t> &db_names_or_uuids,
+            signal_t *interruptor_on_home,
+            std::vector<ql::datum_t> *rows_out)
+        THROWS_ONLY(interrupted_exc_t);
+
     /* This is called for tables that we couldn't even determine the current
     configuration of, because every single server for the table is disconnected. The
     default implementation produces a document with an `error` field describing the
@@ -204,6 +204,8 @@ ql::datum_t convert_durability_to_datum(
             return ql::datum_t("soft");
         case write_durability_t::HARD:
             return ql::datum_t("hard");
+        case write_durability_t::GROUP:
+            return ql::datum_t("group");
         case write_durability_t::INVALID:
         default:
             unreachable();
@@ -218,9 +220,11 @@ bool convert_durability_from_datum(
         *durability_out = write_durability_t::SOFT;
     } else if (datum == ql::datum_t("hard")) {
         *durability_out = write_durability_t::HARD;
+    } else if (datum == ql::datum_t("group")) {
+        *durability_out = write_durability_t::GROUP;
     } else {
         *error_out = admin_err_t{
-            "Expected \"soft\" or \"hard\", got: " + datum.print(),
+            "Expected \"soft\", \"hard\" or \"group\", got: " + datum.print(),
             query_state_t::FAILED};
         return false;
     }
@@ -275,6 +279,25 @@ bool convert_flush_interval_from_datum(
     return true;
 }
 
+bool convert_block_size_from_datum(
+        const ql::datum_t &datum,
+        uint32_t *block_size_out,
+        admin_err_t *error_out) {
+    // The range check comes first, so that the cast can't overflow.
+    if (datum.get_type() != ql::datum_t::R_NUM
+            || !(datum.as_num() >= 0 && datum.as_num() <= MAX_BTREE_BLOCK_SIZE)
+            || datum.as_num() != static_cast<int64_t>(datum.as_num())
+            || !is_valid_table_block_size(static_cast<int64_t>(datum.as_num()))) {
+        *error_out = admin_err_t{
+            strprintf("Expected a power of two between %lld and %lld, got: ",
+                      DEFAULT_BTREE_BLOCK_SIZE, MAX_BTREE_BLOCK_SIZE) + datum.print(),
+            query_state_t::FAILED};
+        return false;
+    }
+    *block_size_out = static_cast<uint32_t>(datum.as_num());
+    return true;
+}
+
 ql::datum_t convert_table_config_shard_to_datum(
         const table_config_t::shard_t &shard,
         admin_identifier_format_t identifier_format,
@@ -461,6 +484,7 @@ ql::datum_t convert_table_config_to_datum(
     builder.overwrite("flush_interval",
         convert_flush_interval_to_datum(config.flush_interval));
     builder.overwrite("data", config.user_data.datum);
+    builder.overwrite("block_size", ql::datum_t(static_cast<double>(config.block_size)));
     return std::move(builder).to_datum();
 }
 
@@ -531,7 +555,8 @@ bool convert_table_config_and_name_from_datum(
     }
 
     /* As a special case, we allow the user to omit `indexes`, `primary_key`, `shards`,
-    `write_acks`, `durability`, and/or `data` for newly-created tables. */
+    `write_acks`, `durability`, `data`, and/or `block_size` for newly-created
+    tables. */
 
     if (converter.has("indexes")) {
         ql::datum_t indexes_datum;
@@ -610,7 +635,8 @@ bool convert_table_config_and_name_from_datum(
             table_generate_config(
                 server_config_client, nil_uuid(), table_meta_client,
                 table_generate_config_params_t::make_default(), table_shard_scheme_t(),
-                interruptor, &config_out->shards, server_names_out);
+                std::map<server_id_t, double>(), interruptor, &config_out->shards,
+                server_names_out);
         } catch (const admin_op_exc_t &msg) {
             throw admin_op_exc_t(
                 "Unable to automatically generate configuration for "
@@ -703,6 +729,20 @@ bool convert_table_config_and_name_from_datum(
         config_out->user_data = default_user_data();
     }
 
+    if (existed_before || converter.has("block_size")) {
+        ql::datum_t block_size_datum;
+        if (!converter.get("block_size", &block_size_datum, error_out)) {
+            return false;
+        }
+        if (!convert_block_size_from_datum(
+                block_size_datum, &config_out->block_size, error_out)) {
+            error_out->msg = "In `block_size`: " + error_out->msg;
+            return false;
+        }
+    } else {
+        config_out->block_size = DEFAULT_BTREE_BLOCK_SIZE;
+    }
+
     if (!converter.check_no_extra_keys(error_out)) {
         return false;
     }
@@ -729,6 +769,11 @@ void table_config_artificial_table_backend_t::do_modify(
                              query_state_t::FAILED);
     }
 
+    if (new_config.config.block_size != old_config.config.block_size) {
+        throw admin_op_exc_t("It's illegal to change a table's block size",
+                             query_state_t::FAILED);
+    }
+
     if (new_config.config.basic.database != old_config.config.basic.database ||
             new_config.config.basic.name != old_config.config.basic.name) {
         if (table_meta_client->exists(
@@ -2,6 +2,7 @@
 #ifndef CLUSTERING_ADMINISTRATION_TABLES_TABLE_METADATA_HPP_
 #define CLUSTERING_ADMINISTRATION_TABLES_TABLE_METADATA_HPP_
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string>
@@ -77,6 +78,10 @@ public:
 
 user_data_t default_user_data();
 
+/* Tables can only use a power of two between `DEFAULT_BTREE_BLOCK_SIZE` and
+`MAX_BTREE_BLOCK_SIZE` as their block size. */
+bool is_valid_table_block_size(int64_t block_size);
+
 /* `table_config_t` describes the complete contents of the `rethinkdb.table_config`
 artificial table. */
 
@@ -107,6 +112,9 @@ public:
     write_durability_t durability;
     flush_interval_config_t flush_interval;
     user_data_t user_data;  // has user-exposed name "data"
+    /* The block size of the table's files, which is fixed when the table is created.
+    Servers that join the table later create their files with it as well. */
+    uint32_t block_size;
 };
 
 RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t);
@@ -143,11 +151,8 @@ public:
     }
 
     size_t find_shard_for_key(const store_key_t &key) const {
-        size_t ix = 0;
-        while (ix < split_points.size() && key >= split_points[ix]) {
-            ++ix;
-        }
-        return ix;
+        return std::upper_bound(split_points.begin(), split_points.end(), key)
+            - split_points.begin();
     }
 };
 
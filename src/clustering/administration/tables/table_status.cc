@@ -168,12 +168,36 @@ void table_status_artificial_table_backend_t::format_row(
     table_status_t status;
     get_table_status(table_id, config, namespace_repo, table_meta_client,
         server_config_client, interruptor_on_home, &status);
+    *row_out = status_to_row(table_id, status, db_name_or_uuid);
+}
+
+void table_status_artificial_table_backend_t::format_all_rows(
+        UNUSED auth::user_context_t const &user_context,
+        const std::map<namespace_id_t, table_config_and_shards_t> &configs,
+        const std::map<namespace_id_t, ql::datum_t> &db_names_or_uuids,
+        signal_t *interruptor_on_home,
+        std::vector<ql::datum_t> *rows_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    std::map<namespace_id_t, table_status_t> statuses;
+    get_all_table_statuses(configs, namespace_repo, table_meta_client,
+        server_config_client, interruptor_on_home, &statuses);
+    for (const auto &pair : statuses) {
+        rows_out->push_back(status_to_row(
+            pair.first, pair.second, db_names_or_uuids.at(pair.first)));
+    }
+}
+
+ql::datum_t table_status_artificial_table_backend_t::status_to_row(
+        const namespace_id_t &table_id,
+        const table_status_t &status,
+        const ql::datum_t &db_name_or_uuid) {
     ql::datum_t status_datum = convert_table_status_to_datum(status, identifier_format);
     ql::datum_object_builder_t builder(status_datum);
     builder.overwrite("id", convert_uuid_to_datum(table_id));
     builder.overwrite("db", db_name_or_uuid);
     builder.overwrite("name", convert_name_to_datum(status.config.config.basic.name));
-    *row_out = std::move(builder).to_datum();
+    return std::move(builder).to_datum();
 }
 
 void table_status_artificial_table_backend_t::format_error_row(
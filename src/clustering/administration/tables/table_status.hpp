@@ -3,7 +3,9 @@
 #define CLUSTERING_ADMINISTRATION_TABLES_TABLE_STATUS_HPP_
 
 #include <memory>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "clustering/administration/tables/calculate_status.hpp"
 #include "clustering/administration/tables/table_common.hpp"
@@ -48,6 +50,19 @@ private:
             ql::datum_t *row_out)
             THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t, failed_table_op_exc_t);
 
+    void format_all_rows(
+            auth::user_context_t const &user_context,
+            const std::map<namespace_id_t, table_config_and_shards_t> &configs,
+            const std::map<namespace_id_t, ql::datum_t> &db_names_or_uuids,
+            signal_t *interruptor_on_home,
+            std::vector<ql::datum_t> *rows_out)
+            THROWS_ONLY(interrupted_exc_t);
+
+    ql::datum_t status_to_row(
+            const namespace_id_t &table_id,
+            const table_status_t &status,
+            const ql::datum_t &db_name_or_uuid);
+
     void format_error_row(
             auth::user_context_t const &user_context,
             const namespace_id_t &table_id,
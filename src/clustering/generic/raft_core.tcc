@@ -1775,8 +1775,11 @@ void raft_member_t<state_t>::leader_send_updates(
                 `committed_state` would help the follower catch up faster. */
                 request.snapshot_state = ps().snapshot_state;
                 request.snapshot_config = ps().snapshot_config;
+                const raft_log_index_t last_included_index = request.last_included_index;
+                /* The snapshot can be large, so we move it into the wrapper instead of
+                keeping a second copy around until the RPC returns. */
                 raft_rpc_request_t<state_t> request_wrapper;
-                request_wrapper.request = request;
+                request_wrapper.request = std::move(request);
 
                 raft_rpc_reply_t reply_wrapper;
                 DEBUG_ONLY_CODE(check_invariants(mutex_acq.get()));
@@ -1818,10 +1821,10 @@ void raft_member_t<state_t>::leader_send_updates(
                     return;
                 }
 
-                next_index = request.last_included_index + 1;
+                next_index = last_included_index + 1;
                 leader_update_match_index(
                     peer,
-                    request.last_included_index,
+                    last_included_index,
                     mutex_acq.get());
                 send_even_if_empty = false;
 
@@ -1844,8 +1847,10 @@ void raft_member_t<state_t>::leader_send_updates(
                 guarantee(request.entries.get_latest_index()
                     == ps().log.get_latest_index());
                 request.leader_commit = committed_state.get_ref().log_index;
+                const raft_log_index_t latest_index = request.entries.get_latest_index();
+                const raft_log_index_t leader_commit = request.leader_commit;
                 raft_rpc_request_t<state_t> request_wrapper;
-                request_wrapper.request = request;
+                request_wrapper.request = std::move(request);
 
                 raft_rpc_reply_t reply_wrapper;
                 DEBUG_ONLY_CODE(check_invariants(mutex_acq.get()));
@@ -1892,14 +1897,14 @@ void raft_member_t<state_t>::leader_send_updates(
                 if (reply->success) {
                     /* Raft paper, Figure 2: "If successful: update nextIndex and
                     matchIndex for follower */
-                    next_index = request.entries.get_latest_index() + 1;
-                    if (match_indexes.at(peer) < request.entries.get_latest_index()) {
+                    next_index = latest_index + 1;
+                    if (match_indexes.at(peer) < latest_index) {
                         leader_update_match_index(
                             peer,
-                            request.entries.get_latest_index(),
+                            latest_index,
                             mutex_acq.get());
                     }
-                    member_commit_index = request.leader_commit;
+                    member_commit_index = leader_commit;
                 } else {
                     /* Raft paper, Section 5.3: "After a rejection, the leader decrements
                     nextIndex and retries the AppendEntries RPC. */
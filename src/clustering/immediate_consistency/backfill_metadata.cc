@@ -1,10 +1,14 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/backfill_metadata.hpp"
 
+/* The queue sizes are the most data that can be in flight between the backfiller and
+the backfillee, so a backfill can't go faster than a queue's worth per round trip. They
+are large enough to keep a link between datacenters busy; the memory is only used when
+the receiving side falls behind. */
 backfill_config_t::backfill_config_t() :
-    item_queue_mem_size(4 * MEGABYTE),
+    item_queue_mem_size(16 * MEGABYTE),
     item_chunk_mem_size(100 * KILOBYTE),
-    pre_item_queue_mem_size(4 * MEGABYTE),
+    pre_item_queue_mem_size(16 * MEGABYTE),
     pre_item_chunk_mem_size(100 * KILOBYTE)
     { }
 
@@ -8,6 +8,7 @@
 #include "concurrency/new_semaphore.hpp"
 #include "containers/scoped.hpp"
 #include "rpc/connectivity/peer_id.hpp"
+#include "rpc/connectivity/server_id.hpp"
 #include "threading.hpp"
 
 /* `backfill_throttler_t` controls which backfills are allowed to run when. It can block
@@ -64,6 +65,19 @@ public:
         cond_t preempt_signal;
     };
 
+    /* Backfillees call `wait_for_bandwidth()` before they acknowledge backfill items
+    that they received from the server `source`, and `on_bytes_received()` when they
+    acknowledge them. Since the backfiller only sends more items once the previous ones
+    have been acknowledged, blocking in `wait_for_bandwidth()` slows the backfill down.
+    By default, the bandwidth isn't limited. */
+    virtual void wait_for_bandwidth(
+            UNUSED const server_id_t &source,
+            UNUSED signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) { }
+    virtual void on_bytes_received(
+            UNUSED const server_id_t &source,
+            UNUSED size_t bytes) { }
+
 protected:
     friend class lock_t;
 
@@ -11,6 +11,12 @@ backfiller. If it's too short, we'll waste resources sending lots of tiny
 acknowledgements; if it's too long, the pipeline might stall. */
 static const int ITEM_ACK_INTERVAL_MS = 100;
 
+/* We also acknowledge right away once we've consumed this fraction of the item queue.
+Otherwise the backfiller could only ever send one queue's worth of items per
+`ITEM_ACK_INTERVAL_MS` plus a round trip, which caps the backfill rate on fast disks
+and on high-latency links long before the network does. */
+static const size_t ITEM_EARLY_ACK_QUEUE_FRACTION = 4;
+
 /* `backfillee_t::session_t` contains all the bits and pieces for managing a single
 backfill session. It's impossible to have multiple sessions running at once, so in
 principle this could have been implemented as some member variables on `backfillee_t`;
@@ -60,6 +66,7 @@ public:
             backfill_item_seq_t<backfill_item_t> &&chunk) {
         rassert(metainfo_chunk.get_domain() == chunk.get_region());
         items_mem_size_unacked += chunk.get_mem_size();
+        parent->progress_tracker->bytes_received += chunk.get_mem_size();
         items.concat(std::move(chunk));
         metainfo.extend_keys_right(std::move(metainfo_chunk));
         metainfo_binary = from_version_map(metainfo);
@@ -98,6 +105,7 @@ private:
                     items, or else we'd wait forever. This also ensures that if we're
                     ending the session, we'll ack every item instead of leaking semaphore
                     credits. */
+                    callback->wait_for_bandwidth(keepalive.get_drain_signal());
                     send_ack_items();
 
                     /* `send_ack_items()` could block, so we have to check again */
@@ -132,7 +140,8 @@ private:
                 range or we run out of items */
                 class producer_t : public store_view_t::backfill_item_producer_t {
                 public:
-                    explicit producer_t(session_t *_parent) : parent(_parent) {
+                    explicit producer_t(session_t *_parent) :
+                            parent(_parent), pulse_to_ack_early(nullptr) {
                         coro_t::spawn_sometime(std::bind(
                             &producer_t::ack_periodically, this, drainer.lock()));
                     }
@@ -147,6 +156,7 @@ private:
                             *is_item_out = true;
                             *item_out = parent->items.front();
                             parent->items.pop_front();
+                            maybe_ack_early();
                             return continue_bool_t::CONTINUE;
                         } else if (!parent->items.empty_domain()) {
                             /* There aren't any more items left in the queue, but there's
@@ -206,14 +216,39 @@ private:
                     void ack_periodically(auto_drainer_t::lock_t keepalive2) {
                         try {
                             while (true) {
-                                nap(ITEM_ACK_INTERVAL_MS, keepalive2.get_drain_signal());
+                                {
+                                    cond_t wake;
+                                    assignment_sentry_t<cond_t *> sentry(
+                                        &pulse_to_ack_early, &wake);
+                                    signal_timer_t timer(ITEM_ACK_INTERVAL_MS);
+                                    wait_any_t waiter(&timer, &wake);
+                                    wait_interruptible(
+                                        &waiter, keepalive2.get_drain_signal());
+                                }
+                                parent->callback->wait_for_bandwidth(
+                                    keepalive2.get_drain_signal());
                                 parent->send_ack_items();
                             }
                         } catch (const interrupted_exc_t &) {
                             /* ignore */
                         }
                     }
+                    /* Wakes up `ack_periodically()` if we've consumed enough items
+                    since the last ack. It doesn't send the ack itself, because
+                    `next_item()` mustn't block. */
+                    void maybe_ack_early() {
+                        const size_t consumed = parent->items_mem_size_unacked
+                            - parent->items.get_mem_size();
+                        const size_t threshold =
+                            parent->parent->backfill_config.item_queue_mem_size
+                            / ITEM_EARLY_ACK_QUEUE_FRACTION;
+                        if (pulse_to_ack_early != nullptr && consumed >= threshold) {
+                            pulse_to_ack_early->pulse_if_not_already_pulsed();
+                        }
+                    }
                     session_t *parent;
+                    /* `ack_periodically()` puts a `cond_t` here while it waits. */
+                    cond_t *pulse_to_ack_early;
                     auto_drainer_t drainer;
                 } producer(this);
 
@@ -261,6 +296,7 @@ private:
             items_mem_size_unacked -= diff;
             send(parent->mailbox_manager, parent->intro.ack_items_mailbox,
                 parent->fifo_source.enter_write(), diff);
+            callback->on_items_acked(diff);
         }
     }
 
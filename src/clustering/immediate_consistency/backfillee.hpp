@@ -52,6 +52,13 @@ public:
     public:
         virtual bool on_progress(
             const region_map_t<version_t> &chunk) THROWS_NOTHING = 0;
+        /* `wait_for_bandwidth()` is called before the backfillee acknowledges the
+        backfill items that it has applied, and `on_items_acked()` is called with their
+        total mem size when it acknowledges them. Blocking in `wait_for_bandwidth()`
+        slows the backfiller down. */
+        virtual void wait_for_bandwidth(
+                UNUSED signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) { }
+        virtual void on_items_acked(UNUSED size_t mem_size) THROWS_NOTHING { }
     protected:
         virtual ~callback_t() { }
     };
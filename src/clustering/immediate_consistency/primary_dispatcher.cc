@@ -1,8 +1,11 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 
-/* Limits how many writes should be sent to a dispatchee at once. */
+/* Limits how many writes should be sent to a dispatchee at once. The limit adapts to
+how long the dispatchee takes to acknowledge the writes, within these bounds. */
+const size_t DISPATCH_WRITES_CORO_POOL_MIN_SIZE = 8;
 const size_t DISPATCH_WRITES_CORO_POOL_SIZE = 64;
+const size_t DISPATCH_WRITES_CORO_POOL_MAX_SIZE = 512;
 
 primary_dispatcher_t::dispatchee_registration_t::dispatchee_registration_t(
         primary_dispatcher_t *_parent,
@@ -20,8 +23,14 @@ primary_dispatcher_t::dispatchee_registration_t::dispatchee_registration_t(
         &queue_count,
         uuid_to_str(server_id.get_uuid()) + "_broadcast_queue_count"),
     background_write_queue(&queue_count),
-    background_write_workers(
+    background_write_limit(
+        DISPATCH_WRITES_CORO_POOL_MIN_SIZE,
         DISPATCH_WRITES_CORO_POOL_SIZE,
+        DISPATCH_WRITES_CORO_POOL_MAX_SIZE,
+        &parent->perfmon_collection,
+        uuid_to_str(server_id.get_uuid()) + "_broadcast"),
+    background_write_workers(
+        &background_write_limit,
         &background_write_queue,
         &background_write_caller),
     latest_acked_write(state_timestamp_t::zero())
@@ -66,6 +75,8 @@ primary_dispatcher_t::primary_dispatcher_t(
         perfmon_collection_t *parent_perfmon_collection,
         const region_map_t<version_t> &base_version) :
     perfmon_membership(parent_perfmon_collection, &perfmon_collection, "broadcaster"),
+    write_ack_latency_membership(&perfmon_collection, &write_ack_latency,
+                                 "write_ack_latency"),
     ready_dispatchees_as_set(std::set<server_id_t>())
 {
     current_timestamp = state_timestamp_t::zero();
@@ -167,6 +178,9 @@ void primary_dispatcher_t::spawn_write(
         case DURABILITY_REQUIREMENT_HARD:
             durability = write_durability_t::HARD;
             break;
+        case DURABILITY_REQUIREMENT_GROUP:
+            durability = write_durability_t::GROUP;
+            break;
         default:
             unreachable();
     }
@@ -108,6 +108,7 @@ public:
         of `std::function`s. */
         unlimited_fifo_queue_t<std::function<void()> > background_write_queue;
         calling_callback_t background_write_caller;
+        adaptive_concurrency_limit_t background_write_limit;
         coro_pool_t<std::function<void()> > background_write_workers;
 
         /* This is the timestamp of the latest write for which a `do_write_sync()` call
@@ -173,10 +174,22 @@ public:
         order_token_t tok,
         write_callback_t *cb);
 
+    /* The timestamp of the latest write that `spawn_write()` has started. */
+    state_timestamp_t get_latest_timestamp() const {
+        return current_timestamp;
+    }
+
     clone_ptr_t<watchable_t<std::set<server_id_t> > > get_ready_dispatchees() {
         return ready_dispatchees_as_set.get_watchable();
     }
 
+    /* The time from `spawn_write()` until enough replicas have acked a write, in
+    microseconds. Only the `write_callback_t` knows when that is, so the caller of
+    `spawn_write()` records it. */
+    perfmon_histogram_t *get_write_ack_latency() {
+        return &write_ack_latency;
+    }
+
 private:
     /* `incomplete_write_t` bundles all of the information related to a given write into
     a single struct. When it is destroyed, it calls `on_end()` on the callback. */
@@ -205,6 +218,8 @@ private:
 
     perfmon_collection_t perfmon_collection;
     perfmon_membership_t perfmon_membership;
+    perfmon_histogram_t write_ack_latency;
+    perfmon_membership_t write_ack_latency_membership;
 
     mutex_assertion_t mutex;
 
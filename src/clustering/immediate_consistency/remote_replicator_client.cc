@@ -4,6 +4,7 @@
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "clustering/immediate_consistency/backfillee.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "containers/map_sentries.hpp"
 #include "stl_utils.hpp"
 #include "store_view.hpp"
 
@@ -162,6 +163,11 @@ remote_replicator_client_t::remote_replicator_client_t(
 
     next_write_waiter_(nullptr),
 
+    latest_received_timestamp_(state_timestamp_t::zero()),
+    last_primary_contact_(current_microtime()),
+
+    ack_batches_scheduled_(false),
+
     write_async_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_write_async, this,
             ph::_1, ph::_2, ph::_3, ph::_4, ph::_5)),
@@ -173,7 +179,10 @@ remote_replicator_client_t::remote_replicator_client_t(
             ph::_1, ph::_2)),
     read_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_read, this,
-            ph::_1, ph::_2, ph::_3, ph::_4))
+            ph::_1, ph::_2, ph::_3, ph::_4)),
+    heartbeat_mailbox_(mailbox_manager,
+        std::bind(&remote_replicator_client_t::on_heartbeat, this,
+            ph::_1, ph::_2))
 {
     guarantee(remote_replicator_server_bcard.branch == branch_id);
     guarantee(remote_replicator_server_bcard.region == region_);
@@ -184,6 +193,7 @@ remote_replicator_client_t::remote_replicator_client_t(
     progress_tracker->start_time = current_microtime();
     progress_tracker->source_server_id = primary_server_id;
     progress_tracker->progress = 0.0;
+    progress_tracker->bytes_received = 0;
 
     /* If the store is currently constructing a secondary index, wait until it finishes
     before we start the backfill. We'll also check again periodically during the
@@ -203,6 +213,9 @@ remote_replicator_client_t::remote_replicator_client_t(
                     intro.streaming_begin_timestamp));
                 tracker_.init(new timestamp_range_tracker_t(
                     region_, intro.streaming_begin_timestamp));
+                latest_received_timestamp_ = std::max(
+                    latest_received_timestamp_, intro.streaming_begin_timestamp);
+                last_primary_contact_ = current_microtime();
                 got_intro.pulse();
             });
         remote_replicator_client_bcard_t our_bcard {
@@ -211,7 +224,8 @@ remote_replicator_client_t::remote_replicator_client_t(
             write_async_mailbox_.get_address(),
             write_sync_mailbox_.get_address(),
             dummy_write_mailbox_.get_address(),
-            read_mailbox_.get_address() };
+            read_mailbox_.get_address(),
+            heartbeat_mailbox_.get_address() };
         registrant_.init(new registrant_t<remote_replicator_client_bcard_t>(
             mailbox_manager, remote_replicator_server_bcard.registrar, our_bcard));
         wait_interruptible(&got_intro, interruptor);
@@ -221,6 +235,15 @@ remote_replicator_client_t::remote_replicator_client_t(
     /* OK, now we're streaming writes from the primary, but they're being discarded as
     they arrive because `tracker_` indicates that nothing has been backfilled. */
 
+    /* If an earlier backfill into this store was interrupted, its progress is not lost
+    even though we start again from the left edge of the region: every chunk it applied
+    left the backfiller's version in the store's metainfo for that key range. The
+    backfiller computes the common ancestor per range from that metainfo, so for the
+    ranges that were already done it only sends what changed since then, and it skips
+    the B-tree subtrees whose recency is older than that. We can't simply skip those
+    ranges, because the writes that happened while we were disconnected still have to
+    be backfilled into them. */
+
     backfillee_t backfillee(mailbox_manager, branch_history_manager, store,
         replica_bcard.backfiller_bcard, backfill_config, progress_tracker, interruptor);
 
@@ -270,8 +293,9 @@ remote_replicator_client_t::remote_replicator_client_t(
         lock tells us to pause again */
         class callback_t : public backfillee_t::callback_t {
         public:
-            callback_t(remote_replicator_client_t *p, signal_t *ps) :
-                parent(p), preempt_signal(ps) { }
+            callback_t(remote_replicator_client_t *p, signal_t *ps,
+                    backfill_throttler_t *t, const server_id_t &s) :
+                parent(p), preempt_signal(ps), throttler(t), source(s) { }
             bool on_progress(const region_map_t<version_t> &chunk) THROWS_NOTHING {
                 mutex_assertion_t::acq_t mutex_assertion_acq(&parent->mutex_assertion_);
                 chunk.visit(chunk.get_domain(),
@@ -289,9 +313,19 @@ remote_replicator_client_t::remote_replicator_client_t(
                 return parent->store_->check_ok_to_receive_backfill()
                     && !preempt_signal->is_pulsed();
             }
+            void wait_for_bandwidth(signal_t *interruptor2)
+                    THROWS_ONLY(interrupted_exc_t) {
+                throttler->wait_for_bandwidth(source, interruptor2);
+            }
+            void on_items_acked(size_t mem_size) THROWS_NOTHING {
+                throttler->on_bytes_received(source, mem_size);
+            }
             remote_replicator_client_t *parent;
             signal_t *preempt_signal;
-        } callback(this, backfill_throttler_lock.get_preempt_signal());
+            backfill_throttler_t *throttler;
+            server_id_t source;
+        } callback(this, backfill_throttler_lock.get_preempt_signal(),
+            backfill_throttler, primary_server_id);
 
         backfillee.go(
             &callback,
@@ -371,8 +405,13 @@ void remote_replicator_client_t::on_write_async(
         write_t &&write,
         state_timestamp_t timestamp,
         order_token_t order_token,
-        const mailbox_t<>::address_t &ack_addr)
+        const remote_replicator_client_bcard_t::write_async_ack_mailbox_t::address_t
+            &ack_addr)
         THROWS_ONLY(interrupted_exc_t) {
+    note_write_received(timestamp);
+    map_insertion_sentry_t<state_timestamp_t, microtime_t> unapplied_write(
+        &unapplied_writes_, timestamp, current_microtime());
+
     wait_interruptible(&registered_, interruptor);
 
     timestamp_enforcer_->wait_all_before(timestamp.pred(), interruptor);
@@ -443,7 +482,7 @@ void remote_replicator_client_t::on_write_async(
         }
     }
 
-    send(mailbox_manager_, ack_addr);
+    send_write_async_ack(ack_addr, timestamp);
 }
 
 void remote_replicator_client_t::on_write_sync(
@@ -452,18 +491,23 @@ void remote_replicator_client_t::on_write_sync(
         state_timestamp_t timestamp,
         order_token_t order_token,
         write_durability_t durability,
-        const mailbox_t<write_response_t>::address_t &ack_addr)
+        const remote_replicator_client_bcard_t::write_sync_ack_mailbox_t::address_t
+            &ack_addr)
         THROWS_ONLY(interrupted_exc_t) {
     /* The current implementation of the dispatcher will never send us an async write
     once it's started sending sync writes, but we don't want to rely on that detail, so
     we pass sync writes through the timestamp enforcer too. */
     timestamp_enforcer_->complete(timestamp);
 
+    note_write_received(timestamp);
+    map_insertion_sentry_t<state_timestamp_t, microtime_t> unapplied_write(
+        &unapplied_writes_, timestamp, current_microtime());
+
     write_response_t response;
     replica_->do_write(
         write, timestamp, order_token, durability,
         interruptor, &response);
-    send(mailbox_manager_, ack_addr, response);
+    send_write_sync_ack(ack_addr, timestamp, std::move(response));
 }
 
 void remote_replicator_client_t::on_dummy_write(
@@ -486,6 +530,30 @@ void remote_replicator_client_t::on_read(
     send(mailbox_manager_, ack_addr, response);
 }
 
+void remote_replicator_client_t::on_heartbeat(
+        signal_t *,
+        state_timestamp_t latest_timestamp) {
+    /* If the primary has writes that haven't reached us yet, the heartbeat doesn't
+    tell us that we're up to date. */
+    if (latest_timestamp <= latest_received_timestamp_) {
+        last_primary_contact_ = current_microtime();
+    }
+}
+
+void remote_replicator_client_t::note_write_received(state_timestamp_t timestamp) {
+    latest_received_timestamp_ = std::max(latest_received_timestamp_, timestamp);
+    last_primary_contact_ = current_microtime();
+}
+
+microtime_t remote_replicator_client_t::get_staleness() const {
+    microtime_t up_to_date = last_primary_contact_;
+    if (!unapplied_writes_.empty()) {
+        up_to_date = std::min(up_to_date, unapplied_writes_.begin()->second);
+    }
+    microtime_t now = current_microtime();
+    return now > up_to_date ? now - up_to_date : 0;
+}
+
 bool remote_replicator_client_t::next_write_can_proceed(
         mutex_assertion_t::acq_t *mutex_assertion_acq) {
     mutex_assertion_acq->assert_is_holding(&mutex_assertion_);
@@ -493,3 +561,61 @@ bool remote_replicator_client_t::next_write_can_proceed(
         tracker_->can_clip_next_write_backfilling();
 }
 
+void remote_replicator_client_t::send_write_async_ack(
+        const remote_replicator_client_bcard_t::write_async_ack_mailbox_t::address_t
+            &ack_addr,
+        state_timestamp_t timestamp) {
+    if (!write_async_ack_batch_.empty() && !(write_async_ack_batch_addr_ == ack_addr)) {
+        std::vector<state_timestamp_t> acks;
+        acks.swap(write_async_ack_batch_);
+        auto addr = write_async_ack_batch_addr_;
+        send(mailbox_manager_, addr, acks);
+    }
+    write_async_ack_batch_addr_ = ack_addr;
+    write_async_ack_batch_.push_back(timestamp);
+    schedule_ack_batches();
+}
+
+void remote_replicator_client_t::send_write_sync_ack(
+        const remote_replicator_client_bcard_t::write_sync_ack_mailbox_t::address_t
+            &ack_addr,
+        state_timestamp_t timestamp,
+        write_response_t &&response) {
+    if (!write_sync_ack_batch_.empty() && !(write_sync_ack_batch_addr_ == ack_addr)) {
+        std::vector<std::pair<state_timestamp_t, write_response_t> > acks;
+        acks.swap(write_sync_ack_batch_);
+        auto addr = write_sync_ack_batch_addr_;
+        send(mailbox_manager_, addr, acks);
+    }
+    write_sync_ack_batch_addr_ = ack_addr;
+    write_sync_ack_batch_.push_back(std::make_pair(timestamp, std::move(response)));
+    schedule_ack_batches();
+}
+
+void remote_replicator_client_t::schedule_ack_batches() {
+    if (!ack_batches_scheduled_) {
+        ack_batches_scheduled_ = true;
+        coro_t::spawn_sometime(std::bind(
+            &remote_replicator_client_t::send_ack_batches, this,
+            auto_drainer_t::lock_t(&ack_drainer_)));
+    }
+}
+
+void remote_replicator_client_t::send_ack_batches(
+        UNUSED auto_drainer_t::lock_t keepalive) {
+    ack_batches_scheduled_ = false;
+    /* We take the batches before we send anything, because `send()` can block and then
+    new acks go into the next batch. */
+    std::vector<state_timestamp_t> async_acks;
+    async_acks.swap(write_async_ack_batch_);
+    auto async_addr = write_async_ack_batch_addr_;
+    std::vector<std::pair<state_timestamp_t, write_response_t> > sync_acks;
+    sync_acks.swap(write_sync_ack_batch_);
+    auto sync_addr = write_sync_ack_batch_addr_;
+    if (!sync_acks.empty()) {
+        send(mailbox_manager_, sync_addr, sync_acks);
+    }
+    if (!async_acks.empty()) {
+        send(mailbox_manager_, async_addr, async_acks);
+    }
+}
@@ -2,7 +2,10 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 
+#include <map>
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
@@ -11,6 +14,7 @@
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/queue/disk_backed_queue_wrapper.hpp"
 #include "concurrency/semaphore.hpp"
+#include "time.hpp"
 
 class backfill_progress_tracker_t;
 
@@ -75,18 +79,29 @@ public:
 
     ~remote_replicator_client_t();
 
+    /* Returns how long ago (in microseconds) the store was last known to be as up to
+    date as the primary. That's the time since the last write or heartbeat from the
+    primary that we had everything before, or since the oldest write that we haven't
+    applied yet arrived, whichever is longer ago. If we're cut off from the primary
+    this keeps growing, even though we don't know of any missing writes. It doesn't
+    include the network delay of the last message. This is for serving
+    `read_mode_t::BOUNDED` reads from the store. */
+    microtime_t get_staleness() const;
+
 private:
     class timestamp_range_tracker_t;
 
     /* `on_write_async()`, `on_write_sync()`, `on_dummy_write()`, and `on_read()`
     are mailbox callbacks for `write_async_mailbox_`, `write_sync_mailbox_`,
-    `dummy_write_mailbox_` and `read_mailbox_`. */
+    `dummy_write_mailbox_` and `read_mailbox_`. `on_heartbeat()` is the callback for
+    `heartbeat_mailbox_`. */
     void on_write_async(
             signal_t *interruptor,
             write_t &&write,
             state_timestamp_t timestamp,
             order_token_t order_token,
-            const mailbox_t<>::address_t &ack_addr)
+            const remote_replicator_client_bcard_t::write_async_ack_mailbox_t::address_t
+                &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
     void on_write_sync(
@@ -95,7 +110,8 @@ private:
             state_timestamp_t timestamp,
             order_token_t order_token,
             write_durability_t durability,
-            const mailbox_t<write_response_t>::address_t &ack_addr)
+            const remote_replicator_client_bcard_t::write_sync_ack_mailbox_t::address_t
+                &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
     void on_dummy_write(
@@ -110,6 +126,25 @@ private:
             const mailbox_t<read_response_t>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
+    void on_heartbeat(signal_t *interruptor, state_timestamp_t latest_timestamp);
+
+    /* Records that a write with the given timestamp arrived from the primary. */
+    void note_write_received(state_timestamp_t timestamp);
+
+    /* `send_write_async_ack()` and `send_write_sync_ack()` add an ack to the next
+    batch, and make sure that `send_ack_batches()` will send it soon. */
+    void send_write_async_ack(
+        const remote_replicator_client_bcard_t::write_async_ack_mailbox_t::address_t
+            &ack_addr,
+        state_timestamp_t timestamp);
+    void send_write_sync_ack(
+        const remote_replicator_client_bcard_t::write_sync_ack_mailbox_t::address_t
+            &ack_addr,
+        state_timestamp_t timestamp,
+        write_response_t &&response);
+    void schedule_ack_batches();
+    void send_ack_batches(auto_drainer_t::lock_t keepalive);
+
     mailbox_manager_t *const mailbox_manager_;
     store_view_t *const store_;
     region_t const region_;   /* same as `store_->get_region()` */
@@ -170,10 +205,36 @@ private:
     acquires it in write mode. */
     rwlock_t cleanup_rwlock_;
 
+    /* When each write that we haven't applied yet arrived, for `get_staleness()`. */
+    std::map<state_timestamp_t, microtime_t> unapplied_writes_;
+
+    /* The latest timestamp of a write that we received, and when we last heard from
+    the primary without knowing of any writes that hadn't reached us. */
+    state_timestamp_t latest_received_timestamp_;
+    microtime_t last_primary_contact_;
+
+    /* The acks that `send_ack_batches()` will send next. We only send acks once we go
+    back to the event loop, so the acks of all writes that finish in the meantime go
+    to the primary in one message. All writes come from the same
+    `remote_replicator_server_t`, so the ack addresses are the same for all of them;
+    if they ever change, we send the batch early. */
+    std::vector<state_timestamp_t> write_async_ack_batch_;
+    remote_replicator_client_bcard_t::write_async_ack_mailbox_t::address_t
+        write_async_ack_batch_addr_;
+    std::vector<std::pair<state_timestamp_t, write_response_t> > write_sync_ack_batch_;
+    remote_replicator_client_bcard_t::write_sync_ack_mailbox_t::address_t
+        write_sync_ack_batch_addr_;
+    bool ack_batches_scheduled_;
+
+    /* `ack_drainer_` has to be destroyed after the mailboxes, because their callbacks
+    can schedule `send_ack_batches()`. */
+    auto_drainer_t ack_drainer_;
+
     remote_replicator_client_bcard_t::write_async_mailbox_t write_async_mailbox_;
     remote_replicator_client_bcard_t::write_sync_mailbox_t write_sync_mailbox_;
     remote_replicator_client_bcard_t::dummy_write_mailbox_t dummy_write_mailbox_;
     remote_replicator_client_bcard_t::read_mailbox_t read_mailbox_;
+    remote_replicator_client_bcard_t::heartbeat_mailbox_t heartbeat_mailbox_;
 
     /* We use `registrant_` to subscribe to a stream of reads and writes from the
     dispatcher via the `remote_replicator_server_t`. */
@@ -2,6 +2,9 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 
+#include <utility>
+#include <vector>
+
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -18,16 +21,26 @@ RDB_DECLARE_SERIALIZABLE(remote_replicator_client_intro_t);
 
 class remote_replicator_client_bcard_t {
 public:
+    /* The client acks writes in batches: it collects the acks of the writes that
+    finish at about the same time and sends them to the server in one message, which
+    identifies the writes by their timestamps. */
+    typedef mailbox_t<
+        std::vector<state_timestamp_t>
+        > write_async_ack_mailbox_t;
+    typedef mailbox_t<
+        std::vector<std::pair<state_timestamp_t, write_response_t> >
+        > write_sync_ack_mailbox_t;
+
     typedef mailbox_t<
         remote_replicator_client_intro_t
         > intro_mailbox_t;
     typedef mailbox_t<
         write_t, state_timestamp_t, order_token_t,
-        mailbox_t<>::address_t
+        write_async_ack_mailbox_t::address_t
         > write_async_mailbox_t;
     typedef mailbox_t<
         write_t, state_timestamp_t, order_token_t, write_durability_t,
-        mailbox_t<write_response_t>::address_t
+        write_sync_ack_mailbox_t::address_t
         > write_sync_mailbox_t;
     typedef mailbox_t<
         mailbox_t<write_response_t>::address_t
@@ -36,6 +49,9 @@ public:
         read_t, state_timestamp_t,
         mailbox_t<read_response_t>::address_t
         > read_mailbox_t;
+    /* The primary sends the latest timestamp it has assigned to the heartbeat mailbox
+    every `REPLICATOR_HEARTBEAT_INTERVAL_MS`. */
+    typedef mailbox_t<state_timestamp_t> heartbeat_mailbox_t;
 
     server_id_t server_id;
     intro_mailbox_t::address_t intro_mailbox;
@@ -43,6 +59,7 @@ public:
     write_sync_mailbox_t::address_t write_sync_mailbox;
     dummy_write_mailbox_t::address_t dummy_write_mailbox;
     read_mailbox_t::address_t read_mailbox;
+    heartbeat_mailbox_t::address_t heartbeat_mailbox;
 };
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_bcard_t);
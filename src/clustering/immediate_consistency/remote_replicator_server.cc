@@ -1,6 +1,9 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
 
+#include "config/args.hpp"
+#include "containers/map_sentries.hpp"
+
 remote_replicator_server_t::remote_replicator_server_t(
         mailbox_manager_t *_mailbox_manager,
         primary_dispatcher_t *_primary) :
@@ -14,9 +17,18 @@ remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
         const remote_replicator_client_bcard_t &_client_bcard,
         UNUSED signal_t *interruptor) :
     client_bcard(_client_bcard), parent(_parent), is_ready(false),
+    write_async_ack_mailbox(
+        parent->mailbox_manager,
+        std::bind(&proxy_replica_t::on_write_async_acks, this, ph::_1, ph::_2)),
+    write_sync_ack_mailbox(
+        parent->mailbox_manager,
+        std::bind(&proxy_replica_t::on_write_sync_acks, this, ph::_1, ph::_2)),
     ready_mailbox(
         parent->mailbox_manager,
-        std::bind(&proxy_replica_t::on_ready, this, ph::_1))
+        std::bind(&proxy_replica_t::on_ready, this, ph::_1)),
+    heartbeat_timer(
+        REPLICATOR_HEARTBEAT_INTERVAL_MS,
+        std::bind(&proxy_replica_t::send_heartbeat, this))
 {
     state_timestamp_t first_timestamp;
     registration = make_scoped<primary_dispatcher_t::dispatchee_registration_t>(
@@ -54,14 +66,12 @@ void remote_replicator_server_t::proxy_replica_t::do_write_sync(
         write_response_t *response_out) {
     guarantee(is_ready);
     cond_t got_response;
-    mailbox_t<write_response_t> response_mailbox(
-        parent->mailbox_manager,
-        [&](signal_t *, const write_response_t &response) {
-            *response_out = response;
-            got_response.pulse();
-        });
+    map_insertion_sentry_t<state_timestamp_t, std::pair<cond_t *, write_response_t *> >
+        waiter(&write_sync_waiters, timestamp,
+               std::make_pair(&got_response, response_out));
     send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
-        write, timestamp, order_token, durability, response_mailbox.get_address());
+        write, timestamp, order_token, durability,
+        write_sync_ack_mailbox.get_address());
     wait_interruptible(&got_response, interruptor);
 }
 
@@ -87,14 +97,44 @@ void remote_replicator_server_t::proxy_replica_t::do_write_async(
         order_token_t order_token,
         signal_t *interruptor) {
     cond_t got_ack;
-    mailbox_t<> ack_mailbox(
-        parent->mailbox_manager,
-        [&](signal_t *) { got_ack.pulse(); });
+    map_insertion_sentry_t<state_timestamp_t, cond_t *> waiter(
+        &write_async_waiters, timestamp, &got_ack);
     send(parent->mailbox_manager, client_bcard.write_async_mailbox,
-        write, timestamp, order_token, ack_mailbox.get_address());
+        write, timestamp, order_token, write_async_ack_mailbox.get_address());
     wait_interruptible(&got_ack, interruptor);
 }
 
+void remote_replicator_server_t::proxy_replica_t::on_write_async_acks(
+        signal_t *,
+        const std::vector<state_timestamp_t> &timestamps) {
+    ASSERT_FINITE_CORO_WAITING;
+    for (const state_timestamp_t &timestamp : timestamps) {
+        /* The write might have been interrupted in the meantime. */
+        auto it = write_async_waiters.find(timestamp);
+        if (it != write_async_waiters.end()) {
+            it->second->pulse_if_not_already_pulsed();
+        }
+    }
+}
+
+void remote_replicator_server_t::proxy_replica_t::on_write_sync_acks(
+        signal_t *,
+        const std::vector<std::pair<state_timestamp_t, write_response_t> > &acks) {
+    ASSERT_FINITE_CORO_WAITING;
+    for (const auto &ack : acks) {
+        auto it = write_sync_waiters.find(ack.first);
+        if (it != write_sync_waiters.end() && !it->second.first->is_pulsed()) {
+            *it->second.second = ack.second;
+            it->second.first->pulse();
+        }
+    }
+}
+
+void remote_replicator_server_t::proxy_replica_t::send_heartbeat() {
+    send(parent->mailbox_manager, client_bcard.heartbeat_mailbox,
+        parent->primary->get_latest_timestamp());
+}
+
 void remote_replicator_server_t::proxy_replica_t::on_ready(signal_t *) {
     // Can't block here, or we would need an auto drainer.
     ASSERT_FINITE_CORO_WAITING;
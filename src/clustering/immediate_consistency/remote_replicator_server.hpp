@@ -2,6 +2,11 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "arch/timing.hpp"
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_metadata.hpp"
@@ -65,15 +70,34 @@ private:
 
     private:
         void on_ready(signal_t *interruptor);
+        void send_heartbeat();
+        void on_write_async_acks(
+            signal_t *interruptor,
+            const std::vector<state_timestamp_t> &timestamps);
+        void on_write_sync_acks(
+            signal_t *interruptor,
+            const std::vector<std::pair<state_timestamp_t, write_response_t> > &acks);
 
         remote_replicator_client_bcard_t client_bcard;
         remote_replicator_server_t *parent;
         bool is_ready;
 
+        /* The writes that are waiting for an ack from the client, by timestamp. */
+        std::map<state_timestamp_t, cond_t *> write_async_waiters;
+        std::map<state_timestamp_t, std::pair<cond_t *, write_response_t *> >
+            write_sync_waiters;
+
+        remote_replicator_client_bcard_t::write_async_ack_mailbox_t
+            write_async_ack_mailbox;
+        remote_replicator_client_bcard_t::write_sync_ack_mailbox_t
+            write_sync_ack_mailbox;
+
         // The destruction order matters: The `ready_mailbox` callback assumes
         // that `registration` is still valid.
         scoped_ptr_t<primary_dispatcher_t::dispatchee_registration_t> registration;
         remote_replicator_client_intro_t::ready_mailbox_t ready_mailbox;
+
+        repeating_timer_t heartbeat_timer;
     };
 
     mailbox_manager_t *mailbox_manager;
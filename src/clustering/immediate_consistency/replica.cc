@@ -43,8 +43,7 @@ void replica_t::do_read(
     read_token_t read_token;
 
 #ifndef NDEBUG
-    metainfo_checker_t metainfo_checker(store->get_region(),
-        [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t metainfo_checker(store->get_region());
 #endif
 
     // Perform the operation
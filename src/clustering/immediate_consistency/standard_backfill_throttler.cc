@@ -1,11 +1,19 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/standard_backfill_throttler.hpp"
 
+#include <algorithm>
+
+#include "arch/timing.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/wait_any.hpp"
 
 static const size_t max_active_backfills = 8;
 
+standard_backfill_throttler_t::standard_backfill_throttler_t(
+        const backfill_rate_limits_t &_rate_limits) :
+    rate_limits(_rate_limits),
+    total_bucket(rate_limits.total_bytes_per_sec) { }
+
 standard_backfill_throttler_t::~standard_backfill_throttler_t() {
     guarantee(active.empty());
     guarantee(waiting.empty());
@@ -87,3 +95,75 @@ void standard_backfill_throttler_t::exit(lock_t *lock) {
     }
 }
 
+
+void standard_backfill_throttler_t::wait_for_bandwidth(
+        const server_id_t &source, signal_t *interruptor_on_caller)
+        THROWS_ONLY(interrupted_exc_t) {
+    if (rate_limits.is_unlimited()) {
+        return;
+    }
+    cross_thread_signal_t interruptor(interruptor_on_caller, home_thread());
+    on_thread_t thread_switcher(home_thread());
+    while (true) {
+        int64_t ms = total_bucket.get_ms_until_available();
+        auto it = source_buckets.find(source);
+        if (it != source_buckets.end()) {
+            ms = std::max(ms, it->second.get_ms_until_available());
+        }
+        if (ms == 0) {
+            return;
+        }
+        nap(ms, &interruptor);
+    }
+}
+
+void standard_backfill_throttler_t::on_bytes_received(
+        const server_id_t &source, size_t bytes) {
+    if (rate_limits.is_unlimited()) {
+        return;
+    }
+    on_thread_t thread_switcher(home_thread());
+    total_bucket.take(bytes);
+    if (rate_limits.per_source_bytes_per_sec != 0) {
+        auto it = source_buckets.find(source);
+        if (it == source_buckets.end()) {
+            it = source_buckets.insert(std::make_pair(
+                source, bucket_t(rate_limits.per_source_bytes_per_sec))).first;
+        }
+        it->second.take(bytes);
+    }
+}
+
+standard_backfill_throttler_t::bucket_t::bucket_t(uint64_t _bytes_per_sec) :
+    bytes_per_sec(_bytes_per_sec),
+    tokens(_bytes_per_sec),
+    last_refill(current_microtime()) { }
+
+void standard_backfill_throttler_t::bucket_t::take(size_t bytes) {
+    if (bytes_per_sec == 0) {
+        return;
+    }
+    refill();
+    tokens -= bytes;
+}
+
+int64_t standard_backfill_throttler_t::bucket_t::get_ms_until_available() {
+    if (bytes_per_sec == 0) {
+        return 0;
+    }
+    refill();
+    if (tokens >= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(-tokens * 1000 / bytes_per_sec) + 1;
+}
+
+void standard_backfill_throttler_t::bucket_t::refill() {
+    microtime_t now = current_microtime();
+    if (now > last_refill) {
+        tokens = std::min<double>(
+            bytes_per_sec,
+            tokens + static_cast<double>(now - last_refill) * bytes_per_sec / 1000000);
+    }
+    last_refill = now;
+}
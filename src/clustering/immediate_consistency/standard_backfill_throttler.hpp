@@ -2,22 +2,66 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_STANDARD_BACKFILL_THROTTLER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_STANDARD_BACKFILL_THROTTLER_HPP_
 
+#include <map>
 #include <set>
 
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "time.hpp"
+
+/* `backfill_rate_limits_t` limits how fast the backfills on a server may receive data,
+in bytes per second. Zero means unlimited. */
+class backfill_rate_limits_t {
+public:
+    backfill_rate_limits_t() : total_bytes_per_sec(0), per_source_bytes_per_sec(0) { }
+
+    bool is_unlimited() const {
+        return total_bytes_per_sec == 0 && per_source_bytes_per_sec == 0;
+    }
+
+    /* The limit for all backfills on the server together */
+    uint64_t total_bytes_per_sec;
+
+    /* The limit for all backfills that receive data from the same server */
+    uint64_t per_source_bytes_per_sec;
+};
 
 /* `standard_backfill_throttler_t` is the `backfill_throttler_t` that is used in
 production. It allows a fixed number of backfills total (currently 8); if there are more
 than 8 backfills trying to run, it will always allow the highest-priority backfills to go
-first, preempting the lower-priority backfills if necessary. */
+first, preempting the lower-priority backfills if necessary.
+
+It also enforces `backfill_rate_limits_t` with a token bucket for the server and one for
+every server that we receive data from. */
 
 class standard_backfill_throttler_t : public backfill_throttler_t {
 public:
     standard_backfill_throttler_t() { }
+    explicit standard_backfill_throttler_t(const backfill_rate_limits_t &_rate_limits);
     ~standard_backfill_throttler_t();
 
+    void wait_for_bandwidth(const server_id_t &source, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+    void on_bytes_received(const server_id_t &source, size_t bytes);
+
 private:
+    /* A `bucket_t` holds up to one second's worth of bytes. Receiving data takes bytes
+    out of the bucket, and it may go into debt; new backfill items are acknowledged only
+    once the debt has been paid off. */
+    class bucket_t {
+    public:
+        bucket_t() : bytes_per_sec(0), tokens(0), last_refill(0) { }
+        explicit bucket_t(uint64_t _bytes_per_sec);
+        void take(size_t bytes);
+        /* Returns how long it will be until the bucket is out of debt */
+        int64_t get_ms_until_available();
+    private:
+        void refill();
+        uint64_t bytes_per_sec;
+        double tokens;
+        microtime_t last_refill;
+    };
+
     void enter(lock_t *lock, signal_t *interruptor);
     void exit(lock_t *lock);
 
@@ -25,6 +69,10 @@ private:
     std::set<std::pair<priority_t, lock_t *> > active;
 
     new_mutex_t mutex;
+
+    backfill_rate_limits_t rate_limits;
+    bucket_t total_bucket;
+    std::map<server_id_t, bucket_t> source_buckets;
 };
 
 #endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_STANDARD_BACKFILL_THROTTLER_HPP_ */
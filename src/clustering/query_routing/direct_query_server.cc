@@ -6,49 +6,78 @@
 
 direct_query_server_t::direct_query_server_t(
         mailbox_manager_t *mm,
-        store_view_t *svs_) :
+        store_view_t *svs_,
+        const std::function<optional<microtime_t>()> &_get_staleness) :
     mailbox_manager(mm),
     svs(svs_),
+    get_staleness(_get_staleness),
     read_mailbox(mm, std::bind(&direct_query_server_t::on_read, this,
-                               ph::_1, ph::_2, ph::_3))
+                               ph::_1, ph::_2, ph::_3)),
+    bounded_read_mailbox(mm, std::bind(&direct_query_server_t::on_bounded_read, this,
+                                       ph::_1, ph::_2, ph::_3))
     { }
 
 direct_query_bcard_t direct_query_server_t::get_bcard() {
-    return direct_query_bcard_t(read_mailbox.get_address());
+    return direct_query_bcard_t(
+        read_mailbox.get_address(), bounded_read_mailbox.get_address());
 }
 
 void direct_query_server_t::on_read(
         signal_t *interruptor,
         const read_t &read,
         const mailbox_addr_t<read_response_t> &cont) {
+    try {
+        read_response_t response;
+        perform_read(read, &response, interruptor);
+        send(mailbox_manager, cont, response);
+    } catch (const interrupted_exc_t &) {
+        /* ignore */
+    }
+}
 
+void direct_query_server_t::on_bounded_read(
+        signal_t *interruptor,
+        const read_t &read,
+        const mailbox_addr_t<optional<read_response_t> > &cont) {
+    /* We check the staleness before the read, so the read sees at least the state that
+    we checked. */
+    optional<microtime_t> staleness = get_staleness();
+    if (!staleness.has_value() || *staleness > read.max_staleness_ms * 1000) {
+        send(mailbox_manager, cont, optional<read_response_t>());
+        return;
+    }
+    try {
+        read_response_t response;
+        perform_read(read, &response, interruptor);
+        send(mailbox_manager, cont, make_optional(std::move(response)));
+    } catch (const interrupted_exc_t &) {
+        /* ignore */
+    }
+}
+
+void direct_query_server_t::perform_read(
+        const read_t &read,
+        read_response_t *response,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
     // Shortcut: Dummy reads for checking table status are fulfilled
     // without hitting the store.
     if (boost::get<dummy_read_t>(&read.read) != nullptr) {
-        read_response_t response;
-        response.response = dummy_read_response_t();
-        response.n_shards = 1;
-        send(mailbox_manager, cont, response);
+        response->response = dummy_read_response_t();
+        response->n_shards = 1;
         return;
     }
 
-    try {
-        /* Leave the token empty. We're not actually interested in ordering here. */
-        read_token_t token;
+    /* Leave the token empty. We're not actually interested in ordering here. */
+    read_token_t token;
 
 #ifndef NDEBUG
-        metainfo_checker_t metainfo_checker(svs->get_region(),
-            [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t metainfo_checker(svs->get_region());
 #endif
 
-        read_response_t response;
-        svs->read(DEBUG_ONLY(metainfo_checker, )
-                  read,
-                  &response,
-                  &token,
-                  interruptor);
-        send(mailbox_manager, cont, response);
-    } catch (const interrupted_exc_t &) {
-        /* ignore */
-    }
+    svs->read(DEBUG_ONLY(metainfo_checker, )
+              read,
+              response,
+              &token,
+              interruptor);
 }
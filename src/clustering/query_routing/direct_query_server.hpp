@@ -2,8 +2,12 @@
 #ifndef CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_
 #define CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_
 
+#include <functional>
+
 #include "clustering/query_routing/metadata.hpp"
 #include "concurrency/fifo_checker.hpp"
+#include "containers/optional.hpp"
+#include "time.hpp"
 
 class store_view_t;
 
@@ -11,13 +15,19 @@ class store_view_t;
 `direct_query_server_t`. The `direct_query_server_t` allows the `table_query_server_t` to
 bypass the `broadcaster_t` and read directly from the B-tree itself. This reduces network
 traffic and is possible even when the primary replica is unavailable, but the data it
-returns might be out of date. */
+returns might be out of date.
+
+For `read_mode_t::BOUNDED` reads, `get_staleness` tells us how far (in microseconds) the
+B-tree might be behind the primary replica, or returns an empty `optional` if we can't
+tell. It's called on the thread of `svs`, which is also the thread that we have to be
+constructed on. */
 
 class direct_query_server_t {
 public:
     direct_query_server_t(
             mailbox_manager_t *mm,
-            store_view_t *svs);
+            store_view_t *svs,
+            const std::function<optional<microtime_t>()> &get_staleness);
 
     direct_query_bcard_t get_bcard();
 
@@ -27,12 +37,25 @@ private:
             const read_t &,
             const mailbox_addr_t<read_response_t> &);
 
+    void on_bounded_read(
+            signal_t *interruptor,
+            const read_t &,
+            const mailbox_addr_t<optional<read_response_t> > &);
+
+    void perform_read(
+            const read_t &read,
+            read_response_t *response,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     mailbox_manager_t *mailbox_manager;
     store_view_t *svs;
+    std::function<optional<microtime_t>()> get_staleness;
 
     order_source_t order_source;  // TODO: order_token_t::ignore
 
     direct_query_bcard_t::read_mailbox_t read_mailbox;
+    direct_query_bcard_t::bounded_read_mailbox_t bounded_read_mailbox;
 };
 
 #endif /* CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_ */
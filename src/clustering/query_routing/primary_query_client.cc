@@ -59,9 +59,11 @@ void primary_query_client_t::read(
         token_for_master,
         result_or_failure_mailbox.get_address());
 
+    const ticks_t start_time = get_ticks();
     multi_client_client.spawn_request(read_request);
 
     wait_interruptible(result_or_failure.get_ready_signal(), interruptor);
+    mailbox_manager->round_trip_latency.record_since(start_time);
 
     if (const cannot_perform_query_exc_t *error
         = boost::get<cannot_perform_query_exc_t>(&result_or_failure.wait())) {
@@ -106,9 +108,11 @@ void primary_query_client_t::write(
         token_for_master,
         result_or_failure_mailbox.get_address());
 
+    const ticks_t start_time = get_ticks();
     multi_client_client.spawn_request(write_request);
 
     wait_interruptible(result_or_failure.get_ready_signal(), interruptor);
+    mailbox_manager->round_trip_latency.record_since(start_time);
 
     if (const cannot_perform_query_exc_t *error
         = boost::get<cannot_perform_query_exc_t>(&result_or_failure.wait())) {
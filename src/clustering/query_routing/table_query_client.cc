@@ -123,6 +123,19 @@ void table_query_client_t::read(
     } else if (r.read_mode == read_mode_t::DEBUG_DIRECT) {
         guarantee(!r.route_to_primary());
         dispatch_debug_direct_read(r, response, interruptor);
+    } else if (r.read_mode == read_mode_t::BOUNDED) {
+        if (r.route_to_primary() || !dispatch_bounded_read(r, response, interruptor)) {
+            /* Either the read has to go to the primaries anyway, or at least one of
+            the replicas was too far behind. The primaries don't know about
+            `read_mode_t::BOUNDED`, but for them it's the same as a single read. */
+            read_t primary_read = r;
+            primary_read.read_mode = read_mode_t::SINGLE;
+            dispatch_immediate_op<
+                    read_t, fifo_enforcer_sink_t::exit_read_t, read_response_t>(
+                &primary_query_client_t::new_read_token,
+                &primary_query_client_t::read,
+                primary_read, response, order_token, interruptor);
+        }
     } else {
         dispatch_immediate_op<read_t, fifo_enforcer_sink_t::exit_read_t, read_response_t>(
                 &primary_query_client_t::new_read_token,
@@ -149,6 +162,8 @@ void table_query_client_t::write(
 
     user_context.require_write_permission(ctx, table_basic_config.database, table_id);
 
+    ctx->stats.table_writes_per_sec.record(table_id);
+
     order_token.assert_write_mode();
     dispatch_immediate_op<write_t, fifo_enforcer_sink_t::exit_write_t, write_response_t>(
         &primary_query_client_t::new_write_token,
@@ -331,16 +346,10 @@ void table_query_client_t::perform_immediate_op(
     }
 }
 
-void table_query_client_t::dispatch_outdated_read(
+void table_query_client_t::choose_direct_readers(
     const read_t &op,
-    read_response_t *response,
-    signal_t *interruptor)
-    THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
-
-    if (interruptor->is_pulsed()) throw interrupted_exc_t();
-
-    std::vector<scoped_ptr_t<outdated_read_info_t> > replicas_to_contact;
-
+    std::vector<scoped_ptr_t<outdated_read_info_t> > *replicas_to_contact)
+    THROWS_ONLY(cannot_perform_query_exc_t) {
     scoped_ptr_t<outdated_read_info_t> new_op_info(new outdated_read_info_t());
     relationships.visit(region_t::universe(),
     [&](const region_t &region, const std::set<relationship_t *> &rels) {
@@ -373,10 +382,22 @@ void table_query_client_t::dispatch_outdated_read(
             new_op_info->direct_bcard = chosen_relationship->direct_bcard;
             new_op_info->keepalive = auto_drainer_t::lock_t(
                 &chosen_relationship->drainer);
-            replicas_to_contact.push_back(std::move(new_op_info));
+            replicas_to_contact->push_back(std::move(new_op_info));
             new_op_info.init(new outdated_read_info_t());
         }
     });
+}
+
+void table_query_client_t::dispatch_outdated_read(
+    const read_t &op,
+    read_response_t *response,
+    signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+
+    if (interruptor->is_pulsed()) throw interrupted_exc_t();
+
+    std::vector<scoped_ptr_t<outdated_read_info_t> > replicas_to_contact;
+    choose_direct_readers(op, &replicas_to_contact);
 
     std::vector<read_response_t> results(replicas_to_contact.size());
     std::vector<std::string> failures(replicas_to_contact.size());
@@ -429,6 +450,78 @@ void table_query_client_t::perform_outdated_read(
     }
 }
 
+bool table_query_client_t::dispatch_bounded_read(
+    const read_t &op,
+    read_response_t *response,
+    signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+
+    if (interruptor->is_pulsed()) throw interrupted_exc_t();
+
+    std::vector<scoped_ptr_t<outdated_read_info_t> > replicas_to_contact;
+    try {
+        choose_direct_readers(op, &replicas_to_contact);
+    } catch (const cannot_perform_query_exc_t &) {
+        /* Let the caller try the primaries, which will produce the error message if
+        they aren't available either. */
+        return false;
+    }
+
+    std::vector<optional<read_response_t> > results(replicas_to_contact.size());
+    std::vector<std::string> failures(replicas_to_contact.size());
+    pmap(replicas_to_contact.size(),
+        std::bind(&table_query_client_t::perform_bounded_read, this,
+            &replicas_to_contact, &results, &failures, ph::_1, interruptor));
+
+    if (interruptor->is_pulsed()) throw interrupted_exc_t();
+
+    std::vector<read_response_t> fresh_results(replicas_to_contact.size());
+    for (size_t i = 0; i < replicas_to_contact.size(); ++i) {
+        if (!failures[i].empty()) {
+            // Reads are never indeterminate.
+            throw cannot_perform_query_exc_t(failures[i], query_state_t::FAILED);
+        }
+        if (!results[i].has_value()) {
+            return false;
+        }
+        fresh_results[i] = std::move(*results[i]);
+    }
+
+    op.unshard(fresh_results.data(), fresh_results.size(), response, ctx, interruptor);
+    return true;
+}
+
+void table_query_client_t::perform_bounded_read(
+        std::vector<scoped_ptr_t<outdated_read_info_t> > *replicas_to_contact,
+        std::vector<optional<read_response_t> > *results,
+        std::vector<std::string> *failures,
+        size_t i,
+        signal_t *interruptor) THROWS_NOTHING {
+    outdated_read_info_t *replica_to_contact = (*replicas_to_contact)[i].get();
+
+    try {
+        cond_t done;
+        mailbox_t<optional<read_response_t> > cont(mailbox_manager,
+            [&](signal_t *, const optional<read_response_t> &res) {
+                results->at(i) = res;
+                done.pulse();
+            });
+
+        send(mailbox_manager,
+            replica_to_contact->direct_bcard->bounded_read_mailbox,
+            replica_to_contact->sharded_op,
+            cont.get_address());
+        wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
+        wait_interruptible(&waiter, interruptor);
+        if (!done.is_pulsed()) {
+            failures->at(i).assign("lost contact with replica");
+        }
+    } catch (const interrupted_exc_t &) {
+        /* Return immediately. `dispatch_bounded_read()` will notice that the
+        interruptor has been pulsed. */
+    }
+}
+
 void table_query_client_t::dispatch_debug_direct_read(
         const read_t &op,
         read_response_t *response,
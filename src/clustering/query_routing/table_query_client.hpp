@@ -123,6 +123,13 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
+    /* Picks a replica with a `direct_query_bcard_t` for every shard of `op`. Local
+    replicas are preferred, otherwise we pick one at random. */
+    void choose_direct_readers(
+            const read_t &op,
+            std::vector<scoped_ptr_t<outdated_read_info_t> > *replicas_to_contact)
+        THROWS_ONLY(cannot_perform_query_exc_t);
+
     void dispatch_outdated_read(
             const read_t &op,
             read_response_t *response,
@@ -137,6 +144,22 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
+    /* Returns `false` without filling in `response` if we couldn't find a replica
+    within `op.max_staleness_ms` of the primary for every shard. */
+    bool dispatch_bounded_read(
+            const read_t &op,
+            read_response_t *response,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
+
+    void perform_bounded_read(
+            std::vector<scoped_ptr_t<outdated_read_info_t> > *direct_readers_to_contact,
+            std::vector<optional<read_response_t> > *results,
+            std::vector<std::string> *failures,
+            size_t i,
+            signal_t *interruptor)
+        THROWS_NOTHING;
+
     void dispatch_debug_direct_read(
             const read_t &op,
             read_response_t *response,
@@ -549,15 +549,25 @@ void calculate_all_contracts(
     /* We want to break the key-space into sub-regions small enough that the contract,
     table config, and ack versions are all constant across the sub-region. First we
     iterate over all contracts: */
-    for (const std::pair<contract_id_t, std::pair<region_t, contract_t> > &cpair :
+    for (const std::pair<const contract_id_t, std::pair<region_t, contract_t> > &cpair :
             old_state.contracts) {
-        /* Next iterate over all shards of the table config and find the ones that
-        overlap the contract in question: */
-        for (size_t shard_index = 0; shard_index < old_state.config.config.shards.size();
+        /* Next find the shards of the table config that overlap the contract in
+        question. The shards are sorted by key, so we start with the shard that contains
+        the contract's left bound and stop at the first shard past its right bound;
+        with thousands of shards, intersecting every contract with every shard would
+        dominate the whole calculation. */
+        const table_shard_scheme_t &shard_scheme = old_state.config.shard_scheme;
+        const key_range_t &contract_range = cpair.second.first.inner;
+        for (size_t shard_index = shard_scheme.find_shard_for_key(contract_range.left);
+                shard_index < old_state.config.config.shards.size();
                 ++shard_index) {
+            const key_range_t shard_range = shard_scheme.get_shard_range(shard_index);
+            if (!contract_range.right.unbounded &&
+                    shard_range.left >= contract_range.right.key()) {
+                break;
+            }
             region_t region = region_intersection(
-                cpair.second.first,
-                region_t(old_state.config.shard_scheme.get_shard_range(shard_index)));
+                cpair.second.first, region_t(shard_range));
             if (region_is_empty(region)) {
                 continue;
             }
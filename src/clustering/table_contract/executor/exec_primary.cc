@@ -127,9 +127,12 @@ void primary_execution_t::run(auto_drainer_t::lock_t keepalive) {
 
         primary_dispatcher_t primary_dispatcher(&perfmon_collection, initial_version);
 
+        /* We're the source of the writes, so we're never behind for the sake of
+        `read_mode_t::BOUNDED` reads. */
         direct_query_server_t direct_query_server(
             context->mailbox_manager,
-            store);
+            store,
+            []() { return make_optional(microtime_t(0)); });
 
         on_thread_t thread_switcher_2(home_thread());
 
@@ -342,6 +345,8 @@ bool primary_execution_t::on_write(
                                     contract_snapshot->default_write_durability,
                                     contract_snapshot->write_ack_config,
                                     &contract_snapshot->contract);
+    perfmon_histogram_t *ack_latency = our_dispatcher->get_write_ack_latency();
+    const ticks_t spawn_time = get_ticks();
     our_dispatcher->spawn_write(request, order_token, &write_callback);
 
     /* Now that we've called `spawn_write()`, our write is in the queue. So it's safe to
@@ -356,7 +361,9 @@ bool primary_execution_t::on_write(
     wait_interruptible(write_callback.result.get_ready_signal(), interruptor);
 
     bool res = write_callback.result.assert_get_value();
-    if (!res) {
+    if (res) {
+        ack_latency->record_since(spawn_time);
+    } else {
         *error_out = admin_err_t{
             "The primary replica lost contact with the secondary "
             "replicas. The write may or may not have been performed.",
@@ -437,7 +444,8 @@ bool primary_execution_t::on_read(
         }
         break;
     case read_mode_t::OUTDATED: // Fallthrough intentional
-    case read_mode_t::DEBUG_DIRECT:
+    case read_mode_t::DEBUG_DIRECT: // Fallthrough intentional
+    case read_mode_t::BOUNDED:
     default:
         // These read modes should not come through the `primary_exection_t`.
         unreachable();
@@ -3,6 +3,7 @@
 
 #include <utility>
 
+#include "assignment_sentry.hpp"
 #include "clustering/immediate_consistency/remote_replicator_client.hpp"
 #include "clustering/query_routing/direct_query_server.hpp"
 #include "concurrency/cross_thread_signal.hpp"
@@ -82,7 +83,19 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                     order_source.check_in("secondary_execution_t").with_read_mode(),
                     &token, region, &interruptor_on_store_thread)));
 
-            direct_query_server_t direct_query_server(context->mailbox_manager, store);
+            /* `streaming_replicator` is set while we're streaming writes from the
+            primary. Before that we can't tell how far behind we are, so we refuse
+            `read_mode_t::BOUNDED` reads. */
+            const remote_replicator_client_t *streaming_replicator = nullptr;
+            direct_query_server_t direct_query_server(
+                context->mailbox_manager,
+                store,
+                [&]() -> optional<microtime_t> {
+                    if (streaming_replicator == nullptr) {
+                        return r_nullopt;
+                    }
+                    return make_optional(streaming_replicator->get_staleness());
+                });
 
             /* Switch back to the home thread so we can send the initial ack */
             on_thread_t thread_switcher_2(home_thread());
@@ -185,6 +198,8 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                 store,
                 context->branch_history_manager,
                 &stop_signal_on_store_thread);
+            assignment_sentry_t<const remote_replicator_client_t *> streaming_sentry(
+                &streaming_replicator, &remote_replicator_client);
 
             on_thread_t thread_switcher_4(home_thread());
 
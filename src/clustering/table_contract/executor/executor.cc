@@ -321,20 +321,35 @@ void contract_executor_t::update_blocking(signal_t *interruptor) {
 
 void contract_executor_t::gc_branch_history(signal_t *interruptor) {
     new_mutex_acq_t executions_mutex_acq(&executions_mutex, interruptor);
+    gc_branch_history_inputs_t inputs;
     std::set<branch_id_t> remove_branches;
-    execution_context.branch_history_manager->prepare_gc(&remove_branches);
     bool ok = true;
     raft_state->apply_read([&](const table_raft_state_t *state) {
-        std::set<contract_id_t> contract_ids;
         for (const auto &pair : state->contracts) {
-            contract_ids.insert(pair.first);
+            inputs.contract_ids.insert(pair.first);
+        }
+        for (const auto &pair : state->branch_history.branches) {
+            inputs.raft_branches.insert(pair.first);
         }
         for (const auto &pair : executions) {
-            contract_ids.erase(pair.second->get_contract_id());
             if (!static_cast<bool>(pair.second->enable_gc_branch)) {
                 ok = false;
-                break;
+                return;
             }
+            inputs.gc_branches.push_back(
+                std::make_pair(pair.first.region, *pair.second->enable_gc_branch));
+        }
+        if (static_cast<bool>(last_gc_branch_history_inputs) &&
+                *last_gc_branch_history_inputs == inputs) {
+            /* Nothing has changed that would let us remove more branches. */
+            ok = false;
+            return;
+        }
+
+        execution_context.branch_history_manager->prepare_gc(&remove_branches);
+        std::set<contract_id_t> contract_ids = inputs.contract_ids;
+        for (const auto &pair : executions) {
+            contract_ids.erase(pair.second->get_contract_id());
             if (!pair.second->enable_gc_branch->is_nil()) {
                 mark_ancestors_since_base_live(
                     *pair.second->enable_gc_branch,
@@ -354,6 +369,7 @@ void contract_executor_t::gc_branch_history(signal_t *interruptor) {
     });
     if (ok) {
         execution_context.branch_history_manager->perform_gc(remove_branches);
+        last_gc_branch_history_inputs = make_optional(std::move(inputs));
     }
 }
 
@@ -111,9 +111,26 @@ private:
                 std::set<execution_key_t> *to_delete_out);
 
     /* `gc_branch_history()` runs in a `pump_coro_t` to garbage-collect the branch
-    history. */
+    history. It gets notified on every Raft state change, but which branches it keeps
+    only depends on the things in `gc_branch_history_inputs_t`. If none of them changed
+    since the last successful run, it returns without walking the branch history. That
+    can only delay the removal of branches that were added to our branch history since
+    then; they get removed the next time the contracts or the executions change. */
     void gc_branch_history(signal_t *interruptor);
 
+    struct gc_branch_history_inputs_t {
+        bool operator==(const gc_branch_history_inputs_t &other) const {
+            return gc_branches == other.gc_branches
+                && contract_ids == other.contract_ids
+                && raft_branches == other.raft_branches;
+        }
+        /* The `enable_gc_branch` of every execution, by region. */
+        std::vector<std::pair<region_t, branch_id_t> > gc_branches;
+        std::set<contract_id_t> contract_ids;
+        /* The branches in the Raft state's branch history. */
+        std::set<branch_id_t> raft_branches;
+    };
+
     const server_id_t server_id;
     clone_ptr_t<watchable_t<table_raft_state_t> > raft_state;
     multistore_ptr_t *const multistore;
@@ -145,6 +162,10 @@ private:
     `executions` at the same time. */
     new_mutex_t executions_mutex;
 
+    /* What `gc_branch_history()` last collected the garbage for. Protected by
+    `executions_mutex`. */
+    optional<gc_branch_history_inputs_t> last_gc_branch_history_inputs;
+
     /* Used to generate unique names for perfmons */
     int perfmon_counter;
 
@@ -18,7 +18,8 @@ multi_table_manager_t::multi_table_manager_t(
         table_persistence_interface_t *_persistence_interface,
         const base_path_t &_base_path,
         io_backender_t *_io_backender,
-        perfmon_collection_repo_t *_perfmon_collection_repo) :
+        perfmon_collection_repo_t *_perfmon_collection_repo,
+        const backfill_rate_limits_t &_backfill_rate_limits) :
     is_proxy_server(false),
     server_id(_server_id),
     mailbox_manager(_mailbox_manager),
@@ -29,9 +30,12 @@ multi_table_manager_t::multi_table_manager_t(
     persistence_interface(_persistence_interface),
     base_path(_base_path),
     io_backender(_io_backender),
-    perfmon_collection_repo(_perfmon_collection_repo) {
+    perfmon_collection_repo(_perfmon_collection_repo),
+    backfill_throttler(_backfill_rate_limits) {
 
-    /* Resurrect any tables that were sitting on disk from when we last shut down */
+    /* Resurrect any tables that were sitting on disk from when we last shut down. The
+    callback for active tables runs for several tables at once, so it must not assume
+    that `tables` stays the same while it blocks. */
     cond_t non_interruptor;
     persistence_interface->read_all_metadata(
         [&](const namespace_id_t &table_id,
@@ -402,6 +406,7 @@ void multi_table_manager_t::on_action(
             cond_t non_interruptor;
             persistence_interface->create_multistore(
                 table_id,
+                initial_raft_state->snapshot_state.config.config.block_size,
                 &table->multistore_ptr,
                 &non_interruptor,
                 &perfmon_collections->serializers_collection);
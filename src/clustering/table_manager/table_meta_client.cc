@@ -21,7 +21,8 @@ table_meta_client_t::table_meta_client_t(
     multi_table_manager_directory(_multi_table_manager_directory),
     table_manager_directory(_table_manager_directory),
     server_config_client(_server_config_client),
-    table_basic_configs(multi_table_manager->get_table_basic_configs())
+    table_basic_configs(multi_table_manager->get_table_basic_configs()),
+    name_indexes(&table_basic_configs)
     { }
 
 void table_meta_client_t::find(
@@ -30,22 +31,21 @@ void table_meta_client_t::find(
         namespace_id_t *table_id_out,
         std::string *primary_key_out)
         THROWS_ONLY(no_such_table_exc_t, ambiguous_table_exc_t) {
-    size_t count = 0;
-    table_basic_configs.get_watchable()->read_all(
-        [&](const namespace_id_t &key, const timestamped_basic_config_t *value) {
-            if (value->first.database == database && value->first.name == name) {
-                ++count;
-                *table_id_out = key;
-                if (primary_key_out != nullptr) {
-                    *primary_key_out = value->first.primary_key;
-                }
-            }
-        });
-    if (count == 0) {
+    const std::set<namespace_id_t> *table_ids =
+        name_indexes.get()->lookup(database, name);
+    if (table_ids == nullptr) {
         throw no_such_table_exc_t();
-    } else if (count >= 2) {
+    } else if (table_ids->size() >= 2) {
         throw ambiguous_table_exc_t();
     }
+    *table_id_out = *table_ids->begin();
+    if (primary_key_out != nullptr) {
+        table_basic_configs.get_watchable()->read_key(*table_id_out,
+            [&](const timestamped_basic_config_t *value) {
+                guarantee(value != nullptr);
+                *primary_key_out = value->first.primary_key;
+            });
+    }
 }
 
 bool table_meta_client_t::exists(const namespace_id_t &table_id) {
@@ -59,14 +59,7 @@ bool table_meta_client_t::exists(const namespace_id_t &table_id) {
 
 bool table_meta_client_t::exists(
         const database_id_t &database, const name_string_t &name) {
-    bool found = false;
-    table_basic_configs.get_watchable()->read_all(
-        [&](const namespace_id_t &, const timestamped_basic_config_t *value) {
-            if (value->first.database == database && value->first.name == name) {
-                found = true;
-            }
-        });
-    return found;
+    return name_indexes.get()->lookup(database, name) != nullptr;
 }
 
 void table_meta_client_t::get_name(
@@ -249,6 +242,46 @@ void table_meta_client_t::get_raft_leader(
       });
 }
 
+void table_meta_client_t::list_shard_statuses(
+        all_replicas_ready_mode_t all_replicas_ready_mode,
+        signal_t *interruptor_on_caller,
+        std::map<namespace_id_t, std::map<server_id_t, range_map_t<
+            key_range_t::right_bound_t, table_shard_status_t> > > *shard_statuses_out,
+        std::map<namespace_id_t, bool> *all_replicas_ready_out,
+        std::map<namespace_id_t, server_id_t> *raft_leaders_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    cross_thread_signal_t interruptor(interruptor_on_caller, home_thread());
+    on_thread_t thread_switcher(home_thread());
+    shard_statuses_out->clear();
+    all_replicas_ready_out->clear();
+    raft_leaders_out->clear();
+    table_status_request_t request;
+    request.want_shard_status = true;
+    request.want_all_replicas_ready = true;
+    request.all_replicas_ready_mode = all_replicas_ready_mode;
+    std::set<namespace_id_t> failures;
+    get_status(
+        r_nullopt,
+        request,
+        server_selector_t::EVERY_SERVER,
+        &interruptor,
+        [&](const server_id_t &server_id, const namespace_id_t &table_id,
+                const table_status_response_t &response) {
+            (*shard_statuses_out)[table_id].insert(
+                std::make_pair(server_id, response.shard_status));
+            (*all_replicas_ready_out)[table_id] |= response.all_replicas_ready;
+        },
+        &failures);
+
+    table_manager_directory->read_all(
+      [&](const std::pair<peer_id_t, namespace_id_t> &key,
+          const table_manager_bcard_t *bcard) {
+          if (static_cast<bool>(bcard->leader)) {
+            (*raft_leaders_out)[key.second] = bcard->server_id;
+          }
+      });
+}
+
 void table_meta_client_t::get_debug_status(
         const namespace_id_t &table_id,
         all_replicas_ready_mode_t all_replicas_ready_mode,
@@ -850,3 +883,38 @@ void table_meta_client_t::wait_until_change_visible(
     table_basic_configs.flush();
 }
 
+table_meta_client_t::name_index_t::name_index_t(
+        all_thread_watchable_map_var_t<namespace_id_t, timestamped_basic_config_t>
+            *configs) :
+    subs(configs->get_watchable(),
+        std::bind(&name_index_t::on_change, this, ph::_1, ph::_2),
+        initial_call_t::YES)
+    { }
+
+const std::set<namespace_id_t> *table_meta_client_t::name_index_t::lookup(
+        const database_id_t &database, const name_string_t &name) const {
+    auto it = tables_by_name.find(std::make_pair(database, name));
+    return it == tables_by_name.end() ? nullptr : &it->second;
+}
+
+void table_meta_client_t::name_index_t::on_change(
+        const namespace_id_t &table_id, const timestamped_basic_config_t *value) {
+    auto it = names.find(table_id);
+    if (it != names.end()) {
+        if (value != nullptr && value->first.database == it->second.first
+                && value->first.name == it->second.second) {
+            return;
+        }
+        auto jt = tables_by_name.find(it->second);
+        jt->second.erase(table_id);
+        if (jt->second.empty()) {
+            tables_by_name.erase(jt);
+        }
+        names.erase(it);
+    }
+    if (value != nullptr) {
+        auto name = std::make_pair(value->first.database, value->first.name);
+        tables_by_name[name].insert(table_id);
+        names.insert(std::make_pair(table_id, name));
+    }
+}
@@ -2,8 +2,14 @@
 #ifndef CLUSTERING_TABLE_MANAGER_TABLE_META_CLIENT_HPP_
 #define CLUSTERING_TABLE_MANAGER_TABLE_META_CLIENT_HPP_
 
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
 #include "clustering/table_manager/table_metadata.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
+#include "concurrency/one_per_thread.hpp"
 #include "concurrency/watchable_map.hpp"
 
 class multi_table_manager_t;
@@ -154,6 +160,20 @@ public:
         optional<server_id_t> *raft_leader_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t, failed_table_op_exc_t);
 
+    /* `list_shard_statuses()` is like calling `get_shard_status()` and
+    `get_raft_leader()` for every table, but it sends each server one status query for
+    all of its tables and reads the directory once, instead of doing both per table.
+    Tables that no server responded for are left out of `shard_statuses_out` and
+    `all_replicas_ready_out`. */
+    void list_shard_statuses(
+        all_replicas_ready_mode_t all_replicas_ready_mode,
+        signal_t *interruptor,
+        std::map<namespace_id_t, std::map<server_id_t, range_map_t<
+            key_range_t::right_bound_t, table_shard_status_t> > > *shard_statuses_out,
+        std::map<namespace_id_t, bool> *all_replicas_ready_out,
+        std::map<namespace_id_t, server_id_t> *raft_leaders_out)
+        THROWS_ONLY(interrupted_exc_t);
+
     /* `get_debug_status()` fetches all status information from all servers. This is for
     displaying in `rethinkdb._debug_table_status`. */
     void get_debug_status(
@@ -269,6 +289,32 @@ private:
     `list_names()` can run without blocking. */
     all_thread_watchable_map_var_t<namespace_id_t, timestamped_basic_config_t>
         table_basic_configs;
+
+    /* `name_index_t` indexes one thread's copy of `table_basic_configs` by database and
+    name, so that `find()` and `exists()` don't have to look at every table. */
+    class name_index_t {
+    public:
+        explicit name_index_t(
+            all_thread_watchable_map_var_t<namespace_id_t, timestamped_basic_config_t>
+                *configs);
+
+        /* Returns the IDs of the tables with the given name in the given database, or
+        `nullptr` if there are none. */
+        const std::set<namespace_id_t> *lookup(
+            const database_id_t &database, const name_string_t &name) const;
+
+    private:
+        void on_change(const namespace_id_t &table_id,
+                       const timestamped_basic_config_t *value);
+
+        std::map<std::pair<database_id_t, name_string_t>, std::set<namespace_id_t> >
+            tables_by_name;
+        std::map<namespace_id_t, std::pair<database_id_t, name_string_t> > names;
+        watchable_map_t<namespace_id_t, timestamped_basic_config_t>::all_subs_t subs;
+
+        DISABLE_COPYING(name_index_t);
+    };
+    one_per_thread_t<name_index_t> name_indexes;
 };
 
 #endif /* CLUSTERING_TABLE_MANAGER_TABLE_META_CLIENT_HPP_ */
@@ -307,7 +307,9 @@ public:
     or `delete_metadata()` affecting that table. */
 
     /* Finds all tables stored in the metadata and calls the appropriate callback. Note
-    that this invalidates any existing `raft_storage_interface_t`s! */
+    that this invalidates any existing `raft_storage_interface_t`s! Calls to
+    `active_cb` may run concurrently in several coroutines, so that tables can be
+    loaded in parallel. */
     virtual void read_all_metadata(
         const std::function<void(
             const namespace_id_t &table_id,
@@ -346,8 +348,11 @@ public:
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
+    /* `create_multistore()` creates the table's files with the given block size (see
+    `table_config_t::block_size`). */
     virtual void create_multistore(
         const namespace_id_t &table_id,
+        uint32_t block_size,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/adaptive_concurrency_limit.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+// The weights of a new latency in the short- and long-term averages.
+static const double SHORT_LATENCY_WEIGHT = 0.1;
+static const double LONG_LATENCY_WEIGHT = 1.0 / 600;
+// The limit only shrinks once the short-term latency is this much above the long-term
+// one, so that noise doesn't keep the limit down.
+static const double LATENCY_TOLERANCE = 1.5;
+// How far the limit moves towards its new value after every task.
+static const double LIMIT_SMOOTHING = 0.2;
+
+adaptive_concurrency_limit_t::adaptive_concurrency_limit_t(
+        size_t _min_limit,
+        size_t initial_limit,
+        size_t _max_limit,
+        perfmon_collection_t *stats,
+        const std::string &name)
+    : min_limit(_min_limit),
+      max_limit(_max_limit),
+      limit(initial_limit),
+      short_latency(0),
+      long_latency(0),
+      reported_limit(initial_limit),
+      latency_stat(secs_to_ticks(1), false),
+      stats_membership(stats,
+                       &limit_stat, (name + "_concurrency_limit").c_str(),
+                       &latency_stat, (name + "_task_latency").c_str()) {
+    guarantee(0 < _min_limit && _min_limit <= initial_limit
+              && initial_limit <= _max_limit);
+    limit_stat += reported_limit;
+}
+
+adaptive_concurrency_limit_t::~adaptive_concurrency_limit_t() {
+    limit_stat -= reported_limit;
+}
+
+size_t adaptive_concurrency_limit_t::get() const {
+    return static_cast<size_t>(limit);
+}
+
+void adaptive_concurrency_limit_t::on_task_done(
+        ticks_t latency, size_t running, bool queued) {
+    assert_thread();
+    latency_stat.record(ticks_to_secs(latency));
+
+    const double sample = std::max<int64_t>(latency.nanos, 1);
+    if (short_latency == 0) {
+        short_latency = long_latency = sample;
+    } else {
+        short_latency += (sample - short_latency) * SHORT_LATENCY_WEIGHT;
+        long_latency += (sample - long_latency) * LONG_LATENCY_WEIGHT;
+        // When the latency goes back down after a long time under load, the long-term
+        // average stays high for a while and the next rise wouldn't register against
+        // it, so we let it catch up faster.
+        if (long_latency > 2 * short_latency) {
+            long_latency *= 0.95;
+        }
+    }
+
+    if (!queued && running < limit / 2) {
+        return;
+    }
+
+    const double gradient = std::max(
+        0.5, std::min(1.0, LATENCY_TOLERANCE * long_latency / short_latency));
+    const double target = limit * gradient + sqrt(limit);
+    limit = std::max(min_limit, std::min(max_limit,
+        limit * (1 - LIMIT_SMOOTHING) + target * LIMIT_SMOOTHING));
+
+    const int64_t rounded = get();
+    limit_stat += rounded - reported_limit;
+    reported_limit = rounded;
+}
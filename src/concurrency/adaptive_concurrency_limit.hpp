@@ -0,0 +1,55 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_ADAPTIVE_CONCURRENCY_LIMIT_HPP_
+#define CONCURRENCY_ADAPTIVE_CONCURRENCY_LIMIT_HPP_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "perfmon/perfmon.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+
+/* `adaptive_concurrency_limit_t` decides how many tasks a `coro_pool_t` may run at once
+from how long its tasks take. It follows the "gradient" limit of Netflix's
+concurrency-limits library: a short-term average of the task latency is compared to a
+long-term one. While they agree, the limit grows by about its square root per task;
+when the short-term latency goes up (the tasks are queueing on whatever they wait
+for), the limit shrinks in proportion.
+
+The limit only moves while the pool is actually using it, that is while tasks are
+waiting in the queue or at least half of the limit is running. Otherwise the latency
+says nothing about what a higher limit would do. */
+class adaptive_concurrency_limit_t : public home_thread_mixin_debug_only_t {
+public:
+    adaptive_concurrency_limit_t(size_t min_limit,
+                                 size_t initial_limit,
+                                 size_t max_limit,
+                                 perfmon_collection_t *stats,
+                                 const std::string &name);
+    ~adaptive_concurrency_limit_t();
+
+    size_t get() const;
+
+    /* Called when a task finishes. `running` is the number of tasks that were running
+    when it finished, including itself, and `queued` tells whether there are more
+    tasks waiting. */
+    void on_task_done(ticks_t latency, size_t running, bool queued);
+
+private:
+    const double min_limit, max_limit;
+    double limit;
+    // Exponential moving averages of the task latency in nanoseconds, or 0 before the
+    // first task.
+    double short_latency, long_latency;
+
+    // `limit_stat` holds the rounded limit; `reported_limit` is what we added to it.
+    perfmon_counter_t limit_stat;
+    int64_t reported_limit;
+    perfmon_sampler_t latency_stat;
+    perfmon_multi_membership_t stats_membership;
+
+    DISABLE_COPYING(adaptive_concurrency_limit_t);
+};
+
+#endif  // CONCURRENCY_ADAPTIVE_CONCURRENCY_LIMIT_HPP_
@@ -4,13 +4,20 @@
 
 #include <functional>
 
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/adaptive_concurrency_limit.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/interruptor.hpp"
 #include "concurrency/queue/passive_producer.hpp"
+#include "time.hpp"
 
 /* coro_pool_t maintains a bunch of coroutines; when you give it tasks, it
 distributes them among the coroutines. It draws its tasks from a
-`passive_producer_t`. */
+`passive_producer_t`. If the callback is known to be shallow, the workers can be
+spawned with small stacks (see `coro_stack_class_t`).
+
+The number of workers is either fixed, or it's set by an
+`adaptive_concurrency_limit_t` from how long the tasks take. */
 
 template <class T>
 class coro_pool_callback_t {
@@ -37,16 +44,33 @@ private:
 template <class T>
 class coro_pool_t : private availability_callback_t, public home_thread_mixin_t {
 public:
-    coro_pool_t(size_t _worker_count, passive_producer_t<T> *_source, coro_pool_callback_t<T> *_callback)
+    coro_pool_t(size_t _worker_count, passive_producer_t<T> *_source, coro_pool_callback_t<T> *_callback,
+                coro_stack_class_t _stack_class = coro_stack_class_t::normal)
         : max_worker_count(_worker_count),
           active_worker_count(0),
+          limit(nullptr),
           source(_source),
-          callback(_callback) {
+          callback(_callback),
+          stack_class(_stack_class) {
         rassert(max_worker_count > 0);
         on_source_availability_changed();   // Start process if necessary
         source->available->set_callback(this);
     }
 
+    // `_limit` must outlive the pool.
+    coro_pool_t(adaptive_concurrency_limit_t *_limit, passive_producer_t<T> *_source,
+                coro_pool_callback_t<T> *_callback,
+                coro_stack_class_t _stack_class = coro_stack_class_t::normal)
+        : max_worker_count(0),
+          active_worker_count(0),
+          limit(_limit),
+          source(_source),
+          callback(_callback),
+          stack_class(_stack_class) {
+        on_source_availability_changed();   // Start process if necessary
+        source->available->set_callback(this);
+    }
+
     ~coro_pool_t() {
         assert_thread();
         source->available->unset_callback();
@@ -65,7 +89,24 @@ private:
         assert_thread();
         try {
             while (!coro_drain_semaphore_lock.get_drain_signal()->is_pulsed()) {
-                callback->coro_pool_callback(object, coro_drain_semaphore_lock.get_drain_signal());
+                if (limit == nullptr) {
+                    callback->coro_pool_callback(
+                        object, coro_drain_semaphore_lock.get_drain_signal());
+                } else {
+                    const ticks_t start = get_ticks();
+                    callback->coro_pool_callback(
+                        object, coro_drain_semaphore_lock.get_drain_signal());
+                    limit->on_task_done(
+                        ticks_t{get_ticks().nanos - start.nanos},
+                        active_worker_count,
+                        source->available->get());
+                    // If the limit went down, the extra workers quit; if it went up,
+                    // new ones get started.
+                    if (static_cast<size_t>(active_worker_count) > limit->get()) {
+                        break;
+                    }
+                    on_source_availability_changed();
+                }
                 if (source->available->get()) {
                     object = source->pop();
                 } else {
@@ -81,17 +122,24 @@ private:
 
     void on_source_availability_changed() {
         assert_thread();
-        while (source->available->get() && active_worker_count < max_worker_count) {
+        while (source->available->get() && active_worker_count < worker_limit()) {
             ++active_worker_count;
             coro_t::spawn_sometime(std::bind(
                 &coro_pool_t::worker_run, this,
-                source->pop(), auto_drainer_t::lock_t(&coro_drain_semaphore)));
+                source->pop(), auto_drainer_t::lock_t(&coro_drain_semaphore)),
+                stack_class);
         }
     }
 
+    int worker_limit() const {
+        return limit == nullptr ? max_worker_count : static_cast<int>(limit->get());
+    }
+
     int max_worker_count, active_worker_count;
+    adaptive_concurrency_limit_t *limit;
     passive_producer_t<T> *source;
     coro_pool_callback_t<T> *callback;
+    const coro_stack_class_t stack_class;
     auto_drainer_t coro_drain_semaphore;
 };
 
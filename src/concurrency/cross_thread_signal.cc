@@ -1,7 +1,7 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "concurrency/cross_thread_signal.hpp"
 
-#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
 
 void cross_thread_signal_subscription_t::run() {
     parent_->on_signal_pulsed(keepalive_);
@@ -10,18 +10,31 @@ void cross_thread_signal_subscription_t::run() {
 cross_thread_signal_t::cross_thread_signal_t(signal_t *source, threadnum_t dest) :
     source_thread(get_thread_id()), dest_thread(dest),
     rethreader(static_cast<signal_t *>(this), dest_thread),
+    delivered(false),
     subs(this, auto_drainer_t::lock_t(&drainer)) {
     rassert(source->home_thread() == source_thread);
     subs.reset(source);
 }
 
 void cross_thread_signal_t::on_signal_pulsed(auto_drainer_t::lock_t keepalive) {
-    /* We can't do anything that blocks when we're in a signal callback, so we
-    have to spawn a new coroutine to do the thread switching. */
-    coro_t::spawn_sometime(std::bind(&cross_thread_signal_t::deliver, this, keepalive));
+    /* We can't pulse right away even if `dest_thread` is this thread, because then
+    we'd be pulsing from inside a signal callback. */
+    in_flight = std::move(keepalive);
+    if (continue_on_thread(dest_thread, this)) {
+        call_later_on_this_thread(this);
+    }
 }
 
-void cross_thread_signal_t::deliver(UNUSED auto_drainer_t::lock_t keepalive) {
-    on_thread_t thread_switcher(dest_thread);
-    signal_t::pulse();
+void cross_thread_signal_t::on_thread_switch() {
+    if (!delivered) {
+        // We're on `dest_thread`.
+        delivered = true;
+        signal_t::pulse();
+        if (continue_on_thread(source_thread, this)) {
+            in_flight.reset();
+        }
+    } else {
+        // We're back on `source_thread`, where `drainer` lives.
+        in_flight.reset();
+    }
 }
@@ -2,6 +2,7 @@
 #ifndef CONCURRENCY_CROSS_THREAD_SIGNAL_HPP_
 #define CONCURRENCY_CROSS_THREAD_SIGNAL_HPP_
 
+#include "arch/runtime/runtime_utils.hpp"
 #include "concurrency/signal.hpp"
 #include "concurrency/auto_drainer.hpp"
 
@@ -25,10 +26,15 @@ private:
 thread, but you wish you had the same `signal_t` on a different thread.
 Construct a `cross_thread_signal_t` on the original thread, and pass the new
 thread to its constructor. It will deliver a notification to the specified
-thread when the original signal is pulsed. */
+thread when the original signal is pulsed.
+
+The notification is the `cross_thread_signal_t` itself: it goes to the other thread's
+message hub as a message, pulses there, and comes back to release its drainer lock.
+So a pulse doesn't allocate anything or spawn a coroutine. */
 
 class cross_thread_signal_t :
-    public signal_t
+    public signal_t,
+    private linux_thread_message_t
 {
 public:
     cross_thread_signal_t(signal_t *source, threadnum_t dest_thread);
@@ -36,7 +42,7 @@ public:
 private:
     friend class cross_thread_signal_subscription_t;
     void on_signal_pulsed(auto_drainer_t::lock_t);
-    void deliver(auto_drainer_t::lock_t);
+    void on_thread_switch();
 
     threadnum_t source_thread;
     threadnum_t dest_thread;
@@ -60,6 +66,12 @@ private:
         const threadnum_t original;
     } rethreader;
 
+    /* Held while the message is on its way, and released on `source_thread`. It must
+    be destroyed after `drainer`, whose destructor waits for it. `delivered` is
+    set on `dest_thread` when we pulse, so the message knows which way it's going. */
+    auto_drainer_t::lock_t in_flight;
+    bool delivered;
+
     /* `drainer` makes sure we don't shut down with a signal still in flight */
     auto_drainer_t drainer;
 
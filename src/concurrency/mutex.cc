@@ -1,6 +1,7 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "concurrency/mutex.hpp"
 
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/coroutines.hpp"
 
 mutex_t::acq_t::acq_t(mutex_t *l, bool eager) : lock_(nullptr), eager_(false) {
@@ -27,6 +28,7 @@ void mutex_t::acq_t::reset(mutex_t *l, bool eager) {
 
 void co_lock_mutex(mutex_t *mutex) {
     if (mutex->locked) {
+        coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::mutex);
         mutex->waiters.push_back(coro_t::self());
         coro_t::wait();
     } else {
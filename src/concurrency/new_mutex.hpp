@@ -1,6 +1,7 @@
 #ifndef CONCURRENCY_NEW_MUTEX_HPP_
 #define CONCURRENCY_NEW_MUTEX_HPP_
 
+#include "arch/runtime/coro_sampler.hpp"
 #include "concurrency/interruptor.hpp"
 #include "concurrency/rwlock.hpp"
 
@@ -45,12 +46,14 @@ public:
     // Acquires the lock.  The constructor blocks the coroutine, it doesn't return
     // until the lock is acquired.
     explicit new_mutex_acq_t(new_mutex_t *lock) : in_line(lock) {
+        coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::mutex);
         in_line.acq_signal()->wait();
     }
 
     // Acquires the lock.  The constructor blocks the coroutine until the lock
     // is acquired or the interruptor is pulsed.
     new_mutex_acq_t(new_mutex_t *lock, signal_t *interruptor) : in_line(lock) {
+        coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::mutex);
         wait_interruptible(in_line.acq_signal(), interruptor);
 
     }
@@ -1,5 +1,6 @@
 #include "concurrency/rwlock.hpp"
 
+#include "arch/runtime/coro_sampler.hpp"
 #include "concurrency/interruptor.hpp"
 #include "valgrind.hpp"
 
@@ -97,6 +98,7 @@ void rwlock_in_line_t::reset() {
 
 rwlock_acq_t::rwlock_acq_t(rwlock_t *lock, access_t access)
     : rwlock_in_line_t(lock, access) {
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::mutex);
     if (access == access_t::read) {
         read_signal()->wait();
     } else {
@@ -106,6 +108,7 @@ rwlock_acq_t::rwlock_acq_t(rwlock_t *lock, access_t access)
 
 rwlock_acq_t::rwlock_acq_t(rwlock_t *lock, access_t access, signal_t *interruptor)
     : rwlock_in_line_t(lock, access) {
+    coro_wait_reason_scope_t wait_reason(coro_wait_reason_t::mutex);
     if (access == access_t::read) {
         wait_interruptible(read_signal(), interruptor);
     } else {
@@ -44,6 +44,17 @@
 // useful.
 #define DEFAULT_IO_BATCH_FACTOR                   1
 
+// How long (in ms) requests of each `io_class_t` may wait in the disk manager's queue
+// before they go ahead of the requests of more urgent classes.
+#define IO_FOREGROUND_READ_TARGET_LATENCY_MS      5
+#define IO_FOREGROUND_WRITE_TARGET_LATENCY_MS     50
+#define IO_BACKGROUND_TARGET_LATENCY_MS           500
+
+// While foreground requests are waiting or in flight, the disk manager only sends this
+// many background requests to the disk at a time, so that the foreground requests
+// don't queue up behind them in the device.
+#define IO_BACKGROUND_MAX_IN_FLIGHT_UNDER_LOAD    2
+
 // I/O priority of index writes in the log serializer
 #define INDEX_WRITE_IO_PRIORITY                   128
 
@@ -75,6 +86,10 @@
 // Size of each btree node (in bytes) on disk
 #define DEFAULT_BTREE_BLOCK_SIZE                  (4 * KILOBYTE)
 
+// Tables can be created with bigger btree nodes, up to this size.  Block sizes are
+// stored in 16 bits all over the serializer and the btree, so this can't grow.
+#define MAX_BTREE_BLOCK_SIZE                      (32 * KILOBYTE)
+
 // Size of each extent (in bytes)
 // This should not be too small, or garbage collection will become
 // inefficient (especially on rotational drives).
@@ -83,6 +98,19 @@
 // Ratio of free ram to use for the cache by default
 #define DEFAULT_MAX_CACHE_RATIO                   2
 
+// How often (in ms) an automatically sized cache checks for memory pressure.  While
+// some tasks in our cgroup (or on the system) spend at least
+// CACHE_SHRINK_MEMORY_PRESSURE_PERCENT of their time stalled on memory, or the cgroup
+// uses more than CACHE_SHRINK_CGROUP_USAGE_PERCENT of its limit, the cache shrinks by
+// a quarter every check.  Once that's over, it grows back by an eighth per check.
+#define CACHE_SIZE_CHECK_INTERVAL_MS              5000
+#define CACHE_SHRINK_MEMORY_PRESSURE_PERCENT      10.0
+#define CACHE_SHRINK_CGROUP_USAGE_PERCENT         95
+
+// How much memory each page cache may spend on block summaries, which are the Bloom
+// filters that let point lookups skip loading leaf nodes that don't have the key.
+#define BLOCK_SUMMARIES_MAX_BYTES                 (2 * MEGABYTE)
+
 // The maximum number of concurrently active
 // index writes per merger serializer.
 // The smaller the number, the more effective
@@ -92,6 +120,12 @@
 // small values of this variable.
 #define MERGER_SERIALIZER_MAX_ACTIVE_WRITES       1
 
+// How long (in ms) the merger serializer holds back an index write so that index
+// writes from other hash shards (and other transactions) can join it and share its LBA
+// and metablock writes.  It only waits if the previous group merged more than one
+// index write, so a single writer never pays for this.  0 disables the wait.
+#define MERGER_SERIALIZER_GROUP_COMMIT_WINDOW_MS  1
+
 // I/O priority of block writes in the merger_serializer_t
 #define MERGER_BLOCK_WRITE_IO_PRIORITY            64
 
@@ -115,15 +149,17 @@
 // id.
 #define SUPERBLOCK_ID                             0
 
-// If the size of the LBA on a given disk exceeds LBA_MIN_SIZE_FOR_GC, then the fraction of the
-// entries that are live and not garbage should be at least LBA_MIN_UNGARBAGE_FRACTION.
+// The LBA garbage collector replaces the LBA extents of a shard with a snapshot of the
+// shard's in-memory index.  It does that once the extents take up more than
+// LBA_MIN_SIZE_FOR_GC for the whole disk, and more than LBA_MAX_REPLAY_RATIO times the
+// size of the snapshot, so that at most that much has to be replayed at startup.
 #define LBA_MIN_SIZE_FOR_GC                       (MEGABYTE * 1)
-#define LBA_MIN_UNGARBAGE_FRACTION                0.5
+#define LBA_MAX_REPLAY_RATIO                      1.0
 
 // I/O priority for LBA garbage collection
 #define LBA_GC_IO_PRIORITY                        8
 
-// How many block ids should the LBA garbage collector rewrite before yielding?
+// How many block ids should the LBA garbage collector snapshot before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
 // How many LBA structures to have for each file (This value defines the disk format!
@@ -141,6 +177,26 @@
 // block infos.
 #define LBA_RECONSTRUCTION_BATCH_SIZE             1024
 
+// Serializers that take at least this long to start up log how long each part of the
+// startup took.
+#define SERIALIZER_STARTUP_LOG_THRESHOLD_SECS     1.0
+
+// Every HOT_SET_MANIFEST_INTERVAL_SECS, and when a table is closed, each of its caches
+// writes the ids of up to HOT_SET_MANIFEST_MAX_BLOCKS of its most recently used blocks
+// to a file next to the table file.  When the table is opened again, each cache
+// prefetches up to HOT_SET_WARM_UP_MAX_BYTES of those blocks.  0 disables warming up.
+#define HOT_SET_MANIFEST_INTERVAL_SECS            300
+#define HOT_SET_MANIFEST_MAX_BLOCKS               65536
+#define HOT_SET_WARM_UP_MAX_BYTES                 (256 * MEGABYTE)
+
+// How many tables a server loads from disk at the same time when it starts up.  Every
+// table that is being loaded can use up to LBA_READ_BUFFER_SIZE for reading its LBA.
+#define TABLE_LOAD_CONCURRENCY                    8
+
+// The log file gets an entry in its time index about every this many bytes, so a read
+// of the `logs` table for a time range only has to scan this much past the range.
+#define LOG_TIME_INDEX_INTERVAL_BYTES             (64 * KILOBYTE)
+
 #if defined (__powerpc64__)
 // getifaddrs() calls alloca() and it tries to allocate 64KB of memory
 // in stack frame. To avoid stack overflow, increasing the stack size
@@ -150,6 +206,26 @@
 #define COROUTINE_STACK_SIZE                      131072
 #endif
 
+// The stack size of coroutines that are spawned with `coro_stack_class_t::shallow`.
+#define COROUTINE_SHALLOW_STACK_SIZE              32768
+
+// When a key in a `directory_map_write_manager_t` changes, it waits this long (in ms)
+// for more changes before it sends them to its peers, and sends at most this many keys
+// in one message.
+#define DIRECTORY_UPDATE_BATCH_WINDOW_MS          10
+#define DIRECTORY_UPDATE_MAX_BATCH_KEYS           100
+
+// How often (in ms) the primary replica tells every secondary the latest timestamp it
+// has assigned, so that the secondary knows how stale its data may be for
+// `read_mode: "bounded"` reads even when there are no writes.
+#define REPLICATOR_HEARTBEAT_INTERVAL_MS          100
+
+// How long (in seconds) a TLS session ticket key is used for new tickets.  Tickets
+// stay valid for as long again after that.  The session cache keeps resumable
+// sessions for the same time, and remembers up to `TLS_SESSION_CACHE_SIZE` of them.
+#define TLS_TICKET_KEY_LIFETIME_SECS              3600
+#define TLS_SESSION_CACHE_SIZE                    20480
+
 
 /**
  * Message scheduler configuration
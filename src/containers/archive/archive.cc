@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "containers/archive/archive.hpp"
 
+#include <limits.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -58,6 +59,11 @@ int64_t force_read(read_stream_t *s, void *p, int64_t n) {
     return written_so_far;
 }
 
+write_message_t::write_message_t(write_message_t &&movee)
+    : buffers_(std::move(movee.buffers_)), tail_chunk_(movee.tail_chunk_) {
+    movee.tail_chunk_ = nullptr;
+}
+
 write_message_t::~write_message_t() {
     while (write_buffer_t *buffer = buffers_.head()) {
         buffers_.remove(buffer);
@@ -65,22 +71,42 @@ write_message_t::~write_message_t() {
     }
 }
 
-void write_message_t::append(const void *p, int64_t n) {
+void write_message_t::append_to_new_chunks(const void *p, int64_t n) {
     while (n > 0) {
-        if (buffers_.empty() || buffers_.tail()->size == write_buffer_t::DATA_SIZE) {
-            buffers_.push_back(new write_buffer_t);
+        if (tail_chunk_ == nullptr || tail_chunk_->size == write_chunk_t::DATA_SIZE) {
+            tail_chunk_ = new write_chunk_t;
+            buffers_.push_back(tail_chunk_);
         }
 
-        write_buffer_t *b = buffers_.tail();
-        int64_t k = std::min<int64_t>(n, write_buffer_t::DATA_SIZE - b->size);
+        write_chunk_t *b = tail_chunk_;
+        int64_t k = std::min<int64_t>(n, write_chunk_t::DATA_SIZE - b->size);
 
-        memcpy(b->data + b->size, p, k);
+        memcpy(b->chunk_data + b->size, p, k);
         b->size += k;
         p = static_cast<const char *>(p) + k;
         n = n - k;
     }
 }
 
+// Below this, a reference costs more than the copy it saves.
+const int64_t MIN_SHARED_WRITE_BUFFER_SIZE = 1024;
+
+void write_message_t::append_shared(const shared_buf_ref_t<char> &ref, int64_t n) {
+    if (n < MIN_SHARED_WRITE_BUFFER_SIZE) {
+        append(ref.get(), n);
+        return;
+    }
+    // Pieces that don't fit in an `int` are split up.
+    int64_t offset = 0;
+    while (offset < n) {
+        const int64_t k = std::min<int64_t>(n - offset, INT_MAX);
+        buffers_.push_back(new shared_write_buffer_t(ref.make_child(offset),
+                                                     static_cast<int>(k)));
+        offset += k;
+    }
+    tail_chunk_ = nullptr;
+}
+
 size_t write_message_t::size() const {
     size_t ret = 0;
     for (write_buffer_t *h = buffers_.head(); h != nullptr; h = buffers_.next(h)) {
@@ -92,7 +118,7 @@ size_t write_message_t::size() const {
 int send_write_message(write_stream_t *s, const write_message_t *wm) {
     intrusive_list_t<write_buffer_t> *list = const_cast<write_message_t *>(wm)->unsafe_expose_buffers();
     for (write_buffer_t *p = list->head(); p; p = list->next(p)) {
-        int64_t res = s->write(p->data, p->size);
+        int64_t res = s->write(p->data(), p->size);
         if (res == -1) {
             return -1;
         }
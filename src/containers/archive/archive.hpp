@@ -3,12 +3,14 @@
 #define CONTAINERS_ARCHIVE_ARCHIVE_HPP_
 
 #include <stdint.h>
+#include <string.h>
 
 #include <string>
 #include <type_traits>
 
 #include "containers/intrusive_list.hpp"
 #include "containers/printf_buffer.hpp"
+#include "containers/shared_buffer.hpp"
 #include "version.hpp"
 #include "valgrind.hpp"
 
@@ -91,31 +93,75 @@ private:
     DISABLE_COPYING(write_stream_t);
 };
 
+// A piece of a `write_message_t`: `size` bytes starting at `data()`.
 class write_buffer_t : public intrusive_list_node_t<write_buffer_t> {
 public:
-    write_buffer_t() : size(0) { }
+    virtual ~write_buffer_t() { }
 
-    static const int DATA_SIZE = 4096;
+    virtual const char *data() const = 0;
     int size;
-    char data[DATA_SIZE];
+
+protected:
+    write_buffer_t() : size(0) { }
 
 private:
     DISABLE_COPYING(write_buffer_t);
 };
 
+// A piece that holds the bytes itself.  This is what `append()` fills.
+class write_chunk_t : public write_buffer_t {
+public:
+    write_chunk_t() { }
+
+    const char *data() const { return chunk_data; }
+
+    static const int DATA_SIZE = 4096;
+    char chunk_data[DATA_SIZE];
+};
+
+// A piece that refers to bytes in a `shared_buf_t`, which it keeps alive.  This is
+// what `append_shared()` adds.
+class shared_write_buffer_t : public write_buffer_t {
+public:
+    shared_write_buffer_t(const shared_buf_ref_t<char> &_ref, int _size)
+        : ref(_ref) {
+        ref.guarantee_in_boundary(_size);
+        size = _size;
+    }
+
+    const char *data() const { return ref.get(); }
+
+private:
+    shared_buf_ref_t<char> ref;
+};
+
 // A set of buffers in which an atomic message to be sent on a stream
 // gets built up.  (This way we don't flush after the first four bytes
 // sent to a stream, or buffer things and then forget to manually
-// flush.  This type can be extended to support holding references to
-// large buffers, to save copying.)  Generally speaking, you serialize
-// to a write_message_t, and then flush that to a write_stream_t.
+// flush.)  Large pieces of `shared_buf_t`s can be added by reference
+// instead of being copied.  Generally speaking, you serialize to a
+// write_message_t, and then flush that to a write_stream_t.
 class write_message_t {
 public:
-    write_message_t() { }
-    explicit write_message_t(write_message_t &&) = default;
+    write_message_t() : tail_chunk_(nullptr) { }
+    explicit write_message_t(write_message_t &&movee);
     ~write_message_t();
 
-    void append(const void *p, int64_t n);
+    // Serializers call this for every field, so the common case of a piece that fits
+    // into the last chunk is inline.
+    void append(const void *p, int64_t n) {
+        if (tail_chunk_ != nullptr
+            && n <= write_chunk_t::DATA_SIZE - tail_chunk_->size) {
+            memcpy(tail_chunk_->chunk_data + tail_chunk_->size, p, n);
+            tail_chunk_->size += n;
+        } else {
+            append_to_new_chunks(p, n);
+        }
+    }
+
+    // Like `append(ref.get(), n)`, but large pieces are referenced rather than
+    // copied.  The shared buffer must not change while the message is around.
+    void append_shared(const shared_buf_ref_t<char> &ref, int64_t n);
 
     size_t size() const;
 
@@ -124,8 +170,14 @@ public:
 private:
     friend int send_write_message(write_stream_t *s, const write_message_t *wm);
 
+    void append_to_new_chunks(const void *p, int64_t n);
+
     intrusive_list_t<write_buffer_t> buffers_;
 
+    // The last buffer in `buffers_`, if it's a chunk that `append()` can copy into.
+    // Null otherwise.
+    write_chunk_t *tail_chunk_;
+
     DISABLE_COPYING(write_message_t);
 };
 
@@ -142,6 +194,11 @@ struct serialized_size_t;
 template <class T>
 struct serialize_universal_size_t;
 
+// True for the types that go over the wire as their raw bytes, so that an array of
+// them can be serialized with a single copy.
+template <class T>
+struct is_raw_serializable_t : public std::false_type { };
+
 // Makes typ1 serializable, sending a typ2 over the wire.  Has range
 // checking on the closed interval [lo, hi] when deserializing.
 #define ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(typ1, typ2, lo, hi)       \
@@ -224,6 +281,8 @@ struct serialize_universal_size_t;
     struct serialized_size_t<typ>                                       \
         : public std::integral_constant<size_t, sizeof(typ)> { }; /* NOLINT(readability/braces) */       \
     template <>                                                         \
+    struct is_raw_serializable_t<typ> : public std::true_type { }; /* NOLINT(readability/braces) */ \
+    template <>                                                         \
     struct serialize_universal_size_t<typ>                              \
         : public std::integral_constant<size_t, sizeof(typ)> { }
 
@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "containers/archive/archive.hpp"
+#include "containers/shared_buffer.hpp"
 
 // Reads from a buffer without taking ownership over it
 class buffer_read_stream_t : public read_stream_t {
@@ -44,5 +45,41 @@ private:
     DISABLE_COPYING(buffer_read_stream_t);
 };
 
+// Reads from a `shared_buf_t` that it holds a reference to. Deserializers that know
+// about this stream (such as the one for datums) can keep a reference into the buffer
+// instead of copying the data out of it.
+class shared_buf_read_stream_t : public read_stream_t {
+public:
+    explicit shared_buf_read_stream_t(counted_t<const shared_buf_t> &&buf)
+        : pos_(0), buf_(std::move(buf)) {
+        guarantee(buf_.has());
+    }
+    virtual ~shared_buf_read_stream_t() { }
+
+    virtual MUST_USE int64_t read(void *p, int64_t n) {
+        int64_t num_to_read = skip(n);
+        memcpy(p, buf_->data(pos_ - num_to_read), num_to_read);
+        return num_to_read;
+    }
+
+    // Moves ahead by up to `n` bytes without reading them, and returns the number of
+    // bytes that it skipped.
+    int64_t skip(int64_t n) {
+        int64_t num_left = buf_->size() - pos_;
+        int64_t num_skipped = n < num_left ? n : num_left;
+        pos_ += num_skipped;
+        return num_skipped;
+    }
+
+    int64_t tell() const { return pos_; }
+
+    const counted_t<const shared_buf_t> &get_buf() const { return buf_; }
+
+private:
+    int64_t pos_;
+    counted_t<const shared_buf_t> buf_;
+
+    DISABLE_COPYING(shared_buf_read_stream_t);
+};
 
 #endif  // CONTAINERS_ARCHIVE_BUFFER_STREAM_HPP_
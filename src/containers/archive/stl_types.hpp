@@ -140,22 +140,75 @@ MUST_USE archive_result_t deserialize(read_stream_t *s, std::string *out) {
 // it'll take O(n) time!
 // Keep in sync with serialize.
 template <cluster_version_t W, class T>
-size_t serialized_size(const std::vector<T> &v) {
-    size_t ret = varint_uint64_serialized_size(v.size());
+size_t serialized_vector_elements_size(const std::vector<T> &v, std::false_type) {
+    size_t ret = 0;
     for (auto it = v.begin(), e = v.end(); it != e; ++it) {
         ret += serialized_size<W>(*it);
     }
     return ret;
 }
 
+template <cluster_version_t W, class T>
+size_t serialized_vector_elements_size(const std::vector<T> &v, std::true_type) {
+    return v.size() * sizeof(T);
+}
+
+template <cluster_version_t W, class T>
+size_t serialized_size(const std::vector<T> &v) {
+    return varint_uint64_serialized_size(v.size())
+        + serialized_vector_elements_size<W>(v, is_raw_serializable_t<T>());
+}
+
+template <cluster_version_t W, class T>
+void serialize_vector_elements(write_message_t *wm, const std::vector<T> &v,
+                               std::false_type) {
+    for (auto it = v.begin(), e = v.end(); it != e; ++it) {
+        serialize<W>(wm, *it);
+    }
+}
+
+// The elements are serialized as their raw bytes anyway, so we copy them all at once.
+// This is what makes the `std::vector<char>`s in backfill items cheap to serialize.
+template <cluster_version_t W, class T>
+void serialize_vector_elements(write_message_t *wm, const std::vector<T> &v,
+                               std::true_type) {
+    if (!v.empty()) {
+        wm->append(v.data(), v.size() * sizeof(T));
+    }
+}
 
 // Keep in sync with serialized_size.
 template <cluster_version_t W, class T>
 void serialize(write_message_t *wm, const std::vector<T> &v) {
     serialize_varint_uint64(wm, v.size());
-    for (auto it = v.begin(), e = v.end(); it != e; ++it) {
-        serialize<W>(wm, *it);
+    serialize_vector_elements<W>(wm, v, is_raw_serializable_t<T>());
+}
+
+template <cluster_version_t W, class T>
+MUST_USE archive_result_t deserialize_vector_elements(
+        read_stream_t *s, std::vector<T> *v, std::false_type) {
+    for (size_t i = 0; i < v->size(); ++i) {
+        archive_result_t res = deserialize<W>(s, &(*v)[i]);
+        if (bad(res)) { return res; }
+    }
+    return archive_result_t::SUCCESS;
+}
+
+template <cluster_version_t W, class T>
+MUST_USE archive_result_t deserialize_vector_elements(
+        read_stream_t *s, std::vector<T> *v, std::true_type) {
+    if (v->empty()) {
+        return archive_result_t::SUCCESS;
     }
+    const int64_t n = v->size() * sizeof(T);
+    int64_t res = force_read(s, v->data(), n);
+    if (res == -1) {
+        return archive_result_t::SOCK_ERROR;
+    }
+    if (res < n) {
+        return archive_result_t::SOCK_EOF;
+    }
+    return archive_result_t::SUCCESS;
 }
 
 template <cluster_version_t W, class T>
@@ -166,17 +219,15 @@ MUST_USE archive_result_t deserialize(read_stream_t *s, std::vector<T> *v) {
     archive_result_t res = deserialize_varint_uint64(s, &sz);
     if (bad(res)) { return res; }
 
-    if (sz > std::numeric_limits<size_t>::max()) {
+    if (sz > std::numeric_limits<size_t>::max()
+        || (is_raw_serializable_t<T>::value
+            && sz > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())
+                    / sizeof(T))) {
         return archive_result_t::RANGE_ERROR;
     }
 
     v->resize(sz);
-    for (uint64_t i = 0; i < sz; ++i) {
-        res = deserialize<W>(s, &(*v)[i]);
-        if (bad(res)) { return res; }
-    }
-
-    return archive_result_t::SUCCESS;
+    return deserialize_vector_elements<W>(s, v, is_raw_serializable_t<T>());
 }
 
 template <cluster_version_t W, class T>
@@ -1,6 +1,7 @@
 #ifndef CONTAINERS_BACKINDEX_BAG_HPP_
 #define CONTAINERS_BACKINDEX_BAG_HPP_
 
+#include <inttypes.h>
 #include <stdint.h>
 
 #include "containers/segmented_vector.hpp"
@@ -50,11 +51,12 @@ private:
     template <class, size_t>
     friend class backindex_bag_t;
 
-    static const size_t NOT_IN_A_BAG = SIZE_MAX;
+    static const uint32_t NOT_IN_A_BAG = UINT32_MAX;
 
     // The item's index into a (specific) backindex_bag_t, or NOT_IN_A_BAG if it
-    // doesn't belong to the backindex_bag_t.
-    size_t index_;
+    // doesn't belong to the backindex_bag_t.  Every cached page has a few of these,
+    // so they're 32 bits; a bag can hold four billion elements.
+    uint32_t index_;
 
     DISABLE_COPYING(backindex_bag_index_t);
 };
@@ -89,7 +91,7 @@ public:
             = access_backindex(element);
         rassert(backindex->index_ != backindex_bag_index_t::NOT_IN_A_BAG);
         guarantee(backindex->index_ < vector_.size(),
-                  "early index has wrong value: index=%zu, size=%zu",
+                  "early index has wrong value: index=%" PRIu32 ", size=%zu",
                   backindex->index_, vector_.size());
 
         const size_t index = backindex->index_;
@@ -103,7 +105,7 @@ public:
             = access_backindex(back_element);
 
         rassert(back_element_backindex->index_ == vector_.size() - 1,
-                "bag %p: index %p has wrong value: index_ = %zu, size = %zu",
+                "bag %p: index %p has wrong value: index_ = %" PRIu32 ", size = %zu",
                 this, back_element_backindex,
                 back_element_backindex->index_, vector_.size());
 
@@ -122,6 +124,7 @@ public:
         guarantee(backindex->index_ == backindex_bag_index_t::NOT_IN_A_BAG,
                   "bag %p, backindex = %p", this, backindex);
 
+        guarantee(vector_.size() < backindex_bag_index_t::NOT_IN_A_BAG);
         backindex->index_ = vector_.size();
         vector_.push_back(element);
     }
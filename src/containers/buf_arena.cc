@@ -0,0 +1,376 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/buf_arena.hpp"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <atomic>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/spinlock.hpp"
+#include "errors.hpp"
+#include "math.hpp"
+#include "memory_utils.hpp"
+
+double buf_arena_stats_t::fragmentation() const {
+    if (touched_bytes == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(touched_bytes - allocated_bytes) / touched_bytes;
+}
+
+#ifdef _WIN32
+
+// There's no arena on Windows, where `raw_free_aligned()` can't free memory from
+// anywhere else.
+
+void *buf_arena_alloc(size_t size) {
+    return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+}
+
+void buf_arena_free(void *ptr) {
+    raw_free_aligned(ptr);
+}
+
+buf_arena_stats_t get_buf_arena_stats() {
+    buf_arena_stats_t stats = { 0, 0, 0, 0, 0 };
+    return stats;
+}
+
+#else  // _WIN32
+
+// The slab size is also the size of a huge page on x86-64.
+const int BUF_ARENA_SLAB_BITS = 21;
+const size_t BUF_ARENA_SLAB_SIZE = static_cast<size_t>(1) << BUF_ARENA_SLAB_BITS;
+
+// Chunk sizes are multiples of `DEVICE_BLOCK_SIZE`, so that buffers of the usual block
+// sizes don't waste anything.
+const size_t BUF_ARENA_NUM_SIZE_CLASSES = BUF_ARENA_MAX_CHUNK_SIZE / DEVICE_BLOCK_SIZE;
+
+// How many empty slabs each arena keeps around before unmapping them.
+const size_t BUF_ARENA_MAX_CACHED_EMPTY_SLABS = 4;
+
+// The slab map covers 48-bit addresses, which is all that `mmap()` hands out unless
+// it's asked for more.  It has two levels, so that only the parts of the map that
+// cover mapped slabs take up memory.
+const int BUF_ARENA_ADDRESS_BITS = 48;
+const int BUF_ARENA_MAP_LEAF_BITS = 14;
+const int BUF_ARENA_MAP_ROOT_BITS =
+    BUF_ARENA_ADDRESS_BITS - BUF_ARENA_SLAB_BITS - BUF_ARENA_MAP_LEAF_BITS;
+
+namespace {
+
+class arena_t;
+
+struct slab_t {
+    char *base;
+    bool huge_pages;
+    arena_t *arena;
+
+    // The chunk size, or 0 while the slab is empty.
+    size_t chunk_size;
+    size_t num_chunks;
+    size_t num_allocated;
+    // Chunks below `num_touched` have been handed out before, and are in `free_list`
+    // (linked through their first bytes) if they are free.  The chunks above it have
+    // never been used.
+    size_t num_touched;
+    void *free_list;
+    // The slab's index in its arena's list of partially used slabs of its size
+    // class, or `SIZE_MAX` if it's not in there.
+    size_t partial_index;
+};
+
+struct slab_map_leaf_t {
+    std::atomic<slab_t *> entries[static_cast<size_t>(1) << BUF_ARENA_MAP_LEAF_BITS];
+};
+
+// Maps the slab number (the address shifted by `BUF_ARENA_SLAB_BITS`) of every mapped
+// slab to the slab.  Lookups don't take any lock, so that freeing a buffer only has to
+// lock the arena that it came from.
+std::atomic<slab_map_leaf_t *> slab_map[static_cast<size_t>(1) << BUF_ARENA_MAP_ROOT_BITS];
+spinlock_t slab_map_lock;
+
+// Set once mapping explicit huge pages failed, because none are reserved.
+std::atomic<bool> huge_pages_unavailable(false);
+
+slab_t *find_slab(const void *ptr) {
+    const uintptr_t slab_number = reinterpret_cast<uintptr_t>(ptr) >> BUF_ARENA_SLAB_BITS;
+    const uintptr_t root_index = slab_number >> BUF_ARENA_MAP_LEAF_BITS;
+    if (root_index >= (static_cast<uintptr_t>(1) << BUF_ARENA_MAP_ROOT_BITS)) {
+        return nullptr;
+    }
+    slab_map_leaf_t *leaf = slab_map[root_index].load(std::memory_order_acquire);
+    if (leaf == nullptr) {
+        return nullptr;
+    }
+    const uintptr_t leaf_index =
+        slab_number & ((static_cast<uintptr_t>(1) << BUF_ARENA_MAP_LEAF_BITS) - 1);
+    return leaf->entries[leaf_index].load(std::memory_order_acquire);
+}
+
+void set_slab_map_entry(const char *base, slab_t *slab) {
+    const uintptr_t slab_number = reinterpret_cast<uintptr_t>(base) >> BUF_ARENA_SLAB_BITS;
+    const uintptr_t root_index = slab_number >> BUF_ARENA_MAP_LEAF_BITS;
+    guarantee(root_index < (static_cast<uintptr_t>(1) << BUF_ARENA_MAP_ROOT_BITS),
+              "mmap returned an address beyond the buffer arena's slab map.");
+    slab_map_leaf_t *leaf = slab_map[root_index].load(std::memory_order_acquire);
+    if (leaf == nullptr) {
+        spinlock_acq_t acq(&slab_map_lock);
+        leaf = slab_map[root_index].load(std::memory_order_acquire);
+        if (leaf == nullptr) {
+            // Leaves are never freed, there are few of them.
+            leaf = new slab_map_leaf_t();
+            slab_map[root_index].store(leaf, std::memory_order_release);
+        }
+    }
+    const uintptr_t leaf_index =
+        slab_number & ((static_cast<uintptr_t>(1) << BUF_ARENA_MAP_LEAF_BITS) - 1);
+    leaf->entries[leaf_index].store(slab, std::memory_order_release);
+}
+
+char *map_slab(bool *huge_pages_out) {
+#ifdef MAP_HUGETLB
+    if (!huge_pages_unavailable.load(std::memory_order_relaxed)) {
+        void *res = mmap(nullptr, BUF_ARENA_SLAB_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (res != MAP_FAILED) {
+            *huge_pages_out = true;
+            return static_cast<char *>(res);
+        }
+        huge_pages_unavailable.store(true, std::memory_order_relaxed);
+    }
+#endif
+
+    // Map twice the slab size so that we can cut an aligned slab out of it, and ask
+    // for transparent huge pages instead.
+    void *res = mmap(nullptr, 2 * BUF_ARENA_SLAB_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (res == MAP_FAILED) {
+        crash_oom();
+    }
+    char *start = static_cast<char *>(res);
+    char *base = reinterpret_cast<char *>(
+        ceil_aligned(reinterpret_cast<uintptr_t>(start), BUF_ARENA_SLAB_SIZE));
+    if (base > start) {
+        guarantee_err(munmap(start, base - start) == 0, "munmap failed");
+    }
+    char *end = start + 2 * BUF_ARENA_SLAB_SIZE;
+    if (end > base + BUF_ARENA_SLAB_SIZE) {
+        guarantee_err(munmap(base + BUF_ARENA_SLAB_SIZE,
+                             end - (base + BUF_ARENA_SLAB_SIZE)) == 0,
+                      "munmap failed");
+    }
+#ifdef MADV_HUGEPAGE
+    // This is only a hint, it's fine if the kernel doesn't support it.
+    madvise(base, BUF_ARENA_SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+    *huge_pages_out = false;
+    return base;
+}
+
+class arena_t {
+public:
+    arena_t()
+        : mapped_bytes(0), touched_bytes(0), allocated_bytes(0),
+          huge_page_slabs(0), slabs(0) { }
+
+    void *alloc(size_t size_class) {
+        spinlock_acq_t acq(&lock);
+        std::vector<slab_t *> *partial = &partial_slabs[size_class];
+        slab_t *slab;
+        if (partial->empty()) {
+            slab = get_empty_slab();
+            slab->chunk_size = (size_class + 1) * DEVICE_BLOCK_SIZE;
+            slab->num_chunks = BUF_ARENA_SLAB_SIZE / slab->chunk_size;
+            add_partial(slab);
+        } else {
+            slab = partial->back();
+        }
+
+        void *chunk;
+        if (slab->free_list != nullptr) {
+            chunk = slab->free_list;
+            slab->free_list = *static_cast<void **>(chunk);
+        } else {
+            rassert(slab->num_touched < slab->num_chunks);
+            chunk = slab->base + slab->num_touched * slab->chunk_size;
+            ++slab->num_touched;
+            touched_bytes.fetch_add(slab->chunk_size, std::memory_order_relaxed);
+        }
+        ++slab->num_allocated;
+        allocated_bytes.fetch_add(slab->chunk_size, std::memory_order_relaxed);
+        if (slab->num_allocated == slab->num_chunks) {
+            remove_partial(slab);
+        }
+        return chunk;
+    }
+
+    void free(slab_t *slab, void *chunk) {
+        spinlock_acq_t acq(&lock);
+        rassert(slab->arena == this);
+        rassert(slab->num_allocated > 0);
+        *static_cast<void **>(chunk) = slab->free_list;
+        slab->free_list = chunk;
+        const bool was_full = slab->num_allocated == slab->num_chunks;
+        --slab->num_allocated;
+        allocated_bytes.fetch_sub(slab->chunk_size, std::memory_order_relaxed);
+        if (slab->num_allocated == 0) {
+            if (!was_full) {
+                remove_partial(slab);
+            }
+            release_empty_slab(slab);
+        } else if (was_full) {
+            add_partial(slab);
+        }
+    }
+
+    void add_stats(buf_arena_stats_t *stats) const {
+        stats->mapped_bytes += mapped_bytes.load(std::memory_order_relaxed);
+        stats->touched_bytes += touched_bytes.load(std::memory_order_relaxed);
+        stats->allocated_bytes += allocated_bytes.load(std::memory_order_relaxed);
+        stats->huge_page_slabs += huge_page_slabs.load(std::memory_order_relaxed);
+        stats->slabs += slabs.load(std::memory_order_relaxed);
+    }
+
+private:
+    slab_t *get_empty_slab() {
+        if (!empty_slabs.empty()) {
+            slab_t *slab = empty_slabs.back();
+            empty_slabs.pop_back();
+            touched_bytes.fetch_sub(BUF_ARENA_SLAB_SIZE, std::memory_order_relaxed);
+            return slab;
+        }
+        slab_t *slab = new slab_t;
+        slab->base = map_slab(&slab->huge_pages);
+        slab->arena = this;
+        slab->chunk_size = 0;
+        slab->num_chunks = 0;
+        slab->num_allocated = 0;
+        slab->num_touched = 0;
+        slab->free_list = nullptr;
+        slab->partial_index = SIZE_MAX;
+        set_slab_map_entry(slab->base, slab);
+        mapped_bytes.fetch_add(BUF_ARENA_SLAB_SIZE, std::memory_order_relaxed);
+        huge_page_slabs.fetch_add(slab->huge_pages ? 1 : 0, std::memory_order_relaxed);
+        slabs.fetch_add(1, std::memory_order_relaxed);
+        return slab;
+    }
+
+    void release_empty_slab(slab_t *slab) {
+        touched_bytes.fetch_sub(slab->num_touched * slab->chunk_size,
+                                std::memory_order_relaxed);
+        slab->chunk_size = 0;
+        slab->num_chunks = 0;
+        slab->num_touched = 0;
+        slab->free_list = nullptr;
+
+        if (empty_slabs.size() < BUF_ARENA_MAX_CACHED_EMPTY_SLABS) {
+            // A cached slab stays resident, so that reusing it is cheap.
+            empty_slabs.push_back(slab);
+            touched_bytes.fetch_add(BUF_ARENA_SLAB_SIZE, std::memory_order_relaxed);
+            return;
+        }
+
+        // Nobody can look the slab up anymore, since none of its chunks are allocated.
+        set_slab_map_entry(slab->base, nullptr);
+        guarantee_err(munmap(slab->base, BUF_ARENA_SLAB_SIZE) == 0, "munmap failed");
+        mapped_bytes.fetch_sub(BUF_ARENA_SLAB_SIZE, std::memory_order_relaxed);
+        huge_page_slabs.fetch_sub(slab->huge_pages ? 1 : 0, std::memory_order_relaxed);
+        slabs.fetch_sub(1, std::memory_order_relaxed);
+        delete slab;
+    }
+
+    void add_partial(slab_t *slab) {
+        rassert(slab->partial_index == SIZE_MAX);
+        std::vector<slab_t *> *partial = &partial_slabs[size_class_of(slab)];
+        slab->partial_index = partial->size();
+        partial->push_back(slab);
+    }
+
+    void remove_partial(slab_t *slab) {
+        std::vector<slab_t *> *partial = &partial_slabs[size_class_of(slab)];
+        rassert(slab->partial_index < partial->size());
+        rassert((*partial)[slab->partial_index] == slab);
+        slab_t *last = partial->back();
+        (*partial)[slab->partial_index] = last;
+        last->partial_index = slab->partial_index;
+        partial->pop_back();
+        slab->partial_index = SIZE_MAX;
+    }
+
+    static size_t size_class_of(const slab_t *slab) {
+        return slab->chunk_size / DEVICE_BLOCK_SIZE - 1;
+    }
+
+    spinlock_t lock;
+    std::vector<slab_t *> partial_slabs[BUF_ARENA_NUM_SIZE_CLASSES];
+    std::vector<slab_t *> empty_slabs;
+
+    // These are only changed with `lock` held, but `get_buf_arena_stats()` reads them
+    // from other threads.
+    std::atomic<uint64_t> mapped_bytes;
+    std::atomic<uint64_t> touched_bytes;
+    std::atomic<uint64_t> allocated_bytes;
+    std::atomic<uint64_t> huge_page_slabs;
+    std::atomic<uint64_t> slabs;
+
+    DISABLE_COPYING(arena_t);
+};
+
+// Arenas are created by their own thread when it first allocates, and never destroyed,
+// because buffers can outlive the thread pool.
+std::atomic<arena_t *> arenas[MAX_THREADS];
+
+arena_t *get_arena_for_this_thread() {
+    const int32_t thread = get_thread_id().threadnum;
+    if (thread < 0 || thread >= MAX_THREADS) {
+        return nullptr;
+    }
+    arena_t *arena = arenas[thread].load(std::memory_order_acquire);
+    if (arena == nullptr) {
+        arena = new arena_t();
+        arenas[thread].store(arena, std::memory_order_release);
+    }
+    return arena;
+}
+
+}  // namespace
+
+void *buf_arena_alloc(size_t size) {
+    if (size == 0 || size > BUF_ARENA_MAX_CHUNK_SIZE) {
+        return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+    }
+    arena_t *arena = get_arena_for_this_thread();
+    if (arena == nullptr) {
+        return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+    }
+    return arena->alloc(ceil_divide(size, DEVICE_BLOCK_SIZE) - 1);
+}
+
+void buf_arena_free(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    slab_t *slab = find_slab(ptr);
+    if (slab == nullptr) {
+        raw_free_aligned(ptr);
+        return;
+    }
+    slab->arena->free(slab, ptr);
+}
+
+buf_arena_stats_t get_buf_arena_stats() {
+    buf_arena_stats_t stats = { 0, 0, 0, 0, 0 };
+    for (size_t i = 0; i < MAX_THREADS; ++i) {
+        const arena_t *arena = arenas[i].load(std::memory_order_acquire);
+        if (arena != nullptr) {
+            arena->add_stats(&stats);
+        }
+    }
+    return stats;
+}
+
+#endif  // _WIN32
@@ -0,0 +1,54 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_BUF_ARENA_HPP_
+#define CONTAINERS_BUF_ARENA_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+
+/* An allocator for the buffers of blocks (see `buf_ptr_t`), which make up most of the
+memory of the page cache.
+
+Small buffers (up to `BUF_ARENA_MAX_CHUNK_SIZE`) are carved out of 2 MB slabs, which are
+mapped as huge pages when the kernel allows it, so that a large cache doesn't thrash the
+TLB.  Every thread of the thread pool has its own arena of slabs.  Since the buffers
+are mostly written by the thread that allocated them, first touch keeps their memory
+on that thread's NUMA node.  A buffer can be freed on any thread.
+
+Each slab only holds chunks of one size, so freeing a buffer never leaves a hole that
+a buffer of another size couldn't use once the whole slab is empty.  When all of a slab
+comes free (typically because the evicter dropped a lot of pages), the slab as a whole
+goes back to the arena, and beyond a few cached empty slabs, to the operating system.
+
+Larger buffers, and buffers allocated outside of the thread pool, fall back to
+`raw_malloc_aligned()`.  All buffers are aligned to `DEVICE_BLOCK_SIZE`. */
+const size_t BUF_ARENA_MAX_CHUNK_SIZE = MAX_BTREE_BLOCK_SIZE;
+
+void *buf_arena_alloc(size_t size);
+void buf_arena_free(void *ptr);
+
+struct buf_arena_stats_t {
+    // The memory mapped for slabs, including the cached empty slabs.
+    uint64_t mapped_bytes;
+    // The part of the slabs that has ever been handed out, which is about what the
+    // slabs contribute to the RSS.
+    uint64_t touched_bytes;
+    // The chunks that are currently allocated.
+    uint64_t allocated_bytes;
+    // How many of the slabs are backed by explicit huge pages.
+    uint64_t huge_page_slabs;
+    uint64_t slabs;
+
+    // The touched memory that doesn't hold a buffer, relative to the touched memory.
+    double fragmentation() const;
+};
+
+buf_arena_stats_t get_buf_arena_stats();
+
+// A type for block buffers allocated from the arena.
+template <class T>
+TEMPLATE_ALIAS(scoped_buf_arena_ptr_t, scoped_alloc_t<T, buf_arena_alloc, buf_arena_free>);
+
+#endif  // CONTAINERS_BUF_ARENA_HPP_
@@ -0,0 +1,89 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/bump_arena.hpp"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "config/args.hpp"
+#include "memory_utils.hpp"
+
+// Blocks start out small, since most containers are, and double up to this size.
+const size_t BUMP_ARENA_FIRST_BLOCK_SIZE = 2 * bump_arena_t::INLINE_SIZE;
+const size_t BUMP_ARENA_MAX_BLOCK_SIZE = 256 * KILOBYTE;
+
+namespace {
+
+char *align_up(char *ptr, size_t alignment) {
+    rassert((alignment & (alignment - 1)) == 0);
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    return reinterpret_cast<char *>((addr + alignment - 1) & ~(alignment - 1));
+}
+
+}  // namespace
+
+bump_arena_t::bump_arena_t()
+    : current(inline_buffer),
+      current_end(inline_buffer + INLINE_SIZE),
+      blocks(nullptr),
+      next_block_size(BUMP_ARENA_FIRST_BLOCK_SIZE),
+      free_chunks(nullptr),
+      free_chunk_size(0) { }
+
+bump_arena_t::~bump_arena_t() {
+    while (blocks != nullptr) {
+        block_t *next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+}
+
+void *bump_arena_t::allocate(size_t size, size_t alignment) {
+    if (size == free_chunk_size && free_chunks != nullptr) {
+        free_chunk_t *chunk = free_chunks;
+        free_chunks = chunk->next;
+        return chunk;
+    }
+
+    char *start = align_up(current, alignment);
+    if (start <= current_end && size <= static_cast<size_t>(current_end - start)) {
+        current = start + size;
+        return start;
+    }
+    return allocate_from_new_block(size, alignment);
+}
+
+void bump_arena_t::deallocate(void *ptr, size_t size) {
+    // We only keep track of one size at a time.  Node-based containers only ever
+    // free one size, and vectors rarely free small buffers at all.
+    if (size < sizeof(free_chunk_t)) {
+        return;
+    }
+    if (size != free_chunk_size) {
+        if (free_chunks != nullptr) {
+            return;
+        }
+        free_chunk_size = size;
+    }
+    free_chunk_t *chunk = static_cast<free_chunk_t *>(ptr);
+    chunk->next = free_chunks;
+    free_chunks = chunk;
+}
+
+void *bump_arena_t::allocate_from_new_block(size_t size, size_t alignment) {
+    const size_t header_size = std::max<size_t>(sizeof(block_t), 16);
+    const size_t block_size = std::max(next_block_size,
+                                       header_size + size + alignment);
+    next_block_size = std::min(next_block_size * 2, BUMP_ARENA_MAX_BLOCK_SIZE);
+
+    block_t *block = static_cast<block_t *>(rmalloc(block_size));
+    block->next = blocks;
+    blocks = block;
+
+    char *start = align_up(reinterpret_cast<char *>(block) + header_size, alignment);
+    current = start + size;
+    current_end = reinterpret_cast<char *>(block) + block_size;
+    rassert(current <= current_end);
+    return start;
+}
@@ -0,0 +1,114 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_BUMP_ARENA_HPP_
+#define CONTAINERS_BUMP_ARENA_HPP_
+
+#include <stddef.h>
+
+#include <limits>
+#include <new>
+#include <utility>
+
+#include "errors.hpp"
+
+/* Hands out memory for short-lived containers by bumping a pointer through a few
+blocks, and frees all of it at once when it's destroyed.  The first allocations come
+out of a buffer inside the arena, so a small container doesn't touch malloc at all.
+
+Freed memory is only reused for later allocations of the same size (which is all
+that node-based containers like `std::map` ever allocate), so an arena is meant for
+containers that don't outlive their owner and don't churn through much more memory
+than they hold at any time.  Not thread-safe. */
+class bump_arena_t {
+public:
+    bump_arena_t();
+    ~bump_arena_t();
+
+    void *allocate(size_t size, size_t alignment);
+    void deallocate(void *ptr, size_t size);
+
+    static const size_t INLINE_SIZE = 512;
+
+private:
+    struct block_t {
+        block_t *next;
+    };
+
+    struct free_chunk_t {
+        free_chunk_t *next;
+    };
+
+    void *allocate_from_new_block(size_t size, size_t alignment);
+
+    char *current;
+    char *current_end;
+    block_t *blocks;
+    size_t next_block_size;
+
+    // Memory that has been given back, for allocations of `free_chunk_size`.
+    free_chunk_t *free_chunks;
+    size_t free_chunk_size;
+
+    // 16 bytes is enough for anything we keep in containers.
+    ATTR_ALIGNED(16) char inline_buffer[INLINE_SIZE];
+
+    DISABLE_COPYING(bump_arena_t);
+};
+
+/* A standard allocator that allocates from a `bump_arena_t`. */
+template <class T>
+class bump_allocator_t {
+public:
+    typedef T value_type;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef bump_allocator_t<U> other;
+    };
+
+    explicit bump_allocator_t(bump_arena_t *_arena) : arena(_arena) { }
+    template <class U>
+    bump_allocator_t(const bump_allocator_t<U> &other)  // NOLINT(runtime/explicit)
+        : arena(other.arena) { }
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *ptr, size_t n) {
+        arena->deallocate(ptr, n * sizeof(T));
+    }
+
+    template <class U, class... Args>
+    void construct(U *ptr, Args &&... args) {
+        new (ptr) U(std::forward<Args>(args)...);
+    }
+    template <class U>
+    void destroy(U *ptr) {
+        ptr->~U();
+    }
+
+    size_t max_size() const {
+        return std::numeric_limits<size_t>::max() / sizeof(T);
+    }
+
+    template <class U>
+    bool operator==(const bump_allocator_t<U> &other) const {
+        return arena == other.arena;
+    }
+    template <class U>
+    bool operator!=(const bump_allocator_t<U> &other) const {
+        return arena != other.arena;
+    }
+
+private:
+    template <class U> friend class bump_allocator_t;
+
+    bump_arena_t *arena;
+};
+
+#endif  // CONTAINERS_BUMP_ARENA_HPP_
@@ -1,179 +1,90 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "containers/disk_backed_queue.hpp"
 
-#include "arch/io/disk.hpp"
-#include "buffer_cache/alt.hpp"
-#include "buffer_cache/blob.hpp"
-#include "buffer_cache/cache_balancer.hpp"
-#include "buffer_cache/serialize_onto_blob.hpp"
-#include "serializer/log/log_serializer.hpp"
+#include <unistd.h>
 
+#include "arch/arch.hpp"
+#include "arch/io/disk.hpp"
+#include "math.hpp"
+#include "paths.hpp"
 
-#define DBQ_MAX_REF_SIZE 251
+// How many bytes of values we keep in memory before we write them to disk.
+static const int64_t DBQ_SPILL_THRESHOLD = MEGABYTE;
+// We start a new segment file once the current one is at least this big.
+static const int64_t DBQ_SEGMENT_SIZE = 32 * MEGABYTE;
 
-internal_disk_backed_queue_t::internal_disk_backed_queue_t(io_backender_t *io_backender,
+internal_disk_backed_queue_t::internal_disk_backed_queue_t(io_backender_t *_io_backender,
                                                            const serializer_filepath_t &filename,
                                                            perfmon_collection_t *stats_parent)
-    : perfmon_membership(stats_parent, &perfmon_collection,
+    : io_backender(_io_backender),
+      base_path(filename.temporary_path()),
+      perfmon_membership(stats_parent, &perfmon_collection,
                          filename.permanent_path().c_str()),
+      bytes_on_disk_membership(&perfmon_collection, &bytes_on_disk, "bytes_on_disk"),
+      disk_bytes(0),
       queue_size(0),
-      head_block_id(NULL_BLOCK_ID),
-      tail_block_id(NULL_BLOCK_ID),
-      file_opener(new filepath_file_opener_t(filename, io_backender)) {
-    log_serializer_t::create(file_opener.get(),
-                                  log_serializer_t::static_config_t());
-
-    serializer.init(new log_serializer_t(log_serializer_t::dynamic_config_t(),
-                                              file_opener.get(),
-                                              &perfmon_collection));
-
-    balancer.init(new dummy_cache_balancer_t(2 * MEGABYTE));
-    cache.init(new cache_t(serializer.get(), balancer.get(), &perfmon_collection,
-                           which_cpu_shard_t{0, 1}));
-    cache_conn.init(new cache_conn_t(cache.get()));
-    // Emulate cache_t::create behavior by zeroing the block with id SUPERBLOCK_ID.
-    txn_t txn(cache_conn.get(), write_durability_t::HARD, 1);
-    {
-        buf_lock_t block(&txn, SUPERBLOCK_ID, alt_create_t::create);
-        buf_write_t write(&block);
-        const block_size_t block_size = cache->max_block_size();
-        void *buf = write.get_data_write(block_size.value());
-        memset(buf, 0, block_size.value());
-    }
-    txn.commit();
-}
+      head_bytes(0),
+      next_segment_number(0) { }
 
 internal_disk_backed_queue_t::~internal_disk_backed_queue_t() {
-    /* First destroy the serializer, then remove the temporary file.
-    This avoids issues with certain file systems (specifically VirtualBox
-    shared folders), see https://github.com/rethinkdb/rethinkdb/issues/3791. */
-    cache_conn.reset();
-    cache.reset();
-    balancer.reset();
-    serializer.reset();
-
-    file_opener->unlink_serializer_file();
+    while (!segments.empty()) {
+        delete_segment(segments.front().get());
+        segments.pop_front();
+    }
 }
 
 void internal_disk_backed_queue_t::push(const write_message_t &wm) {
     mutex_t::acq_t mutex_acq(&mutex);
-
-    // There's no need for hard durability with an unlinked dbq file.
-    txn_t txn(cache_conn.get(), write_durability_t::SOFT, 2);
-
-    push_single(&txn, wm);
-
-    txn.commit();
+    push_single(wm);
 }
 
 void internal_disk_backed_queue_t::push(const scoped_array_t<write_message_t> &wms) {
     mutex_t::acq_t mutex_acq(&mutex);
-
-    // There's no need for hard durability with an unlinked dbq file.
-    txn_t txn(cache_conn.get(), write_durability_t::SOFT, 2);
-
     for (size_t i = 0; i < wms.size(); ++i) {
-        push_single(&txn, wms[i]);
+        push_single(wms[i]);
     }
-
-    txn.commit();
 }
 
-void internal_disk_backed_queue_t::push_single(txn_t *txn, const write_message_t &wm) {
-    if (head_block_id == NULL_BLOCK_ID) {
-        add_block_to_head(txn);
-    }
-
-    auto _head = make_scoped<buf_lock_t>(buf_parent_t(txn), head_block_id,
-                                         access_t::write);
-    auto write = make_scoped<buf_write_t>(_head.get());
-    queue_block_t *head = static_cast<queue_block_t *>(write->get_data_write());
-
-    char buffer[DBQ_MAX_REF_SIZE];
-    memset(buffer, 0, DBQ_MAX_REF_SIZE);
-
-    blob_t blob(cache->max_block_size(), buffer, DBQ_MAX_REF_SIZE);
-
-    write_onto_blob(buf_parent_t(_head.get()), &blob, wm);
+void internal_disk_backed_queue_t::push_single(const write_message_t &wm) {
+    vector_stream_t stream;
+    stream.reserve(wm.size());
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    std::vector<char> value;
+    stream.swap(&value);
+    head_bytes += sizeof(uint64_t) + value.size();
+    head_values.push_back(std::move(value));
+    queue_size++;
 
-    if (static_cast<size_t>((head->data + head->data_size) - reinterpret_cast<char *>(head)) + blob.refsize(cache->max_block_size()) > cache->max_block_size().value()) {
-        // The data won't fit in our current head block, so it's time to make a new one.
-        head = nullptr;
-        write.reset();
-        _head.reset();
-        add_block_to_head(txn);
-        _head.init(new buf_lock_t(buf_parent_t(txn), head_block_id,
-                                  access_t::write));
-        write.init(new buf_write_t(_head.get()));
-        head = static_cast<queue_block_t *>(write->get_data_write());
+    if (head_bytes >= DBQ_SPILL_THRESHOLD) {
+        spill();
     }
-
-    memcpy(head->data + head->data_size, buffer,
-           blob.refsize(cache->max_block_size()));
-    head->data_size += blob.refsize(cache->max_block_size());
-
-    queue_size++;
 }
 
 void internal_disk_backed_queue_t::pop(buffer_group_viewer_t *viewer) {
     guarantee(size() != 0);
     mutex_t::acq_t mutex_acq(&mutex);
 
-    char buffer[DBQ_MAX_REF_SIZE];
-    // No need for hard durability with an unlinked dbq file.
-    txn_t txn(cache_conn.get(), write_durability_t::SOFT, 2);
-
-    buf_lock_t _tail(buf_parent_t(&txn), tail_block_id, access_t::write);
-
-    /* Grab the data from the blob and delete it. */
-    {
-        buf_read_t read(&_tail);
-        const queue_block_t *tail
-            = static_cast<const queue_block_t *>(read.get_data_read());
-        rassert(tail->data_size != tail->live_data_offset);
-        memcpy(buffer, tail->data + tail->live_data_offset,
-               blob::ref_size(cache->max_block_size(),
-                              tail->data + tail->live_data_offset,
-                              DBQ_MAX_REF_SIZE));
-    }
-
-    /* Grab the data from the blob and delete it. */
-
-    std::vector<char> data_vec;
-
-    blob_t blob(cache->max_block_size(), buffer, DBQ_MAX_REF_SIZE);
-    {
-        blob_acq_t acq_group;
-        buffer_group_t blob_group;
-        blob.expose_all(buf_parent_t(&_tail), access_t::read,
-                        &blob_group, &acq_group);
-
-        viewer->view_buffer_group(const_view(&blob_group));
-    }
-
-    int32_t data_size;
-    int32_t live_data_offset;
-    {
-        buf_write_t write(&_tail);
-        queue_block_t *tail = static_cast<queue_block_t *>(write.get_data_write());
-        /* Record how far along in the blob we are. */
-        tail->live_data_offset += blob.refsize(cache->max_block_size());
-        data_size = tail->data_size;
-        live_data_offset = tail->live_data_offset;
+    if (tail_values.empty()) {
+        if (!segments.empty() && !segments.front()->chunks.empty()) {
+            read_chunk();
+        } else {
+            // Nothing is on disk, so the oldest value is still in memory.
+            guarantee(!head_values.empty());
+            head_bytes -= sizeof(uint64_t) + head_values.front().size();
+            tail_values.push_back(std::move(head_values.front()));
+            head_values.pop_front();
+        }
     }
+    guarantee(!tail_values.empty());
 
-    blob.clear(buf_parent_t(&_tail));
-
+    std::vector<char> value = std::move(tail_values.front());
+    tail_values.pop_front();
     queue_size--;
 
-    _tail.reset_buf_lock();
-
-    /* If that was the last blob in this block move on to the next one. */
-    if (live_data_offset == data_size) {
-        remove_block_from_tail(&txn);
-    }
-
-    txn.commit();
+    buffer_group_t group;
+    group.add_buffer(value.size(), value.data());
+    viewer->view_buffer_group(const_view(&group));
 }
 
 bool internal_disk_backed_queue_t::empty() {
@@ -184,46 +95,97 @@ int64_t internal_disk_backed_queue_t::size() {
     return queue_size;
 }
 
-void internal_disk_backed_queue_t::add_block_to_head(txn_t *txn) {
-    buf_lock_t _new_head(buf_parent_t(txn), alt_create_t::create);
-    buf_write_t write(&_new_head);
-    queue_block_t *new_head = static_cast<queue_block_t *>(write.get_data_write());
-    if (head_block_id == NULL_BLOCK_ID) {
-        rassert(tail_block_id == NULL_BLOCK_ID);
-        head_block_id = tail_block_id = _new_head.block_id();
-    } else {
-        buf_lock_t _old_head(buf_parent_t(txn), head_block_id,
-                             access_t::write);
-        buf_write_t old_write(&_old_head);
-        queue_block_t *old_head
-            = static_cast<queue_block_t *>(old_write.get_data_write());
-        rassert(old_head->next == NULL_BLOCK_ID);
-        old_head->next = _new_head.block_id();
-        head_block_id = _new_head.block_id();
+void internal_disk_backed_queue_t::spill() {
+    if (head_values.empty()) {
+        return;
     }
 
-    new_head->next = NULL_BLOCK_ID;
-    new_head->data_size = 0;
-    new_head->live_data_offset = 0;
+    if (segments.empty() || segments.back()->size >= DBQ_SEGMENT_SIZE) {
+        scoped_ptr_t<segment_t> segment(new segment_t());
+        segment->path = strprintf("%s.%" PRIi64, base_path.c_str(),
+                                  next_segment_number++);
+        segment->size = 0;
+        // Segments live in the temporary directory, which is recreated when the
+        // server starts, so a crash doesn't leave them behind and there's no reason
+        // to sync them.
+        const file_open_result_t res = open_file(
+            segment->path.c_str(),
+            linux_file_t::mode_read | linux_file_t::mode_write
+                | linux_file_t::mode_create | linux_file_t::mode_truncate,
+            io_backender,
+            &segment->file);
+        if (res.outcome == file_open_result_t::ERROR) {
+            crash_due_to_inaccessible_database_file(segment->path.c_str(), res);
+        }
+        segments.push_back(std::move(segment));
+    }
+    segment_t *segment = segments.back().get();
+
+    chunk_t chunk;
+    chunk.offset = segment->size;
+    chunk.length = ceil_aligned(head_bytes, DEVICE_BLOCK_SIZE);
+    chunk.num_values = head_values.size();
+
+    // Every value is written as its size, followed by the value itself.
+    scoped_device_block_aligned_ptr_t<char> buf(chunk.length);
+    char *p = buf.get();
+    for (const std::vector<char> &value : head_values) {
+        const uint64_t value_size = value.size();
+        memcpy(p, &value_size, sizeof(value_size));
+        p += sizeof(value_size);
+        memcpy(p, value.data(), value.size());
+        p += value.size();
+    }
+    memset(p, 0, buf.get() + chunk.length - p);
+    head_values.clear();
+    head_bytes = 0;
+
+    segment->file->set_file_size_at_least(chunk.offset + chunk.length,
+                                          DBQ_SEGMENT_SIZE);
+    co_write(segment->file.get(), chunk.offset, chunk.length, buf.get(),
+             DEFAULT_DISK_ACCOUNT, datasync_op::no_datasyncs);
+    segment->size += chunk.length;
+    segment->chunks.push_back(chunk);
+    bytes_on_disk += chunk.length;
+    disk_bytes += chunk.length;
 }
 
-void internal_disk_backed_queue_t::remove_block_from_tail(txn_t *txn) {
-    rassert(tail_block_id != NULL_BLOCK_ID);
-    buf_lock_t _old_tail(buf_parent_t(txn), tail_block_id,
-                         access_t::write);
-
-    {
-        buf_write_t old_write(&_old_tail);
-        queue_block_t *old_tail = static_cast<queue_block_t *>(old_write.get_data_write());
-
-        if (old_tail->next == NULL_BLOCK_ID) {
-            rassert(head_block_id == _old_tail.block_id());
-            tail_block_id = head_block_id = NULL_BLOCK_ID;
-        } else {
-            tail_block_id = old_tail->next;
-        }
+void internal_disk_backed_queue_t::read_chunk() {
+    guarantee(!segments.empty());
+    segment_t *segment = segments.front().get();
+    guarantee(!segment->chunks.empty());
+    const chunk_t chunk = segment->chunks.front();
+    segment->chunks.pop_front();
+
+    scoped_device_block_aligned_ptr_t<char> buf(chunk.length);
+    co_read(segment->file.get(), chunk.offset, chunk.length, buf.get(),
+            DEFAULT_DISK_ACCOUNT);
+
+    const char *p = buf.get();
+    for (int64_t i = 0; i < chunk.num_values; ++i) {
+        uint64_t value_size;
+        memcpy(&value_size, p, sizeof(value_size));
+        p += sizeof(value_size);
+        guarantee(p + value_size <= buf.get() + chunk.length);
+        tail_values.push_back(std::vector<char>(p, p + value_size));
+        p += value_size;
     }
 
-    _old_tail.mark_deleted();
+    // Once a segment has been read completely, nothing refers to it anymore.  If we
+    // were still appending to it, the next spill starts a new one.
+    if (segment->chunks.empty()) {
+        delete_segment(segment);
+        segments.pop_front();
+    }
 }
 
+void internal_disk_backed_queue_t::delete_segment(segment_t *segment) {
+    bytes_on_disk -= segment->size;
+    disk_bytes -= segment->size;
+    /* First close the file, then remove it.  This avoids issues with certain file
+    systems (specifically VirtualBox shared folders), see
+    https://github.com/rethinkdb/rethinkdb/issues/3791. */
+    segment->file.reset();
+    const int res = ::unlink(segment->path.c_str());
+    guarantee_err(res == 0, "unlink() failed");
+}
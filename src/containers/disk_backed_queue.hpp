@@ -2,34 +2,22 @@
 #ifndef CONTAINERS_DISK_BACKED_QUEUE_HPP_
 #define CONTAINERS_DISK_BACKED_QUEUE_HPP_
 
+#include <deque>
 #include <string>
 #include <vector>
 
-#include "concurrency/fifo_checker.hpp"
 #include "concurrency/mutex.hpp"
 #include "containers/buffer_group.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/scoped.hpp"
-#include "perfmon/core.hpp"
-#include "serializer/types.hpp"
+#include "perfmon/perfmon.hpp"
 
-class cache_balancer_t;
-class cache_conn_t;
-class cache_t;
-class txn_t;
+class file_t;
 class io_backender_t;
 class perfmon_collection_t;
 class serializer_filepath_t;
 
-ATTR_PACKED(struct queue_block_t {
-    block_id_t next;
-    int32_t data_size, live_data_offset;
-    char data[0];
-});
-
-class value_acquisition_object_t;
-
 class buffer_group_viewer_t {
 public:
     virtual void view_buffer_group(const const_buffer_group_t *group) = 0;
@@ -41,6 +29,16 @@ protected:
     DISABLE_COPYING(buffer_group_viewer_t);
 };
 
+/* `internal_disk_backed_queue_t` is a FIFO queue of serialized values that keeps its
+newest values in memory, and appends them to a log on disk once they take up more than
+`DBQ_SPILL_THRESHOLD` bytes.  The log is split into segment files of about
+`DBQ_SEGMENT_SIZE` bytes, which get deleted as soon as everything in them has been
+popped, so a queue that keeps up doesn't grow on disk.  Values are read back one spill
+at a time, with sequential reads that release the thread while the disk works.
+
+The queue doesn't survive a restart, so unlike the serializer it doesn't need a page
+cache, an LBA or a garbage collector, and a queue that never spills never creates a
+file. */
 class internal_disk_backed_queue_t {
 public:
     internal_disk_backed_queue_t(io_backender_t *io_backender, const serializer_filepath_t& filename, perfmon_collection_t *stats_parent);
@@ -55,30 +53,59 @@ public:
 
     int64_t size();
 
+    // How many bytes the queue's segment files take up.
+    int64_t disk_size() const { return disk_bytes; }
+
 private:
-    void add_block_to_head(txn_t *txn);
-    void remove_block_from_tail(txn_t *txn);
-    void push_single(txn_t *txn, const write_message_t &value);
+    // One spill, written with a single write.  `length` is a multiple of
+    // `DEVICE_BLOCK_SIZE`.
+    struct chunk_t {
+        int64_t offset;
+        int64_t length;
+        int64_t num_values;
+    };
+
+    struct segment_t {
+        std::string path;
+        scoped_ptr_t<file_t> file;
+        int64_t size;
+        // The chunks that haven't been read back yet, oldest first.
+        std::deque<chunk_t> chunks;
+    };
+
+    void push_single(const write_message_t &value);
+    // Appends `head_values` to the log.
+    void spill();
+    // Reads the oldest chunk on disk into `tail_values`.
+    void read_chunk();
+    void delete_segment(segment_t *segment);
 
     mutex_t mutex;
 
-    // Serves more as sanity-checking for the cache than this type's ordering.
-    order_source_t cache_order_source;
+    io_backender_t *const io_backender;
+    // The segment files are named `base_path` plus their number.  It is in the
+    // temporary directory, like the serializer file this queue used to have.
+    const std::string base_path;
+
     perfmon_collection_t perfmon_collection;
     perfmon_membership_t perfmon_membership;
+    perfmon_counter_t bytes_on_disk;
+    perfmon_membership_t bytes_on_disk_membership;
+    // The same as `bytes_on_disk`, which only adds up its value for the stats.
+    int64_t disk_bytes;
 
     int64_t queue_size;
 
-    // The end we push onto.
-    block_id_t head_block_id;
-    // The end we pop from.
-    block_id_t tail_block_id;
-
-    scoped_ptr_t<serializer_file_opener_t> file_opener;
-    scoped_ptr_t<log_serializer_t> serializer;
-    scoped_ptr_t<cache_balancer_t> balancer;
-    scoped_ptr_t<cache_t> cache;
-    scoped_ptr_t<cache_conn_t> cache_conn;
+    // The values are ordered as `tail_values`, then the chunks in `segments`, then
+    // `head_values`.
+    // Values that have been read back from disk, ready to be popped.
+    std::deque<std::vector<char> > tail_values;
+    // Values that haven't been spilled yet.
+    std::deque<std::vector<char> > head_values;
+    int64_t head_bytes;
+    // The last one is the segment we append to.
+    std::deque<scoped_ptr_t<segment_t> > segments;
+    int64_t next_segment_number;
 
     DISABLE_COPYING(internal_disk_backed_queue_t);
 };
@@ -156,6 +183,10 @@ public:
         return internal_.size();
     }
 
+    int64_t disk_size() const {
+        return internal_.disk_size();
+    }
+
 private:
     internal_disk_backed_queue_t internal_;
     DISABLE_COPYING(disk_backed_queue_t);
@@ -1,8 +1,11 @@
 #ifndef CONTAINERS_RANGE_MAP_HPP_
 #define CONTAINERS_RANGE_MAP_HPP_
 
-#include <map>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
+#include "containers/archive/stl_types.hpp"
 #include "debug.hpp"
 #include "rpc/serialize_macros.hpp"
 #include "utils.hpp"
@@ -10,7 +13,12 @@
 /* `range_map_t` maps from ranges delimited by `edge_t` to values of type `value_t`. The
 ranges must be contiguous and non-overlapping; adjacent ranges with the same value will
 be automatically coalesced. It can be thought of as a more efficient way of storing a
-mapping from `edge_t` to `value_t`. */
+mapping from `edge_t` to `value_t`.
+
+The sub-ranges are kept in a vector sorted by their right edges, so a lookup is a binary
+search over contiguous memory. Maps usually have a handful of sub-ranges (a region map
+has one per shard or so) and are looked up much more often than changed, which is what
+a vector is good at. */
 template<class edge_t, class value_t>
 class range_map_t {
 public:
@@ -31,7 +39,7 @@ public:
     range_map_t(const edge_t &l, const edge_t &r, value_t &&v = value_t()) : left(l) {
         rassert(r >= l);
         if (r != l) {
-            zones.insert(std::make_pair(r, std::move(v)));
+            zones.push_back(std::make_pair(r, std::move(v)));
         }
         DEBUG_ONLY_CODE(validate());
     }
@@ -49,7 +57,7 @@ public:
     }
     const edge_t &right_edge() const {
         if (!zones.empty()) {
-            return (--zones.end())->first;
+            return zones.back().first;
         } else {
             return left;
         }
@@ -65,8 +73,7 @@ public:
     const value_t &lookup(const edge_t &before_point) const {
         rassert(before_point >= left_edge());
         rassert(before_point < right_edge());
-        auto it = zones.upper_bound(before_point);
-        return it->second;
+        return upper_bound(before_point)->second;
     }
 
     /* Calls the given callback for every sub-range from `l` to `r`. If `l` or `r` lie
@@ -82,7 +89,7 @@ public:
         if (l == r) {
             return;
         }
-        auto it = zones.upper_bound(l);
+        auto it = upper_bound(l);
         edge_t prev = l;
         while (it->first < r) {
             cb(prev, it->first, it->second);
@@ -163,6 +170,7 @@ public:
         }
         bool empty_before = empty_domain();
         zones.insert(
+            zones.end(),
             std::make_move_iterator(other.zones.begin()),
             std::make_move_iterator(other.zones.end()));
         if (!empty_before) {
@@ -180,7 +188,7 @@ public:
             return;
         }
         bool empty_before = empty_domain();
-        zones.insert(std::make_pair(r, std::move(v)));
+        zones.push_back(std::make_pair(r, std::move(v)));
         if (!empty_before) {
             coalesce_at(l);
         }
@@ -196,6 +204,7 @@ public:
         }
         bool empty_before = empty_domain();
         zones.insert(
+            zones.begin(),
             std::make_move_iterator(other.zones.begin()),
             std::make_move_iterator(other.zones.end()));
         if (!empty_before) {
@@ -211,7 +220,7 @@ public:
             return;
         }
         bool empty_before = empty_domain();
-        zones.insert(std::make_pair(r, std::move(v)));
+        zones.insert(zones.begin(), std::make_pair(r, std::move(v)));
         if (!empty_before) {
             coalesce_at(r);
         }
@@ -231,13 +240,13 @@ public:
         /* If a single existing zone spans `other.left_edge(), then split it into two
         sub-zones at `other.right_edge()`. */
         if (other.left_edge() != left) {
-            auto split_it = zones.lower_bound(other.left_edge());
+            auto split_it = lower_bound(other.left_edge());
             rassert(split_it != zones.end());
             if (split_it->first == other.left_edge()) {
                 /* no need to split anything, `other.left_edge()` lies on a boundary
                 between two existing zones */
             } else {
-                zones.insert(std::make_pair(other.left_edge(), split_it->second));
+                split_before(split_it, other.left_edge());
             }
         } else {
             /* no need to split anything, `other.left_edge()` lies on the left edge of
@@ -248,14 +257,15 @@ public:
         dealt with the left edge case above. The right edge case will take care of itself
         naturally because one of `other`'s zones will implicitly split any existing zone
         that spans `other.right_edge()`. */
-        auto end = zones.lower_bound(other.right_edge());
+        auto end = lower_bound(other.right_edge());
         if (end->first == other.right_edge()) {
             ++end;
         }
-        zones.erase(zones.upper_bound(other.left_edge()), end);
+        auto position = zones.erase(upper_bound(other.left_edge()), end);
 
-        /* Move all the zones from `other` into us */
+        /* Move all the zones from `other` into the gap */
         zones.insert(
+            position,
             std::make_move_iterator(other.zones.begin()),
             std::make_move_iterator(other.zones.end()));
 
@@ -290,11 +300,11 @@ public:
         if (l == r) {
             return;
         }
-        auto it = zones.upper_bound(l);
-        if (l != left && zones.count(l) == 0) {
+        auto it = upper_bound(l);
+        if (l != left && find(l) == zones.end()) {
             /* We need to chop off the part to the left of `l` */
-            DEBUG_VAR auto res = zones.insert(std::make_pair(l, it->second));
-            rassert(res.second);
+            it = split_before(it, l);
+            ++it;
         }
         edge_t prev = l;
         while (it->first < r) {
@@ -304,9 +314,7 @@ public:
         }
         if (it->first != r) {
             /* We need to chop off the part to the right of `r` */
-            auto res = zones.insert(std::make_pair(r, it->second));
-            rassert(res.second);
-            it = res.first;
+            it = split_before(it, r);
         }
         rassert(it->first == r);
         cb(prev, r, &it->second);
@@ -342,7 +350,7 @@ private:
     merges them if they do. `edge` must correspond to an internal boundary between two
     sub-ranges. */
     void coalesce_at(const edge_t &edge) {
-        auto before_it = zones.find(edge);
+        auto before_it = find(edge);
         rassert(before_it != zones.end());
         auto after_it = before_it;
         ++after_it;
@@ -356,7 +364,7 @@ private:
     inclusive. `l` and `r` must be boundaries of sub-ranges, but they don't necessarily
     have to be internal boundaries; they can be the overall left and right edges. */
     void coalesce_range(const edge_t &l, const edge_t &r) {
-        auto it = (l == left) ? zones.begin() : zones.find(l);
+        auto it = (l == left) ? zones.begin() : find(l);
         while (it != zones.end() && it->first <= r) {
             auto jt = it;
             ++it;
@@ -364,18 +372,62 @@ private:
                 break;
             }
             if (jt->second == it->second) {
-                zones.erase(jt);
+                it = zones.erase(jt);
             }
         }
     }
 
+    typedef typename std::vector<std::pair<edge_t, value_t> >::iterator zone_iterator_t;
+    typedef typename std::vector<std::pair<edge_t, value_t> >::const_iterator
+        const_zone_iterator_t;
+
+    /* The first zone whose right edge is after `edge`. */
+    zone_iterator_t upper_bound(const edge_t &edge) {
+        return std::upper_bound(zones.begin(), zones.end(), edge,
+            [](const edge_t &e, const std::pair<edge_t, value_t> &zone) {
+                return e < zone.first;
+            });
+    }
+    const_zone_iterator_t upper_bound(const edge_t &edge) const {
+        return std::upper_bound(zones.begin(), zones.end(), edge,
+            [](const edge_t &e, const std::pair<edge_t, value_t> &zone) {
+                return e < zone.first;
+            });
+    }
+
+    /* The first zone whose right edge isn't before `edge`. */
+    zone_iterator_t lower_bound(const edge_t &edge) {
+        return std::lower_bound(zones.begin(), zones.end(), edge,
+            [](const std::pair<edge_t, value_t> &zone, const edge_t &e) {
+                return zone.first < e;
+            });
+    }
+
+    /* The zone whose right edge is `edge`, or `zones.end()`. */
+    zone_iterator_t find(const edge_t &edge) {
+        auto it = lower_bound(edge);
+        if (it != zones.end() && !(it->first == edge)) {
+            it = zones.end();
+        }
+        return it;
+    }
+
+    /* Splits the zone at `it` at `edge`, which has to lie inside of it. Returns the
+    left part. */
+    zone_iterator_t split_before(zone_iterator_t it, const edge_t &edge) {
+        std::pair<edge_t, value_t> left_part(edge, it->second);
+        return zones.insert(it, std::move(left_part));
+    }
+
     /* Each sub-range corresponds to an entry in `zones`. The entry's key is the
     right-hand edge of the zone; the zone's left-hand edge is determined by the previous
     entry's key. The first entry's left-hand edge is stored in `left`. Every method
     coalesces adjacent zones before it returns. Sub-ranges always have non-zero width; if
-    the map has a zero-width domain then `zones` won't have any entries. */
+    the map has a zero-width domain then `zones` won't have any entries. `zones` is
+    sorted by key; it serializes the same way as a `std::map` with the same entries
+    would. */
     edge_t left;
-    std::map<edge_t, value_t> zones;
+    std::vector<std::pair<edge_t, value_t> > zones;
 };
 
 template<class E, class V>
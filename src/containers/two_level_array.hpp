@@ -21,12 +21,14 @@ about value_t:
 2. value_t has a good equality operator, where value_t() == value_t(), and
    distinguishable values don't compare equal.
 
+Memory is allocated in chunks of `CHUNK_SIZE` values, so that is also the least an
+array with any non-default values takes.
+
 */
 
-template <class value_t>
+template <class value_t, size_t CHUNK_SIZE = (1 << 14)>
 class two_level_array_t {
 private:
-    static const size_t CHUNK_SIZE = 1 << 14;
 
     struct chunk_t {
         chunk_t()
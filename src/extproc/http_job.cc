@@ -54,24 +54,28 @@ public:
     const std::string error_string;
 };
 
-class scoped_curl_handle_t {
+// The easy handle each worker process uses for all of its requests.  libcurl keeps
+// open connections, the DNS cache and TLS sessions in the handle, so requests to a
+// host we have talked to recently skip the connect and the handshake.  Cookies
+// also survive `curl_easy_reset`, so we erase them before every request.
+class reused_curl_handle_t {
 public:
-    scoped_curl_handle_t() :
-        curl_handle(curl_easy_init()) {
-    }
-
-    ~scoped_curl_handle_t() {
-        curl_easy_cleanup(curl_handle);
-    }
-
-    CURL *get() {
+    // Returns `nullptr` if the handle could not be created.
+    static CURL *get() {
+        if (curl_handle == nullptr) {
+            curl_handle = curl_easy_init();
+        } else {
+            curl_easy_reset(curl_handle);
+        }
         return curl_handle;
     }
 
 private:
-    CURL *curl_handle;
+    static CURL *curl_handle;
 };
 
+CURL *reused_curl_handle_t::curl_handle = nullptr;
+
 // Used for adding headers, which cannot be freed until after the request is done
 class scoped_curl_slist_t {
 public:
@@ -542,22 +546,24 @@ void set_default_opts(CURL *curl_handle,
 
 // TODO: implement streaming API support
 void perform_http(http_opts_t *opts, http_result_t *res_out) {
-    scoped_curl_handle_t curl_handle;
+    CURL *curl_handle = reused_curl_handle_t::get();
     curl_data_t curl_data;
 
-    if (curl_handle.get() == nullptr) {
+    if (curl_handle == nullptr) {
         res_out->error.assign("initialization");
         return;
     }
 
-    set_default_opts(curl_handle.get(), opts->proxy, curl_data);
-    transfer_opts(opts, curl_handle.get(), &curl_data);
+    set_default_opts(curl_handle, opts->proxy, curl_data);
+    // Forget the cookies of the previous request on this handle.
+    exc_setopt(curl_handle, CURLOPT_COOKIELIST, "ALL", "COOKIELIST");
+    transfer_opts(opts, curl_handle, &curl_data);
 
     CURLcode curl_res = CURLE_OK;
     long response_code = 0; // NOLINT(runtime/int)
     for (uint64_t attempts = 0; attempts < opts->attempts; ++attempts) {
         // Do the HTTP operation, then check for errors
-        curl_res = curl_easy_perform(curl_handle.get());
+        curl_res = curl_easy_perform(curl_handle);
 
         if (curl_res == CURLE_SEND_ERROR ||
             curl_res == CURLE_RECV_ERROR ||
@@ -569,7 +575,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
             return;
         }
 
-        curl_res = curl_easy_getinfo(curl_handle.get(),
+        curl_res = curl_easy_getinfo(curl_handle,
                                      CURLINFO_RESPONSE_CODE,
                                      &response_code);
 
@@ -610,7 +616,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
         res_out->error = strprintf("status code %ld", response_code);
     } else {
         parse_header(header_data, res_out);
-        save_cookies(curl_handle.get(), res_out);
+        save_cookies(curl_handle, res_out);
 
         // If this was a HEAD request, we should not be handling data, just return R_NULL
         // so the user knows the request succeeded
@@ -626,7 +632,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
             {
                 std::string content_type;
                 char *content_type_buffer = nullptr;
-                curl_easy_getinfo(curl_handle.get(),
+                curl_easy_getinfo(curl_handle,
                                   CURLINFO_CONTENT_TYPE,
                                   &content_type_buffer);
 
@@ -21,6 +21,11 @@ public:
 
     js_result_t eval(const std::string &source);
     js_result_t call(js_id_t id, const std::vector<ql::datum_t> &args);
+    // Calls the function once for every element of `args_batch` in a single round
+    // trip.  The worker stops at the first error, so the result may be shorter than
+    // `args_batch`, in which case its last element is the error.
+    std::vector<js_result_t> call_batch(
+        js_id_t id, const std::vector<std::vector<ql::datum_t> > &args_batch);
     void release(js_id_t id);
     void exit();
 
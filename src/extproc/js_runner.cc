@@ -3,6 +3,7 @@
 
 #include <inttypes.h>   // For PRIu64
 
+#include <limits>
 #include <map>
 
 #include "extproc/js_job.hpp"
@@ -225,6 +226,68 @@ js_result_t js_runner_t::call(const std::string &source,
     return result;
 }
 
+std::vector<js_result_t> js_runner_t::call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config) {
+    assert_thread();
+    guarantee(job_data.has());
+
+    // This will retrieve the function from the cache if it's there, or re-eval it
+    js_result_t fn_result = eval(source, config);
+    js_id_t *fn_id = boost::get<js_id_t>(&fn_result);
+    if (fn_id == nullptr) {
+        if (boost::get<ql::datum_t>(&fn_result) != nullptr) {
+            fn_result = strprintf("Javascript query `%s` returned a value when it "
+                                  "should have returned a function.", source.c_str());
+        }
+        return std::vector<js_result_t>(1, fn_result);
+    }
+
+    uint64_t batch_timeout_ms = config.timeout_ms;
+    if (!args_batch.empty() && config.timeout_ms
+            <= std::numeric_limits<uint64_t>::max() / args_batch.size()) {
+        batch_timeout_ms = config.timeout_ms * args_batch.size();
+    }
+
+    object_buffer_t<js_timeout_t::sentry_t> sentry;
+    sentry.create(&job_data->js_timeout, batch_timeout_ms);
+
+    std::vector<js_result_t> results;
+    bool is_timeout = false;
+    try {
+        try {
+            results = job_data->js_job.call_batch(*fn_id, args_batch);
+        } catch (...) {
+            // This inner try-catch block deals with cleanup after an exception, but due
+            // to this we must store whether we triggered the timeout signal.
+            is_timeout = job_data->js_timeout.get_signal()->is_pulsed();
+
+            // Sentry must be destroyed before the js_timeout
+            sentry.reset();
+            // This will mark the worker as errored so we don't try to re-sync with it
+            //  on the next line (since we're in a catch statement, we aren't allowed)
+            job_data->js_job.worker_error();
+            job_data.reset();
+
+            throw;
+        }
+    } catch (interrupted_exc_t const &e) {
+        // This outer try-catch block explicitly checks whether it was an
+        // `interrupted_exc_t`, and if so deals with the timeout if set.
+        if (is_timeout) {
+            return std::vector<js_result_t>(1, strprintf(
+                "JavaScript query `%s` timed out after %" PRIu64 ".%03" PRIu64
+                " seconds per row.",
+                source.c_str(), config.timeout_ms / 1000, config.timeout_ms % 1000));
+        } else {
+            throw;
+        }
+    }
+
+    return results;
+}
+
 void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     guarantee(job_data.has());
     guarantee(id != INVALID_ID);
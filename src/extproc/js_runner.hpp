@@ -57,6 +57,16 @@ public:
                      const std::vector<ql::datum_t> &args,
                      const req_config_t &config);
 
+    // Calls a previously compiled function once for every element of `args_batch`,
+    // with a single round trip to the worker.  `config.timeout_ms` applies to every
+    // call, so the whole batch gets `args_batch.size()` times as long.  An error ends
+    // the batch, so the result may be shorter than `args_batch`, in which case its
+    // last element is the error.
+    std::vector<js_result_t> call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config);
+
 private:
     static const size_t CACHE_SIZE;
 
@@ -51,6 +51,10 @@ int main(int argc, char *argv[]) {
             return main_rethinkdb_index_rebuild(argc, argv);
         } else if (subcommand == "repl") {
             return main_rethinkdb_repl(argc, argv);
+        } else if (subcommand == "export-data") {
+            return main_rethinkdb_export_data(argc, argv);
+        } else if (subcommand == "bench") {
+            return main_rethinkdb_bench(argc, argv);
 #ifdef _WIN32
         } else if (subcommand == "run-service") {
             return main_rethinkdb_run_service(argc, argv);
@@ -93,6 +97,10 @@ int main(int argc, char *argv[]) {
                     help_rethinkdb_index_rebuild();
                 } else if (subcommand2 == "repl") {
                     help_rethinkdb_repl();
+                } else if (subcommand2 == "export-data") {
+                    help_rethinkdb_export_data();
+                } else if (subcommand2 == "bench") {
+                    help_rethinkdb_bench();
 #ifdef _WIN32
                 } else if (subcommand2 == "install-service") {
                     help_rethinkdb_install_service();
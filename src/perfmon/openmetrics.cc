@@ -0,0 +1,154 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "perfmon/openmetrics.hpp"
+
+#include <inttypes.h>
+#include <math.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "containers/uuid.hpp"
+#include "utils.hpp"
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string> > labels_t;
+
+struct metric_family_t {
+    const char *type;
+    std::vector<std::string> samples;
+};
+
+// Metric families by name.  OpenMetrics wants all the samples of a family together,
+// but the samples of one metric show up once per table in the perfmon tree.
+typedef std::map<std::string, metric_family_t> families_t;
+
+std::string sanitize_name(const std::string &str) {
+    std::string res = str;
+    for (char &c : res) {
+        if (!isalnum(static_cast<unsigned char>(c))) {
+            c = '_';
+        }
+    }
+    return res;
+}
+
+std::string format_labels(const labels_t &labels) {
+    if (labels.empty()) {
+        return std::string();
+    }
+    std::string res = "{";
+    for (size_t i = 0; i < labels.size(); ++i) {
+        // The label values are table IDs and shard numbers, which never need
+        // escaping.
+        res += strprintf("%s%s=\"%s\"", i == 0 ? "" : ",",
+                         labels[i].first.c_str(), labels[i].second.c_str());
+    }
+    return res + "}";
+}
+
+std::string format_value(double value) {
+    if (value == floor(value) && fabs(value) < 9007199254740992.0) {
+        return strprintf("%" PRIi64, static_cast<int64_t>(value));
+    }
+    return strprintf("%.17g", value);
+}
+
+void add_sample(const std::string &family,
+                const char *type,
+                const std::string &sample,
+                families_t *families) {
+    metric_family_t *f = &(*families)[family];
+    f->type = type;
+    f->samples.push_back(sample);
+}
+
+bool is_histogram(const ql::datum_t &stats) {
+    ql::datum_t buckets = stats.get_field("buckets", ql::throw_bool_t::NOTHROW);
+    return buckets.has() && buckets.get_type() == ql::datum_t::R_ARRAY;
+}
+
+void add_histogram(const ql::datum_t &stats,
+                   const std::string &name,
+                   const labels_t &labels,
+                   families_t *families) {
+    static const std::pair<const char *, const char *> quantiles[] = {
+        {"p50_ms", "0.5"}, {"p90_ms", "0.9"}, {"p99_ms", "0.99"}, {"p999_ms", "0.999"}};
+
+    const std::string family = name + "_seconds";
+    for (const auto &q : quantiles) {
+        ql::datum_t value = stats.get_field(q.first, ql::throw_bool_t::NOTHROW);
+        if (!value.has() || value.get_type() != ql::datum_t::R_NUM) {
+            // The percentiles are `null` if nothing was recorded.
+            continue;
+        }
+        labels_t quantile_labels = labels;
+        quantile_labels.push_back(std::make_pair("quantile", q.second));
+        add_sample(family, "summary",
+                   family + format_labels(quantile_labels) + " "
+                       + format_value(value.as_num() / 1000.0),
+                   families);
+    }
+    ql::datum_t count = stats.get_field("count", ql::throw_bool_t::NOTHROW);
+    if (count.has() && count.get_type() == ql::datum_t::R_NUM) {
+        add_sample(family, "summary",
+                   family + "_count" + format_labels(labels) + " "
+                       + format_value(count.as_num()),
+                   families);
+    }
+}
+
+void add_stats(const ql::datum_t &stats,
+               const std::string &name,
+               const labels_t &labels,
+               families_t *families) {
+    if (stats.get_type() == ql::datum_t::R_NUM) {
+        add_sample(name, "gauge",
+                   name + format_labels(labels) + " " + format_value(stats.as_num()),
+                   families);
+    } else if (stats.get_type() == ql::datum_t::R_OBJECT) {
+        if (is_histogram(stats)) {
+            add_histogram(stats, name, labels, families);
+            return;
+        }
+        for (size_t i = 0; i < stats.obj_size(); ++i) {
+            std::pair<datum_string_t, ql::datum_t> pair = stats.get_pair(i);
+            const std::string key = pair.first.to_std();
+            uuid_u table_id;
+            uint64_t shard;
+            if (str_to_uuid(key, &table_id)) {
+                labels_t sub_labels = labels;
+                sub_labels.push_back(std::make_pair("table", key));
+                add_stats(pair.second, name, sub_labels, families);
+            } else if (key.compare(0, 6, "shard_") == 0
+                       && strtou64_strict(key.substr(6), 10, &shard)) {
+                labels_t sub_labels = labels;
+                sub_labels.push_back(std::make_pair("shard", key.substr(6)));
+                add_stats(pair.second, name, sub_labels, families);
+            } else {
+                add_stats(pair.second, name + "_" + sanitize_name(key), labels,
+                          families);
+            }
+        }
+    }
+    // Anything else (such as strings) has no number that we could export.
+}
+
+}  // namespace
+
+std::string perfmon_stats_to_openmetrics(const ql::datum_t &stats) {
+    families_t families;
+    add_stats(stats, "rethinkdb", labels_t(), &families);
+
+    std::string res;
+    for (const auto &pair : families) {
+        res += strprintf("# TYPE %s %s\n", pair.first.c_str(), pair.second.type);
+        for (const std::string &sample : pair.second.samples) {
+            res += sample;
+            res += '\n';
+        }
+    }
+    res += "# EOF\n";
+    return res;
+}
@@ -0,0 +1,16 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef PERFMON_OPENMETRICS_HPP_
+#define PERFMON_OPENMETRICS_HPP_
+
+#include <string>
+
+#include "rdb_protocol/datum.hpp"
+
+/* Renders the output of `perfmon_get_stats()` in the OpenMetrics text format, so that
+Prometheus can scrape a server without going through the `stats` table. Every number
+becomes a gauge named after its path, with the path components that are table IDs
+and shard numbers turned into `table` and `shard` labels. The output of a
+`perfmon_histogram_t` becomes a summary with its percentiles in seconds. */
+std::string perfmon_stats_to_openmetrics(const ql::datum_t &stats);
+
+#endif  // PERFMON_OPENMETRICS_HPP_
@@ -2,6 +2,7 @@
 #include "perfmon/perfmon.hpp"
 
 #include <stdarg.h>
+#include <string.h>
 
 #include <cmath>
 #include <map>
@@ -16,6 +17,8 @@ static const char *stat_per_sec = "per_sec";
 static const char *stat_count = "count";
 static const char *stat_mean = "mean";
 static const char *stat_std_dev = "std_dev";
+static const char *stat_max_ms = "max_ms";
+static const char *stat_buckets = "buckets";
 
 
 #ifdef FULL_PERFMON
@@ -302,6 +305,245 @@ ql::datum_t perfmon_rate_monitor_t::output_stat(const double &stat) {
     return ql::datum_t(stat / ticks_to_secs(length));
 }
 
+/* perfmon_keyed_rate_monitor_t */
+
+perfmon_keyed_rate_monitor_t::perfmon_keyed_rate_monitor_t(ticks_t _length)
+    : perfmon_perthread_t<std::map<uuid_u, double> >(), length(_length) { }
+
+void perfmon_keyed_rate_monitor_t::update(int64_t interval, key_info_t *info) {
+    if (info->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (info->current_interval + 1 == interval) {
+        info->last_count = info->current_count;
+        info->current_count = 0;
+        info->current_interval = interval;
+    } else {
+        info->last_count = info->current_count = 0;
+        info->current_interval = interval;
+    }
+}
+
+void perfmon_keyed_rate_monitor_t::record(const uuid_u &key, double count) {
+    int64_t interval = get_ticks().nanos / length.nanos;
+    rassert(get_thread_id().threadnum >= 0);
+    auto res = thread_data[get_thread_id().threadnum].value.insert(
+        std::make_pair(key, key_info_t()));
+    if (res.second) {
+        res.first->second.current_interval = interval;
+    }
+    update(interval, &res.first->second);
+    res.first->second.current_count += count;
+}
+
+void perfmon_keyed_rate_monitor_t::get_thread_stat(
+        std::map<uuid_u, double> *stat) {
+    ticks_t now = get_ticks();
+    int64_t interval = now.nanos / length.nanos;
+    double ratio = 1.0 - (static_cast<double>(now.nanos % length.nanos) / length.nanos);
+
+    std::map<uuid_u, key_info_t> *keys =
+        &thread_data[get_thread_id().threadnum].value;
+    for (auto it = keys->begin(); it != keys->end();) {
+        update(interval, &it->second);
+        if (it->second.current_count == 0 && it->second.last_count == 0) {
+            keys->erase(it++);
+        } else {
+            (*stat)[it->first] =
+                it->second.current_count + it->second.last_count * ratio;
+            ++it;
+        }
+    }
+}
+
+std::map<uuid_u, double> perfmon_keyed_rate_monitor_t::combine_stats(
+        const std::map<uuid_u, double> *stats) {
+    std::map<uuid_u, double> total;
+    for (int i = 0; i < get_num_threads(); i++) {
+        for (const auto &pair : stats[i]) {
+            total[pair.first] += pair.second;
+        }
+    }
+    return total;
+}
+
+ql::datum_t perfmon_keyed_rate_monitor_t::output_stat(
+        const std::map<uuid_u, double> &stat) {
+    ql::datum_object_builder_t builder;
+    for (const auto &pair : stat) {
+        builder.overwrite(uuid_to_str(pair.first).c_str(),
+                          ql::datum_t(pair.second / ticks_to_secs(length)));
+    }
+    return std::move(builder).to_datum();
+}
+
+/* perfmon_histogram_t */
+
+size_t perfmon_histogram::bucket_index(uint64_t value) {
+    value = std::min(value, (uint64_t(1) << max_value_bits) - 1);
+    if (value < (uint64_t(1) << sub_bucket_bits)) {
+        return value;
+    }
+    int top_bit = 63 - __builtin_clzll(value);
+    int shift = top_bit - sub_bucket_bits;
+    uint64_t sub_bucket = (value >> shift) & ((uint64_t(1) << sub_bucket_bits) - 1);
+    return (static_cast<size_t>(shift + 1) << sub_bucket_bits) + sub_bucket;
+}
+
+uint64_t perfmon_histogram::bucket_upper_bound(size_t index) {
+    rassert(index < num_buckets);
+    if (index < (size_t(1) << sub_bucket_bits)) {
+        return index;
+    }
+    int shift = static_cast<int>(index >> sub_bucket_bits) - 1;
+    uint64_t sub_bucket = index & ((size_t(1) << sub_bucket_bits) - 1);
+    uint64_t lower_bound = ((uint64_t(1) << sub_bucket_bits) + sub_bucket) << shift;
+    return lower_bound + (uint64_t(1) << shift) - 1;
+}
+
+perfmon_histogram::stats_t::stats_t() : count(0), max(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void perfmon_histogram::stats_t::record(uint64_t value) {
+    ++count;
+    max = std::max(max, value);
+    ++buckets[bucket_index(value)];
+}
+
+void perfmon_histogram::stats_t::aggregate(const stats_t &s) {
+    count += s.count;
+    max = std::max(max, s.max);
+    for (size_t i = 0; i < num_buckets; ++i) {
+        buckets[i] += s.buckets[i];
+    }
+}
+
+void perfmon_histogram::stats_t::aggregate_datum(const ql::datum_t &datum) {
+    if (!datum.has() || datum.get_type() != ql::datum_t::R_OBJECT) {
+        return;
+    }
+    ql::datum_t max_ms = datum.get_field(stat_max_ms, ql::throw_bool_t::NOTHROW);
+    if (max_ms.has() && max_ms.get_type() == ql::datum_t::R_NUM) {
+        max = std::max(max, static_cast<uint64_t>(max_ms.as_num() * 1000));
+    }
+    ql::datum_t pairs = datum.get_field(stat_buckets, ql::throw_bool_t::NOTHROW);
+    if (!pairs.has() || pairs.get_type() != ql::datum_t::R_ARRAY) {
+        return;
+    }
+    for (size_t i = 0; i < pairs.arr_size(); ++i) {
+        ql::datum_t pair = pairs.get(i);
+        if (pair.get_type() != ql::datum_t::R_ARRAY || pair.arr_size() != 2
+            || pair.get(0).get_type() != ql::datum_t::R_NUM
+            || pair.get(1).get_type() != ql::datum_t::R_NUM) {
+            continue;
+        }
+        double index = pair.get(0).as_num();
+        if (index < 0 || index >= num_buckets) {
+            continue;
+        }
+        uint64_t n = static_cast<uint64_t>(pair.get(1).as_num());
+        buckets[static_cast<size_t>(index)] += n;
+        count += n;
+    }
+}
+
+uint64_t perfmon_histogram::stats_t::percentile(double fraction) const {
+    guarantee(count != 0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(fraction * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < num_buckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // `max` is exact, so it's a better bound for the last bucket.
+            return std::min(bucket_upper_bound(i), max);
+        }
+    }
+    return max;
+}
+
+ql::datum_t perfmon_histogram::stats_t::to_datum(bool include_buckets) const {
+    static const std::pair<const char *, double> percentiles[] = {
+        {"p50_ms", 0.5}, {"p90_ms", 0.9}, {"p99_ms", 0.99}, {"p999_ms", 0.999}};
+
+    ql::datum_object_builder_t builder;
+    builder.overwrite(stat_count, ql::datum_t(static_cast<double>(count)));
+    for (const auto &p : percentiles) {
+        builder.overwrite(p.first, count != 0
+            ? ql::datum_t(percentile(p.second) / 1000.0)
+            : ql::datum_t::null());
+    }
+    builder.overwrite(stat_max_ms, count != 0
+        ? ql::datum_t(max / 1000.0)
+        : ql::datum_t::null());
+
+    if (include_buckets) {
+        ql::datum_array_builder_t pairs(ql::configured_limits_t::unlimited);
+        for (size_t i = 0; i < num_buckets; ++i) {
+            if (buckets[i] != 0) {
+                pairs.add(ql::datum_t(std::vector<ql::datum_t>{
+                    ql::datum_t(static_cast<double>(i)),
+                    ql::datum_t(static_cast<double>(buckets[i]))},
+                    ql::configured_limits_t::unlimited));
+            }
+        }
+        builder.overwrite(stat_buckets, std::move(pairs).to_datum());
+    }
+    return std::move(builder).to_datum();
+}
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length)
+    : perfmon_perthread_t<stats_t>(), length(_length) { }
+
+void perfmon_histogram_t::update(thread_info_t *thread, ticks_t now) {
+    int64_t interval = now.nanos / length.nanos;
+    if (thread->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread->current_interval + 1 == interval) {
+        /* We're one step behind */
+        thread->last_stats = thread->current_stats;
+        thread->current_stats = stats_t();
+        thread->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread->last_stats = thread->current_stats = stats_t();
+        thread->current_interval = interval;
+    }
+}
+
+void perfmon_histogram_t::record(uint64_t value) {
+    rassert(get_thread_id().threadnum >= 0);
+    std::unique_ptr<thread_info_t> *thread = &thread_data[get_thread_id().threadnum];
+    ticks_t now = get_ticks();
+    if (!*thread) {
+        thread->reset(new thread_info_t);
+        (*thread)->current_interval = now.nanos / length.nanos;
+    }
+    update(thread->get(), now);
+    (*thread)->current_stats.record(value);
+}
+
+void perfmon_histogram_t::get_thread_stat(stats_t *stat) {
+    rassert(get_thread_id().threadnum >= 0);
+    thread_info_t *thread = thread_data[get_thread_id().threadnum].get();
+    if (thread != nullptr) {
+        update(thread, get_ticks());
+        /* Like `perfmon_sampler_t`, we return the last complete interval. */
+        *stat = thread->last_stats;
+    }
+}
+
+perfmon_histogram::stats_t perfmon_histogram_t::combine_stats(const stats_t *stats) {
+    stats_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+ql::datum_t perfmon_histogram_t::output_stat(const stats_t &aggregated) {
+    return aggregated.to_datum(true);
+}
+
 perfmon_duration_sampler_t::perfmon_duration_sampler_t(ticks_t length, bool _ignore_global_full_perfmon)
     : stat(), active(), total(), recent(length, true),
       active_membership(&stat, &active, "active_count"),
@@ -16,6 +16,7 @@
 
 #include "concurrency/cache_line_padded.hpp"
 #include "config/args.hpp"
+#include "containers/uuid.hpp"
 #include "perfmon/types.hpp"
 #include "perfmon/core.hpp"
 #include "time.hpp"
@@ -215,6 +216,123 @@ public:
     void record(double value = 1.0);
 };
 
+/* `perfmon_keyed_rate_monitor_t` is like `perfmon_rate_monitor_t`, but it keeps a
+ * separate rate for every UUID (such as a table ID) that events are recorded for.
+ * Its output is an object that maps each UUID to its rate per second. UUIDs that
+ * haven't seen any events for two intervals are forgotten, so it is meant for a
+ * modest number of them. The UUIDs are only turned into strings when the stats are
+ * collected, so that recording an event stays cheap.
+ */
+class perfmon_keyed_rate_monitor_t
+    : public perfmon_perthread_t<std::map<uuid_u, double> > {
+private:
+    struct key_info_t {
+        double current_count, last_count;
+        int64_t current_interval;
+
+        key_info_t() : current_count(0), last_count(0), current_interval(0) { }
+    };
+
+    cache_line_padded_t<std::map<uuid_u, key_info_t> > thread_data[MAX_THREADS];
+    void update(int64_t interval, key_info_t *info);
+    ticks_t length;
+
+    void get_thread_stat(std::map<uuid_u, double> *);
+    std::map<uuid_u, double> combine_stats(const std::map<uuid_u, double> *);
+    ql::datum_t output_stat(const std::map<uuid_u, double> &);
+public:
+    explicit perfmon_keyed_rate_monitor_t(ticks_t length);
+    void record(const uuid_u &key, double value = 1.0);
+};
+
+/* `perfmon_histogram_t` counts how many recorded values fall into each of a set of
+ * logarithmically spaced buckets, so that it can report percentiles (such as the
+ * p99 latency) without keeping the values themselves. Like `perfmon_sampler_t`, it
+ * reports on the last complete interval of `length` ticks. The values are meant to
+ * be durations in microseconds; the output is in milliseconds.
+ *
+ * The output also contains the non-empty buckets, so that the histograms of several
+ * servers can be combined with `perfmon_histogram::stats_t::aggregate_datum()`.
+ */
+namespace perfmon_histogram {
+
+/* Values below `2^sub_bucket_bits` have a bucket of their own. Above that, the range
+of each power of two is split into `2^sub_bucket_bits` buckets, so a bucket's bounds
+are within 1/8th of each other. Values of `2^max_value_bits` or more (which is more
+than twelve days in microseconds) go into the last bucket. */
+static const int sub_bucket_bits = 3;
+static const int max_value_bits = 40;
+static const size_t num_buckets =
+    static_cast<size_t>(max_value_bits - sub_bucket_bits + 1) << sub_bucket_bits;
+
+size_t bucket_index(uint64_t value);
+// The largest value that goes into the bucket with index `index`.
+uint64_t bucket_upper_bound(size_t index);
+
+struct stats_t {
+    stats_t();
+    void record(uint64_t value);
+    void aggregate(const stats_t &s);
+
+    // Adds the buckets from the output of a `perfmon_histogram_t`. Ignores anything
+    // that doesn't look like such output.
+    void aggregate_datum(const ql::datum_t &datum);
+
+    // An upper bound for the value that `fraction` of the values are less than or
+    // equal to. `count` must not be zero.
+    uint64_t percentile(double fraction) const;
+
+    // With `include_buckets` false, this only has the count and the percentiles.
+    ql::datum_t to_datum(bool include_buckets) const;
+
+    uint64_t count;
+    uint64_t max;
+    uint64_t buckets[num_buckets];
+};
+
+}   /* namespace perfmon_histogram */
+
+class perfmon_histogram_t : public perfmon_perthread_t<perfmon_histogram::stats_t> {
+    typedef perfmon_histogram::stats_t stats_t;
+    struct thread_info_t {
+        stats_t current_stats, last_stats;
+        int64_t current_interval;
+    };
+
+    /* The `thread_info_t`s are big, so each thread only allocates its own once it
+    records something. */
+    std::unique_ptr<thread_info_t> thread_data[MAX_THREADS];
+
+    void get_thread_stat(stats_t *);
+    stats_t combine_stats(const stats_t *);
+    ql::datum_t output_stat(const stats_t &);
+
+    void update(thread_info_t *thread, ticks_t now);
+
+    ticks_t length;
+public:
+    explicit perfmon_histogram_t(ticks_t _length = secs_to_ticks(10));
+    void record(uint64_t value);
+    // Records the time since `start` in microseconds.
+    void record_since(ticks_t start) {
+        record((get_ticks().nanos - start.nanos) / 1000);
+    }
+};
+
+/* Records the time from its construction to its destruction. */
+class perfmon_histogram_timer_t {
+public:
+    explicit perfmon_histogram_timer_t(perfmon_histogram_t *_histogram)
+        : histogram(_histogram), start(get_ticks()) { }
+    ~perfmon_histogram_timer_t() {
+        histogram->record_since(start);
+    }
+private:
+    perfmon_histogram_t *histogram;
+    ticks_t start;
+    DISABLE_COPYING(perfmon_histogram_timer_t);
+};
+
 /* perfmon_duration_sampler_t is a perfmon_t that monitors events that have a
  * starting and ending time. When something starts, call begin(); when
  * something ends, call end() with the same value as begin. It will produce
@@ -961,6 +961,8 @@ static void pprint_update_reminder() {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
     case Term::UNION:
@@ -164,21 +164,26 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(ignore_write_hook_t,
 //    hard durability.
 //  - DURABILITY_REQUIREMENT_SOFT: Override the table's durability settings with
 //    soft durability.
+//  - DURABILITY_REQUIREMENT_GROUP: Override the table's durability settings with
+//    group durability.
 enum durability_requirement_t { DURABILITY_REQUIREMENT_DEFAULT,
                                 DURABILITY_REQUIREMENT_HARD,
-                                DURABILITY_REQUIREMENT_SOFT };
+                                DURABILITY_REQUIREMENT_SOFT,
+                                DURABILITY_REQUIREMENT_GROUP };
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(durability_requirement_t,
                                       int8_t,
                                       DURABILITY_REQUIREMENT_DEFAULT,
-                                      DURABILITY_REQUIREMENT_SOFT);
+                                      DURABILITY_REQUIREMENT_GROUP);
 
-enum class read_mode_t { MAJORITY, SINGLE, OUTDATED, DEBUG_DIRECT };
+/* `BOUNDED` reads go to any replica that is at most `read_t::max_staleness_ms` behind
+the primary, and to the primary if there is no such replica. */
+enum class read_mode_t { MAJORITY, SINGLE, OUTDATED, DEBUG_DIRECT, BOUNDED };
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(read_mode_t,
                                       int8_t,
                                       read_mode_t::MAJORITY,
-                                      read_mode_t::DEBUG_DIRECT);
+                                      read_mode_t::BOUNDED);
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         reql_version_t, int8_t,
@@ -188,6 +193,10 @@ enum class emergency_repair_mode_t { DEBUG_RECOMMIT,
                                      UNSAFE_ROLLBACK,
                                      UNSAFE_ROLLBACK_OR_ERASE };
 
+/* Whether `rebalance()` divides the documents evenly, or a mix of documents and recent
+load. */
+enum class rebalance_mode_t { DOCUMENTS, LOAD };
+
 /* `backfill_item_memory_tracker_t` is used by the backfilling logic to control the
 memory usage on the backfill sender. It is updated whenever a key/value pair is
 loaded, or a new backfill_item_t structure is allocated. */
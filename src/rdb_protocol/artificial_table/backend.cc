@@ -35,7 +35,8 @@ bool artificial_table_backend_t::read_all_rows_filtered(
 
     /* Fetch the rows from the backend */
     std::vector<ql::datum_t> rows;
-    if (!read_all_rows_as_vector(user_context, interruptor, &rows, error_out)) {
+    if (!read_rows_in_datumspec(user_context, datumspec, interruptor, &rows,
+                                error_out)) {
         return false;
     }
 
@@ -78,6 +79,15 @@ bool artificial_table_backend_t::read_all_rows_filtered(
     return true;
 }
 
+bool artificial_table_backend_t::read_rows_in_datumspec(
+        auth::user_context_t const &user_context,
+        UNUSED const ql::datumspec_t &datumspec,
+        signal_t *interruptor,
+        std::vector<ql::datum_t> *rows_out,
+        admin_err_t *error_out) {
+    return read_all_rows_as_vector(user_context, interruptor, rows_out, error_out);
+}
+
 bool artificial_table_backend_t::read_all_rows_filtered_as_stream(
         auth::user_context_t const &user_context,
         ql::backtrace_id_t bt,
@@ -36,8 +36,8 @@ public:
     change. This must not block. */
     virtual std::string get_primary_key_name() = 0;
 
-    // Returns the full dataset in a vector (in `rows_out`) after applying the filtering
-    // and sorting specified by `datumspec` and `sorting`.
+    // Returns the rows in `datumspec` in a vector (in `rows_out`), sorted as specified
+    // by `sorting`.
     bool read_all_rows_filtered(
         auth::user_context_t const &user_context,
         const ql::datumspec_t &datumspec,
@@ -104,6 +104,17 @@ private:
         std::vector<ql::datum_t> *rows_out,
         admin_err_t *error_out) = 0;
 
+    /* `read_all_rows_filtered()` reads its rows with `read_rows_in_datumspec()`, which
+    may leave out the rows whose primary keys aren't in `datumspec`, but must not return
+    a row twice. Backends that build their rows one at a time can override it to only
+    build the rows that were asked for. The default calls `read_all_rows_as_vector()`. */
+    virtual bool read_rows_in_datumspec(
+        auth::user_context_t const &user_context,
+        const ql::datumspec_t &datumspec,
+        signal_t *interruptor,
+        std::vector<ql::datum_t> *rows_out,
+        admin_err_t *error_out);
+
     name_string_t m_table_name;
     uuid_u m_table_id;
     rdb_context_t *m_rdb_context;
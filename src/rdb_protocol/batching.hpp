@@ -46,6 +46,8 @@ public:
         seen_one_el = true;
         els_left -= 1;
         min_els_left -= 1;
+        // Rows that are backed by a buffer, or that have been measured before, don't
+        // get walked here (see `datum_serialized_size()`).
         size_left -= serialized_size<cluster_version_t::CLUSTER>(t);
         return should_send_batch();
     }
@@ -65,6 +67,8 @@ public:
                 0};
     }
     batch_type_t get_batch_type() { return batch_type; }
+    // How many more elements fit in the batch before `should_send_batch()`.
+    int64_t get_els_left() const { return els_left; }
 private:
     DISABLE_COPYING(batcher_t);
     friend class batchspec_t;
@@ -4,11 +4,13 @@
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "btree/concurrent_traversal.hpp"
+#include "btree/depth_first_traversal.hpp"
 #include "btree/get_distribution.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
@@ -21,6 +23,7 @@
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/buffer_stream.hpp"
 #include "containers/scoped.hpp"
+#include "random.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
@@ -135,13 +138,17 @@ void kv_location_delete(keyvalue_location_t *kv_location,
             deletion_context->balancing_detacher(), &null_cb, delete_mode);
 }
 
+// If `copy_stored_value` is true, `mod_info_out->added.first` is set to a datum that
+// is backed by a copy of the serialized value, which is cheaper to serialize again for
+// secondary indexes and changefeeds.  Otherwise it's set to `data`.
 MUST_USE ql::serialization_result_t
 kv_location_set(keyvalue_location_t *kv_location,
                 const store_key_t &key,
                 ql::datum_t data,
                 repli_timestamp_t timestamp,
                 const deletion_context_t *deletion_context,
-                rdb_modification_info_t *mod_info_out) THROWS_NOTHING {
+                rdb_modification_info_t *mod_info_out,
+                bool copy_stored_value) THROWS_NOTHING {
     scoped_malloc_t<rdb_value_t> new_value(blob::btree_maxreflen);
     memset(new_value.get(), 0, blob::btree_maxreflen);
 
@@ -150,11 +157,17 @@ kv_location_set(keyvalue_location_t *kv_location,
         blob_t blob(block_size, new_value->value_ref(), blob::btree_maxreflen);
         ql::serialization_result_t res
             = datum_serialize_onto_blob(buf_parent_t(&kv_location->buf),
-                                        &blob, data);
+                                        &blob, data,
+                                        mod_info_out != nullptr && copy_stored_value
+                                            ? &mod_info_out->added.first
+                                            : nullptr);
         if (bad(res)) return res;
     }
 
     if (mod_info_out) {
+        if (!copy_stored_value) {
+            mod_info_out->added.first = data;
+        }
         guarantee(mod_info_out->added.second.empty());
         mod_info_out->added.second.assign(new_value->value_ref(),
             new_value->value_ref() + new_value->inline_size(block_size));
@@ -209,9 +222,70 @@ kv_location_set(keyvalue_location_t *kv_location,
     return ql::serialization_result_t::SUCCESS;
 }
 
+// An update that changes a few fields of a big document often leaves its serialized
+// size the same, for example when it changes a number.  Then we write the new value
+// over the old value's blob, which only dirties the blob blocks that actually change,
+// instead of writing a whole new blob and deleting the old one.  That's only safe
+// while no secondary index shares the blob's blocks, because the old version of the
+// value is gone as soon as we're done.  Returns false, having done nothing, if the
+// value can't be overwritten.  Otherwise `*res_out` is set like the return value of
+// `kv_location_set()`.
+static bool kv_location_overwrite(keyvalue_location_t *kv_location,
+                                  const store_key_t &key,
+                                  const ql::datum_t &data,
+                                  repli_timestamp_t timestamp,
+                                  const deletion_context_t *deletion_context,
+                                  rdb_modification_info_t *mod_info_out,
+                                  ql::serialization_result_t *res_out) {
+    if (!kv_location->value.has()) {
+        return false;
+    }
+    const max_block_size_t block_size = kv_location->buf.cache()->max_block_size();
+    rdb_value_t *value = kv_location->value_as<rdb_value_t>();
+    blob_t blob(block_size, value->value_ref(), blob::btree_maxreflen);
+    // The size is usually cached in `data`, which makes this check cheap.
+    if (blob::ref_info(block_size, value->value_ref(), blob::btree_maxreflen).levels == 0
+        || datum_serialized_size(data, ql::check_datum_serialization_errors_t::NO)
+           != static_cast<size_t>(blob.valuesize())) {
+        return false;
+    }
+
+    write_message_t wm;
+    *res_out = datum_serialize(&wm, data, ql::check_datum_serialization_errors_t::YES);
+    if (bad(*res_out)) {
+        return true;
+    }
+    guarantee(static_cast<int64_t>(wm.size()) == blob.valuesize());
+    counted_t<shared_buf_t> buf = flatten_write_message(&wm);
+    blob.overwrite_changed_blocks(buf->data(), buf_parent_t(&kv_location->buf));
+
+    if (mod_info_out != nullptr) {
+        // `deleted.second` stays empty, since the new value now owns the old blocks.
+        guarantee(mod_info_out->added.second.empty());
+        mod_info_out->added.second.assign(value->value_ref(),
+            value->value_ref() + value->inline_size(block_size));
+        mod_info_out->added.first = data.get_buf_ref() != nullptr
+            ? data
+            : ql::datum_deserialize_from_buf(
+                shared_buf_ref_t<char>(std::move(buf), 0), 0);
+    }
+
+    // The value ref doesn't change, but the leaf still needs the new timestamp.
+    null_key_modification_callback_t null_cb;
+    rdb_value_sizer_t sizer(block_size);
+    apply_keyvalue_change(&sizer, kv_location, key.btree_key(),
+                          timestamp,
+                          deletion_context->balancing_detacher(), &null_cb,
+                          delete_mode_t::REGULAR_QUERY);
+    *res_out = ql::serialization_result_t::SUCCESS;
+    return true;
+}
+
 batched_replace_response_t rdb_replace_and_return_superblock(
     const btree_loc_info_t &info,
     const btree_point_replacer_t *replacer,
+    bool has_sindexes,
+    bool has_changefeeds,
     const deletion_context_t *deletion_context,
     promise_t<superblock_t *> *superblock_promise,
     rdb_modification_info_t *mod_info_out,
@@ -269,10 +343,17 @@ batched_replace_response_t rdb_replace_and_return_superblock(
                                    mod_info_out);
             } else {
                 r_sanity_check(new_val.get_field(primary_key, ql::NOTHROW).has());
-                ql::serialization_result_t res =
-                    kv_location_set(&kv_location, *info.key, new_val,
-                                    info.btree->timestamp, deletion_context,
-                                    mod_info_out);
+                ql::serialization_result_t res;
+                if (has_sindexes
+                    || !kv_location_overwrite(&kv_location, *info.key, new_val,
+                                              info.btree->timestamp,
+                                              deletion_context, mod_info_out,
+                                              &res)) {
+                    res = kv_location_set(&kv_location, *info.key, new_val,
+                                          info.btree->timestamp, deletion_context,
+                                          mod_info_out,
+                                          has_sindexes || has_changefeeds);
+                }
                 if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
                     rfail_typed_target(&new_val, "Array too large for disk writes "
                                        "(limit 100,000 elements).");
@@ -285,14 +366,17 @@ batched_replace_response_t rdb_replace_and_return_superblock(
 
             /* Report the changes for sindex and change-feed purposes */
             if (old_val.get_type() != ql::datum_t::R_NULL) {
-                guarantee(!mod_info_out->deleted.second.empty());
+                // `kv_location_overwrite()` leaves `deleted.second` empty.
+                guarantee(!mod_info_out->deleted.second.empty() || !has_sindexes);
                 mod_info_out->deleted.first = old_val;
             } else {
                 guarantee(mod_info_out->deleted.second.empty());
             }
             if (new_val.get_type() != ql::datum_t::R_NULL) {
+                // `kv_location_set()` has set `added.first`, to a buffer-backed copy
+                // of `new_val` if secondary indexes or changefeeds will use it.
                 guarantee(!mod_info_out->added.second.empty());
-                mod_info_out->added.first = new_val;
+                guarantee(mod_info_out->added.first.has());
             } else {
                 guarantee(mod_info_out->added.second.empty());
             }
@@ -395,13 +479,11 @@ void do_a_replace_from_batched_replace(
     const fifo_enforcer_write_token_t &batched_replaces_fifo_token,
     const btree_loc_info_t &info,
     const one_replace_t one_replace,
-    const ql::configured_limits_t &limits,
     promise_t<superblock_t *> *superblock_promise,
     rdb_modification_report_cb_t *mod_cb,
     bool update_pkey_cfeeds,
-    batched_replace_response_t *stats_out,
-    profile::trace_t *trace,
-    std::set<std::string> *conditions) {
+    ql::datum_t *result_out,
+    profile::trace_t *trace) {
 
     fifo_enforcer_sink_t::exit_write_t exiter(
         batched_replaces_fifo_sink, batched_replaces_fifo_token);
@@ -412,10 +494,10 @@ void do_a_replace_from_batched_replace(
 
     rdb_live_deletion_context_t deletion_context;
     rdb_modification_report_t mod_report(*info.key);
-    ql::datum_t res = rdb_replace_and_return_superblock(
-        info, &one_replace, &deletion_context, superblock_promise, &mod_report.info,
-        trace);
-    *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
+    *result_out = rdb_replace_and_return_superblock(
+        info, &one_replace, mod_cb->has_sindexes(),
+        mod_cb->has_changefeeds(*info.key), &deletion_context,
+        superblock_promise, &mod_report.info, trace);
 
     // We wait to make sure we acquire `acq` in the same order we were
     // originally called.
@@ -469,9 +551,23 @@ batched_replace_response_t rdb_batched_replace(
         // write operations depending on the presence of limit changefeeds.
         scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
         bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds(keys);
+        // Every replace descends from the superblock on its own, so we apply them in
+        // key order.  Keys that land in the same leaf then follow each other down the
+        // same path, whose blocks the previous replace has just pulled into the
+        // cache, and they queue up behind each other's write locks instead of
+        // contending all over the tree.  The sort is stable so that replaces of the
+        // same key still happen in the order in which they were given, and the
+        // results get merged in that order as well.
+        std::vector<size_t> key_order(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            key_order[i] = i;
+        }
+        std::stable_sort(key_order.begin(), key_order.end(),
+            [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+        std::vector<ql::datum_t> results(keys.size());
         {
             auto_drainer_t drainer;
-            for (size_t i = 0; i < keys.size(); ++i) {
+            for (size_t i : key_order) {
                 promise_t<superblock_t *> superblock_promise;
                 coro_queue.push(
                     std::bind(
@@ -481,13 +577,11 @@ batched_replace_response_t rdb_batched_replace(
                         source.enter_write(),
                         btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
                         one_replace_t(replacer, i),
-                        limits,
                         &superblock_promise,
                         sindex_cb,
                         update_pkey_cfeeds,
-                        &stats,
-                        trace,
-                        &conditions));
+                        &results[i],
+                        trace));
                 current_superblock.init(
                     static_cast<real_superblock_t *>(superblock_promise.wait()));
             }
@@ -501,6 +595,9 @@ batched_replace_response_t rdb_batched_replace(
             guarantee(current_superblock.has());
             sindex_cb->finish(info.slice, current_superblock.get());
         }
+        for (const ql::datum_t &res : results) {
+            stats = stats.merge(res, ql::stats_merge, limits, &conditions);
+        }
     }
 
     ql::datum_object_builder_t out(stats);
@@ -539,7 +636,7 @@ void rdb_set(const store_key_t &key,
     if (overwrite || !had_value) {
         ql::serialization_result_t res =
             kv_location_set(&kv_location, key, data, timestamp, deletion_context,
-                            mod_info);
+                            mod_info, true);
         if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
             rfail_typed_target(&data, "Array too large for disk writes "
                                "(limit 100,000 elements).");
@@ -729,12 +826,66 @@ public:
             skey_left,
             std::move(waiter));
     }
+    // Range reads tend to touch every block once, so we don't want them to push the
+    // working set of point reads out of the cache.  Blocks that get read again
+    // still end up being treated as hot.
+    virtual page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::streaming;
+    }
+    virtual bool prefetch_children() THROWS_NOTHING {
+        return true;
+    }
 private:
     rget_cb_t *cb;
     size_t copies;
     optional<std::string> skey_left;
 };
 
+// Used for `get_all` on the primary index.  Rather than descending from the superblock
+// once for every key, we traverse the range from the first to the last key once and
+// skip the subtrees and leaf entries that hold none of the keys, so keys that share a
+// leaf are all read while it's acquired once.
+class rget_key_set_cb_wrapper_t : public concurrent_traversal_callback_t {
+public:
+    rget_key_set_cb_wrapper_t(
+            rget_cb_t *_cb,
+            const std::map<store_key_t, uint64_t> *_keys)
+        : cb(_cb), keys(_keys) { }
+    virtual void filter_range(
+            const btree_key_t *left_excl_or_null,
+            const btree_key_t *right_incl,
+            bool *skip_out) {
+        auto it = left_excl_or_null == nullptr
+            ? keys->begin()
+            : keys->upper_bound(store_key_t(left_excl_or_null));
+        *skip_out = it == keys->end()
+            || btree_key_cmp(it->first.btree_key(), right_incl) > 0;
+    }
+    virtual void filter_key(const btree_key_t *key, bool *skip_out) {
+        *skip_out = keys->count(store_key_t(key)) == 0;
+    }
+    virtual continue_bool_t handle_pair(
+        scoped_key_value_t &&keyvalue,
+        concurrent_traversal_fifo_enforcer_signal_t waiter)
+        THROWS_ONLY(interrupted_exc_t) {
+        auto it = keys->find(store_key_t(keyvalue.key()));
+        guarantee(it != keys->end());
+        return cb->handle_pair(
+            std::move(keyvalue),
+            it->second,
+            r_nullopt,
+            std::move(waiter));
+    }
+    // Unlike range reads, these don't read every block between the keys, so neither
+    // the streaming hint nor prefetching the next children would help.  But the
+    // leaves that hold the keys can all be loaded at once, in the order they are in
+    // the file, instead of one after the other as the traversal gets to them.
+    virtual bool prefetch_wanted_children() THROWS_NOTHING { return true; }
+private:
+    rget_cb_t *cb;
+    const std::map<store_key_t, uint64_t> *keys;
+};
+
 rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
                      job_data_t &&_job,
                      optional<rget_sindex_data_t> &&_sindex)
@@ -790,6 +941,7 @@ continue_bool_t rget_cb_t::handle_pair(
     // Count stats whether or not we deserialize the value
     io.slice->stats.pm_keys_read.record();
     io.slice->stats.pm_total_keys_read += 1;
+    ++io.response->rows_scanned;
     // We only load the value if we actually use it (`count` does not).
     if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
         val = row.get();
@@ -1043,33 +1195,15 @@ void rdb_rget_slice(
     direction_t direction = reversed(sorting) ? BACKWARD : FORWARD;
     continue_bool_t cont = continue_bool_t::CONTINUE;
     if (primary_keys.has_value()) {
-        auto cb = [&](const std::pair<store_key_t, uint64_t> &pair, bool is_last) {
-            rget_cb_wrapper_t wrapper(&callback, pair.second, r_nullopt);
-            return btree_concurrent_traversal(
+        if (!primary_keys->empty()) {
+            rget_key_set_cb_wrapper_t wrapper(&callback, &*primary_keys);
+            cont = btree_concurrent_traversal(
                 superblock,
-                key_range_t::one_key(pair.first),
+                key_range_t(key_range_t::closed, primary_keys->begin()->first,
+                            key_range_t::closed, primary_keys->rbegin()->first),
                 &wrapper,
                 direction,
-                is_last ? release_superblock : release_superblock_t::KEEP);
-        };
-        if (!reversed(sorting)) {
-            for (auto it = primary_keys->begin(); it != primary_keys->end();) {
-                auto this_it = it++;
-                if (cb(*this_it, it == primary_keys->end()) == continue_bool_t::ABORT) {
-                    // If required the superblock will get released further up the stack.
-                    cont = continue_bool_t::ABORT;
-                    break;
-                }
-            }
-        } else {
-            for (auto it = primary_keys->rbegin(); it != primary_keys->rend();) {
-                auto this_it = it++;
-                if (cb(*this_it, it == primary_keys->rend()) == continue_bool_t::ABORT) {
-                    // If required the superblock will get released further up the stack.
-                    cont = continue_bool_t::ABORT;
-                    break;
-                }
-            }
+                release_superblock);
         }
     } else {
         rget_cb_wrapper_t wrapper(&callback, 1, r_nullopt);
@@ -1277,6 +1411,135 @@ void rdb_distribution_get(int max_depth,
     }
 }
 
+// `rdb_sample_get()` splits the range into smaller ranges at the keys of the internal
+// nodes down to the depth where the ranges have about `SAMPLE_MIN_RANGE_ROWS` rows, so
+// it never has to read the leaves to do that.  It stops earlier once there are
+// `SAMPLE_RANGES_PER_ROW` ranges for each requested row.
+static const int SAMPLE_MAX_DEPTH = 8;
+static const int64_t SAMPLE_MIN_RANGE_ROWS = 1000;
+static const size_t SAMPLE_RANGES_PER_ROW = 64;
+// With fewer ranges than this per row, we pick the rows from all the rows instead.
+static const size_t SAMPLE_MIN_RANGES_PER_ROW = 4;
+
+/* Picks `n` of the rows it gets with reservoir sampling. */
+class sample_reservoir_cb_t : public depth_first_traversal_callback_t {
+public:
+    sample_reservoir_cb_t(size_t _n, rng_t *_rng, std::vector<ql::datum_t> *_rows_out)
+        : n(_n), rng(_rng), rows_seen(0), first_row(_rows_out->size()),
+          rows_out(_rows_out) { }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue,
+                                signal_t *interruptor) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        ++rows_seen;
+        // We only load the rows that we keep.
+        size_t index = rows_seen <= n ? rows_seen - 1 : rng->randuint64(rows_seen);
+        if (index < n) {
+            ql::datum_t row = get_data(
+                static_cast<const rdb_value_t *>(keyvalue.value()),
+                buf_parent_t(keyvalue.expose_buf()));
+            if (first_row + index == rows_out->size()) {
+                rows_out->push_back(std::move(row));
+            } else {
+                (*rows_out)[first_row + index] = std::move(row);
+            }
+        }
+        return continue_bool_t::CONTINUE;
+    }
+
+private:
+    size_t n;
+    rng_t *rng;
+    uint64_t rows_seen;
+    size_t first_row;
+    std::vector<ql::datum_t> *rows_out;
+};
+
+void rdb_sample_get(real_superblock_t *superblock,
+                    const key_range_t &range,
+                    size_t n,
+                    signal_t *interruptor,
+                    sample_read_response_t *response) {
+    response->rows.clear();
+    response->estimated_rows = 0;
+
+    int64_t key_count = 0;
+    std::vector<store_key_t> splits;
+    for (int depth = 1; depth <= SAMPLE_MAX_DEPTH; ++depth) {
+        std::vector<store_key_t> keys;
+        get_btree_key_distribution(superblock, depth, &key_count, &keys,
+                                   release_superblock_t::KEEP);
+        const bool got_deeper = keys.size() > splits.size();
+        splits = std::move(keys);
+        if (!got_deeper
+            || key_count / static_cast<int64_t>(splits.size() + 1)
+                < SAMPLE_MIN_RANGE_ROWS
+            || splits.size() >= SAMPLE_RANGES_PER_ROW * n) {
+            break;
+        }
+    }
+    const size_t total_ranges = splits.size() + 1;
+
+    // The ranges are split at the keys inside `range`.
+    std::sort(splits.begin(), splits.end());
+    std::vector<store_key_t> lefts;
+    lefts.push_back(range.left);
+    for (const store_key_t &key : splits) {
+        if (key > lefts.back() && range.contains_key(key)) {
+            lefts.push_back(key);
+        }
+    }
+    response->estimated_rows = std::max<int64_t>(key_count, 0)
+        * lefts.size() / total_ranges;
+
+    if (n == 0) {
+        return;
+    }
+    rng_t rng;
+    if (lefts.size() >= SAMPLE_MIN_RANGES_PER_ROW * n) {
+        // The ranges have about the same number of rows, so picking one row from
+        // each of `n` different ranges gives every row the same chance.  Ranges can
+        // be empty after deletions, so we try further ranges in random order until
+        // we have `n` rows, and we only give up once we've tried
+        // `SAMPLE_MIN_RANGES_PER_ROW` ranges per row.
+        std::vector<size_t> order(lefts.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        const size_t max_tries = SAMPLE_MIN_RANGES_PER_ROW * n;
+        for (size_t tries = 0;
+             tries < max_tries && response->rows.size() < n;
+             ++tries) {
+            std::swap(order[tries],
+                      order[tries + rng.randsize(order.size() - tries)]);
+            const size_t i = order[tries];
+            key_range_t subrange = range;
+            subrange.left = lefts[i];
+            if (i + 1 < lefts.size()) {
+                subrange.right = key_range_t::right_bound_t(lefts[i + 1]);
+            }
+            sample_reservoir_cb_t cb(1, &rng, &response->rows);
+            btree_depth_first_traversal(superblock, subrange, &cb, access_t::read,
+                                        FORWARD, release_superblock_t::KEEP,
+                                        interruptor);
+        }
+    }
+    if (response->rows.size() < n) {
+        // Either there are too few ranges, or too many of them were empty, so we
+        // pick the rows from all the rows instead.
+        response->rows.clear();
+        sample_reservoir_cb_t cb(n, &rng, &response->rows);
+        btree_depth_first_traversal(superblock, range, &cb, access_t::read, FORWARD,
+                                    release_superblock_t::KEEP, interruptor);
+    }
+    // Reservoir sampling doesn't put the rows in random order.
+    for (size_t i = response->rows.size(); i > 1; --i) {
+        std::swap(response->rows[i - 1], response->rows[rng.randsize(i)]);
+    }
+}
+
 static const int8_t HAS_VALUE = 0;
 static const int8_t HAS_NO_VALUE = 1;
 
@@ -1336,6 +1599,14 @@ rdb_modification_report_cb_t::rdb_modification_report_cb_t(
 
 rdb_modification_report_cb_t::~rdb_modification_report_cb_t() { }
 
+bool rdb_modification_report_cb_t::has_sindexes() const {
+    return !sindexes_.empty();
+}
+
+bool rdb_modification_report_cb_t::has_changefeeds(const store_key_t &key) {
+    return store_->changefeed_server(key).first != nullptr;
+}
+
 bool rdb_modification_report_cb_t::has_pkey_cfeeds(
     const std::vector<store_key_t> &keys) {
     const store_key_t *min = nullptr, *max = nullptr;
@@ -1436,6 +1707,7 @@ void rdb_modification_report_cb_t::on_mod_report(
         }
         keys_available_cond.wait_lazily_unordered();
         if (cserver.first != nullptr) {
+            perfmon_histogram_timer_t timer(&store_->write_changefeed_latency);
             cserver.first->send_all(
                 ql::changefeed::msg_t(
                     ql::changefeed::msg_t::change_t{
@@ -1459,6 +1731,7 @@ void rdb_modification_report_cb_t::on_mod_report_sub(
     cond_t *done_cond,
     index_vals_t *cfeed_old_keys_out,
     index_vals_t *cfeed_new_keys_out) {
+    const ticks_t start_time = get_ticks();
     store_->sindex_queue_push(mod_report, spot);
     rdb_live_deletion_context_t deletion_context;
     rdb_update_sindexes(store_,
@@ -1470,6 +1743,9 @@ void rdb_modification_report_cb_t::on_mod_report_sub(
                         cfeed_old_keys_out,
                         cfeed_new_keys_out);
     guarantee(keys_available_cond->is_pulsed());
+    if (!sindexes_.empty()) {
+        store_->write_sindex_latency.record_since(start_time);
+    }
     done_cond->pulse();
 }
 
@@ -1663,7 +1939,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_2:
     case cluster_version_t::v2_3:
     case cluster_version_t::v2_4:
-    case cluster_version_t::v2_5_is_latest:
+    case cluster_version_t::v2_5:
+    case cluster_version_t::v2_6_is_latest:
         success = deserialize_reql_version(
                 &read_stream,
                 &info_out->mapping_version_info.original_reql_version,
@@ -1701,7 +1978,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_2: // fallthru
     case cluster_version_t::v2_3: // fallthru
     case cluster_version_t::v2_4: // fallthru
-    case cluster_version_t::v2_5_is_latest:
+    case cluster_version_t::v2_5: // fallthru
+    case cluster_version_t::v2_6_is_latest:
         success = deserialize_for_version(cluster_version, &read_stream, &info_out->geo);
         throw_if_bad_deserialization(success, "sindex description");
         break;
@@ -1770,15 +2048,70 @@ void rdb_update_single_sindex(
 
     auto cserver = store->changefeed_server(modification->primary_key);
 
+    // If the secondary index is being deleted, we don't add any new values to
+    // the sindex tree.
+    // This is so we don't race against any sindex erase about who is faster
+    // (we with inserting new entries, or the erase with removing them).
+    const bool sindex_is_being_deleted = sindex->sindex.being_deleted;
+
+    // We compute both sets of keys before touching the tree, so that keys shared by
+    // the old and the new row don't have to be deleted first.  `kv_location_set()`
+    // replaces the value that's there, and the value has to be replaced even if the
+    // key didn't change, because sindex entries hold a copy of the row.
+    bool has_old_keys = false;
+    std::vector<std::pair<store_key_t, ql::datum_t> > old_keys;
     if (modification->info.deleted.first.has()) {
         guarantee(!modification->info.deleted.second.empty());
         try {
-            ql::datum_t deleted = modification->info.deleted.first;
+            compute_keys(
+                modification->primary_key, modification->info.deleted.first,
+                sindex_info, &old_keys, cfeed_old_keys_out);
+            has_old_keys = true;
+        } catch (const ql::base_exc_t &) {
+            // Do nothing (it wasn't actually in the index).
+            old_keys.clear();
+            guarantee(cfeed_old_keys_out == nullptr || cfeed_old_keys_out->size() == 0);
+        }
+    }
 
-            std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+    bool has_new_keys = false;
+    std::vector<std::pair<store_key_t, ql::datum_t> > new_keys;
+    if (!sindex_is_being_deleted && modification->info.added.first.has()) {
+        try {
             compute_keys(
-                modification->primary_key, deleted, sindex_info,
-                &keys, cfeed_old_keys_out);
+                modification->primary_key, modification->info.added.first,
+                sindex_info, &new_keys, cfeed_new_keys_out);
+            has_new_keys = true;
+        } catch (const ql::base_exc_t &) {
+            // Do nothing (we just drop the row from the index).
+            new_keys.clear();
+            guarantee(cfeed_new_keys_out == nullptr || cfeed_new_keys_out->size() == 0);
+        }
+    }
+
+    if (keys_available_cond != nullptr) {
+        guarantee(*updates_left > 0);
+        if (--*updates_left == 0) {
+            keys_available_cond->pulse();
+        }
+    }
+
+    std::set<store_key_t> new_key_set;
+    for (const auto &pair : new_keys) {
+        new_key_set.insert(pair.first);
+    }
+    std::set<store_key_t> old_key_set;
+    for (const auto &pair : old_keys) {
+        old_key_set.insert(pair.first);
+    }
+    // If neither the keys nor the serialized row changed, the index already holds
+    // exactly what we would write.
+    const bool unchanged = has_old_keys && has_new_keys
+        && old_key_set == new_key_set
+        && modification->info.deleted.second == modification->info.added.second;
+
+    if (has_old_keys && !unchanged) {
+        try {
             if (cserver.first != nullptr) {
                 cserver.first->foreach_limit(
                     make_optional(sindex->name.name),
@@ -1790,12 +2123,16 @@ void rdb_update_single_sindex(
                         ql::changefeed::limit_manager_t *lm) {
                         guarantee(clients_spot->read_signal()->is_pulsed());
                         guarantee(limit_clients_spot->read_signal()->is_pulsed());
-                        for (const auto &pair : keys) {
+                        for (const auto &pair : old_keys) {
                             lm->del(lm_spot, pair.first, is_primary_t::NO);
                         }
                     }, cserver.second);
             }
-            for (auto it = keys.begin(); it != keys.end(); ++it) {
+            for (const store_key_t &key : old_key_set) {
+                if (new_key_set.count(key) != 0) {
+                    // Overwritten below.
+                    continue;
+                }
                 promise_t<superblock_t *> return_superblock_local;
                 {
                     keyvalue_location_t kv_location;
@@ -1804,7 +2141,7 @@ void rdb_update_single_sindex(
                     find_keyvalue_location_for_write(
                         &sizer,
                         superblock,
-                        it->first.btree_key(),
+                        key.btree_key(),
                         repli_timestamp_t::distant_past,
                         deletion_context->balancing_detacher(),
                         &kv_location,
@@ -1814,7 +2151,7 @@ void rdb_update_single_sindex(
                     if (kv_location.value.has()) {
                         kv_location_delete(
                             &kv_location,
-                            it->first,
+                            key,
                             repli_timestamp_t::distant_past,
                             deletion_context,
                             delete_mode_t::REGULAR_QUERY,
@@ -1827,34 +2164,12 @@ void rdb_update_single_sindex(
             }
         } catch (const ql::base_exc_t &) {
             // Do nothing (it wasn't actually in the index).
-
-            // See comment in `catch` below.
-            guarantee(cfeed_old_keys_out == nullptr || cfeed_old_keys_out->size() == 0);
         }
     }
 
-    // If the secondary index is being deleted, we don't add any new values to
-    // the sindex tree.
-    // This is so we don't race against any sindex erase about who is faster
-    // (we with inserting new entries, or the erase with removing them).
-    const bool sindex_is_being_deleted = sindex->sindex.being_deleted;
-    if (!sindex_is_being_deleted && modification->info.added.first.has()) {
-        bool decremented_updates_left = false;
+    if (has_new_keys && !unchanged) {
         try {
             ql::datum_t added = modification->info.added.first;
-
-            std::vector<std::pair<store_key_t, ql::datum_t> > keys;
-
-            compute_keys(
-                modification->primary_key, added, sindex_info,
-                &keys, cfeed_new_keys_out);
-            if (keys_available_cond != nullptr) {
-                guarantee(*updates_left > 0);
-                decremented_updates_left = true;
-                if (--*updates_left == 0) {
-                    keys_available_cond->pulse();
-                }
-            }
             if (cserver.first != nullptr) {
                 cserver.first->foreach_limit(
                     make_optional(sindex->name.name),
@@ -1866,13 +2181,13 @@ void rdb_update_single_sindex(
                         ql::changefeed::limit_manager_t *lm) {
                         guarantee(clients_spot->read_signal()->is_pulsed());
                         guarantee(limit_clients_spot->read_signal()->is_pulsed());
-                        for (const auto &pair :keys) {
+                        for (const auto &pair : new_keys) {
                             lm->add(lm_spot, pair.first, is_primary_t::NO,
                                     pair.second, added);
                         }
                     }, cserver.second);
             }
-            for (auto it = keys.begin(); it != keys.end(); ++it) {
+            for (const store_key_t &key : new_key_set) {
                 promise_t<superblock_t *> return_superblock_local;
                 {
                     keyvalue_location_t kv_location;
@@ -1881,7 +2196,7 @@ void rdb_update_single_sindex(
                     find_keyvalue_location_for_write(
                         &sizer,
                         superblock,
-                        it->first.btree_key(),
+                        key.btree_key(),
                         repli_timestamp_t::distant_past,
                         deletion_context->balancing_detacher(),
                         &kv_location,
@@ -1889,7 +2204,7 @@ void rdb_update_single_sindex(
                         &return_superblock_local);
 
                     ql::serialization_result_t res =
-                        kv_location_set(&kv_location, it->first,
+                        kv_location_set(&kv_location, key,
                                         modification->info.added.second,
                                         repli_timestamp_t::distant_past,
                                         deletion_context);
@@ -1901,29 +2216,9 @@ void rdb_update_single_sindex(
                     return_superblock_local.wait());
             }
         } catch (const ql::base_exc_t &) {
-            // Do nothing (we just drop the row from the index).
-
-            // If we've decremented `updates_left` already, that means we might
-            // have sent a change with new values for this key even though we're
-            // actually dropping the row.  I *believe* that this catch statement
-            // can only be triggered by an exception thrown from `compute_keys`
-            // (which begs the question of why so many other statements are
-            // inside of it), so this guarantee should never trip.
-            if (keys_available_cond != nullptr) {
-                guarantee(!decremented_updates_left);
-                guarantee(cfeed_new_keys_out->size() == 0);
-                guarantee(*updates_left > 0);
-                if (--*updates_left == 0) {
-                    keys_available_cond->pulse();
-                }
-            }
-        }
-    } else {
-        if (keys_available_cond != nullptr) {
-            guarantee(*updates_left > 0);
-            if (--*updates_left == 0) {
-                keys_available_cond->pulse();
-            }
+            // The keys for this row have already been handed to the changefeed, so we
+            // must not drop the row here.  Only `compute_keys` throws, though.
+            guarantee(keys_available_cond == nullptr);
         }
     }
 
@@ -2004,8 +2299,10 @@ void rdb_update_sindexes(
     }
 
     /* All of the sindex have been updated now it's time to actually clear the
-     * deleted blob if it exists. */
-    if (modification->info.deleted.first.has()) {
+     * deleted blob if it exists.  (It doesn't if `kv_location_overwrite()` wrote the
+     * new value over it.) */
+    if (modification->info.deleted.first.has()
+        && !modification->info.deleted.second.empty()) {
         deletion_context->post_deleter()->delete_value(buf_parent_t(txn),
                 modification->info.deleted.second.data());
     }
@@ -2034,12 +2331,21 @@ public:
     }
 
     ~post_construct_traversal_helper_t() {
-        sindexes_.clear();
         if (wtxn_.has()) {
+            // If we got interrupted, the index is going to be cleaned up later anyway.
+            if (!interruptor_->is_pulsed() && !on_indexes_deleted_->is_pulsed()) {
+                new_mutex_acq_t wtxn_acq(&wtxn_lock_);
+                flush_pending_entries(&wtxn_acq);
+            }
+            sindexes_.clear();
             wtxn_->commit();
         }
     }
 
+    page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::streaming;
+    }
+
     continue_bool_t handle_pair(
             scoped_key_value_t &&keyvalue,
             concurrent_traversal_fifo_enforcer_signal_t waiter)
@@ -2058,32 +2364,42 @@ public:
         const store_key_t primary_key(keyvalue.key());
         const rdb_value_t *rdb_value =
             static_cast<const rdb_value_t *>(keyvalue.value());
-        rdb_modification_report_t mod_report(primary_key);
         const max_block_size_t block_size =
             keyvalue.expose_buf().cache()->max_block_size();
-        mod_report.info.added
-            = std::make_pair(
-                get_data(rdb_value, buf_parent_t(keyvalue.expose_buf())),
-                std::vector<char>(rdb_value->value_ref(),
-                    rdb_value->value_ref() + rdb_value->inline_size(block_size)));
+        const ql::datum_t doc =
+            get_data(rdb_value, buf_parent_t(keyvalue.expose_buf()));
+        const std::vector<char> value(
+            rdb_value->value_ref(),
+            rdb_value->value_ref() + rdb_value->inline_size(block_size));
+
+        // We evaluate the index functions before we get the mutex, so that the
+        // traversal's coroutines don't have to wait for each other to do that.
+        std::vector<std::pair<uuid_u, std::vector<store_key_t> > > keys;
+        for (const auto &pair : sindex_infos_) {
+            std::vector<std::pair<store_key_t, ql::datum_t> > index_keys;
+            try {
+                compute_keys(primary_key, doc, pair.second, &index_keys, nullptr);
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (we just drop the row from the index).
+                continue;
+            }
+            keys.emplace_back(pair.first, std::vector<store_key_t>());
+            for (auto &&index_key : index_keys) {
+                keys.back().second.push_back(std::move(index_key.first));
+            }
+        }
 
-        // Store the value into the secondary indexes
+        // Queue up the index entries, which get written at the end of the chunk.
         {
-            // We need this mutex because we don't want `wtxn` to be destructed,
-            // but also because only one coroutine can be traversing the indexes
-            // through `rdb_update_sindexes` at a time (or else the btree will get
-            // corrupted!).
+            // We need this mutex because we don't want `wtxn` to be destructed.
             new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
             guarantee(wtxn_.has());
-            const rdb_post_construction_deletion_context_t deletion_context;
-            rdb_update_sindexes(store_,
-                                sindexes_,
-                                &mod_report,
-                                wtxn_.get(),
-                                &deletion_context,
-                                nullptr,
-                                nullptr,
-                                nullptr);
+            for (auto &&pair : keys) {
+                auto *entries = &pending_entries_[pair.first];
+                for (auto &&key : pair.second) {
+                    entries->emplace_back(std::move(key), value);
+                }
+            }
         }
 
         // Account for the sindex writes in the stats
@@ -2092,8 +2408,9 @@ public:
 
         // Update the traversed range boundary (everything below here will happen in
         // key order).
-        // This can't be interrupted, because we have already called rdb_update_sindexes,
-        // so now we /must/ update traversed_right_bound.
+        // This can't be interrupted, because we have already queued the row's index
+        // entries in `pending_entries_`, and they get written when the chunk ends.
+        // So now we /must/ update traversed_right_bound.
         waiter.wait();
         traversed_right_bound_ = primary_key;
 
@@ -2105,6 +2422,7 @@ public:
             ++current_chunk_size_;
             if (current_chunk_size_ >= MAX_CHUNK_SIZE) {
                 current_chunk_size_ = 0;
+                flush_pending_entries(&wtxn_acq);
                 sindexes_.clear();
                 wtxn_->commit();
                 wtxn_.reset();
@@ -2135,6 +2453,55 @@ private:
     // Also see the comment above `scoped_ptr_t<txn_t> wtxn;` below.
     static const int MAX_CHUNK_SIZE = 32;
 
+    // Writes the entries in `pending_entries_` into the indexes.  Only one coroutine
+    // can be traversing the indexes at a time (or else the btree will get corrupted!),
+    // so this must be called with `wtxn_lock_` held.
+    void flush_pending_entries(new_mutex_acq_t *wtxn_acq) {
+        wtxn_acq->guarantee_is_holding(&wtxn_lock_);
+        const rdb_post_construction_deletion_context_t deletion_context;
+        for (auto &&access : sindexes_) {
+            auto it = pending_entries_.find(access->sindex.id);
+            if (it == pending_entries_.end()) {
+                continue;
+            }
+            // The traversal goes through the primary keys in order, but the index
+            // keys of a chunk are all over the place.  Writing them in order means
+            // that consecutive writes mostly go to the same leaf nodes.
+            std::sort(it->second.begin(), it->second.end(),
+                [](const std::pair<store_key_t, std::vector<char> > &a,
+                   const std::pair<store_key_t, std::vector<char> > &b) {
+                    return a.first < b.first;
+                });
+            superblock_t *superblock = access->superblock.get();
+            for (const auto &entry : it->second) {
+                promise_t<superblock_t *> return_superblock_local;
+                {
+                    keyvalue_location_t kv_location;
+                    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+                    find_keyvalue_location_for_write(
+                        &sizer,
+                        superblock,
+                        entry.first.btree_key(),
+                        repli_timestamp_t::distant_past,
+                        deletion_context.balancing_detacher(),
+                        &kv_location,
+                        nullptr,
+                        &return_superblock_local);
+
+                    ql::serialization_result_t res =
+                        kv_location_set(&kv_location, entry.first, entry.second,
+                                        repli_timestamp_t::distant_past,
+                                        &deletion_context);
+                    // this particular context cannot fail AT THE MOMENT.
+                    guarantee(!bad(res));
+                    // The keyvalue location gets destroyed here.
+                }
+                superblock = return_superblock_local.wait();
+            }
+        }
+        pending_entries_.clear();
+    }
+
     void start_write_transaction(new_mutex_acq_t *wtxn_acq) {
         wtxn_acq->guarantee_is_holding(&wtxn_lock_);
         guarantee(!wtxn_.has());
@@ -2182,11 +2549,18 @@ private:
             on_indexes_deleted_->pulse_if_not_already_pulsed();
         }
 
-        // We pretend that the indexes have been fully constructed, so that when we call
-        // `rdb_update_sindexes` above, it actually updates the range we're currently
-        // constructing. This is a bit hacky, but works.
+        // Deserializing the index functions is expensive, so we only do it once per
+        // index rather than once per row.
         for (auto &&access : sindexes_) {
-            access->sindex.needs_post_construction_range = key_range_t::empty();
+            if (sindex_infos_.count(access->sindex.id) == 0) {
+                sindex_disk_info_t *info = &sindex_infos_[access->sindex.id];
+                try {
+                    deserialize_sindex_info_or_crash(
+                        access->sindex.opaque_definition, info);
+                } catch (const archive_exc_t &e) {
+                    crash("%s", e.what());
+                }
+            }
         }
     }
 
@@ -2213,8 +2587,15 @@ private:
     scoped_ptr_t<txn_t> wtxn_;
     store_t::sindex_access_vector_t sindexes_;
     int current_chunk_size_;
-    // Controls access to `sindexes_` and `wtxn_`.
+    // The index entries of the current chunk that we haven't written yet.
+    std::map<uuid_u, std::vector<std::pair<store_key_t, std::vector<char> > > >
+        pending_entries_;
+    // Controls access to `sindexes_`, `wtxn_` and `pending_entries_`.
     new_mutex_t wtxn_lock_;
+
+    // The definitions of the indexes we're constructing.  We also keep the ones of
+    // indexes that got deleted in the meantime, but we don't write to those.
+    std::map<uuid_u, sindex_disk_info_t> sindex_infos_;
 };
 
 void post_construct_secondary_index_range(
@@ -203,6 +203,13 @@ void rdb_distribution_get(int max_depth,
                           real_superblock_t *superblock,
                           distribution_read_response_t *response);
 
+/* Picks up to `n` rows of `range` at random.  Doesn't release the superblock. */
+void rdb_sample_get(real_superblock_t *superblock,
+                    const key_range_t &range,
+                    size_t n,
+                    signal_t *interruptor,
+                    sample_read_response_t *response);
+
 /* Secondary Indexes */
 
 struct rdb_modification_info_t {
@@ -307,6 +314,12 @@ public:
                        new_mutex_in_line_t *sindex_spot,
                        rwlock_in_line_t *stamp_spot);
     bool has_pkey_cfeeds(const std::vector<store_key_t> &keys);
+    // Whether the table has any secondary indexes, including ones that are still
+    // being constructed.  Holding the sindex block keeps the answer from changing.
+    bool has_sindexes() const;
+    // Whether the shard that `key` is in has a changefeed server, which changes to
+    // the row may have to be sent to.
+    bool has_changefeeds(const store_key_t &key);
     void finish(btree_slice_t *btree, real_superblock_t *superblock);
 
 private:
@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/store.hpp"  // NOLINT(build/include_order)
 
+#include <algorithm>  // NOLINT(build/include_order)
 #include <functional>  // NOLINT(build/include_order)
 
 #include "arch/runtime/coroutines.hpp"
@@ -92,11 +93,26 @@ store_t::store_t(const region_t &_region,
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      latency_membership(&perfmon_collection,
+                         &read_latency, "read_latency",
+                         &write_latency, "write_latency",
+                         &write_superblock_latency, "write_superblock_latency",
+                         &write_btree_latency, "write_btree_latency",
+                         &write_sindex_latency, "write_sindex_latency",
+                         &write_changefeed_latency, "write_changefeed_latency",
+                         &write_commit_latency, "write_commit_latency"),
       ctx(_ctx),
       table_id(_table_id),
       write_superblock_acq_semaphore(WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT)
+#ifndef NDEBUG
+      , checked_metainfo_generation(0)
+#endif
 {
     cache.init(new cache_t(serializer, balancer, &perfmon_collection, which_cpu_shard));
+    // Table scans, changefeeds with initial values and backfills would otherwise
+    // flush the working set out of the cache.  Tables override this with
+    // `--cache-eviction-policy`.
+    cache->configure_eviction_policy(eviction_policy_t::scan_resistant);
     general_cache_conn.init(new cache_conn_t(cache.get()));
 
     if (create) {
@@ -191,17 +207,38 @@ void store_t::read(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    perfmon_histogram_timer_t timer(&read_latency);
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> superblock;
 
     acquire_superblock_for_read(token, &txn, &superblock,
                                 interruptor,
                                 _read.use_snapshot());
-    DEBUG_ONLY_CODE(metainfo->visit(
-        superblock.get(), metainfo_checker.region, metainfo_checker.callback));
+    DEBUG_ONLY_CODE(check_metainfo(metainfo_checker, superblock.get()));
     protocol_read(_read, response, superblock.get(), interruptor);
 }
 
+#ifndef NDEBUG
+void store_t::check_metainfo(const metainfo_checker_t &metainfo_checker,
+                             real_superblock_t *superblock) {
+    if (metainfo_checker.callback) {
+        metainfo->visit(superblock, metainfo_checker.region, metainfo_checker.callback);
+        return;
+    }
+    // Most reads only need the metainfo to cover their region, which can't have
+    // changed unless the metainfo has.
+    const uint64_t generation = metainfo->get_generation(superblock);
+    if (generation == checked_metainfo_generation
+            && region_is_superset(checked_metainfo_region, metainfo_checker.region)) {
+        return;
+    }
+    metainfo->visit(superblock, metainfo_checker.region,
+        [](const region_t &, const binary_blob_t &) { });
+    checked_metainfo_generation = generation;
+    checked_metainfo_region = metainfo_checker.region;
+}
+#endif
+
 void store_t::write(
         DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
         const region_map_t<binary_blob_t>& new_metainfo,
@@ -214,15 +251,19 @@ void store_t::write(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    // Declared before `txn`, so that this includes waiting for the txn to commit.
+    perfmon_histogram_timer_t timer(&write_latency);
 
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> real_superblock;
     // We assume one block per document, plus changes to the stats block and superblock.
     const int expected_change_count = 2 + _write.expected_document_changes();
+    const ticks_t start_time = get_ticks();
     acquire_superblock_for_write(expected_change_count, durability, token,
                                  &txn, &real_superblock, interruptor);
-    DEBUG_ONLY_CODE(metainfo->visit(
-        real_superblock.get(), metainfo_checker.region, metainfo_checker.callback));
+    const ticks_t superblock_time = get_ticks();
+    write_superblock_latency.record_since(start_time);
+    DEBUG_ONLY_CODE(check_metainfo(metainfo_checker, real_superblock.get()));
     metainfo->update(real_superblock.get(), new_metainfo);
     try {
         protocol_write(_write, response, timestamp, &real_superblock, interruptor);
@@ -235,8 +276,23 @@ void store_t::write(
         txn->commit();
         throw;
     }
+    const ticks_t btree_time = get_ticks();
+    write_btree_latency.record_since(superblock_time);
     real_superblock.reset();
     txn->commit();
+    write_commit_latency.record_since(btree_time);
+
+    if (_write.profile == profile_bool_t::PROFILE) {
+        // `protocol_write()` only profiles the btree stage.  Its event log ends with
+        // the `stop_t` of this shard's parallel task, so the commit goes before that.
+        profile::event_log_t *log = &response->event_log;
+        rassert(!log->empty());
+        log->insert(log->begin(), profile::sample_t(
+            "Wait for the superblock.",
+            ticks_t{superblock_time.nanos - start_time.nanos}, 1));
+        log->insert(log->end() - 1, profile::sample_t(
+            "Commit the write.", ticks_t{get_ticks().nanos - btree_time.nanos}, 1));
+    }
 }
 
 void store_t::reset_data(
@@ -252,12 +308,22 @@ void store_t::reset_data(
     // Erase the data in small chunks
     always_true_key_tester_t key_tester;
     const uint64_t max_erased_per_pass = 100;
+    // Without secondary indexes we neither load the values nor collect modification
+    // reports, so a pass is much cheaper and we can erase more keys in each.
+    const uint64_t max_erased_per_pass_without_sindexes = 1000;
+    // We only find out whether there are secondary indexes once we have the
+    // superblock, so we size each transaction by what the previous pass found.  The
+    // first pass assumes that there are some.
+    bool had_sindexes = true;
     for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
          done_erasing == continue_bool_t::CONTINUE;) {
         scoped_ptr_t<txn_t> txn;
         scoped_ptr_t<real_superblock_t> superblock;
 
-        const int expected_change_count = 2 + max_erased_per_pass;
+        const uint64_t max_erased = had_sindexes
+            ? max_erased_per_pass
+            : max_erased_per_pass_without_sindexes;
+        const int expected_change_count = 2 + max_erased;
         write_token_t token;
         new_write_token(&token);
         acquire_superblock_for_write(expected_change_count,
@@ -275,6 +341,11 @@ void store_t::reset_data(
         an inconsistent state. */
         cond_t non_interruptor;
 
+        std::map<sindex_name_t, secondary_index_t> secondary_indexes;
+        get_secondary_indexes(&sindex_block, &secondary_indexes);
+        const bool has_sindexes = !secondary_indexes.empty();
+        had_sindexes = has_sindexes;
+
         rdb_live_deletion_context_t deletion_context;
         std::vector<rdb_modification_report_t> mod_reports;
         key_range_t deleted_range;
@@ -284,8 +355,11 @@ void store_t::reset_data(
                                              superblock.get(),
                                              &deletion_context,
                                              &non_interruptor,
-                                             max_erased_per_pass,
-                                             &mod_reports,
+                                             has_sindexes
+                                                 ? std::min(max_erased,
+                                                            max_erased_per_pass)
+                                                 : max_erased,
+                                             has_sindexes ? &mod_reports : nullptr,
                                              &deleted_range);
 
         region_t deleted_region(subregion.beg, subregion.end, deleted_range);
@@ -347,11 +421,13 @@ std::map<std::string, std::pair<sindex_config_t, sindex_status_t> > store_t::sin
             res->second.progress_numerator = 0.0;
             res->second.progress_denominator = 0.0;
             res->second.start_time = -1;
+            res->second.rows_constructed = 0;
         } else {
             res->second.ready = false;
             res->second.progress_numerator = get_sindex_progress(pair.second.id);
             res->second.progress_denominator = 1.0;
             res->second.start_time = get_sindex_start_time(pair.second.id);
+            res->second.rows_constructed = get_sindex_rows_constructed(pair.second.id);
         }
     }
 
@@ -613,7 +689,7 @@ double store_t::get_sindex_progress(uuid_u const &id) {
     if (iterator == sindex_context.end()) {
         return 0.0;
     } else {
-        return *iterator->second.second;
+        return *iterator->second.progress;
     }
 }
 
@@ -622,7 +698,16 @@ microtime_t store_t::get_sindex_start_time(uuid_u const &id) {
     if (iterator == sindex_context.end()) {
         return -1;
     } else {
-        return iterator->second.first;
+        return iterator->second.start_time;
+    }
+}
+
+int64_t store_t::get_sindex_rows_constructed(uuid_u const &id) {
+    auto iterator = sindex_context.find(id);
+    if (iterator == sindex_context.end()) {
+        return 0;
+    } else {
+        return *iterator->second.rows_constructed;
     }
 }
 
@@ -9,11 +9,16 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/disk_backed_queue.hpp"
 #include "rdb_protocol/artificial_table/backend.hpp"
 #include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/changefeed_queue.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/intersection.hpp"
+#include "rdb_protocol/op.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/response.hpp"
 #include "rdb_protocol/val.hpp"
@@ -25,33 +30,11 @@ namespace ql {
 
 namespace changefeed {
 
-struct indexed_datum_t {
-    indexed_datum_t(
-            datum_t _val,
-            optional<std::string> _btree_index_key)
-        : val(std::move(_val)),
-          btree_index_key(std::move(_btree_index_key)) {
-        guarantee(val.has());
-    }
-    datum_t val;
-    optional<std::string> btree_index_key;
-
-    MOVABLE_BUT_NOT_COPYABLE(indexed_datum_t);
-};
-
-struct stamped_range_t {
-    explicit stamped_range_t(uint64_t _next_expected_stamp)
-        : next_expected_stamp(_next_expected_stamp),
-          left_fencepost(store_key_t::min()) { }
-    const store_key_t &get_right_fencepost() {
-        return ranges.size() == 0 ? left_fencepost : ranges.back().first.right.key();
-    }
-    uint64_t next_expected_stamp;
-    store_key_t left_fencepost;
-    std::deque<std::pair<key_range_t, uint64_t> > ranges;
-
-    MOVABLE_BUT_NOT_COPYABLE(stamped_range_t);
-};
+// The key of a change's value in the index that a `splice_stream_t` reads the initial
+// values from.
+store_key_t splice_key(const store_key_t &pkey, const indexed_datum_t &val) {
+    return val.btree_index_key ? store_key_t(*val.btree_index_key) : pkey;
+}
 
 void debug_print(printf_buffer_t *buf, const stamped_range_t &rng) {
     buf->appendf("stamped_range_t{");
@@ -63,33 +46,6 @@ void debug_print(printf_buffer_t *buf, const stamped_range_t &rng) {
     buf->appendf("}");
 }
 
-struct change_val_t {
-    change_val_t(std::pair<uuid_u, uint64_t> _source_stamp,
-                 const store_key_t &_pkey,
-                 optional<indexed_datum_t> _old_val,
-                 optional<indexed_datum_t> _new_val
-                 DEBUG_ONLY(, optional<std::string> _sindex))
-        : source_stamp(std::move(_source_stamp)),
-          pkey(_pkey),
-          old_val(std::move(_old_val)),
-          new_val(std::move(_new_val))
-          DEBUG_ONLY(, sindex(std::move(_sindex))) {
-        guarantee(old_val || new_val);
-        if (old_val && new_val) {
-            guarantee(static_cast<bool>(old_val->btree_index_key)
-                == static_cast<bool>(new_val->btree_index_key));
-            rassert(old_val->val != new_val->val);
-        }
-    }
-    std::pair<uuid_u, uint64_t> source_stamp;
-    store_key_t pkey;
-    optional<indexed_datum_t> old_val;
-    optional<indexed_datum_t> new_val;
-    DEBUG_ONLY(optional<std::string> sindex;);
-
-    MOVABLE_BUT_NOT_COPYABLE(change_val_t);
-};
-
 namespace debug {
 std::string print(const uuid_u &u) {
     printf_buffer_t buf;
@@ -165,16 +121,10 @@ void debug_print(printf_buffer_t *buf, const T &t) {
 }
 
 enum class pop_type_t { RANGE, POINT };
-class maybe_squashing_queue_t {
-public:
-    virtual ~maybe_squashing_queue_t() { }
-    virtual void add(change_val_t change_val) = 0;
-    virtual size_t size() const = 0;
-    virtual void clear() = 0;
-    virtual change_val_t pop() = 0;
-    virtual const change_val_t &peek() = 0;
-    virtual void purge_below(std::map<uuid_u, uint64_t> stamps) = 0;
-};
+
+// How much disk space the queue of one `changes(spill_to_disk=true)` feed may take up
+// before we drop its changes, like we do when a queue holds too many changes in memory.
+static const int64_t SPILLED_CHANGEFEED_QUEUE_MAX_BYTES = GIGABYTE;
 
 class nonsquashing_queue_t final : public maybe_squashing_queue_t {
     void add(change_val_t change_val) final {
@@ -317,6 +267,7 @@ server_t::client_info_t::client_info_t()
 server_t::server_t(mailbox_manager_t *_manager, store_t *_parent)
     : uuid(generate_uuid()),
       manager(_manager),
+      flush_scheduled(false),
       parent(_parent),
       stop_mailbox(manager,
                    std::bind(&server_t::stop_mailbox_cb, this, ph::_1, ph::_2)),
@@ -390,6 +341,9 @@ void server_t::limit_stop_mailbox_cb(signal_t *,
 void server_t::add_client(
         const client_t::addr_t &addr,
         region_t region,
+        const std::vector<transform_variant_t> &transforms,
+        const optional<serializable_env_t> &s_env,
+        rdb_context_t *ctx,
         const auto_drainer_t::lock_t &keepalive) {
     keepalive.assert_is_holding(&drainer);
     rwlock_in_line_t spot(&clients_lock, access_t::write);
@@ -406,6 +360,18 @@ void server_t::add_client(
     // that's fine.
     if (!info->cond.has()) {
         info->stamp = 0;
+        if (!transforms.empty()) {
+            guarantee(s_env.has_value());
+            info->env = make_scoped<env_t>(
+                ctx,
+                return_empty_normal_batches_t::NO,
+                drainer.get_drain_signal(),
+                *s_env,
+                nullptr/*don't profile*/);
+            for (const auto &transform : transforms) {
+                info->ops.push_back(make_op(transform));
+            }
+        }
         cond_t *stopped = new cond_t();
         info->cond.init(stopped);
         // Passing the raw pointer `stopped` is safe because `add_client_cb` is
@@ -515,7 +481,38 @@ void server_t::send_one_with_lock(
         ASSERT_NO_CORO_WAITING;
         stamp = client->second.stamp++;
     }
-    send(manager, client->first, stamped_msg_t(uuid, stamp, std::move(msg)));
+    send(manager, client->first,
+         std::vector<stamped_msg_t>{stamped_msg_t(uuid, stamp, std::move(msg))});
+}
+
+// Applies a client's transformations to the values of a change.  Returns
+// `r_nullopt` if the transformations filter out both values, since then none of the
+// client's subscriptions would see the change.
+optional<msg_t> transform_change(const msg_t &msg,
+                                 const std::vector<scoped_ptr_t<op_t> > &ops,
+                                 env_t *env) {
+    const msg_t::change_t *change = boost::get<msg_t::change_t>(&msg.op);
+    if (change == nullptr) {
+        return make_optional(msg);
+    }
+    msg_t::change_t res;
+    res.old_indexes = change->old_indexes;
+    res.new_indexes = change->new_indexes;
+    res.pkey = change->pkey;
+    if (change->old_val.has()) {
+        if (optional<datum_t> d = apply_ops(change->old_val, ops, env, datum_t())) {
+            res.old_val = std::move(*d);
+        }
+    }
+    if (change->new_val.has()) {
+        if (optional<datum_t> d = apply_ops(change->new_val, ops, env, datum_t())) {
+            res.new_val = std::move(*d);
+        }
+    }
+    if (!res.old_val.has() && !res.new_val.has()) {
+        return r_nullopt;
+    }
+    return make_optional(msg_t(std::move(res)));
 }
 
 void server_t::send_all(
@@ -529,20 +526,62 @@ void server_t::send_all(
 
     rwlock_acq_t acq(&clients_lock, access_t::read);
     std::map<client_t::addr_t, uint64_t> stamps;
+    // The messages for the clients that have transformations.
+    std::map<client_t::addr_t, msg_t> transformed;
     for (auto &&pair : clients) {
+        if (!std::any_of(pair.second.regions.begin(),
+                         pair.second.regions.end(),
+                         std::bind(&region_contains_key, ph::_1, std::cref(key)))) {
+            continue;
+        }
+        if (!pair.second.ops.empty()) {
+            optional<msg_t> client_msg =
+                transform_change(msg, pair.second.ops, pair.second.env.get());
+            if (!client_msg) {
+                // We don't use up a stamp, so the client doesn't wait for it.
+                continue;
+            }
+            transformed.insert(std::make_pair(pair.first, std::move(*client_msg)));
+        }
         // We don't need a write lock as long as we make sure the coroutine
         // doesn't block between reading and updating the stamp.
         ASSERT_NO_CORO_WAITING;
-        if (std::any_of(pair.second.regions.begin(),
-                        pair.second.regions.end(),
-                        std::bind(&region_contains_key, ph::_1, std::cref(key)))) {
-            stamps[pair.first] = pair.second.stamp++;
-        }
+        stamps[pair.first] = pair.second.stamp++;
     }
     acq.reset();
     stamp_spot->reset(); // Done stamping, no need to hold onto it while we send.
     for (const auto &pair : stamps) {
-        send(manager, pair.first, stamped_msg_t(uuid, pair.second, msg));
+        auto it = transformed.find(pair.first);
+        if (it != transformed.end()) {
+            pending[pair.first].emplace_back(pair.second, std::move(it->second));
+        } else {
+            pending[pair.first].emplace_back(pair.second, msg);
+        }
+    }
+    if (!stamps.empty() && !flush_scheduled) {
+        flush_scheduled = true;
+        coro_t::spawn_sometime(
+            std::bind(&server_t::flush_pending_cb, this, keepalive));
+    }
+}
+
+void server_t::flush_pending_cb(auto_drainer_t::lock_t keepalive) {
+    keepalive.assert_is_holding(&drainer);
+    std::map<client_t::addr_t, std::vector<std::pair<uint64_t, msg_t> > > to_send;
+    {
+        ASSERT_NO_CORO_WAITING;
+        to_send.swap(pending);
+        flush_scheduled = false;
+    }
+    // The clients put the messages back in order using the stamps, so it doesn't
+    // matter that e.g. `send_one_with_lock` might overtake us.
+    for (auto &&pair : to_send) {
+        std::vector<stamped_msg_t> batch;
+        batch.reserve(pair.second.size());
+        for (auto &&msg : pair.second) {
+            batch.push_back(stamped_msg_t(uuid, msg.first, std::move(msg.second)));
+        }
+        send(manager, pair.first, batch);
     }
 }
 
@@ -841,6 +880,137 @@ bool limit_order_t::operator()(const std::string &a, const std::string &b) const
     unreachable();
 }
 
+// The most rows a `limit_manager_t` keeps behind its active set.  Memory use per
+// changefeed is bounded by the limit plus this.
+const size_t LIMIT_CHANGEFEED_MAX_SLACK = 1000;
+
+limit_window_t::limit_window_t(limit_order_t _gt, size_t _limit, size_t _slack_size)
+    : gt(std::move(_gt)),
+      limit(_limit),
+      slack_size(_slack_size),
+      item_queue(gt),
+      slack(gt) { }
+
+void limit_window_t::init(const std::vector<item_t> &item_vec) {
+    guarantee(item_queue.size() == 0);
+    for (const auto &pair : item_vec) {
+        bool inserted = item_queue.insert(pair).second;
+        guarantee(inserted);
+    }
+}
+
+bool limit_window_t::apply_changes(
+        const std::set<std::string> &deleted,
+        const std::map<std::string, std::pair<datum_t, datum_t> > &added,
+        optional<item_t> *boundary_out,
+        item_queue_t *real_added,
+        std::set<std::string> *real_deleted) {
+    // Before we delete anything, we get the boundary between the rows we keep in
+    // memory and the data that didn't make it into them.  Anything <= that
+    // according to our ordering could never be kicked out of the set because of a
+    // read from disk.
+    boundary_out->reset();
+    if (slack.size() != 0) {
+        boundary_out->set(**slack.begin());
+    } else if (item_queue.size() != 0) {
+        boundary_out->set(**item_queue.begin());
+    }
+    const optional<item_t> &window_boundary = *boundary_out;
+
+    bool window_shrunk = false;
+    for (const auto &id : deleted) {
+        if (item_queue.del_id(id)) {
+            bool inserted = real_deleted->insert(id).second;
+            guarantee(inserted);
+            window_shrunk = true;
+        } else if (slack.del_id(id)) {
+            window_shrunk = true;
+        }
+    }
+    // We fill the holes in the active set before adding anything, so that a new
+    // row only goes into the active set if it beats the rows that are left.
+    promote(real_added);
+
+    bool added_on_disk = false;
+    for (const auto &pair : added) {
+        // We only keep a row if we know we beat anything that might be read off of
+        // disk below.  This is fine because if the resulting set is still too
+        // small, and the things we didn't add happen to beat the other things in
+        // the table, we'll read them first.
+        if (window_boundary && gt(item_t(pair), *window_boundary)) {
+            added_on_disk = true;
+        } else if (item_queue.size() >= limit && item_queue.size() != 0
+                   && gt(item_t(pair), item_t(**item_queue.begin()))) {
+            // We can never get two additions for the same key without a deletion
+            // in-between.
+            bool inserted = slack.insert(pair).second;
+            guarantee(inserted);
+        } else {
+            bool inserted = item_queue.insert(pair).second;
+            guarantee(inserted);
+            inserted = real_added->insert(pair).second;
+            guarantee(inserted);
+            demote(real_added, real_deleted);
+        }
+    }
+    if (slack.size() > slack_size) {
+        slack.truncate_top(slack_size);
+        window_shrunk = true;
+    }
+
+    return item_queue.size() < limit && (window_shrunk || added_on_disk);
+}
+
+size_t limit_window_t::rows_to_read() const {
+    guarantee(item_queue.size() < limit);
+    // We read enough to fill up the slack as well, so that the next few deletions
+    // from the active set don't have to read again.
+    return limit + slack_size - item_queue.size() - slack.size();
+}
+
+void limit_window_t::add_read(std::vector<item_t> &&items, item_queue_t *real_added) {
+    for (auto &&pair : items) {
+        // Reading duplicates from disk is fine.
+        if (item_queue.find_id(pair.first) == item_queue.end()) {
+            UNUSED bool inserted = slack.insert(std::move(pair)).second;
+        }
+    }
+    // We need to truncate again because `read_more` may read too much in the
+    // secondary index case.
+    slack.truncate_top(slack_size);
+    promote(real_added);
+}
+
+void limit_window_t::promote(item_queue_t *real_added) {
+    while (item_queue.size() < limit && slack.size() != 0) {
+        auto it = std::prev(slack.end());
+        item_t item = **it;
+        slack.erase(it);
+        bool inserted = item_queue.insert(item).second;
+        guarantee(inserted);
+        inserted = real_added->insert(std::move(item)).second;
+        guarantee(inserted);
+    }
+}
+
+void limit_window_t::demote(item_queue_t *real_added,
+                            std::set<std::string> *real_deleted) {
+    while (item_queue.size() > limit) {
+        auto it = item_queue.begin();
+        item_t item = **it;
+        item_queue.erase(it);
+        auto added_it = real_added->find_id(item.first);
+        if (added_it != real_added->end()) {
+            real_added->erase(added_it);
+        } else {
+            bool inserted = real_deleted->insert(item.first).second;
+            guarantee(inserted);
+        }
+        bool inserted = slack.insert(std::move(item)).second;
+        guarantee(inserted);
+    }
+}
+
 void limit_manager_t::send(msg_t &&msg) {
     if (!parent->drainer.is_draining()) {
         auto_drainer_t::lock_t drain_lock(&parent->drainer);
@@ -871,7 +1041,7 @@ limit_manager_t::limit_manager_t(
       parent_client(std::move(_parent_client)),
       spec(std::move(_spec)),
       gt(std::move(_gt)),
-      item_queue(gt),
+      window(gt, spec.limit, std::min<size_t>(spec.limit, LIMIT_CHANGEFEED_MAX_SLACK)),
       aborted(false) {
     guarantee(clients_lock->read_signal()->is_pulsed());
 
@@ -888,11 +1058,7 @@ limit_manager_t::limit_manager_t(
         ops.push_back(make_op(transform));
     }
 
-    guarantee(item_queue.size() == 0);
-    for (const auto &pair : item_vec) {
-        bool inserted = item_queue.insert(pair).second;
-        guarantee(inserted);
-    }
+    window.init(item_vec);
     send(msg_t(msg_t::limit_start_t(uuid, std::move(item_vec))));
 }
 
@@ -941,14 +1107,18 @@ public:
                   const keyspec_t::limit_t *_spec,
                   sorting_t _sorting,
                   optional<item_t> _start,
-                  const item_queue_t *_item_queue)
+                  size_t _n,
+                  const item_queue_t *_item_queue,
+                  const item_queue_t *_slack)
         : env(_env),
           ops(_ops),
           pk_range(_pk_range),
           spec(_spec),
           sorting(_sorting),
           start(std::move(_start)),
-          item_queue(_item_queue) { }
+          n(_n),
+          item_queue(_item_queue),
+          slack(_slack) { }
 
     std::vector<item_t> operator()(const primary_ref_t &ref) {
         rget_read_response_t resp;
@@ -971,7 +1141,6 @@ public:
         case sorting_t::UNORDERED: // fallthru
         default: unreachable();
         }
-        size_t n = spec->limit - item_queue->size();
         rdb_rget_slice(
             ref.btree,
             region_t(),
@@ -1026,7 +1195,7 @@ public:
                 [](const datum_range_t &) { return true; },
                 [](const std::map<datum_t, uint64_t> &) { return false; }));
         datum_range_t srange = spec->range.datumspec.covering_range();
-        size_t n = spec->limit - item_queue->size();
+        size_t n_to_read = n;
         if (start) {
             datum_t dstart = start->second.first;
             switch (sorting) {
@@ -1041,11 +1210,20 @@ public:
             }
 
             // Because we're using closed bounds, we have to make sure to read enough.
-            for (const auto &pair : *item_queue) {
-                if (pair->second.first != dstart) {
+            // The rows that sort last are at the start of `slack`, followed by the
+            // start of `item_queue`.
+            bool done = false;
+            for (const item_queue_t *queue : {slack, item_queue}) {
+                for (const auto &pair : *queue) {
+                    if (pair->second.first != dstart) {
+                        done = true;
+                        break;
+                    }
+                    n_to_read += 1;
+                }
+                if (done) {
                     break;
                 }
-                n += 1;
             }
         }
         reql_version_t reql_version =
@@ -1061,7 +1239,7 @@ public:
             std::vector<transform_variant_t>(),
             optional<terminal_variant_t>(limit_read_t{
                     is_primary_t::NO,
-                    n,
+                    n_to_read,
                     // This code uses the same generic code path as a normal
                     // read, and a normal read needs to keep track of the
                     // region and last seen key for unsharding, but we
@@ -1089,7 +1267,7 @@ public:
         if (stream.substreams.size() == 1) {
             raw_stream_t *raw_stream = &stream.substreams.begin()->second.stream;
             item_vec = mangle_sort_truncate_stream(
-                std::move(*raw_stream), is_primary_t::NO, sorting, n);
+                std::move(*raw_stream), is_primary_t::NO, sorting, n_to_read);
         } else {
             guarantee(item_vec.size() == 0);
         }
@@ -1103,15 +1281,17 @@ private:
     const keyspec_t::limit_t *spec;
     sorting_t sorting;
     optional<item_t> start;
+    size_t n;
     const item_queue_t *item_queue;
+    const item_queue_t *slack;
 };
 
 std::vector<item_t> limit_manager_t::read_more(
     const boost::variant<primary_ref_t, sindex_ref_t> &ref,
     const optional<item_t> &start) {
-    guarantee(item_queue.size() < spec.limit);
     ref_visitor_t visitor(
-        env.get(), &ops, &region.inner, &spec, spec.range.sorting, start, &item_queue);
+        env.get(), &ops, &region.inner, &spec, spec.range.sorting, start,
+        window.rows_to_read(), &window.get_item_queue(), &window.get_slack());
     return boost::apply_visitor(visitor, ref);
 }
 
@@ -1123,62 +1303,19 @@ void limit_manager_t::commit(
         return;
     }
 
-    // Before we delete anything, we get the boundary between the active set and
-    // the data that didn't make it into the set.  Anything <= that according to
-    // our ordering could never be kicked out of the set because of a read from
-    // disk.
-    optional<item_t> active_boundary;
-    auto item_queue_it = item_queue.begin();
-    if (item_queue_it != item_queue.end()) {
-        active_boundary.set(**item_queue_it);
-    }
-
+    optional<item_t> window_boundary;
     item_queue_t real_added(gt);
     std::set<std::string> real_deleted;
-    for (const auto &id : deleted) {
-        bool data_deleted = item_queue.del_id(id);
-        if (data_deleted) {
-            bool inserted = real_deleted.insert(id).second;
-            guarantee(inserted);
-        }
-    }
+    const bool need_read = window.apply_changes(
+        deleted, added, &window_boundary, &real_added, &real_deleted);
     deleted.clear();
-    bool added_on_disk = false;
-    for (const auto &pair : added) {
-        // We only add to the set if we know we beat anything that might be read
-        // off of disk below.  This is fine because if the resulting set is
-        // still too small, and the things we didn't add happen to beat the
-        // other things in the table, we'll read them first.
-        if (!(active_boundary && gt(item_t(pair), *active_boundary))) {
-            bool inserted = item_queue.insert(pair).second;
-            // We can never get two additions for the same key without a deletion
-            // in-between.
-            guarantee(inserted);
-            inserted = real_added.insert(pair).second;
-            guarantee(inserted);
-        } else {
-            added_on_disk = true;
-        }
-    }
     added.clear();
 
-    std::vector<std::string> truncated = item_queue.truncate_top(spec.limit);
-    for (auto &&id : truncated) {
-        auto it = real_added.find_id(id);
-        if (it != real_added.end()) {
-            real_added.erase(it);
-        } else {
-            bool inserted = real_deleted.insert(std::move(id)).second;
-            guarantee(inserted);
-        }
-    }
-
-    bool anything_on_disk = real_deleted.size() != 0 || added_on_disk;
-    if (item_queue.size() < spec.limit && anything_on_disk) {
+    if (need_read) {
         std::vector<item_t> s;
         optional<exc_t> exc;
         try {
-            s = read_more(sindex_ref, active_boundary);
+            s = read_more(sindex_ref, window_boundary);
         } catch (const exc_t &e) {
             exc.set(e);
         }
@@ -1188,26 +1325,7 @@ void limit_manager_t::commit(
             abort(*exc);
             return;
         }
-        for (auto &&pair : s) {
-            bool inserted = item_queue.insert(pair).second;
-            // Reading duplicates from disk is fine.
-            if (inserted) {
-                bool added_insert = real_added.insert(pair).second;
-                guarantee(added_insert);
-            }
-        }
-        // We need to truncate again because `read_more` may read too much in
-        // the secondary index case.
-        std::vector<std::string> read_trunc = item_queue.truncate_top(spec.limit);
-        for (auto &&id : read_trunc) {
-            auto it = real_added.find_id(id);
-            if (it != real_added.end()) {
-                real_added.erase(it);
-            } else {
-                bool inserted = real_deleted.insert(std::move(id)).second;
-                guarantee(inserted);
-            }
-        }
+        window.add_read(std::move(s), &real_added);
     }
     std::set<std::string> remaining_deleted;
     for (auto &&id : real_deleted) {
@@ -1562,16 +1680,20 @@ public:
             // update step and always pass it through.  (This supports cases
             // like `.get_all(1, 1)`).
             last_stamp = stamp_pair;
+            if (covered_by_initial_read(shard_uuid, pkey, old_val, new_val)) {
+                return;
+            }
             queue->add(change_val_t(
                 std::make_pair(shard_uuid, stamp),
                 pkey,
                 std::move(old_val),
                 std::move(new_val)
                 DEBUG_ONLY(, sindex)));
-            if (queue->size() > limits.changefeed_queue_size()) {
+            if (queue->memory_size() > limits.changefeed_queue_size()
+                || queue->over_disk_limit()) {
                 skipped += queue->size();
                 queue->clear();
-            } else if (queue->size() > limits.changefeed_queue_size() / 2) {
+            } else if (queue->memory_size() > limits.changefeed_queue_size() / 2) {
                 // We do this even if the queue is only half full because we
                 // expect it to take some time to process and we want to be
                 // super safe.  (This will only affect anything if your `squash`
@@ -1595,6 +1717,14 @@ private:
     std::pair<uuid_u, uint64_t> last_stamp;
     virtual void apply_queued_changes() { } // Changes are never queued.
     virtual bool update_stamp(const uuid_u &uuid, uint64_t new_stamp) = 0;
+    // Whether the initial values we're still reading will include the change, so
+    // that we don't need to queue it.
+    virtual bool covered_by_initial_read(const uuid_u &,
+                                         const store_key_t &,
+                                         const optional<indexed_datum_t> &,
+                                         const optional<indexed_datum_t> &) {
+        return false;
+    }
 };
 
 class range_sub_t;
@@ -1645,6 +1775,10 @@ public:
         return table_id;
     }
 
+    // Whether the shards apply the transformations of the feed's range
+    // subscriptions before sending changes (see `server_t::add_client`).
+    virtual bool applies_transforms_on_shard() const { return false; }
+
     name_resolver_t const &get_name_resolver() const {
         return name_resolver;
     }
@@ -1724,30 +1858,36 @@ std::map<uuid_u, uint64_t> feed_t::get_stamps() {
 
 class real_feed_t : public feed_t {
 public:
+    // If `shard_transforms` isn't empty the shards apply them to the changes, and
+    // `key` has their `transforms_id()`.
     real_feed_t(auto_drainer_t::lock_t client_lock,
                 client_t *client,
                 mailbox_manager_t *manager,
                 namespace_interface_t *ns_if,
-                namespace_id_t const &table_id,
+                client_t::feed_key_t const &key,
+                const std::vector<transform_variant_t> &shard_transforms,
+                const optional<serializable_env_t> &s_env,
                 signal_t *interruptor,
                 lifetime_t<name_resolver_t const &> name_resolver);
     ~real_feed_t();
 
     client_t::addr_t get_addr() const;
+    client_t::feed_key_t const &get_key() const { return key; }
+    bool applies_transforms_on_shard() const final { return !key.second.empty(); }
     void abort_feed() final { aborted.pulse_if_not_already_pulsed(); }
     virtual auto_drainer_t::lock_t get_drainer_lock() { return drainer.lock(); }
 private:
-    virtual void maybe_remove_feed() { client->maybe_remove_feed(client_lock, table_id); }
+    virtual void maybe_remove_feed() { client->maybe_remove_feed(client_lock, key); }
     virtual void stop_limit_sub(limit_sub_t *sub);
 
-    void mailbox_cb(signal_t *interruptor, stamped_msg_t msg);
+    void mailbox_cb(signal_t *interruptor, std::vector<stamped_msg_t> msgs);
     void constructor_cb();
 
     auto_drainer_t::lock_t client_lock;
     client_t *client;
-    namespace_id_t table_id;
+    client_t::feed_key_t key;
     mailbox_manager_t *manager;
-    mailbox_t<stamped_msg_t> mailbox;
+    mailbox_t<std::vector<stamped_msg_t> > mailbox;
     std::vector<server_t::addr_t> stop_addrs;
     std::vector<scoped_ptr_t<disconnect_watcher_t> > disconnect_watchers;
 
@@ -1778,17 +1918,23 @@ real_feed_t::real_feed_t(auto_drainer_t::lock_t _client_lock,
                          client_t *_client,
                          mailbox_manager_t *_manager,
                          namespace_interface_t *ns_if,
-                         namespace_id_t const &_table_id,
+                         client_t::feed_key_t const &_key,
+                         const std::vector<transform_variant_t> &shard_transforms,
+                         const optional<serializable_env_t> &s_env,
                          signal_t *interruptor,
                          lifetime_t<name_resolver_t const &> _name_resolver)
-    : feed_t(_table_id, _name_resolver),
+    : feed_t(_key.first, _name_resolver),
       client_lock(std::move(_client_lock)),
       client(_client),
-      table_id(_table_id),
+      key(_key),
       manager(_manager),
       mailbox(manager, std::bind(&real_feed_t::mailbox_cb, this, ph::_1, ph::_2)) {
+    guarantee(shard_transforms.empty() == key.second.empty());
     try {
-        read_t read(changefeed_subscribe_t(mailbox.get_address()),
+        read_t read(shard_transforms.empty()
+                        ? changefeed_subscribe_t(mailbox.get_address())
+                        : changefeed_subscribe_t(
+                            mailbox.get_address(), shard_transforms, *s_env),
                     profile_bool_t::DONT_PROFILE, read_mode_t::SINGLE);
         read_response_t read_resp;
         ns_if->read(
@@ -2146,6 +2292,89 @@ private:
     auto_drainer_t drainer;
 };
 
+// Computes how deterministic the functions in a transformation are.
+class transform_deterministic_visitor_t
+    : public boost::static_visitor<deterministic_t> {
+public:
+    deterministic_t operator()(const map_wire_func_t &f) const {
+        return f.compile_wire_func()->is_deterministic();
+    }
+    deterministic_t operator()(const group_wire_func_t &f) const {
+        deterministic_t res = deterministic_t::always();
+        for (const auto &func : f.compile_funcs()) {
+            res = res.join(func->is_deterministic());
+        }
+        return res;
+    }
+    deterministic_t operator()(const filter_wire_func_t &f) const {
+        deterministic_t res = f.filter_func.compile_wire_func()->is_deterministic();
+        if (f.default_filter_val) {
+            res = res.join(
+                f.default_filter_val->compile_wire_func()->is_deterministic());
+        }
+        return res;
+    }
+    deterministic_t operator()(const concatmap_wire_func_t &f) const {
+        return f.compile_wire_func()->is_deterministic();
+    }
+    deterministic_t operator()(const distinct_wire_func_t &) const {
+        return deterministic_t::always();
+    }
+    deterministic_t operator()(const zip_wire_func_t &) const {
+        return deterministic_t::always();
+    }
+};
+
+deterministic_t transforms_deterministic(
+        const std::vector<transform_variant_t> &transforms) {
+    deterministic_t res = deterministic_t::always();
+    for (const auto &transform : transforms) {
+        res = res.join(
+            boost::apply_visitor(transform_deterministic_visitor_t(), transform));
+    }
+    return res;
+}
+
+// Whether the shards can apply `transforms` to changes before sending them.  We
+// only do that for `map` (which includes `pluck`) and `filter`, and only if the
+// result doesn't depend on which server evaluates them.
+bool can_apply_on_shard(const std::vector<transform_variant_t> &transforms) {
+    for (const auto &transform : transforms) {
+        if (boost::get<map_wire_func_t>(&transform) == nullptr
+            && boost::get<filter_wire_func_t>(&transform) == nullptr) {
+            return false;
+        }
+    }
+    return !transforms.empty()
+        && transforms_deterministic(transforms).test(single_server_t::no,
+                                                     constant_now_t::yes);
+}
+
+// Returns a string that is the same for two range subscriptions iff their
+// transformations compute the same values, or an empty string if we can't tell.
+// Like `sindex_config_t::operator==`, we compare functions by serializing them.
+std::string transforms_id(const std::vector<transform_variant_t> &transforms,
+                          env_t *env) {
+    if (transforms.empty() || env->get_rdb_ctx() == nullptr) {
+        return std::string();
+    }
+    const serializable_env_t &s_env = env->get_serializable_env();
+    write_message_t wm;
+    serialize<cluster_version_t::CLUSTER>(&wm, transforms);
+    serialize<cluster_version_t::CLUSTER>(&wm, s_env.global_optargs);
+    serialize<cluster_version_t::CLUSTER>(&wm, s_env.user_context);
+    if (!transforms_deterministic(transforms).test(single_server_t::yes,
+                                                   constant_now_t::no)) {
+        // The transformations read `r.now()`.
+        serialize<cluster_version_t::CLUSTER>(&wm, s_env.deterministic_time);
+    }
+    vector_stream_t stream;
+    stream.reserve(wm.size());
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    return std::string(stream.vector().begin(), stream.vector().end());
+}
+
 // This gets around some class ordering issues; `range_sub_t` needs to know how
 // to construct a `splice_stream_t` and `splice_stream_t` needs to know about
 // `range_sub_t`.
@@ -2165,6 +2394,7 @@ public:
                 const datum_t &_squash,
                 bool _include_states,
                 bool _include_types,
+                bool spill_to_disk,
                 env_t *outer_env,
                 keyspec_t::range_t _spec)
         // We don't turn on squashing until later for range subs.  (We need to
@@ -2180,10 +2410,28 @@ public:
           spec(std::move(_spec)),
           state(state_t::READY),
           sent_state(state_t::NONE),
-          artificial_include_initial(false) {
+          artificial_include_initial(false),
+          shard_applies_ops(_feed->applies_transforms_on_shard()) {
+        // A squashing queue doesn't grow with the number of changes to a row, so we
+        // only spill non-squashing queues.
+        if (spill_to_disk && !squash) {
+            rcheck_datum(
+                _rdb_context != nullptr && _rdb_context->io_backender != nullptr,
+                base_exc_t::OP_FAILED,
+                "Cannot spill changefeed queues to disk on a server without a data "
+                "directory.");
+            queue = make_scoped<spilling_queue_t>(_rdb_context->io_backender,
+                                                  _rdb_context->base_path,
+                                                  limits.changefeed_queue_size(),
+                                                  SPILLED_CHANGEFEED_QUEUE_MAX_BYTES);
+        }
         env = make_env(outer_env);
-        for (const auto &transform : spec.transforms) {
-            ops.push_back(make_op(transform));
+        // The shards might have applied our transformations already.
+        if (!shard_applies_ops) {
+            for (const auto &transform : spec.transforms) {
+                ops.push_back(make_op(transform));
+            }
+            ops_id = transforms_id(spec.transforms, outer_env);
         }
         store_keys = spec.datumspec.primary_key_map();
         if (!store_keys.has_value()) {
@@ -2223,6 +2471,8 @@ public:
     }
 
     bool has_ops() { return ops.size() != 0; }
+    bool shard_applied_ops() const { return shard_applies_ops; }
+    const std::string &get_ops_id() const { return ops_id; }
 
     optional<datum_t> apply_ops(datum_t val) {
         guarantee(active());
@@ -2380,7 +2630,22 @@ public:
     }
     const std::map<uuid_u, uint64_t> &get_next_stamps() { return next_stamps; }
     const std::map<uuid_u, uint64_t> &get_orig_stamps() { return orig_stamps; }
+    // See `unread_fenceposts`.
+    void set_unread_fenceposts(std::map<uuid_u, store_key_t> &&fenceposts) {
+        unread_fenceposts = std::move(fenceposts);
+    }
 private:
+    bool covered_by_initial_read(const uuid_u &shard_uuid,
+                                 const store_key_t &pkey,
+                                 const optional<indexed_datum_t> &old_val,
+                                 const optional<indexed_datum_t> &new_val) final {
+        auto unread = [&](const optional<indexed_datum_t> &val) {
+            return !val
+                || is_unread(unread_fenceposts, shard_uuid, splice_key(pkey, *val));
+        };
+        return unread(old_val) && unread(new_val);
+    }
+
     scoped_ptr_t<env_t> make_env(env_t *outer_env) {
         // This is to support fake environments from the unit tests that don't
         // actually have a context.
@@ -2398,6 +2663,9 @@ private:
 
     scoped_ptr_t<env_t> env;
     std::vector<scoped_ptr_t<op_t> > ops;
+    // See `transforms_id()`.  Subscriptions with the same `ops_id` share the
+    // results of `apply_ops()` for each change.
+    std::string ops_id;
 
     // The stamp (see `stamped_msg_t`) associated with our `changefeed_stamp_t`
     // read.  We use these to make sure we don't see changes from writes before
@@ -2409,6 +2677,14 @@ private:
     state_t state, sent_state;
     std::vector<datum_t> artificial_initial_vals;
     bool artificial_include_initial;
+    // Set by the `splice_stream_t` reading our initial values while it isn't in the
+    // middle of a read: for each shard, the key from which on it hasn't read anything
+    // yet.  Those keys will get read later, with a newer stamp than any change we've
+    // got for them so far, so we don't have to queue those changes.  That way the
+    // queue doesn't fill up while a big table's initial values are being read.
+    std::map<uuid_u, store_key_t> unread_fenceposts;
+    // Whether the values we get have already been transformed on the shard.
+    const bool shard_applies_ops;
 
     auto_drainer_t *get_drainer() final { return &drainer; }
     auto_drainer_t drainer;
@@ -2837,24 +3113,39 @@ public:
     }
     void operator()(const msg_t::change_t &change) const {
         datum_t null = datum_t::null();
+        // Many subscriptions are often copies of the same query, so we only
+        // evaluate each distinct set of transformations once per change.  Maps
+        // `ops_id`s to the transformed `new_val` and `old_val`.
+        std::map<std::string, std::pair<datum_t, datum_t> > transformed;
 
         feed->each_range_sub(*lock, [&](range_sub_t *sub) {
             datum_t new_val = null, old_val = null;
             if (!sub->active()) return;
             bool trivial = false;
             if (sub->has_ops()) {
-                if (change.new_val.has()) {
-                    if (optional<datum_t> d = sub->apply_ops(change.new_val)) {
-                        new_val = *d;
+                const std::string &ops_id = sub->get_ops_id();
+                auto it = ops_id.empty() ? transformed.end() : transformed.find(ops_id);
+                if (it != transformed.end()) {
+                    new_val = it->second.first;
+                    old_val = it->second.second;
+                } else {
+                    if (change.new_val.has()) {
+                        if (optional<datum_t> d = sub->apply_ops(change.new_val)) {
+                            new_val = *d;
+                        }
                     }
-                }
-                if (!sub->active()) return;
-                if (change.old_val.has()) {
-                    if (optional<datum_t> d = sub->apply_ops(change.old_val)) {
-                        old_val = *d;
+                    if (!sub->active()) return;
+                    if (change.old_val.has()) {
+                        if (optional<datum_t> d = sub->apply_ops(change.old_val)) {
+                            old_val = *d;
+                        }
+                    }
+                    if (!sub->active()) return;
+                    if (!ops_id.empty()) {
+                        transformed.insert(
+                            std::make_pair(ops_id, std::make_pair(new_val, old_val)));
                     }
                 }
-                if (!sub->active()) return;
                 // Duplicate values are caught before being written to disk and
                 // don't generate a `mod_report`, but if we have transforms the
                 // values might have changed.
@@ -2867,6 +3158,9 @@ public:
                 if (change.old_val.has()) {
                     old_val = change.old_val;
                 }
+                // Like above, the transformations on the shard might have made the
+                // values equal.
+                trivial = sub->shard_applied_ops() && new_val == old_val;
             }
             ASSERT_NO_CORO_WAITING;
             optional<std::string> sindex = sub->sindex();
@@ -2962,7 +3256,7 @@ void msg_visit(feed_t *feed,
     feed->update_stamps(server_uuid, stamp);
 }
 
-void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
+void real_feed_t::mailbox_cb(signal_t *, std::vector<stamped_msg_t> msgs) {
     // We stop receiving messages when detached (we're only receiving
     // messages because we haven't managed to get a message to the
     // stop mailboxes for some of the primary replicas yet).  This also stops
@@ -2976,10 +3270,11 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
         wait_any_t wait_any(&queues_ready, lock.get_drain_signal());
         wait_any.wait_lazily_unordered();
         if (detached) return;
-        if (!lock.get_drain_signal()->is_pulsed()) {
-            // We don't need a lock for this because the set of `uuid_u`s never
-            // changes after it's initialized.
-            auto it = queues.find(msg.server_uuid);
+        if (!lock.get_drain_signal()->is_pulsed() && !msgs.empty()) {
+            // All the messages in a batch come from the same `server_t`.  We don't
+            // need a lock for this because the set of `uuid_u`s never changes after
+            // it's initialized.
+            auto it = queues.find(msgs[0].server_uuid);
             guarantee(it != queues.end());
             queue_t *queue = it->second.get();
             guarantee(queue != NULL);
@@ -2989,8 +3284,11 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
             if (detached) return;
 
             // Add us to the queue.
-            guarantee(msg.stamp >= queue->next);
-            queue->map.push(std::move(msg));
+            for (auto &&msg : msgs) {
+                guarantee(msg.server_uuid == it->first);
+                guarantee(msg.stamp >= queue->next);
+                queue->map.push(std::move(msg));
+            }
 
             // Read as much as we can from the queue (this enforces ordering.)
             while (queue->map.size() != 0 && queue->map.top().stamp == queue->next) {
@@ -3005,18 +3303,139 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
     }
 }
 
+splice_ranges_t::splice_ranges_t(const std::map<uuid_u, uint64_t> &orig_stamps)
+    : read_once(false) {
+    for (const auto &p : orig_stamps) {
+        stamped_ranges.insert(std::make_pair(p.first, stamped_range_t(p.second)));
+    }
+}
+
+void splice_ranges_t::add_read(
+        const std::map<uuid_u, std::pair<key_range_t, uint64_t> >
+            &shard_last_read_stamps) {
+    for (const auto &pair : shard_last_read_stamps) {
+        key_range_t read_range = pair.second.first;
+        const uint64_t stamp = pair.second.second;
+        // Safe because we never generate `store_key_t::max()`.
+        if (read_range.right.unbounded) {
+            read_range.right.unbounded = false;
+            read_range.right.internal_key = store_key_t::max();
+        }
+        auto it = stamped_ranges.find(pair.first);
+        r_sanity_check(it != stamped_ranges.end());
+        if (it->second.ranges.size() == 0) {
+            it->second.left_fencepost = read_range.left;
+            it->second.ranges.push_back(std::make_pair(std::move(read_range), stamp));
+        } else if (it->second.ranges.back().second == stamp) {
+            it->second.ranges.back().first.right = read_range.right;
+        } else {
+            it->second.ranges.push_back(std::make_pair(std::move(read_range), stamp));
+        }
+    }
+    read_once = true;
+}
+
+bool splice_ranges_t::discard(const store_key_t &key,
+                              const std::pair<uuid_u, uint64_t> &source_stamp) {
+    auto it = stamped_ranges.find(source_stamp.first);
+    r_sanity_check(it != stamped_ranges.end());
+    it->second.next_expected_stamp = source_stamp.second + 1;
+    if (key < it->second.left_fencepost) return false;
+    if (key >= it->second.get_right_fencepost()) return true;
+    // `ranges` should be extremely small
+    for (const auto &pair : it->second.ranges) {
+        if (pair.first.contains_key(key)) {
+            return source_stamp.second < pair.second;
+        }
+    }
+    // If we get here then there's a gap in the ranges.
+    r_sanity_fail();
+}
+
+void splice_ranges_t::skip_to_feed(
+        const std::map<uuid_u, uint64_t> &sub_stamps,
+        bool sub_queue_empty,
+        const std::function<std::map<uuid_u, uint64_t>()> &get_feed_stamps) {
+    optional<std::map<uuid_u, uint64_t> > feed_stamps;
+    for (auto &&pair : stamped_ranges) {
+        auto it = sub_stamps.find(pair.first);
+        r_sanity_check(it != sub_stamps.end());
+        uint64_t sub_stamp = it->second;
+        // If the subscription's queue is empty, we've consumed all the changes it has
+        // seen except for the ones it didn't queue because of `unread_fenceposts()`,
+        // which we would have discarded.
+        if (sub_queue_empty) {
+            pair.second.next_expected_stamp =
+                std::max(pair.second.next_expected_stamp, sub_stamp);
+        }
+        // If we've consumed all the changes that the subscription has seen,
+        // we can jump ahead to whatever stamp the parent feed says is the
+        // latest it's decided whether or not to pass to the subscription.
+        if (pair.second.next_expected_stamp >= sub_stamp) {
+            if (!feed_stamps) {
+                feed_stamps.set(get_feed_stamps());
+            }
+            auto ft = feed_stamps->find(pair.first);
+            if (ft != feed_stamps->end()) {
+                pair.second.next_expected_stamp =
+                    std::max(pair.second.next_expected_stamp,
+                             ft->second + 1);
+            }
+        }
+    }
+}
+
+void splice_ranges_t::remove_outdated_ranges() {
+    for (auto &&pair : stamped_ranges) {
+        auto *ranges = &pair.second.ranges;
+        while (ranges->size() > 0) {
+            uint64_t read_stamp = ranges->front().second;
+            if (pair.second.next_expected_stamp >= read_stamp) {
+                pair.second.left_fencepost = ranges->front().first.right.key();
+                ranges->pop_front();
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+bool splice_ranges_t::empty() const {
+    for (const auto &pair : stamped_ranges) {
+        if (pair.second.ranges.size() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::map<uuid_u, store_key_t> splice_ranges_t::unread_fenceposts() const {
+    std::map<uuid_u, store_key_t> fenceposts;
+    if (read_once) {
+        for (const auto &pair : stamped_ranges) {
+            fenceposts.insert(
+                std::make_pair(pair.first, pair.second.get_right_fencepost()));
+        }
+    }
+    return fenceposts;
+}
+
+bool is_unread(const std::map<uuid_u, store_key_t> &fenceposts,
+               const uuid_u &shard,
+               const store_key_t &key) {
+    auto it = fenceposts.find(shard);
+    return it != fenceposts.end() && key >= it->second;
+}
+
 class splice_stream_t : public stream_t<range_sub_t> {
 public:
     template<class... Args>
     splice_stream_t(counted_t<datum_stream_t> _src, Args &&... args)
         : stream_t(std::forward<Args>(args)...),
-          read_once(false),
           cached_ready(false),
-          src(std::move(_src)) {
+          src(std::move(_src)),
+          ranges(sub->get_orig_stamps()) {
         r_sanity_check(src.has());
-        for (const auto &p : sub->get_orig_stamps()) {
-            stamped_ranges.insert(std::make_pair(p.first, stamped_range_t(p.second)));
-        }
     }
 
 private:
@@ -3039,10 +3458,10 @@ private:
             // otherwise we don't know the `skey_version`.  We can remove this hack
             // once we're no longer backwards-compatible with pre-1.16 (I think?)
             // skey versions.
-            if (read_once) {
+            if (ranges.has_read()) {
                 while (sub->has_change_val() && !batcher.should_send_batch()) {
                     change_val_t cv = sub->pop_change_val();
-                    // Note that `discard` updates the `stamped_ranges`.
+                    // Note that `discard` updates the `ranges`.
                     datum_t el = change_val_to_change(
                         cv,
                         cv.old_val && discard(
@@ -3058,7 +3477,7 @@ private:
                     }
                 }
                 maybe_skip_to_feed();
-                remove_outdated_ranges();
+                ranges.remove_outdated_ranges();
             } else {
                 if (sub->include_states) {
                     ret.push_back(sub->maybe_add_type(
@@ -3069,10 +3488,14 @@ private:
             if (!src->is_exhausted() && !batcher.should_send_batch()) {
                 // Sorting must be UNORDERED for our last_read range calculation to work.
                 batchspec_t new_bs = bs.with_lazy_sorting_override(sorting_t::UNORDERED);
+                // The read might get further than the `ranges` say before it
+                // returns, so the subscription has to queue everything meanwhile.
+                sub->set_unread_fenceposts(std::map<uuid_u, store_key_t>());
                 std::vector<datum_t> batch = src->next_batch(env, new_bs);
                 update_ranges();
-                r_sanity_check(active_state);
-                read_once = true;
+                // Lets the subscription skip the changes that `discard` would
+                // discard because we haven't read their keys yet.
+                sub->set_unread_fenceposts(ranges.unread_fenceposts());
                 if (batch.size() == 0) {
                     r_sanity_check(src->is_exhausted());
                 } else {
@@ -3106,91 +3529,19 @@ private:
     bool discard(const store_key_t &pkey,
                  const std::pair<uuid_u, uint64_t> &source_stamp,
                  const indexed_datum_t &val) {
-        store_key_t key;
-        if (val.btree_index_key) {
-            key = store_key_t(*val.btree_index_key);
-        } else {
-            key = pkey;
-        }
-
-        auto it = stamped_ranges.find(source_stamp.first);
-        r_sanity_check(it != stamped_ranges.end());
-        it->second.next_expected_stamp = source_stamp.second + 1;
-        if (key < it->second.left_fencepost) return false;
-        if (key >= it->second.get_right_fencepost()) return true;
-        // `ranges` should be extremely small
-        for (const auto &pair : it->second.ranges) {
-            if (pair.first.contains_key(key)) {
-                return source_stamp.second < pair.second;
-            }
-        }
-        // If we get here then there's a gap in the ranges.
-        r_sanity_fail();
+        return ranges.discard(splice_key(pkey, val), source_stamp);
     }
 
     void maybe_skip_to_feed() {
-        const std::map<uuid_u, uint64_t> *sub_stamps = &sub->get_next_stamps();
-        optional<std::map<uuid_u, uint64_t> > feed_stamps;
-        for (auto &&pair : stamped_ranges) {
-            auto it = sub_stamps->find(pair.first);
-            r_sanity_check(it != sub_stamps->end());
-            uint64_t sub_stamp = it->second;
-            // If we've consumed all the changes that the subscription has seen,
-            // we can jump ahead to whatever stamp the parent feed says is the
-            // latest it's decided whether or not to pass to the subscription.
-            if (pair.second.next_expected_stamp >= sub_stamp) {
-                if (!feed_stamps) {
-                    feed_stamps.set(sub->parent_feed()->get_stamps());
-                }
-                auto ft = feed_stamps->find(pair.first);
-                if (ft != feed_stamps->end()) {
-                    pair.second.next_expected_stamp =
-                        std::max(pair.second.next_expected_stamp,
-                                 ft->second + 1);
-                }
-            }
-        }
+        ranges.skip_to_feed(sub->get_next_stamps(), !sub->has_change_val(), [&]() {
+            return sub->parent_feed()->get_stamps();
+        });
     }
 
     void update_ranges() {
         active_state = src->get_active_state();
         r_sanity_check(active_state);
-        for (const auto &pair : active_state->shard_last_read_stamps) {
-            add_range(pair.first, pair.second.first, pair.second.second);
-        }
-    }
-
-    void add_range(uuid_u uuid, key_range_t read_range, uint64_t stamp) {
-        // Safe because we never generate `store_key_t::max()`.
-        if (read_range.right.unbounded) {
-            read_range.right.unbounded = false;
-            read_range.right.internal_key = store_key_t::max();
-        }
-        auto it = stamped_ranges.find(uuid);
-        r_sanity_check(it != stamped_ranges.end());
-        if (it->second.ranges.size() == 0) {
-            it->second.left_fencepost = read_range.left;
-            it->second.ranges.push_back(std::make_pair(std::move(read_range), stamp));
-        } else if (it->second.ranges.back().second == stamp) {
-            it->second.ranges.back().first.right = read_range.right;
-        } else {
-            it->second.ranges.push_back(std::make_pair(std::move(read_range), stamp));
-        }
-    }
-
-    void remove_outdated_ranges() {
-        for (auto &&pair : stamped_ranges) {
-            auto *ranges = &pair.second.ranges;
-            while (ranges->size() > 0) {
-                uint64_t read_stamp = ranges->front().second;
-                if (pair.second.next_expected_stamp >= read_stamp) {
-                    pair.second.left_fencepost = ranges->front().first.right.key();
-                    ranges->pop_front();
-                } else {
-                    break;
-                }
-            }
-        }
+        ranges.add_read(active_state->shard_last_read_stamps);
     }
 
     const reql_version_t &reql_version() const {
@@ -3203,22 +3554,21 @@ private:
         // It's OK to cache this because we only ever call `ready` once we're
         // done doing reads.
         if (!cached_ready) {
-            remove_outdated_ranges();
-            for (const auto &pair : stamped_ranges) {
-                if (pair.second.ranges.size() != 0) {
-                    return cached_ready;
-                }
+            ranges.remove_outdated_ranges();
+            if (!ranges.empty()) {
+                return cached_ready;
             }
+            sub->set_unread_fenceposts(std::map<uuid_u, store_key_t>());
             sub->maybe_enable_squashing();
             cached_ready = true;
         }
         return cached_ready;
     }
 
-    bool read_once, cached_ready;
+    bool cached_ready;
     counted_t<datum_stream_t> src;
     optional<active_state_t> active_state;
-    std::map<uuid_u, stamped_range_t> stamped_ranges;
+    splice_ranges_t ranges;
 };
 
 subscription_t::subscription_t(
@@ -3771,6 +4121,7 @@ scoped_ptr_t<subscription_t> new_sub(
                 ss->squash,
                 ss->include_states,
                 ss->include_types,
+                ss->spill_to_disk,
                 env,
                 range);
         }
@@ -3826,6 +4177,7 @@ streamspec_t::streamspec_t(counted_t<datum_stream_t> _maybe_src,
                            bool _include_types,
                            configured_limits_t _limits,
                            datum_t _squash,
+                           bool _spill_to_disk,
                            keyspec_t::spec_t _spec) :
     maybe_src(std::move(_maybe_src)),
     table_name(std::move(_table_name)),
@@ -3834,6 +4186,7 @@ streamspec_t::streamspec_t(counted_t<datum_stream_t> _maybe_src,
     include_types(std::move(_include_types)),
     limits(std::move(_limits)),
     squash(std::move(_squash)),
+    spill_to_disk(_spill_to_disk),
     spec(std::move(_spec)) { }
 
 counted_t<datum_stream_t> client_t::new_stream(
@@ -3841,6 +4194,22 @@ counted_t<datum_stream_t> client_t::new_stream(
     const streamspec_t &ss,
     const namespace_id_t &table_id,
     backtrace_id_t bt) {
+    // Range changefeeds that only `filter` and `map` get a feed to which the shards
+    // send only the changes that pass the transformations, and only the transformed
+    // values.
+    client_t::feed_key_t key(table_id, std::string());
+    std::vector<transform_variant_t> shard_transforms;
+    optional<serializable_env_t> s_env;
+    if (const keyspec_t::range_t *range = boost::get<keyspec_t::range_t>(&ss.spec)) {
+        if (can_apply_on_shard(range->transforms)) {
+            key.second = transforms_id(range->transforms, env);
+            if (!key.second.empty()) {
+                shard_transforms = range->transforms;
+                s_env.set(env->get_serializable_env());
+            }
+        }
+    }
+
     bool is_second_try = false;
     uuid_u last_feed_uuid;
     for (;;) {
@@ -3858,7 +4227,7 @@ counted_t<datum_stream_t> client_t::new_stream(
                 auto_drainer_t::lock_t lock(&drainer, throw_if_draining_t::YES);
                 rwlock_in_line_t spot(&feeds_lock, access_t::write);
                 spot.read_signal()->wait_lazily_unordered();
-                auto feed_it = feeds.find(table_id);
+                auto feed_it = feeds.find(key);
 
                 if (is_second_try) {
                     guarantee(!last_feed_uuid.is_unset());
@@ -3891,11 +4260,12 @@ counted_t<datum_stream_t> client_t::new_stream(
                         this,
                         manager,
                         access.get(),
-                        table_id,
+                        key,
+                        shard_transforms,
+                        s_env,
                         &interruptor,
                         make_lifetime(name_resolver));
-                    feed_it = feeds.insert(
-                        std::make_pair(table_id, std::move(val))).first;
+                    feed_it = feeds.insert(std::make_pair(key, std::move(val))).first;
                 }
 
                 guarantee(feed_it != feeds.end());
@@ -3935,13 +4305,13 @@ counted_t<datum_stream_t> client_t::new_stream(
 }
 
 void client_t::maybe_remove_feed(
-    const auto_drainer_t::lock_t &lock, const uuid_u &uuid) {
+    const auto_drainer_t::lock_t &lock, const feed_key_t &key) {
     assert_thread();
     lock.assert_is_holding(&drainer);
     scoped_ptr_t<real_feed_t> destroy;
     rwlock_in_line_t spot(&feeds_lock, access_t::write);
     spot.write_signal()->wait_lazily_unordered();
-    auto feed_it = feeds.find(uuid);
+    auto feed_it = feeds.find(key);
     // The feed might have disappeared because it may have been detached while
     // we held the lock, in which case we don't need to do anything.  The feed
     // might also have gotten a new subscriber, in which case we don't want to
@@ -3965,7 +4335,7 @@ scoped_ptr_t<real_feed_t> client_t::detach_feed(
     // there's nothing to detach.
     // It's also possible that the feed had been removed and a new feed has since been
     // added for this table uuid, so we need to compare the pointer to `expected_feed`.
-    auto feed_it = feeds.find(expected_feed->get_table_id());
+    auto feed_it = feeds.find(expected_feed->get_key());
     if (feed_it != feeds.end() && feed_it->second.get_or_null() == expected_feed) {
         ret.swap(feed_it->second);
         ret->mark_detached();
@@ -6,6 +6,7 @@
 #include <exception>
 #include <functional>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <utility>
@@ -132,7 +133,8 @@ RDB_DECLARE_SERIALIZABLE(msg_t);
 class real_feed_t;
 struct stamped_msg_t;
 
-typedef mailbox_addr_t<stamped_msg_t> client_addr_t;
+// `server_t`s send messages in batches; see `server_t::send_all`.
+typedef mailbox_addr_t<std::vector<stamped_msg_t> > client_addr_t;
 
 struct keyspec_t {
     struct range_t {
@@ -186,6 +188,9 @@ struct streamspec_t {
     bool include_types;
     configured_limits_t limits;
     datum_t squash;
+    // Whether range changefeeds move changes that don't fit into memory to disk,
+    // rather than dropping them once there are `changefeed_queue_size` of them.
+    bool spill_to_disk;
     keyspec_t::spec_t spec;
     streamspec_t(counted_t<datum_stream_t> _maybe_src,
                  std::string _table_name,
@@ -194,6 +199,7 @@ struct streamspec_t {
                  bool _include_types,
                  configured_limits_t _limits,
                  datum_t _squash,
+                 bool _spill_to_disk,
                  keyspec_t::spec_t _spec);
 };
 
@@ -202,17 +208,89 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::empty_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::limit_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::point_t);
 
+struct stamped_range_t {
+    explicit stamped_range_t(uint64_t _next_expected_stamp)
+        : next_expected_stamp(_next_expected_stamp),
+          left_fencepost(store_key_t::min()) { }
+    const store_key_t &get_right_fencepost() const {
+        return ranges.size() == 0 ? left_fencepost : ranges.back().first.right.key();
+    }
+    uint64_t next_expected_stamp;
+    store_key_t left_fencepost;
+    std::deque<std::pair<key_range_t, uint64_t> > ranges;
+
+    MOVABLE_BUT_NOT_COPYABLE(stamped_range_t);
+};
+
+// The bookkeeping that a `splice_stream_t` does to merge the initial values of a
+// `changes({includeInitial: true})` feed with the changes that arrive while it's
+// reading them.  For each shard it keeps the ranges of keys it has read, with the
+// stamps it read them at.
+class splice_ranges_t {
+public:
+    explicit splice_ranges_t(const std::map<uuid_u, uint64_t> &orig_stamps);
+
+    // Adds the ranges that a read of the initial values got to.
+    void add_read(
+        const std::map<uuid_u, std::pair<key_range_t, uint64_t> >
+            &shard_last_read_stamps);
+    bool has_read() const { return read_once; }
+
+    // Whether the feed should drop a change of the value at `key` (in the index the
+    // initial values are read from), because the values we've read already include
+    // it, or because we haven't read `key` yet and will get the change from the read.
+    bool discard(const store_key_t &key,
+                 const std::pair<uuid_u, uint64_t> &source_stamp);
+
+    // Moves the stamps we expect next ahead once we've consumed all the changes that
+    // the subscription has seen, which are `sub_stamps`.  `sub_queue_empty` says
+    // whether it has queued changes we haven't consumed yet.
+    void skip_to_feed(
+        const std::map<uuid_u, uint64_t> &sub_stamps,
+        bool sub_queue_empty,
+        const std::function<std::map<uuid_u, uint64_t>()> &get_feed_stamps);
+
+    // Forgets the ranges that no change we can still get is older than.
+    void remove_outdated_ranges();
+    // Whether `remove_outdated_ranges()` has forgotten all the ranges.
+    bool empty() const;
+
+    // For each shard, the first key that we haven't read anything from yet.  A
+    // change of values at or after that key is always discarded, so the subscription
+    // doesn't have to queue it (see `is_unread()`).  This is empty until the first
+    // read, because until then we can't tell the keys of the values apart.
+    std::map<uuid_u, store_key_t> unread_fenceposts() const;
+
+private:
+    bool read_once;
+    std::map<uuid_u, stamped_range_t> stamped_ranges;
+
+    DISABLE_COPYING(splice_ranges_t);
+};
+
+// Whether `fenceposts` from `splice_ranges_t::unread_fenceposts()` say that `key` on
+// `shard` hasn't been read yet.
+bool is_unread(const std::map<uuid_u, store_key_t> &fenceposts,
+               const uuid_u &shard,
+               const store_key_t &key);
+
 // The `client_t` exists on the server handling the changefeed query, in the
 // `rdb_context_t`.  When a query subscribes to the changes on a table, it
 // should call `new_stream`.  The `client_t` will give it back a stream of rows.
 // The `client_t` does this by maintaining an internal map from table UUIDs to
 // `real_feed_t`s.  (It does this so that there is at most one `real_feed_t` per
-// <table, client> pair, to prevent redundant cluster messages.)  The actual
+// <table, client> pair, to prevent redundant cluster messages.  The exception are
+// range changefeeds whose transformations the shards apply before sending the
+// changes, which share a `real_feed_t` with the feeds that have the same
+// transformations.)  The actual
 // logic for subscribing to a changefeed server and distributing writes to
 // streams can be found in the `real_feed_t` class.
 class client_t : public home_thread_mixin_t {
 public:
     typedef client_addr_t addr_t;
+    // The table, and the `transforms_id()` of the transformations that the shards
+    // apply for the feed (or an empty string if they send unmodified changes).
+    typedef std::pair<namespace_id_t, std::string> feed_key_t;
     client_t(
         mailbox_manager_t *_manager,
         const std::function<
@@ -229,7 +307,7 @@ public:
         const namespace_id_t &table_id,
         backtrace_id_t bt);
     void maybe_remove_feed(
-        const auto_drainer_t::lock_t &lock, const namespace_id_t &uuid);
+        const auto_drainer_t::lock_t &lock, const feed_key_t &key);
     scoped_ptr_t<real_feed_t> detach_feed(
         const auto_drainer_t::lock_t &lock,
         real_feed_t *expected_feed);
@@ -242,7 +320,7 @@ private:
             signal_t *)
         > const namespace_source;
     name_resolver_t const &name_resolver;
-    std::map<namespace_id_t, scoped_ptr_t<real_feed_t> > feeds;
+    std::map<feed_key_t, scoped_ptr_t<real_feed_t> > feeds;
     // This lock manages access to the `feeds` map.  The `feeds` map needs to be
     // read whenever `new_stream` is called, and needs to be written to whenever
     // `new_stream` is called with a table not already in the `feeds` map, or
@@ -382,6 +460,52 @@ private:
 
 typedef index_queue_t<std::string, datum_t, datum_t, limit_order_t> item_queue_t;
 
+// The rows that a `limit_manager_t` keeps in memory.  `item_queue` is the active set,
+// i.e. the top `limit` rows that the client sees.  `slack` holds up to `slack_size` of
+// the rows right behind them, so that deleting a row from the active set usually
+// doesn't require a read to replace it.  Every row in the table that is in neither of
+// them sorts after all the rows in them.
+class limit_window_t {
+public:
+    limit_window_t(limit_order_t _gt, size_t _limit, size_t _slack_size);
+
+    // Puts the rows that the feed starts with into the active set.
+    void init(const std::vector<item_t> &item_vec);
+
+    // Applies the rows that were deleted and added since the last commit, and records
+    // the rows that entered and left the active set in `real_added` and
+    // `real_deleted`.  Returns whether the active set is short of rows that may be on
+    // disk.  Then the caller should read the next `rows_to_read()` rows after
+    // `*boundary_out`, which is the last row we had in memory before the changes, and
+    // pass them to `add_read()`.
+    MUST_USE bool apply_changes(
+        const std::set<std::string> &deleted,
+        const std::map<std::string, std::pair<datum_t, datum_t> > &added,
+        optional<item_t> *boundary_out,
+        item_queue_t *real_added,
+        std::set<std::string> *real_deleted);
+    size_t rows_to_read() const;
+    void add_read(std::vector<item_t> &&items, item_queue_t *real_added);
+
+    const item_queue_t &get_item_queue() const { return item_queue; }
+    const item_queue_t &get_slack() const { return slack; }
+
+private:
+    // These move rows between `item_queue` and `slack` until `item_queue` holds
+    // `limit` rows or `slack` is empty, and record the rows that entered or left the
+    // active set.
+    void promote(item_queue_t *real_added);
+    void demote(item_queue_t *real_added, std::set<std::string> *real_deleted);
+
+    limit_order_t gt;
+    const size_t limit;
+    const size_t slack_size;
+    item_queue_t item_queue;
+    item_queue_t slack;
+
+    DISABLE_COPYING(limit_window_t);
+};
+
 struct primary_ref_t {
     btree_slice_t *btree;
     real_superblock_t *superblock;
@@ -448,7 +572,7 @@ private:
     std::vector<scoped_ptr_t<op_t> > ops;
 
     limit_order_t gt;
-    item_queue_t item_queue;
+    limit_window_t window;
 
     std::map<std::string, std::pair<datum_t, datum_t> > added;
     std::set<std::string> deleted;
@@ -469,9 +593,14 @@ public:
         limit_addr_t;
     explicit server_t(mailbox_manager_t *_manager, store_t *_parent);
     ~server_t();
+    // If `transforms` isn't empty, they're applied to changes before they're sent
+    // to `addr`, and changes that they filter out aren't sent at all.
     void add_client(
         const client_t::addr_t &addr,
         region_t region,
+        const std::vector<transform_variant_t> &transforms,
+        const optional<serializable_env_t> &s_env,
+        rdb_context_t *ctx,
         const auto_drainer_t::lock_t &keepalive);
     void add_limit_client(
         const client_t::addr_t &addr,
@@ -538,6 +667,9 @@ private:
         std::map<optional<std::string>,
                  std::vector<scoped_ptr_t<limit_manager_t>>> limit_clients;
         scoped_ptr_t<rwlock_t> limit_clients_lock;
+        // The transformations that `add_client` was called with.
+        scoped_ptr_t<env_t> env;
+        std::vector<scoped_ptr_t<op_t> > ops;
     };
     std::map<client_t::addr_t, client_info_t> clients;
 
@@ -552,6 +684,14 @@ private:
                             msg_t msg,
                             const auto_drainer_t::lock_t &lock);
 
+    // `send_all` doesn't send the changes right away, but queues them up here with
+    // their stamps.  `flush_pending_cb` then sends each client all the changes that
+    // accumulated while the current coroutine was running, in a single mailbox
+    // message.  On busy tables this saves us most of the mailbox messages.
+    void flush_pending_cb(auto_drainer_t::lock_t keepalive);
+    std::map<client_t::addr_t, std::vector<std::pair<uint64_t, msg_t> > > pending;
+    bool flush_scheduled;
+
     // Controls access to `clients`.  A `server_t` needs to read `clients` when:
     // * `send_all` is called
     // * `get_stamp` is called
@@ -0,0 +1,215 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/changefeed_queue.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/coroutines.hpp"
+#include "containers/archive/optional.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/disk_backed_queue.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "rpc/serialize_macros.hpp"
+
+namespace ql {
+
+namespace changefeed {
+
+// The serializable form of a `change_val_t`, for `spilling_queue_t`.
+struct spilled_change_t {
+    spilled_change_t() { }
+    explicit spilled_change_t(change_val_t &&cv)
+        : source_stamp(std::move(cv.source_stamp)),
+          pkey(std::move(cv.pkey)) {
+        if (cv.old_val) {
+            old_val.set(std::move(cv.old_val->val));
+            old_index_key = std::move(cv.old_val->btree_index_key);
+        }
+        if (cv.new_val) {
+            new_val.set(std::move(cv.new_val->val));
+            new_index_key = std::move(cv.new_val->btree_index_key);
+        }
+    }
+    change_val_t to_change_val() {
+        return change_val_t(
+            source_stamp,
+            pkey,
+            old_val
+                ? make_optional(indexed_datum_t(std::move(*old_val),
+                                                std::move(old_index_key)))
+                : r_nullopt,
+            new_val
+                ? make_optional(indexed_datum_t(std::move(*new_val),
+                                                std::move(new_index_key)))
+                : r_nullopt
+            DEBUG_ONLY(, r_nullopt));
+    }
+    std::pair<uuid_u, uint64_t> source_stamp;
+    store_key_t pkey;
+    optional<datum_t> old_val;
+    optional<std::string> old_index_key;
+    optional<datum_t> new_val;
+    optional<std::string> new_index_key;
+};
+RDB_MAKE_SERIALIZABLE_6(spilled_change_t,
+                        source_stamp, pkey,
+                        old_val, old_index_key,
+                        new_val, new_index_key);
+
+spilling_queue_t::spilling_queue_t(io_backender_t *_io_backender,
+                                   base_path_t _base_path,
+                                   size_t _memory_limit,
+                                   int64_t _disk_limit)
+    : io_backender(_io_backender),
+      base_path(std::move(_base_path)),
+      memory_limit(std::max<size_t>(_memory_limit / 2, 1)),
+      disk_limit(_disk_limit),
+      spill_new_changes(false),
+      spilling(false),
+      dropping_disk_queue(false),
+      num_in_flight(0),
+      num_to_discard(0) {
+    guarantee(io_backender != nullptr);
+}
+
+spilling_queue_t::~spilling_queue_t() { }
+
+void spilling_queue_t::add(change_val_t change_val) {
+    if (!spill_new_changes && head.size() < memory_limit) {
+        head.push_back(std::move(change_val));
+        return;
+    }
+    // Changes have to come out in order, so once we've started spilling, the new
+    // ones go behind the ones on disk.
+    spill_new_changes = true;
+    tail.push_back(std::move(change_val));
+    if (!spilling) {
+        spilling = true;
+        coro_t::spawn_sometime(std::bind(&spilling_queue_t::spill_cb, this,
+                                         auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+size_t spilling_queue_t::size() const {
+    return memory_size() + num_on_disk() - num_to_discard;
+}
+
+size_t spilling_queue_t::memory_size() const {
+    return head.size() + num_in_flight + tail.size();
+}
+
+bool spilling_queue_t::over_disk_limit() const {
+    // The discarded changes still take up the disk until `drop_disk_queue_cb` runs.
+    return !dropping_disk_queue
+        && disk_queue.has()
+        && disk_queue->disk_size() > disk_limit;
+}
+
+void spilling_queue_t::clear() {
+    head.clear();
+    tail.clear();
+    // We can't touch the disk queue without blocking, so we skip its changes (and
+    // the ones that `spill_cb` is writing) when we get to them.
+    num_to_discard = num_on_disk() + num_in_flight;
+    // Everything on disk is going to be skipped, so the next changes can go in front
+    // of it again.
+    spill_new_changes = false;
+    if (num_to_discard > 0 && !dropping_disk_queue) {
+        dropping_disk_queue = true;
+        coro_t::spawn_sometime(std::bind(&spilling_queue_t::drop_disk_queue_cb, this,
+                                         auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+const change_val_t &spilling_queue_t::peek() {
+    load_head();
+    guarantee(!head.empty());
+    return head.front();
+}
+
+change_val_t spilling_queue_t::pop() {
+    load_head();
+    guarantee(!head.empty());
+    change_val_t ret = std::move(head.front());
+    head.pop_front();
+    return ret;
+}
+
+void spilling_queue_t::purge_below(std::map<uuid_u, uint64_t> stamps) {
+    for (size_t i = size(); i > 0; --i) {
+        change_val_t cv = pop();
+        auto it = stamps.find(cv.source_stamp.first);
+        r_sanity_check(it != stamps.end());
+        if (cv.source_stamp.second >= it->second) {
+            add(std::move(cv));
+        }
+    }
+}
+
+size_t spilling_queue_t::num_on_disk() const {
+    return disk_queue.has() ? static_cast<size_t>(disk_queue->size()) : 0;
+}
+
+void spilling_queue_t::spill_cb(auto_drainer_t::lock_t keepalive) {
+    while (!keepalive.get_drain_signal()->is_pulsed()) {
+        mutex_t::acq_t acq(&disk_mutex);
+        if (tail.empty()) {
+            break;
+        }
+        std::deque<change_val_t> batch;
+        batch.swap(tail);
+        num_in_flight = batch.size();
+        if (!disk_queue.has()) {
+            disk_queue.init(new disk_backed_queue_t<spilled_change_t>(
+                io_backender,
+                serializer_filepath_t(
+                    base_path, "changefeed_queue_" + uuid_to_str(generate_uuid())),
+                &get_global_perfmon_collection()));
+        }
+        for (auto &&cv : batch) {
+            disk_queue->push(spilled_change_t(std::move(cv)));
+            --num_in_flight;
+        }
+    }
+    spilling = false;
+}
+
+void spilling_queue_t::drop_disk_queue_cb(auto_drainer_t::lock_t) {
+    mutex_t::acq_t acq(&disk_mutex);
+    dropping_disk_queue = false;
+    // `spill_cb` may have written new changes behind the discarded ones in the
+    // meantime.  Then the reader has to skip past the discarded ones.
+    if (disk_queue.has() && num_to_discard == num_on_disk()) {
+        disk_queue.reset();
+        num_to_discard = 0;
+    }
+}
+
+void spilling_queue_t::load_head() {
+    if (!head.empty()) {
+        return;
+    }
+    mutex_t::acq_t acq(&disk_mutex);
+    while (disk_queue.has() && !disk_queue->empty()
+           && head.size() < memory_limit) {
+        spilled_change_t spilled;
+        disk_queue->pop(&spilled);
+        if (num_to_discard > 0) {
+            --num_to_discard;
+        } else {
+            head.push_back(spilled.to_change_val());
+        }
+    }
+    if (!disk_queue.has() || disk_queue->empty()) {
+        // Everything that's left is in memory, so we can stop spilling.
+        guarantee(num_to_discard == 0);
+        while (!tail.empty()) {
+            head.push_back(std::move(tail.front()));
+            tail.pop_front();
+        }
+        spill_new_changes = false;
+    }
+}
+
+}  // namespace changefeed
+
+}  // namespace ql
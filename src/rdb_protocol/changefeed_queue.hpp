@@ -0,0 +1,153 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_CHANGEFEED_QUEUE_HPP_
+#define RDB_PROTOCOL_CHANGEFEED_QUEUE_HPP_
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "btree/keys.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/mutex.hpp"
+#include "containers/optional.hpp"
+#include "containers/scoped.hpp"
+#include "containers/uuid.hpp"
+#include "paths.hpp"
+#include "rdb_protocol/datum.hpp"
+
+class io_backender_t;
+template <class T> class disk_backed_queue_t;
+
+namespace ql {
+
+namespace changefeed {
+
+struct indexed_datum_t {
+    indexed_datum_t(
+            datum_t _val,
+            optional<std::string> _btree_index_key)
+        : val(std::move(_val)),
+          btree_index_key(std::move(_btree_index_key)) {
+        guarantee(val.has());
+    }
+    datum_t val;
+    optional<std::string> btree_index_key;
+
+    MOVABLE_BUT_NOT_COPYABLE(indexed_datum_t);
+};
+
+struct change_val_t {
+    change_val_t(std::pair<uuid_u, uint64_t> _source_stamp,
+                 const store_key_t &_pkey,
+                 optional<indexed_datum_t> _old_val,
+                 optional<indexed_datum_t> _new_val
+                 DEBUG_ONLY(, optional<std::string> _sindex))
+        : source_stamp(std::move(_source_stamp)),
+          pkey(_pkey),
+          old_val(std::move(_old_val)),
+          new_val(std::move(_new_val))
+          DEBUG_ONLY(, sindex(std::move(_sindex))) {
+        guarantee(old_val || new_val);
+        if (old_val && new_val) {
+            guarantee(static_cast<bool>(old_val->btree_index_key)
+                == static_cast<bool>(new_val->btree_index_key));
+            rassert(old_val->val != new_val->val);
+        }
+    }
+    std::pair<uuid_u, uint64_t> source_stamp;
+    store_key_t pkey;
+    optional<indexed_datum_t> old_val;
+    optional<indexed_datum_t> new_val;
+    DEBUG_ONLY(optional<std::string> sindex;);
+
+    MOVABLE_BUT_NOT_COPYABLE(change_val_t);
+};
+
+class maybe_squashing_queue_t {
+public:
+    virtual ~maybe_squashing_queue_t() { }
+    virtual void add(change_val_t change_val) = 0;
+    virtual size_t size() const = 0;
+    virtual void clear() = 0;
+    virtual change_val_t pop() = 0;
+    virtual const change_val_t &peek() = 0;
+    virtual void purge_below(std::map<uuid_u, uint64_t> stamps) = 0;
+    // The number of changes that are held in memory, which is what
+    // `changefeed_queue_size` limits.
+    virtual size_t memory_size() const { return size(); }
+    // Whether the queue takes up more disk space than it may.  Like a queue that
+    // holds too many changes in memory, it should then be cleared.
+    virtual bool over_disk_limit() const { return false; }
+};
+
+struct spilled_change_t;
+
+// A non-squashing queue for `changes(spill_to_disk=true)`.  It keeps the oldest
+// changes in memory, and once it has `memory_limit` of them, new changes go to a
+// `disk_backed_queue_t` until the reader catches up.  We can't block in `add()` (it's
+// called while the feed's locks are held), so `add()` only puts the new changes in
+// `tail`, and `spill_cb` moves them to disk in the background.  Reading may block
+// to load changes from disk.  Once the changes on disk take up more than
+// `disk_limit` bytes, `over_disk_limit()` says so, and `clear()` deletes them in the
+// background.
+class spilling_queue_t final : public maybe_squashing_queue_t {
+public:
+    spilling_queue_t(io_backender_t *_io_backender,
+                     base_path_t _base_path,
+                     size_t _memory_limit,
+                     int64_t _disk_limit);
+    ~spilling_queue_t();
+
+    void add(change_val_t change_val) final;
+    size_t size() const final;
+    size_t memory_size() const final;
+    bool over_disk_limit() const final;
+    void clear() final;
+    const change_val_t &peek() final;
+    change_val_t pop() final;
+    void purge_below(std::map<uuid_u, uint64_t> stamps) final;
+
+private:
+    size_t num_on_disk() const;
+
+    void spill_cb(auto_drainer_t::lock_t keepalive);
+    // Deletes `disk_queue` once everything in it has been discarded by `clear()`.
+    void drop_disk_queue_cb(auto_drainer_t::lock_t keepalive);
+
+    // Makes sure that `head` isn't empty, unless the whole queue is.
+    void load_head();
+
+    io_backender_t *const io_backender;
+    const base_path_t base_path;
+    const size_t memory_limit;
+    const int64_t disk_limit;
+
+    // The oldest changes.
+    std::deque<change_val_t> head;
+    // Changes that didn't fit into `head`, in the order they came after it.
+    scoped_ptr_t<disk_backed_queue_t<spilled_change_t> > disk_queue;
+    // New changes on their way to `disk_queue`.
+    std::deque<change_val_t> tail;
+    bool spill_new_changes;
+
+    // Held while moving changes in and out of `disk_queue`.
+    mutex_t disk_mutex;
+    bool spilling;
+    bool dropping_disk_queue;
+    // The changes that `spill_cb` has taken out of `tail` but hasn't written yet.
+    size_t num_in_flight;
+    // Changes at the front of `disk_queue` (or in flight to it) that were dropped by
+    // `clear()`.
+    size_t num_to_discard;
+
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(spilling_queue_t);
+};
+
+}  // namespace changefeed
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_CHANGEFEED_QUEUE_HPP_
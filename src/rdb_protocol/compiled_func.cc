@@ -0,0 +1,297 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/compiled_func.hpp"
+
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/sym.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+// Deeper functions are rare, and we don't want to recurse too far on a coroutine
+// stack.
+const size_t COMPILED_FUNC_MAX_DEPTH = 32;
+
+counted_t<const compiled_func_t> compiled_func_t::compile(
+        const std::vector<sym_t> &arg_names, const raw_term_t &body) {
+    if (arg_names.size() != 1) {
+        return counted_t<const compiled_func_t>();
+    }
+    scoped_ptr_t<compiled_func_t> res(new compiled_func_t());
+    if (!res->compile_term(arg_names, body, 0, &res->root)) {
+        return counted_t<const compiled_func_t>();
+    }
+    return counted_t<const compiled_func_t>(res.release());
+}
+
+counted_t<const compiled_func_t> compiled_func_t::get_filter(const func_t *f) {
+    const reql_func_t *reql_func = dynamic_cast<const reql_func_t *>(f);
+    if (reql_func == nullptr || !reql_func->compiled.has()
+        || reql_func->compiled->nodes[reql_func->compiled->root].type
+           == node_type_t::CONSTANT) {
+        return counted_t<const compiled_func_t>();
+    }
+    return reql_func->compiled;
+}
+
+bool compiled_func_t::compile_term(const std::vector<sym_t> &arg_names,
+                                   const raw_term_t &term, size_t depth,
+                                   size_t *index_out) {
+    if (depth > COMPILED_FUNC_MAX_DEPTH) {
+        return false;
+    }
+    // `_NO_RECURSE_` only matters for sequences, and we give up on those anyway.
+    bool has_other_optargs = false;
+    term.each_optarg([&](const raw_term_t &, const std::string &name) {
+        if (name != "_NO_RECURSE_") {
+            has_other_optargs = true;
+        }
+    });
+    if (has_other_optargs) {
+        return false;
+    }
+
+    node_t node;
+    switch (static_cast<int>(term.type())) {
+    case Term::VAR: {
+        if (term.num_args() != 1) return false;
+        const datum_t name = term.arg(0).datum();
+        if (name.get_type() != datum_t::R_NUM
+            || name.as_int() != arg_names[0].value) {
+            // A variable from an enclosing scope.
+            return false;
+        }
+        node.type = node_type_t::ROW;
+    } break;
+    case Term::IMPLICIT_VAR: {
+        // If the function emits the implicit variable, `r.row` in its body can only
+        // refer to its argument.
+        if (!function_emits_implicit_variable(arg_names)) return false;
+        node.type = node_type_t::ROW;
+    } break;
+    case Term::DATUM: {
+        node.type = node_type_t::CONSTANT;
+        node.constant = term.datum();
+    } break;
+    case Term::GET_FIELD: // fallthru
+    case Term::BRACKET: {
+        if (term.num_args() != 2) return false;
+        const raw_term_t field = term.arg(1);
+        if (field.type() != Term::DATUM) return false;
+        const datum_t field_name = field.datum();
+        // `bracket` with a number is `nth`.
+        if (field_name.get_type() != datum_t::R_STR) return false;
+        node.type = node_type_t::GET_FIELD;
+        node.field = field_name.as_str();
+    } break;
+    case Term::ADD: node.type = node_type_t::ADD; break;
+    case Term::SUB: node.type = node_type_t::SUB; break;
+    case Term::MUL: node.type = node_type_t::MUL; break;
+    case Term::DIV: node.type = node_type_t::DIV; break;
+    case Term::EQ: node.type = node_type_t::EQ; break;
+    case Term::NE: node.type = node_type_t::NE; break;
+    case Term::LT: node.type = node_type_t::LT; break;
+    case Term::LE: node.type = node_type_t::LE; break;
+    case Term::GT: node.type = node_type_t::GT; break;
+    case Term::GE: node.type = node_type_t::GE; break;
+    case Term::AND: node.type = node_type_t::AND; break;
+    case Term::OR: node.type = node_type_t::OR; break;
+    case Term::NOT: node.type = node_type_t::NOT; break;
+    default:
+        return false;
+    }
+
+    // Argument counts that the terms' `argspec_t`s would reject are left to the
+    // interpreter to report.
+    size_t num_children;
+    switch (node.type) {
+    case node_type_t::ROW: // fallthru
+    case node_type_t::CONSTANT:
+        num_children = 0;
+        break;
+    case node_type_t::GET_FIELD:
+        num_children = 1;
+        break;
+    case node_type_t::ADD: // fallthru
+    case node_type_t::SUB: // fallthru
+    case node_type_t::MUL: // fallthru
+    case node_type_t::DIV:
+        if (term.num_args() < 1) return false;
+        num_children = term.num_args();
+        break;
+    case node_type_t::EQ: // fallthru
+    case node_type_t::NE: // fallthru
+    case node_type_t::LT: // fallthru
+    case node_type_t::LE: // fallthru
+    case node_type_t::GT: // fallthru
+    case node_type_t::GE:
+        if (term.num_args() < 2) return false;
+        num_children = term.num_args();
+        break;
+    case node_type_t::AND: // fallthru
+    case node_type_t::OR:
+        num_children = term.num_args();
+        break;
+    case node_type_t::NOT:
+        if (term.num_args() != 1) return false;
+        num_children = 1;
+        break;
+    default: unreachable();
+    }
+    for (size_t i = 0; i < num_children; ++i) {
+        size_t child;
+        if (!compile_term(arg_names, term.arg(i), depth + 1, &child)) return false;
+        node.children.push_back(child);
+    }
+
+    *index_out = nodes.size();
+    nodes.push_back(std::move(node));
+    return true;
+}
+
+bool compiled_func_t::call(const datum_t &arg, datum_t *out) const {
+    try {
+        return eval(root, arg, out);
+    } catch (const base_exc_t &) {
+        // Let the interpreter produce the error.
+        return false;
+    }
+}
+
+void compiled_func_t::filter_batch(const std::vector<datum_t> &rows,
+                                   std::vector<filter_result_t> *results_out) const {
+    results_out->resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        datum_t res;
+        if (!call(rows[i], &res)) {
+            (*results_out)[i] = filter_result_t::UNKNOWN;
+        } else {
+            (*results_out)[i] = res.as_bool()
+                ? filter_result_t::MATCH
+                : filter_result_t::NO_MATCH;
+        }
+    }
+}
+
+bool compiled_func_t::eval(size_t index, const datum_t &row, datum_t *out) const {
+    const node_t &node = nodes[index];
+    switch (node.type) {
+    case node_type_t::ROW:
+        *out = row;
+        return true;
+    case node_type_t::CONSTANT:
+        *out = node.constant;
+        return true;
+    case node_type_t::GET_FIELD: {
+        datum_t obj;
+        if (!eval(node.children[0], row, &obj)) return false;
+        // `get_field` maps over arrays, and refuses most pseudotypes.
+        if (obj.get_type() != datum_t::R_OBJECT || obj.is_ptype()) return false;
+        *out = obj.get_field(node.field, NOTHROW);
+        return out->has();
+    }
+    case node_type_t::ADD: // fallthru
+    case node_type_t::SUB: // fallthru
+    case node_type_t::MUL: // fallthru
+    case node_type_t::DIV: {
+        // We only do arithmetic on numbers.  Strings, arrays and times go to
+        // `arith_term_t`, and so do division by zero and non-finite results, which
+        // `datum_t` throws on.
+        datum_t acc;
+        if (!eval(node.children[0], row, &acc)) return false;
+        if (acc.get_type() != datum_t::R_NUM) return false;
+        for (size_t i = 1; i < node.children.size(); ++i) {
+            datum_t rhs;
+            if (!eval(node.children[i], row, &rhs)) return false;
+            if (rhs.get_type() != datum_t::R_NUM) return false;
+            const double l = acc.as_num();
+            const double r = rhs.as_num();
+            switch (node.type) {
+            case node_type_t::ADD: acc = datum_t(l + r); break;
+            case node_type_t::SUB: acc = datum_t(l - r); break;
+            case node_type_t::MUL: acc = datum_t(l * r); break;
+            case node_type_t::DIV:
+                if (r == 0) return false;
+                acc = datum_t(l / r);
+                break;
+            case node_type_t::ROW:
+            case node_type_t::CONSTANT:
+            case node_type_t::GET_FIELD:
+            case node_type_t::EQ:
+            case node_type_t::NE:
+            case node_type_t::LT:
+            case node_type_t::LE:
+            case node_type_t::GT:
+            case node_type_t::GE:
+            case node_type_t::AND:
+            case node_type_t::OR:
+            case node_type_t::NOT:
+            default: unreachable();
+            }
+        }
+        *out = std::move(acc);
+        return true;
+    }
+    case node_type_t::EQ: // fallthru
+    case node_type_t::NE: // fallthru
+    case node_type_t::LT: // fallthru
+    case node_type_t::LE: // fallthru
+    case node_type_t::GT: // fallthru
+    case node_type_t::GE: {
+        // Like `predicate_term_t`, we stop evaluating arguments at the first pair that
+        // doesn't satisfy the predicate.
+        datum_t lhs;
+        if (!eval(node.children[0], row, &lhs)) return false;
+        bool all_true = true;
+        for (size_t i = 1; i < node.children.size() && all_true; ++i) {
+            datum_t rhs;
+            if (!eval(node.children[i], row, &rhs)) return false;
+            switch (node.type) {
+            case node_type_t::EQ: // fallthru
+            case node_type_t::NE: all_true = lhs == rhs; break;
+            case node_type_t::LT: all_true = lhs.cmp(rhs) < 0; break;
+            case node_type_t::LE: all_true = lhs.cmp(rhs) <= 0; break;
+            case node_type_t::GT: all_true = lhs.cmp(rhs) > 0; break;
+            case node_type_t::GE: all_true = lhs.cmp(rhs) >= 0; break;
+            case node_type_t::ROW:
+            case node_type_t::CONSTANT:
+            case node_type_t::GET_FIELD:
+            case node_type_t::ADD:
+            case node_type_t::SUB:
+            case node_type_t::MUL:
+            case node_type_t::DIV:
+            case node_type_t::AND:
+            case node_type_t::OR:
+            case node_type_t::NOT:
+            default: unreachable();
+            }
+            lhs = std::move(rhs);
+        }
+        *out = datum_t::boolean(node.type == node_type_t::NE ? !all_true : all_true);
+        return true;
+    }
+    case node_type_t::AND: // fallthru
+    case node_type_t::OR: {
+        // Like `and_term_t` and `or_term_t`, this returns the last argument it
+        // evaluated.
+        const bool is_and = node.type == node_type_t::AND;
+        *out = datum_t::boolean(is_and);
+        for (size_t child : node.children) {
+            if (!eval(child, row, out)) return false;
+            if (out->as_bool() != is_and) break;
+        }
+        return true;
+    }
+    case node_type_t::NOT: {
+        datum_t arg;
+        if (!eval(node.children[0], row, &arg)) return false;
+        *out = datum_t::boolean(!arg.as_bool());
+        return true;
+    }
+    default: unreachable();
+    }
+}
+
+}  // namespace ql
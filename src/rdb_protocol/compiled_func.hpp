@@ -0,0 +1,92 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_COMPILED_FUNC_HPP_
+#define RDB_PROTOCOL_COMPILED_FUNC_HPP_
+
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/sym.hpp"
+
+namespace ql {
+
+class func_t;
+class raw_term_t;
+
+/* A function of one argument that is evaluated directly on datums, without building a
+`var_scope_t` or going through `term_t::eval()`.  Only a small subset of ReQL compiles:
+field accesses on the argument with constant field names, constants, arithmetic on
+numbers, the comparison operators, `and`, `or` and `not`.  That covers functions like
+`r.row('a')`, `x('a').add(x('b'))` and `r.row('a').gt(5).and(r.row('b').eq('x'))`,
+which make up most of the functions in `map`, `filter`, `order_by` and secondary
+indexes.
+
+Fields are looked up with `datum_t::get_field()`, so on rows that are backed by a
+serialized buffer only the fields that the function reads get decoded.
+
+Whenever evaluating the function on a row would have thrown (say because the field is
+missing, which a `default` might handle), the compiled function gives up on that row,
+and the caller has to evaluate the function normally.  That way errors and `default`
+handling come straight from the interpreter. */
+class compiled_func_t : public slow_atomic_countable_t<compiled_func_t> {
+public:
+    enum class filter_result_t { NO_MATCH, MATCH, UNKNOWN };
+
+    // Returns an empty pointer unless there is exactly one argument and `body` is in
+    // the subset we can compile.
+    static counted_t<const compiled_func_t> compile(
+        const std::vector<sym_t> &arg_names, const raw_term_t &body);
+
+    // Returns the compiled form of `f`, if it has one and `filter` can use its result
+    // as is.  Constant bodies can't be used, because objects in them get matched
+    // against the row.
+    static counted_t<const compiled_func_t> get_filter(const func_t *f);
+
+    // Sets `*out` to the function's result for `arg`.  Returns `false` where the
+    // interpreter might throw.
+    bool call(const datum_t &arg, datum_t *out) const;
+
+    // Sets `(*results_out)[i]` to the result of the filter for `rows[i]`.
+    void filter_batch(const std::vector<datum_t> &rows,
+                      std::vector<filter_result_t> *results_out) const;
+
+private:
+    enum class node_type_t {
+        ROW,
+        CONSTANT,
+        GET_FIELD,
+        ADD, SUB, MUL, DIV,
+        EQ, NE, LT, LE, GT, GE,
+        AND,
+        OR,
+        NOT
+    };
+
+    struct node_t {
+        node_type_t type;
+        std::vector<size_t> children;
+        // The value of a `CONSTANT`.
+        datum_t constant;
+        // The field name of a `GET_FIELD`.
+        datum_string_t field;
+    };
+
+    compiled_func_t() { }
+
+    // Appends the node for `term` and its children to `nodes`, and returns its index.
+    // Returns `false` if `term` doesn't compile.
+    bool compile_term(const std::vector<sym_t> &arg_names, const raw_term_t &term,
+                      size_t depth, size_t *index_out);
+
+    // Returns `false` where the interpreter might throw.
+    bool eval(size_t index, const datum_t &row, datum_t *out) const;
+
+    std::vector<node_t> nodes;
+    size_t root;
+
+    DISABLE_COPYING(compiled_func_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_COMPILED_FUNC_HPP_
@@ -54,11 +54,13 @@ void sindex_status_t::accum(const sindex_status_t &other) {
     progress_denominator += other.progress_denominator;
     ready &= other.ready;
     start_time = std::min(start_time, other.start_time);
+    rows_constructed += other.rows_constructed;
     rassert(outdated == other.outdated);
 }
 
-RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(sindex_status_t,
-    progress_numerator, progress_denominator, ready, outdated, start_time);
+RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(sindex_status_t,
+    progress_numerator, progress_denominator, ready, outdated, start_time,
+    rows_constructed);
 
 const char *rql_perfmon_name = "query_engine";
 
@@ -72,13 +74,21 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      query_latency_membership(&qe_stats_collection,
+                               &query_latency, "query_latency"),
+      table_writes_per_sec(secs_to_ticks(60)),
+      table_writes_per_sec_membership(&qe_stats_collection,
+                                      &table_writes_per_sec,
+                                      "table_writes_per_sec") { }
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      slow_query_threshold_ms(0),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -90,6 +100,8 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      slow_query_threshold_ms(0),
       stats(&get_global_perfmon_collection()) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -101,11 +113,17 @@ rdb_context_t::rdb_context_t(
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path,
+        uint64_t _slow_query_threshold_ms)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
+      io_backender(_io_backender),
+      base_path(_base_path),
+      slow_query_threshold_ms(_slow_query_threshold_ms),
       stats(global_stats) {
     init_auth_watchables(auth_semilattice_view);
 }
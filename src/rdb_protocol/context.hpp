@@ -15,6 +15,7 @@
 #include "containers/optional.hpp"
 #include "containers/scoped.hpp"
 #include "containers/uuid.hpp"
+#include "paths.hpp"
 #include "perfmon/perfmon.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
@@ -45,6 +46,7 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
 class auth_semilattice_metadata_t;
 class ellipsoid_spec_t;
 class extproc_pool_t;
+class io_backender_t;
 class name_string_t;
 class namespace_interface_t;
 template <class> class cross_thread_watchable_variable_t;
@@ -100,7 +102,8 @@ public:
         progress_denominator(0),
         ready(true),
         outdated(false),
-        start_time(-1) { }
+        start_time(-1),
+        rows_constructed(0) { }
     void accum(const sindex_status_t &other);
     double progress_numerator;
     double progress_denominator;
@@ -112,6 +115,8 @@ public:
         `void serialize(write_message_t *wm, const batchspec_t &batchspec)`,
     but that's relatively expensive. */
     microtime_t start_time;
+    /* The number of rows that have been put into the index since `start_time`. */
+    int64_t rows_constructed;
 };
 RDB_DECLARE_SERIALIZABLE(sindex_status_t);
 
@@ -134,12 +139,16 @@ public:
         p.num_shards = 1;
         p.primary_replica_tag = name_string_t::guarantee_valid("default");
         p.num_replicas[p.primary_replica_tag] = 1;
+        p.primary_near_writes = false;
         return p;
     }
     size_t num_shards;
     std::map<name_string_t, size_t> num_replicas;
     std::set<name_string_t> nonvoting_replica_tags;
     name_string_t primary_replica_tag;
+    /* If this is set, primary replicas go to the servers that the table's writes
+    come from, or to servers that share a server tag with them. */
+    bool primary_near_writes;
 };
 
 enum class admin_identifier_format_t {
@@ -202,6 +211,17 @@ public:
         dist_unit_t dist_unit,
         const ql::configured_limits_t &limits) = 0;
 
+    // Picks up to `n` rows of the table at random without reading all of them.
+    // Returns false if the table can't do that, and the caller has to sample all of
+    // its rows instead.
+    virtual bool read_sample(
+        ql::env_t *,
+        size_t,
+        read_mode_t,
+        std::vector<ql::datum_t> *) {
+        return false;
+    }
+
     virtual ql::datum_t write_batched_replace(
         ql::env_t *env,
         const std::vector<ql::datum_t> &keys,
@@ -275,6 +295,7 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            uint32_t block_size,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
@@ -361,12 +382,14 @@ public:
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
             const name_string_t &name,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
     virtual bool db_rebalance(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
+            rebalance_mode_t mode,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
@@ -468,7 +491,10 @@ public:
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy);
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path,
+        uint64_t _slow_query_threshold_ms);
 
     ~rdb_context_t();
 
@@ -479,6 +505,16 @@ public:
 
     const std::string reql_http_proxy;
 
+    // Changefeeds with `spill_to_disk` put their queues in files in `base_path`.
+    // `io_backender` is `nullptr` if we don't have a data directory (on proxies and in
+    // most unit tests).
+    io_backender_t *const io_backender;
+    const base_path_t base_path;
+
+    // Queries that spend more than this long evaluating get written to the log. Zero
+    // means that we don't log slow queries.
+    const uint64_t slow_query_threshold_ms;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -493,6 +529,12 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        perfmon_histogram_t query_latency;
+        perfmon_membership_t query_latency_membership;
+        /* The writes that this server sent to each table, keyed by table UUID.
+        `reconfigure()` uses these to put primaries near the tables' writers. */
+        perfmon_keyed_rate_monitor_t table_writes_per_sec;
+        perfmon_membership_t table_writes_per_sec_membership;
     private:
         DISABLE_COPYING(stats_t);
     } stats;
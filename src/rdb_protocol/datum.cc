@@ -5,6 +5,7 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
 #include <cmath>
@@ -17,8 +18,11 @@
 #include "arch/runtime/coroutines.hpp"
 #include "cjson/json.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "containers/archive/varint.hpp"
 #include "containers/scoped.hpp"
+#include "rapidjson/error/en.h"
 #include "rapidjson/prettywriter.h"
+#include "rapidjson/reader.h"
 #include "rapidjson/rapidjson.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
@@ -108,12 +112,12 @@ datum_t::data_wrapper_t::data_wrapper_t(const char *cstr) :
     r_str(cstr), internal_type(internal_type_t::R_STR) { }
 
 datum_t::data_wrapper_t::data_wrapper_t(std::vector<datum_t> &&array) :
-    r_array(new countable_wrapper_t<std::vector<datum_t> >(std::move(array))),
+    r_array(new composite_storage_t<std::vector<datum_t> >(std::move(array))),
     internal_type(internal_type_t::R_ARRAY) { }
 
 datum_t::data_wrapper_t::data_wrapper_t(
         std::vector<std::pair<datum_string_t, datum_t> > &&object) :
-    r_object(new countable_wrapper_t<std::vector<std::pair<datum_string_t, datum_t> > >(
+    r_object(new composite_storage_t<std::vector<std::pair<datum_string_t, datum_t> > >(
         std::move(object))),
     internal_type(internal_type_t::R_OBJECT) {
 
@@ -213,10 +217,10 @@ void datum_t::data_wrapper_t::destruct() {
         r_str.~datum_string_t();
     } break;
     case internal_type_t::R_ARRAY: {
-        r_array.~counted_t<countable_wrapper_t<std::vector<datum_t> > >();
+        r_array.~counted_t<composite_storage_t<std::vector<datum_t> > >();
     } break;
     case internal_type_t::R_OBJECT: {
-        r_object.~counted_t<countable_wrapper_t<std::vector<std::pair<datum_string_t, datum_t> > > >();
+        r_object.~counted_t<composite_storage_t<std::vector<std::pair<datum_string_t, datum_t> > > >();
     } break;
     case internal_type_t::BUF_R_ARRAY: // fallthru
     case internal_type_t::BUF_R_OBJECT: {
@@ -245,10 +249,10 @@ void datum_t::data_wrapper_t::assign_copy(const datum_t::data_wrapper_t &copyee)
         new(&r_str) datum_string_t(copyee.r_str);
     } break;
     case internal_type_t::R_ARRAY: {
-        new(&r_array) counted_t<countable_wrapper_t<std::vector<datum_t> > >(copyee.r_array);
+        new(&r_array) counted_t<composite_storage_t<std::vector<datum_t> > >(copyee.r_array);
     } break;
     case internal_type_t::R_OBJECT: {
-        new(&r_object) counted_t<countable_wrapper_t<std::vector<std::pair<datum_string_t, datum_t> > > >(
+        new(&r_object) counted_t<composite_storage_t<std::vector<std::pair<datum_string_t, datum_t> > > >(
             copyee.r_object);
     } break;
     case internal_type_t::BUF_R_ARRAY: // fallthru
@@ -277,11 +281,11 @@ void datum_t::data_wrapper_t::assign_move(datum_t::data_wrapper_t &&movee) noexc
         new(&r_str) datum_string_t(std::move(movee.r_str));
     } break;
     case internal_type_t::R_ARRAY: {
-        new(&r_array) counted_t<countable_wrapper_t<std::vector<datum_t> > >(
+        new(&r_array) counted_t<composite_storage_t<std::vector<datum_t> > >(
             std::move(movee.r_array));
     } break;
     case internal_type_t::R_OBJECT: {
-        new(&r_object) counted_t<countable_wrapper_t<std::vector<std::pair<datum_string_t, datum_t> > > >(
+        new(&r_object) counted_t<composite_storage_t<std::vector<std::pair<datum_string_t, datum_t> > > >(
             std::move(movee.r_object));
     } break;
     case internal_type_t::BUF_R_ARRAY: // fallthru
@@ -456,8 +460,48 @@ datum_t datum_t::utf8(datum_string_t _data) {
     return datum_t(std::move(_data));
 }
 
+namespace {
+
+/* Hands out the short strings of a JSON document from a few shared buffers, so that
+every key and short value in the document doesn't cost a heap allocation of its own.
+Like the strings of a datum that was read from disk, they keep the whole buffer alive
+for as long as any of them is referenced. */
+class json_string_pool_t {
+public:
+    json_string_pool_t() : chunk_used(0) { }
+
+    datum_string_t make(size_t size, const char *data) {
+        if (size > MAX_POOLED_SIZE) {
+            return datum_string_t(size, data);
+        }
+        const size_t str_offset = varint_uint64_serialized_size(size);
+        if (!chunk.has() || chunk_used + str_offset + size > CHUNK_SIZE) {
+            chunk = shared_buf_t::create(CHUNK_SIZE);
+            chunk_used = 0;
+        }
+        const size_t offset = chunk_used;
+        serialize_varint_uint64_into_buf(
+            size, reinterpret_cast<uint8_t *>(chunk->data(offset)));
+        memcpy(chunk->data(offset + str_offset), data, size);
+        chunk_used += str_offset + size;
+        return datum_string_t(shared_buf_ref_t<char>(chunk, offset));
+    }
+
+private:
+    // Longer strings are copied anyway, so the allocation doesn't matter as much.
+    // Keeping the limit well below the chunk size bounds how much of the last chunk
+    // we waste.
+    static const size_t MAX_POOLED_SIZE = 64;
+    static const size_t CHUNK_SIZE = 4096;
+
+    counted_t<shared_buf_t> chunk;
+    size_t chunk_used;
+
+    DISABLE_COPYING(json_string_pool_t);
+};
+
 datum_t to_datum(const rapidjson::Value &json, const configured_limits_t &limits,
-                 reql_version_t reql_version) {
+                 reql_version_t reql_version, json_string_pool_t *pool) {
     switch(json.GetType()) {
     case rapidjson::kNullType: {
         return datum_t::null();
@@ -476,9 +520,10 @@ datum_t to_datum(const rapidjson::Value &json, const configured_limits_t &limits
                  ++it) {
                 fail_if_invalid(it->name.GetString(),
                                 it->name.GetStringLength());
-                datum_string_t key(it->name.GetStringLength(),
-                                   it->name.GetString());
-                bool dup = builder.add(key, to_datum(it->value, limits, reql_version));
+                datum_string_t key = pool->make(it->name.GetStringLength(),
+                                                it->name.GetString());
+                bool dup = builder.add(
+                    key, to_datum(it->value, limits, reql_version, pool));
                 rcheck_datum(!dup, base_exc_t::LOGIC,
                              strprintf("Duplicate key %s in JSON.",
                                        datum_t(key).print().c_str()));
@@ -494,14 +539,14 @@ datum_t to_datum(const rapidjson::Value &json, const configured_limits_t &limits
             for (rapidjson::Value::ConstValueIterator it = json.Begin();
                  it != json.End();
                  ++it) {
-                builder.add(to_datum(*it, limits, reql_version));
+                builder.add(to_datum(*it, limits, reql_version, pool));
             }
             return std::move(builder).to_datum();
         }, MIN_DATUM_RECURSION_STACK_SPACE);
     } break;
     case rapidjson::kStringType: {
         fail_if_invalid(json.GetString(), json.GetStringLength());
-        return datum_t(datum_string_t(json.GetStringLength(), json.GetString()));
+        return datum_t(pool->make(json.GetStringLength(), json.GetString()));
     } break;
     case rapidjson::kNumberType: {
         return datum_t(json.GetDouble());
@@ -510,6 +555,131 @@ datum_t to_datum(const rapidjson::Value &json, const configured_limits_t &limits
     }
 }
 
+/* A RapidJSON SAX handler that builds the same datum as `to_datum()` would build
+from the document.  Values that are still waiting for their array or object to end
+are kept on flat stacks rather than in a builder per level, and RapidJSON's
+iterative parser keeps the call stack flat too, so deeply nested JSON doesn't need
+any extra stack space. */
+class json_datum_handler_t {
+public:
+    explicit json_datum_handler_t(const configured_limits_t &_limits)
+        : limits(_limits) { }
+
+    bool Null() { return add_value(datum_t::null()); }
+    bool Bool(bool b) { return add_value(datum_t::boolean(b)); }
+    bool Int(int i) { return add_value(datum_t(static_cast<double>(i))); }
+    bool Uint(unsigned u) { return add_value(datum_t(static_cast<double>(u))); }
+    bool Int64(int64_t i) { return add_value(datum_t(static_cast<double>(i))); }
+    bool Uint64(uint64_t u) { return add_value(datum_t(static_cast<double>(u))); }
+    bool Double(double d) { return add_value(datum_t(d)); }
+    bool String(const char *str, rapidjson::SizeType length, bool) {
+        fail_if_invalid(str, length);
+        return add_value(datum_t(pool.make(length, str)));
+    }
+
+    bool StartObject() {
+        frames.push_back(frame_t{true, pairs.size()});
+        return true;
+    }
+    bool Key(const char *str, rapidjson::SizeType length, bool) {
+        fail_if_invalid(str, length);
+        pairs.push_back(std::make_pair(pool.make(length, str), datum_t()));
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        const size_t begin = frames.back().begin;
+        frames.pop_back();
+        std::vector<std::pair<datum_string_t, datum_t> > object(
+            std::make_move_iterator(pairs.begin() + begin),
+            std::make_move_iterator(pairs.end()));
+        pairs.resize(begin);
+        std::stable_sort(object.begin(), object.end(),
+                         [](const std::pair<datum_string_t, datum_t> &a,
+                            const std::pair<datum_string_t, datum_t> &b) {
+                             return a.first < b.first;
+                         });
+        for (size_t i = 1; i < object.size(); ++i) {
+            rcheck_datum(object[i - 1].first != object[i].first, base_exc_t::LOGIC,
+                         strprintf("Duplicate key %s in JSON.",
+                                   datum_t(object[i].first).print().c_str()));
+        }
+        const std::set<std::string> pts = { pseudo::literal_string };
+        return add_value(datum_t(std::move(object), pts));
+    }
+
+    bool StartArray() {
+        frames.push_back(frame_t{false, values.size()});
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        const size_t begin = frames.back().begin;
+        frames.pop_back();
+        std::vector<datum_t> array(std::make_move_iterator(values.begin() + begin),
+                                   std::make_move_iterator(values.end()));
+        values.resize(begin);
+        return add_value(datum_t(std::move(array), limits));
+    }
+
+    datum_t get_result() RVALUE_THIS {
+        guarantee(frames.empty());
+        return std::move(result);
+    }
+
+private:
+    bool add_value(datum_t &&value) {
+        if (frames.empty()) {
+            result = std::move(value);
+        } else if (frames.back().is_object) {
+            pairs.back().second = std::move(value);
+        } else {
+            values.push_back(std::move(value));
+        }
+        return true;
+    }
+
+    struct frame_t {
+        bool is_object;
+        // Where the frame's pairs or values start on `pairs` or `values`.
+        size_t begin;
+    };
+
+    const configured_limits_t limits;
+
+    json_string_pool_t pool;
+    std::vector<frame_t> frames;
+    std::vector<std::pair<datum_string_t, datum_t> > pairs;
+    std::vector<datum_t> values;
+    datum_t result;
+
+    DISABLE_COPYING(json_datum_handler_t);
+};
+
+}  // namespace
+
+datum_t to_datum(const rapidjson::Value &json, const configured_limits_t &limits,
+                 reql_version_t reql_version) {
+    json_string_pool_t pool;
+    return to_datum(json, limits, reql_version, &pool);
+}
+
+datum_t parse_json_insitu_to_datum(char *json,
+                                   const configured_limits_t &limits,
+                                   std::string *error_out) {
+    json_datum_handler_t handler(limits);
+    rapidjson::InsituStringStream stream(json);
+    rapidjson::Reader reader;
+    // `rapidjson::Document` parses with `kParseFullPrecisionFlag` too (see
+    // `RAPIDJSON_PARSE_DEFAULT_FLAGS` in src/build.mk).
+    const rapidjson::ParseResult res = reader.Parse<
+        rapidjson::kParseInsituFlag | rapidjson::kParseIterativeFlag
+        | rapidjson::kParseFullPrecisionFlag>(stream, handler);
+    if (res.IsError()) {
+        *error_out = rapidjson::GetParseError_En(res.Code());
+        return datum_t();
+    }
+    return std::move(handler).get_result();
+}
+
 const shared_buf_ref_t<char> *datum_t::get_buf_ref() const {
     if (data.get_internal_type() == internal_type_t::BUF_R_ARRAY
         || data.get_internal_type() == internal_type_t::BUF_R_OBJECT) {
@@ -519,6 +689,24 @@ const shared_buf_ref_t<char> *datum_t::get_buf_ref() const {
     }
 }
 
+size_t datum_t::get_cached_serialized_size() const {
+    if (data.get_internal_type() == internal_type_t::R_ARRAY) {
+        return data.r_array->serialized_size.load(std::memory_order_relaxed);
+    } else if (data.get_internal_type() == internal_type_t::R_OBJECT) {
+        return data.r_object->serialized_size.load(std::memory_order_relaxed);
+    } else {
+        return 0;
+    }
+}
+
+void datum_t::set_cached_serialized_size(size_t size) const {
+    if (data.get_internal_type() == internal_type_t::R_ARRAY) {
+        data.r_array->serialized_size.store(size, std::memory_order_relaxed);
+    } else if (data.get_internal_type() == internal_type_t::R_OBJECT) {
+        data.r_object->serialized_size.store(size, std::memory_order_relaxed);
+    }
+}
+
 datum_t::type_t datum_t::get_type() const { return data.get_type(); }
 
 bool datum_t::is_ptype() const {
@@ -1487,37 +1675,61 @@ std::pair<datum_string_t, datum_t> datum_t::unchecked_get_pair(size_t index) con
 }
 
 datum_t datum_t::get_field(const datum_string_t &key, throw_bool_t throw_bool) const {
-    // Use binary search on top of unchecked_get_pair()
-    size_t range_beg = 0;
+    return get_field(key.size(), key.data(), throw_bool);
+}
+
+datum_t datum_t::get_field(const char *key, throw_bool_t throw_bool) const {
+    return get_field(strlen(key), key, throw_bool);
+}
+
+datum_t datum_t::get_field(size_t key_size, const char *key_data,
+                           throw_bool_t throw_bool) const {
     // The obj_size() also makes sure that this has the right type (R_OBJECT)
-    size_t range_end = obj_size();
-    while (range_beg < range_end) {
-        const size_t center = range_beg + ((range_end - range_beg) / 2);
-        auto center_pair = unchecked_get_pair(center);
-        const int cmp_res = key.compare(center_pair.first);
-        if (cmp_res == 0) {
-            // Found it
-            return center_pair.second;
-        } else if (cmp_res < 0) {
-            range_end = center;
-        } else {
-            range_beg = center + 1;
+    const size_t num_pairs = obj_size();
+    if (data.get_internal_type() == internal_type_t::R_OBJECT) {
+        // Search the vector in place, so that we only copy the value we find.
+        auto key_cmp = [key_size](const std::pair<datum_string_t, datum_t> &p1,
+                                  const char *k2) -> bool {
+            return p1.first.compare(key_size, k2) < 0;
+        };
+        auto it = std::lower_bound(data.r_object->begin(), data.r_object->end(),
+                                   key_data, key_cmp);
+        if (it != data.r_object->end() && it->first.compare(key_size, key_data) == 0) {
+            return it->second;
+        }
+    } else {
+        // Binary search on the serialized keys, and only deserialize the value once
+        // we've found it.
+        r_sanity_check(data.get_internal_type() == internal_type_t::BUF_R_OBJECT);
+        size_t range_beg = 0;
+        size_t range_end = num_pairs;
+        while (range_beg < range_end) {
+            const size_t center = range_beg + ((range_end - range_beg) / 2);
+            const size_t offset = datum_get_element_offset(data.buf_ref, center);
+            size_t key_ser_size;
+            const int cmp_res = datum_compare_pair_key_in_buf(
+                key_size, key_data, data.buf_ref, offset, &key_ser_size);
+            if (cmp_res == 0) {
+                // Found it
+                return datum_deserialize_from_buf(data.buf_ref, offset + key_ser_size);
+            } else if (cmp_res < 0) {
+                range_end = center;
+            } else {
+                range_beg = center + 1;
+            }
+            rassert(range_beg <= range_end);
         }
-        rassert(range_beg <= range_end);
     }
 
     // Didn't find it
     if (throw_bool == THROW) {
         rfail(base_exc_t::NON_EXISTENCE,
-              "No attribute `%s` in object:\n%s", key.to_std().c_str(), print().c_str());
+              "No attribute `%s` in object:\n%s",
+              std::string(key_data, key_size).c_str(), print().c_str());
     }
     return datum_t();
 }
 
-datum_t datum_t::get_field(const char *key, throw_bool_t throw_bool) const {
-    return get_field(datum_string_t(key), throw_bool);
-}
-
 template <class json_writer_t>
 void datum_t::write_json_unchecked_stack(json_writer_t *writer) const {
     switch (get_type()) {
@@ -1689,6 +1901,7 @@ void datum_t::replace_field(const datum_string_t &key, datum_t val) {
     r_sanity_check(it != data.r_object->end() && it->first == key);
 
     it->second = val;
+    data.r_object->serialized_size.store(0, std::memory_order_relaxed);
 }
 
 datum_t datum_t::default_merge_unchecked_stack(const datum_t &rhs) const {
@@ -1840,6 +2053,166 @@ int datum_t::cmp(const datum_t &rhs) const {
         });
 }
 
+// FNV-1a, because we need the hash to be the same on every platform.
+static const uint64_t DATUM_HASH_OFFSET_BASIS = 14695981039346656037ULL;
+static size_t hash_bytes(size_t h, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t res = h;
+    for (size_t i = 0; i < size; ++i) {
+        res ^= bytes[i];
+        res *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(res);
+}
+static size_t hash_string(size_t h, const datum_string_t &str) {
+    return hash_bytes(h, str.data(), str.size());
+}
+static size_t hash_double(size_t h, double d) {
+    // `-0.0` and `0.0` compare as equal.
+    if (d == 0.0) {
+        d = 0.0;
+    }
+    return hash_bytes(h, &d, sizeof(d));
+}
+
+size_t datum_t::hash_unchecked_stack() const {
+    // This mirrors `cmp_unchecked_stack()`.
+    size_t h = static_cast<size_t>(DATUM_HASH_OFFSET_BASIS);
+    if (is_ptype() && !pseudo_compares_as_obj()) {
+        const std::string reql_type = get_reql_type();
+        h = hash_bytes(h, reql_type.data(), reql_type.size());
+        if (get_type() == R_BINARY) {
+            return hash_string(h, as_binary());
+        } else if (reql_type == pseudo::time_string) {
+            // Times in different time zones are equal.
+            return hash_double(h, pseudo::time_to_epoch_time(*this));
+        }
+        return h;
+    }
+    const uint8_t type = static_cast<uint8_t>(get_type());
+    h = hash_bytes(h, &type, sizeof(type));
+    switch (get_type()) {
+    case R_NULL: return h;
+    case MINVAL: return h;
+    case MAXVAL: return h;
+    case R_BOOL: {
+        const uint8_t b = as_bool();
+        return hash_bytes(h, &b, sizeof(b));
+    }
+    case R_NUM: return hash_double(h, as_num());
+    case R_STR: return hash_string(h, as_str());
+    case R_ARRAY: {
+        const size_t sz = arr_size();
+        for (size_t i = 0; i < sz; ++i) {
+            const size_t el = unchecked_get(i).hash();
+            h = hash_bytes(h, &el, sizeof(el));
+        }
+        return h;
+    }
+    case R_OBJECT: {
+        const size_t sz = obj_size();
+        for (size_t i = 0; i < sz; ++i) {
+            auto pair = unchecked_get_pair(i);
+            h = hash_string(h, pair.first);
+            const size_t val = pair.second.hash();
+            h = hash_bytes(h, &val, sizeof(val));
+        }
+        return h;
+    }
+    case R_BINARY: // This should be handled by the ptype code above
+    case UNINITIALIZED: // fallthru
+    default: unreachable();
+    }
+}
+
+size_t datum_t::hash() const {
+    return call_with_enough_stack_datum<size_t>([&] {
+            return this->hash_unchecked_stack();
+        });
+}
+
+// Strings end with a zero byte, so we escape the zero and one bytes in them.  The
+// escapes still sort below every other byte.
+static void append_escaped_sort_key(const datum_string_t &str, std::string *out) {
+    const char *data = str.data();
+    for (size_t i = 0; i < str.size(); ++i) {
+        if (data[i] == '\x00') {
+            out->append("\x01\x01", 2);
+        } else if (data[i] == '\x01') {
+            out->append("\x01\x02", 2);
+        } else {
+            out->push_back(data[i]);
+        }
+    }
+    out->push_back('\x00');
+}
+
+bool datum_t::append_sort_key_unchecked_stack(std::string *out) const {
+    // This mirrors `cmp_unchecked_stack()` for data without pseudotypes, which are
+    // ordered by `type_t` first.  Every type is at least 1, so the zero byte that
+    // ends arrays and objects sorts before any element.
+    if (is_ptype()) {
+        return false;
+    }
+    out->push_back(static_cast<char>(get_type()));
+    switch (get_type()) {
+    case R_NULL: return true;
+    case MINVAL: return true;
+    case MAXVAL: return true;
+    case R_BOOL:
+        out->push_back(as_bool() ? '\x01' : '\x00');
+        return true;
+    case R_NUM: {
+        // Like `num_to_str_key()`, we flip the bits so that the bytes of the number
+        // compare the way the numbers do.
+        double value = as_num();
+        if (value == 0.0) {
+            value = 0.0;
+        }
+        uint64_t bits;
+        static_assert(sizeof(bits) == sizeof(value), "double isn't 64 bits");
+        memcpy(&bits, &value, sizeof(bits));
+        bits = (bits & (1ULL << 63)) ? ~bits : bits ^ (1ULL << 63);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out->push_back(static_cast<char>((bits >> shift) & 0xff));
+        }
+        return true;
+    }
+    case R_STR:
+        append_escaped_sort_key(as_str(), out);
+        return true;
+    case R_ARRAY: {
+        const size_t sz = arr_size();
+        for (size_t i = 0; i < sz; ++i) {
+            if (!unchecked_get(i).append_sort_key(out)) return false;
+        }
+        out->push_back('\x00');
+        return true;
+    }
+    case R_OBJECT: {
+        const size_t sz = obj_size();
+        for (size_t i = 0; i < sz; ++i) {
+            auto pair = unchecked_get_pair(i);
+            // The key gets a type byte so that it can't look like the end.
+            out->push_back(static_cast<char>(R_STR));
+            append_escaped_sort_key(pair.first, out);
+            if (!pair.second.append_sort_key(out)) return false;
+        }
+        out->push_back('\x00');
+        return true;
+    }
+    case R_BINARY: // This should be handled by the ptype code above
+    case UNINITIALIZED: // fallthru
+    default: unreachable();
+    }
+}
+
+bool datum_t::append_sort_key(std::string *out) const {
+    return call_with_enough_stack_datum<bool>([&] {
+            return this->append_sort_key_unchecked_stack(out);
+        });
+}
+
 bool datum_t::operator==(const datum_t &rhs) const { return cmp(rhs) == 0; }
 bool datum_t::operator!=(const datum_t &rhs) const { return cmp(rhs) != 0; }
 bool datum_t::operator<(const datum_t &rhs) const { return cmp(rhs) < 0; }
@@ -2043,10 +2416,15 @@ datum_t stats_merge(UNUSED const datum_string_t &key,
     return l;
 }
 
-datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from) {
+datum_object_builder_t::datum_object_builder_t()
+    : map(map_t::key_compare(), map_t::allocator_type(&arena)) { }
+
+datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from)
+    : map(map_t::key_compare(), map_t::allocator_type(&arena)) {
     const size_t copy_from_sz = copy_from.obj_size();
     for (size_t i = 0; i < copy_from_sz; ++i) {
-        map.insert(copy_from.get_pair(i));
+        // The pairs come in order, so each one goes at the end.
+        map.insert(map.end(), copy_from.get_pair(i));
     }
 }
 
@@ -2159,13 +2537,23 @@ datum_t datum_object_builder_t::try_get(const datum_string_t &key) const {
     return it == map.end() ? datum_t() : it->second;
 }
 
+std::vector<std::pair<datum_string_t, datum_t> >
+datum_object_builder_t::to_sorted_vec() {
+    std::vector<std::pair<datum_string_t, datum_t> > sorted_vec;
+    sorted_vec.reserve(map.size());
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        sorted_vec.push_back(std::make_pair(std::move(it->first), std::move(it->second)));
+    }
+    return sorted_vec;
+}
+
 datum_t datum_object_builder_t::to_datum() RVALUE_THIS {
-    return datum_t(std::move(map));
+    return datum_t(to_sorted_vec());
 }
 
 datum_t datum_object_builder_t::to_datum(
         const std::set<std::string> &permissible_ptypes) RVALUE_THIS {
-    return datum_t(std::move(map), permissible_ptypes);
+    return datum_t(to_sorted_vec(), permissible_ptypes);
 }
 
 datum_array_builder_t::datum_array_builder_t(const datum_t &copy_from,
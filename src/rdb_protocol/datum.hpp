@@ -4,6 +4,7 @@
 
 #include <float.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <set>
@@ -13,6 +14,7 @@
 
 #include "cjson/json.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/bump_arena.hpp"
 #include "containers/counted.hpp"
 #include "containers/optional.hpp"
 #include "rdb_protocol/datum_string.hpp"
@@ -327,6 +329,15 @@ public:
     bool operator>(const datum_t &rhs) const;
     bool operator>=(const datum_t &rhs) const;
 
+    // Data that are equal according to `cmp()` have the same hash.
+    size_t hash() const;
+
+    // Appends a string to `*out` that compares with `memcmp` the way the datum
+    // compares with `cmp()` against other data that have one.  Returns `false`, and
+    // leaves `*out` partially written, if the datum is or contains a pseudotype,
+    // because those compare by their own rules.  No key is a prefix of another.
+    MUST_USE bool append_sort_key(std::string *out) const;
+
     NORETURN void runtime_fail(base_exc_t::type_t exc_type,
                                const char *test, const char *file, int line,
                                std::string msg) const;
@@ -350,6 +361,13 @@ public:
     // the datum is currently backed by one, or NULL otherwise.
     const shared_buf_ref_t<char> *get_buf_ref() const;
 
+    // Used by `datum_serialized_size()`. Arrays and objects that aren't backed by a
+    // buf_ref remember their serialized size once it's known. Returns 0 if it isn't
+    // known (yet), or if this isn't such a datum, in which case setting it does
+    // nothing.
+    size_t get_cached_serialized_size() const;
+    void set_cached_serialized_size(size_t size) const;
+
 private:
     // We have a special version of `call_with_enough_stack` for datums that only uses
     // `call_with_enough_stack` if there a chance of additional recursion (based on
@@ -366,6 +384,11 @@ private:
     // The key must already exist.
     void replace_field(const datum_string_t &key, datum_t val);
 
+    // Both `get_field()`s end up here, so that looking up a C-string key doesn't
+    // have to allocate a `datum_string_t` first.
+    datum_t get_field(size_t key_size, const char *key_data,
+                      throw_bool_t throw_bool) const;
+
     static std::vector<std::pair<datum_string_t, datum_t> > to_sorted_vec(
             std::map<datum_string_t, datum_t> &&map);
 
@@ -400,6 +423,8 @@ private:
         std::string *str_out) const;
 
     int cmp_unchecked_stack(const datum_t &rhs) const;
+    size_t hash_unchecked_stack() const;
+    bool append_sort_key_unchecked_stack(std::string *out) const;
 
     int pseudo_cmp(const datum_t &rhs) const;
     bool pseudo_compares_as_obj() const;
@@ -412,6 +437,20 @@ private:
     datum_t drop_literals(bool *encountered_literal_out) const;
     datum_t drop_literals_unchecked_stack(bool *encountered_literal_out) const;
 
+    // The storage of arrays and objects that aren't backed by a buf_ref. It
+    // doesn't change once the datum is constructed, so it can remember the
+    // serialized size.
+    template <class T>
+    class composite_storage_t
+        : public T, public slow_atomic_countable_t<composite_storage_t<T> > {
+    public:
+        explicit composite_storage_t(T &&contents)
+            : T(std::move(contents)), serialized_size(0) { }
+
+        // 0 if not known yet. Atomic because datums are shared across threads.
+        std::atomic<size_t> serialized_size;
+    };
+
     // The data_wrapper makes sure we perform proper cleanup when exceptions
     // happen during construction
     class data_wrapper_t {
@@ -444,8 +483,8 @@ private:
             bool r_bool;
             double r_num;
             datum_string_t r_str;
-            counted_t<countable_wrapper_t<std::vector<datum_t> > > r_array;
-            counted_t<countable_wrapper_t<std::vector< //NOLINT(whitespace/operators)
+            counted_t<composite_storage_t<std::vector<datum_t> > > r_array;
+            counted_t<composite_storage_t<std::vector< //NOLINT(whitespace/operators)
                 std::pair<datum_string_t, datum_t> > > > r_object;
             shared_buf_ref_t<char> buf_ref;
         };
@@ -469,6 +508,15 @@ datum_t to_datum(
     const configured_limits_t &,
     reql_version_t);
 
+// Parses the null-terminated JSON at `json` straight into a datum, in a single pass
+// and without building a `rapidjson::Document`.  `json` is overwritten in the
+// process.  Returns an empty datum and sets `*error_out` if `json` isn't valid JSON,
+// and throws like `to_datum()` if it isn't a valid datum.
+datum_t parse_json_insitu_to_datum(
+    char *json,
+    const configured_limits_t &,
+    std::string *error_out);
+
 // DEPRECATED: Used in the r.json term for pre 2.1 backwards compatibility
 datum_t to_datum(cJSON *json, const configured_limits_t &, reql_version_t);
 
@@ -485,7 +533,7 @@ int64_t checked_convert_to_int(const rcheckable_t *target, double d);
 // Useful for building an object datum and doing mutation operations
 class datum_object_builder_t {
 public:
-    datum_object_builder_t() { }
+    datum_object_builder_t();
     explicit datum_object_builder_t(const datum_t &copy_from);
 
     bool empty() const {
@@ -518,7 +566,15 @@ public:
             const std::set<std::string> &permissible_ptypes) RVALUE_THIS;
 
 private:
-    std::map<datum_string_t, datum_t> map;
+    std::vector<std::pair<datum_string_t, datum_t> > to_sorted_vec();
+
+    // Builders are short-lived and never outlive their fields, so the map's nodes
+    // come from an arena instead of a malloc each.
+    typedef std::map<datum_string_t, datum_t, std::less<datum_string_t>,
+                     bump_allocator_t<std::pair<const datum_string_t, datum_t> > >
+        map_t;
+    bump_arena_t arena;
+    map_t map;
     DISABLE_COPYING(datum_object_builder_t);
 };
 
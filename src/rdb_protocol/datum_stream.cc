@@ -1,12 +1,16 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/datum_stream.hpp"
 
+#include <iterator>
 #include <map>
 
+#include "concurrency/pmap.hpp"
 #include "rdb_protocol/batching.hpp"
 #include "rdb_protocol/datum_stream/array.hpp"
 #include "rdb_protocol/datum_stream/eq_join.hpp"
+#include "rdb_protocol/datum_stream/external_sort.hpp"
 #include "rdb_protocol/datum_stream/fold.hpp"
+#include "rdb_protocol/datum_stream/hash_join.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
 #include "rdb_protocol/datum_stream/lazy.hpp"
 #include "rdb_protocol/datum_stream/map.hpp"
@@ -32,6 +36,7 @@
 #include "rdb_protocol/geo/s2/s2polygon.h"
 #include "rdb_protocol/geo/s2/s2polyline.h"
 #include "rdb_protocol/math_utils.hpp"
+#include "rdb_protocol/parallel_eval.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/val.hpp"
 #include "utils.hpp"
@@ -45,6 +50,7 @@ read_mode_t up_to_date_read_mode(read_mode_t in) {
     case read_mode_t::MAJORITY: return in;
     case read_mode_t::SINGLE:   return in;
     case read_mode_t::OUTDATED: return read_mode_t::SINGLE;
+    case read_mode_t::BOUNDED:  return read_mode_t::SINGLE;
     case read_mode_t::DEBUG_DIRECT:
         rfail_datum(base_exc_t::LOGIC,
                     "DEBUG_DIRECT is not a legal read mode for this operation "
@@ -677,10 +683,9 @@ bool rget_response_reader_t::is_finished() const {
     return shards_exhausted() && items_index >= items.size();
 }
 
-rget_read_response_t rget_response_reader_t::do_read(env_t *env, const read_t &read) {
-    read_response_t res;
-    table->read_with_profile(env, read, &res);
-    auto rget_res = boost::get<rget_read_response_t>(&res.response);
+// Extracts the `rget_read_response_t` from `res`, or throws the error it contains.
+static rget_read_response_t take_rget_read_response(read_response_t *res) {
+    auto rget_res = boost::get<rget_read_response_t>(&res->response);
     r_sanity_check(rget_res != NULL);
     if (auto e = boost::get<exc_t>(&rget_res->result)) {
         throw *e;
@@ -688,6 +693,12 @@ rget_read_response_t rget_response_reader_t::do_read(env_t *env, const read_t &r
     return std::move(*rget_res);
 }
 
+rget_read_response_t rget_response_reader_t::do_read(env_t *env, const read_t &read) {
+    read_response_t res;
+    table->read_with_profile(env, read, &res);
+    return take_rget_read_response(&res);
+}
+
 rget_reader_t::rget_reader_t(
     const counted_t<real_table_t> &_table,
     scoped_ptr_t<readgen_t> &&_readgen)
@@ -718,9 +729,13 @@ void rget_reader_t::accumulate_all(env_t *env, eager_acc_t *acc) {
 
 std::vector<rget_item_t>
 rget_reader_t::do_range_read(env_t *env, const read_t &read) {
+    return finish_range_read(read, do_read(env, read));
+}
+
+std::vector<rget_item_t>
+rget_reader_t::finish_range_read(const read_t &read, rget_read_response_t &&res) {
     auto *rr = boost::get<rget_read_t>(&read.read);
     r_sanity_check(rr);
-    rget_read_response_t res = do_read(env, read);
 
     r_sanity_check(stamp.has_value() == rr->stamp.has_value());
     validate_and_record_stamps(stamp, res.stamp_response, &shard_stamp_infos);
@@ -730,20 +745,79 @@ rget_reader_t::do_range_read(env_t *env, const read_t &read) {
 
 bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
     started = true;
+    if (prefetch.has() && batchspec.get_batch_type() != batch_type_t::TERMINAL) {
+        // The prefetched read has a different batchspec.  It's still correct, but
+        // we don't want its size or deadline here, so we drop it.
+        prefetch->abandon.pulse();
+        prefetch->done.wait_lazily_unordered();
+        prefetch.reset();
+    }
     while (items_index >= items.size() && !shards_exhausted()) {
         items_index = 0;
         // `active_range` is guaranteed to be full after the `do_range_read`,
         // because `do_range_read` is responsible for updating the active range.
-        items = do_range_read(
-            env,
-            readgen->next_read(
-                active_ranges, reql_version, stamp, transforms, batchspec));
+        if (prefetch.has()) {
+            items = finish_prefetch(env);
+        } else {
+            items = do_range_read(
+                env,
+                readgen->next_read(
+                    active_ranges, reql_version, stamp, transforms, batchspec));
+        }
         r_sanity_check(active_ranges);
         readgen->sindex_sort(&items, batchspec);
     }
+    maybe_start_prefetch(env, batchspec);
     return items_index < items.size();
 }
 
+void rget_reader_t::maybe_start_prefetch(env_t *env, const batchspec_t &batchspec) {
+    // Terminal batches have no latency cap, so the read doesn't get worse for
+    // starting early.  Profiles and changefeed stamps need the reads to happen in
+    // the query's own coroutine.
+    if (prefetch.has()
+        || shards_exhausted()
+        || batchspec.get_batch_type() != batch_type_t::TERMINAL
+        || env->profile() == profile_bool_t::PROFILE
+        || stamp.has_value()) {
+        return;
+    }
+    // Only `finish_range_read` changes `active_ranges`, so this is the read that
+    // `load_items` would do next.
+    prefetch.init(new prefetch_t(readgen->next_read(
+        active_ranges, reql_version, stamp, transforms, batchspec)));
+    auth::user_context_t user_context = env->get_user_context();
+    auto_drainer_t::lock_t lock(&drainer);
+    prefetch_t *p = prefetch.get();
+    coro_t::spawn_sometime([this, p, user_context, lock]() {
+        this->do_prefetch(p, user_context, lock);
+    });
+}
+
+void rget_reader_t::do_prefetch(prefetch_t *p,
+                                auth::user_context_t user_context,
+                                auto_drainer_t::lock_t lock) THROWS_NOTHING {
+    wait_any_t interruptor(&p->abandon, lock.get_drain_signal());
+    try {
+        table->read_in_background(user_context, p->read, &p->response, &interruptor);
+        p->succeeded = true;
+    } catch (const interrupted_exc_t &) {
+    } catch (const cannot_perform_query_exc_t &) {
+    } catch (const auth::permission_error_t &) {
+    }
+    p->done.pulse();
+}
+
+std::vector<rget_item_t> rget_reader_t::finish_prefetch(env_t *env) {
+    wait_interruptible(&prefetch->done, env->interruptor);
+    scoped_ptr_t<prefetch_t> p(prefetch.release());
+    if (!p->succeeded) {
+        return do_range_read(env, p->read);
+    }
+    table->add_read_to_usage(env, p->response);
+    return finish_range_read(p->read, take_rget_read_response(&p->response));
+}
+
 intersecting_reader_t::intersecting_reader_t(
     const counted_t<real_table_t> &_table,
     scoped_ptr_t<readgen_t> &&_readgen)
@@ -1622,6 +1696,97 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
     return ret;
 }
 
+// EXTERNAL_SORT_DATUM_STREAM_T
+external_sort_datum_stream_t::external_sort_datum_stream_t(
+    std::vector<scoped_ptr_t<disk_backed_queue_t<datum_t> > > &&_disk_runs,
+    std::vector<datum_t> &&_last_run,
+    std::function<bool(env_t *,  // NOLINT(readability/casting)
+                       profile::sampler_t *,
+                       const datum_t &,
+                       const datum_t &)> _lt_cmp,
+    backtrace_id_t bt)
+    : eager_datum_stream_t(bt),
+      disk_runs(std::move(_disk_runs)),
+      last_run(std::move(_last_run)),
+      last_run_index(0),
+      lt_cmp(_lt_cmp),
+      started(false) { }
+
+bool external_sort_datum_stream_t::is_exhausted() const {
+    // We never create empty runs on disk.
+    return started ? heads.empty() : (disk_runs.empty() && last_run.empty());
+}
+feed_type_t external_sort_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+bool external_sort_datum_stream_t::is_infinite() const {
+    return false;
+}
+
+bool external_sort_datum_stream_t::head_gt(env_t *env,
+                                           profile::sampler_t *sampler,
+                                           const head_t &a,
+                                           const head_t &b) const {
+    if (lt_cmp(env, sampler, b.row, a.row)) {
+        return true;
+    } else if (lt_cmp(env, sampler, a.row, b.row)) {
+        return false;
+    }
+    // Equal rows come out in the order of their runs, which keeps the sort stable.
+    return a.run > b.run;
+}
+
+void external_sort_datum_stream_t::load_head(env_t *env,
+                                             profile::sampler_t *sampler,
+                                             size_t run) {
+    head_t head;
+    head.run = run;
+    if (run < disk_runs.size()) {
+        if (disk_runs[run]->empty()) {
+            // Deletes the file.
+            disk_runs[run].reset();
+            return;
+        }
+        disk_runs[run]->pop(&head.row);
+    } else {
+        if (last_run_index >= last_run.size()) {
+            last_run.clear();
+            return;
+        }
+        head.row = std::move(last_run[last_run_index++]);
+    }
+    heads.push_back(std::move(head));
+    std::push_heap(heads.begin(), heads.end(),
+                   std::bind(&external_sort_datum_stream_t::head_gt, this,
+                             env, sampler, ph::_1, ph::_2));
+}
+
+std::vector<datum_t>
+external_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    std::vector<datum_t> ret;
+    batcher_t batcher = batchspec.to_batcher();
+
+    profile::sampler_t sampler("Merging sorted runs from disk.", env->trace);
+    if (!started) {
+        started = true;
+        for (size_t run = 0; run <= disk_runs.size(); ++run) {
+            load_head(env, &sampler, run);
+        }
+    }
+    auto gt = std::bind(&external_sort_datum_stream_t::head_gt, this,
+                        env, &sampler, ph::_1, ph::_2);
+    while (!heads.empty() && !batcher.should_send_batch()) {
+        std::pop_heap(heads.begin(), heads.end(), gt);
+        head_t head = std::move(heads.back());
+        heads.pop_back();
+        load_head(env, &sampler, head.run);
+        batcher.note_el(head.row);
+        ret.push_back(std::move(head.row));
+        sampler.new_sample();
+    }
+    return ret;
+}
+
 // ORDERED_DISTINCT_DATUM_STREAM_T
 ordered_distinct_datum_stream_t::ordered_distinct_datum_stream_t(
     counted_t<datum_stream_t> _source) : wrapper_datum_stream_t(_source) { }
@@ -1786,6 +1951,11 @@ bool slice_datum_stream_t::is_infinite() const {
     return source->is_infinite() && right == std::numeric_limits<size_t>::max();
 }
 
+// The maximum number of reads that a union_datum_stream spawns on its substreams
+// at a time. This limit does not apply to changefeed streams.  An ordered union
+// reads the first rows of its streams with the same parallelism.
+const size_t MAX_CONCURRENT_UNION_READS = 32;
+
 // UNION_DATUM_STREAM_T
 class coro_stream_t {
 public:
@@ -1920,14 +2090,31 @@ std::vector<datum_t> ordered_union_datum_stream_t::next_raw_batch(
 
     if (is_ordered_by_field) {
         if (do_prelim_cache) {
-            for (auto &&stream : streams) {
-                r_sanity_check(stream.has());
-                datum_t cache_item = stream->next(env, batchspec);
-
-                if (cache_item.has()) {
+            std::vector<datum_t> first_rows(streams.size());
+            if (env->trace == nullptr) {
+                // Reading the streams one after another would make the first batch
+                // wait for the sum of their latencies.
+                std::exception_ptr exc;
+                throttled_pmap(streams.size(), [&](int64_t i) {
+                    try {
+                        first_rows[i] = streams[i]->next(env, batchspec);
+                    } catch (...) {
+                        if (!exc) exc = std::current_exception();
+                    }
+                }, MAX_CONCURRENT_UNION_READS);
+                if (exc) std::rethrow_exception(exc);
+            } else {
+                // A profile can only follow one read at a time.
+                for (size_t i = 0; i < streams.size(); ++i) {
+                    first_rows[i] = streams[i]->next(env, batchspec);
+                }
+            }
+            for (size_t i = 0; i < streams.size(); ++i) {
+                r_sanity_check(streams[i].has());
+                if (first_rows[i].has()) {
                     merge_cache.push(
-                        merge_cache_item_t{std::move(cache_item),
-                                stream});
+                        merge_cache_item_t{std::move(first_rows[i]),
+                                streams[i]});
                 }
             }
             do_prelim_cache = false;
@@ -1987,10 +2174,6 @@ bool ordered_union_datum_stream_t::is_exhausted() const {
     }
 }
 
-// The maximum number of reads that a union_datum_stream spawns on its substreams
-// at a time. This limit does not apply to changefeed streams.
-const size_t MAX_CONCURRENT_UNION_READS = 32;
-
 union_datum_stream_t::union_datum_stream_t(
     env_t *env,
     std::vector<counted_t<datum_stream_t> > &&streams,
@@ -2003,6 +2186,7 @@ union_datum_stream_t::union_datum_stream_t(
       ready_needed(expected_states),
       read_coro_pool(MAX_CONCURRENT_UNION_READS, &read_queue, &read_coro_callback),
       active(0),
+      next_launch(0),
       coros_exhausted(false) {
 
     for (const auto &stream : streams) {
@@ -2052,7 +2236,13 @@ union_datum_stream_t::next_batch_impl(env_t *env, const batchspec_t &batchspec)
                 }
 
                 data_available = make_scoped<cond_t>();
-                for (auto &&s : coro_streams) s->maybe_launch_read();
+                // Reads go through `read_queue` in order, so we start with a different
+                // stream every time to keep the first streams from always going first.
+                for (size_t i = 0; i < coro_streams.size(); ++i) {
+                    coro_streams[(i + next_launch) % coro_streams.size()]
+                        ->maybe_launch_read();
+                }
+                next_launch = (next_launch + 1) % coro_streams.size();
                 r_sanity_check(active != 0 || data_available->is_pulsed());
                 wait_interruptible(data_available.get(), &interruptor);
             }
@@ -2253,6 +2443,54 @@ map_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
         batchspec_inner = batchspec_t::default_for(batch_type_t::NORMAL);
     }
     while (!is_exhausted()) {
+        // Once the caches have a batch from every stream, we can evaluate all the
+        // calls we have the arguments for at once.
+        size_t ready = args.empty() ? cache[0].size() : 0;
+        for (const auto &c : cache) {
+            ready = std::min(ready, c.size());
+        }
+        // Don't evaluate more calls than the batch has room for.
+        ready = std::min<size_t>(ready, std::max<int64_t>(batcher.get_els_left(), 0));
+        if (should_eval_in_parallel(env, ready, func.get())) {
+            std::vector<std::vector<datum_t> > all_args(ready);
+            for (size_t i = 0; i < ready; ++i) {
+                all_args[i].reserve(streams.size());
+                for (auto &&c : cache) {
+                    all_args[i].push_back(std::move(c.front()));
+                    c.pop_front();
+                }
+            }
+            std::vector<datum_t> results(ready);
+            parallel_eval(env, ready, [&](env_t *e, size_t i) {
+                results[i] = func->call(e, all_args[i])->as_datum();
+            });
+            size_t used = 0;
+            while (used < ready) {
+                r_sanity_check(results[used].has());
+                const bool full = batcher.note_el(results[used]);
+                batch.push_back(std::move(results[used]));
+                ++used;
+                if (full) {
+                    break;
+                }
+            }
+            if (used < ready) {
+                // The batch filled up by size or time.  The function is
+                // deterministic, so we put the arguments of the results we didn't
+                // use back to evaluate them again for the next batch.
+                for (size_t i = ready; i-- > used;) {
+                    for (size_t j = 0; j < cache.size(); ++j) {
+                        cache[j].push_front(std::move(all_args[i][j]));
+                    }
+                }
+                break;
+            }
+            if (batcher.should_send_batch()) {
+                break;
+            }
+            continue;
+        }
+
         while (args.size() < streams.size()) {
             if (cache[args.size()].size() == 0) {
                 std::vector<datum_t> new_items = streams[args.size()]->next_batch(
@@ -2317,18 +2555,19 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
     const batchspec_t &batchspec) {
     batcher_t batcher = batchspec.to_batcher();
 
-    batchspec_t inner_batchspec = ordered ?
-        batchspec_t::all().with_at_most(1) :
-        batchspec;
-
     std::vector<datum_t> res;
     while (!is_exhausted() && !batcher.should_send_batch()) {
+        if (!ordered_results.empty()) {
+            batcher.note_el(ordered_results.front());
+            res.push_back(std::move(ordered_results.front()));
+            ordered_results.pop_front();
+            continue;
+        }
         if (!get_all_reader.has() ||
             (get_all_reader->is_finished() &&
              get_all_items.empty())) {
             // Get a new batch of keys
-            std::vector<datum_t> stream_batch = stream->next_batch(env,
-                                                                   inner_batchspec);
+            std::vector<datum_t> stream_batch = stream->next_batch(env, batchspec);
             if (stream_batch.empty()) {
                 // We got an empty batch from the input stream. It's either exhausted
                 // or a changefeed. In either case we abort and emit our current results.
@@ -2337,6 +2576,7 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
             // Basically do a get all on the new keys
             // but we get the reader directly so we can read the sindex from the lookup.
             sindex_to_datum.clear();
+            left_rows.clear();
             std::map<datum_t, uint64_t> keys;
             for (size_t i = 0; i < stream_batch.size(); ++i) {
                 datum_t key_val;
@@ -2353,16 +2593,27 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
                 }
                 // Build a multimap from sindex value to datums from left side stream.
                 if (key_val.get_type() != datum_t::type_t::R_NULL) {
-                    sindex_to_datum.insert(std::pair<datum_t, datum_t>{
-                            key_val, stream_batch[i]});
+                    if (ordered) {
+                        left_rows.push_back(std::make_pair(key_val, stream_batch[i]));
+                    } else {
+                        sindex_to_datum.insert(std::pair<datum_t, datum_t>{
+                                key_val, stream_batch[i]});
+                    }
                     keys[key_val] = 1;
                 }
             }
+            if (keys.empty()) {
+                continue;
+            }
             get_all_reader = table->get_all_with_sindexes(
                 env,
                 datumspec_t(std::move(keys)),
                 join_index.to_std(),
                 backtrace());
+            if (ordered) {
+                join_ordered(env, batchspec);
+                continue;
+            }
         }
         if (get_all_items.empty()) {
             get_all_items = get_all_reader->raw_next_batch(env, batchspec);
@@ -2376,8 +2627,7 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
         }
         // Get each item in get_all results, and match it with all datums that match
         // in the multimap from the left side stream.
-        std::pair<std::multimap<datum_t, datum_t>::iterator,
-                  std::multimap<datum_t, datum_t>::iterator> range;
+        std::pair<key_to_datum_t::iterator, key_to_datum_t::iterator> range;
         if (item.sindex_key.has()) {
             range = sindex_to_datum.equal_range(item.sindex_key);
         } else {
@@ -2399,8 +2649,50 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
     return res;
 }
 
+void join_in_left_order(const std::vector<std::pair<datum_t, datum_t> > &left_rows,
+                        std::vector<std::pair<datum_t, datum_t> > &&right_rows,
+                        std::deque<datum_t> *results_out) {
+    std::unordered_multimap<datum_t, datum_t,
+                            optional_datum_hash_t, optional_datum_equal_t>
+        key_to_right;
+    for (auto &&right_row : right_rows) {
+        key_to_right.insert(std::move(right_row));
+    }
+    datum_string_t right("right");
+    datum_string_t left("left");
+    for (const auto &left_row : left_rows) {
+        auto range = key_to_right.equal_range(left_row.first);
+        for (auto pair = range.first; pair != range.second; ++pair) {
+            ql::datum_object_builder_t res_item;
+            bool conflict = true;
+            conflict &= res_item.add(right, pair->second);
+            conflict &= res_item.add(left, left_row.second);
+            guarantee(!conflict);
+            results_out->push_back(std::move(res_item).to_datum());
+        }
+    }
+}
+
+void eq_join_datum_stream_t::join_ordered(env_t *env, const batchspec_t &batchspec) {
+    // We look up all of the keys of the batch with one read, instead of one read per
+    // left row, and restore the order of the left rows afterwards.
+    std::vector<std::pair<datum_t, datum_t> > right_rows;
+    while (!get_all_reader->is_finished()) {
+        std::vector<rget_item_t> items = get_all_reader->raw_next_batch(env, batchspec);
+        for (auto &&item : items) {
+            datum_t key = item.sindex_key.has()
+                ? item.sindex_key
+                : item.data.get_field(join_index);
+            right_rows.push_back(std::make_pair(std::move(key), std::move(item.data)));
+        }
+    }
+    join_in_left_order(left_rows, std::move(right_rows), &ordered_results);
+    left_rows.clear();
+}
+
 bool eq_join_datum_stream_t::is_exhausted() const {
     if (stream->is_exhausted() &&
+        ordered_results.empty() &&
         get_all_items.empty() &&
         (!get_all_reader.has() || get_all_reader->is_finished())) {
         return batch_cache_exhausted();
@@ -2408,6 +2700,167 @@ bool eq_join_datum_stream_t::is_exhausted() const {
     return false;
 }
 
+hash_join_right_t::hash_join_right_t(counted_t<datum_stream_t> _stream,
+                                     datum_string_t _field)
+    : state(state_t::unread), stream(std::move(_stream)), field(std::move(_field)) { }
+
+bool hash_join_right_t::load(env_t *env) {
+    if (state == state_t::unread) {
+        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env);
+        state = state_t::indexed;
+        for (;;) {
+            std::vector<datum_t> data = stream->next_batch(env, batchspec);
+            if (data.empty()) {
+                break;
+            }
+            std::move(data.begin(), data.end(), std::back_inserter(rows));
+            if (rows.size() > env->limits().array_size_limit()) {
+                state = state_t::too_large;
+                rows.clear();
+                break;
+            }
+        }
+        stream.reset();
+        if (state == state_t::indexed) {
+            for (size_t i = 0; i < rows.size(); ++i) {
+                datum_t key = get_key(rows[i], field);
+                if (key.has()) {
+                    index[key].push_back(i);
+                } else {
+                    rows_without_key.push_back(i);
+                }
+            }
+        }
+    }
+    return state == state_t::indexed;
+}
+
+const std::vector<size_t> &hash_join_right_t::rows_with_key(const datum_t &key) const {
+    static const std::vector<size_t> no_rows;
+    auto it = index.find(key);
+    return it == index.end() ? no_rows : it->second;
+}
+
+datum_t hash_join_right_t::get_key(const datum_t &row, const datum_string_t &field) {
+    if (row.get_type() != datum_t::R_OBJECT || row.is_ptype()) {
+        return datum_t();
+    }
+    return row.get_field(field, NOTHROW);
+}
+
+hash_join_datum_stream_t::hash_join_datum_stream_t(
+        counted_t<datum_stream_t> _left,
+        counted_t<hash_join_right_t> _right,
+        datum_string_t _left_field,
+        counted_t<const func_t> _predicate,
+        counted_t<const func_t> _nested_loop,
+        bool _outer,
+        backtrace_id_t _bt)
+    : eager_datum_stream_t(_bt),
+      left(std::move(_left)),
+      right(std::move(_right)),
+      left_field(std::move(_left_field)),
+      predicate(std::move(_predicate)),
+      nested_loop(std::move(_nested_loop)),
+      outer(_outer) { }
+
+void hash_join_datum_stream_t::join_row(env_t *env,
+                                        const datum_t &left_row,
+                                        std::vector<datum_t> *out) {
+    const std::vector<datum_t> &right_rows = right->get_rows();
+    datum_t key = hash_join_right_t::get_key(left_row, left_field);
+    bool matched = false;
+    auto add_pair = [&](size_t i) {
+        ql::datum_object_builder_t res_item;
+        bool conflict = true;
+        conflict &= res_item.add("left", left_row);
+        conflict &= res_item.add("right", right_rows[i]);
+        guarantee(!conflict);
+        out->push_back(std::move(res_item).to_datum());
+        matched = true;
+    };
+    auto call_predicate = [&](size_t i) {
+        return predicate->call(env, left_row, right_rows[i])->as_bool();
+    };
+    if (!key.has()) {
+        for (size_t i = 0; i < right_rows.size(); ++i) {
+            if (call_predicate(i)) {
+                add_pair(i);
+            }
+        }
+    } else {
+        // We merge the matching rows with the ones that need the predicate, so that
+        // the joined rows stay in the order of `right_rows`.
+        const std::vector<size_t> &matches = right->rows_with_key(key);
+        const std::vector<size_t> &others = right->get_rows_without_key();
+        auto match = matches.begin();
+        auto other = others.begin();
+        while (match != matches.end() || other != others.end()) {
+            if (other == others.end()
+                || (match != matches.end() && *match < *other)) {
+                add_pair(*match++);
+            } else {
+                size_t i = *other++;
+                if (call_predicate(i)) {
+                    add_pair(i);
+                }
+            }
+        }
+    }
+    if (outer && !matched) {
+        ql::datum_object_builder_t res_item;
+        bool conflict = res_item.add("left", left_row);
+        guarantee(!conflict);
+        out->push_back(std::move(res_item).to_datum());
+    }
+}
+
+void hash_join_datum_stream_t::nested_loop_row(env_t *env,
+                                               const datum_t &left_row,
+                                               std::vector<datum_t> *out) {
+    counted_t<datum_stream_t> joined = nested_loop->call(env, left_row)->as_seq(env);
+    batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env);
+    for (;;) {
+        std::vector<datum_t> data = joined->next_batch(env, batchspec);
+        if (data.empty()) {
+            break;
+        }
+        std::move(data.begin(), data.end(), std::back_inserter(*out));
+    }
+}
+
+std::vector<datum_t>
+hash_join_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    batcher_t batcher = batchspec.to_batcher();
+    profile::sampler_t sampler("Hash join.", env->trace);
+    std::vector<datum_t> res;
+    while (!batcher.should_send_batch()) {
+        std::vector<datum_t> left_batch = left->next_batch(env, batchspec);
+        if (left_batch.empty()) {
+            break;
+        }
+        // We only read the right side once there is a left row to join it with.
+        const bool indexed = right->load(env);
+        const size_t old_size = res.size();
+        for (const datum_t &left_row : left_batch) {
+            if (indexed) {
+                join_row(env, left_row, &res);
+            } else {
+                nested_loop_row(env, left_row, &res);
+            }
+            sampler.new_sample();
+        }
+        for (size_t i = old_size; i < res.size(); ++i) {
+            batcher.note_el(res[i]);
+        }
+        if (left->cfeed_type() != feed_type_t::not_feed && !res.empty()) {
+            // Don't wait for more changes if we already have something to return.
+            break;
+        }
+    }
+    return res;
+}
+
 fold_datum_stream_t::fold_datum_stream_t(
     counted_t<datum_stream_t> &&_stream,
     datum_t _base,
@@ -1,10 +1,22 @@
 #ifndef RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 #define RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/datum_utils.hpp"
 
 namespace ql {
 
+// Joins each of `left_rows`, a join key and a row, with the `right_rows` that have the
+// same key.  The `{left, right}` objects come out in the order of `left_rows`.
+void join_in_left_order(const std::vector<std::pair<datum_t, datum_t> > &left_rows,
+                        std::vector<std::pair<datum_t, datum_t> > &&right_rows,
+                        std::deque<datum_t> *results_out);
+
 class eq_join_datum_stream_t : public eager_datum_stream_t {
 public:
     eq_join_datum_stream_t(counted_t<datum_stream_t> _stream,
@@ -30,6 +42,14 @@ public:
     }
 
 private:
+    typedef std::unordered_multimap<datum_t, datum_t,
+                                    optional_datum_hash_t, optional_datum_equal_t>
+        key_to_datum_t;
+
+    // Reads all of the right rows for `left_rows` and puts the joined rows into
+    // `ordered_results`, in the order of `left_rows`.
+    void join_ordered(env_t *env, const batchspec_t &batchspec);
+
     counted_t<datum_stream_t> stream;
     scoped_ptr_t<reader_t> get_all_reader;
     std::vector<rget_item_t> get_all_items;
@@ -37,8 +57,12 @@ private:
     counted_t<table_t> table;
     datum_string_t join_index;
 
-    std::multimap<ql::datum_t,
-                  ql::datum_t> sindex_to_datum;
+    key_to_datum_t sindex_to_datum;
+
+    // Only used if `ordered` is true.  The left rows of the current batch with their
+    // keys, in the order they came in, and the results we haven't returned yet.
+    std::vector<std::pair<datum_t, datum_t> > left_rows;
+    std::deque<datum_t> ordered_results;
 
     counted_t<const func_t> predicate;
 
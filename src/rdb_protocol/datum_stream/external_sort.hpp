@@ -0,0 +1,64 @@
+#ifndef RDB_PROTOCOL_DATUM_STREAM_EXTERNAL_SORT_HPP_
+#define RDB_PROTOCOL_DATUM_STREAM_EXTERNAL_SORT_HPP_
+
+#include <functional>
+#include <vector>
+
+#include "containers/disk_backed_queue.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+
+namespace ql {
+
+// Merges sorted runs that `orderby` has spilled to disk because they didn't fit into
+// the array size limit.  The merge is lazy, so a `limit` after the `orderby` only
+// reads the beginning of every run.
+class external_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    // Every run must be sorted according to `lt_cmp`.  The runs have to be in the
+    // order their rows came in, so that equal rows keep their order.  `last_run` is
+    // the last run, which we never wrote to disk.
+    external_sort_datum_stream_t(
+        std::vector<scoped_ptr_t<disk_backed_queue_t<datum_t> > > &&disk_runs,
+        std::vector<datum_t> &&last_run,
+        std::function<bool(env_t *,  // NOLINT(readability/casting)
+                           profile::sampler_t *,
+                           const datum_t &,
+                           const datum_t &)> lt_cmp,
+        backtrace_id_t bt);
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_infinite() const;
+
+private:
+    // The next row of each run that hasn't run out yet; `run` is the index into
+    // `disk_runs`, or `disk_runs.size()` for `last_run`.
+    struct head_t {
+        datum_t row;
+        size_t run;
+    };
+
+    virtual bool is_array() const { return false; }
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    // Loads the next row of `run` into `heads`, unless `run` is empty.
+    void load_head(env_t *env, profile::sampler_t *sampler, size_t run);
+    // Whether `a` should come after `b`, which makes `heads` a min-heap.
+    bool head_gt(env_t *env, profile::sampler_t *sampler,
+                 const head_t &a, const head_t &b) const;
+
+    std::vector<scoped_ptr_t<disk_backed_queue_t<datum_t> > > disk_runs;
+    std::vector<datum_t> last_run;
+    size_t last_run_index;
+    std::function<bool(env_t *,  // NOLINT(readability/casting)
+                       profile::sampler_t *,
+                       const datum_t &,
+                       const datum_t &)> lt_cmp;
+
+    bool started;
+    std::vector<head_t> heads;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_STREAM_EXTERNAL_SORT_HPP_
@@ -0,0 +1,96 @@
+#ifndef RDB_PROTOCOL_DATUM_STREAM_HASH_JOIN_HPP_
+#define RDB_PROTOCOL_DATUM_STREAM_HASH_JOIN_HPP_
+
+#include <unordered_map>
+#include <vector>
+
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/datum_utils.hpp"
+
+namespace ql {
+
+// The right side of a hash join.  It isn't read until some left row needs it, and
+// then it is read and indexed once, even if several streams share it (one per group
+// of a grouped left side).
+class hash_join_right_t : public single_threaded_countable_t<hash_join_right_t> {
+public:
+    hash_join_right_t(counted_t<datum_stream_t> stream, datum_string_t field);
+
+    // Reads the right sequence if that hasn't happened yet.  Returns false if it
+    // doesn't fit into the array size limit, in which case the rows are dropped and
+    // the join has to fall back to the nested loop.
+    bool load(env_t *env);
+
+    const std::vector<datum_t> &get_rows() const { return rows; }
+    // The indexes of the rows whose key is `key`, in ascending order.
+    const std::vector<size_t> &rows_with_key(const datum_t &key) const;
+    // The indexes of the rows that don't have a key, in ascending order.
+    const std::vector<size_t> &get_rows_without_key() const { return rows_without_key; }
+
+    // Returns the value of `field` if `row` is an object that has it.
+    static datum_t get_key(const datum_t &row, const datum_string_t &field);
+
+private:
+    enum class state_t { unread, indexed, too_large };
+    state_t state;
+
+    counted_t<datum_stream_t> stream;
+    datum_string_t field;
+    std::vector<datum_t> rows;
+    std::unordered_map<datum_t, std::vector<size_t>,
+                       optional_datum_hash_t, optional_datum_equal_t> index;
+    std::vector<size_t> rows_without_key;
+
+    DISABLE_COPYING(hash_join_right_t);
+};
+
+// `innerJoin` and `outerJoin` with a predicate like `left(field1).eq(right(field2))`.
+// We index the right rows by `right_field` once, instead of calling the predicate for
+// every pair of rows.  Rows that aren't objects with the field (where `get_field`
+// might fail or map over an array) still go through `predicate`, so the results and
+// errors are the same as with the nested loop.  If the right side is too large, each
+// left row goes through `nested_loop` instead, which returns the joined rows of one
+// left row the way the rewritten term does.
+class hash_join_datum_stream_t : public eager_datum_stream_t {
+public:
+    hash_join_datum_stream_t(counted_t<datum_stream_t> left,
+                             counted_t<hash_join_right_t> right,
+                             datum_string_t left_field,
+                             counted_t<const func_t> predicate,
+                             counted_t<const func_t> nested_loop,
+                             bool outer,
+                             backtrace_id_t bt);
+
+    bool is_array() const final {
+        return left->is_array();
+    }
+    bool is_infinite() const final {
+        return left->is_infinite();
+    }
+    bool is_exhausted() const final {
+        return left->is_exhausted() && batch_cache_exhausted();
+    }
+    feed_type_t cfeed_type() const final {
+        return left->cfeed_type();
+    }
+
+private:
+    std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    // Appends the joined rows of `left_row` in the order of the right rows.
+    void join_row(env_t *env, const datum_t &left_row, std::vector<datum_t> *out);
+    void nested_loop_row(env_t *env, const datum_t &left_row,
+                         std::vector<datum_t> *out);
+
+    counted_t<datum_stream_t> left;
+    counted_t<hash_join_right_t> right;
+    datum_string_t left_field;
+    counted_t<const func_t> predicate;
+    counted_t<const func_t> nested_loop;
+    bool outer;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_STREAM_HASH_JOIN_HPP_
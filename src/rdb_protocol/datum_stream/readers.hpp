@@ -1,7 +1,10 @@
 #ifndef RDB_PROTOCOL_DATUM_STREAM_READERS_HPP_
 #define RDB_PROTOCOL_DATUM_STREAM_READERS_HPP_
 
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "containers/optional.hpp"
+#include "containers/scoped.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/datum_stream/readgens.hpp"
 #include "rdb_protocol/real_table.hpp"
@@ -176,7 +179,31 @@ protected:
     virtual bool load_items(env_t *env, const batchspec_t &batchspec);
 
 private:
+    // While the caller evaluates a terminal batch, we already read the next one.
+    struct prefetch_t {
+        explicit prefetch_t(read_t &&_read)
+            : read(std::move(_read)), succeeded(false) { }
+        const read_t read;
+        read_response_t response;
+        // If the read failed, `load_items` repeats it to report the error.
+        bool succeeded;
+        cond_t abandon;
+        cond_t done;
+    };
+
     std::vector<rget_item_t> do_range_read(env_t *env, const read_t &read);
+    std::vector<rget_item_t> finish_range_read(const read_t &read,
+                                               rget_read_response_t &&res);
+
+    void maybe_start_prefetch(env_t *env, const batchspec_t &batchspec);
+    void do_prefetch(prefetch_t *p,
+                     auth::user_context_t user_context,
+                     auto_drainer_t::lock_t lock) THROWS_NOTHING;
+    std::vector<rget_item_t> finish_prefetch(env_t *env);
+
+    scoped_ptr_t<prefetch_t> prefetch;
+    // Destroyed first, so that it interrupts `do_prefetch` before `prefetch` goes.
+    auto_drainer_t drainer;
 };
 
 // intersecting_reader_t performs filtering for duplicate documents in the stream,
@@ -9,6 +9,11 @@ namespace ql {
 
 class coro_stream_t;
 
+/* Reads from all of its streams in parallel and returns their batches in the order in
+which they arrive, so a slow stream doesn't hold up the others.  A stream only gets
+another read once its last batch has been returned, and only once every batch that
+we have has been returned, so at most one batch per stream is buffered no matter how
+fast the stream is. */
 class union_datum_stream_t : public datum_stream_t, public home_thread_mixin_t {
 public:
     union_datum_stream_t(env_t *env,
@@ -63,6 +68,8 @@ private:
     coro_pool_t<std::function<void()> > read_coro_pool;
 
     size_t active;
+    // The stream that `next_batch_impl` launches a read on first.
+    size_t next_launch;
     // We recompute this only when `next_batch_impl` returns to retain the
     // invariant that a stream won't change from unexhausted to exhausted
     // without attempting to read more from it.
@@ -42,6 +42,8 @@ public:
     bool empty() const;
 
     int compare(const datum_string_t &other) const;
+    // Compares to the `other_size` bytes at `other_data`.
+    int compare(size_t other_size, const char *other_data) const;
 
     // Short cut for comparing to C-strings and STD strings
     bool operator==(const char *other) const;
@@ -57,7 +59,6 @@ public:
 
 private:
     void init(size_t _size, const char *_data);
-    int compare(size_t other_size, const char *other_data) const;
 
     // Contains the length of the string in varint encoding, followed by the actual
     // string content.
@@ -11,9 +11,7 @@ distribution_progress_estimator_t::distribution_progress_estimator_t(
     static const size_t result_limit = 128;
 
 #ifndef NDEBUG
-    metainfo_checker_t metainfo_checker(
-        store->get_region(),
-        [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t metainfo_checker(store->get_region());
 #endif
 
     distribution_read_t distribution_read(max_depth, result_limit);
@@ -9,12 +9,6 @@
 
 #include "debug.hpp"
 
-// This is a totally arbitrary constant limiting the size of the regex cache.  1000
-// was chosen out of a hat; if you have a good argument for it being something else
-// (apart from cache line concerns, which are irrelevant due to the implementation)
-// you're probably right.
-const size_t LRU_CACHE_SIZE = 1000;
-
 namespace ql {
 
 void env_t::set_eval_callback(eval_callback_t *callback) {
@@ -72,13 +66,13 @@ env_t::env_t(rdb_context_t *ctx,
       limits_(from_optargs(ctx, _interruptor, &serializable_.global_optargs,
                            serializable_.deterministic_time)),
       reql_version_(reql_version_t::LATEST),
-      regex_cache_(LRU_CACHE_SIZE),
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(_trace),
       evals_since_yield_(0),
       rdb_ctx_(ctx),
-      eval_callback_(NULL) {
+      eval_callback_(NULL),
+      usage_(nullptr) {
     rassert(ctx != NULL);
     rassert(interruptor != NULL);
 }
@@ -108,13 +102,13 @@ env_t::env_t(signal_t *_interruptor,
         auth::user_context_t(auth::permissions_t(tribool::False, tribool::False, tribool::False, tribool::False)),
         datum_t()},
       reql_version_(_reql_version),
-      regex_cache_(LRU_CACHE_SIZE),
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(NULL),
       evals_since_yield_(0),
       rdb_ctx_(NULL),
-      eval_callback_(NULL) {
+      eval_callback_(NULL),
+      usage_(nullptr) {
     rassert(interruptor != NULL);
 }
 
@@ -11,7 +11,6 @@
 #include "clustering/administration/auth/user_context.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "containers/counted.hpp"
-#include "containers/lru_cache.hpp"
 #include "extproc/js_runner.hpp"
 #include "rdb_protocol/configured_limits.hpp"
 #include "rdb_protocol/context.hpp"
@@ -19,27 +18,19 @@
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/optargs.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/query_usage.hpp"
 #include "rdb_protocol/val.hpp"
 #include "rdb_protocol/var_types.hpp"
 #include "rdb_protocol/wire_func.hpp"
 
 class extproc_pool_t;
 
-namespace re2 {
-class RE2;
-}
-
 namespace ql {
 class datum_t;
 class term_t;
 
 scoped_ptr_t<profile::trace_t> maybe_make_profile_trace(profile_bool_t profile);
 
-struct regex_cache_t {
-    explicit regex_cache_t(size_t cache_size) : regexes(cache_size) {}
-    lru_cache_t<std::string, std::shared_ptr<re2::RE2> > regexes;
-};
-
 class env_t : public home_thread_mixin_t {
 public:
     // This is _not_ to be used for secondary index function evaluation -- it doesn't
@@ -89,6 +80,11 @@ public:
     void set_eval_callback(eval_callback_t *callback);
     void do_eval_callback();
 
+    // The query's `query_usage_t`, or `nullptr` if nobody is counting (such as in
+    // secondary index functions).
+    void set_usage(query_usage_t *usage) { usage_ = usage; }
+    query_usage_t *usage() { return usage_; }
+
 
     const global_optargs_t &get_all_optargs() const {
         return serializable_.global_optargs;
@@ -126,8 +122,6 @@ public:
         }
     }
 
-    regex_cache_t &regex_cache() { return regex_cache_; }
-
     reql_version_t reql_version() const { return reql_version_; }
 
 private:
@@ -141,9 +135,6 @@ private:
     // earlier value.
     const reql_version_t reql_version_;
 
-    // query specific cache parameters; for example match regexes.
-    regex_cache_t regex_cache_;
-
 public:
     const return_empty_normal_batches_t return_empty_normal_batches;
 
@@ -167,6 +158,8 @@ private:
 
     eval_callback_t *eval_callback_;
 
+    query_usage_t *usage_;
+
     DISABLE_COPYING(env_t);
 };
 
@@ -42,6 +42,10 @@ It returns a number of modification reports that should be applied to secondary
 separately. Blobs are detached, and should be deleted later if required (passing the
 modification reports to store_t::update_sindexes() takes care of that).
 
+If `mod_reports_out` is `nullptr`, which the caller may only pass if there are no
+secondary indexes, it deletes the values right away through the deletion context's
+`post_deleter()` instead, and it doesn't load them to build the reports.
+
 Returns `CONTINUE` if it stopped because it collected `max_keys_to_erase` and `ABORT` if
 it stopped because it hit the end of the range. */
 continue_bool_t rdb_erase_small_range(
@@ -33,6 +33,22 @@ scoped_ptr_t<val_t> func_t::call(env_t *env,
     return call(env, make_vector(arg1, arg2), eval_flags);
 }
 
+void func_t::call_on_each(env_t *env, std::vector<datum_t> *rows) const {
+    for (auto it = rows->begin(); it != rows->end(); ++it) {
+        *it = call(env, *it)->as_datum();
+    }
+}
+
+void func_t::filter_call_on_each(env_t *env,
+                                 const std::vector<datum_t> &rows,
+                                 counted_t<const func_t> default_filter_val,
+                                 std::vector<char> *keep_out) const {
+    keep_out->assign(rows.size(), false);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        (*keep_out)[i] = filter_call(env, rows[i], default_filter_val);
+    }
+}
+
 void func_t::assert_deterministic(constant_now_t cn, const char *extra_msg) const {
     rcheck(is_deterministic().test(single_server_t::no, cn),
            base_exc_t::LOGIC,
@@ -41,27 +57,55 @@ void func_t::assert_deterministic(constant_now_t cn, const char *extra_msg) cons
 
 reql_func_t::reql_func_t(const var_scope_t &_captured_scope,
                          std::vector<sym_t> _arg_names,
-                         counted_t<const term_t> _body)
+                         counted_t<const term_t> _body,
+                         counted_t<const compiled_func_t> _compiled)
     : func_t(_body->backtrace()),
       captured_scope(_captured_scope),
       arg_names(std::move(_arg_names)),
-      body(std::move(_body)) { }
+      body(std::move(_body)),
+      compiled(std::move(_compiled)) { }
 
 reql_func_t::reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
                          const var_scope_t &_captured_scope,
                          std::vector<sym_t> _arg_names,
-                         counted_t<const term_t> _body)
+                         counted_t<const term_t> _body,
+                         counted_t<const compiled_func_t> _compiled)
     : func_t(_body->backtrace()),
       captured_scope(_captured_scope),
       arg_names(std::move(_arg_names)),
       term_storage(std::move(_storage)),
-      body(std::move(_body)) { }
+      body(std::move(_body)),
+      compiled(std::move(_compiled)) { }
 
 reql_func_t::~reql_func_t() { }
 
 scoped_ptr_t<val_t> reql_func_t::call(env_t *env,
                                       const std::vector<datum_t> &args,
                                       eval_flags_t eval_flags) const {
+    if (use_compiled(env, args.size())) {
+        datum_t res;
+        if (compiled->call(args[0], &res)) {
+            return make_scoped<val_t>(std::move(res), backtrace());
+        }
+    }
+    return call_interpreted(env, args, eval_flags);
+}
+
+void reql_func_t::call_on_each(env_t *env, std::vector<datum_t> *rows) const {
+    const bool try_compiled = use_compiled(env, 1);
+    for (auto it = rows->begin(); it != rows->end(); ++it) {
+        datum_t res;
+        if (try_compiled && compiled->call(*it, &res)) {
+            *it = std::move(res);
+        } else {
+            *it = call_interpreted(env, make_vector(*it), NO_FLAGS)->as_datum();
+        }
+    }
+}
+
+scoped_ptr_t<val_t> reql_func_t::call_interpreted(env_t *env,
+                                                  const std::vector<datum_t> &args,
+                                                  eval_flags_t eval_flags) const {
     try {
         // We allow arg_names.size() == 0 to specifically permit users (Ruby users
         // especially) to use zero-arity functions without the drivers to know anything
@@ -136,6 +180,77 @@ scoped_ptr_t<val_t> js_func_t::call(
     }
 }
 
+const size_t js_func_t::CALL_BATCH_SIZE = 64;
+
+std::vector<js_result_t> js_func_t::call_batch(env_t *env,
+                                               const std::vector<datum_t> &rows,
+                                               size_t begin) const {
+    js_runner_t::req_config_t config;
+    config.timeout_ms = js_timeout_ms;
+    r_sanity_check(!js_source.empty());
+
+    size_t end = std::min(rows.size(), begin + CALL_BATCH_SIZE);
+    std::vector<std::vector<datum_t> > args_batch;
+    args_batch.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        args_batch.push_back(make_vector(rows[i]));
+    }
+
+    std::vector<js_result_t> results;
+    try {
+        results = env->get_js_runner()->call_batch(js_source, args_batch, config);
+    } catch (const extproc_worker_exc_t &e) {
+        rfail(base_exc_t::INTERNAL,
+              "Javascript query `%s` caused a crash in a worker process.",
+              js_source.c_str());
+    }
+    rcheck(!results.empty(), base_exc_t::INTERNAL,
+           strprintf("Javascript query `%s` returned no results.", js_source.c_str()));
+    return results;
+}
+
+datum_t js_func_t::result_to_datum(const js_result_t &result) const {
+    try {
+        scoped_ptr_t<val_t> val(boost::apply_visitor(
+            js_result_visitor_t(js_source, js_timeout_ms, this), result));
+        return val->as_datum();
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
+void js_func_t::call_on_each(env_t *env, std::vector<datum_t> *rows) const {
+    // A batch that hits an error ends with it, so `result_to_datum` throws before
+    // we get to a row that the worker didn't evaluate.
+    for (size_t begin = 0; begin < rows->size();) {
+        std::vector<js_result_t> results = call_batch(env, *rows, begin);
+        for (size_t i = 0; i < results.size(); ++i) {
+            (*rows)[begin + i] = result_to_datum(results[i]);
+        }
+        begin += results.size();
+    }
+}
+
+void js_func_t::filter_call_on_each(env_t *env,
+                                    const std::vector<datum_t> &rows,
+                                    counted_t<const func_t> default_filter_val,
+                                    std::vector<char> *keep_out) const {
+    keep_out->assign(rows.size(), false);
+    // Every row gets its own error handling, so after an error we continue with
+    // a new batch that starts at the next row.
+    for (size_t begin = 0; begin < rows.size();) {
+        std::vector<js_result_t> results = call_batch(env, rows, begin);
+        for (size_t i = 0; i < results.size(); ++i) {
+            (*keep_out)[begin + i] = filter_call_with(
+                env,
+                [&]() { return result_to_datum(results[i]).as_bool(); },
+                default_filter_val);
+        }
+        begin += results.size();
+    }
+}
+
 optional<size_t> js_func_t::arity() const {
     return r_nullopt;
 }
@@ -210,6 +325,7 @@ func_term_t::func_term_t(compile_env_t *env, const raw_term_t &t)
         captures.implicit_is_captured = false;
     }
 
+    compiled = compiled_func_t::compile(args, compiled_body->get_src());
     arg_names = std::move(args);
     body = std::move(compiled_body);
     external_captures = std::move(captures);
@@ -228,7 +344,7 @@ scoped_ptr_t<val_t> func_term_t::term_eval(scope_env_t *env,
 
 counted_t<const func_t> func_term_t::eval_to_func(const var_scope_t &env_scope) const {
     return make_counted<reql_func_t>(env_scope.filtered_by_captures(external_captures),
-                                     arg_names, body);
+                                     arg_names, body, compiled);
 }
 
 deterministic_t func_term_t::is_deterministic() const {
@@ -318,13 +434,21 @@ bool js_func_t::filter_helper(env_t *env, datum_t arg) const {
 }
 
 bool func_t::filter_call(env_t *env, datum_t arg, counted_t<const func_t> default_filter_val) const {
+    return filter_call_with(env,
+                            [&]() { return filter_helper(env, arg); },
+                            default_filter_val);
+}
+
+bool func_t::filter_call_with(env_t *env,
+                              const std::function<bool()> &helper,
+                              counted_t<const func_t> default_filter_val) const {
     // We have to catch every exception type and save it so we can rethrow it later
     // So we don't trigger a coroutine wait in a catch statement
     std::exception_ptr saved_exception;
     base_exc_t::type_t exception_type;
 
     try {
-        return filter_helper(env, arg);
+        return helper();
     } catch (const base_exc_t &e) {
         saved_exception = std::current_exception();
         exception_type = e.get_type();
@@ -2,6 +2,7 @@
 #ifndef RDB_PROTOCOL_FUNC_HPP_
 #define RDB_PROTOCOL_FUNC_HPP_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
@@ -12,6 +13,7 @@
 
 #include "containers/counted.hpp"
 #include "containers/uuid.hpp"
+#include "rdb_protocol/compiled_func.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/op.hpp"
@@ -55,6 +57,13 @@ public:
                      datum_t arg,
                      counted_t<const func_t> default_filter_val) const;
 
+    // Sets `(*keep_out)[i]` to `filter_call(env, rows[i], default_filter_val)`.
+    // `js_func_t` sends several rows to the worker at once.
+    virtual void filter_call_on_each(env_t *env,
+                                     const std::vector<datum_t> &rows,
+                                     counted_t<const func_t> default_filter_val,
+                                     std::vector<char> *keep_out) const;
+
     // These are simple, they call the vector version of call.
     scoped_ptr_t<val_t> call(env_t *env, eval_flags_t eval_flags = NO_FLAGS) const;
     scoped_ptr_t<val_t> call(env_t *env,
@@ -65,6 +74,10 @@ public:
                              datum_t arg2,
                              eval_flags_t eval_flags = NO_FLAGS) const;
 
+    // Replaces every element of `rows` with the datum the function returns for it,
+    // as `map` does.  `js_func_t` sends several rows to the worker at once.
+    virtual void call_on_each(env_t *env, std::vector<datum_t> *rows) const;
+
     virtual bool is_simple_selector() const {
         return false;
     }
@@ -72,6 +85,11 @@ public:
 protected:
     explicit func_t(backtrace_id_t bt);
 
+    // `filter_call` with `helper` in place of `filter_helper`.
+    bool filter_call_with(env_t *env,
+                          const std::function<bool()> &helper,
+                          counted_t<const func_t> default_filter_val) const;
+
 private:
     virtual bool filter_helper(env_t *env, datum_t arg) const = 0;
 
@@ -81,15 +99,19 @@ private:
 class reql_func_t : public func_t {
 public:
     // Used when constructing in an existing environment - reusing another term storage
+    // `compiled` is `compiled_func_t::compile()` of the arguments and body, which may
+    // be empty.  It's passed in so that `func_term_t` only has to compile it once.
     reql_func_t(const var_scope_t &captured_scope,
                 std::vector<sym_t> arg_names,
-                counted_t<const term_t> body);
+                counted_t<const term_t> body,
+                counted_t<const compiled_func_t> compiled);
 
     // Used when constructing from a function read off the wire
     reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
                 const var_scope_t &captured_scope,
                 std::vector<sym_t> arg_names,
-                counted_t<const term_t> body);
+                counted_t<const term_t> body,
+                counted_t<const compiled_func_t> compiled);
 
     ~reql_func_t();
 
@@ -98,6 +120,8 @@ public:
         const std::vector<datum_t> &args,
         eval_flags_t eval_flags) const;
 
+    void call_on_each(env_t *env, std::vector<datum_t> *rows) const;
+
     optional<size_t> arity() const;
 
     deterministic_t is_deterministic() const;
@@ -111,8 +135,20 @@ public:
 
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
+    friend class compiled_func_t;
     bool filter_helper(env_t *env, datum_t arg) const;
 
+    // `call()` without trying `compiled` first.
+    scoped_ptr_t<val_t> call_interpreted(env_t *env,
+                                         const std::vector<datum_t> &args,
+                                         eval_flags_t eval_flags) const;
+
+    // Whether `compiled` should be tried for a call with `num_args` arguments.
+    // Profiles want to see every term that gets evaluated, so they don't use it.
+    bool use_compiled(env_t *env, size_t num_args) const {
+        return compiled.has() && num_args == 1 && env->trace == nullptr;
+    }
+
     // Only contains the parts of the scope that `body` uses.
     var_scope_t captured_scope;
 
@@ -126,6 +162,9 @@ private:
     // The body of the function, which gets ->eval(...) called when call(...) is called.
     counted_t<const term_t> body;
 
+    // If not empty, `call(...)` evaluates this instead of `body` when it can.
+    counted_t<const compiled_func_t> compiled;
+
     DISABLE_COPYING(reql_func_t);
 };
 
@@ -142,6 +181,12 @@ public:
                              const std::vector<datum_t> &args,
                              eval_flags_t eval_flags) const;
 
+    void call_on_each(env_t *env, std::vector<datum_t> *rows) const;
+    void filter_call_on_each(env_t *env,
+                             const std::vector<datum_t> &rows,
+                             counted_t<const func_t> default_filter_val,
+                             std::vector<char> *keep_out) const;
+
     optional<size_t> arity() const;
 
     deterministic_t is_deterministic() const;
@@ -152,6 +197,16 @@ public:
     void visit(func_visitor_t *visitor) const;
 
 private:
+    // How many rows `call_on_each` sends to the worker in one round trip.
+    static const size_t CALL_BATCH_SIZE;
+
+    // Calls the function on up to `CALL_BATCH_SIZE` rows starting at `begin`.  The
+    // result is never empty, and if it is shorter, its last element is an error.
+    std::vector<js_result_t> call_batch(env_t *env,
+                                        const std::vector<datum_t> &rows,
+                                        size_t begin) const;
+    datum_t result_to_datum(const js_result_t &result) const;
+
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
 
@@ -221,6 +276,8 @@ private:
 
     std::vector<sym_t> arg_names;
     counted_t<const term_t> body;
+    // Shared by every `reql_func_t` that `eval_to_func()` returns.
+    counted_t<const compiled_func_t> compiled;
 
     var_captures_t external_captures;
 };
@@ -2,12 +2,15 @@
 #include "rdb_protocol/geo/indexing.hpp"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "btree/keys.hpp"
 #include "btree/leaf_node.hpp"
 #include "concurrency/interruptor.hpp"
 #include "concurrency/signal.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/lru_cache.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/geojson.hpp"
@@ -21,6 +24,8 @@
 #include "rdb_protocol/geo/s2/strings/strutil.h"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "thread_local.hpp"
 
 using geo::S2Cell;
 using geo::S2CellId;
@@ -304,6 +309,58 @@ std::vector<S2CellId> compute_interior_cell_covering(
     return *covering;
 }
 
+// How many query coverings each thread remembers.
+const size_t QUERY_COVERING_CACHE_SIZE = 1024;
+// Geometries that serialize to more bytes than this aren't cached, so that a few
+// large polygons can't take up a lot of memory.
+const size_t QUERY_COVERING_CACHE_MAX_KEY_SIZE = 16 * KILOBYTE;
+
+typedef lru_cache_t<std::string,
+                    std::pair<std::vector<S2CellId>, std::vector<S2CellId> > >
+    query_covering_cache_t;
+
+TLS_with_init(query_covering_cache_t *, query_covering_cache, nullptr);
+
+void compute_query_cell_coverings(
+        const ql::datum_t &key,
+        int goal_cells,
+        std::vector<S2CellId> *covering_out,
+        std::vector<S2CellId> *interior_covering_out) {
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, goal_cells);
+    ql::datum_serialize(&wm, key, ql::check_datum_serialization_errors_t::NO);
+    bool cacheable = wm.size() <= QUERY_COVERING_CACHE_MAX_KEY_SIZE;
+
+    std::string cache_key;
+    query_covering_cache_t *cache = TLS_get_query_covering_cache();
+    if (cacheable) {
+        vector_stream_t stream;
+        stream.reserve(wm.size());
+        int res = send_write_message(&stream, &wm);
+        guarantee(res == 0);
+        cache_key.assign(stream.vector().begin(), stream.vector().end());
+
+        std::pair<std::vector<S2CellId>, std::vector<S2CellId> > *cached;
+        if (cache != nullptr && cache->lookup(cache_key, &cached)) {
+            *covering_out = cached->first;
+            *interior_covering_out = cached->second;
+            return;
+        }
+    }
+
+    *covering_out = compute_cell_covering(key, goal_cells);
+    *interior_covering_out = compute_interior_cell_covering(key, *covering_out);
+
+    if (cacheable) {
+        if (cache == nullptr) {
+            cache = new query_covering_cache_t(QUERY_COVERING_CACHE_SIZE);
+            TLS_set_query_covering_cache(cache);
+        }
+        cache->insert(std::move(cache_key),
+                      std::make_pair(*covering_out, *interior_covering_out));
+    }
+}
+
 geo_index_traversal_helper_t::geo_index_traversal_helper_t(
         ql::skey_version_t skey_version, const signal_t *interruptor)
     : is_initialized_(false), skey_version_(skey_version), interruptor_(interruptor) { }
@@ -318,6 +375,11 @@ void geo_index_traversal_helper_t::init_query(
     is_initialized_ = true;
 }
 
+void geo_index_traversal_helper_t::exclude_cells(
+        const std::vector<geo::S2CellId> &cells) {
+    excluded_cells_.insert(excluded_cells_.end(), cells.begin(), cells.end());
+}
+
 continue_bool_t
 geo_index_traversal_helper_t::handle_pair(
     scoped_key_value_t &&keyvalue,
@@ -330,6 +392,9 @@ geo_index_traversal_helper_t::handle_pair(
     }
 
     const S2CellId key_cell = btree_key_to_s2cellid(keyvalue.key());
+    if (any_cell_contains(excluded_cells_, key_cell)) {
+        return continue_bool_t::CONTINUE;
+    }
     if (any_cell_intersects(query_cells_, key_cell.range_min(), key_cell.range_max())) {
         bool definitely_intersects_if_point =
             any_cell_contains(query_interior_cells_, key_cell);
@@ -344,7 +409,34 @@ void geo_index_traversal_helper_t::filter_range(
         const btree_key_t *right_incl,
         bool *skip_out) {
     guarantee(is_initialized_);
-    *skip_out = !any_query_cell_intersects(left_excl_or_null, right_incl);
+    *skip_out = !any_query_cell_intersects(left_excl_or_null, right_incl)
+        || any_excluded_cell_contains(left_excl_or_null, right_incl);
+}
+
+bool geo_index_traversal_helper_t::any_excluded_cell_contains(
+        const btree_key_t *left_excl_or_null, const btree_key_t *right_incl) const {
+    if (excluded_cells_.empty()) {
+        return false;
+    }
+    std::pair<S2CellId, bool> left =
+        order_btree_key_relative_to_s2cellid_keys(left_excl_or_null, skey_version_);
+    std::pair<S2CellId, bool> right =
+        order_btree_key_relative_to_s2cellid_keys(right_incl, skey_version_);
+    if (left.first == S2CellId::Sentinel() || right.first == S2CellId::Sentinel()) {
+        return false;
+    }
+
+    /* Every key in the range belongs to a cell whose ID lies in
+    [left.first, right.first].  A cell whose ID lies in the ID range of an excluded
+    cell is a descendant of it (the ID of an ancestor always falls into the gap
+    between the ranges of two of its children), so we can skip the whole range if
+    one excluded cell's range contains both ends. */
+    for (const auto &cell : excluded_cells_) {
+        if (cell.range_min() <= left.first && right.first <= cell.range_max()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool geo_index_traversal_helper_t::any_query_cell_intersects(
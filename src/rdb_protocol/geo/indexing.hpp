@@ -36,6 +36,15 @@ std::vector<geo::S2CellId> compute_interior_cell_covering(
         const ql::datum_t &key,
         const std::vector<geo::S2CellId> &exterior_covering);
 
+/* Computes both coverings of a query geometry.  The same geometries tend to be queried
+over and over again, so the results are cached per thread, keyed by the serialized
+geometry. */
+void compute_query_cell_coverings(
+        const ql::datum_t &key,
+        int goal_cells,
+        std::vector<geo::S2CellId> *covering_out,
+        std::vector<geo::S2CellId> *interior_covering_out);
+
 // TODO (daniel): Support compound indexes somehow.
 class geo_index_traversal_helper_t : public concurrent_traversal_callback_t {
 public:
@@ -46,6 +55,11 @@ public:
         const std::vector<geo::S2CellId> &query_cell_covering,
         const std::vector<geo::S2CellId> &query_interior_cell_covering);
 
+    /* Skips all keys whose cell lies inside one of `cells`, and the B-tree subtrees
+    that only contain such keys.  Used by the nearest traversal to avoid reading the
+    part of the index that an earlier batch has processed completely. */
+    void exclude_cells(const std::vector<geo::S2CellId> &cells);
+
     /* Called for every pair that could potentially intersect with query_grid_keys.
     Note that this might be called multiple times for the same value.
     Correct ordering of the call is not guaranteed. Implementations are expected
@@ -81,6 +95,8 @@ private:
                                            const geo::S2CellId right_max);
     bool any_query_cell_intersects(const btree_key_t *left_excl_or_null,
                                    const btree_key_t *right_incl) const;
+    bool any_excluded_cell_contains(const btree_key_t *left_excl_or_null,
+                                    const btree_key_t *right_incl) const;
     static bool any_cell_intersects(const std::vector<geo::S2CellId> &cells,
                                     const geo::S2CellId left_min,
                                     const geo::S2CellId right_max);
@@ -89,6 +105,7 @@ private:
 
     std::vector<geo::S2CellId> query_cells_;
     std::vector<geo::S2CellId> query_interior_cells_;
+    std::vector<geo::S2CellId> excluded_cells_;
     bool is_initialized_;
     const ql::skey_version_t skey_version_;
     const signal_t *interruptor_;
@@ -6,6 +6,7 @@
 #include "rdb_protocol/geo/geojson.hpp"
 #include "rdb_protocol/geo/geo_visitor.hpp"
 #include "rdb_protocol/geo/s2/s2.h"
+#include "rdb_protocol/geo/s2/s2latlngrect.h"
 #include "rdb_protocol/geo/s2/s2polygon.h"
 #include "rdb_protocol/geo/s2/s2polyline.h"
 #include "rdb_protocol/datum.hpp"
@@ -70,6 +71,48 @@ bool geo_does_intersect(const ql::datum_t &g1,
     return visit_geojson(&tester, g1);
 }
 
+geo_intersection_tester_t::geo_intersection_tester_t(const ql::datum_t &g1)
+    : g1_(g1), converted_(false) { }
+
+geo_intersection_tester_t::~geo_intersection_tester_t() { }
+
+void geo_intersection_tester_t::convert() {
+    datum_string_t type = g1_.get_field("type").as_str();
+    ql::datum_t coordinates = g1_.get_field("coordinates");
+    if (type == "Point") {
+        point_ = coordinates_to_s2point(coordinates);
+    } else if (type == "LineString") {
+        line_ = coordinates_to_s2polyline(coordinates);
+    } else if (type == "Polygon") {
+        polygon_ = coordinates_to_s2polygon(coordinates);
+    } else if (type == "$reql_LatLngRect$") {
+        rect_ = coordinates_to_s2latlngrect(coordinates);
+    }
+    converted_ = true;
+}
+
+bool geo_intersection_tester_t::intersects(const ql::datum_t &g2) {
+    if (!converted_) {
+        convert();
+    }
+    if (point_.has()) {
+        inner_intersection_tester_t<S2Point> tester(point_.get());
+        return visit_geojson(&tester, g2);
+    } else if (line_.has()) {
+        inner_intersection_tester_t<S2Polyline> tester(line_.get());
+        return visit_geojson(&tester, g2);
+    } else if (polygon_.has()) {
+        inner_intersection_tester_t<S2Polygon> tester(polygon_.get());
+        return visit_geojson(&tester, g2);
+    } else if (rect_.has()) {
+        inner_intersection_tester_t<S2LatLngRect> tester(rect_.get());
+        return visit_geojson(&tester, g2);
+    } else {
+        // This throws the right error for the type of `g1_`.
+        return geo_does_intersect(g1_, g2);
+    }
+}
+
 bool geo_does_intersect(const S2Point &point,
                         const S2Point &other_point) {
     return point == other_point;
@@ -3,6 +3,8 @@
 #define RDB_PROTOCOL_GEO_INTERSECTION_HPP_
 
 #include "containers/counted.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/geo/s2/util/math/vector3.h"
 
 namespace geo {
@@ -12,14 +14,35 @@ class S2Polyline;
 class S2Polygon;
 }
 
-namespace ql {
-class datum_t;
-}
-
 /* A variant that works on two GeoJSON objects */
 bool geo_does_intersect(const ql::datum_t &g1,
                         const ql::datum_t &g2);
 
+/* Tests many GeoJSON objects for intersection with the same one.  `intersects(g2)`
+is equivalent to `geo_does_intersect(g1, g2)`, but `g1` only gets converted to S2 once
+(on the first call, so that errors are thrown at the same time as before). */
+class geo_intersection_tester_t {
+public:
+    explicit geo_intersection_tester_t(const ql::datum_t &g1);
+    ~geo_intersection_tester_t();
+
+    bool intersects(const ql::datum_t &g2);
+
+private:
+    void convert();
+
+    const ql::datum_t g1_;
+    bool converted_;
+    // At most one of these is set after `convert()`.  If none is, `g1_` has a type
+    // that `geo_does_intersect` rejects.
+    scoped_ptr_t<geo::S2Point> point_;
+    scoped_ptr_t<geo::S2Polyline> line_;
+    scoped_ptr_t<geo::S2Polygon> polygon_;
+    scoped_ptr_t<geo::S2LatLngRect> rect_;
+
+    DISABLE_COPYING(geo_intersection_tester_t);
+};
+
 /* Variants for each pair of S2 geometry */
 bool geo_does_intersect(const geo::S2Point &point,
                         const geo::S2Point &other_point);
@@ -100,10 +100,12 @@ geo_intersecting_cb_t::geo_intersecting_cb_t(
 
 void geo_intersecting_cb_t::init_query(const ql::datum_t &_query_geometry) {
     query_geometry = _query_geometry;
-    std::vector<geo::S2CellId> covering(
-        compute_cell_covering(query_geometry, QUERYING_GOAL_GRID_CELLS));
-    geo_index_traversal_helper_t::init_query(
-        covering, compute_interior_cell_covering(query_geometry, covering));
+    query_intersection.init(new geo_intersection_tester_t(query_geometry));
+    std::vector<geo::S2CellId> covering;
+    std::vector<geo::S2CellId> interior_covering;
+    compute_query_cell_coverings(
+        query_geometry, QUERYING_GOAL_GRID_CELLS, &covering, &interior_covering);
+    geo_index_traversal_helper_t::init_query(covering, interior_covering);
 }
 
 continue_bool_t geo_intersecting_cb_t::on_candidate(
@@ -174,9 +176,7 @@ continue_bool_t geo_intersecting_cb_t::on_candidate(
             }
         }
 
-        // TODO (daniel): This is a little inefficient because we re-parse
-        // the query_geometry for each test.
-        if ((definitely_intersects || geo_does_intersect(query_geometry, sindex_val))
+        if ((definitely_intersects || query_intersection->intersects(sindex_val))
             && post_filter(sindex_val, val)) {
             if (distinct_emitted->size() >= env->limits().array_size_limit()) {
                 emit_error(ql::exc_t(ql::base_exc_t::RESOURCE,
@@ -319,6 +319,7 @@ nearest_traversal_cb_t::nearest_traversal_cb_t(
         ql::env_t *_env,
         nearest_traversal_state_t *_state) :
     geo_intersecting_cb_t(_slice, std::move(_sindex), _env, &_state->distinct_emitted),
+    last_filtered_dist(0.0),
     state(_state) {
     init_query_geometry();
 }
@@ -361,6 +362,22 @@ void nearest_traversal_cb_t::init_query_geometry() {
         ql::datum_t _query_geometry =
             construct_geo_polygon(shell, holes, ql::configured_limits_t::unlimited);
         init_query(_query_geometry);
+
+        // 3. Every document with a point in the hole is within
+        //    state->processed_inradius, so an earlier batch has emitted it.  Index
+        //    entries in cells that lie completely inside the hole can't lead to new
+        //    results, so we don't read them again.  (A document that is further away
+        //    has an entry for the cell that holds its nearest point, and that cell
+        //    isn't inside the hole.)
+        //    Every batch has a different hole, so its covering doesn't go through
+        //    the cache of `compute_query_cell_coverings()`.
+        if (!holes.empty()) {
+            ql::datum_t processed_geometry = construct_geo_polygon(
+                holes[0], ql::configured_limits_t::unlimited);
+            exclude_cells(compute_interior_cell_covering(
+                processed_geometry,
+                compute_cell_covering(processed_geometry, QUERYING_GOAL_GRID_CELLS)));
+        }
     } catch (const geo_range_exception_t &e) {
         // The radius has become too large for constructing the query geometry.
         // Abort.
@@ -382,21 +399,17 @@ bool nearest_traversal_cb_t::post_filter(
     // Filter out results that are outside of the current inradius
     const S2Point s2center =
         S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    return dist <= state->current_inradius;
+    last_filtered_dist =
+        geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
+    return last_filtered_dist <= state->current_inradius;
 }
 
 continue_bool_t nearest_traversal_cb_t::emit_result(
-        ql::datum_t &&sindex_val,
+        UNUSED ql::datum_t &&sindex_val,
         UNUSED store_key_t &&key,
         ql::datum_t &&val)
         THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
-    // TODO (daniel): Could we avoid re-computing the distance? We have already
-    //   done it in post_filter().
-    const S2Point s2center =
-        S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    result_acc.push_back(std::make_pair(dist, std::move(val)));
+    result_acc.push_back(std::make_pair(last_filtered_dist, std::move(val)));
 
     return continue_bool_t::CONTINUE;
 }
@@ -17,6 +17,7 @@
 #include "rdb_protocol/geo/ellipsoid.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
+#include "rdb_protocol/geo/intersection.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/shards.hpp"
@@ -115,6 +116,8 @@ private:
     btree_slice_t *slice;
     geo_sindex_data_t sindex;
     ql::datum_t query_geometry;
+    // Converts `query_geometry` to S2 once instead of for every candidate.
+    scoped_ptr_t<geo_intersection_tester_t> query_intersection;
 
     ql::env_t *env;
 
@@ -225,6 +228,10 @@ protected:
 private:
     void init_query_geometry();
 
+    // The distance that `post_filter()` computed, for the `emit_result()` call that
+    // `on_candidate()` makes right after it without blocking in between.
+    double last_filtered_dist;
+
     // Accumulate results for the current batch until finish() is called
     std::vector<std::pair<double, ql::datum_t> > result_acc;
     optional<ql::exc_t> error;
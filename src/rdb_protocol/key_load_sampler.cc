@@ -0,0 +1,22 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/key_load_sampler.hpp"
+
+void key_load_sampler_t::get_loads(const key_range_t &range,
+                                   std::map<store_key_t, int64_t> *loads_out) const {
+    for (const std::string &sample : samples) {
+        store_key_t key(sample);
+        if (range.contains_key(key)) {
+            (*loads_out)[key] += sample_rate;
+        }
+    }
+}
+
+void key_load_sampler_t::add_sample(const store_key_t &key) {
+    std::string sample(reinterpret_cast<const char *>(key.contents()), key.size());
+    if (samples.size() < capacity) {
+        samples.push_back(std::move(sample));
+    } else {
+        samples[next_sample] = std::move(sample);
+        next_sample = (next_sample + 1) % capacity;
+    }
+}
@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
+#define RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "random.hpp"
+
+/* `key_load_sampler_t` remembers a random sample of the primary keys that recent point
+reads and writes on a `store_t` have accessed. `rebalance()` uses it to put the split
+points where they divide the load evenly, rather than just the documents. Since it only
+keeps the last `capacity` samples, it reflects recent traffic rather than everything
+since the server started. */
+class key_load_sampler_t {
+public:
+    // We sample one in `sample_rate` accesses, so every sample stands for about that
+    // many accesses.
+    static const int sample_rate = 16;
+    static const size_t capacity = 256;
+
+    key_load_sampler_t() : next_sample(0) { }
+
+    void record(const store_key_t &key) {
+        if (randint(sample_rate) == 0) {
+            add_sample(key);
+        }
+    }
+
+    // Adds the estimated number of recent accesses to each key in `range` to
+    // `loads_out`.
+    void get_loads(const key_range_t &range,
+                   std::map<store_key_t, int64_t> *loads_out) const;
+
+private:
+    void add_sample(const store_key_t &key);
+
+    // A ring buffer; once it's full, `next_sample` is the oldest sample.  We store the
+    // keys as strings because a `store_key_t` always takes up `MAX_KEY_SIZE` bytes.
+    std::vector<std::string> samples;
+    size_t next_sample;
+
+    DISABLE_COPYING(key_load_sampler_t);
+};
+
+#endif  // RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
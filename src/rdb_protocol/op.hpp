@@ -20,6 +20,7 @@ class func_term_t;
 
 enum class single_server_t { no, yes };
 enum class constant_now_t { no, yes };
+enum class constant_tables_t { no, yes };
 
 
 class deterministic_t {
@@ -34,6 +35,9 @@ public:
     // Is non-deterministic if r.now is non-constant.
     static deterministic_t constant_now() { return deterministic_t(4); }
 
+    // Is non-deterministic if the tables it reads change.  Example: `r.table`.
+    static deterministic_t constant_tables() { return deterministic_t(8); }
+
     // Is always deterministic.
     static deterministic_t always() { return deterministic_t(0); }
 
@@ -45,13 +49,16 @@ public:
     // Params tell the situation:
     //  - ss: are we running the term on a single server?
     //  - cn: is r.now() constant?
+    //  - ct: may we pretend that the tables don't change?
     // Returns true if the expression is deterministic (under the given conditions).
     // ("The expression" is whatever expression this deterministic_t value was
     // computed from.)
-    bool test(single_server_t ss, constant_now_t cn) const {
+    bool test(single_server_t ss, constant_now_t cn,
+              constant_tables_t ct = constant_tables_t::no) const {
         // Turn off the bits that don't apply.
         int mask = (ss == single_server_t::yes ? single_server().bitset : 0)
-            | (cn == constant_now_t::yes ? constant_now().bitset : 0);
+            | (cn == constant_now_t::yes ? constant_now().bitset : 0)
+            | (ct == constant_tables_t::yes ? constant_tables().bitset : 0);
         int remaining_bits = bitset & ~mask;
         return remaining_bits == 0;
     }
@@ -45,6 +45,7 @@ static const std::set<std::string> acceptable_optargs({
     "auth",
     "base",
     "binary_format",
+    "cache_ttl",
     "changefeed_queue_size",
     "conflict",
     "data",
@@ -73,11 +74,13 @@ static const std::set<std::string> acceptable_optargs({
     "interleave",
     "ordered",
     "left_bound",
+    "low_priority",
     "max_batch_bytes",
     "max_batch_rows",
     "max_batch_seconds",
     "max_dist",
     "max_results",
+    "max_staleness_ms",
     "method",
     "min_batch_rows",
     "multi",
@@ -88,6 +91,7 @@ static const std::set<std::string> acceptable_optargs({
     "overwrite",
     "page",
     "page_limit",
+    "parallel_eval",
     "params",
     "primary_key",
     "primary_replica_tag",
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/order_util.hpp"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -94,6 +95,41 @@ build_comparisons_from_optional_terms(const term_t *target,
 lt_cmp_t::lt_cmp_t(std::vector<std::pair<order_direction_t, counted_t<const func_t> > > _comparisons)
             : comparisons(std::move(_comparisons)) { }
 
+datum_t lt_cmp_t::eval_comparison(env_t *env, const func_t *f, const datum_t &row) {
+    try {
+        return f->call(env, row)->as_datum();
+    } catch (const base_exc_t &e) {
+        if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+            throw;
+        }
+        return datum_t();
+    }
+}
+
+bool lt_cmp_t::values_lt(const std::vector<datum_t> &l,
+                         const std::vector<datum_t> &r) const {
+    for (size_t i = 0; i < comparisons.size(); ++i) {
+        const bool desc = comparisons[i].first == DESC;
+        const datum_t &lval = l[i];
+        const datum_t &rval = r[i];
+        if (!lval.has() && !rval.has()) {
+            continue;
+        }
+        if (!lval.has()) {
+            return true != desc;
+        }
+        if (!rval.has()) {
+            return false != desc;
+        }
+        int cmp_res = lval.cmp(rval);
+        if (cmp_res == 0) {
+            continue;
+        }
+        return (cmp_res < 0) != desc;
+    }
+    return false;
+}
+
 bool lt_cmp_t::operator()(env_t *env,
                           profile::sampler_t *sampler,
                           datum_t l,
@@ -104,23 +140,8 @@ bool lt_cmp_t::operator()(env_t *env,
     }
 
     for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
-        datum_t lval;
-        datum_t rval;
-        try {
-            lval = it->second->call(env, l)->as_datum();
-        } catch (const base_exc_t &e) {
-            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
-                throw;
-            }
-        }
-
-        try {
-            rval = it->second->call(env, r)->as_datum();
-        } catch (const base_exc_t &e) {
-            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
-                throw;
-            }
-        }
+        datum_t lval = eval_comparison(env, it->second.get(), l);
+        datum_t rval = eval_comparison(env, it->second.get(), r);
 
         if (!lval.has() && !rval.has()) {
             continue;
@@ -141,4 +162,79 @@ bool lt_cmp_t::operator()(env_t *env,
     return false;
 }
 
+void lt_cmp_t::stable_sort(env_t *env,
+                           profile::sampler_t *sampler,
+                           std::vector<datum_t> *rows) const {
+    // With fewer rows nothing gets compared, and so nothing gets evaluated either.
+    if (rows->size() < 2) {
+        return;
+    }
+    std::vector<std::vector<datum_t> > values(rows->size());
+    std::vector<std::string> keys(rows->size());
+    bool have_keys = true;
+    bool failed = false;
+    try {
+        for (size_t i = 0; i < rows->size(); ++i) {
+            if (sampler != nullptr) {
+                sampler->new_sample();
+            }
+            values[i].reserve(comparisons.size());
+            for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
+                values[i].push_back(
+                    eval_comparison(env, it->second.get(), (*rows)[i]));
+                if (!have_keys) {
+                    continue;
+                }
+                const size_t begin = keys[i].size();
+                // Missing values sort first, and the type bytes are all at least 1.
+                if (!values[i].back().has()) {
+                    keys[i].push_back('\x00');
+                } else if (!values[i].back().append_sort_key(&keys[i])) {
+                    have_keys = false;
+                    continue;
+                }
+                if (it->first == DESC) {
+                    // No sort key is a prefix of another, so flipping the bits
+                    // reverses the order.
+                    for (size_t j = begin; j < keys[i].size(); ++j) {
+                        keys[i][j] = ~keys[i][j];
+                    }
+                }
+            }
+        }
+    } catch (const base_exc_t &) {
+        failed = true;
+    }
+    if (failed) {
+        // We evaluate every function on every row, but comparing the rows a pair at
+        // a time skips the later functions once an earlier one orders the rows.  So
+        // the error is only raised if that would raise it as well.
+        std::stable_sort(rows->begin(), rows->end(),
+                         [&](const datum_t &a, const datum_t &b) {
+                             return (*this)(env, sampler, a, b);
+                         });
+        return;
+    }
+
+    std::vector<size_t> order(rows->size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    if (have_keys) {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return keys[a] < keys[b];
+        });
+    } else {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return values_lt(values[a], values[b]);
+        });
+    }
+    std::vector<datum_t> sorted;
+    sorted.reserve(rows->size());
+    for (size_t i : order) {
+        sorted.push_back(std::move((*rows)[i]));
+    }
+    *rows = std::move(sorted);
+}
+
 } // namespace ql
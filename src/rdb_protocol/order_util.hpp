@@ -5,6 +5,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "errors.hpp"
 
@@ -54,7 +55,20 @@ public:
                     datum_t l,
                     datum_t r) const;
 
+    // Sorts `*rows` the way `std::stable_sort` with this comparison would, but only
+    // calls the functions once per row instead of twice per comparison.  Unless the
+    // values contain pseudotypes, the rows get sorted by `datum_t::append_sort_key()`
+    // so that a comparison is just a `memcmp`.
+    void stable_sort(env_t *env,
+                     profile::sampler_t *sampler,
+                     std::vector<datum_t> *rows) const;
+
 private:
+    // Returns an empty datum if the row doesn't have the value.
+    static datum_t eval_comparison(env_t *env, const func_t *f, const datum_t &row);
+    // Compares the results of `eval_comparison` for every comparison.
+    bool values_lt(const std::vector<datum_t> &l, const std::vector<datum_t> &r) const;
+
     const std::vector<std::pair<order_direction_t, counted_t<const func_t> > >
         comparisons;
 };
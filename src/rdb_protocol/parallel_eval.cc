@@ -0,0 +1,197 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/parallel_eval.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "math.hpp"
+#include "random.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/op.hpp"
+#include "rdb_protocol/val.hpp"
+#include "threading.hpp"
+
+namespace ql {
+
+// How many calls a thread claims at once.
+const size_t PARALLEL_EVAL_CHUNK_SIZE = 32;
+
+// Smaller batches aren't worth the thread hops.
+const size_t PARALLEL_EVAL_MIN_COUNT = 4 * PARALLEL_EVAL_CHUNK_SIZE;
+
+// The most threads that help out with one batch.
+const int PARALLEL_EVAL_MAX_HELPERS = 7;
+
+namespace {
+
+struct parallel_eval_state_t {
+    parallel_eval_state_t(env_t *env, size_t _count,
+                          const std::function<void(env_t *, size_t)> *_fn)
+        : count(_count),
+          num_chunks(ceil_divide(_count, PARALLEL_EVAL_CHUNK_SIZE)),
+          fn(_fn),
+          home_thread(get_thread_id()),
+          rdb_ctx(env->get_rdb_ctx()),
+          return_empty_normal_batches(env->return_empty_normal_batches),
+          s_env(env->get_serializable_env()),
+          next_chunk(0),
+          failed(false),
+          errors(num_chunks),
+          chunks_done(0),
+          chunks_claimed(std::numeric_limits<size_t>::max()),
+          all_done(nullptr) { }
+
+    const size_t count;
+    const size_t num_chunks;
+    // Only dereferenced by whoever holds a claimed chunk, so it stays valid until
+    // the caller has stopped waiting.
+    const std::function<void(env_t *, size_t)> *const fn;
+    const threadnum_t home_thread;
+
+    // What helpers need to build their own `env_t`.
+    rdb_context_t *const rdb_ctx;
+    const return_empty_normal_batches_t return_empty_normal_batches;
+    const serializable_env_t s_env;
+
+    // Every chunk below this has been claimed by some thread.
+    std::atomic<size_t> next_chunk;
+    // Set once any chunk has thrown, so that nobody starts new chunks.
+    std::atomic<bool> failed;
+    // Each chunk is written only by the thread that claimed it.
+    std::vector<std::exception_ptr> errors;
+
+    // These are only accessed on `home_thread`.
+    size_t chunks_done;
+    size_t chunks_claimed;
+    cond_t *all_done;
+};
+
+bool claim_chunk(parallel_eval_state_t *state, size_t *chunk_out) {
+    if (state->failed.load()) {
+        return false;
+    }
+    const size_t chunk = state->next_chunk.fetch_add(1);
+    if (chunk >= state->num_chunks) {
+        return false;
+    }
+    *chunk_out = chunk;
+    return true;
+}
+
+void run_chunk(parallel_eval_state_t *state, env_t *env, size_t chunk) {
+    const size_t end = std::min(state->count, (chunk + 1) * PARALLEL_EVAL_CHUNK_SIZE);
+    try {
+        for (size_t i = chunk * PARALLEL_EVAL_CHUNK_SIZE; i < end; ++i) {
+            (*state->fn)(env, i);
+        }
+    } catch (...) {
+        state->errors[chunk] = std::current_exception();
+        state->failed.store(true);
+    }
+}
+
+void run_helper(const std::shared_ptr<parallel_eval_state_t> &state) {
+    size_t chunk;
+    if (!claim_chunk(state.get(), &chunk)) {
+        // We showed up too late.  The caller isn't waiting for us.
+        return;
+    }
+    size_t done = 0;
+    {
+        // Interruption is checked by the caller between its own chunks; a helper
+        // always finishes the chunks it has claimed.
+        cond_t non_interruptor;
+        env_t env(state->rdb_ctx, state->return_empty_normal_batches,
+                  &non_interruptor, state->s_env, nullptr);
+        do {
+            run_chunk(state.get(), &env, chunk);
+            ++done;
+        } while (claim_chunk(state.get(), &chunk));
+    }
+
+    on_thread_t thread_switcher(state->home_thread);
+    state->chunks_done += done;
+    if (state->all_done != nullptr && state->chunks_done == state->chunks_claimed) {
+        state->all_done->pulse();
+    }
+}
+
+}  // namespace
+
+bool should_eval_in_parallel(env_t *env, size_t count,
+                             const func_t *f, const func_t *also) {
+    if (!env->get_all_optargs().has_optarg("parallel_eval")) {
+        return false;
+    }
+    if (!env->get_optarg(env, "parallel_eval")->as_bool()) {
+        return false;
+    }
+    if (count < PARALLEL_EVAL_MIN_COUNT || get_num_threads() < 2) {
+        return false;
+    }
+    // Profiles and old-version semantics aren't something helpers can reproduce.
+    if (env->trace != nullptr
+        || env->get_rdb_ctx() == nullptr
+        || env->reql_version() != reql_version_t::LATEST) {
+        return false;
+    }
+    return f->is_deterministic().test(single_server_t::yes, constant_now_t::no)
+        && (also == nullptr
+            || also->is_deterministic().test(single_server_t::yes, constant_now_t::no));
+}
+
+void parallel_eval(env_t *env, size_t count,
+                   const std::function<void(env_t *, size_t)> &fn) {
+    auto state = std::make_shared<parallel_eval_state_t>(env, count, &fn);
+
+    const int num_threads = get_num_threads();
+    const int num_helpers = static_cast<int>(
+        std::min<size_t>(std::min(PARALLEL_EVAL_MAX_HELPERS, num_threads - 1),
+                         state->num_chunks - 1));
+    if (num_helpers > 0) {
+        // Start on a random thread, so that concurrent batches don't all pile onto
+        // the same neighbors.
+        const int home = state->home_thread.threadnum;
+        const int offset = randint(num_threads - 1);
+        for (int i = 0; i < num_helpers; ++i) {
+            const int other = (offset + i) % (num_threads - 1);
+            const int thread = (home + 1 + other) % num_threads;
+            coro_t::spawn_on_thread([state]() { run_helper(state); },
+                                    threadnum_t(thread));
+        }
+    }
+
+    size_t chunk;
+    size_t done = 0;
+    while (claim_chunk(state.get(), &chunk)) {
+        run_chunk(state.get(), env, chunk);
+        ++done;
+    }
+
+    // From here on nobody can claim a chunk, so we know how many to wait for.
+    state->chunks_claimed = std::min(state->next_chunk.exchange(state->num_chunks),
+                                     state->num_chunks);
+    state->chunks_done += done;
+    if (state->chunks_done < state->chunks_claimed) {
+        cond_t all_done;
+        state->all_done = &all_done;
+        all_done.wait_lazily_unordered();
+        state->all_done = nullptr;
+    }
+
+    for (const std::exception_ptr &error : state->errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+}  // namespace ql
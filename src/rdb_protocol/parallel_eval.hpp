@@ -0,0 +1,42 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_PARALLEL_EVAL_HPP_
+#define RDB_PROTOCOL_PARALLEL_EVAL_HPP_
+
+#include <stddef.h>
+
+#include <functional>
+
+namespace ql {
+
+class env_t;
+class func_t;
+
+/* Spreads the evaluation of a function over a batch of datums across threads, for
+queries that are run with the `parallel_eval` optarg.
+
+The batch is cut into chunks.  The calling coroutine evaluates chunks on its own
+thread, and a few helper coroutines on other threads steal the chunks it hasn't
+gotten to yet.  A helper that arrives on a busy thread late just finds nothing left
+to do, so the calling thread never waits for a helper that hasn't started a chunk.
+
+This is only safe for functions that don't touch any thread-bound state, which is
+what `should_eval_in_parallel()` checks: the functions have to be deterministic (so
+they don't read tables or call out to JavaScript or HTTP), and the query can't be
+profiled.  Helpers evaluate the same `func_t` with an `env_t` of their own, which is
+fine because terms are immutable and datums are atomically refcounted. */
+
+// Whether `count` calls of `f` (and of `also`, unless it's null) are worth spreading
+// across threads, and are allowed to be.
+bool should_eval_in_parallel(env_t *env, size_t count,
+                             const func_t *f, const func_t *also = nullptr);
+
+// Calls `fn(e, i)` for every `i` in `[0, count)`, where `e` is an environment for the
+// thread the call runs on.  Calls for different indices can run at the same time.  If
+// any of the calls throws, this rethrows the exception of the lowest chunk that
+// failed, after all chunks that were started have finished.
+void parallel_eval(env_t *env, size_t count,
+                   const std::function<void(env_t *, size_t)> &fn);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_PARALLEL_EVAL_HPP_
@@ -1,6 +1,9 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "rdb_protocol/pathspec.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #include "rdb_protocol/term.hpp"
 
 namespace ql {
@@ -141,6 +144,40 @@ void pathspec_t::init_from(const pathspec_t &other) {
 
 
 /* Limit the datum to only the paths specified by the pathspec. */
+// Adds the fields of `datum` that `pathspec` selects to `res`, without building an
+// intermediate object for every path.  On a buffer-backed row, only the selected
+// fields are ever deserialized.
+void project_helper(const datum_t &datum,
+                    const pathspec_t &pathspec, recurse_flag_t recurse,
+                    const configured_limits_t &limits,
+                    datum_object_builder_t *res) {
+    if (const datum_string_t *str = pathspec.as_str()) {
+        const datum_t val = datum.get_field(*str, NOTHROW);
+        if (val.has()) {
+            res->overwrite(*str, val);
+        }
+    } else if (const std::vector<pathspec_t> *vec = pathspec.as_vec()) {
+        for (auto it = vec->begin(); it != vec->end(); ++it) {
+            project_helper(datum, *it, recurse, limits, res);
+        }
+    } else if (const std::map<datum_string_t, pathspec_t> *map = pathspec.as_map()) {
+        for (auto it = map->begin(); it != map->end(); ++it) {
+            const datum_t val = datum.get_field(it->first, NOTHROW);
+            if (val.has()) {
+                try {
+                    datum_t sub_result =
+                        project(val, it->second, RECURSE, limits);
+                    res->overwrite(it->first, sub_result);
+                } catch (const datum_exc_t &e) {
+                    // do nothing
+                }
+            }
+        }
+    } else {
+        unreachable();
+    }
+}
+
 datum_t project(datum_t datum,
                 const pathspec_t &pathspec, recurse_flag_t recurse,
                 const configured_limits_t &limits) {
@@ -153,37 +190,27 @@ datum_t project(datum_t datum,
         return std::move(res).to_datum();
     } else {
         datum_object_builder_t res;
-        if (pathspec.as_str() != NULL) {
-            datum_string_t str(*pathspec.as_str());
-            const datum_t val = datum.get_field(str, NOTHROW);
-            if (val.has()) {
-                res.overwrite(std::move(str), val);
-            }
-        } else if (const std::vector<pathspec_t> *vec = pathspec.as_vec()) {
-            for (auto it = vec->begin(); it != vec->end(); ++it) {
-                datum_t sub_result = project(datum, *it, recurse, limits);
-                for (size_t i = 0; i < sub_result.obj_size(); ++i) {
-                    auto pair = sub_result.get_pair(i);
-                    res.overwrite(pair.first, pair.second);
-                }
-            }
-        } else if (const std::map<datum_string_t, pathspec_t> *map = pathspec.as_map()) {
-            for (auto it = map->begin(); it != map->end(); ++it) {
-                const datum_t val = datum.get_field(it->first, NOTHROW);
-                if (val.has()) {
-                    try {
-                        datum_t sub_result =
-                            project(val, it->second, RECURSE, limits);
-                        res.overwrite(it->first, sub_result);
-                    } catch (const datum_exc_t &e) {
-                        // do nothing
-                    }
-                }
+        project_helper(datum, pathspec, recurse, limits, &res);
+        return std::move(res).to_datum();
+    }
+}
+
+// Collects the keys of `pathspec` into `keys_out` if it only names top-level fields.
+// Returns `false` if it selects any nested fields.
+bool get_top_level_keys(const pathspec_t &pathspec,
+                        std::vector<const datum_string_t *> *keys_out) {
+    if (const datum_string_t *str = pathspec.as_str()) {
+        keys_out->push_back(str);
+        return true;
+    } else if (const std::vector<pathspec_t> *vec = pathspec.as_vec()) {
+        for (auto it = vec->begin(); it != vec->end(); ++it) {
+            if (!get_top_level_keys(*it, keys_out)) {
+                return false;
             }
-        } else {
-            unreachable();
         }
-        return std::move(res).to_datum();
+        return true;
+    } else {
+        return false;
     }
 }
 
@@ -227,6 +254,31 @@ datum_t unproject(datum_t datum,
         }
         return std::move(res).to_datum();
     } else {
+        std::vector<const datum_string_t *> keys;
+        if (get_top_level_keys(pathspec, &keys)) {
+            // This is what `without` usually gets.  We copy the pairs we keep straight
+            // into the new object, instead of copying all of them into a builder and
+            // then deleting some again.
+            std::sort(keys.begin(), keys.end(),
+                      [](const datum_string_t *a, const datum_string_t *b) {
+                          return *a < *b;
+                      });
+            const size_t num_pairs = datum.obj_size();
+            std::vector<std::pair<datum_string_t, datum_t> > pairs;
+            pairs.reserve(num_pairs);
+            auto key_it = keys.begin();
+            for (size_t i = 0; i < num_pairs; ++i) {
+                std::pair<datum_string_t, datum_t> pair = datum.get_pair(i);
+                // Both are sorted, so we only ever have to move forward in `keys`.
+                while (key_it != keys.end() && **key_it < pair.first) {
+                    ++key_it;
+                }
+                if (key_it == keys.end() || **key_it != pair.first) {
+                    pairs.push_back(std::move(pair));
+                }
+            }
+            return datum_t(std::move(pairs));
+        }
         datum_object_builder_t res(datum);
         unproject_helper(&res, pathspec, recurse, limits);
         return std::move(res).to_datum();
@@ -2,6 +2,7 @@
 
 #include <inttypes.h>
 
+#include <functional>
 #include <limits>
 
 #include "errors.hpp"
@@ -15,6 +16,10 @@
 
 namespace profile {
 
+// How many events a trace and a sampler have room for before they have to grow.
+static const size_t TRACE_RESERVED_RECORDS = 256;
+static const size_t SAMPLE_RESERVED_RECORDS = 16;
+
 start_t::start_t() { }
 
 start_t::start_t(const std::string &description)
@@ -232,16 +237,16 @@ void sampler_t::init(const std::string &description, trace_t *parent) {
     total_time_ = ticks_t{0};
     n_samples_ = 0;
     if (parent_) {
-        parent_->start_sample(&event_log_);
+        records_.reserve(SAMPLE_RESERVED_RECORDS);
+        parent_->start_sample(&records_);
     }
 }
 
-ticks_t duration(const event_log_t &event_log) {
-    guarantee(!event_log.empty());
-    if (auto start = boost::get<start_t>(&event_log.at(0))) {
-        auto stop = boost::get<stop_t>(&event_log.back());
-        guarantee(stop);
-        return ticks_t{stop->when_.nanos - start->when_.nanos};
+ticks_t duration(const record_log_t &records) {
+    guarantee(!records.empty());
+    if (records.front().type == record_t::type_t::START) {
+        guarantee(records.back().type == record_t::type_t::STOP);
+        return ticks_t{records.back().nanos - records.front().nanos};
     } else {
         //This is a code path that is currently never hit and that will go a
         //way when we implement more meaningful sampling functions.
@@ -250,21 +255,23 @@ ticks_t duration(const event_log_t &event_log) {
 }
 
 void sampler_t::new_sample() {
-    if (!event_log_.empty()) {
+    if (!records_.empty()) {
         n_samples_++;
-        total_time_.nanos += duration(event_log_).nanos;
+        total_time_.nanos += duration(records_).nanos;
     }
 
-    event_log_.clear();
+    // This keeps the capacity, so the next sample doesn't allocate anything.
+    records_.clear();
 }
 
 sampler_t::~sampler_t() {
     new_sample();
     if (parent_) {
         if (n_samples_ > 0) {
-            parent_->stop_sample(description_, ticks_t{total_time_.nanos / int64_t(n_samples_)}, n_samples_, &event_log_);
+            parent_->stop_sample(description_,
+                ticks_t{total_time_.nanos / int64_t(n_samples_)}, n_samples_, &records_);
         } else {
-            parent_->stop_sample(&event_log_);
+            parent_->stop_sample(&records_);
         }
     }
 }
@@ -290,86 +297,129 @@ void disabler_t::init(trace_t *parent) {
     }
 }
 
+/* Turns the events that come back from the shards into records. */
+class append_records_visitor_t : public boost::static_visitor<void> {
+public:
+    append_records_visitor_t(
+            std::function<size_t(const std::string &)> _intern, record_log_t *_out)
+        : intern(std::move(_intern)), out(_out) { }
+
+    void operator()(const start_t &start) const {
+        out->push_back(record_t{
+            record_t::type_t::START, intern(start.description_), start.when_.nanos, 0});
+    }
+    void operator()(const split_t &split) const {
+        out->push_back(record_t{
+            record_t::type_t::SPLIT, split.n_parallel_jobs_, 0, 0});
+    }
+    void operator()(const sample_t &sample) const {
+        out->push_back(record_t{
+            record_t::type_t::SAMPLE, intern(sample.description_),
+            sample.mean_duration_.nanos, sample.n_samples_});
+    }
+    void operator()(const stop_t &stop) const {
+        out->push_back(record_t{record_t::type_t::STOP, 0, stop.when_.nanos, 0});
+    }
+
+private:
+    std::function<size_t(const std::string &)> intern;
+    record_log_t *out;
+};
+
 trace_t::trace_t()
-    : redirected_event_log_(NULL), disabled_ref_count_(0) { }
+    : redirected_records_(NULL), disabled_ref_count_(0) {
+    records_.reserve(TRACE_RESERVED_RECORDS);
+}
 
 ql::datum_t trace_t::as_datum() const {
-    guarantee(!redirected_event_log_);
-    event_log_t::const_iterator begin = event_log_.begin();
+    guarantee(!redirected_records_);
+    event_log_t event_log = to_event_log();
+    event_log_t::const_iterator begin = event_log.begin();
     // Again, use defaults, as there's no predicting where this could
     // come in response to user requests.
-    return construct_datum(&begin, event_log_.end(),
+    return construct_datum(&begin, event_log.end(),
                            ql::configured_limits_t());
 }
 
 event_log_t trace_t::extract_event_log() RVALUE_THIS {
     // These guarantees imply that this trace_t gets left in a default-constructed
     // state (which is valid, thereby acceptable for an RVALUE_THIS function).
-    guarantee(redirected_event_log_ == NULL);
+    guarantee(redirected_records_ == NULL);
     guarantee(disabled_ref_count_ == 0);
-    return std::move(event_log_);
+    event_log_t event_log = to_event_log();
+    records_.clear();
+    descriptions_.clear();
+    description_ids_.clear();
+    return event_log;
 }
 
 void trace_t::start(const std::string &description) {
     if (disabled()) { return; }
     //debugf("Start %s %p.\n", description.c_str(), this);
-    event_log_target()->push_back(start_t(description));
+    records_target()->push_back(record_t{
+        record_t::type_t::START, intern(description), get_ticks().nanos, 0});
 }
 
 void trace_t::stop() {
     if (disabled()) { return; }
     //debugf("Stop %p.\n", this);
-    event_log_target()->push_back(stop_t());
+    records_target()->push_back(
+        record_t{record_t::type_t::STOP, 0, get_ticks().nanos, 0});
 }
 
 void trace_t::start_split() {
     if (disabled()) { return; }
     //debugf("Start split %p.\n", this);
-    event_log_target()->push_back(split_t());
+    records_target()->push_back(record_t{record_t::type_t::SPLIT, 0, 0, 0});
 }
 
 void trace_t::stop_split(size_t n_parallel_jobs_, const event_log_t &par_event_log) {
     if (disabled()) { return; }
     //debugf("Stop split %zu, %p.\n", n_parallel_jobs_, this);
-    auto split = boost::get<split_t>(&event_log_target()->back());
-    guarantee(split);
-    split->n_parallel_jobs_ = n_parallel_jobs_;
-    event_log_target()->insert(event_log_target()->end(), par_event_log.begin(), par_event_log.end());
+    record_log_t *target = records_target();
+    guarantee(!target->empty() && target->back().type == record_t::type_t::SPLIT);
+    target->back().arg = n_parallel_jobs_;
+    append_records_visitor_t visitor(
+        [this](const std::string &d) { return intern(d); }, target);
+    for (const event_t &event : par_event_log) {
+        boost::apply_visitor(visitor, event);
+    }
 }
 
-void trace_t::start_sample(event_log_t *event_log) {
+void trace_t::start_sample(record_log_t *records) {
     if (disabled()) { return; }
     //debugf("Start sample %p.\n", this);
     /* This is a tad hacky. We currently don't  allow samples within samples.
      * And if someone tries to do it the inner sample winds up just being a
      * no-op. We should see if in practice this is something we actually want
      * to support. */
-    if (!redirected_event_log_) {
-        redirected_event_log_ = event_log;
+    if (!redirected_records_) {
+        redirected_records_ = records;
     }
 }
 
 void trace_t::stop_sample(const std::string &description,
-        ticks_t mean_duration, size_t n_samples, event_log_t *event_log) {
+        ticks_t mean_duration, size_t n_samples, record_log_t *records) {
     if (disabled()) { return; }
     //debugf("Stop sample %s, %p.\n", description.c_str(), this);
-    /* Don't reset the redirected_event_log_ if the sampler_t wasn't
+    /* Don't reset the redirected_records_ if the sampler_t wasn't
      * actually being redirected to. The predicate fails when the
      * innter samplers in nested sampler_ts are destructed. */
-    if (event_log == redirected_event_log_) {
-        redirected_event_log_ = NULL;
+    if (records == redirected_records_) {
+        redirected_records_ = NULL;
     }
-    event_log_target()->push_back(sample_t(description, mean_duration, n_samples));
+    records_target()->push_back(record_t{
+        record_t::type_t::SAMPLE, intern(description), mean_duration.nanos, n_samples});
 }
 
-void trace_t::stop_sample(event_log_t *event_log) {
+void trace_t::stop_sample(record_log_t *records) {
     if (disabled()) { return; }
     //debugf("Stop sample %p.\n", this);
-    /* Don't reset the redirected_event_log_ if the sampler_t wasn't
+    /* Don't reset the redirected_records_ if the sampler_t wasn't
      * actually being redirected to. The predicate fails when the
      * innter samplers in nested sampler_ts are destructed. */
-    if (event_log == redirected_event_log_) {
-        redirected_event_log_ = NULL;
+    if (records == redirected_records_) {
+        redirected_records_ = NULL;
     }
 }
 
@@ -384,11 +434,50 @@ bool trace_t::disabled() {
     return disabled_ref_count_ > 0;
 }
 
-event_log_t *trace_t::event_log_target() {
-    if (redirected_event_log_) {
-        return redirected_event_log_;
+size_t trace_t::intern(const std::string &description) {
+    auto res = description_ids_.insert(
+        std::make_pair(description, descriptions_.size()));
+    if (res.second) {
+        descriptions_.push_back(description);
+    }
+    return res.first->second;
+}
+
+event_log_t trace_t::to_event_log() const {
+    event_log_t event_log;
+    event_log.reserve(records_.size());
+    for (const record_t &record : records_) {
+        switch (record.type) {
+        case record_t::type_t::START: {
+            start_t start;
+            start.description_ = descriptions_[record.arg];
+            start.when_.nanos = record.nanos;
+            event_log.push_back(std::move(start));
+        } break;
+        case record_t::type_t::SPLIT:
+            event_log.push_back(split_t(record.arg));
+            break;
+        case record_t::type_t::SAMPLE:
+            event_log.push_back(sample_t(descriptions_[record.arg],
+                ticks_t{record.nanos}, record.n_samples));
+            break;
+        case record_t::type_t::STOP: {
+            stop_t stop;
+            stop.when_.nanos = record.nanos;
+            event_log.push_back(stop);
+        } break;
+        default:
+            unreachable();
+        }
+    }
+    return event_log;
+}
+
+record_log_t *trace_t::records_target() {
+    if (redirected_records_) {
+        return redirected_records_;
     } else {
-        return &event_log_;
+        return &records_;
     }
 }
 
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_PROFILE_HPP_
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "errors.hpp"
@@ -68,8 +69,27 @@ typedef boost::variant<start_t, split_t, sample_t, stop_t> event_t;
 
 typedef std::vector<event_t> event_log_t;
 
-/* A trace_t contains an event_log_t and provides private methods for adding
- * events to it. These methods are leveraged by the instruments. */
+/* record_t is how a trace_t stores an event while the query runs. Unlike event_t
+ * it doesn't own any memory, the descriptions are interned in the trace_t, so
+ * recording an event is just appending to a vector that already has room. */
+struct record_t {
+    enum class type_t : uint8_t { START, SPLIT, SAMPLE, STOP };
+
+    type_t type;
+    /* START and SAMPLE: the index of the description in the trace_t. SPLIT: the
+     * number of parallel jobs. */
+    size_t arg;
+    /* START and STOP: when it happened. SAMPLE: the mean duration. */
+    int64_t nanos;
+    /* SAMPLE: the number of samples. */
+    size_t n_samples;
+};
+
+typedef std::vector<record_t> record_log_t;
+
+/* A trace_t records events and provides private methods for adding events to it.
+ * These methods are leveraged by the instruments. The events only get turned into
+ * an event_log_t or a datum once the response is built. */
 class trace_t {
 public:
     trace_t();
@@ -84,19 +104,24 @@ private:
     void stop();
     void start_split();
     void stop_split(size_t n_parallel_jobs_, const event_log_t &event_log);
-    void start_sample(event_log_t *sample_event_log);
+    void start_sample(record_log_t *sample_records);
     void stop_sample(const std::string &description, ticks_t mean_duration,
-        size_t n_samples, event_log_t *sample_event_log);
-    void stop_sample(event_log_t *sample_event_log);
+        size_t n_samples, record_log_t *sample_records);
+    void stop_sample(record_log_t *sample_records);
     void disable();
     void enable();
 
-    /* returns the event_log_t that we should put events in */
-    event_log_t *event_log_target();
-    event_log_t event_log_;
-    /* redirected_event_log_ is used during sampling to send the events to the
+    size_t intern(const std::string &description);
+    event_log_t to_event_log() const;
+
+    /* returns the record_log_t that we should put events in */
+    record_log_t *records_target();
+    record_log_t records_;
+    /* redirected_records_ is used during sampling to send the events to the
      * sampler to be processed. */
-    event_log_t *redirected_event_log_;
+    record_log_t *redirected_records_;
+    std::vector<std::string> descriptions_;
+    std::unordered_map<std::string, size_t> description_ids_;
     size_t disabled_ref_count_;
     bool disabled();
 
@@ -186,7 +211,7 @@ public:
 private:
     void init(const std::string &description, trace_t *parent);
     trace_t *parent_;
-    event_log_t event_log_;
+    record_log_t records_;
 
     std::string description_;
     ticks_t total_time_;
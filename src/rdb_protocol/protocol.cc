@@ -13,6 +13,7 @@
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/optional.hpp"
 #include "containers/disk_backed_queue.hpp"
+#include "random.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/changefeed.hpp"
 #include "rdb_protocol/distribution_progress.hpp"
@@ -34,6 +35,7 @@ void post_construct_and_drain_queue(
         uuid_u sindex_id_to_bring_up_to_date,
         key_range_t *construction_range_inout,
         int64_t max_pairs_to_construct,
+        int64_t *pairs_constructed_inout,
         store_t *store,
         scoped_ptr_t<disk_backed_queue_wrapper_t<rdb_modification_report_t> >
             &&mod_queue)
@@ -68,12 +70,14 @@ void resume_construct_sindex(
         store, store_keepalive.get_drain_signal());
     double current_progress =
         progress_estimator.estimate_progress(construct_range.left);
+    int64_t rows_constructed = 0;
     map_insertion_sentry_t<
         store_t::sindex_context_map_t::key_type,
         store_t::sindex_context_map_t::mapped_type> sindex_context_sentry(
             store->get_sindex_context_map(),
             sindex_to_construct,
-            std::make_pair(current_microtime(), &current_progress));
+            store_t::sindex_context_t{
+                current_microtime(), &current_progress, &rows_constructed});
 
     /* We start by clearing out any residual data in the index left behind by a previous
     post construction process (if the server got terminated in the middle). */
@@ -169,6 +173,7 @@ void resume_construct_sindex(
             sindex_to_construct,
             &remaining_range,
             PAIRS_TO_CONSTRUCT_PER_PASS,
+            &rows_constructed,
             store,
             std::move(mod_queue));
 
@@ -185,6 +190,7 @@ void post_construct_and_drain_queue(
         uuid_u sindex_id_to_bring_up_to_date,
         key_range_t *construction_range_inout,
         int64_t max_pairs_to_construct,
+        int64_t *pairs_constructed_inout,
         store_t *store,
         scoped_ptr_t<disk_backed_queue_wrapper_t<rdb_modification_report_t> >
             &&mod_queue)
@@ -199,6 +205,7 @@ void post_construct_and_drain_queue(
 
     try {
         const size_t MOD_QUEUE_SIZE_LIMIT = 16;
+        const int64_t pairs_constructed_before = *pairs_constructed_inout;
         // This constructs a part of the index and updates `construction_range_inout`
         // to the range that's still remaining.
         post_construct_secondary_index_range(
@@ -208,6 +215,7 @@ void post_construct_and_drain_queue(
             // Abort if the mod_queue gets larger than the `MOD_QUEUE_SIZE_LIMIT`, or
             // we've constructed `max_pairs_to_construct` pairs.
             [&](int64_t pairs_constructed) {
+                *pairs_constructed_inout = pairs_constructed_before + pairs_constructed;
                 return pairs_constructed >= max_pairs_to_construct
                     || mod_queue->size() > MOD_QUEUE_SIZE_LIMIT;
             },
@@ -252,8 +260,7 @@ void post_construct_and_drain_queue(
             // Pretend that the indexes in `sindexes` have been post-constructed up to
             // the new range. This is important to make the call to
             // `rdb_update_sindexes()` below actually update the indexes.
-            // We use the same trick in the `post_construct_traversal_helper_t`.
-            // TODO: Avoid this hackery (here and in `post_construct_traversal_helper_t`)
+            // TODO: Avoid this hackery
             for (auto &&access : sindexes) {
                 access->sindex.needs_post_construction_range = *construction_range_inout;
             }
@@ -463,6 +470,10 @@ struct rdb_r_get_region_visitor : public boost::static_visitor<region_t> {
         return dg.region;
     }
 
+    region_t operator()(const sample_read_t &sr) const {
+        return sr.region;
+    }
+
     region_t operator()(const changefeed_subscribe_t &s) const {
         return s.shard_region;
     }
@@ -638,6 +649,10 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
         return rangey_read(dg);
     }
 
+    bool operator()(const sample_read_t &sr) const {
+        return rangey_read(sr);
+    }
+
     bool operator()(const dummy_read_t &d) const {
         return rangey_read(d);
     }
@@ -651,6 +666,7 @@ bool read_t::shard(const hash_region_t<key_range_t> &region,
     read_t::variant_t payload;
     bool result = boost::apply_visitor(rdb_r_shard_visitor_t(&region, &payload), read);
     *read_out = read_t(payload, profile, read_mode);
+    read_out->max_staleness_ms = max_staleness_ms;
     return result;
 }
 
@@ -704,6 +720,7 @@ public:
     void operator()(const intersecting_geo_read_t &gr);
     void operator()(const nearest_geo_read_t &gr);
     void operator()(const distribution_read_t &rg);
+    void operator()(const sample_read_t &sr);
     void operator()(const changefeed_subscribe_t &);
     void operator()(const changefeed_limit_subscribe_t &);
     void operator()(const changefeed_stamp_t &);
@@ -912,6 +929,7 @@ void rdb_r_unshard_visitor_t::unshard_range_batch(const query_t &q, sorting_t so
             out->result = std::move(resp->result);
             return;
         }
+        out->rows_scanned += resp->rows_scanned;
 
         if (i == 0) {
             out->reql_version = resp->reql_version;
@@ -979,6 +997,10 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
         size_t total_range_keys = 0;
 
         while (i < results.size() && results[i].region.inner == range) {
+            // Every hash shard sees different keys, so their loads just add up.
+            for (const auto &pair : results[i].key_loads) {
+                res.key_loads[pair.first] += pair.second;
+            }
             size_t tmp_total_keys = 0;
             for (auto mit = results[i].key_counts.begin();
                  mit != results[i].key_counts.end();
@@ -1024,6 +1046,47 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
     response_out->response = res;
 }
 
+void rdb_r_unshard_visitor_t::operator()(const sample_read_t &sr) {
+    // Every shard has picked its rows at random, so we take the next row of a shard
+    // with a probability that's proportional to how many of the remaining rows of the
+    // table are in that shard.
+    std::vector<sample_read_response_t *> results(count);
+    std::vector<size_t> next_row(count, 0);
+    std::vector<uint64_t> weights(count);
+    uint64_t total_weight = 0;
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = boost::get<sample_read_response_t>(&responses[i].response);
+        guarantee(results[i] != nullptr, "Bad boost::get\n");
+        // A shard may have more rows than it estimated.
+        weights[i] = results[i]->rows.empty()
+            ? 0
+            : std::max<uint64_t>(results[i]->estimated_rows, results[i]->rows.size());
+        total_weight += weights[i];
+    }
+
+    sample_read_response_t res;
+    res.estimated_rows = total_weight;
+    while (res.rows.size() < sr.n && total_weight > 0) {
+        uint64_t pick = randuint64(total_weight);
+        size_t i = 0;
+        while (pick >= weights[i]) {
+            pick -= weights[i];
+            ++i;
+        }
+        res.rows.push_back(std::move(results[i]->rows[next_row[i]]));
+        ++next_row[i];
+        if (next_row[i] == results[i]->rows.size()) {
+            total_weight -= weights[i];
+            weights[i] = 0;
+        } else {
+            --total_weight;
+            --weights[i];
+        }
+    }
+
+    response_out->response = std::move(res);
+}
+
 void rdb_r_unshard_visitor_t::operator()(const dummy_read_t &) {
     *response_out = responses[0];
 }
@@ -1076,6 +1139,7 @@ struct use_snapshot_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const changefeed_stamp_t &) const {           return false; }
     bool operator()(const changefeed_point_stamp_t &) const {     return false; }
     bool operator()(const distribution_read_t &) const {          return true;  }
+    bool operator()(const sample_read_t &) const {                return true;  }
 };
 
 // Only use snapshotting if we're doing a range get.
@@ -1101,6 +1165,7 @@ struct route_to_primary_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const changefeed_stamp_t &) const {           return true;  }
     bool operator()(const changefeed_point_stamp_t &) const {     return true;  }
     bool operator()(const distribution_read_t &) const {          return false; }
+    bool operator()(const sample_read_t &) const {                return false; }
 };
 
 // Route changefeed reads to the primary replica. For other reads we don't care.
@@ -1467,10 +1532,12 @@ RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_read_response_t, data);
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
     ql::skey_version_t, int8_t,
     ql::skey_version_t::post_1_16, ql::skey_version_t::post_1_16);
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
-    rget_read_response_t, stamp_response, result, reql_version);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
+    rget_read_response_t, stamp_response, result, reql_version, rows_scanned);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(nearest_geo_read_response_t, results_or_error);
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(distribution_read_response_t, region, key_counts);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
+    distribution_read_response_t, region, key_counts, key_loads);
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(sample_read_response_t, rows, estimated_rows);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
     changefeed_subscribe_response_t, server_uuids, addrs);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
@@ -1539,8 +1606,10 @@ RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
 
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
         distribution_read_t, max_depth, result_limit, region);
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(sample_read_t, n, region);
 
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_subscribe_t, addr, shard_region);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(changefeed_subscribe_t,
+                                    addr, shard_region, transforms, serializable_env);
 RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
     changefeed_limit_subscribe_t,
     addr,
@@ -1553,7 +1622,7 @@ RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_stamp_t, addr, region);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_point_stamp_t, addr, key);
 
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(read_t, read, profile, read_mode);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(read_t, read, profile, read_mode, max_staleness_ms);
 
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_write_response_t, result);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_delete_response_t, result);
@@ -125,11 +125,14 @@ struct rget_read_response_t {
     optional<changefeed_stamp_response_t> stamp_response;
     ql::result_t result;
     reql_version_t reql_version;
+    // How many rows the read loaded from the btree, including the ones that didn't
+    // end up in `result`.  This goes into the query's `query_usage_t`.
+    uint64_t rows_scanned;
 
     rget_read_response_t()
-        : reql_version(reql_version_t::EARLIEST) { }
+        : reql_version(reql_version_t::EARLIEST), rows_scanned(0) { }
     explicit rget_read_response_t(const ql::exc_t &ex)
-        : result(ex), reql_version(reql_version_t::EARLIEST) { }
+        : result(ex), reql_version(reql_version_t::EARLIEST), rows_scanned(0) { }
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(rget_read_response_t);
 
@@ -161,9 +164,22 @@ struct distribution_read_response_t {
     // key_counts[kn] = the number of keys in [kn, right_key)
     region_t region;
     std::map<store_key_t, int64_t> key_counts;
+    // The estimated number of recent point reads and writes of each key, from the
+    // stores' `key_load_sampler_t`s.  Unlike `key_counts`, this isn't scaled to the
+    // `result_limit`.
+    std::map<store_key_t, int64_t> key_loads;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_response_t);
 
+struct sample_read_response_t {
+    // In random order.
+    std::vector<ql::datum_t> rows;
+    // The estimated number of rows in the region that the rows were picked from, so
+    // that the rows of different shards can be combined fairly.
+    uint64_t estimated_rows;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sample_read_response_t);
+
 struct changefeed_subscribe_response_t {
     changefeed_subscribe_response_t() { }
     std::set<uuid_u> server_uuids;
@@ -228,6 +244,7 @@ struct read_response_t {
                            changefeed_stamp_response_t,
                            changefeed_point_stamp_response_t,
                            distribution_read_response_t,
+                           sample_read_response_t,
                            dummy_read_response_t> variant_t;
     variant_t response;
     profile::event_log_t event_log;
@@ -439,12 +456,36 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_t);
 
+// Picks `n` rows at random from the table.  Instead of reading every row, the stores
+// split their key range at the keys of the B-tree's internal nodes, and read only as
+// many of the resulting key ranges as there are rows to pick.
+class sample_read_t {
+public:
+    sample_read_t() : n(0), region(region_t::universe()) { }
+    explicit sample_read_t(size_t _n) : n(_n), region(region_t::universe()) { }
+
+    size_t n;
+    region_t region;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sample_read_t);
+
 struct changefeed_subscribe_t {
     changefeed_subscribe_t() { }
     explicit changefeed_subscribe_t(ql::changefeed::client_t::addr_t _addr)
         : addr(_addr), shard_region(region_t::universe()) { }
+    changefeed_subscribe_t(ql::changefeed::client_t::addr_t _addr,
+                           std::vector<ql::transform_variant_t> _transforms,
+                           serializable_env_t s_env)
+        : addr(_addr),
+          shard_region(region_t::universe()),
+          transforms(std::move(_transforms)),
+          serializable_env(std::move(s_env)) { }
     ql::changefeed::client_t::addr_t addr;
     region_t shard_region;
+    // See `server_t::add_client`.  `serializable_env` is set iff `transforms`
+    // isn't empty.
+    std::vector<ql::transform_variant_t> transforms;
+    optional<serializable_env_t> serializable_env;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_subscribe_t);
 
@@ -490,11 +531,15 @@ struct read_t {
                            changefeed_limit_subscribe_t,
                            changefeed_point_stamp_t,
                            distribution_read_t,
+                           sample_read_t,
                            dummy_read_t> variant_t;
 
     variant_t read;
     profile_bool_t profile;
     read_mode_t read_mode;
+    // How far behind the primary replica the replica that serves the read may be, if
+    // `read_mode` is `read_mode_t::BOUNDED`.
+    uint64_t max_staleness_ms;
 
     region_t get_region() const THROWS_NOTHING;
     // Returns true if the read has any operation for this region.  Returns
@@ -507,10 +552,16 @@ struct read_t {
                  signal_t *interruptor) const
         THROWS_ONLY(interrupted_exc_t);
 
-    read_t() : profile(profile_bool_t::DONT_PROFILE), read_mode(read_mode_t::SINGLE) { }
+    read_t()
+        : profile(profile_bool_t::DONT_PROFILE),
+          read_mode(read_mode_t::SINGLE),
+          max_staleness_ms(0) { }
     template<class T>
     read_t(T &&_read, profile_bool_t _profile, read_mode_t _read_mode)
-        : read(std::forward<T>(_read)), profile(_profile), read_mode(_read_mode) { }
+        : read(std::forward<T>(_read)),
+          profile(_profile),
+          read_mode(_read_mode),
+          max_staleness_ms(0) { }
 
     // We use snapshotting for queries that acquire-and-hold large portions of the
     // table, so that they don't block writes.
@@ -1,7 +1,14 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/query_cache.hpp"
 
+#include <vector>
+
+#include "clustering/administration/admin_op_exc.hpp"
+#include "logger.hpp"
+#include "pprint/js_pprint.hpp"
+#include "random.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/op.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/response.hpp"
 #include "rdb_protocol/term_walker.hpp"
@@ -47,14 +54,126 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
             backtrace_registry_t::EMPTY_BACKTRACE);
     }
 
+    const bool sampled = rdb_ctx->slow_query_threshold_ms != 0
+        && !query_params->profile
+        && randint(SLOW_QUERY_SAMPLE_RATE) == 0;
+    scoped_ptr_t<entry_t> entry(new entry_t(query_params,
+                                            std::move(deterministic_time),
+                                            compile(query_params),
+                                            sampled));
+
+    scoped_ptr_t<ref_t> ref(new ref_t(this,
+                                      query_params->token,
+                                      std::move(query_params->throttler),
+                                      entry.get(),
+                                      interruptor));
+    auto insert_res = queries.insert(std::make_pair(query_params->token,
+                                                    std::move(entry)));
+    guarantee(insert_res.second);
+    return ref;
+}
+
+// Whether `term` can't write or change anything, so that we may answer it with the
+// result of an earlier run.
+static bool term_is_read_only(const raw_term_t &term) {
+    std::vector<raw_term_t> to_visit(1, term);
+    while (!to_visit.empty()) {
+        raw_term_t t = to_visit.back();
+        to_visit.pop_back();
+        if (term_is_write_or_meta(t.type())) {
+            return false;
+        }
+        if (t.type() == Term::DATUM) {
+            continue;
+        }
+        for (size_t i = 0; i < t.num_args(); ++i) {
+            to_visit.push_back(t.arg(i));
+        }
+        t.each_optarg([&](const raw_term_t &optarg, const std::string &) {
+                to_visit.push_back(optarg);
+            });
+    }
+    return true;
+}
+
+bool query_cache_t::results_cacheable(const raw_term_t &root,
+                                      const counted_t<const term_t> &term_tree) {
+    return term_is_read_only(root)
+        && (!term_tree.has()
+            || term_tree->is_deterministic().test(single_server_t::yes,
+                                                  constant_now_t::no,
+                                                  constant_tables_t::yes));
+}
+
+// Sets `*name_out` to the name in `term` if it's a literal string that is a valid name.
+static bool get_literal_name(const raw_term_t &term, name_string_t *name_out) {
+    if (term.type() != Term::DATUM) {
+        return false;
+    }
+    datum_t name = term.datum();
+    return name.get_type() == datum_t::R_STR && name_out->assign_value(name.as_str());
+}
+
+bool query_cache_t::match_point_get(const raw_term_t &term, point_get_t *out) {
+    if (term.type() != Term::GET || term.num_args() != 2 || term.num_optargs() != 0) {
+        return false;
+    }
+    raw_term_t table = term.arg(0);
+    raw_term_t key = term.arg(1);
+    if (table.type() != Term::TABLE || table.num_optargs() != 0
+        || key.type() != Term::DATUM) {
+        return false;
+    }
+    if (table.num_args() == 2) {
+        raw_term_t db = table.arg(0);
+        name_string_t db_name;
+        if (db.type() != Term::DB || db.num_args() != 1 || db.num_optargs() != 0
+            || !get_literal_name(db.arg(0), &db_name)) {
+            return false;
+        }
+        out->db_name.set(db_name);
+        out->db_bt = db.bt();
+    } else if (table.num_args() != 1) {
+        return false;
+    }
+    if (!get_literal_name(table.arg(table.num_args() - 1), &out->table_name)) {
+        return false;
+    }
+    out->table_bt = table.bt();
+    out->key = key.datum();
+    out->get_bt = term.bt();
+    return true;
+}
+
+counted_t<query_cache_t::compiled_query_t> query_cache_t::compile(
+        query_params_t *query_params) {
+    if (query_params->compile_cache_key.has_value()) {
+        auto it = compiled_queries.find(*query_params->compile_cache_key);
+        if (it != compiled_queries.end()) {
+            compiled_queries_lru.splice(compiled_queries_lru.begin(),
+                                        compiled_queries_lru,
+                                        it->second.lru_it);
+            return it->second.compiled_query;
+        }
+    }
+
     global_optargs_t global_optargs;
     counted_t<const term_t> term_tree;
+    optional<point_get_t> point_get;
     try {
         query_params->term_storage->preprocess();
         global_optargs = query_params->term_storage->global_optargs();
 
-        compile_env_t compile_env((var_visibility_t()));
-        term_tree = compile_term(&compile_env, query_params->term_storage->root_term());
+        // A profile has to come from the term tree.
+        point_get_t get;
+        if (!query_params->profile
+            && match_point_get(query_params->term_storage->root_term(), &get)) {
+            point_get.set(std::move(get));
+        } else {
+            compile_env_t compile_env((var_visibility_t()));
+            term_tree = compile_term(&compile_env,
+                                     query_params->term_storage->root_term());
+        }
 
     } catch (const exc_t &e) {
         throw bt_exc_t(Response::COMPILE_ERROR,
@@ -67,20 +186,30 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
                        e.what(),
                        backtrace_registry_t::EMPTY_BACKTRACE);
     }
-    scoped_ptr_t<entry_t> entry(new entry_t(query_params,
-                                            std::move(global_optargs),
-                                            std::move(deterministic_time),
-                                            std::move(term_tree)));
-
-    scoped_ptr_t<ref_t> ref(new ref_t(this,
-                                      query_params->token,
-                                      std::move(query_params->throttler),
-                                      entry.get(),
-                                      interruptor));
-    auto insert_res = queries.insert(std::make_pair(query_params->token,
-                                                    std::move(entry)));
-    guarantee(insert_res.second);
-    return ref;
+    bool cacheable = query_params->compile_cache_key.has_value()
+        && results_cacheable(query_params->term_storage->root_term(), term_tree);
+    counted_t<compiled_query_t> compiled_query =
+        make_counted<compiled_query_t>(std::move(query_params->term_storage),
+                                       std::move(global_optargs),
+                                       std::move(term_tree),
+                                       std::move(point_get),
+                                       cacheable);
+
+    if (query_params->compile_cache_key.has_value()) {
+        if (compiled_queries.size() == MAX_COMPILED_QUERIES) {
+            const std::string *oldest = compiled_queries_lru.back();
+            compiled_queries_lru.pop_back();
+            compiled_queries.erase(*oldest);
+        }
+        auto res = compiled_queries.insert(
+            std::make_pair(std::move(*query_params->compile_cache_key),
+                           compiled_queries_entry_t()));
+        guarantee(res.second);
+        compiled_queries_lru.push_front(&res.first->first);
+        res.first->second.compiled_query = compiled_query;
+        res.first->second.lru_it = compiled_queries_lru.begin();
+    }
+    return compiled_query;
 }
 
 scoped_ptr_t<query_cache_t::ref_t> query_cache_t::get(query_params_t *query_params,
@@ -147,7 +276,9 @@ query_cache_t::ref_t::ref_t(query_cache_t *_query_cache,
                             signal_t *interruptor) :
         entry(_entry),
         token(_token),
-        trace(maybe_make_profile_trace(entry->profile)),
+        trace(maybe_make_profile_trace(entry->sampled
+                                           ? profile_bool_t::PROFILE
+                                           : entry->profile)),
         query_cache(_query_cache),
         throttler(std::move(_throttler)),
         drainer_lock(&entry->drainer),
@@ -205,6 +336,8 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
             &combined_interruptor,
             serializable,
             trace.get_or_null());
+        env.set_usage(&entry->usage);
+        const ticks_t start_time = get_ticks();
 
         if (entry->state == entry_t::state_t::START) {
             run(&env, res);
@@ -214,8 +347,12 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
         if (entry->state == entry_t::state_t::STREAM) {
             serve(&env, res);
         }
+        entry->usage.active_micros += (get_ticks().nanos - start_time.nanos) / 1000;
+        if (entry->state == entry_t::state_t::DONE) {
+            maybe_log_slow_query();
+        }
 
-        if (trace.has()) {
+        if (entry->profile == profile_bool_t::PROFILE) {
             res->set_profile(trace->as_datum());
         }
     } catch (const interrupted_exc_t &ex) {
@@ -252,14 +389,15 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(ex));
+                       entry->compiled_query->term_storage->backtrace_registry()
+                           .datum_backtrace(ex));
     } catch (const datum_exc_t &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(
-                            backtrace_id_t::empty(), 0));
+                       entry->compiled_query->term_storage->backtrace_registry()
+                           .datum_backtrace(backtrace_id_t::empty(), 0));
     } catch (const std::exception &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
@@ -269,17 +407,53 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
     }
 }
 
+// Returns the number of seconds from the `cache_ttl` optarg, if there is one.
+static optional<double> get_cache_ttl(env_t *env) {
+    if (!env->get_all_optargs().has_optarg("cache_ttl")) {
+        return optional<double>();
+    }
+    double cache_ttl = env->get_optarg(env, "cache_ttl")->as_num();
+    rcheck_toplevel(cache_ttl > 0 && cache_ttl <= 86400, base_exc_t::LOGIC,
+        strprintf("Illegal cache_ttl `%g`.  (Must be > 0 and <= 86400 seconds.)",
+                  cache_ttl));
+    return make_optional(cache_ttl);
+}
+
 void query_cache_t::ref_t::run(env_t *env, response_t *res) {
+    const optional<double> cache_ttl = get_cache_ttl(env);
+    compiled_query_t *compiled_query = entry->compiled_query.get();
+    if (cache_ttl.has_value()
+        && entry->profile == profile_bool_t::DONT_PROFILE
+        && compiled_query->cached_result.has()
+        && get_ticks().nanos < compiled_query->cached_result_expiration.nanos) {
+        res->set_type(Response::SUCCESS_ATOM);
+        res->set_data(compiled_query->cached_result);
+        entry->state = entry_t::state_t::DONE;
+        return;
+    }
+
+    if (compiled_query->point_get.has_value()) {
+        datum_t d = run_point_get(env);
+        maybe_cache_result(cache_ttl, d);
+        res->set_type(Response::SUCCESS_ATOM);
+        res->set_data(d);
+        entry->state = entry_t::state_t::DONE;
+        return;
+    }
+
     scope_env_t scope_env(env, var_scope_t());
     scoped_ptr_t<val_t> val = entry->term_tree->eval(&scope_env);
 
     if (val->get_type().is_convertible(val_t::type_t::DATUM)) {
+        datum_t d = val->as_datum();
+        maybe_cache_result(cache_ttl, d);
         res->set_type(Response::SUCCESS_ATOM);
-        res->set_data(val->as_datum());
+        res->set_data(d);
         entry->state = entry_t::state_t::DONE;
     } else if (counted_t<grouped_data_t> gd =
             val->maybe_as_promiscuous_grouped_data(scope_env.env)) {
         datum_t d = to_datum_for_client_serialization(std::move(*gd), env->limits());
+        maybe_cache_result(cache_ttl, d);
         res->set_type(Response::SUCCESS_ATOM);
         res->set_data(d);
         entry->state = entry_t::state_t::DONE;
@@ -287,6 +461,7 @@ void query_cache_t::ref_t::run(env_t *env, response_t *res) {
         counted_t<datum_stream_t> seq = val->as_seq(env);
         const datum_t arr = seq->as_array(env);
         if (arr.has()) {
+            maybe_cache_result(cache_ttl, arr);
             res->set_type(Response::SUCCESS_ATOM);
             res->set_data(arr);
             entry->state = entry_t::state_t::DONE;
@@ -303,6 +478,88 @@ void query_cache_t::ref_t::run(env_t *env, response_t *res) {
     }
 }
 
+// Throws `error` the way `REQL_RETHROW` would from the term with the backtrace `bt`.
+NORETURN static void rethrow_admin_err(backtrace_id_t bt, const admin_err_t &error) {
+    rfail_src(bt,
+              error.query_state == query_state_t::FAILED
+                  ? base_exc_t::OP_FAILED
+                  : base_exc_t::OP_INDETERMINATE,
+              "%s", error.msg.c_str());
+}
+
+datum_t query_cache_t::ref_t::run_point_get(env_t *env) {
+    // This does what the `db`, `table` and `get` terms would, and fails the same way.
+    const point_get_t &get = *entry->compiled_query->point_get;
+    admin_err_t error;
+    counted_t<const db_t> db;
+    if (get.db_name.has_value()) {
+        if (!env->reql_cluster_interface()->db_find(
+                *get.db_name, env->interruptor, &db, &error)) {
+            rethrow_admin_err(get.db_bt, error);
+        }
+    } else {
+        db = env->get_optarg(env, "db")->as_db();
+    }
+    counted_t<base_table_t> table;
+    if (!env->reql_cluster_interface()->table_find(get.table_name, db,
+            optional<admin_identifier_format_t>(), env->interruptor, &table, &error)) {
+        rethrow_admin_err(get.table_bt, error);
+    }
+    try {
+        return table->read_row(env, get.key, read_mode_t::SINGLE);
+    } catch (const datum_exc_t &e) {
+        rfail_src(get.get_bt, e.get_type(), "%s", e.what());
+    }
+}
+
+void query_cache_t::ref_t::maybe_cache_result(const optional<double> &cache_ttl,
+                                              const datum_t &result) {
+    compiled_query_t *compiled_query = entry->compiled_query.get();
+    if (!cache_ttl.has_value() || !compiled_query->results_cacheable) {
+        return;
+    }
+    compiled_query->cached_result = result;
+    compiled_query->cached_result_expiration.nanos =
+        get_ticks().nanos + static_cast<int64_t>(*cache_ttl * 1000000000.0);
+}
+
+// Cuts `str` off after `SLOW_QUERY_LOG_MAX_LENGTH` characters.
+static void truncate_for_slow_query_log(std::string *str) {
+    if (str->size() > query_cache_t::SLOW_QUERY_LOG_MAX_LENGTH) {
+        const size_t omitted = str->size() - query_cache_t::SLOW_QUERY_LOG_MAX_LENGTH;
+        str->resize(query_cache_t::SLOW_QUERY_LOG_MAX_LENGTH);
+        *str += strprintf("... (%zu more characters)", omitted);
+    }
+}
+
+void query_cache_t::ref_t::maybe_log_slow_query() {
+    const uint64_t threshold_ms = query_cache->rdb_ctx->slow_query_threshold_ms;
+    if (threshold_ms == 0 || entry->usage.active_micros < threshold_ms * 1000) {
+        return;
+    }
+    // We'd rather have the whole query on one line of the log file.
+    const size_t columns = 1 << 20;
+    std::string query = pprint::pretty_print_as_js(
+        columns, entry->compiled_query->term_storage->root_term());
+    truncate_for_slow_query_log(&query);
+    std::string profile;
+    if (trace.has()) {
+        profile = trace->as_datum().print();
+        truncate_for_slow_query_log(&profile);
+        profile = " Profile: " + profile;
+    }
+    logNTC("Slow query from %s took %.3fs (%" PRIu64 " reads, %" PRIu64 " rows "
+           "scanned, %" PRIu64 " writes, %" PRIu64 " rows written): %s%s",
+           query_cache->client_addr_port.to_string().c_str(),
+           entry->usage.active_micros / 1e6,
+           entry->usage.reads,
+           entry->usage.rows_scanned,
+           entry->usage.writes,
+           entry->usage.rows_written,
+           query.c_str(),
+           profile.c_str());
+}
+
 void query_cache_t::ref_t::serve(env_t *env, response_t *res) {
     guarantee(entry->stream.has());
 
@@ -356,21 +613,35 @@ void query_cache_t::ref_t::serve(env_t *env, response_t *res) {
     entry->stream->set_notes(res);
 }
 
+query_cache_t::compiled_query_t::compiled_query_t(
+            scoped_ptr_t<term_storage_t> &&_term_storage,
+            global_optargs_t &&_global_optargs,
+            counted_t<const term_t> &&_term_tree,
+            optional<point_get_t> &&_point_get,
+            bool _results_cacheable) :
+        term_storage(std::move(_term_storage)),
+        global_optargs(std::move(_global_optargs)),
+        term_tree(std::move(_term_tree)),
+        point_get(std::move(_point_get)),
+        results_cacheable(_results_cacheable),
+        cached_result_expiration({0}) { }
+
 query_cache_t::entry_t::entry_t(query_params_t *query_params,
-                                global_optargs_t &&_global_optargs,
                                 ql::datum_t && _deterministic_time,
-                                counted_t<const term_t> &&_term_tree) :
+                                counted_t<compiled_query_t> &&_compiled_query,
+                                bool _sampled) :
         state(state_t::START),
         interrupt_reason(interrupt_reason_t::UNKNOWN),
         job_id(generate_uuid()),
         noreply(query_params->noreply),
         profile(query_params->profile ? profile_bool_t::PROFILE :
                                         profile_bool_t::DONT_PROFILE),
-        term_storage(std::move(query_params->term_storage)),
-        global_optargs(std::move(_global_optargs)),
+        sampled(_sampled),
+        compiled_query(std::move(_compiled_query)),
+        global_optargs(compiled_query->global_optargs),
         deterministic_time(_deterministic_time),
         start_time(get_kiloticks()),
-        term_tree(std::move(_term_tree)),
+        term_tree(compiled_query->term_tree),
         has_sent_batch(false) { }
 
 query_cache_t::entry_t::~entry_t() { }
@@ -5,6 +5,7 @@
 #include <time.h>
 
 #include <exception>
+#include <list>
 #include <map>
 #include <set>
 #include <string>
@@ -19,6 +20,7 @@
 #include "containers/scoped.hpp"
 #include "containers/counted.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/name_string.hpp"
 #include "containers/object_buffer.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/rdb_backtrace.hpp"
@@ -35,6 +37,18 @@ namespace ql {
 class query_cache_t : public home_thread_mixin_t {
     class entry_t;
 public:
+    // Queries with at most this much text keep their compiled term tree around, so
+    // that sending the same query again on this connection doesn't preprocess and
+    // compile it again.  We remember the `MAX_COMPILED_QUERIES` most recently used.
+    static const size_t MAX_COMPILED_QUERY_SIZE = 2048;
+    static const size_t MAX_COMPILED_QUERIES = 16;
+    // When the slow query log is on, one in this many queries gets a profile trace, so
+    // that some of the slow queries that get logged come with their profile.
+    static const int SLOW_QUERY_SAMPLE_RATE = 100;
+    // The slow query log cuts off the query and its profile after this many
+    // characters each, so that a large insert doesn't flood the log file.
+    static const size_t SLOW_QUERY_LOG_MAX_LENGTH = 4096;
+
     query_cache_t(rdb_context_t *_rdb_ctx,
                   ip_and_port_t _client_addr_port,
                   return_empty_normal_batches_t _return_empty_normal_batches,
@@ -59,6 +73,14 @@ public:
         void run(env_t *env, response_t *res);
         // Serve a batch from a stream
         void serve(env_t *env, response_t *res);
+        // Reads the row of a query that `match_point_get()` recognized
+        datum_t run_point_get(env_t *env);
+        // Remembers `result` for later runs of the query for `cache_ttl` seconds
+        void maybe_cache_result(const optional<double> &cache_ttl,
+                                const datum_t &result);
+        // Writes the finished query to the log if it took longer than
+        // `rdb_context_t::slow_query_threshold_ms`
+        void maybe_log_slow_query();
 
         query_cache_t::entry_t *const entry;
         const int64_t token;
@@ -102,13 +124,61 @@ public:
 
     auth::user_context_t const &get_user_context() const;
 
+    // Whether a later run of the query `root` may be answered with this run's result,
+    // because the query neither writes nor gives different results for the same
+    // data, as `r.random` or `r.now` do.  `term_tree` is the compiled `root`, or empty
+    // for a point get.
+    static bool results_cacheable(const raw_term_t &root,
+                                  const counted_t<const term_t> &term_tree);
+
 private:
+    // A query of the form `r.table(name).get(key)` or `r.db(name).table(name).get(key)`
+    // with literal arguments and no optargs.  That's the most common query there is, so
+    // we don't compile it into a term tree; `run()` reads the row from the table
+    // directly.  The backtraces are where the term tree would have reported errors.
+    struct point_get_t {
+        // Empty for `r.table(name)`, which is in the database of the `db` global optarg.
+        optional<name_string_t> db_name;
+        backtrace_id_t db_bt;
+        name_string_t table_name;
+        backtrace_id_t table_bt;
+        datum_t key;
+        backtrace_id_t get_bt;
+    };
+
+    // The term tree of a query, together with the term storage its backtraces and raw
+    // terms point into.  Entries share it with `compiled_queries`.
+    class compiled_query_t : public single_threaded_countable_t<compiled_query_t> {
+    public:
+        compiled_query_t(scoped_ptr_t<term_storage_t> &&_term_storage,
+                         global_optargs_t &&_global_optargs,
+                         counted_t<const term_t> &&_term_tree,
+                         optional<point_get_t> &&_point_get,
+                         bool _results_cacheable);
+
+        const scoped_ptr_t<const term_storage_t> term_storage;
+        const global_optargs_t global_optargs;
+        // Empty if the query is a `point_get`.
+        const counted_t<const term_t> term_tree;
+        const optional<point_get_t> point_get;
+
+        // Whether runs with a `cache_ttl` may reuse the result of an earlier run: the
+        // query is in `compiled_queries` and doesn't write or change anything.
+        const bool results_cacheable;
+        // The result of the last run with a `cache_ttl`, and until when it's valid.
+        datum_t cached_result;
+        ticks_t cached_result_expiration;
+
+    private:
+        DISABLE_COPYING(compiled_query_t);
+    };
+
     class entry_t {
     public:
         entry_t(query_params_t *query_params,
-                global_optargs_t &&_global_optargs,
                 ql::datum_t &&_deterministic_time,
-                counted_t<const term_t> &&_term_tree);
+                counted_t<compiled_query_t> &&_compiled_query,
+                bool _sampled);
         ~entry_t();
 
         enum class state_t { START, STREAM, DONE, DELETING } state;
@@ -117,7 +187,10 @@ private:
         const uuid_u job_id;
         const bool noreply;
         const profile_bool_t profile;
-        const scoped_ptr_t<const term_storage_t> term_storage;
+        // Whether we trace the query for the slow query log even though the client
+        // didn't ask for a profile.  The trace only covers the current batch.
+        const bool sampled;
+        const counted_t<compiled_query_t> compiled_query;
         const global_optargs_t global_optargs;
         // TODO: deterministic_time and start_time represent approximately the same
         // time, but we can't compute one from the other because pseudo::time_now() uses
@@ -125,6 +198,8 @@ private:
         const ql::datum_t deterministic_time;
         const kiloticks_t start_time;
 
+        query_usage_t usage;
+
         cond_t persistent_interruptor;
 
         // This will be empty if the root term has already been run
@@ -146,12 +221,30 @@ private:
 
     static void async_destroy_entry(entry_t *entry);
 
+    // Compiles the query in `query_params`, or reuses the term tree of an earlier
+    // query with the same text.
+    counted_t<compiled_query_t> compile(query_params_t *query_params);
+
+    // Returns `true` and fills in `*out` if `term` is a point get that `run()` can read
+    // without a term tree.
+    static bool match_point_get(const raw_term_t &term, point_get_t *out);
+
+    struct compiled_queries_entry_t {
+        counted_t<compiled_query_t> compiled_query;
+        std::list<const std::string *>::iterator lru_it;
+    };
+
     rdb_context_t *const rdb_ctx;
     ip_and_port_t client_addr_port;
     return_empty_normal_batches_t return_empty_normal_batches;
     auth::user_context_t user_context;
     std::map<int64_t, scoped_ptr_t<entry_t> > queries;
 
+    // Compiled queries by their text, and their keys with the most recently used one
+    // first.
+    std::map<std::string, compiled_queries_entry_t> compiled_queries;
+    std::list<const std::string *> compiled_queries_lru;
+
     // Used for noreply waiting, this contains all allocated-but-incomplete query ids
     friend class query_params_t::query_id_t;
     uint64_t next_query_id;
@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_memory.hpp"
+
+#include <atomic>
+#include <limits>
+
+namespace ql {
+
+static std::atomic<uint64_t> query_memory_limit(std::numeric_limits<uint64_t>::max());
+static std::atomic<uint64_t> query_memory_used(0);
+
+void set_query_memory_limit(uint64_t bytes) {
+    query_memory_limit.store(bytes);
+}
+
+uint64_t get_query_memory_limit() {
+    return query_memory_limit.load();
+}
+
+std::string format_query_memory_error() {
+    return "Not enough query memory left on the server to buffer the rows (the limit "
+           "is " + std::to_string(get_query_memory_limit()) + " bytes for all queries "
+           "together).  Use an index, or raise the `--query-memory-limit` option.";
+}
+
+bool query_memory_reservation_t::add(size_t bytes) {
+    // Reserving first and backing out afterwards means that two queries which both
+    // fit on their own might both fail when they race.  That's fine for a limit
+    // that's only meant to stop the server from running out of memory.
+    const uint64_t used = query_memory_used.fetch_add(bytes) + bytes;
+    if (used < bytes || used > query_memory_limit.load()) {
+        query_memory_used.fetch_sub(bytes);
+        return false;
+    }
+    bytes_ += bytes;
+    return true;
+}
+
+void query_memory_reservation_t::reset() {
+    query_memory_used.fetch_sub(bytes_);
+    bytes_ = 0;
+}
+
+}  // namespace ql
@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_MEMORY_HPP_
+#define RDB_PROTOCOL_QUERY_MEMORY_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "errors.hpp"
+
+namespace ql {
+
+// Sets how many bytes of rows all the queries on this server together may buffer in
+// `orderBy` and `distinct`.  It's unlimited until this is called.
+void set_query_memory_limit(uint64_t bytes);
+uint64_t get_query_memory_limit();
+
+// The error for a query that couldn't reserve any more memory.
+std::string format_query_memory_error();
+
+// The bytes from the query memory limit that one operator holds.  They're given back
+// when the reservation is reset or destroyed.
+class query_memory_reservation_t {
+public:
+    query_memory_reservation_t() : bytes_(0) { }
+    ~query_memory_reservation_t() { reset(); }
+
+    // Adds `bytes` to the reservation.  Returns false and doesn't change anything if
+    // the limit doesn't have that many bytes left.
+    MUST_USE bool add(size_t bytes);
+    void reset();
+
+    size_t bytes() const { return bytes_; }
+
+private:
+    size_t bytes_;
+
+    DISABLE_COPYING(query_memory_reservation_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_QUERY_MEMORY_HPP_
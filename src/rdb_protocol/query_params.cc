@@ -1,6 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/query_params.hpp"
 
+#include <string.h>
+
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/optargs.hpp"
@@ -63,16 +65,27 @@ void query_params_t::maybe_release_query_id() {
     }
 }
 
+optional<std::string> query_params_t::make_compile_cache_key(
+        const char *query_text) {
+    size_t size = strnlen(query_text, query_cache_t::MAX_COMPILED_QUERY_SIZE + 1);
+    if (size > query_cache_t::MAX_COMPILED_QUERY_SIZE) {
+        return optional<std::string>();
+    }
+    return make_optional(std::string(query_text, size));
+}
+
 query_params_t::query_params_t(int64_t _token,
                                ql::query_cache_t *_query_cache,
                                scoped_ptr_t<term_storage_t> &&_term_storage) :
         query_cache(_query_cache),
         term_storage(std::move(_term_storage)),
-        id(query_cache), token(_token), noreply(false), profile(false) {
+        id(query_cache), token(_token), noreply(false), profile(false),
+        low_priority(false) {
     // Parse out information that is needed before query evaluation
     type = term_storage->query_type();
     noreply = term_storage->static_optarg_as_bool("noreply", noreply);
     profile = term_storage->static_optarg_as_bool("profile", profile);
+    low_priority = term_storage->static_optarg_as_bool("low_priority", low_priority);
 }
 
 } // namespace ql
@@ -2,8 +2,11 @@
 #ifndef RDB_PROTOCOL_QUERY_PARAMS_HPP_
 #define RDB_PROTOCOL_QUERY_PARAMS_HPP_
 
+#include <string>
+
 #include "concurrency/new_semaphore.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/optional.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/ql2proto.hpp"
@@ -37,14 +40,23 @@ public:
 
     void maybe_release_query_id();
 
+    // Returns the text of the query if it is small enough for the query cache to
+    // keep its compiled term tree around.  `query_text` must be null-terminated.
+    static optional<std::string> make_compile_cache_key(const char *query_text);
+
     query_cache_t *query_cache;
     scoped_ptr_t<term_storage_t> term_storage;
+    // The exact text of the query, if the protocol provides it.  Queries with the
+    // same text compile to the same term tree.
+    optional<std::string> compile_cache_key;
     query_id_t id;
 
     int64_t token;
     Query::QueryType type;
     bool noreply;
     bool profile;
+    // Set by the `low_priority` optarg; see `rdb_query_server_t::run_query()`.
+    bool low_priority;
 
     new_semaphore_in_line_t throttler;
 
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/query_server.hpp"
 
+#include "concurrency/interruptor.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/rdb_backtrace.hpp"
@@ -9,13 +10,29 @@
 #include "rdb_protocol/query_params.hpp"
 #include "rdb_protocol/response.hpp"
 
+// The number of queries with the `low_priority` optarg that can start evaluating on
+// each thread at the same time
+static const int64_t LOW_PRIORITY_QUERIES_PER_THREAD = 2;
+
+void wait_for_low_priority_slot(const ql::query_params_t &query_params,
+                                new_semaphore_t *slots,
+                                new_semaphore_in_line_t *slot_out,
+                                signal_t *interruptor) {
+    if (query_params.low_priority) {
+        slot_out->init(slots, 1);
+        wait_interruptible(slot_out->acquisition_signal(), interruptor);
+    }
+}
+
 rdb_query_server_t::rdb_query_server_t(
     const std::set<ip_address_t> &local_addresses, int port,
     rdb_context_t *_rdb_ctx, server_config_client_t *_server_config_client,
-    const server_id_t &_server_id, tls_ctx_t *tls_ctx
+    const server_id_t &_server_id, tls_ctx_t *tls_ctx, bool reuse_port
 ) :
+    low_priority_slots(LOW_PRIORITY_QUERIES_PER_THREAD),
     server(
-        _rdb_ctx, local_addresses, port, this, default_http_timeout_sec, tls_ctx
+        _rdb_ctx, local_addresses, port, this, default_http_timeout_sec, tls_ctx,
+        reuse_port
     ),
     rdb_ctx(_rdb_ctx),
     server_config_client(_server_config_client),
@@ -35,12 +52,16 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
                                    signal_t *interruptor) {
     guarantee(interruptor != nullptr);
     guarantee(rdb_ctx->cluster_interface != nullptr);
+    const ticks_t start_time = get_ticks();
     try {
         // TODO: make this perfmon correct now that we have parallelized queries
         scoped_perfmon_counter_t client_active(&rdb_ctx->stats.clients_active);
 
         switch (query_params->type) {
         case Query::START: {
+            new_semaphore_in_line_t low_priority_slot;
+            wait_for_low_priority_slot(*query_params, low_priority_slots.get(),
+                                       &low_priority_slot, interruptor);
             scoped_ptr_t<ql::query_cache_t::ref_t> query_ref =
                 query_params->query_cache->create(query_params, ql::pseudo::time_now(),
                                                   interruptor);
@@ -81,6 +102,7 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
 
     rdb_ctx->stats.queries_per_sec.record();
     ++rdb_ctx->stats.queries_total;
+    rdb_ctx->stats.query_latency.record_since(start_time);
 }
 
 void rdb_query_server_t::fill_server_info(ql::response_t *out) {
@@ -6,6 +6,7 @@
 
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
+#include "concurrency/new_semaphore.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "client_protocol/server.hpp"
 #include "clustering/administration/servers/config_client.hpp"
@@ -18,12 +19,20 @@ class response_t;
 
 class rdb_context_t;
 
+/* If the query has the `low_priority` optarg, puts `slot_out` in line on `slots` and
+waits for it to get its turn.  Other queries don't wait.  The caller holds onto
+`slot_out` while the query starts evaluating. */
+void wait_for_low_priority_slot(const ql::query_params_t &query_params,
+                                new_semaphore_t *slots,
+                                new_semaphore_in_line_t *slot_out,
+                                signal_t *interruptor);
+
 class rdb_query_server_t : public query_handler_t {
 public:
     rdb_query_server_t(
       const std::set<ip_address_t> &local_addresses, int port,
       rdb_context_t *_rdb_ctx, server_config_client_t *_server_config_client,
-      const server_id_t &_server_id, tls_ctx_t *tls_ctx);
+      const server_id_t &_server_id, tls_ctx_t *tls_ctx, bool reuse_port);
 
     http_app_t *get_http_app();
     int get_port() const;
@@ -36,6 +45,12 @@ private:
 
     static const uint32_t default_http_timeout_sec = 300;
 
+    /* Queries with the `low_priority` optarg take turns on these, so that a few of
+    them at a time run on each thread, and the rest wait instead of competing with
+    the other queries for the thread. This has to be constructed before `server`
+    starts accepting queries. */
+    one_per_thread_t<new_semaphore_t> low_priority_slots;
+
     query_server_t server;
     rdb_context_t *rdb_ctx;
     server_config_client_t *server_config_client;
@@ -0,0 +1,29 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_USAGE_HPP_
+#define RDB_PROTOCOL_QUERY_USAGE_HPP_
+
+#include <stdint.h>
+
+namespace ql {
+
+// Counts the work that a query has done so far, for the `rethinkdb.jobs` table.  This
+// is always on, unlike `profile::trace_t`; it only has a few counters per query.
+struct query_usage_t {
+    query_usage_t()
+        : reads(0), writes(0), rows_scanned(0), rows_written(0), active_micros(0) { }
+
+    // How many reads and writes the query sent to tables.
+    uint64_t reads;
+    uint64_t writes;
+    // The rows that the reads loaded from the btree (including the ones that a
+    // `filter` dropped), and the rows that the writes meant to change.
+    uint64_t rows_scanned;
+    uint64_t rows_written;
+    // The time spent evaluating the query, not counting the time that a stream
+    // waited for the client to ask for the next batch.
+    uint64_t active_micros;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_QUERY_USAGE_HPP_
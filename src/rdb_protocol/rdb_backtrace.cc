@@ -8,10 +8,22 @@ namespace ql {
 const datum_t backtrace_registry_t::EMPTY_BACKTRACE = datum_t::empty_array();
 
 backtrace_registry_t::frame_t::frame_t(backtrace_id_t _parent, datum_t _val) :
-    parent(_parent), val(_val) { }
+    parent(_parent), val(_val), optarg_name(nullptr), optarg_name_size(0) { }
+
+backtrace_registry_t::frame_t::frame_t(backtrace_id_t _parent,
+                                       const char *_optarg_name,
+                                       size_t _optarg_name_size) :
+    parent(_parent), optarg_name(_optarg_name),
+    optarg_name_size(_optarg_name_size) { }
 
 bool backtrace_registry_t::frame_t::is_head() const {
-    return val.get_type() == datum_t::type_t::R_NULL;
+    return optarg_name == nullptr && val.get_type() == datum_t::type_t::R_NULL;
+}
+
+datum_t backtrace_registry_t::frame_t::get_val() const {
+    return optarg_name != nullptr
+        ? datum_t(datum_string_t(optarg_name_size, optarg_name))
+        : val;
 }
 
 backtrace_registry_t::backtrace_registry_t() {
@@ -24,6 +36,13 @@ backtrace_id_t backtrace_registry_t::new_frame(backtrace_id_t parent_bt,
     return backtrace_id_t(frames.size() - 1);
 }
 
+backtrace_id_t backtrace_registry_t::new_optarg_frame(backtrace_id_t parent_bt,
+                                                      const char *name,
+                                                      size_t name_size) {
+    frames.emplace_back(parent_bt, name, name_size);
+    return backtrace_id_t(frames.size() - 1);
+}
+
 datum_t backtrace_registry_t::datum_backtrace(const exc_t &ex) const {
     return datum_backtrace(ex.backtrace(), ex.dummy_frames());
 }
@@ -38,7 +57,7 @@ datum_t backtrace_registry_t::datum_backtrace(backtrace_id_t bt,
         if (dummy_frames > 0) {
             --dummy_frames;
         } else {
-            res.push_back(f->val);
+            res.push_back(f->get_val());
         }
     }
     std::reverse(res.begin(), res.end());
@@ -43,6 +43,11 @@ public:
 
     backtrace_id_t new_frame(backtrace_id_t parent_bt,
                              const datum_t &val);
+    // Like `new_frame()` with the optarg's name as a string, except that the string
+    // only gets built if the backtrace is needed, instead of for every optarg of
+    // every query.  `name` must outlive the registry, as the query's JSON does.
+    backtrace_id_t new_optarg_frame(backtrace_id_t parent_bt,
+                                    const char *name, size_t name_size);
 
     datum_t datum_backtrace(const exc_t &ex) const;
     datum_t datum_backtrace(backtrace_id_t bt, size_t dummy_frames = 0) const;
@@ -53,10 +58,16 @@ private:
     struct frame_t {
         frame_t(); // Only for creating the HEAD term
         frame_t(backtrace_id_t _parent, datum_t _val);
+        frame_t(backtrace_id_t _parent, const char *_optarg_name,
+                size_t _optarg_name_size);
         bool is_head() const;
+        datum_t get_val() const;
 
         backtrace_id_t parent;
+        // Unless `optarg_name` is set.
         datum_t val;
+        const char *optarg_name;
+        size_t optarg_name_size;
     };
 
     std::vector<frame_t> frames;
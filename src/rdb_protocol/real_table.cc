@@ -25,6 +25,15 @@ const std::string &real_table_t::get_pkey() const {
     return pkey;
 }
 
+// `read_mode_t::BOUNDED` reads get their bound from the `max_staleness_ms` optarg,
+// which `table_term_t` has already checked.
+static void set_max_staleness(ql::env_t *env, read_t *read) {
+    if (read->read_mode == read_mode_t::BOUNDED) {
+        read->max_staleness_ms =
+            env->get_optarg(env, "max_staleness_ms")->as_int<uint64_t>();
+    }
+}
+
 ql::datum_t real_table_t::read_row(
     ql::env_t *env, ql::datum_t pval, read_mode_t read_mode) {
     read_t read(point_read_t(store_key_t(pval.print_primary())),
@@ -149,6 +158,7 @@ ql::datum_t real_table_t::read_nearest(
         sindex,
         env->get_serializable_env());
     read_t read(geo_read, env->profile(), read_mode);
+    set_max_staleness(env, &read);
     read_response_t res;
     try {
         namespace_access.get()->read(
@@ -188,6 +198,20 @@ ql::datum_t real_table_t::read_nearest(
     return std::move(formatted_result).to_datum();
 }
 
+bool real_table_t::read_sample(
+        ql::env_t *env,
+        size_t n,
+        read_mode_t read_mode,
+        std::vector<ql::datum_t> *rows_out) {
+    read_t read(sample_read_t(n), env->profile(), read_mode);
+    read_response_t res;
+    read_with_profile(env, read, &res);
+    sample_read_response_t *s_res = boost::get<sample_read_response_t>(&res.response);
+    r_sanity_check(s_res);
+    *rows_out = std::move(s_res->rows);
+    return true;
+}
+
 const size_t split_size = 128;
 template<class T>
 std::vector<std::vector<T> > split(std::vector<T> &&v) {
@@ -346,18 +370,26 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
         env->profile() == profile_bool_t::PROFILE,
         (read.read_mode == read_mode_t::OUTDATED ? "Perform outdated read." :
          (read.read_mode == read_mode_t::DEBUG_DIRECT ? "Perform debug_direct read." :
+         (read.read_mode == read_mode_t::BOUNDED ? "Perform bounded read." :
          (read.read_mode == read_mode_t::SINGLE ? "Perform read." :
-                                                  "Perform majority read."))),
+                                                  "Perform majority read.")))),
         env->trace);
     profile::splitter_t splitter(env->trace);
     /* propagate whether or not we're doing profiles */
     r_sanity_check(read.profile == env->profile());
 
+    /* The readers don't know about the staleness bound, so we fill it in here. */
+    read_t bounded_read;
+    if (read.read_mode == read_mode_t::BOUNDED) {
+        bounded_read = read;
+        set_max_staleness(env, &bounded_read);
+    }
+
     /* Do the actual read. */
     try {
         namespace_access.get()->read(
             env->get_user_context(),
-            read,
+            read.read_mode == read_mode_t::BOUNDED ? bounded_read : read,
             response,
             order_token_t::ignore,
             env->interruptor);
@@ -367,10 +399,34 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
         rfail_datum(ql::base_exc_t::PERMISSION_ERROR, "%s", error.what());
     }
 
+    add_read_to_usage(env, *response);
+
     /* Append the results of the profile to the current task */
     splitter.give_splits(response->n_shards, response->event_log);
 }
 
+void real_table_t::add_read_to_usage(ql::env_t *env, const read_response_t &response) {
+    if (ql::query_usage_t *usage = env->usage()) {
+        ++usage->reads;
+        if (auto rget = boost::get<rget_read_response_t>(&response.response)) {
+            usage->rows_scanned += rget->rows_scanned;
+        } else if (auto point = boost::get<point_read_response_t>(&response.response)) {
+            if (point->data.has() && point->data.get_type() != ql::datum_t::R_NULL) {
+                ++usage->rows_scanned;
+            }
+        }
+    }
+}
+
+void real_table_t::read_in_background(const auth::user_context_t &user_context,
+                                      const read_t &read,
+                                      read_response_t *response,
+                                      signal_t *interruptor) {
+    r_sanity_check(read.profile == profile_bool_t::DONT_PROFILE);
+    namespace_access.get()->read(
+        user_context, read, response, order_token_t::ignore, interruptor);
+}
+
 void real_table_t::write_with_profile(ql::env_t *env, write_t *write,
         write_response_t *response) {
     PROFILE_STARTER_IF_ENABLED(
@@ -403,6 +459,11 @@ void real_table_t::write_with_profile(ql::env_t *env, write_t *write,
         rfail_datum(ql::base_exc_t::PERMISSION_ERROR, "%s", error.what());
     }
 
+    if (ql::query_usage_t *usage = env->usage()) {
+        ++usage->writes;
+        usage->rows_written += write->expected_document_changes();
+    }
+
     /* Append the results of the profile to the current task */
     splitter.give_splits(response->n_shards, response->event_log);
 }
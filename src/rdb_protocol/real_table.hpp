@@ -76,6 +76,11 @@ public:
         const ellipsoid_spec_t &geo_system,
         dist_unit_t dist_unit,
         const ql::configured_limits_t &limits);
+    bool read_sample(
+        ql::env_t *env,
+        size_t n,
+        read_mode_t read_mode,
+        std::vector<ql::datum_t> *rows_out);
 
     ql::datum_t write_batched_replace(
         ql::env_t *env,
@@ -118,6 +123,19 @@ public:
     void read_with_profile(ql::env_t *env, const read_t &, read_response_t *response);
     void write_with_profile(ql::env_t *env, write_t *, write_response_t *response);
 
+    /* Performs `read` without a `ql::env_t`, for reads that run in the background
+    while the query does something else.  The read must not be profiled.  Throws
+    `cannot_perform_query_exc_t`, `auth::permission_error_t` and `interrupted_exc_t`
+    as they come from the `namespace_if`. */
+    void read_in_background(const auth::user_context_t &user_context,
+                            const read_t &read,
+                            read_response_t *response,
+                            signal_t *interruptor);
+
+    /* Counts a read towards `env`'s `ql::query_usage_t`.  `read_with_profile` does
+    this itself; the callers of `read_in_background` have to do it. */
+    void add_read_to_usage(ql::env_t *env, const read_response_t &response);
+
 private:
     optional<counted_t<const ql::func_t> > get_write_hook(
         ql::env_t *env,
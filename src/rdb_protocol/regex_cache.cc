@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/regex_cache.hpp"
+
+#include <re2/re2.h>
+
+#include "config/args.hpp"
+#include "containers/lru_cache.hpp"
+#include "thread_local.hpp"
+
+namespace ql {
+
+// How many regexes each thread remembers.
+const size_t REGEX_CACHE_SIZE = 1000;
+// Longer patterns aren't cached, so that a few of them can't take up a lot of memory.
+// RE2 limits the memory of every compiled regex on its own.
+const size_t REGEX_CACHE_MAX_PATTERN_SIZE = 4 * KILOBYTE;
+
+typedef lru_cache_t<std::string, std::shared_ptr<const re2::RE2> > regex_cache_t;
+
+TLS_with_init(regex_cache_t *, regex_cache, nullptr);
+
+std::shared_ptr<const re2::RE2> get_cached_regex(const std::string &pattern) {
+    const bool cacheable = pattern.size() <= REGEX_CACHE_MAX_PATTERN_SIZE;
+    regex_cache_t *cache = TLS_get_regex_cache();
+    if (cacheable && cache != nullptr) {
+        std::shared_ptr<const re2::RE2> *found;
+        if (cache->lookup(pattern, &found)) {
+            return *found;
+        }
+    }
+
+    std::shared_ptr<const re2::RE2> regexp =
+        std::make_shared<const re2::RE2>(pattern, re2::RE2::Quiet);
+    if (cacheable && regexp->ok()) {
+        if (cache == nullptr) {
+            cache = new regex_cache_t(REGEX_CACHE_SIZE);
+            TLS_set_regex_cache(cache);
+        }
+        cache->insert(pattern, regexp);
+    }
+    return regexp;
+}
+
+}  // namespace ql
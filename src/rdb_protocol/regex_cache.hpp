@@ -0,0 +1,22 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_REGEX_CACHE_HPP_
+#define RDB_PROTOCOL_REGEX_CACHE_HPP_
+
+#include <memory>
+#include <string>
+
+namespace re2 {
+class RE2;
+}
+
+namespace ql {
+
+/* Returns `pattern` compiled with `re2::RE2::Quiet`.  The regexes that compile are
+remembered in a cache per thread, which outlives queries, so a pattern that many
+queries or changefeeds use only gets compiled once on every thread.  The result may
+not be `ok()`; the caller has to report the error. */
+std::shared_ptr<const re2::RE2> get_cached_regex(const std::string &pattern);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_REGEX_CACHE_HPP_
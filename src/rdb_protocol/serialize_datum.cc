@@ -1,6 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/serialize_datum.hpp"
 
+#include <string.h>
+
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
@@ -111,6 +114,37 @@ serialization_result_t datum_serialize(
 
 /* Helper functions shared by datum_array_* and datum_object_* */
 
+// Writes the offsets of all but the first element as `T`s. They are collected in a
+// buffer and appended in batches, which is the same as `serialize_universal()` for
+// each of them, because that writes the raw bytes too.
+template <class T>
+void serialize_offsets(write_message_t *wm,
+                       datum_t::type_t datum_type,
+                       const std::vector<size_tree_node_t> &elem_sizes,
+                       size_t num_elements) {
+    static const size_t BATCH_SIZE = 128;
+    T batch[BATCH_SIZE];
+    size_t batch_size = 0;
+    size_t next_offset = 0;
+    for (size_t i = 1; i < num_elements; ++i) {
+        if (datum_type == datum_t::R_OBJECT) {
+            next_offset += elem_sizes[(i-1)*2].size; // The key
+            next_offset += elem_sizes[(i-1)*2+1].size; // The value
+        } else {
+            next_offset += elem_sizes[i-1].size;
+        }
+        guarantee(next_offset <= std::numeric_limits<T>::max());
+        batch[batch_size++] = static_cast<T>(next_offset);
+        if (batch_size == BATCH_SIZE) {
+            wm->append(batch, batch_size * sizeof(T));
+            batch_size = 0;
+        }
+    }
+    if (batch_size > 0) {
+        wm->append(batch, batch_size * sizeof(T));
+    }
+}
+
 // Keep in sync with offset_table_serialized_size
 void serialize_offset_table(write_message_t *wm,
                             datum_t::type_t datum_type,
@@ -127,34 +161,21 @@ void serialize_offset_table(write_message_t *wm,
     serialize_varint_uint64(wm, num_elements);
 
     // the offset table
-    size_t next_offset = 0;
-    for (size_t i = 1; i < num_elements; ++i) {
-        if (datum_type == datum_t::R_OBJECT) {
-            next_offset += elem_sizes[(i-1)*2].size; // The key
-            next_offset += elem_sizes[(i-1)*2+1].size; // The value
-        } else {
-            next_offset += elem_sizes[i-1].size;
-        }
-        switch (offset_size) {
-        case datum_offset_size_t::U8BIT:
-            guarantee(next_offset <= std::numeric_limits<uint8_t>::max());
-            serialize_universal(wm, static_cast<uint8_t>(next_offset));
-            break;
-        case datum_offset_size_t::U16BIT:
-            guarantee(next_offset <= std::numeric_limits<uint16_t>::max());
-            serialize_universal(wm, static_cast<uint16_t>(next_offset));
-            break;
-        case datum_offset_size_t::U32BIT:
-            guarantee(next_offset <= std::numeric_limits<uint32_t>::max());
-            serialize_universal(wm, static_cast<uint32_t>(next_offset));
-            break;
-        case datum_offset_size_t::U64BIT:
-            guarantee(next_offset <= std::numeric_limits<uint64_t>::max());
-            serialize_universal(wm, static_cast<uint64_t>(next_offset));
-            break;
-        default:
-            unreachable();
-        }
+    switch (offset_size) {
+    case datum_offset_size_t::U8BIT:
+        serialize_offsets<uint8_t>(wm, datum_type, elem_sizes, num_elements);
+        break;
+    case datum_offset_size_t::U16BIT:
+        serialize_offsets<uint16_t>(wm, datum_type, elem_sizes, num_elements);
+        break;
+    case datum_offset_size_t::U32BIT:
+        serialize_offsets<uint32_t>(wm, datum_type, elem_sizes, num_elements);
+        break;
+    case datum_offset_size_t::U64BIT:
+        serialize_offsets<uint64_t>(wm, datum_type, elem_sizes, num_elements);
+        break;
+    default:
+        unreachable();
     }
 }
 
@@ -270,8 +291,10 @@ size_t datum_array_serialized_size(const datum_t &datum,
         for (size_t i = 0; i < datum.arr_size(); ++i) {
             auto elem = datum.get(i);
             size_tree_node_t elem_size;
-            elem_size.size = datum_serialized_size(elem, check_errors,
-                                                   &elem_size.child_sizes);
+            // Only collect the sizes further down if somebody wants them.
+            elem_size.size = datum_serialized_size(
+                elem, check_errors,
+                element_sizes_out != NULL ? &elem_size.child_sizes : NULL);
             elem_sizes.push_back(std::move(elem_size));
         }
         datum_offset_size_t offset_size;
@@ -304,7 +327,7 @@ serialization_result_t datum_array_serialize(
         && check_errors == check_datum_serialization_errors_t::NO) {
 
         // Subtract 1 for the type byte, which we don't have to rewrite
-        wm->append(existing_buf_ref->get(), precomputed_sizes.size - 1);
+        wm->append_shared(*existing_buf_ref, precomputed_sizes.size - 1);
         return serialization_result_t::SUCCESS;
     }
 
@@ -377,8 +400,9 @@ size_t datum_object_serialized_size(const datum_t &datum,
             size_tree_node_t key_size;
             key_size.size = datum_serialized_size(pair.first);
             size_tree_node_t val_size;
-            val_size.size = datum_serialized_size(pair.second, check_errors,
-                                                  &val_size.child_sizes);
+            val_size.size = datum_serialized_size(
+                pair.second, check_errors,
+                child_sizes_out != NULL ? &val_size.child_sizes : NULL);
             child_sizes.push_back(std::move(key_size));
             child_sizes.push_back(std::move(val_size));
         }
@@ -412,7 +436,7 @@ serialization_result_t datum_object_serialize(
         && check_errors == check_datum_serialization_errors_t::NO) {
 
         // Subtract 1 for the type byte, which we don't have to rewrite
-        wm->append(existing_buf_ref->get(), precomputed_sizes.size - 1);
+        wm->append_shared(*existing_buf_ref, precomputed_sizes.size - 1);
         return serialization_result_t::SUCCESS;
     }
 
@@ -481,6 +505,17 @@ size_t datum_serialized_size(const datum_t &datum,
                              check_datum_serialization_errors_t check_errors,
                              std::vector<size_tree_node_t> *child_sizes_out) {
     rassert(child_sizes_out == NULL || child_sizes_out->empty());
+    // Arrays and objects that we've measured before remember their size, unless
+    // they're backed by a buf_ref (which is cheap to measure anyway).  We can only
+    // use it if nobody wants the sizes of the children.
+    if (check_errors == check_datum_serialization_errors_t::NO
+        && child_sizes_out == NULL) {
+        const size_t cached_size = datum.get_cached_serialized_size();
+        if (cached_size != 0) {
+            return cached_size;
+        }
+    }
+
     // Update datum_object_serialize() and datum_array_serialize() if the size of
     // the type prefix should ever change.
     size_t sz = 1; // 1 byte for the type
@@ -524,6 +559,9 @@ size_t datum_serialized_size(const datum_t &datum,
     default:
         unreachable();
     }
+    if (check_errors == check_datum_serialization_errors_t::NO) {
+        datum.set_cached_serialized_size(sz);
+    }
     return sz;
 }
 
@@ -750,6 +788,16 @@ archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
     case datum_serialized_type_t::BUF_R_ARRAY: // fallthru
     case datum_serialized_type_t::BUF_R_OBJECT:
     {
+        datum_t::type_t dtype = type == datum_serialized_type_t::BUF_R_ARRAY
+                                ? datum_t::R_ARRAY
+                                : datum_t::R_OBJECT;
+
+        // If we're reading from a shared buffer (such as a mailbox message), the
+        // serialized size and the data are already laid out the way the datum needs
+        // them, so it can point into that buffer instead of getting a copy.
+        shared_buf_read_stream_t *shared_s = dynamic_cast<shared_buf_read_stream_t *>(s);
+        const int64_t start = shared_s != nullptr ? shared_s->tell() : 0;
+
         // First read the serialized size of the buffer
         uint64_t ser_size;
         res = deserialize_varint_uint64(s, &ser_size);
@@ -763,7 +811,20 @@ archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
             return archive_result_t::RANGE_ERROR;
         }
 
-        // Then read the data into a shared_buf_t
+        if (shared_s != nullptr) {
+            if (static_cast<uint64_t>(shared_s->skip(ser_size)) < ser_size) {
+                return archive_result_t::SOCK_EOF;
+            }
+            try {
+                *datum = datum_t(dtype,
+                                 shared_buf_ref_t<char>(shared_s->get_buf(), start));
+            } catch (const base_exc_t &) {
+                return archive_result_t::RANGE_ERROR;
+            }
+            break;
+        }
+
+        // Otherwise read the data into a shared_buf_t
         counted_t<shared_buf_t> buf = shared_buf_t::create(static_cast<size_t>(ser_size) + ser_size_sz);
         serialize_varint_uint64_into_buf(ser_size, reinterpret_cast<uint8_t *>(buf->data()));
         int64_t num_read = force_read(s, buf->data() + ser_size_sz, ser_size);
@@ -775,9 +836,6 @@ archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
         }
 
         // ...from which we create the datum_t
-        datum_t::type_t dtype = type == datum_serialized_type_t::BUF_R_ARRAY
-                                ? datum_t::R_ARRAY
-                                : datum_t::R_OBJECT;
         try {
             *datum = datum_t(dtype, shared_buf_ref_t<char>(std::move(buf), 0));
         } catch (const base_exc_t &) {
@@ -866,6 +924,36 @@ std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
     return std::make_pair(std::move(key), std::move(value));
 }
 
+int datum_compare_pair_key_in_buf(size_t key_size,
+                                  const char *key_data,
+                                  const shared_buf_ref_t<char> &buf,
+                                  size_t at_offset,
+                                  size_t *key_ser_size_out) {
+    // See `datum_serialize(write_message_t *, const datum_string_t &)`.
+    const size_t available = buf.get_safety_boundary() - at_offset;
+    buffer_read_stream_t key_read_stream(buf.get() + at_offset, available);
+    uint64_t buf_key_size;
+    guarantee_deserialization(
+        deserialize_varint_uint64(&key_read_stream, &buf_key_size), "datum object key");
+    const size_t buf_key_size_size = varint_uint64_serialized_size(buf_key_size);
+    guarantee(buf_key_size <= available - buf_key_size_size);
+    *key_ser_size_out = buf_key_size_size + static_cast<size_t>(buf_key_size);
+
+    // Same order as `datum_string_t::compare()`.
+    const size_t common_size = std::min(key_size, static_cast<size_t>(buf_key_size));
+    const int content_compare =
+        memcmp(key_data, buf.get() + at_offset + buf_key_size_size, common_size);
+    if (content_compare != 0) {
+        return content_compare;
+    } else if (key_size < buf_key_size) {
+        return -1;
+    } else if (key_size > buf_key_size) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
 /* The format of `array` is:
      varint ser_size
      varint num_elements
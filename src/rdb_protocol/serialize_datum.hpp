@@ -53,6 +53,16 @@ datum_t datum_deserialize_from_buf(const shared_buf_ref_t<char> &buf, size_t at_
 std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
         const shared_buf_ref_t<char> &buf, size_t at_offset);
 
+// Compares the `key_size` bytes at `key_data` to the key of the object pair at
+// `at_offset` in `buf`, like `datum_string_t::compare()`, without constructing the
+// pair.  Sets `*key_ser_size_out` to the serialized size of the pair's key, which is
+// where its value starts.
+int datum_compare_pair_key_in_buf(size_t key_size,
+                                  const char *key_data,
+                                  const shared_buf_ref_t<char> &buf,
+                                  size_t at_offset,
+                                  size_t *key_ser_size_out);
+
 // Finds the offset of the given array element in the buffer
 size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t index);
 // Reads the number of elements in the array stored in the buffer
@@ -1,11 +1,32 @@
 #ifndef RDB_PROTOCOL_SERIALIZE_DATUM_ONTO_BLOB_HPP_
 #define RDB_PROTOCOL_SERIALIZE_DATUM_ONTO_BLOB_HPP_
 
+#include <string.h>
+
+#include "buffer_cache/serialize_onto_blob.hpp"
+#include "containers/shared_buffer.hpp"
 #include "rdb_protocol/serialize_datum.hpp"
 
+// Copies the serialized value in `wm` into one contiguous buffer.
+inline counted_t<shared_buf_t> flatten_write_message(write_message_t *wm) {
+    counted_t<shared_buf_t> buf = shared_buf_t::create(wm->size());
+    size_t offset = 0;
+    intrusive_list_t<write_buffer_t> *buffers = wm->unsafe_expose_buffers();
+    for (write_buffer_t *p = buffers->head(); p != nullptr; p = buffers->next(p)) {
+        memcpy(buf->data(offset), p->data(), p->size);
+        offset += p->size;
+    }
+    return buf;
+}
+
+// If `stored_value_out` isn't null, it's set to a datum that is backed by a copy of the
+// serialized value, like the ones we read back from disk.  Passing that on instead of
+// `value` means that whoever serializes it again (for example to send it to a
+// changefeed) can copy the buffer rather than walk the whole datum tree again.
 inline ql::serialization_result_t
 datum_serialize_onto_blob(buf_parent_t parent, blob_t *blob,
-                          const ql::datum_t &value) {
+                          const ql::datum_t &value,
+                          ql::datum_t *stored_value_out) {
     // We still make an unnecessary copy: serializing to a write_message_t instead of
     // directly onto the stream.  (However, don't be so sure it would be more
     // efficient to serialize onto an abstract stream type -- you've got a whole
@@ -19,6 +40,16 @@ datum_serialize_onto_blob(buf_parent_t parent, blob_t *blob,
                         ql::check_datum_serialization_errors_t::YES);
     if (bad(res)) return res;
     write_onto_blob(parent, blob, wm);
+
+    if (stored_value_out != nullptr) {
+        if (value.get_buf_ref() != nullptr) {
+            // It's already backed by a buffer, so there's nothing to gain.
+            *stored_value_out = value;
+        } else {
+            *stored_value_out = ql::datum_deserialize_from_buf(
+                shared_buf_ref_t<char>(flatten_write_message(&wm), 0), 0);
+        }
+    }
     return res;
 }
 
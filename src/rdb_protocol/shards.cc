@@ -1,13 +1,17 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/shards.hpp"
 
+#include <algorithm>
+#include <unordered_map>
 #include <utility>
 
 #include "errors.hpp"
 #include <boost/variant.hpp>
 
 #include "debug.hpp"
+#include "rdb_protocol/compiled_func.hpp"
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/parallel_eval.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
 
@@ -108,19 +112,62 @@ private:
 
     virtual void unshard(env_t *env, const std::vector<result_t *> &results) {
         guarantee(acc.size() == 0);
-        std::map<datum_t, std::vector<T *>, optional_datum_less_t> vecs;
         r_sanity_check(results.size() != 0);
+        // The groups of every shard are already sorted, so we merge them instead of
+        // looking up every shard's groups in one big map.  That costs
+        // O(log(shards)) comparisons per group of every shard, and the merged
+        // groups are appended to `acc` in order.
+        typedef typename std::map<datum_t, T, optional_datum_less_t>::iterator it_t;
+        std::vector<std::pair<it_t, it_t> > ranges;
         for (auto res = results.begin(); res != results.end(); ++res) {
             guarantee(*res);
             grouped_t<T> *gres = boost::get<grouped_t<T> >(*res);
             guarantee(gres);
-            for (auto kv = gres->begin(); kv != gres->end(); ++kv) {
-                vecs[kv->first].push_back(&kv->second);
+            if (gres->begin() != gres->end()) {
+                ranges.push_back(std::make_pair(gres->begin(), gres->end()));
+            }
+        }
+        const optional_datum_less_t less;
+        // This makes `heap` a min-heap of indices into `ranges`.  Shards with the
+        // same group come out in the order of `results`.
+        auto gt = [&](size_t a, size_t b) {
+            const datum_t &a_key = ranges[a].first->first;
+            const datum_t &b_key = ranges[b].first->first;
+            if (less(b_key, a_key)) {
+                return true;
+            } else if (less(a_key, b_key)) {
+                return false;
+            }
+            return a > b;
+        };
+        std::vector<size_t> heap;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            heap.push_back(i);
+        }
+        std::make_heap(heap.begin(), heap.end(), gt);
+
+        std::map<datum_t, T, optional_datum_less_t> *out = acc.get_underlying_map();
+        std::vector<T *> ts;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), gt);
+            const size_t i = heap.back();
+            heap.pop_back();
+            it_t kv = ranges[i].first++;
+            if (!ts.empty() && less(out->rbegin()->first, kv->first)) {
+                unshard_impl(env, &out->rbegin()->second, ts);
+                ts.clear();
+            }
+            if (ts.empty()) {
+                out->insert(out->end(), std::make_pair(kv->first, default_val));
+            }
+            ts.push_back(&kv->second);
+            if (ranges[i].first != ranges[i].second) {
+                heap.push_back(i);
+                std::push_heap(heap.begin(), heap.end(), gt);
             }
         }
-        for (auto kv = vecs.begin(); kv != vecs.end(); ++kv) {
-            auto t_it = acc.insert(std::make_pair(kv->first, default_val)).first;
-            unshard_impl(env, &t_it->second, kv->second);
+        if (!ts.empty()) {
+            unshard_impl(env, &out->rbegin()->second, ts);
         }
     }
     virtual void unshard_impl(env_t *env, T *acc, const std::vector<T *> &ts) = 0;
@@ -773,6 +820,51 @@ private:
     bool (*cmp)(const datum_t &val1, const datum_t &val2);
 };
 
+class approx_count_distinct_terminal_t : public skip_terminal_t<hll_sketch_t> {
+public:
+    explicit approx_count_distinct_terminal_t(
+        const approx_count_distinct_wire_func_t &_f)
+        : skip_terminal_t<hll_sketch_t>(_f, hll_sketch_t()) { }
+private:
+    virtual void maybe_acc(env_t *env,
+                           const datum_t &el,
+                           hll_sketch_t *out,
+                           const acc_func_t &_f) {
+        out->add(_f(env, el));
+    }
+    virtual datum_t unpack(hll_sketch_t *hll) {
+        return datum_t(static_cast<double>(hll->estimate()));
+    }
+    virtual void unshard_impl(env_t *, hll_sketch_t *out, hll_sketch_t *el) {
+        out->merge(*el);
+    }
+};
+
+class approx_quantile_terminal_t : public skip_terminal_t<tdigest_t> {
+public:
+    explicit approx_quantile_terminal_t(const approx_quantile_wire_func_t &_f)
+        : skip_terminal_t<tdigest_t>(_f, tdigest_t()),
+          quantile(_f.quantile) { }
+private:
+    virtual void maybe_acc(env_t *env,
+                           const datum_t &el,
+                           tdigest_t *out,
+                           const acc_func_t &_f) {
+        out->add(_f(env, el).as_num());
+    }
+    virtual datum_t unpack(tdigest_t *td) {
+        rcheck_datum(!td->empty(), base_exc_t::NON_EXISTENCE,
+                     "Cannot take the approx_quantile of an empty stream.  (If you "
+                     "passed `approx_quantile` a field name, it may be that no "
+                     "elements of the stream had that field.)");
+        return datum_t(td->quantile(quantile));
+    }
+    virtual void unshard_impl(env_t *, tdigest_t *out, tdigest_t *el) {
+        out->merge(*el);
+    }
+    double quantile;
+};
+
 const char *const empty_stream_msg =
     "Cannot reduce over an empty stream.";
 
@@ -823,6 +915,12 @@ public:
     T *operator()(const max_wire_func_t &f) const {
         return new optimizing_terminal_t(f, "max", datum_gt);
     }
+    T *operator()(const approx_count_distinct_wire_func_t &f) const {
+        return new approx_count_distinct_terminal_t(f);
+    }
+    T *operator()(const approx_quantile_wire_func_t &f) const {
+        return new approx_quantile_terminal_t(f);
+    }
     T *operator()(const reduce_wire_func_t &f) const {
         return new reduce_terminal_t(f);
     }
@@ -881,8 +979,12 @@ private:
                             const std::function<datum_t()> &lazy_sindex_val) {
         if (groups->size() == 0) return;
         r_sanity_check(groups->size() == 1 && !groups->begin()->first.has());
-        datums_t *ds = &groups->begin()->second;
-        for (auto el = ds->begin(); el != ds->end(); ++el) {
+        datums_t ds = std::move(groups->begin()->second);
+        groups->clear();
+        // We look up the group of every row in a hash table, and only sort the
+        // groups once at the end.
+        hashed_groups_t hashed_groups;
+        for (auto el = ds.begin(); el != ds.end(); ++el) {
             std::vector<datum_t> arr;
             arr.reserve(funcs.size() + append_index);
             for (auto f = funcs.begin(); f != funcs.end(); ++f) {
@@ -908,7 +1010,7 @@ private:
             r_sanity_check(arr.size() == (funcs.size() + append_index));
 
             if (!multi) {
-                add(groups, std::move(arr), *el, env->limits());
+                add(&hashed_groups, std::move(arr), *el, env->limits());
             } else {
                 std::vector<std::vector<datum_t> > perms(arr.size());
                 for (size_t i = 0; i < arr.size(); ++i) {
@@ -923,21 +1025,26 @@ private:
                 }
                 std::vector<datum_t> instance;
                 instance.reserve(perms.size());
-                add_perms(groups, &instance, &perms, 0, *el, env->limits());
+                add_perms(&hashed_groups, &instance, &perms, 0, *el, env->limits());
                 r_sanity_check(instance.size() == 0);
             }
 
             rcheck_src(bt,
-                       groups->size() <= env->limits().array_size_limit(),
+                       hashed_groups.size() <= env->limits().array_size_limit(),
                        base_exc_t::RESOURCE,
                        strprintf("Too many groups (> %zu).",
                                  env->limits().array_size_limit()));
         }
-        size_t erased = groups->erase(datum_t());
-        r_sanity_check(erased == 1);
+        for (auto &&pair : hashed_groups) {
+            (*groups)[pair.first] = std::move(pair.second);
+        }
     }
 
-    void add(groups_t *groups,
+    typedef std::unordered_map<datum_t, datums_t,
+                               optional_datum_hash_t, optional_datum_equal_t>
+        hashed_groups_t;
+
+    void add(hashed_groups_t *groups,
              std::vector<datum_t> &&arr,
              const datum_t &el,
              const configured_limits_t &limits) {
@@ -948,7 +1055,7 @@ private:
         (*groups)[group].push_back(el);
     }
 
-    void add_perms(groups_t *groups,
+    void add_perms(hashed_groups_t *groups,
                    std::vector<datum_t> *instance,
                    std::vector<std::vector<datum_t> > *arr,
                    size_t index,
@@ -987,8 +1094,12 @@ private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                *it = f->call(env, *it)->as_datum();
+            if (should_eval_in_parallel(env, lst->size(), f.get())) {
+                parallel_eval(env, lst->size(), [&](env_t *e, size_t i) {
+                    (*lst)[i] = f->call(e, (*lst)[i])->as_datum();
+                });
+            } else {
+                f->call_on_each(env, lst);
             }
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace(), 1);
@@ -1035,17 +1146,53 @@ public:
         : f(_f.filter_func.compile_wire_func()),
           default_val(_f.default_filter_val.has_value()
                       ? _f.default_filter_val->compile_wire_func()
-                      : counted_t<const func_t>()) { }
+                      : counted_t<const func_t>()),
+          compiled(compiled_func_t::get_filter(f.get())) { }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         auto it = lst->begin();
         auto loc = it;
         try {
-            for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
-                    std::swap(*loc, *it);
-                    ++loc;
+            // Profiles want to see every term that gets evaluated.
+            if (compiled.has() && env->trace == nullptr) {
+                std::vector<compiled_func_t::filter_result_t> results;
+                compiled->filter_batch(*lst, &results);
+                for (size_t i = 0; i < results.size(); ++i, ++it) {
+                    bool keep;
+                    switch (results[i]) {
+                    case compiled_func_t::filter_result_t::MATCH: keep = true; break;
+                    case compiled_func_t::filter_result_t::NO_MATCH: keep = false; break;
+                    case compiled_func_t::filter_result_t::UNKNOWN:
+                        keep = f->filter_call(env, *it, default_val);
+                        break;
+                    default: unreachable();
+                    }
+                    if (keep) {
+                        std::swap(*loc, *it);
+                        ++loc;
+                    }
+                }
+            } else if (should_eval_in_parallel(
+                           env, lst->size(), f.get(), default_val.get())) {
+                std::vector<char> keep(lst->size(), false);
+                parallel_eval(env, lst->size(), [&](env_t *e, size_t i) {
+                    keep[i] = f->filter_call(e, (*lst)[i], default_val);
+                });
+                for (size_t i = 0; i < keep.size(); ++i, ++it) {
+                    if (keep[i]) {
+                        std::swap(*loc, *it);
+                        ++loc;
+                    }
+                }
+            } else {
+                std::vector<char> keep;
+                f->filter_call_on_each(env, *lst, default_val, &keep);
+                for (size_t i = 0; i < keep.size(); ++i, ++it) {
+                    if (keep[i]) {
+                        std::swap(*loc, *it);
+                        ++loc;
+                    }
                 }
             }
         } catch (const datum_exc_t &e) {
@@ -1054,6 +1201,8 @@ private:
         lst->erase(loc, lst->end());
     }
     counted_t<const func_t> f, default_val;
+    // Empty unless `f` is simple enough to evaluate without the interpreter.
+    counted_t<const compiled_func_t> compiled;
 };
 
 class concatmap_trans_t : public ungrouped_op_t {
@@ -1065,16 +1214,22 @@ private:
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         datums_t new_lst;
         batchspec_t bs = batchspec_t::user(batch_type_t::TERMINAL, env);
-        profile::sampler_t sampler("Evaluating CONCAT_MAP elements.", env->trace);
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                auto ds = f->call(env, *it)->as_seq(env);
-                for (;;) {
-                    auto v = ds->next_batch(env, bs);
-                    if (v.size() == 0) break;
-                    new_lst.reserve(new_lst.size() + v.size());
-                    new_lst.insert(new_lst.end(), v.begin(), v.end());
-                    sampler.new_sample();
+            if (should_eval_in_parallel(env, lst->size(), f.get())) {
+                // Every element gets its own sequence, so that they can be put
+                // together in order afterwards.
+                std::vector<datums_t> seqs(lst->size());
+                parallel_eval(env, lst->size(), [&](env_t *e, size_t i) {
+                    append_seq(e, (*lst)[i], bs, &seqs[i], nullptr);
+                });
+                for (auto &&seq : seqs) {
+                    new_lst.insert(new_lst.end(), seq.begin(), seq.end());
+                }
+            } else {
+                profile::sampler_t sampler("Evaluating CONCAT_MAP elements.",
+                                           env->trace);
+                for (auto it = lst->begin(); it != lst->end(); ++it) {
+                    append_seq(env, *it, bs, &new_lst, &sampler);
                 }
             }
         } catch (const datum_exc_t &e) {
@@ -1082,6 +1237,20 @@ private:
         }
         lst->swap(new_lst);
     }
+    // Appends the sequence that `f` returns for `d` to `out`.  `sampler` can be null.
+    void append_seq(env_t *env, const datum_t &d, const batchspec_t &bs,
+                    datums_t *out, profile::sampler_t *sampler) {
+        auto ds = f->call(env, d)->as_seq(env);
+        for (;;) {
+            auto v = ds->next_batch(env, bs);
+            if (v.size() == 0) break;
+            out->reserve(out->size() + v.size());
+            out->insert(out->end(), v.begin(), v.end());
+            if (sampler != nullptr) {
+                sampler->new_sample();
+            }
+        }
+    }
     counted_t<const func_t> f;
 };
 
@@ -19,6 +19,7 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_utils.hpp"
 #include "rdb_protocol/profile.hpp"
+#include "rdb_protocol/sketches.hpp"
 #include "rdb_protocol/wire_func.hpp"
 #include "region/region.hpp"
 #include "stl_utils.hpp"
@@ -182,6 +183,14 @@ template <cluster_version_t W>
 void serialize_grouped(write_message_t *wm, const datums_t &ds) {
     serialize<W>(wm, ds);
 }
+template <cluster_version_t W>
+void serialize_grouped(write_message_t *wm, const hll_sketch_t &hll) {
+    serialize<W>(wm, hll);
+}
+template <cluster_version_t W>
+void serialize_grouped(write_message_t *wm, const tdigest_t &td) {
+    serialize<W>(wm, td);
+}
 
 template <cluster_version_t W>
 archive_result_t deserialize_grouped(
@@ -219,6 +228,14 @@ template <cluster_version_t W>
 archive_result_t deserialize_grouped(read_stream_t *s, datums_t *ds) {
     return deserialize<W>(s, ds);
 }
+template <cluster_version_t W>
+archive_result_t deserialize_grouped(read_stream_t *s, hll_sketch_t *hll) {
+    return deserialize<W>(s, hll);
+}
+template <cluster_version_t W>
+archive_result_t deserialize_grouped(read_stream_t *s, tdigest_t *td) {
+    return deserialize<W>(s, td);
+}
 
 // This is basically a templated typedef with special serialization.
 template<class T>
@@ -344,6 +361,8 @@ typedef boost::variant<
     grouped_t<std::pair<double, uint64_t> >, // Avg.
     grouped_t<ql::datum_t>, // Reduce (may be NULL)
     grouped_t<optimizer_t>, // min, max
+    grouped_t<hll_sketch_t>, // approx_count_distinct
+    grouped_t<tdigest_t>, // approx_quantile
     grouped_t<stream_t>, // No terminal.
     exc_t // Don't re-order (we don't want this to initialize to an error.)
     > result_t;
@@ -383,6 +402,8 @@ typedef boost::variant<count_wire_func_t,
                        avg_wire_func_t,
                        min_wire_func_t,
                        max_wire_func_t,
+                       approx_count_distinct_wire_func_t,
+                       approx_quantile_wire_func_t,
                        reduce_wire_func_t,
                        limit_read_t
                        > terminal_variant_t;
@@ -0,0 +1,191 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/sketches.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "containers/archive/stl_types.hpp"
+#include "rdb_protocol/datum.hpp"
+
+namespace ql {
+
+void hll_sketch_t::add(const datum_t &d) {
+    // `datum_t::hash()` is the same on every server, but it's an FNV hash whose high
+    // bits don't depend much on the end of the data, so we mix it first (this is
+    // the finalizer of MurmurHash3).
+    uint64_t h = d.hash();
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    add_hash(h);
+}
+
+void hll_sketch_t::add_hash(uint64_t hash) {
+    if (registers.empty()) {
+        registers.resize(NUM_REGISTERS, 0);
+    }
+    const size_t index = hash >> (64 - PRECISION);
+    // The extra bit stops the count at 64 - PRECISION + 1 if the rest is all zeros.
+    const uint64_t rest = (hash << PRECISION) | (1ULL << (PRECISION - 1));
+    const uint8_t rank = __builtin_clzll(rest) + 1;
+    registers[index] = std::max(registers[index], rank);
+}
+
+void hll_sketch_t::merge(const hll_sketch_t &other) {
+    if (other.registers.empty()) {
+        return;
+    }
+    if (registers.empty()) {
+        registers = other.registers;
+        return;
+    }
+    guarantee(registers.size() == NUM_REGISTERS
+              && other.registers.size() == NUM_REGISTERS);
+    for (size_t i = 0; i < NUM_REGISTERS; ++i) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+}
+
+uint64_t hll_sketch_t::estimate() const {
+    if (registers.empty()) {
+        return 0;
+    }
+    const double m = NUM_REGISTERS;
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += ldexp(1.0, -static_cast<int>(r));
+        zeros += (r == 0);
+    }
+    const double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    // Linear counting is more accurate while many registers are still empty.  We
+    // use 64 bit hashes, so there's no correction for hash collisions at the top.
+    if (estimate <= 2.5 * m && zeros != 0) {
+        estimate = m * log(m / zeros);
+    }
+    return static_cast<uint64_t>(llround(estimate));
+}
+
+RDB_MAKE_SERIALIZABLE_1_FOR_CLUSTER(hll_sketch_t, registers);
+
+// How many values `add()` buffers before it merges them into the centroids.
+static const size_t TDIGEST_BUFFER_SIZE = 5 * tdigest_t::COMPRESSION;
+
+void tdigest_t::add(double value) {
+    if (empty()) {
+        min = max = value;
+    } else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    total_weight += 1;
+    unmerged.push_back(value);
+    if (unmerged.size() >= TDIGEST_BUFFER_SIZE) {
+        compress();
+    }
+}
+
+void tdigest_t::merge(const tdigest_t &other) {
+    if (other.empty()) {
+        return;
+    }
+    if (empty()) {
+        min = other.min;
+        max = other.max;
+    } else {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+    total_weight += other.total_weight;
+    centroids.insert(centroids.end(), other.centroids.begin(), other.centroids.end());
+    unmerged.insert(unmerged.end(), other.unmerged.begin(), other.unmerged.end());
+    compress();
+}
+
+// The scale function k_1 from Dunning's paper, and its inverse.  A centroid may only
+// grow as long as it spans at most 1 in `k`, which makes the centroids near q = 0 and
+// q = 1 small.
+static double tdigest_k(double q) {
+    return tdigest_t::COMPRESSION / (2 * M_PI) * asin(2 * q - 1);
+}
+static double tdigest_q(double k) {
+    if (k >= tdigest_t::COMPRESSION / 4.0) {
+        return 1;
+    }
+    return (sin(k * 2 * M_PI / tdigest_t::COMPRESSION) + 1) / 2;
+}
+
+void tdigest_t::compress() {
+    if (unmerged.empty() && centroids.size() <= 1) {
+        return;
+    }
+    std::vector<centroid_t> all;
+    all.reserve(centroids.size() + unmerged.size());
+    all.insert(all.end(), centroids.begin(), centroids.end());
+    for (double value : unmerged) {
+        all.push_back(centroid_t{value, 1});
+    }
+    unmerged.clear();
+    std::sort(all.begin(), all.end(),
+              [](const centroid_t &a, const centroid_t &b) { return a.mean < b.mean; });
+
+    centroids.clear();
+    double weight_so_far = 0;
+    double weight_limit = total_weight * tdigest_q(tdigest_k(0) + 1);
+    centroid_t current = all[0];
+    for (size_t i = 1; i < all.size(); ++i) {
+        if (weight_so_far + current.weight + all[i].weight <= weight_limit) {
+            const double weight = current.weight + all[i].weight;
+            current.mean += (all[i].mean - current.mean) * all[i].weight / weight;
+            current.weight = weight;
+        } else {
+            weight_so_far += current.weight;
+            centroids.push_back(current);
+            weight_limit = total_weight
+                * tdigest_q(tdigest_k(weight_so_far / total_weight) + 1);
+            current = all[i];
+        }
+    }
+    centroids.push_back(current);
+}
+
+double tdigest_t::quantile(double q) {
+    guarantee(!empty());
+    compress();
+    if (centroids.size() == 1) {
+        return centroids[0].mean;
+    }
+    // Every centroid stands for the values around its mean, so we interpolate between
+    // the means and between the outer means and the extremes.
+    const double target = q * total_weight;
+    double left_weight = centroids[0].weight / 2;
+    if (target < left_weight) {
+        return min + (centroids[0].mean - min) * target / left_weight;
+    }
+    for (size_t i = 0; i + 1 < centroids.size(); ++i) {
+        const double step = (centroids[i].weight + centroids[i + 1].weight) / 2;
+        if (target < left_weight + step) {
+            return centroids[i].mean
+                + (centroids[i + 1].mean - centroids[i].mean)
+                * (target - left_weight) / step;
+        }
+        left_weight += step;
+    }
+    const double right_weight = centroids.back().weight / 2;
+    if (right_weight == 0) {
+        return max;
+    }
+    return centroids.back().mean
+        + (max - centroids.back().mean)
+        * std::min(1.0, (target - left_weight) / right_weight);
+}
+
+RDB_MAKE_SERIALIZABLE_2_FOR_CLUSTER(tdigest_t::centroid_t, mean, weight);
+RDB_MAKE_SERIALIZABLE_5_FOR_CLUSTER(
+    tdigest_t, centroids, unmerged, total_weight, min, max);
+
+}  // namespace ql
@@ -0,0 +1,76 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_SKETCHES_HPP_
+#define RDB_PROTOCOL_SKETCHES_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "rpc/serialize_macros.hpp"
+
+namespace ql {
+
+class datum_t;
+
+// A HyperLogLog sketch for `approx_count_distinct`.  Every shard builds one, and
+// merging the sketches gives the same result as building one over all the rows, so
+// only the registers have to be sent to the parsing node.  The standard error of
+// the estimate is about 1.6%.
+class hll_sketch_t {
+public:
+    static const int PRECISION = 12;
+    static const size_t NUM_REGISTERS = 1 << PRECISION;
+
+    hll_sketch_t() { }
+
+    // Data that are equal according to `cmp()` count as one value.
+    void add(const datum_t &d);
+    void merge(const hll_sketch_t &other);
+    uint64_t estimate() const;
+
+    // Empty until the first value is added, so that empty groups stay small.
+    std::vector<uint8_t> registers;
+
+private:
+    void add_hash(uint64_t hash);
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(hll_sketch_t);
+
+// A merging t-digest for `approx_quantile`.  Values are kept in clusters that are
+// small near the ends of the distribution and large in the middle, so extreme
+// quantiles stay accurate while a digest never has much more than `COMPRESSION`
+// clusters.
+class tdigest_t {
+public:
+    static const int COMPRESSION = 100;
+
+    struct centroid_t {
+        double mean;
+        double weight;
+    };
+
+    tdigest_t() : total_weight(0), min(0), max(0) { }
+
+    void add(double value);
+    void merge(const tdigest_t &other);
+    bool empty() const { return total_weight == 0; }
+    // `q` must be between 0 and 1, and the digest must not be empty.
+    double quantile(double q);
+
+    // Sorted by mean after `compress()`.  `unmerged` holds the values that have been
+    // added since then.
+    std::vector<centroid_t> centroids;
+    std::vector<double> unmerged;
+    double total_weight;
+    double min, max;
+
+private:
+    void compress();
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(tdigest_t::centroid_t);
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(tdigest_t);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_SKETCHES_HPP_
@@ -295,7 +295,8 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     void operator()(const changefeed_subscribe_t &s) {
         auto cserver = store->get_or_make_changefeed_server(s.shard_region);
         guarantee(cserver.first != nullptr);
-        cserver.first->add_client(s.addr, s.shard_region, cserver.second);
+        cserver.first->add_client(s.addr, s.shard_region, s.transforms,
+                                  s.serializable_env, ctx, cserver.second);
         response->response = changefeed_subscribe_response_t();
         auto res = boost::get<changefeed_subscribe_response_t>(&response->response);
         guarantee(res != NULL);
@@ -450,6 +451,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const point_read_t &get) {
+        store->load_sampler.record(get.key);
         response->response = point_read_response_t();
         point_read_response_t *res =
             boost::get<point_read_response_t>(&response->response);
@@ -667,6 +669,14 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         }
 
         res->region = dg.region;
+        store->load_sampler.get_loads(dg.region.inner, &res->key_loads);
+    }
+
+    void operator()(const sample_read_t &sr) {
+        response->response = sample_read_response_t();
+        sample_read_response_t *res =
+            boost::get<sample_read_response_t>(&response->response);
+        rdb_sample_get(superblock, sr.region.inner, sr.n, interruptor, res);
     }
 
     void operator()(const dummy_read_t &) {
@@ -825,6 +835,9 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
                                  write_hook,
                                  br.return_changes);
 
+        for (const store_key_t &key : br.keys) {
+            store->load_sampler.record(key);
+        }
         response->response =
             rdb_batched_replace(
                 btree_info_t(btree, timestamp, datum_string_t(br.pkey)),
@@ -853,6 +866,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         keys.reserve(bi.inserts.size());
         for (auto it = bi.inserts.begin(); it != bi.inserts.end(); ++it) {
             keys.emplace_back(it->get_field(datum_string_t(bi.pkey)).print_primary());
+            store->load_sampler.record(keys.back());
         }
         response->response =
             rdb_batched_replace(
@@ -868,6 +882,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
     void operator()(const point_write_t &w) {
         sampler->new_sample();
+        store->load_sampler.record(w.key);
         response->response = point_write_response_t();
         point_write_response_t *res =
             boost::get<point_write_response_t>(&response->response);
@@ -884,6 +899,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
     void operator()(const point_delete_t &d) {
         sampler->new_sample();
+        store->load_sampler.record(d.key);
         response->response = point_delete_response_t();
         point_delete_response_t *res =
             boost::get<point_delete_response_t>(&response->response);
@@ -23,6 +23,7 @@
 #include "paths.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/key_load_sampler.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/store_metainfo.hpp"
 #include "rpc/mailbox/typed.hpp"
@@ -361,13 +362,18 @@ private:
 public:
     namespace_id_t const &get_table_id() const;
 
-    // The `double` is the progress of the secondary index construction.
-    typedef std::map<uuid_u, std::pair<microtime_t, double const *> >
-        sindex_context_map_t;
+    // Tracks a secondary index construction for the `jobs` table and `indexStatus`.
+    struct sindex_context_t {
+        microtime_t start_time;
+        double const *progress;
+        int64_t const *rows_constructed;
+    };
+    typedef std::map<uuid_u, sindex_context_t> sindex_context_map_t;
     sindex_context_map_t *get_sindex_context_map();
 
     double get_sindex_progress(uuid_u const &id);
     microtime_t get_sindex_start_time(uuid_u const &id);
+    int64_t get_sindex_rows_constructed(uuid_u const &id);
 
     fifo_enforcer_source_t main_token_source, sindex_token_source;
     fifo_enforcer_sink_t main_token_sink, sindex_token_sink;
@@ -381,6 +387,15 @@ public:
     io_backender_t *io_backender_;
     base_path_t base_path_;
     perfmon_membership_t perfmon_collection_membership;
+    // The latencies of `read()` and `write()`, in microseconds.
+    perfmon_histogram_t read_latency, write_latency;
+    // These split up `write()`, also in microseconds: waiting for the superblock,
+    // applying the write to the btree, and committing the transaction (with hard
+    // durability that includes the flush).  Within the btree stage, the secondary
+    // index update and the changefeed report of each changed row are recorded too.
+    perfmon_histogram_t write_superblock_latency, write_btree_latency,
+        write_sindex_latency, write_changefeed_latency, write_commit_latency;
+    perfmon_multi_membership_t latency_membership;
     scoped_ptr_t<store_metainfo_manager_t> metainfo;
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
@@ -441,6 +456,17 @@ private:
     // the superblock, if any).
     new_semaphore_t write_superblock_acq_semaphore;
 
+#ifndef NDEBUG
+    // Runs `metainfo_checker` against the metainfo.  Checkers without a callback are
+    // skipped while the metainfo is the same as for an earlier one that covered their
+    // region.
+    void check_metainfo(const metainfo_checker_t &metainfo_checker,
+                        real_superblock_t *superblock);
+
+    uint64_t checked_metainfo_generation;
+    region_t checked_metainfo_region;
+#endif
+
 public:
     // This lock is used to pause backfills while secondary indexes are being
     // post constructed. Secondary index post construction gets in line for a write
@@ -450,6 +476,9 @@ public:
     // A read lock is acquired before a backfill chunk is being processed.
     rwlock_t backfill_postcon_lock;
 
+    // The keys of recent point reads and writes, for `rebalance()`.
+    key_load_sampler_t load_sampler;
+
     // Mind the constructor ordering. We must destruct drainer before destructing
     // many of the other structures.
     auto_drainer_t drainer;
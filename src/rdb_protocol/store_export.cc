@@ -0,0 +1,164 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/store_export.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/types.hpp"
+#include "btree/depth_first_traversal.hpp"
+#include "concurrency/interruptor.hpp"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/lazy_btree_val.hpp"
+#include "rdb_protocol/store_snapshot.hpp"
+#include "utils.hpp"
+
+// How much JSON we collect before compressing and writing it.
+static const size_t NDJSON_WRITE_SIZE = 4 * MEGABYTE;
+
+struct ndjson_file_writer_t::deflater_t {
+    deflater_t() {
+        memset(&stream, 0, sizeof(stream));
+        // 16 more window bits ask zlib for a gzip header and trailer.
+        int res = deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                               Z_DEFAULT_STRATEGY);
+        guarantee(res == Z_OK, "deflateInit2 failed (%d)", res);
+    }
+    ~deflater_t() {
+        deflateEnd(&stream);
+    }
+    z_stream stream;
+};
+
+ndjson_file_writer_t::ndjson_file_writer_t(const std::string &path, bool gzip)
+    : path_(path), rows_written_(0), finished_(false) {
+    int fd;
+    do {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    } while (fd == -1 && get_errno() == EINTR);
+    if (fd == -1) {
+        throw std::runtime_error(strprintf("Could not create '%s': %s", path.c_str(),
+                                           errno_string(get_errno()).c_str()));
+    }
+    fd_.reset(fd);
+    if (gzip) {
+        deflater_.init(new deflater_t());
+    }
+}
+
+ndjson_file_writer_t::~ndjson_file_writer_t() {
+    // Without `finish()` the file is incomplete, so we don't bother writing the rest.
+}
+
+void ndjson_file_writer_t::write_row(const ql::datum_t &row) {
+    guarantee(!finished_);
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer_);
+    row.write_json(&writer);
+    buffer_.Put('\n');
+    ++rows_written_;
+    if (buffer_.GetSize() >= NDJSON_WRITE_SIZE) {
+        flush(false);
+    }
+}
+
+void ndjson_file_writer_t::finish() {
+    guarantee(!finished_);
+    flush(true);
+    finished_ = true;
+    int errsv = 0;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        if (fsync(fd_.get()) != 0) {
+            errsv = get_errno();
+        }
+    });
+    if (errsv != 0) {
+        throw std::runtime_error(strprintf("Could not write '%s': %s", path_.c_str(),
+                                           errno_string(errsv).c_str()));
+    }
+    fd_.reset();
+}
+
+void ndjson_file_writer_t::flush(bool last) {
+    if (!deflater_.has()) {
+        write_to_file(buffer_.GetString(), buffer_.GetSize());
+        buffer_.Clear();
+        return;
+    }
+    std::vector<char> compressed(deflateBound(&deflater_->stream, buffer_.GetSize()));
+    z_stream *stream = &deflater_->stream;
+    stream->next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(buffer_.GetString()));
+    stream->avail_in = buffer_.GetSize();
+    int res;
+    do {
+        stream->next_out = reinterpret_cast<Bytef *>(compressed.data());
+        stream->avail_out = compressed.size();
+        res = deflate(stream, last ? Z_FINISH : Z_NO_FLUSH);
+        guarantee(res == Z_OK || res == Z_STREAM_END || res == Z_BUF_ERROR,
+                  "deflate failed (%d)", res);
+        write_to_file(compressed.data(), compressed.size() - stream->avail_out);
+    } while (stream->avail_in > 0 || (last && res != Z_STREAM_END));
+    buffer_.Clear();
+}
+
+void ndjson_file_writer_t::write_to_file(const char *data, size_t size) {
+    int errsv = 0;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        while (size > 0) {
+            ssize_t res = ::write(fd_.get(), data, size);
+            if (res == -1) {
+                if (get_errno() == EINTR) {
+                    continue;
+                }
+                errsv = get_errno();
+                return;
+            }
+            data += res;
+            size -= res;
+        }
+    });
+    if (errsv != 0) {
+        throw std::runtime_error(strprintf("Could not write '%s': %s", path_.c_str(),
+                                           errno_string(errsv).c_str()));
+    }
+}
+
+class export_rows_cb_t : public depth_first_traversal_callback_t {
+public:
+    explicit export_rows_cb_t(ndjson_file_writer_t *_writer) : writer(_writer) { }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue,
+                                signal_t *interruptor) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        writer->write_row(get_data(
+            static_cast<const rdb_value_t *>(keyvalue.value()),
+            buf_parent_t(keyvalue.expose_buf())));
+        return continue_bool_t::CONTINUE;
+    }
+
+    // An export reads every block once, so it shouldn't push out the working set.
+    page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::streaming;
+    }
+    bool prefetch_children() THROWS_NOTHING { return true; }
+
+private:
+    ndjson_file_writer_t *writer;
+};
+
+int64_t export_store_rows(store_t *store, ndjson_file_writer_t *writer,
+                          signal_t *interruptor) {
+    const int64_t rows_before = writer->rows_written();
+    store_snapshot_t snapshot(store, interruptor);
+    export_rows_cb_t cb(writer);
+    snapshot.traverse(key_range_t::universe(), &cb, interruptor);
+    return writer->rows_written() - rows_before;
+}
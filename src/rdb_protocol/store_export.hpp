@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_STORE_EXPORT_HPP_
+#define RDB_PROTOCOL_STORE_EXPORT_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "arch/io/io_utils.hpp"
+#include "containers/scoped.hpp"
+#include "rapidjson/stringbuffer.h"
+
+namespace ql {
+class datum_t;
+}
+class signal_t;
+class store_t;
+
+/* `ndjson_file_writer_t` writes rows to a file as newline-delimited JSON, which is what
+`rethinkdb import` reads, and can gzip them on the way.  It collects a few megabytes
+before every write, and the writes run in the blocker pool so that they don't stall
+the thread.  The constructor and `write_row()` throw `std::runtime_error` if the file
+can't be written. */
+class ndjson_file_writer_t {
+public:
+    ndjson_file_writer_t(const std::string &path, bool gzip);
+    ~ndjson_file_writer_t();
+
+    void write_row(const ql::datum_t &row);
+
+    // Writes what's left and closes the file.  The file is only complete after this
+    // has returned.
+    void finish();
+
+    int64_t rows_written() const { return rows_written_; }
+
+private:
+    struct deflater_t;
+
+    // Writes out `buffer_`.  With `last` it also ends the gzip stream.
+    void flush(bool last);
+    void write_to_file(const char *data, size_t size);
+
+    const std::string path_;
+    scoped_fd_t fd_;
+    scoped_ptr_t<deflater_t> deflater_;
+    rapidjson::StringBuffer buffer_;
+    int64_t rows_written_;
+    bool finished_;
+
+    DISABLE_COPYING(ndjson_file_writer_t);
+};
+
+/* Writes every row in the primary index of `store` to `writer`.  The rows come from one
+snapshot of the B-tree, so writes that happen meanwhile don't show up in the export and
+don't have to wait for it.  Doesn't call `writer->finish()`.
+Returns the number of rows. */
+int64_t export_store_rows(store_t *store, ndjson_file_writer_t *writer,
+                          signal_t *interruptor);
+
+#endif  // RDB_PROTOCOL_STORE_EXPORT_HPP_
@@ -5,7 +5,8 @@
 #include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
 
-store_metainfo_manager_t::store_metainfo_manager_t(real_superblock_t *superblock) {
+store_metainfo_manager_t::store_metainfo_manager_t(real_superblock_t *superblock)
+    : generation(0) {
     std::vector<std::pair<std::vector<char>, std::vector<char> > > kv_pairs;
     // TODO: this is inefficient, cut out the middleman (vector)
     get_superblock_metainfo(superblock, &kv_pairs, &cache_version);
@@ -33,6 +34,13 @@ cluster_version_t store_metainfo_manager_t::get_version(
     return cache_version;
 }
 
+uint64_t store_metainfo_manager_t::get_generation(
+        real_superblock_t *superblock) const {
+    guarantee(superblock != nullptr);
+    superblock->get()->read_acq_signal()->wait_lazily_unordered();
+    return generation;
+}
+
 region_map_t<binary_blob_t> store_metainfo_manager_t::get(
         real_superblock_t *superblock,
         const region_t &region) const {
@@ -61,6 +69,7 @@ void store_metainfo_manager_t::update(
     superblock->get()->write_acq_signal()->wait_lazily_unordered();
 
     cache.update(new_values);
+    ++generation;
 
     std::vector<std::vector<char> > keys;
     std::vector<binary_blob_t> values;
@@ -35,9 +35,14 @@ public:
 
     cluster_version_t get_version(real_superblock_t *superblock) const;
 
+    // Changes whenever the metainfo changes, so callers can tell whether something
+    // they have checked about the metainfo still holds.
+    uint64_t get_generation(real_superblock_t *superblock) const;
+
 private:
     cluster_version_t cache_version;
     region_map_t<binary_blob_t> cache;
+    uint64_t generation;
 };
 
 #endif /* RDB_PROTOCOL_STORE_METAINFO_HPP_ */
@@ -1,5 +1,7 @@
 #include "rdb_protocol/store.hpp"
 
+#include <algorithm>
+
 #include "btree/backfill.hpp"
 #include "btree/reql_specific.hpp"
 #include "rdb_protocol/btree.hpp"
@@ -14,6 +16,13 @@ backfill faster, but it will also cause the backfill-related transactions to hol
 superblock for a longer time. */
 static const int MAX_CHANGES_PER_TXN = 16;
 
+/* `MAX_CHANGES_PER_TXN_EMPTY_RANGE` is the maximum number of pairs we'll write in a
+single transaction when applying a multi-key backfill item to a part of the B-tree that
+turned out to be empty. That's the common case when a new replica is being backfilled;
+the sender transmits whole leaf nodes as single items, and inserting their pairs in key
+order only touches a leaf or two per transaction. */
+static const int MAX_CHANGES_PER_TXN_EMPTY_RANGE = 256;
+
 /* `MAX_UNSAVED_CHANGES` is the maximum number of keys we'll modify or delete before
 flushing our changes out to disk. This prevents the backfill from using too much of the
 cache's unsaved data limit, which would slow down queries on other shards. */
@@ -292,14 +301,19 @@ void apply_multi_key_item(
         backfill item in several chunks. */
         bool is_first = true;
         size_t next_pair = 0;
+        /* `pairs_per_txn` is how many of the item's pairs we apply in one transaction.
+        As long as the chunks we erase don't contain any existing keys, we grow it up to
+        `MAX_CHANGES_PER_TXN_EMPTY_RANGE`. */
+        size_t pairs_per_txn = MAX_CHANGES_PER_TXN / 2;
         key_range_t::right_bound_t threshold(item.range.left);
         while (threshold != item.range.right) {
             std::vector<rdb_modification_report_t> mod_reports;
 
-            /* Block until there's not too much unsaved data. Note that
-            `MAX_CHANGES_PER_TXN` might be an overestimate, but that's OK. */
+            /* Block until there's not too much unsaved data. Note that this might be an
+            overestimate, but that's OK. */
             tokens.info->limiter->prepare_for_changes(
-                MAX_CHANGES_PER_TXN, tokens.keepalive.get_drain_signal());
+                MAX_CHANGES_PER_TXN / 2 + pairs_per_txn,
+                tokens.keepalive.get_drain_signal());
 
             /* We must not throw within the transaction. So we check the
             drain signal now. */
@@ -330,12 +344,12 @@ void apply_multi_key_item(
 
             /* Establish an upper limit on how much of the range we're willing to delete
             in this cycle. We choose the upper limit such that it contains no more than
-            `MAX_CHANGES_PER_TXN / 2` of the pairs in the backfill item. */
+            `pairs_per_txn` of the pairs in the backfill item. */
             key_range_t range_to_delete;
             range_to_delete.left = threshold.key();
-            if (next_pair + MAX_CHANGES_PER_TXN / 2 + 1 < item.pairs.size()) {
+            if (next_pair + pairs_per_txn + 1 < item.pairs.size()) {
                 range_to_delete.right = key_range_t::right_bound_t(
-                    item.pairs[next_pair + MAX_CHANGES_PER_TXN / 2 + 1].key);
+                    item.pairs[next_pair + pairs_per_txn + 1].key);
             } else {
                 range_to_delete.right = item.range.right;
             }
@@ -351,6 +365,12 @@ void apply_multi_key_item(
                 &mod_reports, &range_deleted);
             guarantee(range_deleted.right == range_to_delete.right
                 || res == continue_bool_t::CONTINUE);
+            if (mod_reports.empty()) {
+                pairs_per_txn = std::min<size_t>(
+                    pairs_per_txn * 2, MAX_CHANGES_PER_TXN_EMPTY_RANGE);
+            } else {
+                pairs_per_txn = MAX_CHANGES_PER_TXN / 2;
+            }
 
             /* Apply any pairs from the item that fall within the deleted region */
             while (next_pair < item.pairs.size() &&
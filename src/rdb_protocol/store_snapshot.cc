@@ -0,0 +1,199 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/store_snapshot.hpp"
+
+#include <set>
+
+#include "btree/depth_first_traversal.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/reql_specific.hpp"
+#include "concurrency/interruptor.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/lazy_btree_val.hpp"
+#include "rdb_protocol/store.hpp"
+
+store_snapshot_t::store_snapshot_t(store_t *store, signal_t *interruptor,
+                                   int64_t refresh_bytes)
+    : store_(store), refresh_bytes_(refresh_bytes), bytes_read_(0),
+      unread_(key_range_t::universe()) {
+    store_->assert_thread();
+    take_snapshot(interruptor);
+}
+
+store_snapshot_t::~store_snapshot_t() {
+    store_->assert_thread();
+}
+
+continue_bool_t store_snapshot_t::traverse(const key_range_t &range,
+                                           depth_first_traversal_callback_t *cb,
+                                           signal_t *interruptor) {
+    store_->assert_thread();
+    if (!superblock_.has()) {
+        take_snapshot(interruptor);
+    }
+    // We keep the superblock, since releasing it would end the snapshot.
+    return btree_depth_first_traversal(superblock_.get(), range, cb, access_t::read,
+                                       FORWARD, release_superblock_t::KEEP,
+                                       interruptor);
+}
+
+class read_batch_cb_t : public depth_first_traversal_callback_t {
+public:
+    read_batch_cb_t(size_t _max_rows, std::vector<ql::datum_t> *_rows_out)
+        : max_rows(_max_rows), rows_read(0), bytes_read(0), rows_out(_rows_out) { }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue,
+                                signal_t *interruptor) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        const rdb_value_t *value = static_cast<const rdb_value_t *>(keyvalue.value());
+        rows_out->push_back(get_data(value, buf_parent_t(keyvalue.expose_buf())));
+        last_key.assign(keyvalue.key());
+        ++rows_read;
+        bytes_read += keyvalue.key()->size + value->value_size();
+        return rows_read == max_rows
+            ? continue_bool_t::ABORT
+            : continue_bool_t::CONTINUE;
+    }
+
+    page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::streaming;
+    }
+
+    const size_t max_rows;
+    size_t rows_read;
+    int64_t bytes_read;
+    std::vector<ql::datum_t> *const rows_out;
+    store_key_t last_key;
+};
+
+continue_bool_t store_snapshot_t::read_batch(size_t max_rows,
+                                             std::vector<ql::datum_t> *rows_out,
+                                             signal_t *interruptor) {
+    guarantee(max_rows > 0);
+    if (unread_.is_empty()) {
+        return continue_bool_t::ABORT;
+    }
+    read_batch_cb_t cb(max_rows, rows_out);
+    if (traverse(unread_, &cb, interruptor) == continue_bool_t::CONTINUE) {
+        unread_ = key_range_t::empty();
+    } else {
+        unread_ = key_range_t(key_range_t::open, cb.last_key,
+                              key_range_t::none, store_key_t());
+    }
+    bytes_read_ += cb.bytes_read;
+    if (refresh_bytes_ != 0 && bytes_read_ >= refresh_bytes_) {
+        // Let go of the old block versions now; the next call takes a new snapshot.
+        superblock_.reset();
+        txn_.reset();
+    }
+    return cb.rows_read == 0 ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
+}
+
+class changed_since_cb_t : public depth_first_traversal_callback_t {
+public:
+    changed_since_cb_t(value_sizer_t *_sizer, const key_range_t &_range,
+                       repli_timestamp_t _since, changed_rows_callback_t *_cb)
+        : sizer(_sizer), range(_range), since(_since), latest(_since), cb(_cb),
+          send_whole_leaf(false) { }
+
+    continue_bool_t filter_range_ts(UNUSED const btree_key_t *left_excl_or_null,
+                                    UNUSED const btree_key_t *right_incl,
+                                    repli_timestamp_t timestamp,
+                                    UNUSED signal_t *interruptor,
+                                    bool *skip_out) {
+        *skip_out = timestamp <= since;
+        return continue_bool_t::CONTINUE;
+    }
+
+    continue_bool_t handle_pre_leaf(const counted_t<counted_buf_lock_and_read_t> &buf,
+                                    const btree_key_t *left_excl_or_null,
+                                    const btree_key_t *right_incl,
+                                    signal_t *interruptor,
+                                    bool *skip_out) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        const leaf_node_t *lnode =
+            static_cast<const leaf_node_t *>(buf->read->get_data_read());
+        changed_keys.clear();
+        // As in `btree_send_backfill_pre()`, a leaf that might have dropped the
+        // deletion entries since `since` has to be sent whole.
+        send_whole_leaf = leaf::min_deletion_timestamp(
+            sizer, lnode, buf->lock.get_recency()) > since.next();
+        if (send_whole_leaf) {
+            key_range_t leaf_range(
+                left_excl_or_null == nullptr
+                    ? key_range_t::bound_t::none : key_range_t::bound_t::open,
+                left_excl_or_null,
+                key_range_t::bound_t::closed,
+                right_incl);
+            cb->on_unknown_deletions(leaf_range.intersection(range));
+        }
+        leaf::visit_entries(sizer, lnode, buf->lock.get_recency(),
+            [&](const btree_key_t *key, repli_timestamp_t timestamp,
+                    const void *value_or_null) -> continue_bool_t {
+                // The entries come from newest to oldest.
+                if (timestamp <= since) {
+                    return continue_bool_t::ABORT;
+                }
+                if (!range.contains_key(key)) {
+                    return continue_bool_t::CONTINUE;
+                }
+                latest = superceding_recency(latest, timestamp);
+                if (value_or_null == nullptr) {
+                    cb->on_deletion(store_key_t(key));
+                } else {
+                    changed_keys.insert(store_key_t(key));
+                }
+                return continue_bool_t::CONTINUE;
+            });
+        *skip_out = !send_whole_leaf && changed_keys.empty();
+        return continue_bool_t::CONTINUE;
+    }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue,
+                                UNUSED signal_t *interruptor) {
+        store_key_t key(keyvalue.key());
+        if (send_whole_leaf || changed_keys.count(key) != 0) {
+            cb->on_row(key, get_data(
+                static_cast<const rdb_value_t *>(keyvalue.value()),
+                buf_parent_t(keyvalue.expose_buf())));
+        }
+        return continue_bool_t::CONTINUE;
+    }
+
+    page_access_hint_t get_access_hint() THROWS_NOTHING {
+        return page_access_hint_t::streaming;
+    }
+
+    value_sizer_t *const sizer;
+    const key_range_t range;
+    const repli_timestamp_t since;
+    // The newest change we've seen.
+    repli_timestamp_t latest;
+    changed_rows_callback_t *const cb;
+
+    // What `handle_pre_leaf()` decided about the current leaf.
+    bool send_whole_leaf;
+    std::set<store_key_t> changed_keys;
+};
+
+repli_timestamp_t store_snapshot_t::read_changed_since(const key_range_t &range,
+                                                       repli_timestamp_t since,
+                                                       changed_rows_callback_t *cb,
+                                                       signal_t *interruptor) {
+    rdb_value_sizer_t sizer(store_->cache->max_block_size());
+    changed_since_cb_t traversal_cb(&sizer, range, since, cb);
+    traverse(range, &traversal_cb, interruptor);
+    return traversal_cb.latest;
+}
+
+void store_snapshot_t::take_snapshot(signal_t *interruptor) {
+    read_token_t token;
+    store_->new_read_token(&token);
+    store_->acquire_superblock_for_read(
+        &token, &txn_, &superblock_, interruptor, true);
+    bytes_read_ = 0;
+}
@@ -0,0 +1,98 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_STORE_SNAPSHOT_HPP_
+#define RDB_PROTOCOL_STORE_SNAPSHOT_HPP_
+
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "btree/types.hpp"
+#include "containers/scoped.hpp"
+#include "repli_timestamp.hpp"
+
+namespace ql {
+class datum_t;
+}
+class depth_first_traversal_callback_t;
+class real_superblock_t;
+class signal_t;
+class store_t;
+class txn_t;
+
+/* `changed_rows_callback_t` hears about the changes that
+`store_snapshot_t::read_changed_since()` finds.  Rows come in key order;
+deletions and `on_unknown_deletions()` come before the rows of the same leaf node. */
+class changed_rows_callback_t {
+public:
+    // The row with the key `key` was written.
+    virtual void on_row(const store_key_t &key, ql::datum_t &&row) = 0;
+    // The row with the key `key` was deleted.
+    virtual void on_deletion(const store_key_t &key) = 0;
+    // The B-tree has forgotten which rows in `range` were deleted.  Every row in
+    // `range` follows, changed or not, and any key in `range` that doesn't must be
+    // considered deleted.
+    virtual void on_unknown_deletions(const key_range_t &range) = 0;
+protected:
+    virtual ~changed_rows_callback_t() { }
+};
+
+/* `store_snapshot_t` is a point-in-time view of the primary index of a store, for
+reads that take too long to stop writes for, such as backups.  Writes go on as usual:
+when one changes a block that the snapshot can see, the cache gives the write a new
+version of the block and the snapshot keeps a reference to the old one, which the
+serializer doesn't garbage-collect until the snapshot lets go of it.  So a snapshot
+costs nothing up front, but its old versions pile up as the store changes; destroy it
+as soon as you're done.  Readers that go through the whole store with `read_batch()`
+while it's being written to can pass `refresh_bytes` to pin only a chunk's worth of old
+versions at a time, at the price of the rows no longer being from one point in time.
+
+A `store_snapshot_t` must be created, used and destroyed on the store's thread. */
+class store_snapshot_t {
+public:
+    // With a `refresh_bytes` other than 0, `read_batch()` lets go of the snapshot
+    // once it has read that many bytes of rows from it, and takes a new one when it's
+    // called again.
+    store_snapshot_t(store_t *store, signal_t *interruptor, int64_t refresh_bytes = 0);
+    ~store_snapshot_t();
+
+    // Runs `cb` over the rows of the snapshot with keys in `range`.  Can be called
+    // any number of times, and every call sees the same rows, unless `read_batch()`
+    // has taken a new snapshot in between.
+    continue_bool_t traverse(const key_range_t &range,
+                             depth_first_traversal_callback_t *cb,
+                             signal_t *interruptor);
+
+    // Appends the next `max_rows` rows in key order to `rows_out`, starting after
+    // the last row of the previous call.  Returns `ABORT` once there are no rows left.
+    // Every key is read once even across new snapshots, but a batch that starts on a
+    // new snapshot sees the writes that have happened since the old one was taken.
+    continue_bool_t read_batch(size_t max_rows,
+                               std::vector<ql::datum_t> *rows_out,
+                               signal_t *interruptor);
+
+    // Tells `cb` about the rows in `range` that were written or deleted after `since`.
+    // Like a backfill, it skips the parts of the B-tree that haven't changed since
+    // then, so it only reads a fraction of a store where few rows have changed.
+    // Returns the `since` to pass next time to get the changes after this snapshot.
+    repli_timestamp_t read_changed_since(const key_range_t &range,
+                                         repli_timestamp_t since,
+                                         changed_rows_callback_t *cb,
+                                         signal_t *interruptor);
+
+private:
+    void take_snapshot(signal_t *interruptor);
+
+    store_t *store_;
+    const int64_t refresh_bytes_;
+    scoped_ptr_t<txn_t> txn_;
+    scoped_ptr_t<real_superblock_t> superblock_;
+
+    // How many bytes of rows `read_batch()` has read from the current snapshot.
+    int64_t bytes_read_;
+
+    // The keys that `read_batch()` hasn't read yet.
+    key_range_t unread_;
+
+    DISABLE_COPYING(store_snapshot_t);
+};
+
+#endif  // RDB_PROTOCOL_STORE_SNAPSHOT_HPP_
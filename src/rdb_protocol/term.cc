@@ -92,6 +92,9 @@ counted_t<const term_t> compile_on_current_stack(
     case Term::COUNT:              return make_count_term(env, t);
     case Term::SUM:                return make_sum_term(env, t);
     case Term::AVG:                return make_avg_term(env, t);
+    case Term::APPROX_COUNT_DISTINCT:
+        return make_approx_count_distinct_term(env, t);
+    case Term::APPROX_QUANTILE:    return make_approx_quantile_term(env, t);
     case Term::MIN:                return make_min_term(env, t);
     case Term::MAX:                return make_max_term(env, t);
     case Term::UNION:              return make_union_term(env, t);
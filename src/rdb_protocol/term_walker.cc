@@ -11,7 +11,6 @@
 namespace ql {
 
 bool term_type_is_valid(Term::TermType type);
-bool term_is_write_or_meta(Term::TermType type);
 bool term_forbids_writes(Term::TermType type);
 
 // The minimum amount of stack space we require to be available on a coroutine
@@ -152,9 +151,7 @@ private:
                 r_sanity_check(optargs->IsObject());
                 for (auto it = optargs->MemberBegin();
                      it != optargs->MemberEnd(); ++it) {
-                    backtrace_id_t child_bt = make_bt(bt,
-                        datum_t(datum_string_t(it->name.GetStringLength(),
-                                               it->name.GetString())));
+                    backtrace_id_t child_bt = make_optarg_bt(bt, it->name);
                     walker_frame_t child_frame(parent, false, this);
                     call_with_enough_stack([&]() {
                             child_frame.walk(&it->value, child_bt);
@@ -170,6 +167,15 @@ private:
             return parent->bt_reg->new_frame(prev, d);
         }
 
+        backtrace_id_t make_optarg_bt(backtrace_id_t prev,
+                                      const rapidjson::Value &name) {
+            if (parent->bt_reg == nullptr) {
+                return backtrace_id_t::empty();
+            }
+            return parent->bt_reg->new_optarg_frame(
+                prev, name.GetString(), name.GetStringLength());
+        }
+
         // True if writes are still legal at this node.  Basically:
         // * Once writes become illegal, they are never legal again.
         // * Writes are legal at the root.
@@ -286,6 +292,8 @@ bool term_type_is_valid(Term::TermType type) {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
     case Term::UNION:
@@ -483,6 +491,8 @@ bool term_is_write_or_meta(Term::TermType type) {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
     case Term::UNION:
@@ -612,6 +622,8 @@ bool term_forbids_writes(Term::TermType type) {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
         return true;
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_TERM_WALKER_HPP_
 
 #include "rapidjson/document.h"
+#include "rdb_protocol/ql2proto.hpp"
 
 namespace ql {
 
@@ -24,6 +25,9 @@ void preprocess_term_tree(rapidjson::Value *query_json,
 void preprocess_global_optarg(rapidjson::Value *optarg,
                               rapidjson::Value::AllocatorType *allocator);
 
+// Returns true if terms of this type write to a table or are meta operations.
+bool term_is_write_or_meta(Term::TermType type);
+
 } // namespace ql
 
 #endif // RDB_PROTOCOL_TERM_WALKER_HPP_
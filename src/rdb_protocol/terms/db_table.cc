@@ -7,6 +7,7 @@
 #include "clustering/administration/admin_op_exc.hpp"
 #include "clustering/administration/auth/permissions.hpp"
 #include "clustering/administration/auth/username.hpp"
+#include "clustering/administration/tables/table_metadata.hpp"
 #include "containers/name_string.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/op.hpp"
@@ -162,7 +163,7 @@ public:
         : meta_op_term_t(env, term, argspec_t(1, 2),
             optargspec_t({"primary_key", "shards", "replicas",
                           "nonvoting_replica_tags", "primary_replica_tag",
-                          "durability"})) { }
+                          "durability", "block_size"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(
             scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -189,10 +190,30 @@ private:
             primary_key = v->as_str().to_std();
         }
 
-        write_durability_t durability =
-            parse_durability_optarg(args->optarg(env, "durability")) ==
-                DURABILITY_REQUIREMENT_SOFT ?
-                    write_durability_t::SOFT : write_durability_t::HARD;
+        write_durability_t durability;
+        switch (parse_durability_optarg(args->optarg(env, "durability"))) {
+        case DURABILITY_REQUIREMENT_SOFT:
+            durability = write_durability_t::SOFT;
+            break;
+        case DURABILITY_REQUIREMENT_GROUP:
+            durability = write_durability_t::GROUP;
+            break;
+        case DURABILITY_REQUIREMENT_DEFAULT:
+        case DURABILITY_REQUIREMENT_HARD:
+        default:
+            durability = write_durability_t::HARD;
+            break;
+        }
+
+        uint32_t block_size = DEFAULT_BTREE_BLOCK_SIZE;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "block_size")) {
+            int64_t value = v->as_int();
+            rcheck_target(v, is_valid_table_block_size(value), base_exc_t::LOGIC,
+                          strprintf("`block_size` must be a power of two between "
+                                    "%lld and %lld.",
+                                    DEFAULT_BTREE_BLOCK_SIZE, MAX_BTREE_BLOCK_SIZE));
+            block_size = value;
+        }
 
         counted_t<const db_t> db;
         name_string_t tbl_name;
@@ -217,6 +238,7 @@ private:
                     config_params,
                     primary_key,
                     durability,
+                    block_size,
                     env->env->interruptor,
                     &result,
                     &error)) {
@@ -551,7 +573,8 @@ public:
     reconfigure_term_t(compile_env_t *env, const raw_term_t &term)
         : table_or_db_meta_term_t(env, term,
             optargspec_t({"dry_run", "emergency_repair", "nonvoting_replica_tags",
-                "primary_replica_tag", "replicas", "shards"})) { }
+                "primary_near_writes", "primary_replica_tag", "replicas",
+                "shards"})) { }
 private:
     scoped_ptr_t<val_t> required_optarg(scope_env_t *env,
                                         args_t *args,
@@ -602,6 +625,11 @@ private:
                                      args->optarg(env, "primary_replica_tag"),
                                      &config_params);
 
+            // Parse the 'primary_near_writes' optarg
+            if (scoped_ptr_t<val_t> v = args->optarg(env, "primary_near_writes")) {
+                config_params.primary_near_writes = v->as_bool();
+            }
+
             bool success;
             datum_t result;
             admin_err_t error;
@@ -656,6 +684,7 @@ private:
             /* Make sure none of the optargs that are used with regular reconfigurations
             are present, to avoid user confusion. */
             if (args->optarg(env, "nonvoting_replica_tags").has() ||
+                    args->optarg(env, "primary_near_writes").has() ||
                     args->optarg(env, "primary_replica_tag").has() ||
                     args->optarg(env, "replicas").has() ||
                     args->optarg(env, "shards").has()) {
@@ -697,7 +726,7 @@ private:
 class rebalance_term_t : public table_or_db_meta_term_t {
 public:
     rebalance_term_t(compile_env_t *env, const raw_term_t &term)
-        : table_or_db_meta_term_t(env, term, optargspec_t({})) { }
+        : table_or_db_meta_term_t(env, term, optargspec_t({"by"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl_on_table_or_db(
             scope_env_t *env, args_t *args, eval_flags_t,
@@ -708,6 +737,19 @@ private:
 	  rfail(base_exc_t::LOGIC, "`rebalance` can only be called on a table or database.");
         }
 
+        rebalance_mode_t mode = rebalance_mode_t::DOCUMENTS;
+        if (scoped_ptr_t<val_t> by = args->optarg(env, "by")) {
+            datum_string_t by_str = by->as_str();
+            if (by_str == "documents") {
+                mode = rebalance_mode_t::DOCUMENTS;
+            } else if (by_str == "load") {
+                mode = rebalance_mode_t::LOAD;
+            } else {
+                rfail_target(by.get(), base_exc_t::LOGIC,
+                    "`by` should be \"documents\" or \"load\".");
+            }
+        }
+
         ql::datum_t result;
         bool success;
         admin_err_t error;
@@ -717,6 +759,7 @@ private:
                     env->env->get_user_context(),
                     db,
                     *name_if_table,
+                    mode,
                     env->env->interruptor,
                     &result,
                     &error);
@@ -724,6 +767,7 @@ private:
                 success = env->env->reql_cluster_interface()->db_rebalance(
                     env->env->get_user_context(),
                     db,
+                    mode,
                     env->env->interruptor,
                     &result,
                     &error);
@@ -842,14 +886,30 @@ private:
                 read_mode = read_mode_t::SINGLE;
             } else if (str == "outdated") {
                 read_mode = read_mode_t::OUTDATED;
+            } else if (str == "bounded") {
+                read_mode = read_mode_t::BOUNDED;
             } else if (str == "_debug_direct") {
                 read_mode = read_mode_t::DEBUG_DIRECT;
             } else {
                 rfail(base_exc_t::LOGIC, "Read mode `%s` unrecognized (options "
-                      "are \"majority\", \"single\", and \"outdated\").",
+                      "are \"majority\", \"single\", \"outdated\", and "
+                      "\"bounded\").",
                       str.to_std().c_str());
             }
         }
+        if (read_mode == read_mode_t::BOUNDED) {
+            /* The bound has to be a global optarg, because only the global optargs
+            reach the reads that `real_table_t` makes for this table. */
+            rcheck(env->env->get_all_optargs().has_optarg("max_staleness_ms"),
+                   base_exc_t::LOGIC,
+                   "Read mode `bounded` requires the `max_staleness_ms` optarg "
+                   "to `run`.");
+            int64_t max_staleness_ms =
+                env->env->get_optarg(env->env, "max_staleness_ms")->as_int();
+            rcheck(max_staleness_ms >= 0, base_exc_t::LOGIC,
+                   strprintf("Illegal max_staleness_ms `%" PRIi64 "`.  "
+                             "(Must be >= 0.)", max_staleness_ms));
+        }
 
         optional<admin_identifier_format_t> identifier_format;
         if (scoped_ptr_t<val_t> v = args->optarg(env, "identifier_format")) {
@@ -886,7 +946,9 @@ private:
         return new_val(make_counted<table_t>(
             std::move(table), db, table_name.str(), read_mode, backtrace()));
     }
-    virtual deterministic_t is_deterministic() const { return deterministic_t::no(); }
+    virtual deterministic_t is_deterministic() const {
+        return deterministic_t::constant_tables();
+    }
     virtual const char *name() const { return "table"; }
 };
 
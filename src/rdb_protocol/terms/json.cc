@@ -4,7 +4,6 @@
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/terms/terms.hpp"
 #include "rapidjson/document.h"
-#include "rapidjson/error/en.h"
 #include "rapidjson/rapidjson.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
@@ -40,19 +39,18 @@ public:
             }
             str_buf[data.size()] = '\0';
 
-            rapidjson::Document json;
-            // Note: Insitu will cause some parts of `json` to directly point into
-            // `str_buf`. `str_buf`'s life time must be at least as long as `json`'s.
-            json.ParseInsitu(str_buf.data());
+            // Note: This parses in-situ, so it overwrites `str_buf`.
+            std::string error;
+            datum_t res = parse_json_insitu_to_datum(
+                str_buf.data(), env->env->limits(), &error);
 
-            rcheck(!json.HasParseError(), base_exc_t::LOGIC,
+            rcheck(res.has(), base_exc_t::LOGIC,
                    strprintf("Failed to parse \"%s\" as JSON: %s",
                        (data.size() > 40
                         ? (data.to_std().substr(0, 37) + "...").c_str()
                         : data.to_std().c_str()),
-                       rapidjson::GetParseError_En(json.GetParseError())));
-            return new_val(to_datum(json, env->env->limits(),
-                                    env->env->reql_version()));
+                       error.c_str()));
+            return new_val(std::move(res));
         }
     }
 
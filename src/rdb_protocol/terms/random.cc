@@ -33,6 +33,19 @@ public:
         counted_t<datum_stream_t> seq;
         scoped_ptr_t<val_t> v = args->arg(env, 0);
 
+        std::vector<datum_t> result;
+        // A whole table can pick its rows without reading all of them.
+        if (v->get_type().is_convertible(val_t::type_t::TABLE)) {
+            t = v->as_table();
+            if (t->get_sample(env->env, num, &result)) {
+                return new_val(make_counted<selection_t>(
+                    t,
+                    make_counted<array_datum_stream_t>(
+                        datum_t(std::move(result), env->env->limits()),
+                        backtrace())));
+            }
+        }
+
         if (v->get_type().is_convertible(val_t::type_t::SELECTION)) {
             counted_t<selection_t> t_seq = v->as_selection(env->env);
             t = t_seq->table;
@@ -41,7 +54,6 @@ public:
             seq = v->as_seq(env->env);
         }
 
-        std::vector<datum_t> result;
         result.reserve(num);
         size_t element_number = 0;
         batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
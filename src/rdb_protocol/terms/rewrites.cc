@@ -1,9 +1,14 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <iterator>
 #include <string>
+#include <vector>
 
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/datum_stream/hash_join.hpp"
 #include "rdb_protocol/error.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/op.hpp"
 #include "rdb_protocol/term_walker.hpp"
@@ -56,24 +61,28 @@ public:
         minidriver_t r(in.bt());
 
         raw_term_t left = in.arg(0);
+
+        minidriver_t::reql_t term = r.expr(left).concat_map(join_left_row(&r, in));
+
+        term.copy_optargs_from_term(in);
+        return term;
+    }
+
+    // The function that returns the joined rows of one left row.
+    static minidriver_t::reql_t join_left_row(minidriver_t *r, const raw_term_t &in) {
         raw_term_t right = in.arg(1);
         raw_term_t func = in.arg(2);
         auto n = minidriver_t::dummy_var_t::INNERJOIN_N;
         auto m = minidriver_t::dummy_var_t::INNERJOIN_M;
 
-        minidriver_t::reql_t term =
-            r.expr(left).concat_map(
-                r.fun(n,
-                    r.expr(right).concat_map(
-                        r.fun(m,
-                            r.branch(
-                                r.expr(func)(r.var(n), r.var(m)),
-                                r.array(r.object(r.optarg("left", n),
-                                                 r.optarg("right", m))),
-                                r.array())))));
-
-        term.copy_optargs_from_term(in);
-        return term;
+        return r->fun(n,
+                   r->expr(right).concat_map(
+                       r->fun(m,
+                           r->branch(
+                               r->expr(func)(r->var(n), r->var(m)),
+                               r->array(r->object(r->optarg("left", n),
+                                                  r->optarg("right", m))),
+                               r->array()))));
     }
 
     virtual const char *name() const { return "inner_join"; }
@@ -88,6 +97,15 @@ public:
         minidriver_t r(in.bt());
 
         raw_term_t left = in.arg(0);
+
+        minidriver_t::reql_t term = r.expr(left).concat_map(join_left_row(&r, in));
+
+        term.copy_optargs_from_term(in);
+        return term;
+    }
+
+    // The function that returns the joined rows of one left row.
+    static minidriver_t::reql_t join_left_row(minidriver_t *r, const raw_term_t &in) {
         raw_term_t right = in.arg(1);
         raw_term_t func = in.arg(2);
         auto n = minidriver_t::dummy_var_t::OUTERJOIN_N;
@@ -95,27 +113,154 @@ public:
         auto lst = minidriver_t::dummy_var_t::OUTERJOIN_LST;
 
         minidriver_t::reql_t inner_concat_map =
-            r.expr(right).concat_map(
-                r.fun(m,
-                    r.branch(
-                        r.expr(func)(r.var(n), r.var(m)),
-                        r.array(r.object(r.optarg("left", n),
-                                         r.optarg("right", m))),
-                        r.array())));
+            r->expr(right).concat_map(
+                r->fun(m,
+                    r->branch(
+                        r->expr(func)(r->var(n), r->var(m)),
+                        r->array(r->object(r->optarg("left", n),
+                                           r->optarg("right", m))),
+                        r->array())));
+
+        return r->fun(n,
+                   inner_concat_map.coerce_to("ARRAY").do_(lst,
+                       r->branch(r->var(lst).count() > 0,
+                                 r->var(lst),
+                                 r->array(r->object(r->optarg("left", n))))));
+    }
 
-        minidriver_t::reql_t term =
-            r.expr(left).concat_map(
-                r.fun(n,
-                    inner_concat_map.coerce_to("ARRAY").do_(lst,
-                        r.branch(r.var(lst).count() > 0,
-                                 r.var(lst),
-                                 r.array(r.object(r.optarg("left", n)))))));
+    virtual const char *name() const { return "outer_join"; }
+};
 
-        term.copy_optargs_from_term(in);
-        return term;
+// Returns true if `func` is `function(l, r) { return l(a).eq(r(b)); }` (or with the
+// sides of `eq` swapped), and sets `*left_field_out` and `*right_field_out` to `a`
+// and `b`.
+static bool is_field_equality(const raw_term_t &func,
+                              std::string *left_field_out,
+                              std::string *right_field_out) {
+    if (func.type() != Term::FUNC || func.num_args() != 2 || func.num_optargs() != 0) {
+        return false;
+    }
+    std::vector<double> vars;
+    const raw_term_t raw_vars = func.arg(0);
+    if (raw_vars.type() == Term::DATUM) {
+        datum_t d = raw_vars.datum();
+        if (d.get_type() != datum_t::R_ARRAY) return false;
+        for (size_t i = 0; i < d.arr_size(); ++i) {
+            if (d.get(i).get_type() != datum_t::R_NUM) return false;
+            vars.push_back(d.get(i).as_num());
+        }
+    } else if (raw_vars.type() == Term::MAKE_ARRAY) {
+        for (size_t i = 0; i < raw_vars.num_args(); ++i) {
+            if (raw_vars.arg(i).type() != Term::DATUM) return false;
+            datum_t d = raw_vars.arg(i).datum();
+            if (d.get_type() != datum_t::R_NUM) return false;
+            vars.push_back(d.as_num());
+        }
+    }
+    if (vars.size() != 2 || vars[0] == vars[1]) {
+        return false;
     }
 
-    virtual const char *name() const { return "outer_join"; }
+    const raw_term_t body = func.arg(1);
+    if (body.type() != Term::EQ || body.num_args() != 2 || body.num_optargs() != 0) {
+        return false;
+    }
+    std::string fields[2];
+    bool seen[2] = {false, false};
+    for (size_t i = 0; i < 2; ++i) {
+        const raw_term_t side = body.arg(i);
+        if ((side.type() != Term::GET_FIELD && side.type() != Term::BRACKET)
+            || side.num_args() != 2 || side.num_optargs() != 0) {
+            return false;
+        }
+        const raw_term_t var = side.arg(0);
+        const raw_term_t field = side.arg(1);
+        if (var.type() != Term::VAR || var.num_args() != 1
+            || var.arg(0).type() != Term::DATUM || field.type() != Term::DATUM) {
+            return false;
+        }
+        const datum_t var_num = var.arg(0).datum();
+        const datum_t field_name = field.datum();
+        if (var_num.get_type() != datum_t::R_NUM
+            || field_name.get_type() != datum_t::R_STR) {
+            return false;
+        }
+        const size_t which = var_num.as_num() == vars[0] ? 0 : 1;
+        if ((which == 1 && var_num.as_num() != vars[1]) || seen[which]) {
+            return false;
+        }
+        seen[which] = true;
+        fields[which] = field_name.as_str().to_std();
+    }
+    *left_field_out = fields[0];
+    *right_field_out = fields[1];
+    return true;
+}
+
+// An `innerJoin` or `outerJoin` on a field equality.  It reads the right sequence
+// into memory once, when the first left row needs it, and joins the left rows
+// through a hash table.  If the right sequence doesn't fit into the array size limit,
+// each left row goes through the function that the nested loop of the rewritten term
+// would call for it.  A grouped left side is joined group by group, with the right
+// side read only once.
+class hash_join_term_t : public op_term_t {
+public:
+    hash_join_term_t(compile_env_t *env, const raw_term_t &term, bool _outer,
+                     const std::string &_left_field, const std::string &_right_field)
+        : op_term_t(env, term, argspec_t(3)),
+          nested_loop_term(compile_nested_loop(env, term, _outer)),
+          outer(_outer),
+          left_field(_left_field.c_str()),
+          right_field(_right_field.c_str()) { }
+
+private:
+    static counted_t<const func_term_t> compile_nested_loop(
+            compile_env_t *env, const raw_term_t &term, bool outer) {
+        minidriver_t r(term.bt());
+        minidriver_t::reql_t func = outer
+            ? outer_join_term_t::join_left_row(&r, term)
+            : inner_join_term_t::join_left_row(&r, term);
+        return make_counted<func_term_t>(env, func.root_term());
+    }
+
+    // We handle grouped data ourselves, so that all groups share the right side.
+    virtual bool can_be_grouped() const { return false; }
+
+    virtual scoped_ptr_t<val_t> eval_impl(
+        scope_env_t *env, args_t *args, eval_flags_t) const {
+        scoped_ptr_t<val_t> left = args->arg(env, 0);
+        counted_t<hash_join_right_t> right = make_counted<hash_join_right_t>(
+            args->arg(env, 1)->as_seq(env->env), right_field);
+        counted_t<const func_t> predicate = args->arg(env, 2)->as_func();
+        counted_t<const func_t> nested_loop =
+            nested_loop_term->eval_to_func(env->scope);
+        auto join = [&](counted_t<datum_stream_t> left_stream) {
+            return make_counted<hash_join_datum_stream_t>(
+                std::move(left_stream), right, left_field, predicate, nested_loop,
+                outer, backtrace());
+        };
+
+        counted_t<grouped_data_t> groups =
+            left->maybe_as_promiscuous_grouped_data(env->env);
+        if (!groups.has()) {
+            return new_val(env->env, join(left->as_seq(env->env)));
+        }
+        counted_t<grouped_data_t> out(new grouped_data_t());
+        for (auto kv = groups->begin(); kv != groups->end(); ++kv) {
+            counted_t<datum_stream_t> group =
+                make_scoped<val_t>(kv->second, backtrace())->as_seq(env->env);
+            (*out)[kv->first] = join(std::move(group))->to_array(env->env)->as_datum();
+        }
+        return make_scoped<val_t>(out, backtrace());
+    }
+    virtual const char *name() const {
+        return outer ? "outer_join" : "inner_join";
+    }
+
+    counted_t<const func_term_t> nested_loop_term;
+    bool outer;
+    datum_string_t left_field;
+    datum_string_t right_field;
 };
 
 class delete_term_t : public rewrite_term_t {
@@ -236,10 +381,22 @@ counted_t<term_t> make_skip_term(
 }
 counted_t<term_t> make_inner_join_term(
         compile_env_t *env, const raw_term_t &term) {
+    std::string left_field, right_field;
+    if (term.num_optargs() == 0
+        && is_field_equality(term.arg(2), &left_field, &right_field)) {
+        return make_counted<hash_join_term_t>(
+            env, term, false, left_field, right_field);
+    }
     return make_counted<inner_join_term_t>(env, term);
 }
 counted_t<term_t> make_outer_join_term(
         compile_env_t *env, const raw_term_t &term) {
+    std::string left_field, right_field;
+    if (term.num_optargs() == 0
+        && is_field_equality(term.arg(2), &left_field, &right_field)) {
+        return make_counted<hash_join_term_t>(
+            env, term, true, left_field, right_field);
+    }
     return make_counted<outer_join_term_t>(env, term);
 }
 counted_t<term_t> make_update_term(
@@ -83,6 +83,40 @@ public:
 private:
     virtual const char *name() const { return "avg"; }
 };
+class approx_count_distinct_term_t
+    : public unindexable_map_acc_term_t<approx_count_distinct_wire_func_t> {
+public:
+    template<class... Args> approx_count_distinct_term_t(Args... args)
+        : unindexable_map_acc_term_t<approx_count_distinct_wire_func_t>(args...) { }
+private:
+    virtual const char *name() const { return "approx_count_distinct"; }
+};
+
+class approx_quantile_term_t : public grouped_seq_op_term_t {
+public:
+    approx_quantile_term_t(compile_env_t *env, const raw_term_t &term)
+        : grouped_seq_op_term_t(env, term, argspec_t(2, 3)) { }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args,
+                                          eval_flags_t) const {
+        scoped_ptr_t<val_t> v = args->arg(env, 0);
+        scoped_ptr_t<val_t> q_val = args->arg(env, 1);
+        double q = q_val->as_num();
+        rcheck_target(q_val, q >= 0 && q <= 1, base_exc_t::LOGIC,
+                      strprintf("Quantile must be between 0 and 1 (got %s).",
+                                q_val->as_datum().print().c_str()));
+        if (args->num_args() == 3) {
+            counted_t<const func_t> func
+                = args->arg(env, 2)->as_func(GET_FIELD_SHORTCUT);
+            return v->as_seq(env->env)->run_terminal(
+                env->env, approx_quantile_wire_func_t(q, backtrace(), func));
+        } else {
+            return v->as_seq(env->env)->run_terminal(
+                env->env, approx_quantile_wire_func_t(q, backtrace()));
+        }
+    }
+    virtual const char *name() const { return "approx_quantile"; }
+};
 
 template<class T>
 class indexable_map_acc_term_t : public map_acc_term_t<T> {
@@ -536,6 +570,7 @@ public:
             env, term, argspec_t(1),
             optargspec_t({"squash",
                           "changefeed_queue_size",
+                          "spill_to_disk",
                           "include_initial",
                           "include_offsets",
                           "include_states",
@@ -576,6 +611,11 @@ private:
             include_offsets = v->as_bool();
         }
 
+        bool spill_to_disk = false;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "spill_to_disk")) {
+            spill_to_disk = v->as_bool();
+        }
+
         scoped_ptr_t<val_t> v = args->arg(env, 0);
         configured_limits_t limits = env->env->limits_with_changefeed_queue_size(
                 args->optarg(env, "changefeed_queue_size"));
@@ -603,6 +643,7 @@ private:
                             include_types,
                             limits,
                             squash,
+                            spill_to_disk,
                             std::move(changespec.keyspec.spec)),
                         backtrace()));
             }
@@ -637,6 +678,7 @@ private:
                         include_types,
                         limits,
                         squash,
+                        spill_to_disk,
                         sel->get_spec()),
                     sel->get_bt()));
         }
@@ -935,6 +977,16 @@ counted_t<term_t> make_sum_term(
     return make_counted<sum_term_t>(env, term);
 }
 
+counted_t<term_t> make_approx_count_distinct_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<approx_count_distinct_term_t>(env, term);
+}
+
+counted_t<term_t> make_approx_quantile_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<approx_quantile_term_t>(env, term);
+}
+
 counted_t<term_t> make_min_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<min_term_t>(env, term);
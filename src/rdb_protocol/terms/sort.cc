@@ -1,17 +1,26 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
+#include "containers/optional.hpp"
+#include "containers/uuid.hpp"
+#include "perfmon/core.hpp"
+#include "rdb_protocol/context.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/datum_stream/array.hpp"
+#include "rdb_protocol/datum_stream/external_sort.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
+#include "rdb_protocol/env.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/op.hpp"
 #include "rdb_protocol/order_util.hpp"
+#include "rdb_protocol/query_memory.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/term_walker.hpp"
 
 namespace ql {
@@ -51,9 +60,13 @@ public:
     orderby_term_t(compile_env_t *env, const raw_term_t &term)
         : op_term_t(env, term, argspec_t(1, -1),
           optargspec_t({"index"})) { }
-private:
-    virtual scoped_ptr_t<val_t>
-    eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
+
+protected:
+    // If `top_k` is set, the caller only looks at the first `*top_k` rows, so an
+    // unindexed sort only keeps that many rows in memory.
+    scoped_ptr_t<val_t> eval_orderby(scope_env_t *env,
+                                     args_t *args,
+                                     optional<size_t> top_k) const {
         std::vector<std::pair<order_direction_t, counted_t<const func_t> > > comparisons
             = build_comparisons_from_raw_term(this, env, args, get_src());
         raw_term_t raw_term = get_src();
@@ -105,7 +118,23 @@ private:
             }
             rcheck(!comparisons.empty(), base_exc_t::LOGIC,
                    "Must specify something to order by.");
+            if (top_k) {
+                seq = make_counted<array_datum_stream_t>(
+                    sort_top_k(env, seq, lt_cmp, *top_k), backtrace());
+                return tbl_slice.has()
+                    ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
+                    : new_val(env->env, seq);
+            }
+            // If the rows don't fit into the array size limit or the query memory
+            // limit and we have a data directory, we write sorted runs of them to
+            // disk and merge those.
+            rdb_context_t *rdb_ctx = env->env->get_rdb_ctx();
+            const bool can_spill =
+                rdb_ctx != nullptr && rdb_ctx->io_backender != nullptr;
+            std::vector<scoped_ptr_t<disk_backed_queue_t<datum_t> > > runs;
             std::vector<datum_t> to_sort;
+            query_memory_reservation_t reservation;
+            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
             batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
             for (;;) {
                 std::vector<datum_t> data
@@ -113,15 +142,46 @@ private:
                 if (data.size() == 0) {
                     break;
                 }
+                size_t data_bytes = 0;
+                for (const datum_t &d : data) {
+                    data_bytes += datum_serialized_size(
+                        d, check_datum_serialization_errors_t::NO);
+                }
                 std::move(data.begin(), data.end(), std::back_inserter(to_sort));
-                rcheck_array_size(to_sort, env->env->limits());
+                const bool fits_memory = reservation.add(data_bytes);
+                if (!can_spill) {
+                    rcheck_array_size(to_sort, env->env->limits());
+                    rcheck(fits_memory, base_exc_t::RESOURCE,
+                           format_query_memory_error());
+                } else if (!fits_memory && reservation.bytes() == 0) {
+                    // Spilling only helps if we're holding some of the memory.
+                    rfail(base_exc_t::RESOURCE, "%s",
+                          format_query_memory_error().c_str());
+                } else if (!fits_memory
+                           || to_sort.size() >= env->env->limits().array_size_limit()) {
+                    lt_cmp.stable_sort(env->env, &sampler, &to_sort);
+                    runs.push_back(make_scoped<disk_backed_queue_t<datum_t> >(
+                        rdb_ctx->io_backender,
+                        serializer_filepath_t(
+                            rdb_ctx->base_path,
+                            "orderby_run_" + uuid_to_str(generate_uuid())),
+                        &get_global_perfmon_collection()));
+                    for (const datum_t &d : to_sort) {
+                        runs.back()->push(d);
+                    }
+                    to_sort.clear();
+                    reservation.reset();
+                }
+            }
+            lt_cmp.stable_sort(env->env, &sampler, &to_sort);
+            if (runs.empty()) {
+                seq = make_counted<array_datum_stream_t>(
+                    datum_t(std::move(to_sort), env->env->limits()),
+                    backtrace());
+            } else {
+                seq = make_counted<external_sort_datum_stream_t>(
+                    std::move(runs), std::move(to_sort), lt_cmp, backtrace());
             }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = std::bind(lt_cmp, env->env, &sampler, ph::_1, ph::_2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
-                backtrace());
         }
         return tbl_slice.has()
             ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
@@ -129,6 +189,107 @@ private:
     }
 
     virtual const char *name() const { return "orderby"; }
+
+private:
+    virtual scoped_ptr_t<val_t>
+    eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
+        return eval_orderby(env, args, optional<size_t>());
+    }
+
+    // Returns the first `k` rows of `seq` in sorted order, keeping the greatest of
+    // them at the top of a heap.  Rows that compare equal keep their order, like
+    // they do with `std::stable_sort`.
+    datum_t sort_top_k(scope_env_t *env,
+                       const counted_t<datum_stream_t> &seq,
+                       const lt_cmp_t &lt_cmp,
+                       size_t k) const {
+        profile::sampler_t sampler("Sorting the first rows in-memory.",
+                                   env->env->trace);
+        // The second element is the row's position in `seq`.
+        typedef std::pair<datum_t, size_t> row_t;
+        auto before = [&](const row_t &a, const row_t &b) {
+            if (lt_cmp(env->env, &sampler, a.first, b.first)) {
+                return true;
+            } else if (lt_cmp(env->env, &sampler, b.first, a.first)) {
+                return false;
+            }
+            return a.second < b.second;
+        };
+        std::vector<row_t> heap;
+        size_t position = 0;
+        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
+        for (;;) {
+            std::vector<datum_t> data = seq->next_batch(env->env, batchspec);
+            if (data.size() == 0) {
+                break;
+            }
+            for (auto &&d : data) {
+                row_t row(std::move(d), position++);
+                if (heap.size() < k) {
+                    heap.push_back(std::move(row));
+                    std::push_heap(heap.begin(), heap.end(), before);
+                } else if (k != 0 && before(row, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), before);
+                    heap.back() = std::move(row);
+                    std::push_heap(heap.begin(), heap.end(), before);
+                }
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), before);
+        std::vector<datum_t> sorted;
+        sorted.reserve(heap.size());
+        for (auto &&row : heap) {
+            sorted.push_back(std::move(row.first));
+        }
+        return datum_t(std::move(sorted), env->env->limits());
+    }
+};
+
+// `orderBy(...).limit(n)` without an index.  Instead of sorting all of the rows and
+// then throwing most of them away, we only keep the first `n` rows while sorting.
+class orderby_limit_term_t : public orderby_term_t {
+public:
+    orderby_limit_term_t(compile_env_t *env, const raw_term_t &limit_term)
+        : orderby_term_t(env, limit_term.arg(0)),
+          limit_arg(compile_term(env, limit_term.arg(1))) { }
+
+    virtual void accumulate_captures(var_captures_t *captures) const {
+        orderby_term_t::accumulate_captures(captures);
+        limit_arg->accumulate_captures(captures);
+    }
+    virtual deterministic_t is_deterministic() const {
+        return orderby_term_t::is_deterministic().join(limit_arg->is_deterministic());
+    }
+
+private:
+    virtual scoped_ptr_t<val_t>
+    eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
+        // We need the limit before we sort, so unlike `limit_term_t` we evaluate it
+        // first.
+        int32_t r = limit_arg->eval(env)->as_int<int32_t>();
+        rcheck_target(limit_arg.get(), r >= 0, base_exc_t::LOGIC,
+                      strprintf("LIMIT takes a non-negative argument (got %d)", r));
+        optional<size_t> top_k;
+        if (static_cast<size_t>(r) <= env->env->limits().array_size_limit()) {
+            top_k.set(r);
+        }
+        scoped_ptr_t<val_t> v = eval_orderby(env, args, top_k);
+        counted_t<table_t> t;
+        counted_t<datum_stream_t> ds;
+        if (v->get_type().is_convertible(val_t::type_t::SELECTION)) {
+            auto selection = v->as_selection(env->env);
+            t = selection->table;
+            ds = selection->seq;
+        } else {
+            ds = v->as_seq(env->env);
+        }
+        counted_t<datum_stream_t> new_ds = ds->slice(0, r);
+        return t.has()
+            ? new_val(make_counted<selection_t>(t, new_ds))
+            : new_val(env->env, new_ds);
+    }
+
+    counted_t<const term_t> limit_arg;
 };
 
 class distinct_term_t : public op_term_t {
@@ -166,23 +327,66 @@ private:
         rcheck(!idx, base_exc_t::LOGIC,
                "Can only perform an indexed distinct on a TABLE.");
         counted_t<datum_stream_t> s = v->as_seq(env->env);
+        // Like in `orderBy`, if the distinct values don't fit into the array size
+        // limit or the query memory limit and we have a data directory, we write
+        // sorted runs of them to disk.  Merging the runs brings the duplicates
+        // from different runs next to each other.
+        rdb_context_t *rdb_ctx = env->env->get_rdb_ctx();
+        const bool can_spill =
+            rdb_ctx != nullptr && rdb_ctx->io_backender != nullptr;
+        std::vector<scoped_ptr_t<disk_backed_queue_t<datum_t> > > runs;
         // The reql_version matters here, because we copy `results` into `toret`
         // in ascending order.
         std::set<datum_t, optional_datum_less_t> results;
+        query_memory_reservation_t reservation;
         batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
         {
             profile::sampler_t sampler("Evaluating elements in distinct.",
                                        env->env->trace);
             datum_t d;
             while (d = s->next(env->env, batchspec), d.has()) {
-                results.insert(std::move(d));
-                rcheck_array_size(results, env->env->limits());
+                const size_t d_bytes = datum_serialized_size(
+                    d, check_datum_serialization_errors_t::NO);
+                if (results.insert(std::move(d)).second) {
+                    const bool fits_memory = reservation.add(d_bytes);
+                    if (!can_spill) {
+                        rcheck_array_size(results, env->env->limits());
+                        rcheck(fits_memory, base_exc_t::RESOURCE,
+                               format_query_memory_error());
+                    } else if (!fits_memory && reservation.bytes() == 0) {
+                        rfail(base_exc_t::RESOURCE, "%s",
+                              format_query_memory_error().c_str());
+                    } else if (!fits_memory
+                               || results.size()
+                                  >= env->env->limits().array_size_limit()) {
+                        runs.push_back(make_scoped<disk_backed_queue_t<datum_t> >(
+                            rdb_ctx->io_backender,
+                            serializer_filepath_t(
+                                rdb_ctx->base_path,
+                                "distinct_run_" + uuid_to_str(generate_uuid())),
+                            &get_global_perfmon_collection()));
+                        for (const datum_t &el : results) {
+                            runs.back()->push(el);
+                        }
+                        results.clear();
+                        reservation.reset();
+                    }
+                }
                 sampler.new_sample();
             }
         }
         std::vector<datum_t> toret;
         std::move(results.begin(), results.end(), std::back_inserter(toret));
-        return new_val(datum_t(std::move(toret), env->env->limits()));
+        if (runs.empty()) {
+            return new_val(datum_t(std::move(toret), env->env->limits()));
+        }
+        counted_t<datum_stream_t> merged = make_counted<external_sort_datum_stream_t>(
+            std::move(runs), std::move(toret),
+            [](env_t *, profile::sampler_t *, const datum_t &a, const datum_t &b) {
+                return optional_datum_less_t()(a, b);
+            },
+            backtrace());
+        return new_val(env->env, merged->ordered_distinct());
     }
 
     virtual const char *name() const { return "distinct"; }
@@ -192,6 +396,20 @@ counted_t<term_t> make_orderby_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<orderby_term_t>(env, term);
 }
+bool is_unindexed_orderby_limit(const raw_term_t &limit_term) {
+    // `r.args` could hide the real arguments, and a stray optarg has to be reported
+    // by `limit_term_t`.
+    if (limit_term.num_args() != 2 || limit_term.num_optargs() != 0
+        || limit_term.arg(1).type() == Term::ARGS) {
+        return false;
+    }
+    raw_term_t orderby = limit_term.arg(0);
+    return orderby.type() == Term::ORDER_BY && !orderby.optarg("index");
+}
+counted_t<term_t> make_orderby_limit_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<orderby_limit_term_t>(env, term);
+}
 counted_t<term_t> make_distinct_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<distinct_term_t>(env, term);
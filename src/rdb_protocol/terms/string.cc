@@ -8,6 +8,7 @@
 #include "parsing/utf8.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/op.hpp"
+#include "rdb_protocol/regex_cache.hpp"
 
 namespace ql {
 
@@ -58,16 +59,26 @@ static bool is_whitespace_character(char32_t c) {
 class match_term_t : public op_term_t {
 public:
     match_term_t(compile_env_t *env, const raw_term_t &term)
-        : op_term_t(env, term, argspec_t(2)) { }
+        : op_term_t(env, term, argspec_t(2)) {
+        // Most patterns are constants, which we compile here instead of on every
+        // evaluation.  If the pattern doesn't compile, `eval_impl` reports it.
+        if (term.num_args() == 2 && term.arg(1).type() == Term::DATUM) {
+            const datum_t pattern = term.arg(1).datum();
+            if (pattern.get_type() == datum_t::R_STR) {
+                std::shared_ptr<const re2::RE2> regexp =
+                    get_cached_regex(pattern.as_str().to_std());
+                if (regexp->ok()) {
+                    constant_regexp = std::move(regexp);
+                }
+            }
+        }
+    }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         std::string str = args->arg(env, 0)->as_str().to_std();
-        std::string re = args->arg(env, 1)->as_str().to_std();
-        std::shared_ptr<re2::RE2> regexp;
-        regex_cache_t &cache = env->env->regex_cache();
-        std::shared_ptr<re2::RE2> *found;
-        if (!cache.regexes.lookup(re, &found)) {
-            regexp.reset(new re2::RE2(re, re2::RE2::Quiet));
+        std::shared_ptr<const re2::RE2> regexp = constant_regexp;
+        if (!regexp) {
+            regexp = get_cached_regex(args->arg(env, 1)->as_str().to_std());
             if (!regexp->ok()) {
                 rfail(base_exc_t::LOGIC,
                       "Error in regexp `%s` (portion `%s`): %s",
@@ -75,9 +86,6 @@ private:
                       regexp->error_arg().c_str(),
                       regexp->error().c_str());
             }
-            cache.regexes.insert(re, regexp);
-        } else {
-            regexp = *found;
         }
         r_sanity_check(static_cast<bool>(regexp));
         // We add 1 to account for $0.
@@ -123,6 +131,9 @@ private:
         }
     }
     virtual const char *name() const { return "match"; }
+
+    // Empty unless the pattern is a constant that compiles.
+    std::shared_ptr<const re2::RE2> constant_regexp;
 };
 
 template <typename It>
@@ -271,6 +271,10 @@ counted_t<term_t> make_sum_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_avg_term(
     compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_approx_count_distinct_term(
+    compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_approx_quantile_term(
+    compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_min_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_max_term(
@@ -305,6 +309,10 @@ counted_t<term_t> make_sindex_rename_term(
 // sort.cc
 counted_t<term_t> make_orderby_term(
     compile_env_t *env, const raw_term_t &term);
+// Whether `limit_term` is a `limit` right after an `orderBy` without an index.
+bool is_unindexed_orderby_limit(const raw_term_t &limit_term);
+counted_t<term_t> make_orderby_limit_term(
+    compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_distinct_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_asc_term(
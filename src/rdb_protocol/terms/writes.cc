@@ -52,10 +52,11 @@ durability_requirement_t parse_durability_optarg(const scoped_ptr_t<val_t> &arg)
     const datum_string_t &str = arg->as_str();
     if (str == "hard") { return DURABILITY_REQUIREMENT_HARD; }
     if (str == "soft") { return DURABILITY_REQUIREMENT_SOFT; }
+    if (str == "group") { return DURABILITY_REQUIREMENT_GROUP; }
     rfail_target(arg.get(),
                  base_exc_t::LOGIC,
                  "Durability option `%s` unrecognized "
-                 "(options are \"hard\" and \"soft\").",
+                 "(options are \"hard\", \"soft\" and \"group\").",
                  str.to_std().c_str());
 }
 
@@ -55,6 +55,8 @@ public:
             dist_unit_t dist_unit,
             const std::string &new_sindex_id,
             const configured_limits_t &limits);
+    // See `base_table_t::read_sample()`.
+    MUST_USE bool get_sample(env_t *env, size_t n, std::vector<datum_t> *rows_out);
 
     scoped_ptr_t<reader_t> get_all_with_sindexes(
         env_t *env,
@@ -197,5 +197,7 @@ deserialize<cluster_version_t::v2_3>(read_stream_t *s, var_scope_t *);
 template archive_result_t
 deserialize<cluster_version_t::v2_4>(read_stream_t *s, var_scope_t *);
 template archive_result_t
-deserialize<cluster_version_t::v2_5_is_latest>(read_stream_t *s, var_scope_t *);
+deserialize<cluster_version_t::v2_5>(read_stream_t *s, var_scope_t *);
+template archive_result_t
+deserialize<cluster_version_t::v2_6_is_latest>(read_stream_t *s, var_scope_t *);
 }  // namespace ql
@@ -23,7 +23,8 @@ wire_func_t::wire_func_t(const raw_term_t &body,
                          std::vector<sym_t> arg_names) {
     compile_env_t env(var_visibility_t().with_func_arg_name_list(arg_names));
     func = make_counted<reql_func_t>(var_scope_t(),
-                                     arg_names, compile_term(&env, body));
+                                     arg_names, compile_term(&env, body),
+                                     compiled_func_t::compile(arg_names, body));
 }
 
 wire_func_t::wire_func_t(const wire_func_t &copyee)
@@ -127,9 +128,12 @@ archive_result_t deserialize(read_stream_t *s, wire_func_t *wf) {
         compile_env_t env(scope.compute_visibility().with_func_arg_name_list(arg_names));
         counted_t<const term_t> term_tree =
             compile_term(&env, term_storage->root_term());
+        counted_t<const compiled_func_t> compiled =
+            compiled_func_t::compile(arg_names, term_storage->root_term());
         wf->func = make_counted<reql_func_t>(std::move(term_storage),
                                              scope, arg_names,
-                                             std::move(term_tree));
+                                             std::move(term_tree),
+                                             std::move(compiled));
         return res;
     }
     case wire_func_type_t::JS: {
@@ -192,9 +196,12 @@ archive_result_t deserialize_wire_func(
         compile_env_t env(scope.compute_visibility().with_func_arg_name_list(arg_names));
         counted_t<const term_t> term_tree =
             compile_term(&env, term_storage->root_term());
+        counted_t<const compiled_func_t> compiled =
+            compiled_func_t::compile(arg_names, term_storage->root_term());
         wf->func = make_counted<reql_func_t>(std::move(term_storage),
                                              scope, arg_names,
-                                             std::move(term_tree));
+                                             std::move(term_tree),
+                                             std::move(compiled));
         return res;
     }
     case wire_func_type_t::JS: {
@@ -243,9 +250,15 @@ archive_result_t deserialize<cluster_version_t::v2_4>(
 }
 
 template <>
-archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(
+archive_result_t deserialize<cluster_version_t::v2_5>(
         read_stream_t *s, wire_func_t *wf) {
-    return deserialize_wire_func<cluster_version_t::v2_5_is_latest>(s, wf);
+    return deserialize_wire_func<cluster_version_t::v2_5>(s, wf);
+}
+
+template <>
+archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(
+        read_stream_t *s, wire_func_t *wf) {
+    return deserialize_wire_func<cluster_version_t::v2_6_is_latest>(s, wf);
 }
 
 template <cluster_version_t W>
@@ -324,4 +337,20 @@ RDB_IMPL_SERIALIZABLE_2_SINCE_v1_13(filter_wire_func_t, filter_func, default_fil
 
 RDB_MAKE_SERIALIZABLE_1_FOR_CLUSTER(distinct_wire_func_t, use_index);
 
+template <>
+void serialize<cluster_version_t::CLUSTER>(
+        write_message_t *wm, const approx_quantile_wire_func_t &wf) {
+    serialize<cluster_version_t::CLUSTER>(
+        wm, static_cast<const maybe_wire_func_t &>(wf));
+    serialize<cluster_version_t::CLUSTER>(wm, wf.quantile);
+}
+template <>
+archive_result_t deserialize<cluster_version_t::CLUSTER>(
+        read_stream_t *s, approx_quantile_wire_func_t *wf) {
+    archive_result_t res = deserialize<cluster_version_t::CLUSTER>(
+        s, static_cast<maybe_wire_func_t *>(wf));
+    if (bad(res)) { return res; }
+    return deserialize<cluster_version_t::CLUSTER>(s, &wf->quantile);
+}
+
 }  // namespace ql
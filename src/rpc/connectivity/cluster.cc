@@ -4,9 +4,11 @@
 #ifndef _WIN32
 #include <netinet/in.h>
 #endif
+#include <zlib.h>
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 
 #include "arch/io/network.hpp"
 #include "arch/timing.hpp"
@@ -29,11 +31,11 @@
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           16
 
 // The cluster communication protocol version.
-static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_5_is_latest,
+static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_6_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
 
-#define CLUSTER_VERSION_STRING "2.5.0"
+#define CLUSTER_VERSION_STRING "2.6.0"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
@@ -133,7 +135,8 @@ connectivity_cluster_t::connection_t::connection_t(
         const peer_id_t &_peer_id,
         const server_id_t &_server_id,
         keepalive_tcp_conn_stream_t *_conn,
-        const peer_address_t &_peer_address) THROWS_NOTHING :
+        const peer_address_t &_peer_address,
+        bool _compress_messages) THROWS_NOTHING :
     conn(_conn),
     peer_address(_peer_address),
     flusher([&](signal_t *) {
@@ -145,13 +148,20 @@ connectivity_cluster_t::connection_t::connection_t(
         // must be handled elsewhere.
         this->conn->flush_buffer();
     }, 1),
+    compress_messages(_compress_messages),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
+    pm_compressed_bytes_in(secs_to_ticks(1), true),
+    pm_compressed_bytes_out(secs_to_ticks(1), true),
     pm_collection_membership(
         &_parent->parent->connectivity_collection,
         &pm_collection,
         uuid_to_str(_peer_id.get_uuid())),
     pm_bytes_sent_membership(&pm_collection, &pm_bytes_sent, "bytes_sent"),
+    pm_compressed_bytes_in_membership(
+        &pm_collection, &pm_compressed_bytes_in, "compressed_bytes_in"),
+    pm_compressed_bytes_out_membership(
+        &pm_collection, &pm_compressed_bytes_out, "compressed_bytes_out"),
     parent(_parent),
     peer_id(_peer_id),
     server_id(_server_id),
@@ -221,11 +231,13 @@ connectivity_cluster_t::run_t::run_t(
             _heartbeat_sl_view,
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t> >
             _auth_sl_view,
-        tls_ctx_t *_tls_ctx)
+        tls_ctx_t *_tls_ctx,
+        bool _compress_messages)
         THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t) :
     parent(_parent),
     server_id(_server_id),
     tls_ctx(_tls_ctx),
+    compress_messages(_compress_messages),
 
     /* Create the socket to use when listening for connections from peers */
     cluster_listener_socket(new tcp_bound_socket_t(local_addresses, port)),
@@ -257,7 +269,8 @@ connectivity_cluster_t::run_t::run_t(
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me]),
+    connection_to_ourself(
+        this, parent->me, _server_id, nullptr, routing_table[parent->me], false),
 
     heartbeat_sl_view(_heartbeat_sl_view),
     auth_sl_view(_auth_sl_view),
@@ -736,8 +749,10 @@ enum class handshake_result_code_t {
 class handshake_result_t {
 public:
     handshake_result_t() { }
-    static handshake_result_t success() {
-        return handshake_result_t(handshake_result_code_t::SUCCESS);
+    /* Older versions ignore `additional_info` on success, so we use it to tell the
+    other side which optional features we want. See `message_compression_feature`. */
+    static handshake_result_t success(const std::string &features) {
+        return handshake_result_t(handshake_result_code_t::SUCCESS, features);
     }
     static handshake_result_t error(handshake_result_code_t error_code,
                                     const std::string &additional_info) {
@@ -748,6 +763,10 @@ public:
         return code;
     }
 
+    const std::string &get_additional_info() const {
+        return additional_info;
+    }
+
     std::string get_error_reason() const {
         if (code == handshake_result_code_t::UNKNOWN_ERROR) {
             return error_code_string + " (" + additional_info + ")";
@@ -782,12 +801,9 @@ private:
                        const std::string &_additional_info)
         : code(_error_code), additional_info(_additional_info) {
         guarantee(code != handshake_result_code_t::UNKNOWN_ERROR);
-        guarantee(code != handshake_result_code_t::SUCCESS);
-        error_code_string = get_code_as_string();
-    }
-    explicit handshake_result_t(handshake_result_code_t _success)
-        : code(_success) {
-        guarantee(code == handshake_result_code_t::SUCCESS);
+        if (code != handshake_result_code_t::SUCCESS) {
+            error_code_string = get_code_as_string();
+        }
     }
 
     friend void serialize_universal(write_message_t *, const handshake_result_t &);
@@ -834,6 +850,72 @@ archive_result_t deserialize_universal(read_stream_t *s, handshake_result_t *out
     return res;
 }
 
+/* The feature that we send in the handshake if we want large messages to be compressed.
+If there are ever more of them, they go into a comma-separated list. */
+static const char *const message_compression_feature = "zlib";
+
+static bool has_feature(const std::string &features, const std::string &feature) {
+    for (const std::string &f : split_string(features, ',')) {
+        if (f == feature) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Compresses `data` into `out` for a message with `compressed_tag`. Returns `false` if
+that wouldn't make it any smaller. */
+static bool compress_message(const std::vector<char> &data, std::vector<char> *out) {
+    uLongf size = compressBound(data.size());
+    out->resize(size);
+    int res = compress2(reinterpret_cast<Bytef *>(out->data()), &size,
+                        reinterpret_cast<const Bytef *>(data.data()), data.size(),
+                        Z_BEST_SPEED);
+    guarantee(res == Z_OK, "compress2() failed with error %d", res);
+    if (size >= data.size()) {
+        return false;
+    }
+    out->resize(size);
+    return true;
+}
+
+/* Reads the rest of a message with `compressed_tag` from `conn`. Returns the tag of the
+original message and stores its data in `data_out`. Throws `fake_archive_exc_t` if the
+data is invalid. */
+static connectivity_cluster_t::message_tag_t read_compressed_message(
+        read_stream_t *conn, std::vector<char> *data_out) {
+    connectivity_cluster_t::message_tag_t tag;
+    uint64_t size, compressed_size;
+    if (bad(deserialize_universal(conn, &tag))
+        || bad(deserialize_universal(conn, &size))
+        || bad(deserialize_universal(conn, &compressed_size))) {
+        throw fake_archive_exc_t();
+    }
+    /* zlib can't compress data by more than a factor of about 1032, so a bigger size
+    can only come from a broken peer. We don't want to allocate memory for it. */
+    if (tag == connectivity_cluster_t::heartbeat_tag
+        || tag == connectivity_cluster_t::compressed_tag
+        || compressed_size == 0
+        || compressed_size > std::numeric_limits<uint32_t>::max()
+        || size > compressed_size * 1032) {
+        throw fake_archive_exc_t();
+    }
+    std::vector<char> compressed(compressed_size);
+    if (force_read(conn, compressed.data(), compressed_size)
+        != static_cast<int64_t>(compressed_size)) {
+        throw fake_archive_exc_t();
+    }
+    data_out->resize(size);
+    uLongf out_size = size;
+    int res = uncompress(reinterpret_cast<Bytef *>(data_out->data()), &out_size,
+                         reinterpret_cast<const Bytef *>(compressed.data()),
+                         compressed_size);
+    if (res != Z_OK || out_size != size) {
+        throw fake_archive_exc_t();
+    }
+    return tag;
+}
+
 void fail_handshake(keepalive_tcp_conn_stream_t *conn,
                     const char *peername,
                     const handshake_result_t &reason,
@@ -1072,10 +1154,12 @@ join_result_t connectivity_cluster_t::run_t::handle(
         return join_result_t::TEMPORARY_ERROR;
     }
 
+    bool peer_wants_compression = false;
     {
         // Tell the other node that we are happy to connect with it
         write_message_t wm;
-        serialize_universal(&wm, handshake_result_t::success());
+        serialize_universal(&wm, handshake_result_t::success(
+            compress_messages ? message_compression_feature : ""));
         if (send_write_message(conn, &wm)) {
             return join_result_t::TEMPORARY_ERROR; // network error.
         }
@@ -1094,6 +1178,9 @@ join_result_t connectivity_cluster_t::run_t::handle(
                 return join_result_t::TEMPORARY_ERROR;
             return join_result_t::PERMANENT_ERROR;
         }
+        peer_wants_compression =
+            has_feature(handshake_result.get_additional_info(),
+                        message_compression_feature);
     }
 
     // Look up the ip addresses for the other host
@@ -1317,7 +1404,8 @@ join_result_t connectivity_cluster_t::run_t::handle(
         constructor registers it in the `connectivity_cluster_t`'s connection
         map. */
         connection_t conn_structure(
-            this, other_id, remote_server_id, conn, *other_peer_addr.get());
+            this, other_id, remote_server_id, conn, *other_peer_addr.get(),
+            compress_messages && peer_wants_compression);
 
         /* `heartbeat_manager` will periodically send a heartbeat message to
         other servers, and it will also close the connection if we don't
@@ -1342,6 +1430,14 @@ join_result_t connectivity_cluster_t::run_t::handle(
                 `keepalive_tcp_conn_stream_t` will have already notified the
                 `heartbeat_manager_t` as soon as the heartbeat arrived. */
                 if (tag != heartbeat_tag) {
+                    /* A compressed message carries the tag and the data of the
+                    original message. */
+                    const bool compressed = tag == compressed_tag;
+                    std::vector<char> uncompressed;
+                    if (compressed) {
+                        tag = read_compressed_message(conn, &uncompressed);
+                    }
+
                     cluster_message_handler_t *handler = parent->message_handlers[tag];
                     guarantee(handler != nullptr, "Got a message for an unfamiliar tag. "
                         "Apparently we aren't compatible with the cluster on the other "
@@ -1350,10 +1446,18 @@ join_result_t connectivity_cluster_t::run_t::handle(
                     /* If you really want to support old cluster versions, the
                     resolved_version should be passed into the on_message() handler. */
                     guarantee(resolved_version == cluster_version_t::CLUSTER);
-                    handler->on_message(
-                        &conn_structure,
-                        auto_drainer_t::lock_t(conn_structure.drainers.get()),
-                        conn); // might raise fake_archive_exc_t
+                    if (compressed) {
+                        vector_read_stream_t stream(std::move(uncompressed));
+                        handler->on_message(
+                            &conn_structure,
+                            auto_drainer_t::lock_t(conn_structure.drainers.get()),
+                            &stream); // might raise fake_archive_exc_t
+                    } else {
+                        handler->on_message(
+                            &conn_structure,
+                            auto_drainer_t::lock_t(conn_structure.drainers.get()),
+                            conn); // might raise fake_archive_exc_t
+                    }
                 }
 
                 ++messages_handled_since_yield;
@@ -1526,16 +1630,40 @@ void connectivity_cluster_t::send_message(connection_t *connection,
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
+        /* We compress on our own thread rather than the connection's, so that one
+        thread doesn't have to compress everything that goes to this peer. */
+        std::vector<char> compressed;
+        const bool compress = connection->compress_messages
+            && bytes_sent >= compress_message_size
+            && compress_message(buffer.vector(), &compressed);
+        if (compress) {
+            connection->pm_compressed_bytes_in.record(bytes_sent);
+            connection->pm_compressed_bytes_out.record(compressed.size());
+        }
+        const std::vector<char> &payload = compress ? compressed : buffer.vector();
+
         on_thread_t threader(connection->conn->home_thread());
 
         /* Acquire the send-mutex so we don't collide with other things trying
         to send on the same connection. */
         {
+            /* Large messages (such as backfill chunks) line up behind each other
+            first, so that a small message (such as a heartbeat or a query's read)
+            waits for at most one large message instead of all of them. A small
+            message can then overtake a large one that another coroutine sent
+            earlier, but the messages of one sender stay in order, because we only
+            return once the message has been written to the connection. */
+            mutex_t::acq_t large_acq;
+            if (bytes_sent >= large_message_size) {
+                large_acq.reset(&connection->large_send_mutex, true);
+            }
+
             /* The `true` is for eager waiting, which is a significant performance
             optimization in this case. */
             mutex_t::acq_t acq(&connection->send_mutex, true);
 
-            /* Write the tag to the network */
+            /* Write the tag to the network. A compressed message is followed by the
+            original tag and the sizes of the data. */
             {
                 // All cluster versions use a uint8_t tag here.
                 write_message_t wm;
@@ -1544,7 +1672,14 @@ void connectivity_cluster_t::send_message(connection_t *connection,
                               "changed, the cluster communication format has changed and "
                               "you need to ask yourself whether live cluster upgrades work."
                               );
-                serialize_universal(&wm, tag);
+                if (compress) {
+                    serialize_universal(&wm, compressed_tag);
+                    serialize_universal(&wm, tag);
+                    serialize_universal(&wm, static_cast<uint64_t>(bytes_sent));
+                    serialize_universal(&wm, static_cast<uint64_t>(payload.size()));
+                } else {
+                    serialize_universal(&wm, tag);
+                }
                 make_buffered_tcp_conn_stream_wrapper_t buffered_conn(connection->conn);
                 int res = send_write_message(&buffered_conn, &wm);
                 if (res == -1) {
@@ -1560,22 +1695,23 @@ void connectivity_cluster_t::send_message(connection_t *connection,
 
             /* Write the message itself to the network */
             {
-                int64_t res = connection->conn->write_buffered(buffer.vector().data(),
-                                                               buffer.vector().size());
+                int64_t res = connection->conn->write_buffered(payload.data(),
+                                                               payload.size());
                 if (res == -1) {
                     if (connection->conn->is_read_open()) {
                         connection->conn->shutdown_read();
                     }
                     return;
                 } else {
-                    guarantee(res == static_cast<int64_t>(buffer.vector().size()));
+                    guarantee(res == static_cast<int64_t>(payload.size()));
                 }
             }
-        } /* Releases the send_mutex */
+        } /* Releases the send_mutex and the large_send_mutex */
 
+        /* We don't wait for the flush. Messages that other senders write in the
+        meantime go out with the same flush, and `write_buffered()` already blocks
+        if too much data is queued up on the connection. */
         connection->flusher.notify();
-        cond_t dummy_interruptor;
-        connection->flusher.flush(&dummy_interruptor);
         if (!connection->conn->is_write_open()) {
             if (connection->conn->is_read_open()) {
                 connection->conn->shutdown_read();
@@ -1596,6 +1732,9 @@ cluster_message_handler_t::cluster_message_handler_t(
     rassert(tag != connectivity_cluster_t::heartbeat_tag,
         "Tag %" PRIu8 " is reserved for heartbeat messages.",
         connectivity_cluster_t::heartbeat_tag);
+    rassert(tag != connectivity_cluster_t::compressed_tag,
+        "Tag %" PRIu8 " is reserved for compressed messages.",
+        connectivity_cluster_t::compressed_tag);
     rassert(connectivity_cluster->message_handlers[tag] == nullptr);
     connectivity_cluster->message_handlers[tag] = this;
 }
@@ -105,6 +105,18 @@ public:
     /* This tag is reserved exclusively for heartbeat messages. */
     static const message_tag_t heartbeat_tag = 'H';
 
+    /* This tag is reserved for messages that contain another message in compressed
+    form. We only send them to peers that asked for them during the handshake. */
+    static const message_tag_t compressed_tag = 'Z';
+
+    /* Messages of at least this many bytes wait for each other before they get in
+    line for a connection's `send_mutex`. See `send_message()`. */
+    static const size_t large_message_size = 64 * KILOBYTE;
+
+    /* If compression is enabled on a connection, we compress messages of at least
+    this many bytes. Smaller ones aren't worth the CPU time. */
+    static const size_t compress_message_size = 4 * KILOBYTE;
+
     class run_t;
 
     /* `connection_t` represents an open connection to another server. If we lose
@@ -154,7 +166,8 @@ public:
             const peer_id_t &peer_id,
             const server_id_t &server_id,
             keepalive_tcp_conn_stream_t *,
-            const peer_address_t &peer_address) THROWS_NOTHING;
+            const peer_address_t &peer_address,
+            bool compress_messages) THROWS_NOTHING;
         ~connection_t() THROWS_NOTHING;
 
         /* NULL for the loopback connection (i.e. our "connection" to ourself) */
@@ -168,13 +181,23 @@ public:
         /* Unused for our connection to ourself */
         mutex_t send_mutex;
 
+        /* Held by the sender of a large message while it waits for and holds
+        `send_mutex`. Unused for our connection to ourself. */
+        mutex_t large_send_mutex;
+
         /* Calls `conn->flush_buffer()`. Can be used for making sure that a
         buffered write makes it to the TCP stack. */
         pump_coro_t flusher;
 
+        /* Whether both sides agreed to compress large messages. */
+        const bool compress_messages;
+
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
-        perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
+        /* The sizes of the messages that we compressed, before and after. */
+        perfmon_sampler_t pm_compressed_bytes_in, pm_compressed_bytes_out;
+        perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership,
+            pm_compressed_bytes_in_membership, pm_compressed_bytes_out_membership;
 
         /* We only hold this information so we can deregister ourself */
         run_t *parent;
@@ -203,7 +226,8 @@ public:
                   heartbeat_semilattice_metadata_t> > heartbeat_sl_view,
               std::shared_ptr<semilattice_read_view_t<
                   auth_semilattice_metadata_t> > auth_sl_view,
-              tls_ctx_t *tls_ctx)
+              tls_ctx_t *tls_ctx,
+              bool compress_messages)
             THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t);
 
         ~run_t();
@@ -298,6 +322,9 @@ public:
 
         tls_ctx_t *tls_ctx;
 
+        /* Whether we ask our peers to compress large messages. */
+        bool compress_messages;
+
         /* `attempt_table` is a table of all the host:port pairs we're currently
         trying to connect to or have connected to. If we are told to connect to
         an address already in this table, we'll just ignore it. That's important
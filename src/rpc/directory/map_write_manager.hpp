@@ -21,7 +21,9 @@ private:
     for creating the `conn_info_t` and spawning the coroutine; the coroutine is
     responsible for stopping itself and removing the `conn_info_t`. The coroutine's job
     is to check for keys marked as dirty in `dirty_keys` and send those key-value pairs
-    over the network. */
+    over the network. It collects the changes for `DIRECTORY_UPDATE_BATCH_WINDOW_MS`
+    and sends them in batches, so that many keys changing at once (say when a server
+    with many tables starts) don't turn into a message per key. */
 
     class update_writer_t;
 
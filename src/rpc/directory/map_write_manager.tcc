@@ -4,8 +4,14 @@
 
 #include "rpc/directory/map_write_manager.hpp"
 
+#include <utility>
+#include <vector>
+
+#include "arch/timing.hpp"
 #include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
 #include "containers/archive/optional.hpp"
+#include "containers/archive/stl_types.hpp"
 
 template<class key_t, class value_t>
 directory_map_write_manager_t<key_t, value_t>::directory_map_write_manager_t(
@@ -42,14 +48,14 @@ class directory_map_write_manager_t<key_t, value_t>::update_writer_t :
 {
 public:
     update_writer_t(
-            uint64_t _timestamp, const key_t &_key, optional<value_t> &&_value) :
-        timestamp(_timestamp), key(_key), value(std::move(_value)) { }
+            uint64_t _timestamp,
+            std::vector<std::pair<key_t, optional<value_t> > > &&_updates) :
+        timestamp(_timestamp), updates(std::move(_updates)) { }
 
     void write(write_stream_t *s) {
         write_message_t wm;
         serialize<cluster_version_t::CLUSTER>(&wm, timestamp);
-        serialize<cluster_version_t::CLUSTER>(&wm, key);
-        serialize<cluster_version_t::CLUSTER>(&wm, value);
+        serialize<cluster_version_t::CLUSTER>(&wm, updates);
         int res = send_write_message(s, &wm);
         if (res) {
             throw fake_archive_exc_t();
@@ -66,8 +72,7 @@ public:
 
 private:
     uint64_t timestamp;
-    key_t key;
-    optional<value_t> value;
+    std::vector<std::pair<key_t, optional<value_t> > > updates;
 };
 
 template<class key_t, class value_t>
@@ -108,22 +113,34 @@ void directory_map_write_manager_t<key_t, value_t>::stream_to_conn(
                 wait_interruptible(&pulse_on_dirty, &interruptor);
             }
 
+            /* Changes tend to come in bursts, so we give the rest of the burst a
+            chance to go into the same messages. */
+            nap(DIRECTORY_UPDATE_BATCH_WINDOW_MS, &interruptor);
+
             /* Copy all dirty keys to a local variable, then iterate over that variable.
             The naive approach would be to always send the first dirty key in
             `conns_entry` until there are no dirty keys left; but that has starvation
             issues. */
             std::set<key_t> dirty_keys;
             std::swap(dirty_keys, conns_entry->second.dirty_keys);
-            for (const key_t &key : dirty_keys) {
+            auto it = dirty_keys.begin();
+            while (it != dirty_keys.end()) {
                 if (interruptor.is_pulsed()) {
                     throw interrupted_exc_t();
                 }
-                /* If the key changed again since we copied `dirty_keys`, we'll be
+                /* If a key changed again since we copied `dirty_keys`, we'll be
                 sending the newest value, because we didn't copy the value at the same
                 time as we copied `dirty_keys`. So it's OK to remove the key from
-                `dirty_keys` to prevent sending a redundant message. */
-                conns_entry->second.dirty_keys.erase(key);
-                update_writer_t writer(timestamp, key, value->get_key(key));
+                `dirty_keys` to prevent sending a redundant message. We don't block
+                while we collect the batch, so `timestamp` is newer than every value
+                in it. */
+                std::vector<std::pair<key_t, optional<value_t> > > updates;
+                for (; it != dirty_keys.end() &&
+                           updates.size() < DIRECTORY_UPDATE_MAX_BATCH_KEYS; ++it) {
+                    conns_entry->second.dirty_keys.erase(*it);
+                    updates.push_back(std::make_pair(*it, value->get_key(*it)));
+                }
+                update_writer_t writer(timestamp, std::move(updates));
                 connectivity_cluster->send_message(
                     connection, connection_keepalive, message_tag, &writer);
             }
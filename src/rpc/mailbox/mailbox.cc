@@ -7,6 +7,7 @@
 
 #include "debug.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "concurrency/pmap.hpp"
@@ -134,31 +135,66 @@ static const int MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD = 4;
 mailbox_manager_t::mailbox_manager_t(connectivity_cluster_t *_connectivity_cluster,
         connectivity_cluster_t::message_tag_t message_tag) :
     cluster_message_handler_t(_connectivity_cluster, message_tag),
-    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD)
+    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD),
+    round_trip_latency_membership(&get_global_perfmon_collection(),
+                                  &round_trip_latency, "mailbox_round_trips")
     { }
 
-mailbox_manager_t::mailbox_table_t::mailbox_table_t() {
-    next_mailbox_id = (UINT64_MAX / get_num_threads()) * get_thread_id().threadnum;
-}
+mailbox_manager_t::mailbox_table_t::mailbox_table_t() :
+    first_free(no_free_slot), next_counter(1) { }
 
 mailbox_manager_t::mailbox_table_t::~mailbox_table_t() {
+    bool empty = true;
+    for (const slot_t &slot : slots) {
+        if (slot.mailbox != nullptr) {
 #ifndef NDEBUG
-    for (const auto &pair : mailboxes) {
-        debugf("ERROR: stray mailbox %p\n%s\n",
-               pair.second, pair.second->bt.lines().c_str());
-    }
+            debugf("ERROR: stray mailbox %p\n%s\n",
+                   slot.mailbox, slot.mailbox->bt.lines().c_str());
 #endif
-    guarantee(mailboxes.empty(),
-              "Please destroy all mailboxes before destroying the cluster");
+            empty = false;
+        }
+    }
+    guarantee(empty, "Please destroy all mailboxes before destroying the cluster");
+}
+
+raw_mailbox_t::id_t mailbox_manager_t::mailbox_table_t::add_mailbox(
+        raw_mailbox_t *mb) {
+    size_t index;
+    if (first_free != no_free_slot) {
+        index = first_free;
+        first_free = slots[index].next_free;
+    } else {
+        index = slots.size();
+        guarantee(index < (static_cast<size_t>(1) << slot_bits),
+                  "Too many mailboxes on one thread");
+        slots.push_back(slot_t());
+    }
+    slot_t *slot = &slots[index];
+    slot->mailbox_id = (next_counter << slot_bits) | index;
+    slot->mailbox = mb;
+    slot->next_free = no_free_slot;
+    /* If the counter ever wraps around, a message would have to be delayed for
+    more than 2^40 registrations on this thread to be sent to the wrong mailbox. */
+    next_counter = (next_counter + 1) & (UINT64_MAX >> slot_bits);
+    return slot->mailbox_id;
+}
+
+void mailbox_manager_t::mailbox_table_t::remove_mailbox(raw_mailbox_t::id_t id) {
+    size_t index = id & ((static_cast<raw_mailbox_t::id_t>(1) << slot_bits) - 1);
+    guarantee(index < slots.size());
+    slot_t *slot = &slots[index];
+    guarantee(slot->mailbox != nullptr && slot->mailbox_id == id);
+    slot->mailbox = nullptr;
+    slot->next_free = first_free;
+    first_free = index;
 }
 
 raw_mailbox_t *mailbox_manager_t::mailbox_table_t::find_mailbox(raw_mailbox_t::id_t id) {
-    std::map<raw_mailbox_t::id_t, raw_mailbox_t *>::iterator it = mailboxes.find(id);
-    if (it == mailboxes.end()) {
+    size_t index = id & ((static_cast<raw_mailbox_t::id_t>(1) << slot_bits) - 1);
+    if (index >= slots.size() || slots[index].mailbox_id != id) {
         return nullptr;
-    } else {
-        return it->second;
     }
+    return slots[index].mailbox;
 }
 
 // This type merely reduces the amount of pointers we have to pass to read_mailbox_header().
@@ -225,12 +261,16 @@ void mailbox_manager_t::on_message(
     read_mailbox_header(stream, &mbox_header);
 
     // Read the data from the read stream, so it can be deallocated before we continue
-    // in a coroutine
-    std::vector<char> stream_data;
-    stream_data.resize(mbox_header.data_length);
-    int64_t bytes_read = force_read(stream, stream_data.data(), mbox_header.data_length);
-    if (bytes_read != static_cast<int64_t>(mbox_header.data_length)) {
-        throw fake_archive_exc_t();
+    // in a coroutine. We read it into a `shared_buf_t`, so that the datums in the
+    // message can point into it instead of being copied out of it.
+    counted_t<const shared_buf_t> stream_data;
+    {
+        counted_t<shared_buf_t> buf = shared_buf_t::create(mbox_header.data_length);
+        int64_t bytes_read = force_read(stream, buf->data(), mbox_header.data_length);
+        if (bytes_read != static_cast<int64_t>(mbox_header.data_length)) {
+            throw fake_archive_exc_t();
+        }
+        stream_data = std::move(buf);
     }
 
     // We use `spawn_now_dangerously()` to avoid having to heap-allocate `stream_data`.
@@ -240,7 +280,7 @@ void mailbox_manager_t::on_message(
         [this, mbox_header, &stream_data]() {
             mailbox_read_coroutine(
                 threadnum_t(mbox_header.dest_thread), mbox_header.dest_mailbox_id,
-                &stream_data, 0, MAYBE_YIELD);
+                &stream_data, MAYBE_YIELD);
         });
 }
 
@@ -256,50 +296,58 @@ void mailbox_manager_t::mailbox_read_coroutine(
     stream_data = nullptr; // <- It is not safe to use `stream_data` anymore once we
                         //    switch the thread
 
-    {
-        on_thread_t rethreader(dest_thread);
-        if (force_yield == FORCE_YIELD && rethreader.home_thread() == get_thread_id()) {
-            // Yield to avoid problems with reentrancy in case of local
-            // delivery.
-            coro_t::yield();
-        }
+    deliver_message(dest_thread, dest_mailbox_id, &stream, force_yield);
+}
 
-        try {
-            raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
-            if (mbox != nullptr) {
-                try {
-                    auto_drainer_t::lock_t keepalive(&mbox->drainer);
-                    mbox->callback->read(&stream, keepalive.get_drain_signal());
-                } catch (const interrupted_exc_t &) {
-                    /* Do nothing. It's no longer safe to access `mbox` (because the
-                    destructor is running) but otherwise we don't need to take any
-                    special action. */
-                }
+void mailbox_manager_t::mailbox_read_coroutine(
+        threadnum_t dest_thread,
+        raw_mailbox_t::id_t dest_mailbox_id,
+        counted_t<const shared_buf_t> *stream_data,
+        force_yield_t force_yield) {
+
+    // Construct a new stream to use
+    shared_buf_read_stream_t stream(std::move(*stream_data));
+    stream_data = nullptr; // <- It is not safe to use `stream_data` anymore once we
+                        //    switch the thread
+
+    deliver_message(dest_thread, dest_mailbox_id, &stream, force_yield);
+}
+
+void mailbox_manager_t::deliver_message(
+        threadnum_t dest_thread,
+        raw_mailbox_t::id_t dest_mailbox_id,
+        read_stream_t *stream,
+        force_yield_t force_yield) {
+    on_thread_t rethreader(dest_thread);
+    if (force_yield == FORCE_YIELD && rethreader.home_thread() == get_thread_id()) {
+        // Yield to avoid problems with reentrancy in case of local
+        // delivery.
+        coro_t::yield();
+    }
+
+    try {
+        raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
+        if (mbox != nullptr) {
+            try {
+                auto_drainer_t::lock_t keepalive(&mbox->drainer);
+                mbox->callback->read(stream, keepalive.get_drain_signal());
+            } catch (const interrupted_exc_t &) {
+                /* Do nothing. It's no longer safe to access `mbox` (because the
+                destructor is running) but otherwise we don't need to take any
+                special action. */
             }
-        } catch (const fake_archive_exc_t &e) {
-            logWRN("Received an invalid cluster message from a peer.");
         }
+    } catch (const fake_archive_exc_t &e) {
+        logWRN("Received an invalid cluster message from a peer.");
     }
 }
 
-raw_mailbox_t::id_t mailbox_manager_t::generate_mailbox_id() {
-    raw_mailbox_t::id_t id = ++mailbox_tables.get()->next_mailbox_id;
-    return id;
-}
-
 raw_mailbox_t::id_t mailbox_manager_t::register_mailbox(raw_mailbox_t *mb) {
-    raw_mailbox_t::id_t id = generate_mailbox_id();
-    std::map<raw_mailbox_t::id_t, raw_mailbox_t *> *mailboxes =
-        &mailbox_tables.get()->mailboxes;
-    std::pair<std::map<raw_mailbox_t::id_t, raw_mailbox_t *>::iterator, bool> res
-        = mailboxes->insert(std::make_pair(id, mb));
-    guarantee(res.second);  // Assert a new element was inserted.
-    return id;
+    return mailbox_tables.get()->add_mailbox(mb);
 }
 
 void mailbox_manager_t::unregister_mailbox(raw_mailbox_t::id_t id) {
-    size_t num_elements_erased = mailbox_tables.get()->mailboxes.erase(id);
-    guarantee(num_elements_erased == 1);
+    mailbox_tables.get()->remove_mailbox(id);
 }
 
 disconnect_watcher_t::disconnect_watcher_t(mailbox_manager_t *mailbox_manager,
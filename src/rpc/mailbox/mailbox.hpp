@@ -2,7 +2,8 @@
 #ifndef RPC_MAILBOX_MAILBOX_HPP_
 #define RPC_MAILBOX_MAILBOX_HPP_
 
-#include <map>
+#include <stdint.h>
+
 #include <string>
 #include <vector>
 
@@ -10,6 +11,8 @@
 #include "concurrency/new_semaphore.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/archive/vector_stream.hpp"
+#include "containers/shared_buffer.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rpc/connectivity/cluster.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 
@@ -141,17 +144,39 @@ public:
     mailbox_manager_t(connectivity_cluster_t *connectivity_cluster,
                       connectivity_cluster_t::message_tag_t message_tag);
 
+    /* Mailboxes are one-way, so the mailbox manager can't tell how long a request
+    takes to get its reply. Callers that send a request and wait for a reply on a
+    mailbox of their own (such as `primary_query_client_t`) record the time in
+    microseconds here. */
+    perfmon_histogram_t round_trip_latency;
+
 private:
     friend struct raw_mailbox_t;
     friend void send_write(mailbox_manager_t *, raw_mailbox_t::address_t, mailbox_write_callback_t *callback);
 
+    /* The mailboxes on one thread. The lower `slot_bits` bits of a mailbox ID are
+    the index of its slot in `slots`, and the upper bits come from a counter. Slots get
+    reused, but IDs don't, so a late message for a destroyed mailbox doesn't reach the
+    next mailbox in the same slot. The free slots form a list through `next_free`, so
+    registering a mailbox doesn't allocate unless all slots are in use. */
     struct mailbox_table_t {
         mailbox_table_t();
         ~mailbox_table_t();
-        raw_mailbox_t::id_t next_mailbox_id;
-        // TODO: use a buffered structure to reduce dynamic allocation
-        std::map<raw_mailbox_t::id_t, raw_mailbox_t *> mailboxes;
-        raw_mailbox_t *find_mailbox(raw_mailbox_t::id_t);
+        raw_mailbox_t::id_t add_mailbox(raw_mailbox_t *mb);
+        void remove_mailbox(raw_mailbox_t::id_t id);
+        raw_mailbox_t *find_mailbox(raw_mailbox_t::id_t id);
+
+        static const int slot_bits = 24;
+        static const size_t no_free_slot = SIZE_MAX;
+        struct slot_t {
+            raw_mailbox_t::id_t mailbox_id;
+            /* `nullptr` if the slot is free */
+            raw_mailbox_t *mailbox;
+            size_t next_free;
+        };
+        std::vector<slot_t> slots;
+        size_t first_free;
+        raw_mailbox_t::id_t next_counter;
     };
     one_per_thread_t<mailbox_table_t> mailbox_tables;
 
@@ -160,7 +185,7 @@ private:
     messages. */
     one_per_thread_t<new_semaphore_t> semaphores;
 
-    raw_mailbox_t::id_t generate_mailbox_id();
+    perfmon_membership_t round_trip_latency_membership;
 
     raw_mailbox_t::id_t register_mailbox(raw_mailbox_t *mb);
     void unregister_mailbox(raw_mailbox_t::id_t id);
@@ -183,6 +208,14 @@ private:
                                 std::vector<char> *stream_data,
                                 int64_t stream_data_offset,
                                 force_yield_t force_yield);
+    void mailbox_read_coroutine(threadnum_t dest_thread,
+                                raw_mailbox_t::id_t dest_mailbox_id,
+                                counted_t<const shared_buf_t> *stream_data,
+                                force_yield_t force_yield);
+    void deliver_message(threadnum_t dest_thread,
+                         raw_mailbox_t::id_t dest_mailbox_id,
+                         read_stream_t *stream,
+                         force_yield_t force_yield);
 };
 
 /* Note: disconnect_watcher_t keeps the connection alive for as long as it
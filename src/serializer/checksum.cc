@@ -1,8 +1,51 @@
 #include "serializer/checksum.hpp"
 
+// The x86 kernels are compiled with function-level target attributes, so they don't
+// need any special compiler flags for the whole file.  We only use them if the CPU
+// supports them at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define CHECKSUM_X86_KERNELS 1
+#else
+#define CHECKSUM_X86_KERNELS 0
+#endif
+
+#if defined(__aarch64__)
+#define CHECKSUM_NEON_KERNEL 1
+#else
+#define CHECKSUM_NEON_KERNEL 0
+#endif
+
+// The ARMv8 CRC instructions are optional, so we only use them if the build targets
+// CPUs that have them.
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CHECKSUM_ARM_CRC32C 1
+#else
+#define CHECKSUM_ARM_CRC32C 0
+#endif
+
+#include <string.h>
+
+#include <algorithm>
+
+#if CHECKSUM_X86_KERNELS
+#include <immintrin.h>
+#endif
+#if CHECKSUM_NEON_KERNEL
+#include <arm_neon.h>
+#endif
+#if CHECKSUM_ARM_CRC32C
+#include <arm_acle.h>
+#endif
+
+#include "errors.hpp"
+
+namespace {
+
 // The return value of this function or its behavior can't be changed -- the on-disk
-// format obviously requires a specific checksum algorithm.
-serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
+// format obviously requires a specific checksum algorithm.  The vectorized
+// implementations below must produce exactly the same results.
+serializer_checksum compute_checksum_scalar(const void *word32s, size_t wordcount) {
     const uint32_t *p = static_cast<const uint32_t *>(word32s);
 
     // This is the Fletcher-64 algorithm, applied to the input whose words are xored with
@@ -30,7 +73,7 @@ serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
     // We go through a minor shenanigan here to handle very large buffers.
     for (;;) {
         // 0xFFFFul is low enough that a and b can't overflow.
-        const size_t n = wordcount & 0xFFFFul;
+        const size_t n = std::min<size_t>(wordcount, 0xFFFFul);
 
         // At this point, a and b are <= 0x1_FFFF_FFFE and non-zero.
 
@@ -60,6 +103,421 @@ serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
     return serializer_checksum{(b << 32) | a};
 }
 
+// Reduces x to a value that is congruent to it modulo 2**32 - 1.  The result is
+// non-zero if x is, and <= 0x1_FFFF_FFFE.
+inline uint64_t fold_checksum_word(uint64_t x) {
+    return (x & 0xFFFFFFFFul) + (x >> 32);
+}
+
+// As the scalar implementation shows, the checksum only depends on the values of A
+// and B modulo 2**32 - 1, with the residue 0 represented as 0xFFFF_FFFF.  So the
+// vectorized implementations are free to sum the words in any order, as long as they
+// keep track of the weight that each word has in B.
+//
+// They all split their input into "steps" of `lanes` words, and keep per-lane 64-bit
+// accumulators:  s[j] is the sum of the words in lane j, and t[j] is the sum of s[j]
+// after each step.  The word at index i = k * lanes + j of a chunk of n = steps *
+// lanes words contributes x_i * (n - i) to B, and
+//     sum_i x_i * (n - i) = lanes * sum_j t[j] - sum_j j * s[j].
+//
+// The chunks are at most this many steps long, which keeps t[j] < 2**53.
+const size_t MAX_CHECKSUM_STEPS = 2048;
+
+// Adds a chunk that was accumulated in lanes to *a and *b.  On input and output, *a
+// and *b are non-zero and <= 0x1_FFFF_FFFE.
+inline void add_checksum_lanes(const uint64_t *s, const uint64_t *t,
+                               size_t lanes, size_t steps,
+                               uint64_t *a, uint64_t *b) {
+    uint64_t sum_s = 0;
+    uint64_t sum_t = 0;
+    uint64_t weighted_s = 0;
+    for (size_t j = 0; j < lanes; ++j) {
+        sum_s += s[j];
+        sum_t += t[j];
+        weighted_s += j * s[j];
+    }
+    const uint64_t n = lanes * steps;
+    // Every word of this chunk adds the previous value of A to B once more.
+    *b = fold_checksum_word(*b + n * *a);
+    *b = fold_checksum_word(*b + fold_checksum_word(lanes * sum_t - weighted_s));
+    *a = fold_checksum_word(*a + sum_s);
+}
+
+// Handles the last few words that don't fill a full step, and produces the result.
+inline serializer_checksum finish_checksum(const uint32_t *p, size_t wordcount,
+                                           uint64_t a, uint64_t b) {
+    const uint32_t xorer = 1;
+    for (size_t i = 0; i < wordcount; ++i) {
+        a += static_cast<uint64_t>(p[i] ^ xorer);
+        b += a;
+    }
+    a = fold_checksum_word(fold_checksum_word(a));
+    b = fold_checksum_word(fold_checksum_word(b));
+    // Now a and b are <= 0xFFFF_FFFF and non-zero.
+    return serializer_checksum{(b << 32) | a};
+}
+
+#if CHECKSUM_X86_KERNELS
+
+__attribute__((target("sse4.1")))
+serializer_checksum compute_checksum_sse41(const void *word32s, size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    uint64_t a = 0xFFFFFFFF;
+    uint64_t b = 0xFFFFFFFF;
+    const __m128i xorer = _mm_set1_epi32(1);
+
+    while (wordcount >= 4) {
+        const size_t steps = std::min(wordcount / 4, MAX_CHECKSUM_STEPS);
+        // Lanes 0 and 1 are in the `lo` registers, lanes 2 and 3 in the `hi` ones.
+        __m128i s_lo = _mm_setzero_si128();
+        __m128i s_hi = _mm_setzero_si128();
+        __m128i t_lo = _mm_setzero_si128();
+        __m128i t_hi = _mm_setzero_si128();
+        for (size_t k = 0; k < steps; ++k) {
+            __m128i x = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 4 * k)), xorer);
+            s_lo = _mm_add_epi64(s_lo, _mm_cvtepu32_epi64(x));
+            s_hi = _mm_add_epi64(s_hi, _mm_cvtepu32_epi64(_mm_srli_si128(x, 8)));
+            t_lo = _mm_add_epi64(t_lo, s_lo);
+            t_hi = _mm_add_epi64(t_hi, s_hi);
+        }
+        uint64_t s[4], t[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(s), s_lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(s + 2), s_hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(t), t_lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(t + 2), t_hi);
+        add_checksum_lanes(s, t, 4, steps, &a, &b);
+        p += 4 * steps;
+        wordcount -= 4 * steps;
+    }
+    return finish_checksum(p, wordcount, a, b);
+}
+
+__attribute__((target("avx2")))
+serializer_checksum compute_checksum_avx2(const void *word32s, size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    uint64_t a = 0xFFFFFFFF;
+    uint64_t b = 0xFFFFFFFF;
+    const __m256i xorer = _mm256_set1_epi32(1);
+
+    while (wordcount >= 8) {
+        const size_t steps = std::min(wordcount / 8, MAX_CHECKSUM_STEPS);
+        // Lanes 0 to 3 are in the `lo` registers, lanes 4 to 7 in the `hi` ones.
+        __m256i s_lo = _mm256_setzero_si256();
+        __m256i s_hi = _mm256_setzero_si256();
+        __m256i t_lo = _mm256_setzero_si256();
+        __m256i t_hi = _mm256_setzero_si256();
+        for (size_t k = 0; k < steps; ++k) {
+            __m256i x = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 8 * k)),
+                xorer);
+            s_lo = _mm256_add_epi64(
+                s_lo, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(x)));
+            s_hi = _mm256_add_epi64(
+                s_hi, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(x, 1)));
+            t_lo = _mm256_add_epi64(t_lo, s_lo);
+            t_hi = _mm256_add_epi64(t_hi, s_hi);
+        }
+        uint64_t s[8], t[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s), s_lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s + 4), s_hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(t), t_lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(t + 4), t_hi);
+        add_checksum_lanes(s, t, 8, steps, &a, &b);
+        p += 8 * steps;
+        wordcount -= 8 * steps;
+    }
+    return finish_checksum(p, wordcount, a, b);
+}
+
+#endif  // CHECKSUM_X86_KERNELS
+
+#if CHECKSUM_NEON_KERNEL
+
+serializer_checksum compute_checksum_neon(const void *word32s, size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    uint64_t a = 0xFFFFFFFF;
+    uint64_t b = 0xFFFFFFFF;
+    const uint32x4_t xorer = vdupq_n_u32(1);
+
+    while (wordcount >= 4) {
+        const size_t steps = std::min(wordcount / 4, MAX_CHECKSUM_STEPS);
+        // Lanes 0 and 1 are in the `lo` registers, lanes 2 and 3 in the `hi` ones.
+        uint64x2_t s_lo = vdupq_n_u64(0);
+        uint64x2_t s_hi = vdupq_n_u64(0);
+        uint64x2_t t_lo = vdupq_n_u64(0);
+        uint64x2_t t_hi = vdupq_n_u64(0);
+        for (size_t k = 0; k < steps; ++k) {
+            uint32x4_t x = veorq_u32(vld1q_u32(p + 4 * k), xorer);
+            s_lo = vaddq_u64(s_lo, vmovl_u32(vget_low_u32(x)));
+            s_hi = vaddq_u64(s_hi, vmovl_u32(vget_high_u32(x)));
+            t_lo = vaddq_u64(t_lo, s_lo);
+            t_hi = vaddq_u64(t_hi, s_hi);
+        }
+        uint64_t s[4], t[4];
+        vst1q_u64(s, s_lo);
+        vst1q_u64(s + 2, s_hi);
+        vst1q_u64(t, t_lo);
+        vst1q_u64(t + 2, t_hi);
+        add_checksum_lanes(s, t, 4, steps, &a, &b);
+        p += 4 * steps;
+        wordcount -= 4 * steps;
+    }
+    return finish_checksum(p, wordcount, a, b);
+}
+
+#endif  // CHECKSUM_NEON_KERNEL
+
+typedef serializer_checksum (*checksum_fn_t)(const void *, size_t);
+
+checksum_fn_t checksum_fn_for_impl(checksum_impl_t impl) {
+    switch (impl) {
+    case checksum_impl_t::scalar:
+        return &compute_checksum_scalar;
+#if CHECKSUM_X86_KERNELS
+    case checksum_impl_t::sse41:
+        return &compute_checksum_sse41;
+    case checksum_impl_t::avx2:
+        return &compute_checksum_avx2;
+#else
+    case checksum_impl_t::sse41:
+    case checksum_impl_t::avx2:
+        return nullptr;
+#endif
+#if CHECKSUM_NEON_KERNEL
+    case checksum_impl_t::neon:
+        return &compute_checksum_neon;
+#else
+    case checksum_impl_t::neon:
+        return nullptr;
+#endif
+    default:
+        unreachable();
+    }
+}
+
+checksum_fn_t choose_checksum_fn() {
+    const checksum_impl_t preferred[] = {
+        checksum_impl_t::avx2,
+        checksum_impl_t::neon,
+        checksum_impl_t::sse41
+    };
+    for (checksum_impl_t impl : preferred) {
+        if (checksum_impl_supported(impl)) {
+            return checksum_fn_for_impl(impl);
+        }
+    }
+    return &compute_checksum_scalar;
+}
+
+// The CRC-32C polynomial, bit-reversed.
+const uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+struct crc32c_table_t {
+    crc32c_table_t() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j) {
+                crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL & (0 - (crc & 1)));
+            }
+            entries[i] = crc;
+        }
+    }
+    uint32_t entries[256];
+};
+
+#if CHECKSUM_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint32_t crc = 0xFFFFFFFF;
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    for (; size >= 4; p += 4, size -= 4) {
+        uint32_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; size > 0; ++p, --size) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+    return ~crc;
+}
+
+#endif  // CHECKSUM_X86_KERNELS
+
+#if CHECKSUM_ARM_CRC32C
+
+uint32_t crc32c_arm(const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint32_t crc = 0xFFFFFFFF;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; size > 0; ++p, --size) {
+        crc = __crc32cb(crc, *p);
+    }
+    return ~crc;
+}
+
+#endif  // CHECKSUM_ARM_CRC32C
+
+uint32_t crc32c(const void *data, size_t size) {
+    static const bool use_hardware = crc32c_hardware_supported();
+    return use_hardware ? crc32c_hardware(data, size) : crc32c_software(data, size);
+}
+
+// Multiplies the 32x32 matrix over GF(2) `mat` (given by its columns), with `vec`.
+uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    for (; vec != 0; vec >>= 1, ++mat) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+    }
+    return sum;
+}
+
+void gf2_matrix_square(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; ++n) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+serializer_checksum make_crc32c_checksum(uint32_t crc) {
+    return serializer_checksum{(static_cast<uint64_t>(crc) << 32)
+                               | CRC32C_CHECKSUM_MARKER};
+}
+
+uint32_t crc32c_of_checksum(serializer_checksum checksum) {
+    rassert((checksum.value & 0xFFFFFFFFull) == CRC32C_CHECKSUM_MARKER);
+    return static_cast<uint32_t>(checksum.value >> 32);
+}
+
+}  // namespace
+
+bool crc32c_hardware_supported() {
+#if CHECKSUM_X86_KERNELS
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return CHECKSUM_ARM_CRC32C;
+#endif
+}
+
+uint32_t crc32c_software(const void *data, size_t size) {
+    static const crc32c_table_t table;
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc >> 8) ^ table.entries[(crc ^ p[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+uint32_t crc32c_hardware(const void *data, size_t size) {
+    guarantee(crc32c_hardware_supported());
+#if CHECKSUM_X86_KERNELS
+    return crc32c_sse42(data, size);
+#elif CHECKSUM_ARM_CRC32C
+    return crc32c_arm(data, size);
+#else
+    (void)data;
+    (void)size;
+    unreachable();
+#endif
+}
+
+// This is the method zlib uses for `crc32_combine`: appending `right_size` zero bytes
+// to the left buffer is a linear operation on its CRC, which we apply by repeatedly
+// squaring the operator for a single zero bit.
+uint32_t crc32c_combine(uint32_t left, uint32_t right, uint64_t right_size) {
+    if (right_size == 0) {
+        return left;
+    }
+
+    uint32_t even[32];
+    uint32_t odd[32];
+
+    // The operator for one zero bit.
+    odd[0] = CRC32C_POLYNOMIAL;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    // The operators for two and four zero bits.
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // Apply the operator for each bit that is set in `right_size` bytes.  The first
+    // square gives us the operator for one zero byte.
+    for (;;) {
+        gf2_matrix_square(even, odd);
+        if (right_size & 1) {
+            left = gf2_matrix_times(even, left);
+        }
+        right_size >>= 1;
+        if (right_size == 0) {
+            break;
+        }
+
+        gf2_matrix_square(odd, even);
+        if (right_size & 1) {
+            left = gf2_matrix_times(odd, left);
+        }
+        right_size >>= 1;
+        if (right_size == 0) {
+            break;
+        }
+    }
+
+    return left ^ right;
+}
+
+bool checksum_impl_supported(checksum_impl_t impl) {
+    switch (impl) {
+    case checksum_impl_t::scalar:
+        return true;
+#if CHECKSUM_X86_KERNELS
+    case checksum_impl_t::sse41:
+        return __builtin_cpu_supports("sse4.1");
+    case checksum_impl_t::avx2:
+        return __builtin_cpu_supports("avx2");
+#else
+    case checksum_impl_t::sse41:
+    case checksum_impl_t::avx2:
+        return false;
+#endif
+    case checksum_impl_t::neon:
+        // NEON is a mandatory part of AArch64.
+        return CHECKSUM_NEON_KERNEL;
+    default:
+        unreachable();
+    }
+}
+
+serializer_checksum compute_checksum_with_impl(checksum_impl_t impl,
+                                               const void *word32s, size_t wordcount) {
+    guarantee(checksum_impl_supported(impl));
+    return checksum_fn_for_impl(impl)(word32s, wordcount);
+}
+
+serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
+    // Picked once, on first use.  This runs for every block we write or read back.
+    static const checksum_fn_t fn = choose_checksum_fn();
+    return fn(word32s, wordcount);
+}
+
 serializer_checksum compute_checksum_concat(serializer_checksum left,
                                             serializer_checksum right,
                                             uint64_t right_wordcount) {
@@ -88,3 +546,44 @@ serializer_checksum compute_checksum_concat(serializer_checksum left,
 
     return serializer_checksum{(b << 32) | a};
 }
+
+serializer_checksum compute_checksum(checksum_algorithm_t algorithm,
+                                     const void *word32s, size_t wordcount) {
+    switch (algorithm) {
+    case checksum_algorithm_t::fletcher64:
+        return compute_checksum(word32s, wordcount);
+    case checksum_algorithm_t::crc32c:
+        return make_crc32c_checksum(
+            crc32c(word32s, wordcount * serializer_checksum::word_size));
+    default:
+        unreachable();
+    }
+}
+
+serializer_checksum compute_checksum_concat(checksum_algorithm_t algorithm,
+                                            serializer_checksum left,
+                                            serializer_checksum right,
+                                            uint64_t right_wordcount) {
+    switch (algorithm) {
+    case checksum_algorithm_t::fletcher64:
+        return compute_checksum_concat(left, right, right_wordcount);
+    case checksum_algorithm_t::crc32c:
+        return make_crc32c_checksum(
+            crc32c_combine(crc32c_of_checksum(left), crc32c_of_checksum(right),
+                           right_wordcount * serializer_checksum::word_size));
+    default:
+        unreachable();
+    }
+}
+
+serializer_checksum identity_checksum(checksum_algorithm_t algorithm) {
+    switch (algorithm) {
+    case checksum_algorithm_t::fletcher64:
+        return identity_checksum();
+    case checksum_algorithm_t::crc32c:
+        // The CRC of an empty buffer is 0.
+        return make_crc32c_checksum(0);
+    default:
+        unreachable();
+    }
+}
@@ -15,6 +15,18 @@ ATTR_PACKED(struct serializer_checksum {
     static const size_t word_size = sizeof(uint32_t);
 });
 
+// The algorithms a serializer file can use for its checksums.  Files record theirs in
+// the static header, and all checksums in a file use the same one.
+enum class checksum_algorithm_t {
+    // What `compute_checksum` computes: Fletcher-64 on words xored with 1.
+    fletcher64,
+    // CRC-32C (Castagnoli), in the upper 32 bits of the checksum.  The lower 32 bits
+    // are always CRC32C_CHECKSUM_MARKER, to keep them non-zero.
+    crc32c
+};
+
+static const uint32_t CRC32C_CHECKSUM_MARKER = 0xC32C0001;
+
 // Computes a checksum of a buffer of length 4*wordcount.
 // word32s: a pointer to the buffer
 // wordcount: the number of 32-bit words in the buffer.
@@ -22,6 +34,23 @@ ATTR_PACKED(struct serializer_checksum {
 // The checksum is never zero.
 serializer_checksum compute_checksum(const void *word32s, size_t wordcount);
 
+// The implementations of `compute_checksum`.  They all produce bit-identical results;
+// `compute_checksum` uses the fastest one that the CPU supports.  They are exposed so
+// that the unit tests can compare them against each other.
+enum class checksum_impl_t {
+    scalar,
+    sse41,
+    avx2,
+    neon
+};
+
+// Whether this build and this CPU can run `impl`.
+bool checksum_impl_supported(checksum_impl_t impl);
+
+// Like `compute_checksum`, but with the given implementation, which must be supported.
+serializer_checksum compute_checksum_with_impl(checksum_impl_t impl,
+                                               const void *word32s, size_t wordcount);
+
 // Combines checksums into the checksum of the concatenated buffer.  Given two buffers,
 // s, and t, serializer_checksum_concat(serializer_checksum(s), serializer_checksum(t),
 // t.wordcount) computes serializer_checksum(concat(s, t)).
@@ -35,6 +64,25 @@ inline serializer_checksum identity_checksum() {
     return compute_checksum(&buf, 0);
 }
 
+// Like the functions above, but with the given algorithm.  The `fletcher64` variants
+// are the same as the functions above.
+serializer_checksum compute_checksum(checksum_algorithm_t algorithm,
+                                     const void *word32s, size_t wordcount);
+serializer_checksum compute_checksum_concat(checksum_algorithm_t algorithm,
+                                            serializer_checksum left,
+                                            serializer_checksum right,
+                                            uint64_t right_wordcount);
+serializer_checksum identity_checksum(checksum_algorithm_t algorithm);
+
+// The CRC-32C implementations.  `compute_checksum` uses the hardware one if the CPU
+// has the SSE4.2 or ARMv8 CRC instructions.
+bool crc32c_hardware_supported();
+uint32_t crc32c_software(const void *data, size_t size);
+// `crc32c_hardware_supported()` must be true.
+uint32_t crc32c_hardware(const void *data, size_t size);
+// Given the CRCs of two buffers, computes the CRC of their concatenation.
+uint32_t crc32c_combine(uint32_t left, uint32_t right, uint64_t right_size);
+
 inline serializer_checksum no_checksum() {
     return serializer_checksum{0};
 }
@@ -0,0 +1,123 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/compression.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "math.hpp"
+
+struct block_compressor_t::zlib_state_t {
+    zlib_state_t() {
+        memset(&deflater, 0, sizeof(deflater));
+        memset(&inflater, 0, sizeof(inflater));
+        // Negative window bits give us raw deflate streams, without the zlib header
+        // and adler32 trailer.  The serializer checksums blocks already.
+        int res = deflateInit2(&deflater, Z_BEST_SPEED, Z_DEFLATED, -15, 8,
+                               Z_DEFAULT_STRATEGY);
+        guarantee(res == Z_OK, "deflateInit2 failed (%d)", res);
+        res = inflateInit2(&inflater, -15);
+        guarantee(res == Z_OK, "inflateInit2 failed (%d)", res);
+    }
+    ~zlib_state_t() {
+        deflateEnd(&deflater);
+        inflateEnd(&inflater);
+    }
+
+    z_stream deflater;
+    z_stream inflater;
+    // Compressed data goes here first, since we don't know its size up front.
+    scoped_array_t<char> scratch;
+
+    DISABLE_COPYING(zlib_state_t);
+};
+
+block_compressor_t::block_compressor_t() { }
+
+block_compressor_t::~block_compressor_t() { }
+
+block_compressor_t::zlib_state_t *block_compressor_t::get_zlib() {
+    if (!zlib_.has()) {
+        zlib_.init(new zlib_state_t);
+    }
+    return zlib_.get();
+}
+
+buf_ptr_t block_compressor_t::compress(block_compression_t compression,
+                                       const ser_buffer_t *buf,
+                                       block_size_t block_size) {
+    assert_thread();
+    if (compression == block_compression_t::none) {
+        return buf_ptr_t();
+    }
+    guarantee(compression == block_compression_t::zlib);
+
+    // Anything that doesn't save us a device block isn't worth decompressing.
+    const uint16_t aligned_size = buf_ptr_t::compute_aligned_block_size(block_size);
+    if (aligned_size <= DEVICE_BLOCK_SIZE) {
+        return buf_ptr_t();
+    }
+    const size_t max_data_size = aligned_size - DEVICE_BLOCK_SIZE
+        - sizeof(compressed_ser_buffer_t);
+
+    zlib_state_t *zlib = get_zlib();
+    if (zlib->scratch.size() < max_data_size) {
+        zlib->scratch.reset();
+        zlib->scratch.init(max_data_size);
+    }
+
+    z_stream *z = &zlib->deflater;
+    int res = deflateReset(z);
+    guarantee(res == Z_OK);
+    z->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(buf->cache_data));
+    z->avail_in = block_size.value();
+    z->next_out = reinterpret_cast<Bytef *>(zlib->scratch.data());
+    z->avail_out = max_data_size;
+    res = deflate(z, Z_FINISH);
+    if (res != Z_STREAM_END) {
+        // We ran out of space, so the block doesn't compress well enough.
+        guarantee(res == Z_OK || res == Z_BUF_ERROR, "deflate failed (%d)", res);
+        return buf_ptr_t();
+    }
+    const size_t data_size = max_data_size - z->avail_out;
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(
+        block_size_t::unsafe_make(sizeof(compressed_ser_buffer_t) + data_size));
+    compressed_ser_buffer_t *out
+        = reinterpret_cast<compressed_ser_buffer_t *>(ret.ser_buffer());
+    out->ser_header = buf->ser_header;
+    out->compression = static_cast<uint8_t>(compression);
+    memcpy(out->data, zlib->scratch.data(), data_size);
+    ret.fill_padding_zero();
+    return ret;
+}
+
+buf_ptr_t block_compressor_t::decompress(const buf_ptr_t &compressed,
+                                         block_size_t block_size) {
+    assert_thread();
+    const uint16_t compressed_size = compressed.block_size().ser_value();
+    guarantee(compressed_size > sizeof(compressed_ser_buffer_t));
+    const compressed_ser_buffer_t *in
+        = reinterpret_cast<const compressed_ser_buffer_t *>(compressed.ser_buffer());
+    guarantee(in->compression == static_cast<uint8_t>(block_compression_t::zlib),
+              "Block %" PR_BLOCK_ID " uses unknown compression %" PRIu8 ".",
+              in->ser_header.block_id, in->compression);
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    ret.ser_buffer()->ser_header = in->ser_header;
+
+    z_stream *z = &get_zlib()->inflater;
+    int res = inflateReset(z);
+    guarantee(res == Z_OK);
+    z->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in->data));
+    z->avail_in = compressed_size - sizeof(compressed_ser_buffer_t);
+    z->next_out = reinterpret_cast<Bytef *>(ret.cache_data());
+    z->avail_out = block_size.value();
+    res = inflate(z, Z_FINISH);
+    guarantee(res == Z_STREAM_END && z->avail_out == 0 && z->avail_in == 0,
+              "Compressed block %" PR_BLOCK_ID " is corrupted (%d).",
+              in->ser_header.block_id, res);
+    ret.fill_padding_zero();
+    return ret;
+}
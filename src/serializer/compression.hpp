@@ -0,0 +1,59 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_COMPRESSION_HPP_
+#define SERIALIZER_COMPRESSION_HPP_
+
+#include <stdint.h>
+
+#include "containers/scoped.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+#include "threading.hpp"
+
+// How the serializer compresses blocks before writing them.  The value is stored on
+// disk in every compressed block, so don't renumber these.
+enum class block_compression_t : uint8_t {
+    none = 0,
+    // Raw deflate at the fastest compression level.
+    zlib = 1
+};
+
+// The on-disk layout of a compressed block.  The block id is left uncompressed in
+// front, so that the GC and read-ahead can identify blocks without decompressing
+// them.  Whether a block is compressed is recorded in the LBA (see `lba_entry_t`),
+// together with its uncompressed size.  This defines the disk format!
+ATTR_PACKED(struct compressed_ser_buffer_t {
+    ls_buf_data_t ser_header;
+    // A `block_compression_t`, other than `none`.
+    uint8_t compression;
+    char data[];
+});
+
+// Compresses and decompresses blocks for one serializer.  It holds on to its
+// compression state between calls, so it must only be used from one thread.
+class block_compressor_t : public home_thread_mixin_debug_only_t {
+public:
+    block_compressor_t();
+    ~block_compressor_t();
+
+    // Compresses the block in `buf`, whose size is `block_size`.  Returns an empty
+    // `buf_ptr_t` if the compressed block wouldn't take up at least one
+    // DEVICE_BLOCK_SIZE less on disk than the original, in which case the block
+    // should be written as it is.
+    buf_ptr_t compress(block_compression_t compression,
+                       const ser_buffer_t *buf,
+                       block_size_t block_size);
+
+    // Decompresses a block written by `compress()`, returning a block of size
+    // `block_size` (the size of the block that was passed to `compress()`).
+    buf_ptr_t decompress(const buf_ptr_t &compressed, block_size_t block_size);
+
+private:
+    struct zlib_state_t;
+    zlib_state_t *get_zlib();
+
+    scoped_ptr_t<zlib_state_t> zlib_;
+
+    DISABLE_COPYING(block_compressor_t);
+};
+
+#endif  // SERIALIZER_COMPRESSION_HPP_
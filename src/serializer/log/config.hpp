@@ -6,6 +6,8 @@
 
 #include "config/args.hpp"
 #include "containers/archive/archive.hpp"
+#include "serializer/checksum.hpp"
+#include "serializer/compression.hpp"
 #include "serializer/types.hpp"
 #include "rpc/serialize_macros.hpp"
 
@@ -14,18 +16,43 @@
 struct log_serializer_dynamic_config_t {
     log_serializer_dynamic_config_t() {
         read_ahead = true;
+        mmap_reads = false;
         // This is probably too low, thanks to status quo bias (the status quo having
         // been to never compute checksums).
         checksum_threshold = 65536;
+        compression = block_compression_t::none;
+        // The data block GC used to start at a garbage ratio of 0.1, which is what
+        // this works out to.
+        gc_space_amplification_target = 10.0 / 9.0;
+        gc_write_amplification_target = 2.0;
+        flash_cache_size = 0;
     }
 
     /* Enable reading more data than requested to let the cache warmup more quickly
        esp. on rotational drives */
     bool read_ahead;
+    /* Read blocks from a read-only memory mapping of their extent instead of
+       through the disk manager, which saves a trip through the i/o pool and lets
+       the OS page cache serve repeated misses.  Meant for read-mostly tables.
+       Writes are unaffected.  Read-ahead is skipped when this is on. */
+    bool mmap_reads;
     /* The threshold above which we don't checksum blocks -- instead we fdatasync before
        writing the serializer superblock.  Designed to make single-document writes
        fast. */
     uint32_t checksum_threshold;
+    /* How to compress blocks before writing them.  Compressed blocks can be read back
+       regardless of this setting. */
+    block_compression_t compression;
+    /* What the data block GC aims for: how large the old data extents may be relative
+       to the live data in them, and how many bytes the GC and foreground writes may
+       write together per foreground byte.  See `data_gc_controller_t`. */
+    double gc_space_amplification_target;
+    double gc_write_amplification_target;
+    /* Where to keep a `flash_cache_t` for this file, and how large it may get.  There
+       is no flash cache if the path is empty or the size is zero.  The cache file's
+       contents are thrown away on every start. */
+    std::string flash_cache_path;
+    uint64_t flash_cache_size;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
@@ -50,7 +77,12 @@ struct log_serializer_static_config_t : public log_serializer_on_disk_static_con
     log_serializer_static_config_t() {
         extent_size_ = DEFAULT_EXTENT_SIZE;
         block_size_ = DEFAULT_BTREE_BLOCK_SIZE;
+        checksum_algorithm = checksum_algorithm_t::fletcher64;
     }
+
+    /* This isn't part of log_serializer_on_disk_static_config_t because the static
+    header records it in its version string (see static_header.cc). */
+    checksum_algorithm_t checksum_algorithm;
 };
 
 RDB_MAKE_SERIALIZABLE_2(log_serializer_static_config_t,
@@ -7,12 +7,15 @@
 #include <functional>
 
 #include "arch/arch.hpp"
+#include "arch/io/disk.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/flash_cache.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -38,13 +41,13 @@ const int GC_IO_PRIORITY_NICE = 8;
 // 4 times the priority of all caches combined
 const int GC_IO_PRIORITY_HIGH = 4 * MERGER_BLOCK_WRITE_IO_PRIORITY;
 
-// The ratio at which we start GCing.
-constexpr double GC_START_RATIO = 0.1;
-// The ratio at which we don't want to keep GC'ing.
-constexpr double GC_STOP_RATIO = 0.05;
-// The ratio at which we start taking more serious measures to get the garbage
-// rate down.
-constexpr double GC_HIGH_RATIO = 0.3;
+// The garbage ratios at which we start GCing, at which we don't want to keep GCing,
+// and at which we start taking more serious measures to get the garbage rate down
+// are chosen by `gc_controller` (see serializer/log/gc_controller.hpp).
+
+// Foreground writes of blocks whose previous version is in an extent that we started
+// writing to longer ago than this go to the cold stream (see `data_stream_t`).
+const kiloticks_t HOT_BLOCK_MAX_AGE = { 30 * MILLION };
 
 // What's the maximum number of "young" extents we can have?
 const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
@@ -76,7 +79,8 @@ public:
           state(state_active),
           garbage_bytes_stat(_parent->static_config->extent_size()),
           num_live_blocks_stat(0),
-          extent_offset(extent_ref.offset()) {
+          extent_offset(extent_ref.offset()),
+          mapping(nullptr) {
         static_assert(sizeof(block_info_t) == 4, "block_info_t not 4 bytes");
         add_self_to_parent_entries();
     }
@@ -91,7 +95,8 @@ public:
           state(state_reconstructing),
           garbage_bytes_stat(_parent->static_config->extent_size()),
           num_live_blocks_stat(0),
-          extent_offset(extent_ref.offset()) {
+          extent_offset(extent_ref.offset()),
+          mapping(nullptr) {
         add_self_to_parent_entries();
     }
 
@@ -105,9 +110,26 @@ public:
         guarantee(parent->entries.get(extent_id) == this);
         parent->entries.set(extent_id, nullptr);
 
+        // The extent might get reused for other blocks, which get mapped again when
+        // they're read.
+        if (mapping != nullptr) {
+            parent->dbfile->unmap(mapping, parent->static_config->extent_size());
+        }
+
         --parent->stats->pm_serializer_data_extents;
     }
 
+    // Maps the extent into memory the first time it's called (see
+    // `log_serializer_dynamic_config_t::mmap_reads`).  Returns null if the file can't be
+    // mapped.
+    const char *mapped_data() {
+        if (mapping == nullptr) {
+            mapping = parent->dbfile->map_read_only(extent_offset,
+                                                    parent->static_config->extent_size());
+        }
+        return mapping;
+    }
+
     // (To borrow Python syntax: returns [relative_offset(i) for i in range(0,
     // num_blocks())] + [back_relative_offset()].
     std::vector<uint32_t> block_boundaries() const {
@@ -369,8 +391,8 @@ public:
     enum state_t {
         // It has been, or is being, reconstructed from data on disk.
         state_reconstructing,
-        // We are currently putting things on this extent. It is equal to
-        // last_data_extent.
+        // We are currently putting things on this extent. It is one of
+        // `active_extents`.
         state_active,
         // Not active, but not a GC candidate yet. It is in young_extent_queue.
         state_young,
@@ -392,6 +414,9 @@ private:
     // parent's entries array.
     const int64_t extent_offset;
 
+    // The read-only mapping of the extent, or null if it hasn't been mapped.
+    const char *mapping;
+
     DISABLE_COPYING(gc_entry_t);
 };
 
@@ -407,7 +432,9 @@ data_block_manager_t::data_block_manager_t(
       /* The capacity of the gc_index_write_semaphore will be scaled
       based on the active number of GC threads. */
       gc_index_write_semaphore(1),
-      gc_stats(stats)
+      gc_stats(stats),
+      gc_controller(serializer->dynamic_config.gc_space_amplification_target,
+                    serializer->dynamic_config.gc_write_amplification_target)
 {
     rassert(static_config != nullptr);
     rassert(extent_manager != nullptr);
@@ -453,8 +480,13 @@ void data_block_manager_t::start_existing(
         const dbm_metablock_mixin_t *last_metablock) {
     guarantee(state == state_unstarted);
     dbfile = file;
-    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
-    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
+    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE,
+                                               UNLIMITED_OUTSTANDING_REQUESTS,
+                                               io_class_t::background));
+    // When the GC can't keep up with the writes, it competes with the flushes.
+    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH,
+                                               UNLIMITED_OUTSTANDING_REQUESTS,
+                                               io_class_t::foreground_write));
 
     /* Reconstruct the active data block extents from the metablock. */
     const int64_t offset = last_metablock->active_extent;
@@ -468,7 +500,7 @@ void data_block_manager_t::start_existing(
             reconstructed_extents.push_back(e);
         }
 
-        active_extent = entries.get(offset / extent_manager->extent_size);
+        gc_entry_t *active_extent = entries.get(offset / extent_manager->extent_size);
         guarantee(active_extent != nullptr);
 
         /* Turn the extent from a reconstructing extent into an active extent */
@@ -476,9 +508,13 @@ void data_block_manager_t::start_existing(
         reconstructed_extents.remove(active_extent);
 
         active_extent->make_active();
+        active_extents[hot_stream] = active_extent;
     } else {
-        active_extent = nullptr;
+        active_extents[hot_stream] = nullptr;
     }
+    /* The metablock only records the hot stream's extent.  Whatever was written to
+    the cold stream's extent is treated like any other old extent. */
+    active_extents[cold_stream] = nullptr;
 
     /* Convert any extents that we found live blocks in, but that are not active
     extents, into old extents */
@@ -665,14 +701,22 @@ public:
 
                 const block_size_t block_size
                     = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                const uint16_t ondisk_ser_block_size = info.ondisk_ser_block_size();
+                const block_size_t ondisk_block_size
+                    = block_size_t::unsafe_make(ondisk_ser_block_size);
+                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(ondisk_block_size);
+                memcpy(buf.ser_buffer(), current_buf, ondisk_ser_block_size);
                 buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+                guarantee(ondisk_ser_block_size <= *(lower_it + 1) - *lower_it);
+                if (info.compressed_ser_block_size != 0) {
+                    buf = parent->serializer->block_compressor->decompress(buf,
+                                                                           block_size);
+                }
 
                 counted_t<block_token_t> token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               ondisk_block_size);
 
                 parent->serializer->offer_buf_to_read_ahead_callbacks(
                         block_id,
@@ -699,6 +743,28 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
                                    file_account_t *io_account) {
     guarantee(state == state_ready);
+    if (serializer->dynamic_config.mmap_reads) {
+        gc_entry_t *entry = entries.get(static_config->extent_index(off_in));
+        guarantee(entry != nullptr);
+        const char *extent_data = entry->mapped_data();
+        if (extent_data != nullptr) {
+            const char *block_data = extent_data + (off_in - entry->extent_ref.offset());
+            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+            if (mapped_range_is_resident(block_data, block_size.ser_value())) {
+                memcpy(ret.ser_buffer(), block_data, block_size.ser_value());
+            } else {
+                // Don't block the thread on the page faults.
+                ser_buffer_t *dest = ret.ser_buffer();
+                linux_thread_pool_t::run_in_blocker_pool([&]() {
+                    memcpy(dest, block_data, block_size.ser_value());
+                });
+            }
+            stats->bytes_read(ret.aligned_block_size());
+            ret.fill_padding_zero();
+            return ret;
+        }
+    }
+
     if (should_perform_read_ahead(off_in)) {
         buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
         dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
@@ -742,11 +808,15 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
                                   size_t writes_count,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
+    const bool is_gc = is_gc_io_account(io_account);
+
     // These tokens are grouped by extent.  You can do a contiguous write in each
-    // extent.
+    // extent.  `write_order[k]` is the write that the k-th token belongs to.
     uint64_t cumulative_aligned_size;
+    std::vector<size_t> write_order;
     std::vector<std::vector<counted_t<block_token_t>>> token_groups
-        = gimme_some_new_offsets(writes, writes_count, &cumulative_aligned_size);
+        = gimme_some_new_offsets(writes, writes_count, is_gc, &write_order,
+                                 &cumulative_aligned_size);
     const bool wants_checksum
         = cumulative_aligned_size <= serializer->dynamic_config.checksum_threshold;
 
@@ -778,7 +848,7 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
     for (const std::vector<counted_t<block_token_t>> &group : token_groups) {
         const int64_t front_offset = group.front()->offset();
         const int64_t back_offset = group.back()->offset()
-            + gc_entry_t::aligned_value(group.back()->block_size());
+            + gc_entry_t::aligned_value(group.back()->ondisk_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -792,19 +862,20 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
         for (size_t j = 0, je = group.size(); j < je; ++j) {
             block_token_t *token = group[j].get();
             const int64_t j_offset = token->offset();
-            const block_size_t j_block_size = token->block_size();
+            const block_size_t j_block_size = token->ondisk_block_size();
             guarantee(j_offset == last_written_offset);
             const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
             total_aligned_size += j_aligned_size;
 
-            // The behavior of gimme_some_new_offsets is supposed to retain order, so
-            // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            const buf_write_info_t &write = writes[write_order[write_number]];
+            guarantee(write.block_size == j_block_size);
 
-            void *buf = writes[write_number].buf;
+            void *buf = write.buf;
             if (wants_checksum) {
                 size_t wordcount = j_aligned_size / serializer_checksum::word_size;
-                serializer_checksum chksum = compute_checksum(buf, wordcount);
+                serializer_checksum chksum
+                    = compute_checksum(extent_manager->checksum_algorithm,
+                                       buf, wordcount);
                 token->checksum_ = chksum;
             }
 
@@ -823,23 +894,33 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
         stats->bytes_written(total_aligned_size);
     }
 
+    update_gc_controller(cumulative_aligned_size, is_gc);
+
     // Call on_io_complete for degenerate case (we added 1 to ops_remaining
     // earlier).
     intermediate_cb->on_io_complete();
 
-    std::vector<counted_t<block_token_t>> ret;
-    ret.reserve(writes_count);
+    std::vector<counted_t<block_token_t>> ret(writes_count);
+    size_t token_number = 0;
     for (std::vector<counted_t<block_token_t>> &group : token_groups) {
         for (counted_t<block_token_t> &token : group) {
-            ret.push_back(std::move(token));
+            ret[write_order[token_number]] = std::move(token);
+            ++token_number;
         }
     }
+    guarantee(token_number == writes_count);
 
     return ret;
 }
 
 void data_block_manager_t::destroy_entry(gc_entry_t *entry) {
     rassert(entry != nullptr);
+    // The extent can get reused once it's released, so the flash cache has to
+    // forget the blocks that were in it.
+    if (serializer->flash_cache.has()) {
+        serializer->flash_cache->forget_extent(entry->extent_ref.offset(),
+                                               static_config->extent_size());
+    }
     entry->destroy();
 }
 
@@ -903,31 +984,28 @@ void data_block_manager_t::check_and_handle_empty_extent(uint64_t extent_id) {
 
 size_t data_block_manager_t::compute_gc_concurrency() const {
     // Ok, what we do here is the following:
-    // As long as the GC ratio is not increasing, i.e. below GC_START_RATIO,
+    // As long as the GC ratio is not increasing, i.e. below the start ratio,
     // we only start 1 GC coroutine.
     // When it turns out that the GC ratio has increased since we have started
     // GCing, we linearly increase the number of concurrent GCs, until reaching
-    // the maximum at GC_HIGH_RATIO.
+    // the maximum at the high ratio.
     // (If the GC ratio still keeps growing at that point, there's probably
     // not much we can do. Unless we would be ok with throttling writes.)
     //
     // Also see `choose_gc_io_account()` for the second component in the automatic
     // GC scaling process.
 
-    CT_ASSERT(GC_HIGH_RATIO > GC_START_RATIO);
-    CT_ASSERT(GC_START_RATIO > GC_STOP_RATIO);
+    const double start_ratio = gc_controller.start_ratio();
+    const double high_ratio = gc_controller.high_ratio();
+    rassert(high_ratio > start_ratio);
 
     const double gc_ratio = garbage_ratio();
-    if (gc_ratio < GC_START_RATIO) {
+    if (gc_ratio < start_ratio) {
         return 1;
-    } else if (gc_ratio >= GC_HIGH_RATIO) {
+    } else if (gc_ratio >= high_ratio) {
         return MAX_CONCURRENT_GCS;
     } else {
-        rassert(gc_ratio >= GC_START_RATIO);
-        rassert(gc_ratio < GC_HIGH_RATIO);
-        rassert(GC_HIGH_RATIO - GC_START_RATIO > 0.0);
-        double linear_factor = (gc_ratio - GC_START_RATIO)
-            / (GC_HIGH_RATIO - GC_START_RATIO);
+        double linear_factor = (gc_ratio - start_ratio) / (high_ratio - start_ratio);
         size_t total_concurrency =
             1 + static_cast<size_t>(linear_factor * MAX_CONCURRENT_GCS);
         // std::min to avoid rounding errors leading to illegal return values
@@ -937,7 +1015,7 @@ size_t data_block_manager_t::compute_gc_concurrency() const {
 
 file_account_t *data_block_manager_t::choose_gc_io_account() {
     // Start going into high priority as soon as the garbage ratio is more than
-    // GC_HIGH_RATIO.
+    // the controller's high ratio.
     // The idea is that we use the nice i/o account whenever possible, except
     // if it proves insufficient to maintain an acceptable garbage ratio, in
     // which case we switch over to the high priority account until the situation
@@ -945,13 +1023,38 @@ file_account_t *data_block_manager_t::choose_gc_io_account() {
 
     // Note that this means that we can end up oscillating between both accounts,
     // which is fine.
-    if (garbage_ratio() > GC_HIGH_RATIO) {
+    if (garbage_ratio() > gc_controller.high_ratio()) {
         return gc_io_account_high.get();
     } else {
         return gc_io_account_nice.get();
     }
 }
 
+bool data_block_manager_t::is_gc_io_account(file_account_t *io_account) const {
+    return io_account == gc_io_account_nice.get()
+        || io_account == gc_io_account_high.get();
+}
+
+void data_block_manager_t::update_gc_controller(size_t written_bytes, bool is_gc) {
+    if (is_gc) {
+        stats->pm_serializer_gc_written_bytes_per_sec.record(written_bytes);
+        stats->pm_serializer_gc_written_bytes_total += written_bytes;
+    }
+    gc_controller.record_write(written_bytes, is_gc);
+
+    const double ratio = garbage_ratio();
+    if (gc_controller.update(ratio, get_ticks())) {
+        stats->pm_serializer_gc_live_ratio.record(1.0 - ratio);
+        stats->pm_serializer_gc_write_amplification.record(
+            gc_controller.write_amplification());
+        if (ratio < 1.0) {
+            // The size of the old data extents relative to the live data in them.
+            stats->pm_serializer_gc_space_amplification.record(1.0 / (1.0 - ratio));
+        }
+        stats->pm_serializer_gc_start_ratio.record(gc_controller.start_ratio());
+    }
+}
+
 void data_block_manager_t::mark_garbage(int64_t offset, extent_transaction_t *txn) {
     uint64_t extent_id = static_config->extent_index(offset);
     gc_entry_t *entry = entries.get(extent_id);
@@ -1233,6 +1336,24 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
               gc_state->current_entry->format_block_infos("\n").c_str());
 }
 
+block_size_t data_block_manager_t::logical_block_size(int64_t offset,
+                                                      block_id_t block_id,
+                                                      block_size_t ondisk_block_size) {
+    // Blocks that are being GCed are still referenced by the index or by a token,
+    // and both know the block's uncompressed size.
+    auto token_it = serializer->offset_tokens.find(offset);
+    if (token_it != serializer->offset_tokens.end()) {
+        rassert(token_it->second->ondisk_block_size() == ondisk_block_size);
+        return token_it->second->block_size();
+    }
+    const index_block_info_t info = serializer->lba_index->get_block_info(block_id);
+    guarantee(info.offset.has_value() && info.offset.get_value() == offset,
+              "GCing block %" PR_BLOCK_ID " at offset %" PRIi64 ", which is "
+              "referenced by neither a token nor the index.", block_id, offset);
+    rassert(info.ondisk_ser_block_size() == ondisk_block_size.ser_value());
+    return block_size_t::unsafe_make(info.ser_block_size);
+}
+
 // `write_gcs` frees gc_blocks, which invalidates the buffer pointers in
 // `writes`. That's why those two values are passed in as rvalue references.
 void data_block_manager_t::write_gcs(
@@ -1262,8 +1383,16 @@ void data_block_manager_t::write_gcs(
         std::vector<buf_write_info_t> the_writes;
         the_writes.reserve(writes.size());
         for (size_t i = 0; i < writes.size(); ++i) {
+            // `writes[i].block_size` is what the block takes up on disk.  We move
+            // compressed blocks as they are, but the tokens need to know how large
+            // the blocks are once they're decompressed.
+            const block_size_t block_size
+                = logical_block_size(writes[i].old_offset,
+                                     writes[i].buf->ser_header.block_id,
+                                     writes[i].block_size);
             old_block_tokens.push_back(
                     serializer->generate_block_token(writes[i].old_offset,
+                                                     block_size,
                                                      writes[i].block_size));
 
             the_writes.push_back(buf_write_info_t(writes[i].buf,
@@ -1276,6 +1405,9 @@ void data_block_manager_t::write_gcs(
                                        &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
+        for (size_t i = 0; i < writes.size(); ++i) {
+            new_block_tokens[i]->block_size_ = old_block_tokens[i]->block_size_;
+        }
     }
 
     // Step 2: Wait on all writes to finish
@@ -1387,8 +1519,10 @@ void data_block_manager_t::flush_gc_index_writes(signal_t *) {
 void data_block_manager_t::prepare_metablock(dbm_metablock_mixin_t *metablock) {
     guarantee(state == state_ready || state == state_shutting_down);
 
-    if (active_extent != nullptr) {
-        metablock->active_extent = active_extent->extent_ref.offset();
+    // There's only room for one active extent in the metablock.  The hot stream's
+    // extent is the one that fills up quickly, so it's the one worth remembering.
+    if (active_extents[hot_stream] != nullptr) {
+        metablock->active_extent = active_extents[hot_stream]->extent_ref.offset();
     } else {
         metablock->active_extent = NULL_OFFSET;
     }
@@ -1419,10 +1553,12 @@ void data_block_manager_t::actually_shutdown() {
 
     guarantee(reconstructed_extents.head() == nullptr);
 
-    if (active_extent != nullptr) {
-        UNUSED int64_t extent = active_extent->extent_ref.release();
-        delete active_extent;
-        active_extent = nullptr;
+    for (gc_entry_t *&active_extent : active_extents) {
+        if (active_extent != nullptr) {
+            UNUSED int64_t extent = active_extent->extent_ref.release();
+            delete active_extent;
+            active_extent = nullptr;
+        }
     }
 
     while (gc_entry_t *entry = young_extent_queue.head()) {
@@ -1442,71 +1578,115 @@ void data_block_manager_t::actually_shutdown() {
     }
 }
 
+data_block_manager_t::data_stream_t
+data_block_manager_t::choose_data_stream(const buf_write_info_t &write, bool is_gc,
+                                         kiloticks_t now) {
+    // Blocks that survived being GCed are unlikely to be rewritten soon.
+    if (is_gc) {
+        return cold_stream;
+    }
+    // Otherwise we go by how long ago the block was last written, which we estimate
+    // from when we started writing to the extent that holds its current version.
+    // New blocks start out hot.
+    const flagged_off64_t offset = serializer->lba_index->get_block_offset(write.block_id);
+    if (!offset.has_value()) {
+        return hot_stream;
+    }
+    const gc_entry_t *entry = entries.get(static_config->extent_index(offset.get_value()));
+    if (entry == nullptr
+        || now.micros - entry->timestamp.micros <= HOT_BLOCK_MAX_AGE.micros) {
+        return hot_stream;
+    }
+    return cold_stream;
+}
+
 // Outputs how many bytes would get written, so we can use that info to decide later
 // whether to checksum the blocks (which'll let us save an fdatasync)
 std::vector<std::vector<counted_t<block_token_t>>>
 data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
                                              size_t writes_count,
+                                             bool is_gc,
+                                             std::vector<size_t> *write_order_out,
                                              uint64_t *cumulative_aligned_size_out) {
     ASSERT_NO_CORO_WAITING;
 
-    // Start a new extent if necessary.
-    if (active_extent == nullptr) {
-        active_extent = new gc_entry_t(this);
-        ++stats->pm_serializer_data_extents_allocated;
+    const kiloticks_t now = get_kiloticks();
+    std::vector<data_stream_t> streams;
+    streams.reserve(writes_count);
+    for (size_t i = 0; i < writes_count; ++i) {
+        streams.push_back(choose_data_stream(writes[i], is_gc, now));
+        if (streams.back() == cold_stream) {
+            ++stats->pm_serializer_cold_block_writes;
+        }
     }
 
-
-    guarantee(active_extent->state == gc_entry_t::state_active);
-
     std::vector<std::vector<counted_t<block_token_t>>> ret;
     uint64_t cumulative_aligned_size = 0;
+    write_order_out->clear();
+    write_order_out->reserve(writes_count);
+
+    // We place the writes of one stream after the other, so that each stream's
+    // blocks are still written contiguously.
+    for (int stream = 0; stream < num_data_streams; ++stream) {
+        gc_entry_t *&active_extent = active_extents[stream];
+        std::vector<counted_t<block_token_t> > tokens;
+        for (size_t i = 0; i < writes_count; ++i) {
+            if (streams[i] != stream) {
+                continue;
+            }
 
-    std::vector<counted_t<block_token_t> > tokens;
-    for (size_t i = 0; i < writes_count; ++i) {
-        block_size_t block_size = writes[i].block_size;
-        uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
-        unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        cumulative_aligned_size += gc_entry_t::aligned_value(block_size);
-        if (!active_extent->new_offset(block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
-            // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
-                destroy_entry(old_active_extent);
-            } else {
-                active_extent->state = gc_entry_t::state_young;
-                active_extent->shrink_to_fit();
-                young_extent_queue.push_back(active_extent);
-                mark_unyoung_entries();
+            // Start a new extent if necessary.
+            if (active_extent == nullptr) {
                 active_extent = new gc_entry_t(this);
+                ++stats->pm_serializer_data_extents_allocated;
             }
+            guarantee(active_extent->state == gc_entry_t::state_active);
+
+            block_size_t block_size = writes[i].block_size;
+            uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
+            unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
+            cumulative_aligned_size += gc_entry_t::aligned_value(block_size);
+            if (!active_extent->new_offset(block_size,
+                                           &relative_offset, &block_index)) {
+                // Move the active_extent gc_entry_t to the young extent queue (if it's
+                // not already empty), and make a new gc_entry_t.
+                if (active_extent->num_live_blocks() == 0) {
+                    gc_entry_t *old_active_extent = active_extent;
+                    active_extent = new gc_entry_t(this);
+                    destroy_entry(old_active_extent);
+                } else {
+                    active_extent->state = gc_entry_t::state_young;
+                    active_extent->shrink_to_fit();
+                    young_extent_queue.push_back(active_extent);
+                    mark_unyoung_entries();
+                    active_extent = new gc_entry_t(this);
+                }
 
-            ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(block_size,
-                                                             &relative_offset,
-                                                             &block_index);
-            guarantee(succeeded);
-
-            // Push the current group of tokens, if it's nonempty, onto the return
-            // vector.
-            if (!tokens.empty()) {
-                ret.push_back(std::move(tokens));
-                tokens.clear();
+                ++stats->pm_serializer_data_extents_allocated;
+                const bool succeeded = active_extent->new_offset(block_size,
+                                                                 &relative_offset,
+                                                                 &block_index);
+                guarantee(succeeded);
+
+                // Push the current group of tokens, if it's nonempty, onto the return
+                // vector.
+                if (!tokens.empty()) {
+                    ret.push_back(std::move(tokens));
+                    tokens.clear();
+                }
             }
-        }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+            const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
+            active_extent->was_written = true;
+            active_extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, block_size));
-    }
+            tokens.push_back(serializer->generate_block_token(offset, block_size));
+            write_order_out->push_back(i);
+        }
 
-    if (!tokens.empty()) {
-        ret.push_back(std::move(tokens));
+        if (!tokens.empty()) {
+            ret.push_back(std::move(tokens));
+        }
     }
 
     *cumulative_aligned_size_out = cumulative_aligned_size;
@@ -1553,9 +1733,9 @@ void data_block_manager_t::remove_last_unyoung_entry() {
 
 // Answers the following question: We're in the middle of gc'ing, and
 // look, it's the next largest entry.  Should we keep gc'ing?  Returns
-// false when the garbage ratio is lower than GC_STOP_RATIO.
+// false when the garbage ratio is lower than the controller's stop ratio.
 bool data_block_manager_t::should_we_keep_gcing() const {
-    return gc_enabled && garbage_ratio() > GC_STOP_RATIO;
+    return gc_enabled && garbage_ratio() > gc_controller.stop_ratio();
 }
 
 bool data_block_manager_t::should_terminate_one_gc_thread() const {
@@ -1564,10 +1744,10 @@ bool data_block_manager_t::should_terminate_one_gc_thread() const {
 }
 
 // Answers the following question: Do we want to bother gc'ing?
-// Returns true when our garbage_ratio is greater than
-// GC_THRESHOLD_RATIO_*.
+// Returns true when our garbage_ratio is greater than the controller's
+// start ratio.
 bool data_block_manager_t::do_we_want_to_start_gcing() const {
-    return gc_enabled && garbage_ratio() > GC_START_RATIO;
+    return gc_enabled && garbage_ratio() > gc_controller.start_ratio();
 }
 
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
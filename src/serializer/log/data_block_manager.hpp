@@ -16,6 +16,7 @@
 #include "serializer/checksum.hpp"
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
+#include "serializer/log/gc_controller.hpp"
 #include "serializer/types.hpp"
 
 class buf_ptr_t;
@@ -92,13 +93,29 @@ public:
                 file_account_t *io_account,
                 iocallback_t *cb);
 
+    // Picks an offset for each write.  The tokens are grouped by extent, and
+    // `write_order_out` receives the index of the write that each token belongs to
+    // (in the order of the groups).
     std::vector<std::vector<counted_t<block_token_t> > >
     gimme_some_new_offsets(const buf_write_info_t *writes, size_t writes_count,
+                           bool is_gc, std::vector<size_t> *write_order_out,
                            uint64_t *cumulative_aligned_size_out);
 
     bool is_gc_active() const;
 
 private:
+    /* Blocks that get rewritten often and blocks that don't are written to separate
+    active extents, so that the GC doesn't have to copy the same cold blocks around
+    every time it collects an extent full of hot garbage. */
+    enum data_stream_t {
+        hot_stream = 0,
+        cold_stream = 1,
+        num_data_streams = 2
+    };
+
+    data_stream_t choose_data_stream(const buf_write_info_t &write, bool is_gc,
+                                     kiloticks_t now);
+
     void actually_shutdown();
 
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
@@ -123,6 +140,11 @@ private:
               block_size(_block_size) { }
     };
 
+    /* Returns the uncompressed size of the block that's stored at `offset`, and
+    takes up `ondisk_block_size` there. */
+    block_size_t logical_block_size(int64_t offset, block_id_t block_id,
+                                    block_size_t ondisk_block_size);
+
     /* Runs in a coroutine and keeps calling `gc_one_extent()` for as long as
     we should keep GCing. */
     void run_gc(gc_state_t *gc_state);
@@ -151,6 +173,12 @@ private:
     // Tells if we should keep gc'ing.
     bool should_we_keep_gcing() const;
 
+    // Whether this is one of the accounts that the GC writes through.
+    bool is_gc_io_account(file_account_t *io_account) const;
+
+    // Lets `gc_controller` adjust the GC thresholds, and updates its stats.
+    void update_gc_controller(size_t written_bytes, bool is_gc);
+
     // Checks the size of active_gcs and determines whether at least one
     // GC thread should terminate.
     bool should_terminate_one_gc_thread() const;
@@ -198,8 +226,9 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
-    gc_entry_t *active_extent;
+    /* Contains the extents in the gc_entry_t::state_active state, one per
+    `data_stream_t`. */
+    gc_entry_t *active_extents[num_data_streams];
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
@@ -269,6 +298,9 @@ private:
 
     gc_stats_t gc_stats;
 
+    /* Decides at which garbage ratios the GC starts, stops and gets serious. */
+    data_gc_controller_t gc_controller;
+
     DISABLE_COPYING(data_block_manager_t);
 };
 
@@ -214,14 +214,24 @@ public:
             free_queue.push(offset_to_id(extent));
             ++held_extents_;
             try_shrink_file();
+            if (offset_to_id(extent) < extents.size()) {
+                // The extent stays in the file, but until we hand it out again
+                // nothing in it is worth keeping.  Letting the file system know frees
+                // the space and lets an SSD erase the blocks ahead of time.  A write
+                // that reuses the extent is ordered after the discard.
+                dbfile->discard(extent, extent_size);
+                ++stats->pm_extents_discarded;
+            }
         }
     }
 };
 
 extent_manager_t::extent_manager_t(file_t *file,
                                    const log_serializer_on_disk_static_config_t *static_config,
+                                   checksum_algorithm_t _checksum_algorithm,
                                    log_serializer_stats_t *_stats)
     : stats(_stats), extent_size(static_config->extent_size()),
+      checksum_algorithm(_checksum_algorithm),
       state(state_reserving_extents) {
     guarantee(divides(DEVICE_BLOCK_SIZE, extent_size));
 
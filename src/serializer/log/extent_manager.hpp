@@ -96,6 +96,7 @@ class extent_manager_t : public home_thread_mixin_debug_only_t {
 public:
     extent_manager_t(file_t *file,
                      const log_serializer_on_disk_static_config_t *static_config,
+                     checksum_algorithm_t checksum_algorithm,
                      log_serializer_stats_t *);
     ~extent_manager_t();
 
@@ -133,6 +134,8 @@ public:
 
     log_serializer_stats_t *const stats;
     const uint64_t extent_size;   /* Same as static_config->extent_size */
+    /* What the file's data block, LBA and metablock checksums use */
+    const checksum_algorithm_t checksum_algorithm;
 
 private:
     void release_extent_preliminaries();
@@ -0,0 +1,204 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/flash_cache.hpp"
+
+#include <functional>
+
+#include "arch/arch.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "config/args.hpp"
+#include "math.hpp"
+#include "serializer/log/stats.hpp"
+
+// Admitting blocks is best effort: rather than queue up writes to the cache file when
+// it can't keep up, we skip blocks.
+static const size_t FLASH_CACHE_MAX_WRITES_IN_FLIGHT = 32;
+static const int FLASH_CACHE_WRITE_IO_PRIORITY = 32;
+
+flash_cache_t::flash_cache_t(scoped_ptr_t<file_t> &&file, uint64_t capacity,
+                             log_serializer_stats_t *stats)
+    : file_(std::move(file)),
+      capacity_(floor_aligned(capacity, DEVICE_BLOCK_SIZE)),
+      stats_(stats),
+      write_head_(0),
+      next_generation_(0),
+      writes_in_flight_(0),
+      // About as many blocks as fit into the cache.
+      max_recent_reads_(capacity / DEFAULT_BTREE_BLOCK_SIZE + 1),
+      next_recent_read_(0) {
+    file_->set_file_size(capacity_);
+    read_account_.init(new file_account_t(file_.get(), CACHE_READS_IO_PRIORITY,
+                                          UNLIMITED_OUTSTANDING_REQUESTS,
+                                          io_class_t::foreground_read));
+    write_account_.init(new file_account_t(file_.get(), FLASH_CACHE_WRITE_IO_PRIORITY,
+                                           UNLIMITED_OUTSTANDING_REQUESTS,
+                                           io_class_t::background));
+}
+
+flash_cache_t::~flash_cache_t() {
+    assert_thread();
+    drainer_.drain();
+}
+
+buf_ptr_t flash_cache_t::read(int64_t offset, block_size_t ondisk_size) {
+    assert_thread();
+    index_iter_t it = index_.find(offset);
+    if (it == index_.end() || !it->second.written) {
+        return buf_ptr_t();
+    }
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(ondisk_size);
+    if (ret.aligned_block_size() != it->second.size) {
+        drop(it);
+        return buf_ptr_t();
+    }
+    const uint64_t generation = it->second.generation;
+    co_read(file_.get(), it->second.cache_offset, ret.aligned_block_size(),
+            ret.ser_buffer(), read_account_.get());
+
+    // The block might have been dropped while we were reading it, in which case
+    // something else might have been written over it.
+    it = index_.find(offset);
+    if (it == index_.end() || it->second.generation != generation) {
+        return buf_ptr_t();
+    }
+    ++stats_->pm_serializer_flash_cache_hits;
+    return ret;
+}
+
+void flash_cache_t::note_read(int64_t offset, const buf_ptr_t &buf) {
+    assert_thread();
+    if (index_.count(offset) != 0 || !check_recently_read(offset)) {
+        return;
+    }
+    const uint32_t size = buf.aligned_block_size();
+    int64_t cache_offset;
+    if (writes_in_flight_ >= FLASH_CACHE_MAX_WRITES_IN_FLIGHT || size > capacity_
+        || !allocate(size, &cache_offset)) {
+        return;
+    }
+
+    entry_t entry;
+    entry.cache_offset = cache_offset;
+    entry.size = size;
+    entry.generation = next_generation_++;
+    entry.pending = buf_ptr_t::alloc_copy(buf);
+    entry.written = false;
+    by_cache_offset_[entry.cache_offset] = offset;
+    const uint64_t generation = entry.generation;
+    index_.insert(std::make_pair(offset, std::move(entry)));
+
+    ++writes_in_flight_;
+    coro_t::spawn_sometime(std::bind(&flash_cache_t::write_block, this,
+                                     offset, generation, drainer_.lock()));
+}
+
+void flash_cache_t::forget_extent(int64_t extent_offset, uint64_t extent_size) {
+    assert_thread();
+    index_iter_t it = index_.lower_bound(extent_offset);
+    while (it != index_.end()
+           && it->first < extent_offset + static_cast<int64_t>(extent_size)) {
+        index_iter_t next = it;
+        ++next;
+        drop(it);
+        it = next;
+    }
+}
+
+bool flash_cache_t::check_recently_read(int64_t offset) {
+    auto it = recent_read_index_.find(offset);
+    if (it != recent_read_index_.end()) {
+        recent_read_index_.erase(it);
+        return true;
+    }
+
+    auto is_live = [&](const std::pair<int64_t, uint64_t> &r) {
+        auto jt = recent_read_index_.find(r.first);
+        return jt != recent_read_index_.end() && jt->second == r.second;
+    };
+    // Don't let removed offsets pile up in `recent_reads_`, see `ghost_list_t::add()`.
+    if (recent_reads_.size() >= 2 * recent_read_index_.size() + 16) {
+        std::deque<std::pair<int64_t, uint64_t> > live_reads;
+        for (const auto &r : recent_reads_) {
+            if (is_live(r)) {
+                live_reads.push_back(r);
+            }
+        }
+        recent_reads_.swap(live_reads);
+    }
+    const uint64_t sequence_number = next_recent_read_++;
+    recent_reads_.push_back(std::make_pair(offset, sequence_number));
+    recent_read_index_.insert(std::make_pair(offset, sequence_number));
+    while (recent_read_index_.size() > max_recent_reads_) {
+        const std::pair<int64_t, uint64_t> front = recent_reads_.front();
+        recent_reads_.pop_front();
+        if (is_live(front)) {
+            recent_read_index_.erase(front.first);
+        }
+    }
+    return false;
+}
+
+bool flash_cache_t::allocate(uint32_t size, int64_t *cache_offset_out) {
+    const int64_t begin = write_head_ + size > capacity_ ? 0 : write_head_;
+    const int64_t end = begin + size;
+
+    // Two writes to the same place could finish in either order.
+    auto jt = writes_in_progress_.lower_bound(begin);
+    if (jt != writes_in_progress_.begin()) {
+        --jt;
+    }
+    for (; jt != writes_in_progress_.end() && jt->first < end; ++jt) {
+        if (jt->first + jt->second > begin) {
+            return false;
+        }
+    }
+
+    // The block before `begin` might reach into the new block.
+    auto it = by_cache_offset_.lower_bound(begin);
+    if (it != by_cache_offset_.begin()) {
+        auto prev = it;
+        --prev;
+        index_iter_t prev_entry = index_.find(prev->second);
+        rassert(prev_entry != index_.end());
+        if (prev->first + prev_entry->second.size > begin) {
+            it = prev;
+        }
+    }
+    while (it != by_cache_offset_.end() && it->first < end) {
+        const int64_t offset = it->second;
+        ++it;
+        drop(index_.find(offset));
+    }
+
+    write_head_ = end;
+    *cache_offset_out = begin;
+    return true;
+}
+
+void flash_cache_t::drop(index_iter_t it) {
+    rassert(it != index_.end());
+    by_cache_offset_.erase(it->second.cache_offset);
+    index_.erase(it);
+}
+
+void flash_cache_t::write_block(int64_t offset, uint64_t generation,
+                                auto_drainer_t::lock_t) {
+    assert_thread();
+    index_iter_t it = index_.find(offset);
+    if (it != index_.end() && it->second.generation == generation) {
+        // The buffer has to outlive the write, even if the block gets dropped.
+        buf_ptr_t buf = std::move(it->second.pending);
+        const int64_t cache_offset = it->second.cache_offset;
+        writes_in_progress_.insert(
+            std::make_pair(cache_offset, buf.aligned_block_size()));
+        co_write(file_.get(), cache_offset, buf.aligned_block_size(),
+                 buf.ser_buffer(), write_account_.get(), datasync_op::no_datasyncs);
+        writes_in_progress_.erase(cache_offset);
+
+        it = index_.find(offset);
+        if (it != index_.end() && it->second.generation == generation) {
+            it->second.written = true;
+            ++stats_->pm_serializer_flash_cache_writes;
+        }
+    }
+    --writes_in_flight_;
+}
@@ -0,0 +1,114 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_FLASH_CACHE_HPP_
+#define SERIALIZER_LOG_FLASH_CACHE_HPP_
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "arch/types.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "threading.hpp"
+
+struct log_serializer_stats_t;
+
+/* A second level below the page cache for the serializer's blocks, in a file on fast
+local storage, for when the database file itself is on slower storage.  On a miss the
+serializer looks here before reading the database file.
+
+Blocks are kept by their offset in the database file, in the form they have on disk
+there.  What's at an offset doesn't change until its extent gets reused, and the
+serializer calls `forget_extent()` before that.  Blocks are written to the cache file
+one after the other, wrapping around at the end and overwriting the oldest ones.  The
+index is only kept in memory, so the cache starts out empty every time.
+
+A block only gets written to the cache when it's read from the database file for the
+second time while it's still among the recently read ones.  The page cache only reads
+a block again after evicting it, so this admits the blocks that the page cache wants
+back, and keeps out the blocks that a scan reads a single time. */
+class flash_cache_t : public home_thread_mixin_debug_only_t {
+public:
+    // Uses the first `capacity` bytes of `file`.
+    flash_cache_t(scoped_ptr_t<file_t> &&file, uint64_t capacity,
+                  log_serializer_stats_t *stats);
+    ~flash_cache_t();
+
+    // Returns the block at `offset` in the database file, which takes up
+    // `ondisk_size` there, or an empty `buf_ptr_t` if it's not in the cache.
+    buf_ptr_t read(int64_t offset, block_size_t ondisk_size);
+
+    // Tells the cache that `buf` was read from `offset` in the database file.  The
+    // cache might write a copy of it to the cache file.
+    void note_read(int64_t offset, const buf_ptr_t &buf);
+
+    // Forgets the blocks in the extent of `extent_size` bytes at `extent_offset`. It
+    // must be called before the extent gets reused.
+    void forget_extent(int64_t extent_offset, uint64_t extent_size);
+
+    size_t block_count() const { return index_.size(); }
+
+private:
+    struct entry_t {
+        int64_t cache_offset;
+        uint32_t size;
+        // Is different for every block we write, so that a coroutine that waited for
+        // I/O can tell if the block got dropped or replaced in the meantime.
+        uint64_t generation;
+        // The block to write until the write starts.
+        buf_ptr_t pending;
+        // False until the block's write has finished.
+        bool written;
+    };
+    typedef std::map<int64_t, entry_t>::iterator index_iter_t;
+
+    // Returns true if `offset` was among the recently read offsets, and removes it.
+    // Adds it otherwise.
+    bool check_recently_read(int64_t offset);
+
+    // Makes room for `size` bytes at the write head, and sets `*cache_offset_out` to
+    // their offset in the cache file.  Returns false if there's a write in progress
+    // there.
+    bool allocate(uint32_t size, int64_t *cache_offset_out);
+    void drop(index_iter_t it);
+
+    void write_block(int64_t offset, uint64_t generation,
+                     auto_drainer_t::lock_t lock);
+
+    scoped_ptr_t<file_t> file_;
+    scoped_ptr_t<file_account_t> read_account_;
+    scoped_ptr_t<file_account_t> write_account_;
+    const int64_t capacity_;
+    log_serializer_stats_t *const stats_;
+
+    // By offset in the database file.
+    std::map<int64_t, entry_t> index_;
+    // The offsets in the database file of the blocks, by their offset in the cache
+    // file.  This finds the blocks that get overwritten.
+    std::map<int64_t, int64_t> by_cache_offset_;
+    int64_t write_head_;
+    uint64_t next_generation_;
+    size_t writes_in_flight_;
+    // The sizes of the writes to the cache file that have started but not finished,
+    // by their offset in it.  A write keeps its place even if its block is dropped.
+    std::map<int64_t, uint32_t> writes_in_progress_;
+
+    // The offsets that were read from the database file recently, with a sequence
+    // number each.  Oldest first.  `recent_reads_` can contain offsets that have been
+    // removed already, those aren't in `recent_read_index_` (under the same sequence
+    // number).
+    std::deque<std::pair<int64_t, uint64_t> > recent_reads_;
+    std::unordered_map<int64_t, uint64_t> recent_read_index_;
+    const size_t max_recent_reads_;
+    uint64_t next_recent_read_;
+
+    auto_drainer_t drainer_;
+
+    DISABLE_COPYING(flash_cache_t);
+};
+
+#endif  // SERIALIZER_LOG_FLASH_CACHE_HPP_
@@ -0,0 +1,109 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/gc_controller.hpp"
+
+#include <algorithm>
+
+// How often the controller adjusts the thresholds.
+const time_t GC_CONTROLLER_INTERVAL_SECS = 1;
+
+// How much the newest interval counts towards the moving averages of the write rates.
+constexpr double GC_CONTROLLER_RATE_WEIGHT = 0.5;
+
+// How much the controller changes the slack per interval, and the bounds of the
+// slack.  The start ratio can at most double, and drop to half of the target
+// garbage ratio.
+constexpr double GC_CONTROLLER_SLACK_STEP = 1.25;
+constexpr double GC_CONTROLLER_MIN_SLACK = 0.5;
+constexpr double GC_CONTROLLER_MAX_SLACK = 2.0;
+
+// The GC switches to high priority once the garbage ratio is this many times the
+// target garbage ratio (but never above the middle of the target and 1).
+constexpr double GC_CONTROLLER_HIGH_FACTOR = 3.0;
+
+namespace {
+
+double high_ratio_for_target(double target_garbage_ratio) {
+    return std::min(target_garbage_ratio * GC_CONTROLLER_HIGH_FACTOR,
+                    (target_garbage_ratio + 1.0) / 2.0);
+}
+
+}  // namespace
+
+data_gc_controller_t::data_gc_controller_t(double space_amplification_target,
+                                           double _write_amplification_target)
+    : target_garbage_ratio(1.0 - 1.0 / space_amplification_target),
+      high_garbage_ratio(high_ratio_for_target(target_garbage_ratio)),
+      write_amplification_target(_write_amplification_target),
+      slack(1.0),
+      interval_started(false),
+      interval_start({0}),
+      interval_foreground_bytes(0),
+      interval_gc_bytes(0),
+      foreground_rate(0.0),
+      gc_rate(0.0) {
+    guarantee(space_amplification_target > 1.0,
+              "The GC space amplification target must be greater than 1.");
+    guarantee(write_amplification_target >= 1.0,
+              "The GC write amplification target must be at least 1.");
+}
+
+void data_gc_controller_t::record_write(int64_t bytes, bool is_gc) {
+    rassert(bytes >= 0);
+    if (is_gc) {
+        interval_gc_bytes += bytes;
+    } else {
+        interval_foreground_bytes += bytes;
+    }
+}
+
+bool data_gc_controller_t::update(double garbage_ratio, ticks_t now) {
+    if (!interval_started) {
+        interval_started = true;
+        interval_start = now;
+        return false;
+    }
+    const int64_t elapsed_nanos = now.nanos - interval_start.nanos;
+    if (elapsed_nanos < secs_to_ticks(GC_CONTROLLER_INTERVAL_SECS).nanos) {
+        return false;
+    }
+
+    const double elapsed_secs = ticks_to_secs(ticks_t{elapsed_nanos});
+    foreground_rate = GC_CONTROLLER_RATE_WEIGHT * (interval_foreground_bytes / elapsed_secs)
+        + (1.0 - GC_CONTROLLER_RATE_WEIGHT) * foreground_rate;
+    gc_rate = GC_CONTROLLER_RATE_WEIGHT * (interval_gc_bytes / elapsed_secs)
+        + (1.0 - GC_CONTROLLER_RATE_WEIGHT) * gc_rate;
+    interval_start = now;
+    interval_foreground_bytes = 0;
+    interval_gc_bytes = 0;
+
+    if (write_amplification() > write_amplification_target) {
+        // The GC is too expensive, let it wait for more garbage.  There's no point in
+        // that once we are at the high ratio anyway.
+        if (garbage_ratio < high_garbage_ratio) {
+            slack = std::min(slack * GC_CONTROLLER_SLACK_STEP, GC_CONTROLLER_MAX_SLACK);
+        }
+    } else {
+        slack = std::max(slack / GC_CONTROLLER_SLACK_STEP, GC_CONTROLLER_MIN_SLACK);
+    }
+    return true;
+}
+
+double data_gc_controller_t::start_ratio() const {
+    // Stay below the high ratio, so that there's some room for scaling up the GC
+    // concurrency (see `data_block_manager_t::compute_gc_concurrency()`).
+    const double ratio = std::min(target_garbage_ratio * slack,
+                                  (target_garbage_ratio + high_garbage_ratio) / 2.0);
+    rassert(ratio < high_garbage_ratio);
+    return ratio;
+}
+
+double data_gc_controller_t::stop_ratio() const {
+    return start_ratio() / 2.0;
+}
+
+double data_gc_controller_t::write_amplification() const {
+    if (foreground_rate <= 0.0) {
+        return 1.0;
+    }
+    return (foreground_rate + gc_rate) / foreground_rate;
+}
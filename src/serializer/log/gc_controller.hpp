@@ -0,0 +1,66 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_GC_CONTROLLER_HPP_
+#define SERIALIZER_LOG_GC_CONTROLLER_HPP_
+
+#include <stdint.h>
+
+#include "errors.hpp"
+#include "time.hpp"
+
+/* Decides at which garbage ratios the data block GC starts, stops, and switches to its
+high priority i/o account.
+
+The garbage ratio that the GC aims for follows from the space amplification target
+(the size of the old data extents relative to the live data in them).  The controller
+also measures how much the GC writes compared to the foreground writes.  While that
+write amplification is above its target, it lets more garbage pile up before GCing,
+which makes every extent cheaper to collect.  While it's below the target (for example
+because there are few foreground writes), it GCs down to a lower garbage ratio instead.
+
+The ratio at which the GC switches to high priority only depends on the space target,
+so the file can't grow without bounds no matter how expensive the GC gets. */
+class data_gc_controller_t {
+public:
+    data_gc_controller_t(double space_amplification_target,
+                         double write_amplification_target);
+
+    // Counts `bytes` written to the data extents, either by the GC or by foreground
+    // writes.
+    void record_write(int64_t bytes, bool is_gc);
+
+    // Recomputes the write rates and the thresholds once every interval.  Returns true
+    // if it did.
+    bool update(double garbage_ratio, ticks_t now);
+
+    double start_ratio() const;
+    double stop_ratio() const;
+    double high_ratio() const { return high_garbage_ratio; }
+
+    double foreground_bytes_per_sec() const { return foreground_rate; }
+    double gc_bytes_per_sec() const { return gc_rate; }
+
+    // All bytes written divided by the foreground bytes written, or 1 if there were
+    // no foreground writes.
+    double write_amplification() const;
+
+private:
+    const double target_garbage_ratio;
+    const double high_garbage_ratio;
+    const double write_amplification_target;
+
+    // The start ratio is `target_garbage_ratio * slack`.
+    double slack;
+
+    bool interval_started;
+    ticks_t interval_start;
+    int64_t interval_foreground_bytes;
+    int64_t interval_gc_bytes;
+
+    // Moving averages of the write rates over the past intervals.
+    double foreground_rate;
+    double gc_rate;
+
+    DISABLE_COPYING(data_gc_controller_t);
+};
+
+#endif  // SERIALIZER_LOG_GC_CONTROLLER_HPP_
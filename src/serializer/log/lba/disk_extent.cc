@@ -67,7 +67,8 @@ void lba_disk_extent_t::read_step_1(read_info_t *info_out,
 }
 
 void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index) {
-    em->assert_thread();
+    // This runs on whichever thread `lba_disk_structure_t::read()` applies the
+    // entries on, so it must not touch `em` or anything else thread-bound.
     lba_extent_t *extent = info->buffer.get();
     guarantee(memcmp(extent->header.magic, lba_magic, LBA_MAGIC_SIZE) == 0);
 
@@ -78,8 +79,11 @@ void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index)
             // We've never actually used them, and we now use 16 bit block sizes
             // for the in-memory index to save a few bytes.
             guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+            guarantee(e->compressed_ser_block_size < e->ser_block_size
+                      || e->compressed_ser_block_size == 0);
             index->set_block_info(e->block_id, e->recency, e->offset,
-                                  static_cast<uint16_t>(e->ser_block_size));
+                                  static_cast<uint16_t>(e->ser_block_size),
+                                  static_cast<uint16_t>(e->compressed_ser_block_size));
         }
     }
 
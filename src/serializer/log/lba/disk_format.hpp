@@ -4,6 +4,7 @@
 
 #include <limits.h>
 
+#include "serializer/checksum.hpp"
 #include "serializer/serializer.hpp"
 
 
@@ -60,9 +61,11 @@ ATTR_PACKED(struct lba_entry_t {
     // (It probably assumes that sizeof(lba_entry_t) evenly divides
     // DEVICE_BLOCK_SIZE).
 
-    // Put the zero-padding at the beginning of the LBA entry.  We could use this, or
-    // the first 16 bits, perhaps, as a version flag.
-    uint32_t zero_reserved;
+    // The size the block takes up in the data file if the serializer stored it
+    // compressed (see serializer/compression.hpp), or 0 if it's stored as it is.
+    // This used to be zero padding, so LBA entries written by older versions read
+    // as uncompressed.
+    uint32_t compressed_ser_block_size;
 
     // This could be a uint16_t if you wanted it to be, as long as block sizes are
     // all less than or equal to 4K (which is less than 64K).
@@ -76,10 +79,13 @@ ATTR_PACKED(struct lba_entry_t {
     flagged_off64_t offset;
 
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint16_t ser_block_size) {
+                            flagged_off64_t offset, uint16_t ser_block_size,
+                            uint16_t compressed_ser_block_size = 0) {
         guarantee(ser_block_size != 0 || !offset.has_value());
+        guarantee(compressed_ser_block_size < ser_block_size
+                  || compressed_ser_block_size == 0);
         lba_entry_t entry;
-        entry.zero_reserved = 0;
+        entry.compressed_ser_block_size = compressed_ser_block_size;
         entry.ser_block_size = ser_block_size;
         entry.block_id = block_id;
         entry.recency = recency;
@@ -105,12 +111,19 @@ ATTR_PACKED(struct lba_shard_metablock_t {
      * reference to the clean extent. */
     int64_t last_lba_extent_offset;
     int32_t last_lba_extent_entries_count;
-    int32_t padding1;
+
+    /* The number of the extent (its offset divided by the extent size) that holds
+     * the directory of the shard's LBA snapshot, or 0 if there is no snapshot.  The
+     * first extent holds the metablocks, so it can never hold a snapshot.  These
+     * used to be padding fields set to 0. */
+    int32_t snapshot_directory_extent;
 
     /* Reference to the LBA superblock and its size */
     int64_t lba_superblock_offset;
     int32_t lba_superblock_entries_count;
-    int32_t padding2;
+
+    /* The number of extents in the LBA snapshot. */
+    int32_t snapshot_extents_count;
 });
 
 
@@ -170,6 +183,52 @@ struct lba_superblock_t {
 };
 
 
+/* An LBA snapshot holds the in-memory index of one LBA shard, as it was some time
+ * after every entry in the LBA extents that were discarded when the snapshot was
+ * written (see `lba_snapshot_t`).  The entries are stored densely, by position:
+ * first the entries for block ids `shard`, `shard + LBA_SHARD_FACTOR`, ..., then the
+ * ones for aux block ids `FIRST_AUX_BLOCK_ID + shard`, and so on.  Unused block ids
+ * have unused offsets. */
+ATTR_PACKED(struct lba_snapshot_entry_t {
+    flagged_off64_t offset;
+    repli_timestamp_t recency;
+    uint16_t ser_block_size;
+    // See `lba_entry_t::compressed_ser_block_size`.
+    uint16_t compressed_ser_block_size;
+});
+
+#define LBA_SNAPSHOT_MAGIC_SIZE 8
+static const char lba_snapshot_magic[LBA_SNAPSHOT_MAGIC_SIZE] = {'l', 'b', 'a', 's', 'n', 'a', 'p', 'e'};
+static const char lba_snapshot_directory_magic[LBA_SNAPSHOT_MAGIC_SIZE] = {'l', 'b', 'a', 's', 'n', 'a', 'p', 'd'};
+
+// A snapshot extent is padded with zeros to a multiple of DEVICE_BLOCK_SIZE.
+ATTR_PACKED(struct lba_snapshot_extent_t {
+    char magic[LBA_SNAPSHOT_MAGIC_SIZE];
+    lba_snapshot_entry_t entries[0];
+});
+
+ATTR_PACKED(struct lba_snapshot_directory_entry_t {
+    int64_t offset;
+    int64_t entries_count;
+    // The checksum of the padded extent contents, in the file's checksum algorithm.
+    serializer_checksum checksum;
+});
+
+ATTR_PACKED(struct lba_snapshot_directory_t {
+    char magic[LBA_SNAPSHOT_MAGIC_SIZE];
+    int32_t shard;
+    int32_t padding;
+    // How many entries there are for regular and aux block ids.
+    int64_t entries_count;
+    int64_t aux_entries_count;
+    // In the order of the entries they contain.
+    lba_snapshot_directory_entry_t extents[0];
+
+    static size_t extents_count_to_file_size(int64_t nextents) {
+        return offsetof(lba_snapshot_directory_t, extents[0])
+            + sizeof(lba_snapshot_directory_entry_t) * nextents;
+    }
+});
 
 #endif  // SERIALIZER_LOG_LBA_DISK_FORMAT_HPP_
 
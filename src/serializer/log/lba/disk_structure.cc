@@ -3,11 +3,13 @@
 
 #include <algorithm>
 
+#include "arch/runtime/coroutines.hpp"
 #include "containers/scoped.hpp"
 #include "math.hpp"
 
 lba_disk_structure_t::lba_disk_structure_t(extent_manager_t *_em, file_t *_file)
-    : em(_em), file(_file), superblock_extent(nullptr), last_extent(nullptr)
+    : em(_em), file(_file), superblock_extent(nullptr), last_extent(nullptr),
+      snapshot(nullptr)
 {
 }
 
@@ -22,6 +24,12 @@ lba_disk_structure_t::lba_disk_structure_t(extent_manager_t *_em, file_t *_file,
         last_extent = nullptr;
     }
 
+    if (lba_snapshot_t::metablock_has_snapshot(metablock)) {
+        snapshot = new lba_snapshot_t(em, file, metablock);
+    } else {
+        snapshot = nullptr;
+    }
+
     if (metablock->lba_superblock_offset != NULL_OFFSET) {
         superblock_offset = metablock->lba_superblock_offset;
         startup_superblock_count = metablock->lba_superblock_entries_count;
@@ -70,6 +78,7 @@ void lba_disk_structure_t::on_extent_read() {
 
 void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t recency,
                                      flagged_off64_t offset, uint16_t ser_block_size,
+                                     uint16_t compressed_ser_block_size,
                                      file_account_t *io_account,
                                      extent_transaction_t *txn,
                                      optional<std::vector<checksum_filerange>> *checksums) {
@@ -91,7 +100,8 @@ void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t rece
 
     rassert(!last_extent->full());
 
-    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size),
+    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size,
+                                             compressed_ser_block_size),
                            io_account, checksums);
 }
 
@@ -116,6 +126,14 @@ void lba_disk_structure_t::destroy_extents(
     write_superblock(io_account, txn, checksums);
 }
 
+void lba_disk_structure_t::set_snapshot(lba_snapshot_t *new_snapshot,
+                                        extent_transaction_t *txn) {
+    if (snapshot != nullptr) {
+        snapshot->destroy(txn);
+    }
+    snapshot = new_snapshot;
+}
+
 void lba_disk_structure_t::write_superblock(
         file_account_t *io_account,
         extent_transaction_t *txn,
@@ -224,6 +242,7 @@ struct reader_t
     lba_disk_structure_t *ds;   // The disk structure we are reading from
     in_memory_index_t *index;   // The in-memory-index we are reading into
     lba_disk_structure_t::read_callback_t *rcb;   // Who to call back when we finish
+    threadnum_t apply_thread;   // The thread on which we write into the index
 
     /* extent_reader_t takes care of reading a single extent. */
     struct extent_reader_t :
@@ -269,7 +288,23 @@ struct reader_t
             if (have_read) done();
         }
         void done() {
-            extent->read_step_2(&read_info, parent->index);
+            if (parent->apply_thread == get_thread_id()) {
+                extent->read_step_2(&read_info, parent->index);
+                finish();
+            } else {
+                // Apply the extent on `apply_thread`, so that the shards of the index
+                // get filled in parallel.  The next extent waits for `finish()`, so
+                // there is never more than one coroutine doing this per shard.
+                coro_t::spawn_sometime([this]() {
+                    {
+                        on_thread_t thread_switcher(parent->apply_thread);
+                        extent->read_step_2(&read_info, parent->index);
+                    }
+                    finish();
+                });
+            }
+        }
+        void finish() {
             parent->active_readers--;
             parent->start_more_readers();
             if (index == static_cast<int>(parent->readers.size()) - 1) {
@@ -289,8 +324,9 @@ struct reader_t
     // throttle the reading process so that we stay under LBA_READ_BUFFER_SIZE.
     int active_readers;
 
-    reader_t(lba_disk_structure_t *_ds, in_memory_index_t *_index, lba_disk_structure_t::read_callback_t *cb)
-        : ds(_ds), index(_index), rcb(cb)
+    reader_t(lba_disk_structure_t *_ds, in_memory_index_t *_index,
+             threadnum_t _apply_thread, lba_disk_structure_t::read_callback_t *cb)
+        : ds(_ds), index(_index), rcb(cb), apply_thread(_apply_thread)
     {
         for (lba_disk_extent_t *e = ds->extents_in_superblock.head();
              e != nullptr; e = ds->extents_in_superblock.next(e)) {
@@ -302,6 +338,18 @@ struct reader_t
         now we have a vector with an extent_reader_t object for each extent we need to
         read, but none of them have been started yet. */
 
+        if (ds->snapshot != nullptr) {
+            // The extents have to be applied on top of the snapshot.
+            coro_t::spawn_sometime([this]() {
+                ds->snapshot->co_read(index, apply_thread);
+                start_readers();
+            });
+        } else {
+            start_readers();
+        }
+    }
+
+    void start_readers() {
         if (readers.empty()) {
             done();
         } else {
@@ -325,8 +373,9 @@ struct reader_t
     }
 };
 
-void lba_disk_structure_t::read(in_memory_index_t *index, read_callback_t *cb) {
-    new reader_t(this, index, cb);
+void lba_disk_structure_t::read(in_memory_index_t *index, threadnum_t apply_thread,
+                                read_callback_t *cb) {
+    new reader_t(this, index, apply_thread, cb);
 }
 
 void lba_disk_structure_t::prepare_metablock(lba_shard_metablock_t *mb_out) {
@@ -348,6 +397,13 @@ void lba_disk_structure_t::prepare_metablock(lba_shard_metablock_t *mb_out) {
         mb_out->lba_superblock_offset = NULL_OFFSET;
         mb_out->lba_superblock_entries_count = 0;
     }
+
+    if (snapshot != nullptr) {
+        snapshot->prepare_metablock(mb_out);
+    } else {
+        mb_out->snapshot_directory_extent = 0;
+        mb_out->snapshot_extents_count = 0;
+    }
 }
 
 int lba_disk_structure_t::num_entries_that_can_fit_in_an_extent() const {
@@ -368,6 +424,10 @@ void lba_disk_structure_t::destroy(extent_transaction_t *txn) {
         last_extent->destroy(txn);
     }
 
+    if (snapshot) {
+        snapshot->destroy(txn);
+    }
+
     delete this;
 }
 
@@ -378,5 +438,6 @@ void lba_disk_structure_t::shutdown() {
         e->shutdown();
     }
     if (last_extent) last_extent->shutdown();
+    if (snapshot) snapshot->shutdown();
     delete this;
 }
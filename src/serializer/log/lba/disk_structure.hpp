@@ -8,6 +8,7 @@
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 #include "serializer/log/lba/disk_extent.hpp"
+#include "serializer/log/lba/snapshot.hpp"
 #include "serializer/log/types.hpp"
 
 class lba_load_fsm_t;
@@ -35,6 +36,7 @@ public:
     // Put entries in an LBA and then call wait_for_write_completion() to write to disk
     void add_entry(block_id_t block_id, repli_timestamp_t recency,
                    flagged_off64_t offset, uint16_t ser_block_size,
+                   uint16_t compressed_ser_block_size,
                    file_account_t *io_account,
                    extent_transaction_t *txn,
                    optional<std::vector<checksum_filerange>> *checksums);
@@ -58,13 +60,23 @@ public:
                          file_account_t *io_account, extent_transaction_t *txn,
                          optional<std::vector<checksum_filerange>> *checksums);
 
-    // If you call read(), then the in_memory_index_t will be populated and then the
-    // read_callback_t will be called when it is done.
+    // Replaces the snapshot (if there is one) with `new_snapshot`, which must be
+    // completely written.  This is done together with `destroy_extents()` on the
+    // extents that the new snapshot covers.
+    void set_snapshot(lba_snapshot_t *new_snapshot, extent_transaction_t *txn);
+
+    // If you call read(), then the in_memory_index_t will be populated (first from
+    // the snapshot, then from the extents) and then the read_callback_t will be
+    // called when it is done.  The entries are written into
+    // the index on `apply_thread`; the callback is called on the home thread.  Only
+    // this structure's shard of the index is touched, so the shards can be read
+    // concurrently on different threads.
     struct read_callback_t {
         virtual void on_lba_extents_read() = 0;
         virtual ~read_callback_t() {}
     };
-    void read(in_memory_index_t *index, read_callback_t *cb);
+    void read(in_memory_index_t *index, threadnum_t apply_thread,
+              read_callback_t *cb);
 
     void prepare_metablock(lba_shard_metablock_t *mb_out);
 
@@ -80,6 +92,7 @@ public:
     int64_t superblock_offset;
     intrusive_list_t<lba_disk_extent_t> extents_in_superblock;
     lba_disk_extent_t *last_extent;
+    lba_snapshot_t *snapshot;   // Can be NULL
 
 private:
     /* Prepares and writes a new superblock. */
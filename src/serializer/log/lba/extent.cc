@@ -42,7 +42,9 @@ struct extent_block_t :
 
         int64_t file_offset = parent->extent_ref.offset() + offset;
         if (checksums->has_value()) {
-            serializer_checksum chksum = compute_checksum(data.get(), DEVICE_BLOCK_SIZE / serializer_checksum::word_size);
+            serializer_checksum chksum = compute_checksum(parent->em->checksum_algorithm,
+                                                          data.get(),
+                                                          DEVICE_BLOCK_SIZE / serializer_checksum::word_size);
             (*checksums)->push_back(
                     checksum_filerange{file_offset, DEVICE_BLOCK_SIZE, chksum});
         }
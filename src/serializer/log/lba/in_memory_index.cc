@@ -3,50 +3,212 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
+#include "math.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 
-in_memory_index_t::in_memory_index_t()
-    : end_block_id_(0), end_aux_block_id_(FIRST_AUX_BLOCK_ID) { }
+in_memory_index_t::in_memory_index_t() { }
+
+// Aux block ids are sharded by their relative id, which gives the same shards because
+// FIRST_AUX_BLOCK_ID is a multiple of LBA_SHARD_FACTOR.
+CT_ASSERT(FIRST_AUX_BLOCK_ID % LBA_SHARD_FACTOR == 0);
 
 block_id_t in_memory_index_t::end_block_id() {
-    return end_block_id_;
+    block_id_t ret = 0;
+    for (int i = 0; i < LBA_SHARD_FACTOR; ++i) {
+        ret = std::max(ret, shards_[i].end_block_id);
+    }
+    return ret;
 }
 
 block_id_t in_memory_index_t::end_aux_block_id() {
-    return end_aux_block_id_;
+    block_id_t ret = FIRST_AUX_BLOCK_ID;
+    for (int i = 0; i < LBA_SHARD_FACTOR; ++i) {
+        ret = std::max(ret, shards_[i].end_aux_block_id);
+    }
+    return ret;
+}
+
+// The largest offset in `DEVICE_BLOCK_SIZE` units that fits into the 40 bits, after
+// adding one.
+static const int64_t MAX_PACKED_DBLOCK_OFFSET = (int64_t(1) << 40) - 2;
+static const uint32_t PACKED_RECENCY_DISTANT_PAST = UINT32_MAX;
+// How far below the first recency a shard sees, or the recency that made it move the
+// base, we put its base.  Recencies only grow, but the LBA is read in no particular
+// order at startup.
+static const uint64_t RECENCY_BASE_SLACK = uint64_t(1) << 31;
+
+static repli_timestamp_t recency_base_for(repli_timestamp_t recency) {
+    repli_timestamp_t base;
+    base.longtime = recency.longtime > RECENCY_BASE_SLACK
+        ? recency.longtime - RECENCY_BASE_SLACK
+        : 0;
+    return base;
+}
+
+bool in_memory_index_t::pack_aux(shard_t *shard, const index_block_info_t &info,
+                                 packed_aux_block_info_t *packed_out) {
+    uint64_t dblock_offset_plus_one = 0;
+    if (info.offset.the_value_ != -1) {
+        if (!info.offset.has_value()
+            || info.offset.get_value() % DEVICE_BLOCK_SIZE != 0
+            || info.offset.get_value() / DEVICE_BLOCK_SIZE > MAX_PACKED_DBLOCK_OFFSET) {
+            return false;
+        }
+        dblock_offset_plus_one = info.offset.get_value() / DEVICE_BLOCK_SIZE + 1;
+    }
+    for (size_t i = 0; i < sizeof(packed_out->dblock_offset_plus_one); ++i) {
+        packed_out->dblock_offset_plus_one[i] = dblock_offset_plus_one >> (8 * i);
+    }
+
+    if (info.ser_block_size == 0) {
+        packed_out->size_class = 0;
+    } else {
+        auto it = std::find(shard->size_classes.begin(), shard->size_classes.end(),
+                            info.ser_block_size);
+        if (it == shard->size_classes.end()) {
+            if (shard->size_classes.size() + 1 >= OVERFLOW_SIZE_CLASS) {
+                return false;
+            }
+            // Size classes are never removed or reordered, since entries refer to
+            // them by index.
+            shard->size_classes.push_back(info.ser_block_size);
+            it = shard->size_classes.end() - 1;
+        }
+        packed_out->size_class = (it - shard->size_classes.begin()) + 1;
+    }
+    packed_out->compressed_ser_block_size = info.compressed_ser_block_size;
+    return true;
+}
+
+uint32_t in_memory_index_t::pack_recency(shard_t *shard, repli_timestamp_t recency) {
+    if (recency == repli_timestamp_t::invalid) {
+        return 0;
+    }
+    if (recency == repli_timestamp_t::distant_past) {
+        return PACKED_RECENCY_DISTANT_PAST;
+    }
+    if (shard->recency_base == repli_timestamp_t::invalid) {
+        shard->recency_base = recency_base_for(recency);
+    }
+    if (recency.longtime - std::min(recency.longtime, shard->recency_base.longtime) + 1
+        >= PACKED_RECENCY_DISTANT_PAST) {
+        rebase_recencies(shard, recency_base_for(recency));
+    }
+    // Raising a recency is safe, since backfills only skip blocks whose recency is
+    // older than what the backfillee has.
+    const uint64_t delta =
+        std::max(recency.longtime, shard->recency_base.longtime)
+        - shard->recency_base.longtime;
+    return delta + 1;
+}
+
+void in_memory_index_t::rebase_recencies(shard_t *shard, repli_timestamp_t new_base) {
+    rassert(shard->recency_base < new_base);
+    const uint64_t shift = new_base.longtime - shard->recency_base.longtime;
+    shard->recency_base = new_base;
+    const block_id_t end = ceil_divide(shard->end_block_id, LBA_SHARD_FACTOR);
+    for (block_id_t i = 0; i < end; ++i) {
+        packed_block_info_t packed = shard->infos.get(i);
+        if (packed.recency != 0 && packed.recency != PACKED_RECENCY_DISTANT_PAST) {
+            packed.recency = packed.recency - 1 > shift
+                ? packed.recency - shift
+                : 1;
+            shard->infos.set(i, packed);
+        }
+    }
+}
+
+index_block_info_t in_memory_index_t::unpack(const shard_t &shard,
+                                             const packed_aux_block_info_t &packed,
+                                             uint32_t recency) {
+    uint64_t dblock_offset_plus_one = 0;
+    for (size_t i = 0; i < sizeof(packed.dblock_offset_plus_one); ++i) {
+        dblock_offset_plus_one |=
+            static_cast<uint64_t>(packed.dblock_offset_plus_one[i]) << (8 * i);
+    }
+    index_block_info_t info;
+    if (dblock_offset_plus_one != 0) {
+        info.offset = flagged_off64_t::make(
+            (dblock_offset_plus_one - 1) * DEVICE_BLOCK_SIZE);
+    }
+    if (recency == PACKED_RECENCY_DISTANT_PAST) {
+        info.recency = repli_timestamp_t::distant_past;
+    } else if (recency != 0) {
+        info.recency.longtime = shard.recency_base.longtime + (recency - 1);
+    }
+    info.ser_block_size = packed.size_class == 0
+        ? 0
+        : shard.size_classes[packed.size_class - 1];
+    info.compressed_ser_block_size = packed.compressed_ser_block_size;
+    return info;
 }
 
 index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
+    const shard_t &shard = shards_[id % LBA_SHARD_FACTOR];
+    packed_aux_block_info_t aux;
+    uint32_t recency;
     if (is_aux_block_id(id)) {
-        index_aux_block_info_t aux_info
-            = aux_infos_.get(make_aux_block_id_relative(id));
-        return index_block_info_t(aux_info.offset,
-                                  repli_timestamp_t::invalid,
-                                  aux_info.ser_block_size);
+        aux = shard.aux_infos.get(make_aux_block_id_relative(id) / LBA_SHARD_FACTOR);
+        recency = 0;
     } else {
-        return infos_.get(id);
+        packed_block_info_t packed = shard.infos.get(id / LBA_SHARD_FACTOR);
+        aux = packed.aux;
+        recency = packed.recency;
     }
+    if (aux.size_class == OVERFLOW_SIZE_CLASS) {
+        auto it = shard.overflow.find(id);
+        guarantee(it != shard.overflow.end());
+        return it->second;
+    }
+    return unpack(shard, aux, recency);
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
                                        flagged_off64_t offset,
-                                       uint16_t ser_block_size) {
+                                       uint16_t ser_block_size,
+                                       uint16_t compressed_ser_block_size) {
+    shard_t *shard = &shards_[id % LBA_SHARD_FACTOR];
     if (is_aux_block_id(id)) {
-        if (id >= end_aux_block_id_) {
-            end_aux_block_id_ = id + 1;
+        if (id >= shard->end_aux_block_id) {
+            shard->end_aux_block_id = id + 1;
         }
         // If you're trying to set the timestamp of  an aux block to anything
         // other than `invalid`, you might be doing something wrong. It will be
         // discarded anyway.
         rassert(recency == repli_timestamp_t::invalid);
-        index_aux_block_info_t info(offset, ser_block_size);
-        aux_infos_.set(make_aux_block_id_relative(id), info);
+        recency = repli_timestamp_t::invalid;
     } else {
-        if (id >= end_block_id_) {
-            end_block_id_ = id + 1;
+        if (id >= shard->end_block_id) {
+            shard->end_block_id = id + 1;
         }
-        index_block_info_t info(offset, recency, ser_block_size);
-        infos_.set(id, info);
+    }
+
+    const index_block_info_t info(offset, recency, ser_block_size,
+                                  compressed_ser_block_size);
+    packed_block_info_t packed;
+    if (pack_aux(shard, info, &packed.aux)) {
+        packed.recency = pack_recency(shard, recency);
+        shard->overflow.erase(id);
+    } else {
+        packed = packed_block_info_t();
+        packed.aux.size_class = OVERFLOW_SIZE_CLASS;
+        shard->overflow[id] = info;
+    }
+
+    if (is_aux_block_id(id)) {
+        shard->aux_infos.set(make_aux_block_id_relative(id) / LBA_SHARD_FACTOR,
+                             packed.aux);
+    } else {
+        shard->infos.set(id / LBA_SHARD_FACTOR, packed);
     }
 }
 
+size_t in_memory_index_t::overflow_size() const {
+    size_t ret = 0;
+    for (int i = 0; i < LBA_SHARD_FACTOR; ++i) {
+        ret += shards_[i].overflow.size();
+    }
+    return ret;
+}
@@ -2,6 +2,11 @@
 #ifndef SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 #define SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 
+#include <string.h>
+
+#include <map>
+#include <vector>
+
 #include "arch/compiler.hpp"
 #include "containers/two_level_array.hpp"
 #include "config/args.hpp"
@@ -12,57 +17,120 @@ ATTR_PACKED(struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          compressed_ser_block_size(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint16_t _ser_block_size)
+                       uint16_t _ser_block_size,
+                       uint16_t _compressed_ser_block_size)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          compressed_ser_block_size(_compressed_ser_block_size) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            compressed_ser_block_size == other.compressed_ser_block_size;
     }
 
-    flagged_off64_t offset;
-    repli_timestamp_t recency;
-    uint16_t ser_block_size;
-});
-
-/* This is a reduced-size block info for auxiliary blocks (currently
-blob blocks used for large values). It doesn't store a replication
-timestamp, because we don't need it for those blocks. */
-ATTR_PACKED(struct index_aux_block_info_t {
-    index_aux_block_info_t()
-        : offset(flagged_off64_t::unused()),
-          ser_block_size(0) { }
-
-    index_aux_block_info_t(flagged_off64_t _offset,
-                           uint16_t _ser_block_size)
-        : offset(_offset),
-          ser_block_size(_ser_block_size) { }
-
-    // For two_level_array_t.
-    bool operator==(const index_aux_block_info_t &other) const {
-        return offset == other.offset &&
-            ser_block_size == other.ser_block_size;
+    // The size of the block in the data file.
+    uint16_t ondisk_ser_block_size() const {
+        return compressed_ser_block_size != 0
+            ? compressed_ser_block_size
+            : ser_block_size;
     }
 
     flagged_off64_t offset;
+    repli_timestamp_t recency;
     uint16_t ser_block_size;
+    // See `lba_entry_t::compressed_ser_block_size`.
+    uint16_t compressed_ser_block_size;
 });
 
-
-
+/* The index is split into the same LBA_SHARD_FACTOR shards as the LBA on disk, by
+block id.  Each shard is a separate data structure, so that the shards can be filled
+from different threads while the LBA is being read at startup (see
+`lba_disk_structure_t::read()`), as long as each shard is only touched by one thread
+at a time. */
 class in_memory_index_t {
-    two_level_array_t<index_block_info_t> infos_;
-    block_id_t end_block_id_;
-    two_level_array_t<index_aux_block_info_t> aux_infos_;
-    block_id_t end_aux_block_id_;
+    /* There is an entry for every block id, so the entries are packed into 12 bytes
+    (8 for aux blocks, which have no recency) instead of the 20 of an
+    `index_block_info_t`:
+     - The offset is counted in `DEVICE_BLOCK_SIZE` units, which all blocks are
+       aligned to, plus one so that 0 can mean "unused".  40 bits of that cover
+       512 TB.
+     - The recency is stored relative to a base that the shard picks when it first
+       sees a recency, plus one so that 0 can mean `invalid`.  `UINT32_MAX` means
+       `distant_past`.  A recency below the base is raised to the base, which only
+       makes backfills send the block when they wouldn't have to.  A recency too far
+       above it moves the base up, and the shard's recencies are packed again.
+     - The serialized block size is an index into the shard's `size_classes`, since a
+       serializer only ever writes a few different sizes uncompressed, and 0 means 0.
+    Anything that doesn't fit goes into the shard's `overflow` map, and its entry
+    gets the size class `OVERFLOW_SIZE_CLASS`.  That leaves the default value of an
+    entry, all zeros, to mean `index_block_info_t()`. */
+    static const uint8_t OVERFLOW_SIZE_CLASS = 255;
+
+    ATTR_PACKED(struct packed_aux_block_info_t {
+        packed_aux_block_info_t() : size_class(0), compressed_ser_block_size(0) {
+            memset(dblock_offset_plus_one, 0, sizeof(dblock_offset_plus_one));
+        }
+        bool operator==(const packed_aux_block_info_t &other) const {
+            return memcmp(this, &other, sizeof(*this)) == 0;
+        }
+
+        uint8_t dblock_offset_plus_one[5];
+        uint8_t size_class;
+        uint16_t compressed_ser_block_size;
+    });
+
+    ATTR_PACKED(struct packed_block_info_t {
+        packed_block_info_t() : recency(0) { }
+        bool operator==(const packed_block_info_t &other) const {
+            return memcmp(this, &other, sizeof(*this)) == 0;
+        }
+
+        packed_aux_block_info_t aux;
+        uint32_t recency;
+    });
+
+    /* Every shard only holds every LBA_SHARD_FACTOR-th block id, so its chunks are
+    smaller by the same factor.  Otherwise even a table with only a few blocks would
+    have a full-size chunk in every shard. */
+    static const size_t SHARD_CHUNK_SIZE = (1 << 14) / LBA_SHARD_FACTOR;
+
+    struct shard_t {
+        shard_t()
+            : end_block_id(0), end_aux_block_id(FIRST_AUX_BLOCK_ID),
+              recency_base(repli_timestamp_t::invalid) { }
+
+        // Indexed by block id / LBA_SHARD_FACTOR.
+        two_level_array_t<packed_block_info_t, SHARD_CHUNK_SIZE> infos;
+        block_id_t end_block_id;
+        // Indexed by the relative aux block id / LBA_SHARD_FACTOR.
+        two_level_array_t<packed_aux_block_info_t, SHARD_CHUNK_SIZE> aux_infos;
+        block_id_t end_aux_block_id;
+
+        std::vector<uint16_t> size_classes;
+        // `invalid` until the shard has seen a recency to pick it by.
+        repli_timestamp_t recency_base;
+        // Indexed by block id, including aux block ids.
+        std::map<block_id_t, index_block_info_t> overflow;
+    };
+
+    static bool pack_aux(shard_t *shard, const index_block_info_t &info,
+                         packed_aux_block_info_t *packed_out);
+    static uint32_t pack_recency(shard_t *shard, repli_timestamp_t recency);
+    static void rebase_recencies(shard_t *shard, repli_timestamp_t new_base);
+    static index_block_info_t unpack(const shard_t &shard,
+                                     const packed_aux_block_info_t &packed,
+                                     uint32_t recency);
+
+    shard_t shards_[LBA_SHARD_FACTOR];
 
 public:
     in_memory_index_t();
@@ -73,8 +141,12 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint16_t ser_block_size);
+                        flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t compressed_ser_block_size);
 
+    // The number of entries that didn't fit into the packed format.  Exposed for
+    // unit tests.
+    size_t overflow_size() const;
 };
 
 #endif  // SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
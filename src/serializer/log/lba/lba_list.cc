@@ -11,8 +11,10 @@
 // TODO: Some of the code in this file is bullshit disgusting shit.
 
 lba_list_t::lba_list_t(extent_manager_t *em,
-        const lba_list_t::write_metablock_fun_t &_write_metablock_fun)
+        const lba_list_t::write_metablock_fun_t &_write_metablock_fun,
+        const lba_list_t::snapshot_written_fun_t &_snapshot_written_fun)
     : gc_drainer(new auto_drainer_t), write_metablock_fun(_write_metablock_fun),
+      snapshot_written_fun(_snapshot_written_fun),
       extent_manager(em), state(state_unstarted), inline_lba_entries_count(0)
 {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
@@ -28,6 +30,8 @@ void lba_list_t::prepare_initial_metablock(lba_metablock_mixin_t *mb_out) {
         mb_out->shards[i].lba_superblock_entries_count = 0;
         mb_out->shards[i].last_lba_extent_offset = NULL_OFFSET;
         mb_out->shards[i].last_lba_extent_entries_count = 0;
+        mb_out->shards[i].snapshot_directory_extent = 0;
+        mb_out->shards[i].snapshot_extents_count = 0;
     }
     mb_out->inline_lba_entries_count = 0;
     memset(mb_out->inline_lba_entries,
@@ -85,9 +89,14 @@ public:
         rassert(cbs_out > 0);
         cbs_out--;
         if (cbs_out == 0) {
+            // Each shard of the in-memory index gets filled in on a different
+            // thread, starting with the one after ours.
             cbs_out = LBA_SHARD_FACTOR;
             for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
-                owner->disk_structures[i]->read(&owner->in_memory_index, this);
+                threadnum_t apply_thread(
+                    (get_thread_id().threadnum + 1 + i) % get_num_threads());
+                owner->disk_structures[i]->read(&owner->in_memory_index,
+                                                apply_thread, this);
             }
         }
     }
@@ -105,11 +114,14 @@ public:
                 // We've never actually used them, and we now use 16 bit block sizes
                 // for the in-memory index to save a few bytes.
                 guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+                guarantee(e->compressed_ser_block_size < e->ser_block_size
+                          || e->compressed_ser_block_size == 0);
                 owner->in_memory_index.set_block_info(
                         e->block_id,
                         e->recency,
                         e->offset,
-                        static_cast<uint16_t>(e->ser_block_size));
+                        static_cast<uint16_t>(e->ser_block_size),
+                        static_cast<uint16_t>(e->compressed_ser_block_size));
             }
 
             owner->state = lba_list_t::state_ready;
@@ -124,7 +136,9 @@ bool lba_list_t::start_existing(file_t *file, lba_metablock_mixin_t *last_metabl
     rassert(state == state_unstarted);
 
     dbfile = file;
-    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY));
+    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY,
+                                          UNLIMITED_OUTSTANDING_REQUESTS,
+                                          io_class_t::background));
 
     lba_start_fsm_t *starter = new lba_start_fsm_t(this, last_metablock);
     if (state == state_ready) {
@@ -164,6 +178,10 @@ block_size_t lba_list_t::get_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
+block_size_t lba_list_t::get_ondisk_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).ondisk_ser_block_size());
+}
+
 repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
     return get_block_info(block).recency;
 }
@@ -192,11 +210,13 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t compressed_ser_block_size,
                                 file_account_t *io_account, extent_transaction_t *txn,
                                 optional<std::vector<checksum_filerange>> *checksums) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   compressed_ser_block_size);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -205,7 +225,8 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size,
+                     compressed_ser_block_size);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -245,6 +266,7 @@ void lba_list_t::move_inline_entries_to_extents(
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.compressed_ser_block_size,
                 io_account,
                 txn,
                 checksums);
@@ -254,11 +276,13 @@ void lba_list_t::move_inline_entries_to_extents(
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size) {
+                                flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t compressed_ser_block_size) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size,
+                              compressed_ser_block_size);
 }
 
 class lba_writer_t :
@@ -330,72 +354,24 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
     // No checksumming in LBA gc, thank you.
     optional<std::vector<checksum_filerange>> checksums = r_nullopt;
 
-    // Start a transaction
-    std::vector<scoped_ptr_t<extent_transaction_t> > txns;
-    txns.push_back(make_scoped<extent_transaction_t>());
-    extent_manager->begin_transaction(txns.back().get());
-
-    // Fetch a list of current LBA extents, minus the active one
+    // Fetch a list of current LBA extents, minus the active one.  Everything in them,
+    // and in the current snapshot, is older than whatever we're going to put into the
+    // new snapshot, so the new snapshot replaces them.  The active extent (and any
+    // extents that fill up while we're writing the snapshot) have to be kept, because
+    // they may contain changes that the snapshot misses.
     const std::set<lba_disk_extent_t *> gced_extents =
         disk_structures[lba_shard]->get_inactive_extents();
 
-    // Begin rewriting all LBA entries, one batch of entries at a time.
-    int num_written_in_batch = 0;
+    // Write the snapshot, one batch of entries at a time.
+    lba_snapshot_t *snapshot = new lba_snapshot_t(extent_manager, dbfile, lba_shard,
+                                                  end_block_id(), end_aux_block_id());
     bool aborted = false;
-    const block_id_t end_id = end_block_id();
-    const block_id_t aux_end_id = end_aux_block_id();
-    guarantee(aux_end_id >= end_id);
-    for (block_id_t id = lba_shard; ; id += LBA_SHARD_FACTOR) {
-        // Once we are done with the regular block IDs, continue with the aux
-        // block IDs.
-        // This assertion makes sure that we can simply restart at
-        // `lba_shard + FIRST_AUX_BLOCK_ID` and still be on the correct shard.
-        CT_ASSERT(FIRST_AUX_BLOCK_ID % LBA_SHARD_FACTOR == 0);
-        if (!is_aux_block_id(id) && id >= end_id) {
-            id = lba_shard + FIRST_AUX_BLOCK_ID;
-        }
-
-        if (id >= aux_end_id) {
-            break;
-        }
+    for (int64_t i = 0; i < snapshot->total_entries_count(); ++i) {
+        snapshot->add_entry(get_block_info(snapshot->block_id_at(i)),
+                            gc_io_account.get());
 
-        flagged_off64_t off = get_block_offset(id);
-        if (off.has_value()) {
-            uint16_t ser_block_size = get_ser_block_size(id);
-            disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
-                                                  off,
-                                                  ser_block_size,
-                                                  gc_io_account.get(),
-                                                  txns.back().get(),
-                                                  &checksums);
-        }
-
-        ++num_written_in_batch;
-        if (num_written_in_batch >= LBA_GC_BATCH_SIZE) {
-            num_written_in_batch = 0;
-            // End the transaction. We must not commit it though until after
-            // we have written a new metablock (see below).
-            extent_manager->end_transaction(txns.back().get());
-
-            // Write the LBA. This is simply to make the final sync at the end
-            // (as well as other LBA syncs done from inside the serializer) finish
-            // faster.
-            // If those took too long, it would block out serializer index writes,
-            // because those have to get in line for writing the metablock,
-            // and `write_metablock()` has to wait for the LBA sync to complete.
-            struct : public cond_t, public lba_disk_structure_t::completion_callback_t {
-                void on_lba_completion() { pulse(); }
-            } on_lba_written;
-            disk_structures[lba_shard]->write_outstanding(gc_io_account.get(),
-                                                          &checksums,
-                                                          &on_lba_written);
-
-            on_lba_written.wait();
-
-            // Start a new transaction for the next batch of entries
-            txns.push_back(make_scoped<extent_transaction_t>());
-            extent_manager->begin_transaction(txns.back().get());
+        if ((i + 1) % LBA_GC_BATCH_SIZE == 0) {
+            coro_t::yield();
 
             // Check if we are shutting down. If yes, we simply abort garbage
             // collection.
@@ -406,32 +382,48 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
         }
     }
 
-    // Discard the old LBA extents
-    if (!aborted) {
-        disk_structures[lba_shard]->destroy_extents(gced_extents, gc_io_account.get(),
-                                                    txns.back().get(), &checksums);
+    extent_transaction_t txn;
+    if (aborted) {
+        // Nothing refers to the unfinished snapshot, so we can throw it away as soon
+        // as it's no longer being written to.
+        snapshot->co_wait_for_write_completion();
+        extent_manager->begin_transaction(&txn);
+        snapshot->destroy(&txn);
+        extent_manager->end_transaction(&txn);
+        extent_manager->commit_transaction(&txn);
+        gc_active[lba_shard] = false;
+        return;
     }
 
-    // Sync the changed LBA for a final time
+    snapshot->co_finish(gc_io_account.get());
+
+    // This has to happen before `set_snapshot()`, since any metablock written after
+    // that (including ones for concurrent index writes) refers to the snapshot.
+    snapshot_written_fun();
+
+    // Discard the old LBA extents and the old snapshot.
+    extent_manager->begin_transaction(&txn);
+    disk_structures[lba_shard]->destroy_extents(gced_extents, gc_io_account.get(),
+                                                &txn, &checksums);
+    disk_structures[lba_shard]->set_snapshot(snapshot, &txn);
+
+    // Sync the changed LBA superblock
     struct : public cond_t, public lba_disk_structure_t::completion_callback_t {
         void on_lba_completion() { pulse(); }
     } on_lba_written;
-    optional<std::vector<checksum_filerange>> no_checksum;
-    disk_structures[lba_shard]->write_outstanding(gc_io_account.get(), &no_checksum,
+    disk_structures[lba_shard]->write_outstanding(gc_io_account.get(), &checksums,
                                                   &on_lba_written);
 
-    // End the last extent manager transaction
-    extent_manager->end_transaction(txns.back().get());
+    // End the extent manager transaction
+    extent_manager->end_transaction(&txn);
 
     // Write a new metablock once the LBA has synced. We have to do this before
-    // we can commit the extent_manager transactions.
+    // we can commit the extent_manager transaction.
     write_metablock_fun(&on_lba_written, gc_io_account.get());
 
-    // Commit all extent transactions. From that point on the data of extents
+    // Commit the extent transaction. From that point on the data of extents
     // we have deleted can be overwritten.
-    for (auto txn = txns.begin(); txn != txns.end(); ++txn) {
-        extent_manager->commit_transaction(txn->get());
-    }
+    extent_manager->commit_transaction(&txn);
 
     gc_active[lba_shard] = false;
 }
@@ -471,14 +463,15 @@ bool lba_list_t::we_want_to_gc(int i) {
         return false;
     }
 
-    // How much space are we using on disk? How much of that space is absolutely
-    // necessary?  If we are not using more than N times the amount of space that we
-    // need, don't GC
-    int entries_per_extent = disk_structures[i]->num_entries_that_can_fit_in_an_extent();
-    int64_t entries_total = disk_structures[i]->extents_in_superblock.size() * entries_per_extent;
-    int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR
-                            + make_aux_block_id_relative(end_aux_block_id()) / LBA_SHARD_FACTOR;
-    if ((entries_live / static_cast<double>(entries_total)) > LBA_MIN_UNGARBAGE_FRACTION) {  // TODO: multiply both sides by common denominator
+    // How much would we have to replay at startup, compared to reading a snapshot?
+    // If it's not more than LBA_MAX_REPLAY_RATIO times as much, don't GC.  This also
+    // bounds how much space we use on disk, since the snapshot contains everything
+    // that is necessary.
+    int64_t lba_size = disk_structures[i]->extents_in_superblock.size()
+        * extent_manager->extent_size;
+    int64_t snapshot_size = lba_snapshot_t::entries_size(end_block_id(),
+                                                         end_aux_block_id());
+    if (lba_size <= snapshot_size * LBA_MAX_REPLAY_RATIO) {
         return false;
     }
 
@@ -23,10 +23,15 @@ class lba_list_t
     friend class lba_writer_t;
 
     typedef std::function<void(const signal_t *, file_account_t *)> write_metablock_fun_t;
+    // Called in the GC coroutine after a snapshot has been written, but before
+    // anything refers to it.  The serializer uses it to mark the file as having LBA
+    // snapshots.
+    typedef std::function<void()> snapshot_written_fun_t;
 
 public:
-    explicit lba_list_t(extent_manager_t *em,
-                        const write_metablock_fun_t &_write_metablock_fun);
+    lba_list_t(extent_manager_t *em,
+               const write_metablock_fun_t &_write_metablock_fun,
+               const snapshot_written_fun_t &_snapshot_written_fun);
     ~lba_list_t();
 
     static void prepare_initial_metablock(lba_metablock_mixin_t *mb_out);
@@ -45,6 +50,9 @@ public:
     flagged_off64_t get_block_offset(block_id_t block);
     uint16_t get_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
+    // The size of the block in the data file, which differs from `get_block_size()`
+    // for compressed blocks.
+    block_size_t get_ondisk_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
@@ -64,6 +72,7 @@ public:
                         repli_timestamp_t recency,
                         flagged_off64_t offset,
                         uint16_t ser_block_size,
+                        uint16_t compressed_ser_block_size,
                         file_account_t *io_account,
                         extent_transaction_t *txn,
                         optional<std::vector<checksum_filerange>> *checksums);
@@ -96,6 +105,7 @@ private:
     scoped_ptr_t<auto_drainer_t> gc_drainer;
 
     write_metablock_fun_t write_metablock_fun;
+    snapshot_written_fun_t snapshot_written_fun;
 
     extent_manager_t *const extent_manager;
 
@@ -123,7 +133,8 @@ private:
             file_account_t *io_account, extent_transaction_t *txn,
             optional<std::vector<checksum_filerange>> *checksums);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                          flagged_off64_t offset, uint16_t ser_block_size);
+                          flagged_off64_t offset, uint16_t ser_block_size,
+                          uint16_t compressed_ser_block_size);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
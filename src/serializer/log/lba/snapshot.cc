@@ -0,0 +1,292 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/lba/snapshot.hpp"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "math.hpp"
+#include "serializer/checksum.hpp"
+
+namespace {
+
+// The number of ids in `[0, end)` that belong to shard `shard`.
+int64_t shard_ids_count(block_id_t end, int shard) {
+    return end > static_cast<block_id_t>(shard)
+        ? (end - shard + LBA_SHARD_FACTOR - 1) / LBA_SHARD_FACTOR
+        : 0;
+}
+
+size_t padded_extent_size(int64_t count) {
+    return ceil_aligned(offsetof(lba_snapshot_extent_t, entries[0])
+                        + sizeof(lba_snapshot_entry_t) * count,
+                        DEVICE_BLOCK_SIZE);
+}
+
+size_t padded_directory_size(int64_t nextents) {
+    return ceil_aligned(lba_snapshot_directory_t::extents_count_to_file_size(nextents),
+                        DEVICE_BLOCK_SIZE);
+}
+
+struct extent_read_cond_t : public extent_t::read_callback_t, public cond_t {
+    void on_extent_read() { pulse(); }
+};
+
+}  // namespace
+
+lba_snapshot_t::lba_snapshot_t(extent_manager_t *_em, file_t *_file, int _shard,
+                               block_id_t end_block_id, block_id_t end_aux_block_id)
+    : em(_em), file(_file), shard(_shard),
+      entries_count(shard_ids_count(end_block_id, _shard)),
+      aux_entries_count(shard_ids_count(
+          make_aux_block_id_relative(end_aux_block_id), _shard)),
+      directory_extent(nullptr), startup_extents_count(0),
+      buffer(em->extent_size), buffer_count(0) {
+    em->assert_thread();
+    CT_ASSERT(FIRST_AUX_BLOCK_ID % LBA_SHARD_FACTOR == 0);
+    guarantee(end_aux_block_id >= FIRST_AUX_BLOCK_ID);
+    memset(buffer.get(), 0, em->extent_size);
+}
+
+lba_snapshot_t::lba_snapshot_t(extent_manager_t *_em, file_t *_file,
+                               const lba_shard_metablock_t *metablock)
+    : em(_em), file(_file), shard(-1), entries_count(0), aux_entries_count(0),
+      startup_extents_count(metablock->snapshot_extents_count), buffer_count(0) {
+    em->assert_thread();
+    guarantee(metablock_has_snapshot(metablock));
+    guarantee(startup_extents_count >= 0);
+    directory_extent = new extent_t(
+        em, file, metablock->snapshot_directory_extent * em->extent_size,
+        padded_directory_size(startup_extents_count));
+}
+
+lba_snapshot_t::~lba_snapshot_t() { }
+
+bool lba_snapshot_t::metablock_has_snapshot(const lba_shard_metablock_t *metablock) {
+    return metablock->snapshot_directory_extent != 0;
+}
+
+int64_t lba_snapshot_t::entries_size(block_id_t end_block_id,
+                                     block_id_t end_aux_block_id) {
+    // This is about the same for every shard.
+    return (shard_ids_count(end_block_id, 0)
+            + shard_ids_count(make_aux_block_id_relative(end_aux_block_id), 0))
+        * sizeof(lba_snapshot_entry_t);
+}
+
+int64_t lba_snapshot_t::total_entries_count() const {
+    return entries_count + aux_entries_count;
+}
+
+block_id_t lba_snapshot_t::block_id_at(int64_t position) const {
+    rassert(position >= 0 && position < total_entries_count());
+    if (position < entries_count) {
+        return position * LBA_SHARD_FACTOR + shard;
+    } else {
+        return FIRST_AUX_BLOCK_ID
+            + (position - entries_count) * LBA_SHARD_FACTOR + shard;
+    }
+}
+
+int64_t lba_snapshot_t::entries_per_extent() const {
+    return (em->extent_size - offsetof(lba_snapshot_extent_t, entries[0]))
+        / sizeof(lba_snapshot_entry_t);
+}
+
+void lba_snapshot_t::add_entry(const index_block_info_t &info,
+                               file_account_t *io_account) {
+    em->assert_thread();
+    rassert(directory_extent == nullptr);
+    lba_snapshot_entry_t *entry = &buffer->entries[buffer_count];
+    entry->offset = info.offset;
+    entry->recency = info.recency;
+    entry->ser_block_size = info.ser_block_size;
+    entry->compressed_ser_block_size = info.compressed_ser_block_size;
+    ++buffer_count;
+
+    if (buffer_count == entries_per_extent()) {
+        write_extent(io_account);
+    }
+}
+
+void lba_snapshot_t::write_extent(file_account_t *io_account) {
+    memcpy(buffer->magic, lba_snapshot_magic, LBA_SNAPSHOT_MAGIC_SIZE);
+    const size_t size = padded_extent_size(buffer_count);
+
+    lba_snapshot_directory_entry_t dir_entry;
+    dir_entry.checksum = compute_checksum(em->checksum_algorithm, buffer.get(),
+                                          size / serializer_checksum::word_size);
+    dir_entry.entries_count = buffer_count;
+
+    // The snapshot isn't referenced by a metablock until it has been completely
+    // written, so there's no need to checksum the individual writes.
+    optional<std::vector<checksum_filerange>> no_checksums;
+    extent_t *extent = new extent_t(em, file);
+    extent->append(buffer.get(), size, io_account, &no_checksums);
+    dir_entry.offset = extent->extent_ref.offset();
+    extents.push_back(extent);
+    directory.push_back(dir_entry);
+
+    memset(buffer.get(), 0, size);
+    buffer_count = 0;
+}
+
+void lba_snapshot_t::co_finish(file_account_t *io_account) {
+    em->assert_thread();
+    if (buffer_count > 0) {
+        write_extent(io_account);
+    }
+    int64_t written_count = 0;
+    for (const lba_snapshot_directory_entry_t &dir_entry : directory) {
+        written_count += dir_entry.entries_count;
+    }
+    guarantee(written_count == total_entries_count());
+
+    const size_t size = padded_directory_size(directory.size());
+    guarantee(size <= em->extent_size,
+              "The LBA snapshot is too big for its directory to fit in an extent.");
+    guarantee(directory.size() <= static_cast<size_t>(
+                  std::numeric_limits<int32_t>::max()));
+    scoped_device_block_aligned_ptr_t<lba_snapshot_directory_t> dir(size);
+    memset(dir.get(), 0, size);
+    memcpy(dir->magic, lba_snapshot_directory_magic, LBA_SNAPSHOT_MAGIC_SIZE);
+    dir->shard = shard;
+    dir->entries_count = entries_count;
+    dir->aux_entries_count = aux_entries_count;
+    std::copy(directory.begin(), directory.end(), dir->extents);
+
+    optional<std::vector<checksum_filerange>> no_checksums;
+    directory_extent = new extent_t(em, file);
+    directory_extent->append(dir.get(), size, io_account, &no_checksums);
+    buffer.reset();
+
+    co_wait_for_write_completion();
+}
+
+void lba_snapshot_t::co_wait_for_extent(extent_t *extent) {
+    struct : public extent_t::completion_callback_t, public cond_t {
+        void on_extent_completion() { pulse(); }
+    } on_written;
+    extent->wait_for_write_completion(&on_written);
+    on_written.wait();
+}
+
+void lba_snapshot_t::co_wait_for_write_completion() {
+    for (extent_t *extent : extents) {
+        co_wait_for_extent(extent);
+    }
+    if (directory_extent != nullptr) {
+        co_wait_for_extent(directory_extent);
+    }
+}
+
+void lba_snapshot_t::co_read(in_memory_index_t *index, threadnum_t apply_thread) {
+    em->assert_thread();
+    guarantee(coro_t::self() != nullptr);
+
+    {
+        const size_t size = padded_directory_size(startup_extents_count);
+        scoped_device_block_aligned_ptr_t<lba_snapshot_directory_t> dir(size);
+        extent_read_cond_t on_read;
+        directory_extent->read(0, size, dir.get(), &on_read);
+        on_read.wait();
+
+        guarantee(memcmp(dir->magic, lba_snapshot_directory_magic,
+                         LBA_SNAPSHOT_MAGIC_SIZE) == 0,
+                  "The LBA snapshot directory is corrupted.");
+        guarantee(dir->shard >= 0 && dir->shard < LBA_SHARD_FACTOR);
+        shard = dir->shard;
+        entries_count = dir->entries_count;
+        aux_entries_count = dir->aux_entries_count;
+        directory.assign(dir->extents, dir->extents + startup_extents_count);
+    }
+
+    int64_t total_count = 0;
+    for (const lba_snapshot_directory_entry_t &dir_entry : directory) {
+        guarantee(dir_entry.entries_count > 0
+                  && dir_entry.entries_count <= entries_per_extent());
+        extents.push_back(new extent_t(em, file, dir_entry.offset,
+                                       padded_extent_size(dir_entry.entries_count)));
+        total_count += dir_entry.entries_count;
+    }
+    guarantee(total_count == total_entries_count());
+
+    // Like the LBA extents, we read a few extents at a time to stay under
+    // LBA_READ_BUFFER_SIZE.
+    const size_t window = std::max<int64_t>(
+        LBA_READ_BUFFER_SIZE / em->extent_size / LBA_SHARD_FACTOR, 1);
+    int64_t position = 0;
+    for (size_t first = 0; first < extents.size(); first += window) {
+        const size_t last = std::min(first + window, extents.size());
+        std::vector<scoped_device_block_aligned_ptr_t<lba_snapshot_extent_t> > buffers;
+        std::vector<scoped_ptr_t<extent_read_cond_t> > reads;
+        for (size_t i = first; i < last; ++i) {
+            const size_t size = padded_extent_size(directory[i].entries_count);
+            buffers.emplace_back(size);
+            reads.push_back(make_scoped<extent_read_cond_t>());
+            extents[i]->read(0, size, buffers.back().get(), reads.back().get());
+        }
+        for (const scoped_ptr_t<extent_read_cond_t> &read : reads) {
+            read->wait();
+        }
+
+        on_thread_t thread_switcher(apply_thread);
+        for (size_t i = first; i < last; ++i) {
+            const lba_snapshot_directory_entry_t &dir_entry = directory[i];
+            const lba_snapshot_extent_t *extent = buffers[i - first].get();
+            const size_t size = padded_extent_size(dir_entry.entries_count);
+            guarantee(memcmp(extent->magic, lba_snapshot_magic,
+                             LBA_SNAPSHOT_MAGIC_SIZE) == 0
+                      && compute_checksum(em->checksum_algorithm, extent,
+                                          size / serializer_checksum::word_size).value
+                         == dir_entry.checksum.value,
+                      "The LBA snapshot extent at offset %" PRIi64 " is corrupted.",
+                      dir_entry.offset);
+
+            for (int64_t j = 0; j < dir_entry.entries_count; ++j, ++position) {
+                const lba_snapshot_entry_t &e = extent->entries[j];
+                if (!e.offset.has_value()) {
+                    continue;
+                }
+                guarantee(e.compressed_ser_block_size < e.ser_block_size
+                          || e.compressed_ser_block_size == 0);
+                index->set_block_info(block_id_at(position), e.recency, e.offset,
+                                      e.ser_block_size, e.compressed_ser_block_size);
+            }
+        }
+    }
+}
+
+void lba_snapshot_t::prepare_metablock(lba_shard_metablock_t *mb_out) const {
+    rassert(directory_extent != nullptr);
+    rassert(divides(em->extent_size, directory_extent->extent_ref.offset()));
+    const int64_t extent_number = directory_extent->extent_ref.offset() / em->extent_size;
+    guarantee(extent_number > 0
+              && extent_number <= std::numeric_limits<int32_t>::max());
+    mb_out->snapshot_directory_extent = extent_number;
+    mb_out->snapshot_extents_count = directory.size();
+}
+
+void lba_snapshot_t::destroy(extent_transaction_t *txn) {
+    for (extent_t *extent : extents) {
+        extent->destroy(txn);
+    }
+    if (directory_extent != nullptr) {
+        directory_extent->destroy(txn);
+    }
+    delete this;
+}
+
+void lba_snapshot_t::shutdown() {
+    for (extent_t *extent : extents) {
+        extent->shutdown();
+    }
+    if (directory_extent != nullptr) {
+        directory_extent->shutdown();
+    }
+    delete this;
+}
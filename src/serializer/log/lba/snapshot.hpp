@@ -0,0 +1,96 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_LBA_SNAPSHOT_HPP_
+#define SERIALIZER_LOG_LBA_SNAPSHOT_HPP_
+
+#include <vector>
+
+#include "arch/types.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/log/extent_manager.hpp"
+#include "serializer/log/lba/disk_format.hpp"
+#include "serializer/log/lba/extent.hpp"
+#include "serializer/log/lba/in_memory_index.hpp"
+#include "threading.hpp"
+
+/* An on-disk copy of one shard of the in-memory index, which replaces the LBA extents
+that were written before it (see `lba_list_t::gc()`).  At startup the snapshot is read
+first, and the remaining LBA extents and the inline LBA entries are replayed on top of
+it.
+
+The snapshot doesn't have to be consistent with any particular point in time.  Any
+entry that changes while the snapshot is being written also gets written to the LBA
+extents that are kept, so the newer value wins when they are replayed.
+
+The entries are stored by position (see `lba_snapshot_entry_t`) in a list of extents,
+which are listed in a directory in yet another extent.  The metablock refers to the
+directory. */
+class lba_snapshot_t {
+public:
+    // Starts writing a new snapshot of `shard`, for the blocks with ids below
+    // `end_block_id` and `end_aux_block_id`.  Fill it in with `add_entry()`.
+    lba_snapshot_t(extent_manager_t *em, file_t *file, int shard,
+                   block_id_t end_block_id, block_id_t end_aux_block_id);
+
+    // Refers to the existing snapshot in `metablock` (during startup).  Use
+    // `co_read()` to load it.
+    lba_snapshot_t(extent_manager_t *em, file_t *file,
+                   const lba_shard_metablock_t *metablock);
+
+    static bool metablock_has_snapshot(const lba_shard_metablock_t *metablock);
+
+    // How much space the entries of a snapshot for the given block ids would take up.
+    static int64_t entries_size(block_id_t end_block_id, block_id_t end_aux_block_id);
+
+    // The number of entries, and the block id of the entry at each position.
+    int64_t total_entries_count() const;
+    block_id_t block_id_at(int64_t position) const;
+
+    // Appends the entry for the next position.
+    void add_entry(const index_block_info_t &info, file_account_t *io_account);
+
+    // Once there is an entry for every position, writes the directory and waits for
+    // all of the snapshot to be written.  Must be called in a coroutine.
+    void co_finish(file_account_t *io_account);
+
+    // Waits for everything that has been written so far, so that an unfinished
+    // snapshot can be destroyed.  Must be called in a coroutine.
+    void co_wait_for_write_completion();
+
+    // Reads the snapshot and fills in the entries that refer to a block.  The index
+    // is only touched on `apply_thread`.  Must be called in a coroutine.
+    void co_read(in_memory_index_t *index, threadnum_t apply_thread);
+
+    void prepare_metablock(lba_shard_metablock_t *mb_out) const;
+
+    void destroy(extent_transaction_t *txn);   // Delete both in memory and on disk
+    void shutdown();   // Delete just in memory
+
+private:
+    // Use destroy() or shutdown() instead
+    ~lba_snapshot_t();
+
+    int64_t entries_per_extent() const;
+    void write_extent(file_account_t *io_account);
+    void co_wait_for_extent(extent_t *extent);
+
+    extent_manager_t *const em;
+    file_t *const file;
+    int shard;
+    int64_t entries_count;
+    int64_t aux_entries_count;
+
+    // The directory extent is null until the directory has been written.
+    extent_t *directory_extent;
+    int32_t startup_extents_count;
+
+    std::vector<extent_t *> extents;
+    std::vector<lba_snapshot_directory_entry_t> directory;
+
+    // The extent we're currently filling in, and how many entries are in it.
+    scoped_device_block_aligned_ptr_t<lba_snapshot_extent_t> buffer;
+    int64_t buffer_count;
+
+    DISABLE_COPYING(lba_snapshot_t);
+};
+
+#endif  // SERIALIZER_LOG_LBA_SNAPSHOT_HPP_
@@ -2,6 +2,7 @@
 #include "serializer/log/log_serializer.hpp"
 
 #include <fcntl.h>
+#include <inttypes.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -9,14 +10,17 @@
 #include <functional>
 
 #include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/types.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "logger.hpp"
+#include "math.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/data_block_manager.hpp"
+#include "serializer/log/flash_cache.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
                                                io_backender_t *backender)
@@ -114,6 +118,22 @@ void filepath_file_opener_t::unlink_serializer_file() {
     guarantee_err(res == 0, "unlink() failed");
 }
 
+bool filepath_file_opener_t::open_flash_cache_file(const std::string &path,
+                                                   scoped_ptr_t<file_t> *file_out) {
+    const file_open_result_t res = open_file(
+            path.c_str(),
+            linux_file_t::mode_read | linux_file_t::mode_write
+                | linux_file_t::mode_create | linux_file_t::mode_truncate,
+            backender_,
+            file_out);
+    if (res.outcome == file_open_result_t::ERROR) {
+        logERR("Could not open flash cache file \"%s\": %s.  The table will be served "
+               "without it.", path.c_str(), errno_string(res.errsv).c_str());
+        return false;
+    }
+    return true;
+}
+
 
 
 log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
@@ -121,40 +141,72 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_block_reads(secs_to_ticks(1)),
       pm_serializer_index_reads(),
       pm_serializer_block_writes(),
+      pm_serializer_block_read_latency(),
+      pm_serializer_block_write_latency(),
       pm_serializer_index_writes(secs_to_ticks(1)),
       pm_serializer_index_writes_size(secs_to_ticks(1), false),
+      pm_serializer_index_write_group_size(secs_to_ticks(1), false),
+      pm_serializer_index_writes_merged(),
+      pm_serializer_compressed_block_writes(),
+      pm_serializer_compression_saved_bytes(),
+      pm_serializer_flash_cache_hits(),
+      pm_serializer_flash_cache_writes(),
       pm_serializer_read_bytes_per_sec(secs_to_ticks(1)),
       pm_serializer_read_bytes_total(),
       pm_serializer_written_bytes_per_sec(secs_to_ticks(1)),
       pm_serializer_written_bytes_total(),
       pm_extents_in_use(),
       pm_file_size_bytes(),
+      pm_extents_discarded(),
       pm_serializer_lba_extents(),
       pm_serializer_data_extents(),
       pm_serializer_data_extents_allocated(),
       pm_serializer_data_extents_gced(),
+      pm_serializer_cold_block_writes(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_gc_written_bytes_per_sec(secs_to_ticks(1)),
+      pm_serializer_gc_written_bytes_total(),
+      pm_serializer_gc_live_ratio(secs_to_ticks(5), false),
+      pm_serializer_gc_write_amplification(secs_to_ticks(5), false),
+      pm_serializer_gc_space_amplification(secs_to_ticks(5), false),
+      pm_serializer_gc_start_ratio(secs_to_ticks(5), false),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
           &pm_serializer_index_reads, "serializer_index_reads",
           &pm_serializer_block_writes, "serializer_block_writes",
+          &pm_serializer_block_read_latency, "serializer_block_read_latency",
+          &pm_serializer_block_write_latency, "serializer_block_write_latency",
           &pm_serializer_index_writes, "serializer_index_writes",
           &pm_serializer_index_writes_size, "serializer_index_writes_size",
+          &pm_serializer_index_write_group_size, "serializer_index_write_group_size",
+          &pm_serializer_index_writes_merged, "serializer_index_writes_merged",
+          &pm_serializer_compressed_block_writes, "serializer_compressed_block_writes",
+          &pm_serializer_compression_saved_bytes, "serializer_compression_saved_bytes",
+          &pm_serializer_flash_cache_hits, "serializer_flash_cache_hits",
+          &pm_serializer_flash_cache_writes, "serializer_flash_cache_writes",
           &pm_serializer_read_bytes_per_sec, "serializer_read_bytes_per_sec",
           &pm_serializer_read_bytes_total, "serializer_read_bytes_total",
           &pm_serializer_written_bytes_per_sec, "serializer_written_bytes_per_sec",
           &pm_serializer_written_bytes_total, "serializer_written_bytes_total",
           &pm_extents_in_use, "serializer_extents_in_use",
           &pm_file_size_bytes, "serializer_file_size_bytes",
+          &pm_extents_discarded, "serializer_extents_discarded",
           &pm_serializer_lba_extents, "serializer_lba_extents",
           &pm_serializer_data_extents, "serializer_data_extents",
           &pm_serializer_data_extents_allocated, "serializer_data_extents_allocated",
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
+          &pm_serializer_cold_block_writes, "serializer_cold_block_writes",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
+          &pm_serializer_gc_written_bytes_per_sec, "serializer_gc_written_bytes_per_sec",
+          &pm_serializer_gc_written_bytes_total, "serializer_gc_written_bytes_total",
+          &pm_serializer_gc_live_ratio, "serializer_gc_live_ratio",
+          &pm_serializer_gc_write_amplification, "serializer_gc_write_amplification",
+          &pm_serializer_gc_space_amplification, "serializer_gc_space_amplification",
+          &pm_serializer_gc_start_ratio, "serializer_gc_start_ratio",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
@@ -171,11 +223,18 @@ void log_serializer_stats_t::bytes_written(size_t count) {
 void log_serializer_t::create(serializer_file_opener_t *file_opener,
                               static_config_t static_config) {
     log_serializer_on_disk_static_config_t *on_disk_config = &static_config;
+    // Block sizes are 16 bits wide in the LBA and in `block_size_t`.
+    guarantee(static_config.block_size_ >= DEFAULT_BTREE_BLOCK_SIZE
+              && static_config.block_size_ <= MAX_BTREE_BLOCK_SIZE
+              && divides(DEVICE_BLOCK_SIZE, static_config.block_size_)
+              && divides(static_config.block_size_, static_config.extent_size_),
+              "Invalid block size %" PRIu64 ".", static_config.block_size_);
 
     scoped_ptr_t<file_t> file;
     file_opener->open_serializer_file_create_temporary(&file);
 
-    co_static_header_write(file.get(), on_disk_config, sizeof(*on_disk_config));
+    co_static_header_write(file.get(), on_disk_config, sizeof(*on_disk_config),
+                           static_config.checksum_algorithm, false, false);
 
     scoped_device_block_aligned_ptr_t<crc_metablock_t> scoped_crc_mb(METABLOCK_SIZE);
     crc_metablock_t *crc_mb = scoped_crc_mb.get();
@@ -186,6 +245,7 @@ void log_serializer_t::create(serializer_file_opener_t *file_opener,
     lba_list_t::prepare_initial_metablock(&crc_mb->metablock.lba_index_part);
 
     metablock_manager_t::create(file.get(), static_config.extent_size(),
+                                static_config.checksum_algorithm,
                                 std::move(scoped_crc_mb));
 }
 
@@ -202,6 +262,9 @@ struct ls_start_existing_fsm_t :
 {
     explicit ls_start_existing_fsm_t(log_serializer_t *serializer)
         : ser(serializer), start_existing_state(state_start) {
+        for (int i = 0; i < num_phases; ++i) {
+            phase_secs[i] = 0;
+        }
     }
 
     ~ls_start_existing_fsm_t() {
@@ -213,6 +276,9 @@ struct ls_start_existing_fsm_t :
         rassert(ser->state == log_serializer_t::state_unstarted);
         ser->state = log_serializer_t::state_starting_up;
 
+        file_name = file_opener->file_name();
+        phase_start_ticks = get_ticks();
+
         scoped_ptr_t<file_t> dbfile;
         file_opener->open_serializer_file_existing(&dbfile);
         ser->dbfile = dbfile.release();
@@ -237,6 +303,9 @@ struct ls_start_existing_fsm_t :
                 &ser->static_config,
                 sizeof(log_serializer_on_disk_static_config_t),
                 &ser->static_header_needs_migration,
+                &ser->static_config.checksum_algorithm,
+                &ser->static_header_has_lba_snapshots,
+                &ser->static_header_has_compressed_blocks,
                 this);
             start_existing_state = state_waiting_for_static_header;
             // STATE B above implies STATE C here
@@ -246,8 +315,10 @@ struct ls_start_existing_fsm_t :
         rassert(start_existing_state != state_waiting_for_static_header);
 
         if (start_existing_state == state_find_metablock) {
+            end_phase(phase_static_header);
             // STATE D
             ser->extent_manager = new extent_manager_t(ser->dbfile, &ser->static_config,
+                                                       ser->static_config.checksum_algorithm,
                                                        ser->stats.get());
             {
                 // We never end up releasing the static header extent reference.  Nobody
@@ -260,7 +331,8 @@ struct ls_start_existing_fsm_t :
             ser->metablock_manager = new metablock_manager_t(ser->extent_manager);
             ser->lba_index = new lba_list_t(ser->extent_manager,
                     std::bind(&log_serializer_t::write_metablock_sans_pipelining,
-                              ser, ph::_1, ph::_2));
+                              ser, ph::_1, ph::_2),
+                    std::bind(&log_serializer_t::on_lba_snapshot_written, ser));
             ser->data_block_manager
                 = new data_block_manager_t(ser->extent_manager, ser,
                                            &ser->static_config, ser->stats.get());
@@ -279,6 +351,7 @@ struct ls_start_existing_fsm_t :
         if (start_existing_state == state_start_lba) {
             // STATE G
             guarantee(metablock_found, "Could not find any valid metablock.");
+            end_phase(phase_metablock);
 
             // STATE H
             if (ser->lba_index->start_existing(ser->dbfile,
@@ -295,6 +368,7 @@ struct ls_start_existing_fsm_t :
         }
 
         if (start_existing_state == state_reconstruct) {
+            end_phase(phase_lba);
             ser->data_block_manager->start_reconstruct();
             start_existing_state = state_reconstruct_ongoing;
             next_block_to_reconstruct = 0;
@@ -318,7 +392,8 @@ struct ls_start_existing_fsm_t :
                     ser->lba_index->get_block_offset(next_block_to_reconstruct);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(next_block_to_reconstruct));
+                        ser->lba_index->get_ondisk_block_size(
+                            next_block_to_reconstruct));
                 }
 
                 ++next_block_to_reconstruct;
@@ -334,6 +409,8 @@ struct ls_start_existing_fsm_t :
 
             ser->extent_manager->start_existing();
 
+            end_phase(phase_reconstruct);
+            log_phase_times();
             start_existing_state = state_finish;
         }
 
@@ -379,6 +456,38 @@ struct ls_start_existing_fsm_t :
         next_starting_up_step();
     }
 
+    // We keep track of how long each part of the startup takes, so that slow starts
+    // on large files can be diagnosed from the log.
+    enum phase_t {
+        phase_static_header,
+        phase_metablock,
+        phase_lba,
+        phase_reconstruct,
+        num_phases
+    };
+
+    void end_phase(phase_t phase) {
+        ticks_t now = get_ticks();
+        phase_secs[phase] = ticks_to_secs(ticks_t{now.nanos - phase_start_ticks.nanos});
+        phase_start_ticks = now;
+    }
+
+    void log_phase_times() {
+        double total_secs = 0;
+        for (int i = 0; i < num_phases; ++i) {
+            total_secs += phase_secs[i];
+        }
+        // Temporary serializers (e.g. for disk backed queues) are opened all the
+        // time, so we only talk about the ones that were noticeably slow.
+        if (total_secs >= SERIALIZER_STARTUP_LOG_THRESHOLD_SECS) {
+            logINF("Opened serializer file %s in %.2fs (static header %.2fs, "
+                   "metablock %.2fs, LBA %.2fs, reconstruction %.2fs).",
+                   file_name.c_str(), total_secs,
+                   phase_secs[phase_static_header], phase_secs[phase_metablock],
+                   phase_secs[phase_lba], phase_secs[phase_reconstruct]);
+        }
+    }
+
     log_serializer_t *ser;
     cond_t *to_signal_when_done;
 
@@ -403,6 +512,10 @@ struct ls_start_existing_fsm_t :
     bool metablock_found;
     log_serializer_metablock_t metablock_buffer;
 
+    std::string file_name;
+    ticks_t phase_start_ticks;
+    double phase_secs[num_phases];
+
 private:
     DISABLE_COPYING(ls_start_existing_fsm_t);
 };
@@ -417,10 +530,14 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config,
       expecting_no_more_tokens(false),
 #endif
       dynamic_config(_dynamic_config),
+      block_compressor(new block_compressor_t),
       shutdown_callback(nullptr),
       shutdown_state(shutdown_not_started),
       state(state_unstarted),
       static_header_needs_migration(false),
+      static_header_has_lba_snapshots(false),
+      static_header_has_compressed_blocks(false),
+      wrote_compressed_blocks(false),
       dbfile(nullptr),
       extent_manager(nullptr),
       metablock_manager(nullptr),
@@ -432,11 +549,25 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config,
     ls_start_existing_fsm_t *s = new ls_start_existing_fsm_t(this);
     cond_t cond;
     if (!s->run(&cond, file_opener)) cond.wait();
+
+    if (!dynamic_config.flash_cache_path.empty()
+        && dynamic_config.flash_cache_size > 0) {
+        scoped_ptr_t<file_t> flash_cache_file;
+        if (file_opener->open_flash_cache_file(dynamic_config.flash_cache_path,
+                                               &flash_cache_file)) {
+            flash_cache.init(new flash_cache_t(std::move(flash_cache_file),
+                                               dynamic_config.flash_cache_size,
+                                               stats.get()));
+        }
+    }
 }
 
 log_serializer_t::~log_serializer_t() {
     assert_thread();
 
+    // Waits for the writes to the cache file.
+    flash_cache.reset();
+
     cond_t cond;
     shutdown(&cond);
     cond.wait();
@@ -447,10 +578,11 @@ log_serializer_t::~log_serializer_t() {
 }
 
 file_account_t *log_serializer_t::make_io_account(int priority,
-                                                  int outstanding_requests_limit) {
+                                                  int outstanding_requests_limit,
+                                                  io_class_t io_class) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, priority, outstanding_requests_limit, io_class);
 }
 
 buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
@@ -461,9 +593,24 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
 
     ticks_t pm_time;
     stats->pm_serializer_block_reads.begin(&pm_time);
+    perfmon_histogram_timer_t latency_timer(&stats->pm_serializer_block_read_latency);
 
-    buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                             io_account);
+    buf_ptr_t ret;
+    if (flash_cache.has()) {
+        ret = flash_cache->read(token->offset_, token->ondisk_block_size());
+    }
+    if (!ret.has()) {
+        const int64_t offset = token->offset_;
+        ret = data_block_manager->read(offset, token->ondisk_block_size(), io_account);
+        // If the GC moved the block while we were reading it, its old extent might
+        // get reused before the cache would hear about it.
+        if (flash_cache.has() && token->offset_ == offset) {
+            flash_cache->note_read(offset, ret);
+        }
+    }
+    if (token->is_compressed()) {
+        ret = block_compressor->decompress(ret, token->block_size());
+    }
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
@@ -496,7 +643,9 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
             flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint16_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t old_info = lba_index->get_block_info(op.block_id);
+            uint16_t ser_block_size = old_info.ser_block_size;
+            uint16_t compressed_ser_block_size = old_info.compressed_ser_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -511,6 +660,9 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
                     ser_block_size = token->block_size().ser_value();
+                    compressed_ser_block_size = token->is_compressed()
+                        ? token->ondisk_block_size().ser_value()
+                        : 0;
 
                     if (checksums) {
                         serializer_checksum checksum = token->checksum_;
@@ -522,18 +674,20 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                             checksums->push_back(
                                 checksum_filerange{
                                     token->offset_,
-                                    ceil_aligned<int64_t>(ser_block_size,
-                                                          DEVICE_BLOCK_SIZE),
+                                    ceil_aligned<int64_t>(
+                                        token->ondisk_block_size().ser_value(),
+                                        DEVICE_BLOCK_SIZE),
                                     checksum});
                         }
                     }
 
                     /* mark the life */
                     data_block_manager->mark_live(offset.get_value(),
-                                                  token->block_size());
+                                                  token->ondisk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    compressed_ser_block_size = 0;
                 }
             }
 
@@ -542,6 +696,7 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 
             lba_index->set_block_info(op.block_id, recency,
                                       offset, ser_block_size,
+                                      compressed_ser_block_size,
                                       index_writes_io_account.get(), &txn,
                                       &checksums);
         }
@@ -555,11 +710,22 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     // Note that this is early enough for upgrading from the 1.13 serializer
     // version to 2.2, since only the format of the LBA changed.
     // Future serializer format changes might require this step to happen earlier.
+    // Compressed blocks only become reachable once this index write references them,
+    // so this is also early enough to mark the file before older versions could read
+    // them as plain blocks.
     {
         new_mutex_acq_t acq(&static_header_migration_mutex);
-        if (static_header_needs_migration) {
+        const bool has_compressed_blocks =
+            static_header_has_compressed_blocks || wrote_compressed_blocks;
+        if (static_header_needs_migration
+            || has_compressed_blocks != static_header_has_compressed_blocks) {
+            migrate_static_header(dbfile, sizeof(log_serializer_on_disk_static_config_t),
+                                  static_header_has_lba_snapshots,
+                                  has_compressed_blocks);
+            // Only set these once the header is written, so that concurrent index
+            // writes wait for it on the mutex.
             static_header_needs_migration = false;
-            migrate_static_header(dbfile, sizeof(log_serializer_on_disk_static_config_t));
+            static_header_has_compressed_blocks = has_compressed_blocks;
         }
     }
 
@@ -677,10 +843,30 @@ void log_serializer_t::write_metablock_sans_pipelining(
 
 }
 
+void log_serializer_t::on_lba_snapshot_written() {
+    assert_thread();
+    new_mutex_acq_t acq(&static_header_migration_mutex);
+    if (!static_header_has_lba_snapshots) {
+        // This also takes care of a pending 1.13 migration, since it rewrites the whole
+        // static header.
+        static_header_has_lba_snapshots = true;
+        static_header_needs_migration = false;
+        migrate_static_header(dbfile, sizeof(log_serializer_on_disk_static_config_t),
+                              true, static_header_has_compressed_blocks);
+    }
+}
+
 counted_t<block_token_t>
 log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+    return generate_block_token(offset, block_size, block_size);
+}
+
+counted_t<block_token_t>
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t ondisk_block_size) {
     assert_thread();
-    counted_t<block_token_t> token(new block_token_t(this, offset, block_size));
+    counted_t<block_token_t> token(new block_token_t(this, offset, block_size,
+                                                     ondisk_block_size));
 
     auto location = offset_tokens.find(offset);
     if (location == offset_tokens.end()) {
@@ -699,9 +885,71 @@ log_serializer_t::block_writes(const buf_write_info_t *write_infos,
     assert_thread();
     stats->pm_serializer_block_writes += write_infos_count;
 
+    // Records the write latency, and holds on to the compressed buffers (if any)
+    // until they have been written.
+    struct block_writes_cb_t : public iocallback_t {
+        void on_io_complete() {
+            latency->record_since(start_time);
+            iocallback_t *local_cb = cb;
+            delete this;
+            local_cb->on_io_complete();
+        }
+
+        std::vector<buf_ptr_t> compressed_bufs;
+        perfmon_histogram_t *latency;
+        ticks_t start_time;
+        iocallback_t *cb;
+    };
+
+    block_writes_cb_t *const writes_cb = new block_writes_cb_t;
+    writes_cb->latency = &stats->pm_serializer_block_write_latency;
+    writes_cb->start_time = get_ticks();
+    writes_cb->cb = cb;
+
+    if (dynamic_config.compression == block_compression_t::none) {
+        std::vector<counted_t<block_token_t> > result
+            = data_block_manager->many_writes(write_infos, write_infos_count,
+                                              io_account, writes_cb);
+        guarantee(result.size() == write_infos_count);
+        return result;
+    }
+
+    writes_cb->compressed_bufs.reserve(write_infos_count);
+
+    std::vector<buf_write_info_t> ondisk_write_infos;
+    ondisk_write_infos.reserve(write_infos_count);
+    for (size_t i = 0; i < write_infos_count; ++i) {
+        const buf_write_info_t &info = write_infos[i];
+        // The compressed block carries the uncompressed block's header.
+        info.buf->ser_header.block_id = info.block_id;
+        buf_ptr_t compressed = block_compressor->compress(dynamic_config.compression,
+                                                          info.buf, info.block_size);
+        if (compressed.has()) {
+            wrote_compressed_blocks = true;
+            ++stats->pm_serializer_compressed_block_writes;
+            stats->pm_serializer_compression_saved_bytes
+                += info.block_size.ser_value() - compressed.block_size().ser_value();
+            ondisk_write_infos.push_back(
+                buf_write_info_t(compressed.ser_buffer(), compressed.block_size(),
+                                 info.block_id));
+            writes_cb->compressed_bufs.push_back(std::move(compressed));
+        } else {
+            ondisk_write_infos.push_back(info);
+        }
+    }
+
     std::vector<counted_t<block_token_t> > result
-        = data_block_manager->many_writes(write_infos, write_infos_count, io_account, cb);
+        = data_block_manager->many_writes(ondisk_write_infos.data(),
+                                          ondisk_write_infos.size(),
+                                          io_account, writes_cb);
     guarantee(result.size() == write_infos_count);
+
+    // The data block manager only knows about the on-disk sizes.  Readers of the
+    // tokens need to know how large the blocks are once they're decompressed.
+    for (size_t i = 0; i < write_infos_count; ++i) {
+        rassert(result[i]->block_size_ == ondisk_write_infos[i].block_size);
+        result[i]->block_size_ = write_infos[i].block_size;
+    }
     return result;
 }
 
@@ -793,6 +1041,14 @@ bool log_serializer_t::is_gc_active() const {
     return data_block_manager->is_gc_active() || lba_index->is_any_gc_active();
 }
 
+void log_serializer_t::record_index_write_group(size_t num_merged_writes) {
+    assert_thread();
+    stats->pm_serializer_index_write_group_size.record(num_merged_writes);
+    if (num_merged_writes > 1) {
+        stats->pm_serializer_index_writes_merged += num_merged_writes - 1;
+    }
+}
+
 block_id_t log_serializer_t::end_block_id() {
     assert_thread();
     rassert(state == state_ready);
@@ -820,8 +1076,10 @@ counted_t<block_token_t> log_serializer_t::index_read(block_id_t block_id) {
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(),
-                                    block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(
+            info.offset.get_value(),
+            block_size_t::unsafe_make(info.ser_block_size),
+            block_size_t::unsafe_make(info.ondisk_ser_block_size()));
     } else {
         return counted_t<block_token_t>();
     }
@@ -1016,9 +1274,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 block_token_t::block_token_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_block_size)
+                             block_size_t initial_block_size,
+                             block_size_t initial_ondisk_block_size)
     : serializer_(serializer), ref_count_(0),
       block_size_(initial_block_size),
+      ondisk_block_size_(initial_ondisk_block_size),
       checksum_(no_checksum()),
       offset_(initial_offset) {
     serializer_->assert_thread();
@@ -27,6 +27,7 @@
 
 class cond_t;
 class data_block_manager_t;
+class flash_cache_t;
 struct block_magic_t;
 class io_backender_t;
 class log_serializer_t;
@@ -61,6 +62,8 @@ public:
     void open_serializer_file_existing(scoped_ptr_t<file_t> *file_out);
     void unlink_serializer_file();
 
+    bool open_flash_cache_file(const std::string &path, scoped_ptr_t<file_t> *file_out);
+
 private:
     void open_serializer_file(const std::string &path, int extra_flags, scoped_ptr_t<file_t> *file_out);
 
@@ -124,7 +127,8 @@ public:
     virtual ~log_serializer_t();
 
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    io_class_t io_class);
 
     void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
     void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
@@ -155,11 +159,18 @@ public:
 
     virtual bool is_gc_active() const;
 
+    void record_index_write_group(size_t num_merged_writes);
+
 private:
     void unregister_block_token(block_token_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<block_token_t> generate_block_token(int64_t offset,
                                                              block_size_t block_size);
+    // For blocks that are stored compressed, where `ondisk_block_size` is smaller
+    // than `block_size`.
+    counted_t<block_token_t> generate_block_token(int64_t offset,
+                                                  block_size_t block_size,
+                                                  block_size_t ondisk_block_size);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -201,6 +212,9 @@ private:
     void write_metablock_sans_pipelining(const signal_t *safe_to_write_cond,
                                          file_account_t *io_account);
 
+    // Used by the LBA gc to mark the static header before the first metablock that
+    // refers to an LBA snapshot is written.  Blocks.
+    void on_lba_snapshot_written();
 
     void prepare_metablock(log_serializer_metablock_t *mb_buffer);
 
@@ -224,7 +238,12 @@ private:
     std::vector<serializer_read_ahead_callback_t *> read_ahead_callbacks;
 
     const dynamic_config_t dynamic_config;
+    // Compresses blocks on write if `dynamic_config.compression` asks for it, and
+    // decompresses compressed blocks on read regardless.
+    scoped_ptr_t<block_compressor_t> block_compressor;
     static_config_t static_config;
+    // Empty unless `dynamic_config` asks for a flash cache and its file could be opened.
+    scoped_ptr_t<flash_cache_t> flash_cache;
 
     cond_t *shutdown_callback;
 
@@ -249,6 +268,14 @@ private:
     We delay migration until we perform the first index_write. That way if some other
     migration step fails, users can still downgrade to the previous release. */
     bool static_header_needs_migration;
+    /* Whether the static header says that the LBA may have snapshots.  It is set the
+    first time the LBA GC writes a snapshot (see `on_lba_snapshot_written()`). */
+    bool static_header_has_lba_snapshots;
+    /* Whether the static header says that the file may contain compressed blocks.  It
+    is set by the first index write after `block_writes()` wrote a compressed block,
+    which `wrote_compressed_blocks` records. */
+    bool static_header_has_compressed_blocks;
+    bool wrote_compressed_blocks;
     new_mutex_t static_header_migration_mutex;
 
     file_t *dbfile;
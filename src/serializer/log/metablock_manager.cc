@@ -38,6 +38,7 @@ struct checksum_filerange_less {
 
 // Returns true if we should double-datasync (ranges are all padding).
 bool prepare_checksums(metablock_fileranges_checksum_t *disk_list,
+                       checksum_algorithm_t checksum_algorithm,
                        optional<std::vector<checksum_filerange>> &&checksums) {
     if (!checksums.has_value()) {
         goto prepare_padding_ranges;
@@ -58,7 +59,8 @@ bool prepare_checksums(metablock_fileranges_checksum_t *disk_list,
         for (size_t i = 1; i < ranges.size(); ++i) {
             if (ranges[merge_ix].offset + ranges[merge_ix].size == ranges[i].offset) {
                 serializer_checksum concat
-                    = compute_checksum_concat(ranges[merge_ix].checksum,
+                    = compute_checksum_concat(checksum_algorithm,
+                                              ranges[merge_ix].checksum,
                                               ranges[i].checksum,
                                               uint64_t(ranges[i].size) / serializer_checksum::word_size);
                 ranges[merge_ix].size += ranges[i].size;
@@ -74,9 +76,10 @@ bool prepare_checksums(metablock_fileranges_checksum_t *disk_list,
             goto prepare_padding_ranges;
         }
 
-        serializer_checksum combined_sum = identity_checksum();
+        serializer_checksum combined_sum = identity_checksum(checksum_algorithm);
         for (size_t i = 0; i < checksum_count; ++i) {
-            combined_sum = compute_checksum_concat(combined_sum, ranges[i].checksum,
+            combined_sum = compute_checksum_concat(checksum_algorithm,
+                                                   combined_sum, ranges[i].checksum,
                                                    ranges[i].size / serializer_checksum::word_size);
             metablock_filerange_t range = { ranges[i].offset, ranges[i].size };
             disk_list->fileranges[i] = range;
@@ -95,7 +98,7 @@ bool prepare_checksums(metablock_fileranges_checksum_t *disk_list,
     for (size_t i = 0; i < METABLOCK_NUM_CHECKSUMS; ++i) {
         disk_list->fileranges[i] = zero_range;
     }
-    disk_list->checksum = identity_checksum();
+    disk_list->checksum = identity_checksum(checksum_algorithm);
     return true;
 }
 
@@ -103,12 +106,14 @@ bool prepare_checksums(metablock_fileranges_checksum_t *disk_list,
 // Returns true if we should double-datasync.
 bool prepare(crc_metablock_t *crc_mb, uint32_t _disk_format_version,
              metablock_version_t vers,
+             checksum_algorithm_t checksum_algorithm,
              optional<std::vector<checksum_filerange>> &&checksums) {
     crc_mb->disk_format_version = _disk_format_version;
     memcpy(crc_mb->magic_marker, MB_MARKER_MAGIC, sizeof(MB_MARKER_MAGIC));
     crc_mb->version = vers;
 
     bool double_datasync = prepare_checksums(&crc_mb->fileranges_checksum_v2_5,
+                                             checksum_algorithm,
                                              std::move(checksums));
 
     crc_mb->_crc = compute_metablock_crc(crc_mb);
@@ -179,6 +184,7 @@ metablock_manager_t::~metablock_manager_t() {
 
 void metablock_manager_t::create(
         file_t *dbfile, int64_t extent_size,
+        checksum_algorithm_t checksum_algorithm,
         scoped_device_block_aligned_ptr_t<crc_metablock_t> &&initial) {
     dbfile->set_file_size_at_least(metablock_offsets::min_filesize(extent_size),
                                        extent_size);
@@ -215,6 +221,7 @@ void metablock_manager_t::create(
     crc_metablock::prepare(buffer.get(),
                            static_cast<uint32_t>(cluster_version_t::LATEST_DISK),
                            MB_START_VERSION,
+                           checksum_algorithm,
                            std::move(checksums));
     co_write(dbfile, metablock_offsets::get(extent_size, 0), METABLOCK_SIZE, buffer.get(),
              DEFAULT_DISK_ACCOUNT, datasync_op::wrap_in_datasyncs);
@@ -244,8 +251,9 @@ bool disk_format_version_is_recognized(uint32_t disk_format_version) {
         || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_2)
         || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_3)
         || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_4)
+        || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_5)
         || disk_format_version ==
-            static_cast<uint32_t>(cluster_version_t::v2_5_is_latest_disk);
+            static_cast<uint32_t>(cluster_version_t::v2_6_is_latest_disk);
 }
 
 bool metablock_manager_t::verify_checksum_fileranges(const crc_metablock_t *mb) {
@@ -257,7 +265,9 @@ bool metablock_manager_t::verify_checksum_fileranges(const crc_metablock_t *mb)
                 mb->disk_format_version);
     }
 
-    if (mb->disk_format_version != static_cast<uint32_t>(cluster_version_t::v2_5_is_latest_disk)) {
+    if (mb->disk_format_version != static_cast<uint32_t>(cluster_version_t::v2_5)
+        && mb->disk_format_version
+            != static_cast<uint32_t>(cluster_version_t::v2_6_is_latest_disk)) {
         // There are no checksums.
         return true;
     }
@@ -299,13 +309,15 @@ bool metablock_manager_t::verify_checksum_fileranges(const crc_metablock_t *mb)
     callback.wait();
     extent_manager->stats->bytes_read(total_read);
 
-    serializer_checksum combined_sum = identity_checksum();
+    const checksum_algorithm_t checksum_algorithm = extent_manager->checksum_algorithm;
+    serializer_checksum combined_sum = identity_checksum(checksum_algorithm);
     for (size_t i = 0; i < num_fileranges; ++i) {
         serializer_checksum x = compute_checksum(
+                checksum_algorithm,
                 bufs[i].get(),
                 disk_list->fileranges[i].size / serializer_checksum::word_size);
         combined_sum = compute_checksum_concat(
-                combined_sum, x,
+                checksum_algorithm, combined_sum, x,
                 disk_list->fileranges[i].size / serializer_checksum::word_size);
     }
     if (combined_sum.value != disk_list->checksum.value) {
@@ -439,6 +451,7 @@ void metablock_manager_t::co_write_metablock(
         = crc_metablock::prepare(crc_mb.get(),
                                  static_cast<uint32_t>(cluster_version_t::LATEST_DISK),
                                  next_version_number++,
+                                 extent_manager->checksum_algorithm,
                                  std::move(checksums));
     rassert(crc_metablock::check_crc(crc_mb.get()));
 
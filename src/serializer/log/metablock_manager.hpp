@@ -35,6 +35,7 @@ public:
        'initial' has its log_serializer_metablock_t part pre-filled, the rest
        zero-wiped. */
     static void create(file_t *dbfile, int64_t extent_size,
+                       checksum_algorithm_t checksum_algorithm,
                        scoped_device_block_aligned_ptr_t<crc_metablock_t> &&initial);
 
     /* Tries to load existing metablocks */
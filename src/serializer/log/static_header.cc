@@ -1,7 +1,10 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "serializer/log/static_header.hpp"
 
+#include <string.h>
+
 #include <functional>
+#include <string>
 #include <vector>
 
 #include "arch/arch.hpp"
@@ -20,6 +23,22 @@
 // files, but previous versions of RethinkDB cannot read 2.2+ files.
 #define V1_13_SERIALIZER_VERSION_STRING "1.13"
 
+// Files that use CRC-32C checksums instead of Fletcher-64 have this suffix.  Their
+// format is otherwise the same.
+#define CRC32C_SERIALIZER_VERSION_SUFFIX "-crc32c"
+
+// Files whose LBA has been garbage collected into a snapshot at least once (see
+// lba/snapshot.hpp) have this suffix after the checksum one.  Older versions would
+// ignore the snapshot and lose the part of the index that it holds, so the version
+// string changes when the first snapshot is written.
+#define LBA_SNAPSHOT_SERIALIZER_VERSION_SUFFIX "-snap"
+
+// Files that may contain compressed blocks (see serializer/compression.hpp) use this
+// in place of CURRENT_SERIALIZER_VERSION_STRING, with the same suffixes.  Older
+// versions would read the compressed blocks as plain block data.  A "-z" suffix
+// wouldn't fit into `static_header_t::version` after "-crc32c-snap".
+#define COMPRESSED_SERIALIZER_VERSION_STRING "2.3"
+
 // See also CLUSTER_VERSION_STRING and cluster_version_t.
 
 bool static_header_check(file_t *file) {
@@ -33,7 +52,31 @@ bool static_header_check(file_t *file) {
     }
 }
 
-void co_static_header_write(file_t *file, void *data, size_t data_size) {
+static std::string serializer_version_string(checksum_algorithm_t checksum_algorithm,
+                                             bool has_lba_snapshots,
+                                             bool has_compressed_blocks) {
+    std::string version = has_compressed_blocks
+        ? COMPRESSED_SERIALIZER_VERSION_STRING
+        : CURRENT_SERIALIZER_VERSION_STRING;
+    switch (checksum_algorithm) {
+    case checksum_algorithm_t::fletcher64:
+        break;
+    case checksum_algorithm_t::crc32c:
+        version += CRC32C_SERIALIZER_VERSION_SUFFIX;
+        break;
+    default:
+        unreachable();
+    }
+    if (has_lba_snapshots) {
+        version += LBA_SNAPSHOT_SERIALIZER_VERSION_SUFFIX;
+    }
+    return version;
+}
+
+void co_static_header_write(file_t *file, void *data, size_t data_size,
+                            checksum_algorithm_t checksum_algorithm,
+                            bool has_lba_snapshots,
+                            bool has_compressed_blocks) {
     scoped_device_block_aligned_ptr_t<static_header_t> buffer(DEVICE_BLOCK_SIZE);
     rassert(sizeof(static_header_t) + data_size < DEVICE_BLOCK_SIZE);
 
@@ -45,9 +88,10 @@ void co_static_header_write(file_t *file, void *data, size_t data_size) {
     rassert(sizeof(SOFTWARE_NAME_STRING) < 16);
     memcpy(buffer->software_name, SOFTWARE_NAME_STRING, sizeof(SOFTWARE_NAME_STRING));
 
-    rassert(sizeof(CURRENT_SERIALIZER_VERSION_STRING) < 16);
-    memcpy(buffer->version, CURRENT_SERIALIZER_VERSION_STRING,
-           sizeof(CURRENT_SERIALIZER_VERSION_STRING));
+    const std::string version = serializer_version_string(
+        checksum_algorithm, has_lba_snapshots, has_compressed_blocks);
+    guarantee(version.size() < sizeof(buffer->version));
+    strncpy(buffer->version, version.c_str(), sizeof(buffer->version));
 
     memcpy(buffer->data, data, data_size);
 
@@ -58,15 +102,48 @@ void co_static_header_write(file_t *file, void *data, size_t data_size) {
 }
 
 void co_static_header_write_helper(file_t *file, static_header_write_callback_t *cb,
-                                   void *data, size_t data_size) {
-    co_static_header_write(file, data, data_size);
+                                   void *data, size_t data_size,
+                                   checksum_algorithm_t checksum_algorithm,
+                                   bool has_lba_snapshots,
+                                   bool has_compressed_blocks) {
+    co_static_header_write(file, data, data_size, checksum_algorithm,
+                           has_lba_snapshots, has_compressed_blocks);
     cb->on_static_header_write();
 }
 
 bool static_header_write(file_t *file, void *data, size_t data_size,
+                         checksum_algorithm_t checksum_algorithm,
+                         bool has_lba_snapshots,
+                         bool has_compressed_blocks,
                          static_header_write_callback_t *cb) {
     coro_t::spawn_later_ordered(std::bind(co_static_header_write_helper,
-                                          file, cb, data, data_size));
+                                          file, cb, data, data_size,
+                                          checksum_algorithm, has_lba_snapshots,
+                                          has_compressed_blocks));
+    return false;
+}
+
+// Sets the outputs and returns true if `version` is one of the version strings that
+// `serializer_version_string()` makes.
+static bool parse_serializer_version_string(const char *version,
+                                            checksum_algorithm_t *checksum_algorithm_out,
+                                            bool *has_lba_snapshots_out,
+                                            bool *has_compressed_blocks_out) {
+    for (checksum_algorithm_t checksum_algorithm
+             : {checksum_algorithm_t::fletcher64, checksum_algorithm_t::crc32c}) {
+        for (bool has_lba_snapshots : {false, true}) {
+            for (bool has_compressed_blocks : {false, true}) {
+                const std::string candidate = serializer_version_string(
+                    checksum_algorithm, has_lba_snapshots, has_compressed_blocks);
+                if (memcmp(version, candidate.c_str(), candidate.size() + 1) == 0) {
+                    *checksum_algorithm_out = checksum_algorithm;
+                    *has_lba_snapshots_out = has_lba_snapshots;
+                    *has_compressed_blocks_out = has_compressed_blocks;
+                    return true;
+                }
+            }
+        }
+    }
     return false;
 }
 
@@ -75,7 +152,10 @@ void co_static_header_read(
         static_header_read_callback_t *callback,
         void *data_out,
         size_t data_size,
-        bool *needs_migration_out) {
+        bool *needs_migration_out,
+        checksum_algorithm_t *checksum_algorithm_out,
+        bool *has_lba_snapshots_out,
+        bool *has_compressed_blocks_out) {
     rassert(sizeof(static_header_t) + data_size < DEVICE_BLOCK_SIZE);
     scoped_device_block_aligned_ptr_t<static_header_t> buffer(DEVICE_BLOCK_SIZE);
     co_read(file, 0, DEVICE_BLOCK_SIZE, buffer.get(), DEFAULT_DISK_ACCOUNT);
@@ -83,11 +163,18 @@ void co_static_header_read(
         fail_due_to_user_error("This doesn't appear to be a RethinkDB data file.");
     }
 
+    // Make sure that the version string is terminated before we print it.
+    buffer->version[sizeof(buffer->version) - 1] = '\0';
     if (memcmp(buffer->version, V1_13_SERIALIZER_VERSION_STRING,
                sizeof(V1_13_SERIALIZER_VERSION_STRING)) == 0) {
         *needs_migration_out = true;
-    } else if (memcmp(buffer->version, CURRENT_SERIALIZER_VERSION_STRING,
-               sizeof(CURRENT_SERIALIZER_VERSION_STRING)) == 0) {
+        *checksum_algorithm_out = checksum_algorithm_t::fletcher64;
+        *has_lba_snapshots_out = false;
+        *has_compressed_blocks_out = false;
+    } else if (parse_serializer_version_string(buffer->version,
+                                               checksum_algorithm_out,
+                                               has_lba_snapshots_out,
+                                               has_compressed_blocks_out)) {
         *needs_migration_out = false;
     } else {
         fail_due_to_user_error("File version is incorrect. This file was created with "
@@ -106,32 +193,51 @@ void static_header_read(
         void *data_out,
         size_t data_size,
         bool *needs_migration_out,
+        checksum_algorithm_t *checksum_algorithm_out,
+        bool *has_lba_snapshots_out,
+        bool *has_compressed_blocks_out,
         static_header_read_callback_t *cb) {
     coro_t::spawn_later_ordered(std::bind(co_static_header_read,
         file,
         cb,
         data_out,
         data_size,
-        needs_migration_out));
+        needs_migration_out,
+        checksum_algorithm_out,
+        has_lba_snapshots_out,
+        has_compressed_blocks_out));
 }
 
-void migrate_static_header(file_t *file, size_t data_size) {
-    // Migrate the static header by rewriting it
-    logNTC("Migrating file to serializer version %s.",
-           CURRENT_SERIALIZER_VERSION_STRING);
-
+void migrate_static_header(file_t *file, size_t data_size, bool has_lba_snapshots,
+                           bool has_compressed_blocks) {
     std::vector<char> data(data_size);
 
     struct noop_cb_t : public static_header_read_callback_t {
         void on_static_header_read() { }
     } noop_cb;
     bool needs_migration;
+    checksum_algorithm_t checksum_algorithm;
+    bool had_lba_snapshots;
+    bool had_compressed_blocks;
     co_static_header_read(file,
         &noop_cb,
         data.data(),
         data_size,
-        &needs_migration);
-    guarantee(needs_migration);
+        &needs_migration,
+        &checksum_algorithm,
+        &had_lba_snapshots,
+        &had_compressed_blocks);
+    guarantee(needs_migration
+              || (has_lba_snapshots && !had_lba_snapshots)
+              || (has_compressed_blocks && !had_compressed_blocks));
+    // Once set, the flags stay set.
+    guarantee(has_lba_snapshots || !had_lba_snapshots);
+    guarantee(has_compressed_blocks || !had_compressed_blocks);
 
-    co_static_header_write(file, data.data(), data_size);
+    // Migrate the static header by rewriting it
+    logNTC("Migrating file to serializer version %s.",
+           serializer_version_string(checksum_algorithm, has_lba_snapshots,
+                                     has_compressed_blocks).c_str());
+    co_static_header_write(file, data.data(), data_size, checksum_algorithm,
+                           has_lba_snapshots, has_compressed_blocks);
 }
@@ -4,6 +4,7 @@
 
 #include <stddef.h>
 #include "arch/types.hpp"
+#include "serializer/checksum.hpp"
 
 struct static_header_t {
     char software_name[16];
@@ -18,12 +19,21 @@ struct static_header_write_callback_t {
     virtual ~static_header_write_callback_t() {}
 };
 
-void co_static_header_write(file_t *file, void *data, size_t data_size);
+// The checksum algorithm, whether the LBA has a snapshot and whether the file may
+// contain compressed blocks are recorded in the version string, so that versions of
+// RethinkDB that don't know about them refuse to open the file.
+void co_static_header_write(file_t *file, void *data, size_t data_size,
+                            checksum_algorithm_t checksum_algorithm,
+                            bool has_lba_snapshots,
+                            bool has_compressed_blocks);
 
 bool static_header_write(
     file_t *file,
     void *data,
     size_t data_size,
+    checksum_algorithm_t checksum_algorithm,
+    bool has_lba_snapshots,
+    bool has_compressed_blocks,
     static_header_write_callback_t *cb);
 
 struct static_header_read_callback_t {
@@ -36,9 +46,17 @@ void static_header_read(
     void *data_out,
     size_t data_size,
     bool *needs_migration_out,
+    checksum_algorithm_t *checksum_algorithm_out,
+    bool *has_lba_snapshots_out,
+    bool *has_compressed_blocks_out,
     static_header_read_callback_t *cb);
 
+// Rewrites the static header with the current version string.  This is used to
+// migrate 1.13 files, to mark a file once its LBA has a snapshot and to mark it before
+// compressed blocks are written to it, which is why `has_lba_snapshots` and
+// `has_compressed_blocks` are passed in rather than read back.
 // Blocks, must be run in a coroutine
-void migrate_static_header(file_t *file, size_t data_size);
+void migrate_static_header(file_t *file, size_t data_size, bool has_lba_snapshots,
+                           bool has_compressed_blocks);
 
 #endif /* SERIALIZER_LOG_STATIC_HEADER_HPP_ */
@@ -14,8 +14,23 @@ struct log_serializer_stats_t {
     perfmon_duration_sampler_t pm_serializer_block_reads;
     perfmon_counter_t pm_serializer_index_reads;
     perfmon_counter_t pm_serializer_block_writes;
+    /* The latencies of single block reads and of block writes (from submitting the
+    write to the callback), in microseconds. */
+    perfmon_histogram_t pm_serializer_block_read_latency;
+    perfmon_histogram_t pm_serializer_block_write_latency;
     perfmon_duration_sampler_t pm_serializer_index_writes;
     perfmon_sampler_t pm_serializer_index_writes_size;
+    /* How many index writes got merged into each group commit, and how many index
+    writes didn't need an LBA and metablock write of their own because of that. */
+    perfmon_sampler_t pm_serializer_index_write_group_size;
+    perfmon_counter_t pm_serializer_index_writes_merged;
+    /* How many blocks we wrote compressed, and how many bytes that saved. */
+    perfmon_counter_t pm_serializer_compressed_block_writes;
+    perfmon_counter_t pm_serializer_compression_saved_bytes;
+    /* How many block reads the flash cache served, and how many blocks were written
+    to it. */
+    perfmon_counter_t pm_serializer_flash_cache_hits;
+    perfmon_counter_t pm_serializer_flash_cache_writes;
 
     perfmon_rate_monitor_t pm_serializer_read_bytes_per_sec;
     perfmon_counter_t pm_serializer_read_bytes_total;
@@ -25,6 +40,7 @@ struct log_serializer_stats_t {
     /* used in serializer/log/extent_manager.cc */
     perfmon_counter_t pm_extents_in_use;
     perfmon_counter_t pm_file_size_bytes;
+    perfmon_counter_t pm_extents_discarded;
 
     /* used in serializer/log/lba/extent.cc */
     perfmon_counter_t pm_serializer_lba_extents;
@@ -33,8 +49,18 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents;
     perfmon_counter_t pm_serializer_data_extents_allocated;
     perfmon_counter_t pm_serializer_data_extents_gced;
+    perfmon_counter_t pm_serializer_cold_block_writes;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    /* The state of the data block GC controller (see serializer/log/gc_controller.hpp):
+    how fast the GC writes, the fraction of the old data extents that's live, the
+    resulting amplifications, and the garbage ratio at which the GC starts. */
+    perfmon_rate_monitor_t pm_serializer_gc_written_bytes_per_sec;
+    perfmon_counter_t pm_serializer_gc_written_bytes_total;
+    perfmon_sampler_t pm_serializer_gc_live_ratio;
+    perfmon_sampler_t pm_serializer_gc_write_amplification;
+    perfmon_sampler_t pm_serializer_gc_space_amplification;
+    perfmon_sampler_t pm_serializer_gc_start_ratio;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
@@ -6,15 +6,20 @@
 #include "errors.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "config/args.hpp"
 #include "serializer/types.hpp"
 
 
 merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+                                         int _max_active_writes,
+                                         int64_t _group_commit_window_ms) :
     inner(std::move(_inner)),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
+    group_commit_window_ms(_group_commit_window_ms),
+    num_ungrouped_index_writes(0),
+    last_group_size(0),
     write_committer(std::bind(&merger_serializer_t::do_index_write, this),
                     _max_active_writes) { }
 
@@ -48,6 +53,7 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
         for (auto op = write_ops.begin(); op != write_ops.end(); ++op) {
             push_index_write_op(*op);
         }
+        ++num_ungrouped_index_writes;
     }
 
     // Changes are now visible for subsequent `index_read()` calls.
@@ -67,6 +73,13 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 void merger_serializer_t::do_index_write() {
     assert_thread();
 
+    // If the previous group merged several index writes, there's concurrent write
+    // traffic.  Give other writers a moment to join this group, so that they can share
+    // its LBA and metablock writes.
+    if (group_commit_window_ms > 0 && last_group_size > 1) {
+        nap(group_commit_window_ms);
+    }
+
     // Pause changes to outstanding_index_write_ops
     new_mutex_in_line_t outstanding_mutex_acq(&outstanding_index_write_mutex);
     outstanding_mutex_acq.acq_signal()->wait_lazily_unordered();
@@ -80,6 +93,11 @@ void merger_serializer_t::do_index_write() {
          ++op_pair) {
         write_ops.push_back(op_pair->second);
     }
+    last_group_size = num_ungrouped_index_writes;
+    num_ungrouped_index_writes = 0;
+    if (last_group_size > 0) {
+        inner->record_index_write_group(last_group_size);
+    }
 
     new_mutex_in_line_t mutex_acq(&inner_index_write_mutex);
     mutex_acq.acq_signal()->wait();
@@ -22,6 +22,12 @@
  * hash shards) can be merged together, improving efficiency and significantly
  * reducing the number of disk seeks on rotational drives.
  *
+ * If a `group_commit_window_ms` is given, the merger also waits that long before
+ * committing a group whenever the previous group contained more than one index
+ * write.  When many clients write with hard durability, this lets their flushes share
+ * one LBA write and one metablock write (including the fdatasync before it), instead
+ * of lining up behind each other.
+ *
  * As an additional optimization, merger_serializer_t uses a common file account
  * for all block_writes, so reduce the amount of random disk seeks that can
  * occur when writes from multiple different accounts get interleaved (see
@@ -30,15 +36,17 @@
 
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes,
+                        int64_t _group_commit_window_ms = 0);
     ~merger_serializer_t();
 
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit) {
-        return inner->make_io_account(priority, outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    io_class_t io_class) {
+        return inner->make_io_account(priority, outstanding_requests_limit, io_class);
     }
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -116,6 +124,10 @@ public:
         return inner->is_gc_active();
     }
 
+    void record_index_write_group(size_t num_merged_writes) {
+        inner->record_index_write_group(num_merged_writes);
+    }
+
 private:
     // Adds `op` to `outstanding_index_write_ops`, using `merge_index_write_op()` if
     // necessary
@@ -129,6 +141,14 @@ private:
     const scoped_ptr_t<serializer_t> inner;
     const scoped_ptr_t<file_account_t> block_writes_io_account;
 
+    const int64_t group_commit_window_ms;
+
+    // The number of `index_write()` calls whose write ops have been pushed to
+    // `outstanding_index_write_ops` since the last group was assembled.
+    size_t num_ungrouped_index_writes;
+    // The number of `index_write()` calls that went into the previous group.
+    size_t last_group_size;
+
     // Used to obey the index_write API and make sure we can't possibly make
     // simultaneous racing index_write calls.
     new_mutex_t inner_index_write_mutex;
@@ -48,9 +48,11 @@ public:
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
-    file_account_t *make_io_account(int priority);
+    file_account_t *make_io_account(
+        int priority, io_class_t io_class = io_class_t::foreground_write);
     virtual file_account_t *make_io_account(int priority,
-                                            int outstanding_requests_limit) = 0;
+                                            int outstanding_requests_limit,
+                                            io_class_t io_class) = 0;
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
     This is supported through a serializer_read_ahead_callback_t which gets called
@@ -126,6 +128,11 @@ public:
     /* Return true if the garbage collector is active */
     virtual bool is_gc_active() const = 0;
 
+    /* Serializers that merge several `index_write()` calls into a single one (see
+    `merger_serializer_t`) call this on their inner serializer right before the merged
+    `index_write()`, so that the size of each group can show up in its stats. */
+    virtual void record_index_write_group(UNUSED size_t num_merged_writes) { }
+
 private:
     DISABLE_COPYING(serializer_t);
 };
@@ -135,6 +135,10 @@ class block_token_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // How much space the block takes up on disk.  This is smaller than
+    // `block_size()` if the serializer stored the block compressed.
+    block_size_t ondisk_block_size() const { return ondisk_block_size_; }
+    bool is_compressed() const { return ondisk_block_size_ != block_size_; }
 
 private:
     friend class log_serializer_t;
@@ -146,13 +150,16 @@ private:
 
     block_token_t(log_serializer_t *serializer,
                   int64_t initial_offset,
-                  block_size_t initial_ser_block_size);
+                  block_size_t initial_ser_block_size,
+                  block_size_t initial_ondisk_ser_block_size);
 
     log_serializer_t *const serializer_;
     std::atomic<intptr_t> ref_count_;
 
     // The block's size.
     block_size_t block_size_;
+    // The block's size on disk, which is what the data block manager deals with.
+    block_size_t ondisk_block_size_;
 
     // Either (a.) a checksum of what the block's on-disk contents should be, (b.)(i.)
     // the value datasync_checksum(), which means the block's write has been datasynced,
@@ -192,6 +199,11 @@ public:
     virtual void move_serializer_file_to_permanent_location() = 0;
     virtual void open_serializer_file_existing(scoped_ptr_t<file_t> *file_out) = 0;
     virtual void unlink_serializer_file() = 0;
+
+    // Opens (and truncates) the file at `path` for a `flash_cache_t`.  Returns false
+    // if that fails; the serializer then does without the flash cache.
+    virtual bool open_flash_cache_file(const std::string &path,
+                                       scoped_ptr_t<file_t> *file_out) = 0;
 };
 
 class serializer_t;
@@ -8,9 +8,11 @@ class backfill_item_t;
 class backfill_pre_item_t;
 
 #ifndef NDEBUG
-// Checks that the metainfo has a certain value, or certain kind of value.
+// Checks that the metainfo has a certain value, or certain kind of value.  Without a
+// callback, it only checks that the metainfo covers `region`.
 class metainfo_checker_t {
 public:
+    explicit metainfo_checker_t(const region_t &r) : region(r) { }
     metainfo_checker_t(
             const region_t &r,
             const std::function<void(const region_t &, const binary_blob_t &)> &cb) :
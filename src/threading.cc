@@ -80,6 +80,27 @@ thread_allocation_t::thread_allocation_t(thread_allocator_t *p)
     ++parent->num_allocated[best_thread];
 }
 
+thread_allocation_t::thread_allocation_t(thread_allocator_t *p, threadnum_t near)
+    : thread(near), /* temporary, will be overwritten below */
+      parent(p) {
+    parent->assert_thread();
+    const int node = get_thread_numa_node(near);
+    int32_t best_thread = near.threadnum;
+    for (int32_t i = 0; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
+        if (i == best_thread || get_thread_numa_node(threadnum_t(i)) != node) {
+            continue;
+        }
+        if (parent->num_allocated[i] < parent->num_allocated[best_thread]) {
+            best_thread = i;
+        } else if (parent->num_allocated[i] == parent->num_allocated[best_thread] &&
+                   parent->secondary_lt(threadnum_t(i), threadnum_t(best_thread))) {
+            best_thread = i;
+        }
+    }
+    thread = threadnum_t(best_thread);
+    ++parent->num_allocated[best_thread];
+}
+
 thread_allocation_t::~thread_allocation_t() {
     rassert(parent->num_allocated[thread.threadnum] > 0);
     --parent->num_allocated[thread.threadnum];
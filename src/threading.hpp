@@ -111,6 +111,8 @@ private:
 class thread_allocation_t {
 public:
     explicit thread_allocation_t(thread_allocator_t *p);
+    // Only picks among the threads on the same NUMA node as `near`.
+    thread_allocation_t(thread_allocator_t *p, threadnum_t near);
     ~thread_allocation_t();
     threadnum_t get_thread() const;
 private:
@@ -0,0 +1,38 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/adaptive_concurrency_limit.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(AdaptiveConcurrencyLimit, FollowsLatency) {
+    perfmon_collection_t stats;
+    adaptive_concurrency_limit_t limit(4, 16, 256, &stats, "test");
+    ASSERT_EQ(16u, limit.get());
+
+    // An idle pool doesn't tell us anything.
+    for (int i = 0; i < 1000; ++i) {
+        limit.on_task_done(ticks_t{MILLION}, 1, false);
+    }
+    ASSERT_EQ(16u, limit.get());
+
+    // A busy pool whose tasks don't slow down grows up to the maximum.
+    for (int i = 0; i < 1000; ++i) {
+        limit.on_task_done(ticks_t{MILLION}, limit.get(), true);
+    }
+    ASSERT_EQ(256u, limit.get());
+
+    // When the latency goes up a lot, it shrinks down to the minimum.
+    for (int i = 0; i < 100; ++i) {
+        limit.on_task_done(ticks_t{20 * MILLION}, limit.get(), true);
+    }
+    ASSERT_EQ(4u, limit.get());
+
+    // Once the long-term latency has caught up, it grows again.
+    for (int i = 0; i < 2000; ++i) {
+        limit.on_task_done(ticks_t{20 * MILLION}, limit.get(), true);
+    }
+    ASSERT_EQ(256u, limit.get());
+}
+
+}  // namespace unittest
@@ -3,8 +3,11 @@
 
 #include "unittest/gtest.hpp"
 
+#include "arch/timing.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "containers/shared_buffer.hpp"
 
 namespace unittest {
 
@@ -13,7 +16,7 @@ void dump_to_string(write_message_t *wm, std::string *out) {
 
     out->clear();
     for (write_buffer_t *p = buffers->head(); p; p = buffers->next(p)) {
-        out->append(p->data, p->data + p->size);
+        out->append(p->data(), p->data() + p->size);
     }
 }
 
@@ -34,6 +37,95 @@ TEST(WriteMessageTest, Variant) {
     ASSERT_EQ(15u, s.size());
 }
 
+TEST(WriteMessageTest, AppendShared) {
+    const size_t big_size = 5000;
+    counted_t<shared_buf_t> buf = shared_buf_t::create(big_size);
+    for (size_t i = 0; i < big_size; ++i) {
+        buf->data()[i] = static_cast<char>('a' + i % 26);
+    }
+    shared_buf_ref_t<char> ref(counted_t<const shared_buf_t>(buf), 0);
+
+    write_message_t wm;
+    wm.append("<", 1);
+    wm.append_shared(ref.make_child(10), 20);
+    wm.append_shared(ref, big_size);
+    wm.append(">", 1);
+
+    // The small piece is copied, the big one referenced.
+    intrusive_list_t<write_buffer_t> *buffers = wm.unsafe_expose_buffers();
+    ASSERT_EQ(3u, buffers->size());
+    ASSERT_EQ(buf->data(), buffers->next(buffers->head())->data());
+
+    std::string s;
+    dump_to_string(&wm, &s);
+    std::string expected = "<" + std::string(buf->data(10), 20)
+        + std::string(buf->data(), big_size) + ">";
+    ASSERT_EQ(expected, s);
+    ASSERT_EQ(expected.size(), wm.size());
+}
+
+TEST(WriteMessageTest, SmallAppendsBenchmark) {
+    // Most serializers append one small field at a time, like this.
+    const int NUM_FIELDS = 2000000;
+    ticks_t start_ticks = get_ticks();
+    write_message_t wm;
+    for (int i = 0; i < NUM_FIELDS; ++i) {
+        serialize<cluster_version_t::LATEST_OVERALL>(&wm, static_cast<int32_t>(i));
+        serialize<cluster_version_t::LATEST_OVERALL>(&wm, static_cast<int8_t>(i));
+    }
+    double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+    printf("write_message_t small appends: %.1f MB/s\n",
+           wm.size() / secs / MEGABYTE);
 
+    ASSERT_EQ(NUM_FIELDS * 5u, wm.size());
+    std::string s;
+    dump_to_string(&wm, &s);
+    int32_t first;
+    memcpy(&first, s.data() + 5 * 1234, sizeof(first));
+    ASSERT_EQ(1234, first);
+}
+
+template <class T>
+void test_raw_vector_round_trip(const std::vector<T> &v) {
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, v);
+    ASSERT_EQ(serialized_size<cluster_version_t::LATEST_OVERALL>(v), wm.size());
+
+    // The elements are copied at once, but the bytes have to be the same as if they
+    // had been serialized one by one.
+    write_message_t expected_wm;
+    serialize_varint_uint64(&expected_wm, v.size());
+    for (const T &x : v) {
+        serialize_universal(&expected_wm, x);
+    }
+    std::string s, expected;
+    dump_to_string(&wm, &s);
+    dump_to_string(&expected_wm, &expected);
+    ASSERT_EQ(expected, s);
+
+    buffer_read_stream_t rs(s.data(), s.size());
+    std::vector<T> out;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::LATEST_OVERALL>(&rs, &out));
+    ASSERT_EQ(v, out);
+
+    // A truncated vector doesn't deserialize.
+    buffer_read_stream_t short_rs(s.data(), s.size() - 1);
+    if (!v.empty()) {
+        ASSERT_EQ(archive_result_t::SOCK_EOF,
+                  deserialize<cluster_version_t::LATEST_OVERALL>(&short_rs, &out));
+    }
+}
+
+TEST(WriteMessageTest, RawVectors) {
+    test_raw_vector_round_trip(std::vector<char>());
+    test_raw_vector_round_trip(std::vector<char>{'a', 'b', '\0', 'c'});
+    std::vector<int64_t> ints;
+    for (int64_t i = 0; i < 1000; ++i) {
+        ints.push_back(i * 1000003 - 500000);
+    }
+    test_raw_vector_round_trip(ints);
+    test_raw_vector_round_trip(std::vector<double>{1.5, -2.25, 1e300});
+}
 
 }  // namespace unittest
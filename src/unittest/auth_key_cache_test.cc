@@ -0,0 +1,39 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/auth/key_cache.hpp"
+#include "clustering/administration/auth/password.hpp"
+#include "clustering/administration/auth/username.hpp"
+#include "crypto/hash.hpp"
+#include "crypto/hmac.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(AuthKeyCache, ScramKeys) {
+    auth::username_t username("alice");
+    auth::password_t password("secret", 16);
+    for (int i = 0; i < 2; ++i) {
+        auth::scram_keys_t keys = auth::get_scram_keys(username, password);
+        EXPECT_EQ(crypto::hmac_sha256(password.get_hash(), "Client Key"),
+                  keys.client_key);
+        EXPECT_EQ(crypto::sha256(keys.client_key), keys.stored_key);
+        EXPECT_EQ(crypto::hmac_sha256(password.get_hash(), "Server Key"),
+                  keys.server_key);
+    }
+}
+
+TPTEST(AuthKeyCache, PlaintextPassword) {
+    auth::username_t username("bob");
+    auth::password_t password("secret", 16);
+    EXPECT_FALSE(auth::check_plaintext_password(username, password, "wrong"));
+    EXPECT_TRUE(auth::check_plaintext_password(username, password, "secret"));
+    // This one comes from the cache.
+    EXPECT_TRUE(auth::check_plaintext_password(username, password, "secret"));
+    EXPECT_FALSE(auth::check_plaintext_password(username, password, "wrong"));
+
+    auth::password_t changed("other", 16);
+    EXPECT_FALSE(auth::check_plaintext_password(username, changed, "secret"));
+    EXPECT_TRUE(auth::check_plaintext_password(username, changed, "other"));
+}
+
+}  // namespace unittest
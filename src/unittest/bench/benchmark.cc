@@ -0,0 +1,113 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "unittest/bench/benchmark.hpp"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+benchmark_run_t::benchmark_run_t(int64_t iterations)
+    : iterations_(iterations), bytes_per_iteration_(0), timing_(false),
+      elapsed_nanos_(0) {
+    start_timer();
+}
+
+void benchmark_run_t::reset_timer() {
+    elapsed_nanos_ = 0;
+    if (timing_) {
+        start_ = get_ticks();
+    }
+}
+
+void benchmark_run_t::stop_timer() {
+    if (timing_) {
+        elapsed_nanos_ += get_ticks().nanos - start_.nanos;
+        timing_ = false;
+    }
+}
+
+void benchmark_run_t::start_timer() {
+    if (!timing_) {
+        start_ = get_ticks();
+        timing_ = true;
+    }
+}
+
+int64_t benchmark_run_t::elapsed_nanos() const {
+    return elapsed_nanos_ + (timing_ ? get_ticks().nanos - start_.nanos : 0);
+}
+
+std::vector<benchmark_t> *all_benchmarks() {
+    // This is a function-local static so that it exists before the static
+    // `benchmark_registration_t`s of the other files get constructed.
+    static std::vector<benchmark_t> benchmarks;
+    return &benchmarks;
+}
+
+benchmark_registration_t::benchmark_registration_t(
+        const char *name, const std::function<void(benchmark_run_t *)> &fun) {
+    all_benchmarks()->push_back(benchmark_t{name, fun, 1});
+}
+
+benchmark_registration_t::benchmark_registration_t(
+        const char *name, const std::function<void(benchmark_run_t *)> &fun,
+        const std::vector<int> &thread_counts) {
+    for (int num_threads : thread_counts) {
+        all_benchmarks()->push_back(benchmark_t{
+            strprintf("%s/%d", name, num_threads), fun, num_threads});
+    }
+}
+
+// We never run more iterations than this, even if the operation is too fast to time.
+static const int64_t MAX_BENCHMARK_ITERATIONS = 1000000000;
+
+benchmark_result_t run_benchmark(const benchmark_t &benchmark, int64_t min_nanos) {
+    int64_t iterations = 1;
+    for (;;) {
+        benchmark_result_t result;
+        run_in_thread_pool([&]() {
+            benchmark_run_t run(iterations);
+            benchmark.fun(&run);
+            run.stop_timer();
+            result.iterations = iterations;
+            result.elapsed_nanos = run.elapsed_nanos();
+            result.bytes_per_iteration = run.bytes_per_iteration();
+        }, benchmark.num_threads);
+        if (result.elapsed_nanos >= min_nanos
+            || iterations >= MAX_BENCHMARK_ITERATIONS) {
+            return result;
+        }
+        // Like Go, we aim for 20% more than the minimum time, but grow by at most a
+        // factor of 100 at a time, because the first runs are too short to predict
+        // much.
+        int64_t next = iterations * 100;
+        if (result.elapsed_nanos > 0) {
+            next = std::min<int64_t>(next, static_cast<int64_t>(
+                1.2 * min_nanos * iterations / result.elapsed_nanos));
+        }
+        iterations = std::min(MAX_BENCHMARK_ITERATIONS,
+                              std::max(next, iterations + 1));
+    }
+}
+
+void print_benchmark_result(FILE *out, const std::string &name,
+                            const benchmark_result_t &result) {
+    const double nanos_per_op =
+        static_cast<double>(result.elapsed_nanos) / result.iterations;
+    // Benchmark names are identifiers, so they never need to be escaped.
+    fprintf(out, "{\"name\": \"%s\", \"version\": \"%s\", \"iterations\": %" PRIi64
+            ", \"ns_per_op\": %.2f",
+            name.c_str(), RETHINKDB_VERSION, result.iterations, nanos_per_op);
+    if (result.bytes_per_iteration > 0 && result.elapsed_nanos > 0) {
+        fprintf(out, ", \"mb_per_sec\": %.2f",
+                result.bytes_per_iteration * 1000.0 / nanos_per_op);
+    }
+    fprintf(out, "}\n");
+    fflush(out);
+}
+
+}  // namespace unittest
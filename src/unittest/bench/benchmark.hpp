@@ -0,0 +1,104 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef UNITTEST_BENCH_BENCHMARK_HPP_
+#define UNITTEST_BENCH_BENCHMARK_HPP_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include "time.hpp"
+
+namespace unittest {
+
+/* One run of a benchmark, a little like Go's `testing.B`.  The benchmark performs
+its operation `iterations()` times, and `rethinkdb-bench` runs it with more and more
+iterations until a run takes long enough to be timed.  The timer is running when the
+benchmark gets called, so it should call `reset_timer()` once it's done setting things
+up. */
+class benchmark_run_t {
+public:
+    explicit benchmark_run_t(int64_t iterations);
+
+    int64_t iterations() const { return iterations_; }
+
+    // Forgets the time measured so far.
+    void reset_timer();
+    void stop_timer();
+    void start_timer();
+    int64_t elapsed_nanos() const;
+
+    // How many bytes one iteration processes, if that makes sense, so that the
+    // results include the throughput.
+    void set_bytes_per_iteration(int64_t bytes) { bytes_per_iteration_ = bytes; }
+    int64_t bytes_per_iteration() const { return bytes_per_iteration_; }
+
+private:
+    const int64_t iterations_;
+    int64_t bytes_per_iteration_;
+    bool timing_;
+    ticks_t start_;
+    int64_t elapsed_nanos_;
+
+    DISABLE_COPYING(benchmark_run_t);
+};
+
+struct benchmark_t {
+    std::string name;
+    std::function<void(benchmark_run_t *)> fun;
+    int num_threads;
+};
+
+// All the benchmarks, in the order they were defined.
+std::vector<benchmark_t> *all_benchmarks();
+
+class benchmark_registration_t {
+public:
+    benchmark_registration_t(const char *name,
+                             const std::function<void(benchmark_run_t *)> &fun);
+    // Registers the benchmark once for every number of threads, as "<name>/<threads>".
+    benchmark_registration_t(const char *name,
+                             const std::function<void(benchmark_run_t *)> &fun,
+                             const std::vector<int> &thread_counts);
+};
+
+struct benchmark_result_t {
+    int64_t iterations;
+    int64_t elapsed_nanos;
+    int64_t bytes_per_iteration;
+};
+
+// Runs the benchmark in a thread pool with `benchmark.num_threads` threads, until one
+// run takes at least `min_nanos`.
+benchmark_result_t run_benchmark(const benchmark_t &benchmark, int64_t min_nanos);
+
+// Prints the result as a single line of JSON.
+void print_benchmark_result(FILE *out, const std::string &name,
+                            const benchmark_result_t &result);
+
+}  // namespace unittest
+
+/* Defines a benchmark called "group.name", which `rethinkdb-bench` runs in a thread
+pool with a single thread. */
+#define BENCHMARK(group, name)                                                  \
+    void bench_##group##_##name(::unittest::benchmark_run_t *run);              \
+    static ::unittest::benchmark_registration_t                                 \
+        bench_##group##_##name##_registration(#group "." #name,                 \
+                                              bench_##group##_##name);          \
+    void bench_##group##_##name(::unittest::benchmark_run_t *run)
+
+/* Defines a benchmark that `rethinkdb-bench` runs once in a thread pool of each of the
+given sizes, as "group.name/<threads>".  The benchmark starts on the first thread and
+can fan out to the others with `get_num_threads()`. */
+#define BENCHMARK_THREADS(group, name, ...)                                     \
+    void bench_##group##_##name(::unittest::benchmark_run_t *run);              \
+    static ::unittest::benchmark_registration_t                                 \
+        bench_##group##_##name##_registration(#group "." #name,                 \
+                                              bench_##group##_##name,           \
+                                              {__VA_ARGS__});                   \
+    void bench_##group##_##name(::unittest::benchmark_run_t *run)
+
+#endif  // UNITTEST_BENCH_BENCHMARK_HPP_
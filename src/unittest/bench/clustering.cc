@@ -0,0 +1,94 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+#include <set>
+#include <vector>
+
+#include "clustering/table_contract/coordinator/calculate_contracts.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
+#include "unittest/bench/benchmark.hpp"
+#include "unittest/clustering_contract_utils.hpp"
+
+namespace unittest {
+
+// Runs the contract coordinator on a table with 1000 shards on three servers, right
+// after one of the servers has gone away, which is when the coordinator has to
+// recalculate the contracts for every shard.
+BENCHMARK(ContractCoordinator, FailoverThousandShards) {
+    const size_t NUM_SHARDS = 1000;
+    std::vector<server_id_t> servers;
+    for (int i = 0; i < 3; ++i) {
+        servers.push_back(server_id_t::generate_server_id());
+    }
+    const std::set<server_id_t> all_servers(servers.begin(), servers.end());
+
+    table_raft_state_t state;
+    table_config_and_shards_t &cs = state.config;
+    cs.config.basic.database = generate_uuid();
+    cs.config.basic.name = name_string_t::guarantee_valid("test");
+    cs.config.basic.primary_key = "id";
+    cs.config.write_ack_config = write_ack_config_t::MAJORITY;
+    cs.config.durability = write_durability_t::HARD;
+    cs.config.user_data = default_user_data();
+    cs.config.block_size = DEFAULT_BTREE_BLOCK_SIZE;
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        table_config_t::shard_t shard;
+        shard.all_replicas = all_servers;
+        shard.primary_replica = servers[i % servers.size()];
+        cs.config.shards.push_back(shard);
+        if (i != 0) {
+            cs.shard_scheme.split_points.push_back(
+                store_key_t(strprintf("%06zu", i)));
+        }
+    }
+
+    cpu_branch_ids_t branch = quick_cpu_branch(
+        &state.branch_history, { {"*-*", nullptr, 0} });
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        state.current_branches.update(cpu_sharding_subspace(i), branch.branch_ids[i]);
+    }
+
+    // The first server has just disconnected, so it doesn't send acks anymore.
+    std::map<contract_id_t, std::map<server_id_t, contract_ack_t> > acks;
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        const server_id_t &primary = cs.config.shards[i].primary_replica;
+        cpu_contracts_t contracts = quick_contract_simple(all_servers, primary);
+        region_t shard_region(cs.shard_scheme.get_shard_range(i));
+        for (size_t cpu = 0; cpu < CPU_SHARDING_FACTOR; ++cpu) {
+            contract_id_t cid = generate_uuid();
+            state.contracts[cid] = std::make_pair(
+                region_intersection(shard_region, cpu_sharding_subspace(cpu)),
+                contracts.contracts[cpu]);
+            for (const server_id_t &server : servers) {
+                if (server == servers[0]) {
+                    continue;
+                }
+                acks[cid][server] = contract_ack_t(server == primary
+                    ? contract_ack_t::state_t::primary_ready
+                    : contract_ack_t::state_t::secondary_streaming);
+            }
+        }
+    }
+
+    watchable_map_var_t<std::pair<server_id_t, server_id_t>, empty_value_t> connections;
+    for (const server_id_t &s1 : servers) {
+        for (const server_id_t &s2 : servers) {
+            if (s1 != servers[0] && s2 != servers[0]) {
+                connections.set_key(std::make_pair(s1, s2), empty_value_t());
+            }
+        }
+    }
+
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        std::set<contract_id_t> remove_contracts;
+        std::map<contract_id_t, std::pair<region_t, contract_t> > add_contracts;
+        std::map<region_t, branch_id_t> register_current_branches;
+        std::set<branch_id_t> remove_branches;
+        branch_history_t add_branches;
+        calculate_all_contracts(state, acks, &connections,
+            &remove_contracts, &add_contracts, &register_current_branches,
+            &remove_branches, &add_branches);
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,134 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/fifo_enforcer.hpp"
+#include "concurrency/new_semaphore.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/rwlock.hpp"
+#include "unittest/bench/benchmark.hpp"
+
+namespace unittest {
+
+// How many coroutines compete for the lock or semaphore in the contended benchmarks.
+static const int64_t CONTENDING_COROUTINES = 16;
+
+// Runs `op` `run->iterations()` times in all, split between `num_coroutines`
+// coroutines that run at the same time.  `op` gets the coroutine's number.
+static void run_in_coroutines(benchmark_run_t *run, int64_t num_coroutines,
+                              const std::function<void(int64_t)> &op) {
+    pmap(num_coroutines, [&](int64_t i) {
+        int64_t share = run->iterations() / num_coroutines
+            + (i < run->iterations() % num_coroutines ? 1 : 0);
+        for (int64_t j = 0; j < share; ++j) {
+            op(i);
+        }
+    });
+}
+
+// Takes and releases a write lock that nobody else wants.
+BENCHMARK(RWLock, UncontendedWrite) {
+    rwlock_t lock;
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        rwlock_in_line_t acq(&lock, access_t::write);
+        acq.write_signal()->wait();
+    }
+}
+
+// Coroutines take turns holding a write lock across a yield, so every acquisition
+// waits for the previous holder and hands the lock on when it's done.
+BENCHMARK(RWLock, ContendedWrite) {
+    rwlock_t lock;
+    run->reset_timer();
+    run_in_coroutines(run, CONTENDING_COROUTINES, [&](int64_t) {
+        rwlock_in_line_t acq(&lock, access_t::write);
+        acq.write_signal()->wait();
+        coro_t::yield();
+    });
+}
+
+// Like `ContendedWrite`, but one coroutine in eight writes and the others read, so
+// readers share the lock between writes.
+BENCHMARK(RWLock, ContendedMixed) {
+    rwlock_t lock;
+    run->reset_timer();
+    run_in_coroutines(run, CONTENDING_COROUTINES, [&](int64_t i) {
+        if (i % 8 == 0) {
+            rwlock_in_line_t acq(&lock, access_t::write);
+            acq.write_signal()->wait();
+            coro_t::yield();
+        } else {
+            rwlock_in_line_t acq(&lock, access_t::read);
+            acq.read_signal()->wait();
+            coro_t::yield();
+        }
+    });
+}
+
+// Coroutines hold one of four slots of a semaphore across a yield.
+BENCHMARK(NewSemaphore, Contended) {
+    new_semaphore_t semaphore(4);
+    run->reset_timer();
+    run_in_coroutines(run, CONTENDING_COROUTINES, [&](int64_t) {
+        new_semaphore_in_line_t acq(&semaphore, 1);
+        acq.acquisition_signal()->wait();
+        coro_t::yield();
+    });
+}
+
+// Writes reach the sink in the opposite order of their tokens, so the sink has to
+// queue all but the last of every batch.
+BENCHMARK(FifoEnforcer, ReorderedWrites) {
+    const int64_t BATCH_SIZE = 64;
+    fifo_enforcer_source_t source;
+    fifo_enforcer_sink_t sink;
+    std::vector<fifo_enforcer_write_token_t> tokens;
+    run->reset_timer();
+    for (int64_t done = 0; done < run->iterations(); done += BATCH_SIZE) {
+        const int64_t batch = std::min(BATCH_SIZE, run->iterations() - done);
+        tokens.clear();
+        for (int64_t i = 0; i < batch; ++i) {
+            tokens.push_back(source.enter_write());
+        }
+        pmap(batch, [&](int64_t i) {
+            fifo_enforcer_sink_t::exit_write_t exit(&sink, tokens[batch - 1 - i]);
+            exit.wait();
+        });
+    }
+}
+
+// A coroutine on every thread goes to the next thread and back, all at the same time.
+BENCHMARK_THREADS(OnThread, RoundTrip, 2, 4, 16, 64) {
+    const int num_threads = get_num_threads();
+    run->reset_timer();
+    pmap(num_threads, [&](int64_t i) {
+        on_thread_t home((threadnum_t(i)));
+        int64_t share = run->iterations() / num_threads
+            + (i < run->iterations() % num_threads ? 1 : 0);
+        for (int64_t j = 0; j < share; ++j) {
+            on_thread_t next((threadnum_t((i + 1) % num_threads)));
+        }
+    });
+}
+
+// Coroutines on the first thread pulse a signal for each of the other threads, and
+// go there to wait for it.  This includes the trip there and back.
+BENCHMARK_THREADS(CrossThreadSignal, Pulse, 2, 4, 16, 64) {
+    const int num_threads = get_num_threads();
+    run->reset_timer();
+    run_in_coroutines(run, num_threads - 1, [&](int64_t i) {
+        cond_t source;
+        cross_thread_signal_t dest(&source, threadnum_t(i + 1));
+        source.pulse();
+        on_thread_t thread((threadnum_t(i + 1)));
+        dest.wait();
+    });
+}
+
+}  // namespace unittest
@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "config/args.hpp"
+#include "unittest/bench/benchmark.hpp"
+#include "utils.hpp"
+
+static void print_usage(FILE *out) {
+    fprintf(out,
+            "Usage: rethinkdb-bench [--filter <substring>] [--min-time <secs>] "
+            "[--list]\n"
+            "Runs the benchmarks whose names contain the substring, and prints one "
+            "line of JSON\nwith the results of each benchmark.\n");
+}
+
+int main(int argc, char **argv) {
+    startup_shutdown_t startup_shutdown;
+
+    std::string filter;
+    double min_secs = 1.0;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            char *end;
+            min_secs = strtod(argv[++i], &end);
+            if (*end != '\0' || !(min_secs > 0)) {
+                print_usage(stderr);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(stdout);
+            return EXIT_SUCCESS;
+        } else {
+            print_usage(stderr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (const unittest::benchmark_t &benchmark : *unittest::all_benchmarks()) {
+        if (benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        if (list) {
+            printf("%s\n", benchmark.name.c_str());
+            continue;
+        }
+        unittest::benchmark_result_t result = unittest::run_benchmark(
+            benchmark, static_cast<int64_t>(min_secs * BILLION));
+        unittest::print_benchmark_result(stdout, benchmark.name, result);
+    }
+
+    return EXIT_SUCCESS;
+}
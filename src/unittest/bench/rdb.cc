@@ -0,0 +1,105 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "btree/reql_specific.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "containers/uuid.hpp"
+#include "rapidjson/document.h"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/store.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "unittest/bench/benchmark.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static void insert_bench_rows(int count, store_t *store) {
+    for (int i = 0; i < count; ++i) {
+        cond_t dummy_interruptor;
+        scoped_ptr_t<txn_t> txn;
+        {
+            scoped_ptr_t<real_superblock_t> superblock;
+            write_token_t token;
+            store->new_write_token(&token);
+            store->acquire_superblock_for_write(
+                1, write_durability_t::SOFT,
+                &token, &txn, &superblock, &dummy_interruptor);
+
+            std::string data = strprintf(
+                "{\"id\": %d, \"name\": \"row number %d\", \"value\": %d}",
+                i, i, i * 7 % 1000);
+            rapidjson::Document doc;
+            doc.Parse(data.c_str());
+            store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
+            rdb_modification_report_t mod_report(pk);
+            rdb_live_deletion_context_t deletion_context;
+            point_write_response_t response;
+            rdb_set(pk,
+                    ql::to_datum(doc, ql::configured_limits_t(),
+                                 reql_version_t::LATEST),
+                    false, store->btree.get(), repli_timestamp_t::distant_past,
+                    superblock.get(), &deletion_context, &response, &mod_report.info,
+                    static_cast<profile::trace_t *>(nullptr), nullptr);
+        }
+        txn->commit();
+    }
+}
+
+// Reads a whole table of 1000 small rows through the primary index.
+BENCHMARK(RdbBtree, RgetSlice) {
+    const int NUM_ROWS = 1000;
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                &file_opener,
+                                &get_global_perfmon_collection());
+    store_t store(region_t::universe(),
+                  &serializer,
+                  &balancer,
+                  "bench_store",
+                  true,
+                  &get_global_perfmon_collection(),
+                  nullptr,
+                  &io_backender,
+                  base_path_t("."),
+                  generate_uuid(),
+                  update_sindexes_t::UPDATE,
+                  which_cpu_shard_t{0, 1});
+    insert_bench_rows(NUM_ROWS, &store);
+
+    cond_t dummy_interruptor;
+    ql::env_t env(&dummy_interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        read_token_t token;
+        store.new_read_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        store.acquire_superblock_for_read(&token, &txn, &superblock,
+                                          &dummy_interruptor, false);
+        rget_read_response_t response;
+        rdb_rget_slice(store.btree.get(),
+                       region_t::universe(),
+                       key_range_t::universe(),
+                       r_nullopt,
+                       superblock.get(),
+                       &env,
+                       ql::batchspec_t::all(),
+                       std::vector<ql::transform_variant_t>(),
+                       optional<ql::terminal_variant_t>(),
+                       sorting_t::ASCENDING,
+                       &response,
+                       release_superblock_t::RELEASE);
+        guarantee(response.rows_scanned == NUM_ROWS);
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,74 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "clustering/table_contract/cpu_sharding.hpp"
+#include "region/region_map.hpp"
+#include "unittest/bench/benchmark.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+// A map like the metainfo of one CPU shard of a table with 64 shards, where every
+// shard has a different value.
+static region_map_t<int> sharded_region_map(std::vector<region_t> *shards_out) {
+    const size_t NUM_SHARDS = 64;
+    const region_t cpu_region = cpu_sharding_subspace(0);
+    region_map_t<int> map(cpu_region, -1);
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        region_t shard = cpu_region;
+        if (i != 0) {
+            shard.inner.left = store_key_t(strprintf("%06zu", i));
+        }
+        if (i != NUM_SHARDS - 1) {
+            shard.inner.right =
+                key_range_t::right_bound_t(store_key_t(strprintf("%06zu", i + 1)));
+        }
+        map.update(shard, static_cast<int>(i));
+        shards_out->push_back(shard);
+    }
+    return map;
+}
+
+// What `store_metainfo_manager_t::get()` does on every read and write.
+BENCHMARK(RegionMap, MaskShard) {
+    std::vector<region_t> shards;
+    region_map_t<int> map = sharded_region_map(&shards);
+    run->reset_timer();
+    int64_t total = 0;
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        region_map_t<int> masked = map.mask(shards[i % shards.size()]);
+        total += masked.get_domain().beg;
+    }
+    guarantee(total >= 0);
+}
+
+BENCHMARK(RegionMap, Lookup) {
+    std::vector<region_t> shards;
+    region_map_t<int> map = sharded_region_map(&shards);
+    std::vector<store_key_t> keys;
+    const region_t cpu_region = cpu_sharding_subspace(0);
+    for (int i = 0; keys.size() < 1000; ++i) {
+        store_key_t key(strprintf("%06d", i % 64) + strprintf("%d", i));
+        uint64_t h = hash_region_hasher(key);
+        if (h >= cpu_region.beg && h < cpu_region.end) {
+            keys.push_back(key);
+        }
+    }
+    run->reset_timer();
+    int64_t total = 0;
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        total += map.lookup(keys[i % keys.size()]);
+    }
+    guarantee(total >= 0);
+}
+
+BENCHMARK(RegionMap, UpdateShard) {
+    std::vector<region_t> shards;
+    region_map_t<int> map = sharded_region_map(&shards);
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        map.update(shards[i % shards.size()], static_cast<int>(i % 1000));
+    }
+}
+
+}  // namespace unittest
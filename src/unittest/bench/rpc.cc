@@ -0,0 +1,40 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/cond_var.hpp"
+#include "rpc/mailbox/mailbox.hpp"
+#include "rpc/mailbox/typed.hpp"
+#include "unittest/bench/benchmark.hpp"
+#include "unittest/clustering_utils.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Sends a message to a mailbox on another node over loopback TCP, and waits for the
+// reply.
+BENCHMARK(Mailbox, RoundTrip) {
+    connectivity_cluster_t c1, c2;
+    mailbox_manager_t m1(&c1, 'M'), m2(&c2, 'M');
+    test_cluster_run_t r1(&c1);
+    test_cluster_run_t r2(&c2);
+    r1.join(get_cluster_local_address(&c2), 0);
+    let_stuff_happen();
+
+    scoped_ptr_t<cond_t> reply_received;
+    mailbox_t<int64_t> reply_mailbox(&m1,
+        [&](signal_t *, int64_t) {
+            reply_received->pulse();
+        });
+    mailbox_t<mailbox_addr_t<int64_t>, int64_t> echo_mailbox(&m2,
+        [&](signal_t *, const mailbox_addr_t<int64_t> &reply_to, int64_t value) {
+            send(&m2, reply_to, value);
+        });
+
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        reply_received.init(new cond_t);
+        send(&m1, echo_mailbox.get_address(), reply_mailbox.get_address(), i);
+        reply_received->wait();
+        reply_received.reset();
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,121 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "containers/archive/buffer_stream.hpp"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "rdb_protocol/serialize_datum_onto_blob.hpp"
+#include "unittest/bench/benchmark.hpp"
+
+namespace unittest {
+
+// A document of the size and shape that a typical table row has.
+static ql::datum_t make_document() {
+    std::string json = "{\"id\": \"5c1a6b6e-8a7e-4f4c-9b1e-2f6d3e4a5b6c\""
+        ", \"name\": \"Benchmark Document\", \"active\": true, \"score\": 1234.5"
+        ", \"tags\": [\"alpha\", \"beta\", \"gamma\", \"delta\"]"
+        ", \"address\": {\"street\": \"1 Main Street\", \"city\": \"Springfield\""
+        ", \"zip\": \"12345\"}, \"history\": [";
+    for (int i = 0; i < 20; ++i) {
+        json += strprintf("%s{\"at\": %d, \"event\": \"event number %d\"}",
+                          i == 0 ? "" : ", ", i * 1000, i);
+    }
+    json += "]}";
+    rapidjson::Document doc;
+    doc.Parse(json.c_str());
+    guarantee(!doc.HasParseError());
+    return ql::to_datum(doc, ql::configured_limits_t(), reql_version_t::LATEST);
+}
+
+BENCHMARK(Datum, Serialize) {
+    const ql::datum_t doc = make_document();
+    run->set_bytes_per_iteration(
+        datum_serialized_size(doc, ql::check_datum_serialization_errors_t::YES));
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        write_message_t wm;
+        ql::serialization_result_t res =
+            datum_serialize(&wm, doc, ql::check_datum_serialization_errors_t::YES);
+        guarantee(!bad(res));
+    }
+}
+
+// Deserializes the document and reads all of its top-level fields, like a query
+// that reads a row from disk does.
+BENCHMARK(Datum, Deserialize) {
+    write_message_t wm;
+    ql::serialization_result_t res = datum_serialize(
+        &wm, make_document(), ql::check_datum_serialization_errors_t::YES);
+    guarantee(!bad(res));
+    counted_t<shared_buf_t> buf = flatten_write_message(&wm);
+
+    run->set_bytes_per_iteration(buf->size());
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        buffer_read_stream_t stream(buf->data(), buf->size());
+        ql::datum_t doc;
+        archive_result_t ares = datum_deserialize(&stream, &doc);
+        guarantee_deserialization(ares, "benchmark document");
+        for (size_t j = 0; j < doc.obj_size(); ++j) {
+            doc.get_pair(j);
+        }
+    }
+}
+
+BENCHMARK(Datum, WriteJson) {
+    const ql::datum_t doc = make_document();
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        doc.write_json(&writer);
+    }
+}
+
+// Values of the kind that `orderBy` sorts on.
+static std::vector<ql::datum_t> make_sort_values() {
+    std::vector<ql::datum_t> values;
+    for (int i = 0; i < 10000; ++i) {
+        const int n = (i * 7919) % 10000;
+        std::vector<ql::datum_t> value = {
+            ql::datum_t(datum_string_t(strprintf("user %d", n % 100))),
+            ql::datum_t(static_cast<double>(n))};
+        values.push_back(ql::datum_t(std::move(value),
+                                     ql::configured_limits_t::unlimited));
+    }
+    return values;
+}
+
+BENCHMARK(Datum, SortWithCmp) {
+    const std::vector<ql::datum_t> values = make_sort_values();
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        std::vector<ql::datum_t> sorted = values;
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const ql::datum_t &a, const ql::datum_t &b) {
+                             return a.cmp(b) < 0;
+                         });
+    }
+}
+
+// Includes the time to compute the keys.
+BENCHMARK(Datum, SortWithSortKeys) {
+    const std::vector<ql::datum_t> values = make_sort_values();
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        std::vector<std::pair<std::string, size_t> > keys(values.size());
+        for (size_t j = 0; j < values.size(); ++j) {
+            guarantee(values[j].append_sort_key(&keys[j].first));
+            keys[j].second = j;
+        }
+        std::stable_sort(keys.begin(), keys.end());
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,213 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <unordered_map>
+#include <vector>
+
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "containers/open_addressing_map.hpp"
+#include "containers/scoped.hpp"
+#include "random.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "unittest/bench/benchmark.hpp"
+#include "unittest/btree_utils.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static std::vector<store_key_t> random_keys(size_t count) {
+    // A fixed seed, so that every run uses the same keys.
+    rng_t rng(12345);
+    std::vector<store_key_t> keys;
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back(store_key_t(random_letter_string(&rng, 8, 24)));
+    }
+    return keys;
+}
+
+// Inserts into a leaf node, and starts over with an empty node when it's full.
+BENCHMARK(LeafNode, Insert) {
+    const max_block_size_t bs = max_block_size_t::unsafe_make(4096);
+    short_value_sizer_t sizer(bs);
+    scoped_malloc_t<leaf_node_t> node(bs.value());
+    leaf::init(&sizer, node.get());
+    const std::vector<store_key_t> keys = random_keys(1000);
+    short_value_buffer_t value(std::string(16, 'v'));
+    repli_timestamp_t tstamp = repli_timestamp_t::distant_past;
+
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        const btree_key_t *key = keys[i % keys.size()].btree_key();
+        if (leaf::is_full(&sizer, node.get(), key, value.data())) {
+            leaf::init(&sizer, node.get());
+        }
+        const repli_timestamp_t next_tstamp = tstamp.next();
+        leaf::insert(&sizer, node.get(), key, value.data(), next_tstamp, tstamp,
+                     key_modification_proof_t::real_proof());
+        tstamp = next_tstamp;
+    }
+}
+
+// Looks up the keys of a full leaf node.
+BENCHMARK(LeafNode, Lookup) {
+    const max_block_size_t bs = max_block_size_t::unsafe_make(4096);
+    short_value_sizer_t sizer(bs);
+    scoped_malloc_t<leaf_node_t> node(bs.value());
+    leaf::init(&sizer, node.get());
+    const std::vector<store_key_t> candidates = random_keys(1000);
+    short_value_buffer_t value(std::string(16, 'v'));
+    std::vector<store_key_t> keys;
+    for (const store_key_t &key : candidates) {
+        if (leaf::is_full(&sizer, node.get(), key.btree_key(), value.data())) {
+            break;
+        }
+        leaf::insert(&sizer, node.get(), key.btree_key(), value.data(),
+                     repli_timestamp_t::distant_past, repli_timestamp_t::distant_past,
+                     key_modification_proof_t::real_proof());
+        keys.push_back(key);
+    }
+
+    run->reset_timer();
+    uint8_t value_out[256];
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        bool found = leaf::lookup(&sizer, node.get(), keys[i % keys.size()].btree_key(),
+                                  value_out);
+        guarantee(found);
+    }
+}
+
+// Acquires and reads blocks that are already in the cache.
+BENCHMARK(PageCache, AcquireRelease) {
+    const int NUM_BLOCKS = 100;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                &file_opener,
+                                &get_global_perfmon_collection());
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    cache_t cache(&serializer, &balancer, &get_global_perfmon_collection(),
+                  which_cpu_shard_t{0, 1});
+    cache_conn_t cache_conn(&cache);
+
+    std::vector<block_id_t> block_ids;
+    {
+        txn_t txn(&cache_conn, write_durability_t::SOFT, NUM_BLOCKS);
+        for (int i = 0; i < NUM_BLOCKS; ++i) {
+            buf_lock_t lock(buf_parent_t(&txn), alt_create_t::create);
+            buf_write_t write(&lock);
+            memset(write.get_data_write(), i, cache.max_block_size().value());
+            block_ids.push_back(lock.block_id());
+        }
+        txn.commit();
+    }
+
+    txn_t txn(&cache_conn, read_access_t::read);
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        buf_lock_t lock(buf_parent_t(&txn), block_ids[i % block_ids.size()],
+                        access_t::read);
+        buf_read_t read(&lock);
+        uint16_t block_size;
+        read.get_data_read(&block_size);
+    }
+}
+
+// How the page cache looks up a block's current_page_t: a working set of sequential
+// block ids, acquired in random order.
+static const size_t PAGE_MAP_BLOCKS = 1 << 20;
+
+static std::vector<block_id_t> random_block_ids() {
+    rng_t rng(12345);
+    std::vector<block_id_t> ids;
+    for (size_t i = 0; i < (1 << 16); ++i) {
+        ids.push_back(rng.randint(PAGE_MAP_BLOCKS));
+    }
+    return ids;
+}
+
+BENCHMARK(PageMap, OpenAddressingLookup) {
+    open_addressing_map_t<block_id_t, int *> map;
+    int value;
+    for (block_id_t id = 0; id < PAGE_MAP_BLOCKS; ++id) {
+        map.insert(id, &value);
+    }
+    const std::vector<block_id_t> ids = random_block_ids();
+
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        const block_id_t id = ids[i % ids.size()];
+        guarantee(map.get(id) != nullptr);
+    }
+}
+
+BENCHMARK(PageMap, UnorderedMapLookup) {
+    std::unordered_map<block_id_t, int *> map;
+    int value;
+    for (block_id_t id = 0; id < PAGE_MAP_BLOCKS; ++id) {
+        map.insert(std::make_pair(id, &value));
+    }
+    const std::vector<block_id_t> ids = random_block_ids();
+
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        const block_id_t id = ids[i % ids.size()];
+        guarantee(map.find(id) != map.end());
+    }
+}
+
+struct io_cond_t : public iocallback_t, public cond_t {
+    void on_io_complete() {
+        pulse();
+    }
+};
+
+// Writes one block at a time, and waits for each write.
+BENCHMARK(LogSerializer, BlockWrite) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    run->set_bytes_per_iteration(ser.max_block_size().value());
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        std::vector<buf_write_info_t> infos;
+        infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), i));
+        io_cond_t cb;
+        std::vector<counted_t<block_token_t> > tokens
+            = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+        cb.wait();
+    }
+}
+
+// Reads the same block over and over.
+BENCHMARK(LogSerializer, BlockRead) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    std::vector<buf_write_info_t> infos;
+    infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), 0));
+    io_cond_t cb;
+    std::vector<counted_t<block_token_t> > tokens
+        = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+
+    run->set_bytes_per_iteration(ser.max_block_size().value());
+    run->reset_timer();
+    for (int64_t i = 0; i < run->iterations(); ++i) {
+        buf_ptr_t read = ser.block_read(tokens[0], account.get());
+    }
+}
+
+}  // namespace unittest
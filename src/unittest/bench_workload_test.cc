@@ -0,0 +1,83 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <vector>
+
+#include "clustering/administration/main/bench.hpp"
+#include "random.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(BenchWorkload, LatencyHistogramPercentiles) {
+    latency_histogram_t empty;
+    ASSERT_EQ(0, empty.percentile(99));
+
+    // Two workers see 1 ... 1000000 between them.
+    latency_histogram_t a, b;
+    for (int64_t i = 1; i <= 1000000; ++i) {
+        (i % 2 == 0 ? a : b).record(i);
+    }
+    a.merge(b);
+    a.merge(empty);
+    ASSERT_EQ(1000000, a.count());
+    ASSERT_EQ(1000000, a.max());
+    ASSERT_EQ(1000000, a.percentile(100));
+    ASSERT_EQ(1, a.percentile(0));
+    for (double p : { 50.0, 90.0, 99.0, 99.9 }) {
+        const double expected = p * 10000;
+        ASSERT_GE(a.percentile(p), expected);
+        ASSERT_LE(a.percentile(p), expected * (1 + 1.0 / 64));
+    }
+
+    // Small values are exact.
+    latency_histogram_t small;
+    for (int64_t i = 0; i < 100; ++i) {
+        small.record(i);
+    }
+    ASSERT_EQ(49, small.percentile(50));
+    ASSERT_EQ(99, small.percentile(100));
+}
+
+TEST(BenchWorkload, ZipfianIsSkewedAndInRange) {
+    const uint64_t n = 1000;
+    zipfian_generator_t zipfian(n);
+    rng_t rng(7);
+    std::vector<int64_t> counts(n, 0);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t key = zipfian.next(&rng);
+        ASSERT_LT(key, n);
+        ++counts[key];
+    }
+    // With theta = 0.99 the hottest key gets about 13% of the draws.
+    int64_t hottest = 0;
+    for (int64_t count : counts) {
+        hottest = std::max(hottest, count);
+    }
+    ASSERT_GT(hottest, 10000);
+    ASSERT_LT(hottest, 16000);
+
+    // The same seed gives the same keys.
+    rng_t rng1(42), rng2(42);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(zipfian.next(&rng1), zipfian.next(&rng2));
+    }
+}
+
+TEST(BenchWorkload, ParseMix) {
+    bench_config_t config;
+    ASSERT_TRUE(parse_bench_mix("b", &config));
+    ASSERT_EQ(95, config.mix[static_cast<size_t>(bench_op_t::GET)]);
+    ASSERT_EQ(5, config.mix[static_cast<size_t>(bench_op_t::UPDATE)]);
+
+    ASSERT_TRUE(parse_bench_mix("range=3,insert=1", &config));
+    ASSERT_EQ(0, config.mix[static_cast<size_t>(bench_op_t::GET)]);
+    ASSERT_EQ(3, config.mix[static_cast<size_t>(bench_op_t::RANGE)]);
+    ASSERT_EQ(1, config.mix[static_cast<size_t>(bench_op_t::INSERT)]);
+
+    ASSERT_FALSE(parse_bench_mix("f", &config));
+    ASSERT_FALSE(parse_bench_mix("get=1,delete=1", &config));
+    ASSERT_FALSE(parse_bench_mix("get=0", &config));
+    ASSERT_FALSE(parse_bench_mix("get=1,", &config));
+}
+
+}  // namespace unittest
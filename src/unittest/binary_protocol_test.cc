@@ -0,0 +1,59 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/binary.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/response.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+ql::datum_t binary_protocol_round_trip(write_message_t *wm) {
+    string_stream_t write_stream;
+    int write_res = send_write_message(&write_stream, wm);
+    EXPECT_EQ(0, write_res);
+
+    string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+    ql::datum_t res;
+    archive_result_t deserialize_res = ql::datum_deserialize(&read_stream, &res);
+    EXPECT_EQ(archive_result_t::SUCCESS, deserialize_res);
+    return res;
+}
+
+TEST(BinaryProtocolTest, ResponseRoundTrip) {
+    std::vector<ql::datum_t> array;
+    array.push_back(ql::datum_t(1.0));
+    array.push_back(ql::datum_t("two"));
+    ql::datum_t plain_row(std::move(array), ql::configured_limits_t::unlimited);
+
+    // A row that comes with its serialization, like the ones read from disk.
+    write_message_t row_wm;
+    ql::datum_serialize(&row_wm, plain_row, ql::check_datum_serialization_errors_t::NO);
+    ql::datum_t buf_row = binary_protocol_round_trip(&row_wm);
+    ASSERT_TRUE(buf_row.get_buf_ref() != nullptr);
+
+    ql::response_t response;
+    response.set_type(Response::SUCCESS_SEQUENCE);
+    std::vector<ql::datum_t> rows;
+    rows.push_back(plain_row);
+    rows.push_back(buf_row);
+    response.set_data(std::move(rows));
+    response.add_note(Response::SEQUENCE_FEED);
+
+    write_message_t wm;
+    binary_protocol_t::write_response_to_message(&response, &wm);
+    ql::datum_t decoded = binary_protocol_round_trip(&wm);
+
+    ASSERT_EQ(ql::datum_t::R_OBJECT, decoded.get_type());
+    EXPECT_EQ(Response::SUCCESS_SEQUENCE, decoded.get_field("t").as_int());
+    ql::datum_t decoded_rows = decoded.get_field("r");
+    ASSERT_EQ(2u, decoded_rows.arr_size());
+    EXPECT_EQ(plain_row, decoded_rows.get(0));
+    EXPECT_EQ(plain_row, decoded_rows.get(1));
+    ql::datum_t notes = decoded.get_field("n");
+    ASSERT_EQ(1u, notes.arr_size());
+    EXPECT_EQ(Response::SEQUENCE_FEED, notes.get(0).as_int());
+    EXPECT_FALSE(decoded.get_field("e", ql::NOTHROW).has());
+}
+
+}  // namespace unittest
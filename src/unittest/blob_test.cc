@@ -123,6 +123,16 @@ public:
         check(txn);
     }
 
+    int64_t overwrite(txn_t *txn, const std::string &x) {
+        SCOPED_TRACE("overwrite");
+        EXPECT_EQ(expected_.size(), x.size());
+        int64_t blocks_written = blob_.overwrite_changed_blocks(x.data(),
+                                                                buf_parent_t(txn));
+        expected_ = x;
+        check(txn);
+        return blocks_written;
+    }
+
     void clear(txn_t *txn) {
         SCOPED_TRACE("clear");
         blob_.clear(buf_parent_t(txn));
@@ -269,6 +279,31 @@ void combinations_test(cache_t *cache) {
     }
 }
 
+void overwrite_test(cache_t *cache) {
+    SCOPED_TRACE("overwrite_test");
+    cache_conn_t cache_conn(cache);
+    txn_t txn(&cache_conn, write_durability_t::SOFT, 0);
+
+    int64_t l2_sz = size_after_magic * (size_after_magic / sizeof(block_id_t));
+    int64_t szs[] = { 3 * size_after_magic + 10, l2_sz + 1 };
+    for (int64_t sz : szs) {
+        SCOPED_TRACE(strprintf("size %" PRIi64, sz));
+        blob_tracker_t tk(251);
+        std::string value(sz, 'a');
+        tk.append(&txn, value);
+
+        ASSERT_EQ(0, tk.overwrite(&txn, value));
+        value[size_after_magic + 1] = 'b';
+        ASSERT_EQ(1, tk.overwrite(&txn, value));
+        value[0] = 'c';
+        value[sz - 1] = 'c';
+        ASSERT_EQ(2, tk.overwrite(&txn, value));
+
+        tk.clear(&txn);
+    }
+
+    txn.commit();
+}
 
 void run_tests(cache_t *cache) {
     // The tests above hard-code constants related to these numbers.
@@ -282,6 +317,7 @@ void run_tests(cache_t *cache) {
     small_value_test(cache);
     small_value_boundary_test(cache);
     combinations_test(cache);
+    overwrite_test(cache);
 }
 
 TPTEST(BlobTest, AllTests) {
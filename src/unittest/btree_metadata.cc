@@ -3,6 +3,7 @@
 
 #include "arch/io/disk.hpp"
 #include "clustering/administration/persist/file.hpp"
+#include "concurrency/pmap.hpp"
 #include "unittest/unittest_utils.hpp"
 
 namespace unittest {
@@ -104,5 +105,55 @@ TPTEST(BtreeMetadata, ManyKeysBigValues) {
     }
 }
 
+TPTEST(BtreeMetadata, ConcurrentWriters) {
+    temp_directory_t temp_dir;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t non_interruptor;
+
+    metadata_file_t::key_t<int> int_prefix("int/");
+    const int num_writers = 20;
+    {
+        metadata_file_t file(
+            &io_backender,
+            temp_dir.path(),
+            &get_global_perfmon_collection(),
+            [&](metadata_file_t::write_txn_t *, signal_t *) { },
+            &non_interruptor);
+
+        // A committed transaction doesn't hold the file's lock anymore, even before
+        // it's destructed, so the next transaction doesn't have to wait for it.
+        {
+            metadata_file_t::write_txn_t first(&file, &non_interruptor);
+            first.write(int_prefix.suffix("first"), 1, &non_interruptor);
+            first.commit();
+            metadata_file_t::write_txn_t second(&file, &non_interruptor);
+            second.write(int_prefix.suffix("second"), 2, &non_interruptor);
+            second.commit();
+        }
+
+        // Writers whose flushes overlap all get their data in.
+        pmap(num_writers, [&](int i) {
+            metadata_file_t::write_txn_t txn(&file, &non_interruptor);
+            txn.write(int_prefix.suffix(strprintf("%d", i)), i, &non_interruptor);
+            txn.commit();
+        });
+    }
+
+    {
+        metadata_file_t file(
+            &io_backender,
+            temp_dir.path(),
+            &get_global_perfmon_collection(),
+            &non_interruptor);
+        metadata_file_t::read_txn_t txn(&file, &non_interruptor);
+        EXPECT_EQ(1, txn.read(int_prefix.suffix("first"), &non_interruptor));
+        EXPECT_EQ(2, txn.read(int_prefix.suffix("second"), &non_interruptor));
+        for (int i = 0; i < num_writers; ++i) {
+            EXPECT_EQ(i, txn.read(int_prefix.suffix(strprintf("%d", i)),
+                                  &non_interruptor));
+        }
+    }
+}
+
 } // namespace unittest
 
@@ -2,6 +2,7 @@
 
 #include "arch/io/disk.hpp"
 #include "arch/types.hpp"
+#include "btree/bulk_load.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "rdb_protocol/btree.hpp"
@@ -174,6 +175,23 @@ public:
         set(key, value, repli_timestamp_t::distant_past);
     }
 
+    // The tree must be empty.
+    void bulk_load(const std::map<store_key_t, std::string> &pairs) {
+        EXPECT_TRUE(is_empty());
+        run_txn_fn(true, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+            btree_bulk_loader_t loader(sizer.get(), superblock.get());
+            for (const auto &pair : pairs) {
+                short_value_buffer_t buf(pair.second);
+                loader.add(pair.first.btree_key(), buf.data(),
+                           repli_timestamp_t::distant_past);
+            }
+            loader.finish();
+            EXPECT_EQ(static_cast<int64_t>(pairs.size()), loader.num_pairs());
+        });
+
+        kv = pairs;
+    }
+
     void remove(const store_key_t &key, repli_timestamp_t timestamp) {
         EXPECT_TRUE(should_have(key));
 
@@ -507,4 +525,44 @@ TPTEST(BTree, RemoveRandomOrder) {
     ctx.verify();
 }
 
+void bulk_load_and_modify(int num_pairs) {
+    BTreeTestContext ctx;
+    rng_t rng;
+
+    std::map<store_key_t, std::string> pairs;
+    while (pairs.size() < static_cast<size_t>(num_pairs)) {
+        pairs[store_key_t(random_letter_string(&rng, 1, 250))] =
+            random_letter_string(&rng, 0, 250);
+    }
+    ctx.bulk_load(pairs);
+    ctx.verify();
+    for (int i = 0; i < 20; ++i) {
+        ctx.get(ctx.pick_random_key(&rng));
+        ctx.range(random_key_range(&rng));
+    }
+
+    // The full nodes that the bulk loader wrote must still split and merge correctly.
+    for (int i = 0; i < 500; ++i) {
+        if (rng.randint(2) == 0) {
+            ctx.set(store_key_t(random_letter_string(&rng, 1, 250)),
+                    random_letter_string(&rng, 0, 250));
+        } else if (!ctx.is_empty()) {
+            ctx.remove(ctx.pick_random_key(&rng));
+        }
+    }
+    ctx.verify();
+}
+
+TPTEST(BTree, BulkLoadEmpty) {
+    bulk_load_and_modify(0);
+}
+
+TPTEST(BTree, BulkLoadSingleLeaf) {
+    bulk_load_and_modify(3);
+}
+
+TPTEST(BTree, BulkLoadLarge) {
+    bulk_load_and_modify(5000);
+}
+
 } // namespace unittest
@@ -0,0 +1,77 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "containers/buf_arena.hpp"
+#include "math.hpp"
+#include "threading.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(BufArenaTest, AllocAndFree) {
+    const buf_arena_stats_t before = get_buf_arena_stats();
+    std::vector<void *> bufs;
+    for (size_t size = DEVICE_BLOCK_SIZE; size <= BUF_ARENA_MAX_CHUNK_SIZE;
+         size += DEVICE_BLOCK_SIZE) {
+        for (int i = 0; i < 10; ++i) {
+            void *buf = buf_arena_alloc(size);
+            ASSERT_TRUE(divides(DEVICE_BLOCK_SIZE, reinterpret_cast<uintptr_t>(buf)));
+            memset(buf, i, size);
+            bufs.push_back(buf);
+        }
+    }
+    const buf_arena_stats_t during = get_buf_arena_stats();
+    EXPECT_GT(during.allocated_bytes, before.allocated_bytes);
+    EXPECT_GE(during.touched_bytes, during.allocated_bytes);
+    EXPECT_GE(during.mapped_bytes, during.touched_bytes);
+
+    for (void *buf : bufs) {
+        buf_arena_free(buf);
+    }
+    EXPECT_EQ(before.allocated_bytes, get_buf_arena_stats().allocated_bytes);
+}
+
+TPTEST(BufArenaTest, EmptySlabsGetUnmapped) {
+    const buf_arena_stats_t before = get_buf_arena_stats();
+    std::vector<void *> bufs;
+    // Enough 4 KB chunks for a few dozen slabs.
+    for (int i = 0; i < 20000; ++i) {
+        bufs.push_back(buf_arena_alloc(4 * KILOBYTE));
+    }
+    EXPECT_GE(get_buf_arena_stats().mapped_bytes,
+              static_cast<uint64_t>(20000 * 4 * KILOBYTE));
+    for (void *buf : bufs) {
+        buf_arena_free(buf);
+    }
+    const buf_arena_stats_t after = get_buf_arena_stats();
+    EXPECT_EQ(before.allocated_bytes, after.allocated_bytes);
+    // Only a few empty slabs stay cached.
+    EXPECT_LT(after.mapped_bytes, before.mapped_bytes + 20000 * 4 * KILOBYTE / 4);
+}
+
+TPTEST(BufArenaTest, FreeOnOtherThread, 2) {
+    const buf_arena_stats_t before = get_buf_arena_stats();
+    void *buf = buf_arena_alloc(8 * KILOBYTE);
+    {
+        on_thread_t thread_switcher(threadnum_t(1));
+        buf_arena_free(buf);
+    }
+    EXPECT_EQ(before.allocated_bytes, get_buf_arena_stats().allocated_bytes);
+}
+
+TEST(BufArenaTest, FallBackOutsideThreadPool) {
+    const buf_arena_stats_t before = get_buf_arena_stats();
+    void *buf = buf_arena_alloc(4 * KILOBYTE);
+    ASSERT_TRUE(divides(DEVICE_BLOCK_SIZE, reinterpret_cast<uintptr_t>(buf)));
+    EXPECT_EQ(before.allocated_bytes, get_buf_arena_stats().allocated_bytes);
+    buf_arena_free(buf);
+
+    void *big = buf_arena_alloc(BUF_ARENA_MAX_CHUNK_SIZE + DEVICE_BLOCK_SIZE);
+    buf_arena_free(big);
+}
+
+}  // namespace unittest
@@ -0,0 +1,49 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "containers/bump_arena.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(BumpArenaTest, Map) {
+    bump_arena_t arena;
+    typedef std::map<int, std::string, std::less<int>,
+                     bump_allocator_t<std::pair<const int, std::string> > > map_t;
+    map_t::allocator_type allocator(&arena);
+    map_t map(std::less<int>(), allocator);
+
+    // Enough entries to spill out of the inline buffer into several blocks.
+    for (int i = 0; i < 10000; ++i) {
+        map[i] = std::to_string(i);
+    }
+    for (int i = 0; i < 10000; i += 2) {
+        map.erase(i);
+    }
+    for (int i = 20000; i < 25000; ++i) {
+        map[i] = std::to_string(i);
+    }
+
+    ASSERT_EQ(10000u, map.size());
+    for (int i = 1; i < 10000; i += 2) {
+        ASSERT_EQ(std::to_string(i), map.at(i));
+    }
+    for (int i = 20000; i < 25000; ++i) {
+        ASSERT_EQ(std::to_string(i), map.at(i));
+    }
+}
+
+TEST(BumpArenaTest, Alignment) {
+    bump_arena_t arena;
+    for (size_t i = 1; i < 2000; ++i) {
+        const size_t alignment = 1 << (i % 5);
+        void *ptr = arena.allocate(i, alignment);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % alignment);
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,96 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <inttypes.h>
+
+#include "clustering/administration/main/cache_size.hpp"
+#include "unittest/gtest.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+TEST(CacheSize, ParseCgroupMemoryValue) {
+    uint64_t value;
+    ASSERT_TRUE(parse_cgroup_memory_value("536870912\n", &value));
+    EXPECT_EQ(536870912u, value);
+    EXPECT_FALSE(parse_cgroup_memory_value("max\n", &value));
+    EXPECT_FALSE(parse_cgroup_memory_value("", &value));
+}
+
+TEST(CacheSize, ParseMemoryPressure) {
+    double percent;
+    ASSERT_TRUE(parse_memory_pressure(
+        "some avg10=12.50 avg60=3.00 avg300=1.00 total=123456\n"
+        "full avg10=2.00 avg60=1.00 avg300=0.50 total=23456\n", &percent));
+    EXPECT_EQ(12.5, percent);
+    EXPECT_FALSE(parse_memory_pressure("full avg10=2.00\n", &percent));
+    EXPECT_FALSE(parse_memory_pressure("some avg10=x\n", &percent));
+}
+
+TEST(CacheSize, CgroupWorkingSet) {
+    const std::string v1_stat =
+        "cache 600\nrss 300\nactive_file 200\ninactive_file 400\n"
+        "total_inactive_file 500\n";
+    const std::string v2_stat =
+        "anon 300\nfile 600\nfile_mapped 50\nfile_dirty 10\n";
+    uint64_t value;
+    ASSERT_TRUE(parse_cgroup_memory_stat(v2_stat, "file", &value));
+    EXPECT_EQ(600u, value);
+    EXPECT_FALSE(parse_cgroup_memory_stat(v2_stat, "inactive_file", &value));
+
+    EXPECT_EQ(600u, cgroup_working_set(1000, v1_stat, false));
+    EXPECT_EQ(400u, cgroup_working_set(1000, v2_stat, true));
+    // The counters aren't read atomically, so the file cache can exceed the usage.
+    EXPECT_EQ(0u, cgroup_working_set(500, v2_stat, true));
+    // Without the statistics we have to count everything.
+    EXPECT_EQ(1000u, cgroup_working_set(1000, "", true));
+}
+
+TEST(CacheSize, CgroupAvailableMemory) {
+    cgroup_memory_t cgroup;
+    cgroup.limit = 4 * GIGABYTE;
+    cgroup.usage = GIGABYTE;
+    EXPECT_EQ(static_cast<uint64_t>(3 * GIGABYTE),
+              cgroup_available_memory(8 * GIGABYTE, cgroup));
+    EXPECT_EQ(static_cast<uint64_t>(2 * GIGABYTE),
+              cgroup_available_memory(2 * GIGABYTE, cgroup));
+    EXPECT_FALSE(cgroup_memory_is_low(cgroup));
+
+    // A working set over the limit leaves nothing.
+    cgroup.usage = 5 * GIGABYTE;
+    EXPECT_EQ(0u, cgroup_available_memory(8 * GIGABYTE, cgroup));
+    EXPECT_TRUE(cgroup_memory_is_low(cgroup));
+
+    // A cgroup that is full of reclaimable file cache isn't low on memory.
+    const uint64_t usage = 4 * GIGABYTE - MEGABYTE;
+    cgroup.usage = usage;
+    EXPECT_TRUE(cgroup_memory_is_low(cgroup));
+    const uint64_t file_cache = usage - GIGABYTE;
+    cgroup.usage =
+        cgroup_working_set(usage, strprintf("file %" PRIu64 "\n", file_cache), true);
+    EXPECT_FALSE(cgroup_memory_is_low(cgroup));
+    EXPECT_EQ(static_cast<uint64_t>(3 * GIGABYTE),
+              cgroup_available_memory(8 * GIGABYTE, cgroup));
+}
+
+TEST(CacheSize, NextAutomaticCacheSize) {
+    const uint64_t mb = MEGABYTE;
+    const uint64_t target = 800 * mb;
+    // Shrinks by a quarter under pressure, but not below the floor.
+    EXPECT_EQ(600 * mb, next_automatic_cache_size(target, target, true));
+    EXPECT_EQ(get_min_default_total_cache_size(),
+              next_automatic_cache_size(120 * mb, target, true));
+    // Grows back by an eighth of the target.
+    EXPECT_EQ(700 * mb, next_automatic_cache_size(600 * mb, target, false));
+    EXPECT_EQ(target, next_automatic_cache_size(750 * mb, target, false));
+    // Follows a smaller target at once.
+    EXPECT_EQ(400 * mb, next_automatic_cache_size(target, 400 * mb, false));
+    EXPECT_EQ(400 * mb, next_automatic_cache_size(target, 400 * mb, true));
+}
+
+TEST(CacheSize, DefaultForLimit) {
+    EXPECT_EQ(get_min_default_total_cache_size(),
+              get_default_total_cache_size_for_limit(512 * MEGABYTE));
+    EXPECT_EQ(static_cast<uint64_t>(GIGABYTE / 2),
+              get_default_total_cache_size_for_limit(2 * GIGABYTE));
+}
+
+}  // namespace unittest
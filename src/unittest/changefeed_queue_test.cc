@@ -0,0 +1,117 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+
+#include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
+#include "containers/uuid.hpp"
+#include "rdb_protocol/changefeed_queue.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+using ql::changefeed::change_val_t;
+using ql::changefeed::indexed_datum_t;
+using ql::changefeed::spilling_queue_t;
+
+// The queue keeps half of this in memory before it spills.
+const size_t SPILL_TEST_MEMORY_LIMIT = 20;
+// A change takes up about this much space on disk.
+const size_t SPILL_TEST_CHANGE_SIZE = 10 * KILOBYTE;
+
+// A change that sets the value of the row `i` to `i`, with a large string so that
+// the queue spills soon.
+static change_val_t change(const uuid_u &shard, uint64_t i) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", ql::datum_t(static_cast<double>(i)));
+    builder.overwrite(
+        "padding",
+        ql::datum_t(datum_string_t(std::string(SPILL_TEST_CHANGE_SIZE, 'x'))));
+    return change_val_t(
+        std::make_pair(shard, i),
+        store_key_t(strprintf("%" PRIu64, i)),
+        r_nullopt,
+        make_optional(indexed_datum_t(std::move(builder).to_datum(), r_nullopt))
+        DEBUG_ONLY(, r_nullopt));
+}
+
+static uint64_t change_id(const change_val_t &cv) {
+    return static_cast<uint64_t>(cv.new_val->val.get_field("id").as_num());
+}
+
+// Waits for the queue to move the changes that don't fit in memory to disk.
+static void wait_for_spill(spilling_queue_t *queue) {
+    while (queue->memory_size() > SPILL_TEST_MEMORY_LIMIT / 2) {
+        nap(1);
+    }
+}
+
+TPTEST(ChangefeedQueue, SpillsInOrder) {
+    temp_directory_t temp_dir;
+    recreate_temporary_directory(temp_dir.path());
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    uuid_u shard = generate_uuid();
+    spilling_queue_t queue(&io_backender, temp_dir.path(), SPILL_TEST_MEMORY_LIMIT,
+                           GIGABYTE);
+
+    const uint64_t num_changes = 500;
+    for (uint64_t i = 0; i < num_changes; ++i) {
+        queue.add(change(shard, i));
+    }
+    ASSERT_EQ(num_changes, queue.size());
+    wait_for_spill(&queue);
+    ASSERT_EQ(num_changes, queue.size());
+    EXPECT_FALSE(queue.over_disk_limit());
+
+    // Changes that arrive while we read come after the ones on disk.
+    for (uint64_t i = 0; i < num_changes; ++i) {
+        ASSERT_EQ(i, change_id(queue.peek()));
+        ASSERT_EQ(i, change_id(queue.pop()));
+        if (i % 10 == 0) {
+            queue.add(change(shard, num_changes + i / 10));
+        }
+    }
+    for (uint64_t i = num_changes; queue.size() != 0; ++i) {
+        ASSERT_EQ(i, change_id(queue.pop()));
+    }
+    EXPECT_EQ(0u, queue.memory_size());
+}
+
+TPTEST(ChangefeedQueue, ClearFreesDisk) {
+    temp_directory_t temp_dir;
+    recreate_temporary_directory(temp_dir.path());
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    uuid_u shard = generate_uuid();
+    spilling_queue_t queue(&io_backender, temp_dir.path(), SPILL_TEST_MEMORY_LIMIT,
+                           MEGABYTE);
+
+    // More than `MEGABYTE`, so the disk queue writes them out.
+    uint64_t next = 0;
+    while (!queue.over_disk_limit()) {
+        for (int i = 0; i < 100; ++i) {
+            queue.add(change(shard, next++));
+        }
+        wait_for_spill(&queue);
+    }
+
+    queue.clear();
+    EXPECT_EQ(0u, queue.size());
+    // The changes on disk are deleted in the background, so they don't count while
+    // that happens.
+    EXPECT_FALSE(queue.over_disk_limit());
+    let_stuff_happen();
+    EXPECT_FALSE(queue.over_disk_limit());
+
+    // Only the changes after `clear()` come out.
+    const uint64_t first_kept = next;
+    for (int i = 0; i < 50; ++i) {
+        queue.add(change(shard, next++));
+    }
+    ASSERT_EQ(next - first_kept, queue.size());
+    for (uint64_t i = first_kept; i < next; ++i) {
+        ASSERT_EQ(i, change_id(queue.pop()));
+    }
+    EXPECT_EQ(0u, queue.size());
+}
+
+}  // namespace unittest
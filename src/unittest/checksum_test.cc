@@ -0,0 +1,218 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <inttypes.h>
+
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "random.hpp"
+#include "serializer/checksum.hpp"
+#include "unittest/gtest.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+const checksum_impl_t all_checksum_impls[] = {
+    checksum_impl_t::scalar,
+    checksum_impl_t::sse41,
+    checksum_impl_t::avx2,
+    checksum_impl_t::neon
+};
+
+const char *checksum_impl_name(checksum_impl_t impl) {
+    switch (impl) {
+    case checksum_impl_t::scalar: return "scalar";
+    case checksum_impl_t::sse41: return "sse4.1";
+    case checksum_impl_t::avx2: return "avx2";
+    case checksum_impl_t::neon: return "neon";
+    default: unreachable();
+    }
+}
+
+std::vector<uint32_t> random_words(rng_t *rng, size_t wordcount) {
+    std::vector<uint32_t> words(wordcount);
+    for (size_t i = 0; i < wordcount; ++i) {
+        words[i] = static_cast<uint32_t>(rng->randint(1 << 16))
+            | (static_cast<uint32_t>(rng->randint(1 << 16)) << 16);
+    }
+    return words;
+}
+
+void check_all_impls(const uint32_t *words, size_t wordcount) {
+    const serializer_checksum expected =
+        compute_checksum_with_impl(checksum_impl_t::scalar, words, wordcount);
+    EXPECT_TRUE(has_checksum(expected));
+    EXPECT_EQ(expected.value, compute_checksum(words, wordcount).value);
+    for (checksum_impl_t impl : all_checksum_impls) {
+        if (!checksum_impl_supported(impl)) {
+            continue;
+        }
+        SCOPED_TRACE(checksum_impl_name(impl));
+        EXPECT_EQ(expected.value,
+                  compute_checksum_with_impl(impl, words, wordcount).value);
+    }
+}
+
+TEST(ChecksumTest, ImplsAgree) {
+    rng_t rng(12345);
+    // Sizes around the vector widths, typical block sizes, and sizes that span more
+    // than one accumulation chunk in the vectorized implementations.
+    const size_t sizes[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 1023, 1024,
+                             1025, 4096, 8191, 8192, 16384, 16385, 65535, 65536,
+                             65537, 200000 };
+    for (size_t wordcount : sizes) {
+        SCOPED_TRACE(strprintf("wordcount = %zu", wordcount));
+        std::vector<uint32_t> words = random_words(&rng, wordcount + 1);
+        check_all_impls(words.data(), wordcount);
+        // The serializer's buffers are aligned, but nothing requires that.
+        check_all_impls(words.data() + 1, wordcount);
+    }
+}
+
+TEST(ChecksumTest, ImplsAgreeOnExtremeWords) {
+    // All-ones words turn into 0xFFFFFFFE after xoring, which maximizes the sums; zero
+    // words turn into 1.  Both must come out the same in every implementation.
+    for (uint32_t fill : { 0u, 1u, 0xFFFFFFFFu, 0xFFFFFFFEu }) {
+        SCOPED_TRACE(strprintf("fill = %" PRIu32, fill));
+        std::vector<uint32_t> words(70000, fill);
+        for (size_t wordcount : { 1024, 16384, 70000 }) {
+            check_all_impls(words.data(), wordcount);
+        }
+    }
+}
+
+TEST(ChecksumTest, Concat) {
+    rng_t rng(54321);
+    const size_t splits[] = { 0, 1, 7, 512, 1000, 1024 };
+    std::vector<uint32_t> words = random_words(&rng, 1024);
+    const serializer_checksum whole = compute_checksum(words.data(), words.size());
+    for (size_t split : splits) {
+        SCOPED_TRACE(strprintf("split = %zu", split));
+        for (checksum_impl_t impl : all_checksum_impls) {
+            if (!checksum_impl_supported(impl)) {
+                continue;
+            }
+            SCOPED_TRACE(checksum_impl_name(impl));
+            serializer_checksum left =
+                compute_checksum_with_impl(impl, words.data(), split);
+            serializer_checksum right =
+                compute_checksum_with_impl(impl, words.data() + split,
+                                           words.size() - split);
+            EXPECT_EQ(whole.value,
+                      compute_checksum_concat(left, right,
+                                              words.size() - split).value);
+        }
+    }
+    EXPECT_EQ(whole.value,
+              compute_checksum_concat(identity_checksum(), whole, words.size()).value);
+}
+
+TEST(ChecksumTest, Crc32c) {
+    // The check value from the CRC catalogue.
+    EXPECT_EQ(0xE3069283u, crc32c_software("123456789", 9));
+    EXPECT_EQ(0u, crc32c_software("", 0));
+
+    rng_t rng(777);
+    std::vector<uint32_t> words = random_words(&rng, 4097);
+    const char *bytes = reinterpret_cast<const char *>(words.data());
+    const size_t size = 4096 * serializer_checksum::word_size;
+    const uint32_t whole = crc32c_software(bytes, size);
+    if (crc32c_hardware_supported()) {
+        EXPECT_EQ(whole, crc32c_hardware(bytes, size));
+        // Unaligned, and with leftover bytes.
+        EXPECT_EQ(crc32c_software(bytes + 3, size - 2),
+                  crc32c_hardware(bytes + 3, size - 2));
+    }
+    for (size_t split : { 0, 1, 7, 512, 4095, 16384 }) {
+        SCOPED_TRACE(strprintf("split = %zu", split));
+        EXPECT_EQ(whole,
+                  crc32c_combine(crc32c_software(bytes, split),
+                                 crc32c_software(bytes + split, size - split),
+                                 size - split));
+    }
+}
+
+TEST(ChecksumTest, Crc32cConcat) {
+    rng_t rng(4321);
+    std::vector<uint32_t> words = random_words(&rng, 1024);
+    const serializer_checksum whole =
+        compute_checksum(checksum_algorithm_t::crc32c, words.data(), words.size());
+    EXPECT_TRUE(has_checksum(whole));
+    EXPECT_FALSE(is_datasync_checksum(whole));
+    for (size_t split : { 0, 1, 7, 512, 1000, 1024 }) {
+        SCOPED_TRACE(strprintf("split = %zu", split));
+        serializer_checksum left =
+            compute_checksum(checksum_algorithm_t::crc32c, words.data(), split);
+        serializer_checksum right =
+            compute_checksum(checksum_algorithm_t::crc32c, words.data() + split,
+                             words.size() - split);
+        EXPECT_EQ(whole.value,
+                  compute_checksum_concat(checksum_algorithm_t::crc32c, left, right,
+                                          words.size() - split).value);
+    }
+    EXPECT_EQ(whole.value,
+              compute_checksum_concat(checksum_algorithm_t::crc32c,
+                                      identity_checksum(checksum_algorithm_t::crc32c),
+                                      whole, words.size()).value);
+
+    // The Fletcher-64 variants are the same as the old functions.
+    EXPECT_EQ(compute_checksum(words.data(), words.size()).value,
+              compute_checksum(checksum_algorithm_t::fletcher64,
+                               words.data(), words.size()).value);
+}
+
+// This is not really a unit test, but a micro benchmark that compares the
+// implementations on 4KB blocks, and on the concatenation of checksums that the
+// metablock manager does.  No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(ChecksumTest, Benchmark) {
+    const size_t NUM_REPETITIONS = 200000;
+    const size_t BLOCK_WORDS = 4096 / serializer_checksum::word_size;
+    rng_t rng(1);
+    std::vector<uint32_t> words = random_words(&rng, BLOCK_WORDS);
+
+    for (checksum_impl_t impl : all_checksum_impls) {
+        if (!checksum_impl_supported(impl)) {
+            continue;
+        }
+        uint64_t dummy = 0;
+        ticks_t start_ticks = get_ticks();
+        for (size_t i = 0; i < NUM_REPETITIONS; ++i) {
+            words[i % BLOCK_WORDS] = i;
+            dummy += compute_checksum_with_impl(impl, words.data(), BLOCK_WORDS).value;
+        }
+        double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+        printf("%s: %.1f MB/s (%" PRIu64 ")\n",
+               checksum_impl_name(impl),
+               NUM_REPETITIONS * BLOCK_WORDS * serializer_checksum::word_size
+                   / secs / MEGABYTE,
+               dummy & 1);
+    }
+
+    if (crc32c_hardware_supported()) {
+        uint64_t dummy = 0;
+        ticks_t start_ticks = get_ticks();
+        for (size_t i = 0; i < NUM_REPETITIONS; ++i) {
+            words[i % BLOCK_WORDS] = i;
+            dummy += compute_checksum(checksum_algorithm_t::crc32c,
+                                      words.data(), BLOCK_WORDS).value;
+        }
+        double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+        printf("crc32c: %.1f MB/s (%" PRIu64 ")\n",
+               NUM_REPETITIONS * BLOCK_WORDS * serializer_checksum::word_size
+                   / secs / MEGABYTE,
+               dummy & 1);
+    }
+
+    serializer_checksum sum = identity_checksum();
+    const serializer_checksum block_sum = compute_checksum(words.data(), BLOCK_WORDS);
+    ticks_t start_ticks = get_ticks();
+    for (size_t i = 0; i < NUM_REPETITIONS; ++i) {
+        sum = compute_checksum_concat(sum, block_sum, BLOCK_WORDS);
+    }
+    double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+    printf("compute_checksum_concat: %.1f million/s (%" PRIu64 ")\n",
+           NUM_REPETITIONS / secs / MILLION, sum.value & 1);
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
@@ -7,6 +7,7 @@
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/administration/tables/split_points.hpp"
 #include "clustering/table_contract/contract_metadata.hpp"
+#include "containers/archive/string_stream.hpp"
 #include "unittest/clustering_utils_raft.hpp"
 #include "unittest/unittest_utils.hpp"
 
@@ -26,6 +27,7 @@ table_config_and_shards_t make_table_config_and_shards() {
     table_config_and_shards.config.write_ack_config = write_ack_config_t::MAJORITY;
     table_config_and_shards.config.durability = write_durability_t::HARD;
     table_config_and_shards.config.user_data = default_user_data();
+    table_config_and_shards.config.block_size = DEFAULT_BTREE_BLOCK_SIZE;
     table_config_and_shards.server_names.names[shard.primary_replica] =
         std::make_pair(0ul, name_string_t::guarantee_valid("primary"));
 
@@ -380,5 +382,49 @@ TPTEST(ClusteringRaft, StorageWriteSnapshot) {
         raft_persistent_state);
 }
 
+template <class T>
+std::string serialize_latest_disk(const T &value) {
+    string_stream_t stream;
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, value);
+    guarantee(send_write_message(&stream, &wm) == 0);
+    return stream.str();
+}
+
+// Tables written by v2.5 have no `block_size`.  They must read back with the default,
+// and everything else must come through unchanged.
+TEST(ClusteringRaft, TableConfigV2_5DefaultsBlockSize) {
+    table_config_and_shards_t config = make_table_config_and_shards();
+    config.config.block_size = 4 * DEFAULT_BTREE_BLOCK_SIZE;
+
+    std::string latest = serialize_latest_disk(config);
+
+    {
+        string_read_stream_t read_stream(std::string(latest), 0);
+        table_config_and_shards_t out;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::LATEST_DISK>(&read_stream, &out));
+        EXPECT_EQ(config, out);
+    }
+
+    // `block_size` is the last field of the `table_config_t`, and the v2.5 format is
+    // the same except that it doesn't have it.
+    size_t tail_size = serialize_latest_disk(config.shard_scheme).size()
+        + serialize_latest_disk(config.server_names).size();
+    size_t block_size_end = latest.size() - tail_size;
+    std::string v2_5 = latest.substr(0, block_size_end - sizeof(uint32_t))
+        + latest.substr(block_size_end);
+
+    string_read_stream_t read_stream(std::move(v2_5), 0);
+    table_config_and_shards_t out;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::v2_5>(&read_stream, &out));
+    char extra;
+    EXPECT_EQ(0, read_stream.read(&extra, 1));
+    EXPECT_EQ(static_cast<uint32_t>(DEFAULT_BTREE_BLOCK_SIZE), out.config.block_size);
+    out.config.block_size = config.config.block_size;
+    EXPECT_EQ(config, out);
+}
+
 }   /* namespace unittest */
 
@@ -0,0 +1,164 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/cond_var.hpp"
+#include "rapidjson/document.h"
+#include "rdb_protocol/compiled_func.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/sym.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+ql::datum_t parse_row(const std::string &json) {
+    rapidjson::Document document;
+    document.Parse(json.c_str());
+    guarantee(!document.HasParseError());
+    return ql::to_datum(document, ql::configured_limits_t::unlimited,
+                        reql_version_t::LATEST);
+}
+
+// A function that always goes through the interpreter, to compare against.
+counted_t<const ql::func_t> interpreted_func(const ql::raw_term_t &body,
+                                             const std::vector<ql::sym_t> &args) {
+    ql::compile_env_t env(ql::var_visibility_t().with_func_arg_name_list(args));
+    return make_counted<ql::reql_func_t>(ql::var_scope_t(), args,
+                                         ql::compile_term(&env, body),
+                                         counted_t<const ql::compiled_func_t>());
+}
+
+TPTEST(CompiledFuncTest, FilterMatchesInterpreter) {
+    const ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    const std::vector<ql::raw_term_t> bodies = {
+        ((r.var(x)["a"] > 5.0) && (r.var(x)["b"] == std::string("x"))).root_term(),
+        (!(r.var(x)["a"] <= r.var(x)["c"]["d"])).root_term(),
+        r.var(x)["c"].root_term(),
+        (r.var(x)["a"] >= 2.0).call(Term::OR, r.var(x).bracket("b")).root_term(),
+        r.var(x)["a"].call(Term::NE, 1.0, 2.0).root_term()
+    };
+    const std::vector<ql::datum_t> rows = {
+        parse_row("{\"a\": 6, \"b\": \"x\", \"c\": {\"d\": 8}}"),
+        parse_row("{\"a\": 6, \"b\": \"y\", \"c\": {\"d\": 1}}"),
+        parse_row("{\"a\": 1, \"b\": false, \"c\": null}"),
+        parse_row("{\"a\": 2}"),
+        parse_row("{\"b\": \"x\"}"),
+        parse_row("[1, 2]"),
+        parse_row("{\"a\": 7, \"b\": \"x\", \"c\": {\"$reql_type$\": \"TIME\", "
+                  "\"epoch_time\": 0, \"timezone\": \"+00:00\"}}"),
+    };
+
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    for (const ql::raw_term_t &body : bodies) {
+        counted_t<const ql::func_t> f = interpreted_func(body, make_vector(x));
+        counted_t<const ql::compiled_func_t> compiled =
+            ql::compiled_func_t::get_filter(
+                ql::map_wire_func_t(body, make_vector(x)).compile_wire_func().get());
+        ASSERT_TRUE(compiled.has());
+
+        std::vector<ql::compiled_func_t::filter_result_t> results;
+        compiled->filter_batch(rows, &results);
+        ASSERT_EQ(rows.size(), results.size());
+        size_t num_known = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            bool interpreted;
+            try {
+                interpreted =
+                    f->filter_call(&env, rows[i], counted_t<const ql::func_t>());
+            } catch (const ql::base_exc_t &) {
+                // Only the interpreter is supposed to throw.
+                ASSERT_EQ(ql::compiled_func_t::filter_result_t::UNKNOWN, results[i]);
+                continue;
+            }
+            if (results[i] != ql::compiled_func_t::filter_result_t::UNKNOWN) {
+                ++num_known;
+                ASSERT_EQ(interpreted,
+                          results[i] == ql::compiled_func_t::filter_result_t::MATCH);
+            }
+        }
+        // The rows that have the fields shouldn't need the interpreter.
+        ASSERT_GE(num_known, 2u);
+    }
+}
+
+TPTEST(CompiledFuncTest, CallMatchesInterpreter) {
+    const ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    const std::vector<ql::raw_term_t> bodies = {
+        (r.var(x)["a"] + r.var(x)["c"]["d"]).root_term(),
+        r.var(x)["a"].call(Term::MUL, 2.0).call(Term::SUB, 1.0, 0.5).root_term(),
+        (r.var(x)["c"]["d"] / r.var(x)["a"]).root_term(),
+        ((r.var(x)["a"] + 1.0) > 5.0).root_term(),
+        r.var(x)["b"].root_term()
+    };
+    const std::vector<ql::datum_t> rows = {
+        parse_row("{\"a\": 6, \"b\": \"x\", \"c\": {\"d\": 8}}"),
+        parse_row("{\"a\": 0, \"b\": [1], \"c\": {\"d\": 1}}"),
+        parse_row("{\"a\": 1e308, \"b\": null, \"c\": {\"d\": 1e308}}"),
+        parse_row("{\"a\": \"6\", \"b\": \"x\", \"c\": {\"d\": \"8\"}}"),
+        parse_row("{\"b\": \"x\"}"),
+    };
+
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    for (const ql::raw_term_t &body : bodies) {
+        counted_t<const ql::func_t> f = interpreted_func(body, make_vector(x));
+        counted_t<const ql::compiled_func_t> compiled =
+            ql::compiled_func_t::compile(make_vector(x), body);
+        ASSERT_TRUE(compiled.has());
+        size_t num_known = 0;
+        for (const ql::datum_t &row : rows) {
+            ql::datum_t res;
+            const bool known = compiled->call(row, &res);
+            ql::datum_t interpreted;
+            try {
+                interpreted = f->call(&env, row)->as_datum();
+            } catch (const ql::base_exc_t &) {
+                ASSERT_FALSE(known);
+                continue;
+            }
+            if (known) {
+                ++num_known;
+                ASSERT_EQ(interpreted, res);
+            }
+        }
+        ASSERT_GE(num_known, 1u);
+    }
+}
+
+TPTEST(CompiledFuncTest, FallsBack) {
+    const ql::sym_t x(1);
+    const ql::sym_t y(2);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    const std::vector<ql::raw_term_t> bodies = {
+        // Field names that aren't constants, and `nth`, aren't compiled.
+        (r.var(x)[r.var(x)["name"]] == 1.0).root_term(),
+        (r.var(x).bracket(0.0) == 1.0).root_term(),
+        r.object(r.optarg("a", 1.0)).root_term(),
+        // Neither are variables from an enclosing scope.
+        (r.var(x)["a"] + r.var(y)).root_term()
+    };
+    for (const ql::raw_term_t &body : bodies) {
+        ASSERT_FALSE(ql::compiled_func_t::compile(make_vector(x), body).has());
+    }
+
+    // Constants compile, but `filter` matches objects in them against the row.
+    const ql::raw_term_t constant = r.expr(ql::datum_t::boolean(true)).root_term();
+    ASSERT_TRUE(ql::compiled_func_t::compile(make_vector(x), constant).has());
+    ASSERT_FALSE(ql::compiled_func_t::get_filter(
+        ql::map_wire_func_t(constant, make_vector(x)).compile_wire_func().get()).has());
+
+    // Functions of two arguments aren't compiled.
+    ASSERT_FALSE(ql::compiled_func_t::compile(
+        make_vector(x, y), (r.var(x) == r.var(y)).root_term()).has());
+}
+
+}  // namespace unittest
@@ -0,0 +1,84 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include "buffer_cache/compressed_page_pool.hpp"
+#include "random.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static buf_ptr_t make_block(bool compressible, rng_t *rng) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(4000));
+    char *data = static_cast<char *>(buf.cache_data());
+    for (uint32_t j = 0; j < buf.block_size().value(); ++j) {
+        data[j] = compressible ? "{\"id\": 1234}"[j % 12] : rng->randint(256);
+    }
+    return buf;
+}
+
+// The pool doesn't look at the tokens, so these tests get by without a serializer.
+static void add_block(alt::compressed_page_pool_t *pool, block_id_t block_id,
+                      const buf_ptr_t &block) {
+    pool->add(block_id, counted_t<block_token_t>(), block.ser_buffer(),
+              block.block_size());
+}
+
+static bool take_block(alt::compressed_page_pool_t *pool, block_id_t block_id) {
+    counted_t<block_token_t> token;
+    return pool->take(block_id, &token).has();
+}
+
+TPTEST(CompressedPagePoolTest, TakeGivesBackTheBlock) {
+    rng_t rng(1234);
+    alt::compressed_page_pool_t pool;
+    pool.set_capacity(MEGABYTE);
+
+    buf_ptr_t block = make_block(true, &rng);
+    add_block(&pool, 1, block);
+    // Random data doesn't compress, so it isn't worth keeping.
+    add_block(&pool, 2, make_block(false, &rng));
+    EXPECT_EQ(1u, pool.entry_count());
+    EXPECT_LT(pool.size(), block.aligned_block_size());
+
+    EXPECT_FALSE(take_block(&pool, 2));
+    counted_t<block_token_t> token;
+    buf_ptr_t taken = pool.take(1, &token);
+    ASSERT_TRUE(taken.has());
+    ASSERT_EQ(block.block_size().ser_value(), taken.block_size().ser_value());
+    EXPECT_EQ(0, memcmp(block.cache_data(), taken.cache_data(),
+                        block.block_size().value()));
+    // Taking the copy removes it.
+    EXPECT_FALSE(take_block(&pool, 1));
+    EXPECT_EQ(0u, pool.size());
+}
+
+TPTEST(CompressedPagePoolTest, OldestCopiesGetDropped) {
+    rng_t rng(1234);
+    alt::compressed_page_pool_t pool;
+    pool.set_capacity(MEGABYTE);
+
+    buf_ptr_t block = make_block(true, &rng);
+    add_block(&pool, 0, block);
+    const uint64_t copy_size = pool.size();
+    pool.set_capacity(3 * copy_size);
+    for (block_id_t i = 1; i < 4; ++i) {
+        add_block(&pool, i, block);
+    }
+    EXPECT_EQ(3u, pool.entry_count());
+    EXPECT_FALSE(take_block(&pool, 0));
+
+    // A newer copy of a block replaces the old one.
+    add_block(&pool, 1, block);
+    EXPECT_EQ(3u, pool.entry_count());
+    pool.remove(2);
+    EXPECT_EQ(2 * copy_size, pool.size());
+
+    // A capacity of zero drops everything and keeps nothing new.
+    pool.set_capacity(0);
+    EXPECT_EQ(0u, pool.entry_count());
+    add_block(&pool, 0, block);
+    EXPECT_EQ(0u, pool.size());
+}
+
+}  // namespace unittest
@@ -0,0 +1,49 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+
+#include "arch/runtime/coro_sampler.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/mutex.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(CoroSamplerTest, RecordsWaitReasons, 2) {
+    coro_sampler_t *sampler = &coro_sampler_t::get_global_sampler();
+    sampler->start(1);
+    EXPECT_TRUE(coro_sampler_t::is_running());
+
+    coro_t::yield();
+    {
+        on_thread_t thread_switcher(threadnum_t(1));
+    }
+    mutex_t mutex;
+    cond_t done;
+    {
+        mutex_t::acq_t acq(&mutex);
+        coro_t::spawn_sometime([&]() {
+            mutex_t::acq_t other_acq(&mutex);
+            done.pulse();
+        });
+        coro_t::yield();
+    }
+    done.wait_lazily_unordered();
+
+    sampler->stop();
+    EXPECT_FALSE(coro_sampler_t::is_running());
+
+    const std::string stacks = sampler->get_folded_stacks();
+    EXPECT_NE(std::string::npos, stacks.find(";yield "));
+    EXPECT_NE(std::string::npos, stacks.find(";cross_thread "));
+    EXPECT_NE(std::string::npos, stacks.find(";mutex "));
+
+    // Starting again drops the old samples.
+    sampler->start(1);
+    sampler->stop();
+    EXPECT_EQ("", sampler->get_folded_stacks());
+}
+
+}  // namespace unittest
@@ -2,7 +2,12 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
 #include "config/args.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -83,6 +88,78 @@ TEST(CoroutinesTest, OnThreadOrdering) {
     }, num_threads);
 }
 
+TEST(CoroutinesTest, ManyThreadsToOneThreadOrdering) {
+    // Tests that messages from many threads that all go to the same thread at the same
+    // time arrive in the order in which each of the threads sent them.
+    const int64_t num_threads = 16;
+    const int coros_per_thread = 200;
+    run_in_thread_pool([&]() {
+        std::vector<int> arrived(num_threads, 0);
+        pmap(static_cast<int64_t>(1), num_threads, [&](int64_t source) {
+            on_thread_t source_thread((threadnum_t(source)));
+            auto_drainer_t drainer;
+            for (int i = 0; i < coros_per_thread; ++i) {
+                auto_drainer_t::lock_t lock(&drainer);
+                coro_t::spawn_later_ordered([&arrived, source, i, lock]() {
+                    on_thread_t target_thread((threadnum_t(0)));
+                    ASSERT_EQ(i, arrived[source]);
+                    ++arrived[source];
+                });
+            }
+            drainer.drain();
+        });
+        for (int64_t source = 1; source < num_threads; ++source) {
+            ASSERT_EQ(coros_per_thread, arrived[source]);
+        }
+    }, num_threads);
+}
+
+TEST(CoroutinesTest, CrossThreadSignal) {
+    const int num_threads = 4;
+    run_in_thread_pool([&]() {
+        for (int i = 0; i < 100; ++i) {
+            // This includes the case where the destination is the same thread.
+            pmap(num_threads, [&](int dest) {
+                cond_t source;
+                cross_thread_signal_t signal(&source, threadnum_t(dest));
+                source.pulse();
+                on_thread_t thread_switcher((threadnum_t(dest)));
+                signal.wait();
+            });
+        }
+        // The destructor waits for a pulse that is still on its way.
+        for (int i = 0; i < 100; ++i) {
+            cond_t source;
+            threadnum_t dest(1 + i % (num_threads - 1));
+            cross_thread_signal_t signal(&source, dest);
+            source.pulse();
+        }
+        {
+            cond_t source;
+            cross_thread_signal_t signal(&source, threadnum_t(1));
+        }
+    }, num_threads);
+}
+
+TEST(CoroutinesTest, BusyPolling) {
+    // The threads busy poll for 1ms, so the naps let them fall asleep in between, and
+    // messages have to get through both while they poll and while they sleep.
+    const int num_threads = 4;
+    ::run_in_thread_pool([&]() {
+        for (int i = 0; i < 20; ++i) {
+            pmap(num_threads, [&](int first) {
+                for (int hop = 0; hop < 100; ++hop) {
+                    on_thread_t thread_switcher(
+                        threadnum_t((first + hop) % num_threads));
+                }
+            });
+            if (i % 2 == 0) {
+                nap(5);
+            }
+        }
+    }, num_threads, false, 1000000);
+}
+
 TEST(CoroutinesTest, NotifyNow) {
     // Test that `spawn_now_dangerously` doesn't block`
     run_in_thread_pool([&]() {
@@ -106,6 +183,36 @@ TEST(CoroutinesTest, NotifyNow) {
     });
 }
 
+// Fibers and threaded coroutines don't get stacks of exactly the requested size.
+#if !defined(_WIN32) && !defined(THREADED_COROUTINES)
+TEST(CoroutinesTest, ShallowStacks) {
+    run_in_thread_pool([&]() {
+        cond_t done;
+        coro_t::spawn_sometime([&]() {
+            EXPECT_EQ(coro_stack_class_t::shallow, coro_t::self()->get_stack_class());
+            EXPECT_TRUE(has_n_bytes_free_stack_space(COROUTINE_SHALLOW_STACK_SIZE / 2));
+            EXPECT_FALSE(has_n_bytes_free_stack_space(COROUTINE_SHALLOW_STACK_SIZE));
+
+            // Code that needs more stack than that moves to a normal coroutine.
+            call_with_enough_stack([&]() {
+                EXPECT_EQ(coro_stack_class_t::normal,
+                          coro_t::self()->get_stack_class());
+            }, COROUTINE_SHALLOW_STACK_SIZE);
+            done.pulse();
+        }, coro_stack_class_t::shallow);
+        done.wait_lazily_unordered();
+
+        // Shallow coroutines come from their own pool.
+        cond_t normal_done;
+        coro_t::spawn_sometime([&]() {
+            EXPECT_EQ(coro_stack_class_t::normal, coro_t::self()->get_stack_class());
+            normal_done.pulse();
+        });
+        normal_done.wait_lazily_unordered();
+    });
+}
+#endif
+
 // The following test does not work on 32 bit architectures because it will exceed
 // their virtual memory.
 #if defined (__x86_64__) || defined (_WIN64)
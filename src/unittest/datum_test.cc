@@ -1,9 +1,18 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/string_stream.hpp"
+#include "rapidjson/document.h"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/pathspec.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -44,6 +53,31 @@ void test_datum_serialization(const ql::datum_t datum) {
         ASSERT_EQ(archive_result_t::SUCCESS, res);
         ASSERT_EQ(deserialized_datum, redeserialized_datum);
     }
+
+    // Deserialize from a shared buffer, which arrays and objects point into instead
+    // of copying from it. The byte after the datum must still be there to be read.
+    {
+        write_message_t wm;
+        serialize<cluster_version_t::LATEST_OVERALL>(&wm, datum);
+        serialize_universal(&wm, static_cast<uint8_t>(123));
+        string_stream_t write_stream;
+        int write_res = send_write_message(&write_stream, &wm);
+        ASSERT_EQ(0, write_res);
+
+        counted_t<shared_buf_t> buf = shared_buf_t::create(write_stream.str().size());
+        memcpy(buf->data(), write_stream.str().data(), write_stream.str().size());
+        shared_buf_read_stream_t read_stream(std::move(buf));
+        ql::datum_t shared_datum;
+        archive_result_t res
+            = deserialize<cluster_version_t::LATEST_OVERALL>(&read_stream,
+                                                             &shared_datum);
+        ASSERT_EQ(archive_result_t::SUCCESS, res);
+        ASSERT_EQ(datum, shared_datum);
+        uint8_t trailer;
+        res = deserialize_universal(&read_stream, &trailer);
+        ASSERT_EQ(archive_result_t::SUCCESS, res);
+        ASSERT_EQ(123, trailer);
+    }
 }
 
 
@@ -205,4 +239,285 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+TEST(DatumTest, CachedSerializedSize) {
+    ql::datum_t inner(
+        std::vector<ql::datum_t>{ql::datum_t(1.0), ql::datum_t("two")},
+        ql::configured_limits_t::unlimited);
+    ql::datum_object_builder_t builder;
+    builder.overwrite("inner", inner);
+    builder.overwrite("str", ql::datum_t(datum_string_t(std::string(300, 'A'))));
+    ql::datum_t outer = std::move(builder).to_datum();
+
+    ASSERT_EQ(0u, outer.get_cached_serialized_size());
+    const size_t size = ql::datum_serialized_size(
+        outer, ql::check_datum_serialization_errors_t::NO);
+    ASSERT_EQ(size, outer.get_cached_serialized_size());
+    ASSERT_EQ(size, ql::datum_serialized_size(
+                  outer, ql::check_datum_serialization_errors_t::NO));
+
+    // The cached sizes of the outer and the inner datum must agree with what
+    // actually gets serialized.
+    write_message_t wm;
+    ql::datum_serialize(&wm, outer, ql::check_datum_serialization_errors_t::NO);
+    ASSERT_EQ(size, wm.size());
+    write_message_t inner_wm;
+    ql::datum_serialize(&inner_wm, inner, ql::check_datum_serialization_errors_t::NO);
+    ASSERT_EQ(inner_wm.size(), ql::datum_serialized_size(
+                  inner, ql::check_datum_serialization_errors_t::NO));
+}
+
+TEST(DatumTest, GetField) {
+    ql::datum_object_builder_t builder;
+    for (int i = 0; i < 40; ++i) {
+        builder.overwrite(datum_string_t(strprintf("field%d", i)),
+                          ql::datum_t(static_cast<double>(i)));
+    }
+    ql::datum_t object = std::move(builder).to_datum();
+
+    // The same lookups on the in-memory object and on one backed by a buffer.
+    write_message_t wm;
+    ql::datum_serialize(&wm, object, ql::check_datum_serialization_errors_t::NO);
+    string_stream_t write_stream;
+    ASSERT_EQ(0, send_write_message(&write_stream, &wm));
+    string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+    ql::datum_t buf_object;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              ql::datum_deserialize(&read_stream, &buf_object));
+    ASSERT_TRUE(buf_object.get_buf_ref() != nullptr);
+
+    for (const ql::datum_t &d : {object, buf_object}) {
+        for (int i = 0; i < 40; ++i) {
+            ql::datum_t value = d.get_field(strprintf("field%d", i).c_str());
+            ASSERT_EQ(static_cast<double>(i), value.as_num());
+        }
+        ASSERT_FALSE(d.get_field("field", ql::NOTHROW).has());
+        ASSERT_FALSE(d.get_field("field99", ql::NOTHROW).has());
+        ASSERT_FALSE(d.get_field("zzz", ql::NOTHROW).has());
+        ASSERT_FALSE(d.get_field("", ql::NOTHROW).has());
+    }
+}
+
+TEST(DatumTest, JsonStrings) {
+    // Enough keys and values to fill several of the buffers that `to_datum()` uses
+    // for short strings, plus one string that's too long for them.
+    std::string json = "{";
+    for (int i = 0; i < 500; ++i) {
+        json += strprintf("\"key%d\": [\"value%d\", \"\"], ", i, i);
+    }
+    const std::string long_value(1000, 'x');
+    json += "\"long\": \"" + long_value + "\"}";
+
+    rapidjson::Document document;
+    document.Parse(json.c_str());
+    ASSERT_FALSE(document.HasParseError());
+    ql::datum_t object = ql::to_datum(document, ql::configured_limits_t::unlimited,
+                                      reql_version_t::LATEST);
+
+    ASSERT_EQ(501u, object.obj_size());
+    for (int i = 0; i < 500; ++i) {
+        ql::datum_t value = object.get_field(strprintf("key%d", i).c_str());
+        ASSERT_EQ(strprintf("value%d", i), value.get(0).as_str().to_std());
+        ASSERT_TRUE(value.get(1).as_str().empty());
+    }
+    ASSERT_EQ(long_value, object.get_field("long").as_str().to_std());
+}
+
+ql::datum_t parse_json_with_document(const std::string &json) {
+    rapidjson::Document document;
+    document.Parse(json.c_str());
+    guarantee(!document.HasParseError());
+    return ql::to_datum(document, ql::configured_limits_t::unlimited,
+                        reql_version_t::LATEST);
+}
+
+ql::datum_t parse_json_insitu(const std::string &json, std::string *error_out) {
+    std::vector<char> buf(json.c_str(), json.c_str() + json.size() + 1);
+    return ql::parse_json_insitu_to_datum(
+        buf.data(), ql::configured_limits_t::unlimited, error_out);
+}
+
+std::string big_json_array(size_t num_rows) {
+    std::string json = "[";
+    for (size_t i = 0; i < num_rows; ++i) {
+        json += strprintf("%s{\"id\": %zu, \"name\": \"row %zu\", \"score\": %zu.25, "
+                          "\"tags\": [\"a\", \"b\"], \"nested\": {\"x\": true}}",
+                          i == 0 ? "" : ", ", i, i, i);
+    }
+    return json + "]";
+}
+
+TEST(DatumTest, ParseJsonInsitu) {
+    const std::vector<std::string> documents = {
+        "null", "true", "-0.5", "1e300", "18446744073709551615", "\"caf\\u00e9\"",
+        "[]", "{}", "  [1, [2, [3, []]], {\"a\": {\"b\": [null]}}]  ",
+        "{\"z\": 1, \"a\": 2, \"m\": {\"y\": [], \"\": \"\"}}",
+        "{\"$reql_type$\": \"TIME\", \"epoch_time\": 0, \"timezone\": \"+00:00\"}",
+        big_json_array(100)
+    };
+    for (const std::string &json : documents) {
+        SCOPED_TRACE(json);
+        std::string error;
+        ql::datum_t parsed = parse_json_insitu(json, &error);
+        ASSERT_TRUE(parsed.has());
+        ASSERT_EQ(parse_json_with_document(json), parsed);
+    }
+
+    for (const char *json : {"", "[1,", "{\"a\" 1}", "[1] 2", "nul"}) {
+        SCOPED_TRACE(json);
+        std::string error;
+        ASSERT_FALSE(parse_json_insitu(json, &error).has());
+        ASSERT_FALSE(error.empty());
+    }
+
+    std::string error;
+    ASSERT_THROW(parse_json_insitu("{\"a\": 1, \"b\": 2, \"a\": 3}", &error),
+                 ql::base_exc_t);
+    ASSERT_THROW(parse_json_insitu("[\"\xff\"]", &error), ql::base_exc_t);
+}
+
+TEST(DatumTest, SortKeys) {
+    std::vector<ql::datum_t> data;
+    for (const char *json : {
+            "null", "false", "true", "-1e300", "-1.5", "-0.0", "0", "1e-300", "2",
+            "1e300", "\"\"", "\"a\"", "\"a\\u0000\"", "\"a\\u0001\"", "\"ab\"",
+            "\"b\"", "[]", "[null]", "[[]]", "[1]", "[1, 2]", "[1, \"a\"]", "[2]",
+            "{}", "{\"\": 1}", "{\"a\": 1}", "{\"a\": 1, \"b\": 1}", "{\"a\": 2}",
+            "{\"b\": []}"}) {
+        data.push_back(parse_json_with_document(json));
+    }
+    ql::datum_t rows = parse_json_with_document(big_json_array(20));
+    for (size_t i = 0; i < rows.arr_size(); ++i) {
+        data.push_back(rows.get(i));
+    }
+    data.push_back(ql::datum_t::minval());
+    data.push_back(ql::datum_t::maxval());
+
+    std::vector<std::string> keys(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        ASSERT_TRUE(data[i].append_sort_key(&keys[i]));
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+        for (size_t j = 0; j < data.size(); ++j) {
+            SCOPED_TRACE(data[i].print() + " vs. " + data[j].print());
+            const int cmp = data[i].cmp(data[j]);
+            const int key_cmp = keys[i].compare(keys[j]);
+            ASSERT_EQ(cmp < 0, key_cmp < 0);
+            ASSERT_EQ(cmp == 0, key_cmp == 0);
+            if (key_cmp != 0) {
+                ASSERT_NE(0, keys[i].compare(0, keys[j].size(), keys[j]));
+            }
+        }
+    }
+
+    // Pseudotypes compare by their own rules.
+    std::string key;
+    ASSERT_FALSE(parse_json_with_document(
+        "[1, {\"$reql_type$\": \"TIME\", \"epoch_time\": 0, "
+        "\"timezone\": \"+00:00\"}]").append_sort_key(&key));
+}
+
+TEST(DatumTest, ProjectAndUnproject) {
+    ql::datum_t row = parse_json_with_document(
+        "{\"id\": 1, \"a\": {\"x\": 1, \"y\": 2}, \"b\": [{\"x\": 3}, {\"z\": 4}], "
+        "\"c\": \"c\", \"d\": null}");
+    write_message_t wm;
+    ql::datum_serialize(&wm, row, ql::check_datum_serialization_errors_t::NO);
+    string_stream_t write_stream;
+    ASSERT_EQ(0, send_write_message(&write_stream, &wm));
+    string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+    ql::datum_t buf_row;
+    ASSERT_EQ(archive_result_t::SUCCESS, ql::datum_deserialize(&read_stream, &buf_row));
+    ASSERT_TRUE(buf_row.get_buf_ref() != nullptr);
+
+    struct test_case_t {
+        std::string paths;
+        std::string plucked;
+        std::string without;
+    };
+    const std::vector<test_case_t> test_cases = {
+        {"[\"id\"]", "{\"id\": 1}",
+         "{\"a\": {\"x\": 1, \"y\": 2}, \"b\": [{\"x\": 3}, {\"z\": 4}], "
+         "\"c\": \"c\", \"d\": null}"},
+        {"[\"d\", \"zzz\", \"c\", [\"id\", \"c\"]]",
+         "{\"c\": \"c\", \"d\": null, \"id\": 1}",
+         "{\"a\": {\"x\": 1, \"y\": 2}, \"b\": [{\"x\": 3}, {\"z\": 4}]}"},
+        {"[{\"a\": \"x\"}, {\"b\": \"x\"}, \"c\"]",
+         "{\"a\": {\"x\": 1}, \"b\": [{\"x\": 3}, {}], \"c\": \"c\"}",
+         "{\"a\": {\"y\": 2}, \"b\": [{}, {\"z\": 4}], \"d\": null, \"id\": 1}"}
+    };
+    for (const test_case_t &test_case : test_cases) {
+        SCOPED_TRACE(test_case.paths);
+        ql::pathspec_t pathspec(parse_json_with_document(test_case.paths), nullptr);
+        for (const ql::datum_t &d : {row, buf_row}) {
+            ASSERT_EQ(parse_json_with_document(test_case.plucked),
+                      ql::project(d, pathspec, ql::DONT_RECURSE,
+                                  ql::configured_limits_t::unlimited));
+            ASSERT_EQ(parse_json_with_document(test_case.without),
+                      ql::unproject(d, pathspec, ql::DONT_RECURSE,
+                                    ql::configured_limits_t::unlimited));
+        }
+    }
+}
+
+TEST(DatumTest, HashAgreesWithCmp) {
+    const std::vector<std::pair<std::string, std::string> > equal = {
+        {"0", "-0"},
+        {"[1, \"a\", null]", "[1.0, \"a\", null]"},
+        {"{\"b\": true, \"a\": {\"x\": []}}", "{\"a\": {\"x\": []}, \"b\": true}"},
+        {"{\"$reql_type$\": \"TIME\", \"epoch_time\": 10, \"timezone\": \"+00:00\"}",
+         "{\"$reql_type$\": \"TIME\", \"epoch_time\": 10, \"timezone\": \"+05:00\"}"}
+    };
+    for (const auto &pair : equal) {
+        SCOPED_TRACE(pair.first);
+        ql::datum_t a = parse_json_with_document(pair.first);
+        ql::datum_t b = parse_json_with_document(pair.second);
+        ASSERT_EQ(a, b);
+        ASSERT_EQ(a.hash(), b.hash());
+    }
+
+    // Not a requirement, but a hash that mixes these up wouldn't be much use.
+    const std::vector<std::string> different = {
+        "null", "false", "true", "0", "1", "\"\"", "\"0\"", "[]", "[0]", "[[]]", "{}",
+        "{\"a\": 0}", "{\"a\": 1}", "{\"b\": 0}"
+    };
+    std::set<size_t> hashes;
+    for (const std::string &json : different) {
+        hashes.insert(parse_json_with_document(json).hash());
+    }
+    ASSERT_EQ(different.size(), hashes.size());
+}
+
+// This is not really a unit test, but a micro benchmark that compares parsing a bulk
+// insert's worth of JSON with `parse_json_insitu_to_datum()` to parsing it into a
+// `rapidjson::Document` first.  No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(DatumTest, ParseJsonBenchmark) {
+    const int NUM_REPETITIONS = 20;
+    const std::string json = big_json_array(20000);
+
+    ticks_t start_ticks = get_ticks();
+    for (int i = 0; i < NUM_REPETITIONS; ++i) {
+        std::vector<char> buf(json.c_str(), json.c_str() + json.size() + 1);
+        rapidjson::Document document;
+        document.ParseInsitu(buf.data());
+        ql::datum_t d = ql::to_datum(document, ql::configured_limits_t::unlimited,
+                                     reql_version_t::LATEST);
+        ASSERT_TRUE(d.has());
+    }
+    double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+    printf("rapidjson::Document + to_datum: %.1f MB/s\n",
+           NUM_REPETITIONS * json.size() / secs / MEGABYTE);
+
+    start_ticks = get_ticks();
+    for (int i = 0; i < NUM_REPETITIONS; ++i) {
+        std::string error;
+        ql::datum_t d = parse_json_insitu(json, &error);
+        ASSERT_TRUE(d.has());
+    }
+    secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+    printf("parse_json_insitu_to_datum: %.1f MB/s\n",
+           NUM_REPETITIONS * json.size() / secs / MEGABYTE);
+}
+#endif  // NDEBUG
+
 }  // namespace unittest
@@ -1,4 +1,5 @@
 #include "serializer/log/data_block_manager.hpp"
+#include "serializer/log/gc_controller.hpp"
 #include "unittest/gtest.hpp"
 
 namespace unittest {
@@ -48,6 +49,39 @@ TEST(DBMTest, ReadAheadInterval) {
     ASSERT_EQ(100, end_offset);
 }
 
+TEST(DBMTest, GcController) {
+    data_gc_controller_t controller(10.0 / 9.0, 2.0);
+    ASSERT_NEAR(0.1, controller.start_ratio(), 1e-9);
+    ASSERT_NEAR(0.05, controller.stop_ratio(), 1e-9);
+    ASSERT_NEAR(0.3, controller.high_ratio(), 1e-9);
 
+    ticks_t now = {0};
+    const ticks_t second = secs_to_ticks(1);
+    ASSERT_FALSE(controller.update(0.1, now));
+
+    // The GC writes four times as much as the foreground writes, so the controller
+    // waits for more garbage, up to twice the target garbage ratio.
+    for (int i = 0; i < 10; ++i) {
+        controller.record_write(1000, false);
+        controller.record_write(4000, true);
+        ASSERT_FALSE(controller.update(0.1, now));
+        now.nanos += second.nanos;
+        ASSERT_TRUE(controller.update(0.1, now));
+    }
+    ASSERT_NEAR(5.0, controller.write_amplification(), 1e-9);
+    ASSERT_NEAR(0.2, controller.start_ratio(), 1e-9);
+    ASSERT_NEAR(0.1, controller.stop_ratio(), 1e-9);
+    ASSERT_NEAR(0.3, controller.high_ratio(), 1e-9);
+
+    // Without GC writes, it GCs down to half of the target garbage ratio.
+    for (int i = 0; i < 20; ++i) {
+        controller.record_write(1000, false);
+        now.nanos += second.nanos;
+        ASSERT_TRUE(controller.update(0.1, now));
+    }
+    ASSERT_LT(controller.write_amplification(), 2.0);
+    ASSERT_NEAR(0.05, controller.start_ratio(), 1e-9);
+    ASSERT_NEAR(0.3, controller.high_ratio(), 1e-9);
+}
 
 }  // namespace unittest
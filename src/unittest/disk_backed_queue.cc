@@ -1,4 +1,5 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <functional>
 #include <queue>
 
 #include "arch/io/disk.hpp"
@@ -18,9 +19,11 @@ serializer_filepath_t dbq_serializer_path() {
     return manual_serializer_filepath(DBQ_TEST_PATH, std::string(DBQ_TEST_PATH) + ".create");
 }
 
-void run_many_ints_test() {
+void run_many_ints_test(io_backend_mode_t backend_mode) {
     static const int NUM_ELTS_IN_QUEUE = 1000;
-    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired,
+                                DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                                backend_mode);
 
     const serializer_filepath_t serializer_path = dbq_serializer_path();
 
@@ -42,7 +45,14 @@ void run_many_ints_test() {
 }
 
 TEST(DiskBackedQueue, ManyInts) {
-    unittest::run_in_thread_pool(&run_many_ints_test, 2);
+    unittest::run_in_thread_pool(
+        std::bind(&run_many_ints_test, io_backend_mode_t::pool), 2);
+}
+
+// Falls back to the thread pool backend if the kernel doesn't support io_uring.
+TEST(DiskBackedQueue, ManyIntsIoUring) {
+    unittest::run_in_thread_pool(
+        std::bind(&run_many_ints_test, io_backend_mode_t::io_uring), 2);
 }
 
 void run_big_values_test() {
@@ -74,6 +84,48 @@ TEST(DiskBackedQueue, BigVals) {
     unittest::run_in_thread_pool(&run_big_values_test, 2);
 }
 
+// Pops while other values are still being pushed, so that values come from memory and
+// from several segment files in turn.
+void run_interleaved_test() {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    const serializer_filepath_t serializer_path = dbq_serializer_path();
+
+    disk_backed_queue_t<std::string> queue(
+        &io_backender, serializer_path, &get_global_perfmon_collection());
+    std::queue<std::string> ref_queue;
+
+    int next_value = 0;
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 500; ++i) {
+            std::string val = std::to_string(next_value++);
+            val.resize(20 * KILOBYTE, 'a' + round);
+            queue.push(val);
+            ref_queue.push(val);
+        }
+        // Pop a bit less than we pushed, so that the queue grows over time.
+        for (int i = 0; i < 400; ++i) {
+            ASSERT_FALSE(queue.empty());
+            std::string x;
+            queue.pop(&x);
+            ASSERT_EQ(ref_queue.front(), x);
+            ref_queue.pop();
+        }
+    }
+    while (!ref_queue.empty()) {
+        ASSERT_EQ(static_cast<int64_t>(ref_queue.size()), queue.size());
+        std::string x;
+        queue.pop(&x);
+        ASSERT_EQ(ref_queue.front(), x);
+        ref_queue.pop();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(DiskBackedQueue, Interleaved) {
+    unittest::run_in_thread_pool(&run_interleaved_test, 2);
+}
+
 static void randomly_delay(int, signal_t *) {
     nap(randint(100));
 }
@@ -40,8 +40,10 @@ TEST(DiskFormatTest, FlaggedOff64T) {
 TEST(DiskFormatTest, LbaShardMetablockT) {
     EXPECT_EQ(0u, offsetof(lba_shard_metablock_t, last_lba_extent_offset));
     EXPECT_EQ(8u, offsetof(lba_shard_metablock_t, last_lba_extent_entries_count));
+    EXPECT_EQ(12u, offsetof(lba_shard_metablock_t, snapshot_directory_extent));
     EXPECT_EQ(16u, offsetof(lba_shard_metablock_t, lba_superblock_offset));
     EXPECT_EQ(24u, offsetof(lba_shard_metablock_t, lba_superblock_entries_count));
+    EXPECT_EQ(28u, offsetof(lba_shard_metablock_t, snapshot_extents_count));
     EXPECT_EQ(32u, sizeof(lba_shard_metablock_t));
 }
 
@@ -56,7 +58,7 @@ TEST(DiskFormatTest, LbaMetablockMixinT) {
 }
 
 TEST(DiskFormatTest, LbaEntryT) {
-    EXPECT_EQ(0u, offsetof(lba_entry_t, zero_reserved));
+    EXPECT_EQ(0u, offsetof(lba_entry_t, compressed_ser_block_size));
     EXPECT_EQ(4u, offsetof(lba_entry_t, ser_block_size));
     EXPECT_EQ(8u, offsetof(lba_entry_t, block_id));
     EXPECT_EQ(16u, offsetof(lba_entry_t, recency));
@@ -98,6 +100,28 @@ TEST(DiskFormatTest, LbaSuperblockT) {
     EXPECT_EQ(16u, offsetof(lba_superblock_t, entries));
 }
 
+TEST(DiskFormatTest, LbaSnapshotT) {
+    EXPECT_EQ(0u, offsetof(lba_snapshot_entry_t, offset));
+    EXPECT_EQ(8u, offsetof(lba_snapshot_entry_t, recency));
+    EXPECT_EQ(16u, offsetof(lba_snapshot_entry_t, ser_block_size));
+    EXPECT_EQ(18u, offsetof(lba_snapshot_entry_t, compressed_ser_block_size));
+    EXPECT_EQ(20u, sizeof(lba_snapshot_entry_t));
+
+    EXPECT_EQ(8, LBA_SNAPSHOT_MAGIC_SIZE);
+    EXPECT_EQ(8u, offsetof(lba_snapshot_extent_t, entries));
+
+    EXPECT_EQ(0u, offsetof(lba_snapshot_directory_entry_t, offset));
+    EXPECT_EQ(8u, offsetof(lba_snapshot_directory_entry_t, entries_count));
+    EXPECT_EQ(16u, offsetof(lba_snapshot_directory_entry_t, checksum));
+    EXPECT_EQ(24u, sizeof(lba_snapshot_directory_entry_t));
+
+    EXPECT_EQ(0u, offsetof(lba_snapshot_directory_t, magic));
+    EXPECT_EQ(8u, offsetof(lba_snapshot_directory_t, shard));
+    EXPECT_EQ(16u, offsetof(lba_snapshot_directory_t, entries_count));
+    EXPECT_EQ(24u, offsetof(lba_snapshot_directory_t, aux_entries_count));
+    EXPECT_EQ(32u, offsetof(lba_snapshot_directory_t, extents));
+}
+
 TEST(DiskFormatTest, DataBlockManagerMetablockMixinT) {
     EXPECT_EQ(0u, offsetof(dbm_metablock_mixin_t, active_extent));
     EXPECT_EQ(8u, sizeof(dbm_metablock_mixin_t));
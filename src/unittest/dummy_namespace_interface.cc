@@ -29,8 +29,7 @@ void dummy_performer_t::read_outdated(const read_t &_read,
     store->new_read_token(&token);
 
 #ifndef NDEBUG
-    metainfo_checker_t metainfo_checker(store->get_region(),
-        [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t metainfo_checker(store->get_region());
 #endif
 
     return store->read(DEBUG_ONLY(metainfo_checker, ) _read, response,
@@ -45,8 +44,7 @@ void dummy_performer_t::write(const write_t &_write,
     cond_t non_interruptor;
 
 #ifndef NDEBUG
-    metainfo_checker_t metainfo_checker(store->get_region(),
-        [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t metainfo_checker(store->get_region());
 #endif
 
     write_token_t token;
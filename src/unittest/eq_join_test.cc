@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/datum_stream/eq_join.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+typedef std::vector<std::pair<ql::datum_t, ql::datum_t> > keyed_rows_t;
+
+static ql::datum_t num(double x) {
+    return ql::datum_t(x);
+}
+
+static ql::datum_t pair_of(double a, double b) {
+    return ql::datum_t(std::vector<ql::datum_t>{num(a), num(b)},
+                       ql::configured_limits_t::unlimited);
+}
+
+// A row with an id, so that rows with the same join key can be told apart.
+static ql::datum_t row(double id) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", num(id));
+    return std::move(builder).to_datum();
+}
+
+static ql::datum_t joined(const ql::datum_t &left, const ql::datum_t &right) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("left", left);
+    builder.overwrite("right", right);
+    return std::move(builder).to_datum();
+}
+
+TEST(EqJoinTest, JoinsInLeftOrder) {
+    // Left rows come in an order that isn't the order of their keys, some of them
+    // share a key, and one of them has no match.
+    keyed_rows_t left_rows = {
+        {num(3), row(0)}, {num(1), row(1)}, {pair_of(1, 2), row(2)},
+        {num(3), row(3)}, {num(7), row(4)}, {num(1), row(5)}};
+    keyed_rows_t right_rows = {
+        {num(1), row(10)}, {pair_of(1, 2), row(11)}, {num(3), row(12)},
+        {num(9), row(13)}};
+
+    // Matching by hash has to give what a nested loop gives.
+    std::deque<ql::datum_t> expected;
+    for (const auto &l : left_rows) {
+        for (const auto &r : right_rows) {
+            if (l.first == r.first) {
+                expected.push_back(joined(l.second, r.second));
+            }
+        }
+    }
+    std::deque<ql::datum_t> results;
+    ql::join_in_left_order(left_rows, keyed_rows_t(right_rows), &results);
+    ASSERT_EQ(5u, expected.size());
+    EXPECT_EQ(expected, results);
+}
+
+TEST(EqJoinTest, RightRowsWithSameKey) {
+    keyed_rows_t left_rows = {{num(2), row(0)}, {num(1), row(1)}};
+    keyed_rows_t right_rows = {
+        {num(1), row(10)}, {num(2), row(11)}, {num(1), row(12)}};
+    std::deque<ql::datum_t> results;
+    ql::join_in_left_order(left_rows, std::move(right_rows), &results);
+
+    // All right rows with a left row's key come out right after each other, and the
+    // rows of the earlier left row come first.
+    ASSERT_EQ(3u, results.size());
+    EXPECT_EQ(joined(row(0), row(11)), results[0]);
+    EXPECT_EQ(row(1), results[1].get_field("left"));
+    EXPECT_EQ(row(1), results[2].get_field("left"));
+    EXPECT_NE(results[1].get_field("right"), results[2].get_field("right"));
+}
+
+TEST(EqJoinTest, NoRightRows) {
+    keyed_rows_t left_rows = {{num(1), row(0)}};
+    std::deque<ql::datum_t> results;
+    ql::join_in_left_order(left_rows, keyed_rows_t(), &results);
+    EXPECT_TRUE(results.empty());
+}
+
+}  // namespace unittest
@@ -0,0 +1,82 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "perfmon/perfmon.hpp"
+#include "serializer/log/flash_cache.hpp"
+#include "serializer/log/stats.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static buf_ptr_t make_block(char c) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(3000));
+    memset(buf.cache_data(), c, buf.block_size().value());
+    return buf;
+}
+
+// Reads the block at `offset`, giving the write to the cache file some time to finish.
+static buf_ptr_t read_block(flash_cache_t *cache, int64_t offset,
+                            const buf_ptr_t &like) {
+    buf_ptr_t ret;
+    for (int i = 0; i < 100 && !ret.has(); ++i) {
+        ret = cache->read(offset, like.block_size());
+        coro_t::yield();
+    }
+    return ret;
+}
+
+TPTEST(FlashCacheTest, SecondReadGetsAdmitted) {
+    perfmon_collection_t collection;
+    log_serializer_stats_t stats(&collection);
+    std::vector<char> data;
+    scoped_ptr_t<file_t> file(new mock_file_t(mock_file_t::mode_rw, &data));
+    flash_cache_t cache(std::move(file), 64 * KILOBYTE, &stats);
+
+    buf_ptr_t block = make_block('a');
+    cache.note_read(DEVICE_BLOCK_SIZE, block);
+    EXPECT_EQ(0u, cache.block_count());
+    cache.note_read(DEVICE_BLOCK_SIZE, block);
+    EXPECT_EQ(1u, cache.block_count());
+
+    buf_ptr_t cached = read_block(&cache, DEVICE_BLOCK_SIZE, block);
+    ASSERT_TRUE(cached.has());
+    EXPECT_EQ(0, memcmp(block.ser_buffer(), cached.ser_buffer(),
+                        block.aligned_block_size()));
+
+    // Once the extent is released, the block can't be served from the cache anymore.
+    cache.forget_extent(0, DEFAULT_EXTENT_SIZE);
+    EXPECT_EQ(0u, cache.block_count());
+    EXPECT_FALSE(cache.read(DEVICE_BLOCK_SIZE, block.block_size()).has());
+}
+
+TPTEST(FlashCacheTest, ScansDontGetAdmitted) {
+    perfmon_collection_t collection;
+    log_serializer_stats_t stats(&collection);
+    std::vector<char> data;
+    scoped_ptr_t<file_t> file(new mock_file_t(mock_file_t::mode_rw, &data));
+    flash_cache_t cache(std::move(file), 64 * KILOBYTE, &stats);
+
+    buf_ptr_t block = make_block('b');
+    for (int64_t i = 0; i < 1000; ++i) {
+        cache.note_read(i * block.aligned_block_size(), block);
+    }
+    EXPECT_EQ(0u, cache.block_count());
+
+    // Blocks keep getting written over the oldest ones once the cache is full.
+    for (int64_t i = 0; i < 100; ++i) {
+        cache.note_read(i * block.aligned_block_size(), block);
+        cache.note_read(i * block.aligned_block_size(), block);
+        read_block(&cache, i * block.aligned_block_size(), block);
+    }
+    EXPECT_LE(cache.block_count() * block.aligned_block_size(),
+              static_cast<uint64_t>(64 * KILOBYTE));
+    EXPECT_TRUE(read_block(&cache, 99 * block.aligned_block_size(), block).has());
+    EXPECT_FALSE(cache.read(0, block.block_size()).has());
+}
+
+}  // namespace unittest
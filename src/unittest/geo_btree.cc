@@ -1,9 +1,13 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 
+#include "concurrency/cond_var.hpp"
 #include "random.hpp"
+#include "rdb_protocol/configured_limits.hpp"
 #include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/geo/geojson.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
 
 using geo::S2CellId;
 
@@ -131,5 +135,82 @@ TEST(GeoBtree, OrderBtreeKeyRelativeToS2CellIdKeys) {
     }
 }
 
+TPTEST(GeoBtree, QueryCoveringCache) {
+    lon_lat_line_t shell;
+    shell.push_back(lon_lat_point_t(0, 0));
+    shell.push_back(lon_lat_point_t(10, 0));
+    shell.push_back(lon_lat_point_t(10, 10));
+    shell.push_back(lon_lat_point_t(0, 10));
+    ql::datum_t polygon = construct_geo_polygon(shell, ql::configured_limits_t());
+
+    for (int goal_cells : {4, 16}) {
+        std::vector<S2CellId> expected = compute_cell_covering(polygon, goal_cells);
+        std::vector<S2CellId> expected_interior =
+            compute_interior_cell_covering(polygon, expected);
+        // The second round is answered from the cache.
+        for (int round = 0; round < 2; ++round) {
+            std::vector<S2CellId> covering;
+            std::vector<S2CellId> interior_covering;
+            compute_query_cell_coverings(
+                polygon, goal_cells, &covering, &interior_covering);
+            ASSERT_EQ(expected, covering);
+            ASSERT_EQ(expected_interior, interior_covering);
+        }
+    }
+}
+
+// A traversal helper that only gets used for `filter_range()`.
+class filter_range_helper_t : public geo_index_traversal_helper_t {
+public:
+    explicit filter_range_helper_t(const signal_t *interruptor)
+        : geo_index_traversal_helper_t(ql::skey_version_t::post_1_16, interruptor) { }
+    continue_bool_t on_candidate(scoped_key_value_t &&,
+                                 concurrent_traversal_fifo_enforcer_signal_t,
+                                 bool) THROWS_ONLY(interrupted_exc_t) {
+        return continue_bool_t::CONTINUE;
+    }
+
+    // Whether a traversal would skip the keys after the key of `left` up to the key
+    // of `right`.
+    bool skips(S2CellId left, S2CellId right) {
+        store_key_t left_key = cell_btree_key(left);
+        store_key_t right_key = cell_btree_key(right);
+        bool skip;
+        filter_range(left_key.btree_key(), right_key.btree_key(), &skip);
+        return skip;
+    }
+
+private:
+    static store_key_t cell_btree_key(S2CellId id) {
+        std::string key = s2cellid_to_key(id);
+        key[0] |= static_cast<char>(0x80);
+        return store_key_t(key);
+    }
+};
+
+TEST(GeoBtree, ExcludeCells) {
+    const S2CellId query_cell = S2CellId::FromFacePosLevel(2, 0, 3);
+    const S2CellId excluded_cell = query_cell.child_begin(5);
+    const S2CellId other_cell = excluded_cell.next();
+    ASSERT_TRUE(query_cell.contains(other_cell));
+
+    cond_t interruptor;
+    filter_range_helper_t helper(&interruptor);
+    helper.init_query({query_cell}, {query_cell});
+    EXPECT_FALSE(helper.skips(excluded_cell.range_min(), excluded_cell.range_max()));
+
+    helper.exclude_cells({excluded_cell});
+    // Ranges that lie inside the excluded cell are skipped...
+    EXPECT_TRUE(helper.skips(excluded_cell.range_min(), excluded_cell.range_max()));
+    EXPECT_TRUE(helper.skips(excluded_cell.child_begin(10),
+                             excluded_cell.child_end(10).prev()));
+    // ... but ranges that reach into the rest of the query cell aren't.
+    EXPECT_FALSE(helper.skips(excluded_cell.range_min(), other_cell.range_max()));
+    EXPECT_FALSE(helper.skips(other_cell.range_min(), other_cell.range_max()));
+    // Ranges outside of the query are skipped either way.
+    EXPECT_TRUE(helper.skips(query_cell.next().range_min(),
+                             query_cell.next().range_max()));
+}
+
 } /* namespace unittest */
 
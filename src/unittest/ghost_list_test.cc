@@ -0,0 +1,55 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/ghost_list.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(GhostListTest, OldestEntriesGetDropped) {
+    alt::ghost_list_t ghosts;
+    ghosts.set_capacity(300);
+    ghosts.add(1, 100);
+    ghosts.add(2, 100);
+    ghosts.add(3, 100);
+    EXPECT_EQ(3u, ghosts.entry_count());
+    EXPECT_EQ(300u, ghosts.size());
+
+    ghosts.add(4, 100);
+    EXPECT_EQ(3u, ghosts.entry_count());
+    EXPECT_FALSE(ghosts.remove(1));
+    EXPECT_TRUE(ghosts.remove(2));
+    EXPECT_FALSE(ghosts.remove(2));
+    EXPECT_EQ(200u, ghosts.size());
+
+    ghosts.set_capacity(100);
+    EXPECT_EQ(1u, ghosts.entry_count());
+    EXPECT_TRUE(ghosts.remove(4));
+    EXPECT_EQ(0u, ghosts.size());
+}
+
+TEST(GhostListTest, ReaddedEntryIsNewest) {
+    alt::ghost_list_t ghosts;
+    ghosts.set_capacity(200);
+    ghosts.add(1, 100);
+    ghosts.add(2, 100);
+    // Re-adding 1 makes 2 the oldest entry.
+    ghosts.add(1, 100);
+    EXPECT_EQ(200u, ghosts.size());
+    ghosts.add(3, 100);
+    EXPECT_FALSE(ghosts.remove(2));
+    EXPECT_TRUE(ghosts.remove(1));
+    EXPECT_TRUE(ghosts.remove(3));
+}
+
+TEST(GhostListTest, ManyRemovals) {
+    alt::ghost_list_t ghosts;
+    ghosts.set_capacity(1000);
+    ghosts.add(0, 1);
+    for (block_id_t i = 1; i < 10000; ++i) {
+        ghosts.add(i, 1);
+        EXPECT_TRUE(ghosts.remove(i));
+    }
+    EXPECT_EQ(1u, ghosts.entry_count());
+    EXPECT_TRUE(ghosts.remove(0));
+}
+
+}  // namespace unittest
@@ -0,0 +1,146 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/cond_var.hpp"
+#include "rapidjson/document.h"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/val.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static ql::datum_t parse_json(const std::string &json) {
+    rapidjson::Document document;
+    document.Parse(json.c_str());
+    guarantee(!document.HasParseError());
+    return ql::to_datum(document, ql::configured_limits_t::unlimited,
+                        reql_version_t::LATEST);
+}
+
+static scoped_ptr_t<ql::val_t> eval_term(ql::env_t *env, ql::raw_term_t term) {
+    ql::compile_env_t compile_env((ql::var_visibility_t()));
+    counted_t<const ql::term_t> compiled = ql::compile_term(&compile_env, term);
+    ql::scope_env_t scope_env(env, ql::var_scope_t());
+    return compiled->eval(&scope_env);
+}
+
+static ql::datum_t eval_to_array(ql::env_t *env, ql::raw_term_t term) {
+    return eval_term(env, term)->as_seq(env)->to_array(env)->as_datum();
+}
+
+// A join on `left.a == right.b`, which gets a hash join, and the same join with a
+// predicate that doesn't look like a field equality, which gets the nested loop.
+static ql::raw_term_t join(ql::minidriver_t *r, Term::TermType type,
+                           ql::minidriver_t::reql_t left,
+                           ql::minidriver_t::reql_t right, bool hashed) {
+    auto x = ql::minidriver_t::dummy_var_t::GROUPBY_REDUCE_A;
+    auto y = ql::minidriver_t::dummy_var_t::GROUPBY_REDUCE_B;
+    ql::minidriver_t::reql_t eq = r->var(x)["a"] == r->var(y)["b"];
+    ql::minidriver_t::reql_t func = hashed
+        ? r->fun(x, y, eq)
+        : r->fun(x, y, eq && r->boolean(true));
+    return left.call(type, right, func).root_term();
+}
+
+const char *const left_rows =
+    "[{\"id\": 1, \"a\": 1, \"g\": 0}, {\"id\": 2, \"a\": 2, \"g\": 1},"
+    " {\"id\": 3, \"a\": 1, \"g\": 1}, {\"id\": 5, \"a\": 9, \"g\": 0},"
+    " {\"id\": 6, \"a\": [1], \"g\": 1}]";
+const char *const right_rows =
+    "[{\"id\": 10, \"b\": 1}, {\"id\": 11, \"b\": 2}, {\"id\": 12, \"b\": 1},"
+    " {\"id\": 14, \"b\": [1]}, {\"id\": 15, \"b\": 1.0}]";
+
+TPTEST(HashJoinTest, MatchesNestedLoop) {
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    for (Term::TermType type : {Term::INNER_JOIN, Term::OUTER_JOIN}) {
+        ql::datum_t hashed = eval_to_array(&env, join(
+            &r, type, r.expr(parse_json(left_rows)), r.expr(parse_json(right_rows)),
+            true));
+        ql::datum_t nested = eval_to_array(&env, join(
+            &r, type, r.expr(parse_json(left_rows)), r.expr(parse_json(right_rows)),
+            false));
+        ASSERT_EQ(nested, hashed);
+        ASSERT_EQ(type == Term::INNER_JOIN ? 8u : 9u, hashed.arr_size());
+    }
+}
+
+TPTEST(HashJoinTest, FallsBackOverArrayLimit) {
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    ql::env_t unlimited_env(&interruptor,
+                            ql::return_empty_normal_batches_t::NO,
+                            reql_version_t::LATEST);
+
+    // The right side has more rows than the array size limit, so the hash join
+    // has to go through the nested loop.  That mustn't hit the limit either.
+    rdb_context_t ctx;
+    ql::global_optargs_t optargs;
+    optargs.add_optarg(r.expr(3.0).root_term(), "array_limit");
+    ql::env_t env(&ctx, ql::return_empty_normal_batches_t::NO, &interruptor,
+                  std::move(optargs),
+                  auth::user_context_t(auth::permissions_t(
+                      tribool::True, tribool::False, tribool::False, tribool::False)),
+                  ql::datum_t(), nullptr);
+    ASSERT_EQ(3u, env.limits().array_size_limit());
+
+    for (Term::TermType type : {Term::INNER_JOIN, Term::OUTER_JOIN}) {
+        ql::datum_t limited = eval_to_array(&env, join(
+            &r, type, r.expr(parse_json(left_rows)), r.expr(parse_json(right_rows)),
+            true));
+        ql::datum_t expected = eval_to_array(&unlimited_env, join(
+            &r, type, r.expr(parse_json(left_rows)), r.expr(parse_json(right_rows)),
+            false));
+        ASSERT_EQ(expected, limited);
+    }
+}
+
+TPTEST(HashJoinTest, EmptyLeftDoesNotReadRight) {
+    auto z = ql::minidriver_t::dummy_var_t::GROUPBY_MAP_OBJ;
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    // Reading this sequence fails, because none of its rows have the field `c`.
+    ql::minidriver_t::reql_t right =
+        r.expr(parse_json(right_rows)).concat_map(r.fun(z, r.var(z)["c"]));
+    for (Term::TermType type : {Term::INNER_JOIN, Term::OUTER_JOIN}) {
+        ql::datum_t res =
+            eval_to_array(&env, join(&r, type, r.array(), right, true));
+        ASSERT_EQ(0u, res.arr_size());
+    }
+}
+
+TPTEST(HashJoinTest, Grouped) {
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    for (Term::TermType type : {Term::INNER_JOIN, Term::OUTER_JOIN}) {
+        counted_t<ql::grouped_data_t> hashed = eval_term(&env, join(
+            &r, type,
+            r.expr(parse_json(left_rows)).call(Term::GROUP, std::string("g")),
+            r.expr(parse_json(right_rows)), true))->as_grouped_data();
+        counted_t<ql::grouped_data_t> nested = eval_term(&env, join(
+            &r, type,
+            r.expr(parse_json(left_rows)).call(Term::GROUP, std::string("g")),
+            r.expr(parse_json(right_rows)), false))->as_grouped_data();
+        ASSERT_EQ(2u, hashed->size());
+        ASSERT_EQ(nested->size(), hashed->size());
+        for (auto it = nested->begin(), jt = hashed->begin(); it != nested->end();
+             ++it, ++jt) {
+            ASSERT_EQ(it->first, jt->first);
+            ASSERT_EQ(it->second, jt->second);
+        }
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,94 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/lba/in_memory_index.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+void check_round_trip(in_memory_index_t *index, block_id_t id,
+                      const index_block_info_t &info) {
+    index->set_block_info(id, info.recency, info.offset, info.ser_block_size,
+                          info.compressed_ser_block_size);
+    ASSERT_TRUE(info == index->get_block_info(id));
+}
+
+repli_timestamp_t make_recency(uint64_t longtime) {
+    repli_timestamp_t recency;
+    recency.longtime = longtime;
+    return recency;
+}
+
+TEST(InMemoryIndex, PackedEntries) {
+    in_memory_index_t index;
+    ASSERT_TRUE(index_block_info_t() == index.get_block_info(5));
+
+    const repli_timestamp_t late = make_recency(uint64_t(1) << 40);
+    check_round_trip(&index, 5, index_block_info_t(
+        flagged_off64_t::make(1000 * DEVICE_BLOCK_SIZE), late, 4080, 0));
+    check_round_trip(&index, 13, index_block_info_t(
+        flagged_off64_t::make(0), repli_timestamp_t::distant_past, 4080, 1500));
+    check_round_trip(&index, 21, index_block_info_t(
+        flagged_off64_t::unused(), repli_timestamp_t::invalid, 0, 0));
+    ASSERT_EQ(22u, index.end_block_id());
+
+    // This can't be packed because of its unaligned offset.
+    check_round_trip(&index, 29, index_block_info_t(
+        flagged_off64_t::make(DEVICE_BLOCK_SIZE + 1), late, 4080, 0));
+    ASSERT_EQ(1u, index.overflow_size());
+    // And once it can, it's packed again.
+    check_round_trip(&index, 29, index_block_info_t(
+        flagged_off64_t::make(DEVICE_BLOCK_SIZE), late.next(), 4080, 0));
+    ASSERT_EQ(0u, index.overflow_size());
+
+    // A recency far below the first is raised to the shard's base.
+    index.set_block_info(37, make_recency(1), flagged_off64_t::make(0), 4080, 0);
+    const repli_timestamp_t base = index.get_block_info(37).recency;
+    ASSERT_LT(make_recency(1), base);
+    ASSERT_LT(base, late);
+    ASSERT_EQ(0u, index.overflow_size());
+
+    // After 254 different sizes, the rest go into the overflow map.
+    for (uint16_t size = 1; size <= 300; ++size) {
+        check_round_trip(&index, 8 * size, index_block_info_t(
+            flagged_off64_t::make(0), late, size, 0));
+    }
+
+    const block_id_t aux_id = FIRST_AUX_BLOCK_ID + 3;
+    check_round_trip(&index, aux_id, index_block_info_t(
+        flagged_off64_t::make(uint64_t(1) << 45), repli_timestamp_t::invalid, 4080, 7));
+    ASSERT_EQ(aux_id + 1, index.end_aux_block_id());
+}
+
+TEST(InMemoryIndex, RecenciesMoveTheBase) {
+    // Writes recencies that span much more than the 32 bits of a packed recency.  The
+    // shard's base has to move up, and nothing goes into the overflow map.
+    in_memory_index_t index;
+    const block_id_t num_blocks = 4 * LBA_SHARD_FACTOR;
+    const uint64_t step = uint64_t(1) << 29;
+    const flagged_off64_t offset = flagged_off64_t::make(0);
+    for (uint64_t round = 1; round <= 64; ++round) {
+        // The blocks of a shard get recencies in a different order in every round, so
+        // some of them are behind when the base moves.
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            const block_id_t id = (i * 7 + round) % num_blocks;
+            index.set_block_info(id, make_recency(round * step + id), offset, 4080, 0);
+        }
+        ASSERT_EQ(0u, index.overflow_size());
+        for (block_id_t id = 0; id < num_blocks; ++id) {
+            EXPECT_EQ(round * step + id, index.get_block_info(id).recency.longtime);
+        }
+    }
+
+    // A recency that is left far behind when the base moves is raised, but it stays
+    // below the new recency.
+    const uint64_t later = 65 * step + (uint64_t(1) << 33);
+    index.set_block_info(0, make_recency(later), offset, 4080, 0);
+    EXPECT_EQ(later, index.get_block_info(0).recency.longtime);
+    const repli_timestamp_t raised = index.get_block_info(LBA_SHARD_FACTOR).recency;
+    EXPECT_LT(64 * step + LBA_SHARD_FACTOR, raised.longtime);
+    EXPECT_LT(raised.longtime, later);
+    EXPECT_EQ(0u, index.overflow_size());
+    // Other shards aren't affected.
+    EXPECT_EQ(64 * step + 1, index.get_block_info(1).recency.longtime);
+}
+
+}  // namespace unittest
@@ -1,11 +1,14 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include <algorithm>
+#include <set>
+#include <string>
 #include <vector>
 
 #include "unittest/gtest.hpp"
 
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
+#include "random.hpp"
 
 namespace unittest {
 
@@ -61,6 +64,46 @@ TEST(InternalNodeTest, Offsets) {
     EXPECT_EQ(9u, sizeof(btree_internal_pair));
 }
 
+// Keys from a small alphabet, so that many of them share their first eight bytes or
+// are prefixes of each other.
+std::string random_internal_key(rng_t *rng) {
+    static const char alphabet[] = { '\0', '\1', 'a', '\xff' };
+    std::string key;
+    const int size = 1 + rng->randint(12);
+    for (int i = 0; i < size; ++i) {
+        key += alphabet[rng->randint(sizeof(alphabet))];
+    }
+    return key;
+}
+
+TEST(InternalNodeTest, LookupMatchesKeyOrder) {
+    rng_t rng(1234);
+    const block_size_t block_size = block_size_t::make_from_cache(4096);
+    std::vector<char> buf(block_size.value());
+    internal_node_t *node = reinterpret_cast<internal_node_t *>(buf.data());
+    internal_node::init(block_size, node);
+
+    std::set<std::string> keys;
+    while (keys.size() < 100) {
+        const std::string key = random_internal_key(&rng);
+        if (keys.insert(key).second) {
+            ASSERT_TRUE(internal_node::insert(node, store_key_t(key).btree_key(),
+                                              keys.size(), keys.size() + 1));
+        }
+    }
+    verify(block_size, node);
+
+    for (int i = 0; i < 1000; ++i) {
+        const store_key_t key(random_internal_key(&rng));
+        const uint16_t *expected = std::lower_bound(
+            node->pair_offsets, node->pair_offsets + node->npairs - 1,
+            static_cast<uint16_t>(internal_key_comp::faux_offset),
+            internal_key_comp(node, key.btree_key()));
+        EXPECT_EQ(expected - node->pair_offsets,
+                  internal_node::get_offset_index(node, key.btree_key()));
+    }
+}
+
 
 }  // namespace unittest
 
@@ -193,6 +193,47 @@ SPAWNER_TEST(JSProc, InfiniteRecursionFunction) {
     ASSERT_EQ(*err_msg, std::string("RangeError: Maximum call stack size exceeded"));
 }
 
+SPAWNER_TEST(JSProc, CallBatch) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, nullptr, limits);
+
+    const std::string source_code =
+        "(function (x) { if (x == 3) { throw 'three'; } return x * 2; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    for (int i = 0; i < 3; ++i) {
+        args_batch.push_back(
+            std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+    std::vector<js_result_t> results =
+        js_runner.call_batch(source_code, args_batch, config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(3u, results.size());
+    for (int i = 0; i < 3; ++i) {
+        ql::datum_t *res_datum = boost::get<ql::datum_t>(&results[i]);
+        ASSERT_TRUE(res_datum != nullptr);
+        ASSERT_EQ(i * 2, res_datum->as_int());
+    }
+
+    // The batch stops at the row that throws.
+    for (int i = 3; i < 6; ++i) {
+        args_batch.push_back(
+            std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+    results = js_runner.call_batch(source_code, args_batch, config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(4u, results.size());
+    std::string *error = boost::get<std::string>(&results[3]);
+    ASSERT_TRUE(error != nullptr);
+    ASSERT_EQ("three", *error);
+}
+
 void run_overalloc_function_test() {
     extproc_pool_t extproc_pool(1);
     js_runner_t js_runner;
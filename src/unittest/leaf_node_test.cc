@@ -194,6 +194,10 @@ public:
         return leaf::is_underfull(&sizer_, node());
     }
 
+    bool IsChangeSafe() {
+        return leaf::is_change_safe(&sizer_, node());
+    }
+
     bool ShouldHave(const store_key_t& key) {
         return kv_.end() != kv_.find(key);
     }
@@ -242,6 +246,12 @@ public:
             printf("\n");
         }
         ASSERT_TRUE(leaf_guts == kv_);
+
+        for (const auto &pair : kv_) {
+            short_value_buffer_t v(std::string(""));
+            ASSERT_TRUE(leaf::lookup(&sizer_, node(), pair.first.btree_key(), v.data()));
+            ASSERT_EQ(pair.second, v.as_str());
+        }
     }
 
 private:
@@ -397,6 +407,83 @@ TEST(LeafNodeTest, RandomOutOfOrderLowTstamp) {
     }
 }
 
+// Keys that share a long prefix, so that the key heads (see leaf_node.cc) only
+// tell the keys apart after skipping it.
+TEST(LeafNodeTest, SharedPrefixKeys) {
+    rng_t rng;
+    const std::string prefix = "tenant:0123456789abcdef:";
+    std::vector<store_key_t> key_pool;
+    for (int i = 0; i < 60; ++i) {
+        // Some keys are equal in their first four bytes after the prefix.
+        key_pool.push_back(store_key_t(
+            prefix + strprintf("%04d", i / 3) + random_letter_string(&rng, 0, 3)));
+    }
+
+    for (int try_num = 0; try_num < 3; ++try_num) {
+        LeafNodeTracker tracker;
+        for (int i = 0; i < 5000; ++i) {
+            const store_key_t &key = key_pool[rng.randint(key_pool.size())];
+            if (rng.randint(3) == 0) {
+                if (tracker.ShouldHave(key)) {
+                    tracker.Remove(key);
+                }
+            } else {
+                tracker.Insert(key, random_letter_string(&rng, 0, 10));
+            }
+        }
+
+        // Keys that aren't in the node must not be found, including ones that sort
+        // between the keys that are in it.
+        short_value_buffer_t v(std::string(""));
+        for (int i = 0; i < 100; ++i) {
+            store_key_t key(prefix + strprintf("%04d", i / 5)
+                            + random_letter_string(&rng, 0, 4));
+            ASSERT_EQ(tracker.ShouldHave(key),
+                      leaf::lookup(tracker.sizer(), tracker.node(), key.btree_key(),
+                                   v.data()));
+        }
+        ASSERT_FALSE(leaf::lookup(tracker.sizer(), tracker.node(),
+                                  store_key_t("tenant:").btree_key(), v.data()));
+        ASSERT_FALSE(leaf::lookup(tracker.sizer(), tracker.node(),
+                                  store_key_t("tenant;").btree_key(), v.data()));
+    }
+}
+
+TEST(LeafNodeTest, KeyFilter) {
+    rng_t rng;
+    LeafNodeTracker tracker;
+    std::vector<store_key_t> inserted, removed;
+    for (int i = 0; i < 100; ++i) {
+        store_key_t key(strprintf("key%03d", i));
+        ASSERT_TRUE(tracker.Insert(key, random_letter_string(&rng, 0, 4)));
+        inserted.push_back(key);
+    }
+    for (int i = 0; i < 100; i += 2) {
+        tracker.Remove(inserted[i]);
+        removed.push_back(inserted[i]);
+    }
+
+    const std::vector<uint64_t> filter = leaf::make_key_filter(tracker.node());
+    for (int i = 1; i < 100; i += 2) {
+        ASSERT_TRUE(leaf::key_filter_may_contain(filter, inserted[i].btree_key()));
+    }
+    // The removed keys still have tombstones in the node, but they don't count.
+    int false_positives = 0;
+    for (const store_key_t &key : removed) {
+        false_positives += leaf::key_filter_may_contain(filter, key.btree_key());
+    }
+    for (int i = 0; i < 1000; ++i) {
+        store_key_t key(strprintf("other%04d", i));
+        false_positives += leaf::key_filter_may_contain(filter, key.btree_key());
+    }
+    ASSERT_LT(false_positives, 40);
+
+    LeafNodeTracker empty;
+    const std::vector<uint64_t> empty_filter = leaf::make_key_filter(empty.node());
+    ASSERT_FALSE(leaf::key_filter_may_contain(empty_filter,
+                                              store_key_t("key").btree_key()));
+}
+
 void make_node_underfull(LeafNodeTracker *tracker, rng_t *rng) {
     leaf_node_t *node = tracker->node();
     while (!tracker->IsUnderfull() ||
@@ -711,4 +798,23 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+TEST(LeafNodeTest, ChangeSafety) {
+    LeafNodeTracker node;
+    ASSERT_FALSE(node.IsChangeSafe());
+
+    const store_key_t big_key(std::string(MAX_KEY_SIZE, 'z'));
+    const std::string big_value(250, 'Z');
+    bool was_safe = false;
+    for (int i = 0; node.Insert(store_key_t(strprintf("a%d", i)), strprintf("A%d", i));
+         ++i) {
+        if (node.IsChangeSafe()) {
+            was_safe = true;
+            ASSERT_FALSE(node.IsFull(big_key, big_value));
+            ASSERT_FALSE(node.IsUnderfull());
+        }
+    }
+    ASSERT_TRUE(was_safe);
+    ASSERT_FALSE(node.IsChangeSafe());
+}
+
 }  // namespace unittest
@@ -0,0 +1,109 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/context.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+using ql::changefeed::item_queue_t;
+using ql::changefeed::item_t;
+using ql::changefeed::limit_order_t;
+using ql::changefeed::limit_window_t;
+
+typedef std::map<std::string, std::pair<ql::datum_t, ql::datum_t> > added_t;
+
+// A row whose id and sort key are `x`.
+static item_t row(double x) {
+    return item_t(strprintf("%g", x),
+                  std::make_pair(ql::datum_t(x), ql::datum_t(x)));
+}
+
+static added_t added_rows(const std::vector<double> &xs) {
+    added_t res;
+    for (double x : xs) {
+        res.insert(row(x));
+    }
+    return res;
+}
+
+static std::set<double> rows_in(const item_queue_t &queue) {
+    std::set<double> res;
+    for (const auto &it : queue) {
+        res.insert(it->second.first.as_num());
+    }
+    return res;
+}
+
+TEST(LimitWindow, SlackFillsDeletions) {
+    limit_order_t gt((sorting_t::ASCENDING));
+    limit_window_t window(gt, 3, 3);
+    window.init({row(1), row(2), row(3)});
+
+    // The feed starts without any slack, so the first deletion has to read.  It
+    // reads enough for the slack too, and keeps at most `slack_size` of it.
+    optional<item_t> boundary;
+    {
+        item_queue_t real_added(gt);
+        std::set<std::string> real_deleted;
+        ASSERT_TRUE(window.apply_changes(
+            {row(1).first}, added_t(), &boundary, &real_added, &real_deleted));
+        ASSERT_TRUE(static_cast<bool>(boundary));
+        EXPECT_EQ(row(3).first, boundary->first);
+        EXPECT_EQ(std::set<std::string>{row(1).first}, real_deleted);
+        EXPECT_EQ(4u, window.rows_to_read());
+        window.add_read({row(3), row(4), row(5), row(6), row(7)}, &real_added);
+        EXPECT_EQ((std::set<double>{2, 3, 4}), rows_in(window.get_item_queue()));
+        EXPECT_EQ((std::set<double>{5, 6}), rows_in(window.get_slack()));
+        EXPECT_EQ((std::set<double>{4}), rows_in(real_added));
+    }
+
+    // Now deleting rows from the active set doesn't have to read.
+    {
+        item_queue_t real_added(gt);
+        std::set<std::string> real_deleted;
+        EXPECT_FALSE(window.apply_changes(
+            {row(2).first}, added_t(), &boundary, &real_added, &real_deleted));
+        EXPECT_EQ((std::set<double>{3, 4, 5}), rows_in(window.get_item_queue()));
+        EXPECT_EQ((std::set<double>{6}), rows_in(window.get_slack()));
+        EXPECT_EQ((std::set<double>{5}), rows_in(real_added));
+        EXPECT_EQ(std::set<std::string>{row(2).first}, real_deleted);
+    }
+}
+
+TEST(LimitWindow, AddedRows) {
+    limit_order_t gt((sorting_t::ASCENDING));
+    limit_window_t window(gt, 3, 3);
+    window.init({row(1), row(2), row(3)});
+    optional<item_t> boundary;
+    {
+        item_queue_t real_added(gt);
+        std::set<std::string> real_deleted;
+        ASSERT_TRUE(window.apply_changes(
+            {row(1).first}, added_t(), &boundary, &real_added, &real_deleted));
+        window.add_read({row(4), row(5), row(6), row(7)}, &real_added);
+    }
+    ASSERT_EQ((std::set<double>{2, 3, 4}), rows_in(window.get_item_queue()));
+    ASSERT_EQ((std::set<double>{5, 6}), rows_in(window.get_slack()));
+
+    // A row that beats the active set pushes its last row into the slack, a row
+    // between the active set and the end of the slack goes into the slack, and a row
+    // after the slack might have rows on disk in front of it, so we drop it.
+    item_queue_t real_added(gt);
+    std::set<std::string> real_deleted;
+    EXPECT_FALSE(window.apply_changes(
+        std::set<std::string>(), added_rows({0, 5.5, 10}), &boundary, &real_added,
+        &real_deleted));
+    EXPECT_EQ(row(6).first, boundary->first);
+    EXPECT_EQ((std::set<double>{0, 2, 3}), rows_in(window.get_item_queue()));
+    // The slack keeps the `slack_size` rows that sort first.
+    EXPECT_EQ((std::set<double>{4, 5, 5.5}), rows_in(window.get_slack()));
+    EXPECT_EQ((std::set<double>{0}), rows_in(real_added));
+    EXPECT_EQ(std::set<std::string>{row(4).first}, real_deleted);
+}
+
+}  // namespace unittest
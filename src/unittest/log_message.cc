@@ -20,7 +20,8 @@ TEST(LogMessageTest, ParseFormat) {
     EXPECT_EQ(message.message, parsed.message);
 }
 
-void test_chunks(const std::vector<size_t> &sizes) {
+// Writes lines of the given sizes and reads them back, starting before line `end_line`.
+void test_chunks(const std::vector<size_t> &sizes, size_t end_line) {
 #ifdef _WIN32
     std::string filename = strprintf("c:\\windows\\temp\\rethinkdb-unittest-file-reverse-reader-%09d", randint(1000000000));
     HANDLE handle = CreateFile(filename.c_str(), GENERIC_WRITE | GENERIC_READ, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, NULL);
@@ -50,8 +51,12 @@ void test_chunks(const std::vector<size_t> &sizes) {
 #ifndef _WIN32
     fsync(fd.get());
 #endif
-    file_reverse_reader_t rr(std::move(fd));
-    for (ssize_t i = sizes.size() - 1; i >= 0; --i) {
+    int64_t end = 0;
+    for (size_t i = 0; i < end_line; ++i) {
+        end += sizes[i] + 1;
+    }
+    file_reverse_reader_t rr(std::move(fd), end);
+    for (ssize_t i = end_line - 1; i >= 0; --i) {
         std::string expected(sizes[i], 'A' + i);
         std::string actual;
         bool ok = rr.get_next(&actual);
@@ -67,7 +72,17 @@ TPTEST(LogMessageTest, FileReverseReader) {
     for (size_t a = 0; a < 10; ++a) {
         for (size_t b = 0; b < 10; ++b) {
             for (size_t c = 0; c < 10; ++c) {
-                test_chunks({4096-5+a, b, c});
+                test_chunks({4096-5+a, b, c}, 3);
+            }
+        }
+    }
+}
+
+TPTEST(LogMessageTest, FileReverseReaderFromOffset) {
+    for (size_t a = 0; a < 10; ++a) {
+        for (size_t b = 0; b < 10; ++b) {
+            for (size_t end_line = 0; end_line <= 3; ++end_line) {
+                test_chunks({4096-5+a, b, 4096}, end_line);
             }
         }
     }
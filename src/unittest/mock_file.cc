@@ -30,6 +30,13 @@ void mock_file_t::set_file_size_at_least(int64_t size, UNUSED int64_t extent_siz
     }
 }
 
+void mock_file_t::discard(int64_t offset, int64_t length) {
+    guarantee(mode_ & mode_write);
+    guarantee(0 <= offset && 0 <= length
+              && static_cast<uint64_t>(offset + length) <= data_->size());
+    memset(data_->data() + offset, 0, length);
+}
+
 void mock_file_t::read_async(int64_t offset, size_t length, void *buf,
                              UNUSED file_account_t *account, linux_iocallback_t *cb) {
     guarantee(mode_ & mode_read);
@@ -102,4 +109,11 @@ void mock_file_opener_t::unlink_serializer_file() {
     file_existence_state_ = unlinked_file;
 }
 
+bool mock_file_opener_t::open_flash_cache_file(const std::string &,
+                                               scoped_ptr_t<file_t> *file_out) {
+    flash_cache_file_.clear();
+    file_out->init(new mock_file_t(mock_file_t::mode_rw, &flash_cache_file_));
+    return true;
+}
+
 }  // namespace unittest
@@ -23,6 +23,7 @@ public:
     int64_t get_file_size();
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size, int64_t extent_size);
+    void discard(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf,
                     file_account_t *account, linux_iocallback_t *cb);
@@ -32,7 +33,8 @@ public:
     void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                       file_account_t *account, linux_iocallback_t *cb);
 
-    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit) {
+    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit,
+                         UNUSED io_class_t io_class) {
         // We don't care about accounts.  Return an arbitrary non-null pointer.
         return this;
     }
@@ -60,10 +62,13 @@ public:
     void open_serializer_file_existing(scoped_ptr_t<file_t> *file_out);
     void unlink_serializer_file();
 
+    bool open_flash_cache_file(const std::string &path, scoped_ptr_t<file_t> *file_out);
+
 private:
     enum existence_state_t { no_file, temporary_file, permanent_file, unlinked_file };
     existence_state_t file_existence_state_;
     std::vector<char> file_;
+    std::vector<char> flash_cache_file_;
 };
 
 }  // namespace unittest
@@ -37,8 +37,7 @@ std::string mock_parse_read_response(const read_response_t &rr) {
 
 std::string mock_lookup(store_view_t *store, std::string key) {
 #ifndef NDEBUG
-    metainfo_checker_t checker(store->get_region(),
-        [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t checker(store->get_region());
 #endif
     read_token_t token;
     store->new_read_token(&token);
@@ -133,7 +132,9 @@ void mock_store_t::read(
         }
 
 #ifndef NDEBUG
-        metainfo_.visit(metainfo_checker.region, metainfo_checker.callback);
+        if (metainfo_checker.callback) {
+            metainfo_.visit(metainfo_checker.region, metainfo_checker.callback);
+        }
 #endif
 
         if (randint(2) == 0) {
@@ -197,7 +198,9 @@ void mock_store_t::write(
         order_sink_.check_out(order_token);
 
 #ifndef NDEBUG
-        metainfo_.visit(metainfo_checker.region, metainfo_checker.callback);
+        if (metainfo_checker.callback) {
+            metainfo_.visit(metainfo_checker.region, metainfo_checker.callback);
+        }
 #endif
 
         if (randint(2) == 0) {
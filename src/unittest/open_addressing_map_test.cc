@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+
+#include "containers/open_addressing_map.hpp"
+#include "random.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(OpenAddressingMap, MatchesStdMap) {
+    int values[8];
+    open_addressing_map_t<uint64_t, int *> map;
+    std::map<uint64_t, int *> expected;
+    rng_t rng(5);
+    // A small key space, so that inserts and erases hit the same keys and the
+    // table grows and shrinks a few times.  Half the keys have the top bit set, like
+    // aux block ids.
+    const uint64_t top_bit = uint64_t(1) << 63;
+    for (int round = 0; round < 4; ++round) {
+        const bool mostly_insert = round % 2 == 0;
+        for (int i = 0; i < 20000; ++i) {
+            const uint64_t key = rng.randint(5000) | (rng.randint(2) == 0 ? top_bit : 0);
+            if (rng.randint(4) != 0 ? mostly_insert : !mostly_insert) {
+                int *value = &values[rng.randint(8)];
+                bool inserted = map.insert(key, value);
+                ASSERT_EQ(expected.count(key) == 0, inserted);
+                expected.insert(std::make_pair(key, value));
+            } else {
+                ASSERT_EQ(expected.erase(key) == 1, map.erase(key));
+            }
+        }
+        ASSERT_EQ(expected.size(), map.size());
+        for (uint64_t i = 0; i < 5000; ++i) {
+            for (uint64_t key : {i, i | top_bit}) {
+                auto it = expected.find(key);
+                ASSERT_EQ(it == expected.end() ? nullptr : it->second, map.get(key));
+            }
+        }
+        size_t visited = 0;
+        map.visit([&](const open_addressing_map_t<uint64_t, int *>::entry_t &entry) {
+            ASSERT_EQ(expected.at(entry.key), entry.value);
+            ++visited;
+        });
+        ASSERT_EQ(expected.size(), visited);
+    }
+}
+
+}  // namespace unittest
@@ -214,6 +214,133 @@ TPTEST(PageTest, OneWriteAcqWait, 4) {
     page_cache.flush(std::move(txn));
 }
 
+TPTEST(PageTest, PrefetchBlock, 4) {
+    mock_ser_t mock;
+    block_id_t block_id;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_id = acq.block_id();
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            memset(page_acq.get_buf_write(), 0, page_cache.max_block_size().value());
+        }
+        page_cache.flush(std::move(txn));
+    }
+
+    // A fresh cache has to load the block from the serializer.
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    ASSERT_TRUE(page_cache.prefetch_block(block_id));
+    // It's already being loaded.
+    ASSERT_FALSE(page_cache.prefetch_block(block_id));
+    ASSERT_EQ(1u, page_cache.prefetched_blocks());
+    ASSERT_EQ(0u, page_cache.prefetch_hits());
+
+    auto txn = make_scoped<test_txn_t>(&page_cache);
+    {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), &page_cache);
+        page_acq.buf_ready_signal()->wait();
+    }
+    page_cache.flush(std::move(txn));
+    ASSERT_EQ(1u, page_cache.prefetch_hits());
+
+    // The block is in memory now.
+    ASSERT_FALSE(page_cache.prefetch_block(block_id));
+    ASSERT_EQ(1u, page_cache.prefetched_blocks());
+}
+
+TPTEST(PageTest, HotSetWarmUp, 4) {
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (int i = 0; i < 3; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            memset(page_acq.get_buf_write(), i, page_cache.max_block_size().value());
+        }
+        page_cache.flush(std::move(txn));
+    }
+
+    // The hot set is ordered by when the blocks were last read.
+    std::vector<block_id_t> hot_set;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (size_t i : {2, 0}) {
+            current_test_acq_t acq(txn.get(), block_ids[i], access_t::read);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_read(), &page_cache);
+            page_acq.buf_ready_signal()->wait();
+            page_acq.get_buf_read();
+        }
+        page_cache.flush(std::move(txn));
+        hot_set = page_cache.hot_block_ids(10);
+        ASSERT_EQ((std::vector<block_id_t>{block_ids[0], block_ids[2]}), hot_set);
+        ASSERT_EQ(std::vector<block_id_t>{block_ids[0]}, page_cache.hot_block_ids(1));
+    }
+
+    // A fresh cache loads them back, within the budget.
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    cond_t non_interruptor;
+    page_cache.warm_up(hot_set, 1, &non_interruptor);
+    ASSERT_EQ(1u, page_cache.prefetched_blocks());
+    page_cache.warm_up(hot_set, GIGABYTE, &non_interruptor);
+    ASSERT_EQ(2u, page_cache.prefetched_blocks());
+}
+
+TPTEST(PageTest, PrefetchBlocks, 4) {
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (int i = 0; i < 3; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            memset(page_acq.get_buf_write(), i, page_cache.max_block_size().value());
+        }
+        page_cache.flush(std::move(txn));
+    }
+
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    auto txn = make_scoped<test_txn_t>(&page_cache);
+    {
+        current_test_acq_t acq(txn.get(), block_ids[1], access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), &page_cache);
+        page_acq.buf_ready_signal()->wait();
+    }
+    page_cache.flush(std::move(txn));
+
+    // The block that's in memory is skipped, the other two get loaded in the
+    // background.
+    page_cache.prefetch_blocks(block_ids);
+    for (int i = 0; i < 100 && page_cache.prefetched_blocks() < 2; ++i) {
+        nap(10);
+    }
+    ASSERT_EQ(2u, page_cache.prefetched_blocks());
+    for (block_id_t block_id : block_ids) {
+        ASSERT_FALSE(page_cache.prefetch_block(block_id));
+    }
+}
+
 struct ReadAfterWrite_state_t {
     block_id_t block_id;
     cond_t write_acquired;
@@ -310,6 +437,27 @@ TPTEST(PageTest, WriteWaitForFlush, 4) {
     pmap(2, std::bind(&WriteWaitForFlush_cases, &s, &page_cache, ph::_1));
 }
 
+TPTEST(PageTest, GroupDurability, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    cache_t cache(mock.ser.get(), &balancer, &get_global_perfmon_collection(),
+                  which_cpu_shard_t{0, 1});
+    // The group txns must get flushed long before the soft durability flush would
+    // come along.
+    const ticks_t start = get_ticks();
+    pmap(16, [&](int i) {
+        cache_conn_t cache_conn(&cache);
+        txn_t txn(&cache_conn, write_durability_t::GROUP, 1);
+        {
+            buf_lock_t lock(buf_parent_t(&txn), alt_create_t::create);
+            buf_write_t write(&lock);
+            memset(write.get_data_write(), i, cache.max_block_size().value());
+        }
+        txn.commit();
+    });
+    EXPECT_LT(get_ticks().nanos - start.nanos, DEFAULT_FLUSH_INTERVAL / 2 * MILLION);
+}
+
 class bigger_test_t {
 public:
     explicit bigger_test_t(uint64_t _memory_limit)
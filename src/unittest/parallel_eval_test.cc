@@ -0,0 +1,149 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/batching.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/val.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+const int PARALLEL_EVAL_TEST_ROWS = 1000;
+
+static ql::datum_t numbers(int count) {
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (int i = 0; i < count; ++i) {
+        builder.add(ql::datum_t(static_cast<double>(i)));
+    }
+    return std::move(builder).to_datum();
+}
+
+// An environment for a query that was run with `parallel_eval` set to `parallel`, and
+// with the batch optargs in `batch_optargs`.
+static scoped_ptr_t<ql::env_t> make_env(
+        ql::minidriver_t *r, rdb_context_t *ctx, signal_t *interruptor, bool parallel,
+        const std::map<std::string, double> &batch_optargs) {
+    ql::global_optargs_t optargs;
+    optargs.add_optarg(r->boolean(parallel).root_term(), "parallel_eval");
+    for (const auto &pair : batch_optargs) {
+        optargs.add_optarg(r->expr(pair.second).root_term(), pair.first);
+    }
+    return make_scoped<ql::env_t>(
+        ctx, ql::return_empty_normal_batches_t::NO, interruptor, std::move(optargs),
+        auth::user_context_t(auth::permissions_t(
+            tribool::True, tribool::False, tribool::False, tribool::False)),
+        ql::datum_t(), nullptr);
+}
+
+// How many rows every other batch is limited to, so that the batches that come after
+// a larger one have less room than there are arguments ready.
+const uint64_t SMALL_BATCH_ROWS = 10;
+
+// Evaluates `term` to a stream and reads it the way the query server does, except
+// that every other batch is limited to `SMALL_BATCH_ROWS` rows.
+static std::vector<ql::datum_t> read_batches(
+        ql::env_t *env, ql::raw_term_t term, size_t *batches_out) {
+    ql::compile_env_t compile_env((ql::var_visibility_t()));
+    counted_t<const ql::term_t> compiled = ql::compile_term(&compile_env, term);
+    ql::scope_env_t scope_env(env, ql::var_scope_t());
+    counted_t<ql::datum_stream_t> stream = compiled->eval(&scope_env)->as_seq(env);
+
+    std::vector<ql::datum_t> rows;
+    for (*batches_out = 0; ; ++*batches_out) {
+        ql::batchspec_t batchspec =
+            ql::batchspec_t::user(ql::batch_type_t::NORMAL, env);
+        const bool small = *batches_out % 2 == 1;
+        if (small) {
+            batchspec = batchspec.with_at_most(SMALL_BATCH_ROWS);
+        }
+        std::vector<ql::datum_t> batch = stream->next_batch(env, batchspec);
+        if (batch.empty()) {
+            break;
+        }
+        if (small) {
+            EXPECT_GE(SMALL_BATCH_ROWS, batch.size());
+        }
+        rows.insert(rows.end(), batch.begin(), batch.end());
+    }
+    return rows;
+}
+
+// Checks that `make_term` gives the same rows in the same order whether or not the
+// query is evaluated in parallel, with the batch optargs in `batch_optargs`.
+static void check_same_rows(
+        const std::function<ql::raw_term_t(ql::minidriver_t *)> &make_term,
+        const std::map<std::string, double> &batch_optargs,
+        size_t expected_rows) {
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    rdb_context_t ctx;
+
+    size_t sequential_batches, parallel_batches;
+    scoped_ptr_t<ql::env_t> sequential_env =
+        make_env(&r, &ctx, &interruptor, false, batch_optargs);
+    std::vector<ql::datum_t> sequential = read_batches(
+        sequential_env.get(), make_term(&r), &sequential_batches);
+    scoped_ptr_t<ql::env_t> parallel_env =
+        make_env(&r, &ctx, &interruptor, true, batch_optargs);
+    std::vector<ql::datum_t> parallel = read_batches(
+        parallel_env.get(), make_term(&r), &parallel_batches);
+
+    ASSERT_EQ(expected_rows, sequential.size());
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (size_t i = 0; i < sequential.size(); ++i) {
+        ASSERT_EQ(sequential[i], parallel[i]);
+    }
+    ASSERT_LT(1u, parallel_batches);
+}
+
+// `r.expr(numbers).concatMap(x -> [x, x + 0.5])`
+static ql::raw_term_t concat_map_term(ql::minidriver_t *r) {
+    auto x = ql::minidriver_t::dummy_var_t::GROUPBY_MAP_OBJ;
+    return r->expr(numbers(PARALLEL_EVAL_TEST_ROWS))
+        .concat_map(r->fun(x, r->array(r->var(x), r->var(x) + 0.5)))
+        .root_term();
+}
+
+// `r.map(numbers, numbers, (x, y) -> [x, y, ...])`, whose results are much larger
+// than its arguments.
+static ql::raw_term_t multi_stream_map_term(ql::minidriver_t *r) {
+    auto x = ql::minidriver_t::dummy_var_t::GROUPBY_REDUCE_A;
+    auto y = ql::minidriver_t::dummy_var_t::GROUPBY_REDUCE_B;
+    return r->expr(numbers(PARALLEL_EVAL_TEST_ROWS))
+        .map(r->expr(numbers(PARALLEL_EVAL_TEST_ROWS)),
+             r->fun(x, y, r->array(r->var(x), r->var(y), r->var(x), r->var(y),
+                                   r->var(x), r->var(y), r->var(x), r->var(y))))
+        .root_term();
+}
+
+TPTEST(ParallelEval, ConcatMap, 4) {
+    check_same_rows(&concat_map_term, {{"max_batch_rows", 300}},
+                    2 * PARALLEL_EVAL_TEST_ROWS);
+}
+
+TPTEST(ParallelEval, MultiStreamMapRowLimit, 4) {
+    check_same_rows(&multi_stream_map_term,
+                    {{"max_batch_rows", 300}, {"min_batch_rows", 1}},
+                    PARALLEL_EVAL_TEST_ROWS);
+}
+
+TPTEST(ParallelEval, MultiStreamMapSizeLimit, 4) {
+    // The results are several times larger than the arguments, so only part of the
+    // arguments that are ready fit in a batch.  The rest must carry over, in order,
+    // to the following batches.
+    check_same_rows(&multi_stream_map_term,
+                    {{"max_batch_bytes", 2000}, {"min_batch_rows", 1}},
+                    PARALLEL_EVAL_TEST_ROWS);
+}
+
+}  // namespace unittest
@@ -5,8 +5,10 @@
 
 #include <cmath>  // for std::isnan -- read the comment below.
 
+#include "perfmon/openmetrics.hpp"
 #include "perfmon/perfmon.hpp"
 #include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -57,4 +59,97 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, HistogramBuckets) {
+    using namespace perfmon_histogram;  // NOLINT(build/namespaces)
+
+    // Every value goes into a bucket whose bounds are within 1/8th of the value, and
+    // the buckets are in ascending order.
+    size_t last_index = 0;
+    for (uint64_t value = 0; value < 100000; value = value * 1.01 + 1) {
+        size_t index = bucket_index(value);
+        ASSERT_LT(index, num_buckets);
+        EXPECT_LE(last_index, index);
+        EXPECT_LE(value, bucket_upper_bound(index));
+        EXPECT_LE(bucket_upper_bound(index), value + value / 8);
+        if (index > 0) {
+            EXPECT_GT(value, bucket_upper_bound(index - 1));
+        }
+        last_index = index;
+    }
+    EXPECT_EQ(num_buckets - 1, bucket_index(UINT64_MAX));
+}
+
+TEST(PerfmonTest, HistogramPercentiles) {
+    perfmon_histogram::stats_t stats;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        stats.record(value);
+    }
+    EXPECT_EQ(1000u, stats.count);
+    EXPECT_EQ(1000u, stats.max);
+    EXPECT_EQ(1000u, stats.percentile(1.0));
+    EXPECT_NEAR(500, stats.percentile(0.5), 500 / 8);
+    EXPECT_NEAR(990, stats.percentile(0.99), 990 / 8);
+
+    // Going through the output and back gives the same histogram, which is how the
+    // `stats` table combines the histograms of several servers.
+    perfmon_histogram::stats_t combined;
+    combined.aggregate_datum(stats.to_datum(true));
+    combined.aggregate_datum(stats.to_datum(true));
+    EXPECT_EQ(2000u, combined.count);
+    EXPECT_EQ(1000u, combined.max);
+    EXPECT_EQ(stats.percentile(0.5), combined.percentile(0.5));
+    EXPECT_EQ(stats.percentile(0.99), combined.percentile(0.99));
+}
+
+TPTEST(PerfmonTest, KeyedRateMonitor) {
+    perfmon_keyed_rate_monitor_t rates(secs_to_ticks(1000));
+    uuid_u a = generate_uuid();
+    uuid_u b = generate_uuid();
+    rates.record(a);
+    rates.record(a);
+    rates.record(b, 3);
+
+    // All of the events were recorded on this thread, so the other threads don't
+    // have to be visited.
+    void *data = rates.begin_stats();
+    rates.visit_stats(data);
+    ql::datum_t res = rates.end_stats(data);
+    ASSERT_EQ(ql::datum_t::R_OBJECT, res.get_type());
+    EXPECT_EQ(2u, res.obj_size());
+    EXPECT_DOUBLE_EQ(2.0 / 1000, res.get_field(uuid_to_str(a).c_str()).as_num());
+    EXPECT_DOUBLE_EQ(3.0 / 1000, res.get_field(uuid_to_str(b).c_str()).as_num());
+}
+
+TEST(PerfmonTest, OpenMetrics) {
+    perfmon_histogram::stats_t latency;
+    latency.record(2000);
+
+    ql::datum_object_builder_t query_engine;
+    query_engine.overwrite("queries_total", ql::datum_t(3.0));
+    query_engine.overwrite("query_latency", latency.to_datum(true));
+    ql::datum_object_builder_t shard;
+    shard.overwrite("blocks_written", ql::datum_t(0.5));
+    ql::datum_object_builder_t serializers;
+    serializers.overwrite("shard_0", std::move(shard).to_datum());
+    ql::datum_object_builder_t table;
+    table.overwrite("serializers", std::move(serializers).to_datum());
+    ql::datum_object_builder_t stats;
+    stats.overwrite("query_engine", std::move(query_engine).to_datum());
+    stats.overwrite("9a4c0d4a-6e4e-4dc5-8a1b-0e3ba1c1b3a7", std::move(table).to_datum());
+
+    std::string res = perfmon_stats_to_openmetrics(std::move(stats).to_datum());
+    EXPECT_NE(std::string::npos,
+              res.find("# TYPE rethinkdb_query_engine_queries_total gauge\n"
+                       "rethinkdb_query_engine_queries_total 3\n"));
+    EXPECT_NE(std::string::npos,
+              res.find("rethinkdb_serializers_blocks_written"
+                       "{table=\"9a4c0d4a-6e4e-4dc5-8a1b-0e3ba1c1b3a7\","
+                       "shard=\"0\"} 0.5\n"));
+    EXPECT_NE(std::string::npos,
+              res.find("# TYPE rethinkdb_query_engine_query_latency_seconds summary\n"));
+    EXPECT_NE(std::string::npos,
+              res.find("rethinkdb_query_engine_query_latency_seconds_count 1\n"));
+    EXPECT_EQ(res.size() - 6, res.find("# EOF\n"));
+}
+
 }  // namespace unittest
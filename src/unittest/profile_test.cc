@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/profile.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(ProfileTest, EventLog) {
+    profile::trace_t trace;
+    {
+        profile::starter_t outer("Outer.", &trace);
+        {
+            profile::sampler_t sampler("Sampled.", &trace);
+            for (int i = 0; i < 3; ++i) {
+                {
+                    profile::starter_t inner("Inner.", &trace);
+                }
+                sampler.new_sample();
+            }
+        }
+        {
+            profile::splitter_t splitter(&trace);
+            profile::event_log_t shard_log;
+            shard_log.push_back(profile::start_t("Shard."));
+            shard_log.push_back(profile::stop_t());
+            shard_log.push_back(profile::stop_t());
+            splitter.give_splits(1, shard_log);
+        }
+    }
+
+    profile::event_log_t log = std::move(trace).extract_event_log();
+    ASSERT_EQ(7u, log.size());
+
+    const profile::start_t *outer = boost::get<profile::start_t>(&log[0]);
+    ASSERT_TRUE(outer != nullptr);
+    EXPECT_EQ("Outer.", outer->description_);
+
+    // The samples themselves don't show up, only their summary.
+    const profile::sample_t *sample = boost::get<profile::sample_t>(&log[1]);
+    ASSERT_TRUE(sample != nullptr);
+    EXPECT_EQ("Sampled.", sample->description_);
+    EXPECT_EQ(3u, sample->n_samples_);
+
+    const profile::split_t *split = boost::get<profile::split_t>(&log[2]);
+    ASSERT_TRUE(split != nullptr);
+    EXPECT_EQ(1u, split->n_parallel_jobs_);
+
+    const profile::start_t *shard = boost::get<profile::start_t>(&log[3]);
+    ASSERT_TRUE(shard != nullptr);
+    EXPECT_EQ("Shard.", shard->description_);
+
+    for (size_t i = 4; i < log.size(); ++i) {
+        EXPECT_TRUE(boost::get<profile::stop_t>(&log[i]) != nullptr);
+    }
+    const profile::stop_t *outer_stop = boost::get<profile::stop_t>(&log[6]);
+    EXPECT_LE(outer->when_.nanos, outer_stop->when_.nanos);
+
+    // The trace is left empty.
+    EXPECT_TRUE(std::move(trace).extract_event_log().empty());
+}
+
+}  // namespace unittest
@@ -0,0 +1,53 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include "rapidjson/document.h"
+#include "rdb_protocol/query_cache.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/term_storage.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Compiles the term `term_json` like `query_cache_t::compile()` does, and returns
+// whether the query's results could be reused.
+static bool query_results_cacheable(const std::string &term_json) {
+    std::string query = strprintf("[%d, %s]", Query::START, term_json.c_str());
+    scoped_array_t<char> buffer(query.size() + 1);
+    memcpy(buffer.data(), query.c_str(), query.size() + 1);
+    rapidjson::Document doc;
+    doc.ParseInsitu(buffer.data());
+    guarantee(!doc.HasParseError());
+    ql::json_term_storage_t storage(std::move(buffer), std::move(doc));
+    storage.preprocess();
+
+    ql::compile_env_t compile_env((ql::var_visibility_t()));
+    counted_t<const ql::term_t> term_tree =
+        ql::compile_term(&compile_env, storage.root_term());
+    return ql::query_cache_t::results_cacheable(storage.root_term(), term_tree);
+}
+
+TPTEST(QueryCacheTest, ResultsCacheable) {
+    // `r.table("t").filter({"a": 1}).count()`
+    EXPECT_TRUE(query_results_cacheable(
+        strprintf("[%d, [[%d, [[%d, [\"t\"]], {\"a\": 1}]]]]",
+                  Term::COUNT, Term::FILTER, Term::TABLE)));
+    // `r.expr(1).add(2)`
+    EXPECT_TRUE(query_results_cacheable(strprintf("[%d, [1, 2]]", Term::ADD)));
+
+    // Non-deterministic terms anywhere in the query.
+    EXPECT_FALSE(query_results_cacheable(strprintf("[%d, []]", Term::NOW)));
+    EXPECT_FALSE(query_results_cacheable(strprintf("[%d, []]", Term::UUID)));
+    EXPECT_FALSE(query_results_cacheable(
+        strprintf("[%d, [1, [%d, [1, 10]]]]", Term::ADD, Term::RANDOM)));
+    EXPECT_FALSE(query_results_cacheable(
+        strprintf("[%d, [[%d, [\"t\"]], {\"a\": [%d, [\"1\"]]}]]",
+                  Term::FILTER, Term::TABLE, Term::JAVASCRIPT)));
+
+    // Writes.
+    EXPECT_FALSE(query_results_cacheable(
+        strprintf("[%d, [[%d, [\"t\"]], {\"a\": 1}]]", Term::INSERT, Term::TABLE)));
+}
+
+}  // namespace unittest
@@ -0,0 +1,33 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_memory.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(QueryMemory, Reservation) {
+    const uint64_t old_limit = ql::get_query_memory_limit();
+    ql::set_query_memory_limit(1000);
+    {
+        ql::query_memory_reservation_t a;
+        ql::query_memory_reservation_t b;
+        ASSERT_TRUE(a.add(600));
+        // `b` doesn't fit next to `a`, and a failed `add()` doesn't reserve anything.
+        ASSERT_FALSE(b.add(500));
+        ASSERT_EQ(0u, b.bytes());
+        ASSERT_TRUE(b.add(400));
+        ASSERT_FALSE(b.add(1));
+
+        a.reset();
+        ASSERT_EQ(0u, a.bytes());
+        ASSERT_TRUE(b.add(600));
+        ASSERT_EQ(1000u, b.bytes());
+    }
+    // Destroying the reservations gave everything back.
+    {
+        ql::query_memory_reservation_t c;
+        ASSERT_TRUE(c.add(1000));
+    }
+    ql::set_query_memory_limit(old_limit);
+}
+
+}  // namespace unittest
@@ -0,0 +1,82 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <string>
+
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/new_semaphore.hpp"
+#include "rapidjson/document.h"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/query_cache.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/query_server.hpp"
+#include "rdb_protocol/term_storage.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// The parameters of the START query `r.expr(1).add(2)` with the global optargs in
+// `optargs_json`.
+static scoped_ptr_t<ql::query_params_t> make_query_params(
+        ql::query_cache_t *query_cache, const std::string &optargs_json) {
+    std::string query = strprintf("[%d, [%d, [1, 2]], %s]",
+                                  Query::START, Term::ADD, optargs_json.c_str());
+    scoped_array_t<char> buffer(query.size() + 1);
+    memcpy(buffer.data(), query.c_str(), query.size() + 1);
+    rapidjson::Document doc;
+    doc.ParseInsitu(buffer.data());
+    guarantee(!doc.HasParseError());
+    return make_scoped<ql::query_params_t>(
+        1, query_cache,
+        scoped_ptr_t<ql::term_storage_t>(
+            new ql::json_term_storage_t(std::move(buffer), std::move(doc))));
+}
+
+TPTEST(QueryServerTest, LowPrioritySlots) {
+    rdb_context_t ctx;
+    ql::query_cache_t query_cache(
+        &ctx, ip_and_port_t(ip_address_t::any(AF_INET), port_t(0)),
+        ql::return_empty_normal_batches_t::NO,
+        auth::user_context_t(auth::permissions_t(
+            tribool::True, tribool::False, tribool::False, tribool::False)));
+    scoped_ptr_t<ql::query_params_t> normal = make_query_params(&query_cache, "{}");
+    scoped_ptr_t<ql::query_params_t> not_low =
+        make_query_params(&query_cache, "{\"low_priority\": false}");
+    scoped_ptr_t<ql::query_params_t> low =
+        make_query_params(&query_cache, "{\"low_priority\": true}");
+    EXPECT_FALSE(normal->low_priority);
+    EXPECT_FALSE(not_low->low_priority);
+    ASSERT_TRUE(low->low_priority);
+
+    cond_t non_interruptor;
+    new_semaphore_t slots(2);
+    new_semaphore_in_line_t first, second, third;
+    wait_for_low_priority_slot(*low, &slots, &first, &non_interruptor);
+    wait_for_low_priority_slot(*low, &slots, &second, &non_interruptor);
+
+    // The slots are taken, so a third low priority query has to wait.
+    cond_t third_started;
+    coro_t::spawn_sometime([&]() {
+        wait_for_low_priority_slot(*low, &slots, &third, &non_interruptor);
+        third_started.pulse();
+    });
+    let_stuff_happen();
+    EXPECT_FALSE(third_started.is_pulsed());
+
+    // Other queries don't wait for the slots, and don't take one.
+    for (ql::query_params_t *params : {normal.get(), not_low.get()}) {
+        new_semaphore_in_line_t slot;
+        wait_for_low_priority_slot(*params, &slots, &slot, &non_interruptor);
+        EXPECT_FALSE(slot.has_semaphore());
+    }
+    EXPECT_FALSE(third_started.is_pulsed());
+
+    // Once a low priority query is done, the next one gets its slot.
+    first.reset();
+    third_started.wait_lazily_unordered();
+    EXPECT_EQ(2, slots.current());
+}
+
+}  // namespace unittest
@@ -1,5 +1,6 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include <functional>
+#include <set>
 
 #include "arch/io/disk.hpp"
 #include "arch/runtime/coroutines.hpp"
@@ -177,6 +178,59 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
     return *groups;
 }
 
+void delete_rows_except_every(int start, int finish, int step, store_t *store) {
+    for (int i = start; i < finish; ++i) {
+        if (i % step == 0) {
+            continue;
+        }
+        cond_t dummy_interruptor;
+        scoped_ptr_t<txn_t> txn;
+        {
+            scoped_ptr_t<real_superblock_t> superblock;
+            write_token_t token;
+            store->new_write_token(&token);
+            store->acquire_superblock_for_write(
+                1, write_durability_t::SOFT,
+                &token, &txn, &superblock, &dummy_interruptor);
+
+            store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
+            rdb_modification_report_t mod_report(pk);
+            rdb_live_deletion_context_t deletion_context;
+            point_delete_response_t response;
+            rdb_delete(pk, store->btree.get(), repli_timestamp_t::distant_past,
+                       superblock.get(), &deletion_context, delete_mode_t::ERASE,
+                       &response, &mod_report.info,
+                       static_cast<profile::trace_t *>(NULL));
+        }
+        txn->commit();
+    }
+}
+
+/* Returns the ids of the rows that `rdb_sample_get()` picks, and checks that none of
+them is picked twice. */
+std::set<int> sample_ids(store_t *store, size_t n) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> super_block;
+    store->acquire_superblock_for_read(
+            &token, &txn, &super_block,
+            &dummy_interruptor, true);
+
+    sample_read_response_t res;
+    rdb_sample_get(super_block.get(), key_range_t::universe(), n,
+                   &dummy_interruptor, &res);
+
+    std::set<int> ids;
+    for (const ql::datum_t &row : res.rows) {
+        ids.insert(static_cast<int>(row.get_field("id").as_num()));
+    }
+    EXPECT_EQ(res.rows.size(), ids.size());
+    return ids;
+}
+
 void _check_keys_are_present(store_t *store,
         sindex_name_t sindex_name) {
     ql::configured_limits_t limits;
@@ -456,4 +510,64 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
     store.reset();
 }
 
+TPTEST(RDBBtree, Sample) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1});
+
+    EXPECT_TRUE(sample_ids(&store, 10).empty());
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+    for (size_t n : {1, 2, 10, 100}) {
+        for (int i = 0; i < 10; ++i) {
+            std::set<int> ids = sample_ids(&store, n);
+            EXPECT_EQ(n, ids.size());
+            EXPECT_LE(0, *ids.begin());
+            EXPECT_GT(TOTAL_KEYS_TO_INSERT, *ids.rbegin());
+        }
+    }
+    EXPECT_EQ(static_cast<size_t>(TOTAL_KEYS_TO_INSERT),
+              sample_ids(&store, 2 * TOTAL_KEYS_TO_INSERT).size());
+
+    // Most of the ranges that the sample picks rows from are empty now, but it
+    // must still return as many rows as it was asked for.
+    delete_rows_except_every(0, TOTAL_KEYS_TO_INSERT, 100, &store);
+    for (size_t n : {1, 2, 5, 10}) {
+        for (int i = 0; i < 10; ++i) {
+            std::set<int> ids = sample_ids(&store, n);
+            EXPECT_EQ(n, ids.size());
+            for (int id : ids) {
+                EXPECT_EQ(0, id % 100);
+            }
+        }
+    }
+    EXPECT_EQ(10u, sample_ids(&store, 20).size());
+}
+
 } //namespace unittest
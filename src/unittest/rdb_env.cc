@@ -124,6 +124,11 @@ void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(
     throw cannot_perform_query_exc_t("unimplemented", query_state_t::FAILED);
 }
 
+void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(
+        UNUSED const sample_read_t &sr) {
+    throw cannot_perform_query_exc_t("unimplemented", query_state_t::FAILED);
+}
+
 mock_namespace_interface_t::read_visitor_t::read_visitor_t(
         mock_namespace_interface_t *_parent,
         read_response_t *_response) :
@@ -419,6 +424,7 @@ bool test_rdb_env_t::instance_t::table_create(
         UNUSED const table_generate_config_params_t &config_params,
         UNUSED const std::string &primary_key,
         UNUSED write_durability_t durability,
+        UNUSED uint32_t block_size,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -603,6 +609,7 @@ bool test_rdb_env_t::instance_t::table_rebalance(
         UNUSED auth::user_context_t const &user_context,
         UNUSED counted_t<const ql::db_t> db,
         UNUSED const name_string_t &name,
+        UNUSED rebalance_mode_t mode,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -615,6 +622,7 @@ bool test_rdb_env_t::instance_t::table_rebalance(
 bool test_rdb_env_t::instance_t::db_rebalance(
         UNUSED auth::user_context_t const &user_context,
         UNUSED counted_t<const ql::db_t> db,
+        UNUSED rebalance_mode_t mode,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
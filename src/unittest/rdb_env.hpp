@@ -84,6 +84,7 @@ private:
         void NORETURN operator()(UNUSED const intersecting_geo_read_t &gr);
         void NORETURN operator()(UNUSED const nearest_geo_read_t &gr);
         void NORETURN operator()(UNUSED const distribution_read_t &dg);
+        void NORETURN operator()(UNUSED const sample_read_t &sr);
 
         read_visitor_t(mock_namespace_interface_t *parent, read_response_t *_response);
 
@@ -191,6 +192,7 @@ public:
                 const table_generate_config_params_t &config_params,
                 const std::string &primary_key,
                 write_durability_t durability,
+                uint32_t block_size,
                 signal_t *interruptor,
                 ql::datum_t *result_out,
                 admin_err_t *error_out);
@@ -277,12 +279,14 @@ public:
                 auth::user_context_t const &user_context,
                 counted_t<const ql::db_t> db,
                 const name_string_t &name,
+                rebalance_mode_t mode,
                 signal_t *interruptor,
                 ql::datum_t *result_out,
                 admin_err_t *error_out);
         bool db_rebalance(
                 auth::user_context_t const &user_context,
                 counted_t<const ql::db_t> db,
+                rebalance_mode_t mode,
                 signal_t *interruptor,
                 ql::datum_t *result_out,
                 admin_err_t *error_out);
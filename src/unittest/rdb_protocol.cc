@@ -12,9 +12,11 @@
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/datum_stream/readers.hpp"
 #include "rdb_protocol/datum_stream/vector.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/real_table.hpp"
 #include "rdb_protocol/store.hpp"
 #include "rpc/directory/read_manager.hpp"
 #include "rpc/semilattice/semilattice_manager.hpp"
@@ -881,6 +883,133 @@ TEST(RDBProtocol, OvershardedMissingAttr) {
     run_in_thread_pool_with_namespace_interface(&run_sindex_missing_attr_test, true);
 }
 
+class dummy_ref_tracker_t : public namespace_interface_access_t::ref_tracker_t {
+    void add_ref() { }
+    void release() { }
+};
+
+// Inserts the rows `{id: 0}` to `{id: num_rows - 1}`, and returns a table for them.
+counted_t<real_table_t> make_numbered_table(
+        namespace_interface_t *nsi, order_source_t *osource, int num_rows) {
+    ql::configured_limits_t limits;
+    for (int i = 0; i < num_rows; ++i) {
+        ql::datum_object_builder_t builder;
+        builder.overwrite("id", ql::datum_t(static_cast<double>(i)));
+        ql::datum_t row = std::move(builder).to_datum();
+        write_t write(point_write_t(store_key_t(row.get_field("id").print_primary()),
+                                    row),
+                      DURABILITY_REQUIREMENT_DEFAULT,
+                      profile_bool_t::DONT_PROFILE,
+                      limits);
+        write_response_t response;
+        cond_t interruptor;
+        nsi->write(
+            auth::user_context_t(auth::permissions_t(
+                tribool::True, tribool::True, tribool::False, tribool::False)),
+            write,
+            &response,
+            osource->check_in("unittest::make_numbered_table(rdb_protocol.cc)"),
+            &interruptor);
+    }
+    static dummy_ref_tracker_t ref_tracker;
+    return make_counted<real_table_t>(
+        nil_uuid(),
+        namespace_interface_access_t(nsi, &ref_tracker, get_thread_id()),
+        "id",
+        nullptr,
+        nullptr);
+}
+
+scoped_ptr_t<ql::reader_t> read_all_in_order(
+        ql::env_t *env, const counted_t<real_table_t> &table) {
+    return table->read_all_with_sindexes(
+        env, "id", ql::backtrace_id_t::empty(), "test",
+        ql::datumspec_t(ql::datum_range_t::universe()), sorting_t::ASCENDING,
+        read_mode_t::SINGLE);
+}
+
+const ql::batchspec_t terminal_batchspec = ql::batchspec_t::all()
+    .with_new_batch_type(ql::batch_type_t::TERMINAL).with_at_most(7);
+const ql::batchspec_t normal_batchspec = ql::batchspec_t::all()
+    .with_new_batch_type(ql::batch_type_t::NORMAL).with_at_most(5);
+
+/* `RangeReadPrefetch` reads a table in terminal batches, which prefetch the next
+batch, mixed with normal batches, which drop the prefetched read. */
+void run_range_read_prefetch_test(
+        namespace_interface_t *nsi,
+        order_source_t *osource,
+        const std::vector<scoped_ptr_t<store_t> > *) {
+    const int num_rows = 100;
+    counted_t<real_table_t> table = make_numbered_table(nsi, osource, num_rows);
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+
+    {
+        scoped_ptr_t<ql::reader_t> reader = read_all_in_order(&env, table);
+        std::vector<ql::datum_t> rows;
+        for (size_t batch = 0; !reader->is_finished(); ++batch) {
+            std::vector<ql::datum_t> got = reader->next_batch(
+                &env, batch % 3 == 2 ? normal_batchspec : terminal_batchspec);
+            rows.insert(rows.end(), got.begin(), got.end());
+        }
+        // The prefetched reads neither skip nor repeat rows.
+        ASSERT_EQ(static_cast<size_t>(num_rows), rows.size());
+        for (int i = 0; i < num_rows; ++i) {
+            EXPECT_EQ(ql::datum_t(static_cast<double>(i)), rows[i].get_field("id"));
+        }
+    }
+
+    {
+        // Destroying the reader while a prefetched read is running must stop it.
+        scoped_ptr_t<ql::reader_t> reader = read_all_in_order(&env, table);
+        ASSERT_EQ(7u, reader->next_batch(&env, terminal_batchspec).size());
+        ASSERT_FALSE(reader->is_finished());
+    }
+}
+
+TEST(RDBProtocol, RangeReadPrefetch) {
+    run_in_thread_pool_with_namespace_interface(&run_range_read_prefetch_test, false);
+}
+
+TEST(RDBProtocol, OvershardedRangeReadPrefetch) {
+    run_in_thread_pool_with_namespace_interface(&run_range_read_prefetch_test, true);
+}
+
+/* `RangeReadUsage` checks that the reads of a query count towards its
+`ql::query_usage_t`, whether they were prefetched or not. */
+void run_range_read_usage_test(
+        namespace_interface_t *nsi,
+        order_source_t *osource,
+        const std::vector<scoped_ptr_t<store_t> > *) {
+    const int num_rows = 100;
+    counted_t<real_table_t> table = make_numbered_table(nsi, osource, num_rows);
+    cond_t interruptor;
+    for (const ql::batchspec_t &batchspec : {normal_batchspec, terminal_batchspec}) {
+        ql::env_t env(&interruptor,
+                      ql::return_empty_normal_batches_t::NO,
+                      reql_version_t::LATEST);
+        ql::query_usage_t usage;
+        env.set_usage(&usage);
+        scoped_ptr_t<ql::reader_t> reader = read_all_in_order(&env, table);
+        size_t rows = 0;
+        while (!reader->is_finished()) {
+            rows += reader->next_batch(&env, batchspec).size();
+        }
+        ASSERT_EQ(static_cast<size_t>(num_rows), rows);
+        // Reading the shards in order can load some rows twice.
+        EXPECT_LE(static_cast<uint64_t>(num_rows), usage.rows_scanned);
+        EXPECT_LT(1u, usage.reads);
+        EXPECT_EQ(0u, usage.writes);
+        EXPECT_EQ(0u, usage.rows_written);
+    }
+}
+
+TEST(RDBProtocol, RangeReadUsage) {
+    run_in_thread_pool_with_namespace_interface(&run_range_read_usage_test, false);
+}
+
 TPTEST(RDBProtocol, ArtificialChangefeeds) {
     using ql::changefeed::artificial_t;
     using ql::changefeed::keyspec_t;
@@ -922,6 +1051,7 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                               false,
                               ql::configured_limits_t(),
                               ql::datum_t::boolean(false),
+                              false,
                               keyspec_t::point_t{ql::datum_t(0.0)}),
                           "id",
                           std::vector<ql::datum_t>(),
@@ -937,6 +1067,7 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                                false,
                                ql::configured_limits_t(),
                                ql::datum_t::boolean(false),
+                               false,
                                keyspec_t::point_t{ql::datum_t(10.0)}),
                            "id",
                            std::vector<ql::datum_t>(),
@@ -952,6 +1083,7 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                             false,
                             ql::configured_limits_t(),
                             ql::datum_t::boolean(false),
+                            false,
                             keyspec_t::range_t{
                                 std::vector<ql::transform_variant_t>(),
                                     optional<std::string>(),
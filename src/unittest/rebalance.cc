@@ -70,4 +70,29 @@ TEST(Rebalance, MaxKeyLength) {
     do_rebalance(distribution, 3);
 }
 
+TEST(Rebalance, ByLoad) {
+    std::map<store_key_t, int64_t> distribution;
+    for (char c = 'A'; c <= 'Z'; ++c) {
+        distribution[store_key_t(std::string(1, c))] = 10;
+    }
+
+    // By documents, the split point ends up in the middle of the alphabet.
+    table_shard_scheme_t by_documents = do_rebalance(distribution, 2);
+    ASSERT_EQ(1u, by_documents.split_points.size());
+    EXPECT_LT(store_key_t("L"), by_documents.split_points[0]);
+    EXPECT_GT(store_key_t("O"), by_documents.split_points[0]);
+
+    // If all the load is on one key near the end, the shard with it gets smaller.
+    std::map<store_key_t, int64_t> loads;
+    loads[store_key_t("Yankee")] = 1000;
+    table_shard_scheme_t by_load;
+    ASSERT_TRUE(calculate_split_points_with_load(distribution, loads, 2, &by_load));
+    ASSERT_EQ(1u, by_load.split_points.size());
+    EXPECT_LT(store_key_t("X"), by_load.split_points[0]);
+
+    // Without any load, there's nothing to rebalance by.
+    EXPECT_FALSE(calculate_split_points_with_load(
+        distribution, std::map<store_key_t, int64_t>(), 2, &by_load));
+}
+
 }  // namespace unittest
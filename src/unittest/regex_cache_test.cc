@@ -0,0 +1,25 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <re2/re2.h>
+
+#include "rdb_protocol/regex_cache.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(RegexCache, SharesCompiledPatterns) {
+    std::shared_ptr<const re2::RE2> a = ql::get_cached_regex("^a(b+)c$");
+    ASSERT_TRUE(a->ok());
+    ASSERT_EQ(a.get(), ql::get_cached_regex("^a(b+)c$").get());
+    ASSERT_NE(a.get(), ql::get_cached_regex("^a(b*)c$").get());
+
+    // Patterns with errors aren't cached, so that callers see the error every time.
+    std::shared_ptr<const re2::RE2> bad = ql::get_cached_regex("a(b");
+    ASSERT_FALSE(bad->ok());
+    ASSERT_NE(bad.get(), ql::get_cached_regex("a(b").get());
+
+    const std::string long_pattern(8192, 'x');
+    ASSERT_NE(ql::get_cached_regex(long_pattern).get(),
+              ql::get_cached_regex(long_pattern).get());
+}
+
+}  // namespace unittest
@@ -452,6 +452,77 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, BinaryData, 3) {
     EXPECT_TRUE(a2.got_spectrum);
 }
 
+/* `CompressedMessage` makes sure that a message that gets compressed on the way
+arrives unchanged. */
+
+class compressible_test_application_t : public cluster_message_handler_t {
+public:
+    explicit compressible_test_application_t(connectivity_cluster_t *cm) :
+        cluster_message_handler_t(cm, 'C'),
+        got_message(false)
+        { }
+    static std::vector<char> make_message() {
+        std::vector<char> message(connectivity_cluster_t::compress_message_size * 4);
+        for (size_t i = 0; i < message.size(); ++i) {
+            message[i] = static_cast<char>(i % 7);
+        }
+        return message;
+    }
+    void send_message(peer_id_t peer) {
+        class message_writer_t : public cluster_send_message_write_callback_t {
+        public:
+            virtual ~message_writer_t() { }
+            void write(write_stream_t *stream) {
+                std::vector<char> message = make_message();
+                int64_t res = stream->write(message.data(), message.size());
+                if (res != static_cast<int64_t>(message.size())) {
+                    throw fake_archive_exc_t();
+                }
+            }
+#ifdef ENABLE_MESSAGE_PROFILER
+            const char *message_profiler_tag() const {
+                return "unittest";
+            }
+#endif
+        } writer;
+        auto_drainer_t::lock_t connection_keepalive;
+        connectivity_cluster_t::connection_t *connection =
+            get_connectivity_cluster()->get_connection(peer, &connection_keepalive);
+        ASSERT_TRUE(connection != nullptr);
+        get_connectivity_cluster()->send_message(connection, connection_keepalive,
+                                                 get_message_tag(), &writer);
+    }
+    void on_message(connectivity_cluster_t::connection_t *,
+                    auto_drainer_t::lock_t,
+                    read_stream_t *stream) {
+        std::vector<char> expected = make_message();
+        std::vector<char> message(expected.size());
+        int64_t res = force_read(stream, message.data(), message.size());
+        if (res != static_cast<int64_t>(message.size())) {
+            throw fake_archive_exc_t();
+        }
+        EXPECT_TRUE(message == expected);
+        got_message = true;
+    }
+    bool got_message;
+};
+
+TPTEST_MULTITHREAD(RPCConnectivityTest, CompressedMessage, 3) {
+    connectivity_cluster_t c1, c2;
+    compressible_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1, peer_address_t(), true);
+    test_cluster_run_t cr2(&c2, peer_address_t(), true);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    a1.send_message(c2.get_me());
+
+    let_stuff_happen();
+
+    EXPECT_TRUE(a2.got_message);
+}
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 TPTEST_MULTITHREAD(RPCConnectivityTest, PeerIDSemantics, 3) {
     peer_id_t nil_peer;
@@ -120,6 +120,39 @@ TPTEST(RPCDirectoryTest, MapUpdate) {
         rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 102)));
 }
 
+/* `MapBatchUpdate` tests that many keys that change at once all arrive, even though
+they get sent in batches. */
+TPTEST(RPCDirectoryTest, MapBatchUpdate) {
+    connectivity_cluster_t c1, c2;
+    directory_map_read_manager_t<int, int> rm1(&c1, 'D'), rm2(&c2, 'D');
+    watchable_map_var_t<int, int> w1, w2;
+    const int num_keys = 1000;
+    for (int i = 0; i < num_keys; ++i) {
+        w1.set_key(i, i);
+    }
+    directory_map_write_manager_t<int, int> wm1(&c1, 'D', &w1), wm2(&c2, 'D', &w2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr2.join(get_cluster_local_address(&c1), 0);
+    let_stuff_happen();
+    for (int i = 0; i < num_keys; ++i) {
+        ASSERT_TRUE(optional<int>(i) ==
+            rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), i)));
+    }
+    for (int i = 0; i < num_keys; ++i) {
+        if (i % 2 == 0) {
+            w1.delete_key(i);
+        } else {
+            w1.set_key(i, -i);
+        }
+    }
+    let_stuff_happen();
+    for (int i = 0; i < num_keys; ++i) {
+        ASSERT_TRUE((i % 2 == 0 ? optional<int>() : optional<int>(-i)) ==
+            rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), i)));
+    }
+}
+
 /* `DestructorRace` tests a nasty race condition that we had at some point. */
 TPTEST(RPCDirectoryTest, DestructorRace) {
     connectivity_cluster_t c;
@@ -61,6 +61,10 @@ public:
     void expect(int message) {
         EXPECT_EQ(1u, inbox.count(message));
     }
+    void expect_only(int message) {
+        EXPECT_EQ(1u, inbox.size());
+        expect(message);
+    }
     raw_mailbox_t mailbox;
 };
 
@@ -128,6 +132,30 @@ TPTEST_MULTITHREAD(RPCMailboxTest, DeadMailbox, 3) {
 
     let_stuff_happen();
 }
+
+/* `ReusedMailboxSlot` makes sure that a message for a destroyed mailbox doesn't reach
+a new mailbox that took over its slot. */
+TPTEST_MULTITHREAD(RPCMailboxTest, ReusedMailboxSlot, 3) {
+    connectivity_cluster_t c;
+    mailbox_manager_t m(&c, 'M');
+    test_cluster_run_t r(&c);
+
+    raw_mailbox_t::address_t old_address;
+    {
+        dummy_mailbox_t mbox(&m);
+        old_address = mbox.mailbox.get_address();
+    }
+    dummy_mailbox_t mbox(&m);
+    EXPECT_FALSE(mbox.mailbox.get_address() == old_address);
+
+    send(&m, old_address, 111);
+    send(&m, mbox.mailbox.get_address(), 222);
+
+    let_stuff_happen();
+
+    mbox.expect_only(222);
+}
+
 /* `MailboxAddressSemantics` makes sure that `raw_mailbox_t::address_t` behaves as
 expected. */
 TPTEST_MULTITHREAD(RPCMailboxTest, MailboxAddressSemantics, 3) {
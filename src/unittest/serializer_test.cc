@@ -1,9 +1,20 @@
+#include <string.h>
+
 #include <functional>
+#include <string>
 
+#include "arch/arch.hpp"
+#include "arch/io/disk.hpp"
 #include "arch/runtime/starter.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "perfmon/perfmon.hpp"
+#include "random.hpp"
+#include "rdb_protocol/datum.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "serializer/log/static_header.hpp"
+#include "serializer/merger.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -90,5 +101,368 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+// Runs concurrent index writes through a merger serializer with a group commit
+// window, and checks that all of them become visible and that they were grouped into
+// much fewer index writes of the inner serializer.
+TPTEST(SerializerTest, MergerGroupCommit, 4) {
+    const int NUM_WRITERS = 16;
+    const int WRITES_PER_WRITER = 20;
+
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    perfmon_collection_t stats;
+    scoped_ptr_t<serializer_t> inner(
+        new log_serializer_t(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &stats));
+    merger_serializer_t ser(std::move(inner), MERGER_SERIALIZER_MAX_ACTIVE_WRITES, 1);
+
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    pmap(NUM_WRITERS, [&](int writer) {
+        for (int i = 0; i < WRITES_PER_WRITER; ++i) {
+            const block_id_t block_id = writer * WRITES_PER_WRITER + i;
+            std::vector<buf_write_info_t> infos;
+            infos.push_back(
+                buf_write_info_t(buf.ser_buffer(), buf.block_size(), block_id));
+
+            struct : public iocallback_t, public cond_t {
+                void on_io_complete() {
+                    pulse();
+                }
+            } cb;
+            std::vector<counted_t<block_token_t>> tokens
+                = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+            cb.wait();
+
+            std::vector<index_write_op_t> write_ops;
+            write_ops.push_back(index_write_op_t(
+                block_id, make_optional(tokens[0]),
+                make_optional(repli_timestamp_t::distant_past)));
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, write_ops);
+        }
+    });
+
+    for (block_id_t id = 0; id < NUM_WRITERS * WRITES_PER_WRITER; ++id) {
+        EXPECT_TRUE(ser.index_read(id).has());
+    }
+
+    // The serializer only updates its stats on this thread.
+    void *stats_ctx = stats.begin_stats();
+    stats.visit_stats(stats_ctx);
+    const ql::datum_t serializer_stats =
+        stats.end_stats(stats_ctx).get_field("serializer");
+    const double merged_writes =
+        serializer_stats.get_field("serializer_index_writes_merged").as_num();
+    const double inner_writes = NUM_WRITERS * WRITES_PER_WRITER - merged_writes;
+    EXPECT_LT(0, inner_writes);
+    EXPECT_LT(inner_writes, NUM_WRITERS * WRITES_PER_WRITER / 2);
+}
+
+void write_blocks_and_index(serializer_t *ser, file_account_t *account,
+                            const std::vector<buf_ptr_t> &bufs) {
+    std::vector<buf_write_info_t> infos;
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        infos.push_back(
+            buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(), i));
+    }
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t>> tokens
+        = ser->block_writes(infos.data(), infos.size(), account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_EQ(bufs[i].block_size().ser_value(),
+                  tokens[i]->block_size().ser_value());
+        write_ops.push_back(index_write_op_t(
+            i, make_optional(tokens[i]),
+            make_optional(repli_timestamp_t::distant_past)));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+void check_blocks(serializer_t *ser, file_account_t *account,
+                  const std::vector<buf_ptr_t> &bufs) {
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        counted_t<block_token_t> token = ser->index_read(i);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(bufs[i].block_size().ser_value(), token->block_size().ser_value());
+        buf_ptr_t buf = ser->block_read(token, account);
+        ASSERT_EQ(bufs[i].block_size().ser_value(), buf.block_size().ser_value());
+        EXPECT_EQ(0, memcmp(bufs[i].cache_data(), buf.cache_data(),
+                            buf.block_size().value()));
+    }
+}
+
+static std::string static_header_version(mock_file_opener_t *file_opener) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    scoped_device_block_aligned_ptr_t<static_header_t> header(DEVICE_BLOCK_SIZE);
+    co_read(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT);
+    return std::string(header->version,
+                       strnlen(header->version, sizeof(header->version)));
+}
+
+// Writes compressible and incompressible blocks with compression turned on, and
+// reads them back, both with and without compression turned on.
+TPTEST(SerializerTest, CompressedBlocks, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    rng_t rng(1234);
+    std::vector<buf_ptr_t> bufs;
+    for (int i = 0; i < 8; ++i) {
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(
+            block_size_t::make_from_cache(1000 + 400 * i));
+        char *data = static_cast<char *>(buf.cache_data());
+        for (uint32_t j = 0; j < buf.block_size().value(); ++j) {
+            // Odd blocks are random and shouldn't compress.
+            data[j] = i % 2 == 0 ? "{\"id\": 1234}"[j % 12] : rng.randint(256);
+        }
+        bufs.push_back(std::move(buf));
+    }
+
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.compression = block_compression_t::zlib;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        EXPECT_EQ("2.2", static_header_version(&file_opener));
+
+        write_blocks_and_index(&ser, account.get(), bufs);
+        for (size_t i = 0; i < bufs.size(); ++i) {
+            EXPECT_EQ(i % 2 == 0, ser.index_read(i)->is_compressed());
+        }
+        check_blocks(&ser, account.get(), bufs);
+    }
+
+    // Older versions would read the compressed blocks as plain blocks, so the file
+    // must no longer have a version string that they accept.
+    EXPECT_EQ("2.3", static_header_version(&file_opener));
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        check_blocks(&ser, account.get(), bufs);
+    }
+}
+
+// Checks that a file with CRC-32C checksums can be written and opened again.  The
+// serializer only trusts the latest metablock if the checksums of the blocks it
+// refers to match, so this would lose the writes if they didn't.
+TPTEST(SerializerTest, Crc32cChecksums, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::static_config_t static_config;
+    static_config.checksum_algorithm = checksum_algorithm_t::crc32c;
+    log_serializer_t::create(&file_opener, static_config);
+
+    std::vector<buf_ptr_t> bufs;
+    for (int i = 0; i < 4; ++i) {
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(2000));
+        memset(buf.cache_data(), 'a' + i, buf.block_size().value());
+        bufs.push_back(std::move(buf));
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_blocks_and_index(&ser, account.get(), bufs);
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        check_blocks(&ser, account.get(), bufs);
+    }
+}
+
+// Checks that the block size a file is created with is kept in its static header,
+// and that blocks of that size can be written and read back.
+TPTEST(SerializerTest, LargeBlockSize, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::static_config_t static_config;
+    static_config.block_size_ = MAX_BTREE_BLOCK_SIZE;
+    log_serializer_t::create(&file_opener, static_config);
+
+    std::vector<buf_ptr_t> bufs;
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        ASSERT_EQ(MAX_BTREE_BLOCK_SIZE, ser.max_block_size().ser_value());
+        for (int i = 0; i < 4; ++i) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+            memset(buf.cache_data(), 'a' + i, buf.block_size().value());
+            bufs.push_back(std::move(buf));
+        }
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_blocks_and_index(&ser, account.get(), bufs);
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        EXPECT_EQ(MAX_BTREE_BLOCK_SIZE, ser.max_block_size().ser_value());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        check_blocks(&ser, account.get(), bufs);
+    }
+}
+
+// Writes enough index entries to spill the LBA into extents on all of its shards,
+// overwriting some of them, and checks that reopening the file reconstructs the
+// latest version of each block.  The shards are read in on different threads.
+TPTEST(SerializerTest, ReconstructShardedLba, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    const block_id_t num_blocks = 2000;
+    std::vector<buf_ptr_t> bufs;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(100));
+        memset(buf.cache_data(), 'a' + i % 26, buf.block_size().value());
+        bufs.push_back(std::move(buf));
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_blocks_and_index(&ser, account.get(), bufs);
+
+        // Overwrite the first half, so that the LBA has stale entries.
+        std::vector<buf_ptr_t> newer_bufs;
+        for (block_id_t i = 0; i < num_blocks / 2; ++i) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(100));
+            memset(buf.cache_data(), 'A' + i % 26, buf.block_size().value());
+            newer_bufs.push_back(std::move(buf));
+        }
+        write_blocks_and_index(&ser, account.get(), newer_bufs);
+        for (block_id_t i = 0; i < num_blocks / 2; ++i) {
+            bufs[i] = std::move(newer_bufs[i]);
+        }
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        EXPECT_EQ(num_blocks, ser.end_block_id());
+        check_blocks(&ser, account.get(), bufs);
+    }
+}
+
+// Updates the recencies of a few blocks often enough that the LBA garbage collector
+// replaces the LBA extents with snapshots, then deletes some of the blocks, and checks
+// that the latest state survives reopening the file.
+TPTEST(SerializerTest, LbaSnapshot, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    const block_id_t num_blocks = 64;
+    const block_id_t num_deleted = 6;
+    std::vector<buf_ptr_t> bufs;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(500));
+        memset(buf.cache_data(), 'a' + i % 26, buf.block_size().value());
+        bufs.push_back(std::move(buf));
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_blocks_and_index(&ser, account.get(), bufs);
+
+        // Every shard fills a few LBA extents with these.
+        uint64_t recency = 0;
+        for (int round = 0; round < 100; ++round) {
+            std::vector<index_write_op_t> write_ops;
+            for (int k = 0; k < 64; ++k) {
+                for (block_id_t i = 0; i < num_blocks; ++i) {
+                    write_ops.push_back(index_write_op_t(
+                        i, r_nullopt, make_optional(repli_timestamp_t{++recency})));
+                }
+            }
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, write_ops);
+        }
+
+        std::vector<index_write_op_t> delete_ops;
+        for (block_id_t i = num_blocks - num_deleted; i < num_blocks; ++i) {
+            delete_ops.push_back(index_write_op_t(
+                i, make_optional(counted_t<block_token_t>()),
+                make_optional(repli_timestamp_t::distant_past)));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, delete_ops);
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        bufs.resize(num_blocks - num_deleted);
+        check_blocks(&ser, account.get(), bufs);
+        for (block_id_t i = num_blocks - num_deleted; i < num_blocks; ++i) {
+            EXPECT_FALSE(ser.index_read(i).has());
+        }
+
+        segmented_vector_t<repli_timestamp_t> recencies = ser.get_all_recencies(0, 1);
+        const uint64_t last_round_start = 99 * 64 * num_blocks + 63 * num_blocks;
+        for (block_id_t i = 0; i < num_blocks - num_deleted; ++i) {
+            EXPECT_EQ(last_round_start + i + 1, recencies[i].longtime);
+        }
+    }
+
+    // Older versions would ignore the snapshots, so the file must say it has them.
+    EXPECT_EQ("2.2-snap", static_header_version(&file_opener));
+}
+
+// Reads blocks through memory-mapped extents, including blocks that were rewritten
+// after their extent had been mapped.  This needs a real file, since the mock file
+// can't be mapped.
+TPTEST(SerializerTest, MmapReads, 4) {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::direct_desired);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    log_serializer_t::dynamic_config_t config;
+    config.mmap_reads = true;
+    log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    for (int round = 0; round < 3; ++round) {
+        std::vector<buf_ptr_t> bufs;
+        for (int i = 0; i < 16; ++i) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(
+                block_size_t::make_from_cache(700 + 300 * i));
+            memset(buf.cache_data(), 'a' + round, buf.block_size().value());
+            bufs.push_back(std::move(buf));
+        }
+        write_blocks_and_index(&ser, account.get(), bufs);
+        check_blocks(&ser, account.get(), bufs);
+    }
+}
 
 }  // namespace unittest
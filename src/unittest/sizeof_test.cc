@@ -2,6 +2,7 @@
 #include "unittest/gtest.hpp"
 
 #include "buffer_cache/alt.hpp"
+#include "buffer_cache/page_cache.hpp"
 #include "serializer/log/log_serializer.hpp"
 
 namespace unittest {
@@ -20,4 +21,12 @@ TEST(SizeofTest, SerBuffer) {
     EXPECT_EQ(8u, offsetof(ser_buffer_t, cache_data));
 }
 
+TEST(SizeofTest, CachedPage) {
+    // Every block in the cache has one of each, so these shouldn't grow by accident.
+    // The limits are for 64-bit pointers.
+    EXPECT_GE(96u, sizeof(alt::current_page_t));
+    EXPECT_GE(72u, sizeof(alt::page_t));
+    EXPECT_EQ(4u, sizeof(backindex_bag_index_t));
+}
+
 }  // namespace unittest
@@ -0,0 +1,55 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <math.h>
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/sketches.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(Sketches, HllCountDistinct) {
+    ql::hll_sketch_t empty;
+    ASSERT_EQ(0u, empty.estimate());
+
+    // Two shards that see overlapping values twice each.
+    ql::hll_sketch_t a, b;
+    for (int rep = 0; rep < 2; ++rep) {
+        for (int i = 0; i < 60000; ++i) {
+            a.add(ql::datum_t(static_cast<double>(i)));
+        }
+        for (int i = 40000; i < 100000; ++i) {
+            b.add(ql::datum_t(static_cast<double>(i)));
+        }
+    }
+    b.merge(empty);
+    a.merge(b);
+    const double estimate = a.estimate();
+    ASSERT_LT(fabs(estimate - 100000) / 100000, 0.05);
+
+    ql::hll_sketch_t small;
+    for (int i = 0; i < 100; ++i) {
+        small.add(ql::datum_t(static_cast<double>(i % 10)));
+    }
+    ASSERT_EQ(10u, small.estimate());
+}
+
+TEST(Sketches, TdigestQuantiles) {
+    // Two shards that see alternating values of 0 ... 99999.
+    ql::tdigest_t a, b;
+    for (int i = 0; i < 100000; ++i) {
+        (i % 2 == 0 ? a : b).add(i);
+    }
+    a.merge(b);
+    ASSERT_LT(a.centroids.size() + a.unmerged.size(), 200u);
+    ASSERT_EQ(0, a.quantile(0));
+    ASSERT_EQ(99999, a.quantile(1));
+    ASSERT_LT(fabs(a.quantile(0.5) - 50000), 500);
+    ASSERT_LT(fabs(a.quantile(0.99) - 99000), 100);
+    ASSERT_LT(fabs(a.quantile(0.001) - 100), 10);
+
+    ql::tdigest_t single;
+    single.add(7);
+    ASSERT_EQ(7, single.quantile(0.3));
+}
+
+}  // namespace unittest
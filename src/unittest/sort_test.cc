@@ -0,0 +1,187 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/batching.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/val.hpp"
+#include "unittest/dummy_metadata_controller.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Small enough that the test rows take several sorted runs.
+const double SORT_TEST_ARRAY_LIMIT = 5;
+const double SORT_TEST_BATCH_ROWS = 2;
+const int SORT_TEST_ROWS = 14;
+
+// The row at position `p` of the input, with a sort key that repeats and an id that
+// tells the rows with the same key apart.
+static ql::datum_t test_row(int p) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", ql::datum_t(static_cast<double>((p * 5) % SORT_TEST_ROWS)));
+    builder.overwrite("k", ql::datum_t(static_cast<double>(p % 3)));
+    return std::move(builder).to_datum();
+}
+
+static ql::datum_t test_rows() {
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (int p = 0; p < SORT_TEST_ROWS; ++p) {
+        builder.add(test_row(p));
+    }
+    return std::move(builder).to_datum();
+}
+
+static scoped_ptr_t<ql::env_t> make_env(
+        ql::minidriver_t *r, rdb_context_t *ctx, signal_t *interruptor,
+        const std::map<std::string, double> &optarg_values) {
+    ql::global_optargs_t optargs;
+    for (const auto &pair : optarg_values) {
+        optargs.add_optarg(r->expr(pair.second).root_term(), pair.first);
+    }
+    return make_scoped<ql::env_t>(
+        ctx, ql::return_empty_normal_batches_t::NO, interruptor, std::move(optargs),
+        auth::user_context_t(auth::permissions_t(
+            tribool::True, tribool::False, tribool::False, tribool::False)),
+        ql::datum_t(), nullptr);
+}
+
+// Evaluates `term` to a stream and reads it in batches, so that we don't build an
+// array that goes over the array size limit.
+static std::vector<ql::datum_t> read_all(ql::env_t *env, ql::raw_term_t term) {
+    ql::compile_env_t compile_env((ql::var_visibility_t()));
+    counted_t<const ql::term_t> compiled = ql::compile_term(&compile_env, term);
+    ql::scope_env_t scope_env(env, ql::var_scope_t());
+    counted_t<ql::datum_stream_t> stream = compiled->eval(&scope_env)->as_seq(env);
+    std::vector<ql::datum_t> rows;
+    for (;;) {
+        std::vector<ql::datum_t> batch = stream->next_batch(
+            env, ql::batchspec_t::user(ql::batch_type_t::NORMAL, env));
+        if (batch.empty()) {
+            break;
+        }
+        rows.insert(rows.end(), batch.begin(), batch.end());
+    }
+    return rows;
+}
+
+TPTEST(SortTest, OrderBySpillsSortedRuns) {
+    temp_directory_t temp_dir;
+    recreate_temporary_directory(temp_dir.path());
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(nullptr, nullptr, nullptr, auth_manager.get_view(),
+                      &get_global_perfmon_collection(), std::string(), &io_backender,
+                      temp_dir.path(), 0);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    scoped_ptr_t<ql::env_t> env = make_env(
+        &r, &ctx, &interruptor,
+        {{"array_limit", SORT_TEST_ARRAY_LIMIT},
+         {"max_batch_rows", SORT_TEST_BATCH_ROWS}});
+
+    // There are more rows than the array size limit, so `orderBy` has to merge
+    // runs from disk.  Rows with the same key keep their order, even when they
+    // come from different runs.
+    std::vector<ql::datum_t> sorted = read_all(
+        env.get(), r.expr(test_rows()).call(Term::ORDER_BY, std::string("k"))
+                       .root_term());
+    std::vector<ql::datum_t> expected;
+    for (int k = 0; k < 3; ++k) {
+        for (int p = k; p < SORT_TEST_ROWS; p += 3) {
+            expected.push_back(test_row(p));
+        }
+    }
+    ASSERT_EQ(expected.size(), sorted.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], sorted[i]);
+    }
+}
+
+TPTEST(SortTest, OrderByWithoutDataDirectory) {
+    // Without a data directory `orderBy` can't spill, so it still fails.
+    rdb_context_t ctx;
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    scoped_ptr_t<ql::env_t> env = make_env(
+        &r, &ctx, &interruptor, {{"array_limit", SORT_TEST_ARRAY_LIMIT}});
+    EXPECT_THROW(
+        read_all(env.get(), r.expr(test_rows()).call(Term::ORDER_BY, std::string("k"))
+                                .root_term()),
+        ql::base_exc_t);
+}
+
+TPTEST(SortTest, OrderByLimitKeepsTopRows) {
+    // `orderBy(...).limit(n)` only keeps `n` rows, so it doesn't need a data
+    // directory to sort more rows than the array size limit.
+    rdb_context_t ctx;
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    scoped_ptr_t<ql::env_t> env = make_env(
+        &r, &ctx, &interruptor,
+        {{"array_limit", SORT_TEST_ARRAY_LIMIT},
+         {"max_batch_rows", SORT_TEST_BATCH_ROWS}});
+    for (int n : {0, 1, 4, 5}) {
+        std::vector<ql::datum_t> top = read_all(
+            env.get(), r.expr(test_rows())
+                           .call(Term::ORDER_BY, std::string("k"))
+                           .call(Term::LIMIT, r.expr(static_cast<double>(n)))
+                           .root_term());
+        // The ties at the end of the limit are broken by the input order, like in
+        // a full sort.
+        std::vector<ql::datum_t> expected;
+        for (int k = 0; k < 3; ++k) {
+            for (int p = k; p < SORT_TEST_ROWS; p += 3) {
+                if (expected.size() < static_cast<size_t>(n)) {
+                    expected.push_back(test_row(p));
+                }
+            }
+        }
+        ASSERT_EQ(expected.size(), top.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(expected[i], top[i]);
+        }
+    }
+}
+
+TPTEST(SortTest, DistinctSpillsSortedRuns) {
+    temp_directory_t temp_dir;
+    recreate_temporary_directory(temp_dir.path());
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(nullptr, nullptr, nullptr, auth_manager.get_view(),
+                      &get_global_perfmon_collection(), std::string(), &io_backender,
+                      temp_dir.path(), 0);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    cond_t interruptor;
+    scoped_ptr_t<ql::env_t> env = make_env(
+        &r, &ctx, &interruptor,
+        {{"array_limit", SORT_TEST_ARRAY_LIMIT},
+         {"max_batch_rows", SORT_TEST_BATCH_ROWS}});
+
+    // Every value comes up several times, and more often than not in a different
+    // run than before, so the merge has to drop the duplicates between runs.
+    const int num_values = 9;
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (int i = 0; i < 4 * num_values; ++i) {
+        builder.add(ql::datum_t(static_cast<double>((i * 5) % num_values)));
+    }
+    std::vector<ql::datum_t> distinct = read_all(
+        env.get(), r.expr(std::move(builder).to_datum()).call(Term::DISTINCT)
+                       .root_term());
+    ASSERT_EQ(static_cast<size_t>(num_values), distinct.size());
+    for (int i = 0; i < num_values; ++i) {
+        EXPECT_EQ(ql::datum_t(static_cast<double>(i)), distinct[i]);
+    }
+}
+
+}  // namespace unittest
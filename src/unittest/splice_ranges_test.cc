@@ -0,0 +1,112 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+#include <utility>
+
+#include "containers/uuid.hpp"
+#include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/context.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+using ql::changefeed::is_unread;
+using ql::changefeed::splice_ranges_t;
+
+typedef std::map<uuid_u, std::pair<key_range_t, uint64_t> > last_read_stamps_t;
+
+static store_key_t key(const char *k) {
+    return store_key_t(std::string(k));
+}
+
+// The ranges that a read of one shard got to, starting at `left` and stopping before
+// `right`, or going to the end if `right` is null.
+static last_read_stamps_t read_up_to(uuid_u shard, const store_key_t &left,
+                                     const char *right, uint64_t stamp) {
+    key_range_t range = right == nullptr
+        ? key_range_t(key_range_t::closed, left, key_range_t::none, store_key_t())
+        : key_range_t(key_range_t::closed, left, key_range_t::open, key(right));
+    last_read_stamps_t res;
+    res.insert(std::make_pair(shard, std::make_pair(range, stamp)));
+    return res;
+}
+
+TEST(SpliceRanges, NothingIsUnreadBeforeTheFirstRead) {
+    uuid_u shard = generate_uuid();
+    splice_ranges_t ranges({{shard, 10}});
+    // The subscription must queue every change until the first read, because only
+    // then do we know the keys of the values.
+    EXPECT_FALSE(ranges.has_read());
+    EXPECT_TRUE(ranges.unread_fenceposts().empty());
+    EXPECT_FALSE(is_unread(ranges.unread_fenceposts(), shard, store_key_t::min()));
+    EXPECT_FALSE(is_unread(ranges.unread_fenceposts(), shard, key("m")));
+}
+
+TEST(SpliceRanges, UnreadKeysAreDiscarded) {
+    uuid_u shard = generate_uuid();
+    uuid_u other_shard = generate_uuid();
+    splice_ranges_t ranges({{shard, 10}, {other_shard, 10}});
+
+    // The first read stops before "m" on `shard`, and doesn't get to `other_shard`.
+    ranges.add_read(read_up_to(shard, store_key_t::min(), "m", 12));
+    ASSERT_TRUE(ranges.has_read());
+    std::map<uuid_u, store_key_t> fenceposts = ranges.unread_fenceposts();
+    EXPECT_EQ(key("m"), fenceposts.at(shard));
+    EXPECT_EQ(store_key_t::min(), fenceposts.at(other_shard));
+
+    // Changes to keys we haven't read yet aren't queued, and would be discarded.
+    EXPECT_TRUE(is_unread(fenceposts, shard, key("m")));
+    EXPECT_TRUE(is_unread(fenceposts, shard, key("x")));
+    EXPECT_TRUE(is_unread(fenceposts, other_shard, key("a")));
+    EXPECT_TRUE(ranges.discard(key("x"), std::make_pair(shard, 11)));
+    EXPECT_TRUE(ranges.discard(key("x"), std::make_pair(shard, 13)));
+    EXPECT_TRUE(ranges.discard(key("a"), std::make_pair(other_shard, 11)));
+
+    // Changes to keys we have read are queued.  The read includes the ones from
+    // before it, and the later ones get sent.
+    EXPECT_FALSE(is_unread(fenceposts, shard, key("a")));
+    EXPECT_FALSE(is_unread(fenceposts, uuid_u(), key("x")));
+    EXPECT_TRUE(ranges.discard(key("a"), std::make_pair(shard, 11)));
+    EXPECT_FALSE(ranges.discard(key("a"), std::make_pair(shard, 12)));
+    EXPECT_FALSE(ranges.discard(key("a"), std::make_pair(shard, 13)));
+
+    // The next read gets to the end of `shard`, at a later stamp.
+    ranges.add_read(read_up_to(shard, key("m"), nullptr, 20));
+    fenceposts = ranges.unread_fenceposts();
+    EXPECT_FALSE(is_unread(fenceposts, shard, key("m")));
+    EXPECT_FALSE(is_unread(fenceposts, shard, key("x")));
+    EXPECT_TRUE(is_unread(fenceposts, other_shard, key("a")));
+    EXPECT_TRUE(ranges.discard(key("x"), std::make_pair(shard, 19)));
+    EXPECT_FALSE(ranges.discard(key("x"), std::make_pair(shard, 20)));
+}
+
+TEST(SpliceRanges, EmptyQueueSkipsToFeed) {
+    uuid_u shard = generate_uuid();
+    splice_ranges_t ranges({{shard, 10}});
+    ranges.add_read(read_up_to(shard, store_key_t::min(), "m", 12));
+
+    // The subscription has seen the changes up to stamp 13, but only queued the ones
+    // for keys we haven't read, so there's nothing for us to consume.
+    std::map<uuid_u, uint64_t> sub_stamps{{shard, 14}};
+    int feed_stamp_calls = 0;
+    auto get_feed_stamps = [&]() {
+        ++feed_stamp_calls;
+        return std::map<uuid_u, uint64_t>{{shard, 30}};
+    };
+
+    // While the subscription has queued changes, we have to wait for them.
+    ranges.skip_to_feed(sub_stamps, false, get_feed_stamps);
+    ranges.remove_outdated_ranges();
+    EXPECT_EQ(0, feed_stamp_calls);
+    EXPECT_FALSE(ranges.empty());
+
+    // Once the queue is empty, we've seen every change the read is older than, and
+    // the read's ranges expire.
+    ranges.skip_to_feed(sub_stamps, true, get_feed_stamps);
+    ranges.remove_outdated_ranges();
+    EXPECT_EQ(1, feed_stamp_calls);
+    EXPECT_TRUE(ranges.empty());
+    // From now on, every change gets sent.
+    EXPECT_FALSE(ranges.discard(key("a"), std::make_pair(shard, 31)));
+}
+
+}  // namespace unittest
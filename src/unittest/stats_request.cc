@@ -0,0 +1,59 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "clustering/administration/datum_adapter.hpp"
+#include "clustering/administration/stats/request.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+static ql::datum_t make_object(const char *key, const ql::datum_t &value) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite(key, value);
+    return std::move(builder).to_datum();
+}
+
+// The write stages come from the shards' stores and from the primary's broadcaster.
+TEST(StatsRequest, WriteLatencyStages) {
+    perfmon_histogram::stats_t one, two;
+    one.record(100);
+    two.record(100);
+    two.record(200);
+
+    ql::datum_object_builder_t shard_builder;
+    shard_builder.overwrite("write_latency", two.to_datum(true));
+    shard_builder.overwrite("write_btree_latency", two.to_datum(true));
+    shard_builder.overwrite("write_commit_latency", one.to_datum(true));
+    ql::datum_object_builder_t sers_builder;
+    sers_builder.overwrite("shard_0", std::move(shard_builder).to_datum());
+    sers_builder.overwrite("shard_1", make_object("write_btree_latency",
+                                                  one.to_datum(true)));
+
+    ql::datum_object_builder_t regions_builder;
+    regions_builder.overwrite("primary-1", make_object("broadcaster",
+        make_object("write_ack_latency", two.to_datum(true))));
+    regions_builder.overwrite("secondary-2", ql::datum_t::empty_object());
+
+    ql::datum_object_builder_t table_builder;
+    table_builder.overwrite("serializers", std::move(sers_builder).to_datum());
+    table_builder.overwrite("regions", std::move(regions_builder).to_datum());
+
+    const server_id_t server_id = server_id_t::generate_server_id();
+    const namespace_id_t table_id = generate_uuid();
+    ql::datum_object_builder_t server_builder;
+    server_builder.overwrite("server_id", convert_server_id_to_datum(server_id));
+    server_builder.overwrite(datum_string_t(uuid_to_str(table_id)),
+                             std::move(table_builder).to_datum());
+
+    parsed_stats_t stats(
+        std::vector<ql::datum_t>{ std::move(server_builder).to_datum() });
+    const parsed_stats_t::table_stats_t &table =
+        stats.servers.at(server_id).tables.at(table_id);
+    EXPECT_EQ(2u, table.write_latency.count);
+    EXPECT_EQ(3u, table.write_btree_latency.count);
+    EXPECT_EQ(1u, table.write_commit_latency.count);
+    EXPECT_EQ(2u, table.write_ack_latency.count);
+    EXPECT_EQ(0u, table.write_sindex_latency.count);
+}
+
+}  // namespace unittest
@@ -0,0 +1,191 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "btree/depth_first_traversal.hpp"
+#include "btree/reql_specific.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "containers/uuid.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/store.hpp"
+#include "rdb_protocol/store_snapshot.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+void set_rows(int start, int finish, int value, store_t *store,
+              repli_timestamp_t timestamp = repli_timestamp_t::distant_past) {
+    for (int i = start; i < finish; ++i) {
+        cond_t non_interruptor;
+        scoped_ptr_t<txn_t> txn;
+        {
+            scoped_ptr_t<real_superblock_t> superblock;
+            write_token_t token;
+            store->new_write_token(&token);
+            store->acquire_superblock_for_write(
+                1, write_durability_t::SOFT,
+                &token, &txn, &superblock, &non_interruptor);
+
+            ql::datum_object_builder_t row;
+            row.overwrite("id", ql::datum_t(static_cast<double>(i)));
+            row.overwrite("value", ql::datum_t(static_cast<double>(value)));
+            store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
+            point_write_response_t response;
+            rdb_modification_info_t mod_info;
+            rdb_live_deletion_context_t deletion_context;
+            rdb_set(pk, std::move(row).to_datum(), true, store->btree.get(),
+                    timestamp, superblock.get(),
+                    &deletion_context, &response, &mod_info, nullptr);
+        }
+        txn->commit();
+    }
+}
+
+void check_snapshot_rows(store_snapshot_t *snapshot, int count, int value) {
+    cond_t non_interruptor;
+    std::vector<ql::datum_t> rows;
+    while (snapshot->read_batch(64, &rows, &non_interruptor)
+           == continue_bool_t::CONTINUE) { }
+    ASSERT_EQ(static_cast<size_t>(count), rows.size());
+    for (const ql::datum_t &row : rows) {
+        ASSERT_EQ(value, row.get_field("value").as_int());
+    }
+}
+
+TPTEST(StoreSnapshot, KeepsOldVersionsWhileWritesContinue) {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                &file_opener,
+                                &get_global_perfmon_collection());
+    store_t store(region_t::universe(), &serializer, &balancer, "unit_test_store",
+                  true, &get_global_perfmon_collection(), nullptr, &io_backender,
+                  base_path_t("."), generate_uuid(), update_sindexes_t::UPDATE,
+                  which_cpu_shard_t{0, 1});
+
+    set_rows(0, 1000, 1, &store);
+    cond_t non_interruptor;
+    store_snapshot_t before(&store, &non_interruptor);
+
+    // These writes mustn't wait for `before`, and it mustn't see them.
+    set_rows(0, 2000, 2, &store);
+    store_snapshot_t after(&store, &non_interruptor);
+    check_snapshot_rows(&before, 1000, 1);
+    check_snapshot_rows(&after, 2000, 2);
+
+    // A snapshot can be read again.
+    class count_cb_t : public depth_first_traversal_callback_t {
+    public:
+        continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+            ++count;
+            return continue_bool_t::CONTINUE;
+        }
+        int count = 0;
+    } cb;
+    ASSERT_EQ(continue_bool_t::CONTINUE,
+              before.traverse(key_range_t::universe(), &cb, &non_interruptor));
+    ASSERT_EQ(1000, cb.count);
+}
+
+TPTEST(StoreSnapshot, RefreshSeesLaterWrites) {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                &file_opener,
+                                &get_global_perfmon_collection());
+    store_t store(region_t::universe(), &serializer, &balancer, "unit_test_store",
+                  true, &get_global_perfmon_collection(), nullptr, &io_backender,
+                  base_path_t("."), generate_uuid(), update_sindexes_t::UPDATE,
+                  which_cpu_shard_t{0, 1});
+
+    set_rows(0, 1000, 1, &store);
+    cond_t non_interruptor;
+    // Any batch goes over one byte, so every batch takes a new snapshot.
+    store_snapshot_t snapshot(&store, &non_interruptor, 1);
+    std::vector<ql::datum_t> rows;
+    ASSERT_EQ(continue_bool_t::CONTINUE,
+              snapshot.read_batch(64, &rows, &non_interruptor));
+
+    set_rows(0, 1000, 2, &store);
+    while (snapshot.read_batch(64, &rows, &non_interruptor)
+           == continue_bool_t::CONTINUE) { }
+
+    // Every row shows up once, and the ones after the first batch are new.
+    ASSERT_EQ(1000u, rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        ASSERT_EQ(i < 64 ? 1 : 2, rows[i].get_field("value").as_int());
+    }
+}
+
+TPTEST(StoreSnapshot, ReadChangedSince) {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                &file_opener,
+                                &get_global_perfmon_collection());
+    store_t store(region_t::universe(), &serializer, &balancer, "unit_test_store",
+                  true, &get_global_perfmon_collection(), nullptr, &io_backender,
+                  base_path_t("."), generate_uuid(), update_sindexes_t::UPDATE,
+                  which_cpu_shard_t{0, 1});
+
+    repli_timestamp_t first, second;
+    first.longtime = 1;
+    second.longtime = 5;
+    set_rows(0, 1000, 1, &store, first);
+    set_rows(500, 510, 2, &store, second);
+
+    class changes_cb_t : public changed_rows_callback_t {
+    public:
+        void on_row(const store_key_t &key, ql::datum_t &&row) {
+            rows[key] = std::move(row);
+        }
+        void on_deletion(const store_key_t &) {
+            ADD_FAILURE() << "Nothing was deleted.";
+        }
+        void on_unknown_deletions(const key_range_t &range) {
+            unknown.push_back(range);
+        }
+        std::map<store_key_t, ql::datum_t> rows;
+        std::vector<key_range_t> unknown;
+    };
+
+    cond_t non_interruptor;
+    store_snapshot_t snapshot(&store, &non_interruptor);
+    changes_cb_t changes;
+    ASSERT_EQ(second, snapshot.read_changed_since(
+        key_range_t::universe(), first, &changes, &non_interruptor));
+
+    // Besides the rows that changed, we may get the rest of a leaf that has forgotten
+    // its deletions, but nothing else.
+    int changed = 0;
+    for (const auto &pair : changes.rows) {
+        if (pair.second.get_field("value").as_int() == 2) {
+            ++changed;
+        } else {
+            bool in_unknown = false;
+            for (const key_range_t &range : changes.unknown) {
+                in_unknown = in_unknown || range.contains_key(pair.first);
+            }
+            ASSERT_TRUE(in_unknown);
+        }
+    }
+    ASSERT_EQ(10, changed);
+    ASSERT_LT(changes.rows.size(), 1000u);
+
+    changes_cb_t no_changes;
+    ASSERT_EQ(second, snapshot.read_changed_since(
+        key_range_t::universe(), second, &no_changes, &non_interruptor));
+    ASSERT_TRUE(no_changes.rows.empty());
+    ASSERT_TRUE(no_changes.unknown.empty());
+}
+
+}  // namespace unittest
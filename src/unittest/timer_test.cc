@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include <algorithm>
+#include <vector>
 
+#include "arch/timer.hpp"
 #include "arch/timing.hpp"
 #include "concurrency/pmap.hpp"
 #include "unittest/gtest.hpp"
@@ -93,5 +95,42 @@ TPTEST(TimerTest, TestChangeInterval) {
     nap(70);
 }
 
+// Long timers go into the timer wheel, where they get canceled a lot.
+class wheel_test_callback_t : public timer_callback_t {
+public:
+    wheel_test_callback_t() : token(nullptr), due_nanos(0), rang_nanos(0), rings(0) { }
+    void on_timer(ticks_t ticks) {
+        rang_nanos = ticks.nanos;
+        ++rings;
+    }
+    timer_token_t *token;
+    int64_t due_nanos;
+    int64_t rang_nanos;
+    int rings;
+};
+
+TPTEST(TimerTest, TestWheelTimers) {
+    const int count = 300;
+    std::vector<wheel_test_callback_t> callbacks(count);
+    for (int i = 0; i < count; ++i) {
+        const int64_t ms = 50 + (i * 37) % 200;
+        callbacks[i].due_nanos = get_ticks().nanos + ms * MILLION;
+        callbacks[i].token = fire_timer_once(ms, &callbacks[i]);
+    }
+    for (int i = 0; i < count; i += 3) {
+        cancel_timer(callbacks[i].token);
+    }
+    nap(300);
+    for (int i = 0; i < count; ++i) {
+        if (i % 3 == 0) {
+            EXPECT_EQ(0, callbacks[i].rings);
+        } else {
+            ASSERT_EQ(1, callbacks[i].rings);
+            EXPECT_GE(callbacks[i].rang_nanos, callbacks[i].due_nanos);
+            EXPECT_LT(callbacks[i].rang_nanos - callbacks[i].due_nanos,
+                      max_error_ms * MILLION);
+        }
+    }
+}
 
 }  // namespace unittest
@@ -0,0 +1,47 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifdef ENABLE_TLS
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arch/io/openssl.hpp"
+#include "clustering/administration/main/command_line.hpp"
+#include "clustering/administration/main/options.hpp"
+#include "stl_utils.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static std::shared_ptr<tls_ctx_t> tls_ctx_for(
+        const std::vector<const char *> &command_line) {
+    std::vector<options::option_t> tls_options;
+    get_tls_options(&tls_options);
+    std::map<std::string, options::values_t> opts = options::parse_command_line(
+        command_line.size(), command_line.data(), tls_options);
+    std::shared_ptr<tls_ctx_t> tls_ctx;
+    guarantee(initialize_tls_ctx(opts, &tls_ctx));
+    return tls_ctx;
+}
+
+TPTEST(TlsOptions, KernelTls) {
+    std::shared_ptr<tls_ctx_t> plain = tls_ctx_for(std::vector<const char *>());
+    std::shared_ptr<tls_ctx_t> ktls =
+        tls_ctx_for(make_vector<const char *>("--tls-ktls"));
+    const uint64_t plain_options = SSL_CTX_get_options(plain.get());
+    const uint64_t ktls_options = SSL_CTX_get_options(ktls.get());
+#ifdef SSL_OP_ENABLE_KTLS
+    // The option adds `SSL_OP_ENABLE_KTLS` and doesn't change anything else.
+    EXPECT_EQ(0u, plain_options & SSL_OP_ENABLE_KTLS);
+    EXPECT_EQ(plain_options | SSL_OP_ENABLE_KTLS, ktls_options);
+#else
+    // Without kernel TLS support in OpenSSL, the option is ignored.
+    EXPECT_EQ(plain_options, ktls_options);
+#endif
+}
+
+}  // namespace unittest
+
+#endif  // ENABLE_TLS